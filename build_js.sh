@@ -4,10 +4,14 @@
 set -e
 
 BULLET=false
+WEB_WORKER=false
+SIMD_THREADS=false
 
 while [[ "$#" -gt 0 ]]; do
     case $1 in
         --bullet) BULLET=true ;;
+        --worker) WEB_WORKER=true ;;
+        --simd-threads) SIMD_THREADS=true ;;
         *) echo "Unknown parameter passed: $1"; exit 1 ;;
     esac
     shift
@@ -34,25 +38,45 @@ EXE_LINKER_FLAGS="-s USE_WEBGL2=1"
 if ${BULLET}; 
     then EXE_LINKER_FLAGS="${EXE_LINKER_FLAGS} -s USE_BULLET=1"
 fi
-cmake ../src \
-    -DCORRADE_RC_EXECUTABLE=../build_corrade-rc/RelWithDebInfo/bin/corrade-rc \
-    -DBUILD_GUI_VIEWERS=ON \
-    -DBUILD_PYTHON_BINDINGS=OFF \
-    -DBUILD_ASSIMP_SUPPORT=OFF \
-    -DBUILD_DATATOOL=OFF \
-    -DBUILD_PTEX_SUPPORT=OFF \
-    -DCMAKE_BUILD_TYPE=Release \
-    -DCMAKE_PREFIX_PATH="$EMSCRIPTEN" \
-    -DCMAKE_TOOLCHAIN_FILE="../src/deps/corrade/toolchains/generic/Emscripten-wasm.cmake" \
-    -DCMAKE_INSTALL_PREFIX="." \
-    -DCMAKE_CXX_FLAGS="-s FORCE_FILESYSTEM=1 -s ALLOW_MEMORY_GROWTH=1" \
-    -DCMAKE_EXE_LINKER_FLAGS="${EXE_LINKER_FLAGS}" \
-    -DBUILD_WITH_BULLET="$( if ${BULLET} ; then echo ON ; else echo OFF; fi )" \
-    -DUSE_EMSCRIPTEN_PORTS_BULLET="$( if ${BULLET} ; then echo ON ; else echo OFF; fi )"
+# configure_js <source dir> <SIMD and threads ON/OFF>
+configure_js() {
+    cmake "$1" \
+        -DCORRADE_RC_EXECUTABLE=../build_corrade-rc/RelWithDebInfo/bin/corrade-rc \
+        -DBUILD_GUI_VIEWERS=ON \
+        -DBUILD_PYTHON_BINDINGS=OFF \
+        -DBUILD_ASSIMP_SUPPORT=OFF \
+        -DBUILD_DATATOOL=OFF \
+        -DBUILD_PTEX_SUPPORT=OFF \
+        -DCMAKE_BUILD_TYPE=Release \
+        -DCMAKE_PREFIX_PATH="$EMSCRIPTEN" \
+        -DCMAKE_TOOLCHAIN_FILE="$1/deps/corrade/toolchains/generic/Emscripten-wasm.cmake" \
+        -DCMAKE_INSTALL_PREFIX="." \
+        -DCMAKE_CXX_FLAGS="-s FORCE_FILESYSTEM=1 -s ALLOW_MEMORY_GROWTH=1" \
+        -DCMAKE_EXE_LINKER_FLAGS="${EXE_LINKER_FLAGS}" \
+        -DBUILD_WITH_BULLET="$( if ${BULLET} ; then echo ON ; else echo OFF; fi )" \
+        -DUSE_EMSCRIPTEN_PORTS_BULLET="$( if ${BULLET} ; then echo ON ; else echo OFF; fi )" \
+        -DBUILD_WEB_WORKER="$( if ${WEB_WORKER} ; then echo ON ; else echo OFF; fi )" \
+        -DBUILD_WEB_SIMD_THREADS="$2"
+}
 
+configure_js ../src OFF
 cmake --build . -- -j 4
 cmake --build . --target install -- -j 4
 
+# The SIMD and threads variant of the bindings, put next to the default
+# build, which the pages fall back to where the browser doesn't support it
+if ${SIMD_THREADS}; then
+    mkdir -p ../build_js_simd_threads
+    pushd ../build_js_simd_threads
+    configure_js ../src ON
+    cmake --build . --target hsim_bindings -- -j 4
+    if ${WEB_WORKER}; then
+        cmake --build . --target hsim_bindings_worker -- -j 4
+    fi
+    cp esp/bindings_js/hsim_bindings*_simd_threads.* ../build_js/esp/bindings_js/
+    popd
+fi
+
 echo "Done building."
 echo "Run:"
 echo "python2 -m SimpleHTTPServer 8000"
@@ -62,3 +86,13 @@ echo "Then open in browser:"
 echo "http://0.0.0.0:8000/build_js/utils/viewer/viewer.html?scene=skokloster-castle.glb"
 echo "Or:"
 echo "http://0.0.0.0:8000/build_js/esp/bindings_js/bindings.html?scene=skokloster-castle.glb"
+if ${WEB_WORKER}; then
+    echo "Or, to run the simulator in a Web Worker:"
+    echo "http://0.0.0.0:8000/build_js/esp/bindings_js/worker.html?scene=skokloster-castle.glb"
+fi
+if ${SIMD_THREADS}; then
+    echo "The SIMD and threads build needs SharedArrayBuffer, so it is only used"
+    echo "when the server sends the headers of a cross-origin isolated page:"
+    echo "  Cross-Origin-Opener-Policy: same-origin"
+    echo "  Cross-Origin-Embedder-Policy: require-corp"
+fi
@@ -141,9 +141,15 @@ class Agent(object):
         if reconfigure_sensors:
             self._sensors.clear()
             for spec in self.agent_config.sensor_specifications:
-                self._sensors.add(
-                    hsim.PinholeCamera(self.scene_node.create_child(), spec)
-                )
+                if hsim.LidarSensor.is_lidar_spec(spec):
+                    sensor_type = hsim.LidarSensor
+                elif hsim.CubeMapCamera.is_cube_map_spec(spec):
+                    sensor_type = hsim.CubeMapCamera
+                elif hsim.TopDownMapCamera.is_top_down_map_spec(spec):
+                    sensor_type = hsim.TopDownMapCamera
+                else:
+                    sensor_type = hsim.PinholeCamera
+                self._sensors.add(sensor_type(self.scene_node.create_child(), spec))
 
     def act(self, action_id: Any) -> bool:
         r"""Take the action specified by action_id
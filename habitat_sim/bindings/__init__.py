@@ -15,11 +15,16 @@ modules = [
     "MultiGoalShortestPath",
     "PathFinder",
     "PinholeCamera",
+    "CubeMapCamera",
+    "LidarSensor",
+    "TopDownMapCamera",
     "SceneGraph",
     "SceneNode",
     "Sensor",
     "SensorSpec",
     "SensorType",
+    "ObservationFormat",
+    "RenderQuality",
     "ShortestPath",
     "SimulatorConfiguration",
     "ConfigurationGroup",
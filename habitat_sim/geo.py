@@ -10,8 +10,11 @@ from habitat_sim._ext.habitat_sim_bindings.geo import (
     LEFT,
     RIGHT,
     UP,
+    CoordinateFrame,
     compute_gravity_aligned_MOBB,
     get_transformed_bb,
+    quaternions_to_rotation_matrices,
+    rotation_matrices_to_quaternions,
 )
 
 __all__ = [
@@ -23,7 +26,10 @@ __all__ = [
     "BACK",
     "LEFT",
     "RIGHT",
+    "CoordinateFrame",
     "compute_gravity_aligned_MOBB",
     "get_transformed_bb",
+    "quaternions_to_rotation_matrices",
+    "rotation_matrices_to_quaternions",
     "Ray",
 ]
@@ -5,14 +5,21 @@
 from habitat_sim._ext.habitat_sim_bindings import (
     DEFAULT_LIGHTING_KEY,
     NO_LIGHT_KEY,
+    BatchRenderer,
     Camera,
+    GpuDeviceInfo,
+    GpuDevicePolicy,
     LightInfo,
     LightPositionModel,
     Renderer,
     RenderTarget,
+    gpu_devices,
+    num_gpu_devices,
+    select_gpu_device,
 )
 
 __all__ = [
+    "BatchRenderer",
     "Camera",
     "Renderer",
     "RenderTarget",
@@ -20,4 +27,9 @@ __all__ = [
     "LightInfo",
     "DEFAULT_LIGHTING_KEY",
     "NO_LIGHT_KEY",
+    "GpuDeviceInfo",
+    "GpuDevicePolicy",
+    "gpu_devices",
+    "num_gpu_devices",
+    "select_gpu_device",
 ]
@@ -5,6 +5,7 @@ import numpy as np
 
 from habitat_sim import errors, scene
 from habitat_sim.agent import agent
+from habitat_sim.bindings import RigidState
 from habitat_sim.nav import GreedyFollowerCodes, GreedyGeodesicFollowerImpl, PathFinder
 from habitat_sim.utils.common import quat_to_magnum
 
@@ -191,6 +192,66 @@ class GreedyGeodesicFollower(object):
 
         return path
 
+    def find_paths(
+        self,
+        start_states: List[agent.AgentState],
+        goal_positions: List[np.ndarray],
+        num_threads: int = 0,
+    ) -> List[Optional[List[Any]]]:
+        r"""Finds the sequences of actions from many start states to their
+        goals, planned in parallel
+
+        :param start_states: The states to start from
+        :param goal_positions: The goal of each start state
+        :param num_threads: The number of planning threads, all hardware
+            threads if :py:`0`
+        :return: The list of actions of each start state as returned by
+            :ref:`find_path`, or :py:`None` where no path was found
+
+        The geodesic distances are looked up in a precomputed distance field
+        per goal, so the actions may differ slightly from :ref:`find_path`.
+        Does not change the state of the follower.
+        """
+        paths = self.impl.find_paths_batch(
+            [
+                RigidState(quat_to_magnum(state.rotation), state.position)
+                for state in start_states
+            ],
+            goal_positions,
+            num_threads,
+        )
+
+        return [
+            list(map(lambda v: self.action_mapping[v], path))
+            if len(path) > 0
+            else None
+            for path in paths
+        ]
+
+    def precompute_actions(
+        self, goal_pos: np.ndarray, cell_size: float = 0.1, num_threads: int = 0
+    ) -> bool:
+        r"""Plans the next action toward a goal ahead of time, for the cells of
+        a grid over the navmesh and every heading the agent can turn to
+
+        :param goal_pos: The position of the goal
+        :param cell_size: The size of a grid cell in meters
+        :param num_threads: The number of planning threads, all hardware
+            threads if :py:`0`
+        :return: Whether the actions could be planned
+
+        :ref:`next_action_along` toward :py:`goal_pos` then looks the action
+        up at the cell and closest heading of the agent instead of planning,
+        which may differ slightly from the action planned at the exact state.
+        States off the grid are still planned for. The actions are kept per
+        goal across :ref:`reset` until :ref:`clear_precomputed_actions`.
+        """
+        return self.impl.precompute_actions(goal_pos, cell_size, num_threads)
+
+    def clear_precomputed_actions(self):
+        r"""Discards the actions of :ref:`precompute_actions` for all goals"""
+        self.impl.clear_precomputed_actions()
+
     def reset(self):
         self.impl.reset()
         self.last_goal = None
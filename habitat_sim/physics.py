@@ -5,6 +5,7 @@
 from habitat_sim._ext.habitat_sim_bindings import (
     MotionType,
     PhysicsSimulationLibrary,
+    PhysicsSnapshot,
     RaycastResults,
     RayHitInfo,
     VelocityControl,
@@ -13,6 +14,7 @@ from habitat_sim._ext.habitat_sim_bindings import (
 __all__ = [
     "PhysicsSimulationLibrary",
     "MotionType",
+    "PhysicsSnapshot",
     "VelocityControl",
     "RayHitInfo",
     "RaycastResults",
@@ -0,0 +1,207 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+r"""Client of a habitat_sim.sim.SimulatorServer
+
+Drives the environments of a VectorSimulator on a render node from a trainer
+elsewhere, with one request per batched step and the observations sent as
+raw frames, or written into shared memory for a trainer on the same machine.
+"""
+
+import socket
+import struct
+from typing import Dict, List, Sequence, Union
+
+import numpy as np
+
+__all__ = ["RemoteVectorEnv"]
+
+# see esp/sim/SimulatorServer.h for the protocol
+_MAGIC = 0x56525348
+_VERSION = 1
+_HEADER = struct.Struct("=IHHQ")
+
+_DESCRIBE = 0
+_DESCRIPTION = 1
+_RESET = 2
+_STEP = 3
+_OBSERVATIONS = 4
+_MAP_SHARED_MEMORY = 5
+_SHARED_MEMORY = 6
+_CLOSE = 7
+_ERROR = 8
+
+# by esp::core::DataType
+_DTYPES = {
+    1: np.int8,
+    2: np.uint8,
+    3: np.int16,
+    4: np.uint16,
+    5: np.int32,
+    6: np.uint32,
+    7: np.int64,
+    8: np.uint64,
+    9: np.float32,
+    10: np.float64,
+    11: np.float16,
+}
+
+
+class RemoteVectorEnv:
+    r"""The environments of a VectorSimulator served by a SimulatorServer
+
+    :param host: The host of the server
+    :param port: The port of the server
+    :param shared_memory_slots: For a server on the same machine, the number
+        of slots of the shared memory ring the observations are written into
+        instead of being sent, 0 to receive them over the socket. An
+        observation stays valid until that many more steps.
+
+    step() and reset() return a dict from sensor uuid to an array of the
+    observations of all environments, [num_envs, H, W, C]. The arrays are
+    reused and overwritten by later calls.
+    """
+
+    def __init__(self, host: str, port: int, shared_memory_slots: int = 0):
+        self._socket = socket.create_connection((host, port))
+        self._socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self._ring = None
+        # size of the frames following the slot of the last observations
+        self._frames_size = 0
+
+        payload = self._request(_DESCRIBE, b"", _DESCRIPTION)
+        offset = 0
+
+        def read(fmt):
+            nonlocal offset
+            values = struct.unpack_from(fmt, payload, offset)
+            offset += struct.calcsize(fmt)
+            return values
+
+        def read_string():
+            nonlocal offset
+            (length,) = read("=I")
+            offset += length
+            return bytes(payload[offset - length : offset]).decode()
+
+        self.num_envs, num_actions = read("=II")
+        self.action_names: List[str] = [read_string() for _ in range(num_actions)]
+        self._action_indices = {
+            name: index for index, name in enumerate(self.action_names)
+        }
+        self._observations: Dict[str, np.ndarray] = {}
+        (num_fields,) = read("=I")
+        for _ in range(num_fields):
+            name = read_string()
+            data_type, ndim = read("=II")
+            shape = read("=" + "Q" * ndim)
+            self._observations[name] = np.empty(shape, dtype=_DTYPES[data_type])
+
+        if shared_memory_slots > 0:
+            from habitat_sim.sensor import SharedMemoryRing
+
+            payload = self._request(
+                _MAP_SHARED_MEMORY,
+                struct.pack("=I", shared_memory_slots),
+                _SHARED_MEMORY,
+            )
+            (length,) = struct.unpack_from("=I", payload)
+            self._ring = SharedMemoryRing(bytes(payload[4 : 4 + length]).decode())
+
+    @property
+    def observation_shapes(self) -> Dict[str, tuple]:
+        r"""The shape of the observations of each sensor, by uuid"""
+        return {name: obs.shape for name, obs in self._observations.items()}
+
+    def reset(self) -> Dict[str, np.ndarray]:
+        r"""Reset all environments and return their observations"""
+        return self._receive_observations(self._request(_RESET, b"", _OBSERVATIONS))
+
+    def step(
+        self, actions: Sequence[Union[str, int, None]], dt: float = 1.0 / 60.0
+    ) -> Dict[str, np.ndarray]:
+        r"""Act in every environment, by action name or index, None or a
+        negative index for no action, step their physics by dt and return
+        their observations, in a single round trip
+        """
+        if len(actions) != self.num_envs:
+            raise ValueError(f"expected {self.num_envs} actions, got {len(actions)}")
+        indices = [
+            -1
+            if action is None
+            else (self._action_indices[action] if isinstance(action, str) else action)
+            for action in actions
+        ]
+        payload = struct.pack(f"=d{self.num_envs}i", dt, *indices)
+        return self._receive_observations(self._request(_STEP, payload, _OBSERVATIONS))
+
+    def close(self) -> None:
+        r"""End the session, the server then serves its next client"""
+        if self._socket is None:
+            return
+        try:
+            self._request(_CLOSE, b"", _CLOSE)
+        finally:
+            self._ring = None
+            self._socket.close()
+            self._socket = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def _request(self, request_type: int, payload: bytes, reply_type: int):
+        r"""Send a request and return the payload of its reply, up to the
+        observation frames of an inline reply
+        """
+        self._socket.sendall(
+            _HEADER.pack(_MAGIC, _VERSION, request_type, len(payload)) + payload
+        )
+        magic, version, message_type, size = _HEADER.unpack(
+            self._receive(_HEADER.size)
+        )
+        if magic != _MAGIC or version != _VERSION:
+            raise RuntimeError("unsupported protocol version or byte order")
+        if message_type == _OBSERVATIONS:
+            # the frames are received straight into the observation arrays
+            self._frames_size = size - 4
+            size = 4
+        payload = self._receive(size)
+        if message_type == _ERROR:
+            (length,) = struct.unpack_from("=I", payload)
+            raise RuntimeError(bytes(payload[4 : 4 + length]).decode())
+        if message_type != reply_type:
+            raise RuntimeError(f"unexpected reply {message_type} to {request_type}")
+        return payload
+
+    def _receive_observations(self, payload) -> Dict[str, np.ndarray]:
+        (slot,) = struct.unpack_from("=i", payload)
+        if slot >= 0:
+            return {
+                name: np.asarray(self._ring.field(slot, name))
+                for name in self._observations
+            }
+        expected = sum(obs.nbytes for obs in self._observations.values())
+        if self._frames_size != expected:
+            raise RuntimeError(
+                f"expected {expected} bytes of observations, got {self._frames_size}"
+            )
+        for obs in self._observations.values():
+            self._receive_into(memoryview(obs.reshape(-1)).cast("B"))
+        return self._observations
+
+    def _receive(self, size: int) -> memoryview:
+        data = memoryview(bytearray(size))
+        self._receive_into(data)
+        return data
+
+    def _receive_into(self, view: memoryview) -> None:
+        received = 0
+        while received < len(view):
+            count = self._socket.recv_into(view[received:])
+            if count == 0:
+                raise ConnectionError("the server closed the connection")
+            received += count
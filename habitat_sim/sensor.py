@@ -3,19 +3,39 @@
 # LICENSE file in the root directory of this source tree.
 
 from habitat_sim._ext.habitat_sim_bindings import (
+    Buffer,
+    CubeMapCamera,
+    DatasetCompression,
+    LidarSensor,
     Observation,
+    ObservationDatasetReader,
+    ObservationDatasetWriter,
+    ObservationFormat,
     PinholeCamera,
+    RenderQuality,
     Sensor,
     SensorSpec,
     SensorType,
+    SharedMemoryRing,
+    TopDownMapCamera,
     VisualSensor,
 )
 
 __all__ = [
+    "Buffer",
+    "CubeMapCamera",
+    "DatasetCompression",
+    "LidarSensor",
     "Observation",
+    "ObservationDatasetReader",
+    "ObservationDatasetWriter",
+    "ObservationFormat",
     "PinholeCamera",
+    "RenderQuality",
     "Sensor",
     "SensorType",
     "SensorSpec",
+    "SharedMemoryRing",
+    "TopDownMapCamera",
     "VisualSensor",
 ]
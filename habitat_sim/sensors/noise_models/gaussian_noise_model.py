@@ -8,8 +8,10 @@ import attr
 import numba
 import numpy as np
 
+from habitat_sim.bindings import cuda_enabled
 from habitat_sim.registry import registry
 from habitat_sim.sensor import SensorType
+from habitat_sim.sensors.noise_models.rgb_noise_model_gpu import RgbNoiseModelGPU
 from habitat_sim.sensors.noise_models.sensor_noise_model import SensorNoiseModel
 
 
@@ -42,9 +44,18 @@ class GaussianNoiseModel(SensorNoiseModel):
     sigma: int = 1
 
     def __attrs_post_init__(self):
-        self._impl = GaussianNoiseModelCPUImpl(
-            self.intensity_constant, self.mean, self.sigma
-        )
+        if cuda_enabled:
+            self._impl = RgbNoiseModelGPU(
+                self.gpu_device_id,
+                "GAUSSIAN",
+                intensity_constant=self.intensity_constant,
+                mean=self.mean,
+                sigma=self.sigma,
+            )
+        else:
+            self._impl = GaussianNoiseModelCPUImpl(
+                self.intensity_constant, self.mean, self.sigma
+            )
 
     @staticmethod
     def is_valid_sensor_type(sensor_type: SensorType) -> bool:
@@ -56,3 +67,9 @@ class GaussianNoiseModel(SensorNoiseModel):
     def apply(self, image):
         r"""Alias of `simulate()` to conform to base-class and expected API"""
         return self.simulate(image)
+
+    def apply_in_place_gpu(self, image, flipped: bool = False) -> bool:
+        r"""Applies the noise in-place to a batch of color frames on the GPU,
+        with the CUDA implementation if habitat sim is built with it
+        """
+        return cuda_enabled and self._impl.apply_in_place_gpu(image)
@@ -7,8 +7,10 @@
 import attr
 import numpy as np
 
+from habitat_sim.bindings import cuda_enabled
 from habitat_sim.registry import registry
 from habitat_sim.sensor import SensorType
+from habitat_sim.sensors.noise_models.rgb_noise_model_gpu import RgbNoiseModelGPU
 from habitat_sim.sensors.noise_models.sensor_noise_model import SensorNoiseModel
 
 
@@ -37,7 +39,10 @@ class PoissonNoiseModelCPUImpl:
 @attr.s(auto_attribs=True, kw_only=True)
 class PoissonNoiseModel(SensorNoiseModel):
     def __attrs_post_init__(self):
-        self._impl = PoissonNoiseModelCPUImpl()
+        if cuda_enabled:
+            self._impl = RgbNoiseModelGPU(self.gpu_device_id, "POISSON")
+        else:
+            self._impl = PoissonNoiseModelCPUImpl()
 
     @staticmethod
     def is_valid_sensor_type(sensor_type: SensorType) -> bool:
@@ -49,3 +54,9 @@ class PoissonNoiseModel(SensorNoiseModel):
     def apply(self, image):
         r"""Alias of `simulate()` to conform to base-class and expected API"""
         return self.simulate(image)
+
+    def apply_in_place_gpu(self, image, flipped: bool = False) -> bool:
+        r"""Applies the noise in-place to a batch of color frames on the GPU,
+        with the CUDA implementation if habitat sim is built with it
+        """
+        return cuda_enabled and self._impl.apply_in_place_gpu(image)
@@ -7,9 +7,9 @@
 from os import path as osp
 
 import attr
-import numba
 import numpy as np
 
+from habitat_sim._ext.habitat_sim_bindings import RedwoodNoiseModelCPUImpl
 from habitat_sim.bindings import cuda_enabled
 from habitat_sim.registry import registry
 from habitat_sim.sensor import SensorType
@@ -21,88 +21,6 @@ if cuda_enabled:
 torch = None
 
 
-# Read about the noise model here: http://www.alexteichman.com/octo/clams/
-# Original source code: http://redwood-data.org/indoor/data/simdepth.py
-@numba.jit(nopython=True, fastmath=True)
-def _undistort(x, y, z, model):
-    i2 = int((z + 1) / 2)
-    i1 = int(i2 - 1)
-    a = (z - (i1 * 2.0 + 1.0)) / 2.0
-    x = x // 8
-    y = y // 6
-    f = (1 - a) * model[y, x, min(max(i1, 0), 4)] + a * model[y, x, min(i2, 4)]
-
-    if f < 1e-5:
-        return 0
-    else:
-        return z / f
-
-
-@numba.jit(nopython=True, parallel=True, fastmath=True)
-def _simulate(gt_depth, model, noise_multiplier):
-    noisy_depth = np.empty_like(gt_depth)
-
-    H, W = gt_depth.shape
-    ymax, xmax = H - 1.0, W - 1.0
-
-    rand_nums = np.random.randn(H, W, 3).astype(np.float32)
-
-    # Parallelize just the outer loop.  This doesn't change the speed
-    # noticably but reduces CPU usage compared to two parallel loops
-    for j in numba.prange(H):
-        for i in range(W):
-            y = int(
-                min(max(j + rand_nums[j, i, 0] * 0.25 * noise_multiplier, 0.0), ymax)
-                + 0.5
-            )
-            x = int(
-                min(max(i + rand_nums[j, i, 1] * 0.25 * noise_multiplier, 0.0), xmax)
-                + 0.5
-            )
-
-            # Downsample
-            d = gt_depth[y - y % 2, x - x % 2]
-            # If the depth is greater than 10, the sensor will just return 0
-            if d >= 10.0:
-                noisy_depth[j, i] = 0.0
-            else:
-                # Distort
-                # The noise model was originally made for a 640x480 sensor,
-                # so re-map our arbitrarily sized sensor to that size!
-                undistorted_d = _undistort(
-                    int(x / xmax * 639.0 + 0.5), int(y / ymax * 479.0 + 0.5), d, model
-                )
-
-                if undistorted_d == 0.0:
-                    noisy_depth[j, i] = 0.0
-                else:
-                    denom = round(
-                        (
-                            35.130 / undistorted_d
-                            + rand_nums[j, i, 2] * 0.027778 * noise_multiplier
-                        )
-                        * 8.0
-                    )
-                    if denom <= 1e-5:
-                        noisy_depth[j, i] = 0.0
-                    else:
-                        noisy_depth[j, i] = 35.130 * 8.0 / denom
-
-    return noisy_depth
-
-
-@attr.s(auto_attribs=True)
-class RedwoodNoiseModelCPUImpl:
-    model: np.ndarray
-    noise_multiplier: float
-
-    def __attrs_post_init__(self):
-        self.model = self.model.reshape(self.model.shape[0], -1, 4)
-
-    def simulate(self, gt_depth):
-        return _simulate(gt_depth, self.model, self.noise_multiplier)
-
-
 @registry.register_noise_model
 @attr.s(auto_attribs=True, kw_only=True)
 class RedwoodDepthNoiseModel(SensorNoiseModel):
@@ -139,8 +57,25 @@ class RedwoodDepthNoiseModel(SensorNoiseModel):
                 )
                 return noisy_depth
         else:
-            return self._impl.simulate(gt_depth)
+            return self._impl.simulate_from_cpu(gt_depth)
 
     def apply(self, gt_depth):
         r"""Alias of `simulate()` to conform to base-class and expected API"""
         return self.simulate(gt_depth)
+
+    def apply_in_place_gpu(self, gt_depth, flipped: bool = False) -> bool:
+        r"""Replaces a batch of depth frames on the GPU with their noisy version
+        without allocating any output.  The last two dimensions of ``gt_depth``
+        are rows and columns, all leading ones are batched.  Runs on the
+        default CUDA stream, the one the GPU readback of the render targets
+        uses.
+        """
+        if not cuda_enabled:
+            return False
+
+        rows, cols = gt_depth.size()[-2:]
+        num_frames = gt_depth.numel() // (rows * cols)
+        self._impl.simulate_in_place_from_gpu(
+            gt_depth.data_ptr(), rows, cols, num_frames, flipped
+        )
+        return True
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+import numpy as np
+
+from habitat_sim.bindings import cuda_enabled
+
+if cuda_enabled:
+    from habitat_sim._ext.habitat_sim_bindings import (
+        RgbNoiseModelGPUImpl,
+        RgbNoiseParameters,
+        RgbNoiseType,
+    )
+
+torch = None
+
+
+class RgbNoiseModelGPU:
+    r"""Runs a color noise model with the CUDA `RgbNoiseModelGPUImpl`, on numpy
+    images and CUDA tensors of shape (H, W, C)
+
+    :param gpu_device_id: The CUDA device to run on
+    :param noise_type: The name of the `RgbNoiseType`, e.g. ``"GAUSSIAN"``
+    :param parameters: The `RgbNoiseParameters` of the noise, by name
+    """
+
+    def __init__(self, gpu_device_id, noise_type, **parameters):
+        params = RgbNoiseParameters()
+        params.type = getattr(RgbNoiseType, noise_type)
+        for name, value in parameters.items():
+            setattr(params, name, float(value))
+        self._impl = RgbNoiseModelGPUImpl(params, gpu_device_id)
+
+    def simulate(self, image):
+        global torch
+        if isinstance(image, np.ndarray):
+            return self._impl.simulate_from_cpu(image)
+
+        if torch is None:
+            import torch
+        noisy = torch.empty_like(image)
+        rows, cols, channels = image.size()
+        self._impl.simulate_from_gpu(
+            image.data_ptr(), rows, cols, channels, noisy.data_ptr()
+        )
+        return noisy
+
+    def apply_in_place_gpu(self, image):
+        r"""Replaces a batch of color frames on the GPU with their noisy version.
+        The last three dimensions of ``image`` are rows, columns and channels,
+        all leading ones are batched.
+        """
+        rows, cols, channels = image.size()[-3:]
+        num_frames = image.numel() // (rows * cols * channels)
+        self._impl.simulate_in_place_from_gpu(
+            image.data_ptr(), rows, cols, channels, num_frames
+        )
+        return True
@@ -8,8 +8,10 @@
 import attr
 import numpy as np
 
+from habitat_sim.bindings import cuda_enabled
 from habitat_sim.registry import registry
 from habitat_sim.sensor import SensorType
+from habitat_sim.sensors.noise_models.rgb_noise_model_gpu import RgbNoiseModelGPU
 from habitat_sim.sensors.noise_models.sensor_noise_model import SensorNoiseModel
 
 
@@ -44,7 +46,15 @@ class SaltAndPepperNoiseModel(SensorNoiseModel):
     amount: float = 0.05
 
     def __attrs_post_init__(self):
-        self._impl = SaltAndPepperNoiseModelCPUImpl(self.s_vs_p, self.amount)
+        if cuda_enabled:
+            self._impl = RgbNoiseModelGPU(
+                self.gpu_device_id,
+                "SALT_AND_PEPPER",
+                s_vs_p=self.s_vs_p,
+                amount=self.amount,
+            )
+        else:
+            self._impl = SaltAndPepperNoiseModelCPUImpl(self.s_vs_p, self.amount)
 
     @staticmethod
     def is_valid_sensor_type(sensor_type: SensorType) -> bool:
@@ -56,3 +66,9 @@ class SaltAndPepperNoiseModel(SensorNoiseModel):
     def apply(self, image):
         r"""Alias of `simulate()` to conform to base-class and expected API"""
         return self.simulate(image)
+
+    def apply_in_place_gpu(self, image, flipped: bool = False) -> bool:
+        r"""Applies the noise in-place to a batch of color frames on the GPU,
+        with the CUDA implementation if habitat sim is built with it
+        """
+        return cuda_enabled and self._impl.apply_in_place_gpu(image)
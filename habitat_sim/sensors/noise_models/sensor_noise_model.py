@@ -36,6 +36,20 @@ class SensorNoiseModel(abc.ABC):
         :return: The sensor observation with noise applied.
         """
 
+    def apply_in_place_gpu(self, sensor_observation, flipped: bool = False) -> bool:
+        r"""Applies the noise model in-place to a sensor observation on the GPU,
+        if the noise model supports it
+
+        :param sensor_observation: The clean sensor observation as a CUDA
+            tensor.  Will be replaced with the noisy observation.
+        :param flipped: Whether the observation is stored bottom row first, as
+            read from OpenGL
+
+        :return: True if the noise was applied, False if the observation was
+            left untouched and `apply()` must be used instead
+        """
+        return False
+
     def __call__(self, sensor_observation):
         r"""Alias of `apply()`"""
         return self.apply(sensor_observation)
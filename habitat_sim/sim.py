@@ -3,6 +3,21 @@
 # LICENSE file in the root directory of this source tree.
 
 from habitat_sim._ext.habitat_sim_bindings import Simulator as SimulatorBackend
-from habitat_sim._ext.habitat_sim_bindings import SimulatorConfiguration
+from habitat_sim._ext.habitat_sim_bindings import (
+    EpisodeScheduler,
+    InstanceMeshCpuData,
+    SimulatorConfiguration,
+    SimulatorServer,
+    VectorSimulator,
+    ViewCache,
+)
 
-__all__ = ["SimulatorBackend", "SimulatorConfiguration"]
+__all__ = [
+    "EpisodeScheduler",
+    "InstanceMeshCpuData",
+    "SimulatorBackend",
+    "SimulatorConfiguration",
+    "SimulatorServer",
+    "VectorSimulator",
+    "ViewCache",
+]
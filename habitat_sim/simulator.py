@@ -5,6 +5,7 @@
 # LICENSE file in the root directory of this source tree.
 
 import time
+from concurrent.futures import Future
 from os import path as osp
 from typing import Any, Dict, List, Optional
 
@@ -17,7 +18,14 @@ from habitat_sim.agent import Agent, AgentConfiguration, AgentState
 from habitat_sim.bindings import cuda_enabled
 from habitat_sim.logging import logger
 from habitat_sim.nav import GreedyGeodesicFollower, NavMeshSettings, PathFinder
-from habitat_sim.sensor import SensorType
+from habitat_sim.physics import PhysicsSnapshot
+from habitat_sim.sensor import (
+    CubeMapCamera,
+    Observation,
+    ObservationFormat,
+    SensorType,
+    TopDownMapCamera,
+)
 from habitat_sim.sensors.noise_models import make_sensor_noise_model
 from habitat_sim.sim import SimulatorBackend, SimulatorConfiguration
 from habitat_sim.utils.common import quat_from_angle_axis
@@ -40,6 +48,38 @@ class Configuration(object):
     agents: Optional[List[AgentConfiguration]] = None
 
 
+class _ObservationFuture(Future):
+    r"""The observations of a Simulator.step_async()
+
+    Resolved by the simulator once the GPU finished them, which it checks
+    whenever the future is asked for its state or result.
+    """
+
+    def __init__(self, sim):
+        super().__init__()
+        self._sim = sim
+
+    def done(self):
+        if not super().done():
+            self._sim.poll_async_observations()
+        return super().done()
+
+    def result(self, timeout=None):
+        self._wait()
+        return super().result(timeout)
+
+    def exception(self, timeout=None):
+        self._wait()
+        return super().exception(timeout)
+
+    def _wait(self):
+        if not super().done():
+            self._sim.poll_async_observations(wait=True)
+        # dropped by a reset or close of the simulator
+        if not super().done():
+            self.cancel()
+
+
 @attr.s(auto_attribs=True)
 class Simulator(SimulatorBackend):
     r"""The core class of habitat-sim
@@ -100,6 +140,8 @@ class Simulator(SimulatorBackend):
         self.__set_from_config(self.config)
 
     def close(self):
+        # resolve a step_async() before its sensors go away
+        self.poll_async_observations(wait=True)
         for sensor in self._sensors.values():
             sensor.close()
             del sensor
@@ -131,11 +173,36 @@ class Simulator(SimulatorBackend):
 
     def reset(self):
         super().reset()
+        for sensor in self._sensors.values():
+            sensor._reset_update_schedule()
         for i in range(len(self.agents)):
             self.reset_agent(i)
 
         return self.get_sensor_observations()
 
+    def reset_episode(self, agent_states, object_states=None):
+        r"""Start a new episode in the current scene without reconfiguring
+
+        Keeps the scene graph, agents, sensors and GPU resources and only
+        moves the agents to agent_states, one for each agent in order, and
+        the objects to a PhysicsSnapshot saved with save_physics_snapshot(),
+        which also sets the world time. Much faster than reconfigure() or
+        reset() when the episodes share a scene.
+        """
+        if len(agent_states) > len(self.agents):
+            raise ValueError(
+                f"{len(agent_states)} agent states for {len(self.agents)} agents"
+            )
+        if object_states is None:
+            object_states = PhysicsSnapshot()
+        super().reset_episode(object_states)
+        for sensor in self._sensors.values():
+            sensor._reset_update_schedule()
+        for agent_id, state in enumerate(agent_states):
+            self.initialize_agent(agent_id, state)
+
+        return self.get_sensor_observations()
+
     def reset_agent(self, agent_id):
         agent = self.get_agent(agent_id)
         initial_agent_state = agent.initial_state
@@ -158,6 +225,11 @@ class Simulator(SimulatorBackend):
         ]
 
     def _config_pathfinder(self, config: Configuration):
+        if self.active_scene_reused:
+            # a resident scene keeps the navmesh it was first configured with
+            self.pathfinder.seed(config.sim_cfg.random_seed)
+            return
+
         if "navmesh" in config.sim_cfg.scene.filepaths:
             navmesh_filenname = config.sim_cfg.scene.filepaths["navmesh"]
         else:
@@ -209,6 +281,15 @@ class Simulator(SimulatorBackend):
             self.config = config
 
     def __set_from_config(self, config: Configuration):
+        # hand the render targets of the old sensors to the renderer, which
+        # binds them to new sensors of the same specification
+        if self._initialized:
+            for sensor in self._sensors.values():
+                if sensor._is_visual:
+                    self.renderer.release_render_target(sensor._sensor_object)
+                sensor.close()
+            self._sensors = {}
+
         self._config_backend(config)
         self._config_agents(config)
         self._config_pathfinder(config)
@@ -226,6 +307,9 @@ class Simulator(SimulatorBackend):
                 sim=self, agent=self._default_agent, sensor_id=spec.uuid
             )
 
+        if self.renderer is not None:
+            self.renderer.clear_released_render_targets()
+
         for i in range(len(self.agents)):
             self.initialize_agent(i)
 
@@ -247,12 +331,23 @@ class Simulator(SimulatorBackend):
         return agent
 
     def get_sensor_observations(self):
-        for _, sensor in self._sensors.items():
+        r"""Observe with the sensors that are due by their update_period
+
+        The others return their last observation, sensors with an
+        update_period of 0 are left out.
+        """
+        due = [
+            sensor for sensor in self._sensors.values() if sensor._schedule_update()
+        ]
+        for sensor in due:
             sensor.draw_observation()
+        for sensor in due:
+            sensor._last_observation = sensor.get_observation()
 
         observations = {}
         for sensor_uuid, sensor in self._sensors.items():
-            observations[sensor_uuid] = sensor.get_observation()
+            if sensor._last_observation is not None:
+                observations[sensor_uuid] = sensor._last_observation
 
         return observations
 
@@ -275,6 +370,53 @@ class Simulator(SimulatorBackend):
 
         return observations
 
+    def step_async(self, action, dt=1.0 / 60.0) -> Future:
+        r"""Like step(), but returns a concurrent.futures.Future of the
+        observations instead of waiting for the GPU to draw and read them back
+
+        The future is resolved by a callback from the native side once the
+        reads finished, checked by future.done() and future.result(), the
+        latter waiting for them. Stepping several simulators this way before
+        asking for their results overlaps their GPU work in a single process.
+        A simulator keeps one step in flight, the next step completes it first.
+        The observations are views of buffers the next step overwrites, like
+        those of step(). Not supported with gpu2gpu_transfer.
+        """
+        due = [
+            sensor for sensor in self._sensors.values() if sensor._schedule_update()
+        ]
+        if any(sensor._spec.gpu2gpu_transfer for sensor in due):
+            raise ValueError("step_async() does not support gpu2gpu_transfer")
+        # the previous step resolves before the agent moves on
+        self.poll_async_observations(wait=True)
+
+        self._num_total_frames += 1
+        collided = self._default_agent.act(action)
+        self._last_state = self._default_agent.get_state()
+
+        step_start_Time = time.time()
+        super().step_world(dt)
+        self._previous_step_time = time.time() - step_start_Time
+
+        future = _ObservationFuture(self)
+
+        def on_observed(native_observations):
+            try:
+                for sensor, obs in zip(due, native_observations):
+                    sensor._last_observation = sensor._observation_from(obs)
+                observations = {
+                    sensor_uuid: sensor._last_observation
+                    for sensor_uuid, sensor in self._sensors.items()
+                    if sensor._last_observation is not None
+                }
+                observations["collided"] = collided
+                future.set_result(observations)
+            except Exception as e:
+                future.set_exception(e)
+
+        self.observe_async([sensor._sensor_object for sensor in due], on_observed)
+        return future
+
     def make_greedy_follower(
         self,
         agent_id: int = 0,
@@ -336,11 +478,36 @@ class Sensor:
         # store such "attached object" in _sensor_object
         self._sensor_object = self._agent._sensors.get(sensor_id)
         self._spec = self._sensor_object.specification()
+        self._reset_update_schedule()
+        # a sensor which does not render, e.g. a lidar, observes by itself
+        self._is_visual = self._sensor_object.is_visual_sensor()
+        if not self._is_visual:
+            return
+        # a cube map camera draws its faces itself
+        self._is_cube_map = isinstance(self._sensor_object, CubeMapCamera)
+        # a top-down map draws the navmesh instead of the scene
+        self._is_top_down_map = isinstance(self._sensor_object, TopDownMapCamera)
+        # a format or downsampling converted on the GPU is read by the sensor
+        self._is_converted = self._sensor_object.has_converted_observation
 
         self._sim.renderer.bind_render_target(self._sensor_object)
+        self._sim.fit_texture_size_to_sensor(self._sensor_object)
 
         if self._spec.gpu2gpu_transfer:
             assert cuda_enabled, "Must build habitat sim with cuda for gpu2gpu-transfer"
+            assert not (
+                self._is_cube_map and self._sensor_object.is_equirectangular
+            ), "gpu2gpu-transfer is not supported by equirectangular sensors"
+            assert (
+                not self._is_converted
+            ), "gpu2gpu-transfer is not supported with an observation format or downsampling"
+            assert self._spec.sensor_type not in (
+                SensorType.NORMAL,
+                SensorType.OPTICAL_FLOW,
+            ), "gpu2gpu-transfer is not supported by normal and optical flow sensors"
+            assert (
+                self._sim.gpu_device >= 0
+            ), "gpu2gpu-transfer is not supported with software rendering"
 
             if torch is None:
                 import torch
@@ -361,6 +528,24 @@ class Sensor:
                 self._buffer = torch.empty(
                     resolution[0], resolution[1], 4, dtype=torch.uint8, device=device
                 )
+        elif self._is_converted:
+            size = self._sensor_object.observation_size
+            shape = (size[1], size[0])
+            observation_format = self._spec.observation_format
+            if observation_format == ObservationFormat.RGB:
+                self._buffer = np.empty(shape + (3,), dtype=np.uint8)
+            elif observation_format == ObservationFormat.GRAYSCALE:
+                self._buffer = np.empty(shape, dtype=np.uint8)
+            elif observation_format == ObservationFormat.HALF_DEPTH:
+                self._buffer = np.empty(shape, dtype=np.float16)
+            elif observation_format == ObservationFormat.MILLIMETER_DEPTH:
+                self._buffer = np.empty(shape, dtype=np.uint16)
+            elif self._spec.sensor_type == SensorType.SEMANTIC:
+                self._buffer = np.empty(shape, dtype=np.uint32)
+            elif self._spec.sensor_type == SensorType.DEPTH:
+                self._buffer = np.empty(shape, dtype=np.float32)
+            else:
+                self._buffer = np.empty(shape + (self._spec.channels,), dtype=np.uint8)
         else:
             if self._spec.sensor_type == SensorType.SEMANTIC:
                 self._buffer = np.empty(
@@ -372,6 +557,16 @@ class Sensor:
                     (self._spec.resolution[0], self._spec.resolution[1]),
                     dtype=np.float32,
                 )
+            elif self._spec.sensor_type == SensorType.NORMAL:
+                self._buffer = np.empty(
+                    (self._spec.resolution[0], self._spec.resolution[1], 3),
+                    dtype=np.float32,
+                )
+            elif self._spec.sensor_type == SensorType.OPTICAL_FLOW:
+                self._buffer = np.empty(
+                    (self._spec.resolution[0], self._spec.resolution[1], 2),
+                    dtype=np.float32,
+                )
             else:
                 self._buffer = np.empty(
                     (
@@ -383,6 +578,8 @@ class Sensor:
                 )
 
         noise_model_kwargs = self._spec.noise_model_kwargs
+        # resyncs the copy session recordings keep if the dict was edited in place
+        self._spec.noise_model_kwargs = noise_model_kwargs
         self._noise_model = make_sensor_noise_model(
             self._spec.noise_model,
             {"gpu_device_id": self._sim.gpu_device, **noise_model_kwargs},
@@ -394,6 +591,9 @@ class Sensor:
         )
 
     def draw_observation(self):
+        if not self._is_visual:
+            return
+
         # sanity check:
 
         # see if the sensor is attached to a scene graph, otherwise it is invalid,
@@ -424,38 +624,79 @@ class Sensor:
         agent_node = self._agent.scene_node
         agent_node.parent = scene.get_root_node()
 
+        if self._is_cube_map or self._is_top_down_map:
+            self._sensor_object.draw_observation(self._sim)
+            return
+
         render_flags = habitat_sim.gfx.Camera.Flags.NONE
 
         if self._sim.frustum_culling:
             render_flags |= habitat_sim.gfx.Camera.Flags.FRUSTUM_CULLING
 
+        if self._sim.sort_by_draw_state:
+            render_flags |= habitat_sim.gfx.Camera.Flags.SORT_BY_DRAW_STATE
+
+        if self._sim.occlusion_culling:
+            render_flags |= habitat_sim.gfx.Camera.Flags.OCCLUSION_CULLING
+
+        if self._sim.potentially_visible_set:
+            render_flags |= habitat_sim.gfx.Camera.Flags.POTENTIALLY_VISIBLE_SET
+
+        if self._sim.render_list:
+            render_flags |= habitat_sim.gfx.Camera.Flags.RENDER_LIST
+
         with self._sensor_object.render_target:
             self._sim.renderer.draw(self._sensor_object, scene, render_flags)
 
-        # add an OBJECT only 2nd pass on the standard SceneGraph if SEMANTIC sensor with separate semantic SceneGraph
-        if (
-            self._spec.sensor_type == SensorType.SEMANTIC
-            and self._sim.get_active_scene_graph()
-            is not self._sim.get_active_semantic_scene_graph()
-        ):
-            agent_node.parent = self._sim.get_active_scene_graph().get_root_node()
-            render_flags |= habitat_sim.gfx.Camera.Flags.OBJECTS_ONLY
-            self._sim.renderer.draw(
-                self._sensor_object, self._sim.get_active_scene_graph(), render_flags
-            )
+            # add an OBJECT only 2nd pass on the standard SceneGraph if SEMANTIC sensor with separate semantic SceneGraph,
+            # before the render target resolves its samples on exit
+            if (
+                self._spec.sensor_type == SensorType.SEMANTIC
+                and self._sim.get_active_scene_graph()
+                is not self._sim.get_active_semantic_scene_graph()
+            ):
+                agent_node.parent = self._sim.get_active_scene_graph().get_root_node()
+                render_flags |= habitat_sim.gfx.Camera.Flags.OBJECTS_ONLY
+                self._sim.renderer.draw(
+                    self._sensor_object,
+                    self._sim.get_active_scene_graph(),
+                    render_flags,
+                )
 
     def get_observation(self):
 
+        if not self._is_visual:
+            obs = Observation()
+            self._sensor_object.get_observation(self._sim, obs)
+            return np.array(obs.buffer)
+
         tgt = self._sensor_object.render_target
 
-        if self._spec.gpu2gpu_transfer:
+        if self._is_converted or (
+            self._is_cube_map and self._sensor_object.is_equirectangular
+        ):
+            # converted on the GPU, or resampled from the faces on the CPU
+            obs = Observation()
+            self._sensor_object.read_observation(obs)
+            self._buffer[...] = np.asarray(obs.buffer).reshape(self._buffer.shape)
+            obs = np.flip(self._buffer, axis=0)
+        elif self._spec.gpu2gpu_transfer:
             with torch.cuda.device(self._buffer.device):
                 if self._spec.sensor_type == SensorType.SEMANTIC:
                     tgt.read_frame_object_id_gpu(self._buffer.data_ptr())
                 elif self._spec.sensor_type == SensorType.DEPTH:
                     tgt.read_frame_depth_gpu(self._buffer.data_ptr())
+                    # run the noise directly on the readback buffer if possible
+                    if self._noise_model.apply_in_place_gpu(
+                        self._buffer, flipped=True
+                    ):
+                        return self._buffer.flip(0)
                 else:
                     tgt.read_frame_rgba_gpu(self._buffer.data_ptr())
+                    if self._noise_model.apply_in_place_gpu(
+                        self._buffer, flipped=True
+                    ):
+                        return self._buffer.flip(0)
 
                 obs = self._buffer.flip(0)
         else:
@@ -469,6 +710,24 @@ class Sensor:
                 tgt.read_frame_depth(
                     mn.MutableImageView2D(mn.PixelFormat.R32F, size, self._buffer)
                 )
+            elif self._spec.sensor_type == SensorType.NORMAL:
+                tgt.read_frame_surface_normals(
+                    mn.MutableImageView2D(
+                        mn.PixelFormat.RGB32F,
+                        size,
+                        self._buffer.reshape(self._spec.resolution[0], -1),
+                    )
+                )
+            elif self._spec.sensor_type == SensorType.OPTICAL_FLOW:
+                tgt.read_frame_motion_vectors(
+                    mn.MutableImageView2D(
+                        mn.PixelFormat.RG32F,
+                        size,
+                        self._buffer.reshape(self._spec.resolution[0], -1),
+                    )
+                )
+                # the rows are flipped to go down the image, and so is the flow
+                self._buffer[..., 1] *= -1.0
             else:
                 tgt.read_frame_rgba(
                     mn.MutableImageView2D(
@@ -482,6 +741,28 @@ class Sensor:
 
         return self._noise_model(obs)
 
+    def _observation_from(self, obs):
+        r"""The observation a native read filled obs with, as get_observation()
+        returns it
+        """
+        if not self._is_visual:
+            return np.array(obs.buffer)
+        self._buffer[...] = np.asarray(obs.buffer).reshape(self._buffer.shape)
+        if self._spec.sensor_type == SensorType.OPTICAL_FLOW and not self._is_converted:
+            self._buffer[..., 1] *= -1.0
+        return self._noise_model(np.flip(self._buffer, axis=0))
+
+    def _schedule_update(self):
+        r"""Whether the sensor observes in this get_sensor_observations()"""
+        period = self._spec.update_period
+        due = period > 0 and self._update_calls % period == 0
+        self._update_calls += 1
+        return due
+
+    def _reset_update_schedule(self):
+        self._update_calls = 0
+        self._last_observation = None
+
     def close(self):
         self._sim = None
         self._agent = None
@@ -41,6 +41,26 @@ def quat_to_coeffs(quat: np.quaternion) -> np.ndarray:
     return coeffs
 
 
+def quats_from_coeffs(coeffs: np.ndarray) -> np.ndarray:
+    r"""Batched :ref:`quat_from_coeffs`, for an Nx4 array of coeffs, e.g. as
+    returned by :ref:`habitat_sim.geo.rotation_matrices_to_quaternions`
+
+    :param coeffs: Coefficients of quaternions in :py:`[b, c, d, a]` format
+    :return: An array of N quaternions
+    """
+    coeffs = np.asarray(coeffs)
+    return quaternion.as_quat_array(np.roll(coeffs, 1, axis=-1))
+
+
+def quats_to_coeffs(quats: np.ndarray) -> np.ndarray:
+    r"""Batched :ref:`quat_to_coeffs`, for an array of N quaternions
+
+    :param quats: The quaternions
+    :return: An Nx4 array of coefficients in :py:`[b, c, d, a]` format
+    """
+    return np.roll(quaternion.as_float_array(quats), -1, axis=-1)
+
+
 def quat_to_magnum(quat: np.quaternion) -> mn.Quaternion:
     return mn.Quaternion(quat.imag, quat.real)
 
@@ -66,6 +66,12 @@ Use "HEADLESS=True pip install ." to build in headless mode with pip""",
         action="store_true",
         help="Build data tool",
     )
+    parser.add_argument(
+        "--build-benchmark",
+        dest="build_benchmark",
+        action="store_true",
+        help="Build the native benchmark",
+    )
     parser.add_argument(
         "--cmake-args",
         type=str,
@@ -257,6 +263,9 @@ class CMakeBuild(build_ext):
         cmake_args += [
             "-DBUILD_DATATOOL={}".format("ON" if args.build_datatool else "OFF")
         ]
+        cmake_args += [
+            "-DBUILD_BENCHMARK={}".format("ON" if args.build_benchmark else "OFF")
+        ]
         cmake_args += ["-DBUILD_WITH_CUDA={}".format("ON" if args.with_cuda else "OFF")]
 
         env = os.environ.copy()
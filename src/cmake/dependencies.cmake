@@ -90,6 +90,14 @@ if(BUILD_ASSIMP_SUPPORT)
   find_package(Assimp REQUIRED)
 endif()
 
+# meshoptimizer and Draco, decoding the compressed geometry of glTF files
+if(BUILD_MESHOPT_SUPPORT)
+  find_package(meshoptimizer CONFIG REQUIRED)
+endif()
+if(BUILD_DRACO_SUPPORT)
+  find_package(draco CONFIG REQUIRED)
+endif()
+
 # recast
 set(RECASTNAVIGATION_DEMO OFF CACHE BOOL "RECASTNAVIGATION_DEMO" FORCE)
 set(RECASTNAVIGATION_TESTS OFF CACHE BOOL "RECASTNAVIGATION_TESTS" FORCE)
@@ -8,8 +8,11 @@
 #include <Magnum/EigenIntegration/Integration.h>
 
 #include "esp/scene/ObjectControls.h"
+#include "esp/sensor/CubeMapCamera.h"
+#include "esp/sensor/LidarSensor.h"
 #include "esp/sensor/PinholeCamera.h"
 #include "esp/sensor/Sensor.h"
+#include "esp/sensor/TopDownMapCamera.h"
 
 using Magnum::EigenIntegration::cast;
 
@@ -24,46 +27,101 @@ Agent::Agent(scene::SceneNode& agentNode, const AgentConfiguration& cfg)
     : Magnum::SceneGraph::AbstractFeature3D(agentNode),
       configuration_(cfg),
       sensors_(),
-      controls_(scene::ObjectControls::create()) {
+      controls_(scene::ObjectControls::create()),
+      velocityControl_(physics::VelocityControl::create()) {
   agentNode.setType(scene::SceneNodeType::AGENT);
   for (sensor::SensorSpec::ptr spec : cfg.sensorSpecifications) {
     // TODO: this should take type into account to create appropriate
     // sensor
 
     auto& sensorNode = agentNode.createChild();
-    sensors_.add(
-        sensor::PinholeCamera::create(sensorNode, spec));  // transformed within
+    if (sensor::LidarSensor::isLidarSpec(*spec)) {
+      sensors_.add(sensor::LidarSensor::create(sensorNode, spec));
+    } else if (sensor::CubeMapCamera::isCubeMapSpec(*spec)) {
+      sensors_.add(sensor::CubeMapCamera::create(sensorNode, spec));
+    } else if (sensor::TopDownMapCamera::isTopDownMapSpec(*spec)) {
+      sensors_.add(sensor::TopDownMapCamera::create(sensorNode, spec));
+    } else {
+      sensors_.add(sensor::PinholeCamera::create(
+          sensorNode, spec));  // transformed within
+    }
   }
+  compileActions();
 }
 
 Agent::~Agent() {
-  LOG(INFO) << "Deconstructing Agent";
+  VLOG(1) << "Deconstructing Agent";
   sensors_.clear();
 }
 
 bool Agent::act(const std::string& actionName) {
-  if (hasAction(actionName)) {
-    const ActionSpec& actionSpec = *configuration_.actionSpace.at(actionName);
-    if (BodyActions.find(actionSpec.name) != BodyActions.end()) {
-      controls_->action(object(), actionSpec.name,
+  auto action = configuration_.actionSpace.find(actionName);
+  if (action == configuration_.actionSpace.end()) {
+    return false;
+  }
+  const ActionSpec& actionSpec = *action->second;
+  if (BodyActions.find(actionSpec.name) != BodyActions.end()) {
+    controls_->action(object(), actionSpec.name,
+                      actionSpec.actuation.at("amount"),
+                      /*applyFilter=*/true);
+  } else {
+    for (const auto& p : sensors_.getSensors()) {
+      controls_->action(p.second->object(), actionSpec.name,
                         actionSpec.actuation.at("amount"),
-                        /*applyFilter=*/true);
-    } else {
-      for (auto p : sensors_.getSensors()) {
-        controls_->action(p.second->object(), actionSpec.name,
-                          actionSpec.actuation.at("amount"),
-                          /*applyFilter=*/false);
-      }
+                        /*applyFilter=*/false);
     }
-    return true;
-  } else {
+  }
+  return true;
+}
+
+bool Agent::act(const int actionIndex, const bool applyFilter) {
+  if (actionIndex < 0 || actionIndex >= compiledActions_.size()) {
+    return false;
+  }
+  const CompiledAction& action = compiledActions_[actionIndex];
+  if (!action.moveFunc) {
     return false;
   }
+  if (action.isBodyAction) {
+    controls_->applyMoveFunc(object(), *action.moveFunc, action.amount,
+                             applyFilter);
+  } else {
+    for (const auto& p : sensors_.getSensors()) {
+      controls_->applyMoveFunc(p.second->object(), *action.moveFunc,
+                               action.amount, /*applyFilter=*/false);
+    }
+  }
+  return true;
+}
+
+bool Agent::hasAction(const std::string& actionName) const {
+  return configuration_.actionSpace.count(actionName) > 0;
 }
 
-bool Agent::hasAction(const std::string& actionName) {
-  auto actionSpace = configuration_.actionSpace;
-  return !(actionSpace.find(actionName) == actionSpace.end());
+int Agent::getActionIndex(const std::string& actionName) const {
+  auto index = actionIndices_.find(actionName);
+  return index == actionIndices_.end() ? ID_UNDEFINED : index->second;
+}
+
+void Agent::compileActions() {
+  compiledActions_.clear();
+  actionIndices_.clear();
+  for (const auto& action : configuration_.actionSpace) {
+    const ActionSpec& actionSpec = *action.second;
+    CompiledAction compiled;
+    auto amount = actionSpec.actuation.find("amount");
+    if (amount != actionSpec.actuation.end()) {
+      compiled.moveFunc = controls_->getMoveFunc(actionSpec.name);
+      compiled.amount = amount->second;
+    }
+    if (!compiled.moveFunc) {
+      LOG(WARNING) << "Agent::compileActions : action " << action.first
+                   << " has no move function or amount, it can't be taken";
+    }
+    compiled.isBodyAction = BodyActions.count(actionSpec.name) > 0;
+    actionIndices_[action.first] = compiledActions_.size();
+    compiledActions_.push_back(compiled);
+  }
 }
 
 void Agent::reset() {
@@ -110,7 +168,10 @@ bool operator==(const AgentConfiguration& a, const AgentConfiguration& b) {
          a.angularFriction == b.angularFriction &&
          a.coefficientOfRestitution == b.coefficientOfRestitution &&
          esp::equal(a.sensorSpecifications, b.sensorSpecifications) &&
-         esp::equal(a.actionSpace, b.actionSpace) && a.bodyType == b.bodyType;
+         esp::equal(a.actionSpace, b.actionSpace) &&
+         a.bodyType == b.bodyType &&
+         a.velocityControlSubstep == b.velocityControlSubstep &&
+         a.velocityControlAllowSliding == b.velocityControlAllowSliding;
 }
 bool operator!=(const AgentConfiguration& a, const AgentConfiguration& b) {
   return !(a == b);
@@ -7,8 +7,10 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "esp/core/esp.h"
+#include "esp/physics/RigidObject.h"
 #include "esp/scene/ObjectControls.h"
 #include "esp/scene/SceneNode.h"
 #include "esp/sensor/Sensor.h"
@@ -74,6 +76,12 @@ struct AgentConfiguration {
        ActionSpec::create("turnRight", ActuationMap{{"amount", 10.0f}})}};
   std::string bodyType = "cylinder";
 
+  // longest timestep the native velocity control of the body integrates over
+  // at once, see sim::Simulator::stepAgentVelocityControl()
+  float velocityControlSubstep = 1.0f / 120.0f;
+  // whether the velocity controlled body slides along navmesh boundaries
+  bool velocityControlAllowSliding = true;
+
   ESP_SMART_POINTERS(AgentConfiguration)
 };
 bool operator==(const AgentConfiguration& a, const AgentConfiguration& b);
@@ -104,7 +112,46 @@ class Agent : public Magnum::SceneGraph::AbstractFeature3D {
 
   bool act(const std::string& actionName);
 
-  bool hasAction(const std::string& actionName);
+  /**
+   * @brief Act with the action of index @p actionIndex in the action table
+   * compiled by @ref compileActions(), see @ref getActionIndex(). Dispatches
+   * straight to the move function with the pre-resolved amount, without any
+   * string lookup.
+   * @param actionIndex The index of the action
+   * @param applyFilter Whether to pass the move of a body action through the
+   * move filter of @ref getControls(). Callers filtering the moves of many
+   * agents in a batch, like @ref sim::Simulator::actAll(), skip it.
+   * @return false if there is no such action, or it has no move function or
+   * amount
+   */
+  bool act(int actionIndex, bool applyFilter = true);
+
+  /**
+   * @brief Whether the action of index @p actionIndex moves the body of the
+   * agent rather than only its sensors, see @ref BodyActions
+   */
+  bool isBodyAction(int actionIndex) const {
+    return actionIndex >= 0 && actionIndex < compiledActions_.size() &&
+           compiledActions_[actionIndex].isBodyAction;
+  }
+
+  bool hasAction(const std::string& actionName) const;
+
+  /**
+   * @brief The index of an action of the action space for @ref act(int), or
+   * @ref ID_UNDEFINED if there is no such action
+   */
+  int getActionIndex(const std::string& actionName) const;
+
+  /** @brief The number of actions in the compiled action table */
+  int getNumActions() const { return compiledActions_.size(); }
+
+  /**
+   * @brief Compile the action space of the configuration into the table used
+   * by @ref act(int), in the order of the action names. Done on construction,
+   * call it again after modifying the action space of @ref getConfig().
+   */
+  void compileActions();
 
   void reset();
 
@@ -120,6 +167,15 @@ class Agent : public Magnum::SceneGraph::AbstractFeature3D {
 
   scene::ObjectControls::ptr getControls() { return controls_; }
 
+  /**
+   * @brief The constant velocity control of the body of the agent, integrated
+   * natively by @ref sim::Simulator::stepAgentVelocityControl(). Controls
+   * nothing until enabled.
+   */
+  physics::VelocityControl::ptr getVelocityControl() {
+    return velocityControl_;
+  }
+
   const sensor::SensorSuite& getSensorSuite() const { return sensors_; }
   sensor::SensorSuite& getSensorSuite() { return sensors_; }
 
@@ -136,8 +192,20 @@ class Agent : public Magnum::SceneGraph::AbstractFeature3D {
   AgentConfiguration configuration_;
   sensor::SensorSuite sensors_;
   scene::ObjectControls::ptr controls_;
+  physics::VelocityControl::ptr velocityControl_;
   AgentState initialState_;
 
+  //! an action of the action space, resolved for act(int)
+  struct CompiledAction {
+    //! owned by controls_, nullptr if the action has no move function
+    const scene::ObjectControls::MoveFunc* moveFunc = nullptr;
+    float amount = 0.0f;
+    bool isBodyAction = false;
+  };
+  std::vector<CompiledAction> compiledActions_;
+  //! index of each action in compiledActions_, by name
+  std::map<std::string, int> actionIndices_;
+
   ESP_SMART_POINTERS(Agent)
 };
 
@@ -26,6 +26,8 @@
 namespace esp {
 namespace assets {
 
+class MeshArena;
+
 /**
   @brief Enumeration of mesh types supported by the simulator.
 
@@ -97,6 +99,30 @@ class BaseMesh {
    */
   SupportedMeshType getMeshType() { return type_; }
 
+  /**
+   * @brief Set whether @ref uploadBuffersToGPU() uses compact vertex and index
+   * formats, shrinking the GPU memory and vertex bandwidth of the mesh.
+   *
+   * Meshes not supporting it upload their usual formats. Takes effect on the
+   * next upload, the CPU-side data is not changed.
+   */
+  void setCompactVertexFormat(bool compact) { compactVertexFormat_ = compact; }
+
+  /**
+   * @brief Whether the mesh is uploaded in compact formats, see @ref
+   * setCompactVertexFormat()
+   */
+  bool getCompactVertexFormat() const { return compactVertexFormat_; }
+
+  /**
+   * @brief Set the arena @ref uploadBuffersToGPU() suballocates the buffers
+   * of the mesh from, nullptr for buffers of its own
+   *
+   * Meshes not supporting it upload to buffers of their own. The arena is
+   * expected to outlive the upload, the allocations are kept by the mesh.
+   */
+  void setMeshArena(MeshArena* arena) { meshArena_ = arena; }
+
   /**
    * @brief Upload the mesh data to GPU memory.
    *
@@ -104,6 +130,12 @@ class BaseMesh {
    */
   virtual void uploadBuffersToGPU(bool){};
 
+  /**
+   * @brief Estimated GPU memory of the buffers uploaded by @ref
+   * uploadBuffersToGPU(), in bytes, 0 before the upload
+   */
+  std::size_t getGpuBytes() const { return gpuBytes_; }
+
   /**
    * @brief Get a pointer to the compiled rendering buffer for the asset.
    *
@@ -164,6 +196,23 @@ class BaseMesh {
    */
   bool buffersOnGPU_ = false;
 
+  /**
+   * @brief Whether the mesh is uploaded in compact formats, see @ref
+   * setCompactVertexFormat()
+   */
+  bool compactVertexFormat_ = false;
+
+  /**
+   * @brief The arena the buffers are uploaded to, see @ref setMeshArena()
+   */
+  MeshArena* meshArena_ = nullptr;
+
+  /**
+   * @brief Estimated GPU memory of the uploaded buffers, see @ref
+   * getGpuBytes()
+   */
+  std::size_t gpuBytes_ = 0;
+
   // ==== rendering ===
   /**
    * @brief Optional storage container for mesh render data.
@@ -0,0 +1,913 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CompressedGltf.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/String.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/esp.h"
+#include "esp/io/json.h"
+
+#ifdef ESP_BUILD_MESHOPT_SUPPORT
+#include <meshoptimizer.h>
+#endif
+#ifdef ESP_BUILD_DRACO_SUPPORT
+#include <draco/compression/decode.h>
+#endif
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+constexpr const char* MeshoptExtension = "EXT_meshopt_compression";
+constexpr const char* DracoExtension = "KHR_draco_mesh_compression";
+
+constexpr uint32_t GlbMagic = 0x46546c67;      // glTF
+constexpr uint32_t GlbJsonChunk = 0x4e4f534a;  // JSON
+constexpr uint32_t GlbBinChunk = 0x004e4942;   // BIN
+
+// glTF accessor component types
+constexpr unsigned ComponentByte = 5120;
+constexpr unsigned ComponentUnsignedByte = 5121;
+constexpr unsigned ComponentShort = 5122;
+constexpr unsigned ComponentUnsignedShort = 5123;
+constexpr unsigned ComponentUnsignedInt = 5125;
+constexpr unsigned ComponentFloat = 5126;
+
+//! a glTF file, its JSON and the binary chunk of a GLB
+struct GltfFile {
+  std::string directory;
+  io::JsonDocument json;
+  std::string bin;
+  bool hasBin = false;
+  //! the data of the buffers with an uri, read when first used
+  std::unordered_map<unsigned, std::string> buffers;
+};
+
+uint32_t readUint32(const char* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void appendUint32(std::string& out, uint32_t value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::size_t align4(std::size_t size) {
+  return (size + 3) & ~std::size_t(3);
+}
+
+unsigned uintMember(const io::JsonGenericValue& value,
+                    const char* name,
+                    unsigned defaultValue = 0) {
+  return value.HasMember(name) && value[name].IsUint() ? value[name].GetUint()
+                                                       : defaultValue;
+}
+
+std::string stringMember(const io::JsonGenericValue& value,
+                         const char* name,
+                         const std::string& defaultValue) {
+  return value.HasMember(name) && value[name].IsString()
+             ? value[name].GetString()
+             : defaultValue;
+}
+
+//! the object extension @p extension of @p value, nullptr if it has none
+io::JsonGenericValue* extensionOf(io::JsonGenericValue& value,
+                                  const char* extension) {
+  if (!value.IsObject() || !value.HasMember("extensions") ||
+      !value["extensions"].IsObject() ||
+      !value["extensions"].HasMember(extension) ||
+      !value["extensions"][extension].IsObject()) {
+    return nullptr;
+  }
+  return &value["extensions"][extension];
+}
+
+//! set member @p name of the object @p value to @p number
+void setUint(io::JsonGenericValue& value,
+             const char* name,
+             std::size_t number,
+             io::JsonDocument::AllocatorType& allocator) {
+  if (value.HasMember(name)) {
+    value[name].SetUint(number);
+  } else {
+    value.AddMember(rapidjson::StringRef(name), unsigned(number), allocator);
+  }
+}
+
+//! the array member @p name of the JSON root, added if missing
+io::JsonGenericValue& rootArray(io::JsonDocument& json, const char* name) {
+  if (!json.HasMember(name) || !json[name].IsArray()) {
+    json.RemoveMember(name);
+    json.AddMember(rapidjson::StringRef(name),
+                   rapidjson::Value(rapidjson::kArrayType),
+                   json.GetAllocator());
+  }
+  return json[name];
+}
+
+bool usesExtension(const io::JsonDocument& json, const char* extension) {
+  if (!json.HasMember("extensionsUsed") || !json["extensionsUsed"].IsArray()) {
+    return false;
+  }
+  for (const auto& used : json["extensionsUsed"].GetArray()) {
+    if (used.IsString() && std::strcmp(used.GetString(), extension) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//! remove @p extension from the used and required extensions, or add it
+void setExtensionUsed(io::JsonDocument& json,
+                      const char* extension,
+                      bool used) {
+  for (const char* list : {"extensionsUsed", "extensionsRequired"}) {
+    io::JsonGenericValue& extensions = rootArray(json, list);
+    for (auto it = extensions.Begin(); it != extensions.End();) {
+      if (it->IsString() && std::strcmp(it->GetString(), extension) == 0) {
+        it = extensions.Erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (used) {
+      extensions.PushBack(rapidjson::StringRef(extension),
+                          json.GetAllocator());
+    } else if (extensions.Empty()) {
+      json.RemoveMember(list);
+    }
+  }
+}
+
+//! the JSON text and the binary chunk of @p data, the contents of a glTF or
+//! GLB file
+bool splitGltf(const std::string& data,
+               std::string& jsonText,
+               std::string& bin,
+               bool& hasBin) {
+  hasBin = false;
+  if (data.size() < 12 || readUint32(data.data()) != GlbMagic) {
+    jsonText = data;
+    return true;
+  }
+  const std::size_t length =
+      std::min<std::size_t>(readUint32(data.data() + 8), data.size());
+  bool hasJson = false;
+  for (std::size_t offset = 12; offset + 8 <= length;) {
+    const uint32_t chunkLength = readUint32(data.data() + offset);
+    const uint32_t chunkType = readUint32(data.data() + offset + 4);
+    offset += 8;
+    if (offset + chunkLength > length) {
+      return false;
+    }
+    if (chunkType == GlbJsonChunk && !hasJson) {
+      jsonText.assign(data, offset, chunkLength);
+      hasJson = true;
+    } else if (chunkType == GlbBinChunk && !hasBin) {
+      bin.assign(data, offset, chunkLength);
+      hasBin = true;
+    }
+    offset += align4(chunkLength);
+  }
+  return hasJson;
+}
+
+//! just the JSON of the glTF or GLB file @p filename
+bool readGltfJson(const std::string& filename, std::string& jsonText) {
+  std::ifstream file(filename, std::ios::binary);
+  char header[20];
+  if (!file.read(header, sizeof(header))) {
+    return false;
+  }
+  if (readUint32(header) != GlbMagic) {
+    file.seekg(0);
+    jsonText.assign(std::istreambuf_iterator<char>{file},
+                    std::istreambuf_iterator<char>{});
+    return true;
+  }
+  if (readUint32(header + 16) != GlbJsonChunk) {
+    return false;
+  }
+  jsonText.resize(readUint32(header + 12));
+  return bool(file.read(&jsonText[0], jsonText.size()));
+}
+
+bool readGltf(const std::string& filename, GltfFile& file) {
+  if (!Cr::Utility::Directory::exists(filename)) {
+    LOG(ERROR) << "readGltf : Cannot open " << filename;
+    return false;
+  }
+  std::string jsonText;
+  if (!splitGltf(Cr::Utility::Directory::readString(filename), jsonText,
+                 file.bin, file.hasBin)) {
+    LOG(ERROR) << "readGltf : Invalid GLB " << filename;
+    return false;
+  }
+  file.json.Parse(jsonText.c_str());
+  if (file.json.HasParseError() || !file.json.IsObject()) {
+    LOG(ERROR) << "readGltf : Invalid glTF JSON in " << filename;
+    return false;
+  }
+  // added up front, adding members later would move the references to them
+  for (const char* name : {"buffers", "bufferViews", "accessors"}) {
+    rootArray(file.json, name);
+  }
+  file.directory = Cr::Utility::Directory::path(filename);
+  return true;
+}
+
+//! the data of buffer @p index, nullptr if it has none
+const std::string* bufferData(GltfFile& file, unsigned index) {
+  io::JsonGenericValue& buffers = rootArray(file.json, "buffers");
+  if (index >= buffers.Size()) {
+    return nullptr;
+  }
+  const io::JsonGenericValue& buffer = buffers[index];
+  if (!buffer.HasMember("uri") || !buffer["uri"].IsString()) {
+    return index == 0 && file.hasBin ? &file.bin : nullptr;
+  }
+  auto found = file.buffers.find(index);
+  if (found != file.buffers.end()) {
+    return &found->second;
+  }
+  const std::string uri = buffer["uri"].GetString();
+  const std::string path = Cr::Utility::Directory::join(file.directory, uri);
+  if (Cr::Utility::String::beginsWith(uri, "data:") ||
+      !Cr::Utility::Directory::exists(path)) {
+    LOG(ERROR) << "readGltf : Cannot read buffer " << index << " from "
+               << uri.substr(0, 64);
+    return nullptr;
+  }
+  return &(file.buffers[index] = Cr::Utility::Directory::readString(path));
+}
+
+//! the data of buffer view @p index
+bool bufferViewData(GltfFile& file,
+                    unsigned index,
+                    const char*& data,
+                    std::size_t& size) {
+  io::JsonGenericValue& views = rootArray(file.json, "bufferViews");
+  if (index >= views.Size()) {
+    return false;
+  }
+  const io::JsonGenericValue& view = views[index];
+  const std::string* buffer = bufferData(file, uintMember(view, "buffer"));
+  const std::size_t offset = uintMember(view, "byteOffset");
+  size = uintMember(view, "byteLength");
+  if (!buffer || offset + size > buffer->size()) {
+    return false;
+  }
+  data = buffer->data() + offset;
+  return true;
+}
+
+//! @p json and @p bin written as a GLB
+std::string writeGlb(const io::JsonDocument& json, std::string bin) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer{buffer};
+  json.Accept(writer);
+  std::string jsonText{buffer.GetString(), buffer.GetSize()};
+  // the chunks are 4-byte aligned, JSON with spaces
+  jsonText.resize(align4(jsonText.size()), ' ');
+  bin.resize(align4(bin.size()), '\0');
+
+  std::string glb;
+  glb.reserve(28 + jsonText.size() + bin.size());
+  appendUint32(glb, GlbMagic);
+  appendUint32(glb, 2);
+  appendUint32(glb, 12 + 8 + jsonText.size() + (bin.empty() ? 0 : 8) +
+                        bin.size());
+  appendUint32(glb, jsonText.size());
+  appendUint32(glb, GlbJsonChunk);
+  glb += jsonText;
+  if (!bin.empty()) {
+    appendUint32(glb, bin.size());
+    appendUint32(glb, GlbBinChunk);
+    glb += bin;
+  }
+  return glb;
+}
+
+unsigned componentCount(const std::string& type) {
+  if (type == "SCALAR") {
+    return 1;
+  }
+  if (type == "VEC2") {
+    return 2;
+  }
+  if (type == "VEC3") {
+    return 3;
+  }
+  return type == "VEC4" ? 4 : 0;
+}
+
+std::size_t componentSize(unsigned componentType) {
+  switch (componentType) {
+    case ComponentByte:
+    case ComponentUnsignedByte:
+      return 1;
+    case ComponentShort:
+    case ComponentUnsignedShort:
+      return 2;
+    default:
+      return 4;
+  }
+}
+
+/**
+ * Buffer views decoded into the binary chunk of a GLB, buffer 0. The views
+ * are collected apart, so that the data they are decoded from stays valid,
+ * and appended once all are decoded.
+ */
+struct DecodedViews {
+  //! the offset of the decoded views in the binary chunk
+  std::size_t binOffset;
+  std::string data;
+
+  //! room for @p size bytes, at the offset in the binary chunk returned
+  std::size_t allocate(std::size_t size) {
+    const std::size_t offset = align4(data.size());
+    data.resize(offset + size);
+    return offset;
+  }
+  char* at(std::size_t offset) { return &data[offset]; }
+
+  //! a new buffer view of the allocated @p offset and @p size
+  unsigned addView(io::JsonDocument& json,
+                   std::size_t offset,
+                   std::size_t size) {
+    io::JsonGenericValue& views = rootArray(json, "bufferViews");
+    rapidjson::Value view{rapidjson::kObjectType};
+    view.AddMember("buffer", 0u, json.GetAllocator());
+    view.AddMember("byteOffset", unsigned(binOffset + offset),
+                   json.GetAllocator());
+    view.AddMember("byteLength", unsigned(size), json.GetAllocator());
+    views.PushBack(view, json.GetAllocator());
+    return views.Size() - 1;
+  }
+};
+
+#ifdef ESP_BUILD_MESHOPT_SUPPORT
+bool decodeMeshoptView(GltfFile& file,
+                       io::JsonGenericValue& view,
+                       DecodedViews& decoded) {
+  io::JsonGenericValue& extension = *extensionOf(view, MeshoptExtension);
+  const std::string* source =
+      bufferData(file, uintMember(extension, "buffer"));
+  const std::size_t sourceOffset = uintMember(extension, "byteOffset");
+  const std::size_t sourceSize = uintMember(extension, "byteLength");
+  const std::size_t stride = uintMember(extension, "byteStride");
+  const std::size_t count = uintMember(extension, "count");
+  const std::string mode = stringMember(extension, "mode", "ATTRIBUTES");
+  const std::string filter = stringMember(extension, "filter", "NONE");
+  if (!source || sourceOffset + sourceSize > source->size() || stride == 0) {
+    return false;
+  }
+
+  const std::size_t offset = decoded.allocate(count * stride);
+  void* destination = decoded.at(offset);
+  const auto* data =
+      reinterpret_cast<const unsigned char*>(source->data() + sourceOffset);
+  int result;
+  if (mode == "TRIANGLES") {
+    result = meshopt_decodeIndexBuffer(destination, count, stride, data,
+                                       sourceSize);
+  } else if (mode == "INDICES") {
+    result = meshopt_decodeIndexSequence(destination, count, stride, data,
+                                         sourceSize);
+  } else {
+    result = meshopt_decodeVertexBuffer(destination, count, stride, data,
+                                        sourceSize);
+  }
+  if (result != 0) {
+    return false;
+  }
+  if (filter == "OCTAHEDRAL") {
+    meshopt_decodeFilterOct(destination, count, stride);
+  } else if (filter == "QUATERNION") {
+    meshopt_decodeFilterQuat(destination, count, stride);
+  } else if (filter == "EXPONENTIAL") {
+    meshopt_decodeFilterExp(destination, count, stride);
+  }
+
+  auto& allocator = file.json.GetAllocator();
+  setUint(view, "buffer", 0, allocator);
+  setUint(view, "byteOffset", decoded.binOffset + offset, allocator);
+  setUint(view, "byteLength", count * stride, allocator);
+  view["extensions"].RemoveMember(MeshoptExtension);
+  return true;
+}
+#endif
+
+#ifdef ESP_BUILD_DRACO_SUPPORT
+template <class T>
+bool convertDracoAttribute(const draco::PointAttribute& attribute,
+                           uint32_t numPoints,
+                           unsigned components,
+                           char* out) {
+  T* values = reinterpret_cast<T*>(out);
+  for (uint32_t i = 0; i < numPoints; ++i) {
+    if (!attribute.ConvertValue<T>(attribute.mapped_index(draco::PointIndex(i)),
+                                   components, values + i * components)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool decodeDracoPrimitive(GltfFile& file,
+                          io::JsonGenericValue& primitive,
+                          DecodedViews& decoded) {
+  io::JsonGenericValue& extension = *extensionOf(primitive, DracoExtension);
+  const char* viewData;
+  std::size_t viewSize;
+  if (!bufferViewData(file, uintMember(extension, "bufferView"), viewData,
+                      viewSize) ||
+      !extension.HasMember("attributes") ||
+      !extension["attributes"].IsObject()) {
+    return false;
+  }
+  draco::DecoderBuffer buffer;
+  buffer.Init(viewData, viewSize);
+  draco::Decoder decoder;
+  auto status = decoder.DecodeMeshFromBuffer(&buffer);
+  if (!status.ok()) {
+    LOG(ERROR) << "decompressGltf : " << status.status().error_msg_string();
+    return false;
+  }
+  const std::unique_ptr<draco::Mesh> mesh = std::move(status).value();
+
+  auto& allocator = file.json.GetAllocator();
+  io::JsonGenericValue& accessors = rootArray(file.json, "accessors");
+  // the accessors the decoded data is written to, in new views
+  const auto write = [&](unsigned accessorIndex, unsigned componentType,
+                         std::size_t count, std::size_t size) {
+    io::JsonGenericValue& accessor = accessors[accessorIndex];
+    const std::size_t offset = decoded.allocate(size);
+    setUint(accessor, "bufferView",
+            decoded.addView(file.json, offset, size), allocator);
+    setUint(accessor, "byteOffset", 0, allocator);
+    setUint(accessor, "componentType", componentType, allocator);
+    setUint(accessor, "count", count, allocator);
+    return offset;
+  };
+
+  if (primitive.HasMember("indices")) {
+    const unsigned indices = uintMember(primitive, "indices");
+    if (indices >= accessors.Size()) {
+      return false;
+    }
+    const std::size_t count = mesh->num_faces() * 3;
+    const std::size_t offset =
+        write(indices, ComponentUnsignedInt, count, count * sizeof(uint32_t));
+    auto* out = reinterpret_cast<uint32_t*>(decoded.at(offset));
+    for (draco::FaceIndex face{0}; face < mesh->num_faces(); ++face) {
+      for (int corner = 0; corner < 3; ++corner) {
+        *out++ = mesh->face(face)[corner].value();
+      }
+    }
+  }
+
+  if (!primitive.HasMember("attributes") ||
+      !primitive["attributes"].IsObject()) {
+    return false;
+  }
+  for (const auto& member : extension["attributes"].GetObject()) {
+    const char* name = member.name.GetString();
+    if (!member.value.IsUint() || !primitive["attributes"].HasMember(name)) {
+      continue;
+    }
+    const unsigned accessorIndex = uintMember(primitive["attributes"], name);
+    const draco::PointAttribute* attribute =
+        mesh->GetAttributeByUniqueId(member.value.GetUint());
+    if (!attribute || accessorIndex >= accessors.Size()) {
+      return false;
+    }
+    const io::JsonGenericValue& accessor = accessors[accessorIndex];
+    const unsigned componentType = uintMember(accessor, "componentType");
+    const unsigned components =
+        componentCount(stringMember(accessor, "type", ""));
+    if (components == 0) {
+      return false;
+    }
+    const uint32_t numPoints = mesh->num_points();
+    const std::size_t offset =
+        write(accessorIndex, componentType, numPoints,
+              numPoints * components * componentSize(componentType));
+    char* out = decoded.at(offset);
+    bool converted;
+    switch (componentType) {
+      case ComponentByte:
+        converted = convertDracoAttribute<int8_t>(*attribute, numPoints,
+                                                  components, out);
+        break;
+      case ComponentUnsignedByte:
+        converted = convertDracoAttribute<uint8_t>(*attribute, numPoints,
+                                                   components, out);
+        break;
+      case ComponentShort:
+        converted = convertDracoAttribute<int16_t>(*attribute, numPoints,
+                                                   components, out);
+        break;
+      case ComponentUnsignedShort:
+        converted = convertDracoAttribute<uint16_t>(*attribute, numPoints,
+                                                    components, out);
+        break;
+      case ComponentUnsignedInt:
+        converted = convertDracoAttribute<uint32_t>(*attribute, numPoints,
+                                                    components, out);
+        break;
+      case ComponentFloat:
+        converted = convertDracoAttribute<float>(*attribute, numPoints,
+                                                 components, out);
+        break;
+      default:
+        converted = false;
+    }
+    if (!converted) {
+      return false;
+    }
+  }
+  primitive["extensions"].RemoveMember(DracoExtension);
+  return true;
+}
+#endif
+
+}  // namespace
+
+bool isCompressedGltf(const std::string& filename) {
+  const std::string extension =
+      Cr::Utility::String::lowercase(Cr::Utility::Directory::splitExtension(
+                                         filename)
+                                         .second);
+  std::string jsonText;
+  if ((extension != ".glb" && extension != ".gltf") ||
+      !readGltfJson(filename, jsonText)) {
+    return false;
+  }
+  io::JsonDocument json;
+  json.Parse(jsonText.c_str());
+  return !json.HasParseError() && json.IsObject() &&
+         (usesExtension(json, MeshoptExtension) ||
+          usesExtension(json, DracoExtension));
+}
+
+Cr::Containers::Optional<std::string> decompressGltf(
+    const std::string& filename) {
+  core::ScopedTraceEvent trace{"decompressGltf", "assets"};
+  GltfFile file;
+  if (!readGltf(filename, file)) {
+    return Cr::Containers::NullOpt;
+  }
+  io::JsonDocument& json = file.json;
+  auto& allocator = json.GetAllocator();
+  io::JsonGenericValue& buffers = rootArray(json, "buffers");
+  io::JsonGenericValue& views = rootArray(json, "bufferViews");
+
+  // the decoded views go to the binary chunk, buffer 0, so a glTF without
+  // one gets a new first buffer
+  if (!file.hasBin || buffers.Empty() || buffers[0].HasMember("uri")) {
+    rapidjson::Value shifted{rapidjson::kArrayType};
+    shifted.PushBack(rapidjson::Value{rapidjson::kObjectType}, allocator);
+    for (auto& buffer : buffers.GetArray()) {
+      shifted.PushBack(buffer, allocator);
+    }
+    buffers = shifted;
+    for (auto& view : views.GetArray()) {
+      setUint(view, "buffer", uintMember(view, "buffer") + 1, allocator);
+      if (io::JsonGenericValue* meshopt = extensionOf(view, MeshoptExtension)) {
+        setUint(*meshopt, "buffer", uintMember(*meshopt, "buffer") + 1,
+                allocator);
+      }
+    }
+    file.bin.clear();
+    file.hasBin = true;
+  }
+  DecodedViews decoded{align4(file.bin.size()), {}};
+
+  for (auto& view : views.GetArray()) {
+    if (!extensionOf(view, MeshoptExtension)) {
+      continue;
+    }
+#ifdef ESP_BUILD_MESHOPT_SUPPORT
+    if (!decodeMeshoptView(file, view, decoded)) {
+      LOG(ERROR) << "decompressGltf : Cannot decode a " << MeshoptExtension
+                 << " buffer view of " << filename;
+      return Cr::Containers::NullOpt;
+    }
+#else
+    LOG(ERROR) << "decompressGltf : " << filename << " uses "
+               << MeshoptExtension << ", built without BUILD_MESHOPT_SUPPORT";
+    return Cr::Containers::NullOpt;
+#endif
+  }
+  // the meshopt views are appended first, Draco data may be compressed by
+  // meshopt as well
+  file.bin.resize(decoded.binOffset);
+  file.bin += decoded.data;
+  decoded = DecodedViews{align4(file.bin.size()), {}};
+
+  if (json.HasMember("meshes") && json["meshes"].IsArray()) {
+    for (auto& mesh : json["meshes"].GetArray()) {
+      if (!mesh.HasMember("primitives") || !mesh["primitives"].IsArray()) {
+        continue;
+      }
+      for (auto& primitive : mesh["primitives"].GetArray()) {
+        if (!extensionOf(primitive, DracoExtension)) {
+          continue;
+        }
+#ifdef ESP_BUILD_DRACO_SUPPORT
+        if (!decodeDracoPrimitive(file, primitive, decoded)) {
+          LOG(ERROR) << "decompressGltf : Cannot decode a " << DracoExtension
+                     << " primitive of " << filename;
+          return Cr::Containers::NullOpt;
+        }
+#else
+        LOG(ERROR) << "decompressGltf : " << filename << " uses "
+                   << DracoExtension << ", built without BUILD_DRACO_SUPPORT";
+        return Cr::Containers::NullOpt;
+#endif
+      }
+    }
+  }
+  file.bin.resize(decoded.binOffset);
+  file.bin += decoded.data;
+
+  // drop the meshopt fallback buffers, which have no data, and point the
+  // views at the remaining ones
+  std::vector<unsigned> remap(buffers.Size());
+  rapidjson::Value kept{rapidjson::kArrayType};
+  for (unsigned i = 0; i < buffers.Size(); ++i) {
+    io::JsonGenericValue* meshopt = extensionOf(buffers[i], MeshoptExtension);
+    remap[i] = kept.Size();
+    if (i == 0 || !meshopt || buffers[i].HasMember("uri")) {
+      io::JsonGenericValue& buffer = buffers[i];
+      if (buffer.HasMember("uri") && buffer["uri"].IsString() &&
+          !Cr::Utility::String::beginsWith(buffer["uri"].GetString(),
+                                           "data:")) {
+        const std::string uri = Cr::Utility::Directory::join(
+            file.directory, buffer["uri"].GetString());
+        buffer["uri"].SetString(uri.c_str(), uri.size(), allocator);
+      }
+      kept.PushBack(buffer, allocator);
+    }
+  }
+  buffers = kept;
+  setUint(buffers[0], "byteLength", file.bin.size(), allocator);
+  for (auto& view : views.GetArray()) {
+    setUint(view, "buffer", remap[uintMember(view, "buffer")], allocator);
+  }
+  if (json.HasMember("images") && json["images"].IsArray()) {
+    for (auto& image : json["images"].GetArray()) {
+      if (image.HasMember("uri") && image["uri"].IsString() &&
+          !Cr::Utility::String::beginsWith(image["uri"].GetString(),
+                                           "data:")) {
+        const std::string uri = Cr::Utility::Directory::join(
+            file.directory, image["uri"].GetString());
+        image["uri"].SetString(uri.c_str(), uri.size(), allocator);
+      }
+    }
+  }
+  setExtensionUsed(json, MeshoptExtension, false);
+  setExtensionUsed(json, DracoExtension, false);
+  return writeGlb(json, std::move(file.bin));
+}
+
+bool compressGltf(const std::string& filename, const std::string& outputFile) {
+#ifndef ESP_BUILD_MESHOPT_SUPPORT
+  LOG(ERROR) << "compressGltf : Cannot compress " << filename
+             << ", built without BUILD_MESHOPT_SUPPORT";
+  return false;
+#else
+  core::ScopedTraceEvent trace{"compressGltf", "assets"};
+  GltfFile file;
+  if (!readGltf(filename, file)) {
+    return false;
+  }
+  io::JsonDocument& json = file.json;
+  if (usesExtension(json, MeshoptExtension) ||
+      usesExtension(json, DracoExtension)) {
+    LOG(ERROR) << "compressGltf : " << filename << " is already compressed";
+    return false;
+  }
+  auto& allocator = json.GetAllocator();
+  io::JsonGenericValue& views = rootArray(json, "bufferViews");
+  io::JsonGenericValue& accessors = rootArray(json, "accessors");
+
+  // how the meshes use each view, only views used in one way are encoded
+  enum class Use { None, Attributes, Triangles, Indices, Other };
+  struct ViewUse {
+    Use use = Use::None;
+    std::size_t stride = 0;
+  };
+  std::vector<ViewUse> uses(views.Size());
+  const auto markUse = [&](unsigned accessorIndex, Use use,
+                           std::size_t stride) {
+    if (accessorIndex >= accessors.Size() ||
+        !accessors[accessorIndex].HasMember("bufferView")) {
+      return;
+    }
+    const unsigned viewIndex =
+        uintMember(accessors[accessorIndex], "bufferView");
+    if (viewIndex >= uses.size()) {
+      return;
+    }
+    ViewUse& viewUse = uses[viewIndex];
+    const std::size_t viewStride = uintMember(views[viewIndex], "byteStride");
+    if (use == Use::Attributes && viewStride != 0) {
+      stride = viewStride;
+    }
+    if (viewUse.use == Use::None) {
+      viewUse = {use, stride};
+    } else if (viewUse.use != use || viewUse.stride != stride) {
+      viewUse.use = Use::Other;
+    }
+  };
+  std::vector<bool> meshAccessor(accessors.Size(), false);
+  if (json.HasMember("meshes") && json["meshes"].IsArray()) {
+    for (auto& mesh : json["meshes"].GetArray()) {
+      if (!mesh.HasMember("primitives") || !mesh["primitives"].IsArray()) {
+        continue;
+      }
+      for (auto& primitive : mesh["primitives"].GetArray()) {
+        if (primitive.HasMember("indices")) {
+          const unsigned indices = uintMember(primitive, "indices");
+          if (indices < accessors.Size()) {
+            const unsigned type = uintMember(accessors[indices],
+                                             "componentType");
+            const std::size_t size = type == ComponentUnsignedShort ? 2
+                                     : type == ComponentUnsignedInt ? 4
+                                                                    : 0;
+            const bool triangles =
+                uintMember(primitive, "mode", 4) == 4 &&
+                uintMember(accessors[indices], "count") % 3 == 0;
+            markUse(indices,
+                    size == 0 ? Use::Other
+                              : triangles ? Use::Triangles : Use::Indices,
+                    size);
+            meshAccessor[indices] = true;
+          }
+        }
+        if (!primitive.HasMember("attributes") ||
+            !primitive["attributes"].IsObject()) {
+          continue;
+        }
+        for (const auto& attribute : primitive["attributes"].GetObject()) {
+          if (!attribute.value.IsUint() ||
+              attribute.value.GetUint() >= accessors.Size()) {
+            continue;
+          }
+          const unsigned index = attribute.value.GetUint();
+          const io::JsonGenericValue& accessor = accessors[index];
+          // tightly packed views hold a single accessor
+          const std::size_t size =
+              componentSize(uintMember(accessor, "componentType")) *
+              componentCount(stringMember(accessor, "type", ""));
+          markUse(index, Use::Attributes, size);
+          meshAccessor[index] = true;
+        }
+      }
+    }
+  }
+  // views shared with accessors of animations or skins are copied
+  for (unsigned i = 0; i < accessors.Size(); ++i) {
+    if (!meshAccessor[i]) {
+      markUse(i, Use::Other, 0);
+    }
+  }
+
+  meshopt_encodeVertexVersion(0);
+  meshopt_encodeIndexVersion(1);
+  std::string bin;
+  std::size_t fallbackSize = 0;
+  std::vector<unsigned char> encoded;
+  for (unsigned i = 0; i < views.Size(); ++i) {
+    const char* data;
+    std::size_t size;
+    if (!bufferViewData(file, i, data, size)) {
+      LOG(ERROR) << "compressGltf : Cannot read buffer view " << i << " of "
+                 << filename;
+      return false;
+    }
+    io::JsonGenericValue& view = views[i];
+    const ViewUse& use = uses[i];
+    const std::size_t stride = use.stride;
+    bool compressible = stride != 0 && size % stride == 0;
+    if (use.use == Use::Attributes) {
+      compressible = compressible && stride % 4 == 0 && stride <= 256;
+    } else if (use.use != Use::Triangles && use.use != Use::Indices) {
+      compressible = false;
+    }
+
+    const std::size_t offset = align4(bin.size());
+    bin.resize(offset);
+    if (!compressible) {
+      bin.append(data, size);
+      setUint(view, "buffer", 0, allocator);
+      setUint(view, "byteOffset", offset, allocator);
+      continue;
+    }
+
+    const std::size_t count = size / stride;
+    if (use.use == Use::Attributes) {
+      encoded.resize(meshopt_encodeVertexBufferBound(count, stride));
+      encoded.resize(meshopt_encodeVertexBuffer(encoded.data(), encoded.size(),
+                                                data, count, stride));
+    } else {
+      std::vector<unsigned> indices(count);
+      for (std::size_t j = 0; j < count; ++j) {
+        if (stride == 2) {
+          uint16_t index;
+          std::memcpy(&index, data + j * 2, 2);
+          indices[j] = index;
+        } else {
+          std::memcpy(&indices[j], data + j * 4, 4);
+        }
+      }
+      const std::size_t vertexCount =
+          indices.empty() ? 0
+                          : *std::max_element(indices.begin(), indices.end()) +
+                                1;
+      if (use.use == Use::Triangles) {
+        encoded.resize(meshopt_encodeIndexBufferBound(count, vertexCount));
+        encoded.resize(meshopt_encodeIndexBuffer(
+            encoded.data(), encoded.size(), indices.data(), count));
+      } else {
+        encoded.resize(meshopt_encodeIndexSequenceBound(count, vertexCount));
+        encoded.resize(meshopt_encodeIndexSequence(
+            encoded.data(), encoded.size(), indices.data(), count));
+      }
+    }
+    bin.append(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+
+    // the view refers to the fallback buffer, which has no data
+    rapidjson::Value extension{rapidjson::kObjectType};
+    extension.AddMember("buffer", 0u, allocator);
+    extension.AddMember("byteOffset", unsigned(offset), allocator);
+    extension.AddMember("byteLength", unsigned(encoded.size()), allocator);
+    extension.AddMember("byteStride", unsigned(stride), allocator);
+    extension.AddMember("count", unsigned(count), allocator);
+    extension.AddMember(
+        "mode",
+        rapidjson::StringRef(use.use == Use::Attributes  ? "ATTRIBUTES"
+                             : use.use == Use::Triangles ? "TRIANGLES"
+                                                         : "INDICES"),
+        allocator);
+    if (!view.HasMember("extensions")) {
+      view.AddMember("extensions", rapidjson::Value{rapidjson::kObjectType},
+                     allocator);
+    }
+    view["extensions"].AddMember(rapidjson::StringRef(MeshoptExtension),
+                                 extension, allocator);
+    setUint(view, "buffer", 1, allocator);
+    setUint(view, "byteOffset", fallbackSize, allocator);
+    fallbackSize = align4(fallbackSize + size);
+  }
+
+  io::JsonGenericValue& buffers = rootArray(json, "buffers");
+  buffers.Clear();
+  rapidjson::Value binBuffer{rapidjson::kObjectType};
+  binBuffer.AddMember("byteLength", unsigned(bin.size()), allocator);
+  buffers.PushBack(binBuffer, allocator);
+  if (fallbackSize > 0) {
+    rapidjson::Value fallback{rapidjson::kObjectType};
+    fallback.AddMember("byteLength", unsigned(fallbackSize), allocator);
+    rapidjson::Value extension{rapidjson::kObjectType};
+    extension.AddMember("fallback", true, allocator);
+    rapidjson::Value extensions{rapidjson::kObjectType};
+    extensions.AddMember(rapidjson::StringRef(MeshoptExtension), extension,
+                         allocator);
+    fallback.AddMember("extensions", extensions, allocator);
+    buffers.PushBack(fallback, allocator);
+    setExtensionUsed(json, MeshoptExtension, true);
+  }
+
+  if (!Cr::Utility::Directory::writeString(outputFile,
+                                           writeGlb(json, std::move(bin)))) {
+    LOG(ERROR) << "compressGltf : Cannot write " << outputFile;
+    return false;
+  }
+  return true;
+#endif
+}
+
+}  // namespace assets
+}  // namespace esp
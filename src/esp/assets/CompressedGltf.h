@@ -0,0 +1,59 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_COMPRESSEDGLTF_H_
+#define ESP_ASSETS_COMPRESSEDGLTF_H_
+
+/** @file
+ * @brief Functions @ref esp::assets::isCompressedGltf(), @ref
+ * esp::assets::decompressGltf(), @ref esp::assets::compressGltf()
+ */
+
+#include <string>
+
+#include <Corrade/Containers/Optional.h>
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief Whether @p filename is a glTF or GLB file with geometry compressed
+ * by `EXT_meshopt_compression` or `KHR_draco_mesh_compression`, which the
+ * glTF importer can't read, see @ref decompressGltf(). Reads just the JSON of
+ * the file.
+ */
+bool isCompressedGltf(const std::string& filename);
+
+/**
+ * @brief Decode the compressed geometry of a glTF or GLB file into a GLB in
+ * memory, which the glTF importer opens as data.
+ *
+ * The decoded buffer views and accessors are appended to the binary chunk,
+ * the compression extensions are removed, and the relative uris of the
+ * remaining external buffers and images are made absolute, so that the GLB
+ * doesn't depend on the directory of @p filename. `EXT_meshopt_compression`
+ * needs a build with `BUILD_MESHOPT_SUPPORT`, `KHR_draco_mesh_compression` a
+ * build with `BUILD_DRACO_SUPPORT`.
+ * @return The GLB, or an empty optional if the file can't be read or uses a
+ * compression this build doesn't decode
+ */
+Corrade::Containers::Optional<std::string> decompressGltf(
+    const std::string& filename);
+
+/**
+ * @brief Compress the geometry of a glTF or GLB file with
+ * `EXT_meshopt_compression` into a GLB.
+ *
+ * The vertex and index buffer views of the meshes are encoded losslessly,
+ * the other views, external buffers included, are copied into the binary
+ * chunk. External images keep their uris, so @p outputFile has to be next to
+ * them. Needs a build with `BUILD_MESHOPT_SUPPORT`.
+ * @return Whether @p outputFile was written
+ */
+bool compressGltf(const std::string& filename, const std::string& outputFile);
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_COMPRESSEDGLTF_H_
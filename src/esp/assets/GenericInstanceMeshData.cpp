@@ -4,6 +4,8 @@
 
 #include "GenericInstanceMeshData.h"
 
+#include <algorithm>
+
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/ArrayViewStl.h>
@@ -18,6 +20,8 @@
 #include <Magnum/Shaders/Generic.h>
 #include <Magnum/Trade/AbstractImporter.h>
 
+#include "esp/core/Profiling.h"
+#include "esp/core/TaskScheduler.h"
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
 #include "esp/io/io.h"
@@ -102,12 +106,106 @@ Cr::Containers::Optional<InstancePlyData> parsePly(
   const quatf T_esp_scene =
       quatf::FromTwoVectors(-vec3f::UnitZ(), geo::ESP_GRAVITY);
 
-  for (auto& xyz : data.cpu_vbo) {
-    xyz = T_esp_scene * xyz;
-  }
+  core::TaskScheduler::global().parallelForRanges(
+      data.cpu_vbo.size(), 0, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          data.cpu_vbo[i] = T_esp_scene * data.cpu_vbo[i];
+        }
+      });
   return data;
 }
 
+/**
+ * @brief Split the parsed mesh by the object ID of the vertices, the objects
+ * in the order their first index appears.
+ *
+ * Every vertex has a single object ID, so the objects own disjoint vertices
+ * and are built in parallel.
+ */
+std::vector<InstancePlyData> splitByObjectId(const InstancePlyData& data) {
+  // the object and index count of each split mesh, in index order
+  std::vector<int> objectIdToMesh(65536, ID_UNDEFINED);
+  std::vector<uint16_t> meshObjectIds;
+  std::vector<size_t> meshIndexStart;
+  for (const uint32_t globalIndex : data.cpu_ibo) {
+    const uint16_t objectId = data.objectIds[globalIndex];
+    if (objectIdToMesh[objectId] == ID_UNDEFINED) {
+      objectIdToMesh[objectId] = meshObjectIds.size();
+      meshObjectIds.push_back(objectId);
+      meshIndexStart.push_back(0);
+    }
+    ++meshIndexStart[objectIdToMesh[objectId]];
+  }
+
+  // group the indices by mesh, keeping their order
+  size_t indexStart = 0;
+  for (size_t& start : meshIndexStart) {
+    const size_t count = start;
+    start = indexStart;
+    indexStart += count;
+  }
+  meshIndexStart.push_back(indexStart);
+  std::vector<uint32_t> groupedIndices(data.cpu_ibo.size());
+  {
+    std::vector<size_t> next(meshIndexStart.begin(), meshIndexStart.end() - 1);
+    for (const uint32_t globalIndex : data.cpu_ibo) {
+      const int mesh = objectIdToMesh[data.objectIds[globalIndex]];
+      groupedIndices[next[mesh]++] = globalIndex;
+    }
+  }
+
+  std::vector<InstancePlyData> split(meshObjectIds.size());
+  // local index of each vertex in the mesh of its object
+  std::vector<uint32_t> vertexIdToVertexIndex(data.cpu_vbo.size(), ~0u);
+  // handed out one by one, as the objects vary a lot in size
+  core::TaskScheduler::global().parallelFor(
+      split.size(), 0, [&](size_t mesh, int) {
+        InstancePlyData& meshData = split[mesh];
+        const size_t begin = meshIndexStart[mesh];
+        const size_t end = meshIndexStart[mesh + 1];
+        meshData.cpu_ibo.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+          const uint32_t globalIndex = groupedIndices[i];
+          // if we haven't seen this vertex, add it to the local buffers
+          uint32_t& localIndex = vertexIdToVertexIndex[globalIndex];
+          if (localIndex == ~0u) {
+            localIndex = meshData.cpu_vbo.size();
+            meshData.cpu_vbo.emplace_back(data.cpu_vbo[globalIndex]);
+            meshData.cpu_cbo.emplace_back(data.cpu_cbo[globalIndex]);
+            meshData.objectIds.emplace_back(meshObjectIds[mesh]);
+          }
+          meshData.cpu_ibo.emplace_back(localIndex);
+        }
+      });
+  return split;
+}
+
+//! @p count values of @p data from @p start, empty once released
+template <typename T>
+Cr::Containers::ArrayView<T> meshRange(std::vector<T>& data,
+                                       std::size_t start,
+                                       std::size_t count) {
+  if (start + count > data.size()) {
+    return nullptr;
+  }
+  return Cr::Containers::arrayView(data).slice(start, start + count);
+}
+
+template <typename T>
+Cr::Containers::ArrayView<const T> meshRange(const std::vector<T>& data,
+                                             std::size_t start,
+                                             std::size_t count) {
+  if (start + count > data.size()) {
+    return nullptr;
+  }
+  return Cr::Containers::arrayView(data).slice(start, start + count);
+}
+
+template <typename T>
+void freeVector(std::vector<T>& data) {
+  std::vector<T>{}.swap(data);
+}
+
 }  // namespace
 
 std::vector<std::unique_ptr<GenericInstanceMeshData>>
@@ -119,22 +217,53 @@ GenericInstanceMeshData::fromPlySplitByObjectId(
   if (!parseResult) {
     return {};
   }
-  const InstancePlyData& data = *parseResult;
+  std::vector<InstancePlyData> split = splitByObjectId(*parseResult);
 
-  std::vector<GenericInstanceMeshData::uptr> splitMeshData;
-  std::unordered_map<uint16_t, PerObjectIdMeshBuilder> objectIdToObjectData;
+  // the meshes are ranges of one set of vectors, so they share one vertex
+  // and one index buffer instead of a pair of small ones each
+  auto splitData = std::make_shared<SplitData>();
+  std::size_t vertexCount = 0, indexCount = 0;
+  for (const InstancePlyData& meshData : split) {
+    vertexCount += meshData.cpu_vbo.size();
+    indexCount += meshData.cpu_ibo.size();
+  }
+  splitData->cpu_vbo.reserve(vertexCount);
+  splitData->cpu_cbo.reserve(vertexCount);
+  splitData->objectIds.reserve(vertexCount);
+  splitData->cpu_ibo.reserve(indexCount);
+  splitData->meshCount = split.size();
 
-  for (size_t i = 0; i < data.cpu_ibo.size(); ++i) {
-    const uint32_t globalIndex = data.cpu_ibo[i];
-    const uint16_t objectId = data.objectIds[globalIndex];
-    if (objectIdToObjectData.find(objectId) == objectIdToObjectData.end()) {
-      auto instanceMesh = GenericInstanceMeshData::create_unique();
-      objectIdToObjectData.emplace(
-          objectId, PerObjectIdMeshBuilder{*instanceMesh, objectId});
-      splitMeshData.emplace_back(std::move(instanceMesh));
-    }
-    objectIdToObjectData.at(objectId).addVertex(
-        globalIndex, data.cpu_vbo[globalIndex], data.cpu_cbo[globalIndex]);
+  std::vector<GenericInstanceMeshData::uptr> splitMeshData;
+  splitMeshData.reserve(split.size());
+  for (InstancePlyData& meshData : split) {
+    auto instanceMesh = GenericInstanceMeshData::create_unique();
+    instanceMesh->split_ = splitData;
+    instanceMesh->vertexStart_ = splitData->cpu_vbo.size();
+    instanceMesh->vertexCount_ = meshData.cpu_vbo.size();
+    instanceMesh->indexStart_ = splitData->cpu_ibo.size();
+    instanceMesh->indexCount_ = meshData.cpu_ibo.size();
+    splitData->maxVertexCount =
+        std::max(splitData->maxVertexCount, meshData.cpu_vbo.size());
+    splitData->cpu_vbo.insert(splitData->cpu_vbo.end(),
+                              meshData.cpu_vbo.begin(),
+                              meshData.cpu_vbo.end());
+    splitData->cpu_cbo.insert(splitData->cpu_cbo.end(),
+                              meshData.cpu_cbo.begin(),
+                              meshData.cpu_cbo.end());
+    splitData->objectIds.insert(splitData->objectIds.end(),
+                                meshData.objectIds.begin(),
+                                meshData.objectIds.end());
+    splitData->cpu_ibo.insert(splitData->cpu_ibo.end(),
+                              meshData.cpu_ibo.begin(),
+                              meshData.cpu_ibo.end());
+    // freed as they are appended, to bound the peak memory
+    meshData = InstancePlyData{};
+    splitMeshData.emplace_back(std::move(instanceMesh));
+  }
+  for (GenericInstanceMeshData::uptr& instanceMesh : splitMeshData) {
+    instanceMesh->collisionMeshData_.primitive =
+        Magnum::MeshPrimitive::Triangles;
+    instanceMesh->updateCollisionMeshData();
   }
   return splitMeshData;
 }
@@ -163,28 +292,97 @@ std::unique_ptr<GenericInstanceMeshData> GenericInstanceMeshData::fromPLY(
   return data;
 }
 
+void GenericInstanceMeshData::uploadSplitBuffers() {
+  SplitData& split = *split_;
+  if (split.onGPU) {
+    return;
+  }
+
+  // the split meshes are mostly small enough for 16-bit indices
+  std::vector<uint16_t> compactIndices;
+  Cr::Containers::ArrayView<const void> indexData =
+      Cr::Containers::arrayView(split.cpu_ibo);
+  split.indexType = Mn::GL::MeshIndexType::UnsignedInt;
+  split.indexSize = sizeof(uint32_t);
+  if (compactVertexFormat_ && split.maxVertexCount <= 65536) {
+    compactIndices.resize(split.cpu_ibo.size());
+    Mn::Math::castInto(
+        Cr::Containers::arrayCast<2, const Mn::UnsignedInt>(
+            Cr::Containers::stridedArrayView(split.cpu_ibo)),
+        Cr::Containers::arrayCast<2, Mn::UnsignedShort>(
+            Cr::Containers::stridedArrayView(compactIndices)));
+    indexData = Cr::Containers::arrayView(compactIndices);
+    split.indexType = Mn::GL::MeshIndexType::UnsignedShort;
+    split.indexSize = sizeof(uint16_t);
+  }
+
+  const Cr::Containers::Array<char> vertexData = Mn::MeshTools::interleave(
+      split.cpu_vbo, split.cpu_cbo, 1, split.objectIds, 2);
+  split.vertexStride =
+      split.cpu_vbo.empty() ? 0 : vertexData.size() / split.cpu_vbo.size();
+
+  if (meshArena_ && !vertexData.empty() && !indexData.empty()) {
+    split.vertices = meshArena_->allocate(MeshArena::Kind::Vertex, vertexData);
+    split.indices = meshArena_->allocate(MeshArena::Kind::Index, indexData);
+  } else {
+    split.vertexBuffer = Mn::GL::Buffer{Mn::GL::Buffer::TargetHint::Array};
+    split.indexBuffer =
+        Mn::GL::Buffer{Mn::GL::Buffer::TargetHint::ElementArray};
+    split.vertexBuffer.setData(vertexData, Mn::GL::BufferUsage::StaticDraw);
+    split.indexBuffer.setData(indexData, Mn::GL::BufferUsage::StaticDraw);
+  }
+  split.onGPU = true;
+}
+
 void GenericInstanceMeshData::uploadBuffersToGPU(bool forceReload) {
+  if (cpuDataReleased_) {
+    // nothing left to upload again, the buffers stay as they are
+    return;
+  }
   if (forceReload) {
     buffersOnGPU_ = false;
   }
   if (buffersOnGPU_) {
     return;
   }
+  core::ScopedTimer timer{core::ProfilingStage::GpuUpload};
 
-  Mn::GL::Buffer vertices, indices;
-  indices.setTargetHint(Mn::GL::Buffer::TargetHint::ElementArray);
-  indices.setData(cpu_ibo_, Mn::GL::BufferUsage::StaticDraw);
+  if (!split_) {
+    // a mesh of its own is uploaded as the only range of a split
+    split_ = std::make_shared<SplitData>();
+    split_->meshCount = 1;
+    vertexCount_ = split_->maxVertexCount = cpu_vbo_.size();
+    indexCount_ = cpu_ibo_.size();
+    split_->cpu_vbo = std::move(cpu_vbo_);
+    split_->cpu_cbo = std::move(cpu_cbo_);
+    split_->cpu_ibo = std::move(cpu_ibo_);
+    split_->objectIds = std::move(objectIds_);
+  }
+  uploadSplitBuffers();
+  if (!renderingBuffer_) {
+    ++split_->uploadedCount;
+  }
 
-  vertices.setData(
-      Mn::MeshTools::interleave(cpu_vbo_, cpu_cbo_, 1, objectIds_, 2),
-      Mn::GL::BufferUsage::StaticDraw);
+  SplitData& split = *split_;
+  Mn::GL::Buffer& vertexBuffer =
+      split.vertices ? split.vertices.buffer() : split.vertexBuffer;
+  Mn::GL::Buffer& indexBuffer =
+      split.indices ? split.indices.buffer() : split.indexBuffer;
+  const std::size_t vertexOffset =
+      (split.vertices ? split.vertices.offset() : 0) +
+      vertexStart_ * split.vertexStride;
+  const std::size_t indexOffset =
+      (split.indices ? split.indices.offset() : 0) +
+      indexStart_ * split.indexSize;
+  gpuBytes_ =
+      vertexCount_ * split.vertexStride + indexCount_ * split.indexSize;
 
   renderingBuffer_ =
       std::make_unique<GenericInstanceMeshData::RenderingBuffer>();
   renderingBuffer_->mesh.setPrimitive(Magnum::GL::MeshPrimitive::Triangles)
-      .setCount(cpu_ibo_.size())
+      .setCount(indexCount_)
       .addVertexBuffer(
-          std::move(vertices), 0, Mn::Shaders::Generic3D::Position{},
+          vertexBuffer, vertexOffset, Mn::Shaders::Generic3D::Position{},
           Mn::Shaders::Generic3D::Color3{
               Mn::Shaders::Generic3D::Color3::DataType::UnsignedByte,
               Mn::Shaders::Generic3D::Color3::DataOption::Normalized},
@@ -192,14 +390,69 @@ void GenericInstanceMeshData::uploadBuffersToGPU(bool forceReload) {
           Mn::Shaders::Generic3D::ObjectId{
               Mn::Shaders::Generic3D::ObjectId::DataType::UnsignedShort},
           2)
-      .setIndexBuffer(std::move(indices), 0,
-                      Mn::GL::MeshIndexType::UnsignedInt);
+      .setIndexBuffer(indexBuffer, indexOffset, split.indexType);
 
   updateCollisionMeshData();
 
   buffersOnGPU_ = true;
 }
 
+void GenericInstanceMeshData::releaseCpuData() {
+  if (!buffersOnGPU_ || !split_ ||
+      retainedCpuData_ == InstanceMeshCpuData::All) {
+    return;
+  }
+  cpuDataReleased_ = true;
+  SplitData& split = *split_;
+  // the other meshes of the split still upload from the shared data
+  if (split.uploadedCount < split.meshCount) {
+    return;
+  }
+  freeVector(split.cpu_cbo);
+  freeVector(split.objectIds);
+  if (retainedCpuData_ == InstanceMeshCpuData::None) {
+    freeVector(split.cpu_vbo);
+    freeVector(split.cpu_ibo);
+  }
+  updateCollisionMeshData();
+}
+
+Cr::Containers::ArrayView<const vec3f>
+GenericInstanceMeshData::getVertexBufferObjectCPU() const {
+  if (!split_) {
+    return Cr::Containers::arrayView(cpu_vbo_);
+  }
+  const SplitData& split = *split_;
+  return meshRange(split.cpu_vbo, vertexStart_, vertexCount_);
+}
+
+Cr::Containers::ArrayView<const vec3uc>
+GenericInstanceMeshData::getColorBufferObjectCPU() const {
+  if (!split_) {
+    return Cr::Containers::arrayView(cpu_cbo_);
+  }
+  const SplitData& split = *split_;
+  return meshRange(split.cpu_cbo, vertexStart_, vertexCount_);
+}
+
+Cr::Containers::ArrayView<const uint32_t>
+GenericInstanceMeshData::getIndexBufferObjectCPU() const {
+  if (!split_) {
+    return Cr::Containers::arrayView(cpu_ibo_);
+  }
+  const SplitData& split = *split_;
+  return meshRange(split.cpu_ibo, indexStart_, indexCount_);
+}
+
+Cr::Containers::ArrayView<const uint16_t>
+GenericInstanceMeshData::getObjectIdsBufferObjectCPU() const {
+  if (!split_) {
+    return Cr::Containers::arrayView(objectIds_);
+  }
+  const SplitData& split = *split_;
+  return meshRange(split.objectIds, vertexStart_, vertexCount_);
+}
+
 Magnum::GL::Mesh* GenericInstanceMeshData::getMagnumGLMesh() {
   if (renderingBuffer_ == nullptr) {
     return nullptr;
@@ -208,26 +461,17 @@ Magnum::GL::Mesh* GenericInstanceMeshData::getMagnumGLMesh() {
 }
 
 void GenericInstanceMeshData::updateCollisionMeshData() {
+  if (!split_) {
+    collisionMeshData_.positions = Cr::Containers::arrayCast<Mn::Vector3>(
+        Cr::Containers::arrayView(cpu_vbo_));
+    collisionMeshData_.indices = Cr::Containers::arrayCast<Mn::UnsignedInt>(
+        Cr::Containers::arrayView(cpu_ibo_));
+    return;
+  }
   collisionMeshData_.positions = Cr::Containers::arrayCast<Mn::Vector3>(
-      Cr::Containers::arrayView(cpu_vbo_));
+      meshRange(split_->cpu_vbo, vertexStart_, vertexCount_));
   collisionMeshData_.indices = Cr::Containers::arrayCast<Mn::UnsignedInt>(
-      Cr::Containers::arrayView(cpu_ibo_));
-}
-
-void GenericInstanceMeshData::PerObjectIdMeshBuilder::addVertex(
-    uint32_t vertexId,
-    const vec3f& position,
-    const vec3uc& color) {
-  // if we haven't seen this vertex, add it to the local vertex/color buffer
-  auto result = vertexIdToVertexIndex_.emplace(vertexId, data_.cpu_vbo_.size());
-  if (result.second) {
-    data_.cpu_vbo_.emplace_back(position);
-    data_.cpu_cbo_.emplace_back(color);
-    data_.objectIds_.emplace_back(objectId_);
-  }
-
-  // update index buffers with local index of vertex/color
-  data_.cpu_ibo_.emplace_back(result.first->second);
+      meshRange(split_->cpu_ibo, indexStart_, indexCount_));
 }
 
 }  // namespace assets
@@ -5,6 +5,7 @@
 #ifndef ESP_ASSETS_GENERICINSTANCEMESHDATA_H_
 #define ESP_ASSETS_GENERICINSTANCEMESHDATA_H_
 
+#include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/Optional.h>
 #include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/Mesh.h>
@@ -14,17 +15,61 @@
 #include <vector>
 
 #include "BaseMesh.h"
+#include "MeshArena.h"
 #include "esp/core/esp.h"
 
 namespace esp {
 namespace assets {
 
+/**
+ * @brief What CPU-side data an instance mesh keeps once it is uploaded, see
+ * @ref GenericInstanceMeshData::releaseCpuData()
+ */
+enum class InstanceMeshCpuData {
+  //! All of it, e.g. to transfer the object ids to the render mesh
+  All,
+  //! The positions and indices collision meshes and navmeshes are built from
+  Collision,
+  //! Nothing, when collision meshes and navmeshes come from baked files
+  None
+};
+
 class GenericInstanceMeshData : public BaseMesh {
  public:
   struct RenderingBuffer {
+    //! drawing the ranges of the mesh in the buffers of its @ref SplitData
     Magnum::GL::Mesh mesh;
   };
 
+  /**
+   * @brief The data of the meshes split from one file, which are ranges of
+   * shared vertex and index buffers, see @ref fromPlySplitByObjectId()
+   */
+  struct SplitData {
+    std::vector<vec3f> cpu_vbo;
+    std::vector<vec3uc> cpu_cbo;
+    //! the indices of each mesh, relative to its first vertex
+    std::vector<uint32_t> cpu_ibo;
+    std::vector<uint16_t> objectIds;
+    //! the largest vertex count of a mesh, whether 16-bit indices fit
+    std::size_t maxVertexCount = 0;
+    std::size_t meshCount = 0;
+    //! the meshes uploaded, the CPU data is kept until all are
+    std::size_t uploadedCount = 0;
+
+    //! whether the shared buffers are uploaded, with the first mesh
+    bool onGPU = false;
+    //! the ranges of the buffers in a MeshArena, if uploaded to one
+    MeshArena::Allocation vertices, indices;
+    //! the buffers otherwise
+    Magnum::GL::Buffer vertexBuffer{Magnum::NoCreate},
+        indexBuffer{Magnum::NoCreate};
+    std::size_t vertexStride = 0;
+    std::size_t indexSize = 4;
+    Magnum::GL::MeshIndexType indexType =
+        Magnum::GL::MeshIndexType::UnsignedInt;
+  };
+
   explicit GenericInstanceMeshData(SupportedMeshType type) : BaseMesh{type} {};
   explicit GenericInstanceMeshData()
       : GenericInstanceMeshData{SupportedMeshType::INSTANCE_MESH} {};
@@ -34,6 +79,8 @@ class GenericInstanceMeshData : public BaseMesh {
   /**
    * @brief Split a .ply file by objectIDs into different meshes
    *
+   * The meshes are ranges of one @ref SplitData, so that they share a vertex
+   * and an index buffer on the CPU and the GPU.
    * @param plyFile .ply file to load and split
    * @return Mesh data split by objectID
    */
@@ -56,37 +103,41 @@ class GenericInstanceMeshData : public BaseMesh {
 
   virtual Magnum::GL::Mesh* getMagnumGLMesh() override;
 
-  const std::vector<vec3f>& getVertexBufferObjectCPU() const {
-    return cpu_vbo_;
-  }
-  const std::vector<vec3uc>& getColorBufferObjectCPU() const {
-    return cpu_cbo_;
-  }
+  //! empty once released, see @ref releaseCpuData()
+  Corrade::Containers::ArrayView<const vec3f> getVertexBufferObjectCPU() const;
+  Corrade::Containers::ArrayView<const vec3uc> getColorBufferObjectCPU() const;
+  Corrade::Containers::ArrayView<const uint32_t> getIndexBufferObjectCPU()
+      const;
+  Corrade::Containers::ArrayView<const uint16_t> getObjectIdsBufferObjectCPU()
+      const;
 
-  const std::vector<uint32_t>& getIndexBufferObjectCPU() const {
-    return cpu_ibo_;
-  }
-
-  const std::vector<uint16_t>& getObjectIdsBufferObjectCPU() const {
-    return objectIds_;
+  /**
+   * @brief Set what CPU-side data @ref releaseCpuData() keeps, all by
+   * default
+   */
+  void setRetainedCpuData(InstanceMeshCpuData retained) {
+    retainedCpuData_ = retained;
   }
 
- protected:
-  class PerObjectIdMeshBuilder {
-   public:
-    PerObjectIdMeshBuilder(GenericInstanceMeshData& data, uint16_t objectId)
-        : data_{data}, objectId_{objectId} {}
-
-    void addVertex(uint32_t vertexId, const vec3f& vertex, const vec3uc& color);
+  /** @brief What CPU-side data @ref releaseCpuData() keeps */
+  InstanceMeshCpuData getRetainedCpuData() const { return retainedCpuData_; }
 
-   private:
-    GenericInstanceMeshData& data_;
-    uint16_t objectId_;
-    std::unordered_map<uint32_t, size_t> vertexIdToVertexIndex_;
-  };
+  /**
+   * @brief Free the CPU-side data not kept by @ref setRetainedCpuData(), once
+   * the mesh is uploaded, shrinking the host memory of the mesh.
+   *
+   * Meshes split from one file free the shared data once all of them are
+   * uploaded. Without the positions the collision mesh is empty, and a
+   * forced upload afterwards keeps the buffers on the GPU.
+   */
+  void releaseCpuData();
 
+ protected:
   void updateCollisionMeshData();
 
+  //! upload the shared buffers of @ref split_, if not already
+  void uploadSplitBuffers();
+
   // ==== rendering ====
   std::unique_ptr<RenderingBuffer> renderingBuffer_ = nullptr;
 
@@ -95,6 +146,14 @@ class GenericInstanceMeshData : public BaseMesh {
   std::vector<uint32_t> cpu_ibo_;
   std::vector<uint16_t> objectIds_;
 
+  //! the shared data of a split mesh, nullptr if it has the vectors above
+  std::shared_ptr<SplitData> split_;
+  std::size_t vertexStart_ = 0, vertexCount_ = 0;
+  std::size_t indexStart_ = 0, indexCount_ = 0;
+
+  InstanceMeshCpuData retainedCpuData_ = InstanceMeshCpuData::All;
+  bool cpuDataReleased_ = false;
+
   ESP_SMART_POINTERS(GenericInstanceMeshData)
 };
 
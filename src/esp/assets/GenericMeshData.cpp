@@ -4,17 +4,307 @@
 
 #include "GenericMeshData.h"
 
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Algorithms.h>
+#include <Corrade/Utility/Assert.h>
 #include <Corrade/Utility/DebugStl.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/FunctionsBatch.h>
+#include <Magnum/Math/PackingBatch.h>
 #include <Magnum/MeshTools/Compile.h>
+#include <Magnum/MeshTools/CompressIndices.h>
+#include <Magnum/MeshTools/GenerateNormals.h>
 #include <Magnum/MeshTools/Interleave.h>
+#include <Magnum/Shaders/Generic.h>
+#include <Magnum/VertexFormat.h>
+
+#include "IndexOptimization.h"
+#include "esp/core/Profiling.h"
+
 namespace Cr = Corrade;
 namespace Mn = Magnum;
 
 namespace esp {
 namespace assets {
 
+namespace {
+
+/**
+ * @brief The format of an attribute in the compact vertex format, the
+ * original one if it has no compact variant.
+ *
+ * Normals are packed to signed bytes and colors to unsigned bytes, texture
+ * coordinates are converted to half floats. Positions stay floats, as halves
+ * are too imprecise for the extents of a scene.
+ */
+Mn::VertexFormat compactFormat(Mn::Trade::MeshAttribute name,
+                               Mn::VertexFormat format,
+                               Mn::UnsignedShort arraySize) {
+  if (arraySize != 0) {
+    return format;
+  }
+  switch (name) {
+    case Mn::Trade::MeshAttribute::Normal:
+      return format == Mn::VertexFormat::Vector3
+                 ? Mn::VertexFormat::Vector3bNormalized
+                 : format;
+    case Mn::Trade::MeshAttribute::TextureCoordinates:
+      return format == Mn::VertexFormat::Vector2 ? Mn::VertexFormat::Vector2h
+                                                 : format;
+    case Mn::Trade::MeshAttribute::Color:
+      if (format == Mn::VertexFormat::Vector3) {
+        return Mn::VertexFormat::Vector3ubNormalized;
+      }
+      if (format == Mn::VertexFormat::Vector4) {
+        return Mn::VertexFormat::Vector4ubNormalized;
+      }
+      return format;
+    default:
+      return format;
+  }
+}
+
+/**
+ * @brief A copy of the vertices of @p meshData in the compact vertex format,
+ * interleaved with every attribute aligned to four bytes. The indices are
+ * referenced, not copied. NullOpt if the mesh has implementation-specific
+ * formats.
+ */
+Cr::Containers::Optional<Mn::Trade::MeshData> compactMeshData(
+    const Mn::Trade::MeshData& meshData) {
+  const Mn::UnsignedInt vertexCount = meshData.vertexCount();
+  const Mn::UnsignedInt attributeCount = meshData.attributeCount();
+
+  std::vector<Mn::VertexFormat> formats(attributeCount);
+  std::vector<std::size_t> sizes(attributeCount);
+  std::vector<std::size_t> offsets(attributeCount);
+  std::size_t stride = 0;
+  for (Mn::UnsignedInt i = 0; i != attributeCount; ++i) {
+    if (Mn::isVertexFormatImplementationSpecific(meshData.attributeFormat(i))) {
+      return Cr::Containers::NullOpt;
+    }
+    const Mn::UnsignedShort arraySize = meshData.attributeArraySize(i);
+    formats[i] = compactFormat(meshData.attributeName(i),
+                               meshData.attributeFormat(i), arraySize);
+    sizes[i] = Mn::vertexFormatSize(formats[i]) * std::max<int>(arraySize, 1);
+    offsets[i] = stride;
+    stride += (sizes[i] + 3) & ~std::size_t{3};
+  }
+
+  Cr::Containers::Array<char> vertexData{Cr::Containers::ValueInit,
+                                         stride * vertexCount};
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      attributeCount};
+  for (Mn::UnsignedInt i = 0; i != attributeCount; ++i) {
+    const Cr::Containers::StridedArrayView2D<char> destination{
+        vertexData,
+        vertexData.data() + offsets[i],
+        {vertexCount, sizes[i]},
+        {std::ptrdiff_t(stride), 1}};
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        meshData.attributeName(i), formats[i],
+        Cr::Containers::StridedArrayView1D<const void>{
+            vertexData, vertexData.data() + offsets[i], vertexCount,
+            std::ptrdiff_t(stride)},
+        meshData.attributeArraySize(i)};
+
+    if (formats[i] == meshData.attributeFormat(i)) {
+      Cr::Utility::copy(meshData.attribute(i), destination);
+    } else if (formats[i] == Mn::VertexFormat::Vector2h) {
+      Mn::Math::packHalfInto(
+          Cr::Containers::arrayCast<2, const Mn::Float>(
+              meshData.attribute<Mn::Vector2>(i)),
+          Cr::Containers::arrayCast<Mn::UnsignedShort>(destination));
+    } else if (formats[i] == Mn::VertexFormat::Vector3bNormalized) {
+      Mn::Math::packInto(Cr::Containers::arrayCast<2, const Mn::Float>(
+                             meshData.attribute<Mn::Vector3>(i)),
+                         Cr::Containers::arrayCast<Mn::Byte>(destination));
+    } else if (formats[i] == Mn::VertexFormat::Vector3ubNormalized) {
+      Mn::Math::packInto(
+          Cr::Containers::arrayCast<2, const Mn::Float>(
+              meshData.attribute<Mn::Vector3>(i)),
+          Cr::Containers::arrayCast<Mn::UnsignedByte>(destination));
+    } else {
+      CORRADE_INTERNAL_ASSERT(formats[i] ==
+                              Mn::VertexFormat::Vector4ubNormalized);
+      Mn::Math::packInto(
+          Cr::Containers::arrayCast<2, const Mn::Float>(
+              meshData.attribute<Mn::Vector4>(i)),
+          Cr::Containers::arrayCast<Mn::UnsignedByte>(destination));
+    }
+  }
+
+  if (!meshData.isIndexed()) {
+    return Mn::Trade::MeshData{meshData.primitive(), std::move(vertexData),
+                               std::move(attributes), vertexCount};
+  }
+  const Mn::Trade::MeshIndexData indices{
+      meshData.indexType(),
+      meshData.indexData()
+          .suffix(meshData.indexOffset())
+          .prefix(meshData.indexCount() *
+                  Mn::meshIndexTypeSize(meshData.indexType()))};
+  return Mn::Trade::MeshData{meshData.primitive(),  {},
+                             meshData.indexData(),  indices,
+                             std::move(vertexData), std::move(attributes),
+                             vertexCount};
+}
+
+/**
+ * @brief A copy of @p meshData laid out for the collision data to reference,
+ * instead of keeping copies of the positions and indices.
+ *
+ * The positions are unpacked to a contiguous Vector3 array at the start of the
+ * vertex buffer, followed by the other attributes interleaved, with every
+ * attribute aligned to four bytes. The indices are unpacked to 32 bits.
+ * NullOpt if the mesh has no positions or implementation-specific formats.
+ */
+Cr::Containers::Optional<Mn::Trade::MeshData> collisionSharedMeshData(
+    const Mn::Trade::MeshData& meshData) {
+  if (!meshData.hasAttribute(Mn::Trade::MeshAttribute::Position)) {
+    return Cr::Containers::NullOpt;
+  }
+  const Mn::UnsignedInt positionId =
+      meshData.attributeId(Mn::Trade::MeshAttribute::Position);
+  const Mn::UnsignedInt vertexCount = meshData.vertexCount();
+  const Mn::UnsignedInt attributeCount = meshData.attributeCount();
+
+  const std::size_t positionSize = vertexCount * sizeof(Mn::Vector3);
+  std::vector<std::size_t> sizes(attributeCount);
+  std::vector<std::size_t> offsets(attributeCount);
+  std::size_t stride = 0;
+  for (Mn::UnsignedInt i = 0; i != attributeCount; ++i) {
+    const Mn::VertexFormat format = meshData.attributeFormat(i);
+    if (Mn::isVertexFormatImplementationSpecific(format)) {
+      return Cr::Containers::NullOpt;
+    }
+    if (i == positionId) {
+      continue;
+    }
+    sizes[i] = Mn::vertexFormatSize(format) *
+               std::max<int>(meshData.attributeArraySize(i), 1);
+    offsets[i] = positionSize + stride;
+    stride += (sizes[i] + 3) & ~std::size_t{3};
+  }
+
+  Cr::Containers::Array<char> vertexData{Cr::Containers::ValueInit,
+                                         positionSize + stride * vertexCount};
+  const Cr::Containers::ArrayView<Mn::Vector3> positions =
+      Cr::Containers::arrayCast<Mn::Vector3>(vertexData.prefix(positionSize));
+  meshData.positions3DInto(positions);
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      attributeCount};
+  for (Mn::UnsignedInt i = 0; i != attributeCount; ++i) {
+    if (i == positionId) {
+      attributes[i] = Mn::Trade::MeshAttributeData{
+          Mn::Trade::MeshAttribute::Position,
+          Cr::Containers::arrayView<const Mn::Vector3>(positions)};
+      continue;
+    }
+    const Cr::Containers::StridedArrayView2D<char> destination{
+        vertexData,
+        vertexData.data() + offsets[i],
+        {vertexCount, sizes[i]},
+        {std::ptrdiff_t(stride), 1}};
+    Cr::Utility::copy(meshData.attribute(i), destination);
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        meshData.attributeName(i), meshData.attributeFormat(i),
+        Cr::Containers::StridedArrayView1D<const void>{
+            vertexData, vertexData.data() + offsets[i], vertexCount,
+            std::ptrdiff_t(stride)},
+        meshData.attributeArraySize(i)};
+  }
+
+  if (!meshData.isIndexed()) {
+    return Mn::Trade::MeshData{meshData.primitive(), std::move(vertexData),
+                               std::move(attributes), vertexCount};
+  }
+  Cr::Containers::Array<char> indexData{
+      Cr::Containers::NoInit, meshData.indexCount() * sizeof(Mn::UnsignedInt)};
+  const Cr::Containers::ArrayView<Mn::UnsignedInt> indices =
+      Cr::Containers::arrayCast<Mn::UnsignedInt>(indexData);
+  meshData.indicesInto(indices);
+  const Mn::Trade::MeshIndexData meshIndices{indices};
+  return Mn::Trade::MeshData{meshData.primitive(),  std::move(indexData),
+                             meshIndices,           std::move(vertexData),
+                             std::move(attributes), vertexCount};
+}
+
+/**
+ * @brief The triangles of @p indices with every vertex snapped to the vertex
+ * nearest to the center of its cell in a grid of @p cellSize, without the
+ * triangles which collapsed or became duplicates.
+ */
+std::vector<Mn::UnsignedInt> clusterTriangles(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    const Mn::Vector3& origin,
+    float cellSize) {
+  struct Cell {
+    Mn::UnsignedInt vertex;
+    float distance;
+  };
+  std::unordered_map<uint64_t, Cell> cells;
+  std::vector<uint64_t> vertexCells(positions.size());
+  for (std::size_t i = 0; i != positions.size(); ++i) {
+    const Mn::Vector3 cell = Mn::Math::max(
+        Mn::Math::floor((positions[i] - origin) / cellSize), Mn::Vector3{0.0f});
+    const float distance =
+        (positions[i] - origin - (cell + Mn::Vector3{0.5f}) * cellSize).dot();
+    // 21 bits per axis are plenty for the grid sizes used
+    const Mn::Vector3ui c{cell};
+    vertexCells[i] = uint64_t(c.x()) | uint64_t(c.y()) << 21 |
+                     uint64_t(c.z()) << 42;
+    auto result =
+        cells.emplace(vertexCells[i], Cell{Mn::UnsignedInt(i), distance});
+    if (!result.second && distance < result.first->second.distance) {
+      result.first->second = Cell{Mn::UnsignedInt(i), distance};
+    }
+  }
+
+  std::vector<Mn::UnsignedInt> representatives(positions.size());
+  for (std::size_t i = 0; i != positions.size(); ++i) {
+    representatives[i] = cells.at(vertexCells[i]).vertex;
+  }
+
+  std::vector<std::array<Mn::UnsignedInt, 3>> triangles;
+  triangles.reserve(indices.size() / 3);
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    std::array<Mn::UnsignedInt, 3> triangle{representatives[indices[i]],
+                                            representatives[indices[i + 1]],
+                                            representatives[indices[i + 2]]};
+    if (triangle[0] == triangle[1] || triangle[1] == triangle[2] ||
+        triangle[2] == triangle[0]) {
+      continue;
+    }
+    // smallest index first, keeping the winding, so duplicates compare equal
+    std::rotate(triangle.begin(),
+                std::min_element(triangle.begin(), triangle.end()),
+                triangle.end());
+    triangles.push_back(triangle);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  triangles.erase(std::unique(triangles.begin(), triangles.end()),
+                  triangles.end());
+
+  std::vector<Mn::UnsignedInt> clustered;
+  clustered.reserve(triangles.size() * 3);
+  for (const std::array<Mn::UnsignedInt, 3>& triangle : triangles) {
+    clustered.insert(clustered.end(), triangle.begin(), triangle.end());
+  }
+  return clustered;
+}
+
+}  // namespace
+
 void GenericMeshData::uploadBuffersToGPU(bool forceReload) {
   if (forceReload) {
     buffersOnGPU_ = false;
@@ -22,6 +312,7 @@ void GenericMeshData::uploadBuffersToGPU(bool forceReload) {
   if (buffersOnGPU_) {
     return;
   }
+  core::ScopedTimer timer{core::ProfilingStage::GpuUpload};
 
   renderingBuffer_.reset();
   renderingBuffer_ = std::make_unique<GenericMeshData::RenderingBuffer>();
@@ -30,12 +321,194 @@ void GenericMeshData::uploadBuffersToGPU(bool forceReload) {
       !meshData_->hasAttribute(Mn::Trade::MeshAttribute::Normal)) {
     compileFlags |= Magnum::MeshTools::CompileFlag::GenerateSmoothNormals;
   }
+  // each step below makes a new mesh out of the previous one, if needed
+  const Mn::Trade::MeshData* data = &*meshData_;
+  Cr::Containers::Optional<Mn::Trade::MeshData> normalsData, compactData,
+      levelsOfDetailData, compressedData;
+
+  const bool arenaNormals = meshArena_ && meshData_->isIndexed();
+  if ((!levelsOfDetail_.empty() || arenaNormals) &&
+      (compileFlags & Magnum::MeshTools::CompileFlag::GenerateSmoothNormals)) {
+    // from the full detail triangles, not the coarser levels, and before the
+    // arena, which takes the mesh as it is
+    const Cr::Containers::Array<Mn::Vector3> normals =
+        Mn::MeshTools::generateSmoothNormals(collisionMeshData_.indices,
+                                             collisionMeshData_.positions);
+    const Mn::Trade::MeshAttributeData extra[]{Mn::Trade::MeshAttributeData{
+        Mn::Trade::MeshAttribute::Normal, Cr::Containers::arrayView(normals)}};
+    normalsData = Mn::MeshTools::interleave(*data, extra);
+    data = &*normalsData;
+    compileFlags = {};
+  }
+
+  if (compactVertexFormat_ && (compactData = compactMeshData(*data))) {
+    data = &*compactData;
+  }
+
+  if (!levelsOfDetail_.empty()) {
+    // the levels follow the full detail indices in one index buffer
+    const std::size_t indexCount =
+        collisionMeshData_.indices.size() + levelOfDetailIndices_.size();
+    Cr::Containers::Array<char> indexData{
+        Cr::Containers::NoInit, indexCount * sizeof(Mn::UnsignedInt)};
+    const Cr::Containers::ArrayView<Mn::UnsignedInt> indices =
+        Cr::Containers::arrayCast<Mn::UnsignedInt>(indexData);
+    std::copy(collisionMeshData_.indices.begin(),
+              collisionMeshData_.indices.end(), indices.begin());
+    std::copy(levelOfDetailIndices_.begin(), levelOfDetailIndices_.end(),
+              indices.begin() + collisionMeshData_.indices.size());
+    Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+        data->attributeCount()};
+    std::copy(data->attributeData().begin(), data->attributeData().end(),
+              attributes.begin());
+    const Mn::Trade::MeshIndexData meshIndices{indices};
+    levelsOfDetailData = Mn::Trade::MeshData{data->primitive(),
+                                             std::move(indexData),
+                                             meshIndices,
+                                             {},
+                                             data->vertexData(),
+                                             std::move(attributes),
+                                             data->vertexCount()};
+    data = &*levelsOfDetailData;
+  }
+
+  if (data->isIndexed() &&
+      (compactVertexFormat_ ||
+       importedIndexType_ != Mn::MeshIndexType::UnsignedInt)) {
+    // 16-bit indices whenever the vertex count allows, or back to the
+    // imported type, which the CPU copy was unpacked from
+    compressedData = Mn::MeshTools::compressIndices(
+        *data, compactVertexFormat_ ? Mn::MeshIndexType::UnsignedShort
+                                    : importedIndexType_);
+    data = &*compressedData;
+  }
+
   // position, normals, uv, colors are bound to corresponding attributes
-  renderingBuffer_->mesh = Magnum::MeshTools::compile(*meshData_, compileFlags);
+  if (meshArena_ && !compileFlags && MeshArena::canCompile(*data)) {
+    renderingBuffer_->mesh = meshArena_->compile(
+        *data, renderingBuffer_->vertices, renderingBuffer_->indices);
+  } else {
+    renderingBuffer_->mesh = Magnum::MeshTools::compile(*data, compileFlags);
+  }
+  gpuBytes_ = data->vertexData().size() + data->indexData().size();
+  if (compileFlags & Magnum::MeshTools::CompileFlag::GenerateSmoothNormals) {
+    // compile() adds a normal to each vertex
+    gpuBytes_ += data->vertexCount() * sizeof(Mn::Vector3);
+  }
+  if (!levelsOfDetail_.empty()) {
+    // everything but GenericDrawable draws just the full detail
+    renderingBuffer_->mesh.setCount(collisionMeshData_.indices.size());
+  }
+  uploadPerVertexObjectIds();
 
   buffersOnGPU_ = true;
 }
 
+void GenericMeshData::setPerVertexObjectIds(
+    std::vector<Mn::UnsignedInt> objectIds) {
+  CORRADE_ASSERT(
+      objectIds.size() == collisionMeshData_.positions.size(),
+      "GenericMeshData::setPerVertexObjectIds(): expected"
+          << collisionMeshData_.positions.size() << "ids, got"
+          << objectIds.size(), );
+  CORRADE_ASSERT(perVertexObjectIds_.empty(),
+                 "GenericMeshData::setPerVertexObjectIds(): already set", );
+  perVertexObjectIds_ = std::move(objectIds);
+  if (buffersOnGPU_) {
+    uploadPerVertexObjectIds();
+  }
+}
+
+void GenericMeshData::uploadPerVertexObjectIds() {
+  if (perVertexObjectIds_.empty()) {
+    return;
+  }
+  gpuBytes_ += perVertexObjectIds_.size() * sizeof(Mn::UnsignedInt);
+  if (renderingBuffer_->vertices) {
+    // next to the rest of the vertices
+    MeshArena::Allocation& objectIds = renderingBuffer_->objectIds;
+    objectIds = meshArena_->allocate(
+        MeshArena::Kind::Vertex,
+        Cr::Containers::arrayView(perVertexObjectIds_));
+    renderingBuffer_->mesh.addVertexBuffer(objectIds.buffer(),
+                                           objectIds.offset(),
+                                           Mn::Shaders::Generic3D::ObjectId{});
+    return;
+  }
+  Mn::GL::Buffer objectIds;
+  objectIds.setData(perVertexObjectIds_, Mn::GL::BufferUsage::StaticDraw);
+  renderingBuffer_->mesh.addVertexBuffer(std::move(objectIds), 0,
+                                         Mn::Shaders::Generic3D::ObjectId{});
+}
+
+void GenericMeshData::optimizeIndexOrder() {
+  if (!meshData_ || !meshData_->isIndexed() ||
+      meshData_->primitive() != Mn::MeshPrimitive::Triangles) {
+    return;
+  }
+  const Cr::Containers::ArrayView<Mn::UnsignedInt> indices =
+      collisionMeshData_.indices;
+  optimizeVertexCache(indices, collisionMeshData_.positions.size());
+  optimizeOverdraw(indices, collisionMeshData_.positions);
+
+  // the collision indices are a copy if they couldn't be shared
+  if (meshData_->indexType() == Mn::MeshIndexType::UnsignedShort) {
+    const Cr::Containers::ArrayView<Mn::UnsignedShort> meshIndices =
+        meshData_->mutableIndices<Mn::UnsignedShort>();
+    std::copy(indices.begin(), indices.end(), meshIndices.begin());
+  } else if (meshData_->indexType() == Mn::MeshIndexType::UnsignedByte) {
+    const Cr::Containers::ArrayView<Mn::UnsignedByte> meshIndices =
+        meshData_->mutableIndices<Mn::UnsignedByte>();
+    std::copy(indices.begin(), indices.end(), meshIndices.begin());
+  }
+}
+
+void GenericMeshData::generateLevelsOfDetail(int count) {
+  if (levelsOfDetail_.size() == std::size_t(Mn::Math::max(count, 0))) {
+    return;
+  }
+  levelsOfDetail_.clear();
+  levelOfDetailIndices_.clear();
+  if (count <= 0 || !meshData_ || !meshData_->isIndexed() ||
+      meshData_->primitive() != Mn::MeshPrimitive::Triangles) {
+    return;
+  }
+
+  const Cr::Containers::ArrayView<const Mn::Vector3> positions =
+      collisionMeshData_.positions;
+  const Cr::Containers::ArrayView<const Mn::UnsignedInt> indices =
+      collisionMeshData_.indices;
+  const std::pair<Mn::Vector3, Mn::Vector3> bounds =
+      Mn::Math::minmax(positions);
+  float cellSize = (bounds.second - bounds.first).max() / FinestLevelGridSize;
+  if (!(cellSize > 0.0f)) {
+    return;
+  }
+
+  Mn::UnsignedInt indexOffset = 0;
+  Mn::UnsignedInt indexCount = indices.size();
+  for (int i = 0; i != count; ++i, cellSize *= LevelGridScale) {
+    std::vector<Mn::UnsignedInt> clustered =
+        clusterTriangles(positions, indices, bounds.first, cellSize);
+    // a level which isn't coarser draws the previous one instead
+    if (!clustered.empty() && clustered.size() < indexCount) {
+      indexOffset = indices.size() + levelOfDetailIndices_.size();
+      indexCount = clustered.size();
+      optimizeVertexCache(clustered, positions.size());
+      levelOfDetailIndices_.insert(levelOfDetailIndices_.end(),
+                                   clustered.begin(), clustered.end());
+    }
+    levelsOfDetail_.push_back(LevelOfDetail{indexOffset, indexCount, cellSize});
+  }
+}
+
+void GenericMeshData::setLevelsOfDetail(
+    std::vector<LevelOfDetail> levels,
+    std::vector<Mn::UnsignedInt> indices) {
+  levelsOfDetail_ = std::move(levels);
+  levelOfDetailIndices_ = std::move(indices);
+}
+
 Magnum::GL::Mesh* GenericMeshData::getMagnumGLMesh() {
   if (renderingBuffer_ == nullptr) {
     return nullptr;
@@ -45,26 +518,46 @@ Magnum::GL::Mesh* GenericMeshData::getMagnumGLMesh() {
 }
 
 void GenericMeshData::setMeshData(Magnum::Trade::MeshData&& meshData) {
-  /* Interleave the mesh, if not already. This makes the GPU happier (better
-     cache locality for vertex fetching) and is a no-op if the source data is
-     already interleaved, so doesn't hurt to have it there always. */
-
   /* TODO: Address that non-triangle meshes will have their collisionMeshData_
    * incorrectly calculated */
 
+  importedIndexType_ = meshData.isIndexed() ? meshData.indexType()
+                                            : Mn::MeshIndexType::UnsignedInt;
+  positionData_ = nullptr;
+  indexData_ = nullptr;
+
+  /* The collision data needs positions as Vector3 in a contiguous array and
+     UnsignedInt indices. Lay the mesh out like that, so they are shared with
+     it instead of copied. */
+  if (Cr::Containers::Optional<Mn::Trade::MeshData> shared =
+          collisionSharedMeshData(meshData)) {
+    meshData_ = std::move(shared);
+    collisionMeshData_.primitive = meshData_->primitive();
+    collisionMeshData_.positions = Cr::Containers::arrayCast<Mn::Vector3>(
+        meshData_->mutableVertexData().prefix(meshData_->vertexCount() *
+                                              sizeof(Mn::Vector3)));
+    if (meshData_->isIndexed()) {
+      collisionMeshData_.indices = meshData_->mutableIndices<Mn::UnsignedInt>();
+    } else {
+      collisionMeshData_.indices = nullptr;
+    }
+    return;
+  }
+
+  /* Otherwise interleave the mesh, if not already. This makes the GPU happier
+     (better cache locality for vertex fetching) and is a no-op if the source
+     data is already interleaved. */
   meshData_ = Mn::MeshTools::interleave(std::move(meshData));
 
   collisionMeshData_.primitive = meshData_->primitive();
 
-  /* For collision data we need positions as Vector3 in a contiguous array.
-     There's little chance the data are stored like that in MeshData, so unpack
-     them to an array. */
+  /* Unpack the positions to an array, there's little chance the data are
+     stored like that in MeshData. */
   collisionMeshData_.positions = positionData_ =
       meshData_->positions3DAsArray();
 
-  /* For collision data we need indices as UnsignedInt. If the mesh already has
-     those, just make the collision data reference them. If not, unpack them
-     and store them here. */
+  /* If the mesh already has UnsignedInt indices, just make the collision data
+     reference them. If not, unpack them and store them here. */
   if (meshData_->indexType() == Mn::MeshIndexType::UnsignedInt)
     collisionMeshData_.indices = meshData_->mutableIndices<Mn::UnsignedInt>();
   else
@@ -10,11 +10,14 @@
  * esp::assets::GenericMeshData::RenderingBuffer
  */
 
+#include <vector>
+
 #include <Corrade/Containers/Optional.h>
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/Trade/AbstractImporter.h>
 
 #include "BaseMesh.h"
+#include "MeshArena.h"
 #include "esp/core/esp.h"
 
 namespace esp {
@@ -30,12 +33,41 @@ class GenericMeshData : public BaseMesh {
    * @brief Stores render data for the mesh necessary for gltf format.
    */
   struct RenderingBuffer {
+    /**
+     * @brief The ranges of the vertices, indices and per-vertex object ids in
+     * the @ref MeshArena they were uploaded to, if any. Declared before @ref
+     * mesh, which draws from them.
+     */
+    MeshArena::Allocation vertices, indices, objectIds;
+
     /**
      * @brief Compiled openGL render data for the mesh.
      */
     Magnum::GL::Mesh mesh;
   };
 
+  /**
+   * @brief A coarser level of detail of the mesh, drawn from a range of the
+   * index buffer uploaded after the indices of the full detail.
+   */
+  struct LevelOfDetail {
+    /** @brief First index of the level in the uploaded index buffer */
+    Magnum::UnsignedInt indexOffset;
+    /** @brief Index count of the level */
+    Magnum::UnsignedInt indexCount;
+    /**
+     * @brief Size of the grid cells the vertices were clustered in. No vertex
+     * moves further than the cell diagonal.
+     */
+    float cellSize;
+  };
+
+  /** @brief Grid cells along the largest extent of the finest level */
+  static constexpr float FinestLevelGridSize = 64.0f;
+
+  /** @brief Factor the grid cells grow by from one level to the next */
+  static constexpr float LevelGridScale = 4.0f;
+
   /** @brief Constructor. Sets @ref SupportedMeshType::GENERIC_MESH to identify
    * the asset type.*/
   GenericMeshData(bool needsNormals = true)
@@ -57,6 +89,10 @@ class GenericMeshData : public BaseMesh {
    * @brief Set mesh data from external source, and sets the @ref collisionMesh_
    * references.  Can be used for meshDatas that are manually synthesized, such
    * as NavMesh. Sets the @ref collisionMesh_ references.
+   *
+   * The mesh is stored with contiguous positions and 32-bit indices, which the
+   * collision data references instead of keeping copies. The GPU copy gets
+   * the original index type back.
    * @param meshData the meshData to be assigned.
    */
   void setMeshData(Magnum::Trade::MeshData&& meshData);
@@ -82,6 +118,66 @@ class GenericMeshData : public BaseMesh {
   void importAndSetMeshData(Magnum::Trade::AbstractImporter& importer,
                             const std::string& meshName);
 
+  /**
+   * @brief Reorder the triangles for the vertex cache, then groups of them to
+   * reduce overdraw, see @ref optimizeVertexCache() and @ref
+   * optimizeOverdraw(). Only indexed triangle meshes are reordered. Takes
+   * effect on the next @ref uploadBuffersToGPU().
+   */
+  void optimizeIndexOrder();
+
+  /**
+   * @brief Generate @p count coarser levels of detail by vertex clustering.
+   *
+   * Each level snaps the vertices to the vertex nearest to the center of
+   * their cell in a grid @ref LevelGridScale times coarser than the previous
+   * level, starting with @ref FinestLevelGridSize cells along the largest
+   * extent, and drops the collapsed triangles. The levels reuse the vertices,
+   * only adding indices, which are ordered for the vertex cache. A level
+   * which isn't coarser than the previous one draws the previous one.
+   *
+   * Keeps the current levels if there are @p count of them already, e.g. read
+   * from a scene cache, removes them for 0. Only indexed triangle meshes get
+   * levels. Takes effect on the next @ref uploadBuffersToGPU().
+   */
+  void generateLevelsOfDetail(int count);
+
+  /**
+   * @brief The coarser levels of detail, from finest to coarsest, see @ref
+   * generateLevelsOfDetail()
+   */
+  const std::vector<LevelOfDetail>& getLevelsOfDetail() const {
+    return levelsOfDetail_;
+  }
+
+  /**
+   * @brief The indices of all coarser levels, following the full detail ones
+   * in the uploaded index buffer
+   */
+  const std::vector<Magnum::UnsignedInt>& getLevelOfDetailIndices() const {
+    return levelOfDetailIndices_;
+  }
+
+  /**
+   * @brief Set levels of detail generated before, e.g. by @ref
+   * generateLevelsOfDetail() of the mesh saved in a scene cache
+   */
+  void setLevelsOfDetail(std::vector<LevelOfDetail> levels,
+                         std::vector<Magnum::UnsignedInt> indices);
+
+  /**
+   * @brief Set an object id for each vertex, uploaded as the per-vertex object
+   * id attribute of @ref Magnum::Shaders::Phong::Flag::InstancedObjectId.
+   *
+   * Adds the attribute to the mesh right away if it is already uploaded,
+   * which keeps the mesh drawables refer to. See @ref transferObjectIds().
+   * @param objectIds One id per vertex of the mesh
+   */
+  void setPerVertexObjectIds(std::vector<Magnum::UnsignedInt> objectIds);
+
+  /** @brief Whether the mesh has per-vertex object ids */
+  bool hasPerVertexObjectIds() const { return !perVertexObjectIds_.empty(); }
+
   /**
    * @brief Returns a pointer to the compiled render data storage structure.
    * @return Pointer to the @ref renderingBuffer_.
@@ -107,9 +203,22 @@ class GenericMeshData : public BaseMesh {
 
   bool needsNormals_ = true;
 
+  std::vector<LevelOfDetail> levelsOfDetail_;
+  std::vector<Magnum::UnsignedInt> levelOfDetailIndices_;
+
+  //! see @ref setPerVertexObjectIds()
+  std::vector<Magnum::UnsignedInt> perVertexObjectIds_;
+
  private:
-  /* Internal; can store data referenced by positions / indices if the original
-     MeshData doesn't have them in desired type */
+  //! add the per-vertex object ids to the uploaded mesh
+  void uploadPerVertexObjectIds();
+
+  /* Index type of the mesh before its indices were unpacked, which the GPU
+     copy is packed back to */
+  Magnum::MeshIndexType importedIndexType_ = Magnum::MeshIndexType::UnsignedInt;
+
+  /* Internal; can store data referenced by positions / indices if the MeshData
+     cannot be laid out to share them, see setMeshData() */
   Corrade::Containers::Array<Magnum::Vector3> positionData_;
   Corrade::Containers::Array<Magnum::UnsignedInt> indexData_;
 };
@@ -0,0 +1,305 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "IndexOptimization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <Magnum/Math/Functions.h>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+//! size of the vertex cache the scores model
+constexpr int ScoreCacheSize = 32;
+constexpr float CacheDecayPower = 1.5f;
+//! vertices of the last triangle score lower, to avoid strips
+constexpr float LastTriangleScore = 0.75f;
+constexpr float ValenceBoostScale = 2.0f;
+constexpr float ValenceBoostPower = 0.5f;
+
+//! the smallest group of triangles reordered to reduce overdraw
+constexpr std::size_t MinGroupTriangles = 64;
+//! how much worse than its region a group may use the vertex cache
+constexpr float GroupMissRatioThreshold = 1.05f;
+
+/**
+ * @brief Score of a vertex at @p cachePosition, -1 if not cached, with
+ * @p remaining triangles not emitted yet
+ */
+float vertexScore(int cachePosition, Mn::UnsignedInt remaining) {
+  if (remaining == 0) {
+    return -1.0f;
+  }
+  float score = 0.0f;
+  if (cachePosition >= 0) {
+    score = cachePosition < 3
+                ? LastTriangleScore
+                : std::pow(1.0f - float(cachePosition - 3) /
+                                      float(ScoreCacheSize - 3),
+                           CacheDecayPower);
+  }
+  // vertices with few triangles left are preferred, to finish them off
+  return score +
+         ValenceBoostScale * std::pow(float(remaining), -ValenceBoostPower);
+}
+
+}  // namespace
+
+void optimizeVertexCache(Cr::Containers::ArrayView<Mn::UnsignedInt> indices,
+                         Mn::UnsignedInt vertexCount) {
+  const std::size_t triangleCount = indices.size() / 3;
+  if (triangleCount < 2) {
+    return;
+  }
+
+  // triangles of each vertex, the first `remaining` of them not emitted yet
+  std::vector<Mn::UnsignedInt> remaining(vertexCount, 0);
+  for (std::size_t i = 0; i != triangleCount * 3; ++i) {
+    ++remaining[indices[i]];
+  }
+  std::vector<std::size_t> offsets(vertexCount + 1, 0);
+  for (Mn::UnsignedInt v = 0; v != vertexCount; ++v) {
+    offsets[v + 1] = offsets[v] + remaining[v];
+  }
+  std::vector<Mn::UnsignedInt> adjacency(triangleCount * 3);
+  {
+    std::vector<std::size_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i != triangleCount * 3; ++i) {
+      adjacency[cursors[indices[i]]++] = Mn::UnsignedInt(i / 3);
+    }
+  }
+
+  std::vector<int> cachePositions(vertexCount, -1);
+  std::vector<float> vertexScores(vertexCount);
+  for (Mn::UnsignedInt v = 0; v != vertexCount; ++v) {
+    vertexScores[v] = vertexScore(-1, remaining[v]);
+  }
+  std::vector<float> triangleScores(triangleCount);
+  std::size_t best = 0;
+  for (std::size_t t = 0; t != triangleCount; ++t) {
+    triangleScores[t] = vertexScores[indices[3 * t]] +
+                        vertexScores[indices[3 * t + 1]] +
+                        vertexScores[indices[3 * t + 2]];
+    if (triangleScores[t] > triangleScores[best]) {
+      best = t;
+    }
+  }
+
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<Mn::UnsignedInt> output;
+  output.reserve(triangleCount * 3);
+  std::vector<Mn::UnsignedInt> cache, newCache;
+  cache.reserve(ScoreCacheSize + 3);
+  newCache.reserve(ScoreCacheSize + 3);
+  std::size_t cursor = 0;
+  while (true) {
+    emitted[best] = true;
+    const Mn::UnsignedInt* triangle = indices.data() + 3 * best;
+    output.insert(output.end(), triangle, triangle + 3);
+
+    // a degenerate triangle may repeat a vertex, the cache must not
+    newCache.clear();
+    for (int i = 0; i != 3; ++i) {
+      if (std::find(newCache.begin(), newCache.end(), triangle[i]) ==
+          newCache.end()) {
+        newCache.push_back(triangle[i]);
+      }
+    }
+    for (const Mn::UnsignedInt v : cache) {
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+        newCache.push_back(v);
+      }
+    }
+    for (int i = 0; i != 3; ++i) {
+      const Mn::UnsignedInt v = triangle[i];
+      Mn::UnsignedInt* begin = adjacency.data() + offsets[v];
+      Mn::UnsignedInt* last = begin + remaining[v] - 1;
+      std::iter_swap(std::find(begin, last, Mn::UnsignedInt(best)), last);
+      --remaining[v];
+    }
+
+    // rescore the cached vertices, and the ones just evicted
+    for (std::size_t i = 0; i != newCache.size(); ++i) {
+      const Mn::UnsignedInt v = newCache[i];
+      cachePositions[v] = i < std::size_t(ScoreCacheSize) ? int(i) : -1;
+      vertexScores[v] = vertexScore(cachePositions[v], remaining[v]);
+    }
+    float bestScore = -1.0f;
+    for (const Mn::UnsignedInt v : newCache) {
+      for (std::size_t j = 0; j != remaining[v]; ++j) {
+        const Mn::UnsignedInt t = adjacency[offsets[v] + j];
+        triangleScores[t] = vertexScores[indices[3 * t]] +
+                            vertexScores[indices[3 * t + 1]] +
+                            vertexScores[indices[3 * t + 2]];
+        if (triangleScores[t] > bestScore) {
+          bestScore = triangleScores[t];
+          best = t;
+        }
+      }
+    }
+    newCache.resize(std::min<std::size_t>(newCache.size(), ScoreCacheSize));
+    std::swap(cache, newCache);
+
+    if (bestScore < 0.0f) {
+      // nothing left around the cache, continue with the next triangle
+      while (cursor != triangleCount && emitted[cursor]) {
+        ++cursor;
+      }
+      if (cursor == triangleCount) {
+        break;
+      }
+      best = cursor;
+    }
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimizeOverdraw(Cr::Containers::ArrayView<Mn::UnsignedInt> indices,
+                      Cr::Containers::ArrayView<const Mn::Vector3> positions,
+                      Mn::UnsignedInt cacheSize) {
+  const std::size_t triangleCount = indices.size() / 3;
+  if (triangleCount < 2) {
+    return;
+  }
+
+  std::vector<Mn::UnsignedInt> timestamps(positions.size(), 0);
+  Mn::UnsignedInt time = cacheSize + 1;
+  const auto triangleMisses = [&](std::size_t t) {
+    int misses = 0;
+    for (std::size_t i = 3 * t; i != 3 * t + 3; ++i) {
+      if (time - timestamps[indices[i]] > cacheSize) {
+        timestamps[indices[i]] = time++;
+        ++misses;
+      }
+    }
+    return misses;
+  };
+
+  // hard boundaries, where the cache has none of the vertices of a triangle
+  std::vector<std::size_t> hardStarts{0};
+  triangleMisses(0);
+  for (std::size_t t = 1; t != triangleCount; ++t) {
+    if (triangleMisses(t) == 3) {
+      hardStarts.push_back(t);
+    }
+  }
+  hardStarts.push_back(triangleCount);
+
+  // soft boundaries within them, wherever the groups so far would be
+  // drawn about as cache efficiently on their own as the whole region
+  std::vector<std::size_t> groupStarts;
+  for (std::size_t h = 0; h + 1 != hardStarts.size(); ++h) {
+    const std::size_t begin = hardStarts[h], end = hardStarts[h + 1];
+    time += cacheSize + 1;
+    std::size_t regionMisses = 0;
+    for (std::size_t t = begin; t != end; ++t) {
+      regionMisses += triangleMisses(t);
+    }
+    const float threshold =
+        GroupMissRatioThreshold * float(regionMisses) / float(end - begin);
+
+    time += cacheSize + 1;
+    std::size_t groupStart = begin, groupMisses = 0;
+    groupStarts.push_back(begin);
+    for (std::size_t t = begin; t + 1 < end; ++t) {
+      groupMisses += triangleMisses(t);
+      const std::size_t groupSize = t + 1 - groupStart;
+      if (groupSize >= MinGroupTriangles &&
+          float(groupMisses) <= threshold * float(groupSize)) {
+        groupStart = t + 1;
+        groupMisses = 0;
+        groupStarts.push_back(groupStart);
+        time += cacheSize + 1;
+      }
+    }
+  }
+  if (groupStarts.size() < 2) {
+    return;
+  }
+  groupStarts.push_back(triangleCount);
+
+  // area-weighted normals and centroids of the groups and the mesh
+  const std::size_t groupCount = groupStarts.size() - 1;
+  std::vector<Mn::Vector3> normals(groupCount), centroids(groupCount);
+  std::vector<float> areas(groupCount, 0.0f);
+  Mn::Vector3 meshCentroid;
+  float meshArea = 0.0f;
+  for (std::size_t g = 0; g != groupCount; ++g) {
+    for (std::size_t t = groupStarts[g]; t != groupStarts[g + 1]; ++t) {
+      const Mn::Vector3& a = positions[indices[3 * t]];
+      const Mn::Vector3& b = positions[indices[3 * t + 1]];
+      const Mn::Vector3& c = positions[indices[3 * t + 2]];
+      const Mn::Vector3 normal = Mn::Math::cross(b - a, c - a);
+      const float area = normal.length();
+      normals[g] += normal;
+      centroids[g] += area * (a + b + c) / 3.0f;
+      areas[g] += area;
+    }
+    meshCentroid += centroids[g];
+    meshArea += areas[g];
+    if (areas[g] > 0.0f) {
+      centroids[g] /= areas[g];
+    }
+  }
+  if (!(meshArea > 0.0f)) {
+    return;
+  }
+  meshCentroid /= meshArea;
+
+  std::vector<float> keys(groupCount, 0.0f);
+  for (std::size_t g = 0; g != groupCount; ++g) {
+    const float length = normals[g].length();
+    if (length > 0.0f) {
+      keys[g] = Mn::Math::dot(centroids[g] - meshCentroid, normals[g]) / length;
+    }
+  }
+  std::vector<std::size_t> order(groupCount);
+  for (std::size_t g = 0; g != groupCount; ++g) {
+    order[g] = g;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return keys[a] > keys[b];
+                   });
+
+  std::vector<Mn::UnsignedInt> output;
+  output.reserve(triangleCount * 3);
+  for (const std::size_t g : order) {
+    output.insert(output.end(), indices.begin() + 3 * groupStarts[g],
+                  indices.begin() + 3 * groupStarts[g + 1]);
+  }
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+float averageCacheMissRatio(
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    Mn::UnsignedInt vertexCount,
+    Mn::UnsignedInt cacheSize) {
+  const std::size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0) {
+    return 0.0f;
+  }
+  std::vector<Mn::UnsignedInt> timestamps(vertexCount, 0);
+  Mn::UnsignedInt time = cacheSize + 1;
+  std::size_t misses = 0;
+  for (std::size_t i = 0; i != triangleCount * 3; ++i) {
+    if (time - timestamps[indices[i]] > cacheSize) {
+      timestamps[indices[i]] = time++;
+      ++misses;
+    }
+  }
+  return float(misses) / float(triangleCount);
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,256 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "MeshArena.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Attribute.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Shaders/Generic.h>
+#include <Magnum/Trade/MeshData.h>
+#include <Magnum/VertexFormat.h>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+//! the ranges are aligned for any vertex format and index type
+constexpr std::size_t Alignment = 16;
+
+std::size_t alignedSize(std::size_t size) {
+  return (size + Alignment - 1) / Alignment * Alignment;
+}
+
+Mn::GL::DynamicAttribute genericAttribute(Mn::Trade::MeshAttribute name,
+                                          Mn::VertexFormat format) {
+  switch (name) {
+    case Mn::Trade::MeshAttribute::Position:
+      return Mn::GL::DynamicAttribute{Mn::Shaders::Generic3D::Position{},
+                                      format};
+    case Mn::Trade::MeshAttribute::TextureCoordinates:
+      return Mn::GL::DynamicAttribute{
+          Mn::Shaders::Generic3D::TextureCoordinates{}, format};
+    case Mn::Trade::MeshAttribute::Color:
+      // as compile(), Color4 for any color format
+      return Mn::GL::DynamicAttribute{Mn::Shaders::Generic3D::Color4{},
+                                      format};
+    case Mn::Trade::MeshAttribute::Normal:
+      return Mn::GL::DynamicAttribute{Mn::Shaders::Generic3D::Normal{},
+                                      format};
+    default:
+      CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+  }
+}
+}  // namespace
+
+/**
+ * @brief A buffer of a @ref MeshArena and its free ranges
+ */
+class MeshArena::Pool {
+ public:
+  Pool(Kind kind, std::size_t capacity)
+      : kind{kind},
+        capacity{capacity},
+        buffer{kind == Kind::Vertex
+                   ? Mn::GL::Buffer::TargetHint::Array
+                   : Mn::GL::Buffer::TargetHint::ElementArray} {
+    buffer.setData({nullptr, capacity}, Mn::GL::BufferUsage::StaticDraw);
+    freeRanges.emplace(0, capacity);
+  }
+
+  /**
+   * @brief Take the first free range that fits @p size bytes
+   * @return Whether one did
+   */
+  bool allocate(std::size_t size, std::size_t& offset) {
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+      if (it->second < size) {
+        continue;
+      }
+      offset = it->first;
+      const std::size_t rest = it->second - size;
+      freeRanges.erase(it);
+      if (rest != 0) {
+        freeRanges.emplace(offset + size, rest);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  /** @brief Give a range back, merged with the free ranges next to it */
+  void free(std::size_t offset, std::size_t size) {
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.end() && offset + size == next->first) {
+      size += next->second;
+      next = freeRanges.erase(next);
+    }
+    if (next != freeRanges.begin()) {
+      const auto previous = std::prev(next);
+      if (previous->first + previous->second == offset) {
+        previous->second += size;
+        return;
+      }
+    }
+    freeRanges.emplace(offset, size);
+  }
+
+  std::size_t freeBytes() const {
+    std::size_t bytes = 0;
+    for (const auto& range : freeRanges) {
+      bytes += range.second;
+    }
+    return bytes;
+  }
+
+  const Kind kind;
+  const std::size_t capacity;
+  Mn::GL::Buffer buffer;
+  //! size of each free range by its offset
+  std::map<std::size_t, std::size_t> freeRanges;
+};
+
+MeshArena::Allocation::Allocation(Allocation&& other) noexcept
+    : pool_{std::move(other.pool_)},
+      offset_{other.offset_},
+      size_{other.size_} {
+  other.pool_ = nullptr;
+}
+
+MeshArena::Allocation::~Allocation() {
+  if (pool_) {
+    pool_->free(offset_, size_);
+  }
+}
+
+MeshArena::Allocation& MeshArena::Allocation::operator=(
+    Allocation&& other) noexcept {
+  if (this != &other) {
+    if (pool_) {
+      pool_->free(offset_, size_);
+    }
+    pool_ = std::move(other.pool_);
+    offset_ = other.offset_;
+    size_ = other.size_;
+    other.pool_ = nullptr;
+  }
+  return *this;
+}
+
+Mn::GL::Buffer& MeshArena::Allocation::buffer() const {
+  CORRADE_INTERNAL_ASSERT(pool_);
+  return pool_->buffer;
+}
+
+MeshArena::MeshArena(std::size_t poolSize)
+    : poolSize_{alignedSize(poolSize)} {}
+
+MeshArena::~MeshArena() = default;
+
+MeshArena::Allocation MeshArena::allocate(
+    Kind kind,
+    Cr::Containers::ArrayView<const void> data) {
+  Allocation allocation;
+  if (data.empty()) {
+    return allocation;
+  }
+  const std::size_t size = alignedSize(data.size());
+  std::size_t offset = 0;
+  for (const std::weak_ptr<Pool>& weakPool : pools_) {
+    std::shared_ptr<Pool> pool = weakPool.lock();
+    if (pool && pool->kind == kind && pool->allocate(size, offset)) {
+      allocation.pool_ = std::move(pool);
+      break;
+    }
+  }
+  if (!allocation) {
+    pools_.erase(std::remove_if(pools_.begin(), pools_.end(),
+                                [](const std::weak_ptr<Pool>& pool) {
+                                  return pool.expired();
+                                }),
+                 pools_.end());
+    auto pool = std::make_shared<Pool>(kind, std::max(poolSize_, size));
+    CORRADE_INTERNAL_ASSERT_OUTPUT(pool->allocate(size, offset));
+    pools_.emplace_back(pool);
+    allocation.pool_ = std::move(pool);
+  }
+  allocation.offset_ = offset;
+  allocation.size_ = size;
+  allocation.pool_->buffer.setSubData(offset, data);
+  return allocation;
+}
+
+bool MeshArena::canCompile(const Mn::Trade::MeshData& data) {
+  if (data.vertexCount() == 0 ||
+      !data.hasAttribute(Mn::Trade::MeshAttribute::Position)) {
+    return false;
+  }
+  for (Mn::UnsignedInt i = 0; i != data.attributeCount(); ++i) {
+    if (Mn::isVertexFormatImplementationSpecific(data.attributeFormat(i))) {
+      return false;
+    }
+    switch (data.attributeName(i)) {
+      case Mn::Trade::MeshAttribute::Position:
+      case Mn::Trade::MeshAttribute::TextureCoordinates:
+      case Mn::Trade::MeshAttribute::Color:
+      case Mn::Trade::MeshAttribute::Normal:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+Mn::GL::Mesh MeshArena::compile(const Mn::Trade::MeshData& data,
+                                Allocation& vertices,
+                                Allocation& indices) {
+  CORRADE_INTERNAL_ASSERT(canCompile(data));
+  vertices = allocate(Kind::Vertex, data.vertexData());
+  indices = data.isIndexed() ? allocate(Kind::Index, data.indexData())
+                             : Allocation{};
+
+  Mn::GL::Mesh mesh{data.primitive()};
+  for (Mn::UnsignedInt i = 0; i != data.attributeCount(); ++i) {
+    mesh.addVertexBuffer(
+        vertices.buffer(), vertices.offset() + data.attributeOffset(i),
+        data.attributeStride(i),
+        genericAttribute(data.attributeName(i), data.attributeFormat(i)));
+  }
+  if (data.isIndexed()) {
+    mesh.setIndexBuffer(indices.buffer(),
+                        indices.offset() + data.indexOffset(),
+                        data.indexType())
+        .setCount(data.indexCount());
+  } else {
+    mesh.setCount(data.vertexCount());
+  }
+  return mesh;
+}
+
+std::size_t MeshArena::poolCount() const {
+  return std::count_if(
+      pools_.begin(), pools_.end(),
+      [](const std::weak_ptr<Pool>& pool) { return !pool.expired(); });
+}
+
+std::size_t MeshArena::getFreeBytes() const {
+  std::size_t bytes = 0;
+  for (const std::weak_ptr<Pool>& weakPool : pools_) {
+    if (const std::shared_ptr<Pool> pool = weakPool.lock()) {
+      bytes += pool->freeBytes();
+    }
+  }
+  return bytes;
+}
+
+}  // namespace assets
+}  // namespace esp
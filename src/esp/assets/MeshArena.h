@@ -0,0 +1,149 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_MESHARENA_H_
+#define ESP_ASSETS_MESHARENA_H_
+
+/** @file
+ * @brief Class @ref esp::assets::MeshArena
+ */
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/GL/GL.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Trade/Trade.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief Large vertex and index buffers shared by many meshes
+ *
+ * Instead of a pair of GL buffers per mesh, the data of the meshes are
+ * suballocated from a few pools of @ref poolSize() bytes, a pool of vertex
+ * and one of index buffers at a time, and their meshes draw from offsets
+ * into them, see @ref compile(). Data larger than a pool get a pool of their
+ * own. The ranges of a pool go back to its free list when their @ref
+ * Allocation is destroyed, e.g. with the mesh of a removed asset, and are
+ * reused by later allocations. The pools live as long as any allocation of
+ * theirs.
+ */
+class MeshArena {
+ public:
+  /** @brief Default size of a pool, in bytes */
+  static constexpr std::size_t DefaultPoolSize = 32 * 1024 * 1024;
+
+  /** @brief Kind of the data of a pool */
+  enum class Kind { Vertex, Index };
+
+  class Pool;
+
+  /**
+   * @brief A range of a pool, given back when destroyed
+   */
+  class Allocation {
+   public:
+    /** @brief Construct an empty allocation */
+    Allocation() = default;
+
+    Allocation(const Allocation&) = delete;
+    Allocation(Allocation&& other) noexcept;
+    ~Allocation();
+
+    Allocation& operator=(const Allocation&) = delete;
+    Allocation& operator=(Allocation&& other) noexcept;
+
+    /** @brief Whether the allocation has a range */
+    explicit operator bool() const { return pool_ != nullptr; }
+
+    /**
+     * @brief The buffer of the pool, expects a non-empty allocation
+     */
+    Magnum::GL::Buffer& buffer() const;
+
+    /** @brief Offset of the range in the buffer, in bytes */
+    std::size_t offset() const { return offset_; }
+
+    /** @brief Size of the range, in bytes */
+    std::size_t size() const { return size_; }
+
+   private:
+    friend MeshArena;
+
+    std::shared_ptr<Pool> pool_;
+    std::size_t offset_ = 0;
+    std::size_t size_ = 0;
+  };
+
+  /**
+   * @brief Constructor
+   * @param poolSize Size of each pool, in bytes
+   *
+   * The buffers are only created by the first allocations, which need a
+   * current GL context.
+   */
+  explicit MeshArena(std::size_t poolSize = DefaultPoolSize);
+
+  ~MeshArena();
+
+  /** @brief Size of each pool, in bytes */
+  std::size_t poolSize() const { return poolSize_; }
+
+  /**
+   * @brief Copy data into a free range of a pool of @p kind
+   * @return The allocation, empty for empty @p data
+   */
+  Allocation allocate(Kind kind,
+                      Corrade::Containers::ArrayView<const void> data);
+
+  /**
+   * @brief Whether @ref compile() supports a mesh
+   *
+   * Meshes with positions, texture coordinates, colors and normals in
+   * formats Magnum knows are supported.
+   */
+  static bool canCompile(const Magnum::Trade::MeshData& data);
+
+  /**
+   * @brief Copy a mesh into the arena and make a mesh drawing it
+   * @param data The mesh, expected to be supported, see @ref canCompile()
+   * @param[out] vertices The allocation of the vertex data
+   * @param[out] indices The allocation of the index data, empty for a
+   *    non-indexed mesh
+   *
+   * As @ref Magnum::MeshTools::compile(), the attributes are bound to the
+   * matching @ref Magnum::Shaders::Generic attributes. The mesh does not own
+   * the buffers, it draws as long as both allocations are kept.
+   */
+  Magnum::GL::Mesh compile(const Magnum::Trade::MeshData& data,
+                           Allocation& vertices,
+                           Allocation& indices);
+
+  /** @brief Number of pools in use, of all kinds */
+  std::size_t poolCount() const;
+
+  /**
+   * @brief Bytes of the pools in use not allocated, e.g. the rest of the
+   * pool filled last or the ranges of removed meshes
+   */
+  std::size_t getFreeBytes() const;
+
+ private:
+  std::size_t poolSize_;
+  //! the pools filled so far, expired with their last allocation
+  std::vector<std::weak_ptr<Pool>> pools_;
+
+  ESP_SMART_POINTERS(MeshArena)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_MESHARENA_H_
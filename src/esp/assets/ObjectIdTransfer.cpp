@@ -0,0 +1,87 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObjectIdTransfer.h"
+
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+struct CellHash {
+  std::size_t operator()(const Mn::Vector3i& cell) const {
+    // the primes of "Optimized Spatial Hashing for Collision Detection of
+    // Deformable Objects" by Teschner et al.
+    return (std::size_t(cell.x()) * 73856093u) ^
+           (std::size_t(cell.y()) * 19349663u) ^
+           (std::size_t(cell.z()) * 83492791u);
+  }
+};
+
+}  // namespace
+
+std::vector<Mn::UnsignedInt> transferObjectIds(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::Vector3> sourcePositions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> sourceObjectIds,
+    float maxDistance) {
+  CORRADE_ASSERT(sourcePositions.size() == sourceObjectIds.size(),
+                 "transferObjectIds(): expected" << sourcePositions.size()
+                                                 << "object ids, got"
+                                                 << sourceObjectIds.size(),
+                 {});
+  CORRADE_ASSERT(maxDistance > 0.0f,
+                 "transferObjectIds(): the distance has to be positive", {});
+
+  const auto cellOf = [&](const Mn::Vector3& position) {
+    return Mn::Vector3i{Mn::Math::floor(position / maxDistance)};
+  };
+
+  // the source vertices of each cell
+  std::unordered_map<Mn::Vector3i, std::vector<Mn::UnsignedInt>, CellHash>
+      cells;
+  for (Mn::UnsignedInt i = 0; i != sourcePositions.size(); ++i) {
+    cells[cellOf(sourcePositions[i])].push_back(i);
+  }
+
+  const float maxDistanceSquared = maxDistance * maxDistance;
+  std::vector<Mn::UnsignedInt> objectIds(positions.size(), 0);
+  for (std::size_t i = 0; i != positions.size(); ++i) {
+    const Mn::Vector3& position = positions[i];
+    const Mn::Vector3i cell = cellOf(position);
+    float nearest = std::numeric_limits<float>::infinity();
+    for (int z = -1; z <= 1; ++z) {
+      for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+          auto found = cells.find(cell + Mn::Vector3i{x, y, z});
+          if (found == cells.end()) {
+            continue;
+          }
+          for (Mn::UnsignedInt source : found->second) {
+            const float distance =
+                (sourcePositions[source] - position).dot();
+            if (distance < nearest && distance <= maxDistanceSquared) {
+              nearest = distance;
+              objectIds[i] = sourceObjectIds[source];
+            }
+          }
+        }
+      }
+    }
+  }
+  return objectIds;
+}
+
+}  // namespace assets
+}  // namespace esp
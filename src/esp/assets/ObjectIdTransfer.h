@@ -0,0 +1,44 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_OBJECTIDTRANSFER_H_
+#define ESP_ASSETS_OBJECTIDTRANSFER_H_
+
+/** @file
+ * @brief Function @ref esp::assets::transferObjectIds()
+ */
+
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief The object id of the vertex of another mesh nearest to each of
+ * @p positions, e.g. to draw the object ids of a semantic mesh with the
+ * geometry of the render mesh it annotates.
+ *
+ * The source vertices are hashed into a grid of cells of @p maxDistance, so
+ * that a lookup only visits the 27 cells around a position.
+ * @param positions The positions to look up, in the space of the source mesh
+ * @param sourcePositions The vertex positions of the source mesh
+ * @param sourceObjectIds The object id of each source vertex
+ * @param maxDistance The farthest a source vertex may be from a position
+ * @return The object id of each position, 0 where there is no source vertex
+ * within @p maxDistance
+ */
+std::vector<Magnum::UnsignedInt> transferObjectIds(
+    Corrade::Containers::ArrayView<const Magnum::Vector3> positions,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> sourcePositions,
+    Corrade::Containers::ArrayView<const Magnum::UnsignedInt> sourceObjectIds,
+    float maxDistance);
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_OBJECTIDTRANSFER_H_
@@ -0,0 +1,113 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PTexAtlasCache.h"
+
+#include <cmath>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/DebugStl.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+
+#include "esp/core/esp.h"
+#include "esp/io/io.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+std::shared_ptr<PTexAtlasCache> PTexAtlasCache::forCurrentContext() {
+  // the textures must go with their context, so the map only observes them
+  static std::map<Mn::GL::Context*, std::weak_ptr<PTexAtlasCache>> caches;
+  std::weak_ptr<PTexAtlasCache>& cache = caches[&Mn::GL::Context::current()];
+  std::shared_ptr<PTexAtlasCache> shared = cache.lock();
+  if (!shared) {
+    shared = std::make_shared<PTexAtlasCache>();
+    cache = shared;
+  }
+  return shared;
+}
+
+std::size_t PTexAtlasCache::loadAtlas(const std::string& hdrFile,
+                                      Mn::GL::Texture2D& texture) {
+  CORRADE_ASSERT(io::exists(hdrFile),
+                 "PTexAtlasCache::loadAtlas: Cannot find the .hdr file"
+                     << hdrFile,
+                 0);
+
+  Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter> data =
+      Cr::Utility::Directory::mapRead(hdrFile);
+  // divided by 6, since there are 3 channels, R, G, B, each of which takes
+  // 1 half_float (2 bytes)
+  const int dim = static_cast<int>(std::sqrt(data.size() / 6));  // square
+  CORRADE_ASSERT(dim * dim * 6 == data.size(),
+                 "PTexAtlasCache::loadAtlas: the atlas texture is not "
+                 "a square",
+                 0);
+
+  // atlas
+  // the size of each image is dim x dim x 3 (RGB) x 2 (half_float), which
+  // equals to numBytes
+  Magnum::ImageView2D image(Magnum::PixelFormat::RGB16F, {dim, dim}, data);
+
+  texture.setWrapping(Magnum::GL::SamplerWrapping::ClampToEdge)
+      .setMagnificationFilter(Magnum::GL::SamplerFilter::Linear)
+      .setMinificationFilter(Magnum::GL::SamplerFilter::Linear)
+      .setStorage(Magnum::Math::log2(image.size().min()) + 1,  // mip levels
+                  Magnum::GL::TextureFormat::RGB16F, image.size())
+      .setSubImage(0,   // mipLevel
+                   {},  // offset
+                   image)
+      .generateMipmap();
+
+  // the mip levels add up to a third of the first level
+  return data.size() * 4 / 3;
+}
+
+void PTexAtlasCache::setBudget(std::size_t bytes) {
+  budget_ = bytes;
+  evict({});
+}
+
+Mn::GL::Texture2D& PTexAtlasCache::acquire(const std::string& hdrFile) {
+  Atlas& atlas = atlases_[hdrFile];
+  atlas.lastUsed = ++useCount_;
+  if (!atlas.texture) {
+    atlas.texture = std::make_unique<Mn::GL::Texture2D>();
+    atlas.bytes = loadAtlas(hdrFile, *atlas.texture);
+    residentBytes_ += atlas.bytes;
+    evict(hdrFile);
+  }
+  return *atlas.texture;
+}
+
+void PTexAtlasCache::evict(const std::string& keep) {
+  while (budget_ != 0 && residentBytes_ > budget_) {
+    auto leastRecent = atlases_.end();
+    for (auto it = atlases_.begin(); it != atlases_.end(); ++it) {
+      if (it->first != keep &&
+          (leastRecent == atlases_.end() ||
+           it->second.lastUsed < leastRecent->second.lastUsed)) {
+        leastRecent = it;
+      }
+    }
+    if (leastRecent == atlases_.end()) {
+      // a single atlas over the budget stays resident
+      break;
+    }
+    residentBytes_ -= leastRecent->second.bytes;
+    atlases_.erase(leastRecent);
+  }
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,92 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_PTEXATLASCACHE_H_
+#define ESP_ASSETS_PTEXATLASCACHE_H_
+
+/** @file
+ * @brief Class @ref esp::assets::PTexAtlasCache
+ */
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <Magnum/GL/Texture.h>
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief PTex atlas textures uploaded on first use and evicted under a GPU
+ * memory budget, shared by all @ref PTexMeshData of a GL context.
+ *
+ * A streaming @ref PTexMeshData asks for the atlas of a submesh only when a
+ * drawable of it is drawn, which is after frustum culling, so only the atlases
+ * of visible submeshes are resident. When an upload exceeds the budget, the
+ * least recently drawn atlases are evicted. A budget smaller than the atlases
+ * visible in one frame makes them upload again every frame.
+ *
+ * Simulators in one process render with the same GL context, so the atlases
+ * of a scene loaded by several of them are uploaded once. Not thread-safe,
+ * like the GL context.
+ */
+class PTexAtlasCache {
+ public:
+  /**
+   * @brief The cache of the current GL context, created on first use and
+   * destroyed with the last @ref PTexMeshData holding it
+   */
+  static std::shared_ptr<PTexAtlasCache> forCurrentContext();
+
+  /**
+   * @brief Load an atlas file into a texture, with all of its mip levels
+   * @return The estimated GPU memory of the texture, in bytes
+   */
+  static std::size_t loadAtlas(const std::string& hdrFile,
+                               Magnum::GL::Texture2D& texture);
+
+  /**
+   * @brief Set the GPU memory budget of the resident atlases, 0 for no limit.
+   * Shared by every user of the cache, so the last one set applies.
+   */
+  void setBudget(std::size_t bytes);
+
+  /** @brief The GPU memory budget of the resident atlases */
+  std::size_t getBudget() const { return budget_; }
+
+  /** @brief Estimated GPU memory of the resident atlases */
+  std::size_t getResidentBytes() const { return residentBytes_; }
+
+  /** @brief The number of resident atlases */
+  std::size_t getResidentCount() const { return atlases_.size(); }
+
+  /**
+   * @brief The atlas texture of @p hdrFile, uploading it if it is not
+   * resident. The reference is valid until the next call.
+   */
+  Magnum::GL::Texture2D& acquire(const std::string& hdrFile);
+
+ private:
+  struct Atlas {
+    std::unique_ptr<Magnum::GL::Texture2D> texture;
+    std::size_t bytes = 0;
+    //! value of @ref useCount_ when the atlas was last acquired
+    uint64_t lastUsed = 0;
+  };
+
+  //! evict the least recently used atlases but @p keep until in the budget
+  void evict(const std::string& keep);
+
+  std::map<std::string, Atlas> atlases_;
+  uint64_t useCount_ = 0;
+  std::size_t budget_ = 0;
+  std::size_t residentBytes_ = 0;
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_PTEXATLASCACHE_H_
@@ -4,11 +4,16 @@
 
 #include "PTexMeshData.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/ArrayViewStl.h>
@@ -18,9 +23,8 @@
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/GL/BufferTextureFormat.h>
 #include <Magnum/GL/TextureFormat.h>
-#include <Magnum/ImageView.h>
-#include <Magnum/PixelFormat.h>
 
+#include "esp/core/Profiling.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/PTexMeshShader.h"
 #include "esp/io/io.h"
@@ -34,6 +38,42 @@ namespace Cr = Corrade;
 namespace esp {
 namespace assets {
 
+namespace {
+
+/**
+ * @brief Sort @p values with all OpenMP threads, by sorting a chunk per thread
+ * and merging the chunks pairwise. Equal values keep no particular order.
+ */
+template <typename T, typename Compare>
+void parallelSort(std::vector<T>& values, Compare compare) {
+#ifdef _OPENMP
+  const size_t numChunks = omp_get_max_threads();
+#else
+  const size_t numChunks = 1;
+#endif
+  const auto chunkBegin = [&](size_t chunk) {
+    return values.begin() + values.size() * chunk / numChunks;
+  };
+
+#pragma omp parallel for
+  for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+    std::sort(chunkBegin(chunk), chunkBegin(chunk + 1), compare);
+  }
+
+  for (size_t width = 1; width < numChunks; width *= 2) {
+#pragma omp parallel for
+    for (size_t chunk = 0; chunk < numChunks; chunk += 2 * width) {
+      if (chunk + width < numChunks) {
+        std::inplace_merge(chunkBegin(chunk), chunkBegin(chunk + width),
+                           chunkBegin(std::min(chunk + 2 * width, numChunks)),
+                           compare);
+      }
+    }
+  }
+}
+
+}  // namespace
+
 void PTexMeshData::load(const std::string& meshFile,
                         const std::string& atlasFolder) {
   if (!io::exists(meshFile)) {
@@ -108,6 +148,31 @@ void computeTriangleMeshIndices(uint64_t numFaces,
   }
 }
 
+// the vertices of the quads, four consecutive ones of their own per quad,
+// and the indices of two triangles per quad, (0, 1, 2) and (0, 2, 3) as in
+// computeTriangleMeshIndices(). The PTex shader derives the face and the
+// atlas coordinates from the index of the vertex.
+void computeCornerMesh(const PTexMeshData::MeshData& mesh,
+                       std::vector<vec3f>& corners,
+                       std::vector<uint32_t>& indices) {
+  const size_t numFaces = mesh.ibo.size() / 4;
+  corners.resize(numFaces * 4);
+  indices.resize(numFaces * 6);
+  for (size_t jFace = 0; jFace < numFaces; ++jFace) {
+    const uint32_t first = jFace * 4;
+    for (uint32_t k = 0; k < 4; ++k) {
+      corners[first + k] = mesh.vbo[mesh.ibo[first + k]];
+    }
+    uint32_t* triangles = &indices[jFace * 6];
+    triangles[0] = first + 0;
+    triangles[1] = first + 1;
+    triangles[2] = first + 2;
+    triangles[3] = first + 0;
+    triangles[4] = first + 2;
+    triangles[5] = first + 3;
+  }
+}
+
 // split the original ptex mesh into sub-meshes.
 //
 // WARNING:
@@ -304,18 +369,27 @@ std::vector<PTexMeshData::MeshData> loadSubMeshes(
 
   std::vector<PTexMeshData::MeshData> subMeshes(numSubMeshes);
 
+  // the face indices in the *original* mesh of each sub-mesh, read first so
+  // the sub-meshes can be built in parallel
+  std::vector<std::vector<uint32_t>> originalFaces(numSubMeshes);
   size_t totalFaces = 0;  // used in sanity check
   for (uint64_t iMesh = 0; iMesh < numSubMeshes; ++iMesh) {
     uint64_t numFaces = 0;
     file.read(reinterpret_cast<char*>(&numFaces), sizeof(uint64_t));
 
-    std::vector<uint32_t> originalFaces(numFaces);
-    // load the face indices in the *original* mesh
-    file.read(reinterpret_cast<char*>(originalFaces.data()),
+    originalFaces[iMesh].resize(numFaces);
+    file.read(reinterpret_cast<char*>(originalFaces[iMesh].data()),
               sizeof(uint32_t) * numFaces);
+    totalFaces += numFaces;
+  }
+
+#pragma omp parallel for schedule(dynamic)
+  for (uint64_t iMesh = 0; iMesh < numSubMeshes; ++iMesh) {
+    const std::vector<uint32_t>& faces = originalFaces[iMesh];
+    const size_t numFaces = faces.size();
     // a *vertex* lookup table:
     // global index of the original mesh --> local index in sub-meshes
-    // (note: this table cannot be defined outside of the for loop, as a vertex
+    // (note: this table cannot be shared by the sub-meshes, as a vertex
     // in original mesh may appear in different sub-meshes.)
     std::unordered_map<uint32_t, uint32_t> globalToLocal;
 
@@ -323,32 +397,19 @@ std::vector<PTexMeshData::MeshData> loadSubMeshes(
     // local index of current sub-mesh --> global index of the original mesh
     std::vector<uint32_t> localToGlobal;
 
-    // compute the two lookup tables
-    for (size_t jFace = 0; jFace < numFaces; ++jFace) {
-      uint32_t f = originalFaces[jFace];  // face index in original mesh
-      for (size_t v = 0; v < 4; ++v) {
-        uint32_t global = mesh.ibo[f * 4 + v];
-        if (globalToLocal.find(global) == globalToLocal.end()) {
-          globalToLocal[global] = localToGlobal.size();
-          localToGlobal.push_back(global);
-        }
-      }
-    }
-
-    // compute the ibo for the current sub-mesh
+    // compute the two lookup tables and the ibo for the current sub-mesh
     auto& ibo = subMeshes[iMesh].ibo;
     ibo.resize(numFaces * 4);
     uint64_t idx = 0;
     for (size_t jFace = 0; jFace < numFaces; ++jFace) {
-      uint32_t f = originalFaces[jFace];
+      uint32_t f = faces[jFace];  // face index in original mesh
       for (size_t v = 0; v < 4; ++v) {
         uint32_t global = mesh.ibo[f * 4 + v];
-        uint32_t local = globalToLocal[global];
-        CORRADE_ASSERT(local >= 0,
-                       "PTexMeshData::loadSubMeshes: vertex "
-                           << global << " is not in the sub-mesh " << iMesh,
-                       {});
-        ibo[idx++] = local;
+        auto result = globalToLocal.emplace(global, localToGlobal.size());
+        if (result.second) {
+          localToGlobal.push_back(global);
+        }
+        ibo[idx++] = result.first->second;
       }
     }  // for jFace
 
@@ -368,8 +429,6 @@ std::vector<PTexMeshData::MeshData> loadSubMeshes(
 
     // Careful:
     // for Ptex mesh we never ever set the "cbo"
-
-    totalFaces += numFaces;
   }  // for iMesh
   file.close();
   CORRADE_ASSERT(totalFaces == mesh.ibo.size() / 4,
@@ -386,74 +445,66 @@ std::vector<PTexMeshData::MeshData> loadSubMeshes(
 
 void PTexMeshData::calculateAdjacency(const PTexMeshData::MeshData& mesh,
                                       std::vector<uint32_t>& adjFaces) {
+  // every edge of every face, keyed by its two vertices in either direction.
+  // Sorting them brings the faces sharing an edge next to each other, which
+  // is much faster than hashing millions of edges, and parallelizes.
   struct EdgeData {
-    int face;
-    int edge;
+    uint64_t key;
+    // face * 4 + edge, sorted too so the faces of an edge stay in face order
+    uint32_t index;
   };
 
-  std::unordered_map<uint64_t, std::vector<EdgeData>> edgeMap;
-
-  size_t numFaces = mesh.ibo.size() / 4;
-
-  typedef std::unordered_map<uint64_t, std::vector<EdgeData>>::iterator
-      EdgeIter;
-  std::vector<EdgeIter> edgeIterators(numFaces * 4);
+  const size_t numFaces = mesh.ibo.size() / 4;
+  std::vector<EdgeData> edges(numFaces * 4);
 
   // for each face
-  for (int f = 0; f < numFaces; f++) {
+#pragma omp parallel for
+  for (size_t f = 0; f < numFaces; f++) {
     // for each edge
     for (int e = 0; e < 4; e++) {
-      // add to edge to face map
-      const int e_index = f * 4 + e;
+      const size_t e_index = f * 4 + e;
       const uint32_t i0 = mesh.ibo[e_index];
       const uint32_t i1 = mesh.ibo[f * 4 + ((e + 1) % 4)];
-      const uint64_t key =
+      edges[e_index].key =
           static_cast<uint64_t>(std::min(i0, i1)) << 32 | std::max(i0, i1);
+      edges[e_index].index = e_index;
+    }
+  }
 
-      const EdgeData edgeData{f, e};
-
-      auto it = edgeMap.find(key);
-
-      if (it == edgeMap.end()) {
-        it = edgeMap.emplace(key, std::vector<EdgeData>()).first;
-        it->second.reserve(4);
-        it->second.push_back(edgeData);
-      } else {
-        it->second.push_back(edgeData);
-      }
+  parallelSort(edges, [](const EdgeData& a, const EdgeData& b) {
+    return a.key < b.key || (a.key == b.key && a.index < b.index);
+  });
 
-      edgeIterators[e_index] = it;
-    }
+  // the start of each run of faces sharing an edge
+  std::vector<size_t> runStarts;
+  for (size_t i = 0; i < edges.size(); i++) {
+    if (i == 0 || edges[i].key != edges[i - 1].key)
+      runStarts.push_back(i);
   }
+  runStarts.push_back(edges.size());
 
   adjFaces.resize(numFaces * 4);
 
-  for (int f = 0; f < numFaces; f++) {
-    for (int e = 0; e < 4; e++) {
-      const int e_index = f * 4 + e;
-      auto it = edgeIterators[e_index];
-      const std::vector<EdgeData>& adj = it->second;
+#pragma omp parallel for
+  for (size_t run = 0; run < runStarts.size() - 1; run++) {
+    const size_t begin = runStarts[run];
+    const size_t end = runStarts[run + 1];
+    for (size_t i = begin; i < end; i++) {
+      const int f = edges[i].index / 4;
+      const int e = edges[i].index % 4;
 
       // find adjacent face
       int adjFace = -1;
-      for (size_t i = 0; i < adj.size(); i++) {
-        if (adj[i].face != f)
-          adjFace = adj[i].face;
+      for (size_t j = begin; j < end; j++) {
+        if (int(edges[j].index / 4) != f)
+          adjFace = edges[j].index / 4;
       }
 
       // find number of 90 degree rotation steps between faces
       int rot = 0;
-      if (adj.size() == 2) {
-        int edge0 = 0, edge1 = 0;
-        if (adj[0].edge == e) {
-          edge0 = adj[0].edge;
-          edge1 = adj[1].edge;
-        } else if (adj[1].edge == e) {
-          edge0 = adj[1].edge;
-          edge1 = adj[0].edge;
-        }
-
-        rot = (edge0 - edge1 + 2) & 3;
+      if (end - begin == 2) {
+        const int otherEdge = edges[i == begin ? end - 1 : begin].index % 4;
+        rot = (e - otherEdge + 2) & 3;
       }
 
       // pack adjacent face and rotation into 32-bit int
@@ -745,6 +796,9 @@ void PTexMeshData::parsePLY(const std::string& filename,
   // Parse each vertex packet and unpack
   const char* bytes = mmappedData + postHeader;
 
+  // the packets are independent, so they are unpacked in parallel straight
+  // out of the mapped file
+#pragma omp parallel for
   for (size_t i = 0; i < numVertices; i++) {
     const char* nextBytes = bytes + vertexPacketSizeBytes * i;
 
@@ -792,6 +846,7 @@ void PTexMeshData::parsePLY(const std::string& filename,
 
   meshData.ibo.resize(numFaces * faceDimensions);
 
+#pragma omp parallel for
   for (size_t i = 0; i < numFaces; i++) {
     const char* nextBytes = bytes + facePacketSizeBytes * i;
 
@@ -807,7 +862,10 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
   if (buffersOnGPU_) {
     return;
   }
+  core::ScopedTimer timer{core::ProfilingStage::GpuUpload};
 
+  gpuBytes_ = 0;
+  atlasBytes_ = 0;
   for (int iMesh = 0; iMesh < submeshes_.size(); ++iMesh) {
     LOG(INFO) << "Loading mesh " << iMesh + 1 << "/" << submeshes_.size()
               << "... ";
@@ -816,6 +874,18 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
         std::make_unique<PTexMeshData::RenderingBuffer>());
 
     auto& currentMesh = renderingBuffers_.back();
+    if (faceIdSource_ != gfx::PTexMeshShader::FaceIdSource::GeometryShader) {
+      std::vector<vec3f> corners;
+      std::vector<uint32_t> cornerIndices;
+      computeCornerMesh(submeshes_[iMesh], corners, cornerIndices);
+      currentMesh->vertexBuffer.setData(corners,
+                                        Magnum::GL::BufferUsage::StaticDraw);
+      currentMesh->triangleMeshIndexBuffer.setData(
+          cornerIndices, Magnum::GL::BufferUsage::StaticDraw);
+      gpuBytes_ += corners.size() * sizeof(vec3f) +
+                   cornerIndices.size() * sizeof(uint32_t);
+      continue;
+    }
     currentMesh->vertexBuffer.setData(submeshes_[iMesh].vbo,
                                       Magnum::GL::BufferUsage::StaticDraw);
     currentMesh->indexBuffer.setData(submeshes_[iMesh].ibo,
@@ -833,13 +903,18 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
     // https://github.com/facebookresearch/habitat-sim/pull/745/files)
     currentMesh->triangleMeshIndexBuffer.setData(
         submeshes_[iMesh].ibo_tri, Magnum::GL::BufferUsage::StaticDraw);
+    gpuBytes_ += submeshes_[iMesh].vbo.size() * sizeof(vec3f) +
+                 (submeshes_[iMesh].ibo.size() +
+                  submeshes_[iMesh].ibo_tri.size()) *
+                     sizeof(uint32_t);
   }
 #ifndef CORRADE_TARGET_APPLE
   LOG(INFO) << "Calculating mesh adjacency... ";
 
   std::vector<std::vector<uint32_t>> adjFaces(submeshes_.size());
 
-#pragma omp parallel for
+  // a single mesh parallelizes inside calculateAdjacency() instead
+#pragma omp parallel for if (submeshes_.size() > 1)
   for (int iMesh = 0; iMesh < submeshes_.size(); ++iMesh) {
     calculateAdjacency(submeshes_[iMesh], adjFaces[iMesh]);
   }
@@ -853,8 +928,23 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
         Magnum::GL::BufferTextureFormat::R32UI, currentMesh->adjFacesBuffer);
     currentMesh->adjFacesBuffer.setData(adjFaces[iMesh],
                                         Magnum::GL::BufferUsage::StaticDraw);
+    gpuBytes_ += adjFaces[iMesh].size() * sizeof(uint32_t);
 #endif
     GLintptr offset = 0;
+    if (faceIdSource_ != gfx::PTexMeshShader::FaceIdSource::GeometryShader) {
+      // two triangles per quad, with the corners in the order of the quad
+      const size_t count = submeshes_[iMesh].ibo.size() / 4 * 6;
+      for (Magnum::GL::Mesh* mesh :
+           {&currentMesh->mesh, &currentMesh->triangleMesh}) {
+        mesh->setPrimitive(Magnum::GL::MeshPrimitive::Triangles)
+            .setCount(count)
+            .addVertexBuffer(currentMesh->vertexBuffer, offset,
+                             gfx::PTexMeshShader::Position{})
+            .setIndexBuffer(currentMesh->triangleMeshIndexBuffer, offset,
+                            Magnum::GL::MeshIndexType::UnsignedInt);
+      }
+      continue;
+    }
     currentMesh->mesh
         .setPrimitive(Magnum::GL::MeshPrimitive::LinesAdjacency)
         // Warning:
@@ -881,45 +971,16 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
                         Magnum::GL::MeshIndexType::UnsignedInt);
   }
 
-  // load atlas data and upload them to GPU
-  LOG(INFO) << "loading atlas textures: ";
-  for (size_t iMesh = 0; iMesh < renderingBuffers_.size(); ++iMesh) {
-    const std::string hdrFile = Cr::Utility::Directory::join(
-        atlasFolder_, std::to_string(iMesh) + "-color-ptex.hdr");
-
-    CORRADE_ASSERT(io::exists(hdrFile),
-                   "PTexMeshData::uploadBuffersToGPU: Cannot find the .hdr file"
-                       << hdrFile, );
-
-    LOG(INFO) << "Loading atlas " << iMesh + 1 << "/"
-              << renderingBuffers_.size() << " from " << hdrFile << ". ";
-
-    Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter> data =
-        Cr::Utility::Directory::mapRead(hdrFile);
-    // divided by 6, since there are 3 channels, R, G, B, each of which takes
-    // 1 half_float (2 bytes)
-    const int dim = static_cast<int>(std::sqrt(data.size() / 6));  // square
-    CORRADE_ASSERT(dim * dim * 6 == data.size(),
-                   "PTexMeshData::uploadBuffersToGPU: the atlas texture is not "
-                   "a square", );
-
-    // atlas
-    // the size of each image is dim x dim x 3 (RGB) x 2 (half_float), which
-    // equals to numBytes
-    Magnum::ImageView2D image(Magnum::PixelFormat::RGB16F, {dim, dim}, data);
-
-    renderingBuffers_[iMesh]
-        ->atlasTexture.setWrapping(Magnum::GL::SamplerWrapping::ClampToEdge)
-        .setMagnificationFilter(Magnum::GL::SamplerFilter::Linear)
-        .setMinificationFilter(Magnum::GL::SamplerFilter::Linear)
-        .setStorage(
-            Magnum::Math::log2(image.size().min()) + 1,  // mip level count
-            Magnum::GL::TextureFormat::RGB16F,
-            image.size())
-        .setSubImage(0,   // mipLevel
-                     {},  // offset
-                     image)
-        .generateMipmap();
+  // load atlas data and upload them to GPU, unless they are streamed
+  if (!atlasCache_) {
+    LOG(INFO) << "loading atlas textures: ";
+    for (size_t iMesh = 0; iMesh < renderingBuffers_.size(); ++iMesh) {
+      LOG(INFO) << "Loading atlas " << iMesh + 1 << "/"
+                << renderingBuffers_.size() << " from " << atlasFile(iMesh)
+                << ". ";
+      atlasBytes_ += PTexAtlasCache::loadAtlas(
+          atlasFile(iMesh), renderingBuffers_[iMesh]->atlasTexture);
+    }
   }
 
   buffersOnGPU_ = true;
@@ -933,6 +994,33 @@ PTexMeshData::RenderingBuffer* PTexMeshData::getRenderingBuffer(int submeshID) {
   return renderingBuffers_[submeshID].get();
 }
 
+void PTexMeshData::setFaceIdSource(
+    gfx::PTexMeshShader::FaceIdSource faceIdSource) {
+  CORRADE_ASSERT(!buffersOnGPU_,
+                 "PTexMeshData::setFaceIdSource: the buffers are already "
+                 "uploaded", );
+  faceIdSource_ = faceIdSource;
+}
+
+void PTexMeshData::setAtlasCache(std::shared_ptr<PTexAtlasCache> atlasCache) {
+  CORRADE_ASSERT(!buffersOnGPU_,
+                 "PTexMeshData::setAtlasCache: the buffers are already "
+                 "uploaded", );
+  atlasCache_ = std::move(atlasCache);
+}
+
+std::string PTexMeshData::atlasFile(int submeshID) const {
+  return Cr::Utility::Directory::join(
+      atlasFolder_, std::to_string(submeshID) + "-color-ptex.hdr");
+}
+
+Magnum::GL::Texture2D& PTexMeshData::getAtlasTexture(int submeshID) {
+  if (atlasCache_) {
+    return atlasCache_->acquire(atlasFile(submeshID));
+  }
+  return getRenderingBuffer(submeshID)->atlasTexture;
+}
+
 Magnum::GL::Mesh* PTexMeshData::getMagnumGLMesh(int submeshID) {
   CORRADE_ASSERT(submeshID >= 0 && submeshID < renderingBuffers_.size(),
                  "PTexMeshData::getMagnumGLMesh: the submesh ID"
@@ -15,7 +15,9 @@
 #include <Magnum/GL/Texture.h>
 
 #include "BaseMesh.h"
+#include "PTexAtlasCache.h"
 #include "esp/core/esp.h"
+#include "esp/gfx/PTexMeshShader.h"
 
 namespace esp {
 namespace assets {
@@ -31,6 +33,7 @@ class PTexMeshData : public BaseMesh {
   };
 
   struct RenderingBuffer {
+    //! the mesh drawn by the PTex shader, see @ref setFaceIdSource()
     Magnum::GL::Mesh mesh;
     Magnum::GL::Mesh triangleMesh;
     Magnum::GL::Texture2D atlasTexture;
@@ -66,6 +69,48 @@ class PTexMeshData : public BaseMesh {
   virtual void uploadBuffersToGPU(bool forceReload = false) override;
   virtual Magnum::GL::Mesh* getMagnumGLMesh(int submeshID) override;
 
+  /**
+   * @brief Stream the atlases through @p atlasCache instead of uploading all
+   * of them in @ref uploadBuffersToGPU(). Must be set before the upload.
+   * @param atlasCache The cache, nullptr to upload all atlases
+   */
+  void setAtlasCache(std::shared_ptr<PTexAtlasCache> atlasCache);
+
+  /**
+   * @brief Set how the PTex shader gets the faces, see @ref
+   * gfx::PTexMeshShader::FaceIdSource. Must be set before the upload.
+   *
+   * Except with @ref gfx::PTexMeshShader::FaceIdSource::GeometryShader, the
+   * quads are uploaded as triangles of four vertices of their own, so that
+   * the vertex shader derives the atlas coordinates from gl_VertexID. Both
+   * @ref RenderingBuffer::mesh and @ref RenderingBuffer::triangleMesh then
+   * draw these triangles, which can also be drawn by other shaders, e.g. for
+   * linear depth.
+   */
+  void setFaceIdSource(gfx::PTexMeshShader::FaceIdSource faceIdSource);
+
+  /** @brief How the PTex shader gets the faces, see @ref setFaceIdSource() */
+  gfx::PTexMeshShader::FaceIdSource faceIdSource() const {
+    return faceIdSource_;
+  }
+
+  /**
+   * @brief The atlas texture of a submesh, uploaded first if it is streamed
+   * and not resident. A streamed atlas is only valid until the next call.
+   */
+  Magnum::GL::Texture2D& getAtlasTexture(int submeshID);
+
+  /**
+   * @brief Estimated GPU memory of the atlases uploaded with the buffers, 0
+   * if they are streamed through a @ref PTexAtlasCache
+   */
+  std::size_t getAtlasBytes() const { return atlasBytes_; }
+
+  /** @brief The atlas cache streaming the atlases, nullptr if there is none */
+  const std::shared_ptr<PTexAtlasCache>& getAtlasCache() const {
+    return atlasCache_;
+  }
+
   float exposure() const;
   void setExposure(float val);
 
@@ -98,6 +143,18 @@ class PTexMeshData : public BaseMesh {
   // we will have to use smart pointer here since each item within the structure
   // (e.g., Magnum::GL::Mesh) does NOT have copy constructor
   std::vector<std::unique_ptr<RenderingBuffer>> renderingBuffers_;
+
+  //! the atlas file of a submesh
+  std::string atlasFile(int submeshID) const;
+
+  //! streams the atlases, if set, see @ref setAtlasCache()
+  std::shared_ptr<PTexAtlasCache> atlasCache_;
+
+  //! estimated GPU memory of the atlases uploaded with the buffers
+  std::size_t atlasBytes_ = 0;
+
+  gfx::PTexMeshShader::FaceIdSource faceIdSource_ =
+      gfx::PTexMeshShader::defaultFaceIdSource();
 };
 
 }  // namespace assets
@@ -4,8 +4,17 @@
 
 #include "ResourceManager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
 #include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/PointerStl.h>
+#include <Corrade/Containers/StridedArrayView.h>
 #include <Corrade/PluginManager/Manager.h>
 #include <Corrade/PluginManager/PluginMetadata.h>
 #include <Corrade/Utility/Assert.h>
@@ -13,6 +22,7 @@
 #include <Corrade/Utility/Debug.h>
 #include <Corrade/Utility/DebugStl.h>
 #include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
 #include <Corrade/Utility/String.h>
 #include <Magnum/EigenIntegration/GeometryIntegration.h>
 #include <Magnum/EigenIntegration/Integration.h>
@@ -28,17 +38,22 @@
 #include <Magnum/Shaders/Flat.h>
 #include <Magnum/Trade/AbstractImporter.h>
 #include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MeshData.h>
 #include <Magnum/Trade/MeshObjectData3D.h>
 #include <Magnum/Trade/PbrMetallicRoughnessMaterialData.h>
 #include <Magnum/Trade/PhongMaterialData.h>
 #include <Magnum/Trade/SceneData.h>
 #include <Magnum/Trade/TextureData.h>
 
+#include "esp/core/Profiling.h"
+#include "esp/core/TaskScheduler.h"
 #include "esp/geo/geo.h"
 #include "esp/gfx/GenericDrawable.h"
+#include "esp/gfx/InstancedDrawable.h"
 #include "esp/gfx/MaterialUtil.h"
 #include "esp/io/io.h"
 #include "esp/io/json.h"
+#include "esp/physics/KinematicPhysicsManager.h"
 #include "esp/physics/PhysicsManager.h"
 #include "esp/scene/SceneConfiguration.h"
 #include "esp/scene/SceneGraph.h"
@@ -50,9 +65,11 @@
 #endif
 
 #include "CollisionMeshData.h"
+#include "CompressedGltf.h"
 #include "GenericInstanceMeshData.h"
 #include "GenericMeshData.h"
 #include "MeshData.h"
+#include "ObjectIdTransfer.h"
 
 #ifdef ESP_BUILD_PTEX_SUPPORT
 #include "PTexMeshData.h"
@@ -72,10 +89,210 @@ using metadata::attributes::StageAttributes;
 using metadata::managers::AssetAttributesManager;
 using metadata::managers::ObjectAttributesManager;
 using metadata::managers::PhysicsAttributesManager;
+using metadata::managers::SceneAttributesManager;
 using metadata::managers::StageAttributesManager;
 
 namespace assets {
 
+namespace {
+
+//! whether every channel of @p format is one byte, see halveImage()
+bool isBytePerChannel(Mn::PixelFormat format) {
+  switch (format) {
+    case Mn::PixelFormat::R8Unorm:
+    case Mn::PixelFormat::RG8Unorm:
+    case Mn::PixelFormat::RGB8Unorm:
+    case Mn::PixelFormat::RGBA8Unorm:
+    case Mn::PixelFormat::R8Srgb:
+    case Mn::PixelFormat::RG8Srgb:
+    case Mn::PixelFormat::RGB8Srgb:
+    case Mn::PixelFormat::RGBA8Srgb:
+      return true;
+    default:
+      return false;
+  }
+}
+
+//! @p image of a format of one byte per channel, halved along both sides
+//! with a box filter
+Mn::Trade::ImageData2D halveImage(const Mn::Trade::ImageData2D& image) {
+  const Mn::Vector2i size = Mn::Math::max(image.size() / 2, Mn::Vector2i{1});
+  const std::size_t pixelSize = image.pixelSize();
+  // rows aligned to four bytes, the default pixel storage
+  const std::size_t rowSize = (size.x() * pixelSize + 3) / 4 * 4;
+  Cr::Containers::Array<char> data{Cr::Containers::ValueInit,
+                                   rowSize * size.y()};
+  const Cr::Containers::StridedArrayView3D<const char> pixels = image.pixels();
+  const int maxX = image.size().x() - 1;
+  const int maxY = image.size().y() - 1;
+  for (int y = 0; y < size.y(); ++y) {
+    const int y0 = std::min(2 * y, maxY), y1 = std::min(2 * y + 1, maxY);
+    for (int x = 0; x < size.x(); ++x) {
+      const int x0 = std::min(2 * x, maxX), x1 = std::min(2 * x + 1, maxX);
+      for (std::size_t c = 0; c < pixelSize; ++c) {
+        const unsigned int sum = static_cast<unsigned char>(pixels[y0][x0][c]) +
+                                 static_cast<unsigned char>(pixels[y0][x1][c]) +
+                                 static_cast<unsigned char>(pixels[y1][x0][c]) +
+                                 static_cast<unsigned char>(pixels[y1][x1][c]);
+        data[y * rowSize + x * pixelSize + c] = char((sum + 2) / 4);
+      }
+    }
+  }
+  return Mn::Trade::ImageData2D{image.format(), size, std::move(data)};
+}
+
+/**
+ * @brief The primitive meshes generated by any resource manager of the
+ * process, by the handle of their template, which encodes every parameter of
+ * the primitive. Only the CPU data is shared, each manager uploads its own GL
+ * meshes in its own context.
+ */
+struct PrimitiveMeshCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::shared_ptr<const Mn::Trade::MeshData>>
+      meshes;
+};
+
+PrimitiveMeshCache& primitiveMeshCache() {
+  static PrimitiveMeshCache cache;
+  return cache;
+}
+
+/**
+ * @brief Grow @p aabb by the meshes of @p node and its children and count
+ * their triangles, in the frame @p parentTransform transforms the parent of
+ * @p node to. @p meshAt returns the mesh of a local mesh index.
+ */
+template <class MeshAt>
+void accumulateAssetMetadata(const MeshAt& meshAt,
+                             const MeshTransformNode& node,
+                             const Mn::Matrix4& parentTransform,
+                             Cr::Containers::Optional<Mn::Range3D>& aabb,
+                             int& triangleCount) {
+  const Mn::Matrix4 transform =
+      parentTransform * node.transformFromLocalToParent;
+  if (node.meshIDLocal != ID_UNDEFINED) {
+    BaseMesh& mesh = meshAt(node.meshIDLocal);
+    const Mn::Range3D meshAabb = geo::getTransformedBB(mesh.BB, transform);
+    aabb = aabb ? Mn::Math::join(*aabb, meshAabb) : meshAabb;
+    const CollisionMeshData& meshData = mesh.getCollisionMeshData();
+    triangleCount += (meshData.indices.empty() ? meshData.positions.size()
+                                               : meshData.indices.size()) /
+                     3;
+  }
+  for (const MeshTransformNode& child : node.children) {
+    accumulateAssetMetadata(meshAt, child, transform, aabb, triangleCount);
+  }
+}
+
+/**
+ * @brief Append the triangles of the meshes of @p node and its children to
+ * @p itemTriangles, one item per mesh in depth-first order, in the frame
+ * @p parentTransform transforms the parent of @p node to. @p meshAt returns
+ * the mesh of a local mesh index.
+ */
+template <class MeshAt>
+void gatherItemTriangles(
+    const MeshAt& meshAt,
+    const MeshTransformNode& node,
+    const Mn::Matrix4& parentTransform,
+    std::vector<std::vector<Mn::Vector3>>& itemTriangles) {
+  const Mn::Matrix4 transform =
+      parentTransform * node.transformFromLocalToParent;
+  if (node.meshIDLocal != ID_UNDEFINED) {
+    // meshes of other primitives are items without triangles
+    const CollisionMeshData& meshData =
+        meshAt(node.meshIDLocal).getCollisionMeshData();
+    itemTriangles.emplace_back();
+    if (meshData.primitive == Mn::MeshPrimitive::Triangles) {
+      std::vector<Mn::Vector3>& triangles = itemTriangles.back();
+      if (meshData.indices.empty()) {
+        for (const Mn::Vector3& position : meshData.positions) {
+          triangles.push_back(transform.transformPoint(position));
+        }
+      } else {
+        for (Mn::UnsignedInt index : meshData.indices) {
+          triangles.push_back(
+              transform.transformPoint(meshData.positions[index]));
+        }
+      }
+    }
+  }
+  for (const MeshTransformNode& child : node.children) {
+    gatherItemTriangles(meshAt, child, transform, itemTriangles);
+  }
+}
+
+//! a mesh referencing the data of @p mesh instead of owning a copy
+Mn::Trade::MeshData meshDataView(const Mn::Trade::MeshData& mesh) {
+  if (!mesh.isIndexed()) {
+    return Mn::Trade::MeshData{
+        mesh.primitive(), {}, mesh.vertexData(),
+        Mn::Trade::meshAttributeDataNonOwningArray(mesh.attributeData()),
+        mesh.vertexCount()};
+  }
+  const Mn::Trade::MeshIndexData indices{
+      mesh.indexType(),
+      mesh.indexData()
+          .suffix(mesh.indexOffset())
+          .prefix(mesh.indexCount() * Mn::meshIndexTypeSize(mesh.indexType()))};
+  return Mn::Trade::MeshData{
+      mesh.primitive(),
+      {},
+      mesh.indexData(),
+      indices,
+      {},
+      mesh.vertexData(),
+      Mn::Trade::meshAttributeDataNonOwningArray(mesh.attributeData()),
+      mesh.vertexCount()};
+}
+
+//! what instanced materials in texture arrays have in common, all but the
+//! layer
+std::string textureArrayBatchKey(const gfx::PhongMaterialData& material) {
+  std::ostringstream key;
+  Cr::Utility::Debug{&key, Cr::Utility::Debug::Flag::NoNewlineAtTheEnd}
+      << material.ambientTextureArray << material.diffuseTextureArray
+      << material.specularTextureArray << material.normalTextureArray
+      << material.shininess << material.ambientColor << material.diffuseColor
+      << material.specularColor << material.textureMatrix
+      << material.vertexColored;
+  return key.str();
+}
+
+/**
+ * @p importer opened on @p filename, or for a glTF file with compressed
+ * geometry, which the glTF importer can't read, a glTF importer of the same
+ * manager opened on the decoded file, see @ref decompressGltf(). The decoded
+ * file and the importer are kept in @p decompressed and @p gltfImporter.
+ * @return The opened importer, nullptr if the file can't be opened
+ */
+Mn::Trade::AbstractImporter* openSceneFile(
+    Mn::Trade::AbstractImporter& importer,
+    const std::string& filename,
+    Cr::Containers::Pointer<Mn::Trade::AbstractImporter>& gltfImporter,
+    Cr::Containers::Optional<std::string>& decompressed) {
+  if (!isCompressedGltf(filename)) {
+    return importer.openFile(filename) ? &importer : nullptr;
+  }
+  auto* manager =
+      static_cast<Cr::PluginManager::Manager<Mn::Trade::AbstractImporter>*>(
+          importer.manager());
+  decompressed = decompressGltf(filename);
+  if (!manager || !decompressed) {
+    return nullptr;
+  }
+  gltfImporter = manager->loadAndInstantiate("TinyGltfImporter");
+  if (!gltfImporter ||
+      !gltfImporter->openData(
+          {decompressed->data(), decompressed->size()})) {
+    return nullptr;
+  }
+  return gltfImporter.get();
+}
+
+}  // namespace
+
 // static constexpr arrays require redundant definitions until C++17
 constexpr char ResourceManager::NO_LIGHT_KEY[];
 constexpr char ResourceManager::DEFAULT_LIGHTING_KEY[];
@@ -96,6 +313,7 @@ ResourceManager::ResourceManager()
 }  // namespace assets
 
 void ResourceManager::buildImportersAndAttributesManagers() {
+  core::ScopedTimer timer{core::ProfilingStage::ImporterSetup};
   assetAttributesManager_ = AssetAttributesManager::create(*this);
   objectAttributesManager_ = ObjectAttributesManager::create(*this);
   objectAttributesManager_->setAssetAttributesManager(assetAttributesManager_);
@@ -103,6 +321,7 @@ void ResourceManager::buildImportersAndAttributesManagers() {
       PhysicsAttributesManager::create(*this, objectAttributesManager_);
   stageAttributesManager_ = StageAttributesManager::create(
       *this, objectAttributesManager_, physicsAttributesManager_);
+  sceneAttributesManager_ = SceneAttributesManager::create(*this);
 
   // instantiate a primitive importer
   CORRADE_INTERNAL_ASSERT_OUTPUT(
@@ -117,6 +336,7 @@ void ResourceManager::buildImportersAndAttributesManagers() {
 }  // buildImportersAndAttributesManagers
 
 void ResourceManager::initDefaultPrimAttributes() {
+  core::ScopedTimer timer{core::ProfilingStage::PrimitiveAttributes};
   // by this point, we should have a GL::Context so load the bb primitive.
   // TODO: replace this completely with standard mesh (i.e. treat the bb
   // wireframe cube no differently than other primivite-based rendered
@@ -153,6 +373,11 @@ void ResourceManager::initPhysicsManager(
              "updates "
              "only. Reinstall with --bullet to enable Bullet dynamics.\n---";
 #endif
+    } else if (physicsManagerAttributes->getSimulator().compare(
+                   "kinematic") == 0) {
+      physicsManager.reset(new physics::KinematicPhysicsManager(
+          *this, physicsManagerAttributes));
+      defaultToNoneSimulator = false;
     }
   }
   // reset to base PhysicsManager to override previous as default behavior
@@ -177,16 +402,21 @@ bool ResourceManager::loadStage(
     esp::scene::SceneManager* sceneManagerPtr,
     std::vector<int>& activeSceneIDs,
     bool loadSemanticMesh) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  core::ScopedTraceEvent trace{"ResourceManager::loadStage", "assets"};
+  core::ScopedTimer timer{core::ProfilingStage::StageLoading};
   // create AssetInfos here for each potential mesh file for the scene, if they
   // are unique.
   bool buildCollisionMesh =
-      ((_physicsManager != nullptr) &&
-       (_physicsManager->getInitializationAttributes()->getSimulator().compare(
-            "none") != 0));
+      !renderOnly_ && (_physicsManager != nullptr) &&
+      (_physicsManager->getInitializationAttributes()->getSimulator().compare(
+           "none") != 0);
   const Magnum::ResourceKey& renderLightSetup(stageAttributes->getLightSetup());
   std::map<std::string, AssetInfo> assetInfoMap =
       createStageAssetInfosFromAttributes(stageAttributes, buildCollisionMesh,
                                           loadSemanticMesh);
+  ++stageLoadCount_;
+  stageSemanticVertexIds_ = false;
 
   auto& sceneGraph = sceneManagerPtr->getSceneGraph(activeSceneIDs[0]);
   auto& rootNode = sceneGraph.getRootNode();
@@ -244,8 +474,8 @@ bool ResourceManager::loadStage(
 
   if ((_physicsManager != nullptr) &&
       (infoToUse.filepath.compare(EMPTY_SCENE) != 0)) {
-    bool success = buildMeshGroups(infoToUse, meshGroup);
-    if (!success) {
+    // a render only stage is added with an empty mesh group
+    if (!renderOnly_ && !buildMeshGroups(infoToUse, meshGroup)) {
       return false;
     }
     //! Add to physics manager - will only be null for certain tests
@@ -270,7 +500,16 @@ bool ResourceManager::loadStage(
     // check if file names exist
     AssetInfo semanticInfo = assetInfoMap.at("semantic");
     auto semanticStageFilename = semanticInfo.filepath;
-    if (Cr::Utility::Directory::exists(semanticStageFilename)) {
+    if (semanticVertexIds_ &&
+        Cr::Utility::Directory::exists(semanticStageFilename) &&
+        semanticInfo.type == AssetType::INSTANCE_MESH &&
+        loadStageInternal(semanticInfo, nullptr, nullptr, false, false) &&
+        transferSemanticVertexIds(renderInfo, semanticStageFilename)) {
+      // the stage draws the object ids itself, in the active scene graph
+      LOG(INFO) << "ResourceManager::loadStage : Semantic Stage mesh : "
+                << semanticStageFilename << " drawn with the stage.";
+      stageSemanticVertexIds_ = true;
+    } else if (Cr::Utility::Directory::exists(semanticStageFilename)) {
       LOG(INFO) << "ResourceManager::loadStage : Loading Semantic Stage mesh : "
                 << semanticStageFilename;
       activeSemanticSceneID = sceneManagerPtr->initSceneGraph();
@@ -311,12 +550,366 @@ bool ResourceManager::loadStage(
   // save active semantic scene ID so that simulator can consume
   activeSceneIDs[1] = activeSemanticSceneID;
 
+  // keep the assets of recent stages within the cache budget
+  for (const auto& assetInfo : assetInfoMap) {
+    markStageAssetUsed(assetInfo.second.filepath);
+  }
+  evictStageAssets();
+
   return true;
 }  // ResourceManager::loadScene
 
+bool ResourceManager::transferSemanticVertexIds(
+    const AssetInfo& renderInfo,
+    const std::string& semanticFilename) {
+  auto render = resourceDict_.find(renderInfo.filepath);
+  auto semantic = resourceDict_.find(semanticFilename);
+  if (render == resourceDict_.end() || semantic == resourceDict_.end()) {
+    return false;
+  }
+
+  // each render mesh with the transformation of its component and its
+  // material, which has to be one of its own to draw the ids
+  struct Component {
+    GenericMeshData* mesh;
+    Mn::Matrix4 transformation;
+    std::string materialKey;
+  };
+  std::vector<Component> components;
+  const MeshMetaData& renderMetaData = render->second.meshMetaData;
+  std::vector<std::pair<const MeshTransformNode*, Mn::Matrix4>> stack{
+      {&renderMetaData.root, Mn::Matrix4{}}};
+  while (!stack.empty()) {
+    const MeshTransformNode& node = *stack.back().first;
+    const Mn::Matrix4 transformation =
+        stack.back().second * node.transformFromLocalToParent;
+    stack.pop_back();
+    for (const MeshTransformNode& child : node.children) {
+      stack.emplace_back(&child, transformation);
+    }
+    if (node.meshIDLocal == ID_UNDEFINED) {
+      continue;
+    }
+    auto* mesh = dynamic_cast<GenericMeshData*>(
+        meshes_[renderMetaData.meshIndex.first + node.meshIDLocal].get());
+    if (!mesh || node.materialIDLocal == ID_UNDEFINED ||
+        renderMetaData.materialIndex.second == ID_UNDEFINED) {
+      return false;
+    }
+    for (const Component& component : components) {
+      // a mesh drawn in several places can only have the ids of one
+      if (component.mesh == mesh) {
+        return false;
+      }
+    }
+    components.push_back(
+        {mesh, transformation,
+         std::to_string(renderMetaData.materialIndex.first +
+                        node.materialIDLocal)});
+  }
+
+  if (components.empty()) {
+    return false;
+  }
+  if (std::all_of(components.begin(), components.end(),
+                  [](const Component& component) {
+                    return component.mesh->hasPerVertexObjectIds();
+                  })) {
+    // the stage was loaded with the ids before
+    return true;
+  }
+
+  // the semantic vertices, which are in the space of the asset, like the
+  // render meshes within their components
+  std::vector<Mn::Vector3> sourcePositions;
+  std::vector<Mn::UnsignedInt> sourceObjectIds;
+  const MeshMetaData& semanticMetaData = semantic->second.meshMetaData;
+  for (int i = semanticMetaData.meshIndex.first;
+       i <= semanticMetaData.meshIndex.second; ++i) {
+    auto* instanceMesh =
+        dynamic_cast<GenericInstanceMeshData*>(meshes_[i].get());
+    if (!instanceMesh) {
+      return false;
+    }
+    const Cr::Containers::ArrayView<const vec3f> positions =
+        instanceMesh->getVertexBufferObjectCPU();
+    const Cr::Containers::ArrayView<const uint16_t> objectIds =
+        instanceMesh->getObjectIdsBufferObjectCPU();
+    if (positions.size() != objectIds.size()) {
+      // the object ids were released after the upload
+      return false;
+    }
+    for (const vec3f& position : positions) {
+      sourcePositions.emplace_back(Mn::Vector3{position});
+    }
+    sourceObjectIds.insert(sourceObjectIds.end(), objectIds.begin(),
+                           objectIds.end());
+  }
+
+  const float maxDistance =
+      SemanticVertexIdDistance / renderInfo.virtualUnitToMeters;
+  for (const Component& component : components) {
+    if (component.mesh->hasPerVertexObjectIds()) {
+      continue;
+    }
+    const Cr::Containers::ArrayView<Mn::Vector3> meshPositions =
+        component.mesh->getCollisionMeshData().positions;
+    std::vector<Mn::Vector3> positions;
+    positions.reserve(meshPositions.size());
+    for (const Mn::Vector3& position : meshPositions) {
+      positions.push_back(component.transformation.transformPoint(position));
+    }
+    component.mesh->setPerVertexObjectIds(transferObjectIds(
+        positions, sourcePositions, sourceObjectIds, maxDistance));
+
+    auto materialData =
+        shaderManager_.get<gfx::MaterialData, gfx::PhongMaterialData>(
+            component.materialKey);
+    if (materialData) {
+      // the drawables of the stage pick the shader from it when drawn
+      materialData->perVertexObjectId = true;
+    }
+  }
+  return true;
+}
+
+void ResourceManager::markStageAssetUsed(const std::string& filename) {
+  auto loadedAsset = resourceDict_.find(filename);
+  if (loadedAsset == resourceDict_.end()) {
+    return;
+  }
+  auto inserted = cachedStageAssets_.emplace(filename, CachedStageAsset{});
+  CachedStageAsset& cachedAsset = inserted.first->second;
+  cachedAsset.lastUsed = stageLoadCount_;
+  if (!inserted.second) {
+    return;
+  }
+
+  // the positions and indices are kept for collision and uploaded for render
+  const MeshMetaData& metaData = loadedAsset->second.meshMetaData;
+  std::size_t meshBytes = 0;
+  if (metaData.meshIndex.first != ID_UNDEFINED) {
+    for (int iMesh = metaData.meshIndex.first;
+         iMesh <= metaData.meshIndex.second; ++iMesh) {
+      if (!meshes_[iMesh]) {
+        continue;
+      }
+      const CollisionMeshData& meshData =
+          meshes_[iMesh]->getCollisionMeshData();
+      meshBytes += meshData.positions.size() * sizeof(Mn::Vector3) +
+                   meshData.indices.size() * sizeof(Mn::UnsignedInt);
+    }
+  }
+  cachedAsset.cpuBytes = meshBytes;
+  cachedAsset.gpuBytes =
+      assetGpuMemoryUsage(loadedAsset->second).totalBytes();
+}
+
+void ResourceManager::evictStageAssets() {
+  std::size_t cpuBytes = 0;
+  std::size_t gpuBytes = 0;
+  for (const auto& cachedAsset : cachedStageAssets_) {
+    cpuBytes += cachedAsset.second.cpuBytes;
+    gpuBytes += cachedAsset.second.gpuBytes;
+  }
+
+  auto overBudget = [&]() {
+    return (stageAssetCacheCpuBudget_ != 0 &&
+            cpuBytes > stageAssetCacheCpuBudget_) ||
+           (stageAssetCacheGpuBudget_ != 0 &&
+            gpuBytes > stageAssetCacheGpuBudget_);
+  };
+  while (overBudget()) {
+    // the least recently used asset neither used by the current stage nor
+    // pinned by the scene graph of another simulator
+    auto leastRecent = cachedStageAssets_.end();
+    for (auto it = cachedStageAssets_.begin(); it != cachedStageAssets_.end();
+         ++it) {
+      if (it->second.lastUsed != stageLoadCount_ && it->second.pins == 0 &&
+          (leastRecent == cachedStageAssets_.end() ||
+           it->second.lastUsed < leastRecent->second.lastUsed)) {
+        leastRecent = it;
+      }
+    }
+    if (leastRecent == cachedStageAssets_.end()) {
+      // the current and pinned stages alone exceed the budget
+      break;
+    }
+    LOG(INFO) << "ResourceManager::evictStageAssets : Releasing "
+              << leastRecent->first;
+    cpuBytes -= leastRecent->second.cpuBytes;
+    gpuBytes -= leastRecent->second.gpuBytes;
+    releaseAsset(leastRecent->first);
+    cachedStageAssets_.erase(leastRecent);
+  }
+}
+
+void ResourceManager::releaseAsset(const std::string& filename) {
+  auto loadedAsset = resourceDict_.find(filename);
+  if (loadedAsset == resourceDict_.end()) {
+    return;
+  }
+  // the indices of other assets must stay valid, so only the slots are
+  // emptied. The materials are kept, no drawable created afterwards refers to
+  // them.
+  const MeshMetaData& metaData = loadedAsset->second.meshMetaData;
+  if (metaData.meshIndex.first != ID_UNDEFINED) {
+    for (int iMesh = metaData.meshIndex.first;
+         iMesh <= metaData.meshIndex.second; ++iMesh) {
+      meshes_[iMesh] = nullptr;
+      instanceBuffers_.erase(iMesh);
+    }
+  }
+  if (metaData.textureIndex.first != ID_UNDEFINED) {
+    for (int iTexture = metaData.textureIndex.first;
+         iTexture <= metaData.textureIndex.second; ++iTexture) {
+      textures_[iTexture] = nullptr;
+    }
+  }
+  for (const gfx::TextureArrayPool::Allocation& layer :
+       loadedAsset->second.textureArrayLayers) {
+    textureArrayPool_.release(layer);
+  }
+  // views into the released meshes
+  collisionMeshGroups_.erase(filename);
+  resourceDict_.erase(loadedAsset);
+}
+
+std::vector<std::string> ResourceManager::getCachedStageAssets() const {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  std::vector<std::pair<std::size_t, std::string>> byUse;
+  for (const auto& cachedAsset : cachedStageAssets_) {
+    byUse.emplace_back(cachedAsset.second.lastUsed, cachedAsset.first);
+  }
+  std::stable_sort(byUse.begin(), byUse.end(),
+                   [](const std::pair<std::size_t, std::string>& a,
+                      const std::pair<std::size_t, std::string>& b) {
+                     return a.first > b.first;
+                   });
+  std::vector<std::string> filenames;
+  for (auto& entry : byUse) {
+    filenames.push_back(std::move(entry.second));
+  }
+  return filenames;
+}
+
+std::vector<std::string> ResourceManager::getCurrentStageAssets() const {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  std::vector<std::string> filenames;
+  for (const auto& cachedAsset : cachedStageAssets_) {
+    if (cachedAsset.second.lastUsed == stageLoadCount_) {
+      filenames.push_back(cachedAsset.first);
+    }
+  }
+  return filenames;
+}
+
+void ResourceManager::useStageAssets(
+    const std::vector<std::string>& filenames) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  ++stageLoadCount_;
+  for (const std::string& filename : filenames) {
+    auto cachedAsset = cachedStageAssets_.find(filename);
+    if (cachedAsset != cachedStageAssets_.end()) {
+      cachedAsset->second.lastUsed = stageLoadCount_;
+    }
+  }
+}
+
+void ResourceManager::pinStageAssets(
+    const std::vector<std::string>& filenames) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  for (const std::string& filename : filenames) {
+    auto cachedAsset = cachedStageAssets_.find(filename);
+    if (cachedAsset != cachedStageAssets_.end()) {
+      ++cachedAsset->second.pins;
+    }
+  }
+}
+
+void ResourceManager::unpinStageAssets(
+    const std::vector<std::string>& filenames) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  for (const std::string& filename : filenames) {
+    auto cachedAsset = cachedStageAssets_.find(filename);
+    if (cachedAsset != cachedStageAssets_.end() &&
+        cachedAsset->second.pins > 0) {
+      --cachedAsset->second.pins;
+    }
+  }
+}
+
+gfx::GpuMemoryUsage ResourceManager::assetGpuMemoryUsage(
+    const LoadedAssetData& loadedAssetData) const {
+  gfx::GpuMemoryUsage usage;
+  usage.textureBytes = loadedAssetData.textureBytes;
+  const MeshMetaData& metaData = loadedAssetData.meshMetaData;
+  if (metaData.meshIndex.first == ID_UNDEFINED) {
+    return usage;
+  }
+  for (int iMesh = metaData.meshIndex.first;
+       iMesh <= metaData.meshIndex.second; ++iMesh) {
+    if (!meshes_[iMesh]) {
+      continue;
+    }
+    usage.meshBytes += meshes_[iMesh]->getGpuBytes();
+#ifdef ESP_BUILD_PTEX_SUPPORT
+    if (meshes_[iMesh]->getMeshType() == SupportedMeshType::PTEX_MESH) {
+      usage.ptexAtlasBytes +=
+          static_cast<const PTexMeshData&>(*meshes_[iMesh]).getAtlasBytes();
+    }
+#endif
+  }
+  return usage;
+}
+
+gfx::GpuMemoryUsage ResourceManager::getGpuMemoryUsage() const {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  gfx::GpuMemoryUsage usage;
+  // every mesh, primitives included, and the textures of the assets
+  for (const std::shared_ptr<BaseMesh>& mesh : meshes_) {
+    if (mesh) {
+      usage.meshBytes += mesh->getGpuBytes();
+    }
+  }
+  // the meshes count their ranges of the arena, not the rest of its pools
+  usage.meshBytes += meshArena_.getFreeBytes();
+  for (const auto& loadedAsset : resourceDict_) {
+    usage.textureBytes += loadedAsset.second.textureBytes;
+  }
+#ifdef ESP_BUILD_PTEX_SUPPORT
+  std::set<const PTexAtlasCache*> atlasCaches;
+  for (const std::shared_ptr<BaseMesh>& mesh : meshes_) {
+    if (!mesh || mesh->getMeshType() != SupportedMeshType::PTEX_MESH) {
+      continue;
+    }
+    const auto& pTexMeshData = static_cast<const PTexMeshData&>(*mesh);
+    usage.ptexAtlasBytes += pTexMeshData.getAtlasBytes();
+    if (pTexMeshData.getAtlasCache()) {
+      atlasCaches.insert(pTexMeshData.getAtlasCache().get());
+    }
+  }
+  for (const PTexAtlasCache* atlasCache : atlasCaches) {
+    usage.ptexAtlasBytes += atlasCache->getResidentBytes();
+  }
+#endif
+  return usage;
+}
+
+std::map<std::string, std::size_t> ResourceManager::getAssetGpuBytes() const {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  std::map<std::string, std::size_t> assetBytes;
+  for (const auto& loadedAsset : resourceDict_) {
+    assetBytes[loadedAsset.first] =
+        assetGpuMemoryUsage(loadedAsset.second).totalBytes();
+  }
+  return assetBytes;
+}
+
 bool ResourceManager::buildMeshGroups(
     const AssetInfo& info,
     std::vector<CollisionMeshData>& meshGroup) {
+  core::ScopedTimer timer{core::ProfilingStage::CollisionMeshBuild};
   if (collisionMeshGroups_.count(info.filepath) == 0) {
     //! Collect collision mesh group
     bool colMeshGroupSuccess = false;
@@ -468,6 +1061,7 @@ template <class T>
 bool ResourceManager::buildStageCollisionMeshGroup(
     const std::string& filename,
     std::vector<CollisionMeshData>& meshGroup) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
   // TODO : refactor to manage any mesh groups, not just scene
 
   //! Collect collision mesh group
@@ -520,6 +1114,7 @@ Magnum::Range3D ResourceManager::computeMeshBB(BaseMesh* meshDataGL) {
 void ResourceManager::computePTexMeshAbsoluteAABBs(
     BaseMesh& baseMesh,
     const std::vector<StaticDrawableInfo>& staticDrawableInfo) {
+  core::ScopedTimer timer{core::ProfilingStage::BoundsComputation};
   std::vector<Mn::Matrix4> absTransforms =
       computeAbsoluteTransformations(staticDrawableInfo);
 
@@ -549,6 +1144,7 @@ void ResourceManager::computePTexMeshAbsoluteAABBs(
 
 void ResourceManager::computeGeneralMeshAbsoluteAABBs(
     const std::vector<StaticDrawableInfo>& staticDrawableInfo) {
+  core::ScopedTimer timer{core::ProfilingStage::BoundsComputation};
   std::vector<Mn::Matrix4> absTransforms =
       computeAbsoluteTransformations(staticDrawableInfo);
 
@@ -594,6 +1190,7 @@ void ResourceManager::computeGeneralMeshAbsoluteAABBs(
 
 void ResourceManager::computeInstanceMeshAbsoluteAABBs(
     const std::vector<StaticDrawableInfo>& staticDrawableInfo) {
+  core::ScopedTimer timer{core::ProfilingStage::BoundsComputation};
   std::vector<Mn::Matrix4> absTransforms =
       computeAbsoluteTransformations(staticDrawableInfo);
 
@@ -605,12 +1202,22 @@ void ResourceManager::computeInstanceMeshAbsoluteAABBs(
   for (size_t iEntry = 0; iEntry < absTransforms.size(); ++iEntry) {
     const uint32_t meshID = staticDrawableInfo[iEntry].meshID;
 
-    // convert std::vector<vec3f> to std::vector<Mn::Vector3>
-    const std::vector<vec3f>& vertexPositions =
+    // convert vec3f to Mn::Vector3, the corners of the bounding box if the
+    // positions were released
+    const Cr::Containers::ArrayView<const vec3f> vertexPositions =
         dynamic_cast<GenericInstanceMeshData&>(*meshes_[meshID])
             .getVertexBufferObjectCPU();
     std::vector<Mn::Vector3> transformedPositions{vertexPositions.begin(),
                                                   vertexPositions.end()};
+    if (transformedPositions.empty()) {
+      const Mn::Range3D& box = meshes_[meshID]->BB;
+      for (int corner = 0; corner < 8; ++corner) {
+        transformedPositions.emplace_back(
+            corner & 1 ? box.max().x() : box.min().x(),
+            corner & 2 ? box.max().y() : box.min().y(),
+            corner & 4 ? box.max().z() : box.min().z());
+      }
+    }
 
     Mn::MeshTools::transformPointsInPlace(absTransforms[iEntry],
                                           transformedPositions);
@@ -679,16 +1286,38 @@ void ResourceManager::buildPrimitiveAssetData(
 
   // class of primitive object
   std::string primClassName = primTemplate->getPrimObjClassName();
-  // make sure it is open before use
-  primitiveImporter_->openData("");
-  // configuration for PrimitiveImporter - replace appropriate group's data
-  // before instancing prim object
   Cr::Utility::ConfigurationGroup& conf = primitiveImporter_->configuration();
-  Cr::Utility::ConfigurationGroup* cfgGroup = conf.group(primClassName);
-  if (cfgGroup != nullptr) {  // ignore prims with no configuration like cubes
-    auto newCfgGroup = primTemplate->getConfigGroup();
-    // replace current conf group with passed attributes
-    *cfgGroup = newCfgGroup;
+
+  // reuse the mesh if any resource manager generated it already
+  PrimitiveMeshCache& cache = primitiveMeshCache();
+  std::shared_ptr<const Mn::Trade::MeshData> generatedMesh;
+  {
+    std::lock_guard<std::mutex> lock{cache.mutex};
+    auto cached = cache.meshes.find(primAssetHandle);
+    if (cached != cache.meshes.end()) {
+      generatedMesh = cached->second;
+    }
+  }
+  if (!generatedMesh) {
+    // make sure it is open before use
+    primitiveImporter_->openData("");
+    // configuration for PrimitiveImporter - replace appropriate group's data
+    // before instancing prim object
+    Cr::Utility::ConfigurationGroup* cfgGroup = conf.group(primClassName);
+    if (cfgGroup != nullptr) {  // ignore prims with no configuration like cubes
+      auto newCfgGroup = primTemplate->getConfigGroup();
+      // replace current conf group with passed attributes
+      *cfgGroup = newCfgGroup;
+    }
+    Cr::Containers::Optional<Mn::Trade::MeshData> mesh =
+        primitiveImporter_->mesh(primClassName);
+    CORRADE_INTERNAL_ASSERT(mesh);
+    generatedMesh =
+        std::make_shared<const Mn::Trade::MeshData>(*std::move(mesh));
+    std::lock_guard<std::mutex> lock{cache.mutex};
+    // keeps the mesh of a concurrent manager generating it too
+    generatedMesh =
+        cache.meshes.emplace(primAssetHandle, generatedMesh).first->second;
   }
 
   // make assetInfo
@@ -697,12 +1326,14 @@ void ResourceManager::buildPrimitiveAssetData(
   // set up primitive mesh
   // make  primitive mesh structure
   auto primMeshData = std::make_unique<GenericMeshData>(false);
-  // build mesh data object
-  primMeshData->importAndSetMeshData(*primitiveImporter_, primClassName);
+  // build mesh data object, copying the cached mesh
+  primMeshData->setMeshData(meshDataView(*generatedMesh));
 
   // compute the mesh bounding box
   primMeshData->BB = computeMeshBB(primMeshData.get());
 
+  primMeshData->setCompactVertexFormat(compactVertexFormat_);
+  primMeshData->setMeshArena(meshArenaEnabled_ ? &meshArena_ : nullptr);
   primMeshData->uploadBuffersToGPU(false);
 
   // make MeshMetaData
@@ -745,6 +1376,7 @@ void ResourceManager::buildPrimitiveAssetData(
 bool ResourceManager::loadPTexMeshData(const AssetInfo& info,
                                        scene::SceneNode* parent,
                                        DrawableGroup* drawables) {
+  core::ScopedTraceEvent trace{"ResourceManager::loadPTexMeshData", "assets"};
 #ifdef ESP_BUILD_PTEX_SUPPORT
   // if this is a new file, load it and add it to the dictionary
   const std::string& filename = info.filepath;
@@ -755,7 +1387,20 @@ bool ResourceManager::loadPTexMeshData(const AssetInfo& info,
     meshes_.emplace_back(std::make_unique<PTexMeshData>());
     int index = meshes_.size() - 1;
     auto* pTexMeshData = dynamic_cast<PTexMeshData*>(meshes_[index].get());
-    pTexMeshData->load(filename, atlasDir);
+    {
+      core::ScopedTimer timer{core::ProfilingStage::AssetImport};
+      pTexMeshData->load(filename, atlasDir);
+    }
+    if (ptexAtlasStreaming_) {
+      std::shared_ptr<PTexAtlasCache> atlasCache =
+          PTexAtlasCache::forCurrentContext();
+      atlasCache->setBudget(ptexAtlasBudget_);
+      pTexMeshData->setAtlasCache(std::move(atlasCache));
+    }
+    if (ptexGeometryShader_) {
+      pTexMeshData->setFaceIdSource(
+          gfx::PTexMeshShader::FaceIdSource::GeometryShader);
+    }
 
     // update the dictionary
     auto inserted =
@@ -826,6 +1471,8 @@ bool ResourceManager::loadInstanceMeshData(
     DrawableGroup* drawables,
     bool computeAbsoluteAABBs,
     bool splitSemanticMesh /* = true */) {
+  core::ScopedTraceEvent trace{"ResourceManager::loadInstanceMeshData",
+                               "assets"};
   if (info.type != AssetType::INSTANCE_MESH) {
     LOG(ERROR) << "loadInstanceMeshData only works with INSTANCE_MESH type!";
     return false;
@@ -840,14 +1487,17 @@ bool ResourceManager::loadInstanceMeshData(
   const std::string& filename = info.filepath;
   if (resourceDict_.count(filename) == 0) {
     std::vector<GenericInstanceMeshData::uptr> instanceMeshes;
-    if (splitSemanticMesh) {
-      instanceMeshes =
-          GenericInstanceMeshData::fromPlySplitByObjectId(*importer, filename);
-    } else {
-      GenericInstanceMeshData::uptr meshData =
-          GenericInstanceMeshData::fromPLY(*importer, filename);
-      if (meshData)
-        instanceMeshes.emplace_back(std::move(meshData));
+    {
+      core::ScopedTimer timer{core::ProfilingStage::AssetImport};
+      if (splitSemanticMesh) {
+        instanceMeshes = GenericInstanceMeshData::fromPlySplitByObjectId(
+            *importer, filename);
+      } else {
+        GenericInstanceMeshData::uptr meshData =
+            GenericInstanceMeshData::fromPLY(*importer, filename);
+        if (meshData)
+          instanceMeshes.emplace_back(std::move(meshData));
+      }
     }
 
     if (instanceMeshes.empty()) {
@@ -862,7 +1512,13 @@ bool ResourceManager::loadInstanceMeshData(
 
     for (int meshIDLocal = 0; meshIDLocal < instanceMeshes.size();
          ++meshIDLocal) {
-      instanceMeshes[meshIDLocal]->uploadBuffersToGPU(false);
+      instanceMeshes[meshIDLocal]->setCompactVertexFormat(compactVertexFormat_);
+      instanceMeshes[meshIDLocal]->setRetainedCpuData(instanceMeshCpuData_);
+      // kept for the bounds of later graphs, once the positions are released
+      instanceMeshes[meshIDLocal]->BB =
+          computeMeshBB(instanceMeshes[meshIDLocal].get());
+      instanceMeshes[meshIDLocal]->setMeshArena(
+          meshArenaEnabled_ ? &meshArena_ : nullptr);
       meshes_.emplace_back(std::move(instanceMeshes[meshIDLocal]));
 
       meshMetaData.root.children[meshIDLocal].meshIDLocal = meshIDLocal;
@@ -881,6 +1537,9 @@ bool ResourceManager::loadInstanceMeshData(
     int end = indexPair.second;
 
     for (uint32_t iMesh = start; iMesh <= end; ++iMesh) {
+      // uploaded by the first graph drawing them, a semantic mesh only
+      // transferring its ids to the render mesh stays on the CPU
+      meshes_[iMesh]->uploadBuffersToGPU(false);
       scene::SceneNode& node = parent->createChild();
       node.addFeature<gfx::GenericDrawable>(
           *meshes_[iMesh]->getMagnumGLMesh(), shaderManager_, NO_LIGHT_KEY,
@@ -895,29 +1554,29 @@ bool ResourceManager::loadInstanceMeshData(
     if (computeAbsoluteAABBs) {
       computeInstanceMeshAbsoluteAABBs(staticDrawableInfo);
     }
+    for (uint32_t iMesh = start; iMesh <= end; ++iMesh) {
+      static_cast<GenericInstanceMeshData&>(*meshes_[iMesh]).releaseCpuData();
+    }
   }  // if parent not null
 
   return true;
 }
 
-bool ResourceManager::loadGeneralMeshData(
-    const AssetInfo& info,
-    scene::SceneNode* parent /* = nullptr */,
-    DrawableGroup* drawables /* = nullptr */,
-    bool computeAbsoluteAABBs, /* = false */
-    const Mn::ResourceKey& lightSetup) {
-  const std::string& filename = info.filepath;
-  const bool fileIsLoaded = resourceDict_.count(filename) > 0;
-  const bool drawData = parent != nullptr && drawables != nullptr;
-
-  // Preferred plugins, Basis target GPU format
-  importerManager_.setPreferredPlugins("GltfImporter", {"TinyGltfImporter"});
+void ResourceManager::setPreferredImporterPlugins(
+    Cr::PluginManager::Manager<Importer>& manager) {
+  manager.setPreferredPlugins("GltfImporter", {"TinyGltfImporter"});
 #ifdef ESP_BUILD_ASSIMP_SUPPORT
-  importerManager_.setPreferredPlugins("ObjImporter", {"AssimpImporter"});
+  manager.setPreferredPlugins("ObjImporter", {"AssimpImporter"});
 #endif
-  {
+}
+
+void ResourceManager::configureImporterManager(
+    Cr::PluginManager::Manager<Importer>& manager) {
+  // Preferred plugins, Basis target GPU format
+  setPreferredImporterPlugins(manager);
+  if (Mn::GL::Context::hasCurrent()) {
     Cr::PluginManager::PluginMetadata* const metadata =
-        importerManager_.metadata("BasisImporter");
+        manager.metadata("BasisImporter");
     Mn::GL::Context& context = Mn::GL::Context::current();
 #ifdef MAGNUM_TARGET_WEBGL
     if (context.isExtensionSupported<
@@ -988,46 +1647,56 @@ bool ResourceManager::loadGeneralMeshData(
     }
 #endif
   }
+}  // configureImporterManager
+
+std::string ResourceManager::importerPluginDirectory() {
+#ifdef MAGNUM_BUILD_STATIC
+  // avoid using plugins that might depend on different library versions
+  return "nonexistent";
+#else
+  // the default search path
+  return {};
+#endif
+}
+
+bool ResourceManager::loadGeneralMeshData(
+    const AssetInfo& info,
+    scene::SceneNode* parent /* = nullptr */,
+    DrawableGroup* drawables /* = nullptr */,
+    bool computeAbsoluteAABBs, /* = false */
+    const Mn::ResourceKey& lightSetup) {
+  const std::string& filename = info.filepath;
+  const bool fileIsLoaded = resourceDict_.count(filename) > 0;
+  const bool drawData = parent != nullptr && drawables != nullptr;
+
+  configureImporterManager(importerManager_);
 
   // Optional File loading
   if (!fileIsLoaded) {
-    if (!fileImporter_->openFile(filename)) {
-      LOG(ERROR) << "Cannot open file " << filename;
+    // decode here unless a prefetch already did
+    std::unique_ptr<DecodedAssetData> decodedAssetData;
+    {
+      core::ScopedTimer timer{core::ProfilingStage::AssetImport};
+      decodedAssetData = takePrefetchedAsset(info);
+      if (!decodedAssetData) {
+        decodedAssetData = decodeGeneralMeshData(
+            *fileImporter_, info, requiresTextures_, true, transcodeCacheDir_);
+      }
+    }
+    if (!decodedAssetData) {
       return false;
     }
 
     // if this is a new file, load it and add it to the dictionary
     LoadedAssetData loadedAssetData{info};
-    if (requiresTextures_) {
-      loadTextures(*fileImporter_, loadedAssetData);
-      loadMaterials(*fileImporter_, loadedAssetData);
-    }
-    loadMeshes(*fileImporter_, loadedAssetData);
+    // without the images, the materials just have no textures for now
+    loadTextures(*decodedAssetData, loadedAssetData);
+    loadMaterials(*decodedAssetData, loadedAssetData);
+    loadMeshes(*decodedAssetData, loadedAssetData);
+    loadedAssetData.meshMetaData.root = std::move(decodedAssetData->root);
     auto inserted = resourceDict_.emplace(filename, std::move(loadedAssetData));
     MeshMetaData& meshMetaData = inserted.first->second.meshMetaData;
 
-    // Register magnum mesh
-    if (fileImporter_->defaultScene() != -1) {
-      Cr::Containers::Optional<Magnum::Trade::SceneData> sceneData =
-          fileImporter_->scene(fileImporter_->defaultScene());
-      if (!sceneData) {
-        LOG(ERROR) << "Cannot load scene, exiting";
-        return false;
-      }
-      for (unsigned int sceneDataID : sceneData->children3D()) {
-        loadMeshHierarchy(*fileImporter_, meshMetaData.root, sceneDataID);
-      }
-    } else if (fileImporter_->meshCount() &&
-               meshes_[meshMetaData.meshIndex.first]) {
-      // no default scene --- standalone OBJ/PLY files, for example
-      // take a wild guess and load the first mesh with the first material
-      // addMeshToDrawables(metaData, *parent, drawables, 0, 0);
-      loadMeshHierarchy(*fileImporter_, meshMetaData.root, 0);
-    } else {
-      LOG(ERROR) << "No default scene available and no meshes found, exiting";
-      return false;
-    }
-
     const quatf transform = info.frame.rotationFrameToWorld();
     Magnum::Matrix4 R = Magnum::Matrix4::from(
         Magnum::Quaternion(transform).toMatrix(), Magnum::Vector3());
@@ -1084,9 +1753,566 @@ bool ResourceManager::loadGeneralMeshData(
   return true;
 }  // loadGeneralMeshData
 
+std::unique_ptr<DecodedAssetData> ResourceManager::decodeGeneralMeshData(
+    Importer& fileImporter,
+    const AssetInfo& info,
+    bool requiresTextures,
+    bool useSceneCache /* = true */,
+    const std::string& transcodeCacheDir /* = "" */) {
+  core::ScopedTraceEvent trace{"ResourceManager::decodeGeneralMeshData",
+                               "assets"};
+  const std::string& filename = info.filepath;
+  const std::string cacheFile = sceneCacheFilename(filename);
+  if (useSceneCache && Cr::Utility::Directory::exists(cacheFile)) {
+    std::unique_ptr<DecodedAssetData> decodedAssetData =
+        loadSceneCache(cacheFile, info, requiresTextures);
+    if (decodedAssetData) {
+      return decodedAssetData;
+    }
+    LOG(WARNING) << "Scene cache " << cacheFile
+                 << " is outdated or invalid, importing " << filename;
+  }
+
+  Cr::Containers::Pointer<Importer> gltfImporter;
+  Cr::Containers::Optional<std::string> decompressed;
+  Importer* const opened =
+      openSceneFile(fileImporter, filename, gltfImporter, decompressed);
+  if (!opened) {
+    LOG(ERROR) << "Cannot open file " << filename;
+    return nullptr;
+  }
+  Importer& importer = *opened;
+
+  auto decodedAssetData = std::make_unique<DecodedAssetData>();
+  decodedAssetData->assetInfo = info;
+  decodedAssetData->requiresTextures = requiresTextures;
+
+  decodeTexturesAndMaterials(importer, *decodedAssetData, transcodeCacheDir);
+
+  for (int iMesh = 0; iMesh < importer.meshCount(); ++iMesh) {
+    // don't need normals if we aren't using lighting
+    auto gltfMeshData = std::make_unique<GenericMeshData>(info.requiresLighting);
+    gltfMeshData->importAndSetMeshData(importer, iMesh);
+    // once per import, a scene cache stores the optimized order
+    gltfMeshData->optimizeIndexOrder();
+
+    // compute the mesh bounding box
+    gltfMeshData->BB = computeMeshBB(gltfMeshData.get());
+    decodedAssetData->meshes.push_back(std::move(gltfMeshData));
+  }
+
+  // Register magnum mesh
+  if (importer.defaultScene() != -1) {
+    Cr::Containers::Optional<Magnum::Trade::SceneData> sceneData =
+        importer.scene(importer.defaultScene());
+    if (!sceneData) {
+      LOG(ERROR) << "Cannot load scene, exiting";
+      return nullptr;
+    }
+    for (unsigned int sceneDataID : sceneData->children3D()) {
+      loadMeshHierarchy(importer, decodedAssetData->root, sceneDataID);
+    }
+  } else if (importer.meshCount()) {
+    // no default scene --- standalone OBJ/PLY files, for example
+    // take a wild guess and load the first mesh with the first material
+    loadMeshHierarchy(importer, decodedAssetData->root, 0);
+  } else {
+    LOG(ERROR) << "No default scene available and no meshes found, exiting";
+    return nullptr;
+  }
+
+  return decodedAssetData;
+}  // decodeGeneralMeshData
+
+void ResourceManager::decodeTexturesAndMaterials(
+    Importer& importer,
+    DecodedAssetData& decodedAssetData,
+    const std::string& transcodeCacheDir /* = "" */) {
+  // textures whose images are imported
+  std::vector<int> texturesToDecode;
+  for (int iTexture = 0; iTexture < importer.textureCount(); ++iTexture) {
+    Cr::Containers::Optional<Mn::Trade::TextureData> textureData =
+        importer.texture(iTexture);
+    if (!textureData ||
+        textureData->type() != Magnum::Trade::TextureData::Type::Texture2D) {
+      LOG(ERROR) << "Cannot load texture " << iTexture << " skipping";
+      textureData = Cr::Containers::NullOpt;
+    } else if (decodedAssetData.requiresTextures) {
+      texturesToDecode.push_back(iTexture);
+    }
+    decodedAssetData.textures.push_back(std::move(textureData));
+  }
+  decodedAssetData.textureImages.resize(decodedAssetData.textures.size());
+  decodeTextureImages(importer, decodedAssetData, texturesToDecode,
+                      transcodeCacheDir);
+
+  for (int iMaterial = 0; iMaterial < importer.materialCount(); ++iMaterial) {
+    // TODO:
+    // it seems we have a way to just load the material once in this case,
+    // as long as the materialName includes the full path to the material
+    decodedAssetData.materials.push_back(importer.material(iMaterial));
+  }
+}
+
+std::vector<Mn::Trade::ImageData2D> ResourceManager::importImageLevels(
+    Importer& importer,
+    Mn::UnsignedInt image) {
+  std::vector<Mn::Trade::ImageData2D> levels;
+  // Load all mip levels
+  const std::uint32_t levelCount = importer.image2DLevelCount(image);
+  for (std::uint32_t level = 0; level != levelCount; ++level) {
+    // TODO:
+    // it seems we have a way to just load the image once in this case,
+    // as long as the image2DName include the full path to the image
+    Cr::Containers::Optional<Mn::Trade::ImageData2D> imageData =
+        importer.image2D(image, level);
+    if (!imageData) {
+      // Mip level loading failed, fail the whole texture
+      return {};
+    }
+    levels.push_back(*std::move(imageData));
+  }
+  return levels;
+}
+
+std::string ResourceManager::basisTargetFormat(Importer& importer) {
+  Cr::PluginManager::PluginMetadata* const metadata =
+      importer.manager() ? importer.manager()->metadata("BasisImporter")
+                         : nullptr;
+  const std::string format =
+      metadata ? metadata->configuration().value("format") : std::string{};
+  return format.empty() ? "default" : format;
+}
+
+void ResourceManager::decodeTextureImages(
+    Importer& importer,
+    DecodedAssetData& decodedAssetData,
+    const std::vector<int>& textures,
+    const std::string& transcodeCacheDir) {
+  const std::string& filename = decodedAssetData.assetInfo.filepath;
+  const std::string format = basisTargetFormat(importer);
+  auto textureImage = [&](int iTexture) {
+    return decodedAssetData.textures[iTexture]->image();
+  };
+
+  // images transcoded by an earlier load of the same file contents
+  uint64_t assetHash = 0;
+  if (!transcodeCacheDir.empty() && !textures.empty() &&
+      Cr::Utility::Directory::mkpath(transcodeCacheDir)) {
+    assetHash = fileContentHash(filename);
+  }
+  auto cacheFile = [&](int iTexture) {
+    return transcodedImageCacheFilename(transcodeCacheDir, assetHash, format,
+                                        textureImage(iTexture));
+  };
+  std::vector<int> pending;
+  for (int iTexture : textures) {
+    if (assetHash == 0 ||
+        !loadTranscodedImage(cacheFile(iTexture),
+                             decodedAssetData.textureImages[iTexture])) {
+      pending.push_back(iTexture);
+    }
+  }
+
+  // importers are not thread-safe, so every worker opens the file in an
+  // importer of its own, transcoding Basis images to the same format
+  auto decodeStride = [&](Importer& strideImporter, std::size_t first,
+                          std::size_t stride) {
+    for (std::size_t i = first; i < pending.size(); i += stride) {
+      const int iTexture = pending[i];
+      std::vector<Mn::Trade::ImageData2D>& levels =
+          decodedAssetData.textureImages[iTexture];
+      levels = importImageLevels(strideImporter, textureImage(iTexture));
+      // only GPU-native blocks, decoded images are as fast to import again
+      if (assetHash != 0 && !levels.empty() && levels[0].isCompressed()) {
+        saveTranscodedImage(levels, cacheFile(iTexture));
+      }
+    }
+  };
+  core::TaskScheduler& scheduler = core::TaskScheduler::global();
+  std::size_t numThreads = scheduler.concurrency(pending.size());
+  if (!Cr::Utility::Directory::exists(filename) ||
+      isCompressedGltf(filename)) {
+    // the importer was not opened from a file the workers could open
+    numThreads = 1;
+  }
+  if (numThreads <= 1) {
+    decodeStride(importer, 0, 1);
+  } else {
+    Cr::PluginManager::PluginMetadata* const metadata =
+        importer.manager() ? importer.manager()->metadata("BasisImporter")
+                           : nullptr;
+    const std::string formatValue =
+        metadata ? metadata->configuration().value("format") : std::string{};
+    // not a std::vector<bool>, its elements can't be written concurrently
+    std::vector<char> workerFailed(numThreads, false);
+    scheduler.parallelFor(numThreads, numThreads, [&](std::size_t worker,
+                                                      int) {
+      Cr::PluginManager::Manager<Importer> manager{
+          importerPluginDirectory()};
+      setPreferredImporterPlugins(manager);
+      Cr::PluginManager::PluginMetadata* const workerMetadata =
+          manager.metadata("BasisImporter");
+      if (workerMetadata && !formatValue.empty()) {
+        workerMetadata->configuration().setValue("format", formatValue);
+      }
+      Cr::Containers::Pointer<Importer> workerImporter =
+          manager.loadAndInstantiate("AnySceneImporter");
+      if (!workerImporter || !workerImporter->openFile(filename)) {
+        workerFailed[worker] = true;
+        return;
+      }
+      decodeStride(*workerImporter, worker, numThreads);
+    });
+    for (std::size_t worker = 0; worker < numThreads; ++worker) {
+      if (workerFailed[worker]) {
+        decodeStride(importer, worker, numThreads);
+      }
+    }
+  }
+
+  for (int iTexture : pending) {
+    if (decodedAssetData.textureImages[iTexture].empty()) {
+      LOG(ERROR) << "Cannot load texture image, skipping";
+      decodedAssetData.textures[iTexture] = Cr::Containers::NullOpt;
+    }
+  }
+}
+
+std::unique_ptr<DecodedAssetData> ResourceManager::decodeTextureData(
+    Importer& fileImporter,
+    const AssetInfo& info,
+    const std::string& transcodeCacheDir /* = "" */) {
+  core::ScopedTraceEvent trace{"ResourceManager::decodeTextureData", "assets"};
+  const std::string cacheFile = sceneCacheFilename(info.filepath);
+  if (Cr::Utility::Directory::exists(cacheFile)) {
+    std::unique_ptr<DecodedAssetData> decodedAssetData =
+        loadSceneCache(cacheFile, info, true);
+    if (decodedAssetData) {
+      return decodedAssetData;
+    }
+  }
+  Cr::Containers::Pointer<Importer> gltfImporter;
+  Cr::Containers::Optional<std::string> decompressed;
+  Importer* const importer =
+      openSceneFile(fileImporter, info.filepath, gltfImporter, decompressed);
+  if (!importer) {
+    LOG(ERROR) << "Cannot open file " << info.filepath;
+    return nullptr;
+  }
+  auto decodedAssetData = std::make_unique<DecodedAssetData>();
+  decodedAssetData->assetInfo = info;
+  decodedAssetData->requiresTextures = true;
+  decodeTexturesAndMaterials(*importer, *decodedAssetData, transcodeCacheDir);
+  return decodedAssetData;
+}
+
+void ResourceManager::prefetchStage(
+    const StageAttributes::ptr& stageAttributes) {
+  std::map<std::string, AssetInfo> assetInfoMap =
+      createStageAssetInfosFromAttributes(stageAttributes, true, true);
+
+  // discard the prefetches of a stage which was not loaded
+  for (auto it = prefetchedAssets_.begin(); it != prefetchedAssets_.end();) {
+    bool inStage = false;
+    for (const auto& assetInfo : assetInfoMap) {
+      inStage |= assetInfo.second.filepath == it->first;
+    }
+    it = inStage ? std::next(it) : prefetchedAssets_.erase(it);
+  }
+
+  for (const auto& assetInfo : assetInfoMap) {
+    const AssetInfo& info = assetInfo.second;
+    // the same asset types as loadStageInternal() loads as general meshes
+    if (info.type == AssetType::INSTANCE_MESH ||
+        info.type == AssetType::FRL_PTEX_MESH ||
+        info.type == AssetType::SUNCG_SCENE) {
+      continue;
+    }
+    prefetchAsset(info);
+  }
+}  // prefetchStage
+
+bool ResourceManager::prefetchAsset(const AssetInfo& info) {
+  const std::string& filename = info.filepath;
+  if (resourceDict_.count(filename) > 0 ||
+      prefetchedAssets_.count(filename) > 0) {
+    return true;
+  }
+  if (filename.compare(EMPTY_SCENE) == 0 ||
+      !Cr::Utility::Directory::exists(filename)) {
+    return false;
+  }
+
+  // plugin managers are not thread-safe, so every worker gets its own one,
+  // configured here as it needs the GL context
+  auto manager = std::make_unique<Cr::PluginManager::Manager<Importer>>(
+      importerPluginDirectory());
+  configureImporterManager(*manager);
+  Cr::Containers::Pointer<Importer> importer =
+      manager->loadAndInstantiate("AnySceneImporter");
+  if (!importer) {
+    LOG(ERROR) << "ResourceManager::prefetchAsset : Cannot instantiate an "
+                  "importer, not prefetching "
+               << filename;
+    return false;
+  }
+
+  LOG(INFO) << "ResourceManager::prefetchAsset : Prefetching " << filename;
+  prefetchedAssets_.emplace(
+      filename,
+      std::async(std::launch::async,
+                 [info, requiresTextures = requiresTextures_,
+                  transcodeCacheDir = transcodeCacheDir_,
+                  manager = std::move(manager),
+                  importer = std::move(importer)]() mutable {
+                   std::unique_ptr<DecodedAssetData> decodedAssetData =
+                       decodeGeneralMeshData(*importer, info, requiresTextures,
+                                             true, transcodeCacheDir);
+                   // the importer must go before its manager
+                   importer = nullptr;
+                   manager = nullptr;
+                   return decodedAssetData;
+                 }));
+  return true;
+}  // prefetchAsset
+
+bool ResourceManager::isAssetPrefetching(const std::string& filename) const {
+  auto prefetched = prefetchedAssets_.find(filename);
+  return prefetched != prefetchedAssets_.end() &&
+         prefetched->second.wait_for(std::chrono::seconds(0)) !=
+             std::future_status::ready;
+}
+
+void ResourceManager::discardPrefetchedAsset(const std::string& filename) {
+  prefetchedAssets_.erase(filename);
+}  // discardPrefetchedAsset
+
+bool ResourceManager::loadStreamedAsset(const AssetInfo& info,
+                                        scene::SceneNode* parent,
+                                        DrawableGroup* drawables,
+                                        bool buildCollisionMesh,
+                                        const Mn::ResourceKey& lightSetup) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  if (!loadStageInternal(info, parent, drawables, parent != nullptr, false,
+                         lightSetup)) {
+    LOG(ERROR) << "ResourceManager::loadStreamedAsset : Cannot load "
+               << info.filepath;
+    return false;
+  }
+  ++streamedAssetUses_[info.filepath];
+  // without a collision mesh the asset is only drawn
+  std::vector<CollisionMeshData> meshGroup;
+  if (buildCollisionMesh && !buildMeshGroups(info, meshGroup)) {
+    LOG(ERROR) << "ResourceManager::loadStreamedAsset : Cannot build the "
+                  "collision mesh of "
+               << info.filepath;
+  }
+  return true;
+}  // loadStreamedAsset
+
+void ResourceManager::releaseStreamedAsset(const std::string& filename) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
+  auto uses = streamedAssetUses_.find(filename);
+  if (uses == streamedAssetUses_.end() || --uses->second > 0) {
+    return;
+  }
+  streamedAssetUses_.erase(uses);
+  releaseAsset(filename);
+}  // releaseStreamedAsset
+
+std::shared_ptr<StageStreamer> ResourceManager::createStageStreamer(
+    const StageAttributes::ptr& stageAttributes,
+    scene::SceneNode& parent,
+    DrawableGroup& drawables,
+    std::shared_ptr<physics::PhysicsManager> physicsManager,
+    std::shared_ptr<nav::PathFinder> pathfinder,
+    const StageStreamer::Configuration& configuration) {
+  const std::string manifest = io::changeExtension(
+      stageAttributes->getRenderAssetHandle(), ".chunks.json");
+  std::vector<StageChunk> chunks;
+  if (!io::exists(manifest) || !loadStageChunks(manifest, chunks)) {
+    return nullptr;
+  }
+  LOG(INFO) << "ResourceManager::createStageStreamer : Streaming "
+            << chunks.size() << " chunks of " << manifest;
+  const AssetInfo stageInfo =
+      createStageAssetInfosFromAttributes(stageAttributes, false, false)
+          .at("render");
+  return StageStreamer::create(
+      *this, std::move(chunks), stageInfo, parent, drawables,
+      std::move(physicsManager), std::move(pathfinder), configuration,
+      Mn::ResourceKey{stageAttributes->getLightSetup()});
+}  // createStageStreamer
+
+bool ResourceManager::bakeSceneCache(const std::string& assetFile,
+                                     const std::string& cacheFile,
+                                     int levelOfDetailCount /* = 0 */) {
+  Cr::PluginManager::Manager<Importer> manager{importerPluginDirectory()};
+  configureImporterManager(manager);
+  Cr::Containers::Pointer<Importer> importer =
+      manager.loadAndInstantiate("AnySceneImporter");
+  if (!importer) {
+    LOG(ERROR) << "ResourceManager::bakeSceneCache : Cannot instantiate an "
+                  "importer";
+    return false;
+  }
+
+  // the cache holds everything it may be loaded with
+  const AssetInfo info = AssetInfo::fromPath(assetFile);
+  std::unique_ptr<DecodedAssetData> decodedAssetData =
+      decodeGeneralMeshData(*importer, info, true, false);
+  if (!decodedAssetData) {
+    return false;
+  }
+  for (std::unique_ptr<GenericMeshData>& mesh : decodedAssetData->meshes) {
+    mesh->generateLevelsOfDetail(levelOfDetailCount);
+  }
+  return saveSceneCache(*decodedAssetData, cacheFile);
+}
+
+bool ResourceManager::bakeAssetMetadata(const std::string& assetFile) {
+  Cr::PluginManager::Manager<Importer> manager{importerPluginDirectory()};
+  configureImporterManager(manager);
+  Cr::Containers::Pointer<Importer> importer =
+      manager.loadAndInstantiate("AnySceneImporter");
+  if (!importer) {
+    LOG(ERROR) << "ResourceManager::bakeAssetMetadata : Cannot instantiate an "
+                  "importer";
+    return false;
+  }
+
+  // the frame objects load their render asset in
+  const AssetInfo info{AssetType::UNKNOWN, assetFile};
+  std::unique_ptr<DecodedAssetData> decodedAssetData =
+      decodeGeneralMeshData(*importer, info, false);
+  if (!decodedAssetData) {
+    return false;
+  }
+  const Mn::Matrix4 R = Mn::Matrix4::from(
+      Mn::Quaternion(info.frame.rotationFrameToWorld()).toMatrix(),
+      Mn::Vector3());
+  Cr::Containers::Optional<Mn::Range3D> aabb;
+  int triangleCount = 0;
+  accumulateAssetMetadata(
+      [&](int meshID) -> BaseMesh& {
+        return *decodedAssetData->meshes[meshID];
+      },
+      decodedAssetData->root, R, aabb, triangleCount);
+  return ObjectAttributesManager::saveAssetMetadata(
+      assetFile, aabb ? *aabb : Mn::Range3D{}, triangleCount);
+}
+
+bool ResourceManager::bakePotentiallyVisibleSet(
+    const std::string& assetFile,
+    const std::vector<Mn::Vector3>& navigablePoints,
+    const std::string& pvsFile,
+    const gfx::PotentiallyVisibleSet::Configuration& configuration) {
+  Cr::PluginManager::Manager<Importer> manager{importerPluginDirectory()};
+  configureImporterManager(manager);
+  Cr::Containers::Pointer<Importer> importer =
+      manager.loadAndInstantiate("AnySceneImporter");
+  if (!importer) {
+    LOG(ERROR) << "ResourceManager::bakePotentiallyVisibleSet : Cannot "
+                  "instantiate an importer";
+    return false;
+  }
+
+  // in world space, like the stage and its navmesh
+  const AssetInfo info = AssetInfo::fromPath(assetFile);
+  std::unique_ptr<DecodedAssetData> decodedAssetData =
+      decodeGeneralMeshData(*importer, info, false);
+  if (!decodedAssetData) {
+    return false;
+  }
+  const Mn::Matrix4 R = Mn::Matrix4::from(
+      Mn::Quaternion(info.frame.rotationFrameToWorld()).toMatrix(),
+      Mn::Vector3());
+  std::vector<std::vector<Mn::Vector3>> itemTriangles;
+  gatherItemTriangles(
+      [&](int meshID) -> BaseMesh& {
+        return *decodedAssetData->meshes[meshID];
+      },
+      decodedAssetData->root, R, itemTriangles);
+
+  const gfx::PotentiallyVisibleSet set = gfx::PotentiallyVisibleSet::compute(
+      itemTriangles, navigablePoints, configuration);
+  if (!set.save(pvsFile)) {
+    LOG(ERROR) << "ResourceManager::bakePotentiallyVisibleSet : Cannot write "
+               << pvsFile;
+    return false;
+  }
+  double numVisible = 0.0;
+  for (uint32_t cell = 0; cell < set.numCells(); ++cell) {
+    numVisible += set.numVisible(cell);
+  }
+  LOG(INFO) << "ResourceManager::bakePotentiallyVisibleSet : "
+            << set.numCells() << " cells see "
+            << (set.numCells() ? numVisible / set.numCells() : 0.0) << " of "
+            << set.numItems() << " meshes on average";
+  return true;
+}
+
+bool ResourceManager::bakeTranscodedTextures(
+    const std::string& assetFile,
+    const std::string& cacheDir,
+    const std::string& basisFormat /* = "" */) {
+  Cr::PluginManager::Manager<Importer> manager{importerPluginDirectory()};
+  if (basisFormat.empty()) {
+    configureImporterManager(manager);
+  } else {
+    setPreferredImporterPlugins(manager);
+    if (Cr::PluginManager::PluginMetadata* const metadata =
+            manager.metadata("BasisImporter")) {
+      metadata->configuration().setValue("format", basisFormat);
+    }
+  }
+  Cr::Containers::Pointer<Importer> fileImporter =
+      manager.loadAndInstantiate("AnySceneImporter");
+  Cr::Containers::Pointer<Importer> gltfImporter;
+  Cr::Containers::Optional<std::string> decompressed;
+  Importer* const importer =
+      fileImporter ? openSceneFile(*fileImporter, assetFile, gltfImporter,
+                                   decompressed)
+                   : nullptr;
+  if (!importer) {
+    LOG(ERROR) << "ResourceManager::bakeTranscodedTextures : Cannot open "
+               << assetFile;
+    return false;
+  }
+
+  DecodedAssetData decodedAssetData;
+  decodedAssetData.assetInfo = AssetInfo::fromPath(assetFile);
+  decodeTexturesAndMaterials(*importer, decodedAssetData, cacheDir);
+  for (const auto& texture : decodedAssetData.textures) {
+    if (!texture) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<DecodedAssetData> ResourceManager::takePrefetchedAsset(
+    const AssetInfo& info) {
+  auto prefetched = prefetchedAssets_.find(info.filepath);
+  if (prefetched == prefetchedAssets_.end()) {
+    return nullptr;
+  }
+  std::unique_ptr<DecodedAssetData> decodedAssetData = prefetched->second.get();
+  prefetchedAssets_.erase(prefetched);
+  if (decodedAssetData && (decodedAssetData->assetInfo != info ||
+                           decodedAssetData->requiresTextures !=
+                               requiresTextures_)) {
+    // decodes differently, e.g. without normals
+    return nullptr;
+  }
+  return decodedAssetData;
+}
+
 int ResourceManager::loadNavMeshVisualization(esp::nav::PathFinder& pathFinder,
                                               scene::SceneNode* parent,
                                               DrawableGroup* drawables) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
   int navMeshPrimitiveID = ID_UNDEFINED;
 
   if (!pathFinder.isLoaded())
@@ -1142,62 +2368,169 @@ int ResourceManager::loadNavMeshVisualization(esp::nav::PathFinder& pathFinder,
   return navMeshPrimitiveID;
 }  // loadNavMeshVisualization
 
-void ResourceManager::loadMaterials(Importer& importer,
+void ResourceManager::loadMaterials(DecodedAssetData& decodedAssetData,
                                     LoadedAssetData& loadedAssetData) {
+  core::ScopedTraceEvent trace{"ResourceManager::loadMaterials", "assets"};
+  const int materialCount = decodedAssetData.materials.size();
   int materialStart = nextMaterialID_;
-  int materialEnd = materialStart + importer.materialCount() - 1;
+  int materialEnd = materialStart + materialCount - 1;
   loadedAssetData.meshMetaData.setMaterialIndices(materialStart, materialEnd);
 
-  for (int iMaterial = 0; iMaterial < importer.materialCount(); ++iMaterial) {
+  std::vector<std::unique_ptr<gfx::MaterialData>> materials;
+  for (int iMaterial = 0; iMaterial < materialCount; ++iMaterial) {
+    materials.push_back(
+        buildMaterial(decodedAssetData.materials[iMaterial], loadedAssetData));
+  }
+  packMaterialTextures(decodedAssetData, loadedAssetData, materials);
+
+  for (std::unique_ptr<gfx::MaterialData>& finalMaterial : materials) {
     int currentMaterialID = nextMaterialID_++;
+    if (!finalMaterial) {
+      continue;
+    }
+    // for now, just use unique ID for material key. This may change if we
+    // expose materials to user for post-load modification. Materials waiting
+    // for their textures are replaced once they are loaded.
+    shaderManager_.set(std::to_string(currentMaterialID),
+                       finalMaterial.release(),
+                       loadedAssetData.deferredTextures
+                           ? Mn::ResourceDataState::Mutable
+                           : Mn::ResourceDataState::Final,
+                       Mn::ResourcePolicy::Resident);
+  }
+}
 
-    // TODO:
-    // it seems we have a way to just load the material once in this case,
-    // as long as the materialName includes the full path to the material
-    Cr::Containers::Optional<Mn::Trade::MaterialData> materialData =
-        importer.material(iMaterial);
+void ResourceManager::packMaterialTextures(
+    const DecodedAssetData& decodedAssetData,
+    LoadedAssetData& loadedAssetData,
+    std::vector<std::unique_ptr<gfx::MaterialData>>& materials) {
+  const int textureStart = loadedAssetData.meshMetaData.textureIndex.first;
+  const int textureCount = decodedAssetData.textures.size();
+  if (textureArraySize_ <= 0 || textureCount == 0 ||
+      !decodedAssetData.requiresTextures) {
+    return;
+  }
+  // packed textures are never truncated
+  textureArrayPool_.setMaxTextureSize(
+      maxTextureSize_ > 0 ? std::min(textureArraySize_, maxTextureSize_)
+                          : textureArraySize_);
+
+  // the index of a texture in the asset, ID_UNDEFINED if it isn't one
+  const auto localIndex = [&](const Mn::GL::Texture2D* texture) {
+    for (int iTexture = 0; iTexture < textureCount; ++iTexture) {
+      if (textures_[textureStart + iTexture].get() == texture) {
+        return iTexture;
+      }
+    }
+    return int(ID_UNDEFINED);
+  };
 
-    if (!materialData) {
-      LOG(ERROR) << "Cannot load material, skipping";
+  std::vector<bool> packed(textureCount, false);
+  std::vector<bool> usedSeparately(textureCount, false);
+  for (std::unique_ptr<gfx::MaterialData>& material : materials) {
+    if (!material) {
       continue;
     }
+    auto& phong = static_cast<gfx::PhongMaterialData&>(*material);
+    Mn::GL::Texture2D** slots[]{&phong.ambientTexture, &phong.diffuseTexture,
+                                &phong.specularTexture, &phong.normalTexture};
+    Mn::GL::Texture2DArray** arraySlots[]{
+        &phong.ambientTextureArray, &phong.diffuseTextureArray,
+        &phong.specularTextureArray, &phong.normalTextureArray};
+
+    // the distinct textures of the material, a texture in several slots is
+    // packed once
+    int slotTextures[4];
+    std::vector<int> textures;
+    bool packable = true;
+    for (int slot = 0; slot < 4; ++slot) {
+      slotTextures[slot] =
+          *slots[slot] ? localIndex(*slots[slot]) : int(ID_UNDEFINED);
+      if (*slots[slot] && slotTextures[slot] == ID_UNDEFINED) {
+        packable = false;
+      } else if (slotTextures[slot] != ID_UNDEFINED &&
+                 std::find(textures.begin(), textures.end(),
+                           slotTextures[slot]) == textures.end()) {
+        textures.push_back(slotTextures[slot]);
+      }
+    }
 
-    std::unique_ptr<gfx::MaterialData> finalMaterial;
-    int textureBaseIndex = loadedAssetData.meshMetaData.textureIndex.first;
-
-    if (loadedAssetData.assetInfo.requiresLighting &&
-        materialData->types() &
-            Magnum::Trade::MaterialType::PbrMetallicRoughness) {
-      const Mn::Trade::PbrMetallicRoughnessMaterialData&
-          pbrMetallicRoughnessMaterialData =
-              static_cast<Mn::Trade::PbrMetallicRoughnessMaterialData&>(
-                  *materialData);
+    Cr::Containers::Optional<gfx::TextureArrayPool::Allocation> allocation;
+    if (packable && !textures.empty()) {
+      std::vector<gfx::TextureArrayPool::Texture> poolTextures;
+      for (int iTexture : textures) {
+        const auto& textureData = decodedAssetData.textures[iTexture];
+        poolTextures.push_back(
+            {textureData ? &*textureData : nullptr,
+             &decodedAssetData.textureImages[iTexture]});
+      }
+      allocation = textureArrayPool_.add(poolTextures);
+    }
+    if (!allocation) {
+      for (int iTexture : textures) {
+        usedSeparately[iTexture] = true;
+      }
+      continue;
+    }
 
-      finalMaterial = gfx::buildPhongFromPbrMetallicRoughness(
-          pbrMetallicRoughnessMaterialData, textureBaseIndex, textures_);
-    } else {
-      ASSERT(materialData);
-      if (!(materialData->types() & Magnum::Trade::MaterialType::Phong)) {
-        LOG(ERROR) << "Cannot load material, skipping";
+    for (int slot = 0; slot < 4; ++slot) {
+      if (slotTextures[slot] == ID_UNDEFINED) {
         continue;
       }
+      const std::size_t index =
+          std::find(textures.begin(), textures.end(), slotTextures[slot]) -
+          textures.begin();
+      *arraySlots[slot] = allocation->arrays[index];
+      *slots[slot] = nullptr;
+      packed[slotTextures[slot]] = true;
+    }
+    phong.textureLayer = allocation->layer;
+    loadedAssetData.textureArrayLayers.push_back(std::move(*allocation));
+  }
+  textureArrayPool_.generateMipmaps();
 
-      const auto& phongMaterialData =
-          materialData->as<Mn::Trade::PhongMaterialData>();
-      if (loadedAssetData.assetInfo.requiresLighting) {
-        finalMaterial =
-            buildPhongShadedMaterialData(phongMaterialData, textureBaseIndex);
-
-      } else {
-        finalMaterial =
-            buildFlatShadedMaterialData(phongMaterialData, textureBaseIndex);
-      }
+  // the layers take the place of the separate textures in the memory
+  // estimate of the asset
+  for (int iTexture = 0; iTexture < textureCount; ++iTexture) {
+    if (packed[iTexture] && !usedSeparately[iTexture]) {
+      textures_[textureStart + iTexture] = nullptr;
     }
-    // for now, just use unique ID for material key. This may change if we
-    // expose materials to user for post-load modification
-    shaderManager_.set(std::to_string(currentMaterialID),
-                       finalMaterial.release());
   }
+}  // ResourceManager::packMaterialTextures
+
+std::unique_ptr<gfx::MaterialData> ResourceManager::buildMaterial(
+    const Cr::Containers::Optional<Mn::Trade::MaterialData>& materialData,
+    const LoadedAssetData& loadedAssetData) {
+  if (!materialData) {
+    LOG(ERROR) << "Cannot load material, skipping";
+    return nullptr;
+  }
+
+  int textureBaseIndex = loadedAssetData.meshMetaData.textureIndex.first;
+
+  if (loadedAssetData.assetInfo.requiresLighting &&
+      materialData->types() &
+          Magnum::Trade::MaterialType::PbrMetallicRoughness) {
+    const Mn::Trade::PbrMetallicRoughnessMaterialData&
+        pbrMetallicRoughnessMaterialData =
+            static_cast<const Mn::Trade::PbrMetallicRoughnessMaterialData&>(
+                *materialData);
+
+    return gfx::buildPhongFromPbrMetallicRoughness(
+        pbrMetallicRoughnessMaterialData, textureBaseIndex, textures_);
+  }
+
+  if (!(materialData->types() & Magnum::Trade::MaterialType::Phong)) {
+    LOG(ERROR) << "Cannot load material, skipping";
+    return nullptr;
+  }
+
+  const auto& phongMaterialData =
+      materialData->as<Mn::Trade::PhongMaterialData>();
+  if (loadedAssetData.assetInfo.requiresLighting) {
+    return buildPhongShadedMaterialData(phongMaterialData, textureBaseIndex);
+  }
+  return buildFlatShadedMaterialData(phongMaterialData, textureBaseIndex);
 }
 
 gfx::PhongMaterialData::uptr ResourceManager::buildFlatShadedMaterialData(
@@ -1267,21 +2600,18 @@ gfx::PhongMaterialData::uptr ResourceManager::buildPhongShadedMaterialData(
   return finalMaterial;
 }
 
-void ResourceManager::loadMeshes(Importer& importer,
+void ResourceManager::loadMeshes(DecodedAssetData& decodedAssetData,
                                  LoadedAssetData& loadedAssetData) {
+  core::ScopedTraceEvent trace{"ResourceManager::loadMeshes", "assets"};
   int meshStart = meshes_.size();
-  int meshEnd = meshStart + importer.meshCount() - 1;
+  int meshEnd = meshStart + decodedAssetData.meshes.size() - 1;
   loadedAssetData.meshMetaData.setMeshIndices(meshStart, meshEnd);
 
-  for (int iMesh = 0; iMesh < importer.meshCount(); ++iMesh) {
-    // don't need normals if we aren't using lighting
-    auto gltfMeshData = std::make_unique<GenericMeshData>(
-        loadedAssetData.assetInfo.requiresLighting);
-    gltfMeshData->importAndSetMeshData(importer, iMesh);
-
-    // compute the mesh bounding box
-    gltfMeshData->BB = computeMeshBB(gltfMeshData.get());
-
+  for (std::unique_ptr<GenericMeshData>& gltfMeshData :
+       decodedAssetData.meshes) {
+    gltfMeshData->generateLevelsOfDetail(levelOfDetailCount_);
+    gltfMeshData->setCompactVertexFormat(compactVertexFormat_);
+    gltfMeshData->setMeshArena(meshArenaEnabled_ ? &meshArena_ : nullptr);
     gltfMeshData->uploadBuffersToGPU(false);
     meshes_.emplace_back(std::move(gltfMeshData));
   }
@@ -1311,13 +2641,9 @@ void ResourceManager::loadMeshHierarchy(Importer& importer,
   if (objectData->instanceType() == Magnum::Trade::ObjectInstanceType3D::Mesh &&
       meshIDLocal != ID_UNDEFINED) {
     parent.children.back().meshIDLocal = meshIDLocal;
-    if (requiresTextures_) {
-      parent.children.back().materialIDLocal =
-          static_cast<Magnum::Trade::MeshObjectData3D*>(objectData.get())
-              ->material();
-    } else {
-      parent.children.back().materialIDLocal = ID_UNDEFINED;
-    }
+    parent.children.back().materialIDLocal =
+        static_cast<Magnum::Trade::MeshObjectData3D*>(objectData.get())
+            ->material();
   }
 
   // Recursively add children
@@ -1326,84 +2652,210 @@ void ResourceManager::loadMeshHierarchy(Importer& importer,
   }
 }
 
-void ResourceManager::loadTextures(Importer& importer,
+void ResourceManager::loadTextures(DecodedAssetData& decodedAssetData,
                                    LoadedAssetData& loadedAssetData) {
+  core::ScopedTraceEvent trace{"ResourceManager::loadTextures", "assets"};
+  core::ScopedTimer timer{core::ProfilingStage::GpuUpload};
   int textureStart = textures_.size();
-  int textureEnd = textureStart + importer.textureCount() - 1;
+  int textureEnd = textureStart + decodedAssetData.textures.size() - 1;
   loadedAssetData.meshMetaData.setTextureIndices(textureStart, textureEnd);
+  loadedAssetData.deferredTextures = !decodedAssetData.requiresTextures;
+
+  for (std::size_t iTexture = 0; iTexture < decodedAssetData.textures.size();
+       ++iTexture) {
+    const Cr::Containers::Optional<Mn::Trade::TextureData>& textureData =
+        decodedAssetData.textures[iTexture];
+    // an empty slot until the images are loaded, if they are deferred
+    if (!textureData || !decodedAssetData.requiresTextures) {
+      textures_.emplace_back(nullptr);
+      continue;
+    }
+    textures_.emplace_back(createTexture(
+        *textureData, decodedAssetData.textureImages[iTexture],
+        loadedAssetData));
+  }
+}  // ResourceManager::loadTextures
 
-  for (int iTexture = 0; iTexture < importer.textureCount(); ++iTexture) {
-    textures_.emplace_back(std::make_shared<Magnum::GL::Texture2D>());
-    auto& currentTexture = textures_.back();
+std::shared_ptr<Mn::GL::Texture2D> ResourceManager::createTexture(
+    const Mn::Trade::TextureData& textureData,
+    const std::vector<Mn::Trade::ImageData2D>& images,
+    LoadedAssetData& loadedAssetData) {
+  auto texturePtr = std::make_shared<Magnum::GL::Texture2D>();
+
+  // Configure the texture
+  Mn::GL::Texture2D& texture = *texturePtr;
+  texture.setMagnificationFilter(textureData.magnificationFilter())
+      .setMinificationFilter(textureData.minificationFilter(),
+                             textureData.mipmapFilter())
+      .setWrapping(textureData.wrapping().xy());
+
+  // skip the mip levels above the size limit, keeping at least the last one
+  std::uint32_t firstLevel = 0;
+  while (maxTextureSize_ > 0 && firstLevel + 1 < images.size() &&
+         images[firstLevel].size().max() > maxTextureSize_) {
+    ++firstLevel;
+  }
+  // a single level gets its mips generated, so it is halved instead
+  Cr::Containers::Optional<Mn::Trade::ImageData2D> halved;
+  if (maxTextureSize_ > 0 && images.size() == 1 &&
+      !images[0].isCompressed() && isBytePerChannel(images[0].format())) {
+    const Mn::Trade::ImageData2D* source = &images[0];
+    while (source->size().max() > maxTextureSize_) {
+      halved = halveImage(*source);
+      source = &*halved;
+    }
+  }
+  if (firstLevel > 0 || halved) {
+    loadedAssetData.truncatedTextureSize = maxTextureSize_;
+  }
 
-    auto textureData = importer.texture(iTexture);
-    if (!textureData ||
-        textureData->type() != Magnum::Trade::TextureData::Type::Texture2D) {
-      LOG(ERROR) << "Cannot load texture " << iTexture << " skipping";
-      currentTexture = nullptr;
-      continue;
+  // Load the mip levels
+  const std::uint32_t levelCount = images.size() - firstLevel;
+  bool generateMipmap = false;
+  for (std::uint32_t level = 0; level != levelCount; ++level) {
+    const Mn::Trade::ImageData2D& image =
+        halved ? *halved : images[firstLevel + level];
+
+    Mn::GL::TextureFormat format;
+    if (image.isCompressed()) {
+      format = Mn::GL::textureFormat(image.compressedFormat());
+    } else {
+      format = Mn::GL::textureFormat(image.format());
     }
 
-    // Configure the texture
-    Mn::GL::Texture2D& texture = *(textures_[textureStart + iTexture].get());
-    texture.setMagnificationFilter(textureData->magnificationFilter())
-        .setMinificationFilter(textureData->minificationFilter(),
-                               textureData->mipmapFilter())
-        .setWrapping(textureData->wrapping().xy());
-
-    // Load all mip levels
-    const std::uint32_t levelCount =
-        importer.image2DLevelCount(textureData->image());
-    bool generateMipmap = false;
-    for (std::uint32_t level = 0; level != levelCount; ++level) {
-      // TODO:
-      // it seems we have a way to just load the image once in this case,
-      // as long as the image2DName include the full path to the image
-      Cr::Containers::Optional<Mn::Trade::ImageData2D> image =
-          importer.image2D(textureData->image(), level);
-      if (!image) {
-        LOG(ERROR) << "Cannot load texture image, skipping";
-        currentTexture = nullptr;
-        break;
-      }
+    // For the very first level, allocate the texture
+    if (level == 0) {
+      // If there is just one level and the image is not compressed, we'll
+      // generate mips ourselves
+      if (levelCount == 1 && !image.isCompressed()) {
+        texture.setStorage(Mn::Math::log2(image.size().max()) + 1, format,
+                           image.size());
+        generateMipmap = true;
+      } else
+        texture.setStorage(levelCount, format, image.size());
+    }
 
-      Mn::GL::TextureFormat format;
-      if (image->isCompressed()) {
-        format = Mn::GL::textureFormat(image->compressedFormat());
-      } else {
-        format = Mn::GL::textureFormat(image->format());
-      }
+    if (image.isCompressed())
+      texture.setCompressedSubImage(level, {}, image);
+    else
+      texture.setSubImage(level, {}, image);
+    // generated mip levels add up to a third of the first level
+    loadedAssetData.textureBytes +=
+        generateMipmap ? image.data().size() * 4 / 3 : image.data().size();
+  }
 
-      // For the very first level, allocate the texture
-      if (level == 0) {
-        // If there is just one level and the image is not compressed, we'll
-        // generate mips ourselves
-        if (levelCount == 1 && !image->isCompressed()) {
-          texture.setStorage(Mn::Math::log2(image->size().max()) + 1, format,
-                             image->size());
-          generateMipmap = true;
-        } else
-          texture.setStorage(levelCount, format, image->size());
-      }
+  // Generate a mipmap if requested
+  if (generateMipmap)
+    texture.generateMipmap();
+  return texturePtr;
+}  // ResourceManager::createTexture
+
+void ResourceManager::setRequiresTextures(bool newVal) {
+  const bool load = newVal && !requiresTextures_;
+  requiresTextures_ = newVal;
+  if (load) {
+    loadDeferredTextures();
+  }
+}
 
-      if (image->isCompressed())
-        texture.setCompressedSubImage(level, {}, *image);
-      else
-        texture.setSubImage(level, {}, *image);
+void ResourceManager::setMaxTextureSize(int maxTextureSize) {
+  const int oldMaxTextureSize = maxTextureSize_;
+  maxTextureSize_ = maxTextureSize;
+  // not raised
+  if (oldMaxTextureSize == 0 ||
+      (maxTextureSize_ > 0 && maxTextureSize_ <= oldMaxTextureSize)) {
+    return;
+  }
+  configureImporterManager(importerManager_);
+  for (auto& loadedAsset : resourceDict_) {
+    LoadedAssetData& loadedAssetData = loadedAsset.second;
+    // deferred textures are loaded at the limit of when they are needed
+    if (loadedAssetData.truncatedTextureSize == 0 ||
+        loadedAssetData.deferredTextures) {
+      continue;
     }
+    LOG(INFO) << "ResourceManager::setMaxTextureSize : Loading the textures "
+                 "of "
+              << loadedAsset.first << " at a higher resolution";
+    reloadAssetTextures(loadedAsset.first, loadedAssetData);
+  }
+}
 
-    // Mip level loading failed, fail the whole texture
-    if (currentTexture == nullptr)
+void ResourceManager::loadDeferredTextures() {
+  configureImporterManager(importerManager_);
+  for (auto& loadedAsset : resourceDict_) {
+    LoadedAssetData& loadedAssetData = loadedAsset.second;
+    if (!loadedAssetData.deferredTextures) {
       continue;
+    }
+    LOG(INFO) << "ResourceManager::loadDeferredTextures : Loading the "
+                 "textures of "
+              << loadedAsset.first;
+    if (reloadAssetTextures(loadedAsset.first, loadedAssetData)) {
+      loadedAssetData.deferredTextures = false;
+    }
+  }
+}
 
-    // Generate a mipmap if requested
-    if (generateMipmap)
-      texture.generateMipmap();
+bool ResourceManager::reloadAssetTextures(const std::string& filename,
+                                          LoadedAssetData& loadedAssetData) {
+  std::unique_ptr<DecodedAssetData> decodedAssetData = decodeTextureData(
+      *fileImporter_, loadedAssetData.assetInfo, transcodeCacheDir_);
+  const MeshMetaData& metaData = loadedAssetData.meshMetaData;
+  const int textureCount =
+      metaData.textureIndex.second - metaData.textureIndex.first + 1;
+  const int materialCount =
+      metaData.materialIndex.second - metaData.materialIndex.first + 1;
+  if (!decodedAssetData ||
+      int(decodedAssetData->textures.size()) != textureCount ||
+      int(decodedAssetData->materials.size()) != materialCount) {
+    LOG(ERROR) << "ResourceManager::reloadAssetTextures : Cannot load the "
+                  "textures of "
+               << filename << ", keeping the current ones";
+    return false;
   }
-}  // ResourceManager::loadTextures
+
+  // the old textures are freed here, the materials referring to them are
+  // replaced below
+  loadedAssetData.textureBytes = 0;
+  loadedAssetData.truncatedTextureSize = 0;
+  for (int iTexture = 0; iTexture < textureCount; ++iTexture) {
+    const Cr::Containers::Optional<Mn::Trade::TextureData>& textureData =
+        decodedAssetData->textures[iTexture];
+    if (textureData) {
+      textures_[metaData.textureIndex.first + iTexture] =
+          createTexture(*textureData, decodedAssetData->textureImages[iTexture],
+                        loadedAssetData);
+    }
+  }
+  // the drawables refer to the materials by key, so they pick up the
+  // textured ones, and the matching shader variant
+  // released in reverse, so that the materials get their layers back and
+  // the instances batched by them stay valid
+  for (auto layer = loadedAssetData.textureArrayLayers.rbegin();
+       layer != loadedAssetData.textureArrayLayers.rend(); ++layer) {
+    textureArrayPool_.release(*layer);
+  }
+  loadedAssetData.textureArrayLayers.clear();
+  std::vector<std::unique_ptr<gfx::MaterialData>> materials;
+  for (int iMaterial = 0; iMaterial < materialCount; ++iMaterial) {
+    materials.push_back(buildMaterial(decodedAssetData->materials[iMaterial],
+                                      loadedAssetData));
+  }
+  packMaterialTextures(*decodedAssetData, loadedAssetData, materials);
+  for (int iMaterial = 0; iMaterial < materialCount; ++iMaterial) {
+    if (materials[iMaterial]) {
+      shaderManager_.set(
+          std::to_string(metaData.materialIndex.first + iMaterial),
+          materials[iMaterial].release());
+    }
+  }
+  return true;
+}
 
 bool ResourceManager::instantiateAssetsOnDemand(
     const std::string& objectTemplateHandle) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
   // Meta data
   ObjectAttributes::ptr ObjectAttributes =
       objectAttributesManager_->getObjectByHandle(objectTemplateHandle);
@@ -1455,8 +2907,31 @@ bool ResourceManager::instantiateAssetsOnDemand(
     }
   }  // if no render asset exists
 
+  // describe the render asset in the template, so that the next templates
+  // using it can be reasoned about without loading it
+  if (!ObjectAttributes->getRenderAssetIsPrimitive() &&
+      !ObjectAttributes->getHasAssetMetadata() &&
+      resourceDict_.count(renderAssetHandle) > 0) {
+    const MeshMetaData& meshMetaData = getMeshMetaData(renderAssetHandle);
+    Cr::Containers::Optional<Mn::Range3D> aabb;
+    int triangleCount = 0;
+    accumulateAssetMetadata(
+        [&](int meshID) -> BaseMesh& {
+          return *meshes_[meshMetaData.meshIndex.first + meshID];
+        },
+        meshMetaData.root, Mn::Matrix4{}, aabb, triangleCount);
+    // the registered template, which may have been replaced above
+    auto registered =
+        objectAttributesManager_->getObjectByHandle(objectTemplateHandle);
+    registered->setRenderAssetAabb(aabb ? *aabb : Mn::Range3D{});
+    registered->setRenderAssetTriangleCount(triangleCount);
+    registered->setHasAssetMetadata(true);
+    ObjectAttributesManager::saveAssetMetadata(
+        renderAssetHandle, registered->getRenderAssetAabb(), triangleCount);
+  }
+
   // check if uses collision mesh
-  if (!ObjectAttributes->getCollisionAssetIsPrimitive()) {
+  if (!renderOnly_ && !ObjectAttributes->getCollisionAssetIsPrimitive()) {
     const auto collisionAssetHandle =
         ObjectAttributes->getCollisionAssetHandle();
     if (resourceDict_.count(collisionAssetHandle) == 0) {
@@ -1497,6 +2972,7 @@ void ResourceManager::addObjectToDrawables(
     DrawableGroup* drawables,
     std::vector<scene::SceneNode*>& visNodeCache,
     const Mn::ResourceKey& lightSetup) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
   if (parent != nullptr and drawables != nullptr) {
     //! Add mesh to rendering stack
 
@@ -1527,7 +3003,7 @@ void ResourceManager::addObjectToDrawables(
 
     addComponent(loadedAssetData.meshMetaData, scalingNode, lightSetup,
                  drawables, loadedAssetData.meshMetaData.root, visNodeCache,
-                 false, staticDrawableInfo);
+                 false, staticDrawableInfo, instancedObjectRendering_);
 
     // set the node type for all cached visual nodes
     for (auto node : visNodeCache) {
@@ -1545,7 +3021,8 @@ void ResourceManager::addComponent(
     const MeshTransformNode& meshTransformNode,
     std::vector<scene::SceneNode*>& visNodeCache,
     bool computeAbsoluteAABBs,
-    std::vector<StaticDrawableInfo>& staticDrawableInfo) {
+    std::vector<StaticDrawableInfo>& staticDrawableInfo,
+    bool instanced) {
   // Add the object to the scene and set its transformation
   scene::SceneNode& node = parent.createChild();
   visNodeCache.push_back(&node);
@@ -1568,7 +3045,12 @@ void ResourceManager::addComponent(
           std::to_string(metaData.materialIndex.first + materialIDLocal);
     }
 
-    createGenericDrawable(mesh, node, lightSetup, materialKey, drawables);
+    if (!(instanced && drawables &&
+          addInstanceToDrawables(meshID, mesh, node, lightSetup, materialKey,
+                                 *drawables))) {
+      createGenericDrawable(mesh, node, lightSetup, materialKey, drawables,
+                            meshID);
+    }
 
     // compute the bounding box for the mesh we are adding
     if (computeAbsoluteAABBs) {
@@ -1581,19 +3063,71 @@ void ResourceManager::addComponent(
   // Recursively add children
   for (auto& child : meshTransformNode.children) {
     addComponent(metaData, node, lightSetup, drawables, child, visNodeCache,
-                 computeAbsoluteAABBs, staticDrawableInfo);
+                 computeAbsoluteAABBs, staticDrawableInfo, instanced);
   }
 }  // addComponent
 
+bool ResourceManager::addInstanceToDrawables(uint32_t meshID,
+                                             Mn::GL::Mesh& mesh,
+                                             scene::SceneNode& node,
+                                             const Mn::ResourceKey& lightSetup,
+                                             const Mn::ResourceKey& material,
+                                             DrawableGroup& drawables) {
+  // per-vertex object ids occupy the attribute of the per-instance object ids
+  auto materialData =
+      shaderManager_.get<gfx::MaterialData, gfx::PhongMaterialData>(material);
+  if (!materialData || materialData->perVertexObjectId) {
+    return false;
+  }
+
+  // materials in texture arrays which differ only in the layer are drawn
+  // together, each instance with its layer
+  const std::string key = Cr::Utility::formatString(
+      "{}:{}:{}", meshID,
+      materialData->hasTextureArrays() ? textureArrayBatchKey(*materialData)
+                                       : material.hexString(),
+      lightSetup.hexString());
+  gfx::InstancedDrawable* instancedDrawable =
+      drawables.getInstancedDrawable(key);
+  if (!instancedDrawable) {
+    std::unique_ptr<Mn::GL::Buffer>& instanceBuffer = instanceBuffers_[meshID];
+    if (!instanceBuffer) {
+      instanceBuffer = std::make_unique<Mn::GL::Buffer>();
+      gfx::InstancedDrawable::setupInstanceBuffer(mesh, *instanceBuffer);
+    }
+
+    // anchor the drawable at the root node, so it lives as long as the scene
+    // graph of the group
+    scene::SceneNode* root = &node;
+    while (auto* parent = dynamic_cast<scene::SceneNode*>(root->parent())) {
+      root = parent;
+    }
+    scene::SceneNode& anchor = root->createChild();
+    // so that the drawable takes part in ObjectsOnly passes
+    anchor.setType(scene::SceneNodeType::OBJECT);
+
+    // the drawable is owned by the anchor node
+    // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
+    instancedDrawable = new gfx::InstancedDrawable{
+        anchor,     mesh,     *instanceBuffer, shaderManager_,
+        lightSetup, material, &drawables};
+    drawables.setInstancedDrawable(key, *instancedDrawable);
+  }
+  instancedDrawable->addInstance(node, materialData->textureLayer);
+  return true;
+}
+
 void ResourceManager::addPrimitiveToDrawables(int primitiveID,
                                               scene::SceneNode& node,
                                               DrawableGroup* drawables) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
   CHECK(primitive_meshes_.count(primitiveID));
   createGenericDrawable(*primitive_meshes_.at(primitiveID), node, NO_LIGHT_KEY,
                         WHITE_MATERIAL_KEY, drawables);
 }
 
 void ResourceManager::removePrimitiveMesh(int primitiveID) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
   CHECK(primitive_meshes_.count(primitiveID));
   primitive_meshes_.erase(primitiveID);
 }
@@ -1603,9 +3137,30 @@ void ResourceManager::createGenericDrawable(
     scene::SceneNode& node,
     const Mn::ResourceKey& lightSetup,
     const Mn::ResourceKey& material,
-    DrawableGroup* group /* = nullptr */) {
-  node.addFeature<gfx::GenericDrawable>(mesh, shaderManager_, lightSetup,
-                                        material, group);
+    DrawableGroup* group /* = nullptr */,
+    int meshID /* = ID_UNDEFINED */) {
+  // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
+  auto* drawable = new gfx::GenericDrawable{
+      node, mesh, shaderManager_, lightSetup, material, group};
+  if (meshID == ID_UNDEFINED) {
+    return;
+  }
+  const auto* genericMesh =
+      dynamic_cast<const GenericMeshData*>(meshes_[meshID].get());
+  if (genericMesh && !genericMesh->getLevelsOfDetail().empty()) {
+    drawable->setLevelsOfDetail(genericMesh->getLevelsOfDetail(),
+                                genericMesh->BB,
+                                levelOfDetailPixelError_);
+  }
+  // the full detail triangles, for the indirect batch of a static drawable
+  if (genericMesh) {
+    const CollisionMeshData& triangles =
+        meshes_[meshID]->getCollisionMeshData();
+    if (triangles.primitive == Mn::MeshPrimitive::Triangles &&
+        !triangles.indices.empty()) {
+      drawable->setIndirectGeometry(triangles.positions, triangles.indices);
+    }
+  }
 }
 
 bool ResourceManager::loadSUNCGHouseFile(const AssetInfo& houseInfo,
@@ -1698,6 +3253,7 @@ bool ResourceManager::loadSUNCGHouseFile(const AssetInfo& houseInfo,
 void ResourceManager::initDefaultLightSetups() {
   shaderManager_.set(NO_LIGHT_KEY, gfx::LightSetup{});
   shaderManager_.setFallback(gfx::LightSetup{});
+  gfx::markLightSetupsChanged();
 }
 
 void ResourceManager::initDefaultMaterials() {
@@ -1739,9 +3295,16 @@ void ResourceManager::joinHeirarchy(
         meshes_[node.meshIDLocal + metaData.meshIndex.first]
             ->getCollisionMeshData();
     int lastIndex = mesh.vbo.size();
-    for (auto& pos : meshData.positions) {
-      mesh.vbo.push_back(Magnum::EigenIntegration::cast<vec3f>(
-          transformFromLocalToWorld.transformPoint(pos)));
+    // the positions are only transformed if the transform isn't identity
+    if (transformFromLocalToWorld == Magnum::Matrix4{}) {
+      for (auto& pos : meshData.positions) {
+        mesh.vbo.push_back(Magnum::EigenIntegration::cast<vec3f>(pos));
+      }
+    } else {
+      for (auto& pos : meshData.positions) {
+        mesh.vbo.push_back(Magnum::EigenIntegration::cast<vec3f>(
+            transformFromLocalToWorld.transformPoint(pos)));
+      }
     }
     for (auto& index : meshData.indices) {
       mesh.ibo.push_back(index + lastIndex);
@@ -1755,12 +3318,25 @@ void ResourceManager::joinHeirarchy(
 
 std::unique_ptr<MeshData> ResourceManager::createJoinedCollisionMesh(
     const std::string& filename) {
+  std::lock_guard<std::recursive_mutex> lock{registryMutex_};
   std::unique_ptr<MeshData> mesh = std::make_unique<MeshData>();
 
   CHECK(resourceDict_.count(filename) > 0);
 
   const MeshMetaData& metaData = getMeshMetaData(filename);
 
+  // a mesh is usually referenced once, so this avoids growing the buffers
+  std::size_t vertexCount = 0, indexCount = 0;
+  for (int iMesh = metaData.meshIndex.first;
+       iMesh >= 0 && iMesh <= metaData.meshIndex.second; ++iMesh) {
+    const CollisionMeshData& meshData = meshes_[iMesh]->getCollisionMeshData();
+    vertexCount += meshData.positions.size();
+    indexCount += meshData.indices.size();
+  }
+  mesh->vbo.reserve(vertexCount);
+  mesh->ibo.reserve(indexCount);
+
+  core::ScopedTimer timer{core::ProfilingStage::HierarchyJoin};
   Magnum::Matrix4 identity;
   joinHeirarchy(*mesh, metaData, metaData.root, identity);
 
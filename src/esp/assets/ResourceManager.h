@@ -10,14 +10,17 @@
  * esp::assets::ResourceManager::ShaderType
  */
 
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <Corrade/Containers/Optional.h>
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/MeshTools/Transform.h>
@@ -26,12 +29,19 @@
 #include "Asset.h"
 #include "BaseMesh.h"
 #include "CollisionMeshData.h"
+#include "GenericInstanceMeshData.h"
 #include "GenericMeshData.h"
+#include "MeshArena.h"
 #include "MeshData.h"
 #include "MeshMetaData.h"
+#include "SceneCache.h"
+#include "StageStreamer.h"
 #include "esp/gfx/DrawableGroup.h"
+#include "esp/gfx/GpuDevices.h"
 #include "esp/gfx/MaterialData.h"
+#include "esp/gfx/PotentiallyVisibleSet.h"
 #include "esp/gfx/ShaderManager.h"
+#include "esp/gfx/TextureArrayPool.h"
 #include "esp/physics/configure.h"
 #include "esp/scene/SceneManager.h"
 #include "esp/scene/SceneNode.h"
@@ -40,6 +50,7 @@
 #include "esp/metadata/managers/AssetAttributesManager.h"
 #include "esp/metadata/managers/ObjectAttributesManager.h"
 #include "esp/metadata/managers/PhysicsAttributesManager.h"
+#include "esp/metadata/managers/SceneAttributesManager.h"
 #include "esp/metadata/managers/StageAttributesManager.h"
 
 // forward declarations
@@ -173,6 +184,166 @@ class ResourceManager {
                  std::vector<int>& activeSceneIDs,
                  bool createSemanticMesh);
 
+  /**
+   * @brief Start decoding the assets of a stage on worker threads, so that a
+   * later @ref loadStage() of it only has to upload them to the GPU.
+   *
+   * The meshes, textures, materials and collision meshes of the general mesh
+   * assets of the stage (glTF, glb, obj, ...) are decoded into CPU memory,
+   * one worker thread per asset. Other asset types, loaded assets and assets
+   * already being prefetched are skipped. Loading waits for a prefetch still
+   * in progress. Prefetched assets of a stage not loaded before the next call
+   * are discarded.
+   *
+   * Must be called from the thread owning the GL context, since the target
+   * format of compressed textures depends on it.
+   * @param stageAttributes The @ref StageAttributes that describes the stage
+   */
+  void prefetchStage(const Attrs::StageAttributes::ptr& stageAttributes);
+
+  /**
+   * @brief Start decoding a general mesh asset on a worker thread, as
+   * @ref prefetchStage() does for the assets of a stage, e.g. a chunk of a
+   * streamed stage, see @ref StageStreamer.
+   *
+   * Must be called from the thread owning the GL context.
+   * @param info The asset, of a type loaded as a general mesh
+   * @return Whether the asset is loaded, being prefetched, or started. False
+   * if the file doesn't exist or no importer is available.
+   */
+  bool prefetchAsset(const AssetInfo& info);
+
+  /**
+   * @brief Whether an asset of @ref prefetchAsset() is still being decoded,
+   * so that loading it now would wait for the decode
+   */
+  bool isAssetPrefetching(const std::string& filename) const;
+
+  /**
+   * @brief Drop the decoded data of an asset of @ref prefetchAsset() that is
+   * not going to be loaded, e.g. a chunk the agents moved away from. Waits
+   * for the decode if it is still in progress.
+   */
+  void discardPrefetchedAsset(const std::string& filename);
+
+  /**
+   * @brief Load a general mesh asset of a streamed stage, e.g. a chunk of a
+   * @ref StageStreamer, and count a use of it.
+   *
+   * The asset is loaded like a stage, with the absolute AABBs of its
+   * drawables computed for culling. Its meshes stay loaded until each use is
+   * released with @ref releaseStreamedAsset().
+   * @param info The asset
+   * @param parent The node to instantiate the asset under, nullptr to only
+   * load it
+   * @param drawables The drawable group of @p parent
+   * @param buildCollisionMesh Whether to build the collision mesh of the
+   * asset too, see @ref physics::PhysicsManager::addStageChunk(). A failure
+   * to build it is logged and leaves the asset without one.
+   * @param lightSetup The light setup to draw the asset with
+   * @return Whether the asset was loaded, in which case a use is counted
+   */
+  bool loadStreamedAsset(const AssetInfo& info,
+                         scene::SceneNode* parent,
+                         DrawableGroup* drawables,
+                         bool buildCollisionMesh,
+                         const Mn::ResourceKey& lightSetup = Mn::ResourceKey{
+                             DEFAULT_LIGHTING_KEY});
+
+  /**
+   * @brief Release a use of an asset of @ref loadStreamedAsset(), releasing
+   * its meshes, textures and collision mesh with the last one. The nodes it
+   * was instantiated under have to be deleted before.
+   */
+  void releaseStreamedAsset(const std::string& filename);
+
+  /**
+   * @brief Create a @ref StageStreamer for the chunks of a stage, if a
+   * manifest of them, see @ref loadStageChunks(), is next to its render
+   * asset. The chunks are loaded with the frame, units and light setup of
+   * the stage.
+   * @param stageAttributes The attributes of the loaded stage
+   * @param parent The node to instantiate the chunks under
+   * @param drawables The drawable group of @p parent
+   * @param physicsManager The physics manager to add the collision of the
+   * chunks to, nullptr for none
+   * @param pathfinder The pathfinder whose tiles to stream, may be nullptr
+   * @param configuration The streaming configuration
+   * @return The streamer, nullptr if the stage isn't chunked
+   */
+  std::shared_ptr<StageStreamer> createStageStreamer(
+      const Attrs::StageAttributes::ptr& stageAttributes,
+      scene::SceneNode& parent,
+      DrawableGroup& drawables,
+      std::shared_ptr<physics::PhysicsManager> physicsManager,
+      std::shared_ptr<nav::PathFinder> pathfinder,
+      const StageStreamer::Configuration& configuration);
+
+  /**
+   * @brief Import a general mesh asset file and write it as a scene cache,
+   * see @ref saveSceneCache().
+   *
+   * Loading the asset afterwards reads the cache instead if it is at @ref
+   * sceneCacheFilename() of the asset. Basis textures are stored in the format
+   * chosen for the current GL context, or the importer default without one.
+   * @param assetFile The asset to import
+   * @param cacheFile The file to write
+   * @param levelOfDetailCount Coarser levels of detail to store with the
+   * meshes, see @ref setLevelsOfDetail()
+   * @return Whether the cache was written
+   */
+  static bool bakeSceneCache(const std::string& assetFile,
+                             const std::string& cacheFile,
+                             int levelOfDetailCount = 0);
+
+  /**
+   * @brief Import the Basis textures of an asset file into a transcoded image
+   * cache, see @ref setTextureTranscodeCacheDir().
+   *
+   * The images are only read from the cache when they are transcoded to the
+   * same format, so @p basisFormat has to be the one loading picks for the GL
+   * context it renders with, e.g. "Bc7RGBA".
+   * @param assetFile The asset to import
+   * @param cacheDir The directory of the cache
+   * @param basisFormat The Basis target format, empty for the one chosen for
+   * the current GL context or the importer default without one
+   * @return Whether all textures were imported
+   */
+  static bool bakeTranscodedTextures(const std::string& assetFile,
+                                     const std::string& cacheDir,
+                                     const std::string& basisFormat = "");
+
+  /**
+   * @brief Import a general mesh asset file and write the asset metadata
+   * object templates using it as render asset are filled with, see @ref
+   * AttrMgrs::ObjectAttributesManager::saveAssetMetadata().
+   * @param assetFile The asset to import
+   * @return Whether the metadata was written
+   */
+  static bool bakeAssetMetadata(const std::string& assetFile);
+
+  /**
+   * @brief Import a general mesh asset file, sample which of its meshes are
+   * visible from the navigable points, then write them as a potentially
+   * visible set, see @ref gfx::PotentiallyVisibleSet::compute().
+   *
+   * The items of the set are the meshes of the asset in the depth-first
+   * order of its hierarchy, which is the order a stage adds its drawables
+   * in, see @ref gfx::DrawableGroup::setPotentiallyVisibleSet(). The
+   * simulator looks for the set next to the asset, with the `.pvs`
+   * extension.
+   * @param assetFile The asset to import
+   * @param navigablePoints Points on the navmesh of the asset, in world space
+   * @param pvsFile The file to write
+   * @param configuration The sampling
+   * @return Whether the set was written
+   */
+  static bool bakePotentiallyVisibleSet(
+      const std::string& assetFile,
+      const std::vector<Mn::Vector3>& navigablePoints,
+      const std::string& pvsFile,
+      const gfx::PotentiallyVisibleSet::Configuration& configuration);
+
   /**
    * @brief Construct scene collision mesh group based on name and type of
    * scene.
@@ -199,6 +370,15 @@ class ResourceManager {
   bool instantiateAssetsOnDemand(const std::string& objTemplateHandle);
 
   //======== Accessor functions ========
+  /**
+   * @brief Whether @ref assets::CollisionMeshData are loaded for an asset,
+   * see @ref getCollisionMesh().
+   */
+  bool hasCollisionMesh(const std::string& collisionAssetHandle) const {
+    return collisionMeshGroups_.count(collisionAssetHandle) > 0 &&
+           resourceDict_.count(collisionAssetHandle) > 0;
+  }
+
   /**
    * @brief Getter for all @ref assets::CollisionMeshData associated with the
    * particular asset.
@@ -244,6 +424,14 @@ class ResourceManager {
       const {
     return stageAttributesManager_;
   }
+  /**
+   * @brief Return manager for construction and access to scene instance
+   * attributes.
+   */
+  const AttrMgrs::SceneAttributesManager::ptr getSceneAttributesManager()
+      const {
+    return sceneAttributesManager_;
+  }
 
   /**
    * @brief Retrieve the composition of all transforms applied to a mesh
@@ -277,6 +465,7 @@ class ResourceManager {
    */
   Mn::Resource<gfx::LightSetup> getLightSetup(
       const Mn::ResourceKey& key = Mn::ResourceKey{DEFAULT_LIGHTING_KEY}) {
+    std::lock_guard<std::recursive_mutex> lock{registryMutex_};
     return shaderManager_.get<gfx::LightSetup>(key);
   }
 
@@ -292,10 +481,23 @@ class ResourceManager {
   void setLightSetup(gfx::LightSetup setup,
                      const Mn::ResourceKey& key = Mn::ResourceKey{
                          DEFAULT_LIGHTING_KEY}) {
+    std::lock_guard<std::recursive_mutex> lock{registryMutex_};
     shaderManager_.set(key, std::move(setup), Mn::ResourceDataState::Mutable,
                        Mn::ResourcePolicy::Manual);
+    gfx::markLightSetupsChanged();
   }
 
+  /**
+   * @brief The lock of the loaded assets, meshes, textures and shader
+   * resources, held by the functions loading, drawing or releasing them.
+   *
+   * Simulators on several threads sharing the manager, each with a context
+   * of one share group, see @ref gfx::WindowlessContext::isShareable(), hold
+   * it while they draw, since the shader programs of the drawables and their
+   * uniforms are shared as well. The attribute managers are not locked.
+   */
+  std::recursive_mutex& getRegistryMutex() const { return registryMutex_; }
+
   /**
    * @brief Construct a unified @ref MeshData from a loaded asset's collision
    * meshes.
@@ -425,9 +627,258 @@ class ResourceManager {
 
   /**
    * @brief Sets whether or not the current agent sensor suite requires textures
-   * for rendering. Textures will not be loaded if this is false.
+   * for rendering. Texture images will not be loaded if this is false.
+   *
+   * The materials are loaded regardless, without textures, so the drawables
+   * use the untextured shader variants. Setting this to true later loads the
+   * textures of the assets loaded before and replaces their materials, see
+   * @ref loadDeferredTextures().
+   */
+  void setRequiresTextures(bool newVal);
+
+  /**
+   * @brief Sets the largest mip level of the textures uploaded afterwards, in
+   * texels along the longer side, 0 for no limit, the default.
+   *
+   * The larger mip levels of a texture are not uploaded, or for a texture of
+   * a single level of one byte per channel, it is halved on the CPU before
+   * generating its mips. Raising the limit loads the textures of the assets
+   * truncated before again, at the new limit, see @ref
+   * reloadAssetTextures(). Lowering it does not touch uploaded textures.
+   */
+  void setMaxTextureSize(int maxTextureSize);
+
+  /** @brief The largest texture mip level uploaded, 0 for no limit */
+  int getMaxTextureSize() const { return maxTextureSize_; }
+
+  /**
+   * @brief Sets whether objects added with @ref addObjectToDrawables are
+   * drawn with one @ref gfx::InstancedDrawable per mesh, material and light
+   * setup instead of one @ref gfx::GenericDrawable per instance. Only affects
+   * objects added afterwards. Components with per-vertex object ids are never
+   * instanced.
+   */
+  inline void setInstancedObjectRendering(bool newVal) {
+    instancedObjectRendering_ = newVal;
+  }
+
+  /**
+   * @brief Whether objects are drawn instanced, see @ref
+   * setInstancedObjectRendering()
    */
-  inline void setRequiresTextures(bool newVal) { requiresTextures_ = newVal; }
+  inline bool getInstancedObjectRendering() const {
+    return instancedObjectRendering_;
+  }
+
+  /**
+   * @brief Sets the largest textures of the general meshes loaded afterwards
+   * packed into layers of shared texture arrays, 0 to disable, see @ref
+   * gfx::TextureArrayPool.
+   *
+   * The materials whose textures are all packed draw from the arrays, so
+   * drawables of different materials bind the same textures, and instanced
+   * objects of the same mesh whose materials differ only in their textures
+   * are drawn by one @ref gfx::InstancedDrawable, with a layer per instance.
+   * Textures larger than @ref getMaxTextureSize() are never packed.
+   */
+  void setTextureArraySize(int maxTextureSize) {
+    textureArraySize_ = maxTextureSize;
+  }
+
+  /** @brief The texture arrays, see @ref setTextureArraySize() */
+  const gfx::TextureArrayPool& getTextureArrayPool() const {
+    return textureArrayPool_;
+  }
+
+  /**
+   * @brief Sets whether assets are loaded for rendering only. Stages then
+   * load no collision mesh and build no collision mesh group, and objects
+   * load no collision asset, so a physics engine can't simulate what is
+   * loaded afterwards.
+   */
+  inline void setRenderOnly(bool newVal) { renderOnly_ = newVal; }
+
+  /** @brief Whether assets are loaded for rendering only */
+  inline bool getRenderOnly() const { return renderOnly_; }
+
+  /**
+   * @brief Sets whether meshes loaded afterwards are uploaded in compact
+   * vertex and index formats, see @ref BaseMesh::setCompactVertexFormat()
+   */
+  void setCompactVertexFormat(bool compact) { compactVertexFormat_ = compact; }
+
+  /**
+   * @brief Sets whether meshes loaded afterwards suballocate their buffers
+   * from the shared @ref getMeshArena(), see @ref BaseMesh::setMeshArena()
+   */
+  void setMeshArenaEnabled(bool enabled) { meshArenaEnabled_ = enabled; }
+
+  /** @brief The arena meshes are uploaded to, see @ref setMeshArenaEnabled() */
+  const MeshArena& getMeshArena() const { return meshArena_; }
+
+  /**
+   * @brief Sets what CPU-side data the instance meshes loaded afterwards keep
+   * once drawn, see @ref GenericInstanceMeshData::releaseCpuData()
+   */
+  void setInstanceMeshCpuData(InstanceMeshCpuData retained) {
+    instanceMeshCpuData_ = retained;
+  }
+
+  /**
+   * @brief Sets whether @ref loadStage() draws the object ids of the semantic
+   * mesh with the render mesh of the stage instead of a separate semantic
+   * scene graph, so that one draw of the stage yields both the colors and
+   * the object ids.
+   *
+   * Each vertex of the render mesh takes the id of the nearest vertex of the
+   * semantic mesh within @ref SemanticVertexIdDistance, see @ref
+   * transferObjectIds(). Only applies to general render meshes with a
+   * material for each component and @ref AssetType::INSTANCE_MESH semantic
+   * meshes, other stages still get a semantic scene graph. See @ref
+   * stageHasSemanticVertexIds().
+   *
+   * The geometry is then on the GPU once: the semantic mesh is only loaded
+   * to the CPU, as instance meshes are uploaded by the first scene graph
+   * drawing them, and both the color and the semantic sensors draw the
+   * buffers of the render mesh, with different shader variants.
+   */
+  void setSemanticVertexIds(bool semanticVertexIds) {
+    semanticVertexIds_ = semanticVertexIds;
+  }
+
+  /**
+   * @brief Whether the stage of the last @ref loadStage() draws the object
+   * ids of its semantic mesh, see @ref setSemanticVertexIds()
+   */
+  bool stageHasSemanticVertexIds() const { return stageSemanticVertexIds_; }
+
+  /**
+   * @brief The farthest a render mesh vertex can be from the semantic mesh
+   * vertex it takes the object id of, in meters, see @ref
+   * setSemanticVertexIds()
+   */
+  static constexpr float SemanticVertexIdDistance = 0.1f;
+
+  /**
+   * @brief Sets the levels of detail of the general meshes loaded afterwards.
+   *
+   * The meshes get @p count coarser levels, see @ref
+   * GenericMeshData::generateLevelsOfDetail(), which their drawables select
+   * from by screen size, see @ref gfx::GenericDrawable::setLevelsOfDetail().
+   * Instanced objects are always drawn at full detail.
+   * @param count The number of coarser levels, 0 to disable
+   * @param pixelError The largest screen-space error of a level, in pixels
+   */
+  void setLevelsOfDetail(int count, float pixelError) {
+    levelOfDetailCount_ = count;
+    levelOfDetailPixelError_ = pixelError;
+  }
+
+  /**
+   * @brief Sets the memory budgets of the stage assets kept loaded after a
+   * stage is replaced, so that switching back to a recent stage does not
+   * import it again.
+   *
+   * After each @ref loadStage(), the least recently used stage assets which
+   * the new stage does not use are released until the estimated memory of all
+   * loaded stage assets is within both budgets. The estimates account for the
+   * mesh positions and indices kept on the CPU, and the uploaded buffers and
+   * textures of @ref getAssetGpuBytes() on the GPU. Scene graphs of released
+   * stages must not be drawn anymore.
+   * @param cpuBytes Budget of the CPU memory, 0 for no limit.
+   * @param gpuBytes Budget of the GPU memory, 0 for no limit.
+   */
+  void setStageAssetCacheBudget(std::size_t cpuBytes, std::size_t gpuBytes) {
+    stageAssetCacheCpuBudget_ = cpuBytes;
+    stageAssetCacheGpuBudget_ = gpuBytes;
+  }
+
+  /**
+   * @brief Sets whether PTex meshes loaded afterwards stream their atlas
+   * textures, see @ref PTexAtlasCache.
+   *
+   * Streamed atlases are uploaded when first drawn and evicted under a GPU
+   * memory budget shared by all simulators rendering with the same GL
+   * context.
+   * @param streaming Whether to stream instead of uploading all atlases
+   * @param budgetBytes Budget of the resident atlases, 0 for no limit
+   */
+  void setPTexAtlasStreaming(bool streaming, std::size_t budgetBytes) {
+    ptexAtlasStreaming_ = streaming;
+    ptexAtlasBudget_ = budgetBytes;
+  }
+
+  /**
+   * @brief Sets whether PTex meshes loaded afterwards are drawn with the
+   * geometry shader expanding their quads, instead of as triangles taking the
+   * face from gl_PrimitiveID, see @ref gfx::PTexMeshShader::FaceIdSource
+   */
+  void setPTexGeometryShader(bool geometryShader) {
+    ptexGeometryShader_ = geometryShader;
+  }
+
+  /**
+   * @brief Sets the directory caching the Basis textures of assets loaded
+   * afterwards as transcoded GPU-native blocks, so that loading the same
+   * assets again skips transcoding. Empty, the default, for no cache.
+   *
+   * The cache files are keyed by the hash of the asset file contents, so an
+   * external image changed in place needs the cache to be cleared.
+   */
+  void setTextureTranscodeCacheDir(const std::string& dir) {
+    transcodeCacheDir_ = dir;
+  }
+
+  /**
+   * @brief The filenames of the loaded stage assets, the most recently used
+   * first. See @ref setStageAssetCacheBudget().
+   */
+  std::vector<std::string> getCachedStageAssets() const;
+
+  /**
+   * @brief The filenames of the loaded stage assets used by the current
+   * stage, see @ref setStageAssetCacheBudget()
+   */
+  std::vector<std::string> getCurrentStageAssets() const;
+
+  /**
+   * @brief Make a stage loaded before the current one current again, without
+   * loading it, e.g. when switching back to its scene graph. Its assets are
+   * then released last. Filenames which are not loaded anymore are skipped.
+   * @param filenames The stage assets, see @ref getCurrentStageAssets()
+   */
+  void useStageAssets(const std::vector<std::string>& filenames);
+
+  /**
+   * @brief Keep stage assets loaded whatever the budget, e.g. those of the
+   * scene graphs of several simulators sharing the resource manager, which
+   * the stage loads of the others would release otherwise. Pins are counted,
+   * every call needs an @ref unpinStageAssets() with the same filenames.
+   * @param filenames The stage assets, see @ref getCurrentStageAssets()
+   */
+  void pinStageAssets(const std::vector<std::string>& filenames);
+
+  /**
+   * @brief Let stage assets pinned by @ref pinStageAssets() be released once
+   * no other pin holds them
+   */
+  void unpinStageAssets(const std::vector<std::string>& filenames);
+
+  /**
+   * @brief Estimated GPU memory of the loaded meshes, textures and PTex
+   * atlases. The render target and noise model fields are left 0.
+   *
+   * Streamed PTex atlases are counted with the resident bytes of their
+   * @ref PTexAtlasCache, which every resource manager of the GL context
+   * shares.
+   */
+  gfx::GpuMemoryUsage getGpuMemoryUsage() const;
+
+  /**
+   * @brief Estimated GPU memory of each loaded asset, by filename. Streamed
+   * PTex atlases are not included, see @ref getGpuMemoryUsage().
+   */
+  std::map<std::string, std::size_t> getAssetGpuBytes() const;
 
  private:
   /**
@@ -466,8 +917,57 @@ class ResourceManager {
   struct LoadedAssetData {
     AssetInfo assetInfo;
     MeshMetaData meshMetaData;
+    //! estimated GPU memory of the textures, see @ref loadTextures()
+    std::size_t textureBytes = 0;
+    //! whether the texture images were skipped, see @ref
+    //! setRequiresTextures()
+    bool deferredTextures = false;
+    //! the limit some of the textures were truncated to, 0 if none were,
+    //! see @ref setMaxTextureSize()
+    int truncatedTextureSize = 0;
+    //! the layers of the textures packed into texture arrays, see @ref
+    //! setTextureArraySize()
+    std::vector<gfx::TextureArrayPool::Allocation> textureArrayLayers;
+  };
+
+  /**
+   * @brief Use and memory estimate of a loaded stage asset, see @ref
+   * setStageAssetCacheBudget()
+   */
+  struct CachedStageAsset {
+    //! value of @ref stageLoadCount_ when the asset was last used
+    std::size_t lastUsed = 0;
+    //! number of @ref pinStageAssets() calls holding the asset
+    int pins = 0;
+    std::size_t cpuBytes = 0;
+    std::size_t gpuBytes = 0;
   };
 
+  /**
+   * @brief Estimated GPU memory of the meshes, textures and non-streamed
+   * PTex atlases of a loaded asset
+   */
+  gfx::GpuMemoryUsage assetGpuMemoryUsage(
+      const LoadedAssetData& loadedAssetData) const;
+
+  /**
+   * @brief Record that a stage asset is used by the stage being loaded,
+   * estimating its memory on first use. Does nothing if it is not loaded.
+   */
+  void markStageAssetUsed(const std::string& filename);
+
+  /**
+   * @brief Release the least recently used stage assets neither used by the
+   * current stage nor pinned until the loaded stage assets fit the budgets.
+   */
+  void evictStageAssets();
+
+  /**
+   * @brief Release the meshes, textures and collision meshes of an asset and
+   * remove it from @ref resourceDict_.
+   */
+  void releaseAsset(const std::string& filename);
+
   /**
    * node: drawable's scene node
    *
@@ -506,6 +1006,8 @@ class ResourceManager {
    * result of this recursive process.
    * @param computeAABBs whether absolute bounding boxes should be computed
    * @param staticDrawableInfo structure holding the drawable infos for aabbs
+   * @param instanced whether the meshes are added as instances of a shared
+   * @ref gfx::InstancedDrawable, see @ref addInstanceToDrawables
    */
   void addComponent(const MeshMetaData& metaData,
                     scene::SceneNode& parent,
@@ -514,28 +1016,179 @@ class ResourceManager {
                     const MeshTransformNode& meshTransformNode,
                     std::vector<scene::SceneNode*>& visNodeCache,
                     bool computeAbsoluteAABBs,
-                    std::vector<StaticDrawableInfo>& staticDrawableInfo);
+                    std::vector<StaticDrawableInfo>& staticDrawableInfo,
+                    bool instanced = false);
 
   /**
-   * @brief Load textures from importer into assets, and update metaData for
-   * an asset to link textures to that asset.
+   * @brief Add a node as an instance of the @ref gfx::InstancedDrawable of
+   * the group drawing a mesh with a material and light setup, creating the
+   * drawable on first use.
    *
-   * @param importer The importer already loaded with information for the
-   * asset.
+   * @param meshID The index of the mesh in @ref meshes_
+   * @param mesh The GL mesh of @p meshID
+   * @param node The node of the instance
+   * @param lightSetup The light setup key
+   * @param material The material key
+   * @param drawables The group of the instanced drawable
+   * @return false if the material cannot be instanced, in which case nothing
+   * was added
+   */
+  bool addInstanceToDrawables(uint32_t meshID,
+                              Mn::GL::Mesh& mesh,
+                              scene::SceneNode& node,
+                              const Mn::ResourceKey& lightSetup,
+                              const Mn::ResourceKey& material,
+                              DrawableGroup& drawables);
+
+  /**
+   * @brief The plugin directory of importer plugin managers created besides
+   * @ref importerManager_
+   */
+  static std::string importerPluginDirectory();
+
+  /**
+   * @brief Set the preferred plugins and the Basis target GPU format of an
+   * importer plugin manager. Without a current GL context, the Basis importer
+   * keeps its default format.
+   */
+  static void configureImporterManager(
+      Corrade::PluginManager::Manager<Importer>& manager);
+
+  /**
+   * @brief Set the preferred plugins of an importer plugin manager, without
+   * touching the Basis target format
+   */
+  static void setPreferredImporterPlugins(
+      Corrade::PluginManager::Manager<Importer>& manager);
+
+  /**
+   * @brief The Basis target format of the plugin manager of @p importer, or
+   * "default" if it keeps the importer default
+   */
+  static std::string basisTargetFormat(Importer& importer);
+
+  /**
+   * @brief Decode the meshes, textures, materials and component hierarchy of
+   * a general mesh asset file. Does not touch any state of the resource
+   * manager, so it can run on any thread owning @p importer.
+   *
+   * A scene cache next to the asset, see @ref sceneCacheFilename(), is read
+   * instead of importing the file, unless it is outdated. Imported meshes get
+   * their triangles reordered, see @ref GenericMeshData::optimizeIndexOrder().
+   * glTF files with meshopt or Draco compressed geometry are decoded first,
+   * see @ref decompressGltf().
+   * @param importer The importer to open the file with
+   * @param info The asset to decode
+   * @param requiresTextures Whether the texture images are needed, the
+   * textures and materials are decoded regardless
+   * @param useSceneCache Whether to read a scene cache of the asset
+   * @param transcodeCacheDir Directory of the transcoded image cache, see
+   * @ref setTextureTranscodeCacheDir(), empty for none
+   * @return The decoded asset, nullptr if the file cannot be imported
+   */
+  static std::unique_ptr<DecodedAssetData> decodeGeneralMeshData(
+      Importer& importer,
+      const AssetInfo& info,
+      bool requiresTextures,
+      bool useSceneCache = true,
+      const std::string& transcodeCacheDir = "");
+
+  /**
+   * @brief Decode the textures and materials of the file open in @p importer,
+   * with the images if @ref DecodedAssetData::requiresTextures is set, see
+   * @ref decodeTextureImages()
+   */
+  static void decodeTexturesAndMaterials(
+      Importer& importer,
+      DecodedAssetData& decodedAssetData,
+      const std::string& transcodeCacheDir = "");
+
+  /**
+   * @brief Import all mip levels of an image of the file open in @p importer
+   * @return The levels, empty if one of them fails to import
+   */
+  static std::vector<Magnum::Trade::ImageData2D> importImageLevels(
+      Importer& importer,
+      Magnum::UnsignedInt image);
+
+  /**
+   * @brief Import the images of @p textures, transcoding Basis images on one
+   * worker thread per core, each with an importer of its own.
+   *
+   * With a @p transcodeCacheDir, images transcoded to GPU-native blocks are
+   * stored there, keyed by the hash of the asset file contents, the Basis
+   * target format and the image, and read back instead of transcoding when
+   * they are found. Textures whose images fail to import are reset.
+   */
+  static void decodeTextureImages(Importer& importer,
+                                  DecodedAssetData& decodedAssetData,
+                                  const std::vector<int>& textures,
+                                  const std::string& transcodeCacheDir);
+
+  /**
+   * @brief Decode just the textures, with their images, and the materials of
+   * a general mesh asset file, or read them from its scene cache
+   * @return nullptr if the file cannot be imported
+   */
+  static std::unique_ptr<DecodedAssetData> decodeTextureData(
+      Importer& importer,
+      const AssetInfo& info,
+      const std::string& transcodeCacheDir = "");
+
+  /**
+   * @brief Load the textures of all assets loaded without them, and replace
+   * their materials with textured ones, see @ref setRequiresTextures()
+   */
+  void loadDeferredTextures();
+
+  /**
+   * @brief Decode the textures of a loaded asset again and replace them and
+   * its materials, with the current @ref setMaxTextureSize() limit
+   * @return false if they cannot be decoded, the asset keeps its textures
+   */
+  bool reloadAssetTextures(const std::string& filename,
+                           LoadedAssetData& loadedAssetData);
+
+  /**
+   * @brief The prefetched decoded asset of @p info, waiting for the prefetch
+   * if it is still in progress.
+   * @return nullptr if @p info was not prefetched, the prefetch failed or was
+   * for a different configuration
+   */
+  std::unique_ptr<DecodedAssetData> takePrefetchedAsset(const AssetInfo& info);
+
+  /**
+   * @brief Upload decoded textures into assets, and update metaData for an
+   * asset to link textures to that asset.
+   *
+   * The textures are left empty if their images weren't decoded, until @ref
+   * loadDeferredTextures().
+   * @param decodedAssetData The decoded contents of the asset.
    * @param loadedAssetData The asset's @ref LoadedAssetData object.
    */
-  void loadTextures(Importer& importer, LoadedAssetData& loadedAssetData);
+  void loadTextures(DecodedAssetData& decodedAssetData,
+                    LoadedAssetData& loadedAssetData);
+
+  /**
+   * @brief Upload a decoded texture with its mip levels up to @ref
+   * setMaxTextureSize(), adding its size to @ref
+   * LoadedAssetData::textureBytes of @p loadedAssetData
+   */
+  std::shared_ptr<Magnum::GL::Texture2D> createTexture(
+      const Magnum::Trade::TextureData& textureData,
+      const std::vector<Magnum::Trade::ImageData2D>& images,
+      LoadedAssetData& loadedAssetData);
 
   /**
-   * @brief Load meshes from importer into assets.
+   * @brief Move decoded meshes into assets.
    *
-   * Compute bounding boxes, upload mesh data to GPU, and update metaData for
-   * an asset to link meshes to that asset.
-   * @param importer The importer already loaded with information for the
-   * asset.
+   * Upload mesh data to GPU, and update metaData for an asset to link meshes
+   * to that asset.
+   * @param decodedAssetData The decoded contents of the asset.
    * @param loadedAssetData The asset's @ref LoadedAssetData object.
    */
-  void loadMeshes(Importer& importer, LoadedAssetData& loadedAssetData);
+  void loadMeshes(DecodedAssetData& decodedAssetData,
+                  LoadedAssetData& loadedAssetData);
 
   /**
    * @brief Recursively parse the mesh component transformation heirarchy for
@@ -549,9 +1202,9 @@ class ResourceManager {
    * @param componentID The next component to add to the heirarchy. Identifies
    * the component in the @ref Importer.
    */
-  void loadMeshHierarchy(Importer& importer,
-                         MeshTransformNode& parent,
-                         int componentID);
+  static void loadMeshHierarchy(Importer& importer,
+                                MeshTransformNode& parent,
+                                int componentID);
 
   /**
    * @brief Recursively build a unified @ref MeshData from loaded assets via a
@@ -570,14 +1223,38 @@ class ResourceManager {
                      const Mn::Matrix4& transformFromParentToWorld);
 
   /**
-   * @brief Load materials from importer into assets, and update metaData for
-   * an asset to link materials to that asset.
+   * @brief Build decoded materials into assets, and update metaData for an
+   * asset to link materials to that asset.
    *
-   * @param importer The importer already loaded with information for the
-   * asset.
+   * @param decodedAssetData The decoded contents of the asset.
    * @param loadedAssetData The asset's @ref LoadedAssetData object.
    */
-  void loadMaterials(Importer& importer, LoadedAssetData& loadedAssetData);
+  void loadMaterials(DecodedAssetData& decodedAssetData,
+                     LoadedAssetData& loadedAssetData);
+
+  /**
+   * @brief Build a decoded material of an asset, with the textures of the
+   * asset loaded so far
+   * @return nullptr if the material is missing or of an unsupported type
+   */
+  std::unique_ptr<gfx::MaterialData> buildMaterial(
+      const Corrade::Containers::Optional<Magnum::Trade::MaterialData>&
+          materialData,
+      const LoadedAssetData& loadedAssetData);
+
+  /**
+   * @brief Pack the textures of the built @p materials of an asset into
+   * texture arrays, see @ref setTextureArraySize(), and release the separate
+   * textures only the packed materials used
+   * @param decodedAssetData The decoded textures of the asset
+   * @param loadedAssetData The asset, records the packed layers
+   * @param materials The materials of the asset, nullptr for the missing
+   * ones
+   */
+  void packMaterialTextures(
+      const DecodedAssetData& decodedAssetData,
+      LoadedAssetData& loadedAssetData,
+      std::vector<std::unique_ptr<gfx::MaterialData>>& materials);
 
   /**
    * @brief Build a @ref PhongMaterialData for use with flat shading
@@ -761,7 +1438,7 @@ class ResourceManager {
    * @param meshDataGL The mesh data.
    * @return The mesh bounding box.
    */
-  Mn::Range3D computeMeshBB(BaseMesh* meshDataGL);
+  static Mn::Range3D computeMeshBB(BaseMesh* meshDataGL);
 
   /**
    * @brief Compute the absolute AABBs for drawables in PTex mesh in world
@@ -774,6 +1451,17 @@ class ResourceManager {
       const std::vector<StaticDrawableInfo>& staticDrawableInfo);
 #endif
 
+  /**
+   * @brief Give the vertices of the render meshes of a stage the object ids
+   * of its semantic mesh and draw them with the ids, see @ref
+   * setSemanticVertexIds()
+   * @param renderInfo The loaded render asset of the stage
+   * @param semanticFilename The loaded semantic asset of the stage
+   * @return false without changing the stage if either asset isn't supported
+   */
+  bool transferSemanticVertexIds(const AssetInfo& renderInfo,
+                                 const std::string& semanticFilename);
+
   /**
    * @brief Compute the absolute AABBs for drawables in general mesh (e.g.,
    * MP3D) world space
@@ -812,10 +1500,10 @@ class ResourceManager {
    * for the drawable.
    * @param material The @ref MaterialData key that will be used
    * for the drawable.
-   * @param meshID Optional, the index of this mesh component stored in
-   * meshes_
    * @param group Optional @ref DrawableGroup with which the render the @ref
    * gfx::Drawable.
+   * @param meshID Optional, the index of this mesh component stored in
+   * meshes_, whose levels of detail the drawable draws
    * @param texture Optional texture for the mesh.
    * @param color Optional color parameter for the shader program. Defaults to
    * white.
@@ -824,7 +1512,8 @@ class ResourceManager {
                              scene::SceneNode& node,
                              const Mn::ResourceKey& lightSetup,
                              const Mn::ResourceKey& material,
-                             DrawableGroup* group = nullptr);
+                             DrawableGroup* group = nullptr,
+                             int meshID = ID_UNDEFINED);
 
   // ======== General geometry data ========
   // shared_ptr is used here, instead of Corrade::Containers::Optional, or
@@ -879,6 +1568,17 @@ class ResourceManager {
    */
   Corrade::Containers::Pointer<Importer> fileImporter_;
 
+  /**
+   * @brief Assets being decoded by @ref prefetchStage(), by filename
+   */
+  std::map<std::string, std::future<std::unique_ptr<DecodedAssetData>>>
+      prefetchedAssets_;
+
+  /**
+   * @brief Uses of the assets of @ref loadStreamedAsset(), by filename
+   */
+  std::map<std::string, int> streamedAssetUses_;
+
   // ======== Physical parameter data ========
 
   /**
@@ -901,6 +1601,11 @@ class ResourceManager {
    */
   AttrMgrs::StageAttributesManager::ptr stageAttributesManager_ = nullptr;
 
+  /**
+   * @brief Manages all construction and access to scene instance attributes.
+   */
+  AttrMgrs::SceneAttributesManager::ptr sceneAttributesManager_ = nullptr;
+
   //! tracks primitive mesh ids
   int nextPrimitiveMeshId = 0;
   /**
@@ -911,7 +1616,9 @@ class ResourceManager {
 
   /**
    * @brief Maps string keys (typically property filenames) to @ref
-   * CollisionMeshData for all components of a loaded asset.
+   * CollisionMeshData for all components of a loaded asset. The entries view
+   * the CPU data of the meshes in @ref meshes_, which the render meshes are
+   * uploaded from, so they are removed with the asset.
    */
   std::map<std::string, std::vector<CollisionMeshData>> collisionMeshGroups_;
 
@@ -919,6 +1626,90 @@ class ResourceManager {
    * @brief Flag to load textures of meshes
    */
   bool requiresTextures_ = true;
+
+  /**
+   * @brief Flag to draw objects instanced, see @ref
+   * setInstancedObjectRendering()
+   */
+  bool instancedObjectRendering_ = false;
+
+  /**
+   * @brief Flag to skip collision assets, see @ref setRenderOnly()
+   */
+  bool renderOnly_ = false;
+
+  /**
+   * @brief Flag to upload meshes in compact formats, see @ref
+   * setCompactVertexFormat()
+   */
+  bool compactVertexFormat_ = false;
+
+  //! see @ref setMeshArenaEnabled()
+  bool meshArenaEnabled_ = false;
+
+  //! see @ref setInstanceMeshCpuData()
+  InstanceMeshCpuData instanceMeshCpuData_ = InstanceMeshCpuData::All;
+
+  //! the shared buffers of the meshes, see @ref setMeshArenaEnabled()
+  MeshArena meshArena_;
+
+  //! see @ref setSemanticVertexIds()
+  bool semanticVertexIds_ = false;
+
+  //! see @ref stageHasSemanticVertexIds()
+  bool stageSemanticVertexIds_ = false;
+
+  //! coarser levels of detail of general meshes, see @ref setLevelsOfDetail()
+  int levelOfDetailCount_ = 0;
+
+  //! screen-space error of the levels of detail, in pixels
+  float levelOfDetailPixelError_ = 1.0f;
+
+  //! the largest textures packed, see @ref setTextureArraySize()
+  int textureArraySize_ = 0;
+
+  //! the texture arrays, see @ref setTextureArraySize()
+  gfx::TextureArrayPool textureArrayPool_;
+
+  /**
+   * @brief Per-instance buffers of meshes drawn by @ref
+   * gfx::InstancedDrawable, by index in @ref meshes_. Bound to the mesh once
+   * and shared by all instanced drawables of the mesh.
+   */
+  std::map<uint32_t, std::unique_ptr<Mn::GL::Buffer>> instanceBuffers_;
+
+  /**
+   * @brief Loaded stage assets by filename, see @ref
+   * setStageAssetCacheBudget()
+   */
+  std::map<std::string, CachedStageAsset> cachedStageAssets_;
+
+  //! number of @ref loadStage() calls, marks the use of stage assets
+  std::size_t stageLoadCount_ = 0;
+
+  //! CPU memory budget of the stage assets, 0 for no limit
+  std::size_t stageAssetCacheCpuBudget_ = 0;
+
+  //! GPU memory budget of the stage assets, 0 for no limit
+  std::size_t stageAssetCacheGpuBudget_ = 0;
+
+  //! whether PTex meshes stream their atlases, see @ref PTexAtlasCache
+  bool ptexAtlasStreaming_ = false;
+
+  //! GPU memory budget of the streamed PTex atlases, 0 for no limit
+  std::size_t ptexAtlasBudget_ = 0;
+
+  //! whether PTex meshes are drawn with the geometry shader
+  bool ptexGeometryShader_ = false;
+
+  //! directory of the transcoded Basis images, empty for no cache
+  std::string transcodeCacheDir_;
+
+  //! largest texture mip level uploaded, 0 for no limit
+  int maxTextureSize_ = 0;
+
+  //! see @ref getRegistryMutex()
+  mutable std::recursive_mutex registryMutex_;
 };
 
 }  // namespace assets
@@ -0,0 +1,791 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SceneCache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Corrade/Utility/String.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/PixelStorage.h>
+#include <Magnum/Sampler.h>
+#include <Magnum/Trade/MeshData.h>
+#include <Magnum/VertexFormat.h>
+
+#include "esp/core/esp.h"
+#include "esp/io/io.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+/**
+ * @brief Header of a scene cache file. It is followed by the meshes, the
+ * textures, the materials and the component hierarchy, each written by the
+ * matching function below.
+ */
+struct SceneCacheHeader {
+  char magic[4];
+  uint32_t version;
+  //! the files the cache was baked from, see @ref assetFilesStamp()
+  uint64_t assetStamp;
+  //! FNV-1a hash of the rest of the file
+  uint64_t payloadHash;
+  uint32_t meshCount;
+  uint32_t textureCount;
+  uint32_t materialCount;
+  uint32_t materialAttributeSize;
+};
+
+constexpr char SceneCacheMagic[4]{'H', 'S', 'C', 'N'};
+constexpr uint32_t SceneCacheVersion = 4;
+
+//! Header of a transcoded image cache file, followed by its mip levels
+struct TranscodedImageHeader {
+  char magic[4];
+  uint32_t version;
+};
+
+constexpr char TranscodedImageMagic[4]{'H', 'T', 'E', 'X'};
+constexpr uint32_t TranscodedImageVersion = 1;
+
+uint64_t hashBytes(Cr::Containers::ArrayView<const char> data) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const char byte : data) {
+    hash = (hash ^ static_cast<unsigned char>(byte)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+//! the files an asset is imported from: itself and, for a glTF, the
+//! external buffers and images its URIs refer to
+std::vector<std::string> assetFiles(const std::string& assetFile) {
+  std::vector<std::string> files{assetFile};
+  if (!Cr::Utility::String::endsWith(
+          Cr::Utility::String::lowercase(assetFile), ".gltf")) {
+    return files;
+  }
+  const std::string json = Cr::Utility::Directory::readString(assetFile);
+  const std::string directory = Cr::Utility::Directory::path(assetFile);
+  const std::string key = "\"uri\"";
+  for (std::size_t pos = json.find(key); pos != std::string::npos;
+       pos = json.find(key, pos)) {
+    pos = json.find_first_not_of(" \t\r\n:", pos + key.size());
+    if (pos == std::string::npos || json[pos] != '"') {
+      continue;
+    }
+    const std::size_t end = json.find('"', pos + 1);
+    if (end == std::string::npos) {
+      break;
+    }
+    const std::string uri = json.substr(pos + 1, end - pos - 1);
+    // embedded buffers change with the file itself
+    if (uri.compare(0, 5, "data:") != 0) {
+      files.push_back(Cr::Utility::Directory::join(directory, uri));
+    }
+    pos = end;
+  }
+  return files;
+}
+
+//! hash of the paths, sizes and modification times of the files of an
+//! asset, see @ref assetFiles()
+uint64_t assetFilesStamp(const std::string& assetFile) {
+  uint64_t hash = 14695981039346656037ull;
+  const auto add = [&](uint64_t value) {
+    for (int i = 0; i != 8; ++i) {
+      hash = (hash ^ ((value >> (8 * i)) & 0xff)) * 1099511628211ull;
+    }
+  };
+  for (const std::string& file : assetFiles(assetFile)) {
+    add(hashBytes(Cr::Containers::arrayView(file.data(), file.size())));
+    add(io::fileSize(file));
+    add(uint64_t(io::fileModificationTime(file)));
+  }
+  return hash;
+}
+
+//! the primitives, index types and vertex formats a cache holds. The values
+//! read are checked against them before they are handed to Magnum, whose
+//! size queries assert on unknown ones.
+bool isCachedPrimitive(Mn::UnsignedInt primitive) {
+  switch (Mn::MeshPrimitive(primitive)) {
+    case Mn::MeshPrimitive::Points:
+    case Mn::MeshPrimitive::Lines:
+    case Mn::MeshPrimitive::LineLoop:
+    case Mn::MeshPrimitive::LineStrip:
+    case Mn::MeshPrimitive::Triangles:
+    case Mn::MeshPrimitive::TriangleStrip:
+    case Mn::MeshPrimitive::TriangleFan:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool isCachedIndexType(Mn::UnsignedInt indexType) {
+  switch (Mn::MeshIndexType(indexType)) {
+    case Mn::MeshIndexType::UnsignedByte:
+    case Mn::MeshIndexType::UnsignedShort:
+    case Mn::MeshIndexType::UnsignedInt:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool isCachedVertexFormat(Mn::UnsignedInt format) {
+  using Mn::VertexFormat;
+  switch (VertexFormat(format)) {
+    // clang-format off
+    case VertexFormat::Float: case VertexFormat::Half:
+    case VertexFormat::UnsignedByte: case VertexFormat::UnsignedByteNormalized:
+    case VertexFormat::Byte: case VertexFormat::ByteNormalized:
+    case VertexFormat::UnsignedShort:
+    case VertexFormat::UnsignedShortNormalized:
+    case VertexFormat::Short: case VertexFormat::ShortNormalized:
+    case VertexFormat::UnsignedInt: case VertexFormat::Int:
+    case VertexFormat::Vector2: case VertexFormat::Vector2h:
+    case VertexFormat::Vector2ub: case VertexFormat::Vector2ubNormalized:
+    case VertexFormat::Vector2b: case VertexFormat::Vector2bNormalized:
+    case VertexFormat::Vector2us: case VertexFormat::Vector2usNormalized:
+    case VertexFormat::Vector2s: case VertexFormat::Vector2sNormalized:
+    case VertexFormat::Vector2ui: case VertexFormat::Vector2i:
+    case VertexFormat::Vector3: case VertexFormat::Vector3h:
+    case VertexFormat::Vector3ub: case VertexFormat::Vector3ubNormalized:
+    case VertexFormat::Vector3b: case VertexFormat::Vector3bNormalized:
+    case VertexFormat::Vector3us: case VertexFormat::Vector3usNormalized:
+    case VertexFormat::Vector3s: case VertexFormat::Vector3sNormalized:
+    case VertexFormat::Vector3ui: case VertexFormat::Vector3i:
+    case VertexFormat::Vector4: case VertexFormat::Vector4h:
+    case VertexFormat::Vector4ub: case VertexFormat::Vector4ubNormalized:
+    case VertexFormat::Vector4b: case VertexFormat::Vector4bNormalized:
+    case VertexFormat::Vector4us: case VertexFormat::Vector4usNormalized:
+    case VertexFormat::Vector4s: case VertexFormat::Vector4sNormalized:
+    case VertexFormat::Vector4ui: case VertexFormat::Vector4i:
+      // clang-format on
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool isCachedAttribute(Mn::UnsignedShort name) {
+  const Mn::Trade::MeshAttribute attribute{name};
+  switch (attribute) {
+    case Mn::Trade::MeshAttribute::Position:
+    case Mn::Trade::MeshAttribute::TextureCoordinates:
+    case Mn::Trade::MeshAttribute::Color:
+    case Mn::Trade::MeshAttribute::Normal:
+    case Mn::Trade::MeshAttribute::Tangent:
+    case Mn::Trade::MeshAttribute::Bitangent:
+    case Mn::Trade::MeshAttribute::ObjectId:
+      return true;
+    default:
+      return Mn::Trade::isMeshAttributeCustom(attribute);
+  }
+}
+
+//! Appends plain values and byte ranges to an in-memory file
+class Writer {
+ public:
+  template <typename T>
+  void write(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    writeBytes(&value, sizeof(T));
+  }
+
+  template <typename T>
+  void writeArray(Cr::Containers::ArrayView<const T> values) {
+    write<uint64_t>(values.size() * sizeof(T));
+    writeBytes(values.data(), values.size() * sizeof(T));
+  }
+
+  void writeBytes(const void* data, std::size_t size) {
+    data_.append(static_cast<const char*>(data), size);
+  }
+
+  const std::string& data() const { return data_; }
+
+ private:
+  std::string data_;
+};
+
+//! Reads values written by @ref Writer, failing on a truncated file
+class Reader {
+ public:
+  explicit Reader(Cr::Containers::ArrayView<const char> data) : data_{data} {}
+
+  template <typename T>
+  bool read(T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    return readBytes(&value, sizeof(T));
+  }
+
+  template <typename T>
+  bool readArray(Cr::Containers::Array<T>& values) {
+    uint64_t size = 0;
+    if (!read(size) || size % sizeof(T) != 0 || size > data_.size() - pos_) {
+      return false;
+    }
+    values = Cr::Containers::Array<T>{Cr::Containers::NoInit,
+                                      std::size_t(size / sizeof(T))};
+    return readBytes(values.data(), size);
+  }
+
+  //! skips an array written by @ref Writer::writeArray()
+  bool skipArray() {
+    uint64_t size = 0;
+    if (!read(size) || size > data_.size() - pos_) {
+      return false;
+    }
+    pos_ += size;
+    return true;
+  }
+
+  bool readBytes(void* data, std::size_t size) {
+    if (size > data_.size() - pos_) {
+      return false;
+    }
+    std::memcpy(data, data_.data() + pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+ private:
+  Cr::Containers::ArrayView<const char> data_;
+  std::size_t pos_ = 0;
+};
+
+bool writeMesh(Writer& writer, GenericMeshData& mesh) {
+  const Mn::Trade::MeshData& meshData = *mesh.getMeshData();
+  // the layouts readMesh() checks for
+  if (!isCachedPrimitive(Mn::UnsignedInt(meshData.primitive())) ||
+      (meshData.isIndexed() &&
+       !isCachedIndexType(Mn::UnsignedInt(meshData.indexType())))) {
+    LOG(ERROR) << "saveSceneCache : Cannot store a mesh of primitive "
+               << meshData.primitive();
+    return false;
+  }
+  for (Mn::UnsignedInt i = 0; i != meshData.attributeCount(); ++i) {
+    if (!isCachedAttribute(Mn::UnsignedShort(meshData.attributeName(i))) ||
+        !isCachedVertexFormat(Mn::UnsignedInt(meshData.attributeFormat(i))) ||
+        meshData.attributeStride(i) <= 0) {
+      LOG(ERROR) << "saveSceneCache : Cannot store mesh attribute "
+                 << meshData.attributeName(i) << " of format "
+                 << meshData.attributeFormat(i);
+      return false;
+    }
+  }
+  writer.write(Mn::UnsignedInt(meshData.primitive()));
+  writer.write(uint8_t(meshData.isIndexed()));
+  if (meshData.isIndexed()) {
+    writer.write(Mn::UnsignedInt(meshData.indexType()));
+    writer.write(uint64_t(meshData.indexOffset()));
+    writer.write(Mn::UnsignedInt(meshData.indexCount()));
+    writer.writeArray(meshData.indexData());
+  }
+  writer.write(Mn::UnsignedInt(meshData.vertexCount()));
+  writer.writeArray(meshData.vertexData());
+  writer.write(Mn::UnsignedInt(meshData.attributeCount()));
+  for (Mn::UnsignedInt i = 0; i != meshData.attributeCount(); ++i) {
+    writer.write(Mn::UnsignedShort(meshData.attributeName(i)));
+    writer.write(Mn::UnsignedInt(meshData.attributeFormat(i)));
+    writer.write(uint64_t(meshData.attributeOffset(i)));
+    writer.write(int64_t(meshData.attributeStride(i)));
+    writer.write(Mn::UnsignedShort(meshData.attributeArraySize(i)));
+  }
+  writer.write(mesh.BB);
+  const std::vector<GenericMeshData::LevelOfDetail>& levels =
+      mesh.getLevelsOfDetail();
+  writer.writeArray(Cr::Containers::arrayView(levels.data(), levels.size()));
+  const std::vector<Mn::UnsignedInt>& levelIndices =
+      mesh.getLevelOfDetailIndices();
+  writer.writeArray(
+      Cr::Containers::arrayView(levelIndices.data(), levelIndices.size()));
+  return true;
+}
+
+std::unique_ptr<GenericMeshData> readMesh(Reader& reader,
+                                          bool requiresLighting) {
+  // every value is range-checked before it sizes a view, so that a
+  // corrupt file fails instead of asserting in Magnum
+  Mn::UnsignedInt primitive = 0;
+  uint8_t isIndexed = 0;
+  if (!reader.read(primitive) || !reader.read(isIndexed) ||
+      !isCachedPrimitive(primitive)) {
+    return nullptr;
+  }
+
+  Mn::UnsignedInt indexType = 0;
+  uint64_t indexOffset = 0;
+  Mn::UnsignedInt indexCount = 0;
+  Cr::Containers::Array<char> indexData;
+  if (isIndexed &&
+      (!reader.read(indexType) || !reader.read(indexOffset) ||
+       !reader.read(indexCount) || !reader.readArray(indexData) ||
+       !isCachedIndexType(indexType) || indexOffset > indexData.size() ||
+       uint64_t(indexCount) *
+               Mn::meshIndexTypeSize(Mn::MeshIndexType(indexType)) >
+           indexData.size() - indexOffset)) {
+    return nullptr;
+  }
+
+  Mn::UnsignedInt vertexCount = 0;
+  Cr::Containers::Array<char> vertexData;
+  Mn::UnsignedInt attributeCount = 0;
+  if (!reader.read(vertexCount) || !reader.readArray(vertexData) ||
+      !reader.read(attributeCount)) {
+    return nullptr;
+  }
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      Cr::Containers::ValueInit, attributeCount};
+  for (Mn::UnsignedInt i = 0; i != attributeCount; ++i) {
+    Mn::UnsignedShort name = 0;
+    Mn::UnsignedInt format = 0;
+    uint64_t offset = 0;
+    int64_t stride = 0;
+    Mn::UnsignedShort arraySize = 0;
+    if (!reader.read(name) || !reader.read(format) || !reader.read(offset) ||
+        !reader.read(stride) || !reader.read(arraySize) ||
+        !isCachedAttribute(name) || !isCachedVertexFormat(format) ||
+        stride <= 0 ||
+        (arraySize != 0 &&
+         !Mn::Trade::isMeshAttributeCustom(Mn::Trade::MeshAttribute(name)))) {
+      return nullptr;
+    }
+    // the last vertex ends within the vertex data
+    const uint64_t attributeSize =
+        uint64_t(Mn::vertexFormatSize(Mn::VertexFormat(format))) *
+        std::max<uint64_t>(arraySize, 1);
+    if (vertexCount != 0 &&
+        (offset > vertexData.size() ||
+         uint64_t(vertexCount - 1) * uint64_t(stride) + attributeSize >
+             vertexData.size() - offset)) {
+      return nullptr;
+    }
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        Mn::Trade::MeshAttribute(name), Mn::VertexFormat(format),
+        std::size_t(offset), vertexCount, std::ptrdiff_t(stride), arraySize};
+  }
+
+  Mn::Range3D bb;
+  Cr::Containers::Array<GenericMeshData::LevelOfDetail> levels;
+  Cr::Containers::Array<Mn::UnsignedInt> levelIndices;
+  if (!reader.read(bb) || !reader.readArray(levels) ||
+      !reader.readArray(levelIndices)) {
+    return nullptr;
+  }
+  // the levels index into the full detail indices followed by levelIndices
+  const uint64_t uploadedIndexCount =
+      uint64_t(isIndexed ? indexCount : vertexCount) + levelIndices.size();
+  for (const GenericMeshData::LevelOfDetail& level : levels) {
+    if (uint64_t(level.indexOffset) + level.indexCount > uploadedIndexCount) {
+      return nullptr;
+    }
+  }
+
+  auto mesh = std::make_unique<GenericMeshData>(requiresLighting);
+  if (isIndexed) {
+    const Mn::Trade::MeshIndexData indices{
+        Mn::MeshIndexType(indexType),
+        Cr::Containers::arrayView(
+            indexData.data() + indexOffset,
+            indexCount * Mn::meshIndexTypeSize(Mn::MeshIndexType(indexType)))};
+    mesh->setMeshData(Mn::Trade::MeshData{
+        Mn::MeshPrimitive(primitive), std::move(indexData), indices,
+        std::move(vertexData), std::move(attributes), vertexCount});
+  } else {
+    mesh->setMeshData(Mn::Trade::MeshData{Mn::MeshPrimitive(primitive),
+                                          std::move(vertexData),
+                                          std::move(attributes), vertexCount});
+  }
+  // stored, so the positions are not scanned again
+  mesh->BB = bb;
+  mesh->setLevelsOfDetail({levels.begin(), levels.end()},
+                          {levelIndices.begin(), levelIndices.end()});
+  return mesh;
+}
+
+bool writeImages(Writer& writer,
+                 const std::vector<Mn::Trade::ImageData2D>& images) {
+  writer.write(Mn::UnsignedInt(images.size()));
+  for (const Mn::Trade::ImageData2D& image : images) {
+    writer.write(uint8_t(image.isCompressed()));
+    if (image.isCompressed()) {
+      writer.write(Mn::UnsignedInt(image.compressedFormat()));
+    } else {
+      // the pixel size of those would have to be stored as well
+      if (Mn::isPixelFormatImplementationSpecific(image.format())) {
+        LOG(ERROR) << "saveSceneCache : Cannot store images of an "
+                      "implementation-specific pixel format";
+        return false;
+      }
+      writer.write(Mn::UnsignedInt(image.format()));
+      writer.write(Mn::Int(image.storage().alignment()));
+    }
+    writer.write(image.size());
+    writer.writeArray(image.data());
+  }
+  return true;
+}
+
+bool readImages(Reader& reader,
+                std::vector<Mn::Trade::ImageData2D>& images,
+                bool readImageData) {
+  Mn::UnsignedInt levelCount = 0;
+  if (!reader.read(levelCount)) {
+    return false;
+  }
+  for (Mn::UnsignedInt level = 0; level != levelCount; ++level) {
+    uint8_t compressed = 0;
+    Mn::UnsignedInt format = 0;
+    Mn::Int alignment = 4;
+    Mn::Vector2i size;
+    Cr::Containers::Array<char> data;
+    if (!reader.read(compressed) || !reader.read(format) ||
+        (!compressed && !reader.read(alignment)) || !reader.read(size) ||
+        !(readImageData ? reader.readArray(data) : reader.skipArray())) {
+      return false;
+    }
+    if (!readImageData) {
+      continue;
+    }
+    if (size.x() < 0 || size.y() < 0) {
+      return false;
+    }
+    if (!compressed) {
+      // what the image constructor would assert on
+      if (format == 0 ||
+          format > Mn::UnsignedInt(Mn::PixelFormat::Depth32FStencil8UI) ||
+          (alignment != 1 && alignment != 2 && alignment != 4 &&
+           alignment != 8)) {
+        return false;
+      }
+      const uint64_t rowSize =
+          uint64_t(size.x()) * Mn::pixelSize(Mn::PixelFormat(format));
+      const uint64_t paddedRowSize =
+          (rowSize + alignment - 1) / alignment * alignment;
+      if (paddedRowSize * uint64_t(size.y()) > data.size()) {
+        return false;
+      }
+    }
+    if (compressed) {
+      images.emplace_back(Mn::CompressedPixelFormat(format), size,
+                          std::move(data));
+    } else {
+      images.emplace_back(Mn::PixelStorage{}.setAlignment(alignment),
+                          Mn::PixelFormat(format), size, std::move(data));
+    }
+  }
+  return true;
+}
+
+bool writeTexture(
+    Writer& writer,
+    const Cr::Containers::Optional<Mn::Trade::TextureData>& texture,
+    const std::vector<Mn::Trade::ImageData2D>& images) {
+  writer.write(uint8_t(bool(texture)));
+  if (!texture) {
+    return true;
+  }
+  writer.write(Mn::UnsignedInt(texture->type()));
+  writer.write(Mn::UnsignedInt(texture->minificationFilter()));
+  writer.write(Mn::UnsignedInt(texture->magnificationFilter()));
+  writer.write(Mn::UnsignedInt(texture->mipmapFilter()));
+  for (std::size_t i = 0; i != 3; ++i) {
+    writer.write(Mn::UnsignedInt(texture->wrapping()[i]));
+  }
+  writer.write(Mn::UnsignedInt(texture->image()));
+  return writeImages(writer, images);
+}
+
+bool readTexture(Reader& reader,
+                 Cr::Containers::Optional<Mn::Trade::TextureData>& texture,
+                 std::vector<Mn::Trade::ImageData2D>& images,
+                 bool readImageData) {
+  uint8_t valid = 0;
+  if (!reader.read(valid)) {
+    return false;
+  }
+  if (!valid) {
+    return true;
+  }
+
+  Mn::UnsignedInt type = 0, minification = 0, magnification = 0, mipmap = 0,
+                  image = 0;
+  Mn::UnsignedInt wrapping[3]{};
+  if (!reader.read(type) || !reader.read(minification) ||
+      !reader.read(magnification) || !reader.read(mipmap) ||
+      !reader.read(wrapping) || !reader.read(image)) {
+    return false;
+  }
+  texture = Mn::Trade::TextureData{
+      Mn::Trade::TextureData::Type(type),
+      Mn::SamplerFilter(minification),
+      Mn::SamplerFilter(magnification),
+      Mn::SamplerMipmap(mipmap),
+      {Mn::SamplerWrapping(wrapping[0]), Mn::SamplerWrapping(wrapping[1]),
+       Mn::SamplerWrapping(wrapping[2])},
+      image};
+  return readImages(reader, images, readImageData);
+}
+
+bool writeMaterial(
+    Writer& writer,
+    const Cr::Containers::Optional<Mn::Trade::MaterialData>& material) {
+  writer.write(uint8_t(bool(material)));
+  if (!material) {
+    return true;
+  }
+  // the attributes hold their values inline, except for pointers
+  for (Mn::UnsignedInt i = 0; i != material->attributeCount(); ++i) {
+    const Mn::Trade::MaterialAttributeType type = material->attributeType(i);
+    if (type == Mn::Trade::MaterialAttributeType::Pointer ||
+        type == Mn::Trade::MaterialAttributeType::MutablePointer) {
+      LOG(ERROR) << "saveSceneCache : Cannot store pointer material "
+                    "attribute "
+                 << material->attributeName(i);
+      return false;
+    }
+  }
+  writer.write(Mn::UnsignedInt(material->types()));
+  writer.writeArray(material->attributeData());
+  return true;
+}
+
+bool readMaterial(Reader& reader,
+                  Cr::Containers::Optional<Mn::Trade::MaterialData>& material) {
+  uint8_t valid = 0;
+  if (!reader.read(valid)) {
+    return false;
+  }
+  if (!valid) {
+    return true;
+  }
+  Mn::UnsignedInt types = 0;
+  Cr::Containers::Array<Mn::Trade::MaterialAttributeData> attributes;
+  if (!reader.read(types) || !reader.readArray(attributes)) {
+    return false;
+  }
+  material = Mn::Trade::MaterialData{Mn::Trade::MaterialType(types),
+                                     std::move(attributes)};
+  return true;
+}
+
+void writeNode(Writer& writer, const MeshTransformNode& node) {
+  writer.write(int32_t(node.meshIDLocal));
+  writer.write(int32_t(node.materialIDLocal));
+  writer.write(int32_t(node.componentID));
+  writer.write(node.transformFromLocalToParent);
+  writer.write(Mn::UnsignedInt(node.children.size()));
+  for (const MeshTransformNode& child : node.children) {
+    writeNode(writer, child);
+  }
+}
+
+bool readNode(Reader& reader, MeshTransformNode& node) {
+  int32_t meshIDLocal = 0, materialIDLocal = 0, componentID = 0;
+  Mn::UnsignedInt childCount = 0;
+  if (!reader.read(meshIDLocal) || !reader.read(materialIDLocal) ||
+      !reader.read(componentID) ||
+      !reader.read(node.transformFromLocalToParent) ||
+      !reader.read(childCount)) {
+    return false;
+  }
+  node.meshIDLocal = meshIDLocal;
+  node.materialIDLocal = materialIDLocal;
+  node.componentID = componentID;
+  for (Mn::UnsignedInt i = 0; i != childCount; ++i) {
+    node.children.emplace_back();
+    if (!readNode(reader, node.children.back())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+std::string sceneCacheFilename(const std::string& assetFile) {
+  return assetFile + ".scene_cache";
+}
+
+bool saveSceneCache(const DecodedAssetData& decodedAssetData,
+                    const std::string& cacheFile) {
+  CHECK(decodedAssetData.requiresTextures);
+
+  SceneCacheHeader header{};
+  std::memcpy(header.magic, SceneCacheMagic, sizeof(SceneCacheMagic));
+  header.version = SceneCacheVersion;
+  header.assetStamp = assetFilesStamp(decodedAssetData.assetInfo.filepath);
+  header.meshCount = decodedAssetData.meshes.size();
+  header.textureCount = decodedAssetData.textures.size();
+  header.materialCount = decodedAssetData.materials.size();
+  header.materialAttributeSize = sizeof(Mn::Trade::MaterialAttributeData);
+
+  Writer writer;
+  for (const std::unique_ptr<GenericMeshData>& mesh : decodedAssetData.meshes) {
+    if (!writeMesh(writer, *mesh)) {
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i != decodedAssetData.textures.size(); ++i) {
+    if (!writeTexture(writer, decodedAssetData.textures[i],
+                      decodedAssetData.textureImages[i])) {
+      return false;
+    }
+  }
+  for (const auto& material : decodedAssetData.materials) {
+    if (!writeMaterial(writer, material)) {
+      return false;
+    }
+  }
+  writeNode(writer, decodedAssetData.root);
+  header.payloadHash = hashBytes(
+      Cr::Containers::arrayView(writer.data().data(), writer.data().size()));
+
+  std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+  data += writer.data();
+  if (!io::writeFileAtomically(cacheFile, data)) {
+    LOG(ERROR) << "saveSceneCache : Cannot write " << cacheFile;
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr<DecodedAssetData> loadSceneCache(const std::string& cacheFile,
+                                                 const AssetInfo& info,
+                                                 bool requiresTextures) {
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      mapped = Cr::Utility::Directory::mapRead(cacheFile);
+  if (!mapped) {
+    return nullptr;
+  }
+  Reader reader{mapped};
+
+  // a truncated or corrupt file fails the hash before any value is used
+  SceneCacheHeader header{};
+  if (!reader.read(header) ||
+      std::memcmp(header.magic, SceneCacheMagic, sizeof(SceneCacheMagic)) !=
+          0 ||
+      header.version != SceneCacheVersion ||
+      header.materialAttributeSize !=
+          sizeof(Mn::Trade::MaterialAttributeData) ||
+      header.assetStamp != assetFilesStamp(info.filepath) ||
+      header.payloadHash != hashBytes(mapped.suffix(sizeof(header)))) {
+    return nullptr;
+  }
+
+  auto decodedAssetData = std::make_unique<DecodedAssetData>();
+  decodedAssetData->assetInfo = info;
+  decodedAssetData->requiresTextures = requiresTextures;
+
+  for (uint32_t i = 0; i != header.meshCount; ++i) {
+    std::unique_ptr<GenericMeshData> mesh =
+        readMesh(reader, info.requiresLighting);
+    if (!mesh) {
+      return nullptr;
+    }
+    decodedAssetData->meshes.push_back(std::move(mesh));
+  }
+
+  // the images are skipped if not needed, the materials refer to the textures
+  decodedAssetData->textures.resize(header.textureCount);
+  decodedAssetData->textureImages.resize(header.textureCount);
+  for (uint32_t i = 0; i != header.textureCount; ++i) {
+    if (!readTexture(reader, decodedAssetData->textures[i],
+                     decodedAssetData->textureImages[i], requiresTextures)) {
+      return nullptr;
+    }
+  }
+  decodedAssetData->materials.resize(header.materialCount);
+  for (uint32_t i = 0; i != header.materialCount; ++i) {
+    if (!readMaterial(reader, decodedAssetData->materials[i])) {
+      return nullptr;
+    }
+  }
+
+  if (!readNode(reader, decodedAssetData->root)) {
+    return nullptr;
+  }
+  return decodedAssetData;
+}
+
+uint64_t fileContentHash(const std::string& file) {
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      mapped = Cr::Utility::Directory::mapRead(file);
+  if (!mapped) {
+    return 0;
+  }
+  return hashBytes(mapped);
+}
+
+std::string transcodedImageCacheFilename(const std::string& cacheDir,
+                                         uint64_t assetHash,
+                                         const std::string& format,
+                                         unsigned int image) {
+  return Cr::Utility::Directory::join(
+      cacheDir, Cr::Utility::formatString("{:.16x}-{}-{}.transcoded",
+                                          assetHash, format, image));
+}
+
+bool saveTranscodedImage(const std::vector<Mn::Trade::ImageData2D>& levels,
+                         const std::string& cacheFile) {
+  TranscodedImageHeader header{};
+  std::memcpy(header.magic, TranscodedImageMagic,
+              sizeof(TranscodedImageMagic));
+  header.version = TranscodedImageVersion;
+
+  Writer writer;
+  writer.write(header);
+  if (!writeImages(writer, levels)) {
+    return false;
+  }
+  if (!io::writeFileAtomically(cacheFile, writer.data())) {
+    LOG(ERROR) << "saveTranscodedImage : Cannot write " << cacheFile;
+    return false;
+  }
+  return true;
+}
+
+bool loadTranscodedImage(const std::string& cacheFile,
+                         std::vector<Mn::Trade::ImageData2D>& levels) {
+  levels.clear();
+  if (!Cr::Utility::Directory::exists(cacheFile)) {
+    return false;
+  }
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      mapped = Cr::Utility::Directory::mapRead(cacheFile);
+  if (!mapped) {
+    return false;
+  }
+  Reader reader{mapped};
+
+  TranscodedImageHeader header{};
+  if (!reader.read(header) ||
+      std::memcmp(header.magic, TranscodedImageMagic,
+                  sizeof(TranscodedImageMagic)) != 0 ||
+      header.version != TranscodedImageVersion ||
+      !readImages(reader, levels, true) || levels.empty()) {
+    levels.clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,126 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_SCENECACHE_H_
+#define ESP_ASSETS_SCENECACHE_H_
+
+/** @file
+ * @brief Struct @ref esp::assets::DecodedAssetData, functions @ref
+ * esp::assets::saveSceneCache(), @ref esp::assets::loadSceneCache(), @ref
+ * esp::assets::saveTranscodedImage(), @ref esp::assets::loadTranscodedImage()
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Corrade/Containers/Optional.h>
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MaterialData.h>
+#include <Magnum/Trade/TextureData.h>
+
+#include "Asset.h"
+#include "GenericMeshData.h"
+#include "MeshMetaData.h"
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief CPU-side contents of a general mesh asset file, decoded on any thread
+ * and uploaded by @ref ResourceManager::loadGeneralMeshData() on the thread
+ * owning the GL context.
+ */
+struct DecodedAssetData {
+  AssetInfo assetInfo;
+  //! whether the texture images were decoded, the textures and materials
+  //! always are, see @ref ResourceManager::setRequiresTextures()
+  bool requiresTextures = true;
+  //! meshes with their collision data and bounding boxes, not uploaded yet
+  std::vector<std::unique_ptr<GenericMeshData>> meshes;
+  //! textures, NullOpt if a texture or one of its images failed to import
+  std::vector<Corrade::Containers::Optional<Magnum::Trade::TextureData>>
+      textures;
+  //! all mip levels of the image of each texture, empty if not decoded
+  std::vector<std::vector<Magnum::Trade::ImageData2D>> textureImages;
+  std::vector<Corrade::Containers::Optional<Magnum::Trade::MaterialData>>
+      materials;
+  //! the component hierarchy, with local mesh and material ids
+  MeshTransformNode root;
+};
+
+/**
+ * @brief The scene cache file @ref ResourceManager looks for next to an asset
+ */
+std::string sceneCacheFilename(const std::string& assetFile);
+
+/**
+ * @brief Write a decoded asset into a scene cache file.
+ *
+ * The file holds the interleaved vertex and index data of the meshes with
+ * their bounding boxes and levels of detail, the texture images as imported,
+ * including compressed ones, the materials and the component hierarchy, so
+ * that loading it skips the importers. The file is read from a memory map and
+ * each array is copied out of it. The sizes and modification times of the
+ * asset and, for a glTF, of the buffers and images it refers to are recorded
+ * to detect an outdated cache, and a hash of the contents to detect a
+ * corrupt one. The layout is native, caches are not portable between
+ * architectures.
+ * @param decodedAssetData The asset, decoded with textures
+ * @param cacheFile The file to write
+ * @return false if the asset has data a cache cannot hold, such as pointer
+ * material attributes, or the file cannot be written
+ */
+bool saveSceneCache(const DecodedAssetData& decodedAssetData,
+                    const std::string& cacheFile);
+
+/**
+ * @brief Read a scene cache file written by @ref saveSceneCache()
+ *
+ * @param cacheFile The file to read
+ * @param info The asset the cache is for
+ * @param requiresTextures Whether the texture images are needed
+ * @return The decoded asset, nullptr if the file is invalid, of a different
+ * version or outdated
+ */
+std::unique_ptr<DecodedAssetData> loadSceneCache(const std::string& cacheFile,
+                                                 const AssetInfo& info,
+                                                 bool requiresTextures);
+
+/**
+ * @brief FNV-1a hash of the contents of a file, 0 if it cannot be read
+ */
+uint64_t fileContentHash(const std::string& file);
+
+/**
+ * @brief The file in @p cacheDir caching the mip levels of image @p image of
+ * the asset of contents hash @p assetHash, transcoded to @p format
+ */
+std::string transcodedImageCacheFilename(const std::string& cacheDir,
+                                         uint64_t assetHash,
+                                         const std::string& format,
+                                         unsigned int image);
+
+/**
+ * @brief Write the mip levels of a transcoded image into a cache file, in the
+ * same layout as the images of a scene cache
+ * @return false if the file cannot be written
+ */
+bool saveTranscodedImage(const std::vector<Magnum::Trade::ImageData2D>& levels,
+                         const std::string& cacheFile);
+
+/**
+ * @brief Read a cache file written by @ref saveTranscodedImage()
+ * @param cacheFile The file to read
+ * @param[out] levels The mip levels, left empty on failure
+ * @return false if the file is missing, invalid or of a different version
+ */
+bool loadTranscodedImage(const std::string& cacheFile,
+                         std::vector<Magnum::Trade::ImageData2D>& levels);
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_SCENECACHE_H_
@@ -0,0 +1,334 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "StageStreamer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/String.h>
+#include <Magnum/Math/Functions.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include "ResourceManager.h"
+#include "esp/core/Profiling.h"
+#include "esp/io/io.h"
+#include "esp/io/json.h"
+#include "esp/nav/PathFinder.h"
+#include "esp/physics/PhysicsManager.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+bool loadStageChunks(const std::string& filename,
+                     std::vector<StageChunk>& chunks) {
+  if (!io::exists(filename)) {
+    return false;
+  }
+  io::JsonDocument json;
+  try {
+    json = io::parseJsonFile(filename);
+  } catch (...) {
+    LOG(ERROR) << "loadStageChunks : Failed to parse " << filename;
+    return false;
+  }
+  if (!json.IsObject() || !json.HasMember("chunks") ||
+      !json["chunks"].IsArray()) {
+    LOG(ERROR) << "loadStageChunks : " << filename
+               << " has no \"chunks\" array";
+    return false;
+  }
+
+  const std::string directory = Cr::Utility::Directory::path(filename);
+  std::vector<StageChunk> loaded;
+  for (const auto& value : json["chunks"].GetArray()) {
+    StageChunk chunk;
+    Mn::Vector3 min, max;
+    if (!value.IsObject() || !value.HasMember("render_asset") ||
+        !value.HasMember("aabb_min") || !value.HasMember("aabb_max") ||
+        !io::jsonValueIntoVal(value["render_asset"], "render_asset",
+                              chunk.renderAsset) ||
+        !io::jsonValueIntoVal(value["aabb_min"], "aabb_min", min) ||
+        !io::jsonValueIntoVal(value["aabb_max"], "aabb_max", max)) {
+      LOG(ERROR) << "loadStageChunks : Invalid chunk " << loaded.size()
+                 << " in " << filename;
+      return false;
+    }
+    if (value.HasMember("collision_asset") &&
+        !io::jsonValueIntoVal(value["collision_asset"], "collision_asset",
+                              chunk.collisionAsset)) {
+      return false;
+    }
+    chunk.renderAsset =
+        Cr::Utility::Directory::join(directory, chunk.renderAsset);
+    if (!chunk.collisionAsset.empty()) {
+      chunk.collisionAsset =
+          Cr::Utility::Directory::join(directory, chunk.collisionAsset);
+    }
+    chunk.bounds = Mn::Range3D{min, max};
+    loaded.push_back(std::move(chunk));
+  }
+  chunks = std::move(loaded);
+  return true;
+}
+
+bool saveStageChunks(const std::string& filename,
+                     const std::vector<StageChunk>& chunks) {
+  // paths under the directory of the manifest are written relative to it
+  const std::string directory = Cr::Utility::Directory::path(filename);
+  const auto relative = [&](const std::string& path) {
+    if (!directory.empty() &&
+        Cr::Utility::String::beginsWith(path, directory + "/")) {
+      return path.substr(directory.size() + 1);
+    }
+    return path;
+  };
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer{buffer};
+  writer.StartObject();
+  writer.Key("chunks");
+  writer.StartArray();
+  for (const StageChunk& chunk : chunks) {
+    writer.StartObject();
+    writer.Key("render_asset");
+    writer.String(relative(chunk.renderAsset).c_str());
+    if (!chunk.collisionAsset.empty()) {
+      writer.Key("collision_asset");
+      writer.String(relative(chunk.collisionAsset).c_str());
+    }
+    writer.Key("aabb_min");
+    writer.StartArray();
+    for (int i = 0; i < 3; ++i) {
+      writer.Double(chunk.bounds.min()[i]);
+    }
+    writer.EndArray();
+    writer.Key("aabb_max");
+    writer.StartArray();
+    for (int i = 0; i < 3; ++i) {
+      writer.Double(chunk.bounds.max()[i]);
+    }
+    writer.EndArray();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+
+  if (!Cr::Utility::Directory::writeString(filename, buffer.GetString())) {
+    LOG(ERROR) << "saveStageChunks : Failed to write " << filename;
+    return false;
+  }
+  return true;
+}
+
+StageStreamer::StageStreamer(
+    ResourceManager& resourceManager,
+    std::vector<StageChunk> chunks,
+    const AssetInfo& stageInfo,
+    scene::SceneNode& parent,
+    gfx::DrawableGroup& drawables,
+    std::shared_ptr<physics::PhysicsManager> physicsManager,
+    std::shared_ptr<nav::PathFinder> pathfinder,
+    const Configuration& configuration,
+    const Mn::ResourceKey& lightSetup)
+    : resourceManager_{resourceManager},
+      stageInfo_{stageInfo},
+      parent_{parent},
+      drawables_{drawables},
+      physicsManager_{std::move(physicsManager)},
+      pathfinder_{std::move(pathfinder)},
+      configuration_{configuration},
+      lightSetup_{lightSetup} {
+  // the evict radius has to contain the load radius, or a chunk would be
+  // evicted as soon as it is loaded
+  configuration_.evictRadius =
+      std::max(configuration_.evictRadius, configuration_.loadRadius);
+  chunks_.reserve(chunks.size());
+  for (StageChunk& chunk : chunks) {
+    chunks_.emplace_back();
+    chunks_.back().chunk = std::move(chunk);
+  }
+}
+
+StageStreamer::~StageStreamer() {
+  for (Chunk& chunk : chunks_) {
+    if (chunk.state == State::Resident) {
+      evict(chunk);
+    } else if (chunk.state == State::Loading) {
+      discardPrefetch(chunk);
+    }
+  }
+}
+
+AssetInfo StageStreamer::chunkInfo(const std::string& filename,
+                                   bool requiresLighting) const {
+  AssetInfo info;
+  info.type = AssetType::UNKNOWN;
+  info.filepath = filename;
+  info.frame = stageInfo_.frame;
+  info.virtualUnitToMeters = stageInfo_.virtualUnitToMeters;
+  info.requiresLighting = requiresLighting;
+  return info;
+}
+
+float StageStreamer::distance(const Chunk& chunk,
+                              const std::vector<Mn::Vector3>& positions) {
+  float nearest = Mn::Constants::inf();
+  const Mn::Range3D& bounds = chunk.chunk.bounds;
+  for (const Mn::Vector3& position : positions) {
+    const Mn::Vector3 closest =
+        Mn::Math::clamp(position, bounds.min(), bounds.max());
+    nearest = std::min(nearest, (position - closest).length());
+  }
+  return nearest;
+}
+
+void StageStreamer::prefetch(Chunk& chunk) {
+  const StageChunk& stageChunk = chunk.chunk;
+  resourceManager_.prefetchAsset(
+      chunkInfo(stageChunk.renderAsset, stageInfo_.requiresLighting));
+  if (physicsManager_ && !stageChunk.collisionAsset.empty()) {
+    resourceManager_.prefetchAsset(chunkInfo(stageChunk.collisionAsset, false));
+  }
+  chunk.state = State::Loading;
+}
+
+bool StageStreamer::isPrefetching(const Chunk& chunk) const {
+  const StageChunk& stageChunk = chunk.chunk;
+  return resourceManager_.isAssetPrefetching(stageChunk.renderAsset) ||
+         (physicsManager_ && !stageChunk.collisionAsset.empty() &&
+          resourceManager_.isAssetPrefetching(stageChunk.collisionAsset));
+}
+
+void StageStreamer::discardPrefetch(Chunk& chunk) {
+  const StageChunk& stageChunk = chunk.chunk;
+  resourceManager_.discardPrefetchedAsset(stageChunk.renderAsset);
+  if (physicsManager_ && !stageChunk.collisionAsset.empty()) {
+    resourceManager_.discardPrefetchedAsset(stageChunk.collisionAsset);
+  }
+  chunk.state = State::Evicted;
+}
+
+void StageStreamer::instantiate(Chunk& chunk) {
+  const StageChunk& stageChunk = chunk.chunk;
+  const bool separateCollision = !stageChunk.collisionAsset.empty();
+  chunk.node = &parent_.createChild();
+  if (resourceManager_.loadStreamedAsset(
+          chunkInfo(stageChunk.renderAsset, stageInfo_.requiresLighting),
+          chunk.node, &drawables_, physicsManager_ && !separateCollision,
+          lightSetup_)) {
+    chunk.assets.push_back(stageChunk.renderAsset);
+  } else {
+    LOG(ERROR) << "StageStreamer::instantiate : Failed to load "
+               << stageChunk.renderAsset;
+  }
+
+  if (physicsManager_) {
+    const std::string& collisionAsset =
+        separateCollision ? stageChunk.collisionAsset : stageChunk.renderAsset;
+    if (separateCollision &&
+        resourceManager_.loadStreamedAsset(chunkInfo(collisionAsset, false),
+                                           nullptr, nullptr, true)) {
+      chunk.assets.push_back(collisionAsset);
+    }
+    chunk.collisionId = physicsManager_->addStageChunk(collisionAsset);
+  }
+  chunk.state = State::Resident;
+}
+
+void StageStreamer::evict(Chunk& chunk) {
+  // the drawables go with the node, before their meshes are released
+  delete chunk.node;
+  chunk.node = nullptr;
+  if (physicsManager_ && chunk.collisionId != ID_UNDEFINED) {
+    physicsManager_->removeStageChunk(chunk.collisionId);
+  }
+  chunk.collisionId = ID_UNDEFINED;
+  for (const std::string& asset : chunk.assets) {
+    resourceManager_.releaseStreamedAsset(asset);
+  }
+  chunk.assets.clear();
+  chunk.state = State::Evicted;
+}
+
+void StageStreamer::update(const std::vector<Mn::Vector3>& positions,
+                           bool wait) {
+  core::ScopedTraceEvent trace{"StageStreamer::update", "assets"};
+  int numLoads = 0;
+  for (Chunk& chunk : chunks_) {
+    const float chunkDistance = distance(chunk, positions);
+    switch (chunk.state) {
+      case State::Evicted:
+        if (chunkDistance <= configuration_.loadRadius) {
+          prefetch(chunk);
+        }
+        break;
+      case State::Resident:
+        if (chunkDistance > configuration_.evictRadius) {
+          evict(chunk);
+        }
+        break;
+      case State::Loading:
+        break;
+    }
+  }
+
+  // instantiate the decoded chunks, the nearest first, after all prefetches
+  // have been started so that the decodes overlap the waits
+  std::vector<std::pair<float, Chunk*>> decoded;
+  for (Chunk& chunk : chunks_) {
+    if (chunk.state == State::Loading && (wait || !isPrefetching(chunk))) {
+      decoded.emplace_back(distance(chunk, positions), &chunk);
+    }
+  }
+  std::sort(decoded.begin(), decoded.end(),
+            [](const std::pair<float, Chunk*>& a,
+               const std::pair<float, Chunk*>& b) {
+              return a.first < b.first;
+            });
+  for (const auto& entry : decoded) {
+    Chunk& chunk = *entry.second;
+    if (entry.first > configuration_.evictRadius) {
+      // the agents moved away while it was decoded
+      discardPrefetch(chunk);
+    } else if (wait || numLoads < configuration_.maxLoadsPerUpdate) {
+      instantiate(chunk);
+      ++numLoads;
+    }
+  }
+
+  if (pathfinder_ && pathfinder_->isLoaded()) {
+    std::vector<vec3f> points;
+    points.reserve(positions.size());
+    for (const Mn::Vector3& position : positions) {
+      points.emplace_back(position.x(), position.y(), position.z());
+    }
+    pathfinder_->streamTiles(points, configuration_.evictRadius);
+  }
+}
+
+bool StageStreamer::isChunkResident(int chunk) const {
+  return chunk >= 0 && chunk < int(chunks_.size()) &&
+         chunks_[chunk].state == State::Resident;
+}
+
+int StageStreamer::getNumResidentChunks() const {
+  return std::count_if(chunks_.begin(), chunks_.end(), [](const Chunk& c) {
+    return c.state == State::Resident;
+  });
+}
+
+int StageStreamer::getNumLoadingChunks() const {
+  return std::count_if(chunks_.begin(), chunks_.end(), [](const Chunk& c) {
+    return c.state == State::Loading;
+  });
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,201 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_STAGESTREAMER_H_
+#define ESP_ASSETS_STAGESTREAMER_H_
+
+/** @file
+ * @brief Class @ref esp::assets::StageStreamer, struct @ref
+ * esp::assets::StageChunk
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Magnum/Math/Range.h>
+#include <Magnum/Resource.h>
+
+#include "Asset.h"
+#include "esp/core/esp.h"
+#include "esp/gfx/DrawableGroup.h"
+#include "esp/scene/SceneNode.h"
+
+namespace esp {
+namespace nav {
+class PathFinder;
+}
+namespace physics {
+class PhysicsManager;
+}
+namespace assets {
+
+class ResourceManager;
+
+/**
+ * @brief A spatial chunk of a streamed stage, see @ref StageStreamer
+ */
+struct StageChunk {
+  //! The render asset of the chunk
+  std::string renderAsset;
+  //! The collision asset of the chunk, the render asset if empty
+  std::string collisionAsset;
+  //! The bounds of the chunk in world space
+  Magnum::Range3D bounds;
+};
+
+/**
+ * @brief Load the chunks of a streamed stage from a manifest.
+ *
+ * The manifest is a JSON file next to the stage asset, named like it with
+ * the extension `.chunks.json`:
+ *
+ * @code{.json}
+ * {"chunks": [{"render_asset": "chunk_0_0.glb",
+ *              "collision_asset": "chunk_0_0_collision.glb",
+ *              "aabb_min": [0, -1, 0], "aabb_max": [16, 4, 16]}]}
+ * @endcode
+ *
+ * The assets are relative to the manifest, `collision_asset` is optional.
+ * @return Whether the manifest was read
+ */
+bool loadStageChunks(const std::string& filename,
+                     std::vector<StageChunk>& chunks);
+
+/**
+ * @brief Write the chunks of a streamed stage to a manifest, see @ref
+ * loadStageChunks(). The assets are written relative to the manifest.
+ * @return Whether the manifest was written
+ */
+bool saveStageChunks(const std::string& filename,
+                     const std::vector<StageChunk>& chunks);
+
+/**
+ * @brief Keeps the chunks of a stage too large to be resident as a whole
+ * loaded around the agents.
+ *
+ * The chunks within @ref Configuration::loadRadius of an agent are decoded on
+ * worker threads with @ref ResourceManager::prefetchAsset(), then
+ * instantiated for drawing under the stage and added to the static collision
+ * of the @ref physics::PhysicsManager once decoded. The chunks farther than
+ * @ref Configuration::evictRadius from all agents are removed and their
+ * assets released, and so are the navmesh tiles, which are compressed in
+ * memory by @ref nav::PathFinder::streamTiles(). The radii differ so that an
+ * agent walking along a chunk boundary doesn't load and evict it each step.
+ */
+class StageStreamer {
+ public:
+  /** @brief Streaming configuration */
+  struct Configuration {
+    //! Distance to an agent within which chunks are loaded
+    float loadRadius = 20.0f;
+    //! Distance to all agents beyond which chunks are evicted
+    float evictRadius = 30.0f;
+    //! The most chunks instantiated by an update, to bound its stall
+    int maxLoadsPerUpdate = 1;
+  };
+
+  /**
+   * @brief Constructor
+   * @param resourceManager The resource manager to load the chunks with
+   * @param chunks The chunks of the stage
+   * @param stageInfo The asset of the stage, its frame, units and lighting
+   * are used for the chunks
+   * @param parent The node to instantiate the chunks under
+   * @param drawables The drawable group of @p parent
+   * @param physicsManager The physics manager to add the collision of the
+   * chunks to, nullptr for none
+   * @param pathfinder The pathfinder whose tiles to stream, may be nullptr
+   * @param configuration The streaming configuration
+   * @param lightSetup The light setup to draw the chunks with
+   */
+  StageStreamer(ResourceManager& resourceManager,
+                std::vector<StageChunk> chunks,
+                const AssetInfo& stageInfo,
+                scene::SceneNode& parent,
+                gfx::DrawableGroup& drawables,
+                std::shared_ptr<physics::PhysicsManager> physicsManager,
+                std::shared_ptr<nav::PathFinder> pathfinder,
+                const Configuration& configuration,
+                const Magnum::ResourceKey& lightSetup);
+
+  /** @brief Evicts all chunks and drops the ones being decoded */
+  ~StageStreamer();
+
+  /**
+   * @brief Load and evict chunks and navmesh tiles around the agents.
+   * @param positions The positions of the agents
+   * @param wait Whether to wait for all chunks within the load radius to be
+   * loaded, e.g. on a reset, instead of instantiating the decoded ones only
+   */
+  void update(const std::vector<Magnum::Vector3>& positions,
+              bool wait = false);
+
+  /** @brief The number of chunks of the stage */
+  int getNumChunks() const { return chunks_.size(); }
+
+  /** @brief Whether chunk @p chunk is instantiated */
+  bool isChunkResident(int chunk) const;
+
+  /** @brief The number of instantiated chunks */
+  int getNumResidentChunks() const;
+
+  /** @brief The number of chunks being decoded */
+  int getNumLoadingChunks() const;
+
+  /** @brief Set the pathfinder whose tiles to stream, may be nullptr */
+  void setPathFinder(std::shared_ptr<nav::PathFinder> pathfinder) {
+    pathfinder_ = std::move(pathfinder);
+  }
+
+  /** @brief The streaming configuration */
+  const Configuration& getConfiguration() const { return configuration_; }
+
+ private:
+  enum class State { Evicted, Loading, Resident };
+
+  struct Chunk {
+    StageChunk chunk;
+    State state = State::Evicted;
+    scene::SceneNode* node = nullptr;
+    int collisionId = ID_UNDEFINED;
+    //! the assets loaded for the chunk, a use of each is released on evict
+    std::vector<std::string> assets;
+  };
+
+  //! the asset of @p filename of a chunk
+  AssetInfo chunkInfo(const std::string& filename,
+                      bool requiresLighting) const;
+  //! the distance of @p chunk to the nearest of @p positions
+  static float distance(const Chunk& chunk,
+                        const std::vector<Magnum::Vector3>& positions);
+  //! start decoding the assets of @p chunk
+  void prefetch(Chunk& chunk);
+  //! whether the assets of @p chunk are still being decoded
+  bool isPrefetching(const Chunk& chunk) const;
+  //! drop the decoded assets of @p chunk without instantiating it
+  void discardPrefetch(Chunk& chunk);
+  //! instantiate the decoded @p chunk
+  void instantiate(Chunk& chunk);
+  //! remove @p chunk and release its assets
+  void evict(Chunk& chunk);
+
+  ResourceManager& resourceManager_;
+  std::vector<Chunk> chunks_;
+  AssetInfo stageInfo_;
+  scene::SceneNode& parent_;
+  gfx::DrawableGroup& drawables_;
+  std::shared_ptr<physics::PhysicsManager> physicsManager_;
+  std::shared_ptr<nav::PathFinder> pathfinder_;
+  Configuration configuration_;
+  Magnum::ResourceKey lightSetup_;
+
+  ESP_SMART_POINTERS(StageStreamer)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_STAGESTREAMER_H_
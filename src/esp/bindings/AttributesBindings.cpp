@@ -182,6 +182,20 @@ void initAttributesBindings(py::module& m) {
           &ObjectAttributes::setAngularDamping,
           R"(The damping of angular velocity for objects constructed from
           this template.)")
+      .def_property(
+          "linear_sleeping_threshold",
+          &ObjectAttributes::getLinearSleepingThreshold,
+          &ObjectAttributes::setLinearSleepingThreshold,
+          R"(The linear speed below which objects constructed from this
+          template may fall asleep. Negative to use the one of the physics
+          manager.)")
+      .def_property(
+          "angular_sleeping_threshold",
+          &ObjectAttributes::getAngularSleepingThreshold,
+          &ObjectAttributes::setAngularSleepingThreshold,
+          R"(The angular speed below which objects constructed from this
+          template may fall asleep. Negative to use the one of the physics
+          manager.)")
       .def_property("bounding_box_collisions",
                     &ObjectAttributes::getBoundingBoxCollisions,
                     &ObjectAttributes::setBoundingBoxCollisions,
@@ -192,6 +206,35 @@ void initAttributesBindings(py::module& m) {
           &ObjectAttributes::setJoinCollisionMeshes,
           R"(Whether collision meshes for objects constructed from this
           template should be joined into a convex hull or kept separate.)")
+      .def_property(
+          "max_convex_hulls", &ObjectAttributes::getMaxConvexHulls,
+          &ObjectAttributes::setMaxConvexHulls,
+          R"(If positive, collision meshes for objects constructed from this
+          template are decomposed into at most this many convex hulls, cached
+          on disk. 0 to use the hulls of the mesh components.)")
+      .def_property(
+          "max_hull_vertices", &ObjectAttributes::getMaxHullVertices,
+          &ObjectAttributes::setMaxHullVertices,
+          R"(The maximum number of vertices of each hull of the convex
+          decomposition.)")
+      .def_property(
+          "convex_hulls_handle", &ObjectAttributes::getConvexHullsHandle,
+          &ObjectAttributes::setConvexHullsHandle,
+          R"(The file caching the convex decomposition, the collision asset
+          handle with a .hulls extension if empty.)")
+      .def_property_readonly(
+          "has_asset_metadata", &ObjectAttributes::getHasAssetMetadata,
+          R"(Whether the render asset aabb and triangle count are known,
+          read from the cache next to the render asset or computed when
+          it was first loaded.)")
+      .def_property_readonly(
+          "render_asset_aabb", &ObjectAttributes::getRenderAssetAabb,
+          R"(The bounding box of the render asset, before the scale of the
+          template.)")
+      .def_property_readonly(
+          "render_asset_triangle_count",
+          &ObjectAttributes::getRenderAssetTriangleCount,
+          R"(The number of triangles of the render asset.)")
       .def_property(
           "is_visibile", &ObjectAttributes::getIsVisible,
           &ObjectAttributes::setIsVisible,
@@ -279,7 +322,64 @@ void initAttributesBindings(py::module& m) {
           &PhysicsManagerAttributes::getRestitutionCoefficient,
           &PhysicsManagerAttributes::setRestitutionCoefficient,
           R"(Default restitution coefficient for contact modeling.  Can be overridden by
-          stage and object values.)");
+          stage and object values.)")
+      .def_property(
+          "num_threads", &PhysicsManagerAttributes::getNumThreads,
+          &PhysicsManagerAttributes::setNumThreads,
+          R"(The number of threads stepping the Bullet world. More than 1 uses the
+          multi-threaded world, which requires Bullet built thread-safe.)")
+      .def_property(
+          "task_scheduler", &PhysicsManagerAttributes::getTaskScheduler,
+          &PhysicsManagerAttributes::setTaskScheduler,
+          R"(The Bullet task scheduler of the multi-threaded world: internal,
+          openmp, tbb or ppl.)")
+      .def_property(
+          "cache_stage_bvh", &PhysicsManagerAttributes::getCacheStageBvh,
+          &PhysicsManagerAttributes::setCacheStageBvh,
+          R"(Whether the BVH of each stage collision mesh is saved next to the
+          stage asset and loaded from there instead of being rebuilt.)")
+      .def_property(
+          "broadphase", &PhysicsManagerAttributes::getBroadphase,
+          &PhysicsManagerAttributes::setBroadphase,
+          R"(The Bullet broadphase: dbvt, or sweep and prune over the bounds of
+          the stage.)")
+      .def_property(
+          "world_bounds_padding",
+          &PhysicsManagerAttributes::getWorldBoundsPadding,
+          &PhysicsManagerAttributes::setWorldBoundsPadding,
+          R"(How far the bounds of the sweep and prune broadphase extend beyond
+          the collision AABB of the stage, in meters.)")
+      .def_property(
+          "solver_iterations", &PhysicsManagerAttributes::getSolverIterations,
+          &PhysicsManagerAttributes::setSolverIterations,
+          R"(The number of iterations of the Bullet constraint solver per
+          substep.)")
+      .def_property(
+          "manifold_pool_size", &PhysicsManagerAttributes::getManifoldPoolSize,
+          &PhysicsManagerAttributes::setManifoldPoolSize,
+          R"(The number of contact manifolds Bullet preallocates.)")
+      .def_property(
+          "collision_algorithm_pool_size",
+          &PhysicsManagerAttributes::getCollisionAlgorithmPoolSize,
+          &PhysicsManagerAttributes::setCollisionAlgorithmPoolSize,
+          R"(The number of collision algorithms Bullet preallocates.)")
+      .def_property(
+          "linear_sleeping_threshold",
+          &PhysicsManagerAttributes::getLinearSleepingThreshold,
+          &PhysicsManagerAttributes::setLinearSleepingThreshold,
+          R"(The linear speed below which dynamic objects may fall asleep,
+          unless their template sets its own.)")
+      .def_property(
+          "angular_sleeping_threshold",
+          &PhysicsManagerAttributes::getAngularSleepingThreshold,
+          &PhysicsManagerAttributes::setAngularSleepingThreshold,
+          R"(The angular speed below which dynamic objects may fall asleep,
+          unless their template sets its own.)")
+      .def_property(
+          "deactivation_time", &PhysicsManagerAttributes::getDeactivationTime,
+          &PhysicsManagerAttributes::setDeactivationTime,
+          R"(How long an object must stay below its sleeping thresholds to
+          fall asleep, for all Bullet worlds of the process.)");
 
   // ==== AbstractPrimitiveAttributes ====
   py::class_<AbstractPrimitiveAttributes, AbstractAttributes,
@@ -87,6 +87,10 @@ void declareBaseAttributesManager(py::module& m, std::string classStrPrefix) {
       .def("get_random_template_handle", &MgrClass::getRandomObjectHandle,
            R"(Returns the handle for a random template chosen from the
              existing templates being managed.)")
+      .def("seed", &MgrClass::seed,
+           R"(Seeds the random generator of the random template handle
+             queries.)",
+           "new_seed"_a)
       .def(
           "get_undeletable_handles", &MgrClass::getUndeletableObjectHandles,
           R"(Returns a list of template handles for templates that have been marked
@@ -265,9 +269,9 @@ void initAttributesManagersBindings(py::module& m) {
           "load_object_configs", &ObjectAttributesManager::loadObjectConfigs,
           R"(Build templates for all files with ".phys_properties.json" extension
             that exist in the provided file or directory path. If save_as_defaults
-            is true, then these templates will be unable to be deleted)"
-          "path"_a,
-          "save_as_defaults"_a = false)
+            is true, then these templates will be unable to be deleted. The files
+            are parsed on num_threads threads, 0 for all hardware threads.)",
+          "path"_a, "save_as_defaults"_a = false, "num_threads"_a = 0)
 
       // manage file-based templates access
       .def(
@@ -4,15 +4,47 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/numpy.h>
+
+#include "esp/geo/CoordinateFrame.h"
 #include "esp/geo/OBB.h"
+#include "esp/geo/PoseConversion.h"
 #include "esp/geo/geo.h"
 
+namespace Cr = Corrade;
 namespace py = pybind11;
 using py::literals::operator""_a;
 
 namespace esp {
 namespace geo {
 
+namespace {
+
+typedef py::array_t<float, py::array::c_style | py::array::forcecast>
+    FloatArray;
+
+//! the N x (T components) array @p array as N values of T
+template <class T>
+Cr::Containers::ArrayView<const T> arrayOf(const FloatArray& array,
+                                           const char* name) {
+  constexpr py::ssize_t components = sizeof(T) / sizeof(float);
+  if (array.ndim() != 2 || array.shape(1) != components) {
+    throw py::value_error{std::string{"expected an Nx"} +
+                          std::to_string(components) + " array of " + name};
+  }
+  return {reinterpret_cast<const T*>(array.data()), size_t(array.shape(0))};
+}
+
+//! a new array of @p size values of T, viewed as an N x (T components) array
+template <class T>
+std::pair<FloatArray, Cr::Containers::ArrayView<T>> newArrayOf(size_t size) {
+  constexpr py::ssize_t components = sizeof(T) / sizeof(float);
+  FloatArray array{{py::ssize_t(size), components}};
+  return {array, {reinterpret_cast<T*>(array.mutable_data()), size}};
+}
+
+}  // namespace
+
 void initGeoBindings(py::module& m) {
   auto geo = m.def_submodule("geo");
 
@@ -45,6 +77,99 @@ void initGeoBindings(py::module& m) {
   geo.def("compute_gravity_aligned_MOBB", &geo::computeGravityAlignedMOBB);
   geo.def("get_transformed_bb", &geo::getTransformedBB, "range"_a, "xform"_a);
 
+  // ==== batched pose conversion ====
+  // Magnum::Matrix3x3 is column-major, the 3x3 matrices of numpy row-major
+  geo.def(
+      "quaternions_to_rotation_matrices",
+      [](const FloatArray& quaternions) {
+        auto input = arrayOf<Mn::Quaternion>(quaternions, "quaternions");
+        FloatArray matrices{{py::ssize_t(input.size()), py::ssize_t{3},
+                             py::ssize_t{3}}};
+        rotationMatricesFromQuaternions(
+            input, {reinterpret_cast<Mn::Matrix3x3*>(matrices.mutable_data()),
+                    input.size()});
+        return matrices.attr("transpose")(0, 2, 1);
+      },
+      "quaternions"_a,
+      R"(The rotation matrices of an Nx4 array of unit quaternions ordered [x, y, z, w], as an Nx3x3 array.)");
+  geo.def(
+      "rotation_matrices_to_quaternions",
+      [](const py::array& matrices) {
+        if (matrices.ndim() != 3 || matrices.shape(1) != 3 ||
+            matrices.shape(2) != 3) {
+          throw py::value_error{"expected an Nx3x3 array of matrices"};
+        }
+        // the transposed copy is laid out as column-major matrices
+        const FloatArray columnMajor =
+            FloatArray::ensure(matrices.attr("transpose")(0, 2, 1));
+        if (!columnMajor) {
+          throw py::error_already_set{};
+        }
+        const size_t size = matrices.shape(0);
+        auto quaternions = newArrayOf<Mn::Quaternion>(size);
+        quaternionsFromRotationMatrices(
+            {reinterpret_cast<const Mn::Matrix3x3*>(columnMajor.data()),
+             size},
+            quaternions.second);
+        return quaternions.first;
+      },
+      "matrices"_a,
+      R"(The unit quaternions ordered [x, y, z, w] of an Nx3x3 array of rotation matrices, as an Nx4 array.)");
+
+  // ==== CoordinateFrame ====
+  py::class_<CoordinateFrame, CoordinateFrame::ptr>(geo, "CoordinateFrame")
+      .def(py::init<const vec3f&, const vec3f&, const vec3f&>(),
+           "up"_a = ESP_UP, "front"_a = ESP_FRONT,
+           "origin"_a = vec3f::Zero())
+      .def_property_readonly("up", &CoordinateFrame::up)
+      .def_property_readonly("front", &CoordinateFrame::front)
+      .def_property_readonly("origin", &CoordinateFrame::origin)
+      .def_property_readonly("rotation_world_to_frame",
+                             [](const CoordinateFrame& self) {
+                               return self.rotationWorldToFrame().coeffs();
+                             })
+      .def(
+          "points_world_to_frame",
+          [](const CoordinateFrame& self, const FloatArray& points) {
+            auto input = arrayOf<Mn::Vector3>(points, "points");
+            auto result = newArrayOf<Mn::Vector3>(input.size());
+            self.pointsWorldToFrame(input, result.second);
+            return result.first;
+          },
+          "points"_a,
+          R"(Transform an Nx3 array of points from world coordinates to this frame.)")
+      .def(
+          "points_frame_to_world",
+          [](const CoordinateFrame& self, const FloatArray& points) {
+            auto input = arrayOf<Mn::Vector3>(points, "points");
+            auto result = newArrayOf<Mn::Vector3>(input.size());
+            self.pointsFrameToWorld(input, result.second);
+            return result.first;
+          },
+          "points"_a,
+          R"(Transform an Nx3 array of points from this frame to world coordinates.)")
+      .def(
+          "rotations_world_to_frame",
+          [](const CoordinateFrame& self, const FloatArray& rotations) {
+            auto input = arrayOf<Mn::Quaternion>(rotations, "quaternions");
+            auto result = newArrayOf<Mn::Quaternion>(input.size());
+            self.rotationsWorldToFrame(input, result.second);
+            return result.first;
+          },
+          "rotations"_a,
+          R"(Express an Nx4 array of rotations relative to the world, quaternions ordered [x, y, z, w], in this frame.)")
+      .def(
+          "rotations_frame_to_world",
+          [](const CoordinateFrame& self, const FloatArray& rotations) {
+            auto input = arrayOf<Mn::Quaternion>(rotations, "quaternions");
+            auto result = newArrayOf<Mn::Quaternion>(input.size());
+            self.rotationsFrameToWorld(input, result.second);
+            return result.first;
+          },
+          "rotations"_a,
+          R"(Express an Nx4 array of rotations relative to this frame, quaternions ordered [x, y, z, w], in the world.)")
+      .def("__repr__", &CoordinateFrame::toJson);
+
   // ==== Ray ====
   py::class_<Ray>(m, "Ray")
       .def(py::init<Magnum::Vector3, Magnum::Vector3>())
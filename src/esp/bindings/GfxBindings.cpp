@@ -4,8 +4,11 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/numpy.h>
+
 #include <Magnum/ImageView.h>
 #include <Magnum/Magnum.h>
+#include <Magnum/PixelFormat.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 
 #include <Magnum/PythonBindings.h>
@@ -14,6 +17,10 @@
 #include "python/corrade/EnumOperators.h"
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/core/Buffer.h"
+#include "esp/gfx/BatchRenderer.h"
+#include "esp/gfx/FrameEncoder.h"
+#include "esp/gfx/GpuDevices.h"
 #include "esp/gfx/LightSetup.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/RenderTarget.h"
@@ -32,6 +39,21 @@ esp::scene::SceneNode* nodeGetter(T& self) {
     throw py::value_error{"feature not valid"};
   return &self.node();
 };
+
+#ifdef ESP_BUILD_WITH_CUDA
+//! the memory of @p buffer, checked to be device memory holding a frame
+template <class T>
+T* gpuFrameMemory(const esp::gfx::RenderTarget& target,
+                  esp::core::Buffer& buffer,
+                  std::size_t channels) {
+  if (buffer.deviceId() < 0)
+    throw py::value_error{"buffer is not in CUDA device memory"};
+  const std::size_t pixels = target.framebufferSize().product();
+  if (buffer.data.size() != pixels * channels * sizeof(T))
+    throw py::value_error{"buffer size does not match the framebuffer"};
+  return reinterpret_cast<T*>(buffer.data.data());
+}
+#endif
 }  // namespace
 
 namespace esp {
@@ -51,6 +73,12 @@ void initGfxBindings(py::module& m) {
 
   flags.value("FRUSTUM_CULLING", RenderCamera::Flag::FrustumCulling)
       .value("OBJECTS_ONLY", RenderCamera::Flag::ObjectsOnly)
+      .value("SORT_BY_DRAW_STATE", RenderCamera::Flag::SortByDrawState)
+      .value("OCCLUSION_CULLING", RenderCamera::Flag::OcclusionCulling)
+      .value("RENDER_LIST", RenderCamera::Flag::RenderList)
+      .value("GPU_DRIVEN", RenderCamera::Flag::GpuDriven)
+      .value("POTENTIALLY_VISIBLE_SET",
+             RenderCamera::Flag::PotentiallyVisibleSet)
       .value("NONE", RenderCamera::Flag{});
   corrade::enumOperators(flags);
 
@@ -81,7 +109,8 @@ void initGfxBindings(py::module& m) {
           },
           R"(Draw given scene using the visual sensor)", "visualSensor"_a,
           "scene"_a,
-          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling})
+          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling},
+          py::call_guard<py::gil_scoped_release>())
       .def(
           "draw",
           [](Renderer& self, RenderCamera& camera,
@@ -89,8 +118,25 @@ void initGfxBindings(py::module& m) {
             self.draw(camera, sceneGraph, RenderCamera::Flags{flags});
           },
           R"(Draw given scene using the camera)", "camera"_a, "scene"_a,
-          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling})
-      .def("bind_render_target", &Renderer::bindRenderTarget);
+          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling},
+          py::call_guard<py::gil_scoped_release>())
+      .def("bind_render_target", &Renderer::bindRenderTarget)
+      .def("release_render_target", &Renderer::releaseRenderTarget,
+           R"(Give the render target of the visual sensor back, for a new sensor of the same specification)",
+           "visual_sensor"_a)
+      .def_property_readonly("num_released_render_targets",
+                             &Renderer::numReleasedRenderTargets)
+      .def("clear_released_render_targets",
+           &Renderer::clearReleasedRenderTargets);
+
+  py::class_<VisibleObject>(
+      m, "VisibleObject",
+      R"(An object seen in a frame, see RenderTarget.read_visible_objects())")
+      .def_readonly("object_id", &VisibleObject::objectId)
+      .def_readonly("pixel_count", &VisibleObject::pixelCount)
+      .def_readonly(
+          "bounds", &VisibleObject::bounds,
+          R"(Bounding box of the pixels, max exclusive, rows from the bottom)");
 
   py::class_<RenderTarget>(m, "RenderTarget")
       .def("__enter__",
@@ -102,11 +148,62 @@ void initGfxBindings(py::module& m) {
            [](RenderTarget& self, py::object exc_type, py::object exc_value,
               py::object traceback) { self.renderExit(); })
       .def("read_frame_rgba", &RenderTarget::readFrameRgba,
-           "Reads RGBA frame into passed img in uint8 byte format.")
-      .def("read_frame_depth", &RenderTarget::readFrameDepth)
-      .def("read_frame_object_id", &RenderTarget::readFrameObjectId)
-      .def("blit_rgba_to_default", &RenderTarget::blitRgbaToDefault)
+           "Reads RGBA frame into passed img in uint8 byte format.",
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_depth", &RenderTarget::readFrameDepth,
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_object_id", &RenderTarget::readFrameObjectId,
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_surface_normals", &RenderTarget::readFrameSurfaceNormals,
+           R"(Reads the camera-space normals of a normal sensor as RGB32F)",
+           py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("has_surface_normals",
+                             &RenderTarget::hasSurfaceNormals)
+      .def("read_frame_motion_vectors", &RenderTarget::readFrameMotionVectors,
+           R"(Reads the pixel motion of an optical flow sensor as RG32F)",
+           py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("has_motion_vectors",
+                             &RenderTarget::hasMotionVectors)
+      .def("blit_rgba_to_default", &RenderTarget::blitRgbaToDefault,
+           py::call_guard<py::gil_scoped_release>())
+#ifndef MAGNUM_TARGET_WEBGL
+      .def(
+          "read_visible_objects",
+          [](RenderTarget& self, Magnum::UnsignedInt capacity) {
+            std::vector<VisibleObject> objects;
+            self.readVisibleObjects(capacity, objects);
+            return objects;
+          },
+          R"(The IDs below capacity seen in the ObjectID frame, with their
+          pixel counts and bounding boxes, reduced on the GPU so that only
+          a few KB are read back)",
+          "capacity"_a = ObjectIdStatisticsShader::Width,
+          py::call_guard<py::gil_scoped_release>())
+#endif
 #ifdef ESP_BUILD_WITH_CUDA
+      .def(
+          "read_frame_rgba_gpu",
+          [](RenderTarget& self, core::Buffer& buffer) {
+            self.readFrameRgbaGPU(gpuFrameMemory<uint8_t>(self, buffer, 4));
+          },
+          "buffer"_a,
+          R"(Reads the RGBA frame into a Buffer created with
+          Buffer.on_device(), e.g. to hand it to torch.from_dlpack(). The copy
+          runs on the default CUDA stream.)",
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "read_frame_depth_gpu",
+          [](RenderTarget& self, core::Buffer& buffer) {
+            self.readFrameDepthGPU(gpuFrameMemory<float>(self, buffer, 1));
+          },
+          "buffer"_a, py::call_guard<py::gil_scoped_release>())
+      .def(
+          "read_frame_object_id_gpu",
+          [](RenderTarget& self, core::Buffer& buffer) {
+            self.readFrameObjectIdGPU(
+                gpuFrameMemory<int32_t>(self, buffer, 1));
+          },
+          "buffer"_a, py::call_guard<py::gil_scoped_release>())
       .def("read_frame_rgba_gpu",
            [](RenderTarget& self, size_t devPtr) {
              /*
@@ -125,19 +222,116 @@ void initGfxBindings(py::module& m) {
               */
 
              self.readFrameRgbaGPU(reinterpret_cast<uint8_t*>(devPtr));
-           })
+           },
+           py::call_guard<py::gil_scoped_release>())
       .def("read_frame_depth_gpu",
            [](RenderTarget& self, size_t devPtr) {
              self.readFrameDepthGPU(reinterpret_cast<float*>(devPtr));
-           })
+           },
+           py::call_guard<py::gil_scoped_release>())
       .def("read_frame_object_id_gpu",
            [](RenderTarget& self, size_t devPtr) {
              self.readFrameObjectIdGPU(reinterpret_cast<int32_t*>(devPtr));
-           })
+           },
+           py::call_guard<py::gil_scoped_release>())
 #endif
+      .def_property_readonly("samples", &RenderTarget::samples,
+                             R"(Number of samples per pixel the draws take)")
+      .def_property_readonly("gpu_bytes", &RenderTarget::getGpuBytes,
+                             R"(Estimated GPU memory of the render target)")
       .def("render_enter", &RenderTarget::renderEnter)
       .def("render_exit", &RenderTarget::renderExit);
 
+  py::class_<FrameEncoder, FrameEncoder::ptr>(
+      m, "FrameEncoder",
+      R"(Writes frames to PNG or JPEG files on a thread of its own, in the order they were queued)")
+      .def(py::init([](int jpegQuality, size_t maxPendingFrames) {
+             FrameEncoder::Configuration configuration;
+             configuration.jpegQuality = jpegQuality;
+             configuration.maxPendingFrames = maxPendingFrames;
+             return FrameEncoder::create(configuration);
+           }),
+           "jpeg_quality"_a = 90, "max_pending_frames"_a = 16)
+      .def(
+          "encode",
+          [](FrameEncoder& self,
+             const py::array_t<uint8_t, py::array::c_style |
+                                            py::array::forcecast>& image,
+             const std::string& filename) {
+            const int channels = image.ndim() == 3 ? image.shape(2) : 1;
+            if ((image.ndim() != 2 && image.ndim() != 3) || channels < 1 ||
+                channels > 4) {
+              throw py::value_error{
+                  "expected an HxW or HxWxC uint8 image with 1 to 4 "
+                  "channels"};
+            }
+            const Magnum::PixelFormat formats[]{
+                Magnum::PixelFormat::R8Unorm, Magnum::PixelFormat::RG8Unorm,
+                Magnum::PixelFormat::RGB8Unorm,
+                Magnum::PixelFormat::RGBA8Unorm};
+            const Magnum::ImageView2D view{
+                Magnum::PixelStorage{}.setAlignment(1),
+                formats[channels - 1],
+                {int(image.shape(1)), int(image.shape(0))},
+                {image.data(), size_t(image.size())}};
+            py::gil_scoped_release release;
+            return self.encode(view, filename);
+          },
+          R"(Queue an observation, rows from top to bottom, to be written to filename, in the format of its extension. Waits while max_pending_frames are queued.)",
+          "image"_a, "filename"_a)
+      .def("encode_frame", &FrameEncoder::encodeFrame,
+           R"(Read the RGBA frame of a render target back and queue it like encode())",
+           "target"_a, "filename"_a, py::call_guard<py::gil_scoped_release>())
+      .def("wait", &FrameEncoder::wait,
+           R"(Wait for all queued frames to be written)",
+           py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("num_pending", &FrameEncoder::numPending)
+      .def_property_readonly("num_written", &FrameEncoder::numWritten)
+      .def_property_readonly("num_failed", &FrameEncoder::numFailed);
+
+  py::class_<BatchRenderer, BatchRenderer::ptr>(
+      m, "BatchRenderer",
+      R"(Draws many sensors into the tiles of one large framebuffer and reads
+      the results of the whole batch back at once.)")
+      .def(py::init(&BatchRenderer::create<Renderer::ptr, const Magnum::Vector2i&,
+                                           int>),
+           "renderer"_a, "tile_size"_a, "num_tiles"_a)
+      .def_property_readonly("num_tiles", &BatchRenderer::numTiles)
+      .def_property_readonly("tile_size", &BatchRenderer::tileSize)
+      .def_property_readonly("tile_grid_size", &BatchRenderer::tileGridSize)
+      .def_property_readonly("framebuffer_size",
+                             &BatchRenderer::framebufferSize)
+      .def("tile_viewport", &BatchRenderer::tileViewport, "tile"_a)
+      .def("__enter__",
+           [](BatchRenderer& self) {
+             self.renderEnter();
+             return &self;
+           })
+      .def("__exit__",
+           [](BatchRenderer& self, py::object exc_type, py::object exc_value,
+              py::object traceback) { self.renderExit(); })
+      .def(
+          "draw_tile",
+          [](BatchRenderer& self, int tile, sensor::VisualSensor& visualSensor,
+             scene::SceneGraph& sceneGraph, RenderCamera::Flag flags) {
+            self.drawTile(tile, visualSensor, sceneGraph,
+                          RenderCamera::Flags{flags});
+          },
+          R"(Draw given scene using the visual sensor into a tile of the batch)",
+          "tile"_a, "visual_sensor"_a, "scene"_a,
+          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling},
+          py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_rgba", &BatchRenderer::readFrameRgba,
+           "Reads RGBA frames of all tiles into passed img in uint8 byte "
+           "format.",
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_depth", &BatchRenderer::readFrameDepth,
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_object_id", &BatchRenderer::readFrameObjectId,
+           py::call_guard<py::gil_scoped_release>())
+      .def("render_enter", &BatchRenderer::renderEnter)
+      .def("render_exit", &BatchRenderer::renderExit);
+
   py::enum_<LightPositionModel>(
       m, "LightPositionModel",
       R"(Defines the coordinate frame of a light source.)")
@@ -163,6 +357,42 @@ void initGfxBindings(py::module& m) {
   m.attr("DEFAULT_LIGHTING_KEY") =
       assets::ResourceManager::DEFAULT_LIGHTING_KEY;
   m.attr("NO_LIGHT_KEY") = assets::ResourceManager::NO_LIGHT_KEY;
+
+  py::enum_<GpuDevicePolicy>(
+      m, "GpuDevicePolicy",
+      R"(How a simulator picks the GPU of its OpenGL context.)")
+      .value("FIXED", GpuDevicePolicy::Fixed)
+      .value("ROUND_ROBIN", GpuDevicePolicy::RoundRobin)
+      .value("LEAST_LOADED", GpuDevicePolicy::LeastLoaded)
+      .value("CUDA_COLOCATED", GpuDevicePolicy::CudaColocated);
+
+  py::class_<GpuDeviceInfo>(
+      m, "GpuDeviceInfo",
+      R"(A GPU contexts can be created on, with its memory in bytes, 0 if unknown, and the contexts of this process on it.)")
+      .def_readonly("device", &GpuDeviceInfo::device)
+      .def_readonly("total_memory", &GpuDeviceInfo::totalMemory)
+      .def_readonly("free_memory", &GpuDeviceInfo::freeMemory)
+      .def_readonly("num_contexts", &GpuDeviceInfo::numContexts);
+
+  py::class_<GpuMemoryUsage>(
+      m, "GpuMemoryUsage",
+      R"(Estimated GPU memory allocated for a simulator, in bytes, by what it holds.)")
+      .def(py::init<>())
+      .def_readonly("mesh_bytes", &GpuMemoryUsage::meshBytes)
+      .def_readonly("texture_bytes", &GpuMemoryUsage::textureBytes)
+      .def_readonly("ptex_atlas_bytes", &GpuMemoryUsage::ptexAtlasBytes)
+      .def_readonly("render_target_bytes", &GpuMemoryUsage::renderTargetBytes)
+      .def_readonly("noise_model_bytes", &GpuMemoryUsage::noiseModelBytes)
+      .def_property_readonly("total_bytes", &GpuMemoryUsage::totalBytes);
+
+  m.def("num_gpu_devices", &numGpuDevices,
+        R"(The number of GPUs OpenGL contexts can be created on.)");
+  m.def("gpu_devices", &gpuDevices,
+        R"(The GPUs OpenGL contexts can be created on, with their memory and load.)",
+        py::call_guard<py::gil_scoped_release>());
+  m.def("select_gpu_device", &selectGpuDevice,
+        R"(The device the policy places a new context on.)", "policy"_a,
+        "device"_a = 0, py::call_guard<py::gil_scoped_release>());
 }
 
 }  // namespace gfx
@@ -1,4 +1,7 @@
 #include "esp/bindings/bindings.h"
+
+#include <pybind11/numpy.h>
+
 #include "esp/physics/PhysicsManager.h"
 #include "esp/physics/RigidObject.h"
 
@@ -13,7 +16,8 @@ void initPhysicsBindings(py::module& m) {
   py::enum_<PhysicsManager::PhysicsSimulationLibrary>(
       m, "PhysicsSimulationLibrary")
       .value("NONE", PhysicsManager::PhysicsSimulationLibrary::NONE)
-      .value("BULLET", PhysicsManager::PhysicsSimulationLibrary::BULLET);
+      .value("BULLET", PhysicsManager::PhysicsSimulationLibrary::BULLET)
+      .value("KINEMATIC", PhysicsManager::PhysicsSimulationLibrary::KINEMATIC);
 
   // ==== enum object MotionType ====
   py::enum_<MotionType>(m, "MotionType")
@@ -48,6 +52,142 @@ void initPhysicsBindings(py::module& m) {
       .def_readonly("hits", &RaycastResults::hits)
       .def_readonly("ray", &RaycastResults::ray)
       .def("has_hits", &RaycastResults::hasHits);
+
+  // ==== struct object PhysicsSnapshot ====
+  py::class_<PhysicsSnapshot, PhysicsSnapshot::ptr>(m, "PhysicsSnapshot")
+      .def(py::init(&PhysicsSnapshot::create<>))
+      .def_readonly("world_time", &PhysicsSnapshot::worldTime)
+      .def("__len__",
+           [](const PhysicsSnapshot& self) { return self.objects.size(); })
+      .def(
+          "to_bytes",
+          [](const PhysicsSnapshot& self) {
+            return py::bytes(self.serialize());
+          },
+          R"(Serialize into a binary blob, e.g. to send it to another process.)")
+      .def_static(
+          "from_bytes",
+          [](const py::bytes& data) {
+            auto snapshot = PhysicsSnapshot::create();
+            if (!snapshot->deserialize(data)) {
+              throw py::value_error{"invalid physics snapshot"};
+            }
+            return snapshot;
+          },
+          "data"_a, R"(Deserialize a blob created by to_bytes().)")
+      .def(py::pickle(
+          [](const PhysicsSnapshot& self) {
+            return py::make_tuple(py::bytes(self.serialize()));
+          },
+          [](const py::tuple& state) {
+            auto snapshot = PhysicsSnapshot::create();
+            if (state.size() != 1 ||
+                !snapshot->deserialize(state[0].cast<std::string>())) {
+              throw py::value_error{"invalid physics snapshot"};
+            }
+            return snapshot;
+          }));
+
+  // ==== struct object BatchRaycastResults ====
+  // the arrays are views of the results, which they keep alive
+  py::class_<BatchRaycastResults, BatchRaycastResults::ptr>(
+      m, "BatchRaycastResults")
+      .def(py::init(&BatchRaycastResults::create<>))
+      .def("__len__", &BatchRaycastResults::size)
+      .def_property_readonly(
+          "has_hit",
+          [](py::object self) {
+            auto& results = self.cast<BatchRaycastResults&>();
+            return py::array_t<bool>(
+                {results.size()},
+                reinterpret_cast<const bool*>(results.hasHit.data()), self);
+          },
+          R"(N bools, whether each ray hit anything within max_distance.)")
+      .def_property_readonly(
+          "object_ids",
+          [](py::object self) {
+            auto& results = self.cast<BatchRaycastResults&>();
+            return py::array_t<int>({results.size()}, results.objectIds.data(),
+                                    self);
+          },
+          R"(N ids of the objects hit first, -1 for the stage and misses.)")
+      .def_property_readonly(
+          "points",
+          [](py::object self) {
+            auto& results = self.cast<BatchRaycastResults&>();
+            return py::array_t<float>(
+                {results.size(), size_t{3}},
+                reinterpret_cast<const float*>(results.points.data()), self);
+          },
+          R"(Nx3 first impact points in world space, zero for misses.)")
+      .def_property_readonly(
+          "normals",
+          [](py::object self) {
+            auto& results = self.cast<BatchRaycastResults&>();
+            return py::array_t<float>(
+                {results.size(), size_t{3}},
+                reinterpret_cast<const float*>(results.normals.data()), self);
+          },
+          R"(Nx3 normals at the first impact points, zero for misses.)")
+      .def_property_readonly(
+          "ray_distances",
+          [](py::object self) {
+            auto& results = self.cast<BatchRaycastResults&>();
+            return py::array_t<double>({results.size()},
+                                       results.rayDistances.data(), self);
+          },
+          R"(N distances to the first impact in units of ray length, inf for
+          misses.)");
+
+  // ==== struct object ContactPointResults ====
+  // the arrays are views of the results, which they keep alive
+  py::class_<ContactPointResults, ContactPointResults::ptr>(
+      m, "ContactPointResults")
+      .def(py::init(&ContactPointResults::create<>))
+      .def("__len__", &ContactPointResults::size)
+      .def_property_readonly(
+          "object_ids_a",
+          [](py::object self) {
+            auto& results = self.cast<ContactPointResults&>();
+            return py::array_t<int>({results.size()},
+                                    results.objectIdsA.data(), self);
+          },
+          R"(N ids of the first objects of the contacts, -1 for the stage.)")
+      .def_property_readonly(
+          "object_ids_b",
+          [](py::object self) {
+            auto& results = self.cast<ContactPointResults&>();
+            return py::array_t<int>({results.size()},
+                                    results.objectIdsB.data(), self);
+          },
+          R"(N ids of the second objects of the contacts, -1 for the stage.)")
+      .def_property_readonly(
+          "points",
+          [](py::object self) {
+            auto& results = self.cast<ContactPointResults&>();
+            return py::array_t<float>(
+                {results.size(), size_t{3}},
+                reinterpret_cast<const float*>(results.points.data()), self);
+          },
+          R"(Nx3 contact points on the second objects in world space.)")
+      .def_property_readonly(
+          "normals",
+          [](py::object self) {
+            auto& results = self.cast<ContactPointResults&>();
+            return py::array_t<float>(
+                {results.size(), size_t{3}},
+                reinterpret_cast<const float*>(results.normals.data()), self);
+          },
+          R"(Nx3 contact normals in world space, from the second objects to the
+          first ones.)")
+      .def_property_readonly(
+          "impulses",
+          [](py::object self) {
+            auto& results = self.cast<ContactPointResults&>();
+            return py::array_t<double>({results.size()},
+                                       results.impulses.data(), self);
+          },
+          R"(N impulses applied along the normals during the last step.)");
 }
 
 }  // namespace physics
@@ -4,6 +4,8 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/numpy.h>
+
 #include <Magnum/Magnum.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 
@@ -255,7 +257,52 @@ void initSceneBindings(py::module& m) {
       .def_property_readonly("semantic_index_map",
                              &SemanticScene::getSemanticIndexMap)
       .def("semantic_index_to_object_index",
-           &SemanticScene::semanticIndexToObjectIndex);
+           &SemanticScene::semanticIndexToObjectIndex)
+      .def_property_readonly(
+          "semantic_id_to_object_index",
+          [](py::object self) {
+            const auto& table =
+                self.cast<SemanticScene&>().semanticIdObjectIndices();
+            return py::array_t<int>({table.size()}, table.data(), self);
+          },
+          R"(
+        The index into `objects` of each semantic id, -1 where unmapped. Index
+        it with a semantic observation to map all its pixels at once.
+      )")
+      .def_property_readonly(
+          "semantic_id_to_category_index",
+          [](py::object self) {
+            const auto& table =
+                self.cast<SemanticScene&>().semanticIdCategoryIndices();
+            return py::array_t<int>({table.size()}, table.data(), self);
+          },
+          R"(
+        The category index of the object of each semantic id, -1 where there
+        is none.
+      )")
+      .def_property_readonly(
+          "semantic_id_to_region_index",
+          [](py::object self) {
+            const auto& table =
+                self.cast<SemanticScene&>().semanticIdRegionIndices();
+            return py::array_t<int>({table.size()}, table.data(), self);
+          },
+          R"(
+        The index into `regions` of the region of the object of each semantic
+        id, -1 where there is none.
+      )")
+      .def("objects_within_radius", &SemanticScene::objectsWithinRadius,
+           R"(
+        For each of the points, the indices into `objects` of the objects whose
+        oriented bounding box is within radius of it.
+      )",
+           "points"_a, "radius"_a)
+      .def("regions_containing", &SemanticScene::regionsContaining,
+           R"(
+        For each of the points, the index into `regions` of the smallest region
+        whose bounding box contains it, or -1 if there is none.
+      )",
+           "points"_a);
 
   // ==== ObjectControls ====
   py::class_<ObjectControls, ObjectControls::ptr>(m, "ObjectControls")
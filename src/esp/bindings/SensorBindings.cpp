@@ -4,17 +4,28 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <algorithm>
+#include <memory>
+
+#include <pybind11/numpy.h>
+
 #include <Magnum/Magnum.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 
 #include <Magnum/PythonBindings.h>
 #include <Magnum/SceneGraph/PythonBindings.h>
 
+#include "esp/core/SharedMemoryRing.h"
+#include "esp/sensor/CubeMapCamera.h"
+#include "esp/sensor/LidarSensor.h"
 #include "esp/sensor/PinholeCamera.h"
+#include "esp/sensor/RedwoodNoiseModelCPU.h"
 #ifdef ESP_BUILD_WITH_CUDA
 #include "esp/sensor/RedwoodNoiseModel.h"
+#include "esp/sensor/RgbNoiseModel.h"
 #endif
 #include "esp/sensor/Sensor.h"
+#include "esp/sensor/TopDownMapCamera.h"
 #include "esp/sim/Simulator.h"
 
 namespace py = pybind11;
@@ -29,14 +40,358 @@ esp::scene::SceneNode* nodeGetter(T& self) {
     throw py::value_error{"feature not valid"};
   return &self.node();
 };
+
+std::string dataTypeFormat(esp::core::DataType dataType) {
+  switch (dataType) {
+    case esp::core::DataType::DT_INT8:
+      return py::format_descriptor<int8_t>::format();
+    case esp::core::DataType::DT_UINT8:
+      return py::format_descriptor<uint8_t>::format();
+    case esp::core::DataType::DT_INT16:
+      return py::format_descriptor<int16_t>::format();
+    case esp::core::DataType::DT_UINT16:
+      return py::format_descriptor<uint16_t>::format();
+    case esp::core::DataType::DT_INT32:
+      return py::format_descriptor<int32_t>::format();
+    case esp::core::DataType::DT_UINT32:
+      return py::format_descriptor<uint32_t>::format();
+    case esp::core::DataType::DT_INT64:
+      return py::format_descriptor<int64_t>::format();
+    case esp::core::DataType::DT_UINT64:
+      return py::format_descriptor<uint64_t>::format();
+    case esp::core::DataType::DT_FLOAT:
+      return py::format_descriptor<float>::format();
+    case esp::core::DataType::DT_DOUBLE:
+      return py::format_descriptor<double>::format();
+    case esp::core::DataType::DT_FLOAT16:
+      // the struct module code of a half, which pybind has no type for
+      return "e";
+    default:
+      throw py::value_error{"buffer has no data type"};
+  }
+}
+
+//! strides in bytes of a C-contiguous array
+std::vector<std::size_t> contiguousStrides(
+    const std::vector<std::size_t>& shape,
+    std::size_t itemSize) {
+  std::vector<std::size_t> strides(shape.size());
+  std::size_t stride = itemSize;
+  for (std::size_t i = shape.size(); i-- > 0;) {
+    strides[i] = stride;
+    stride *= shape[i];
+  }
+  return strides;
+}
+
+/* The DLPack ABI, https://github.com/dmlc/dlpack, which the array libraries
+   exchange tensors through without copying them */
+enum DLDeviceType : int32_t { kDLCPU = 1, kDLCUDA = 2 };
+enum DLDataTypeCode : uint8_t { kDLInt = 0, kDLUInt = 1, kDLFloat = 2 };
+
+struct DLDevice {
+  int32_t device_type;
+  int32_t device_id;
+};
+
+struct DLDataType {
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+};
+
+struct DLTensor {
+  void* data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t* shape;
+  int64_t* strides;
+  uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+  DLTensor dl_tensor;
+  void* manager_ctx;
+  void (*deleter)(DLManagedTensor*);
+};
+
+DLDataType dlDataType(esp::core::DataType dataType) {
+  const uint8_t bits = 8 * esp::core::getDataTypeByteSize(dataType);
+  switch (dataType) {
+    case esp::core::DataType::DT_INT8:
+    case esp::core::DataType::DT_INT16:
+    case esp::core::DataType::DT_INT32:
+    case esp::core::DataType::DT_INT64:
+      return {kDLInt, bits, 1};
+    case esp::core::DataType::DT_UINT8:
+    case esp::core::DataType::DT_UINT16:
+    case esp::core::DataType::DT_UINT32:
+    case esp::core::DataType::DT_UINT64:
+      return {kDLUInt, bits, 1};
+    case esp::core::DataType::DT_FLOAT:
+    case esp::core::DataType::DT_DOUBLE:
+    case esp::core::DataType::DT_FLOAT16:
+      return {kDLFloat, bits, 1};
+    default:
+      throw py::value_error{"buffer has no data type"};
+  }
+}
+
+//! device of the memory of @p buffer, pinned host memory counts as CPU memory
+DLDevice dlDevice(const esp::core::Buffer& buffer) {
+  if (buffer.deviceId() >= 0) {
+    return {kDLCUDA, buffer.deviceId()};
+  }
+  return {kDLCPU, 0};
+}
+
+//! a DLPack tensor keeping the buffer it views alive
+struct DLPackContext {
+  esp::core::Buffer::ptr buffer;
+  std::vector<int64_t> shape;
+  std::vector<int64_t> strides;
+  DLManagedTensor managed{};
+};
+
+constexpr const char* DLTensorCapsuleName = "dltensor";
+
+py::capsule toDLPack(const esp::core::Buffer::ptr& buffer) {
+  auto context = std::make_unique<DLPackContext>();
+  context->buffer = buffer;
+  context->shape.assign(buffer->shape.begin(), buffer->shape.end());
+  // DLPack strides count elements, not bytes
+  for (std::size_t stride : contiguousStrides(buffer->shape, 1)) {
+    context->strides.push_back(stride);
+  }
+  DLTensor& tensor = context->managed.dl_tensor;
+  tensor.data = buffer->data.data();
+  tensor.device = dlDevice(*buffer);
+  tensor.ndim = buffer->shape.size();
+  tensor.dtype = dlDataType(buffer->dataType);
+  tensor.shape = context->shape.data();
+  tensor.strides = context->strides.data();
+  tensor.byte_offset = 0;
+  context->managed.manager_ctx = context.get();
+  context->managed.deleter = [](DLManagedTensor* managed) {
+    delete static_cast<DLPackContext*>(managed->manager_ctx);
+  };
+
+  DLManagedTensor* managed = &context.release()->managed;
+  // a consumer renames the capsule to "used_dltensor" and becomes the owner
+  return py::capsule(managed, DLTensorCapsuleName, [](PyObject* capsule) {
+    if (PyCapsule_IsValid(capsule, DLTensorCapsuleName)) {
+      auto* managed = static_cast<DLManagedTensor*>(
+          PyCapsule_GetPointer(capsule, DLTensorCapsuleName));
+      managed->deleter(managed);
+    }
+  });
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+esp::core::DataType dataTypeOf(const py::dtype& dtype) {
+  for (int i = int(esp::core::DataType::DT_INT8);
+       i <= int(esp::core::DataType::DT_FLOAT16); ++i) {
+    const auto dataType = esp::core::DataType(i);
+    if (dtype.equal(py::dtype(dataTypeFormat(dataType)))) {
+      return dataType;
+    }
+  }
+  throw py::value_error{"unsupported dtype"};
+}
+#endif
 }  // namespace
 
 namespace esp {
 namespace sensor {
 
 void initSensorBindings(py::module& m) {
+  // ==== Buffer ====
+  py::class_<core::Buffer, core::Buffer::ptr>(
+      m, "Buffer", py::buffer_protocol(), R"(
+        Memory holding an observation.  Supports the buffer protocol, so
+        numpy.asarray(buffer) views the observation without copying it.
+        )")
+      .def_buffer([](core::Buffer& self) -> py::buffer_info {
+        if (self.deviceId() >= 0)
+          throw py::buffer_error{
+              "the buffer is in CUDA device memory, use __dlpack__()"};
+        const std::size_t itemSize = core::getDataTypeByteSize(self.dataType);
+        return py::buffer_info(self.data.data(), itemSize,
+                               dataTypeFormat(self.dataType), self.shape.size(),
+                               self.shape,
+                               contiguousStrides(self.shape, itemSize));
+      })
+      .def_readonly("shape", &core::Buffer::shape)
+      .def_property_readonly("is_external", &core::Buffer::isExternal)
+      .def_property_readonly(
+          "device", &core::Buffer::deviceId,
+          R"(The CUDA device holding the memory, -1 for host memory.)")
+      .def(
+          "__dlpack__",
+          [](const core::Buffer::ptr& self, const py::object& /*stream*/) {
+            // waiting for the copies on the default stream makes the tensor
+            // ready for the stream of any consumer
+            self->synchronize();
+            return toDLPack(self);
+          },
+          "stream"_a = py::none(),
+          R"(Views the buffer as a DLPack tensor, e.g. for torch.from_dlpack(),
+          jax.dlpack.from_dlpack() or numpy.from_dlpack(), without copying it.
+          The tensor keeps the buffer alive. A sensor reuses its buffer, so
+          the tensor is overwritten by the next observation. Device memory is
+          synchronized with the default stream first, whatever the stream.)")
+      .def("__dlpack_device__",
+           [](const core::Buffer& self) {
+             const DLDevice device = dlDevice(self);
+             return py::make_tuple(device.device_type, device.device_id);
+           })
+#ifdef ESP_BUILD_WITH_CUDA
+      .def_static(
+          "on_device",
+          [](const std::vector<std::size_t>& shape, const py::object& dtype,
+             int device) {
+            auto buffer = core::Buffer::createOnDevice(
+                shape, dataTypeOf(py::dtype::from_args(dtype)), device);
+            if (!buffer)
+              throw std::bad_alloc{};
+            return buffer;
+          },
+          "shape"_a, "dtype"_a, "device"_a = 0,
+          R"(A zeroed Buffer in the memory of a CUDA device, to read GPU
+          frames into with RenderTarget.read_frame_rgba_gpu() and friends.)")
+#endif
+      ;
+
+  // ==== SharedMemoryRing ====
+  py::class_<core::SharedMemoryRing, core::SharedMemoryRing::ptr> ring(
+      m, "SharedMemoryRing", R"(
+        A ring of slots in shared memory holding observations, written by an
+        environment worker process with Simulator.write_agent_observations()
+        and viewed by another process opening the ring by name, without any
+        serialization or copy.
+        )");
+  py::class_<core::SharedMemoryRing::Field>(ring, "Field")
+      .def_readonly("name", &core::SharedMemoryRing::Field::name)
+      .def_readonly("shape", &core::SharedMemoryRing::Field::shape)
+      .def_property_readonly("dtype",
+                             [](const core::SharedMemoryRing::Field& self) {
+                               return dataTypeFormat(self.dataType);
+                             });
+  ring.def(py::init<const std::string&, int,
+                    const std::vector<core::SharedMemoryRing::Field>&>(),
+           "name"_a, "num_slots"_a, "fields"_a,
+           R"(Create a ring, removed again when this object is destroyed.)")
+      .def(py::init<const std::string&>(), "name"_a,
+           R"(Open the ring another process created.)")
+      .def_property_readonly("name", &core::SharedMemoryRing::name)
+      .def_property_readonly("num_slots", &core::SharedMemoryRing::numSlots)
+      .def_property_readonly("slot_size", &core::SharedMemoryRing::slotSize)
+      .def_property_readonly("fields", &core::SharedMemoryRing::fields)
+      .def("field", &core::SharedMemoryRing::field, "slot"_a, "name"_a,
+           py::keep_alive<0, 1>(),
+           R"(A Buffer viewing a field of a slot, numpy.asarray() it to read it without a copy. None if there is no such slot or field.)")
+      .def("sequence", &core::SharedMemoryRing::sequence, "slot"_a,
+           R"(The number of times the slot was published.)")
+      .def("publish", &core::SharedMemoryRing::publish, "slot"_a);
+
+  // ==== ObservationDataset ====
+  py::enum_<sim::DatasetCompression>(m, "DatasetCompression")
+      .value("NONE", sim::DatasetCompression::None)
+      .value("DELTA_LZ", sim::DatasetCompression::DeltaLz);
+
+  py::class_<sim::ObservationDatasetWriter,
+             sim::ObservationDatasetWriter::ptr>(m, "ObservationDatasetWriter",
+                                                 R"(
+        Streams records of observations, agent states and actions into
+        chunked shard files on a thread of its own, fed with
+        Simulator.write_agent_observations(). Read the shards with
+        ObservationDatasetReader.
+        )")
+      .def(py::init([](const std::string& directory,
+                       const std::vector<core::SharedMemoryRing::Field>& fields,
+                       std::size_t recordsPerChunk, std::size_t chunksPerShard,
+                       sim::DatasetCompression compression,
+                       std::size_t maxPendingRecords, bool overwrite) {
+             sim::ObservationDatasetWriter::Configuration configuration;
+             configuration.recordsPerChunk = recordsPerChunk;
+             configuration.chunksPerShard = chunksPerShard;
+             configuration.compression = compression;
+             configuration.maxPendingRecords = maxPendingRecords;
+             configuration.overwrite = overwrite;
+             return std::make_shared<sim::ObservationDatasetWriter>(
+                 directory, fields, configuration);
+           }),
+           "directory"_a, "fields"_a, "records_per_chunk"_a = 64,
+           "chunks_per_shard"_a = 64,
+           "compression"_a = sim::DatasetCompression::DeltaLz,
+           "max_pending_records"_a = 256, "overwrite"_a = false,
+           R"(Write shards into directory with the fields of Simulator.get_agent_dataset_fields() or any others. If the directory has shards already, they are deleted with overwrite, else the writer refuses all records and is_good is False.)")
+      .def_property_readonly("fields", &sim::ObservationDatasetWriter::fields)
+      .def_property_readonly("num_records",
+                             &sim::ObservationDatasetWriter::numRecords)
+      .def_property_readonly("is_good", &sim::ObservationDatasetWriter::isGood)
+      .def(
+          "write",
+          [](sim::ObservationDatasetWriter& self,
+             const std::vector<py::array>& arrays) {
+            std::vector<Corrade::Containers::ArrayView<const char>> data;
+            for (const py::array& array : arrays) {
+              if (!(array.flags() & py::array::c_style))
+                throw py::value_error{"the arrays must be C-contiguous"};
+              data.emplace_back(static_cast<const char*>(array.data()),
+                                array.nbytes());
+            }
+            py::gil_scoped_release release;
+            return self.write(data);
+          },
+          "arrays"_a,
+          R"(Queue a record of one C-contiguous array per field, in the order of the fields. Returns False if the writer is closed or the arrays don't match the fields.)")
+      .def("wait", &sim::ObservationDatasetWriter::wait,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Wait for all queued records to be written.)")
+      .def("close", &sim::ObservationDatasetWriter::close,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Write the queued records, close the last shard and stop the thread. Returns False if writing a shard failed.)");
+
+  py::class_<sim::ObservationDatasetReader,
+             sim::ObservationDatasetReader::ptr>(m, "ObservationDatasetReader",
+                                                 R"(
+        Random access to the memory-mapped shards of an
+        ObservationDatasetWriter, e.g. for the dataset of a data loader.
+        )")
+      .def(py::init(&sim::ObservationDatasetReader::create<>))
+      .def("open", &sim::ObservationDatasetReader::open, "directory"_a,
+           R"(Map the shards in directory. Returns False if there are none or one is malformed.)")
+      .def_property_readonly("num_records",
+                             &sim::ObservationDatasetReader::numRecords)
+      .def_property_readonly("fields", &sim::ObservationDatasetReader::fields)
+      .def("__len__", &sim::ObservationDatasetReader::numRecords)
+      .def(
+          "read",
+          [](sim::ObservationDatasetReader& self, std::size_t record,
+             const std::string& name) -> core::Buffer::ptr {
+            const int field = self.fieldIndex(name);
+            if (field < 0)
+              return nullptr;
+            const Corrade::Containers::ArrayView<const char> data =
+                self.read(record, field);
+            if (data.empty() && self.fieldSize(field) != 0)
+              return nullptr;
+            // a copy, the view is overwritten by reads of other chunks
+            const core::SharedMemoryRing::Field& info = self.fields()[field];
+            auto buffer =
+                std::make_shared<core::Buffer>(info.shape, info.dataType);
+            std::copy(data.begin(), data.end(), buffer->data.data());
+            return buffer;
+          },
+          "record"_a, "name"_a,
+          R"(A Buffer with a copy of a field of a record, None if there is no such record or field or it is malformed.)");
+
   // ==== Observation ====
-  py::class_<Observation, Observation::ptr>(m, "Observation");
+  py::class_<Observation, Observation::ptr>(m, "Observation")
+      .def(py::init(&Observation::create<>))
+      .def_readonly("buffer", &Observation::buffer);
 
   // TODO fill out other SensorTypes
   // ==== enum SensorType ====
@@ -44,7 +399,25 @@ void initSensorBindings(py::module& m) {
       .value("NONE", SensorType::NONE)
       .value("COLOR", SensorType::COLOR)
       .value("DEPTH", SensorType::DEPTH)
-      .value("SEMANTIC", SensorType::SEMANTIC);
+      .value("NORMAL", SensorType::NORMAL)
+      .value("SEMANTIC", SensorType::SEMANTIC)
+      .value("LIDAR", SensorType::LIDAR)
+      .value("OPTICAL_FLOW", SensorType::OPTICAL_FLOW);
+
+  // ==== enum ObservationFormat ====
+  py::enum_<ObservationFormat>(m, "ObservationFormat")
+      .value("DEFAULT", ObservationFormat::DEFAULT)
+      .value("RGB", ObservationFormat::RGB)
+      .value("GRAYSCALE", ObservationFormat::GRAYSCALE)
+      .value("HALF_DEPTH", ObservationFormat::HALF_DEPTH)
+      .value("MILLIMETER_DEPTH", ObservationFormat::MILLIMETER_DEPTH)
+      .value("SEMANTIC_CATEGORY", ObservationFormat::SEMANTIC_CATEGORY);
+
+  // ==== enum RenderQuality ====
+  py::enum_<RenderQuality>(m, "RenderQuality")
+      .value("FULL", RenderQuality::FULL)
+      .value("UNLIT", RenderQuality::UNLIT)
+      .value("VERTEX_COLOR", RenderQuality::VERTEX_COLOR);
 
   // ==== SensorSpec ====
   py::class_<SensorSpec, SensorSpec::ptr>(m, "SensorSpec", py::dynamic_attr())
@@ -59,6 +432,22 @@ void initSensorBindings(py::module& m) {
       .def_readwrite("channels", &SensorSpec::channels)
       .def_readwrite("encoding", &SensorSpec::encoding)
       .def_readwrite("gpu2gpu_transfer", &SensorSpec::gpu2gpuTransfer)
+      .def_readwrite("observation_format", &SensorSpec::observationFormat,
+                     R"(Pixel format of the observation, converted on the GPU
+                     before it is read back)")
+      .def_readwrite("downsampling", &SensorSpec::downsampling,
+                     R"(Factor the resolution is downsampled by on the GPU for
+                     the observation, averaging each square of pixels)")
+      .def_readwrite("samples", &SensorSpec::samples,
+                     R"(Number of MSAA samples per pixel to draw with, resolved
+                     on the GPU before the readback)")
+      .def_readwrite("render_quality", &SensorSpec::renderQuality,
+                     R"(Shading tier to draw the scene with, UNLIT and
+                     VERTEX_COLOR skip the lighting and texture fetches)")
+      .def_readwrite("update_period", &SensorSpec::updatePeriod,
+                     R"(The sensor observes in every update_period-th call
+                     of get_agent_observations and returns its last
+                     observation in the others, with 0 only on demand)")
       .def_readwrite("observation_space", &SensorSpec::observationSpace)
       .def_readwrite("noise_model", &SensorSpec::noiseModel)
       .def_property(
@@ -72,6 +461,14 @@ void initSensorBindings(py::module& m) {
           },
           [](SensorSpec& self, py::dict v) {
             py::setattr(py::cast(self), "__noise_model_kwargs", v);
+            // mirrored for the session recordings
+            py::object dumps = py::module::import("json").attr("dumps");
+            py::object repr = py::module::import("builtins").attr("repr");
+            self.noiseModelKwargs.clear();
+            for (const auto& item : v) {
+              self.noiseModelKwargs[py::str(item.first)] =
+                  dumps(item.second, "default"_a = repr).cast<std::string>();
+            }
           })
       .def("__eq__",
            [](const SensorSpec& self, const SensorSpec& other) -> bool {
@@ -89,7 +486,43 @@ void initSensorBindings(py::module& m) {
       .def("specification", &Sensor::specification)
       .def("set_transformation_from_spec", &Sensor::setTransformationFromSpec)
       .def("is_visual_sensor", &Sensor::isVisualSensor)
-      .def("get_observation", &Sensor::getObservation)
+      .def("get_observation", &Sensor::getObservation,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "bind_observation_buffer",
+          [](Sensor& self, py::buffer buffer) {
+            ObservationSpace space;
+            if (!self.getObservationSpace(space))
+              throw py::value_error{"sensor has no observation space"};
+
+            py::buffer_info info = buffer.request(true);
+            const std::size_t itemSize =
+                core::getDataTypeByteSize(space.dataType);
+            const std::vector<std::size_t> shape(info.shape.begin(),
+                                                 info.shape.end());
+            const std::vector<std::size_t> strides(info.strides.begin(),
+                                                   info.strides.end());
+            if (info.format != dataTypeFormat(space.dataType) ||
+                static_cast<std::size_t>(info.itemsize) != itemSize)
+              throw py::value_error{
+                  "buffer data type does not match the observation space"};
+            if (shape != space.shape)
+              throw py::value_error{
+                  "buffer shape does not match the observation space"};
+            if (strides != contiguousStrides(shape, itemSize))
+              throw py::value_error{"buffer must be C-contiguous"};
+
+            self.bindObservationBuffer(
+                core::Buffer::create(info.ptr, shape, space.dataType));
+          },
+          "buffer"_a, py::keep_alive<1, 2>(),
+          R"(
+            Read all following observations of this sensor directly into the
+            memory of a writable, C-contiguous buffer, e.g. a numpy array or
+            the .numpy() view of a (pinned) CPU torch tensor, without any
+            intermediate copy.  Its shape and dtype must match the observation
+            space of the sensor.  The buffer is kept alive by the sensor.
+          )")
       .def_property_readonly("node", nodeGetter<Sensor>,
                              "Node this object is attached to")
       .def_property_readonly("object", nodeGetter<Sensor>, "Alias to node");
@@ -107,7 +540,67 @@ void initSensorBindings(py::module& m) {
       m, "PinholeCamera")
       // initialized, attached to pinholeCameraNode, status: "valid"
       .def(py::init_alias<std::reference_wrapper<scene::SceneNode>,
-                          const SensorSpec::ptr&>());
+                          const SensorSpec::ptr&>())
+      .def_property_readonly("has_converted_observation",
+                             &PinholeCamera::hasConvertedObservation)
+      .def_property_readonly("observation_size",
+                             &PinholeCamera::observationSize)
+      .def(
+          "read_observation",
+          [](PinholeCamera& self, Observation& obs) {
+            return self.readObservationFrom(self.renderTarget(), obs);
+          },
+          R"(Read the observation drawn last, converted if the spec has an
+          observation format or downsampling, and resampled for an
+          equirectangular sensor)",
+          py::call_guard<py::gil_scoped_release>());
+
+  // ==== CubeMapCamera (subclass of PinholeCamera) ====
+  py::class_<CubeMapCamera, Magnum::SceneGraph::PyFeature<CubeMapCamera>,
+             PinholeCamera, Magnum::SceneGraph::PyFeatureHolder<CubeMapCamera>>(
+      m, "CubeMapCamera")
+      .def(py::init_alias<std::reference_wrapper<scene::SceneNode>,
+                          const SensorSpec::ptr&>())
+      .def_static("is_cube_map_spec",
+                  [](const SensorSpec::ptr& spec) {
+                    return CubeMapCamera::isCubeMapSpec(*spec);
+                  })
+      .def_property_readonly("face_size", &CubeMapCamera::faceSize)
+      .def_property_readonly("is_equirectangular",
+                             &CubeMapCamera::isEquirectangular)
+      .def("draw_observation", &CubeMapCamera::drawObservation,
+           R"(Draw all faces into the render target)",
+           py::call_guard<py::gil_scoped_release>());
+
+  // ==== TopDownMapCamera (subclass of PinholeCamera) ====
+  py::class_<TopDownMapCamera, Magnum::SceneGraph::PyFeature<TopDownMapCamera>,
+             PinholeCamera,
+             Magnum::SceneGraph::PyFeatureHolder<TopDownMapCamera>>(
+      m, "TopDownMapCamera")
+      .def(py::init_alias<std::reference_wrapper<scene::SceneNode>,
+                          const SensorSpec::ptr&>())
+      .def_static("is_top_down_map_spec",
+                  [](const SensorSpec::ptr& spec) {
+                    return TopDownMapCamera::isTopDownMapSpec(*spec);
+                  })
+      .def_property_readonly("meters_per_pixel",
+                             &TopDownMapCamera::metersPerPixel)
+      .def_property_readonly("slab_height", &TopDownMapCamera::slabHeight)
+      .def("draw_observation", &TopDownMapCamera::drawObservation,
+           R"(Draw the navmesh around the sensor into the render target)",
+           py::call_guard<py::gil_scoped_release>());
+
+  // ==== LidarSensor ====
+  py::class_<LidarSensor, Magnum::SceneGraph::PyFeature<LidarSensor>, Sensor,
+             Magnum::SceneGraph::PyFeatureHolder<LidarSensor>>(m,
+                                                               "LidarSensor")
+      .def(py::init_alias<std::reference_wrapper<scene::SceneNode>,
+                          const SensorSpec::ptr&>())
+      .def_static("is_lidar_spec",
+                  [](const SensorSpec::ptr& spec) {
+                    return LidarSensor::isLidarSpec(*spec);
+                  })
+      .def_property_readonly("max_range", &LidarSensor::maxRange);
 
   // ==== SensorSuite ====
   py::class_<SensorSuite, SensorSuite::ptr>(m, "SensorSuite")
@@ -115,18 +608,126 @@ void initSensorBindings(py::module& m) {
       .def("add", &SensorSuite::add)
       .def("get", &SensorSuite::get, R"(get the sensor by id)");
 
+  py::class_<RedwoodNoiseModelCPUImpl, RedwoodNoiseModelCPUImpl::uptr>(
+      m, "RedwoodNoiseModelCPUImpl")
+      .def(py::init(&RedwoodNoiseModelCPUImpl::create_unique<
+                    const Eigen::Ref<const Eigen::RowMatrixXf>&, float>))
+      .def(py::init(&RedwoodNoiseModelCPUImpl::create_unique<
+                    const Eigen::Ref<const Eigen::RowMatrixXf>&, float,
+                    uint32_t, int>),
+           "model"_a, "noise_multiplier"_a, "seed"_a, "num_threads"_a = 0)
+      .def("simulate_from_cpu", &RedwoodNoiseModelCPUImpl::simulateFromCPU,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "simulate_in_place",
+          [](RedwoodNoiseModelCPUImpl& self, py::array depth, bool flipped) {
+            // a converted copy would get the noise instead of the frames
+            if (!depth.dtype().equal(py::dtype::of<float>()) ||
+                !(depth.flags() & py::array::c_style) || depth.ndim() < 2)
+              throw py::value_error{
+                  "expected C-contiguous float32 frames of rows and columns"};
+            const int rows = depth.shape(depth.ndim() - 2);
+            const int cols = depth.shape(depth.ndim() - 1);
+            const int numFrames = depth.size() / std::max(rows * cols, 1);
+            float* data = static_cast<float*>(depth.mutable_data());
+            py::gil_scoped_release release;
+            self.simulateInPlace(data, rows, cols, numFrames, flipped);
+          },
+          "depth"_a, "flipped"_a = false,
+          R"(Replace a batch of C-contiguous float32 depth frames with their noisy version, the last two dimensions being rows and columns.)")
+      .def_property_readonly("num_frames",
+                             &RedwoodNoiseModelCPUImpl::getNumFrames);
+
 #ifdef ESP_BUILD_WITH_CUDA
   py::class_<RedwoodNoiseModelGPUImpl, RedwoodNoiseModelGPUImpl::uptr>(
       m, "RedwoodNoiseModelGPUImpl")
       .def(py::init(&RedwoodNoiseModelGPUImpl::create_unique<
                     const Eigen::Ref<const Eigen::RowMatrixXf>&, int, float>))
+      .def(py::init(&RedwoodNoiseModelGPUImpl::create_unique<
+                    const Eigen::Ref<const Eigen::RowMatrixXf>&, int, float,
+                    uint32_t>),
+           "model"_a, "gpu_device_id"_a, "noise_multiplier"_a, "seed"_a)
       .def("simulate_from_cpu", &RedwoodNoiseModelGPUImpl::simulateFromCPU)
+      .def_property_readonly("gpu_bytes",
+                             &RedwoodNoiseModelGPUImpl::getGpuBytes)
+      .def_static("get_total_gpu_bytes",
+                  &RedwoodNoiseModelGPUImpl::getTotalGpuBytes)
+      .def_property_readonly("num_frames",
+                             &RedwoodNoiseModelGPUImpl::getNumFrames)
       .def("simulate_from_gpu", [](RedwoodNoiseModelGPUImpl& self,
                                    std::size_t devDepth, const int rows,
                                    const int cols, std::size_t devNoisyDepth) {
         self.simulateFromGPU(reinterpret_cast<const float*>(devDepth), rows,
                              cols, reinterpret_cast<float*>(devNoisyDepth));
-      });
+      })
+      .def(
+          "simulate_in_place_from_gpu",
+          [](RedwoodNoiseModelGPUImpl& self, std::size_t devDepth,
+             const int rows, const int cols, const int numFrames,
+             const bool flipped, std::size_t cudaStream) {
+            self.simulateInPlaceFromGPU(reinterpret_cast<float*>(devDepth),
+                                        rows, cols, numFrames, flipped,
+                                        reinterpret_cast<void*>(cudaStream));
+          },
+          "dev_depth"_a, "rows"_a, "cols"_a, "num_frames"_a = 1,
+          "flipped"_a = false, "cuda_stream"_a = 0);
+
+  py::enum_<RgbNoiseType>(m, "RgbNoiseType")
+      .value("GAUSSIAN", RgbNoiseType::Gaussian)
+      .value("SALT_AND_PEPPER", RgbNoiseType::SaltAndPepper)
+      .value("POISSON", RgbNoiseType::Poisson);
+
+  py::class_<RgbNoiseParameters>(m, "RgbNoiseParameters")
+      .def(py::init<>())
+      .def_readwrite("type", &RgbNoiseParameters::type)
+      .def_readwrite("intensity_constant",
+                     &RgbNoiseParameters::intensityConstant)
+      .def_readwrite("mean", &RgbNoiseParameters::mean)
+      .def_readwrite("sigma", &RgbNoiseParameters::sigma)
+      .def_readwrite("s_vs_p", &RgbNoiseParameters::saltVsPepper)
+      .def_readwrite("amount", &RgbNoiseParameters::amount);
+
+  py::class_<RgbNoiseModelGPUImpl, RgbNoiseModelGPUImpl::uptr>(
+      m, "RgbNoiseModelGPUImpl")
+      .def(py::init(&RgbNoiseModelGPUImpl::create_unique<
+                    const RgbNoiseParameters&, int>))
+      .def(py::init(&RgbNoiseModelGPUImpl::create_unique<
+                    const RgbNoiseParameters&, int, uint32_t>),
+           "parameters"_a, "gpu_device_id"_a, "seed"_a)
+      .def("simulate_from_cpu",
+           [](RgbNoiseModelGPUImpl& self,
+              py::array_t<uint8_t, py::array::c_style | py::array::forcecast>
+                  image) {
+             if (image.ndim() != 3)
+               throw py::value_error("Expected an H x W x C image");
+             py::array_t<uint8_t> noisy{
+                 {image.shape(0), image.shape(1), image.shape(2)}};
+             self.simulateFromCPU(image.data(), image.shape(0),
+                                  image.shape(1), image.shape(2),
+                                  noisy.mutable_data());
+             return noisy;
+           })
+      .def_property_readonly("gpu_bytes", &RgbNoiseModelGPUImpl::getGpuBytes)
+      .def_static("get_total_gpu_bytes",
+                  &RgbNoiseModelGPUImpl::getTotalGpuBytes)
+      .def("simulate_from_gpu",
+           [](RgbNoiseModelGPUImpl& self, std::size_t devImage, const int rows,
+              const int cols, const int channels, std::size_t devNoisyImage) {
+             self.simulateFromGPU(reinterpret_cast<const uint8_t*>(devImage),
+                                  rows, cols, channels,
+                                  reinterpret_cast<uint8_t*>(devNoisyImage));
+           })
+      .def(
+          "simulate_in_place_from_gpu",
+          [](RgbNoiseModelGPUImpl& self, std::size_t devImage, const int rows,
+             const int cols, const int channels, const int numFrames,
+             std::size_t cudaStream) {
+            self.simulateInPlaceFromGPU(reinterpret_cast<uint8_t*>(devImage),
+                                        rows, cols, channels, numFrames,
+                                        reinterpret_cast<void*>(cudaStream));
+          },
+          "dev_image"_a, "rows"_a, "cols"_a, "channels"_a, "num_frames"_a = 1,
+          "cuda_stream"_a = 0);
 #endif
 }
 
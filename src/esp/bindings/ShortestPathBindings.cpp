@@ -23,6 +23,26 @@ using py::literals::operator""_a;
 namespace esp {
 namespace nav {
 
+namespace {
+typedef Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> PointsArray;
+
+std::vector<vec3f> toPoints(const PointsArray& pts) {
+  std::vector<vec3f> points(pts.rows());
+  for (int i = 0; i < pts.rows(); ++i) {
+    points[i] = pts.row(i).transpose();
+  }
+  return points;
+}
+
+PointsArray toPointsArray(const std::vector<vec3f>& points) {
+  PointsArray pts(points.size(), 3);
+  for (size_t i = 0; i < points.size(); ++i) {
+    pts.row(i) = points[i].transpose();
+  }
+  return pts;
+}
+}  // namespace
+
 void initShortestPathBindings(py::module& m) {
   py::class_<HitRecord>(m, "HitRecord")
       .def(py::init())
@@ -47,6 +67,12 @@ void initShortestPathBindings(py::module& m) {
       .def_readwrite("geodesic_distance",
                      &MultiGoalShortestPath::geodesicDistance);
 
+  py::class_<GeodesicDistanceField, GeodesicDistanceField::ptr>(
+      m, "GeodesicDistanceField",
+      R"(Precomputed geodesic distances to the closest of a fixed set of goals,
+      see PathFinder.build_geodesic_distance_field())")
+      .def_property_readonly("goals", &GeodesicDistanceField::getGoals);
+
   py::class_<NavMeshSettings, NavMeshSettings::ptr>(m, "NavMeshSettings")
       .def(py::init(&NavMeshSettings::create<>))
       .def_readwrite("cell_size", &NavMeshSettings::cellSize)
@@ -68,6 +94,14 @@ void initShortestPathBindings(py::module& m) {
       .def_readwrite("filter_ledge_spans", &NavMeshSettings::filterLedgeSpans)
       .def_readwrite("filter_walkable_low_height_spans",
                      &NavMeshSettings::filterWalkableLowHeightSpans)
+      .def_readwrite("cull_input_triangles",
+                     &NavMeshSettings::cullInputTriangles,
+                     R"(Whether duplicate triangles, and triangles too far
+                     above every walkable surface to block the agent, are left
+                     out of the rasterization. Gives the same navmesh faster.)")
+      .def_readwrite("tile_size", &NavMeshSettings::tileSize,
+                     R"(Tile size in voxels, 0 builds a single tile which
+                     Simulator.update_navmesh_region() cannot update.)")
       .def("set_defaults", &NavMeshSettings::setDefaults);
 
   py::class_<PathFinder, PathFinder::ptr>(m, "PathFinder")
@@ -75,14 +109,146 @@ void initShortestPathBindings(py::module& m) {
       .def("get_bounds", &PathFinder::bounds)
       .def("seed", &PathFinder::seed)
       .def("get_topdown_view", &PathFinder::getTopDownView,
+           py::call_guard<py::gil_scoped_release>(),
            R"(Returns the topdown view of the PathFinder's navmesh.)",
            "meters_per_pixel"_a, "height"_a)
-      .def("get_random_navigable_point", &PathFinder::getRandomNavigablePoint)
+      .def("get_random_navigable_point", &PathFinder::getRandomNavigablePoint,
+           R"(Returns a random navigable point, optionally restricted to an
+           island.)",
+           "island_index"_a = ID_UNDEFINED)
+      .def("sample_navigable_points", &PathFinder::sampleNavigablePoints,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Returns num_points random navigable points, optionally restricted
+           to an island.)",
+           "num_points"_a, "island_index"_a = ID_UNDEFINED)
+      .def("get_island_index", &PathFinder::getIslandIndex,
+           R"(Returns the island of a point, or -1 if it is not navigable.)",
+           "pt"_a)
+      .def_property_readonly("num_islands", &PathFinder::numIslands)
       .def("find_path", py::overload_cast<ShortestPath&>(&PathFinder::findPath),
-           "path"_a)
+           "path"_a, py::call_guard<py::gil_scoped_release>())
       .def("find_path",
            py::overload_cast<MultiGoalShortestPath&>(&PathFinder::findPath),
-           "path"_a)
+           "path"_a, py::call_guard<py::gil_scoped_release>())
+      .def("set_path_cache_size", &PathFinder::setPathCacheSize, "size"_a,
+           R"(Keep the results of the last size distinct find_path() queries of
+          a ShortestPath, answering repeated queries with the same start and
+          end without a search. Cleared when the navmesh changes, 0 disables
+          it.)")
+      .def_property_readonly("path_cache_size", &PathFinder::getPathCacheSize)
+      .def_property_readonly("path_cache_hits", &PathFinder::getPathCacheHits)
+      .def_property_readonly("path_cache_misses",
+                             &PathFinder::getPathCacheMisses)
+      .def(
+          "find_paths_batch",
+          [](PathFinder& self, const std::vector<ShortestPath*>& paths,
+             int numThreads) {
+            // the Python objects can't be touched without the GIL, so work on
+            // copies
+            std::vector<ShortestPath> batch;
+            batch.reserve(paths.size());
+            for (const ShortestPath* path : paths) {
+              batch.push_back(*path);
+            }
+            {
+              py::gil_scoped_release release;
+              self.findPathsBatch(batch, numThreads);
+            }
+            for (size_t i = 0; i < paths.size(); ++i) {
+              *paths[i] = std::move(batch[i]);
+            }
+          },
+          "paths"_a, "num_threads"_a = 0,
+          R"(Find the shortest paths of a list of ShortestPath in parallel on
+          num_threads threads, all hardware threads if 0. Releases the GIL
+          while searching.)")
+      .def("find_distances_batch", &PathFinder::findDistancesBatch,
+           "starts"_a, "ends"_a, "num_threads"_a = 0,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Geodesic distances from starts[i] to ends[i] for all i, computed
+          in parallel on num_threads threads. inf where no path exists.
+          Releases the GIL while searching.)")
+      .def(
+          "snap_points_batch",
+          [](PathFinder& self, const PointsArray& pts, int numThreads) {
+            const std::vector<vec3f> points = toPoints(pts);
+            std::vector<vec3f> snapped;
+            {
+              py::gil_scoped_release release;
+              snapped = self.snapPointsBatch(points, numThreads);
+            }
+            return toPointsArray(snapped);
+          },
+          "pts"_a, "num_threads"_a = 0,
+          R"(Snaps an Nx3 array of points to the navmesh in parallel on
+          num_threads threads, returning an Nx3 array with NaN rows where no
+          point was close enough. Releases the GIL while snapping.)")
+      .def(
+          "is_navigable_batch",
+          [](PathFinder& self, const PointsArray& pts, float maxYDelta,
+             int numThreads) {
+            const std::vector<vec3f> points = toPoints(pts);
+            Eigen::Matrix<bool, Eigen::Dynamic, 1> navigable;
+            {
+              py::gil_scoped_release release;
+              navigable = self.isNavigableBatch(points, maxYDelta, numThreads);
+            }
+            return navigable;
+          },
+          "pts"_a, "max_y_delta"_a = 0.5, "num_threads"_a = 0,
+          R"(Whether each point of an Nx3 array is navigable, as an array of N
+          bools computed in parallel on num_threads threads. Releases the GIL
+          while checking.)")
+      .def(
+          "try_steps_batch",
+          [](PathFinder& self, const PointsArray& starts,
+             const PointsArray& ends, bool allowSliding, int numThreads) {
+            const std::vector<vec3f> startPoints = toPoints(starts);
+            const std::vector<vec3f> endPoints = toPoints(ends);
+            if (startPoints.size() != endPoints.size()) {
+              throw py::value_error{
+                  "try_steps_batch: expected as many starts as ends"};
+            }
+            std::vector<vec3f> steps;
+            {
+              py::gil_scoped_release release;
+              steps = self.tryStepsBatch(startPoints, endPoints, allowSliding,
+                                         numThreads);
+            }
+            return toPointsArray(steps);
+          },
+          "starts"_a, "ends"_a, "allow_sliding"_a = true, "num_threads"_a = 0,
+          R"(try_step, or try_step_no_sliding if allow_sliding is False, from
+          each row of an Nx3 array of starts towards the same row of ends, in
+          parallel on num_threads threads. Returns the Nx3 array of reached
+          points and releases the GIL while stepping.)")
+      .def("build_geodesic_distance_field",
+           &PathFinder::buildGeodesicDistanceField, "goals"_a,
+           "samples_per_portal"_a = 3, py::call_guard<py::gil_scoped_release>(),
+           R"(Precompute the geodesic distances to the closest of goals for
+          O(1) lookups with geodesic_distance().)")
+      .def("geodesic_distance", &PathFinder::geodesicDistance, "field"_a,
+           "pt"_a,
+           R"(Geodesic distance from pt to the closest goal of a
+          GeodesicDistanceField built on the current navmesh.)")
+      .def(
+          "geodesic_distance_matrix",
+          [](PathFinder& self, const PointsArray& pts, int samplesPerPortal,
+             int numThreads) {
+            const std::vector<vec3f> points = toPoints(pts);
+            Eigen::MatrixXf distances;
+            {
+              py::gil_scoped_release release;
+              distances = self.geodesicDistanceMatrix(points, samplesPerPortal,
+                                                      numThreads);
+            }
+            return distances;
+          },
+          "pts"_a, "samples_per_portal"_a = 3, "num_threads"_a = 0,
+          R"(NxN matrix of the geodesic distances between all pairs of an Nx3
+          array of points, with the approximation of geodesic_distance(),
+          computed in parallel on num_threads threads and inf where no path
+          exists. Releases the GIL while searching.)")
       .def("try_step", &PathFinder::tryStep<Magnum::Vector3>, "start"_a,
            "end"_a)
       .def("try_step", &PathFinder::tryStep<vec3f>, "start"_a, "end"_a)
@@ -94,9 +260,37 @@ void initShortestPathBindings(py::module& m) {
       .def("snap_point", &PathFinder::snapPoint<vec3f>)
       .def("island_radius", &PathFinder::islandRadius, "pt"_a)
       .def_property_readonly("is_loaded", &PathFinder::isLoaded)
+      .def("compress", &PathFinder::compress,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Compresses the navmesh tiles in memory and frees everything derived
+          from them, for pathfinders not in use. The first query needing the
+          navmesh decompresses it again.)")
+      .def_property_readonly("is_compressed", &PathFinder::isCompressed)
+      .def_property_readonly("tile_data_bytes", &PathFinder::getTileDataBytes)
+      .def("stream_tiles", &PathFinder::streamTiles, "points"_a, "radius"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Keeps only the navmesh tiles within radius of the points resident,
+          compressing the others in memory. Returns the number of tiles
+          evicted or restored.)")
+      .def_property_readonly("num_evicted_tiles",
+                             &PathFinder::getNumEvictedTiles)
       .def_property_readonly("navigable_area", &PathFinder::getNavigableArea)
-      .def("load_nav_mesh", &PathFinder::loadNavMesh)
-      .def("save_nav_mesh", &PathFinder::saveNavMesh, "path"_a)
+      .def("load_nav_mesh", &PathFinder::loadNavMesh,
+           py::call_guard<py::gil_scoped_release>())
+      .def("save_nav_mesh", &PathFinder::saveNavMesh, "path"_a,
+           "mappable"_a = false, py::call_guard<py::gil_scoped_release>(),
+           R"(Saves the navmesh. With mappable, in a format which is memory
+          mapped on load and shared between processes, but which older
+          versions can't read.)")
+      .def_static("save_nav_mesh_variants", &PathFinder::saveNavMeshVariants,
+                  "pathfinders"_a, "path"_a,
+                  py::call_guard<py::gil_scoped_release>(),
+                  R"(Saves the navmeshes of several pathfinders, e.g. from
+          Simulator.recompute_navmesh_variants, into one file.)")
+      .def_static("load_nav_mesh_variants", &PathFinder::loadNavMeshVariants,
+                  "path"_a, py::call_guard<py::gil_scoped_release>(),
+                  R"(Loads the pathfinders saved by save_nav_mesh_variants, an
+          empty list if the file could not be loaded.)")
       .def("distance_to_closest_obstacle",
            &PathFinder::distanceToClosestObstacle,
            R"(Returns the distance to the closest obstacle.)", "pt"_a,
@@ -106,6 +300,47 @@ void initShortestPathBindings(py::module& m) {
            R"(Returns the hit_pos, hit_normal and hit_dist of the surface point
           on the closest obstacle.)",
            "pt"_a, "max_search_radius"_a = 2.0)
+      .def(
+          "distances_to_closest_obstacle",
+          [](const PathFinder& self, const PointsArray& pts,
+             float maxSearchRadius) {
+            const std::vector<vec3f> points = toPoints(pts);
+            std::vector<float> distances;
+            {
+              py::gil_scoped_release release;
+              distances =
+                  self.distancesToClosestObstacle(points, maxSearchRadius);
+            }
+            return Eigen::VectorXf{
+                Eigen::Map<const Eigen::VectorXf>(distances.data(),
+                                                  distances.size())};
+          },
+          R"(Returns the distances to the closest obstacle of an Nx3 array of
+          points as an array of N distances.)",
+          "pts"_a, "max_search_radius"_a = 2.0)
+      .def("build_obstacle_distance_field",
+           &PathFinder::buildObstacleDistanceField,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Precomputes the distances to the closest obstacle on a grid of
+          cell_size, up to max_distance, to speed up the obstacle distance
+          queries. Their error is bounded by
+          obstacle_distance_field_max_error.)",
+           "cell_size"_a = 0.05, "max_distance"_a = 2.0)
+      .def_property_readonly("has_obstacle_distance_field",
+                             &PathFinder::hasObstacleDistanceField)
+      .def_property_readonly("obstacle_distance_field_max_error",
+                             &PathFinder::obstacleDistanceFieldMaxError)
+      .def("build_path_hierarchy", &PathFinder::buildPathHierarchy,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Cluster the navmesh in cells of cluster_size meters, so that
+          long paths are searched between the clusters first and then refined
+          in short segments, at a cost growing with their length instead of
+          the navmesh size. The paths can be slightly longer.)",
+           "cluster_size"_a = 8.0)
+      .def_property_readonly("has_path_hierarchy",
+                             &PathFinder::hasPathHierarchy)
+      .def_property_readonly("num_path_clusters",
+                             &PathFinder::numPathClusters)
       .def("is_navigable", &PathFinder::isNavigable,
            R"(Checks to see if the agent can stand at the specified point.)",
            "pt"_a, "max_y_delta"_a = 0.5);
@@ -133,20 +368,40 @@ void initShortestPathBindings(py::module& m) {
            py::overload_cast<const Mn::Quaternion&, const Mn::Vector3&,
                              const Mn::Vector3&>(
                &GreedyGeodesicFollowerImpl::nextActionAlong),
-           py::return_value_policy::move)
+           py::return_value_policy::move,
+           py::call_guard<py::gil_scoped_release>())
       .def("next_action_along",
            py::overload_cast<const core::RigidState&, const Mn::Vector3&>(
                &GreedyGeodesicFollowerImpl::nextActionAlong),
-           py::return_value_policy::move)
+           py::return_value_policy::move,
+           py::call_guard<py::gil_scoped_release>())
       .def("find_path",
            py::overload_cast<const Mn::Quaternion&, const Mn::Vector3&,
                              const Mn::Vector3&>(
                &GreedyGeodesicFollowerImpl::findPath),
-           py::return_value_policy::move)
+           py::return_value_policy::move,
+           py::call_guard<py::gil_scoped_release>())
       .def("find_path",
            py::overload_cast<const core::RigidState&, const Mn::Vector3&>(
                &GreedyGeodesicFollowerImpl::findPath),
-           py::return_value_policy::move)
+           py::return_value_policy::move,
+           py::call_guard<py::gil_scoped_release>())
+      .def("find_paths_batch", &GreedyGeodesicFollowerImpl::findPathsBatch,
+           "starts"_a, "ends"_a, "num_threads"_a = 0,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Finds the actions from starts[i] to ends[i] for all i, planned
+          in parallel on num_threads threads. Empty where no path was found.
+          The move functions are called from the worker threads.)")
+      .def("precompute_actions", &GreedyGeodesicFollowerImpl::precomputeActions,
+           "end"_a, "cell_size"_a = 0.1f, "num_threads"_a = 0,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Plans the next action toward end for the cells of a grid of
+          cell_size over the navmesh and every heading, on num_threads
+          threads. next_action_along toward end then looks its action up.)")
+      .def("has_precomputed_actions",
+           &GreedyGeodesicFollowerImpl::hasPrecomputedActions, "end"_a)
+      .def("clear_precomputed_actions",
+           &GreedyGeodesicFollowerImpl::clearPrecomputedActions)
       .def("reset", &GreedyGeodesicFollowerImpl::reset);
 }
 
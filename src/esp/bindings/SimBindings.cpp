@@ -4,6 +4,8 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/functional.h>
+
 #include <Magnum/ImageView.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
@@ -14,8 +16,15 @@
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/Renderer.h"
 #include "esp/scene/SemanticScene.h"
+#ifdef ESP_BUILD_WITH_CUDA
+#include "esp/sensor/RedwoodNoiseModel.h"
+#include "esp/sensor/RgbNoiseModel.h"
+#endif
+#include "esp/sim/EpisodeScheduler.h"
 #include "esp/sim/Simulator.h"
 #include "esp/sim/SimulatorConfiguration.h"
+#include "esp/sim/SimulatorServer.h"
+#include "esp/sim/VectorSimulator.h"
 
 namespace py = pybind11;
 using py::literals::operator""_a;
@@ -24,6 +33,13 @@ namespace esp {
 namespace sim {
 
 void initSimBindings(py::module& m) {
+  py::enum_<assets::InstanceMeshCpuData>(
+      m, "InstanceMeshCpuData",
+      R"(What CPU-side data the semantic instance meshes keep once drawn.)")
+      .value("ALL", assets::InstanceMeshCpuData::All)
+      .value("COLLISION", assets::InstanceMeshCpuData::Collision)
+      .value("NONE", assets::InstanceMeshCpuData::None);
+
   // ==== SimulatorConfiguration ====
   py::class_<SimulatorConfiguration, SimulatorConfiguration::ptr>(
       m, "SimulatorConfiguration")
@@ -35,21 +51,95 @@ void initSimBindings(py::module& m) {
       .def_readwrite("default_camera_uuid",
                      &SimulatorConfiguration::defaultCameraUuid)
       .def_readwrite("gpu_device_id", &SimulatorConfiguration::gpuDeviceId)
+      .def_readwrite("gpu_device_policy",
+                     &SimulatorConfiguration::gpuDevicePolicy)
+      .def_readwrite("software_rendering",
+                     &SimulatorConfiguration::softwareRendering)
+      .def_readwrite("software_rendering_threads",
+                     &SimulatorConfiguration::softwareRenderingThreads)
       .def_readwrite("allow_sliding", &SimulatorConfiguration::allowSliding)
       .def_readwrite("create_renderer", &SimulatorConfiguration::createRenderer)
       .def_readwrite("frustum_culling", &SimulatorConfiguration::frustumCulling)
+      .def_readwrite("instanced_object_rendering",
+                     &SimulatorConfiguration::instancedObjectRendering)
+      .def_readwrite("asset_cache_cpu_budget",
+                     &SimulatorConfiguration::assetCacheCpuBudget)
+      .def_readwrite("asset_cache_gpu_budget",
+                     &SimulatorConfiguration::assetCacheGpuBudget)
+      .def_readwrite("resident_scenes", &SimulatorConfiguration::residentScenes)
+      .def_readwrite("ptex_atlas_streaming",
+                     &SimulatorConfiguration::ptexAtlasStreaming)
+      .def_readwrite("ptex_atlas_budget",
+                     &SimulatorConfiguration::ptexAtlasBudget)
+      .def_readwrite("ptex_geometry_shader",
+                     &SimulatorConfiguration::ptexGeometryShader)
+      .def_readwrite("texture_transcode_cache_dir",
+                     &SimulatorConfiguration::textureTranscodeCacheDir)
+      .def_readwrite("program_binary_cache_dir",
+                     &SimulatorConfiguration::programBinaryCacheDir)
+      .def_readwrite("max_texture_size",
+                     &SimulatorConfiguration::maxTextureSize)
+      .def_readwrite("compact_vertex_format",
+                     &SimulatorConfiguration::compactVertexFormat)
+      .def_readwrite("shared_mesh_arena",
+                     &SimulatorConfiguration::sharedMeshArena)
+      .def_readwrite("instance_mesh_cpu_data",
+                     &SimulatorConfiguration::instanceMeshCpuData)
+      .def_readwrite("texture_array_size",
+                     &SimulatorConfiguration::textureArraySize)
+      .def_readwrite("level_of_detail_count",
+                     &SimulatorConfiguration::levelOfDetailCount)
+      .def_readwrite("level_of_detail_pixel_error",
+                     &SimulatorConfiguration::levelOfDetailPixelError)
+      .def_readwrite("pipelined_step", &SimulatorConfiguration::pipelinedStep)
+      .def_readwrite("fused_depth_unprojection",
+                     &SimulatorConfiguration::fusedDepthUnprojection)
+      .def_readwrite("stage_chunk_load_radius",
+                     &SimulatorConfiguration::stageChunkLoadRadius)
+      .def_readwrite("stage_chunk_evict_radius",
+                     &SimulatorConfiguration::stageChunkEvictRadius)
       .def_readwrite("enable_physics", &SimulatorConfiguration::enablePhysics)
+      .def_readwrite("render_only", &SimulatorConfiguration::renderOnly)
       .def_readwrite("physics_config_file",
                      &SimulatorConfiguration::physicsConfigFile)
       .def_readwrite("scene_light_setup",
                      &SimulatorConfiguration::sceneLightSetup)
       .def_readwrite("load_semantic_mesh",
                      &SimulatorConfiguration::loadSemanticMesh)
+      .def_readwrite("semantic_vertex_ids",
+                     &SimulatorConfiguration::semanticVertexIds)
       .def_readwrite("requires_textures",
                      &SimulatorConfiguration::requiresTextures)
       .def(py::self == py::self)
       .def(py::self != py::self);
 
+  // ==== StageStreamer ====
+  py::class_<assets::StageStreamer, assets::StageStreamer::ptr>(
+      m, "StageStreamer",
+      R"(Keeps the chunks of a stage too large to be resident loaded around the agents, with their collision and navmesh tiles.)")
+      .def_property_readonly("num_chunks",
+                             &assets::StageStreamer::getNumChunks)
+      .def_property_readonly("num_resident_chunks",
+                             &assets::StageStreamer::getNumResidentChunks)
+      .def_property_readonly("num_loading_chunks",
+                             &assets::StageStreamer::getNumLoadingChunks)
+      .def("is_chunk_resident", &assets::StageStreamer::isChunkResident,
+           "chunk"_a);
+
+  // ==== ViewCache ====
+  py::class_<ViewCache, ViewCache::ptr>(m, "ViewCache", R"(
+        A disk-backed cache of the observations of visual sensors, by scene,
+        sensor specification and pose quantized to position_step meters and
+        rotation_step per quaternion component. Several simulators and
+        processes may share a directory.
+        )")
+      .def(py::init(&ViewCache::create<const std::string&, float, float>),
+           "directory"_a, "position_step"_a = 0.001f,
+           "rotation_step"_a = 0.0005f)
+      .def_property_readonly("directory", &ViewCache::directory)
+      .def_property_readonly("position_step", &ViewCache::positionStep)
+      .def_property_readonly("rotation_step", &ViewCache::rotationStep);
+
   // ==== Simulator ====
   py::class_<Simulator, Simulator::ptr>(m, "Simulator")
       .def(py::init<const SimulatorConfiguration&>())
@@ -69,8 +159,31 @@ void initSimBindings(py::module& m) {
             )")
       .def_property_readonly("renderer", &Simulator::getRenderer)
       .def("seed", &Simulator::seed, "new_seed"_a)
-      .def("reconfigure", &Simulator::reconfigure, "configuration"_a)
-      .def("reset", &Simulator::reset)
+      .def("reconfigure", &Simulator::reconfigure, "configuration"_a,
+           py::call_guard<py::gil_scoped_release>())
+      .def("prefetch_scene", &Simulator::prefetchScene, "scene_filename"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Start decoding the assets of a scene on worker threads, so that a later reconfigure to it only has to upload them to the GPU.)")
+      .def("get_resident_scenes", &Simulator::getResidentScenes,
+           R"(The scene ids of the scenes kept loaded, the active one first, see SimulatorConfiguration.resident_scenes.)")
+      .def_property_readonly(
+          "active_scene_reused", &Simulator::isActiveSceneReused,
+          R"(Whether the last reconfigure switched to a resident scene instead of loading it.)")
+      .def("fit_texture_size_to_sensor", &Simulator::fitTextureSizeToSensor,
+           "sensor"_a,
+           R"(Raise the texture size limit, if max_texture_size is set, to twice the resolution of a visual sensor attached to the simulator, loading lower resolution textures again.)")
+      .def("reset", &Simulator::reset, py::call_guard<py::gil_scoped_release>())
+      .def(
+          "clone", &Simulator::clone, py::call_guard<py::gil_scoped_release>(),
+          R"(A backend simulator in the current state of this one, e.g. to plan rollouts. Shares the meshes, textures, navmesh, collision shapes and attribute templates, and duplicates only the scene graph, the objects and the agents with their states. Navmesh changes affect both simulators.)")
+      .def(
+          "reset_episode",
+          [](Simulator& self, const physics::PhysicsSnapshot& objectStates) {
+            return self.resetEpisode({}, objectStates);
+          },
+          "object_states"_a = physics::PhysicsSnapshot{},
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Start a new episode in the current scene, keeping the scene graph, agents, sensors and GPU resources. Restores the objects and world time of a PhysicsSnapshot and drops the pending asynchronous readbacks. Agents added natively keep their state.)")
       .def("close", &Simulator::close)
       .def_property("pathfinder", &Simulator::getPathFinder,
                     &Simulator::setPathFinder)
@@ -83,6 +196,116 @@ void initSimBindings(py::module& m) {
       .def_property("frustum_culling", &Simulator::isFrustumCullingEnabled,
                     &Simulator::setFrustumCullingEnabled,
                     R"(Enable or disable the frustum culling)")
+      .def_property(
+          "sort_by_draw_state", &Simulator::isSortByDrawStateEnabled,
+          &Simulator::setSortByDrawStateEnabled,
+          R"(Enable or disable drawing sorted by shader, material, texture and mesh)")
+      .def_property(
+          "occlusion_culling", &Simulator::isOcclusionCullingEnabled,
+          &Simulator::setOcclusionCullingEnabled,
+          R"(Enable or disable skipping the drawables hidden behind others with occlusion queries)")
+      .def_property(
+          "potentially_visible_set",
+          &Simulator::isPotentiallyVisibleSetEnabled,
+          &Simulator::setPotentiallyVisibleSetEnabled,
+          R"(Enable or disable skipping the stage drawables not visible from the navigable cell of the camera, precomputed by datatool create_pvs)")
+      .def_property_readonly(
+          "stage_streamer", &Simulator::getStageStreamer,
+          R"(The streamer of the chunks of the active stage, None unless a .chunks.json manifest is next to the stage asset.)")
+      .def(
+          "update_stage_streaming", &Simulator::updateStageStreaming,
+          "wait"_a = false, py::call_guard<py::gil_scoped_release>(),
+          R"(Load and evict the chunks and navmesh tiles of a chunked stage around the agents, done by each step and, waiting for the loads, by reset.)")
+      .def_property(
+          "multi_frustum_culling", &Simulator::isMultiFrustumCullingEnabled,
+          &Simulator::setMultiFrustumCullingEnabled,
+          R"(Enable or disable culling against the frustums of all sensors observing at once)")
+      .def_property(
+          "instanced_object_rendering",
+          &Simulator::isInstancedObjectRenderingEnabled,
+          &Simulator::setInstancedObjectRenderingEnabled,
+          R"(Enable or disable drawing the objects added afterwards instanced)")
+      .def_property(
+          "render_list", &Simulator::isRenderListEnabled,
+          &Simulator::setRenderListEnabled,
+          R"(Enable or disable collecting the drawables from flattened render lists instead of walking the scene graph)")
+      .def_property(
+          "gpu_driven_render", &Simulator::isGpuDrivenRenderEnabled,
+          &Simulator::setGpuDrivenRenderEnabled,
+          R"(Enable or disable drawing the depth of the static stage meshes culled by a compute shader in a single multi-draw)")
+      .def_property(
+          "observation_cache", &Simulator::isObservationCacheEnabled,
+          &Simulator::setObservationCacheEnabled,
+          R"(Enable or disable returning the previous observation of a visual sensor without drawing it again while neither it nor the scene changed)")
+      .def("mark_scene_changed", &Simulator::markSceneChanged,
+           R"(Let the next observations draw all sensors again, after changing what the scene looks like outside of the simulator)")
+      .def_property(
+          "view_cache", &Simulator::getViewCache, &Simulator::setViewCache,
+          R"(The ViewCache observations of visual sensors are read from instead of drawn and written to, or None. Only serves while the scene is as the last reconfigure loaded it.)")
+      .def_property(
+          "async_physics", &Simulator::isAsyncPhysicsEnabled,
+          &Simulator::setAsyncPhysicsEnabled,
+          R"(Enable or disable stepping the physics of step_world_and_observe on a worker thread after the frames are queued, so the observations lag the physics by one step)")
+      .def("get_latest_physics_snapshot", &Simulator::getLatestPhysicsSnapshot,
+           R"(Get the object states saved by the last physics step finished on the worker thread, without waiting for a running one)")
+      .def_property(
+          "profiling_enabled", &Simulator::isProfilingEnabled,
+          &Simulator::setProfilingEnabled,
+          R"(Enable or disable the process-wide per-stage profiling timers and counters)")
+      .def("get_profiling_stats", &Simulator::getProfilingStats,
+           R"(Get the per-stage timings and counters collected since the last
+          reset_profiling_stats() as a ProfilingStats.)")
+      .def("reset_profiling_stats", &Simulator::resetProfilingStats,
+           R"(Zero all profiling timings and counters.)")
+      .def("start_tracing", &Simulator::startTracing,
+           R"(Start recording a process-wide timeline trace of the step stages, scene loading and navmesh builds.)")
+      .def("stop_tracing", &Simulator::stopTracing, "filename"_a,
+           R"(Stop recording and save the trace as a Chrome trace event JSON file, which chrome://tracing and Perfetto open. Returns false if it couldn't be written.)")
+      .def_property_readonly("is_tracing", &Simulator::isTracing)
+      .def("start_recording", &Simulator::startRecording,
+           R"(Start recording the session: actions taken through step(), observations with the agent and sensor poses, object additions, removals and rigid states, physics steps, seeds and resets.)")
+      .def("stop_recording", &Simulator::stopRecording, "filename"_a,
+           R"(Stop recording and save the session in a compact binary file, which the replay utility reruns. Returns false if nothing was recorded or it couldn't be written.)")
+      .def_property_readonly("is_recording", &Simulator::isRecording)
+      .def("save_frame",
+           py::overload_cast<int, const std::string&, const std::string&>(
+               &Simulator::saveFrame),
+           R"(Write the RGBA frame last drawn by a visual sensor to filename, in the format of its extension, encoded on the thread of frame_encoder.)",
+           "agent_id"_a, "sensor_id"_a, "filename"_a,
+           py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly(
+          "frame_encoder", &Simulator::getFrameEncoder,
+          R"(The FrameEncoder of save_frame(), which recordings can queue observations to.)",
+          py::return_value_policy::reference_internal)
+      .def("get_gpu_memory_usage", &Simulator::getGpuMemoryUsage,
+           R"(Estimated GPU memory this simulator allocated for meshes, textures, PTex atlases and render targets, and of the CUDA noise models of the process, as a GpuMemoryUsage.)")
+      .def("get_asset_gpu_bytes", &Simulator::getAssetGpuBytes,
+           R"(Estimated GPU memory of each loaded asset in bytes, by filename.)")
+#ifdef ESP_BUILD_WITH_CUDA
+      .def(
+          "get_agent_observations_gpu",
+          [](Simulator& self, int agentId, sensor::SensorType sensorType,
+             size_t devPtr, size_t cudaStream,
+             sensor::RedwoodNoiseModelGPUImpl* depthNoiseModel,
+             sensor::RgbNoiseModelGPUImpl* colorNoiseModel) {
+            // Pointers from PyTorch come in as size_t, see
+            // RenderTarget.read_frame_rgba_gpu
+            return self.getAgentObservationsGPU(
+                agentId, sensorType, reinterpret_cast<void*>(devPtr),
+                reinterpret_cast<void*>(cudaStream), depthNoiseModel,
+                colorNoiseModel);
+          },
+          "agent_id"_a, "sensor_type"_a, "dev_ptr"_a, "cuda_stream"_a = 0,
+          "depth_noise_model"_a = nullptr, "color_noise_model"_a = nullptr,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Draw all sensors of sensor_type of an agent and copy their
+          observations into one [num_sensors, H, W, C] CUDA tensor given by
+          dev_ptr, e.g. tensor.data_ptr(), on cuda_stream, e.g.
+          torch.cuda.current_stream().cuda_stream. For depth, an optional
+          RedwoodNoiseModelGPUImpl is applied in-place on the same stream,
+          for color an optional RgbNoiseModelGPUImpl.
+          Returns the number of observations written.)")
+#endif
       /* --- Physics functions --- */
       /* --- Template Manager accessors --- */
       .def(
@@ -111,14 +334,18 @@ void initSimBindings(py::module& m) {
           "add_object", &Simulator::addObject, "object_lib_id"_a,
           "attachment_node"_a = nullptr,
           "light_setup_key"_a = assets::ResourceManager::DEFAULT_LIGHTING_KEY,
-          "scene_id"_a = 0,
+          "scene_id"_a = 0, py::call_guard<py::gil_scoped_release>(),
           R"(Instance an object into the scene via a template referenced by library id. Optionally attach the object to an existing SceneNode and assign its initial LightSetup key.)")
       .def(
           "add_object_by_handle", &Simulator::addObjectByHandle,
           "object_lib_handle"_a, "attachment_node"_a = nullptr,
           "light_setup_key"_a = assets::ResourceManager::DEFAULT_LIGHTING_KEY,
-          "scene_id"_a = 0,
+          "scene_id"_a = 0, py::call_guard<py::gil_scoped_release>(),
           R"(Instance an object into the scene via a template referenced by its handle. Optionally attach the object to an existing SceneNode and assign its initial LightSetup key.)")
+      .def(
+          "load_scene_instance", &Simulator::loadSceneInstance,
+          "scene_instance_file"_a, "scene_id"_a = 0,
+          R"(Instance all the objects listed in a scene instance file in a single batch, placed and given the motion type the file specifies. Returns the object ids, in file order, with ID_UNDEFINED for the objects which failed.)")
       .def("remove_object", &Simulator::removeObject, "object_id"_a,
            "delete_object_node"_a = true, "delete_visual_node"_a = true,
            "scene_id"_a = 0, R"(
@@ -130,6 +357,15 @@ void initSimBindings(py::module& m) {
             of an Agent expected to continue producing observations
             will likely result in errors if delete_object_node is true.
             )")
+      .def(
+          "set_object_pooling", &Simulator::setObjectPooling, "enabled"_a,
+          "scene_id"_a = 0,
+          R"(Enable or disable the pooling of removed objects. With pooling, remove_object() takes objects out of the world and hides them instead of destroying them, and adding an object of the same template recycles one of them. Only objects added without an attachment node and removed with their object node are pooled. Disabling pooling destroys the pooled objects.)")
+      .def("get_object_pooling", &Simulator::getObjectPooling,
+           "scene_id"_a = 0, R"(Whether removed objects are pooled.)")
+      .def("get_num_pooled_objects", &Simulator::getNumPooledObjects,
+           "scene_id"_a = 0,
+           R"(The number of removed objects kept for recycling.)")
       .def(
           "get_object_initialization_template",
           &Simulator::getObjectInitializationTemplate, "object_id"_a,
@@ -149,11 +385,79 @@ void initSimBindings(py::module& m) {
           "get_existing_object_ids", &Simulator::getExistingObjectIDs,
           "scene_id"_a = 0,
           R"(Get the list of ids for all objects currently instanced in the scene.)")
+      .def(
+          "get_active_object_ids", &Simulator::getActiveObjectIds,
+          "scene_id"_a = 0,
+          R"(Get the sorted ids of the objects active at the end of the last physics step. Cheap to poll, e.g. to wait until the objects settled.)")
+      .def(
+          "set_object_sleeping_thresholds",
+          &Simulator::setObjectSleepingThresholds, "linear_threshold"_a,
+          "angular_threshold"_a, "object_id"_a, "scene_id"_a = 0,
+          R"(Set the linear and angular speeds below which an object may fall asleep.)")
 
       /* --- Kinematics and dynamics --- */
       .def(
           "step_world", &Simulator::stepWorld, "dt"_a = 1.0 / 60.0,
+          py::call_guard<py::gil_scoped_release>(),
           R"(Step the physics simulation by a desired timestep (dt). Note that resulting world time after step may not be exactly t+dt. Use get_world_time to query current simulation time.)")
+      .def(
+          "step_agents",
+          [](Simulator& self, const std::map<int, std::string>& actions,
+             double dt) {
+            std::map<int, std::map<std::string, sensor::Observation>>
+                observations;
+            self.step(actions, observations, dt);
+            return observations;
+          },
+          "actions"_a, "dt"_a = 1.0 / 60.0,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Act with the agents added natively, e.g. those of the environments of a VectorSimulator, by a dict from agent id to action name, step the physics by dt and return a dict from agent id to the observations of all its sensors, in a single call.)")
+      .def("step_agents_async", &Simulator::stepAsync, "actions"_a,
+           "callback"_a, "dt"_a = 1.0 / 60.0,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Like step_agents(), but without waiting for the GPU: the callback gets the dict of observations from poll_async_observations() once they are read back.)")
+      .def(
+          "observe_async", &Simulator::observeAsync, "sensors"_a, "callback"_a,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Draw with the sensors and queue the reads of their frames without waiting for the GPU. The callback gets the list of their Observations from poll_async_observations() once they are read back. Completes the observations still in flight first.)")
+      .def(
+          "poll_async_observations", &Simulator::pollAsyncObservations,
+          "wait"_a = false, py::call_guard<py::gil_scoped_release>(),
+          R"(Call the callback of the observations in flight if the GPU finished them, or waiting for it with wait. Returns False if they are still in flight.)")
+      .def_property_readonly("has_async_observations",
+                             &Simulator::hasAsyncObservations)
+      .def(
+          "get_agent_velocity_control",
+          [](Simulator& self, int agentId) {
+            return self.getAgent(agentId)->getVelocityControl();
+          },
+          "agent_id"_a,
+          R"(The velocity control of the body of an agent added natively, integrated and constrained to the navmesh at a fixed substep rate by step_world.)")
+      .def("act_all", &Simulator::actAll, "action_indices"_a,
+           "num_threads"_a = 0, py::call_guard<py::gil_scoped_release>(),
+           R"(Act with all agents added natively by action index, a negative index for no action, filtering the moves of all agents through the navmesh in parallel. Returns False if an agent doesn't have its action.)")
+      .def(
+          "write_agent_observations",
+          py::overload_cast<int, core::SharedMemoryRing&, int>(
+              &Simulator::getAgentObservations),
+          "agent_id"_a, "ring"_a, "slot"_a,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Observe with the sensors of a natively added agent straight into a slot of a SharedMemoryRing and publish it. Returns False if the ring doesn't match the sensors, the slot is not published then.)")
+      .def(
+          "get_agent_observation_fields",
+          &Simulator::getAgentObservationFields, "agent_id"_a,
+          R"(The fields of a SharedMemoryRing for the observations of all sensors of a natively added agent.)")
+      .def(
+          "write_agent_observations",
+          py::overload_cast<int, ObservationDatasetWriter&, int>(
+              &Simulator::getAgentObservations),
+          "agent_id"_a, "writer"_a, "action"_a = -1,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Observe with the sensors of a natively added agent and queue the observations, its state and action as a record of an ObservationDatasetWriter. Returns False if the writer doesn't match the sensors, nothing is queued then.)")
+      .def(
+          "get_agent_dataset_fields", &Simulator::getAgentDatasetFields,
+          "agent_id"_a,
+          R"(The fields of an ObservationDatasetWriter for the observations, state and action of a natively added agent.)")
       .def("get_world_time", &Simulator::getWorldTime,
            R"(Query the current simualtion world time.)")
       .def("get_gravity", &Simulator::getGravity, "scene_id"_a = 0,
@@ -184,6 +488,99 @@ void initSimBindings(py::module& m) {
           "get_rigid_state", &Simulator::getRigidState, "object_id"_a,
           "scene_id"_a = 0,
           R"(Get an object's transformation as a RigidState (i.e. vector, quaternion).)")
+      .def(
+          "get_rigid_states",
+          [](Simulator& self, const std::vector<int>& objectIDs, int sceneID) {
+            Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>
+                translations(objectIDs.size(), 3);
+            Eigen::Matrix<float, Eigen::Dynamic, 4, Eigen::RowMajor> rotations(
+                objectIDs.size(), 4);
+            self.getRigidStates(
+                objectIDs,
+                {reinterpret_cast<Magnum::Vector3*>(translations.data()),
+                 objectIDs.size()},
+                {reinterpret_cast<Magnum::Quaternion*>(rotations.data()),
+                 objectIDs.size()},
+                sceneID);
+            return std::make_pair(translations, rotations);
+          },
+          "object_ids"_a, "scene_id"_a = 0,
+          R"(Get the translations and rotations of many objects in one call, as an Nx3 array of translations and an Nx4 array of quaternions ordered [x, y, z, w].)")
+      .def(
+          "set_rigid_states",
+          [](Simulator& self, const std::vector<int>& objectIDs,
+             const Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>&
+                 translations,
+             const Eigen::Matrix<float, Eigen::Dynamic, 4, Eigen::RowMajor>&
+                 rotations,
+             int sceneID) {
+            const Eigen::Index numObjects = objectIDs.size();
+            if (translations.rows() != numObjects ||
+                rotations.rows() != numObjects) {
+              throw py::value_error{
+                  "translations and rotations need a row per object"};
+            }
+            self.setRigidStates(
+                objectIDs,
+                {reinterpret_cast<const Magnum::Vector3*>(translations.data()),
+                 objectIDs.size()},
+                {reinterpret_cast<const Magnum::Quaternion*>(rotations.data()),
+                 objectIDs.size()},
+                sceneID);
+          },
+          "object_ids"_a, "translations"_a, "rotations"_a, "scene_id"_a = 0,
+          R"(Set the translations and rotations of many objects kinematically in one call, from an Nx3 array of translations and an Nx4 array of quaternions ordered [x, y, z, w], e.g. as returned by get_rigid_states().)")
+      .def(
+          "get_velocities",
+          [](Simulator& self, const std::vector<int>& objectIDs, int sceneID) {
+            Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> linVels(
+                objectIDs.size(), 3);
+            Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> angVels(
+                objectIDs.size(), 3);
+            self.getVelocities(
+                objectIDs,
+                {reinterpret_cast<Magnum::Vector3*>(linVels.data()),
+                 objectIDs.size()},
+                {reinterpret_cast<Magnum::Vector3*>(angVels.data()),
+                 objectIDs.size()},
+                sceneID);
+            return std::make_pair(linVels, angVels);
+          },
+          "object_ids"_a, "scene_id"_a = 0,
+          R"(Get the linear and angular velocities of many objects in one call, as two Nx3 arrays.)")
+      .def(
+          "set_velocities",
+          [](Simulator& self, const std::vector<int>& objectIDs,
+             const Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>&
+                 linVels,
+             const Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>&
+                 angVels,
+             int sceneID) {
+            const Eigen::Index numObjects = objectIDs.size();
+            if (linVels.rows() != numObjects || angVels.rows() != numObjects) {
+              throw py::value_error{
+                  "linear and angular velocities need a row per object"};
+            }
+            self.setVelocities(
+                objectIDs,
+                {reinterpret_cast<const Magnum::Vector3*>(linVels.data()),
+                 objectIDs.size()},
+                {reinterpret_cast<const Magnum::Vector3*>(angVels.data()),
+                 objectIDs.size()},
+                sceneID);
+          },
+          "object_ids"_a, "linear_velocities"_a, "angular_velocities"_a,
+          "scene_id"_a = 0,
+          R"(Set the linear and angular velocities of many dynamic objects in one call, from two Nx3 arrays, e.g. as returned by get_velocities().)")
+      .def(
+          "save_physics_snapshot", &Simulator::savePhysicsSnapshot,
+          "scene_id"_a = 0,
+          R"(Capture the rigid states, velocities, motion types and velocity controls of all objects and the world time into a PhysicsSnapshot.)")
+      .def(
+          "restore_physics_snapshot", &Simulator::restorePhysicsSnapshot,
+          "snapshot"_a, "scene_id"_a = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Restore a PhysicsSnapshot in place, without re-creating objects. Returns false if an object of the snapshot was removed since.)")
       .def("set_translation", &Simulator::setTranslation, "translation"_a,
            "object_id"_a, "scene_id"_a = 0,
            R"(Set an object's translation and update its simulation state.)")
@@ -224,12 +621,46 @@ void initSimBindings(py::module& m) {
           R"(Apply torque to an object. Only applies to MotionType::DYNAMIC objects.)")
       .def(
           "contact_test", &Simulator::contactTest, "object_id"_a,
-          "scene_id"_a = 0,
+          "scene_id"_a = 0, py::call_guard<py::gil_scoped_release>(),
           R"(Run collision detection and return a binary indicator of penetration between the specified object and any other collision object. Physics must be enabled.)")
       .def(
           "cast_ray", &Simulator::castRay, "ray"_a, "max_distance"_a = 100.0,
-          "scene_id"_a = 0,
+          "scene_id"_a = 0, py::call_guard<py::gil_scoped_release>(),
           R"(Cast a ray into the collidable scene and return hit results. Physics must be enabled. max_distance in units of ray length.)")
+      .def(
+          "cast_rays",
+          [](Simulator& self,
+             const Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>&
+                 origins,
+             const Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>&
+                 directions,
+             float maxDistance, int numThreads, int sceneID) {
+            if (origins.rows() != directions.rows()) {
+              throw py::value_error{
+                  "origins and directions must have the same number of rows"};
+            }
+            std::vector<geo::Ray> rays(origins.rows());
+            for (int i = 0; i < origins.rows(); ++i) {
+              rays[i].origin = Magnum::Vector3{origins(i, 0), origins(i, 1),
+                                               origins(i, 2)};
+              rays[i].direction = Magnum::Vector3{
+                  directions(i, 0), directions(i, 1), directions(i, 2)};
+            }
+            py::gil_scoped_release release;
+            return self.castRays(rays, maxDistance, numThreads, sceneID);
+          },
+          "origins"_a, "directions"_a, "max_distance"_a = 100.0,
+          "num_threads"_a = 0, "scene_id"_a = 0,
+          R"(Cast the rays of Nx3 arrays of origins and directions into the collidable scene on num_threads threads, all hardware threads if 0, and return the first hit of each. Physics must be enabled. max_distance in units of ray length. Releases the GIL while casting.)")
+      .def(
+          "box_overlap_test", &Simulator::boxOverlapTest, "center"_a,
+          "half_extents"_a, "scene_id"_a = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Get the sorted ids of the objects overlapping the axis aligned box of center and half_extents, e.g. the bounds of an agent, -1 for the stage. Physics must be enabled.)")
+      .def(
+          "get_contact_points", &Simulator::getContactPoints,
+          "scene_id"_a = 0,
+          R"(Get all contact points found by the last physics step in one pass, including those of sleeping objects. Physics must be enabled.)")
       .def("set_object_bb_draw", &Simulator::setObjectBBDraw, "draw_bb"_a,
            "object_id"_a, "scene_id"_a = 0,
            R"(Enable or disable bounding box visualization for an object.)")
@@ -240,7 +671,19 @@ void initSimBindings(py::module& m) {
       .def(
           "recompute_navmesh", &Simulator::recomputeNavMesh, "pathfinder"_a,
           "navmesh_settings"_a, "include_static_objects"_a = false,
+          py::call_guard<py::gil_scoped_release>(),
           R"(Recompute the NavMesh for a given PathFinder instance using configured NavMeshSettings. Optionally include all MotionType::STATIC objects in the navigability constraints.)")
+      .def(
+          "recompute_navmesh_variants", &Simulator::recomputeNavMeshVariants,
+          "navmesh_settings"_a, "include_static_objects"_a = false,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Compute a NavMesh for each of a list of NavMeshSettings in one pass, sharing the rasterization of the scene between the ones only differing in agent_radius and agent_height. Returns a PathFinder for each, not loaded if its NavMesh could not be built.)")
+      .def(
+          "update_navmesh_region", &Simulator::updateNavMeshRegion,
+          "pathfinder"_a, "region_min"_a, "region_max"_a,
+          "include_static_objects"_a = false,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Rebuild only the tiles of a tiled NavMesh (NavMeshSettings.tile_size > 0) which the region between region_min and region_max can affect, e.g. the old and new bounds of moved objects.)")
       .def("get_light_setup", &Simulator::getLightSetup,
            "key"_a = assets::ResourceManager::DEFAULT_LIGHTING_KEY,
            R"(Get a copy of the LightSetup registered with a specific key.)")
@@ -258,6 +701,106 @@ void initSimBindings(py::module& m) {
           &Simulator::getNumActiveContactPoints,
           R"(The number of contact points that were active during the last step. An object resting on another object will involve several active contact points. Once both objects are asleep, the contact points are inactive. This count can be used as a metric for the complexity/cost of collision-handling in the current scene.)");
   ;
+
+  // ==== VectorSimulator ====
+  py::class_<VectorSimulator, VectorSimulator::ptr>(m, "VectorSimulator")
+      .def(py::init([](const std::vector<SimulatorConfiguration>& cfgs,
+                       const std::vector<sensor::SensorSpec::ptr>& sensors,
+                       bool threaded) {
+             agent::AgentConfiguration agentConfig;
+             agentConfig.sensorSpecifications = sensors;
+             // the instance is registered with the GIL held, so it is only
+             // released around loading the scenes
+             py::gil_scoped_release release;
+             return VectorSimulator::create(cfgs, agentConfig, threaded);
+           }),
+           "configurations"_a, "sensor_specifications"_a, "threaded"_a = false,
+           R"(Create an environment for each SimulatorConfiguration, all sharing one OpenGL context, asset cache and renderer, each with an agent with the default action space carrying the given sensors. With threaded, each environment is stepped and drawn on a thread of its own, with an OpenGL context sharing the assets of the others.)")
+      .def_property_readonly("num_envs", &VectorSimulator::getNumEnvs)
+      .def_property_readonly("threaded", &VectorSimulator::isThreaded)
+      .def_property_readonly("gpu_device", &VectorSimulator::gpuDevice)
+      .def("get_env", &VectorSimulator::getEnv, "env_id"_a,
+           R"(PYTHON DOES NOT GET OWNERSHIP)",
+           py::return_value_policy::reference_internal)
+      .def("reset_all", &VectorSimulator::resetAll,
+           py::call_guard<py::gil_scoped_release>())
+      .def("step_all", &VectorSimulator::stepAll, "actions"_a,
+           "dt"_a = 1.0 / 60.0, py::call_guard<py::gil_scoped_release>(),
+           R"(Act with the agent of each environment, an empty string for no action, step the physics by dt and return get_observations().)")
+      .def("step_all", &VectorSimulator::stepAllByActionIndices, "actions"_a,
+           "dt"_a = 1.0 / 60.0, py::call_guard<py::gil_scoped_release>(),
+           R"(Act with the agent of each environment by action index, see get_action_index, a negative index for no action, step the physics by dt and return get_observations().)")
+      .def(
+          "get_action_index",
+          [](VectorSimulator& self, const std::string& actionName) {
+            return self.getEnv(0).getAgent(0)->getActionIndex(actionName);
+          },
+          "action_name"_a,
+          R"(The index of an action of the action space of the agents for step_all, all environments sharing one action space.)")
+      .def(
+          "get_observations", &VectorSimulator::getObservations,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Draw the sensors of all environments and return a Buffer for each sensor uuid holding the observations of all of them, [num_envs, H, W, C]. The buffers are overwritten by the next call.)");
+
+  // ==== SimulatorServer ====
+  py::class_<SimulatorServer, SimulatorServer::ptr>(m, "SimulatorServer", R"(
+        Serves the environments of a VectorSimulator over TCP with a compact
+        binary protocol, to a habitat_sim.remote.RemoteVectorEnv on another
+        machine or, through shared memory, on the same one.
+        )")
+      .def(py::init<VectorSimulator&>(), "simulator"_a, py::keep_alive<1, 2>())
+      .def("listen", &SimulatorServer::listen, "port"_a = 0,
+           "address"_a = "127.0.0.1",
+           R"(Listen for clients, on a free port for port 0, on the loopback interface by default, "0.0.0.0" for all of them. The protocol has no authentication, so only listen on a trusted network. Returns the port.)")
+      .def_property_readonly("port", &SimulatorServer::port)
+      .def("serve", &SimulatorServer::serve, "num_clients"_a = 0,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Serve clients one after another, from the thread owning the OpenGL context, until num_clients were served or, for 0, until stop().)")
+      .def("stop", &SimulatorServer::stop,
+           R"(Make serve() return once the current session ends.)");
+
+  // ==== EpisodeScheduler ====
+  py::class_<EpisodeScheduler, EpisodeScheduler::ptr>(m, "EpisodeScheduler",
+                                                      R"(
+        Orders the episodes of a dataset for a group of workers so that each
+        runs the episodes of a scene in a row. The scenes are split among the
+        workers, and each worker visits its scenes in turn, shuffled anew each
+        epoch.
+        )")
+      .def(py::init([](const std::vector<std::string>& episodeScenes,
+                       int numWorkers, std::size_t episodesPerVisit,
+                       bool shuffle, unsigned int seed) {
+             EpisodeScheduler::Configuration configuration;
+             configuration.episodesPerVisit = episodesPerVisit;
+             configuration.shuffle = shuffle;
+             configuration.seed = seed;
+             return EpisodeScheduler::create(episodeScenes, numWorkers,
+                                             configuration);
+           }),
+           "episode_scenes"_a, "num_workers"_a, "episodes_per_visit"_a = 0,
+           "shuffle"_a = true, "seed"_a = 0,
+           R"(Schedule episodes given by their scenes. A worker runs at most episodes_per_visit episodes of a scene in a row, all of them for 0.)")
+      .def_property_readonly("num_workers", &EpisodeScheduler::getNumWorkers)
+      .def("get_scene", &EpisodeScheduler::getScene, "episode"_a)
+      .def("get_worker_scenes", &EpisodeScheduler::getWorkerScenes, "worker"_a)
+      .def("get_num_worker_episodes", &EpisodeScheduler::getNumWorkerEpisodes,
+           "worker"_a)
+      .def(
+          "next_episode",
+          [](EpisodeScheduler& self, int worker,
+             Simulator* simulator) -> py::object {
+            const std::size_t episode =
+                simulator ? self.nextEpisode(worker, *simulator)
+                          : self.nextEpisode(worker);
+            if (episode == ~std::size_t{})
+              return py::none();
+            return py::int_(episode);
+          },
+          "worker"_a, "simulator"_a = nullptr,
+          R"(The next episode of a worker, None if it has none. With a simulator, prefetches the scene of the episode after it there if it is another scene.)")
+      .def("peek_next_scene", &EpisodeScheduler::peekNextScene, "worker"_a)
+      .def("get_num_scene_switches", &EpisodeScheduler::getNumSceneSwitches,
+           "worker"_a);
 }
 
 }  // namespace sim
@@ -6,7 +6,9 @@
 
 #include "esp/core//random.h"
 #include "esp/core/Configuration.h"
+#include "esp/core/Profiling.h"
 #include "esp/core/RigidState.h"
+#include "esp/core/TaskScheduler.h"
 
 namespace py = pybind11;
 using py::literals::operator""_a;
@@ -25,12 +27,24 @@ namespace core {
 void initCoreBindings(py::module& m) {
   py::class_<Configuration, Configuration::ptr>(m, "ConfigurationGroup")
       .def(py::init(&Configuration::create<>))
-      .def("get_bool", &Configuration::getBool)
-      .def("get_string", &Configuration::getString)
-      .def("get_int", &Configuration::getInt)
-      .def("get_double", &Configuration::getDouble)
-      .def("get_vec3", &Configuration::getVec3)
-      .def("get", &Configuration::getString)
+      .def("get_bool",
+           py::overload_cast<const std::string&>(&Configuration::getBool,
+                                                 py::const_))
+      .def("get_string",
+           py::overload_cast<const std::string&>(&Configuration::getString,
+                                                 py::const_))
+      .def("get_int",
+           py::overload_cast<const std::string&>(&Configuration::getInt,
+                                                 py::const_))
+      .def("get_double",
+           py::overload_cast<const std::string&>(&Configuration::getDouble,
+                                                 py::const_))
+      .def("get_vec3",
+           py::overload_cast<const std::string&>(&Configuration::getVec3,
+                                                 py::const_))
+      .def("get",
+           py::overload_cast<const std::string&>(&Configuration::getString,
+                                                 py::const_))
       .def("set", &Configuration::set<std::string>)
       .def("set", &Configuration::set<int>)
       .def("set", &Configuration::set<double>)
@@ -51,13 +65,69 @@ void initCoreBindings(py::module& m) {
 
   py::class_<Random, Random::ptr>(m, "Random")
       .def(py::init(&Random::create<>))
+      .def(py::init(&Random::create<unsigned int, uint64_t>), "seed"_a,
+           "stream_id"_a = 0)
       .def("seed", &Random::seed)
+      .def("stream", &Random::stream, "stream_id"_a,
+           R"(A new generator of the same seed and the given stream, independent of this one.)")
+      .def_property_readonly("stream_id", &Random::getStream)
+      .def(
+          "uniform_floats_01",
+          [](Random& self, size_t count) {
+            std::vector<float> values(count);
+            self.fill_uniform_float_01(values.data(), count);
+            return values;
+          },
+          "count"_a)
       .def("uniform_float_01", &Random::uniform_float_01)
       .def("uniform_float", &Random::uniform_float)
       .def("uniform_int", py::overload_cast<>(&Random::uniform_int))
       .def("uniform_int", py::overload_cast<int, int>(&Random::uniform_int))
       .def("uniform_uint", &Random::uniform_uint)
       .def("normal_float_01", &Random::normal_float_01);
+
+  // ==== struct ProfilingStats ===
+  py::class_<ProfilingStats> profilingStats(m, "ProfilingStats");
+  py::class_<ProfilingStats::Timing>(profilingStats, "Timing")
+      .def_readonly("calls", &ProfilingStats::Timing::calls)
+      .def_readonly("cpu_time_ms", &ProfilingStats::Timing::cpuTimeMs)
+      .def_readonly("gpu_time_ms", &ProfilingStats::Timing::gpuTimeMs);
+  profilingStats
+      .def_readonly("agent_observations", &ProfilingStats::agentObservations)
+      .def_readonly("physics", &ProfilingStats::physics)
+      .def_readonly("culling", &ProfilingStats::culling)
+      .def_readonly("drawing", &ProfilingStats::drawing)
+      .def_readonly("readback", &ProfilingStats::readback)
+      .def_readonly("noise", &ProfilingStats::noise)
+      .def_readonly("context_creation", &ProfilingStats::contextCreation)
+      .def_readonly("importer_setup", &ProfilingStats::importerSetup)
+      .def_readonly("primitive_attributes",
+                    &ProfilingStats::primitiveAttributes)
+      .def_readonly("stage_loading", &ProfilingStats::stageLoading)
+      .def_readonly("navmesh_loading", &ProfilingStats::navmeshLoading)
+      .def_readonly("shader_compilation", &ProfilingStats::shaderCompilation)
+      .def_readonly("asset_import", &ProfilingStats::assetImport)
+      .def_readonly("hierarchy_join", &ProfilingStats::hierarchyJoin)
+      .def_readonly("bounds_computation", &ProfilingStats::boundsComputation)
+      .def_readonly("gpu_upload", &ProfilingStats::gpuUpload)
+      .def_readonly("collision_mesh_build",
+                    &ProfilingStats::collisionMeshBuild)
+      .def_readonly("semantic_scene_loading",
+                    &ProfilingStats::semanticSceneLoading)
+      .def_readonly("drawables_culled", &ProfilingStats::drawablesCulled)
+      .def_readonly("draw_calls", &ProfilingStats::drawCalls)
+      .def_readonly("drawables_occluded", &ProfilingStats::drawablesOccluded)
+      .def_readonly("view_cache_hits", &ProfilingStats::viewCacheHits)
+      .def_readonly("view_cache_misses", &ProfilingStats::viewCacheMisses);
+
+  // ==== TaskScheduler ====
+  m.def("configure_task_scheduler", &TaskScheduler::configureGlobal,
+        "num_threads"_a, "cpus"_a = std::vector<int>{},
+        R"(Set the threads of the scheduler shared by the parallel work of all simulators of the process, callers included, 0 for all hardware threads, and the CPUs its workers are pinned to. Returns False if the scheduler already runs, call it before creating simulators.)");
+  m.def(
+      "task_scheduler_threads",
+      []() { return TaskScheduler::global().numThreads(); },
+      R"(The number of threads of the shared scheduler, callers included.)");
 }
 
 }  // namespace core
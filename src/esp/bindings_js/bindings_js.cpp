@@ -47,10 +47,26 @@ std::map<std::string, ObservationSpace> Simulator_getAgentObservationSpaces(
   return spaces;
 }
 
+// The batched queries run on the threads of core::TaskScheduler::global() in
+// the SIMD and threads build, and on the calling thread otherwise
+std::vector<vec3f> PathFinder_snapPointsBatch(PathFinder& pathFinder,
+                                              const std::vector<vec3f>& pts) {
+  return pathFinder.snapPointsBatch(pts);
+}
+
+std::vector<float> PathFinder_findDistancesBatch(
+    PathFinder& pathFinder,
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends) {
+  return pathFinder.findDistancesBatch(starts, ends);
+}
+
 EMSCRIPTEN_BINDINGS(habitat_sim_bindings_js) {
   em::register_vector<SensorSpec::ptr>("VectorSensorSpec");
   em::register_vector<size_t>("VectorSizeT");
   em::register_vector<std::string>("VectorString");
+  em::register_vector<float>("VectorFloat");
+  em::register_vector<vec3f>("VectorVec3f");
   em::register_vector<std::shared_ptr<SemanticCategory>>(
       "VectorSemanticCategories");
   em::register_vector<std::shared_ptr<SemanticObject>>("VectorSemanticObjects");
@@ -121,7 +137,9 @@ EMSCRIPTEN_BINDINGS(habitat_sim_bindings_js) {
   em::class_<PathFinder>("PathFinder")
       .smart_ptr<PathFinder::ptr>("PathFinder::ptr")
       .property("bounds", &PathFinder::bounds)
-      .function("isNavigable", &PathFinder::isNavigable);
+      .function("isNavigable", &PathFinder::isNavigable)
+      .function("snapPointsBatch", &PathFinder_snapPointsBatch)
+      .function("findDistancesBatch", &PathFinder_findDistancesBatch);
 
   em::class_<SensorSuite>("SensorSuite")
       .smart_ptr_constructor("SensorSuite", &SensorSuite::create<>)
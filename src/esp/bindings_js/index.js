@@ -7,7 +7,9 @@
 import WebDemo from "./modules/web_demo";
 import VRDemo from "./modules/vr_demo";
 import ViewerDemo from "./modules/viewer_demo";
+import WorkerDemo from "./modules/worker_demo";
 import { defaultScene } from "./modules/defaults";
+import { loadBindings } from "./modules/simenv_embind";
 import "./bindings.css";
 import {
   checkWebAssemblySupport,
@@ -26,11 +28,16 @@ function preload(url) {
   return file;
 }
 
-Module.preRun.push(() => {
+function buildConfig() {
   let config = {};
   config.scene = defaultScene;
   buildConfigFromURLParameters(config);
   window.config = config;
+  return config;
+}
+
+function preloadAssets() {
+  const config = buildConfig();
   const scene = config.scene;
   Module.scene = preload(scene);
   const fileNoExtension = scene.substr(0, scene.lastIndexOf("."));
@@ -42,9 +49,9 @@ Module.preRun.push(() => {
   } else if (config.semantic === "replica") {
     preload(getInfoSemanticUrl(config.scene));
   }
-});
+}
 
-Module.onRuntimeInitialized = () => {
+function runDemo() {
   console.log("hsim_bindings initialized");
   let demo;
   if (window.vrEnabled) {
@@ -61,7 +68,19 @@ Module.onRuntimeInitialized = () => {
   }
 
   demo.display();
-};
+}
+
+// The worker demo loads hsim_bindings_worker.js in sim_worker.js instead of
+// hsim_bindings.js on the main thread.
+if (window.workerEnabled) {
+  buildConfig();
+  new WorkerDemo().display();
+} else {
+  Module.preRun.push(preloadAssets);
+  Module.onRuntimeInitialized = runDemo;
+  // the SIMD and threads build where supported, see checkSimdThreadsSupport()
+  loadBindings("hsim_bindings");
+}
 
 function checkSupport() {
   const webgl2Support = checkWebgl2Support();
@@ -0,0 +1,160 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+/* global FS, Module, addRunDependency, removeRunDependency, importScripts */
+
+/**
+ * Web Worker running the simulator off the browser main thread.
+ *
+ * Built from hsim_bindings_worker.js (BUILD_WEB_WORKER), it renders with the
+ * OffscreenCanvas transferred by SimEnvWorker, streams the assets into the
+ * Emscripten FS with fetch while the runtime starts, and posts observations
+ * back as transferable ArrayBuffers. Every request is answered by a message
+ * with the same id.
+ */
+import SimEnv from "./simenv_embind";
+
+let simenv = null;
+
+/**
+ * Stream the body of url into the file path of the Emscripten FS, chunk by
+ * chunk, without holding the whole asset in memory.
+ * @param {string} url - url of the asset
+ * @param {string} path - path of the file in the FS
+ */
+async function streamToFS(url, path) {
+  const response = await fetch(url);
+  if (!response.ok) {
+    throw new Error("Failed to fetch " + url + ": " + response.status);
+  }
+  const stream = FS.open(path, "w");
+  try {
+    const reader = response.body.getReader();
+    for (;;) {
+      const { done, value } = await reader.read();
+      if (done) {
+        break;
+      }
+      FS.write(stream, value, 0, value.length);
+    }
+  } finally {
+    FS.close(stream);
+  }
+}
+
+function reply(id, result = {}, transfer = []) {
+  self.postMessage({ id, ...result }, transfer);
+}
+
+function replyError(id, error) {
+  self.postMessage({ id, error: String(error) });
+}
+
+/**
+ * Load the runtime, fetching the files in parallel before it starts.
+ * @param {Object} message - init message with canvas, files and configs
+ */
+function init(message) {
+  self.Module = {
+    canvas: message.canvas,
+    print: text => console.log(text),
+    printErr: text => console.error(text),
+    preRun: [
+      () => {
+        for (const file of message.files) {
+          const dependency = "fetch " + file.path;
+          addRunDependency(dependency);
+          streamToFS(file.url, file.path)
+            .catch(error => replyError(message.id, error))
+            .then(() => removeRunDependency(dependency));
+        }
+      }
+    ],
+    onRuntimeInitialized: () => {
+      const sceneConfig = new Module.SceneConfiguration();
+      sceneConfig.id = message.scene;
+      const config = new Module.SimulatorConfiguration();
+      config.scene = sceneConfig;
+      simenv = new SimEnv(config, message.episode, 0);
+      simenv.addAgent(message.agentConfig);
+      simenv.reset();
+      reply(message.id);
+    }
+  };
+  try {
+    loadBindings(message.bindingsUrl);
+  } catch (error) {
+    if (
+      !message.fallbackBindingsUrl ||
+      message.fallbackBindingsUrl === message.bindingsUrl
+    ) {
+      throw error;
+    }
+    console.warn(
+      "Failed to load " + message.bindingsUrl + ", loading " +
+        message.fallbackBindingsUrl
+    );
+    loadBindings(message.fallbackBindingsUrl);
+  }
+}
+
+/**
+ * Load the bindings at url, the threads of the SIMD and threads build are
+ * started from the same script.
+ * @param {string} url - url of the bindings
+ */
+function loadBindings(url) {
+  self.Module.mainScriptUrlOrBlob = url;
+  importScripts(url);
+}
+
+/**
+ * Copy the observation of a sensor out of the wasm heap into its own
+ * ArrayBuffer, which is transferred to the main thread without a copy.
+ * @param {Object} message - observe message with the sensor id
+ */
+function observe(message) {
+  const obs = simenv.getObservation(message.sensorId, new Module.Observation());
+  const data = obs.getData().slice();
+  const shape = simenv.getObservationSpace(message.sensorId).shape;
+  const dims = [];
+  for (let i = 0; i < shape.size(); i++) {
+    dims.push(shape.get(i));
+  }
+  obs.delete();
+  reply(message.id, { data: data.buffer, shape: dims }, [data.buffer]);
+}
+
+self.onmessage = event => {
+  const message = event.data;
+  try {
+    switch (message.type) {
+      case "init":
+        init(message);
+        break;
+      case "reset":
+        simenv.reset();
+        reply(message.id);
+        break;
+      case "step":
+        simenv.step(message.action);
+        reply(message.id);
+        break;
+      case "display":
+        simenv.displayObservation(message.sensorId);
+        reply(message.id);
+        break;
+      case "observe":
+        observe(message);
+        break;
+      case "distanceToGoal":
+        reply(message.id, { distance: simenv.distanceToGoal() });
+        break;
+      default:
+        replyError(message.id, "Unknown message type " + message.type);
+    }
+  } catch (error) {
+    replyError(message.id, error);
+  }
+};
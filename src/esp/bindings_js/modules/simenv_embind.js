@@ -4,6 +4,81 @@
 
 /*global Module */
 
+// A function returning i8x16.popcnt(i8x16.splat(0)), valid with wasm SIMD
+const SIMD_MODULE = Uint8Array.of(
+  0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x05, 0x01, 0x60,
+  0x00, 0x01, 0x7b, 0x03, 0x02, 0x01, 0x00, 0x0a, 0x0a, 0x01, 0x08, 0x00,
+  0x41, 0x00, 0xfd, 0x0f, 0xfd, 0x62, 0x0b
+);
+
+/**
+ * Check whether the SIMD and threads build of the bindings can run: wasm
+ * SIMD, shared wasm memory, and SharedArrayBuffer, which browsers only
+ * enable for cross-origin isolated pages.
+ * @returns {boolean} whether the browser supports the build
+ */
+export function checkSimdThreadsSupport() {
+  try {
+    if (
+      typeof WebAssembly !== "object" ||
+      typeof SharedArrayBuffer !== "function" ||
+      !globalThis.crossOriginIsolated
+    ) {
+      return false;
+    }
+    const memory = new WebAssembly.Memory({
+      initial: 1,
+      maximum: 1,
+      shared: true
+    });
+    return (
+      memory.buffer instanceof SharedArrayBuffer &&
+      WebAssembly.validate(SIMD_MODULE)
+    );
+  } catch (e) {
+    return false;
+  }
+}
+
+/**
+ * The url of a build of the bindings, its SIMD and threads variant
+ * (BUILD_WEB_SIMD_THREADS) if requested.
+ * @param {string} name - name of the build, e.g. hsim_bindings_worker
+ * @param {boolean} simdThreads - whether to use the SIMD and threads variant
+ * @returns {string} url of the build
+ */
+export function bindingsUrl(
+  name = "hsim_bindings",
+  simdThreads = checkSimdThreadsSupport()
+) {
+  return simdThreads ? name + "_simd_threads.js" : name + ".js";
+}
+
+/**
+ * Load the bindings with a script element, the SIMD and threads variant
+ * where the browser supports it. Falls back to the default build if the
+ * variant fails to load, e.g. when it wasn't built.
+ * @param {string} name - name of the build
+ */
+export function loadBindings(name = "hsim_bindings") {
+  const load = (url, fallback) => {
+    const script = document.createElement("script");
+    script.async = true;
+    script.src = url;
+    if (fallback !== null) {
+      script.onerror = () => {
+        console.warn("Failed to load " + url + ", loading " + fallback);
+        script.remove();
+        load(fallback, null);
+      };
+    }
+    document.body.appendChild(script);
+  };
+  const url = bindingsUrl(name);
+  const fallback = bindingsUrl(name, false);
+  load(url, url === fallback ? null : fallback);
+}
+
 /**
  * SimEnv class
  *
@@ -194,4 +269,126 @@ class SimEnv {
   }
 }
 
+/**
+ * SimEnvWorker class
+ *
+ * Proxy to a SimEnv running in the sim_worker.js Web Worker, rendering into
+ * the OffscreenCanvas of a canvas element. Every method returns a Promise
+ * resolved when the worker has handled the request.
+ */
+export class SimEnvWorker {
+  /**
+   * Create the worker, transferring the rendering of canvas to it.
+   * @param {HTMLCanvasElement} canvas - canvas the worker renders to
+   * @param {string} workerUrl - url of the worker bundle
+   */
+  constructor(canvas, workerUrl = "sim_worker.js") {
+    this.worker = new Worker(workerUrl);
+    this.canvas = canvas.transferControlToOffscreen();
+    this.nextId = 0;
+    this.pending = new Map();
+    this.worker.onmessage = event => {
+      const message = event.data;
+      const request = this.pending.get(message.id);
+      if (request === undefined) {
+        return;
+      }
+      this.pending.delete(message.id);
+      if (message.error !== undefined) {
+        request.reject(new Error(message.error));
+      } else {
+        request.resolve(message);
+      }
+    };
+  }
+
+  /**
+   * Load the bindings and the assets in the worker and create the simulator.
+   * @param {Object} options - scene (path of the scene in the FS), files
+   *   (array of {url, path} streamed into the FS), agentConfig, episode and
+   *   bindingsUrl (url of hsim_bindings_worker.js, or of its SIMD and
+   *   threads variant where supported) and fallbackBindingsUrl (loaded if
+   *   bindingsUrl fails to)
+   */
+  init(options) {
+    return this.request(
+      {
+        type: "init",
+        canvas: this.canvas,
+        bindingsUrl: bindingsUrl("hsim_bindings_worker"),
+        fallbackBindingsUrl: bindingsUrl("hsim_bindings_worker", false),
+        episode: {},
+        ...options
+      },
+      [this.canvas]
+    );
+  }
+
+  /**
+   * Resets the simulation.
+   */
+  reset() {
+    return this.request({ type: "reset" });
+  }
+
+  /**
+   * Take one step in the simulation.
+   * @param {string} action - action to take
+   */
+  step(action) {
+    return this.request({ type: "step", action });
+  }
+
+  /**
+   * Display an observation from the given sensorId to the canvas.
+   * @param {string} sensorId - id of sensor
+   */
+  displayObservation(sensorId) {
+    return this.request({ type: "display", sensorId });
+  }
+
+  /**
+   * Get an observation from the given sensorId.
+   * @param {string} sensorId - id of sensor
+   * @returns {Promise} resolved with {data: ArrayBuffer, shape: Array}
+   */
+  getObservation(sensorId) {
+    return this.request({ type: "observe", sensorId }).then(message => ({
+      data: message.data,
+      shape: message.shape
+    }));
+  }
+
+  /**
+   * Get the distance to goal in polar coordinates.
+   * @returns {Promise} resolved with [magnitude, clockwise-angle (in radians)]
+   */
+  distanceToGoal() {
+    return this.request({ type: "distanceToGoal" }).then(
+      message => message.distance
+    );
+  }
+
+  /**
+   * Stop the worker, rejecting the pending requests.
+   */
+  terminate() {
+    this.worker.terminate();
+    for (const request of this.pending.values()) {
+      request.reject(new Error("SimEnvWorker terminated"));
+    }
+    this.pending.clear();
+  }
+
+  // PRIVATE methods.
+
+  request(message, transfer = []) {
+    const id = this.nextId++;
+    return new Promise((resolve, reject) => {
+      this.pending.set(id, { resolve, reject });
+      this.worker.postMessage({ id, ...message }, transfer);
+    });
+  }
+}
+
 export default SimEnv;
@@ -0,0 +1,112 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+import {
+  defaultAgentConfig,
+  defaultEpisode,
+  defaultResolution
+} from "./defaults";
+import { SimEnvWorker } from "./simenv_embind";
+import { buildConfigFromURLParameters } from "./utils";
+
+/**
+ * Demo running the simulator in a Web Worker, so that loading and rendering
+ * the scene never blocks the main thread.
+ */
+class WorkerDemo {
+  constructor(canvasId = "canvas") {
+    this.canvasId = canvasId;
+    this.actions = [
+      { name: "moveForward", key: "w" },
+      { name: "turnLeft", key: "a" },
+      { name: "turnRight", key: "d" },
+      { name: "lookUp", key: "ArrowUp" },
+      { name: "lookDown", key: "ArrowDown" }
+    ];
+    // a key press while the worker is still stepping is dropped
+    this.busy = false;
+  }
+
+  // the {url, path} of an asset, a url is stored under its file name
+  asset(url) {
+    let path = url;
+    if (url.indexOf("http") === 0) {
+      const splits = url.split("/");
+      path = splits[splits.length - 1];
+    }
+    return { url, path };
+  }
+
+  display(agentConfig = defaultAgentConfig, episode = {}) {
+    const config = buildConfigFromURLParameters();
+    if (config.useDefaultEpisode) {
+      episode = defaultEpisode;
+    }
+    const scene = this.asset(window.config.scene);
+    const fileNoExtension = window.config.scene.substr(
+      0,
+      window.config.scene.lastIndexOf(".")
+    );
+    const files = [scene, this.asset(fileNoExtension + ".navmesh")];
+
+    const canvas = document.getElementById(this.canvasId);
+    canvas.width = defaultResolution.width;
+    canvas.height = defaultResolution.height;
+    this.status = document.getElementById("status");
+    this.simenv = new SimEnvWorker(canvas);
+    this.simenv
+      .init({
+        scene: scene.path,
+        files,
+        episode,
+        // sensor types are resolved in the worker, COLOR is the default one
+        agentConfig: {
+          ...agentConfig,
+          sensorSpecifications: [
+            {
+              uuid: "rgb",
+              resolution: [defaultResolution.height, defaultResolution.width]
+            }
+          ]
+        }
+      })
+      .then(() => {
+        this.bindKeys();
+        return this.render();
+      })
+      .catch(error => this.setStatus(error.message));
+  }
+
+  // PRIVATE methods.
+
+  setStatus(text) {
+    this.status.innerHTML = text;
+  }
+
+  render() {
+    return this.simenv.displayObservation("rgb").then(() => {
+      this.setStatus("Ready");
+    });
+  }
+
+  bindKeys() {
+    document.addEventListener("keydown", event => {
+      const action = this.actions.find(a => a.key === event.key);
+      if (action === undefined || this.busy) {
+        return;
+      }
+      event.preventDefault();
+      this.busy = true;
+      this.simenv
+        .step(action.name)
+        .then(() => this.render())
+        .catch(error => this.setStatus(error.message))
+        .then(() => {
+          this.busy = false;
+        });
+    });
+  }
+}
+
+export default WorkerDemo;
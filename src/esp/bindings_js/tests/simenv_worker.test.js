@@ -0,0 +1,76 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+import {
+  SimEnvWorker,
+  bindingsUrl,
+  checkSimdThreadsSupport
+} from "../modules/simenv_embind";
+
+// Answers every message on the next tick like sim_worker.js does
+class FakeWorker {
+  constructor(url) {
+    this.url = url;
+    this.messages = [];
+  }
+
+  postMessage(message, transfer) {
+    this.messages.push({ message, transfer });
+    let reply = { id: message.id };
+    if (message.type === "observe") {
+      const data = new Uint8Array([1, 2, 3, 4]).buffer;
+      reply = { ...reply, data, shape: [1, 1, 4] };
+    } else if (message.type === "step" && message.action === "fly") {
+      reply = { ...reply, error: "Unknown action fly" };
+    }
+    setTimeout(() => this.onmessage({ data: reply }), 0);
+  }
+
+  terminate() {}
+}
+
+function createSimEnvWorker() {
+  global.Worker = FakeWorker;
+  const canvas = { transferControlToOffscreen: () => ({ offscreen: true }) };
+  return new SimEnvWorker(canvas);
+}
+
+test("SimEnvWorker transfers the canvas on init", () => {
+  const simenv = createSimEnvWorker();
+  return simenv.init({ scene: "scene.glb", files: [] }).then(() => {
+    const { message, transfer } = simenv.worker.messages[0];
+    expect(message.type).toEqual("init");
+    expect(message.scene).toEqual("scene.glb");
+    expect(message.bindingsUrl).toEqual("hsim_bindings_worker.js");
+    expect(transfer).toEqual([simenv.canvas]);
+  });
+});
+
+test("SimEnvWorker matches replies to requests", () => {
+  const simenv = createSimEnvWorker();
+  const step = simenv.step("moveForward");
+  const observation = simenv.getObservation("rgb");
+  return Promise.all([step, observation]).then(([, obs]) => {
+    expect(Array.from(new Uint8Array(obs.data))).toEqual([1, 2, 3, 4]);
+    expect(obs.shape).toEqual([1, 1, 4]);
+    expect(simenv.pending.size).toEqual(0);
+  });
+});
+
+test("SimEnvWorker rejects failed requests", () => {
+  const simenv = createSimEnvWorker();
+  return expect(simenv.step("fly")).rejects.toThrow("Unknown action fly");
+});
+
+test("bindingsUrl falls back without SIMD and threads", () => {
+  expect(bindingsUrl("hsim_bindings", true)).toEqual(
+    "hsim_bindings_simd_threads.js"
+  );
+  expect(bindingsUrl("hsim_bindings", false)).toEqual("hsim_bindings.js");
+  // not a cross-origin isolated page
+  expect(checkSimdThreadsSupport()).toEqual(false);
+  expect(bindingsUrl("hsim_bindings_worker")).toEqual(
+    "hsim_bindings_worker.js"
+  );
+});
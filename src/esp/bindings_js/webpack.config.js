@@ -60,9 +60,30 @@ const config = {
       template: path.resolve(__dirname, "viewer.html"),
       filename: path.resolve(buildRootPath, "viewer.html"),
       hash: true
+    }),
+    new HtmlWebpackPlugin({
+      template: path.resolve(__dirname, "worker.html"),
+      filename: path.resolve(buildRootPath, "worker.html"),
+      hash: true
     })
   ],
   devtool: "source-map"
 };
 
-module.exports = config;
+// The Web Worker running the simulator for worker.html, it loads
+// hsim_bindings_worker.js itself
+const workerConfig = {
+  target: "webworker",
+  entry: path.resolve(__dirname, "modules/sim_worker.js"),
+  output: {
+    path: buildRootPath,
+    filename: "sim_worker.js"
+  },
+  module: {
+    rules: [config.module.rules[0]]
+  },
+  resolve: config.resolve,
+  devtool: "source-map"
+};
+
+module.exports = [config, workerConfig];
@@ -4,6 +4,19 @@
 
 #include "Buffer.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <Corrade/Utility/Assert.h>
+
+#ifdef ESP_BUILD_WITH_CUDA
+#include <cuda_runtime.h>
+#endif
+
 namespace esp {
 namespace core {
 
@@ -14,6 +27,7 @@ size_t getDataTypeByteSize(DataType dt) {
       return 1;
     case DataType::DT_INT16:
     case DataType::DT_UINT16:
+    case DataType::DT_FLOAT16:
       return 2;
     case DataType::DT_INT32:
     case DataType::DT_UINT32:
@@ -30,21 +44,254 @@ size_t getDataTypeByteSize(DataType dt) {
   }
 }
 
+namespace {
+//! deleter of wrapped external memory, which the buffer does not own
+void noopDeleter(uint8_t*, size_t) {}
+
+void pooledDeleter(uint8_t* data, size_t size) {
+  BufferPool::release(data, size, /*pinned=*/false);
+}
+
+void pinnedDeleter(uint8_t* data, size_t size) {
+  BufferPool::release(data, size, /*pinned=*/true);
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+void deviceDeleter(uint8_t* data, size_t) {
+  cudaFree(data);
+}
+
+//! makes @p device current for the lifetime of the guard
+class DeviceGuard {
+ public:
+  explicit DeviceGuard(int device) {
+    cudaGetDevice(&previous_);
+    cudaSetDevice(device);
+  }
+  ~DeviceGuard() { cudaSetDevice(previous_); }
+
+ private:
+  int previous_ = 0;
+};
+#endif
+
+constexpr size_t PageSize = 4096;
+
+struct Pool {
+  std::mutex mutex;
+  //! free memory by size class, pageable and pinned
+  std::unordered_map<size_t, std::vector<uint8_t*>> freeLists[2];
+  size_t cachedBytes = 0;
+  size_t maxCachedBytes = size_t{1} << 30;
+};
+
+Pool& pool() {
+  // never destroyed, buffers of static lifetime are released after main()
+  static Pool* pool = new Pool;
+  return *pool;
+}
+
+uint8_t* allocateClass(size_t classSize, bool pinned) {
+#ifdef ESP_BUILD_WITH_CUDA
+  if (pinned) {
+    void* data = nullptr;
+    if (cudaHostAlloc(&data, classSize, cudaHostAllocDefault) !=
+        cudaSuccess) {
+      return nullptr;
+    }
+    return static_cast<uint8_t*>(data);
+  }
+#endif
+  void* data = nullptr;
+  const size_t alignment =
+      classSize >= PageSize ? PageSize : BufferPool::Alignment;
+  if (posix_memalign(&data, alignment, classSize) != 0) {
+    return nullptr;
+  }
+  return static_cast<uint8_t*>(data);
+}
+
+void freeClass(uint8_t* data, bool pinned) {
+#ifdef ESP_BUILD_WITH_CUDA
+  if (pinned) {
+    cudaFreeHost(data);
+    return;
+  }
+#endif
+  free(data);
+}
+
+bool usePinned(bool pinned) {
+#ifdef ESP_BUILD_WITH_CUDA
+  return pinned;
+#else
+  static_cast<void>(pinned);
+  return false;
+#endif
+}
+}  // namespace
+
+size_t BufferPool::sizeClass(size_t size) {
+  if (size <= Alignment) {
+    return Alignment;
+  }
+  // four classes per power of two, in steps of a quarter of it
+  size_t power = Alignment;
+  while (power * 2 < size) {
+    power *= 2;
+  }
+  const size_t step = std::max(power / 4, Alignment);
+  return (size + step - 1) / step * step;
+}
+
+uint8_t* BufferPool::allocate(size_t size, bool pinned) {
+  if (size == 0) {
+    return nullptr;
+  }
+  pinned = usePinned(pinned);
+  const size_t classSize = sizeClass(size);
+  uint8_t* data = nullptr;
+  {
+    Pool& p = pool();
+    std::lock_guard<std::mutex> lock{p.mutex};
+    auto freeList = p.freeLists[pinned].find(classSize);
+    if (freeList != p.freeLists[pinned].end() && !freeList->second.empty()) {
+      data = freeList->second.back();
+      freeList->second.pop_back();
+      p.cachedBytes -= classSize;
+    }
+  }
+  if (!data) {
+    data = allocateClass(classSize, pinned);
+    CORRADE_ASSERT(data,
+                   "BufferPool::allocate: can't allocate" << classSize
+                                                          << "bytes",
+                   nullptr);
+  }
+  memset(data, 0, size);
+  return data;
+}
+
+void BufferPool::release(uint8_t* data, size_t size, bool pinned) {
+  if (!data) {
+    return;
+  }
+  pinned = usePinned(pinned);
+  const size_t classSize = sizeClass(size);
+  {
+    Pool& p = pool();
+    std::lock_guard<std::mutex> lock{p.mutex};
+    if (p.cachedBytes + classSize <= p.maxCachedBytes) {
+      p.freeLists[pinned][classSize].push_back(data);
+      p.cachedBytes += classSize;
+      return;
+    }
+  }
+  freeClass(data, pinned);
+}
+
+size_t BufferPool::cachedBytes() {
+  Pool& p = pool();
+  std::lock_guard<std::mutex> lock{p.mutex};
+  return p.cachedBytes;
+}
+
+void BufferPool::setMaxCachedBytes(size_t maxCachedBytes) {
+  Pool& p = pool();
+  std::lock_guard<std::mutex> lock{p.mutex};
+  p.maxCachedBytes = maxCachedBytes;
+  for (int pinned = 0; pinned < 2; ++pinned) {
+    for (auto& freeList : p.freeLists[pinned]) {
+      while (p.cachedBytes > maxCachedBytes && !freeList.second.empty()) {
+        freeClass(freeList.second.back(), pinned);
+        freeList.second.pop_back();
+        p.cachedBytes -= freeList.first;
+      }
+    }
+  }
+}
+
+Buffer::Buffer(void* externalData,
+               const std::vector<size_t> shape,
+               const DataType dataType) {
+  this->shape = shape;
+  this->dataType = dataType;
+  size_t size = 1;
+  for (size_t i = 0; i < this->shape.size(); i++) {
+    size *= this->shape[i];
+  }
+  this->totalSize = size;
+  this->data = Corrade::Containers::Array<uint8_t>{
+      static_cast<uint8_t*>(externalData), size * getDataTypeByteSize(dataType),
+      noopDeleter};
+  isExternal_ = true;
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+Buffer::ptr Buffer::createOnDevice(const std::vector<size_t>& shape,
+                                   DataType dataType,
+                                   int device) {
+  auto buffer = Buffer::create();
+  buffer->shape = shape;
+  buffer->dataType = dataType;
+  buffer->totalSize = 1;
+  for (size_t extent : shape) {
+    buffer->totalSize *= extent;
+  }
+  const size_t bytes = buffer->totalSize * getDataTypeByteSize(dataType);
+  DeviceGuard guard{device};
+  void* data = nullptr;
+  if (bytes > 0 && (cudaMalloc(&data, bytes) != cudaSuccess ||
+                    cudaMemset(data, 0, bytes) != cudaSuccess)) {
+    cudaFree(data);
+    return nullptr;
+  }
+  buffer->data = Corrade::Containers::Array<uint8_t>{
+      static_cast<uint8_t*>(data), bytes, deviceDeleter};
+  buffer->deviceId_ = device;
+  return buffer;
+}
+#endif
+
+void Buffer::synchronize() const {
+#ifdef ESP_BUILD_WITH_CUDA
+  if (deviceId_ >= 0) {
+    DeviceGuard guard{deviceId_};
+    cudaStreamSynchronize(0);
+  }
+#endif
+}
+
 void Buffer::clear() {
-  if (this->data != nullptr) {
-    memset(this->data, 0, this->data.size());
+  if (this->data == nullptr) {
+    return;
+  }
+#ifdef ESP_BUILD_WITH_CUDA
+  if (deviceId_ >= 0) {
+    DeviceGuard guard{deviceId_};
+    cudaMemset(this->data, 0, this->data.size());
+    return;
   }
+#endif
+  memset(this->data, 0, this->data.size());
 }
 
 void Buffer::alloc() {
+  // never replace memory that was provided by the caller or on a device
+  CORRADE_INTERNAL_ASSERT(!isExternal_ && deviceId_ < 0);
+  isPinned_ = usePinned(isPinned_);
   size_t size = 1;
   for (size_t i = 0; i < this->shape.size(); i++) {
     size *= this->shape[i];
   }
   if (size != this->totalSize) {
     this->totalSize = size;
+    const size_t bytes = size * getDataTypeByteSize(dataType);
+    // the old memory goes back to the pool first, so that it can be reused
+    this->data = Corrade::Containers::Array<uint8_t>{};
     this->data = Corrade::Containers::Array<uint8_t>{
-        size * getDataTypeByteSize(dataType)};
+        BufferPool::allocate(bytes, isPinned_), bytes,
+        isPinned_ ? pinnedDeleter : pooledDeleter};
   }
 }
 
@@ -52,6 +299,8 @@ void Buffer::dealloc() {
   if (this->data != nullptr) {
     this->data = Corrade::Containers::Array<uint8_t>{};
     this->totalSize = 0;
+    isExternal_ = false;
+    deviceId_ = -1;
   }
 }
 
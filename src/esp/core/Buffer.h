@@ -25,19 +25,124 @@ enum class DataType {
   DT_UINT64 = 8,
   DT_FLOAT = 9,
   DT_DOUBLE = 10,
+  //! IEEE half-precision float
+  DT_FLOAT16 = 11,
+};
+
+//! Size in bytes of a single element of the given data type
+size_t getDataTypeByteSize(DataType dt);
+
+/**
+ * @brief Pool of the memory allocated by @ref Buffer
+ *
+ * Allocations are rounded up to size classes, four per power of two, and
+ * released memory is kept in a free list of its class for the next buffer of
+ * that class, up to @ref setMaxCachedBytes() in total. The memory is aligned
+ * to @ref Alignment bytes, or to pages from a page size on. Pinned memory,
+ * with CUDA, is page-locked with `cudaHostAlloc()` so that host-device
+ * copies run at full bandwidth, and pooled separately. Thread-safe.
+ */
+class BufferPool {
+ public:
+  //! The least alignment of the memory, enough for any SIMD load
+  static constexpr size_t Alignment = 64;
+
+  /**
+   * @brief Zero-initialized memory of at least @p size bytes, nullptr for zero
+   * @param size The size
+   * @param pinned Whether to page-lock the memory, ignored without CUDA
+   */
+  static uint8_t* allocate(size_t size, bool pinned = false);
+
+  /**
+   * @brief Return memory from @ref allocate() with the same @p size and
+   * @p pinned to the pool
+   */
+  static void release(uint8_t* data, size_t size, bool pinned = false);
+
+  //! The size in bytes of the allocations made for @p size bytes
+  static size_t sizeClass(size_t size);
+
+  //! The bytes kept in the free lists
+  static size_t cachedBytes();
+
+  //! Limit the bytes kept in the free lists, freeing memory beyond it
+  static void setMaxCachedBytes(size_t maxCachedBytes);
+
+  //! Free all memory kept in the free lists
+  static void trim() { setMaxCachedBytes(0); }
 };
 
 class Buffer {
  public:
   explicit Buffer() {}
-  explicit Buffer(const std::vector<size_t> shape, const DataType dataType) {
+  /**
+   * @brief Allocate a buffer of @p shape from the @ref BufferPool
+   * @param shape The shape
+   * @param dataType The type of the elements
+   * @param pinned Whether to back it with page-locked memory, see @ref
+   * BufferPool
+   */
+  explicit Buffer(const std::vector<size_t> shape,
+                  const DataType dataType,
+                  const bool pinned = false)
+      : isPinned_{pinned} {
     this->shape = shape;
     this->dataType = dataType;
     alloc();
   }
+  /**
+   * @brief Wrap caller-provided memory without copying it.
+   *
+   * The buffer does not take ownership: @p externalData, e.g. pinned host
+   * memory or the storage of a numpy array / torch tensor, must stay valid
+   * for as long as the buffer is in use and hold at least the product of
+   * @p shape elements of @p dataType.
+   */
+  explicit Buffer(void* externalData,
+                  const std::vector<size_t> shape,
+                  const DataType dataType);
+
+#ifdef ESP_BUILD_WITH_CUDA
+  /**
+   * @brief A buffer of @p shape in the memory of the CUDA device @p device,
+   * e.g. to read GPU observations into, see @ref deviceId(). Not pooled.
+   * @return nullptr if the memory can't be allocated
+   */
+  static std::shared_ptr<Buffer> createOnDevice(
+      const std::vector<size_t>& shape,
+      DataType dataType,
+      int device);
+#endif
+
   void clear();
   virtual ~Buffer() { dealloc(); }
 
+  /**
+   * @brief Whether the memory of the buffer was provided by the caller, see
+   * @ref Buffer(void*, std::vector<size_t>, DataType)
+   */
+  bool isExternal() const { return isExternal_; }
+
+  /**
+   * @brief Whether the memory of the buffer is page-locked, never without
+   * CUDA
+   */
+  bool isPinned() const { return isPinned_; }
+
+  /**
+   * @brief The CUDA device holding the memory of the buffer, -1 for host
+   * memory, see @ref createOnDevice()
+   */
+  int deviceId() const { return deviceId_; }
+
+  /**
+   * @brief Wait for the copies into device memory issued on the default
+   * stream, e.g. by @ref gfx::RenderTarget::readFrameRgbaGPU(), so that the
+   * buffer can be read on any stream. Does nothing for host memory.
+   */
+  void synchronize() const;
+
  protected:
   void alloc();
   void dealloc();
@@ -48,6 +153,11 @@ class Buffer {
   DataType dataType = DataType::DT_UINT8;
   std::vector<size_t> shape;
 
+ protected:
+  bool isExternal_ = false;
+  bool isPinned_ = false;
+  int deviceId_ = -1;
+
   ESP_SMART_POINTERS(Buffer)
 };
 
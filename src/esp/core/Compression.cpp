@@ -0,0 +1,115 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace esp {
+namespace core {
+
+namespace {
+constexpr size_t MIN_MATCH = 4;
+constexpr int HASH_BITS = 12;
+}  // namespace
+
+std::vector<unsigned char> compressBytes(const unsigned char* data,
+                                         size_t size) {
+  std::vector<unsigned char> compressed;
+  compressed.reserve(size / 2 + 16);
+  const auto writeLength = [&](size_t length) {
+    for (; length >= 255; length -= 255)
+      compressed.push_back(255);
+    compressed.push_back(length);
+  };
+  const auto writeLiterals = [&](size_t begin, size_t end,
+                                 size_t matchLength) {
+    const size_t literals = end - begin;
+    compressed.push_back(std::min<size_t>(literals, 15) << 4 |
+                         std::min<size_t>(matchLength, 15));
+    if (literals >= 15)
+      writeLength(literals - 15);
+    compressed.insert(compressed.end(), data + begin, data + end);
+  };
+
+  constexpr size_t NoPosition = ~size_t(0);
+  std::vector<size_t> positions(size_t(1) << HASH_BITS, NoPosition);
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i + MIN_MATCH <= size) {
+    uint32_t sequence;
+    std::memcpy(&sequence, data + i, sizeof(sequence));
+    const uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+    const size_t candidate = positions[hash];
+    positions[hash] = i;
+    if (candidate == NoPosition || i - candidate > 0xffff ||
+        std::memcmp(data + candidate, data + i, MIN_MATCH) != 0) {
+      ++i;
+      continue;
+    }
+
+    size_t length = MIN_MATCH;
+    while (i + length < size && data[candidate + length] == data[i + length])
+      ++length;
+    const size_t offset = i - candidate;
+    writeLiterals(anchor, i, length - MIN_MATCH);
+    compressed.push_back(offset & 0xff);
+    compressed.push_back(offset >> 8);
+    if (length - MIN_MATCH >= 15)
+      writeLength(length - MIN_MATCH - 15);
+    i += length;
+    anchor = i;
+  }
+  writeLiterals(anchor, size, 0);
+  return compressed;
+}
+
+bool decompressBytes(const unsigned char* compressed,
+                     size_t compressedSize,
+                     unsigned char* data,
+                     size_t size) {
+  size_t in = 0;
+  size_t out = 0;
+  const auto readLength = [&](size_t& length) {
+    unsigned char byte;
+    do {
+      if (in == compressedSize)
+        return false;
+      byte = compressed[in++];
+      length += byte;
+    } while (byte == 255);
+    return true;
+  };
+
+  while (in < compressedSize) {
+    const unsigned char token = compressed[in++];
+    size_t literals = token >> 4;
+    if ((literals == 15 && !readLength(literals)) ||
+        literals > compressedSize - in || literals > size - out)
+      return false;
+    std::memcpy(data + out, compressed + in, literals);
+    in += literals;
+    out += literals;
+    if (in == compressedSize)
+      break;
+
+    if (compressedSize - in < 2)
+      return false;
+    const size_t offset = compressed[in] | compressed[in + 1] << 8;
+    in += 2;
+    size_t length = token & 15;
+    if ((length == 15 && !readLength(length)) || offset == 0 ||
+        offset > out || length + MIN_MATCH > size - out)
+      return false;
+    // the match may overlap the bytes it produces
+    for (length += MIN_MATCH; length > 0; --length, ++out)
+      data[out] = data[out - offset];
+  }
+  return out == size;
+}
+
+}  // namespace core
+}  // namespace esp
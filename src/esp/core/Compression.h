@@ -0,0 +1,45 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_COMPRESSION_H_
+#define ESP_CORE_COMPRESSION_H_
+
+/** @file
+ * @brief Functions @ref esp::core::compressBytes(),
+ * @ref esp::core::decompressBytes()
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Compress @p size bytes at @p data with a byte oriented LZ77 codec
+ *
+ * In the spirit of the compressors of the Detour tile cache: each sequence is
+ * a token with the number of literals in the high and the match length minus
+ * 4 in the low four bits, both continued by bytes of 255 if they don't fit,
+ * the literals, and the 16 bit offset and continued length of the match. The
+ * last sequence only has literals. Fast, and good on data with repeated
+ * runs, e.g. navmesh tiles or flat regions of a frame.
+ */
+std::vector<unsigned char> compressBytes(const unsigned char* data,
+                                         size_t size);
+
+/**
+ * @brief Decompress the output of @ref compressBytes() into @p size bytes at
+ * @p data
+ * @return Whether @p compressed decompressed to exactly @p size bytes
+ */
+bool decompressBytes(const unsigned char* compressed,
+                     size_t compressedSize,
+                     unsigned char* data,
+                     size_t size);
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_COMPRESSION_H_
@@ -0,0 +1,164 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "Configuration.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace core {
+
+namespace {
+//! the interned key names, a deque so that references to them stay valid
+struct KeyRegistry {
+  std::shared_timed_mutex mutex;
+  std::unordered_map<std::string, int> ids;
+  std::deque<std::string> names;
+};
+
+KeyRegistry& keyRegistry() {
+  static KeyRegistry registry;
+  return registry;
+}
+}  // namespace
+
+int ConfigKey::intern(const std::string& name) {
+  KeyRegistry& registry = keyRegistry();
+  {
+    std::shared_lock<std::shared_timed_mutex> lock{registry.mutex};
+    auto id = registry.ids.find(name);
+    if (id != registry.ids.end()) {
+      return id->second;
+    }
+  }
+  std::unique_lock<std::shared_timed_mutex> lock{registry.mutex};
+  auto inserted = registry.ids.emplace(name, registry.names.size());
+  if (inserted.second) {
+    registry.names.push_back(name);
+  }
+  return inserted.first->second;
+}
+
+int ConfigKey::find(const std::string& name) {
+  KeyRegistry& registry = keyRegistry();
+  std::shared_lock<std::shared_timed_mutex> lock{registry.mutex};
+  auto id = registry.ids.find(name);
+  return id == registry.ids.end() ? ID_UNDEFINED : id->second;
+}
+
+const std::string& ConfigKey::name(int id) {
+  KeyRegistry& registry = keyRegistry();
+  std::shared_lock<std::shared_timed_mutex> lock{registry.mutex};
+  return registry.names.at(id);
+}
+
+std::string ConfigValue::toString() const {
+  switch (type) {
+    case ConfigValueType::Bool:
+      return Cr::Utility::ConfigurationValue<bool>::toString(b, {});
+    case ConfigValueType::Int:
+      return Cr::Utility::ConfigurationValue<int>::toString(i, {});
+    case ConfigValueType::Float:
+      return Cr::Utility::ConfigurationValue<float>::toString(f, {});
+    case ConfigValueType::Double:
+      return Cr::Utility::ConfigurationValue<double>::toString(d, {});
+    case ConfigValueType::String:
+      return string;
+    case ConfigValueType::Vec3:
+      return Cr::Utility::ConfigurationValue<Magnum::Vector3>::toString(
+          get<Magnum::Vector3>(), {});
+    case ConfigValueType::StringGroup:
+      return group.front();
+    case ConfigValueType::Unset:
+      break;
+  }
+  return {};
+}
+
+int Configuration::addStringToGroup(const std::string& key,
+                                    const std::string& value) {
+  ConfigValue& groupValue = valueAt(ConfigKey::intern(key));
+  if (groupValue.type != ConfigValueType::StringGroup) {
+    // a single value becomes the first of the group
+    std::vector<std::string> group;
+    if (groupValue.type != ConfigValueType::Unset) {
+      group.push_back(groupValue.toString());
+    }
+    groupValue = ConfigValue{};
+    groupValue.type = ConfigValueType::StringGroup;
+    groupValue.group = std::move(group);
+  }
+  groupValue.group.push_back(value);
+  return groupValue.group.size();
+}
+
+std::vector<std::string> Configuration::getStringGroup(
+    const std::string& key) const {
+  const ConfigValue* value = find(ConfigKey::find(key));
+  if (!value) {
+    return {};
+  }
+  if (value->type == ConfigValueType::StringGroup) {
+    return value->group;
+  }
+  return {value->toString()};
+}
+
+bool Configuration::removeValue(const std::string& key) {
+  const int id = ConfigKey::find(key);
+  if (!find(id)) {
+    return false;
+  }
+  ConfigValue& value = values_[id];
+  if (value.type == ConfigValueType::StringGroup && value.group.size() > 1) {
+    value.group.erase(value.group.begin());
+  } else {
+    value = ConfigValue{};
+  }
+  return true;
+}
+
+Cr::Utility::ConfigurationGroup Configuration::getConfigurationGroup() const {
+  Cr::Utility::ConfigurationGroup group;
+  for (int id = 0; id < values_.size(); ++id) {
+    const ConfigValue& value = values_[id];
+    const std::string& key = ConfigKey::name(id);
+    switch (value.type) {
+      case ConfigValueType::Bool:
+        group.setValue(key, value.b);
+        break;
+      case ConfigValueType::Int:
+        group.setValue(key, value.i);
+        break;
+      case ConfigValueType::Float:
+        group.setValue(key, value.f);
+        break;
+      case ConfigValueType::Double:
+        group.setValue(key, value.d);
+        break;
+      case ConfigValueType::String:
+        group.setValue(key, value.string);
+        break;
+      case ConfigValueType::Vec3:
+        group.setValue(key, value.get<Magnum::Vector3>());
+        break;
+      case ConfigValueType::StringGroup:
+        for (const std::string& string : value.group) {
+          group.addValue(key, string);
+        }
+        break;
+      case ConfigValueType::Unset:
+        break;
+    }
+  }
+  return group;
+}
+
+}  // namespace core
+}  // namespace esp
@@ -5,16 +5,198 @@
 #ifndef ESP_CORE_CONFIGURATION_H_
 #define ESP_CORE_CONFIGURATION_H_
 
+/** @file
+ * @brief Class @ref esp::core::Configuration, class @ref
+ * esp::core::ConfigKey, struct @ref esp::core::ConfigValue
+ */
+
 #include <Corrade/Utility/Configuration.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/ConfigurationValue.h>
+#include <Magnum/Math/Vector3.h>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "esp/core/esp.h"
 
 namespace esp {
 namespace core {
 
+/**
+ * @brief A configuration key interned to a small integer ID, shared by all
+ * @ref Configuration instances
+ *
+ * The ID is the offset of the value in the storage of a configuration, so
+ * reading through a key constructed once, e.g. a function-local static, is a
+ * direct load without hashing the name. Interning is thread-safe.
+ */
+class ConfigKey {
+ public:
+  explicit ConfigKey(const std::string& name) : id_{intern(name)} {}
+
+  /** @brief The interned ID of the key */
+  int id() const { return id_; }
+
+  /** @brief The name of the key */
+  const std::string& name() const { return name(id_); }
+
+  /** @brief The ID of @p name, interning it if it is new */
+  static int intern(const std::string& name);
+
+  /**
+   * @brief The ID of @p name, or @ref ID_UNDEFINED if it was never interned,
+   * in which case no configuration holds a value for it
+   */
+  static int find(const std::string& name);
+
+  /** @brief The name of an interned ID, stays valid forever */
+  static const std::string& name(int id);
+
+ private:
+  int id_;
+};
+
+/** @brief The type a @ref ConfigValue holds */
+enum class ConfigValueType : uint8_t {
+  Unset,
+  Bool,
+  Int,
+  Float,
+  Double,
+  String,
+  Vec3,
+  //! several strings, see @ref Configuration::addStringToGroup()
+  StringGroup,
+};
+
+/**
+ * @brief A typed configuration value
+ *
+ * Reading a value as its own type, or a number as another number type, is a
+ * plain load or cast. Other conversions go through the string representation
+ * of @ref Corrade::Utility::ConfigurationValue, as for values stored in a
+ * @ref Corrade::Utility::ConfigurationGroup.
+ */
+struct ConfigValue {
+  ConfigValue() : d{0.0} {}
+
+  void set(bool value) {
+    type = ConfigValueType::Bool;
+    b = value;
+  }
+  void set(int value) {
+    type = ConfigValueType::Int;
+    i = value;
+  }
+  void set(float value) {
+    type = ConfigValueType::Float;
+    f = value;
+  }
+  void set(double value) {
+    type = ConfigValueType::Double;
+    d = value;
+  }
+  void set(const std::string& value) {
+    type = ConfigValueType::String;
+    string = value;
+  }
+  void set(const char* value) { set(std::string{value}); }
+  void set(const Magnum::Vector3& value) {
+    type = ConfigValueType::Vec3;
+    vec3[0] = value.x();
+    vec3[1] = value.y();
+    vec3[2] = value.z();
+  }
+
+  /** @brief Whether the value is a bool, int, float or double */
+  bool isNumber() const {
+    return type == ConfigValueType::Bool || type == ConfigValueType::Int ||
+           type == ConfigValueType::Float || type == ConfigValueType::Double;
+  }
+
+  /** @brief The value as a number type, which it must be, see @ref isNumber */
+  template <typename T>
+  T number() const {
+    switch (type) {
+      case ConfigValueType::Bool:
+        return T(b);
+      case ConfigValueType::Int:
+        return T(i);
+      case ConfigValueType::Float:
+        return T(f);
+      default:
+        return T(d);
+    }
+  }
+
+  /** @brief The value as a string, the first one of a string group */
+  std::string toString() const;
+
+  /** @brief The value converted to @p T, see the class documentation */
+  template <typename T>
+  T get() const;
+
+  ConfigValueType type = ConfigValueType::Unset;
+  union {
+    bool b;
+    int i;
+    float f;
+    double d;
+    float vec3[3];
+  };
+  std::string string;
+  std::vector<std::string> group;
+};
+
+template <typename T>
+inline T ConfigValue::get() const {
+  return Corrade::Utility::ConfigurationValue<T>::fromString(toString(), {});
+}
+template <>
+inline bool ConfigValue::get<bool>() const {
+  return isNumber() ? number<bool>()
+                    : Corrade::Utility::ConfigurationValue<bool>::fromString(
+                          toString(), {});
+}
+template <>
+inline int ConfigValue::get<int>() const {
+  return isNumber() ? number<int>()
+                    : Corrade::Utility::ConfigurationValue<int>::fromString(
+                          toString(), {});
+}
+template <>
+inline float ConfigValue::get<float>() const {
+  return isNumber() ? number<float>()
+                    : Corrade::Utility::ConfigurationValue<float>::fromString(
+                          toString(), {});
+}
+template <>
+inline double ConfigValue::get<double>() const {
+  return isNumber() ? number<double>()
+                    : Corrade::Utility::ConfigurationValue<double>::fromString(
+                          toString(), {});
+}
+template <>
+inline std::string ConfigValue::get<std::string>() const {
+  return type == ConfigValueType::String ? string : toString();
+}
+template <>
+inline Magnum::Vector3 ConfigValue::get<Magnum::Vector3>() const {
+  return type == ConfigValueType::Vec3
+             ? Magnum::Vector3{vec3[0], vec3[1], vec3[2]}
+             : Corrade::Utility::ConfigurationValue<
+                   Magnum::Vector3>::fromString(toString(), {});
+}
+
+/**
+ * @brief Typed key-value configuration
+ *
+ * The values are kept in a flat array indexed by the @ref ConfigKey ID of
+ * their key. Access by name hashes it once to find the ID; access through a
+ * @ref ConfigKey is a direct offset load. Reading a missing value returns a
+ * default-constructed one.
+ */
 class Configuration {
  public:
   // virtual destructor set to that pybind11 recognizes attributes inheritance
@@ -23,7 +205,8 @@ class Configuration {
 
   template <typename T>
   bool set(const std::string& key, const T& value) {
-    return cfg.setValue(key, value);
+    valueAt(ConfigKey::intern(key)).set(value);
+    return true;
   }
   bool setBool(const std::string& key, bool value) { return set(key, value); }
   bool setFloat(const std::string& key, float value) { return set(key, value); }
@@ -40,75 +223,77 @@ class Configuration {
 
   template <typename T>
   T get(const std::string& key) const {
-    return cfg.value<T>(key);
+    const ConfigValue* value = find(ConfigKey::find(key));
+    return value ? value->get<T>() : T{};
+  }
+  template <typename T>
+  T get(const ConfigKey& key) const {
+    const ConfigValue* value = find(key.id());
+    return value ? value->get<T>() : T{};
   }
   bool getBool(const std::string& key) const { return get<bool>(key); }
+  bool getBool(const ConfigKey& key) const { return get<bool>(key); }
   float getFloat(const std::string& key) const { return get<float>(key); }
+  float getFloat(const ConfigKey& key) const { return get<float>(key); }
   double getDouble(const std::string& key) const { return get<double>(key); }
+  double getDouble(const ConfigKey& key) const { return get<double>(key); }
   int getInt(const std::string& key) const { return get<int>(key); }
+  int getInt(const ConfigKey& key) const { return get<int>(key); }
   std::string getString(const std::string& key) const {
     return get<std::string>(key);
   }
+  std::string getString(const ConfigKey& key) const {
+    return get<std::string>(key);
+  }
   Magnum::Vector3 getVec3(const std::string& key) const {
     return get<Magnum::Vector3>(key);
   }
+  Magnum::Vector3 getVec3(const ConfigKey& key) const {
+    return get<Magnum::Vector3>(key);
+  }
 
   /**@brief Add a string to a group and return the resulting group size. */
-  int addStringToGroup(const std::string& key, const std::string& value) {
-    cfg.addValue(key, value);
-    return cfg.valueCount(key);
-  }
+  int addStringToGroup(const std::string& key, const std::string& value);
 
   /**@brief Collect and return strings in a key group. */
-  std::vector<std::string> getStringGroup(const std::string& key) const {
-    std::vector<std::string> strings;
-    for (size_t v = 0; v < cfg.valueCount(key); ++v) {
-      strings.push_back(cfg.value<std::string>(key, v));
-    }
-    return strings;
+  std::vector<std::string> getStringGroup(const std::string& key) const;
+
+  bool hasValue(const std::string& key) const {
+    return find(ConfigKey::find(key)) != nullptr;
   }
 
-  bool hasValue(const std::string& key) const { return cfg.hasValue(key); }
+  /**
+   * @brief Remove the value of @p key, the first string of a string group
+   * @return false if there was none
+   */
+  bool removeValue(const std::string& key);
 
-  bool removeValue(const std::string& key) { return cfg.removeValue(key); }
+  /**
+   * @brief The values as a @ref Corrade::Utility::ConfigurationGroup, e.g. for
+   * plugin configurations
+   */
+  Corrade::Utility::ConfigurationGroup getConfigurationGroup() const;
 
  protected:
-  Corrade::Utility::ConfigurationGroup cfg;
-
-  ESP_SMART_POINTERS(Configuration)
-};
-
-// Below uses std::variant; not yet available in clang c++17
-/*
-#include <std/variant>
-
-class Configuration {
- public:
-  Configuration() : values_() {}
-
-  template <typename T>
-  bool set(const std::string& key, const T& value) {
-    bool didOverride = hasValue(key);
-    values_[key] = value;
-    return didOverride;
+  //! the value of a key ID, nullptr if it is unset
+  const ConfigValue* find(int id) const {
+    return id >= 0 && id < values_.size() &&
+                   values_[id].type != ConfigValueType::Unset
+               ? &values_[id]
+               : nullptr;
   }
-
-  template <typename T>
-  T get(const std::string& key) const {
-    return boost::get<T>(values_.at(key));
-  }
-
-  bool hasValue(const std::string& key) {
-    return values_.count(key) > 0;
+  ConfigValue& valueAt(int id) {
+    if (id >= values_.size()) {
+      values_.resize(id + 1);
+    }
+    return values_[id];
   }
 
- protected:
-  typedef boost::variant<bool, int, float, double, std::string> ConfigValue;
-  std::map<std::string, ConfigValue> values_;
+  //! values indexed by the ConfigKey ID of their key
+  std::vector<ConfigValue> values_;
 
   ESP_SMART_POINTERS(Configuration)
 };
-*/
 
 }  // namespace core
 }  // namespace esp
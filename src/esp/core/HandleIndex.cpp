@@ -0,0 +1,157 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "HandleIndex.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/String.h>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace core {
+
+bool HandleIndex::emplace(int id, const std::string& handle) {
+  if (!slotById_.emplace(id, ids_.size()).second) {
+    return false;
+  }
+  ids_.push_back(id);
+  handles_.push_back(handle);
+  lowercaseHandles_.push_back(Cr::Utility::String::lowercase(handle));
+  trigramsDirty_ = true;
+  return true;
+}
+
+size_t HandleIndex::erase(int id) {
+  auto it = slotById_.find(id);
+  if (it == slotById_.end()) {
+    return 0;
+  }
+  // move the last handle into the freed slot
+  const uint32_t slot = it->second;
+  slotById_.erase(it);
+  const uint32_t last = ids_.size() - 1;
+  if (slot != last) {
+    ids_[slot] = ids_[last];
+    handles_[slot] = std::move(handles_[last]);
+    lowercaseHandles_[slot] = std::move(lowercaseHandles_[last]);
+    slotById_[ids_[slot]] = slot;
+  }
+  ids_.pop_back();
+  handles_.pop_back();
+  lowercaseHandles_.pop_back();
+  trigramsDirty_ = true;
+  return 1;
+}
+
+void HandleIndex::clear() {
+  ids_.clear();
+  handles_.clear();
+  lowercaseHandles_.clear();
+  slotById_.clear();
+  trigramSlots_.clear();
+  trigramsDirty_ = true;
+}
+
+const std::string& HandleIndex::randomHandle(Random& random) const {
+  CORRADE_INTERNAL_ASSERT(!handles_.empty());
+  return handles_[random.uniform_uint() % handles_.size()];
+}
+
+void HandleIndex::buildTrigrams() const {
+  trigramSlots_.clear();
+  for (uint32_t slot = 0; slot != lowercaseHandles_.size(); ++slot) {
+    const std::string& handle = lowercaseHandles_[slot];
+    for (size_t i = 0; i + 3 <= handle.size(); ++i) {
+      std::vector<uint32_t>& slots = trigramSlots_[trigram(&handle[i])];
+      // a trigram repeating within a handle is recorded once
+      if (slots.empty() || slots.back() != slot) {
+        slots.push_back(slot);
+      }
+    }
+  }
+  trigramsDirty_ = false;
+}
+
+std::vector<std::string> HandleIndex::handlesOfSlots(
+    std::vector<uint32_t>& slots) const {
+  std::sort(slots.begin(), slots.end(),
+            [&](uint32_t a, uint32_t b) { return ids_[a] < ids_[b]; });
+  std::vector<std::string> res;
+  res.reserve(slots.size());
+  for (uint32_t slot : slots) {
+    res.push_back(handles_[slot]);
+  }
+  return res;
+}
+
+std::vector<std::string> HandleIndex::handlesBySubstring(
+    const std::string& subStr,
+    bool contains) const {
+  std::vector<uint32_t> slots;
+  // if search string is empty, return all values
+  if (subStr.empty()) {
+    slots.resize(handles_.size());
+    std::iota(slots.begin(), slots.end(), 0);
+    return handlesOfSlots(slots);
+  }
+
+  const std::string strToLookFor = Cr::Utility::String::lowercase(subStr);
+  if (strToLookFor.size() < 3) {
+    // too short for the trigram index, test all handles
+    for (uint32_t slot = 0; slot != lowercaseHandles_.size(); ++slot) {
+      const bool found =
+          lowercaseHandles_[slot].find(strToLookFor) != std::string::npos;
+      if (found == contains) {
+        slots.push_back(slot);
+      }
+    }
+    return handlesOfSlots(slots);
+  }
+
+  if (trigramsDirty_) {
+    buildTrigrams();
+  }
+  // only the handles with the rarest trigram of the query can contain it
+  const std::vector<uint32_t>* candidates = nullptr;
+  for (size_t i = 0; i + 3 <= strToLookFor.size(); ++i) {
+    auto it = trigramSlots_.find(trigram(&strToLookFor[i]));
+    if (it == trigramSlots_.end()) {
+      candidates = nullptr;
+      break;
+    }
+    if (!candidates || it->second.size() < candidates->size()) {
+      candidates = &it->second;
+    }
+  }
+
+  std::vector<uint32_t> found;
+  if (candidates) {
+    for (uint32_t slot : *candidates) {
+      if (lowercaseHandles_[slot].find(strToLookFor) != std::string::npos) {
+        found.push_back(slot);
+      }
+    }
+  }
+  if (contains) {
+    return handlesOfSlots(found);
+  }
+  // the complement of the matches
+  std::vector<bool> isFound(handles_.size(), false);
+  for (uint32_t slot : found) {
+    isFound[slot] = true;
+  }
+  for (uint32_t slot = 0; slot != handles_.size(); ++slot) {
+    if (!isFound[slot]) {
+      slots.push_back(slot);
+    }
+  }
+  return handlesOfSlots(slots);
+}
+
+}  // namespace core
+}  // namespace esp
@@ -0,0 +1,103 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_HANDLEINDEX_H_
+#define ESP_CORE_HANDLEINDEX_H_
+
+/** @file
+ * @brief Class @ref esp::core::HandleIndex
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/core/random.h"
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Handles of managed objects keyed by their IDs, indexed for random
+ * sampling and case-insensitive substring queries
+ *
+ * The handles are kept in contiguous arrays, so that sampling one at random
+ * is constant time, with a hash map from each ID to its slot. Substring
+ * queries of three or more characters only test the handles sharing the
+ * rarest trigram of the query, taken from a trigram index which is built on
+ * the first query after handles were added or removed.
+ */
+class HandleIndex {
+ public:
+  /**
+   * @brief Add a handle under @p id
+   * @return false, leaving the index unchanged, if @p id is already present
+   */
+  bool emplace(int id, const std::string& handle);
+
+  /**
+   * @brief Remove the handle of @p id
+   * @return The number of removed handles, 0 or 1
+   */
+  size_t erase(int id);
+
+  /** @brief Remove all handles */
+  void clear();
+
+  /** @brief The number of handles */
+  size_t size() const { return ids_.size(); }
+
+  /** @brief Whether there is a handle with @p id, as 0 or 1 */
+  size_t count(int id) const { return slotById_.count(id); }
+
+  /**
+   * @brief The handle of @p id
+   *
+   * Throws std::out_of_range if there is none, like std::map::at().
+   */
+  const std::string& at(int id) const { return handles_[slotById_.at(id)]; }
+
+  /**
+   * @brief A handle sampled uniformly with @p random, which must not be empty
+   */
+  const std::string& randomHandle(Random& random) const;
+
+  /**
+   * @brief The handles whose lower case contains, or does not contain, the
+   * lower case of @p subStr, ordered by ID. All handles if @p subStr is empty.
+   */
+  std::vector<std::string> handlesBySubstring(const std::string& subStr,
+                                              bool contains) const;
+
+ protected:
+  //! the trigram starting at @p s
+  static uint32_t trigram(const char* s) {
+    return uint32_t(uint8_t(s[0])) << 16 | uint32_t(uint8_t(s[1])) << 8 |
+           uint32_t(uint8_t(s[2]));
+  }
+
+  //! the trigrams of the lower case handles, and the slots they occur in
+  void buildTrigrams() const;
+
+  //! the handles of the slots, their matches, ordered by ID
+  std::vector<std::string> handlesOfSlots(std::vector<uint32_t>& slots) const;
+
+  std::vector<int> ids_;
+  std::vector<std::string> handles_;
+  std::vector<std::string> lowercaseHandles_;
+  std::unordered_map<int, uint32_t> slotById_;
+
+  //! slots of the handles containing each trigram, each slot at most once
+  mutable std::unordered_map<uint32_t, std::vector<uint32_t>> trigramSlots_;
+  mutable bool trigramsDirty_ = true;
+
+  ESP_SMART_POINTERS(HandleIndex)
+};
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_HANDLEINDEX_H_
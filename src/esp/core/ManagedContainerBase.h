@@ -10,6 +10,7 @@
  * functionality to manage @ref esp::core::AbstractManagedObject objects
  */
 
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <map>
@@ -19,6 +20,9 @@
 #include <Corrade/Utility/String.h>
 
 #include "esp/core/AbstractManagedObject.h"
+#include "esp/core/HandleIndex.h"
+#include "esp/core/TaskScheduler.h"
+#include "esp/core/random.h"
 
 #include "esp/io/json.h"
 
@@ -46,6 +50,7 @@ class ManagedContainer {
                 "AbstractManagedObject");
 
   typedef std::shared_ptr<T> ManagedPtr;
+  typedef std::shared_ptr<const T> ManagedCPtr;
 
   ManagedContainer(esp::assets::ResourceManager& resourceManager,
                    const std::string& metadataType)
@@ -128,6 +133,50 @@ class ManagedContainer {
     return this->postCreateRegister(attr, registerObject);
   }  // ManagedContainer::createObjectFromFile
 
+  /**
+   * @brief Creates instances of managed objects from a batch of JSON files, as
+   * @ref createObjectFromFile() does for each of them.
+   *
+   * The files are read and parsed on several threads, and the managed objects
+   * are then created and registered one after another in the order of @p
+   * filenames, so that the result is the same as loading the files one by
+   * one.
+   * @param filenames the names of the files describing the managed objects
+   * @param registerObject whether to add the managed objects to the library
+   * @param numThreads the number of threads to parse on, 0 for all threads of
+   * @ref TaskScheduler::global()
+   * @return the managed object of each file, nullptr where it failed
+   */
+  std::vector<ManagedPtr> createObjectsFromFiles(
+      const std::vector<std::string>& filenames,
+      bool registerObject = true,
+      int numThreads = 0) {
+    std::vector<io::JsonDocument> jsonConfigs(filenames.size());
+    // not a std::vector<bool>, its elements can't be written concurrently
+    std::vector<char> success(filenames.size(), false);
+    auto parseRange = [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        success[i] = this->verifyLoadJson(filenames[i], jsonConfigs[i]);
+      }
+    };
+    TaskScheduler::global().parallelForRanges(filenames.size(), numThreads,
+                                              parseRange);
+
+    std::vector<ManagedPtr> res(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i) {
+      if (!success[i]) {
+        LOG(ERROR) << objectType_
+                   << "ManagedContainer::createObjectsFromFiles : "
+                      "Failure reading json : "
+                   << filenames[i] << ". Skipping.";
+        continue;
+      }
+      ManagedPtr attr = this->loadFromJSONDoc(filenames[i], jsonConfigs[i]);
+      res[i] = this->postCreateRegister(attr, registerObject);
+    }
+    return res;
+  }  // ManagedContainer::createObjectsFromFiles
+
   /**
    * @brief Parse passed JSON Document specifically for @ref ManagedPtr object.
    * It always returns a @ref ManagedPtr object.
@@ -436,6 +485,13 @@ class ManagedContainer {
     return getRandomObjectHandlePerType(objectLibKeyByID_, "");
   }  // ManagedContainer::getRandomObjectHandle
 
+  /**
+   * @brief Seed the random generator of @ref getRandomObjectHandle() and the
+   * other random handle queries of this manager.
+   * @param newSeed The seed
+   */
+  void seed(uint32_t newSeed) { random_.seed(newSeed); }
+
   /**
    * @brief Get a copy of the managed object identified by the
    * managedObjectID.
@@ -474,6 +530,31 @@ class ManagedContainer {
     return this->copyObject(orig);
   }  // ManagedContainer::getObjectCopyByHandle
 
+  /**
+   * @brief Get the managed object identified by the managedObjectID as it is
+   * stored in the library, without copying it.
+   *
+   * The library keeps its own copy of each registered managed object and
+   * replaces that copy when the object is registered again, instead of
+   * modifying it, so the returned object never changes. Use @ref
+   * getObjectCopyByID() to get an object to modify.
+   * @param managedObjectID The ID of the managed object.
+   * @return The shared immutable managed object, or nullptr if does not exist
+   */
+  ManagedCPtr getObjectSharedByID(int managedObjectID) const {
+    return getObjectByID(managedObjectID);
+  }  // ManagedContainer::getObjectSharedByID
+
+  /**
+   * @brief Get the managed object specified by passed handle as it is stored
+   * in the library, without copying it. See @ref getObjectSharedByID().
+   * @param objectHandle the string key of the managed object desired.
+   * @return The shared immutable managed object, or nullptr if does not exist
+   */
+  ManagedCPtr getObjectSharedByHandle(const std::string& objectHandle) const {
+    return getObjectByHandle(objectHandle);
+  }  // ManagedContainer::getObjectSharedByHandle
+
   /**
    * @brief Get a copy of the managed object identified by the
    * managedObjectID, casted to the appropriate derived managed object class.
@@ -761,9 +842,8 @@ class ManagedContainer {
    * @return a random managed object handle of the chosen type, or the empty
    * string if none loaded
    */
-  std::string getRandomObjectHandlePerType(
-      const std::map<int, std::string>& mapOfHandles,
-      const std::string& type) const;
+  std::string getRandomObjectHandlePerType(const HandleIndex& mapOfHandles,
+                                           const std::string& type) const;
 
   /**
    * @brief Get a list of all managed objects of passed type whose origin
@@ -778,9 +858,11 @@ class ManagedContainer {
    * containing the passed substring
    */
   std::vector<std::string> getObjectHandlesBySubStringPerType(
-      const std::map<int, std::string>& mapOfHandles,
+      const HandleIndex& mapOfHandles,
       const std::string& subStr,
-      bool contains) const;
+      bool contains) const {
+    return mapOfHandles.handlesBySubstring(subStr, contains);
+  }
 
   // ======== Typedefs and Instance Variables ========
 
@@ -817,7 +899,12 @@ class ManagedContainer {
    * @brief Maps all object attribute IDs to the appropriate handles used
    * by lib
    */
-  std::map<int, std::string> objectLibKeyByID_;
+  HandleIndex objectLibKeyByID_;
+
+  /**
+   * @brief Random generator of the random handle queries, see @ref seed()
+   */
+  mutable Random random_;
 
   /**
    * @brief Deque holding all IDs of deleted objects. These ID's should be
@@ -916,67 +1003,16 @@ auto ManagedContainer<T>::removeObjectInternal(const std::string& objectHandle,
 
 template <class T>
 std::string ManagedContainer<T>::getRandomObjectHandlePerType(
-    const std::map<int, std::string>& mapOfHandles,
+    const HandleIndex& mapOfHandles,
     const std::string& type) const {
-  std::size_t numVals = mapOfHandles.size();
-  if (numVals == 0) {
+  if (mapOfHandles.size() == 0) {
     LOG(ERROR) << "Attempting to get a random " << type << objectType_
                << " managed object handle but none are loaded; Aboring";
     return "";
   }
-  int randIDX = rand() % numVals;
-
-  std::string res;
-  for (std::pair<std::map<int, std::string>::const_iterator, int> iter(
-           mapOfHandles.begin(), 0);
-       (iter.first != mapOfHandles.end() && iter.second <= randIDX);
-       ++iter.first, ++iter.second) {
-    res = iter.first->second;
-  }
-  return res;
+  return mapOfHandles.randomHandle(random_);
 }  // ManagedContainer::getRandomObjectHandlePerType
 
-template <class T>
-std::vector<std::string>
-ManagedContainer<T>::getObjectHandlesBySubStringPerType(
-    const std::map<int, std::string>& mapOfHandles,
-    const std::string& subStr,
-    bool contains) const {
-  std::vector<std::string> res;
-  // if empty return empty vector
-  if (mapOfHandles.size() == 0) {
-    return res;
-  }
-  // if search string is empty, return all values
-  if (subStr.length() == 0) {
-    for (auto elem : mapOfHandles) {
-      res.push_back(elem.second);
-    }
-    return res;
-  }
-  // build search criteria
-  std::string strToLookFor = Cr::Utility::String::lowercase(subStr);
-
-  std::size_t strSize = strToLookFor.length();
-
-  for (std::map<int, std::string>::const_iterator iter = mapOfHandles.begin();
-       iter != mapOfHandles.end(); ++iter) {
-    std::string key = Cr::Utility::String::lowercase(iter->second);
-    // be sure that key is big enough to search in (otherwise find has undefined
-    // behavior)
-    if (key.length() < strSize) {
-      continue;
-    }
-    bool found = (std::string::npos != key.find(strToLookFor));
-    if (found == contains) {
-      // if found and searching for contains, or not found and searching for not
-      // contains
-      res.push_back(iter->second);
-    }
-  }
-  return res;
-}  // ManagedContainer::getObjectHandlesBySubStringPerType
-
 }  // namespace core
 }  // namespace esp
 #endif  // ESP_CORE_MANAGEDCONTAINERBASE_H_
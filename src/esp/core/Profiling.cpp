@@ -0,0 +1,359 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "Profiling.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <Corrade/Utility/Assert.h>
+
+#include "esp/core/logging.h"
+
+namespace esp {
+namespace core {
+
+std::atomic<bool> Profiler::enabled_{false};
+
+namespace {
+//! the stats of a thread, locked by the thread only against stats() and
+//! reset(), so uncontended while profiling
+struct ThreadProfilingStats {
+  ThreadProfilingStats();
+  ~ThreadProfilingStats();
+
+  std::mutex mutex;
+  ProfilingStats stats;
+};
+
+//! the stats of the running threads, and those of the ended ones
+struct ProfilingRegistry {
+  std::mutex mutex;
+  std::vector<ThreadProfilingStats*> threads;
+  ProfilingStats ended;
+};
+
+ProfilingRegistry& profilingRegistry() {
+  // constructed before and so destroyed after any thread_local stats
+  static ProfilingRegistry registry;
+  return registry;
+}
+
+ThreadProfilingStats::ThreadProfilingStats() {
+  ProfilingRegistry& registry = profilingRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  registry.threads.push_back(this);
+}
+
+ThreadProfilingStats::~ThreadProfilingStats() {
+  ProfilingRegistry& registry = profilingRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  registry.ended += stats;
+  registry.threads.erase(
+      std::find(registry.threads.begin(), registry.threads.end(), this));
+}
+
+ThreadProfilingStats& threadProfilingStats() {
+  thread_local ThreadProfilingStats stats;
+  return stats;
+}
+
+//! the last enumerators
+constexpr int NumProfilingStages =
+    int(ProfilingStage::SemanticSceneLoading) + 1;
+constexpr int NumProfilingCounters = int(ProfilingCounter::ViewCacheMisses) + 1;
+}  // namespace
+
+ProfilingStats Profiler::stats() {
+  ProfilingRegistry& registry = profilingRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  ProfilingStats stats = registry.ended;
+  for (ThreadProfilingStats* thread : registry.threads) {
+    std::lock_guard<std::mutex> threadLock{thread->mutex};
+    stats += thread->stats;
+  }
+  return stats;
+}
+
+void Profiler::reset() {
+  ProfilingRegistry& registry = profilingRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  registry.ended = ProfilingStats{};
+  for (ThreadProfilingStats* thread : registry.threads) {
+    std::lock_guard<std::mutex> threadLock{thread->mutex};
+    thread->stats = ProfilingStats{};
+  }
+}
+
+void Profiler::addCpuTime(ProfilingStage stage, double milliseconds) {
+  ThreadProfilingStats& thread = threadProfilingStats();
+  std::lock_guard<std::mutex> lock{thread.mutex};
+  ProfilingStats::Timing& timing = thread.stats.timing(stage);
+  ++timing.calls;
+  timing.cpuTimeMs += milliseconds;
+}
+
+void Profiler::addGpuTime(ProfilingStage stage, double milliseconds) {
+  ThreadProfilingStats& thread = threadProfilingStats();
+  std::lock_guard<std::mutex> lock{thread.mutex};
+  thread.stats.timing(stage).gpuTimeMs += milliseconds;
+}
+
+void Profiler::addCount(ProfilingCounter counter, uint64_t amount) {
+  ThreadProfilingStats& thread = threadProfilingStats();
+  std::lock_guard<std::mutex> lock{thread.mutex};
+  thread.stats.counter(counter) += amount;
+}
+
+const char* profilingStageName(ProfilingStage stage) {
+  switch (stage) {
+    case ProfilingStage::AgentObservations:
+      return "AgentObservations";
+    case ProfilingStage::Physics:
+      return "Physics";
+    case ProfilingStage::Culling:
+      return "Culling";
+    case ProfilingStage::Drawing:
+      return "Drawing";
+    case ProfilingStage::Readback:
+      return "Readback";
+    case ProfilingStage::Noise:
+      return "Noise";
+    case ProfilingStage::ContextCreation:
+      return "ContextCreation";
+    case ProfilingStage::ImporterSetup:
+      return "ImporterSetup";
+    case ProfilingStage::PrimitiveAttributes:
+      return "PrimitiveAttributes";
+    case ProfilingStage::StageLoading:
+      return "StageLoading";
+    case ProfilingStage::NavmeshLoading:
+      return "NavmeshLoading";
+    case ProfilingStage::ShaderCompilation:
+      return "ShaderCompilation";
+    case ProfilingStage::AssetImport:
+      return "AssetImport";
+    case ProfilingStage::HierarchyJoin:
+      return "HierarchyJoin";
+    case ProfilingStage::BoundsComputation:
+      return "BoundsComputation";
+    case ProfilingStage::GpuUpload:
+      return "GpuUpload";
+    case ProfilingStage::CollisionMeshBuild:
+      return "CollisionMeshBuild";
+    case ProfilingStage::SemanticSceneLoading:
+      return "SemanticSceneLoading";
+  }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+ProfilingStats::Timing& ProfilingStats::timing(ProfilingStage stage) {
+  switch (stage) {
+    case ProfilingStage::AgentObservations:
+      return agentObservations;
+    case ProfilingStage::Physics:
+      return physics;
+    case ProfilingStage::Culling:
+      return culling;
+    case ProfilingStage::Drawing:
+      return drawing;
+    case ProfilingStage::Readback:
+      return readback;
+    case ProfilingStage::Noise:
+      return noise;
+    case ProfilingStage::ContextCreation:
+      return contextCreation;
+    case ProfilingStage::ImporterSetup:
+      return importerSetup;
+    case ProfilingStage::PrimitiveAttributes:
+      return primitiveAttributes;
+    case ProfilingStage::StageLoading:
+      return stageLoading;
+    case ProfilingStage::NavmeshLoading:
+      return navmeshLoading;
+    case ProfilingStage::ShaderCompilation:
+      return shaderCompilation;
+    case ProfilingStage::AssetImport:
+      return assetImport;
+    case ProfilingStage::HierarchyJoin:
+      return hierarchyJoin;
+    case ProfilingStage::BoundsComputation:
+      return boundsComputation;
+    case ProfilingStage::GpuUpload:
+      return gpuUpload;
+    case ProfilingStage::CollisionMeshBuild:
+      return collisionMeshBuild;
+    case ProfilingStage::SemanticSceneLoading:
+      return semanticSceneLoading;
+  }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+const ProfilingStats::Timing& ProfilingStats::timing(
+    ProfilingStage stage) const {
+  return const_cast<ProfilingStats&>(*this).timing(stage);
+}
+
+uint64_t& ProfilingStats::counter(ProfilingCounter which) {
+  switch (which) {
+    case ProfilingCounter::DrawablesCulled:
+      return drawablesCulled;
+    case ProfilingCounter::DrawCalls:
+      return drawCalls;
+    case ProfilingCounter::DrawablesOccluded:
+      return drawablesOccluded;
+    case ProfilingCounter::ViewCacheHits:
+      return viewCacheHits;
+    case ProfilingCounter::ViewCacheMisses:
+      return viewCacheMisses;
+  }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+uint64_t ProfilingStats::counter(ProfilingCounter which) const {
+  return const_cast<ProfilingStats&>(*this).counter(which);
+}
+
+ProfilingStats& ProfilingStats::operator+=(const ProfilingStats& other) {
+  for (int i = 0; i < NumProfilingStages; ++i) {
+    const Timing& from = other.timing(ProfilingStage(i));
+    Timing& to = timing(ProfilingStage(i));
+    to.calls += from.calls;
+    to.cpuTimeMs += from.cpuTimeMs;
+    to.gpuTimeMs += from.gpuTimeMs;
+  }
+  for (int i = 0; i < NumProfilingCounters; ++i) {
+    counter(ProfilingCounter(i)) += other.counter(ProfilingCounter(i));
+  }
+  return *this;
+}
+
+namespace {
+struct TraceEvent {
+  const char* name;
+  const char* category;
+  Tracer::Clock::time_point begin;
+  Tracer::Clock::time_point end;
+  int track;
+};
+
+struct TraceLog {
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+  //! the time of the trace start, the origin of the event timestamps
+  Tracer::Clock::time_point origin;
+};
+
+TraceLog& traceLog() {
+  // never destroyed, threads may still record events during exit
+  static auto* log = new TraceLog;
+  return *log;
+}
+}  // namespace
+
+constexpr int Tracer::GpuTrack;
+std::atomic<bool> Tracer::tracing_{false};
+
+void Tracer::start() {
+  TraceLog& log = traceLog();
+  std::lock_guard<std::mutex> lock{log.mutex};
+  log.events.clear();
+  log.origin = Clock::now();
+  tracing_ = true;
+}
+
+bool Tracer::stop(const std::string& filename) {
+  tracing_ = false;
+  TraceLog& log = traceLog();
+  std::lock_guard<std::mutex> lock{log.mutex};
+  std::ofstream file{filename};
+  if (!file) {
+    LOG(ERROR) << "Tracer::stop : cannot open " << filename;
+    return false;
+  }
+  const auto microseconds = [&](Clock::time_point time) {
+    return std::chrono::duration<double, std::micro>(time - log.origin)
+        .count();
+  };
+  // microseconds with nanosecond digits, whatever the length of the trace
+  file << std::fixed << std::setprecision(3);
+  file << "{\"traceEvents\":[\n";
+  file << R"({"name":"thread_name","ph":"M","pid":0,"tid":)" << GpuTrack
+       << R"(,"args":{"name":"GPU"}})";
+  for (const TraceEvent& event : log.events) {
+    file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\""
+         << event.category << "\",\"ph\":\"X\",\"ts\":"
+         << microseconds(event.begin)
+         << ",\"dur\":" << microseconds(event.end) - microseconds(event.begin)
+         << ",\"pid\":0,\"tid\":" << event.track << "}";
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  log.events.clear();
+  return bool(file);
+}
+
+size_t Tracer::numEvents() {
+  TraceLog& log = traceLog();
+  std::lock_guard<std::mutex> lock{log.mutex};
+  return log.events.size();
+}
+
+void Tracer::addEvent(const char* name,
+                      const char* category,
+                      Clock::time_point begin,
+                      Clock::time_point end,
+                      int track) {
+  if (!isTracing()) {
+    return;
+  }
+  if (track < 0) {
+    track = currentThreadTrack();
+  }
+  TraceLog& log = traceLog();
+  std::lock_guard<std::mutex> lock{log.mutex};
+  log.events.push_back({name, category, begin, end, track});
+}
+
+int Tracer::currentThreadTrack() {
+  static std::atomic<int> numThreadTracks{0};
+  thread_local const int track = GpuTrack + 1 + numThreadTracks++;
+  return track;
+}
+
+uint64_t residentMemory() {
+#ifdef __linux__
+  std::FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (!statm)
+    return 0;
+  unsigned long long size = 0, resident = 0;
+  const int read = std::fscanf(statm, "%llu %llu", &size, &resident);
+  std::fclose(statm);
+  return read == 2 ? resident * sysconf(_SC_PAGESIZE) : 0;
+#else
+  return 0;
+#endif
+}
+
+uint64_t peakResidentMemory() {
+#ifdef __linux__
+  rusage usage{};
+  return getrusage(RUSAGE_SELF, &usage) == 0
+             ? uint64_t(usage.ru_maxrss) * 1024
+             : 0;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace core
+}  // namespace esp
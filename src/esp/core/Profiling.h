@@ -0,0 +1,328 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_PROFILING_H_
+#define ESP_CORE_PROFILING_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Stages of a simulation step timed by the @ref Profiler
+ */
+enum class ProfilingStage : uint8_t {
+  //! sim::Simulator::getAgentObservations()
+  AgentObservations,
+  //! physics::PhysicsManager::stepPhysics()
+  Physics,
+  //! gfx::RenderCamera::cull() and the hierarchical culling of a draw
+  Culling,
+  //! gfx::Renderer::draw()
+  Drawing,
+  //! gfx::RenderTarget::read*()
+  Readback,
+  //! sensor noise models
+  Noise,
+  //! gfx::WindowlessContext creation by sim::Simulator::reconfigure()
+  ContextCreation,
+  //! the importer plugins and attributes managers of assets::ResourceManager
+  ImporterSetup,
+  //! assets::ResourceManager::initDefaultPrimAttributes()
+  PrimitiveAttributes,
+  //! assets::ResourceManager::loadStage(), including the shaders compiled
+  //! for its drawables
+  StageLoading,
+  //! nav::PathFinder::loadNavMesh() by sim::Simulator::reconfigure()
+  NavmeshLoading,
+  //! compilation, or load from the program binary cache, of the shaders
+  ShaderCompilation,
+  //! import or scene cache load of the mesh data of an asset, part of
+  //! StageLoading for the stage assets
+  AssetImport,
+  //! assets::ResourceManager::joinHeirarchy() flattening a mesh hierarchy
+  HierarchyJoin,
+  //! the absolute bounds of the static drawables of a stage
+  BoundsComputation,
+  //! upload of the mesh buffers and textures to the GPU
+  GpuUpload,
+  //! assets::ResourceManager::buildMeshGroups() for the collision meshes
+  CollisionMeshBuild,
+  //! scene::SemanticScene parse by sim::Simulator::reconfigure()
+  SemanticSceneLoading,
+};
+
+/** @brief The name of a stage, e.g. "Physics" */
+const char* profilingStageName(ProfilingStage stage);
+
+/**
+ * @brief Counters accumulated by the @ref Profiler
+ */
+enum class ProfilingCounter : uint8_t {
+  //! drawables removed by frustum culling
+  DrawablesCulled,
+  //! GL draw calls of the drawables, batches and occlusion queries drawn by
+  //! gfx::RenderCamera::draw(), counted where they are issued. An instanced
+  //! or multi-draw batch is one.
+  DrawCalls,
+  //! drawables skipped by occlusion culling, counted once the result of
+  //! their query is collected in a later frame
+  DrawablesOccluded,
+  //! observations served by sim::ViewCache::read()
+  ViewCacheHits,
+  //! observations sim::ViewCache::read() didn't find
+  ViewCacheMisses,
+};
+
+/**
+ * @brief Accumulated timings and counters since the last @ref
+ * Profiler::reset()
+ */
+struct ProfilingStats {
+  /** @brief Timing of one @ref ProfilingStage */
+  struct Timing {
+    //! number of times the stage ran
+    uint64_t calls = 0;
+    //! wall clock time spent on the CPU
+    double cpuTimeMs = 0.0;
+    //! time spent on the GPU, only measured for render stages
+    double gpuTimeMs = 0.0;
+  };
+
+  Timing agentObservations;
+  Timing physics;
+  Timing culling;
+  Timing drawing;
+  Timing readback;
+  Timing noise;
+  Timing contextCreation;
+  Timing importerSetup;
+  Timing primitiveAttributes;
+  Timing stageLoading;
+  Timing navmeshLoading;
+  Timing shaderCompilation;
+  Timing assetImport;
+  Timing hierarchyJoin;
+  Timing boundsComputation;
+  Timing gpuUpload;
+  Timing collisionMeshBuild;
+  Timing semanticSceneLoading;
+
+  uint64_t drawablesCulled = 0;
+  uint64_t drawCalls = 0;
+  uint64_t drawablesOccluded = 0;
+  uint64_t viewCacheHits = 0;
+  uint64_t viewCacheMisses = 0;
+
+  /** @brief The timing of a stage */
+  Timing& timing(ProfilingStage stage);
+  /** @overload */
+  const Timing& timing(ProfilingStage stage) const;
+
+  /** @brief The value of a counter */
+  uint64_t& counter(ProfilingCounter which);
+  /** @overload */
+  uint64_t counter(ProfilingCounter which) const;
+
+  /** @brief Add the timings and counters of @p other */
+  ProfilingStats& operator+=(const ProfilingStats& other);
+};
+
+/**
+ * @brief Process-wide collection of per-stage timings and counters.
+ *
+ * Disabled by default. While disabled, @ref ScopedTimer and @ref increment()
+ * only test @ref isEnabled() and do not read any clock. Thread-safe: each
+ * thread collects into its own stats, e.g. the physics thread of a
+ * pipelined step or the workers of a sim::VectorSimulator, which
+ * @ref stats() sums up.
+ */
+class Profiler {
+ public:
+  /** @brief Whether timings and counters are collected */
+  static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /** @brief Enable or disable the collection */
+  static void setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief The timings and counters collected by all threads since the last
+   * reset
+   */
+  static ProfilingStats stats();
+
+  /** @brief Zero all timings and counters */
+  static void reset();
+
+  /** @brief Add CPU time of one run of a stage */
+  static void addCpuTime(ProfilingStage stage, double milliseconds);
+
+  /** @brief Add GPU time of a stage, does not count as a run */
+  static void addGpuTime(ProfilingStage stage, double milliseconds);
+
+  /** @brief Increment a counter, if enabled */
+  static void increment(ProfilingCounter counter, uint64_t amount = 1) {
+    if (isEnabled()) {
+      addCount(counter, amount);
+    }
+  }
+
+ private:
+  static void addCount(ProfilingCounter counter, uint64_t amount);
+
+  static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief Process-wide recorder of timeline events, saved in the Chrome trace
+ * event format, which chrome://tracing and Perfetto open
+ *
+ * Disabled by default. While no trace is recorded, @ref ScopedTraceEvent and
+ * @ref ScopedTimer only test @ref isTracing(). Recording is thread-safe, the
+ * events of each thread are shown on their own track and GPU times of the
+ * render stages on a separate "GPU" track.
+ */
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /** @brief Track of the GPU events, threads get the ones from 1 */
+  static constexpr int GpuTrack = 0;
+
+  /** @brief Whether events are being recorded */
+  static bool isTracing() { return tracing_.load(std::memory_order_relaxed); }
+
+  /** @brief Drop the events recorded so far and start recording */
+  static void start();
+
+  /**
+   * @brief Stop recording and write the recorded events to @p filename
+   * @return false if the file couldn't be written
+   */
+  static bool stop(const std::string& filename);
+
+  /** @brief Number of events recorded since the last @ref start() */
+  static size_t numEvents();
+
+  /**
+   * @brief Record a complete event, if tracing
+   * @param name       Name of the event, must be a string literal, the
+   *                   pointer is kept until the trace is written
+   * @param category   Category of the event, also a string literal
+   * @param begin      When the event began
+   * @param end        When the event ended
+   * @param track      Track to show the event on, the calling thread's if
+   *                   negative
+   */
+  static void addEvent(const char* name,
+                       const char* category,
+                       Clock::time_point begin,
+                       Clock::time_point end,
+                       int track = -1);
+
+  /** @brief The track of the calling thread */
+  static int currentThreadTrack();
+
+ private:
+  static std::atomic<bool> tracing_;
+};
+
+/**
+ * @brief Records its scope as a @ref Tracer event
+ *
+ * For phases which are not a @ref ProfilingStage, e.g. scene loading. Whether
+ * it is recorded is decided at construction.
+ */
+class ScopedTraceEvent {
+ public:
+  /** @param name and @p category must be string literals */
+  explicit ScopedTraceEvent(const char* name, const char* category)
+      : name_{name}, category_{category}, active_{Tracer::isTracing()} {
+    if (active_) {
+      begin_ = Tracer::Clock::now();
+    }
+  }
+
+  ~ScopedTraceEvent() {
+    if (active_) {
+      Tracer::addEvent(name_, category_, begin_, Tracer::Clock::now());
+    }
+  }
+
+  ScopedTraceEvent(const ScopedTraceEvent&) = delete;
+  ScopedTraceEvent& operator=(const ScopedTraceEvent&) = delete;
+
+ private:
+  const char* const name_;
+  const char* const category_;
+  const bool active_;
+  Tracer::Clock::time_point begin_;
+};
+
+/**
+ * @brief Adds the wall clock time of its scope to a @ref ProfilingStage, and
+ * records it as a @ref Tracer event
+ *
+ * Whether the profiler is enabled and whether a trace is recorded are decided
+ * at construction.
+ */
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(ProfilingStage stage)
+      : stage_{stage},
+        active_{Profiler::isEnabled()},
+        traced_{Tracer::isTracing()} {
+    if (active_ || traced_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ScopedTimer() {
+    if (active_ || traced_) {
+      const std::chrono::steady_clock::time_point end =
+          std::chrono::steady_clock::now();
+      if (active_) {
+        const std::chrono::duration<double, std::milli> elapsed = end - start_;
+        Profiler::addCpuTime(stage_, elapsed.count());
+      }
+      if (traced_) {
+        Tracer::addEvent(profilingStageName(stage_), "stage", start_, end);
+      }
+    }
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  /** @brief When the scope began, if the profiler or the tracer is on */
+  std::chrono::steady_clock::time_point start() const { return start_; }
+
+ private:
+  const ProfilingStage stage_;
+  const bool active_;
+  const bool traced_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/** @brief The resident memory of the process, in bytes, 0 if unknown */
+uint64_t residentMemory();
+
+/**
+ * @brief The peak resident memory of the process so far, in bytes, 0 if
+ * unknown
+ */
+uint64_t peakResidentMemory();
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_PROFILING_H_
@@ -0,0 +1,244 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SharedMemoryRing.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <Corrade/Utility/Assert.h>
+
+namespace esp {
+namespace core {
+
+namespace {
+
+constexpr uint32_t RingMagic = 0x52505345;  // "ESPR"
+constexpr uint32_t RingVersion = 1;
+// keeps each field, and the sequence number of each slot, on its own cache
+// line
+constexpr size_t RingAlignment = 64;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "the sequence numbers must be lock-free to be shared between "
+              "processes");
+
+size_t alignUp(size_t size) {
+  return (size + RingAlignment - 1) / RingAlignment * RingAlignment;
+}
+
+struct alignas(RingAlignment) SlotSequence {
+  std::atomic<uint64_t> value;
+};
+
+std::string sharedMemoryName(const std::string& name) {
+  return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+std::runtime_error sharedMemoryError(const std::string& what,
+                                     const std::string& name) {
+  return std::runtime_error{"SharedMemoryRing: " + what + " " + name + ": " +
+                            std::strerror(errno)};
+}
+
+}  // namespace
+
+struct SharedMemoryRing::Header {
+  struct FieldHeader {
+    char name[MaxNameLength + 1];
+    uint32_t dataType;
+    uint32_t numDimensions;
+    uint64_t shape[MaxDimensions];
+    //! offset of the field in a slot
+    uint64_t offset;
+  };
+
+  //! written last by the creator
+  std::atomic<uint32_t> magic;
+  uint32_t version;
+  uint32_t numSlots;
+  uint32_t numFields;
+  uint64_t slotSize;
+  //! offset of the first slot in the shared memory
+  uint64_t dataOffset;
+  FieldHeader fields[MaxFields];
+
+  SlotSequence* sequences() {
+    return reinterpret_cast<SlotSequence*>(reinterpret_cast<uint8_t*>(this) +
+                                           alignUp(sizeof(Header)));
+  }
+};
+
+SharedMemoryRing::SharedMemoryRing(const std::string& name,
+                                   int numSlots,
+                                   const std::vector<Field>& fields)
+    : name_{sharedMemoryName(name)}, isCreator_{true}, fields_{fields} {
+  if (numSlots <= 0 || fields.size() > MaxFields) {
+    throw std::runtime_error{"SharedMemoryRing: a ring needs at least one "
+                             "slot and at most " +
+                             std::to_string(MaxFields) + " fields"};
+  }
+
+  // lay the fields out one after the other
+  std::vector<size_t> offsets;
+  size_t slotSize = 0;
+  for (const Field& field : fields) {
+    if (field.name.size() > MaxNameLength ||
+        field.shape.size() > MaxDimensions) {
+      throw std::runtime_error{"SharedMemoryRing: field " + field.name +
+                               " has too long a name or too many dimensions"};
+    }
+    size_t fieldSize = getDataTypeByteSize(field.dataType);
+    for (size_t dimension : field.shape) {
+      fieldSize *= dimension;
+    }
+    offsets.push_back(slotSize);
+    slotSize += alignUp(fieldSize);
+  }
+  const size_t dataOffset =
+      alignUp(sizeof(Header)) + numSlots * sizeof(SlotSequence);
+
+  // replace a ring left behind by a crashed process
+  shm_unlink(name_.c_str());
+  fd_ = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd_ == -1) {
+    throw sharedMemoryError("cannot create", name_);
+  }
+  const size_t size = dataOffset + numSlots * slotSize;
+  if (ftruncate(fd_, size) != 0) {
+    const std::runtime_error error = sharedMemoryError("cannot resize", name_);
+    close(fd_);
+    shm_unlink(name_.c_str());
+    throw error;
+  }
+  map(size);
+
+  header_->version = RingVersion;
+  header_->numSlots = numSlots;
+  header_->numFields = fields.size();
+  header_->slotSize = slotSize;
+  header_->dataOffset = dataOffset;
+  for (int i = 0; i < fields.size(); ++i) {
+    Header::FieldHeader& fieldHeader = header_->fields[i];
+    std::strncpy(fieldHeader.name, fields[i].name.c_str(), MaxNameLength + 1);
+    fieldHeader.dataType = static_cast<uint32_t>(fields[i].dataType);
+    fieldHeader.numDimensions = fields[i].shape.size();
+    std::copy(fields[i].shape.begin(), fields[i].shape.end(),
+              fieldHeader.shape);
+    fieldHeader.offset = offsets[i];
+  }
+  for (int slot = 0; slot < numSlots; ++slot) {
+    new (&header_->sequences()[slot]) SlotSequence{{0}};
+  }
+  header_->magic.store(RingMagic, std::memory_order_release);
+}
+
+SharedMemoryRing::SharedMemoryRing(const std::string& name)
+    : name_{sharedMemoryName(name)} {
+  fd_ = shm_open(name_.c_str(), O_RDWR, 0600);
+  if (fd_ == -1) {
+    throw sharedMemoryError("cannot open", name_);
+  }
+  struct stat status;
+  if (fstat(fd_, &status) != 0) {
+    const std::runtime_error error = sharedMemoryError("cannot stat", name_);
+    close(fd_);
+    throw error;
+  }
+  if (static_cast<size_t>(status.st_size) < sizeof(Header)) {
+    close(fd_);
+    throw std::runtime_error{"SharedMemoryRing: " + name_ +
+                             " is not a ring or not created yet"};
+  }
+  map(status.st_size);
+
+  if (header_->magic.load(std::memory_order_acquire) != RingMagic ||
+      header_->version != RingVersion ||
+      size_ < header_->dataOffset + header_->numSlots * header_->slotSize) {
+    munmap(data_, size_);
+    close(fd_);
+    throw std::runtime_error{"SharedMemoryRing: " + name_ +
+                             " is not a ring of version " +
+                             std::to_string(RingVersion)};
+  }
+  for (int i = 0; i < header_->numFields; ++i) {
+    const Header::FieldHeader& fieldHeader = header_->fields[i];
+    fields_.push_back(
+        {fieldHeader.name,
+         {fieldHeader.shape, fieldHeader.shape + fieldHeader.numDimensions},
+         static_cast<DataType>(fieldHeader.dataType)});
+  }
+}
+
+SharedMemoryRing::~SharedMemoryRing() {
+  munmap(data_, size_);
+  close(fd_);
+  if (isCreator_) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+void SharedMemoryRing::map(size_t size) {
+  data_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data_ == MAP_FAILED) {
+    const std::runtime_error error = sharedMemoryError("cannot map", name_);
+    close(fd_);
+    if (isCreator_) {
+      shm_unlink(name_.c_str());
+    }
+    throw error;
+  }
+  size_ = size;
+  header_ = static_cast<Header*>(data_);
+}
+
+int SharedMemoryRing::numSlots() const {
+  return header_->numSlots;
+}
+
+size_t SharedMemoryRing::slotSize() const {
+  return header_->slotSize;
+}
+
+Buffer::ptr SharedMemoryRing::field(int slot, const std::string& name) {
+  if (slot < 0 || slot >= numSlots()) {
+    LOG(ERROR) << "SharedMemoryRing::field: no slot " << slot << " in "
+               << name_;
+    return nullptr;
+  }
+  for (int i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].name == name) {
+      uint8_t* data = static_cast<uint8_t*>(data_) + header_->dataOffset +
+                      slot * header_->slotSize + header_->fields[i].offset;
+      return Buffer::create(data, fields_[i].shape, fields_[i].dataType);
+    }
+  }
+  LOG(ERROR) << "SharedMemoryRing::field: no field " << name << " in "
+             << name_;
+  return nullptr;
+}
+
+uint64_t SharedMemoryRing::sequence(int slot) const {
+  CORRADE_ASSERT(0 <= slot && slot < numSlots(),
+                 "SharedMemoryRing::sequence: no slot" << slot, 0);
+  return header_->sequences()[slot].value.load(std::memory_order_acquire);
+}
+
+void SharedMemoryRing::publish(int slot) {
+  CORRADE_ASSERT(0 <= slot && slot < numSlots(),
+                 "SharedMemoryRing::publish: no slot" << slot, );
+  header_->sequences()[slot].value.fetch_add(1, std::memory_order_release);
+}
+
+}  // namespace core
+}  // namespace esp
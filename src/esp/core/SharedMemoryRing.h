@@ -0,0 +1,137 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_SHAREDMEMORYRING_H_
+#define ESP_CORE_SHAREDMEMORYRING_H_
+
+/** @file
+ * @brief Class @ref esp::core::SharedMemoryRing
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp/core/Buffer.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief A ring of slots in POSIX shared memory, each holding the same named
+ * fields, e.g. the observations of the sensors of an agent.
+ *
+ * An environment worker process creates the ring and writes the observations
+ * of each step into the next slot, see @ref
+ * sim::Simulator::getAgentObservations(int, SharedMemoryRing&, int), while
+ * the trainer process opens the same ring by name and views the fields
+ * of a slot as buffers, without any serialization or copy.
+ *
+ * Each slot has a sequence number, incremented by @ref publish() once the
+ * writer is done with the slot. The reader waits for it to change before
+ * viewing the slot and must be done with it before the writer comes around
+ * to it again, e.g. by acknowledging it through the pipe it sends the
+ * actions over. The layout is native, writer and reader must run on the
+ * same machine.
+ */
+class SharedMemoryRing {
+ public:
+  /**
+   * @brief A named array in each slot
+   */
+  struct Field {
+    std::string name;
+    std::vector<size_t> shape;
+    DataType dataType = DataType::DT_UINT8;
+  };
+
+  /** @brief Maximum number of fields of a ring */
+  static constexpr int MaxFields = 16;
+
+  /** @brief Maximum number of dimensions of a field */
+  static constexpr int MaxDimensions = 4;
+
+  /** @brief Maximum length of the name of a field */
+  static constexpr int MaxNameLength = 63;
+
+  /**
+   * @brief Create a ring, replacing one of the same name. It is removed when
+   * the creating instance is destroyed, the processes that opened it keep
+   * their mapping.
+   * @param name The name of the shared memory object, at most 31 characters
+   * on macOS, a leading slash is added if missing
+   * @param numSlots The number of slots
+   * @param fields The arrays of each slot
+   * @throw std::runtime_error If the fields cannot be described, or the
+   * shared memory cannot be created
+   */
+  SharedMemoryRing(const std::string& name,
+                   int numSlots,
+                   const std::vector<Field>& fields);
+
+  /**
+   * @brief Open the ring created under @p name by another process
+   * @throw std::runtime_error If there is no such ring or it is of a different
+   * version
+   */
+  explicit SharedMemoryRing(const std::string& name);
+
+  ~SharedMemoryRing();
+
+  SharedMemoryRing(const SharedMemoryRing&) = delete;
+  SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+  /** @brief The name of the shared memory object */
+  const std::string& name() const { return name_; }
+
+  /** @brief The number of slots */
+  int numSlots() const;
+
+  /** @brief The size of a slot in bytes */
+  size_t slotSize() const;
+
+  /** @brief The arrays of each slot */
+  const std::vector<Field>& fields() const { return fields_; }
+
+  /**
+   * @brief View the field @p name of slot @p slot, without copying it.
+   *
+   * The buffer wraps the shared memory and must not outlive the ring.
+   * @return nullptr if the slot or field doesn't exist
+   */
+  Buffer::ptr field(int slot, const std::string& name);
+
+  /**
+   * @brief The number of times slot @p slot was published, see @ref publish()
+   */
+  uint64_t sequence(int slot) const;
+
+  /**
+   * @brief Mark the writes into slot @p slot done, making them visible to
+   * the readers that see the new @ref sequence().
+   */
+  void publish(int slot);
+
+ private:
+  struct Header;
+
+  //! map size bytes of the shared memory object fd_
+  void map(size_t size);
+
+  std::string name_;
+  bool isCreator_ = false;
+  int fd_ = -1;
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  Header* header_ = nullptr;
+  std::vector<Field> fields_;
+
+  ESP_SMART_POINTERS(SharedMemoryRing)
+};
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_SHAREDMEMORYRING_H_
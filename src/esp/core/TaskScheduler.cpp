@@ -0,0 +1,383 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <Corrade/configure.h>
+
+#if defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_APPLE) && \
+    !defined(CORRADE_TARGET_EMSCRIPTEN)
+#define ESP_CORE_THREAD_AFFINITY
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace esp {
+namespace core {
+
+namespace {
+
+typedef std::function<void()> Task;
+
+struct WorkerQueue {
+  std::mutex mutex;
+  std::deque<Task> tasks;
+};
+
+//! the scheduler and queue of the worker thread, if any
+thread_local const void* currentScheduler = nullptr;
+thread_local int currentWorker = -1;
+
+struct GlobalSchedulerConfig {
+  std::mutex mutex;
+  std::unique_ptr<TaskScheduler> scheduler;
+  int numThreads = 0;
+  std::vector<int> cpus;
+};
+
+GlobalSchedulerConfig& globalSchedulerConfig() {
+  static GlobalSchedulerConfig config;
+  return config;
+}
+
+}  // namespace
+
+struct TaskScheduler::Impl {
+  Impl(int numThreads, const std::vector<int>& cpus) {
+    if (numThreads <= 0) {
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numThreads_ = numThreads;
+    // the threads starting the loops take part in them
+    const int numWorkers = numThreads - 1;
+    for (int i = 0; i < std::max(numWorkers, 1); ++i) {
+      queues_.emplace_back(new WorkerQueue);
+    }
+    workers_.reserve(numWorkers);
+    for (int i = 0; i < numWorkers; ++i) {
+      workers_.emplace_back([this, i]() { workerLoop(i); });
+#ifdef ESP_CORE_THREAD_AFFINITY
+      if (!cpus.empty()) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpus[i % cpus.size()], &cpuSet);
+        pthread_setaffinity_np(workers_.back().native_handle(),
+                               sizeof(cpuSet), &cpuSet);
+      }
+#endif
+    }
+#ifndef ESP_CORE_THREAD_AFFINITY
+    if (!cpus.empty()) {
+      LOG(WARNING) << "TaskScheduler : pinning to CPUs is not supported on "
+                      "this platform";
+    }
+#endif
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock{sleepMutex_};
+      stopped_ = true;
+    }
+    wakeUp_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void submit(Task task) {
+    // a worker pushes to its own queue, to run the task itself unless stolen
+    const size_t queue =
+        currentScheduler == this
+            ? currentWorker
+            : nextQueue_.fetch_add(1, std::memory_order_relaxed) %
+                  queues_.size();
+    {
+      std::lock_guard<std::mutex> lock{queues_[queue]->mutex};
+      queues_[queue]->tasks.push_back(std::move(task));
+    }
+    ++numQueued_;
+    { std::lock_guard<std::mutex> lock{sleepMutex_}; }
+    wakeUp_.notify_one();
+  }
+
+  bool runPendingTask() {
+    Task task;
+    if (!popTask(currentScheduler == this ? currentWorker : -1, task)) {
+      return false;
+    }
+    task();
+    return true;
+  }
+
+  //! the newest task of queue @p self, else the oldest of another one
+  bool popTask(int self, Task& task) {
+    if (numQueued_ == 0) {
+      return false;
+    }
+    if (self >= 0) {
+      WorkerQueue& queue = *queues_[self];
+      std::lock_guard<std::mutex> lock{queue.mutex};
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        --numQueued_;
+        return true;
+      }
+    }
+    const size_t start = self >= 0 ? self + 1 : 0;
+    for (size_t i = 0; i < queues_.size(); ++i) {
+      WorkerQueue& queue = *queues_[(start + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock{queue.mutex};
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        --numQueued_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void workerLoop(int index) {
+    currentScheduler = this;
+    currentWorker = index;
+    for (Task task;;) {
+      if (popTask(index, task)) {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock{sleepMutex_};
+      wakeUp_.wait(lock, [&]() { return stopped_ || numQueued_ > 0; });
+      if (stopped_ && numQueued_ == 0) {
+        return;
+      }
+    }
+  }
+
+  int numThreads_ = 1;
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> numQueued_{0};
+  std::atomic<size_t> nextQueue_{0};
+  std::mutex sleepMutex_;
+  std::condition_variable wakeUp_;
+  bool stopped_ = false;
+};
+
+TaskScheduler::TaskScheduler(int numThreads, const std::vector<int>& cpus)
+    : pimpl_(spimpl::make_unique_impl<Impl>(numThreads, cpus)) {}
+
+TaskScheduler::~TaskScheduler() = default;
+
+TaskScheduler& TaskScheduler::global() {
+  GlobalSchedulerConfig& config = globalSchedulerConfig();
+  std::lock_guard<std::mutex> lock{config.mutex};
+  if (!config.scheduler) {
+    int numThreads = config.numThreads;
+    const char* variable = std::getenv("HABITAT_SIM_NUM_THREADS");
+    if (numThreads <= 0 && variable != nullptr) {
+      numThreads = std::atoi(variable);
+    }
+    config.scheduler.reset(new TaskScheduler{numThreads, config.cpus});
+  }
+  return *config.scheduler;
+}
+
+bool TaskScheduler::configureGlobal(int numThreads,
+                                    const std::vector<int>& cpus) {
+  GlobalSchedulerConfig& config = globalSchedulerConfig();
+  std::lock_guard<std::mutex> lock{config.mutex};
+  if (config.scheduler) {
+    LOG(WARNING) << "TaskScheduler::configureGlobal : the scheduler is "
+                    "already running, keeping its "
+                 << config.scheduler->numThreads() << " threads";
+    return false;
+  }
+  config.numThreads = numThreads;
+  config.cpus = cpus;
+  return true;
+}
+
+int TaskScheduler::numThreads() const {
+  return pimpl_->numThreads_;
+}
+
+int TaskScheduler::concurrency(size_t numItems, int maxThreads) const {
+  const int numThreads = maxThreads <= 0
+                             ? pimpl_->numThreads_
+                             : std::min(maxThreads, pimpl_->numThreads_);
+  return std::min<size_t>(numThreads, numItems);
+}
+
+void TaskScheduler::parallelFor(size_t numItems,
+                                int maxThreads,
+                                const std::function<void(size_t, int)>& func) {
+  const int numThreads = concurrency(numItems, maxThreads);
+  if (numThreads <= 1) {
+    for (size_t i = 0; i < numItems; ++i) {
+      func(i, 0);
+    }
+    return;
+  }
+
+  // the helpers join by taking a thread index, those starting after the
+  // loop is closed leave without touching it
+  struct Loop {
+    const std::function<void(size_t, int)>* func;
+    size_t numItems;
+    std::atomic<size_t> nextItem{0};
+    std::atomic<int> nextThread{1};
+    std::atomic<int> numFinished{0};
+  };
+  auto loop = std::make_shared<Loop>();
+  loop->func = &func;
+  loop->numItems = numItems;
+  auto runItems = [](Loop& loop, int threadIndex) {
+    for (size_t i = loop.nextItem++; i < loop.numItems; i = loop.nextItem++) {
+      (*loop.func)(i, threadIndex);
+    }
+  };
+  for (int i = 1; i < numThreads; ++i) {
+    submit([loop, runItems, numThreads]() {
+      const int threadIndex = loop->nextThread++;
+      if (threadIndex >= numThreads) {
+        return;
+      }
+      runItems(*loop, threadIndex);
+      ++loop->numFinished;
+    });
+  }
+  runItems(*loop, 0);
+
+  const int numJoined = std::min(loop->nextThread.exchange(numThreads),
+                                 numThreads) -
+                        1;
+  while (loop->numFinished < numJoined) {
+    std::this_thread::yield();
+  }
+}
+
+void TaskScheduler::parallelForRanges(
+    size_t numItems,
+    int maxThreads,
+    const std::function<void(size_t, size_t)>& func) {
+  const int numRanges = concurrency(numItems, maxThreads);
+  if (numRanges == 0) {
+    return;
+  }
+  const size_t itemsPerRange = (numItems + numRanges - 1) / numRanges;
+  parallelFor(numRanges, numRanges, [&](size_t range, int) {
+    const size_t begin = range * itemsPerRange;
+    if (begin < numItems) {
+      func(begin, std::min(begin + itemsPerRange, numItems));
+    }
+  });
+}
+
+void TaskScheduler::submit(std::function<void()> task) {
+  if (pimpl_->workers_.empty()) {
+    task();
+    return;
+  }
+  pimpl_->submit(std::move(task));
+}
+
+bool TaskScheduler::runPendingTask() {
+  return pimpl_->runPendingTask();
+}
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler) : scheduler_{scheduler} {}
+
+TaskGroup::~TaskGroup() {
+  wait();
+}
+
+TaskGroup::TaskId TaskGroup::add(std::function<void()> task,
+                                 const std::vector<TaskId>& dependencies) {
+  TaskId id;
+  bool ready;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    id = nodes_.size();
+    nodes_.emplace_back();
+    Node& node = nodes_.back();
+    node.task = std::move(task);
+    for (TaskId dependency : dependencies) {
+      CORRADE_ASSERT(dependency < id,
+                     "TaskGroup::add: unknown dependency" << dependency, id);
+      if (!nodes_[dependency].done) {
+        nodes_[dependency].successors.push_back(id);
+        ++node.numPendingDependencies;
+      }
+    }
+    ++numUnfinished_;
+    ready = node.numPendingDependencies == 0;
+  }
+  if (ready) {
+    scheduler_.submit([this, id]() { run(id); });
+  }
+  return id;
+}
+
+void TaskGroup::run(TaskId id) {
+  std::function<void()> task;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    task = std::move(nodes_[id].task);
+  }
+  task();
+
+  std::vector<TaskId> ready;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    Node& node = nodes_[id];
+    node.done = true;
+    for (TaskId successor : node.successors) {
+      if (--nodes_[successor].numPendingDependencies == 0) {
+        ready.push_back(successor);
+      }
+    }
+    // notified under the lock, the group may be gone right after
+    if (--numUnfinished_ == 0) {
+      done_.notify_all();
+      return;
+    }
+  }
+  // the successors are unfinished, so the group is still alive
+  for (TaskId successor : ready) {
+    scheduler_.submit([this, successor]() { run(successor); });
+  }
+}
+
+void TaskGroup::wait() {
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (numUnfinished_ == 0) {
+        return;
+      }
+    }
+    // help instead of blocking a worker that other tasks of the group need
+    if (scheduler_.runPendingTask()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_.wait_for(lock, std::chrono::milliseconds(1),
+                   [&]() { return numUnfinished_ == 0; });
+  }
+}
+
+}  // namespace core
+}  // namespace esp
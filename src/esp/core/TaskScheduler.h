@@ -0,0 +1,173 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_TASKSCHEDULER_H_
+#define ESP_CORE_TASKSCHEDULER_H_
+
+/** @file
+ * @brief Class @ref esp::core::TaskScheduler, @ref esp::core::TaskGroup
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief A pool of worker threads shared by the parallel work of all
+ * simulators of the process, e.g. batched path queries and raycasts or
+ * texture decoding, so that they don't oversubscribe the cores.
+ *
+ * Each worker has its own queue of tasks, taking the last one pushed first
+ * and stealing the oldest ones of the other workers once its queue is empty.
+ * The thread starting a parallel loop takes part in it, so a loop started
+ * from a worker, or while all workers are busy, still makes progress on the
+ * calling thread alone.
+ */
+class TaskScheduler {
+ public:
+  /**
+   * @brief Create a scheduler
+   * @param numThreads The number of threads running the tasks, the one
+   * starting a loop included, all hardware threads if 0 or less
+   * @param cpus The CPUs the workers are pinned to in turn, none if empty.
+   * Linux only.
+   */
+  explicit TaskScheduler(int numThreads = 0,
+                         const std::vector<int>& cpus = {});
+
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  /**
+   * @brief The scheduler of the process, created on first use with the
+   * threads of @ref configureGlobal(), else of the `HABITAT_SIM_NUM_THREADS`
+   * environment variable, else all hardware threads
+   */
+  static TaskScheduler& global();
+
+  /**
+   * @brief Set the threads and CPUs of @ref global()
+   * @return Whether they apply, false if the scheduler was already created
+   */
+  static bool configureGlobal(int numThreads,
+                              const std::vector<int>& cpus = {});
+
+  /** @brief The number of threads running the tasks, callers included */
+  int numThreads() const;
+
+  /**
+   * @brief The number of threads a loop over @p numItems items on at most
+   * @p maxThreads threads runs on, the bound of the thread indices passed to
+   * its function
+   * @param numItems The number of items
+   * @param maxThreads The most threads, @ref numThreads() if 0 or less
+   */
+  int concurrency(size_t numItems, int maxThreads = 0) const;
+
+  /**
+   * @brief Run @p func(i, threadIndex) for all i in [0, @p numItems)
+   *
+   * The items are handed out one by one, so they can vary in cost. The
+   * thread index is below @ref concurrency(), for per-thread state, and 0
+   * for the calling thread. Returns once all items are done.
+   * @param numItems The number of items
+   * @param maxThreads The most threads to run on, all if 0 or less
+   * @param func The function of an item
+   */
+  void parallelFor(size_t numItems,
+                   int maxThreads,
+                   const std::function<void(size_t, int)>& func);
+
+  /**
+   * @brief Run @p func(begin, end) on a contiguous range of
+   * [0, @p numItems) per thread, e.g. for items of the same cost writing to
+   * adjacent memory
+   *
+   * Writing per item results, each thread writes its own cache lines but
+   * for the two at the ends of its range.
+   */
+  void parallelForRanges(size_t numItems,
+                         int maxThreads,
+                         const std::function<void(size_t, size_t)>& func);
+
+  /**
+   * @brief Queue @p task to be run by a worker, or by a thread waiting in
+   * @ref runPendingTask(). Prefer @ref TaskGroup to wait for it.
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * @brief Run a queued task on the calling thread, if any
+   * @return Whether a task was run
+   */
+  bool runPendingTask();
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(TaskScheduler)
+};
+
+/**
+ * @brief A graph of tasks run by a @ref TaskScheduler, each once the tasks it
+ * depends on are done
+ *
+ * Tasks can be added while the earlier ones run, from any thread, including
+ * from within a task. The destructor waits for all of them.
+ */
+class TaskGroup {
+ public:
+  //! Identifies a task of the group, in the order they are added
+  typedef size_t TaskId;
+
+  explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::global());
+
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /**
+   * @brief Add @p task, to run once the tasks of @p dependencies are done
+   * @return The ID of the task, to depend on it
+   */
+  TaskId add(std::function<void()> task,
+             const std::vector<TaskId>& dependencies = {});
+
+  /**
+   * @brief Wait for all tasks added so far, running queued tasks on the
+   * calling thread meanwhile
+   */
+  void wait();
+
+ private:
+  struct Node {
+    std::function<void()> task;
+    std::vector<TaskId> successors;
+    int numPendingDependencies = 0;
+    bool done = false;
+  };
+
+  //! run task @p id and release its successors
+  void run(TaskId id);
+
+  TaskScheduler& scheduler_;
+  std::mutex mutex_;
+  std::condition_variable done_;
+  //! stable references while tasks are added
+  std::deque<Node> nodes_;
+  size_t numUnfinished_ = 0;
+};
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_TASKSCHEDULER_H_
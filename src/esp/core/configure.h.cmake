@@ -15,3 +15,9 @@
 #cmakedefine ESP_BUILD_WITH_CUDA
 
 #cmakedefine ESP_BUILD_WITH_BULLET
+
+#cmakedefine ESP_BUILD_MESHOPT_SUPPORT
+
+#cmakedefine ESP_BUILD_DRACO_SUPPORT
+
+#define ESP_MIN_LOG_LEVEL @ESP_MIN_LOG_LEVEL@
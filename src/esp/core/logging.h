@@ -5,8 +5,24 @@
 #ifndef ESP_CORE_LOGGING_H_
 #define ESP_CORE_LOGGING_H_
 
+#include <atomic>
+
 #include "esp/core/configure.h"
 
+// Severities of the LOG() calls compiled in, see the MIN_LOG_LEVEL CMake
+// option: the less severe ones compile to nothing
+#ifndef ESP_MIN_LOG_LEVEL
+#define ESP_MIN_LOG_LEVEL 0
+#endif
+#define ESP_LOG_SEVERITY_INFO 0
+#define ESP_LOG_SEVERITY_WARNING 1
+#define ESP_LOG_SEVERITY_ERROR 2
+// never stripped, as it aborts
+#define ESP_LOG_SEVERITY_FATAL 3
+#define ESP_LOG_IS_ON(severity)                        \
+  (ESP_LOG_SEVERITY_##severity >= ESP_MIN_LOG_LEVEL || \
+   ESP_LOG_SEVERITY_##severity == ESP_LOG_SEVERITY_FATAL)
+
 #if defined(ESP_BUILD_GLOG_SHIM)
 
 #include <Corrade/Utility/Debug.h>
@@ -31,9 +47,14 @@ class LogMessageVoidify {
   Corrade::Utility::Error {}
 #define GLOG_FATAL \
   Corrade::Utility::Fatal {}
-#define LOG(severity) GLOG_##severity
-#define LOG_IF(severity, condition) \
-  !(condition) ? (void)0 : LogMessageVoidify() & LOG(severity)
+// the stream operands of a disabled severity are never evaluated
+#define LOG(severity)                \
+  !ESP_LOG_IS_ON(severity) ? (void)0 \
+                           : LogMessageVoidify() & GLOG_##severity
+#define LOG_IF(severity, condition)         \
+  !(ESP_LOG_IS_ON(severity) && (condition)) \
+      ? (void)0                             \
+      : LogMessageVoidify() & GLOG_##severity
 
 #define VLOG_LEVEL 0
 
@@ -54,11 +75,44 @@ class LogMessageVoidify {
 #define CHECK_LE(a, b) CHECK(a <= b)
 
 #else
+// glog compiles LOG() of the stripped severities to a null stream
+#if !defined(GOOGLE_STRIP_LOG) && ESP_MIN_LOG_LEVEL > 0
+#define GOOGLE_STRIP_LOG ESP_MIN_LOG_LEVEL
+#endif
 // stl_logging.h needs to be before logging.h because template magic.
 #include <glog/logging.h>
 #include <glog/stl_logging.h>
+// replaced below by versions which are thread-safe and stripped as LOG() is
+#undef LOG_EVERY_N
+#undef LOG_IF_EVERY_N
+#undef LOG_FIRST_N
 #endif
 
+#define ESP_LOG_CONCAT_IMPL(a, b) a##b
+#define ESP_LOG_CONCAT(a, b) ESP_LOG_CONCAT_IMPL(a, b)
+#define ESP_LOG_OCCURRENCES ESP_LOG_CONCAT(espLogOccurrences, __LINE__)
+
+/**
+ * Log the 1st, (n+1)th, (2n+1)th... time this is reached with @p condition
+ * true. Expands to a statement, like the glog macros of the same name, so
+ * it must not be the unbraced body of an if.
+ */
+#define LOG_IF_EVERY_N(severity, condition, n)     \
+  static std::atomic<int> ESP_LOG_OCCURRENCES{0};  \
+  if (ESP_LOG_IS_ON(severity) && (condition) &&    \
+      ESP_LOG_OCCURRENCES.fetch_add(1) % (n) == 0) \
+  LOG(severity)
+
+/** Log the 1st, (n+1)th, (2n+1)th... time this is reached */
+#define LOG_EVERY_N(severity, n) LOG_IF_EVERY_N(severity, true, n)
+
+/** Log the first @p n times this is reached */
+#define LOG_FIRST_N(severity, n)                                     \
+  static std::atomic<int> ESP_LOG_OCCURRENCES{0};                    \
+  if (ESP_LOG_IS_ON(severity) && ESP_LOG_OCCURRENCES.load() < (n) && \
+      ESP_LOG_OCCURRENCES.fetch_add(1) < (n))                        \
+  LOG(severity)
+
 #define ASSERT(x, ...)                                              \
   do {                                                              \
     if (!(x)) {                                                     \
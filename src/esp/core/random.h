@@ -5,6 +5,10 @@
 #ifndef ESP_CORE_RANDOM_H_
 #define ESP_CORE_RANDOM_H_
 
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <random>
 
 #include "esp.h"
@@ -12,35 +16,74 @@
 namespace esp {
 namespace core {
 
+/**
+ * @brief Counter-based random generator (Philox4x32-10) with independent
+ * streams
+ *
+ * Every block of four 32-bit numbers is a pure function of the seed, the
+ * stream ID and the index of the block, so generators of different streams,
+ * e.g. one per thread or per environment from @ref stream(), are independent
+ * and reproducible whatever order they are used in. A generator itself is not
+ * thread-safe.
+ */
 class Random {
  public:
-  explicit Random(unsigned int seed = std::random_device()())
-      : gen_(seed),
-        uniform_float_01_(0, 1),
-        uniform_int_(),
-        uniform_uint32_(),
-        normal_float_01_(0, 1) {}
+  explicit Random(unsigned int seed = std::random_device()(),
+                  uint64_t streamId = 0)
+      : seed_(seed), stream_(streamId) {}
+
+  //! Seed the random generator state with the given number, restarting the
+  //! sequence of the stream
+  void seed(uint32_t newSeed) {
+    seed_ = newSeed;
+    counter_ = 0;
+    blockIndex_ = 4;
+    hasSpareNormal_ = false;
+  }
+
+  //! Return a new generator of the same seed and stream @p streamId, starting
+  //! at the beginning of its sequence
+  Random stream(uint64_t streamId) const { return Random(seed_, streamId); }
 
-  //! Seed the random generator state with the given number
-  void seed(uint32_t newSeed) { gen_.seed(newSeed); }
+  //! The stream ID of this generator
+  uint64_t getStream() const { return stream_; }
 
   //! Return randomly sampled int distributed uniformly in [0,
   //! std::numeric_limits<int>::max()]
-  int uniform_int() { return uniform_int_(gen_); }
+  int uniform_int() { return static_cast<int>(uniform_uint() >> 1); }
 
   //! Return randomly sampled uint32_t distributed uniformly in [0,
   //! std::numeric_limits<uint32_t>::max()]
-  uint32_t uniform_uint() { return uniform_uint32_(gen_); }
+  uint32_t uniform_uint() {
+    if (blockIndex_ == 4) {
+      block_ = nextBlock();
+      blockIndex_ = 0;
+    }
+    return block_[blockIndex_++];
+  }
 
   //! Return randomly sampled float distributed uniformly in [0, 1)
-  float uniform_float_01() { return uniform_float_01_(gen_); }
+  float uniform_float_01() { return toFloat01(uniform_uint()); }
 
   //! Return randomly sampled float distributed normally (mean=0, std=1)
-  float normal_float_01() { return normal_float_01_(gen_); }
+  float normal_float_01() {
+    if (hasSpareNormal_) {
+      hasSpareNormal_ = false;
+      return spareNormal_;
+    }
+    // Box-Muller, with u1 in (0, 1] so that its log is finite
+    const float u1 = 1.0f - uniform_float_01();
+    const float u2 = uniform_float_01();
+    const float radius = std::sqrt(-2.0f * std::log(u1));
+    const float angle = 2.0f * float(M_PI) * u2;
+    spareNormal_ = radius * std::sin(angle);
+    hasSpareNormal_ = true;
+    return radius * std::cos(angle);
+  }
 
   //! Return randomly sampled float distributed uniformly in [a, b)
   float uniform_float(float a, float b) {
-    return uniform_float_01_(gen_) * (b - a) + a;
+    return uniform_float_01() * (b - a) + a;
   }
 
   //! Return randomly sampled int distributed uniformly in [a, b)
@@ -49,12 +92,57 @@ class Random {
         uniform_float(static_cast<float>(a), static_cast<float>(b)));
   }
 
+  //! Fill @p data with @p count floats distributed uniformly in [0, 1), the
+  //! same ones as that many calls to @ref uniform_float_01() but whole blocks
+  //! at a time
+  void fill_uniform_float_01(float* data, size_t count) {
+    size_t i = 0;
+    for (; i < count && blockIndex_ != 4; ++i) {
+      data[i] = uniform_float_01();
+    }
+    for (; i + 4 <= count; i += 4) {
+      const std::array<uint32_t, 4> block = nextBlock();
+      for (int j = 0; j < 4; ++j) {
+        data[i + j] = toFloat01(block[j]);
+      }
+    }
+    for (; i < count; ++i) {
+      data[i] = uniform_float_01();
+    }
+  }
+
  protected:
-  std::default_random_engine gen_;
-  std::uniform_real_distribution<float> uniform_float_01_;
-  std::uniform_int_distribution<int> uniform_int_;
-  std::uniform_int_distribution<uint32_t> uniform_uint32_;
-  std::normal_distribution<float> normal_float_01_;
+  //! the 24 high bits, the precision of a float in [0, 1)
+  static float toFloat01(uint32_t bits) {
+    return (bits >> 8) * (1.0f / 16777216.0f);
+  }
+
+  //! the block of counter_, advancing it
+  std::array<uint32_t, 4> nextBlock() {
+    std::array<uint32_t, 4> ctr{uint32_t(counter_), uint32_t(counter_ >> 32),
+                                uint32_t(stream_), uint32_t(stream_ >> 32)};
+    std::array<uint32_t, 2> key{uint32_t(seed_), uint32_t(seed_ >> 32)};
+    ++counter_;
+    for (int round = 0; round < 10; ++round) {
+      const uint64_t product0 = uint64_t(0xD2511F53u) * ctr[0];
+      const uint64_t product1 = uint64_t(0xCD9E8D57u) * ctr[2];
+      ctr = {uint32_t(product1 >> 32) ^ ctr[1] ^ key[0], uint32_t(product1),
+             uint32_t(product0 >> 32) ^ ctr[3] ^ key[1], uint32_t(product0)};
+      key[0] += 0x9E3779B9u;
+      key[1] += 0xBB67AE85u;
+    }
+    return ctr;
+  }
+
+  uint64_t seed_;
+  uint64_t stream_;
+  //! index of the next block of the stream
+  uint64_t counter_ = 0;
+  std::array<uint32_t, 4> block_{};
+  //! next unused number of block_, 4 when it is used up
+  int blockIndex_ = 4;
+  float spareNormal_ = 0.0f;
+  bool hasSpareNormal_ = false;
 
   ESP_SMART_POINTERS(Random);
 };
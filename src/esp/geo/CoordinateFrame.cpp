@@ -4,9 +4,14 @@
 
 #include "CoordinateFrame.h"
 
+#include <Magnum/EigenIntegration/Integration.h>
+
+#include "esp/geo/PoseConversion.h"
 #include "esp/geo/geo.h"
 #include "esp/io/json.h"
 
+namespace Cr = Corrade;
+
 namespace esp {
 namespace geo {
 
@@ -35,6 +40,47 @@ quatf CoordinateFrame::rotationFrameToWorld() const {
   return rotationWorldToFrame().inverse();
 }
 
+Transform CoordinateFrame::transformationWorldToFrame() const {
+  Transform transformation = Transform::Identity();
+  transformation.rotate(rotationWorldToFrame());
+  transformation.translate(-origin_);
+  return transformation;
+}
+
+namespace {
+Mn::Quaternion toMagnum(const quatf& q) {
+  return Mn::Quaternion{{q.x(), q.y(), q.z()}, q.w()};
+}
+}  // namespace
+
+void CoordinateFrame::pointsWorldToFrame(
+    Cr::Containers::ArrayView<const Mn::Vector3> points,
+    Cr::Containers::ArrayView<Mn::Vector3> result) const {
+  // R * (p - origin)
+  const Mn::Matrix3x3 rotation = toMagnum(rotationWorldToFrame()).toMatrix();
+  transformPoints(rotation, -(rotation * Mn::Vector3{origin_}), points,
+                  result);
+}
+
+void CoordinateFrame::pointsFrameToWorld(
+    Cr::Containers::ArrayView<const Mn::Vector3> points,
+    Cr::Containers::ArrayView<Mn::Vector3> result) const {
+  transformPoints(toMagnum(rotationFrameToWorld()).toMatrix(),
+                  Mn::Vector3{origin_}, points, result);
+}
+
+void CoordinateFrame::rotationsWorldToFrame(
+    Cr::Containers::ArrayView<const Mn::Quaternion> rotations,
+    Cr::Containers::ArrayView<Mn::Quaternion> result) const {
+  rotateQuaternions(toMagnum(rotationWorldToFrame()), rotations, result);
+}
+
+void CoordinateFrame::rotationsFrameToWorld(
+    Cr::Containers::ArrayView<const Mn::Quaternion> rotations,
+    Cr::Containers::ArrayView<Mn::Quaternion> result) const {
+  rotateQuaternions(toMagnum(rotationFrameToWorld()), rotations, result);
+}
+
 std::string CoordinateFrame::toJson() const {
   std::stringstream ss;
   ss << "{\"up\":" << up() << ",\"front\":" << front()
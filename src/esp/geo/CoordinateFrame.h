@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Math/Quaternion.h>
+
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
 
@@ -47,6 +50,30 @@ class CoordinateFrame {
   //! Return Transform from world coordinates to local coordinates
   Transform transformationWorldToFrame() const;
 
+  //! Transform @p points from world coordinates to this CoordinateFrame into
+  //! @p result, which can be the same array
+  void pointsWorldToFrame(
+      Corrade::Containers::ArrayView<const Magnum::Vector3> points,
+      Corrade::Containers::ArrayView<Magnum::Vector3> result) const;
+
+  //! Transform @p points from this CoordinateFrame to world coordinates into
+  //! @p result, which can be the same array
+  void pointsFrameToWorld(
+      Corrade::Containers::ArrayView<const Magnum::Vector3> points,
+      Corrade::Containers::ArrayView<Magnum::Vector3> result) const;
+
+  //! Express @p rotations relative to the world in this CoordinateFrame into
+  //! @p result, which can be the same array
+  void rotationsWorldToFrame(
+      Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations,
+      Corrade::Containers::ArrayView<Magnum::Quaternion> result) const;
+
+  //! Express @p rotations relative to this CoordinateFrame in the world into
+  //! @p result, which can be the same array
+  void rotationsFrameToWorld(
+      Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations,
+      Corrade::Containers::ArrayView<Magnum::Quaternion> result) const;
+
   //! Returns a stringified JSON representation of this CoordinateFrame
   std::string toJson() const;
 
@@ -0,0 +1,290 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "MeshBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <Magnum/Math/Functions.h>
+
+#include "esp/core/TaskScheduler.h"
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace geo {
+
+namespace {
+
+//! the most triangles in a leaf, one pack
+constexpr uint32_t LeafSize = 4;
+
+//! deeper than a median split of 2^32 triangles gets
+constexpr int MaxStackSize = 64;
+
+//! triangles this close to parallel to the ray are missed
+constexpr float DeterminantEpsilon = 1e-12f;
+
+//! whether the ray from @p origin with inverse direction @p invDirection
+//! crosses @p bounds before @p maxT. Coordinates of an axis parallel ray on
+//! a face of the bounds give NaNs, which are ignored.
+bool hitsBounds(const Mn::Range3D& bounds,
+                const Mn::Vector3& origin,
+                const Mn::Vector3& invDirection,
+                float maxT) {
+  float tmin = 0.0f;
+  float tmax = maxT;
+  for (int i = 0; i < 3; ++i) {
+    const float t1 = (bounds.min()[i] - origin[i]) * invDirection[i];
+    const float t2 = (bounds.max()[i] - origin[i]) * invDirection[i];
+    tmin = std::max(tmin, std::min(t1, t2));
+    tmax = std::min(tmax, std::max(t1, t2));
+  }
+  return tmin <= tmax;
+}
+
+}  // namespace
+
+constexpr uint32_t MeshBVH::NoTriangle;
+
+void MeshBVH::build(std::vector<Mn::Vector3> vertices) {
+  clear();
+  const uint32_t numTriangles = vertices.size() / 3;
+  if (numTriangles == 0) {
+    return;
+  }
+  numTriangles_ = numTriangles;
+  std::vector<uint32_t> order(numTriangles);
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<Mn::Vector3> centroids(numTriangles);
+  for (uint32_t i = 0; i < numTriangles; ++i) {
+    centroids[i] =
+        (vertices[3 * i] + vertices[3 * i + 1] + vertices[3 * i + 2]) / 3.0f;
+  }
+
+  // depth first, so the left child of a node is created right after it and
+  // only the right child index needs patching into its parent
+  struct Task {
+    uint32_t begin, end, parent;
+  };
+  constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+  std::vector<Task> tasks{{0, numTriangles, NoParent}};
+  nodes_.reserve(2 * (numTriangles / LeafSize + 1));
+  packs_.reserve(numTriangles / LeafSize + 1);
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    const uint32_t nodeIndex = nodes_.size();
+    if (task.parent != NoParent) {
+      nodes_[task.parent].index = nodeIndex;
+    }
+
+    Mn::Range3D bounds{vertices[3 * order[task.begin]],
+                       vertices[3 * order[task.begin]]};
+    Mn::Range3D centroidBounds{centroids[order[task.begin]],
+                               centroids[order[task.begin]]};
+    for (uint32_t i = task.begin; i < task.end; ++i) {
+      for (int corner = 0; corner < 3; ++corner) {
+        const Mn::Vector3& v = vertices[3 * order[i] + corner];
+        bounds = Mn::Math::join(bounds, Mn::Range3D{v, v});
+      }
+      const Mn::Vector3& centroid = centroids[order[i]];
+      centroidBounds =
+          Mn::Math::join(centroidBounds, Mn::Range3D{centroid, centroid});
+    }
+
+    const uint32_t count = task.end - task.begin;
+    if (count <= LeafSize) {
+      TrianglePack pack{};
+      for (uint32_t lane = 0; lane < LeafSize; ++lane) {
+        pack.triangles[lane] = NoTriangle;
+        if (lane >= count) {
+          continue;
+        }
+        const uint32_t triangle = order[task.begin + lane];
+        const Mn::Vector3& a = vertices[3 * triangle];
+        const Mn::Vector3 e1 = vertices[3 * triangle + 1] - a;
+        const Mn::Vector3 e2 = vertices[3 * triangle + 2] - a;
+        for (int i = 0; i < 3; ++i) {
+          pack.v0[i][lane] = a[i];
+          pack.e1[i][lane] = e1[i];
+          pack.e2[i][lane] = e2[i];
+        }
+        pack.triangles[lane] = triangle;
+      }
+      nodes_.push_back(Node{bounds, uint32_t(packs_.size()), 1, 0});
+      packs_.push_back(pack);
+      continue;
+    }
+
+    const Mn::Vector3 extent = centroidBounds.size();
+    const int axis = extent.x() >= extent.y() && extent.x() >= extent.z()
+                         ? 0
+                         : (extent.y() >= extent.z() ? 1 : 2);
+    nodes_.push_back(Node{bounds, 0, 0, uint16_t(axis)});
+    const uint32_t mid = task.begin + count / 2;
+    std::nth_element(order.begin() + task.begin, order.begin() + mid,
+                     order.begin() + task.end,
+                     [&centroids, axis](uint32_t lhs, uint32_t rhs) {
+                       return centroids[lhs][axis] < centroids[rhs][axis];
+                     });
+    tasks.push_back(Task{mid, task.end, nodeIndex});
+    tasks.push_back(Task{task.begin, mid, NoParent});
+  }
+}
+
+void MeshBVH::clear() {
+  nodes_.clear();
+  packs_.clear();
+  numTriangles_ = 0;
+}
+
+void MeshBVH::intersect(const TrianglePack& pack,
+                        const Mn::Vector3& origin,
+                        const Mn::Vector3& direction,
+                        float maxT,
+                        float (&t)[4]) {
+  const float dx = direction.x(), dy = direction.y(), dz = direction.z();
+  // Moller-Trumbore on all lanes, without branches so it vectorizes
+  for (int i = 0; i < 4; ++i) {
+    const float e1x = pack.e1[0][i], e1y = pack.e1[1][i], e1z = pack.e1[2][i];
+    const float e2x = pack.e2[0][i], e2y = pack.e2[1][i], e2z = pack.e2[2][i];
+    const float px = dy * e2z - dz * e2y;
+    const float py = dz * e2x - dx * e2z;
+    const float pz = dx * e2y - dy * e2x;
+    const float det = e1x * px + e1y * py + e1z * pz;
+    const bool valid = std::abs(det) > DeterminantEpsilon;
+    const float invDet = valid ? 1.0f / det : 0.0f;
+    const float sx = origin.x() - pack.v0[0][i];
+    const float sy = origin.y() - pack.v0[1][i];
+    const float sz = origin.z() - pack.v0[2][i];
+    const float u = (sx * px + sy * py + sz * pz) * invDet;
+    const float qx = sy * e1z - sz * e1y;
+    const float qy = sz * e1x - sx * e1z;
+    const float qz = sx * e1y - sy * e1x;
+    const float v = (dx * qx + dy * qy + dz * qz) * invDet;
+    const float hitT = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+    const bool hit = valid & (u >= 0.0f) & (v >= 0.0f) & (u + v <= 1.0f) &
+                     (hitT >= 0.0f) & (hitT <= maxT);
+    t[i] = hit ? hitT : std::numeric_limits<float>::infinity();
+  }
+}
+
+Mn::Vector3 MeshBVH::normal(const TrianglePack& pack,
+                            int lane,
+                            const Mn::Vector3& direction) {
+  const Mn::Vector3 e1{pack.e1[0][lane], pack.e1[1][lane], pack.e1[2][lane]};
+  const Mn::Vector3 e2{pack.e2[0][lane], pack.e2[1][lane], pack.e2[2][lane]};
+  const Mn::Vector3 n = Mn::Math::cross(e1, e2).normalized();
+  return Mn::Math::dot(n, direction) > 0.0f ? -n : n;
+}
+
+bool MeshBVH::castRay(const Mn::Vector3& origin,
+                      const Mn::Vector3& direction,
+                      float maxT,
+                      Hit& hit) const {
+  hit = Hit{};
+  if (nodes_.empty()) {
+    return false;
+  }
+  const Mn::Vector3 invDirection = 1.0f / direction;
+  const TrianglePack* firstPack = nullptr;
+  int firstLane = 0;
+  float searchT = maxT;
+
+  uint32_t stack[MaxStackSize];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const uint32_t nodeIndex = stack[--stackSize];
+    const Node& node = nodes_[nodeIndex];
+    if (!hitsBounds(node.bounds, origin, invDirection, searchT)) {
+      continue;
+    }
+    if (node.count == 0) {
+      // the near child is popped first, so it can cut the far one short
+      const bool leftFirst = direction[node.axis] >= 0.0f;
+      stack[stackSize++] = leftFirst ? node.index : nodeIndex + 1;
+      stack[stackSize++] = leftFirst ? nodeIndex + 1 : node.index;
+      continue;
+    }
+    for (uint32_t p = node.index; p < node.index + node.count; ++p) {
+      float t[4];
+      intersect(packs_[p], origin, direction, searchT, t);
+      for (int lane = 0; lane < 4; ++lane) {
+        if (t[lane] <= searchT) {
+          searchT = t[lane];
+          firstPack = &packs_[p];
+          firstLane = lane;
+        }
+      }
+    }
+  }
+  if (firstPack == nullptr) {
+    return false;
+  }
+  hit.t = searchT;
+  hit.triangle = firstPack->triangles[firstLane];
+  hit.normal = normal(*firstPack, firstLane, direction);
+  return true;
+}
+
+void MeshBVH::castRayAll(const Mn::Vector3& origin,
+                         const Mn::Vector3& direction,
+                         float maxT,
+                         std::vector<Hit>& hits) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  const size_t firstHit = hits.size();
+  const Mn::Vector3 invDirection = 1.0f / direction;
+  uint32_t stack[MaxStackSize];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const uint32_t nodeIndex = stack[--stackSize];
+    const Node& node = nodes_[nodeIndex];
+    if (!hitsBounds(node.bounds, origin, invDirection, maxT)) {
+      continue;
+    }
+    if (node.count == 0) {
+      stack[stackSize++] = node.index;
+      stack[stackSize++] = nodeIndex + 1;
+      continue;
+    }
+    for (uint32_t p = node.index; p < node.index + node.count; ++p) {
+      float t[4];
+      intersect(packs_[p], origin, direction, maxT, t);
+      for (int lane = 0; lane < 4; ++lane) {
+        if (t[lane] <= maxT) {
+          hits.push_back(Hit{t[lane], packs_[p].triangles[lane],
+                             normal(packs_[p], lane, direction)});
+        }
+      }
+    }
+  }
+  std::sort(hits.begin() + firstHit, hits.end(),
+            [](const Hit& lhs, const Hit& rhs) { return lhs.t < rhs.t; });
+}
+
+void MeshBVH::castRays(Cr::Containers::ArrayView<const Ray> rays,
+                       float maxT,
+                       Cr::Containers::ArrayView<Hit> hits,
+                       int numThreads) const {
+  CORRADE_ASSERT(hits.size() == rays.size(),
+                 "MeshBVH::castRays: expected" << rays.size() << "hits, got"
+                                               << hits.size(), );
+  core::TaskScheduler::global().parallelForRanges(
+      rays.size(), numThreads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          castRay(rays[i].origin, rays[i].direction, maxT, hits[i]);
+        }
+      });
+}
+
+}  // namespace geo
+}  // namespace esp
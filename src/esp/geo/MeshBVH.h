@@ -0,0 +1,146 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GEO_MESHBVH_H_
+#define ESP_GEO_MESHBVH_H_
+
+/** @file
+ * @brief Class @ref esp::geo::MeshBVH
+ */
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "esp/core/esp.h"
+#include "esp/geo/geo.h"
+
+namespace esp {
+namespace geo {
+
+/**
+ * @brief A bounding volume hierarchy over the triangles of a mesh, for
+ * casting rays without a physics simulator
+ *
+ * Built once by splitting the triangles at the median of their centroids
+ * along the longest axis of their bounds. Each leaf holds up to four
+ * triangles packed as structure of arrays, with their first corner and edges
+ * precomputed, which are intersected in one loop the compiler vectorizes.
+ * Nodes are stored depth first, the left child of a node following it, and
+ * traversed nearest child first.
+ */
+class MeshBVH {
+ public:
+  //! The triangle index of a ray that hit nothing
+  static constexpr uint32_t NoTriangle = std::numeric_limits<uint32_t>::max();
+
+  /** @brief A ray hit of a triangle */
+  struct Hit {
+    //! The ray parameter, in units of the direction length.
+    float t = std::numeric_limits<float>::infinity();
+    //! The index of the triangle in the built vertices, @ref NoTriangle if
+    //! none was hit.
+    uint32_t triangle = NoTriangle;
+    //! The unit triangle normal, facing the ray origin.
+    Magnum::Vector3 normal;
+  };
+
+  /**
+   * @brief Build the hierarchy
+   * @param vertices The triangle corners, three per triangle
+   */
+  void build(std::vector<Magnum::Vector3> vertices);
+
+  /** @brief Remove all triangles */
+  void clear();
+
+  /** @brief The number of triangles */
+  size_t numTriangles() const { return numTriangles_; }
+
+  /** @brief The bounds of all triangles, empty without triangles */
+  Magnum::Range3D bounds() const {
+    return nodes_.empty() ? Magnum::Range3D{} : nodes_[0].bounds;
+  }
+
+  /**
+   * @brief Find the first triangle the ray from @p origin along
+   * @p direction hits within @p maxT
+   * @return Whether a triangle was hit, written to @p hit
+   */
+  bool castRay(const Magnum::Vector3& origin,
+               const Magnum::Vector3& direction,
+               float maxT,
+               Hit& hit) const;
+
+  /**
+   * @brief Append all hits of the ray from @p origin along @p direction
+   * within @p maxT to @p hits, sorted by distance
+   */
+  void castRayAll(const Magnum::Vector3& origin,
+                  const Magnum::Vector3& direction,
+                  float maxT,
+                  std::vector<Hit>& hits) const;
+
+  /**
+   * @brief The first hit of each of @p rays within @p maxT, cast on the
+   * threads of @ref core::TaskScheduler::global()
+   * @param rays The rays
+   * @param maxT The maximum distance along the ray directions
+   * @param[out] hits The hits, as many as @p rays. Misses have a
+   * @ref Hit::triangle of @ref NoTriangle.
+   * @param numThreads The most threads to cast on, all if 0 or less
+   */
+  void castRays(Corrade::Containers::ArrayView<const Ray> rays,
+                float maxT,
+                Corrade::Containers::ArrayView<Hit> hits,
+                int numThreads = 0) const;
+
+ private:
+  struct Node {
+    Magnum::Range3D bounds;
+    //! the first pack of a leaf, the right child of an inner node
+    uint32_t index;
+    //! the number of packs of a leaf, 0 for an inner node
+    uint16_t count;
+    //! the split axis of an inner node
+    uint16_t axis;
+  };
+
+  //! four triangles, unused lanes have zero edges and never hit
+  struct alignas(16) TrianglePack {
+    float v0[3][4];
+    float e1[3][4];
+    float e2[3][4];
+    uint32_t triangles[4];
+  };
+
+  //! the ray parameters of the lanes of @p pack hit before @p maxT, else
+  //! infinity
+  static void intersect(const TrianglePack& pack,
+                        const Magnum::Vector3& origin,
+                        const Magnum::Vector3& direction,
+                        float maxT,
+                        float (&t)[4]);
+
+  //! the unit normal of lane @p lane of @p pack facing against @p direction
+  static Magnum::Vector3 normal(const TrianglePack& pack,
+                                int lane,
+                                const Magnum::Vector3& direction);
+
+  std::vector<Node> nodes_;
+  std::vector<TrianglePack> packs_;
+  size_t numTriangles_ = 0;
+
+  ESP_SMART_POINTERS(MeshBVH)
+};
+
+}  // namespace geo
+}  // namespace esp
+
+#endif  // ESP_GEO_MESHBVH_H_
@@ -0,0 +1,128 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "OBBSet.h"
+
+#include <cmath>
+
+namespace esp {
+namespace geo {
+
+OBBSet::OBBSet(const std::vector<OBB>& boxes) {
+  for (const OBB& box : boxes) {
+    add(box);
+  }
+}
+
+void OBBSet::add(const OBB& box) {
+  const vec3f center = box.center();
+  const mat3f R = box.rotation().matrix();
+  const vec3f halfExtents = box.halfExtents();
+  cx_.push_back(center[0]);
+  cy_.push_back(center[1]);
+  cz_.push_back(center[2]);
+  a0x_.push_back(R(0, 0));
+  a0y_.push_back(R(1, 0));
+  a0z_.push_back(R(2, 0));
+  a1x_.push_back(R(0, 1));
+  a1y_.push_back(R(1, 1));
+  a1z_.push_back(R(2, 1));
+  a2x_.push_back(R(0, 2));
+  a2y_.push_back(R(1, 2));
+  a2z_.push_back(R(2, 2));
+  h0_.push_back(halfExtents[0]);
+  h1_.push_back(halfExtents[1]);
+  h2_.push_back(halfExtents[2]);
+}
+
+void OBBSet::clear() {
+  for (std::vector<float>* array :
+       {&cx_, &cy_, &cz_, &a0x_, &a0y_, &a0z_, &a1x_, &a1y_, &a1z_, &a2x_,
+        &a2y_, &a2z_, &h0_, &h1_, &h2_}) {
+    array->clear();
+  }
+}
+
+void OBBSet::contains(const vec3f& p,
+                      std::vector<uint8_t>& result,
+                      float epsilon /* = 1e-6f */) const {
+  const size_t n = size();
+  result.resize(n);
+  const float bound = 1.0f + epsilon;
+  for (size_t i = 0; i < n; ++i) {
+    const float dx = p[0] - cx_[i];
+    const float dy = p[1] - cy_[i];
+    const float dz = p[2] - cz_[i];
+    // coordinates in the frame of the box
+    const float d0 = a0x_[i] * dx + a0y_[i] * dy + a0z_[i] * dz;
+    const float d1 = a1x_[i] * dx + a1y_[i] * dy + a1z_[i] * dz;
+    const float d2 = a2x_[i] * dx + a2y_[i] * dy + a2z_[i] * dz;
+    result[i] = (std::abs(d0) <= h0_[i] * bound) &
+                (std::abs(d1) <= h1_[i] * bound) &
+                (std::abs(d2) <= h2_[i] * bound);
+  }
+}
+
+void OBBSet::distances(const vec3f& p, std::vector<float>& result) const {
+  const size_t n = size();
+  result.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    result[i] = distance(i, p);
+  }
+}
+
+float OBBSet::distance(size_t i, const vec3f& p) const {
+  const float dx = p[0] - cx_[i];
+  const float dy = p[1] - cy_[i];
+  const float dz = p[2] - cz_[i];
+  // how far the point is outside of each slab of the box, the axes are
+  // orthonormal so these are the offsets to the closest point
+  const float e0 = std::abs(a0x_[i] * dx + a0y_[i] * dy + a0z_[i] * dz);
+  const float e1 = std::abs(a1x_[i] * dx + a1y_[i] * dy + a1z_[i] * dz);
+  const float e2 = std::abs(a2x_[i] * dx + a2y_[i] * dy + a2z_[i] * dz);
+  const float o0 = e0 > h0_[i] ? e0 - h0_[i] : 0.0f;
+  const float o1 = e1 > h1_[i] ? e1 - h1_[i] : 0.0f;
+  const float o2 = e2 > h2_[i] ? e2 - h2_[i] : 0.0f;
+  return std::sqrt(o0 * o0 + o1 * o1 + o2 * o2);
+}
+
+void OBBSet::rayIntersections(const Ray& ray,
+                              std::vector<float>& result) const {
+  const size_t n = size();
+  result.resize(n);
+  const float ox = ray.origin.x();
+  const float oy = ray.origin.y();
+  const float oz = ray.origin.z();
+  const float vx = ray.direction.x();
+  const float vy = ray.direction.y();
+  const float vz = ray.direction.z();
+  for (size_t i = 0; i < n; ++i) {
+    const float dx = ox - cx_[i];
+    const float dy = oy - cy_[i];
+    const float dz = oz - cz_[i];
+    // slab test in the frame of the box, a direction parallel to a slab
+    // gives infinite ray parameters of the right sign
+    const float o0 = a0x_[i] * dx + a0y_[i] * dy + a0z_[i] * dz;
+    const float o1 = a1x_[i] * dx + a1y_[i] * dy + a1z_[i] * dz;
+    const float o2 = a2x_[i] * dx + a2y_[i] * dy + a2z_[i] * dz;
+    const float inv0 = 1.0f / (a0x_[i] * vx + a0y_[i] * vy + a0z_[i] * vz);
+    const float inv1 = 1.0f / (a1x_[i] * vx + a1y_[i] * vy + a1z_[i] * vz);
+    const float inv2 = 1.0f / (a2x_[i] * vx + a2y_[i] * vy + a2z_[i] * vz);
+    const float s0 = (-h0_[i] - o0) * inv0, t0 = (h0_[i] - o0) * inv0;
+    const float s1 = (-h1_[i] - o1) * inv1, t1 = (h1_[i] - o1) * inv1;
+    const float s2 = (-h2_[i] - o2) * inv2, t2 = (h2_[i] - o2) * inv2;
+    const float near0 = s0 < t0 ? s0 : t0, far0 = s0 < t0 ? t0 : s0;
+    const float near1 = s1 < t1 ? s1 : t1, far1 = s1 < t1 ? t1 : s1;
+    const float near2 = s2 < t2 ? s2 : t2, far2 = s2 < t2 ? t2 : s2;
+    float tNear = near0 > near1 ? near0 : near1;
+    tNear = tNear > near2 ? tNear : near2;
+    tNear = tNear > 0.0f ? tNear : 0.0f;
+    float tFar = far0 < far1 ? far0 : far1;
+    tFar = tFar < far2 ? tFar : far2;
+    result[i] = tFar >= tNear ? tNear : -1.0f;
+  }
+}
+
+}  // namespace geo
+}  // namespace esp
@@ -0,0 +1,89 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GEO_OBBSET_H_
+#define ESP_GEO_OBBSET_H_
+
+/** @file
+ * @brief Class @ref esp::geo::OBBSet
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/geo/OBB.h"
+#include "esp/geo/geo.h"
+
+namespace esp {
+namespace geo {
+
+/**
+ * @brief A set of oriented bounding boxes, stored as a structure of arrays
+ * for testing many boxes against a point or a ray at once
+ *
+ * Each box is kept as its center, the three unit axes of its frame and its
+ * half extents along them, one array per coordinate. The batch queries are
+ * branch-free loops over these arrays, which the compiler vectorizes, and
+ * give the same results as the corresponding functions of @ref OBB.
+ */
+class OBBSet {
+ public:
+  /** @brief Constructor */
+  explicit OBBSet(const std::vector<OBB>& boxes = {});
+
+  /** @brief Append a box */
+  void add(const OBB& box);
+
+  /** @brief Remove all boxes */
+  void clear();
+
+  /** @brief The number of boxes */
+  size_t size() const { return cx_.size(); }
+
+  /**
+   * @brief Whether each box contains @p p, see @ref OBB::contains()
+   * @param[out] result Set to 1 for the boxes containing the point and 0 for
+   * the others, resized to @ref size()
+   */
+  void contains(const vec3f& p,
+                std::vector<uint8_t>& result,
+                float epsilon = 1e-6f) const;
+
+  /**
+   * @brief The distance of @p p to each box, see @ref OBB::distance()
+   * @param[out] result The distances, 0 for the boxes containing the point,
+   * resized to @ref size()
+   */
+  void distances(const vec3f& p, std::vector<float>& result) const;
+
+  /** @brief The distance of @p p to box @p i, see @ref OBB::distance() */
+  float distance(size_t i, const vec3f& p) const;
+
+  /**
+   * @brief Intersect @p ray with each box
+   * @param[out] result For each box, the ray parameter of the first point of
+   * the box along the ray, in units of the direction length, 0 if the origin
+   * is inside of it, and a negative value if the ray misses it. Resized to
+   * @ref size().
+   */
+  void rayIntersections(const Ray& ray, std::vector<float>& result) const;
+
+ protected:
+  // centers
+  std::vector<float> cx_, cy_, cz_;
+  // the unit axes of the box frames, aix_ to aiz_ are those of axis i
+  std::vector<float> a0x_, a0y_, a0z_;
+  std::vector<float> a1x_, a1y_, a1z_;
+  std::vector<float> a2x_, a2y_, a2z_;
+  // half extents along the axes
+  std::vector<float> h0_, h1_, h2_;
+
+  ESP_SMART_POINTERS(OBBSet)
+};
+
+}  // namespace geo
+}  // namespace esp
+
+#endif  // ESP_GEO_OBBSET_H_
@@ -0,0 +1,119 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PoseConversion.h"
+
+#include <cmath>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace geo {
+
+void rotationMatricesFromQuaternions(
+    Cr::Containers::ArrayView<const Mn::Quaternion> quaternions,
+    Cr::Containers::ArrayView<Mn::Matrix3x3> matrices) {
+  CORRADE_ASSERT(matrices.size() == quaternions.size(),
+                 "geo::rotationMatricesFromQuaternions(): expected"
+                     << quaternions.size() << "matrices, got"
+                     << matrices.size(), );
+  for (size_t i = 0; i != quaternions.size(); ++i) {
+    const float x = quaternions[i].vector().x();
+    const float y = quaternions[i].vector().y();
+    const float z = quaternions[i].vector().z();
+    const float w = quaternions[i].scalar();
+    Mn::Matrix3x3& m = matrices[i];
+    m[0][0] = 1.0f - 2.0f * (y * y + z * z);
+    m[0][1] = 2.0f * (x * y + w * z);
+    m[0][2] = 2.0f * (x * z - w * y);
+    m[1][0] = 2.0f * (x * y - w * z);
+    m[1][1] = 1.0f - 2.0f * (x * x + z * z);
+    m[1][2] = 2.0f * (y * z + w * x);
+    m[2][0] = 2.0f * (x * z + w * y);
+    m[2][1] = 2.0f * (y * z - w * x);
+    m[2][2] = 1.0f - 2.0f * (x * x + y * y);
+  }
+}
+
+void quaternionsFromRotationMatrices(
+    Cr::Containers::ArrayView<const Mn::Matrix3x3> matrices,
+    Cr::Containers::ArrayView<Mn::Quaternion> quaternions) {
+  CORRADE_ASSERT(quaternions.size() == matrices.size(),
+                 "geo::quaternionsFromRotationMatrices(): expected"
+                     << matrices.size() << "quaternions, got"
+                     << quaternions.size(), );
+  for (size_t i = 0; i != matrices.size(); ++i) {
+    // m[column][row], the largest of the four terms gives the most precision
+    const Mn::Matrix3x3& m = matrices[i];
+    const float trace = m[0][0] + m[1][1] + m[2][2];
+    float x, y, z, w;
+    if (trace > 0.0f) {
+      const float s = 0.5f / std::sqrt(trace + 1.0f);
+      w = 0.25f / s;
+      x = (m[1][2] - m[2][1]) * s;
+      y = (m[2][0] - m[0][2]) * s;
+      z = (m[0][1] - m[1][0]) * s;
+    } else if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+      const float s = 2.0f * std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]);
+      w = (m[1][2] - m[2][1]) / s;
+      x = 0.25f * s;
+      y = (m[1][0] + m[0][1]) / s;
+      z = (m[2][0] + m[0][2]) / s;
+    } else if (m[1][1] > m[2][2]) {
+      const float s = 2.0f * std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]);
+      w = (m[2][0] - m[0][2]) / s;
+      x = (m[1][0] + m[0][1]) / s;
+      y = 0.25f * s;
+      z = (m[2][1] + m[1][2]) / s;
+    } else {
+      const float s = 2.0f * std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]);
+      w = (m[0][1] - m[1][0]) / s;
+      x = (m[2][0] + m[0][2]) / s;
+      y = (m[2][1] + m[1][2]) / s;
+      z = 0.25f * s;
+    }
+    quaternions[i] = Mn::Quaternion{{x, y, z}, w};
+  }
+}
+
+void rotateQuaternions(
+    const Mn::Quaternion& rotation,
+    Cr::Containers::ArrayView<const Mn::Quaternion> rotations,
+    Cr::Containers::ArrayView<Mn::Quaternion> result) {
+  CORRADE_ASSERT(result.size() == rotations.size(),
+                 "geo::rotateQuaternions(): expected"
+                     << rotations.size() << "results, got" << result.size(), );
+  const float ax = rotation.vector().x();
+  const float ay = rotation.vector().y();
+  const float az = rotation.vector().z();
+  const float aw = rotation.scalar();
+  for (size_t i = 0; i != rotations.size(); ++i) {
+    const float bx = rotations[i].vector().x();
+    const float by = rotations[i].vector().y();
+    const float bz = rotations[i].vector().z();
+    const float bw = rotations[i].scalar();
+    result[i] = Mn::Quaternion{{aw * bx + ax * bw + ay * bz - az * by,
+                                aw * by - ax * bz + ay * bw + az * bx,
+                                aw * bz + ax * by - ay * bx + az * bw},
+                               aw * bw - ax * bx - ay * by - az * bz};
+  }
+}
+
+void transformPoints(const Mn::Matrix3x3& rotation,
+                     const Mn::Vector3& translation,
+                     Cr::Containers::ArrayView<const Mn::Vector3> points,
+                     Cr::Containers::ArrayView<Mn::Vector3> result) {
+  CORRADE_ASSERT(result.size() == points.size(),
+                 "geo::transformPoints(): expected"
+                     << points.size() << "results, got" << result.size(), );
+  for (size_t i = 0; i != points.size(); ++i) {
+    const Mn::Vector3 p = points[i];
+    result[i] = rotation[0] * p.x() + rotation[1] * p.y() +
+                rotation[2] * p.z() + translation;
+  }
+}
+
+}  // namespace geo
+}  // namespace esp
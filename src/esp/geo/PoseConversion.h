@@ -0,0 +1,67 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GEO_POSECONVERSION_H_
+#define ESP_GEO_POSECONVERSION_H_
+
+/** @file
+ * @brief Functions @ref esp::geo::rotationMatricesFromQuaternions(),
+ * @ref esp::geo::quaternionsFromRotationMatrices(),
+ * @ref esp::geo::rotateQuaternions(), @ref esp::geo::transformPoints()
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Math/Matrix3.h>
+#include <Magnum/Math/Quaternion.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace geo {
+
+/**
+ * @brief The rotation matrix of each unit quaternion
+ *
+ * The same as @ref Magnum::Quaternion::toMatrix() for each of them, in a loop
+ * the compiler vectorizes. Expects @p matrices to be as large as
+ * @p quaternions, which they can alias through a reinterpreted buffer.
+ */
+void rotationMatricesFromQuaternions(
+    Corrade::Containers::ArrayView<const Magnum::Quaternion> quaternions,
+    Corrade::Containers::ArrayView<Magnum::Matrix3x3> matrices);
+
+/**
+ * @brief The unit quaternion of each rotation matrix
+ *
+ * The same as @ref Magnum::Quaternion::fromMatrix(), without its checks
+ * that the matrices are orthogonal. Expects @p quaternions to be as large as
+ * @p matrices.
+ */
+void quaternionsFromRotationMatrices(
+    Corrade::Containers::ArrayView<const Magnum::Matrix3x3> matrices,
+    Corrade::Containers::ArrayView<Magnum::Quaternion> quaternions);
+
+/**
+ * @brief Rotate each of @p rotations by @p rotation, i.e. set them to
+ * @p rotation * rotations[i]. The arrays can be the same.
+ */
+void rotateQuaternions(
+    const Magnum::Quaternion& rotation,
+    Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations,
+    Corrade::Containers::ArrayView<Magnum::Quaternion> result);
+
+/**
+ * @brief Transform each of @p points by @p rotation and then @p translation.
+ * The arrays can be the same.
+ */
+void transformPoints(
+    const Magnum::Matrix3x3& rotation,
+    const Magnum::Vector3& translation,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> points,
+    Corrade::Containers::ArrayView<Magnum::Vector3> result);
+
+}  // namespace geo
+}  // namespace esp
+
+#endif  // ESP_GEO_POSECONVERSION_H_
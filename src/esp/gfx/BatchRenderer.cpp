@@ -0,0 +1,237 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "BatchRenderer.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/PixelFormat.h>
+#include <Magnum/GL/Renderbuffer.h>
+#include <Magnum/GL/RenderbufferFormat.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/PixelFormat.h>
+
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/scene/SceneGraph.h"
+#include "esp/sensor/VisualSensor.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+const Mn::GL::Framebuffer::ColorAttachment RgbaBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment ObjectIdBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{1};
+
+//! lay the tiles out as close to a square as possible
+Mn::Vector2i computeTileGridSize(int numTiles) {
+  const int columns =
+      static_cast<int>(std::ceil(std::sqrt(static_cast<float>(numTiles))));
+  const int rows = (numTiles + columns - 1) / columns;
+  return {columns, rows};
+}
+}  // namespace
+
+struct BatchRenderer::Impl {
+  Impl(Renderer::ptr renderer, const Mn::Vector2i& tileSize, int numTiles)
+      : renderer_{std::move(renderer)},
+        tileSize_{tileSize},
+        numTiles_{numTiles},
+        tileGridSize_{computeTileGridSize(numTiles)},
+        depthUnprojections_(numTiles, Mn::Vector2{}),
+        framebuffer_{Mn::NoCreate} {
+    CORRADE_ASSERT(renderer_ != nullptr,
+                   "BatchRenderer::BatchRenderer(): renderer is null", );
+    CORRADE_ASSERT(numTiles_ > 0,
+                   "BatchRenderer::BatchRenderer(): expected at least one tile",
+                   );
+
+    const Mn::Vector2i size = tileSize_ * tileGridSize_;
+    if ((size > Mn::GL::AbstractFramebuffer::maxViewportSize()).any()) {
+      throw std::runtime_error(
+          "BatchRenderer: batch framebuffer exceeds the maximum viewport "
+          "size, reduce the number of tiles or the tile size");
+    }
+
+    colorBuffer_.setStorage(Mn::GL::RenderbufferFormat::SRGB8Alpha8, size);
+    objectIdBuffer_.setStorage(Mn::GL::RenderbufferFormat::R32UI, size);
+    depthRenderTexture_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+        .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+        .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+        .setStorage(1, Mn::GL::TextureFormat::DepthComponent32F, size);
+
+    framebuffer_ = Mn::GL::Framebuffer{{{}, size}};
+    framebuffer_.attachRenderbuffer(RgbaBuffer, colorBuffer_)
+        .attachRenderbuffer(ObjectIdBuffer, objectIdBuffer_)
+        .attachTexture(Mn::GL::Framebuffer::BufferAttachment::Depth,
+                       depthRenderTexture_, 0)
+        .mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+    CORRADE_INTERNAL_ASSERT(
+        framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+        Mn::GL::Framebuffer::Status::Complete);
+  }
+
+  Mn::Range2Di tileViewport(int tile) const {
+    CORRADE_ASSERT(tile >= 0 && tile < numTiles_,
+                   "BatchRenderer::tileViewport(): tile" << tile
+                                                         << "out of range",
+                   {});
+    const Mn::Vector2i min{(tile % tileGridSize_.x()) * tileSize_.x(),
+                           (tile / tileGridSize_.x()) * tileSize_.y()};
+    return Mn::Range2Di::fromSize(min, tileSize_);
+  }
+
+  void renderEnter() {
+    framebuffer_.setViewport({{}, framebufferSize()});
+    framebuffer_.clearDepth(1.0);
+    framebuffer_.clearColor(0, Mn::Color4{0, 0, 0, 1});
+    framebuffer_.clearColor(1, Mn::Vector4ui{});
+    framebuffer_.bind();
+  }
+
+  void drawTile(int tile,
+                sensor::VisualSensor& visualSensor,
+                scene::SceneGraph& sceneGraph,
+                RenderCamera::Flags flags) {
+    // the tile comes from the caller and indexes depthUnprojections_
+    if (tile < 0 || tile >= numTiles_) {
+      throw std::out_of_range("BatchRenderer::drawTile: tile " +
+                              std::to_string(tile) + " out of range for " +
+                              std::to_string(numTiles_) + " tiles");
+    }
+    if (visualSensor.framebufferSize() != tileSize_) {
+      throw std::runtime_error(
+          "BatchRenderer::drawTile: sensor resolution does not match the "
+          "tile size");
+    }
+
+    auto depthUnprojection = visualSensor.depthUnprojection();
+    if (depthUnprojection) {
+      depthUnprojections_[tile] = *depthUnprojection;
+    }
+
+    // the framebuffer is bound, so this updates the GL viewport immediately
+    framebuffer_.setViewport(tileViewport(tile));
+    renderer_->draw(visualSensor, sceneGraph, flags);
+  }
+
+  void renderExit() { framebuffer_.setViewport({{}, framebufferSize()}); }
+
+  void readFrameRgba(const Mn::MutableImageView2D& view) {
+    if (renderer_->flags() & Renderer::Flag::NoTextures)
+      throw std::runtime_error(
+          "Simulator was initialized with requiresTextures = false");
+
+    framebuffer_.mapForRead(RgbaBuffer).read(framebuffer_.viewport(), view);
+  }
+
+  void readFrameDepth(const Mn::MutableImageView2D& view) {
+    Mn::MutableImageView2D depthBufferView{
+        Mn::GL::PixelFormat::DepthComponent, Mn::GL::PixelType::Float,
+        view.size(), view.data()};
+    framebuffer_.read(framebuffer_.viewport(), depthBufferView);
+
+    // each tile has its own projection, so unproject one tile row at a time
+    auto depth = Cr::Containers::arrayCast<Mn::Float>(view.data());
+    const int width = framebufferSize().x();
+    for (int tile = 0; tile < numTiles_; ++tile) {
+      const Mn::Range2Di viewport = tileViewport(tile);
+      for (int y = viewport.min().y(); y < viewport.max().y(); ++y) {
+        unprojectDepth(depthUnprojections_[tile],
+                       depth.slice(y * width + viewport.min().x(),
+                                   y * width + viewport.max().x()));
+      }
+    }
+  }
+
+  void readFrameObjectId(const Mn::MutableImageView2D& view) {
+    framebuffer_.mapForRead(ObjectIdBuffer).read(framebuffer_.viewport(), view);
+  }
+
+  Mn::Vector2i framebufferSize() const { return tileSize_ * tileGridSize_; }
+
+  int numTiles() const { return numTiles_; }
+  Mn::Vector2i tileSize() const { return tileSize_; }
+  Mn::Vector2i tileGridSize() const { return tileGridSize_; }
+
+ private:
+  Renderer::ptr renderer_;
+  const Mn::Vector2i tileSize_;
+  const int numTiles_;
+  const Mn::Vector2i tileGridSize_;
+  std::vector<Mn::Vector2> depthUnprojections_;
+
+  Mn::GL::Renderbuffer colorBuffer_;
+  Mn::GL::Renderbuffer objectIdBuffer_;
+  Mn::GL::Texture2D depthRenderTexture_;
+  Mn::GL::Framebuffer framebuffer_;
+};
+
+BatchRenderer::BatchRenderer(Renderer::ptr renderer,
+                             const Mn::Vector2i& tileSize,
+                             int numTiles)
+    : pimpl_(spimpl::make_unique_impl<Impl>(std::move(renderer),
+                                            tileSize,
+                                            numTiles)) {}
+
+int BatchRenderer::numTiles() const {
+  return pimpl_->numTiles();
+}
+
+Mn::Vector2i BatchRenderer::tileSize() const {
+  return pimpl_->tileSize();
+}
+
+Mn::Vector2i BatchRenderer::tileGridSize() const {
+  return pimpl_->tileGridSize();
+}
+
+Mn::Vector2i BatchRenderer::framebufferSize() const {
+  return pimpl_->framebufferSize();
+}
+
+Mn::Range2Di BatchRenderer::tileViewport(int tile) const {
+  return pimpl_->tileViewport(tile);
+}
+
+void BatchRenderer::renderEnter() {
+  pimpl_->renderEnter();
+}
+
+void BatchRenderer::drawTile(int tile,
+                             sensor::VisualSensor& visualSensor,
+                             scene::SceneGraph& sceneGraph,
+                             RenderCamera::Flags flags) {
+  pimpl_->drawTile(tile, visualSensor, sceneGraph, flags);
+}
+
+void BatchRenderer::renderExit() {
+  pimpl_->renderExit();
+}
+
+void BatchRenderer::readFrameRgba(const Mn::MutableImageView2D& view) {
+  pimpl_->readFrameRgba(view);
+}
+
+void BatchRenderer::readFrameDepth(const Mn::MutableImageView2D& view) {
+  pimpl_->readFrameDepth(view);
+}
+
+void BatchRenderer::readFrameObjectId(const Mn::MutableImageView2D& view) {
+  pimpl_->readFrameObjectId(view);
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,154 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_BATCHRENDERER_H_
+#define ESP_GFX_BATCHRENDERER_H_
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Range.h>
+
+#include "esp/core/esp.h"
+
+#include "esp/gfx/RenderCamera.h"
+#include "esp/gfx/Renderer.h"
+
+namespace esp {
+namespace scene {
+class SceneGraph;
+}
+namespace sensor {
+class VisualSensor;
+}
+
+namespace gfx {
+
+/**
+ * @brief Renders many environments / sensors into the tiles of a single large
+ * framebuffer.
+ *
+ * Instead of binding, clearing and reading back one @ref RenderTarget per
+ * sensor, all sensors of a batch share one framebuffer which is laid out as a
+ * grid of equally sized tiles. The framebuffer is cleared and bound once in
+ * @ref renderEnter(), each sensor is drawn into its tile with @ref drawTile()
+ * and the results of the whole batch are retrieved with a single read in
+ * @ref readFrameRgba(), @ref readFrameDepth() or @ref readFrameObjectId().
+ *
+ * Tile @p i occupies the pixel range returned by @ref tileViewport(). The
+ * read functions return the full framebuffer, so tile @p i of an image of
+ * size @ref framebufferSize() starts at row
+ * `(i / tileGridSize().x()) * tileSize().y()` and column
+ * `(i % tileGridSize().x()) * tileSize().x()`.
+ */
+class BatchRenderer {
+ public:
+  /**
+   * @brief Constructor
+   * @param renderer  The renderer used to draw the scene graphs
+   * @param tileSize  The size of a single tile in WxH. Every sensor drawn
+   *                  with @ref drawTile() must have this framebuffer size.
+   * @param numTiles  The number of tiles (i.e. sensors) in the batch
+   */
+  BatchRenderer(Renderer::ptr renderer,
+                const Magnum::Vector2i& tileSize,
+                int numTiles);
+
+  ~BatchRenderer() { LOG(INFO) << "Deconstructing BatchRenderer"; }
+
+  /**
+   * @brief The number of tiles in the batch
+   */
+  int numTiles() const;
+
+  /**
+   * @brief The size of a single tile in WxH
+   */
+  Magnum::Vector2i tileSize() const;
+
+  /**
+   * @brief The number of tiles along each axis of the framebuffer
+   */
+  Magnum::Vector2i tileGridSize() const;
+
+  /**
+   * @brief The size of the whole batch framebuffer in WxH
+   */
+  Magnum::Vector2i framebufferSize() const;
+
+  /**
+   * @brief The pixel range covered by a tile in the batch framebuffer
+   */
+  Magnum::Range2Di tileViewport(int tile) const;
+
+  /**
+   * @brief Called before any @ref drawTile() call of a batch. Clears the whole
+   * framebuffer and binds it.
+   */
+  void renderEnter();
+
+  /**
+   * @brief Draw a scene graph with a visual sensor into a tile
+   *
+   * May only be called between @ref renderEnter() and @ref renderExit(). The
+   * same scene graph may be drawn into several tiles (e.g. by several sensors
+   * of one agent).
+   *
+   * @param tile         The tile to draw into, in range [0, @ref numTiles())
+   * @param visualSensor The sensor providing camera pose and projection
+   * @param sceneGraph   The scene graph to draw
+   * @param flags        The flags passed to @ref RenderCamera::draw()
+   * @throw std::out_of_range If @p tile is out of range
+   * @throw std::runtime_error If the sensor resolution is not the tile size
+   */
+  void drawTile(int tile,
+                sensor::VisualSensor& visualSensor,
+                scene::SceneGraph& sceneGraph,
+                RenderCamera::Flags flags = {
+                    RenderCamera::Flag::FrustumCulling});
+
+  /**
+   * @brief Called after all @ref drawTile() calls of a batch. Restores the
+   * full-framebuffer viewport so that the batch can be read back.
+   */
+  void renderExit();
+
+  /**
+   * @brief Retrieve the RGBA rendering results of all tiles.
+   *
+   * @param[in, out] view Preallocated memory of @ref framebufferSize() that
+   * will be populated with the result.
+   */
+  void readFrameRgba(const Magnum::MutableImageView2D& view);
+
+  /**
+   * @brief Retrieve the depth rendering results of all tiles.
+   *
+   * Depth of every tile is unprojected with the depth unprojection parameters
+   * of the sensor that was last drawn into it.
+   *
+   * @param[in, out] view Preallocated memory of @ref framebufferSize(). The
+   * PixelFormat of the image must only specify the R channel, generally @ref
+   * Magnum::PixelFormat::R32F
+   */
+  void readFrameDepth(const Magnum::MutableImageView2D& view);
+
+  /**
+   * @brief Retrieve the ObjectID rendering results of all tiles.
+   *
+   * @param[in, out] view Preallocated memory of @ref framebufferSize(). See
+   * @ref RenderTarget::readFrameObjectId() for allowed pixel formats.
+   */
+  void readFrameObjectId(const Magnum::MutableImageView2D& view);
+
+  // @brief Delete copy Constructor
+  BatchRenderer(const BatchRenderer&) = delete;
+  // @brief Delete copy operator
+  BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(BatchRenderer)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_BATCHRENDERER_H_
@@ -0,0 +1,206 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CullingBVH.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+constexpr uint32_t CullingBVH::MaxLeafSize;
+
+namespace {
+
+//! all six frustum planes still need to be tested
+constexpr uint8_t AllPlanes = 0x3f;
+
+/**
+ * @brief test a range against the frustum planes in @p planeMask, starting
+ * with the plane which culled it last time
+ * @param[in, out] planeMask, on input the planes to test, on output the
+ * planes the range is not entirely inside of
+ * @param[in, out] frustumPlaneIndex, set to the culling plane if culled
+ * @return true if the range is entirely outside of one of the planes
+ */
+bool cullRange(const Mn::Range3D& range,
+               const Mn::Frustum& frustum,
+               uint8_t& planeMask,
+               int& frustumPlaneIndex) {
+  const Mn::Vector3 center = range.min() + range.max();
+  const Mn::Vector3 extent = range.max() - range.min();
+
+  for (int iPlane = 0; iPlane < 6; ++iPlane) {
+    const int index = (iPlane + frustumPlaneIndex) % 6;
+    if (!(planeMask & (1 << index))) {
+      continue;
+    }
+    const Mn::Vector4& plane = frustum[index];
+
+    const float d = Mn::Math::dot(center, plane.xyz());
+    const float r = Mn::Math::dot(extent, Mn::Math::abs(plane.xyz()));
+    if (d + r < -2.0f * plane.w()) {
+      frustumPlaneIndex = index;
+      return true;
+    }
+    if (d - r >= -2.0f * plane.w()) {
+      // entirely on the inner side, children need not test this plane
+      planeMask &= ~(1 << index);
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+CullingBVH::CullingBVH(std::vector<Mn::Range3D> itemBounds) {
+  build(std::move(itemBounds));
+}
+
+void CullingBVH::build(std::vector<Mn::Range3D> itemBounds) {
+  itemBounds_ = std::move(itemBounds);
+  itemFrustumPlaneIndices_.assign(itemBounds_.size(), 0);
+  order_.resize(itemBounds_.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  nodes_.clear();
+  if (!itemBounds_.empty()) {
+    // a binary tree with n leaves has 2n - 1 nodes
+    nodes_.reserve(2 * (itemBounds_.size() / MaxLeafSize + 1));
+    buildNode(0, itemBounds_.size());
+  }
+}
+
+uint32_t CullingBVH::buildNode(uint32_t begin, uint32_t end) {
+  const uint32_t nodeIndex = nodes_.size();
+  nodes_.emplace_back();
+
+  Mn::Range3D bounds = itemBounds_[order_[begin]];
+  Mn::Range3D centroidBounds{bounds.center(), bounds.center()};
+  for (uint32_t i = begin + 1; i < end; ++i) {
+    const Mn::Range3D& itemBounds = itemBounds_[order_[i]];
+    bounds = Mn::Math::join(bounds, itemBounds);
+    centroidBounds = Mn::Math::join(
+        centroidBounds, Mn::Range3D{itemBounds.center(), itemBounds.center()});
+  }
+
+  uint32_t rightChild = 0;
+  if (end - begin > MaxLeafSize) {
+    // median split along the axis the item centers are spread the most
+    const Mn::Vector3 spread = centroidBounds.size();
+    int axis = 0;
+    if (spread[1] > spread[axis])
+      axis = 1;
+    if (spread[2] > spread[axis])
+      axis = 2;
+
+    const uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(order_.begin() + begin, order_.begin() + mid,
+                     order_.begin() + end, [&](uint32_t a, uint32_t b) {
+                       return itemBounds_[a].center()[axis] <
+                              itemBounds_[b].center()[axis];
+                     });
+    buildNode(begin, mid);
+    rightChild = buildNode(mid, end);
+  }
+
+  // nodes_ may have been reallocated by the recursion
+  nodes_[nodeIndex] = Node{bounds, begin, end, rightChild, 0};
+  return nodeIndex;
+}
+
+Mn::Range3D CullingBVH::bounds() const {
+  return nodes_.empty() ? Mn::Range3D{} : nodes_[0].bounds;
+}
+
+size_t CullingBVH::cull(const Mn::Frustum& frustum,
+                        std::vector<uint32_t>& visibleItems) {
+  const size_t numVisibleBefore = visibleItems.size();
+  if (nodes_.empty()) {
+    return 0;
+  }
+
+  // pairs of node index and the frustum planes it still has to be tested
+  // against; the depth of a median split tree is logarithmic
+  std::vector<std::pair<uint32_t, uint8_t>> stack;
+  stack.reserve(64);
+  stack.emplace_back(0, AllPlanes);
+
+  while (!stack.empty()) {
+    const uint32_t nodeIndex = stack.back().first;
+    uint8_t planeMask = stack.back().second;
+    stack.pop_back();
+
+    Node& node = nodes_[nodeIndex];
+    if (cullRange(node.bounds, frustum, planeMask, node.frustumPlaneIndex)) {
+      continue;
+    }
+
+    if (planeMask == 0) {
+      // entirely inside of the frustum, accept the whole subtree
+      visibleItems.insert(visibleItems.end(), order_.begin() + node.begin,
+                          order_.begin() + node.end);
+    } else if (node.rightChild == 0) {
+      for (uint32_t i = node.begin; i < node.end; ++i) {
+        const uint32_t item = order_[i];
+        uint8_t itemPlaneMask = planeMask;
+        if (!cullRange(itemBounds_[item], frustum, itemPlaneMask,
+                       itemFrustumPlaneIndices_[item])) {
+          visibleItems.push_back(item);
+        }
+      }
+    } else {
+      stack.emplace_back(node.rightChild, planeMask);
+      stack.emplace_back(nodeIndex + 1, planeMask);
+    }
+  }
+
+  return visibleItems.size() - numVisibleBefore;
+}
+
+size_t CullingBVH::overlap(const Mn::Range3D& range,
+                           std::vector<uint32_t>& items) const {
+  const size_t numItemsBefore = items.size();
+  if (nodes_.empty()) {
+    return 0;
+  }
+
+  auto overlaps = [&](const Mn::Range3D& bounds) {
+    return (bounds.min() <= range.max()).all() &&
+           (range.min() <= bounds.max()).all();
+  };
+
+  std::vector<uint32_t> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const uint32_t nodeIndex = stack.back();
+    stack.pop_back();
+
+    const Node& node = nodes_[nodeIndex];
+    if (!overlaps(node.bounds)) {
+      continue;
+    }
+    if (node.rightChild == 0) {
+      for (uint32_t i = node.begin; i < node.end; ++i) {
+        if (overlaps(itemBounds_[order_[i]])) {
+          items.push_back(order_[i]);
+        }
+      }
+    } else {
+      stack.push_back(node.rightChild);
+      stack.push_back(nodeIndex + 1);
+    }
+  }
+
+  return items.size() - numItemsBefore;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,110 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_CULLINGBVH_H_
+#define ESP_GFX_CULLINGBVH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Range.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Bounding volume hierarchy over a static set of axis-aligned bounding
+ * boxes, used to frustum cull them hierarchically.
+ *
+ * A subtree that is completely outside of the frustum is culled with a single
+ * test, and a subtree that is completely inside of it is accepted without
+ * testing any of its boxes. Every BVH node remembers the frustum plane that
+ * culled it in the last query (temporal coherence, as in @ref
+ * scene::SceneNode::getFrustumPlaneIndex()), and planes a parent is fully
+ * inside of are not tested again for its children.
+ */
+class CullingBVH {
+ public:
+  /**
+   * @brief Constructor
+   * @param itemBounds The boxes to build the hierarchy over. Item @p i of
+   * @ref cull() results refers to `itemBounds[i]`.
+   */
+  explicit CullingBVH(std::vector<Magnum::Range3D> itemBounds = {});
+
+  /**
+   * @brief Rebuild the hierarchy over a new set of boxes
+   */
+  void build(std::vector<Magnum::Range3D> itemBounds);
+
+  /**
+   * @brief The number of boxes in the hierarchy
+   */
+  size_t size() const { return itemBounds_.size(); }
+
+  /**
+   * @brief The number of nodes of the hierarchy
+   */
+  size_t nodeCount() const { return nodes_.size(); }
+
+  /**
+   * @brief The bounds of all boxes in the hierarchy
+   */
+  Magnum::Range3D bounds() const;
+
+  /**
+   * @brief Collect the boxes which intersect a frustum
+   * @param frustum The frustum in the same space as the boxes
+   * @param[out] visibleItems Indices of the boxes which are not culled are
+   * appended here, in no particular order
+   * @return The number of appended indices
+   */
+  size_t cull(const Magnum::Frustum& frustum,
+              std::vector<uint32_t>& visibleItems);
+
+  /**
+   * @brief Collect the boxes which overlap a box
+   * @param range The box in the same space as the boxes
+   * @param[out] items Indices of the overlapping boxes are appended here, in
+   * no particular order. Boxes touching @p range count as overlapping.
+   * @return The number of appended indices
+   *
+   * Unlike @ref cull(), this doesn't update any state, so it can be used for
+   * spatial queries that are unrelated to rendering.
+   */
+  size_t overlap(const Magnum::Range3D& range,
+                 std::vector<uint32_t>& items) const;
+
+  /** @brief The maximal number of boxes in a leaf node */
+  static constexpr uint32_t MaxLeafSize = 4;
+
+ protected:
+  struct Node {
+    Magnum::Range3D bounds;
+    // the items of the subtree are order_[begin, end)
+    uint32_t begin;
+    uint32_t end;
+    // the left child immediately follows its parent, 0 marks a leaf
+    uint32_t rightChild;
+    int frustumPlaneIndex;
+  };
+
+  uint32_t buildNode(uint32_t begin, uint32_t end);
+
+  std::vector<Magnum::Range3D> itemBounds_;
+  std::vector<int> itemFrustumPlaneIndices_;
+  std::vector<uint32_t> order_;
+  std::vector<Node> nodes_;
+
+  ESP_SMART_POINTERS(CullingBVH)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_CULLINGBVH_H_
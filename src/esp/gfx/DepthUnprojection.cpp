@@ -6,12 +6,34 @@
 
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/FormatStl.h>
 #include <Corrade/Utility/Resource.h>
 #include <Magnum/GL/Shader.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/Version.h>
 #include <Magnum/Math/Functions.h>
 #include <Magnum/Math/Matrix4.h>
+#include <Magnum/Shaders/Generic.h>
+
+#include "ShaderManager.h"
+#include "esp/core/Profiling.h"
+
+#if defined(CORRADE_TARGET_X86) && defined(__SSE2__)
+#define ESP_DEPTH_UNPROJECTION_SSE2
+#include <emmintrin.h>
+#endif
+/* Only GCC and Clang can compile a function for a target the whole file isn't
+   compiled for and check the CPU for it */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__)
+#define ESP_DEPTH_UNPROJECTION_AVX2
+#include <immintrin.h>
+#endif
+/* The vector division is AArch64-only */
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define ESP_DEPTH_UNPROJECTION_NEON
+#include <arm_neon.h>
+#endif
 
 namespace Cr = Corrade;
 namespace Mn = Magnum;
@@ -28,6 +50,7 @@ enum { DepthTextureUnit = 1 };
 }
 
 DepthShader::DepthShader(Flags flags) : flags_{flags} {
+  core::ScopedTimer timer{core::ProfilingStage::ShaderCompilation};
   if (!Corrade::Utility::Resource::hasGroup("default-shaders")) {
     importShaderResources();
   }
@@ -51,14 +74,52 @@ DepthShader::DepthShader(Flags flags) : flags_{flags} {
   if (flags & Flag::NoFarPlanePatching)
     frag.addSource("#define NO_FAR_PLANE_PATCHING\n");
 
+  if (flags & Flag::InstancedTransformation) {
+    CORRADE_INTERNAL_ASSERT(!(flags & Flag::UnprojectExistingDepth));
+    vert.addSource(Cr::Utility::formatString(
+        "#define INSTANCED_TRANSFORMATION\n"
+        "#define TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION {}\n",
+        Mn::Shaders::Generic3D::TransformationMatrix::Location));
+  }
+
+  if (flags & Flag::SurfaceNormals) {
+    CORRADE_INTERNAL_ASSERT(!(flags & Flag::UnprojectExistingDepth));
+    vert.addSource(Cr::Utility::formatString(
+        "#define SURFACE_NORMALS\n"
+        "#define NORMAL_ATTRIBUTE_LOCATION {}\n",
+        Mn::Shaders::Generic3D::Normal::Location));
+    frag.addSource("#define SURFACE_NORMALS\n");
+  }
+
+  if (flags & Flag::MotionVectors) {
+    CORRADE_INTERNAL_ASSERT(
+        !(flags & (Flag::UnprojectExistingDepth | Flag::SurfaceNormals)));
+    vert.addSource("#define MOTION_VECTORS\n");
+    frag.addSource("#define MOTION_VECTORS\n");
+  }
+
+  if (flags & Flag::Multiview) {
+    CORRADE_INTERNAL_ASSERT(
+        !(flags & (Flag::UnprojectExistingDepth | Flag::SurfaceNormals |
+                   Flag::MotionVectors)));
+    vert.addSource(
+        "#extension GL_OVR_multiview2: require\n"
+        "#define MULTIVIEW\n");
+  }
+
   vert.addSource(rs.get("depth.vert"));
   frag.addSource(rs.get("depth.frag"));
 
-  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+  // skips the compilation and link if cached, see setProgramBinaryCacheDir()
+  if (!loadProgramBinary(*this, {vert, frag})) {
+    CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
 
-  attachShaders({vert, frag});
+    attachShaders({vert, frag});
 
-  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    setRetrievableBinary(true);
+    CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    saveProgramBinary(*this, {vert, frag});
+  }
 
   if (flags & Flag::UnprojectExistingDepth) {
     projectionMatrixOrDepthUnprojectionUniform_ =
@@ -69,6 +130,17 @@ DepthShader::DepthShader(Flags flags) : flags_{flags} {
     projectionMatrixOrDepthUnprojectionUniform_ =
         uniformLocation("projectionMatrix");
   }
+  if (flags & Flag::MotionVectors) {
+    previousTransformationProjectionMatrixUniform_ =
+        uniformLocation("previousTransformationProjectionMatrix");
+    viewportSizeUniform_ = uniformLocation("viewportSize");
+  }
+  if (flags & Flag::Multiview) {
+    viewTransformationMatrixUniforms_[0] =
+        uniformLocation("viewTransformationMatrices[0]");
+    viewTransformationMatrixUniforms_[1] =
+        uniformLocation("viewTransformationMatrices[1]");
+  }
 }
 
 DepthShader& DepthShader::setDepthUnprojection(
@@ -94,6 +166,28 @@ DepthShader& DepthShader::setProjectionMatrix(const Mn::Matrix4& matrix) {
   return *this;
 }
 
+DepthShader& DepthShader::setPreviousTransformationProjectionMatrix(
+    const Mn::Matrix4& matrix) {
+  CORRADE_INTERNAL_ASSERT(flags_ & Flag::MotionVectors);
+  setUniform(previousTransformationProjectionMatrixUniform_, matrix);
+  return *this;
+}
+
+DepthShader& DepthShader::setViewportSize(const Mn::Vector2& size) {
+  CORRADE_INTERNAL_ASSERT(flags_ & Flag::MotionVectors);
+  setUniform(viewportSizeUniform_, size);
+  return *this;
+}
+
+DepthShader& DepthShader::setViewTransformationMatrices(
+    const Mn::Matrix4& first,
+    const Mn::Matrix4& second) {
+  CORRADE_INTERNAL_ASSERT(flags_ & Flag::Multiview);
+  setUniform(viewTransformationMatrixUniforms_[0], first);
+  setUniform(viewTransformationMatrixUniforms_[1], second);
+  return *this;
+}
+
 DepthShader& DepthShader::bindDepthTexture(Mn::GL::Texture2D& texture) {
   texture.bind(DepthTextureUnit);
   return *this;
@@ -104,12 +198,14 @@ Mn::Vector2 calculateDepthUnprojection(const Mn::Matrix4& projectionMatrix) {
          0.5f;
 }
 
+namespace {
+
 /* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
 #if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
 __attribute__((target_clones("default", "sse4.2", "avx2")))
 #endif
-void unprojectDepth(const Mn::Vector2& unprojection,
-                    Cr::Containers::ArrayView<Mn::Float> depth) {
+void unprojectDepthScalar(const Mn::Vector2& unprojection,
+                          Cr::Containers::ArrayView<Mn::Float> depth) {
   for (Mn::Float& d : depth) {
     d = unprojection[1] / (d + unprojection[0]);
   }
@@ -127,5 +223,147 @@ void unprojectDepth(const Mn::Vector2& unprojection,
   }
 }
 
+/* The vector kernels do both in a single pass and finish the tail that
+   doesn't fill a whole vector with the scalar kernel. The division is
+   IEEE-exact in all of them, so the results are bit-exact with the scalar
+   kernel. */
+
+#ifdef ESP_DEPTH_UNPROJECTION_SSE2
+void unprojectDepthSse2(const Mn::Vector2& unprojection,
+                        Cr::Containers::ArrayView<Mn::Float> depth) {
+  const __m128 a = _mm_set1_ps(unprojection[0]);
+  const __m128 b = _mm_set1_ps(unprojection[1]);
+  const __m128 far =
+      _mm_set1_ps(unprojection[1] / (1.0f + unprojection[0]));
+  Mn::Float* data = depth.data();
+  const std::size_t vectorSize = depth.size() & ~std::size_t{3};
+  for (std::size_t i = 0; i != vectorSize; i += 4) {
+    const __m128 d = _mm_loadu_ps(data + i);
+    const __m128 unprojected = _mm_div_ps(b, _mm_add_ps(d, a));
+    _mm_storeu_ps(data + i,
+                  _mm_andnot_ps(_mm_cmpeq_ps(unprojected, far), unprojected));
+  }
+  unprojectDepthScalar(unprojection, depth.suffix(vectorSize));
+}
+#endif
+
+#ifdef ESP_DEPTH_UNPROJECTION_AVX2
+__attribute__((target("avx2"))) void unprojectDepthAvx2(
+    const Mn::Vector2& unprojection,
+    Cr::Containers::ArrayView<Mn::Float> depth) {
+  const __m256 a = _mm256_set1_ps(unprojection[0]);
+  const __m256 b = _mm256_set1_ps(unprojection[1]);
+  const __m256 far =
+      _mm256_set1_ps(unprojection[1] / (1.0f + unprojection[0]));
+  Mn::Float* data = depth.data();
+  const std::size_t vectorSize = depth.size() & ~std::size_t{7};
+  for (std::size_t i = 0; i != vectorSize; i += 8) {
+    const __m256 d = _mm256_loadu_ps(data + i);
+    const __m256 unprojected = _mm256_div_ps(b, _mm256_add_ps(d, a));
+    _mm256_storeu_ps(
+        data + i,
+        _mm256_andnot_ps(_mm256_cmp_ps(unprojected, far, _CMP_EQ_OQ),
+                         unprojected));
+  }
+  unprojectDepthScalar(unprojection, depth.suffix(vectorSize));
+}
+#endif
+
+#ifdef ESP_DEPTH_UNPROJECTION_NEON
+void unprojectDepthNeon(const Mn::Vector2& unprojection,
+                        Cr::Containers::ArrayView<Mn::Float> depth) {
+  const float32x4_t a = vdupq_n_f32(unprojection[0]);
+  const float32x4_t b = vdupq_n_f32(unprojection[1]);
+  const float32x4_t far =
+      vdupq_n_f32(unprojection[1] / (1.0f + unprojection[0]));
+  Mn::Float* data = depth.data();
+  const std::size_t vectorSize = depth.size() & ~std::size_t{3};
+  for (std::size_t i = 0; i != vectorSize; i += 4) {
+    const float32x4_t d = vld1q_f32(data + i);
+    const float32x4_t unprojected = vdivq_f32(b, vaddq_f32(d, a));
+    vst1q_f32(data + i, vreinterpretq_f32_u32(
+                            vbicq_u32(vreinterpretq_u32_f32(unprojected),
+                                      vceqq_f32(unprojected, far))));
+  }
+  unprojectDepthScalar(unprojection, depth.suffix(vectorSize));
+}
+#endif
+
+}  // namespace
+
+bool isDepthUnprojectionKernelSupported(DepthUnprojectionKernel kernel) {
+  switch (kernel) {
+    case DepthUnprojectionKernel::Scalar:
+      return true;
+    case DepthUnprojectionKernel::Sse2:
+#ifdef ESP_DEPTH_UNPROJECTION_SSE2
+      return true;
+#else
+      return false;
+#endif
+    case DepthUnprojectionKernel::Avx2:
+#ifdef ESP_DEPTH_UNPROJECTION_AVX2
+    {
+      static const bool supported = __builtin_cpu_supports("avx2");
+      return supported;
+    }
+#else
+      return false;
+#endif
+    case DepthUnprojectionKernel::Neon:
+#ifdef ESP_DEPTH_UNPROJECTION_NEON
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+DepthUnprojectionKernel defaultDepthUnprojectionKernel() {
+  static const DepthUnprojectionKernel kernel = []() {
+    for (DepthUnprojectionKernel kernel :
+         {DepthUnprojectionKernel::Avx2, DepthUnprojectionKernel::Sse2,
+          DepthUnprojectionKernel::Neon}) {
+      if (isDepthUnprojectionKernelSupported(kernel))
+        return kernel;
+    }
+    return DepthUnprojectionKernel::Scalar;
+  }();
+  return kernel;
+}
+
+void unprojectDepth(DepthUnprojectionKernel kernel,
+                    const Mn::Vector2& unprojection,
+                    Cr::Containers::ArrayView<Mn::Float> depth) {
+  CORRADE_ASSERT(isDepthUnprojectionKernelSupported(kernel),
+                 "unprojectDepth(): kernel" << int(kernel)
+                                            << "not supported on this CPU", );
+  switch (kernel) {
+#ifdef ESP_DEPTH_UNPROJECTION_SSE2
+    case DepthUnprojectionKernel::Sse2:
+      unprojectDepthSse2(unprojection, depth);
+      return;
+#endif
+#ifdef ESP_DEPTH_UNPROJECTION_AVX2
+    case DepthUnprojectionKernel::Avx2:
+      unprojectDepthAvx2(unprojection, depth);
+      return;
+#endif
+#ifdef ESP_DEPTH_UNPROJECTION_NEON
+    case DepthUnprojectionKernel::Neon:
+      unprojectDepthNeon(unprojection, depth);
+      return;
+#endif
+    default:
+      unprojectDepthScalar(unprojection, depth);
+  }
+}
+
+void unprojectDepth(const Mn::Vector2& unprojection,
+                    Cr::Containers::ArrayView<Mn::Float> depth) {
+  unprojectDepth(defaultDepthUnprojectionKernel(), unprojection, depth);
+}
+
 }  // namespace gfx
 }  // namespace esp
@@ -15,7 +15,10 @@ namespace gfx {
 @brief Depth-only shader
 
 Outputs depth values without projection applied. Can also unproject existing
-depth buffer if @ref Flag::UnprojectExistingDepth is enabled.
+depth buffer if @ref Flag::UnprojectExistingDepth is enabled, or output the
+surface normals with @ref Flag::SurfaceNormals or the motion vectors with
+@ref Flag::MotionVectors, and draw two views at once with @ref
+Flag::Multiview.
 @see @ref calculateDepthUnprojection(), @ref unprojectDepth()
 */
 class DepthShader : public Magnum::GL::AbstractShaderProgram {
@@ -37,7 +40,44 @@ class DepthShader : public Magnum::GL::AbstractShaderProgram {
      * set to). This might have some performance penalty and can be turned off
      * with this flag.
      */
-    NoFarPlanePatching = 1 << 1
+    NoFarPlanePatching = 1 << 1,
+
+    /**
+     * Multiply the transformation matrix with a per-instance one, from the
+     * @ref Magnum::Shaders::Generic3D::TransformationMatrix attribute of an
+     * instanced mesh, as drawn by @ref InstancedDrawable. Expects that
+     * @ref Flag::UnprojectExistingDepth is not set.
+     */
+    InstancedTransformation = 1 << 2,
+
+    /**
+     * Output the unit surface normal in camera space, from the
+     * @ref Magnum::Shaders::Generic3D::Normal attribute, instead of the
+     * depth, into an RGBA float attachment with alpha zero. Meshes without
+     * normals output zero. Expects that @ref Flag::UnprojectExistingDepth
+     * is not set.
+     */
+    SurfaceNormals = 1 << 3,
+
+    /**
+     * Output the motion vector of the surface in framebuffer pixels, from
+     * where it was with the transformation set by @ref
+     * setPreviousTransformationProjectionMatrix() to where it is now, into
+     * an RG float attachment. Expects that neither @ref
+     * Flag::UnprojectExistingDepth nor @ref Flag::SurfaceNormals is set.
+     */
+    MotionVectors = 1 << 4,
+
+    /**
+     * Draw two views at once with @gl_extension{OVR,multiview2}, into the
+     * two layers of a multiview framebuffer, see @ref MultiviewFramebuffer.
+     * Each view further transforms the transformation set by @ref
+     * setTransformationMatrix() with its own matrix from @ref
+     * setViewTransformationMatrices() before projecting it. Outputs depth
+     * only, expects that neither @ref Flag::UnprojectExistingDepth, @ref
+     * Flag::SurfaceNormals nor @ref Flag::MotionVectors is set.
+     */
+    Multiview = 1 << 5
   };
 
   /** @brief Flags */
@@ -66,6 +106,35 @@ class DepthShader : public Magnum::GL::AbstractShaderProgram {
    */
   DepthShader& setProjectionMatrix(const Magnum::Matrix4& matrix);
 
+  /**
+   * @brief Set the projection times the transformation of the drawable in
+   * the previous frame
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that @ref Flag::MotionVectors is set.
+   */
+  DepthShader& setPreviousTransformationProjectionMatrix(
+      const Magnum::Matrix4& matrix);
+
+  /**
+   * @brief Set the size of the viewport the motion vectors are measured in
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that @ref Flag::MotionVectors is set.
+   */
+  DepthShader& setViewportSize(const Magnum::Vector2& size);
+
+  /**
+   * @brief Set the transformation from the camera space of the
+   * transformation matrix to the camera space of each of the two views
+   * @return Reference to self (for method chaining)
+   *
+   * Identity for a view of the camera the drawables are transformed to.
+   * Expects that @ref Flag::Multiview is set.
+   */
+  DepthShader& setViewTransformationMatrices(const Magnum::Matrix4& first,
+                                             const Magnum::Matrix4& second);
+
   /**
    * @brief Bind depth texture
    * @return Reference to self (for method chaining)
@@ -82,6 +151,9 @@ class DepthShader : public Magnum::GL::AbstractShaderProgram {
  private:
   const Flags flags_;
   int transformationMatrixUniform_, projectionMatrixOrDepthUnprojectionUniform_;
+  int previousTransformationProjectionMatrixUniform_ = -1,
+      viewportSizeUniform_ = -1;
+  int viewTransformationMatrixUniforms_[2]{-1, -1};
 };
 
 CORRADE_ENUMSET_OPERATORS(DepthShader::Flags)
@@ -151,6 +223,45 @@ consumers expect zeros for things that are too far.
 void unprojectDepth(const Magnum::Vector2& unprojection,
                     Corrade::Containers::ArrayView<Magnum::Float> depth);
 
+/**
+@brief CPU kernel of @ref unprojectDepth()
+
+The default @ref unprojectDepth() uses the fastest kernel the CPU supports,
+see @ref defaultDepthUnprojectionKernel(). All kernels give bit-exact results.
+*/
+enum class DepthUnprojectionKernel : Magnum::UnsignedByte {
+  /** Plain C++, auto-vectorized for SSE4.2 and AVX2 on GCC */
+  Scalar,
+  /** Four values at a time with SSE2 on x86 */
+  Sse2,
+  /** Eight values at a time with AVX2 on x86, picked at runtime */
+  Avx2,
+  /** Four values at a time with NEON on AArch64 */
+  Neon,
+};
+
+/**
+@brief Whether the build and the CPU support the depth unprojection @p kernel
+*/
+bool isDepthUnprojectionKernelSupported(DepthUnprojectionKernel kernel);
+
+/**
+@brief The fastest supported depth unprojection kernel, the one
+    @ref unprojectDepth() uses
+*/
+DepthUnprojectionKernel defaultDepthUnprojectionKernel();
+
+/**
+@brief Unproject depth values with a particular kernel
+
+Same as @ref unprojectDepth() with the default kernel, for testing and
+benchmarking the kernels. Expects that the kernel is supported, see
+@ref isDepthUnprojectionKernelSupported().
+*/
+void unprojectDepth(DepthUnprojectionKernel kernel,
+                    const Magnum::Vector2& unprojection,
+                    Corrade::Containers::ArrayView<Magnum::Float> depth);
+
 }  // namespace gfx
 }  // namespace esp
 
@@ -10,6 +10,7 @@
 namespace esp {
 namespace gfx {
 uint64_t Drawable::drawableIdCounter = 0;
+constexpr uint32_t Drawable::NoStaticIndex;
 Drawable::Drawable(scene::SceneNode& node,
                    Magnum::GL::Mesh& mesh,
                    DrawableGroup* group /* = nullptr */)
@@ -29,6 +30,24 @@ Drawable::~Drawable() {
   }
 }
 
+DrawState Drawable::getDrawState() {
+  DrawState state;
+  state.mesh = &mesh_;
+  return state;
+}
+
+void Drawable::setIndirectGeometry(
+    Corrade::Containers::ArrayView<const Magnum::Vector3> positions,
+    Corrade::Containers::ArrayView<const Magnum::UnsignedInt> indices) {
+  indirectPositions_ = positions;
+  indirectIndices_ = indices;
+  // the drawable may move between the culling layers of its group
+  DrawableGroup* group = drawables();
+  if (group) {
+    group->invalidateCullingBVH();
+  }
+}
+
 DrawableGroup* Drawable::drawables() {
   auto* group = Magnum::SceneGraph::Drawable3D::drawables();
   if (!group) {
@@ -5,6 +5,10 @@
 #ifndef ESP_GFX_DRAWABLE_H_
 #define ESP_GFX_DRAWABLE_H_
 
+#include <functional>
+
+#include <Corrade/Containers/ArrayView.h>
+
 #include "esp/core/esp.h"
 #include "magnum.h"
 
@@ -16,6 +20,34 @@ namespace gfx {
 
 class DrawableGroup;
 
+/**
+ * @brief The GL state a drawable binds when it draws itself.
+ *
+ * Used to sort draw lists such that drawables sharing a shader, then a
+ * material, a texture and a mesh are drawn next to each other. Members are
+ * only compared for identity, a nullptr means that the drawable does not bind
+ * such a state.
+ */
+struct DrawState {
+  const void* shader = nullptr;
+  const void* material = nullptr;
+  const void* texture = nullptr;
+  const void* mesh = nullptr;
+
+  bool operator<(const DrawState& other) const {
+    // the built-in < is unspecified for unrelated pointers, std::less is a
+    // total order
+    const std::less<const void*> less;
+    if (shader != other.shader)
+      return less(shader, other.shader);
+    if (material != other.material)
+      return less(material, other.material);
+    if (texture != other.texture)
+      return less(texture, other.texture);
+    return less(mesh, other.mesh);
+  }
+};
+
 /**
  * @brief Drawable for use with @ref DrawableGroup.
  *
@@ -66,7 +98,70 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
    */
   virtual Magnum::GL::Mesh& getVisualizerMesh() { return mesh_; }
 
+  /**
+   * @brief Get the GL state this drawable binds when drawn, used by @ref
+   * DrawableGroup::sortByDrawState()
+   *
+   * @return just the mesh by default. Sub-classes binding shaders, materials
+   * or textures should override this.
+   */
+  virtual DrawState getDrawState();
+
+  /**
+   * @brief Get the position of this drawable in the draw-state sorted order
+   * of its group, see @ref DrawableGroup::sortByDrawState()
+   */
+  uint32_t getDrawOrder() const { return drawOrder_; }
+
+  /**
+   * @brief Set the triangles of the mesh, relative to the node, so that the
+   * drawable can be drawn from the @ref IndirectDrawBatch of its group while
+   * its node is static, see @ref DrawableGroup::indirectDrawBatch()
+   *
+   * The data are not copied, they are expected to stay valid as long as the
+   * drawable is in a group.
+   */
+  void setIndirectGeometry(
+      Corrade::Containers::ArrayView<const Magnum::Vector3> positions,
+      Corrade::Containers::ArrayView<const Magnum::UnsignedInt> indices);
+
+  /**
+   * @brief The positions set by @ref setIndirectGeometry()
+   */
+  Corrade::Containers::ArrayView<const Magnum::Vector3> getIndirectPositions()
+      const {
+    return indirectPositions_;
+  }
+
+  /**
+   * @brief The indices set by @ref setIndirectGeometry()
+   */
+  Corrade::Containers::ArrayView<const Magnum::UnsignedInt>
+  getIndirectIndices() const {
+    return indirectIndices_;
+  }
+
+  /**
+   * @brief Whether the drawable is drawn from the @ref IndirectDrawBatch of
+   * its group in the passes with @ref RenderCamera::Flag::GpuDriven
+   */
+  bool isIndirectBatched() const { return indirectBatched_; }
+
+  /**
+   * @brief The position of this drawable among the static drawables of its
+   * group by drawable id, which the items of the @ref PotentiallyVisibleSet
+   * of the group refer to, see @ref DrawableGroup::setPotentiallyVisibleSet()
+   *
+   * @ref NoStaticIndex for a dynamic drawable, or before the group was culled.
+   */
+  uint32_t getStaticIndex() const { return staticIndex_; }
+
+  //! The static index of a dynamic drawable
+  static constexpr uint32_t NoStaticIndex = ~uint32_t{};
+
  protected:
+  friend class DrawableGroup;
+
   /**
    * @brief Draw the object using given camera
    *
@@ -84,6 +179,17 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
 
   scene::SceneNode& node_;
   Magnum::GL::Mesh& mesh_;
+
+  //! position in the draw-state sorted order, maintained by the group
+  uint32_t drawOrder_ = 0;
+
+  //! the triangles of setIndirectGeometry()
+  Corrade::Containers::ArrayView<const Magnum::Vector3> indirectPositions_;
+  Corrade::Containers::ArrayView<const Magnum::UnsignedInt> indirectIndices_;
+  //! whether the group put the drawable into its indirect batch
+  bool indirectBatched_ = false;
+  //! see getStaticIndex(), maintained by the group
+  uint32_t staticIndex_ = NoStaticIndex;
 };
 
 }  // namespace gfx
@@ -3,6 +3,20 @@
 // LICENSE file in the root directory of this source tree.
 #include "DrawableGroup.h"
 #include "Drawable.h"
+#include "IndirectDrawBatch.h"
+#include "InstancedDrawable.h"
+#include "RenderList.h"
+
+#include <algorithm>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Intersection.h>
+
+#include "esp/scene/SceneNode.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
 
 namespace esp {
 namespace gfx {
@@ -37,9 +51,308 @@ Drawable* DrawableGroup::getDrawable(uint64_t id) const {
   return nullptr;
 }
 
+InstancedDrawable* DrawableGroup::getInstancedDrawable(
+    const std::string& key) const {
+  auto it = instancedDrawables_.find(key);
+  if (it == instancedDrawables_.end()) {
+    return nullptr;
+  }
+  return dynamic_cast<InstancedDrawable*>(getDrawable(it->second));
+}
+
+void DrawableGroup::setInstancedDrawable(const std::string& key,
+                                         InstancedDrawable& drawable) {
+  CORRADE_ASSERT(hasDrawable(drawable.getDrawableId()),
+                 "DrawableGroup::setInstancedDrawable(): the drawable is not "
+                 "in this group", );
+  instancedDrawables_[key] = drawable.getDrawableId();
+}
+
+size_t DrawableGroup::cull(
+    const Mn::Frustum& frustum,
+    std::vector<std::reference_wrapper<Drawable>>& visibleDrawables,
+    bool indirectBatched,
+    Cr::Containers::ArrayView<const uint64_t> potentiallyVisible) {
+  if (cullingBVHDirty_) {
+    buildCullingBVH();
+  }
+  const size_t numVisibleBefore = visibleDrawables.size();
+
+  const auto preculled = std::find(preculledFrustums_.begin(),
+                                   preculledFrustums_.end(), frustum);
+  if (preculled != preculledFrustums_.end()) {
+    const uint64_t frustumBit = uint64_t{1}
+                                << (preculled - preculledFrustums_.begin());
+    for (uint32_t i = 0; i < staticIndexDrawables_.size(); ++i) {
+      Drawable& drawable = *staticIndexDrawables_[i];
+      if ((staticFrustumMasks_[i] & frustumBit) &&
+          (indirectBatched || !drawable.indirectBatched_) &&
+          (potentiallyVisible.empty() ||
+           (potentiallyVisible[i / 64] & (uint64_t{1} << (i % 64))))) {
+        visibleDrawables.emplace_back(drawable);
+      }
+    }
+    for (size_t i = 0; i < dynamicDrawables_.size(); ++i) {
+      if (dynamicFrustumMasks_[i] & frustumBit) {
+        visibleDrawables.emplace_back(*dynamicDrawables_[i]);
+      }
+    }
+    return visibleDrawables.size() - numVisibleBefore;
+  }
+
+  if (!potentiallyVisible.empty()) {
+    CORRADE_INTERNAL_ASSERT(potentiallyVisible.size() * 64 >=
+                            staticIndexDrawables_.size());
+    // only the few drawables seen from the cell are tested, one by one
+    for (size_t word = 0; word < potentiallyVisible.size(); ++word) {
+      uint32_t index = word * 64;
+      for (uint64_t bits = potentiallyVisible[word]; bits;
+           bits >>= 1, ++index) {
+        if (!(bits & 1)) {
+          continue;
+        }
+        Drawable& drawable = *staticIndexDrawables_[index];
+        if ((indirectBatched || !drawable.indirectBatched_) &&
+            Mn::Math::Intersection::rangeFrustum(
+                *drawable.getSceneNode().getAbsoluteAABB(), frustum)) {
+          visibleDrawables.emplace_back(drawable);
+        }
+      }
+    }
+  } else {
+    visibleStaticItems_.clear();
+    cullingBVH_.cull(frustum, visibleStaticItems_);
+    for (uint32_t item : visibleStaticItems_) {
+      visibleDrawables.emplace_back(*staticDrawables_[item]);
+    }
+  }
+  if (indirectBatched && potentiallyVisible.empty()) {
+    visibleStaticItems_.clear();
+    indirectCullingBVH_.cull(frustum, visibleStaticItems_);
+    for (uint32_t item : visibleStaticItems_) {
+      visibleDrawables.emplace_back(*indirectDrawables_[item]);
+    }
+  }
+
+  for (Drawable* drawable : dynamicDrawables_) {
+    // only recomputed for the drawables which moved since the last cull
+    Cr::Containers::Optional<Mn::Range3D> aabb =
+        drawable->getSceneNode().getWorldAABB();
+    if (!aabb || Mn::Math::Intersection::rangeFrustum(*aabb, frustum)) {
+      visibleDrawables.emplace_back(*drawable);
+    }
+  }
+
+  return visibleDrawables.size() - numVisibleBefore;
+}
+
+void DrawableGroup::precull(
+    Cr::Containers::ArrayView<const Mn::Frustum> frustums) {
+  if (cullingBVHDirty_) {
+    buildCullingBVH();
+  }
+  preculledFrustums_.assign(
+      frustums.begin(),
+      frustums.begin() +
+          std::min(frustums.size(), MultiFrustumCulling::MaxFrustums));
+  staticMultiFrustumCulling_.cull(preculledFrustums_, staticFrustumMasks_);
+
+  // the world AABBs are only recomputed for the drawables which moved
+  dynamicAABBs_.clear();
+  boundedDynamicDrawables_.clear();
+  dynamicFrustumMasks_.assign(dynamicDrawables_.size(), ~uint64_t{});
+  for (uint32_t i = 0; i < dynamicDrawables_.size(); ++i) {
+    Cr::Containers::Optional<Mn::Range3D> aabb =
+        dynamicDrawables_[i]->getSceneNode().getWorldAABB();
+    if (aabb) {
+      dynamicAABBs_.push_back(*aabb);
+      boundedDynamicDrawables_.push_back(i);
+    }
+  }
+  dynamicMultiFrustumCulling_.build(dynamicAABBs_);
+  dynamicMultiFrustumCulling_.cull(preculledFrustums_, boundedDynamicMasks_);
+  for (size_t i = 0; i < boundedDynamicDrawables_.size(); ++i) {
+    dynamicFrustumMasks_[boundedDynamicDrawables_[i]] = boundedDynamicMasks_[i];
+  }
+}
+
+Cr::Containers::ArrayView<const uint64_t> DrawableGroup::potentiallyVisible(
+    const Mn::Vector3& position) {
+  if (!potentiallyVisibleSet_) {
+    return nullptr;
+  }
+  if (cullingBVHDirty_) {
+    buildCullingBVH();
+  }
+  if (potentiallyVisibleSet_->numItems() != staticIndexDrawables_.size()) {
+    if (!potentiallyVisibleSetMismatchLogged_) {
+      LOG(WARNING) << "DrawableGroup::potentiallyVisible : the potentially "
+                      "visible set has "
+                   << potentiallyVisibleSet_->numItems()
+                   << " items but the group has "
+                   << staticIndexDrawables_.size()
+                   << " static drawables, it is ignored";
+      potentiallyVisibleSetMismatchLogged_ = true;
+    }
+    return nullptr;
+  }
+  const uint32_t cell = potentiallyVisibleSet_->findCell(position);
+  if (cell == PotentiallyVisibleSet::NoCell) {
+    return nullptr;
+  }
+  return potentiallyVisibleSet_->cellBits(cell);
+}
+
+IndirectDrawBatch* DrawableGroup::indirectDrawBatch() {
+  if (cullingBVHDirty_) {
+    buildCullingBVH();
+  }
+  if (indirectDrawables_.empty()) {
+    indirectDrawBatch_ = nullptr;
+    indirectDrawBatchIds_.clear();
+    return nullptr;
+  }
+  // adding or removing other drawables, e.g. of objects, keeps the batch
+  std::vector<uint64_t> ids;
+  ids.reserve(indirectDrawables_.size());
+  for (Drawable* drawable : indirectDrawables_) {
+    ids.push_back(drawable->getDrawableId());
+  }
+  if (indirectDrawBatchDirty_ || !indirectDrawBatch_ ||
+      ids != indirectDrawBatchIds_) {
+    indirectDrawBatch_ =
+        std::make_unique<IndirectDrawBatch>(indirectDrawables_);
+    indirectDrawBatchIds_ = std::move(ids);
+    indirectDrawBatchDirty_ = false;
+  }
+  return indirectDrawBatch_.get();
+}
+
+RenderList& DrawableGroup::renderList() {
+  if (!renderList_) {
+    renderList_ = std::make_unique<RenderList>();
+  }
+  if (renderListDirty_) {
+    renderList_->build(*this);
+    renderListDirty_ = false;
+  }
+  return *renderList_;
+}
+
+uint64_t DrawableGroup::epoch() {
+  // the render list collects the moved entries until its next update
+  if (renderList().update() > 0) {
+    ++epoch_;
+  }
+  return epoch_;
+}
+
+void DrawableGroup::sortByDrawState(
+    std::vector<std::pair<std::reference_wrapper<MagnumDrawable>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  if (drawOrderDirty_) {
+    updateDrawOrder();
+  }
+  std::sort(drawableTransforms.begin(), drawableTransforms.end(),
+            [](const std::pair<std::reference_wrapper<MagnumDrawable>,
+                               Mn::Matrix4>& a,
+               const std::pair<std::reference_wrapper<MagnumDrawable>,
+                               Mn::Matrix4>& b) {
+              return static_cast<Drawable&>(a.first.get()).getDrawOrder() <
+                     static_cast<Drawable&>(b.first.get()).getDrawOrder();
+            });
+}
+
+void DrawableGroup::updateDrawOrder() {
+  std::vector<std::pair<DrawState, Drawable*>> states;
+  states.reserve(idToDrawable_.size());
+  for (const auto& entry : idToDrawable_) {
+    states.emplace_back(entry.second->getDrawState(), entry.second);
+  }
+  // ties are broken by drawable id, so the order is deterministic
+  std::sort(states.begin(), states.end(),
+            [](const std::pair<DrawState, Drawable*>& a,
+               const std::pair<DrawState, Drawable*>& b) {
+              if (a.first < b.first)
+                return true;
+              if (b.first < a.first)
+                return false;
+              return a.second->getDrawableId() < b.second->getDrawableId();
+            });
+  for (uint32_t i = 0; i < states.size(); ++i) {
+    states[i].second->drawOrder_ = i;
+  }
+  drawOrderDirty_ = false;
+}
+
+void DrawableGroup::buildCullingBVH() {
+  staticDrawables_.clear();
+  dynamicDrawables_.clear();
+  indirectDrawables_.clear();
+  std::vector<Mn::Range3D> staticAABBs;
+  for (const auto& entry : idToDrawable_) {
+    Drawable* drawable = entry.second;
+    Corrade::Containers::Optional<Mn::Range3D> aabb =
+        drawable->getSceneNode().getAbsoluteAABB();
+    drawable->indirectBatched_ = aabb && !drawable->indirectIndices_.empty();
+    if (drawable->indirectBatched_) {
+      indirectDrawables_.push_back(drawable);
+    } else if (aabb) {
+      staticDrawables_.push_back(drawable);
+      staticAABBs.push_back(*aabb);
+    } else {
+      dynamicDrawables_.push_back(drawable);
+    }
+  }
+  cullingBVH_.build(std::move(staticAABBs));
+
+  // by id, so that an unchanged set keeps its batch
+  std::sort(indirectDrawables_.begin(), indirectDrawables_.end(),
+            [](Drawable* a, Drawable* b) {
+              return a->getDrawableId() < b->getDrawableId();
+            });
+  std::vector<Mn::Range3D> indirectAABBs;
+  indirectAABBs.reserve(indirectDrawables_.size());
+  for (Drawable* drawable : indirectDrawables_) {
+    indirectAABBs.push_back(*drawable->getSceneNode().getAbsoluteAABB());
+  }
+  indirectCullingBVH_.build(std::move(indirectAABBs));
+
+  // in the order the stage added them, which a potentially visible set
+  // computed offline can refer to
+  staticIndexDrawables_ = staticDrawables_;
+  staticIndexDrawables_.insert(staticIndexDrawables_.end(),
+                               indirectDrawables_.begin(),
+                               indirectDrawables_.end());
+  std::sort(staticIndexDrawables_.begin(), staticIndexDrawables_.end(),
+            [](Drawable* a, Drawable* b) {
+              return a->getDrawableId() < b->getDrawableId();
+            });
+  for (uint32_t i = 0; i < staticIndexDrawables_.size(); ++i) {
+    staticIndexDrawables_[i]->staticIndex_ = i;
+  }
+  for (Drawable* drawable : dynamicDrawables_) {
+    drawable->staticIndex_ = Drawable::NoStaticIndex;
+  }
+
+  std::vector<Mn::Range3D> staticIndexAABBs;
+  staticIndexAABBs.reserve(staticIndexDrawables_.size());
+  for (Drawable* drawable : staticIndexDrawables_) {
+    staticIndexAABBs.push_back(*drawable->getSceneNode().getAbsoluteAABB());
+  }
+  staticMultiFrustumCulling_.build(staticIndexAABBs);
+  // the layers the results refer to changed
+  preculledFrustums_.clear();
+  cullingBVHDirty_ = false;
+}
+
 bool DrawableGroup::registerDrawable(Drawable& drawable) {
   // if it is already registered, emplace will do nothing
   if (idToDrawable_.emplace(drawable.getDrawableId(), &drawable).second) {
+    cullingBVHDirty_ = true;
+    drawOrderDirty_ = true;
+    renderListDirty_ = true;
+    ++epoch_;
     return true;
   }
   return false;
@@ -49,6 +362,12 @@ bool DrawableGroup::unregisterDrawable(Drawable& drawable) {
   if (idToDrawable_.erase(drawable.getDrawableId()) == 0) {
     return false;
   }
+  drawable.indirectBatched_ = false;
+  drawable.staticIndex_ = Drawable::NoStaticIndex;
+  cullingBVHDirty_ = true;
+  drawOrderDirty_ = true;
+  renderListDirty_ = true;
+  ++epoch_;
   return true;
 }
 
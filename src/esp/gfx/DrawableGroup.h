@@ -11,13 +11,22 @@
 #include <unordered_map>
 
 #include <functional>
+#include <memory>
+#include <string>
 #include "esp/core/esp.h"
+#include "esp/gfx/CullingBVH.h"
+#include "esp/gfx/MultiFrustumCulling.h"
+#include "esp/gfx/PotentiallyVisibleSet.h"
+#include "esp/gfx/magnum.h"
 
 namespace esp {
 namespace gfx {
 
 class RenderCamera;
 class Drawable;
+class IndirectDrawBatch;
+class InstancedDrawable;
+class RenderList;
 
 /**
  * @brief Group of drawables, and shared group parameters.
@@ -64,6 +73,178 @@ class DrawableGroup : public Magnum::SceneGraph::DrawableGroup3D {
    */
   virtual bool prepareForDraw(const RenderCamera&) { return true; }
 
+  /**
+   * @brief Collect the drawables of the group which intersect a frustum
+   *
+   * Drawables whose node has an absolute AABB (see @ref
+   * scene::SceneNode::getAbsoluteAABB()) are static and culled hierarchically
+   * with a @ref CullingBVH over these AABBs. The BVH is built on first use and
+   * rebuilt after drawables were added or removed, or after @ref
+   * invalidateCullingBVH(). All other drawables (e.g. physics objects) form a
+   * dynamic layer, which is tested one by one using the mesh bounding box of
+   * their node in world space, cached until the node moves (see @ref
+   * scene::SceneNode::getWorldAABB()). Dynamic drawables without a mesh
+   * bounding box are never culled.
+   *
+   * @param frustum The frustum in world space
+   * @param[out] visibleDrawables The drawables which are not culled are
+   * appended here
+   * @param indirectBatched Whether to collect the drawables of @ref
+   * indirectDrawBatch() too, set to false when the batch draws them
+   * @param potentiallyVisible The static drawables to test, see @ref
+   * potentiallyVisible(), all if empty. The others are culled without
+   * testing their AABB.
+   * @return The number of appended drawables
+   *
+   * If @p frustum is one of those of the last @ref precull(), the drawables
+   * are collected from its results instead, without testing any AABB.
+   */
+  size_t cull(
+      const Magnum::Frustum& frustum,
+      std::vector<std::reference_wrapper<Drawable>>& visibleDrawables,
+      bool indirectBatched = true,
+      Corrade::Containers::ArrayView<const uint64_t> potentiallyVisible = {});
+
+  /**
+   * @brief Cull the drawables against several frustums at once, for the
+   * @ref cull() calls with one of them that follow
+   *
+   * Tests the AABBs of the static and dynamic layers against all
+   * @p frustums in one sweep with a @ref MultiFrustumCulling, e.g. for all
+   * sensors drawing a step, instead of once per @ref cull(). The results
+   * are kept until the next call, @ref clearPrecull(), or drawables being
+   * added or removed. Dynamic drawables which move in between are culled
+   * where they were.
+   * @param frustums At most @ref MultiFrustumCulling::MaxFrustums
+   * frustums in world space, the others are ignored
+   */
+  void precull(Corrade::Containers::ArrayView<const Magnum::Frustum> frustums);
+
+  /**
+   * @brief Drop the results of @ref precull(), so that @ref cull() tests
+   * the AABBs again
+   */
+  void clearPrecull() { preculledFrustums_.clear(); }
+
+  /**
+   * @brief The frustums of the last @ref precull(), empty if cleared
+   */
+  const std::vector<Magnum::Frustum>& getPreculledFrustums() const {
+    return preculledFrustums_;
+  }
+
+  /**
+   * @brief Set the static drawables visible from each navigable cell,
+   * precomputed for the stage of the group, for @ref
+   * RenderCamera::Flag::PotentiallyVisibleSet. Pass nullptr to unset.
+   *
+   * Item @p i of the set is the static drawable whose @ref
+   * Drawable::getStaticIndex() is @p i, i.e. the meshes of the stage in the
+   * depth-first order of its hierarchy, as they were added.
+   */
+  void setPotentiallyVisibleSet(PotentiallyVisibleSet::ptr set) {
+    potentiallyVisibleSet_ = std::move(set);
+    potentiallyVisibleSetMismatchLogged_ = false;
+  }
+
+  /**
+   * @brief The set of @ref setPotentiallyVisibleSet()
+   */
+  const PotentiallyVisibleSet::ptr& getPotentiallyVisibleSet() const {
+    return potentiallyVisibleSet_;
+  }
+
+  /**
+   * @brief The static drawables potentially visible from a view at
+   * @p position, as a bitset by @ref Drawable::getStaticIndex()
+   * @return Empty if the group has no set, the items of the set are not the
+   * static drawables of the group, or @p position is outside of its cells
+   */
+  Corrade::Containers::ArrayView<const uint64_t> potentiallyVisible(
+      const Magnum::Vector3& position);
+
+  /**
+   * @brief Force a rebuild of the static culling BVH on next @ref cull(),
+   * e.g. after the absolute AABBs of the scene nodes changed, and of the
+   * @ref indirectDrawBatch()
+   */
+  void invalidateCullingBVH() {
+    cullingBVHDirty_ = true;
+    indirectDrawBatchDirty_ = true;
+  }
+
+  /**
+   * @brief The static drawables of the group which have their triangles set
+   * (see @ref Drawable::setIndirectGeometry()), packed for @ref
+   * RenderCamera::Flag::GpuDriven
+   *
+   * Built on first use, with the culling layers of @ref cull(), and rebuilt
+   * when the set of these drawables changed or after @ref
+   * invalidateCullingBVH(). Expects @ref IndirectDrawBatch::isSupported().
+   * @return nullptr if the group has no such drawables
+   */
+  IndirectDrawBatch* indirectDrawBatch();
+
+  /**
+   * @brief Sort drawables of this group by the GL state they bind
+   *
+   * Drawables are ordered by their @ref Drawable::getDrawState(), i.e. by
+   * shader, then material, texture and mesh, so that drawing them in this
+   * order minimizes state switches. The order over all drawables of the group
+   * is cached and only recomputed after drawables were added or removed, or
+   * after @ref invalidateDrawOrder(), so sorting a frame only compares the
+   * cached positions.
+   *
+   * @param[in, out] drawableTransforms, a vector of pairs of drawables of this
+   * group and their transformations
+   */
+  void sortByDrawState(
+      std::vector<std::pair<std::reference_wrapper<MagnumDrawable>,
+                            Magnum::Matrix4>>& drawableTransforms);
+
+  /**
+   * @brief Force the draw order used by @ref sortByDrawState() to be
+   * recomputed, e.g. after the shader or material of a drawable changed
+   */
+  void invalidateDrawOrder() { drawOrderDirty_ = true; }
+
+  /**
+   * @brief The flattened @ref RenderList of the drawables of this group, for
+   * @ref RenderCamera::Flag::RenderList
+   *
+   * Built on first use and rebuilt after drawables were added or removed.
+   * The entries of the nodes which moved are only recomputed by @ref
+   * RenderList::update().
+   */
+  RenderList& renderList();
+
+  /**
+   * @brief A counter bumped whenever drawables were added to or removed from
+   * the group, or the node of one of them moved since the last call
+   *
+   * The moves are detected by the features of the @ref renderList(), so
+   * they are tracked from the first call on. The instance nodes of an
+   * @ref InstancedDrawable are not in the group and their moves are not
+   * detected.
+   */
+  uint64_t epoch();
+
+  /**
+   * @brief Get the @ref InstancedDrawable of this group registered under a
+   * key with @ref setInstancedDrawable()
+   * @return nullptr if no drawable was registered under the key, or if it
+   * is not in the group anymore
+   */
+  InstancedDrawable* getInstancedDrawable(const std::string& key) const;
+
+  /**
+   * @brief Register an @ref InstancedDrawable of this group under a key, e.g.
+   * identifying its mesh and material, so that further instances can be added
+   * to it
+   */
+  void setInstancedDrawable(const std::string& key,
+                            InstancedDrawable& drawable);
+
  protected:
   /**
    * Why a friend class here?
@@ -87,6 +268,69 @@ class DrawableGroup : public Magnum::SceneGraph::DrawableGroup3D {
    * a lookup table, that maps a drawable id to the drawable object
    */
   std::unordered_map<uint64_t, Drawable*> idToDrawable_;
+
+  /**
+   * @brief Split the drawables into the static and dynamic culling layers and
+   * build the BVH over the static one
+   */
+  void buildCullingBVH();
+
+  //! static drawables, in the item order of @ref cullingBVH_
+  std::vector<Drawable*> staticDrawables_;
+  //! static drawables with indirect geometry, by drawable id, in the item
+  //! order of @ref indirectCullingBVH_
+  std::vector<Drawable*> indirectDrawables_;
+  CullingBVH indirectCullingBVH_;
+  //! drawables whose node has no absolute AABB
+  std::vector<Drawable*> dynamicDrawables_;
+  CullingBVH cullingBVH_;
+  bool cullingBVHDirty_ = true;
+  //! scratch space for the BVH query, kept to avoid per-frame allocations
+  std::vector<uint32_t> visibleStaticItems_;
+  //! static and indirect drawables by Drawable::getStaticIndex()
+  std::vector<Drawable*> staticIndexDrawables_;
+
+  //! the AABBs of staticIndexDrawables_, in its order
+  MultiFrustumCulling staticMultiFrustumCulling_;
+  //! the world AABBs of the dynamic drawables which have one, set by
+  //! precull()
+  MultiFrustumCulling dynamicMultiFrustumCulling_;
+  std::vector<Magnum::Frustum> preculledFrustums_;
+  //! the frustums of precull() each static drawable intersects, one bit per
+  //! frustum, in the order of staticIndexDrawables_
+  std::vector<uint64_t> staticFrustumMasks_;
+  //! the same for dynamicDrawables_, all bits set for those without an AABB
+  std::vector<uint64_t> dynamicFrustumMasks_;
+  //! scratch space of precull()
+  std::vector<Magnum::Range3D> dynamicAABBs_;
+  std::vector<uint32_t> boundedDynamicDrawables_;
+  std::vector<uint64_t> boundedDynamicMasks_;
+
+  PotentiallyVisibleSet::ptr potentiallyVisibleSet_;
+  //! whether a mismatch of the set and the static drawables was reported
+  bool potentiallyVisibleSetMismatchLogged_ = false;
+
+  std::unique_ptr<IndirectDrawBatch> indirectDrawBatch_;
+  //! the drawable ids the batch was built from
+  std::vector<uint64_t> indirectDrawBatchIds_;
+  bool indirectDrawBatchDirty_ = true;
+
+  /**
+   * @brief Recompute @ref Drawable::getDrawOrder() of all drawables
+   */
+  void updateDrawOrder();
+  bool drawOrderDirty_ = true;
+
+  std::unique_ptr<RenderList> renderList_;
+  bool renderListDirty_ = true;
+
+  //! see epoch()
+  uint64_t epoch_ = 0;
+
+  //! instanced drawables by key, as drawable ids so that stale entries of
+  //! destroyed drawables are detected
+  std::unordered_map<std::string, uint64_t> instancedDrawables_;
+
   ESP_SMART_POINTERS(DrawableGroup)
 };
 
@@ -0,0 +1,71 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "FrameArena.h"
+
+#include <algorithm>
+
+namespace esp {
+namespace gfx {
+
+FrameArena::FrameArena(size_t blockSize) : blockSize_{blockSize} {}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+  for (;;) {
+    if (block_ < blocks_.size()) {
+      Block& block = blocks_[block_];
+      const size_t offset = (current_ + alignment - 1) / alignment * alignment;
+      if (offset + size <= block.size) {
+        current_ = offset + size;
+        return block.data.get() + offset;
+      }
+      if (block_ + 1 < blocks_.size() &&
+          blocks_[block_ + 1].size >= size + alignment) {
+        used_ += current_;
+        ++block_;
+        current_ = 0;
+        continue;
+      }
+      used_ += current_;
+      ++block_;
+      current_ = 0;
+    }
+    // the blocks after it are too small for this allocation, they are merged
+    // on the next reset
+    const size_t blockSize = std::max(blockSize_, size + alignment);
+    blocks_.insert(blocks_.begin() + block_,
+                   Block{std::unique_ptr<char[]>{new char[blockSize]},
+                         blockSize});
+    ++numBlockAllocations_;
+  }
+}
+
+void FrameArena::reset() {
+  if (blocks_.size() > 1) {
+    const size_t total = capacity();
+    blocks_.clear();
+    blocks_.push_back(
+        Block{std::unique_ptr<char[]>{new char[total]}, total});
+    ++numBlockAllocations_;
+  }
+  block_ = 0;
+  current_ = 0;
+  used_ = 0;
+}
+
+size_t FrameArena::capacity() const {
+  size_t total = 0;
+  for (const Block& block : blocks_) {
+    total += block.size;
+  }
+  return total;
+}
+
+FrameArena& frameArena() {
+  thread_local FrameArena arena;
+  return arena;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,155 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_FRAMEARENA_H_
+#define ESP_GFX_FRAMEARENA_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::FrameArena, @ref esp::gfx::FrameAllocator,
+ * function @ref esp::gfx::frameArena()
+ */
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Bump allocator for the temporaries of drawing a frame
+ *
+ * Allocations take the next bytes of the current block and are never freed
+ * one by one. @ref reset() makes all the memory available again, merging the
+ * blocks into one sized for the most used so far, so that once the frames
+ * stop growing, drawing them allocates nothing from the heap. Not
+ * thread-safe, see @ref frameArena() for the arena of the drawing thread.
+ */
+class FrameArena {
+ public:
+  /**
+   * @brief Constructor
+   * @param blockSize The size of the first block, allocated on first use
+   */
+  explicit FrameArena(size_t blockSize = 64 * 1024);
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /**
+   * @brief Allocate @p size bytes aligned to @p alignment, valid until the
+   * next @ref reset() or the end of an enclosing @ref Scope
+   */
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * @brief Make all memory available again, merging the blocks into one if
+   * there are several
+   */
+  void reset();
+
+  /** @brief Bytes allocated since the last @ref reset() */
+  size_t bytesUsed() const { return used_ + current_; }
+
+  /** @brief Bytes of all blocks */
+  size_t capacity() const;
+
+  /** @brief The number of blocks allocated from the heap so far */
+  size_t numBlockAllocations() const { return numBlockAllocations_; }
+
+  /**
+   * @brief Frees the allocations made during its lifetime when destroyed,
+   * for temporaries of a draw reentering the arena or of a draw outside of a
+   * render target
+   */
+  class Scope {
+   public:
+    explicit Scope(FrameArena& arena)
+        : arena_{arena}, block_{arena.block_}, offset_{arena.current_},
+          used_{arena.used_} {}
+
+    ~Scope() {
+      arena_.block_ = block_;
+      arena_.current_ = offset_;
+      arena_.used_ = used_;
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    FrameArena& arena_;
+    size_t block_;
+    size_t offset_;
+    size_t used_;
+  };
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  size_t blockSize_;
+  std::vector<Block> blocks_;
+  //! the block allocated from and the bytes used in it
+  size_t block_ = 0;
+  size_t current_ = 0;
+  //! the bytes used in the blocks before it
+  size_t used_ = 0;
+  size_t numBlockAllocations_ = 0;
+};
+
+/**
+ * @brief The arena of the calling thread, used by @ref RenderCamera::draw()
+ * and reset by @ref RenderTarget::renderExit()
+ */
+FrameArena& frameArena();
+
+/**
+ * @brief Standard allocator over a @ref FrameArena, for containers of drawing
+ * temporaries. Deallocation is a no-op.
+ */
+template <class T>
+class FrameAllocator {
+ public:
+  typedef T value_type;
+
+  explicit FrameAllocator(FrameArena& arena = frameArena()) : arena_{&arena} {}
+
+  template <class U>
+  FrameAllocator(const FrameAllocator<U>& other) : arena_{other.arena()} {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, size_t) {}
+
+  FrameArena* arena() const { return arena_; }
+
+ private:
+  FrameArena* arena_;
+};
+
+template <class T, class U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+
+template <class T, class U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+  return a.arena() != b.arena();
+}
+
+/** @brief A vector of drawing temporaries in the arena of the thread */
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_FRAMEARENA_H_
@@ -0,0 +1,130 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "FrameConversion.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/GL/Version.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+static void importShaderResources() {
+  CORRADE_RESOURCE_INITIALIZE(ShaderResources)
+}
+
+namespace esp {
+namespace gfx {
+
+namespace {
+enum { SourceTextureUnit = 1, LookupTextureUnit = 2 };
+}
+
+void ObjectIdLookup::setData(
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> table) {
+  size_ = table.size();
+  if (table.empty()) {
+    texture_ = Mn::GL::Texture2D{Mn::NoCreate};
+    return;
+  }
+
+  // whole rows, the padding is never looked up
+  const Mn::Vector2i size{Width, Mn::Int((table.size() + Width - 1) / Width)};
+  std::vector<Mn::UnsignedInt> rows(size.product(), 0);
+  std::copy(table.begin(), table.end(), rows.begin());
+  texture_ = Mn::GL::Texture2D{};
+  texture_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::R32UI, size)
+      .setSubImage(0, {},
+                   Mn::ImageView2D{Mn::PixelFormat::R32UI, size, rows});
+}
+
+FrameConversionShader::FrameConversionShader(Flags flags) : flags_{flags} {
+  // the flags pick exclusive variants of the output
+  CORRADE_INTERNAL_ASSERT(bool(flags & Flag::Grayscale) +
+                              bool(flags & Flag::MillimeterDepth) +
+                              bool(flags & Flag::ObjectIdLookup) <=
+                          1);
+
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+#ifdef MAGNUM_TARGET_WEBGL
+  Mn::GL::Version glVersion = Mn::GL::Version::GLES300;
+#else
+  Mn::GL::Version glVersion = Mn::GL::Version::GL330;
+#endif
+
+  Mn::GL::Shader vert{glVersion, Mn::GL::Shader::Type::Vertex};
+  Mn::GL::Shader frag{glVersion, Mn::GL::Shader::Type::Fragment};
+
+  if (flags & Flag::Grayscale)
+    frag.addSource("#define GRAYSCALE\n");
+  if (flags & Flag::MillimeterDepth)
+    frag.addSource("#define MILLIMETER_DEPTH\n");
+  if (flags & Flag::ObjectIdLookup)
+    frag.addSource("#define OBJECT_ID_LOOKUP\n#define LOOKUP_WIDTH " +
+                   std::to_string(ObjectIdLookup::Width) + "u\n");
+
+  vert.addSource(rs.get("frame-conversion.vert"));
+  frag.addSource(rs.get("frame-conversion.frag"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+
+  attachShaders({vert, frag});
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  downsamplingUniform_ = uniformLocation("downsampling");
+  setUniform(uniformLocation("sourceTexture"), SourceTextureUnit);
+  if (flags & Flag::ObjectIdLookup) {
+    lookupSizeUniform_ = uniformLocation("lookupSize");
+    setUniform(uniformLocation("lookupTexture"), LookupTextureUnit);
+    setUniform(lookupSizeUniform_, Mn::UnsignedInt{0});
+  }
+  setDownsampling(1);
+}
+
+FrameConversionShader& FrameConversionShader::setDownsampling(
+    Mn::Int downsampling) {
+  CORRADE_INTERNAL_ASSERT(downsampling >= 1);
+  setUniform(downsamplingUniform_, downsampling);
+  return *this;
+}
+
+FrameConversionShader& FrameConversionShader::bindSourceTexture(
+    Mn::GL::Texture2D& texture) {
+  texture.bind(SourceTextureUnit);
+  return *this;
+}
+
+FrameConversionShader& FrameConversionShader::bindLookup(
+    ObjectIdLookup& lookup) {
+  CORRADE_INTERNAL_ASSERT(flags_ & Flag::ObjectIdLookup);
+  setUniform(lookupSizeUniform_, lookup.size());
+  // an empty table has no texture, every ID is past its end then
+  if (lookup.size() != 0) {
+    lookup.texture().bind(LookupTextureUnit);
+  }
+  return *this;
+}
+
+}  // namespace gfx
+}  // namespace esp
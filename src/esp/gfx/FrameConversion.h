@@ -0,0 +1,141 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_FRAMECONVERSION_H_
+#define ESP_GFX_FRAMECONVERSION_H_
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/EnumSet.h>
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Texture.h>
+
+namespace esp {
+namespace gfx {
+
+/**
+@brief A table of unsigned integers on the GPU that object IDs are looked up
+in by a @ref FrameConversionShader
+
+Entry @cpp i @ce is at @cpp {i % Width, i / Width} @ce of an
+@ref Magnum::GL::TextureFormat::R32UI texture of @ref Width columns, so that
+large tables fit the texture size limits.
+@see @ref FrameConversionShader::Flag::ObjectIdLookup
+*/
+class ObjectIdLookup {
+ public:
+  /** @brief Number of columns of the texture */
+  static constexpr Magnum::Int Width = 1024;
+
+  /**
+   * @brief Upload the table, replacing the previous one
+   *
+   * An empty table releases the texture.
+   */
+  void setData(Corrade::Containers::ArrayView<const Magnum::UnsignedInt> table);
+
+  /** @brief Number of entries of the table */
+  Magnum::UnsignedInt size() const { return size_; }
+
+  /**
+   * @brief The texture, with no GL object if the table is empty
+   */
+  Magnum::GL::Texture2D& texture() { return texture_; }
+
+ private:
+  Magnum::GL::Texture2D texture_{Magnum::NoCreate};
+  Magnum::UnsignedInt size_ = 0;
+};
+
+/**
+@brief Shader converting a rendered frame into a smaller observation format
+
+Renders a full-screen triangle into a framebuffer @ref setDownsampling() times
+smaller than the bound source texture, each output pixel the box-filtered
+average of a square of source texels. The output is written as-is, in the
+pixel format of the target attachment, e.g. dropping alpha into an RGB8 one
+or converting to half floats into an R16F one, unless a @ref Flag changes
+it.
+@see @ref RenderTarget::readFrameConverted()
+*/
+class FrameConversionShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  /** @brief Flag */
+  enum class Flag {
+    /**
+     * Output the luma of the RGB of the source, with the BT.601 weights of
+     * the encoded values
+     */
+    Grayscale = 1 << 0,
+
+    /**
+     * Output the red channel of the source, in meters, as an unsigned integer
+     * in millimeters, for an R16UI attachment. Depths beyond its range are
+     * clamped to 65535.
+     */
+    MillimeterDepth = 1 << 1,
+
+    /**
+     * Output the entry of the lookup table at the unsigned integer red
+     * channel of the source, for an R32UI attachment, see @ref bindLookup().
+     * IDs past the end of the table output 0. Since IDs can't be averaged,
+     * the one nearest to the center of each square of source texels is
+     * looked up.
+     */
+    ObjectIdLookup = 1 << 2
+  };
+
+  /** @brief Flags */
+  typedef Corrade::Containers::EnumSet<Flag> Flags;
+
+  /**
+   * @brief Constructor
+   *
+   * Expects that at most one flag is set.
+   */
+  explicit FrameConversionShader(Flags flags = {});
+
+  /**
+   * @brief Set the factor the source is downsampled by in each direction
+   * @return Reference to self (for method chaining)
+   *
+   * The source has to be at least @p downsampling times the size of the
+   * viewport. Default is @cpp 1 @ce.
+   */
+  FrameConversionShader& setDownsampling(Magnum::Int downsampling);
+
+  /**
+   * @brief Bind the source texture
+   * @return Reference to self (for method chaining)
+   *
+   * The texture is read with @glsl texelFetch() @ce, its filtering does not
+   * matter.
+   */
+  FrameConversionShader& bindSourceTexture(Magnum::GL::Texture2D& texture);
+
+  /**
+   * @brief Bind the lookup table
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that @ref Flag::ObjectIdLookup is set. The source texture is
+   * then an unsigned integer one.
+   */
+  FrameConversionShader& bindLookup(ObjectIdLookup& lookup);
+
+  /**
+   * @brief The flags passed to the Constructor
+   */
+  Flags flags() const { return flags_; }
+
+ private:
+  const Flags flags_;
+  int downsamplingUniform_;
+  int lookupSizeUniform_ = -1;
+};
+
+CORRADE_ENUMSET_OPERATORS(FrameConversionShader::Flags)
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_FRAMECONVERSION_H_
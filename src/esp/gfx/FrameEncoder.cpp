@@ -0,0 +1,249 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "FrameEncoder.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/ConfigurationGroup.h>
+#include <Corrade/Utility/String.h>
+#include <Magnum/Image.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/AbstractImageConverter.h>
+
+#include "RenderTarget.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+using ImageConverter = Mn::Trade::AbstractImageConverter;
+
+bool isJpeg(const std::string& filename) {
+  const std::string lower = Cr::Utility::String::lowercase(filename);
+  return Cr::Utility::String::endsWith(lower, ".jpg") ||
+         Cr::Utility::String::endsWith(lower, ".jpeg");
+}
+
+bool isPng(const std::string& filename) {
+  return Cr::Utility::String::endsWith(
+      Cr::Utility::String::lowercase(filename), ".png");
+}
+
+//! a queued frame, in the layout of Magnum images
+struct Frame {
+  Cr::Containers::Array<char> data;
+  Mn::PixelFormat format;
+  Mn::Vector2i size;
+  std::string filename;
+};
+
+}  // namespace
+
+struct FrameEncoder::Impl {
+  explicit Impl(const Configuration& configuration)
+      : configuration_{configuration}, worker_{[this]() { run(); }} {}
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopped_ = true;
+    }
+    queued_.notify_all();
+    worker_.join();
+  }
+
+  void push(Frame&& frame) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    written_.wait(lock, [this]() {
+      return frames_.size() + numEncoding_ <
+             std::max<size_t>(configuration_.maxPendingFrames, 1);
+    });
+    frames_.push_back(std::move(frame));
+    queued_.notify_one();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    written_.wait(lock,
+                  [this]() { return frames_.empty() && numEncoding_ == 0; });
+  }
+
+  size_t numPending() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return frames_.size() + numEncoding_;
+  }
+
+  size_t numWritten() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return numWritten_;
+  }
+
+  size_t numFailed() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return numFailed_;
+  }
+
+ private:
+  void run() {
+    // plugin managers are not thread-safe, so the thread has its own one
+#ifdef MAGNUM_BUILD_STATIC
+    // avoid using plugins that might depend on different library versions
+    Cr::PluginManager::Manager<ImageConverter> manager{"nonexistent"};
+#else
+    Cr::PluginManager::Manager<ImageConverter> manager;
+#endif
+    Cr::Containers::Pointer<ImageConverter> pngConverter;
+    Cr::Containers::Pointer<ImageConverter> jpegConverter;
+    Cr::Containers::Pointer<ImageConverter> anyConverter;
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (true) {
+      queued_.wait(lock, [this]() { return stopped_ || !frames_.empty(); });
+      if (frames_.empty()) {
+        return;
+      }
+      Frame frame = std::move(frames_.front());
+      frames_.pop_front();
+      numEncoding_ = 1;
+      lock.unlock();
+
+      const char* plugin = "AnyImageConverter";
+      Cr::Containers::Pointer<ImageConverter>* converter = &anyConverter;
+      if (isPng(frame.filename)) {
+        plugin = "PngImageConverter";
+        converter = &pngConverter;
+      } else if (isJpeg(frame.filename)) {
+        plugin = "JpegImageConverter";
+        converter = &jpegConverter;
+      }
+      if (!*converter) {
+        *converter = manager.loadAndInstantiate(plugin);
+        if (*converter && converter == &jpegConverter) {
+          (*converter)->configuration().setValue(
+              "jpegQuality",
+              Mn::Math::clamp(configuration_.jpegQuality, 1, 100) / 100.0f);
+        }
+      }
+      const bool success =
+          *converter &&
+          (*converter)->convertToFile(
+              Mn::ImageView2D{Mn::PixelStorage{}.setAlignment(1),
+                              frame.format, frame.size, frame.data},
+              frame.filename);
+      if (!success) {
+        LOG(ERROR) << "FrameEncoder : Cannot write " << frame.filename
+                   << " with " << plugin;
+      }
+
+      lock.lock();
+      numEncoding_ = 0;
+      if (success) {
+        ++numWritten_;
+      } else {
+        ++numFailed_;
+      }
+      written_.notify_all();
+    }
+  }
+
+  const Configuration configuration_;
+  mutable std::mutex mutex_;
+  //! notified when a frame is queued or the encoder stops
+  std::condition_variable queued_;
+  //! notified when a frame was written or failed to be
+  std::condition_variable written_;
+  std::deque<Frame> frames_;
+  //! the frame taken from frames_ and being written, 0 or 1
+  size_t numEncoding_ = 0;
+  size_t numWritten_ = 0;
+  size_t numFailed_ = 0;
+  bool stopped_ = false;
+  //! started last, once the state it uses is constructed
+  std::thread worker_;
+};
+
+FrameEncoder::FrameEncoder(const Configuration& configuration)
+    : pimpl_{spimpl::make_unique_impl<Impl>(configuration)} {}
+
+FrameEncoder::~FrameEncoder() = default;
+
+bool FrameEncoder::encode(const Mn::ImageView2D& image,
+                          const std::string& filename) {
+  const Mn::PixelFormat format = image.format();
+  if (format != Mn::PixelFormat::R8Unorm &&
+      format != Mn::PixelFormat::RG8Unorm &&
+      format != Mn::PixelFormat::RGB8Unorm &&
+      format != Mn::PixelFormat::RGBA8Unorm) {
+    LOG(ERROR) << "FrameEncoder::encode : Unsupported pixel format "
+               << Mn::UnsignedInt(format) << " of " << filename;
+    return false;
+  }
+
+  // JPEG has no alpha channel
+  const bool dropAlpha =
+      format == Mn::PixelFormat::RGBA8Unorm && isJpeg(filename);
+  const size_t pixelSize = dropAlpha ? 3 : image.pixelSize();
+  const Mn::Vector2i size = image.size();
+  Frame frame{Cr::Containers::Array<char>{Cr::NoInit,
+                                          size.product() * pixelSize},
+              dropAlpha ? Mn::PixelFormat::RGB8Unorm : format, size,
+              filename};
+  // Magnum images start with the bottom row
+  const Cr::Containers::StridedArrayView3D<const char> pixels =
+      image.pixels();
+  for (int y = 0; y < size.y(); ++y) {
+    char* row = frame.data + y * size.x() * pixelSize;
+    for (int x = 0; x < size.x(); ++x) {
+      std::memcpy(row + x * pixelSize, &pixels[size.y() - 1 - y][x][0],
+                  pixelSize);
+    }
+  }
+  pimpl_->push(std::move(frame));
+  return true;
+}
+
+bool FrameEncoder::encodeFrame(RenderTarget& target,
+                               const std::string& filename) {
+  const Mn::Vector2i size = target.framebufferSize();
+  Mn::Image2D image{
+      Mn::PixelFormat::RGBA8Unorm, size,
+      Cr::Containers::Array<char>{Cr::NoInit, std::size_t(size.product()) * 4}};
+  target.readFrameRgba(image);
+  return encode(image, filename);
+}
+
+void FrameEncoder::wait() {
+  pimpl_->wait();
+}
+
+size_t FrameEncoder::numPending() const {
+  return pimpl_->numPending();
+}
+
+size_t FrameEncoder::numWritten() const {
+  return pimpl_->numWritten();
+}
+
+size_t FrameEncoder::numFailed() const {
+  return pimpl_->numFailed();
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,92 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_FRAMEENCODER_H_
+#define ESP_GFX_FRAMEENCODER_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::FrameEncoder
+ */
+
+#include <cstddef>
+#include <string>
+
+#include <Magnum/Magnum.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+class RenderTarget;
+
+/**
+ * @brief Writes frames to image files on a thread of its own, so that
+ * recording observations doesn't stall the step
+ *
+ * Frames are copied when queued and encoded in the order they were queued,
+ * into the format of the file extension: PNG for `.png`, JPEG for `.jpg`
+ * and `.jpeg`, and any format of `AnyImageConverter` otherwise. Once
+ * @ref Configuration::maxPendingFrames are queued, queueing waits for the
+ * oldest to be written, bounding the memory of a recording that outpaces
+ * the encoding.
+ */
+class FrameEncoder {
+ public:
+  /** @brief The encoding of the frames */
+  struct Configuration {
+    //! The quality of JPEG files, from 1 to 100.
+    int jpegQuality = 90;
+    //! The most frames queued and not written yet.
+    size_t maxPendingFrames = 16;
+  };
+
+  /** @brief Start the thread encoding the frames */
+  explicit FrameEncoder(const Configuration& configuration = {});
+
+  /** @brief Write the frames still queued and stop the thread */
+  ~FrameEncoder();
+
+  FrameEncoder(const FrameEncoder&) = delete;
+  FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+  /**
+   * @brief Queue @p image to be written to @p filename
+   * @param image A frame with its rows from top to bottom, as the
+   * observations of visual sensors, in `R8Unorm`, `RG8Unorm`, `RGB8Unorm` or
+   * `RGBA8Unorm`. JPEG files drop the alpha.
+   * @param filename The file to write, replaced if it exists
+   * @return false if the format of @p image isn't supported, nothing is
+   * queued then
+   */
+  bool encode(const Magnum::ImageView2D& image, const std::string& filename);
+
+  /**
+   * @brief Read the RGBA frame of @p target back and queue it to be written
+   * to @p filename, see @ref encode()
+   *
+   * The read waits for the GPU to finish the frame, only the encoding is
+   * done on the thread of the encoder.
+   */
+  bool encodeFrame(RenderTarget& target, const std::string& filename);
+
+  /** @brief Wait for all queued frames to be written */
+  void wait();
+
+  /** @brief The number of frames queued and not written yet */
+  size_t numPending() const;
+
+  /** @brief The number of frames written so far */
+  size_t numWritten() const;
+
+  /** @brief The number of queued frames which failed to be written */
+  size_t numFailed() const;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(FrameEncoder)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_FRAMEENCODER_H_
@@ -4,11 +4,16 @@
 
 #include "GenericDrawable.h"
 
-#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Utility/FormatStl.h>
+#include <Magnum/GL/MeshView.h>
 #include <Magnum/Math/Color.h>
+#include <Magnum/Math/Constants.h>
 #include <Magnum/Math/Matrix3.h>
 
+#include "esp/core/Profiling.h"
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/DrawableGroup.h"
+#include "esp/gfx/RenderCamera.h"
 #include "esp/scene/SceneNode.h"
 
 namespace Mn = Magnum;
@@ -32,71 +37,155 @@ GenericDrawable::GenericDrawable(scene::SceneNode& node,
 }
 
 void GenericDrawable::setLightSetup(const Mn::ResourceKey& resourceKey) {
+  // e.g. the drawables of a subtree already using the setup
+  if (lightSetup_.key() == resourceKey) {
+    return;
+  }
   lightSetup_ = shaderManager_.get<LightSetup>(resourceKey);
 
   // update the shader early here to to avoid doing it during the render loop
   updateShader();
+
+  // the shader may have changed, the draw order needs to know
+  if (DrawableGroup* group = drawables()) {
+    group->invalidateDrawOrder();
+  }
+}
+
+void GenericDrawable::setLevelsOfDetail(
+    std::vector<assets::GenericMeshData::LevelOfDetail> levels,
+    const Mn::Range3D& bounds,
+    float pixelError) {
+  levelsOfDetail_ = std::move(levels);
+  levelOfDetailBounds_ = bounds;
+  levelOfDetailPixelError_ = pixelError;
+}
+
+const assets::GenericMeshData::LevelOfDetail*
+GenericDrawable::selectLevelOfDetail(const Mn::Matrix4& transformationMatrix,
+                                     Mn::SceneGraph::Camera3D& camera) const {
+  if (levelsOfDetail_.empty()) {
+    return nullptr;
+  }
+  const Mn::Matrix4& projection = camera.projectionMatrix();
+  const float scale = transformationMatrix.scaling().max();
+  // pixels per unit of length in the mesh, at unit distance for perspective
+  float pixelsPerUnit = 0.5f * projection[1][1] * camera.viewport().y() * scale;
+  if (projection[2][3] != 0.0f) {
+    const Mn::Vector3 center =
+        transformationMatrix.transformPoint(levelOfDetailBounds_.center());
+    const float distance =
+        -center.z() - 0.5f * levelOfDetailBounds_.size().length() * scale;
+    if (distance <= 0.0f) {
+      return nullptr;
+    }
+    pixelsPerUnit /= distance;
+  }
+
+  const assets::GenericMeshData::LevelOfDetail* selected = nullptr;
+  for (const assets::GenericMeshData::LevelOfDetail& level : levelsOfDetail_) {
+    // no vertex moves further than the cell diagonal
+    if (level.cellSize * Mn::Constants::sqrt3() * pixelsPerUnit >
+        levelOfDetailPixelError_) {
+      break;
+    }
+    selected = &level;
+  }
+  return selected;
+}
+
+DrawState GenericDrawable::getDrawState() {
+  DrawState state;
+  state.shader = shader_ ? &*shader_ : nullptr;
+  state.material = materialData_ ? &*materialData_ : nullptr;
+  if (materialData_ && materialData_->hasTextureArrays()) {
+    // the materials of an array differ only by the layer
+    state.texture = materialData_->diffuseTextureArray
+                        ? materialData_->diffuseTextureArray
+                        : materialData_->ambientTextureArray;
+  } else if (materialData_) {
+    state.texture = materialData_->diffuseTexture
+                        ? materialData_->diffuseTexture
+                        : materialData_->ambientTexture;
+  }
+  state.mesh = &mesh_;
+  return state;
 }
 
 void GenericDrawable::updateShaderLightingParameters(
     const Mn::Matrix4& transformationMatrix,
     Mn::SceneGraph::Camera3D& camera) {
-  const Mn::Matrix4 cameraMatrix = camera.cameraMatrix();
-
-  std::vector<Mn::Vector4> lightPositions;
-  lightPositions.reserve(lightSetup_->size());
-  std::vector<Mn::Color3> lightColors;
-  lightColors.reserve(lightSetup_->size());
-  std::vector<Mn::Color3> lightSpecularColors;
-  lightSpecularColors.reserve(lightSetup_->size());
-  constexpr float dummyRange = 10000;
-  std::vector<float> lightRanges(lightSetup_->size(), dummyRange);
-  const Mn::Color4 ambientLightColor = getAmbientLightColor(*lightSetup_);
-
-  for (Mn::UnsignedInt i = 0; i < lightSetup_->size(); ++i) {
-    const auto& lightInfo = (*lightSetup_)[i];
-    lightPositions.emplace_back(Mn::Vector4(getLightPositionRelativeToCamera(
-        lightInfo, transformationMatrix, cameraMatrix)));
-
-    const auto& lightColor = (*lightSetup_)[i].color;
-    lightColors.emplace_back(lightColor);
-
-    // In general, a light's specular color should match its base color.
-    // However, negative lights have zero (black) specular.
-    constexpr Mn::Color3 blackColor(0.0, 0.0, 0.0);
-    bool isNegativeLight = lightColor.x() < 0;
-    lightSpecularColors.emplace_back(isNegativeLight ? blackColor : lightColor);
-  }
-
-  // See documentation in src/deps/magnum/src/Magnum/Shaders/Phong.h
+  // the lights and the projection are shared by all drawables of the shader
+  const PhongUniformCache::Lights& lights =
+      static_cast<RenderCamera&>(camera)
+          .phongUniformCache()
+          .setLightingUniforms(*shader_, *lightSetup_, transformationMatrix,
+                               camera);
+
   (*shader_)
-      .setAmbientColor(materialData_->ambientColor * ambientLightColor)
+      .setAmbientColor(materialData_->ambientColor * lights.ambientColor)
       .setDiffuseColor(materialData_->diffuseColor)
       .setSpecularColor(materialData_->specularColor)
-      .setShininess(materialData_->shininess)
-      .setLightPositions(lightPositions)
-      .setLightColors(lightColors)
-      .setLightRanges(lightRanges);
+      .setShininess(materialData_->shininess);
 }
 
 void GenericDrawable::draw(const Mn::Matrix4& transformationMatrix,
                            Mn::SceneGraph::Camera3D& camera) {
-  updateShader();
+  if (DepthShader* depthShader =
+          static_cast<RenderCamera&>(camera).linearDepthShader()) {
+    depthShader->setTransformationMatrix(transformationMatrix);
+    drawLevelOfDetail(*depthShader, transformationMatrix, camera);
+    return;
+  }
+
+  // e.g., semantic mesh has its own per vertex annotation, which has been
+  // uploaded to GPU so simply pass 0 to the uniform "objectId" in the
+  // fragment shader
+  const Mn::UnsignedInt objectId =
+      static_cast<RenderCamera&>(camera).useDrawableIds()
+          ? drawableId_
+          : (materialData_->perVertexObjectId ? 0 : node_.getSemanticId());
+
+  const RenderCamera::Shading shading =
+      static_cast<RenderCamera&>(camera).shading();
+  if (shading != RenderCamera::Shading::Phong) {
+    Mn::Shaders::Flat3D& flatShader = updateFlatShader(shading, objectId);
+    flatShader.setTransformationProjectionMatrix(camera.projectionMatrix() *
+                                                 transformationMatrix);
+    drawLevelOfDetail(flatShader, transformationMatrix, camera);
+    return;
+  }
+
+  updateShaderIfLightSetupChanged();
 
   updateShaderLightingParameters(transformationMatrix, camera);
 
   (*shader_)
-      // e.g., semantic mesh has its own per vertex annotation, which has been
-      // uploaded to GPU so simply pass 0 to the uniform "objectId" in the
-      // fragment shader
-      .setObjectId(
-          static_cast<RenderCamera&>(camera).useDrawableIds()
-              ? drawableId_
-              : (materialData_->perVertexObjectId ? 0 : node_.getSemanticId()))
+      .setObjectId(objectId)
       .setTransformationMatrix(transformationMatrix)
-      .setProjectionMatrix(camera.projectionMatrix())
       .setNormalMatrix(transformationMatrix.rotationScaling());
 
+  bindMaterialTextures();
+
+  drawLevelOfDetail(*shader_, transformationMatrix, camera);
+}
+
+void GenericDrawable::drawLevelOfDetail(
+    Mn::GL::AbstractShaderProgram& shader,
+    const Mn::Matrix4& transformationMatrix,
+    Mn::SceneGraph::Camera3D& camera) {
+  if (const assets::GenericMeshData::LevelOfDetail* level =
+          selectLevelOfDetail(transformationMatrix, camera)) {
+    Mn::GL::MeshView view{mesh_};
+    view.setCount(level->indexCount).setIndexRange(level->indexOffset);
+    shader.draw(view);
+  } else {
+    shader.draw(mesh_);
+  }
+  core::Profiler::increment(core::ProfilingCounter::DrawCalls);
+}
+
+void GenericDrawable::bindMaterialTextures() {
   if (materialData_->textureMatrix != Mn::Matrix3{})
     shader_->setTextureMatrix(materialData_->textureMatrix);
 
@@ -109,11 +198,20 @@ void GenericDrawable::draw(const Mn::Matrix4& transformationMatrix,
   if (materialData_->normalTexture)
     shader_->bindNormalTexture(*(materialData_->normalTexture));
 
-  shader_->draw(mesh_);
+  if (!materialData_->hasTextureArrays())
+    return;
+  if (materialData_->ambientTextureArray)
+    shader_->bindAmbientTexture(*(materialData_->ambientTextureArray));
+  if (materialData_->diffuseTextureArray)
+    shader_->bindDiffuseTexture(*(materialData_->diffuseTextureArray));
+  if (materialData_->specularTextureArray)
+    shader_->bindSpecularTexture(*(materialData_->specularTextureArray));
+  if (materialData_->normalTextureArray)
+    shader_->bindNormalTexture(*(materialData_->normalTextureArray));
+  shader_->setTextureLayer(materialData_->textureLayer);
 }
 
-void GenericDrawable::updateShader() {
-  Mn::UnsignedInt lightCount = lightSetup_->size();
+Mn::Shaders::Phong::Flags GenericDrawable::getShaderFlags() {
   Mn::Shaders::Phong::Flags flags = Mn::Shaders::Phong::Flag::ObjectId;
 
   if (materialData_->textureMatrix != Mn::Matrix3{})
@@ -126,10 +224,105 @@ void GenericDrawable::updateShader() {
     flags |= Mn::Shaders::Phong::Flag::SpecularTexture;
   if (materialData_->normalTexture)
     flags |= Mn::Shaders::Phong::Flag::NormalTexture;
+  if (materialData_->hasTextureArrays()) {
+    flags |= Mn::Shaders::Phong::Flag::TextureArrays;
+    if (materialData_->ambientTextureArray)
+      flags |= Mn::Shaders::Phong::Flag::AmbientTexture;
+    if (materialData_->diffuseTextureArray)
+      flags |= Mn::Shaders::Phong::Flag::DiffuseTexture;
+    if (materialData_->specularTextureArray)
+      flags |= Mn::Shaders::Phong::Flag::SpecularTexture;
+    if (materialData_->normalTextureArray)
+      flags |= Mn::Shaders::Phong::Flag::NormalTexture;
+  }
   if (materialData_->perVertexObjectId)
     flags |= Mn::Shaders::Phong::Flag::InstancedObjectId;
   if (materialData_->vertexColored)
     flags |= Mn::Shaders::Phong::Flag::VertexColor;
+  return flags;
+}
+
+Mn::Shaders::Flat3D::Flags GenericDrawable::getFlatShaderFlags(
+    RenderCamera::Shading shading) {
+  Mn::Shaders::Flat3D::Flags flags = Mn::Shaders::Flat3D::Flag::ObjectId;
+
+  if (materialData_->perVertexObjectId)
+    flags |= Mn::Shaders::Flat3D::Flag::InstancedObjectId;
+  if (materialData_->vertexColored)
+    flags |= Mn::Shaders::Flat3D::Flag::VertexColor;
+  if (shading == RenderCamera::Shading::Unlit &&
+      (materialData_->diffuseTexture || materialData_->ambientTexture ||
+       materialData_->diffuseTextureArray ||
+       materialData_->ambientTextureArray)) {
+    flags |= Mn::Shaders::Flat3D::Flag::Textured;
+    if (materialData_->hasTextureArrays())
+      flags |= Mn::Shaders::Flat3D::Flag::TextureArrays;
+    if (materialData_->textureMatrix != Mn::Matrix3{})
+      flags |= Mn::Shaders::Flat3D::Flag::TextureTransformation;
+  }
+  return flags;
+}
+
+Mn::Shaders::Flat3D& GenericDrawable::updateFlatShader(
+    RenderCamera::Shading shading,
+    Mn::UnsignedInt objectId) {
+  const Mn::Shaders::Flat3D::Flags flags = getFlatShaderFlags(shading);
+  if (!flatShader_ || flatShader_->flags() != flags) {
+    flatShader_ =
+        shaderManager_.get<Mn::GL::AbstractShaderProgram, Mn::Shaders::Flat3D>(
+            Corrade::Utility::formatString(
+                FLAT_SHADER_KEY_TEMPLATE,
+                static_cast<Mn::Shaders::Flat3D::Flags::UnderlyingType>(
+                    flags)));
+    if (!flatShader_) {
+      core::ScopedTimer timer{core::ProfilingStage::ShaderCompilation};
+      shaderManager_.set<Mn::GL::AbstractShaderProgram>(
+          flatShader_.key(), new Mn::Shaders::Flat3D{flags},
+          Mn::ResourceDataState::Final, Mn::ResourcePolicy::ReferenceCounted);
+    }
+    CORRADE_INTERNAL_ASSERT(flatShader_ && flatShader_->flags() == flags);
+  }
+
+  // the albedo is the diffuse term, or the ambient one of unlit materials,
+  // which have a black diffuse color
+  const bool diffuseAlbedo =
+      materialData_->diffuseTexture || materialData_->diffuseTextureArray ||
+      (!materialData_->ambientTexture &&
+       !materialData_->ambientTextureArray &&
+       materialData_->diffuseColor.rgb() != Mn::Color3{0.0f});
+  Mn::Shaders::Flat3D& shader = *flatShader_;
+  shader
+      .setColor(diffuseAlbedo ? materialData_->diffuseColor
+                              : materialData_->ambientColor)
+      .setObjectId(objectId);
+  if (flags & Mn::Shaders::Flat3D::Flag::TextureArrays) {
+    shader
+        .bindTexture(diffuseAlbedo ? *materialData_->diffuseTextureArray
+                                   : *materialData_->ambientTextureArray)
+        .setTextureLayer(materialData_->textureLayer);
+  } else if (flags & Mn::Shaders::Flat3D::Flag::Textured) {
+    shader.bindTexture(diffuseAlbedo ? *materialData_->diffuseTexture
+                                     : *materialData_->ambientTexture);
+  }
+  if (flags & Mn::Shaders::Flat3D::Flag::TextureTransformation) {
+    shader.setTextureMatrix(materialData_->textureMatrix);
+  }
+  return shader;
+}
+
+void GenericDrawable::updateShaderIfLightSetupChanged() {
+  if (lightSetupVersion_ != getLightSetupVersion() ||
+      shaderMaterial_ != &*materialData_) {
+    updateShader();
+  }
+}
+
+void GenericDrawable::updateShader() {
+  // read before the setup, so that a change in between updates again
+  lightSetupVersion_ = getLightSetupVersion();
+  shaderMaterial_ = &*materialData_;
+  Mn::UnsignedInt lightCount = lightSetup_->size();
+  Mn::Shaders::Phong::Flags flags = getShaderFlags();
 
   if (!shader_ || shader_->lightCount() != lightCount ||
       shader_->flags() != flags) {
@@ -141,6 +334,7 @@ void GenericDrawable::updateShader() {
 
     // if no shader with desired number of lights and flags exists, create one
     if (!shader_) {
+      core::ScopedTimer timer{core::ProfilingStage::ShaderCompilation};
       shaderManager_.set<Mn::GL::AbstractShaderProgram>(
           shader_.key(), new Mn::Shaders::Phong{flags, lightCount},
           Mn::ResourceDataState::Final, Mn::ResourcePolicy::ReferenceCounted);
@@ -5,9 +5,16 @@
 #ifndef ESP_GFX_GENERICDRAWABLE_H_
 #define ESP_GFX_GENERICDRAWABLE_H_
 
+#include <cstdint>
+#include <vector>
+
+#include <Magnum/Math/Range.h>
+#include <Magnum/Shaders/Flat.h>
 #include <Magnum/Shaders/Phong.h>
 
+#include "esp/assets/GenericMeshData.h"
 #include "esp/gfx/Drawable.h"
+#include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/ShaderManager.h"
 
 namespace esp {
@@ -26,17 +33,90 @@ class GenericDrawable : public Drawable {
                            DrawableGroup* group = nullptr);
 
   void setLightSetup(const Magnum::ResourceKey& lightSetup) override;
+  DrawState getDrawState() override;
+
+  /**
+   * @brief Draw coarser levels of detail of the mesh when they are small on
+   * screen.
+   *
+   * Each draw picks the coarsest level whose vertices move by at most @p
+   * pixelError pixels at the projected size of the point of @p bounds nearest
+   * to the camera, and the full detail if there is none.
+   * @param levels The levels, from finest to coarsest, see @ref
+   * assets::GenericMeshData::getLevelsOfDetail()
+   * @param bounds The bounds of the mesh, in its local space
+   * @param pixelError The largest screen-space error allowed, in pixels
+   */
+  void setLevelsOfDetail(
+      std::vector<assets::GenericMeshData::LevelOfDetail> levels,
+      const Magnum::Range3D& bounds,
+      float pixelError);
   static constexpr const char* SHADER_KEY_TEMPLATE = "Phong-lights={}-flags={}";
+  static constexpr const char* FLAT_SHADER_KEY_TEMPLATE = "Flat-flags={}";
 
  protected:
   virtual void draw(const Magnum::Matrix4& transformationMatrix,
                     Magnum::SceneGraph::Camera3D& camera) override;
 
   void updateShader();
+
+  /**
+   * @brief @ref updateShader() if a light setup was set since the last
+   * update, which may have changed the light count, see @ref
+   * getLightSetupVersion(), or if the material was replaced, e.g. once its
+   * textures are loaded
+   */
+  void updateShaderIfLightSetupChanged();
+
+  /**
+   * @brief The flags of the Phong shader variant needed to draw the material
+   *
+   * Called by @ref updateShader(), sub-classes may add flags, e.g. for
+   * instancing.
+   */
+  virtual Magnum::Shaders::Phong::Flags getShaderFlags();
+
+  /**
+   * @brief The flags of the flat shader variant drawing the material with a
+   * cheaper @p shading, see @ref RenderCamera::Flag::Unlit
+   *
+   * Sub-classes may add flags, e.g. for instancing.
+   */
+  virtual Magnum::Shaders::Flat3D::Flags getFlatShaderFlags(
+      RenderCamera::Shading shading);
+
+  /**
+   * @brief Fetch the flat shader variant for @p shading and set its color,
+   * object ID and texture uniforms, the transformation is left to the caller
+   */
+  Magnum::Shaders::Flat3D& updateFlatShader(RenderCamera::Shading shading,
+                                            Magnum::UnsignedInt objectId);
+  /**
+   * @brief Set the lighting and material uniforms of the shader
+   *
+   * The lights and the projection matrix are only uploaded on the first use
+   * of the shader in the pass, see @ref PhongUniformCache.
+   */
   void updateShaderLightingParameters(
       const Magnum::Matrix4& transformationMatrix,
       Magnum::SceneGraph::Camera3D& camera);
 
+  //! set the texture matrix and bind the textures of the material
+  void bindMaterialTextures();
+
+  /**
+   * @brief The level of detail to draw, nullptr for the full detail, see @ref
+   * setLevelsOfDetail()
+   */
+  const assets::GenericMeshData::LevelOfDetail* selectLevelOfDetail(
+      const Magnum::Matrix4& transformationMatrix,
+      Magnum::SceneGraph::Camera3D& camera) const;
+
+  //! draw the level of detail selected for the camera with @p shader
+  void drawLevelOfDetail(Magnum::GL::AbstractShaderProgram& shader,
+                         const Magnum::Matrix4& transformationMatrix,
+                         Magnum::SceneGraph::Camera3D& camera);
+
   Magnum::ResourceKey getShaderKey(Magnum::UnsignedInt lightCount,
                                    Magnum::Shaders::Phong::Flags flags) const;
 
@@ -47,8 +127,19 @@ class GenericDrawable : public Drawable {
   ShaderManager& shaderManager_;
   Magnum::Resource<Magnum::GL::AbstractShaderProgram, Magnum::Shaders::Phong>
       shader_;
+  //! variant of the cheaper shading tiers, fetched on first use
+  Magnum::Resource<Magnum::GL::AbstractShaderProgram, Magnum::Shaders::Flat3D>
+      flatShader_;
   Magnum::Resource<MaterialData, PhongMaterialData> materialData_;
   Magnum::Resource<LightSetup> lightSetup_;
+  //! the version of the light setups at the last updateShader()
+  uint64_t lightSetupVersion_ = 0;
+  //! the material at the last updateShader()
+  const PhongMaterialData* shaderMaterial_ = nullptr;
+
+  std::vector<assets::GenericMeshData::LevelOfDetail> levelsOfDetail_;
+  Magnum::Range3D levelOfDetailBounds_;
+  float levelOfDetailPixelError_ = 1.0f;
 };
 
 }  // namespace gfx
@@ -0,0 +1,165 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "GpuDevices.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#include <Corrade/configure.h>
+
+#if defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_APPLE) && \
+    defined(ESP_BUILD_EGL_SUPPORT)
+#define ESP_GFX_EGL_DEVICES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef ESP_BUILD_WITH_CUDA
+#include <cuda_runtime.h>
+#endif
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+struct GpuDeviceState {
+  std::mutex mutex;
+  //! live contexts per device
+  std::map<int, int> numContexts;
+  //! the device round-robin placement picks next
+  int nextDevice = 0;
+};
+
+GpuDeviceState& gpuDeviceState() {
+  static GpuDeviceState state;
+  return state;
+}
+
+int queryNumGpuDevices() {
+#ifdef ESP_GFX_EGL_DEVICES
+  auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+      eglGetProcAddress("eglQueryDevicesEXT"));
+  auto queryDeviceAttrib = reinterpret_cast<PFNEGLQUERYDEVICEATTRIBEXTPROC>(
+      eglGetProcAddress("eglQueryDeviceAttribEXT"));
+  EGLint count = 0;
+  if (!queryDevices || !queryDeviceAttrib ||
+      !queryDevices(0, nullptr, &count)) {
+    LOG(WARNING) << "numGpuDevices: EGL cannot enumerate devices, assuming 1";
+    return 1;
+  }
+  std::vector<EGLDeviceEXT> devices(count);
+  queryDevices(count, devices.data(), &count);
+
+  // the contexts are placed by CUDA device, other EGL devices such as the
+  // software rasterizer can't be asked for
+  int numCudaDevices = 0;
+  for (EGLint i = 0; i < count; ++i) {
+    EGLAttrib cudaDevice;
+    if (queryDeviceAttrib(devices[i], EGL_CUDA_DEVICE_NV, &cudaDevice)) {
+      ++numCudaDevices;
+    }
+  }
+  return std::max(numCudaDevices, 1);
+#else
+  return 1;
+#endif
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+bool queryGpuMemory(int device, size_t& freeMemory, size_t& totalMemory) {
+  int currentDevice;
+  if (cudaGetDevice(&currentDevice) != cudaSuccess) {
+    return false;
+  }
+  const bool success = cudaSetDevice(device) == cudaSuccess &&
+                       cudaMemGetInfo(&freeMemory, &totalMemory) == cudaSuccess;
+  cudaSetDevice(currentDevice);
+  return success;
+}
+#endif
+
+}  // namespace
+
+int numGpuDevices() {
+  static const int numDevices = queryNumGpuDevices();
+  return numDevices;
+}
+
+std::vector<GpuDeviceInfo> gpuDevices() {
+  std::vector<GpuDeviceInfo> devices(numGpuDevices());
+  GpuDeviceState& state = gpuDeviceState();
+  std::lock_guard<std::mutex> lock{state.mutex};
+  for (int i = 0; i < devices.size(); ++i) {
+    devices[i].device = i;
+    devices[i].numContexts = state.numContexts[i];
+#ifdef ESP_BUILD_WITH_CUDA
+    queryGpuMemory(i, devices[i].freeMemory, devices[i].totalMemory);
+#endif
+  }
+  return devices;
+}
+
+int selectGpuDevice(GpuDevicePolicy policy, int device) {
+  const int numDevices = numGpuDevices();
+  switch (policy) {
+    case GpuDevicePolicy::Fixed:
+      return device;
+
+    case GpuDevicePolicy::RoundRobin: {
+      GpuDeviceState& state = gpuDeviceState();
+      std::lock_guard<std::mutex> lock{state.mutex};
+      const int selected = state.nextDevice;
+      state.nextDevice = (selected + 1) % numDevices;
+      return selected;
+    }
+
+    case GpuDevicePolicy::LeastLoaded: {
+      const auto lessLoaded = [](const GpuDeviceInfo& a,
+                                 const GpuDeviceInfo& b) {
+        if (a.numContexts != b.numContexts) {
+          return a.numContexts < b.numContexts;
+        }
+        return a.freeMemory > b.freeMemory;
+      };
+      const std::vector<GpuDeviceInfo> devices = gpuDevices();
+      return std::min_element(devices.begin(), devices.end(), lessLoaded)
+          ->device;
+    }
+
+    case GpuDevicePolicy::CudaColocated: {
+#ifdef ESP_BUILD_WITH_CUDA
+      int cudaDevice;
+      if (cudaGetDevice(&cudaDevice) == cudaSuccess &&
+          cudaDevice < numDevices) {
+        return cudaDevice;
+      }
+      LOG(WARNING) << "selectGpuDevice: no current CUDA device, using device "
+                   << device;
+#else
+      LOG(WARNING) << "selectGpuDevice: built without CUDA, using device "
+                   << device;
+#endif
+      return device;
+    }
+  }
+  return device;
+}
+
+void addGpuDeviceContext(int device) {
+  GpuDeviceState& state = gpuDeviceState();
+  std::lock_guard<std::mutex> lock{state.mutex};
+  ++state.numContexts[device];
+}
+
+void removeGpuDeviceContext(int device) {
+  GpuDeviceState& state = gpuDeviceState();
+  std::lock_guard<std::mutex> lock{state.mutex};
+  --state.numContexts[device];
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,134 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_GPUDEVICES_H_
+#define ESP_GFX_GPUDEVICES_H_
+
+/** @file
+ * @brief Enum @ref esp::gfx::GpuDevicePolicy, struct @ref
+ * esp::gfx::GpuDeviceInfo, @ref esp::gfx::GpuMemoryUsage, functions @ref
+ * esp::gfx::gpuDevices(), @ref esp::gfx::selectGpuDevice()
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief How @ref selectGpuDevice() places a new OpenGL context
+ */
+enum class GpuDevicePolicy {
+  /**
+   * The device asked for, e.g. @ref sim::SimulatorConfiguration::gpuDeviceId
+   */
+  Fixed,
+  /** The devices in turn, one after the other */
+  RoundRobin,
+  /**
+   * The device with the fewest contexts of this process, the one with the
+   * most free memory of those if it is known, see @ref gpuDevices()
+   */
+  LeastLoaded,
+  /**
+   * The current CUDA device of the calling thread, i.e. the one a training
+   * framework such as PyTorch computes on. The device asked for if built
+   * without CUDA.
+   */
+  CudaColocated,
+};
+
+/**
+ * @brief A GPU the OpenGL contexts can be created on
+ */
+struct GpuDeviceInfo {
+  //! The CUDA device ID, as passed to @ref WindowlessContext
+  int device = 0;
+  //! Total memory in bytes, 0 if unknown, i.e. built without CUDA
+  size_t totalMemory = 0;
+  //! Free memory in bytes, 0 if unknown
+  size_t freeMemory = 0;
+  //! The number of @ref WindowlessContext instances of this process on it
+  int numContexts = 0;
+};
+
+/**
+ * @brief GPU memory allocated for a simulator, in bytes, by what it holds
+ *
+ * Estimated from the sizes and formats of the allocations, the driver may
+ * round them up and keeps its own memory besides.
+ */
+struct GpuMemoryUsage {
+  //! Vertex and index buffers of the loaded meshes
+  size_t meshBytes = 0;
+  //! Textures of the loaded assets, with their mip levels
+  size_t textureBytes = 0;
+  //! PTex atlas textures, uploaded or resident in the streaming cache
+  size_t ptexAtlasBytes = 0;
+  //! Color, ObjectID, depth, unprojection and readback buffers of the
+  //! render targets of the sensors
+  size_t renderTargetBytes = 0;
+  //! Device buffers of the CUDA depth and color noise models
+  size_t noiseModelBytes = 0;
+
+  /** @brief The sum of all of the above */
+  size_t totalBytes() const {
+    return meshBytes + textureBytes + ptexAtlasBytes + renderTargetBytes +
+           noiseModelBytes;
+  }
+
+  GpuMemoryUsage& operator+=(const GpuMemoryUsage& other) {
+    meshBytes += other.meshBytes;
+    textureBytes += other.textureBytes;
+    ptexAtlasBytes += other.ptexAtlasBytes;
+    renderTargetBytes += other.renderTargetBytes;
+    noiseModelBytes += other.noiseModelBytes;
+    return *this;
+  }
+};
+
+/**
+ * @brief The number of GPUs contexts can be created on.
+ *
+ * The EGL devices with a CUDA device when built with EGL support, always 1
+ * with GLX or on other platforms.
+ */
+int numGpuDevices();
+
+/**
+ * @brief The GPUs contexts can be created on, with their memory and load.
+ *
+ * Querying the free memory initializes the CUDA context of each device.
+ */
+std::vector<GpuDeviceInfo> gpuDevices();
+
+/**
+ * @brief The device to create a new context on.
+ * @param policy How to pick the device
+ * @param device The device for @ref GpuDevicePolicy::Fixed, and the fallback
+ * if the policy cannot be applied
+ *
+ * Thread-safe. Only the contexts created so far count for the load, so create
+ * a context before selecting the device of the next one.
+ */
+int selectGpuDevice(GpuDevicePolicy policy, int device = 0);
+
+/**
+ * @brief Count a new context on @p device, called by @ref WindowlessContext
+ */
+void addGpuDeviceContext(int device);
+
+/**
+ * @brief Stop counting a context on @p device, called by @ref
+ * WindowlessContext
+ */
+void removeGpuDeviceContext(int device);
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_GPUDEVICES_H_
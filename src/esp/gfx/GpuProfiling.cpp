@@ -0,0 +1,98 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "GpuProfiling.h"
+
+#include <chrono>
+#include <vector>
+
+#include <Magnum/GL/TimeQuery.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+#ifndef MAGNUM_TARGET_WEBGL
+namespace {
+struct PendingQuery {
+  core::ProfilingStage stage;
+  Mn::GL::TimeQuery query;
+  //! when the CPU issued the work, the GPU has no common clock with it
+  core::Tracer::Clock::time_point issued;
+  bool profiled;
+  bool traced;
+};
+
+//! queries issued but not added to the profiler yet, in issue order
+std::vector<PendingQuery>& pendingQueries() {
+  // never destroyed, the GL context is gone by the time statics are
+  static auto* queries = new std::vector<PendingQuery>;
+  return *queries;
+}
+}  // namespace
+#endif
+
+ScopedGpuTimer::ScopedGpuTimer(core::ProfilingStage stage)
+    : cpuTimer_{stage},
+      stage_{stage},
+      active_{core::Profiler::isEnabled() || core::Tracer::isTracing()} {
+#ifndef MAGNUM_TARGET_WEBGL
+  if (active_) {
+    // keep the list short without stalling on unfinished queries
+    collectGpuTimings();
+    pendingQueries().push_back(
+        {stage_, Mn::GL::TimeQuery{Mn::GL::TimeQuery::Target::TimeElapsed},
+         cpuTimer_.start(), core::Profiler::isEnabled(),
+         core::Tracer::isTracing()});
+    pendingQueries().back().query.begin();
+  }
+#endif
+}
+
+ScopedGpuTimer::~ScopedGpuTimer() {
+#ifndef MAGNUM_TARGET_WEBGL
+  if (active_) {
+    pendingQueries().back().query.end();
+  }
+#endif
+}
+
+void collectGpuTimings(bool wait) {
+#ifndef MAGNUM_TARGET_WEBGL
+  auto& queries = pendingQueries();
+  size_t numCollected = 0;
+  // queries finish in issue order, stop at the first unfinished one
+  for (PendingQuery& query : queries) {
+    if (!wait && !query.query.resultAvailable()) {
+      break;
+    }
+    const Mn::UnsignedLong nanoseconds =
+        query.query.result<Mn::UnsignedLong>();
+    if (query.profiled) {
+      core::Profiler::addGpuTime(query.stage, nanoseconds * 1.0e-6);
+    }
+    if (query.traced) {
+      // shown from when it was issued, the GPU may have started it later
+      core::Tracer::addEvent(
+          core::profilingStageName(query.stage), "gpu", query.issued,
+          query.issued + std::chrono::nanoseconds{nanoseconds},
+          core::Tracer::GpuTrack);
+    }
+    ++numCollected;
+  }
+  queries.erase(queries.begin(), queries.begin() + numCollected);
+#else
+  static_cast<void>(wait);
+#endif
+}
+
+void discardGpuTimings() {
+#ifndef MAGNUM_TARGET_WEBGL
+  pendingQueries().clear();
+#endif
+}
+
+}  // namespace gfx
+}  // namespace esp
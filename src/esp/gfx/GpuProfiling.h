@@ -0,0 +1,56 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_GPUPROFILING_H_
+#define ESP_GFX_GPUPROFILING_H_
+
+#include "esp/core/Profiling.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Adds both the CPU and the GPU time of its scope to a @ref
+ * core::ProfilingStage
+ *
+ * The GPU time is measured with a timer query, whose result is only added to
+ * the @ref core::Profiler once the GPU has finished the work, see @ref
+ * collectGpuTimings(). Timer queries cannot be nested, so scopes of this type
+ * must not be either. Does not issue any query while the profiler is
+ * disabled and no @ref core::Tracer trace is recorded; while one is, the GPU
+ * time is also an event of its GPU track. GPU times are not measured on
+ * WebGL.
+ */
+class ScopedGpuTimer {
+ public:
+  explicit ScopedGpuTimer(core::ProfilingStage stage);
+  ~ScopedGpuTimer();
+
+  ScopedGpuTimer(const ScopedGpuTimer&) = delete;
+  ScopedGpuTimer& operator=(const ScopedGpuTimer&) = delete;
+
+ private:
+  core::ScopedTimer cpuTimer_;
+  const core::ProfilingStage stage_;
+  const bool active_;
+};
+
+/**
+ * @brief Add the results of finished GPU timer queries to the @ref
+ * core::Profiler and the @ref core::Tracer
+ * @param wait Whether to wait for queries the GPU has not finished yet
+ */
+void collectGpuTimings(bool wait = false);
+
+/**
+ * @brief Drop all pending GPU timer queries. Must be called before the GL
+ * context they were issued in is destroyed.
+ */
+void discardGpuTimings();
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_GPUPROFILING_H_
@@ -0,0 +1,219 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "IndirectDrawBatch.h"
+
+#include <algorithm>
+#include <string>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/OpenGL.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/Version.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Math/Vector4.h>
+#include <Magnum/Shaders/Generic.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/Drawable.h"
+#include "esp/scene/SceneNode.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+static void importShaderResources() {
+  CORRADE_RESOURCE_INITIALIZE(ShaderResources)
+}
+
+namespace esp {
+namespace gfx {
+
+namespace {
+//! the layout of a GL DrawElementsIndirectCommand
+struct DrawCommand {
+  Mn::UnsignedInt count;
+  Mn::UnsignedInt instanceCount;
+  Mn::UnsignedInt firstIndex;
+  Mn::Int baseVertex;
+  Mn::UnsignedInt baseInstance;
+};
+static_assert(sizeof(DrawCommand) == 5 * 4,
+              "the commands have to be tightly packed for the shader");
+
+enum : Mn::UnsignedInt { BoundsBinding = 0, CommandsBinding = 1 };
+}  // namespace
+
+constexpr Mn::UnsignedInt IndirectCullingShader::GroupSize;
+
+IndirectCullingShader::IndirectCullingShader() {
+#ifndef MAGNUM_TARGET_GLES
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+  Mn::GL::Shader comp{Mn::GL::Version::GL430, Mn::GL::Shader::Type::Compute};
+  comp.addSource("#define GROUP_SIZE " + std::to_string(GroupSize) + "\n")
+      .addSource(rs.get("indirect-culling.comp"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(comp.compile());
+
+  attachShader(comp);
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  frustumPlanesUniform_ = uniformLocation("frustumPlanes");
+  drawCountUniform_ = uniformLocation("drawCount");
+#else
+  CORRADE_ASSERT_UNREACHABLE();
+#endif
+}
+
+IndirectCullingShader& IndirectCullingShader::setFrustum(
+    const Mn::Frustum& frustum) {
+  Mn::Vector4 planes[6];
+  for (std::size_t i = 0; i != 6; ++i) {
+    planes[i] = frustum[i];
+  }
+  setUniform(frustumPlanesUniform_, planes);
+  return *this;
+}
+
+IndirectCullingShader& IndirectCullingShader::setDrawCount(
+    Mn::UnsignedInt count) {
+  setUniform(drawCountUniform_, count);
+  return *this;
+}
+
+bool IndirectDrawBatch::isSupported() {
+#ifndef MAGNUM_TARGET_GLES
+  return Mn::GL::Context::hasCurrent() &&
+         Mn::GL::Context::current().isVersionSupported(Mn::GL::Version::GL430);
+#else
+  return false;
+#endif
+}
+
+IndirectDrawBatch::IndirectDrawBatch(const std::vector<Drawable*>& drawables)
+    : drawCount_{Mn::UnsignedInt(drawables.size())},
+      vertices_{Mn::GL::Buffer::TargetHint::Array},
+      indices_{Mn::GL::Buffer::TargetHint::ElementArray},
+#ifndef MAGNUM_TARGET_GLES
+      bounds_{Mn::GL::Buffer::TargetHint::ShaderStorage},
+      commands_{Mn::GL::Buffer::TargetHint::DrawIndirect}
+#else
+      bounds_{Mn::NoCreate},
+      commands_{Mn::NoCreate}
+#endif
+{
+  CORRADE_INTERNAL_ASSERT(isSupported());
+
+  std::size_t vertexCount = 0;
+  std::size_t indexCount = 0;
+  for (Drawable* drawable : drawables) {
+    vertexCount += drawable->getIndirectPositions().size();
+    indexCount += drawable->getIndirectIndices().size();
+  }
+
+  // the indices stay local to each drawable, the commands offset them
+  Cr::Containers::Array<Mn::Vector3> positions{Cr::NoInit, vertexCount};
+  Cr::Containers::Array<Mn::UnsignedInt> indices{Cr::NoInit, indexCount};
+  Cr::Containers::Array<Mn::Vector4> bounds{Cr::NoInit, 2 * drawables.size()};
+  Cr::Containers::Array<DrawCommand> commands{Cr::NoInit, drawables.size()};
+  std::size_t vertexOffset = 0;
+  std::size_t indexOffset = 0;
+  for (std::size_t i = 0; i != drawables.size(); ++i) {
+    scene::SceneNode& node = drawables[i]->getSceneNode();
+    const Mn::Matrix4 transformation = node.absoluteTransformationMatrix();
+    const auto drawablePositions = drawables[i]->getIndirectPositions();
+    const auto drawableIndices = drawables[i]->getIndirectIndices();
+    for (std::size_t j = 0; j != drawablePositions.size(); ++j) {
+      positions[vertexOffset + j] =
+          transformation.transformPoint(drawablePositions[j]);
+    }
+    std::copy(drawableIndices.begin(), drawableIndices.end(),
+              indices.begin() + indexOffset);
+
+    const Cr::Containers::Optional<Mn::Range3D> aabb = node.getAbsoluteAABB();
+    CORRADE_INTERNAL_ASSERT(aabb);
+    bounds[2 * i] = Mn::Vector4{aabb->min(), 0.0f};
+    bounds[2 * i + 1] = Mn::Vector4{aabb->max(), 0.0f};
+    commands[i] = DrawCommand{Mn::UnsignedInt(drawableIndices.size()), 1,
+                              Mn::UnsignedInt(indexOffset),
+                              Mn::Int(vertexOffset), 0};
+    vertexOffset += drawablePositions.size();
+    indexOffset += drawableIndices.size();
+  }
+
+#ifndef MAGNUM_TARGET_GLES
+  vertices_.setData(positions, Mn::GL::BufferUsage::StaticDraw);
+  indices_.setData(indices, Mn::GL::BufferUsage::StaticDraw);
+  bounds_.setData(bounds, Mn::GL::BufferUsage::StaticDraw);
+  commands_.setData(commands, Mn::GL::BufferUsage::DynamicCopy);
+  mesh_.setPrimitive(Mn::MeshPrimitive::Triangles)
+      .addVertexBuffer(vertices_, 0, Mn::Shaders::Generic3D::Position{})
+      .setIndexBuffer(indices_, 0, Mn::MeshIndexType::UnsignedInt);
+#endif
+  gpuBytes_ = positions.size() * sizeof(Mn::Vector3) +
+              indices.size() * sizeof(Mn::UnsignedInt) +
+              bounds.size() * sizeof(Mn::Vector4) +
+              commands.size() * sizeof(DrawCommand);
+}
+
+std::size_t IndirectDrawBatch::getGpuBytes() const {
+  return gpuBytes_;
+}
+
+void IndirectDrawBatch::draw(IndirectCullingShader& cullingShader,
+                             DepthShader& shader,
+                             const Mn::Matrix4& cameraMatrix,
+                             const Mn::Frustum& frustum) {
+#ifndef MAGNUM_TARGET_GLES
+  // the culling sets the instance count of each command, zero if culled
+  bounds_.bind(Mn::GL::Buffer::Target::ShaderStorage, BoundsBinding);
+  commands_.bind(Mn::GL::Buffer::Target::ShaderStorage, CommandsBinding);
+  cullingShader.setFrustum(frustum).setDrawCount(drawCount_).dispatchCompute(
+      {(drawCount_ + IndirectCullingShader::GroupSize - 1) /
+           IndirectCullingShader::GroupSize,
+       1, 1});
+  Mn::GL::Renderer::setMemoryBarrier(
+      Mn::GL::Renderer::MemoryBarrier::Command);
+
+  // the positions are in world space already
+  shader.setTransformationMatrix(cameraMatrix);
+
+  // Magnum has no indirect multi-draws, the draw is made on the raw GL
+  // state, which Magnum is told about around it
+  Mn::GL::Context& context = Mn::GL::Context::current();
+  context.resetState(Mn::GL::Context::State::EnterExternal);
+  glUseProgram(shader.id());
+  glBindVertexArray(mesh_.id());
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_.id());
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                              GLsizei(drawCount_), 0);
+  // a single draw call however many drawables it has
+  core::Profiler::increment(core::ProfilingCounter::DrawCalls);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+  glUseProgram(0);
+  context.resetState(Mn::GL::Context::State::ExitExternal);
+#else
+  static_cast<void>(cullingShader);
+  static_cast<void>(shader);
+  static_cast<void>(cameraMatrix);
+  static_cast<void>(frustum);
+  CORRADE_ASSERT_UNREACHABLE();
+#endif
+}
+
+}  // namespace gfx
+}  // namespace esp
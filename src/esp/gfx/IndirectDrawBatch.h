@@ -0,0 +1,137 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_INDIRECTDRAWBATCH_H_
+#define ESP_GFX_INDIRECTDRAWBATCH_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::IndirectCullingShader, class @ref
+ * esp::gfx::IndirectDrawBatch
+ */
+
+#include <vector>
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Frustum.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+class DepthShader;
+class Drawable;
+
+/**
+@brief Compute shader culling the drawables of an @ref IndirectDrawBatch
+
+Tests the world space bounds of each drawable against a frustum and sets the
+instance count of its indirect draw command to one if they intersect it and
+to zero otherwise, the same test as @ref DrawableGroup::cull().
+*/
+class IndirectCullingShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  /** @brief The number of drawables each work group culls */
+  static constexpr Magnum::UnsignedInt GroupSize = 64;
+
+  explicit IndirectCullingShader();
+
+  /**
+   * @brief Set the frustum to cull against, in world space
+   * @return Reference to self (for method chaining)
+   */
+  IndirectCullingShader& setFrustum(const Magnum::Frustum& frustum);
+
+  /**
+   * @brief Set the number of drawables to cull
+   * @return Reference to self (for method chaining)
+   */
+  IndirectCullingShader& setDrawCount(Magnum::UnsignedInt count);
+
+ private:
+  int frustumPlanesUniform_;
+  int drawCountUniform_;
+};
+
+/**
+@brief The static drawables of a @ref DrawableGroup, culled on the GPU and
+drawn with a single multi-draw
+
+The triangles of the drawables, set by @ref Drawable::setIndirectGeometry(),
+are transformed to world space once and packed into one vertex and one index
+buffer, with an indirect draw command and the absolute AABB of the node of
+each drawable in shader storage buffers. @ref draw() then culls
+them with an @ref IndirectCullingShader and draws the visible ones with
+@cpp glMultiDrawElementsIndirect() @ce, so that its CPU cost does not grow
+with the number of drawables. Only positions are packed, the batch draws
+depth with a @ref DepthShader. The drawables are expected not to move, a
+moved node needs a new batch, see @ref DrawableGroup::invalidateCullingBVH().
+*/
+class IndirectDrawBatch {
+ public:
+  /**
+   * @brief Whether the GPU supports compute shaders and indirect
+   * multi-draws, i.e. OpenGL 4.3
+   *
+   * Always false on OpenGL ES and WebGL.
+   */
+  static bool isSupported();
+
+  /**
+   * @brief Constructor
+   * @param drawables Drawables with indirect geometry and an absolute AABB,
+   * see @ref scene::SceneNode::getAbsoluteAABB()
+   *
+   * Expects that @ref isSupported() is true.
+   */
+  explicit IndirectDrawBatch(const std::vector<Drawable*>& drawables);
+
+  /**
+   * @brief The number of drawables in the batch
+   */
+  Magnum::UnsignedInt size() const { return drawCount_; }
+
+  /**
+   * @brief Estimated GPU memory of the batch, in bytes
+   */
+  std::size_t getGpuBytes() const;
+
+  /**
+   * @brief Cull the drawables against @p frustum and draw the visible ones
+   * @param cullingShader The shader culling the drawables
+   * @param shader The shader drawing their depth, with the projection
+   *    matrix of the camera set already
+   * @param cameraMatrix The transformation from world to camera space
+   * @param frustum The frustum in world space
+   *
+   * Draws into the bound framebuffer with the current GL state.
+   */
+  void draw(IndirectCullingShader& cullingShader,
+            DepthShader& shader,
+            const Magnum::Matrix4& cameraMatrix,
+            const Magnum::Frustum& frustum);
+
+ private:
+  Magnum::UnsignedInt drawCount_ = 0;
+  //! world space positions and indices of all drawables
+  Magnum::GL::Buffer vertices_;
+  Magnum::GL::Buffer indices_;
+  //! min and max corner of the AABB of each drawable, as vec4s
+  Magnum::GL::Buffer bounds_;
+  //! the indirect draw command of each drawable, culled in place
+  Magnum::GL::Buffer commands_;
+  //! binds the vertex and index buffer for the multi-draw
+  Magnum::GL::Mesh mesh_;
+  std::size_t gpuBytes_ = 0;
+
+  ESP_SMART_POINTERS(IndirectDrawBatch)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_INDIRECTDRAWBATCH_H_
@@ -0,0 +1,220 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "InstancedDrawable.h"
+
+#include <algorithm>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Intersection.h>
+#include <Magnum/Math/Matrix3.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/SceneGraph/AbstractFeature.h>
+#include <Magnum/SceneGraph/AbstractObject.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/RenderCamera.h"
+#include "esp/scene/SceneNode.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Feature on the node of an instance. Its lifetime is bound to the
+ * node, so it removes the instance from the drawable once the node goes away.
+ */
+class InstancedDrawable::Instance : public Mn::SceneGraph::AbstractFeature3D {
+ public:
+  Instance(scene::SceneNode& node,
+           InstancedDrawable& drawable,
+           Mn::Int textureLayerOffset)
+      : Mn::SceneGraph::AbstractFeature3D{node},
+        drawable_{&drawable},
+        textureLayerOffset_{textureLayerOffset} {}
+
+  ~Instance() {
+    if (drawable_) {
+      drawable_->removeInstance(*this);
+    }
+  }
+
+  scene::SceneNode& node() { return static_cast<scene::SceneNode&>(object()); }
+
+  //! the drawable this instance belongs to, nullptr once it was destroyed
+  InstancedDrawable* drawable_;
+  //! the layer of the texture arrays of the instance, relative to the one
+  //! of the material of the drawable
+  Mn::Int textureLayerOffset_;
+};
+
+InstancedDrawable::InstancedDrawable(scene::SceneNode& node,
+                                     Mn::GL::Mesh& mesh,
+                                     Mn::GL::Buffer& instanceBuffer,
+                                     ShaderManager& shaderManager,
+                                     const Mn::ResourceKey& lightSetup,
+                                     const Mn::ResourceKey& materialData,
+                                     DrawableGroup* group /* = nullptr */)
+    : GenericDrawable{node,       mesh,         shaderManager,
+                      lightSetup, materialData, group},
+      instanceBuffer_{instanceBuffer} {
+  CORRADE_ASSERT(!materialData_->perVertexObjectId,
+                 "InstancedDrawable: materials with per-vertex object ids "
+                 "are not supported", );
+  // the base class constructor could only fetch the non-instanced variant
+  updateShader();
+}
+
+InstancedDrawable::~InstancedDrawable() {
+  // the nodes of the instances may outlive this drawable
+  for (Instance* instance : instances_) {
+    instance->drawable_ = nullptr;
+  }
+}
+
+void InstancedDrawable::setupInstanceBuffer(Mn::GL::Mesh& mesh,
+                                            Mn::GL::Buffer& instanceBuffer) {
+  mesh.addVertexBufferInstanced(instanceBuffer, 1, 0,
+                                Mn::Shaders::Phong::TransformationMatrix{},
+                                Mn::Shaders::Phong::NormalMatrix{},
+                                Mn::Shaders::Phong::ObjectId{},
+                                Mn::Shaders::Phong::TextureOffsetLayer{});
+}
+
+void InstancedDrawable::addInstance(scene::SceneNode& node,
+                                    Mn::UnsignedInt textureLayer) {
+  // the feature is owned by the node
+  // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
+  // relative to the layer of the material, so that instances added before
+  // the textures of the material were packed draw with its layer
+  instances_.push_back(
+      new Instance{node, *this,
+                   Mn::Int(textureLayer) -
+                       Mn::Int(materialData_->textureLayer)});
+}
+
+void InstancedDrawable::removeInstance(Instance& instance) {
+  auto it = std::find(instances_.begin(), instances_.end(), &instance);
+  if (it != instances_.end()) {
+    *it = instances_.back();
+    instances_.pop_back();
+  }
+}
+
+Mn::Shaders::Phong::Flags InstancedDrawable::getShaderFlags() {
+  Mn::Shaders::Phong::Flags flags =
+      GenericDrawable::getShaderFlags() |
+      Mn::Shaders::Phong::Flag::InstancedTransformation |
+      Mn::Shaders::Phong::Flag::InstancedObjectId;
+  if (flags & Mn::Shaders::Phong::Flag::TextureArrays)
+    flags |= Mn::Shaders::Phong::Flag::InstancedTextureOffset;
+  return flags;
+}
+
+Mn::Shaders::Flat3D::Flags InstancedDrawable::getFlatShaderFlags(
+    RenderCamera::Shading shading) {
+  Mn::Shaders::Flat3D::Flags flags =
+      GenericDrawable::getFlatShaderFlags(shading) |
+      Mn::Shaders::Flat3D::Flag::InstancedTransformation |
+      Mn::Shaders::Flat3D::Flag::InstancedObjectId;
+  if (flags & Mn::Shaders::Flat3D::Flag::TextureArrays)
+    flags |= Mn::Shaders::Flat3D::Flag::InstancedTextureOffset;
+  return flags;
+}
+
+void InstancedDrawable::draw(const Mn::Matrix4& transformationMatrix,
+                             Mn::SceneGraph::Camera3D& camera) {
+  previousNumVisibleInstances_ = 0;
+  if (instances_.empty()) {
+    return;
+  }
+
+  updateShaderIfLightSetupChanged();
+
+  // transformations of all instances relative to the camera, in one pass
+  std::vector<std::reference_wrapper<Mn::SceneGraph::AbstractObject3D>>
+      objects;
+  objects.reserve(instances_.size());
+  for (Instance* instance : instances_) {
+    objects.emplace_back(instance->node());
+  }
+  Mn::SceneGraph::AbstractObject3D* scene = camera.object().scene();
+  CORRADE_INTERNAL_ASSERT(scene);
+  const std::vector<Mn::Matrix4> transformations =
+      scene->transformationMatrices(objects, camera.cameraMatrix());
+
+  // cull in world space with the boxes cached until an instance moves,
+  // instances without a mesh bounding box are kept
+  const Mn::Frustum frustum = Mn::Frustum::fromMatrix(
+      camera.projectionMatrix() * camera.cameraMatrix());
+  const bool useDrawableIds =
+      static_cast<RenderCamera&>(camera).useDrawableIds();
+  std::vector<InstanceData> instanceData;
+  instanceData.reserve(instances_.size());
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    scene::SceneNode& node = instances_[i]->node();
+    Cr::Containers::Optional<Mn::Range3D> aabb = node.getWorldAABB();
+    if (aabb && !Mn::Math::Intersection::rangeFrustum(*aabb, frustum)) {
+      continue;
+    }
+    instanceData.push_back(InstanceData{
+        transformations[i], transformations[i].rotationScaling(),
+        static_cast<Mn::UnsignedInt>(useDrawableIds ? drawableId_
+                                                    : node.getSemanticId()),
+        Mn::Vector3{0.0f, 0.0f,
+                    Mn::Float(instances_[i]->textureLayerOffset_)}});
+  }
+  previousNumVisibleInstances_ = instanceData.size();
+  if (instanceData.empty()) {
+    return;
+  }
+
+  instanceBuffer_.setData(instanceData, Mn::GL::BufferUsage::DynamicDraw);
+
+  if (DepthShader* depthShader =
+          static_cast<RenderCamera&>(camera).instancedLinearDepthShader()) {
+    depthShader->setTransformationMatrix(Mn::Matrix4{});
+    mesh_.setInstanceCount(instanceData.size());
+    depthShader->draw(mesh_);
+    core::Profiler::increment(core::ProfilingCounter::DrawCalls);
+    mesh_.setInstanceCount(1);
+    return;
+  }
+
+  mesh_.setInstanceCount(instanceData.size());
+  const RenderCamera::Shading shading =
+      static_cast<RenderCamera&>(camera).shading();
+  if (shading != RenderCamera::Shading::Phong) {
+    // the object IDs and texture layer offsets are per instance
+    Mn::Shaders::Flat3D& flatShader = updateFlatShader(shading, 0);
+    flatShader.setTransformationProjectionMatrix(camera.projectionMatrix())
+        .draw(mesh_);
+    core::Profiler::increment(core::ProfilingCounter::DrawCalls);
+    mesh_.setInstanceCount(1);
+    return;
+  }
+
+  updateShaderLightingParameters(transformationMatrix, camera);
+
+  // the per-instance transformations are already relative to the camera
+  (*shader_)
+      .setTransformationMatrix(Mn::Matrix4{})
+      .setNormalMatrix(Mn::Matrix3x3{});
+
+  bindMaterialTextures();
+  // the per-instance layer offsets are added to the uniform layer, set by
+  // bindMaterialTextures()
+
+  shader_->draw(mesh_);
+  core::Profiler::increment(core::ProfilingCounter::DrawCalls);
+  // the mesh is shared with non-instanced drawables
+  mesh_.setInstanceCount(1);
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,125 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_INSTANCEDDRAWABLE_H_
+#define ESP_GFX_INSTANCEDDRAWABLE_H_
+
+#include <vector>
+
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/gfx/GenericDrawable.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Draws many instances of one mesh with one material in a single
+ * instanced draw call.
+ *
+ * The drawable itself is attached to an anchor node, every instance is a
+ * separate @ref scene::SceneNode registered with @ref addInstance(). On draw,
+ * the instances are culled against the camera frustum with the mesh bounding
+ * box of their node, and the transformations and object ids of the remaining
+ * ones are uploaded into a per-instance buffer. The object id of an instance
+ * is the semantic id of its node, or the drawable id of this drawable if the
+ * camera uses drawable ids.
+ *
+ * Materials with texture arrays, see @ref PhongMaterialData::textureLayer,
+ * draw each instance with its own layer, so materials which differ only in
+ * the layer can be drawn by one drawable.
+ *
+ * An instance is removed automatically when its node is destroyed. Lights
+ * with an object-relative position are placed relative to the anchor node.
+ * Materials with per-vertex object ids are not supported, as these use the
+ * same vertex attribute as the per-instance object ids.
+ */
+class InstancedDrawable : public GenericDrawable {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param node Anchor node, the instances are independent of its
+   * transformation
+   * @param mesh Mesh to draw on render, see @ref setupInstanceBuffer()
+   * @param instanceBuffer Per-instance buffer bound to @p mesh by @ref
+   * setupInstanceBuffer(). Drawables sharing a mesh must share this buffer as
+   * well.
+   * @param shaderManager Shader manager to fetch the shader variant from
+   * @param lightSetup Light setup key
+   * @param materialData Material key
+   * @param group Drawable group this drawable will be added to
+   */
+  explicit InstancedDrawable(scene::SceneNode& node,
+                             Magnum::GL::Mesh& mesh,
+                             Magnum::GL::Buffer& instanceBuffer,
+                             ShaderManager& shaderManager,
+                             const Magnum::ResourceKey& lightSetup,
+                             const Magnum::ResourceKey& materialData,
+                             DrawableGroup* group = nullptr);
+  virtual ~InstancedDrawable();
+
+  /**
+   * @brief Bind the per-instance attributes of a mesh to a buffer. Must be
+   * done once per mesh before any @ref InstancedDrawable draws it.
+   */
+  static void setupInstanceBuffer(Magnum::GL::Mesh& mesh,
+                                  Magnum::GL::Buffer& instanceBuffer);
+
+  /**
+   * @brief Add an instance drawn at the transformation of @p node
+   * @param node The node of the instance
+   * @param textureLayer The layer of the texture arrays of the material to
+   * draw the instance with, if it has any
+   */
+  void addInstance(scene::SceneNode& node,
+                   Magnum::UnsignedInt textureLayer = 0);
+
+  /**
+   * @brief The number of instances
+   */
+  size_t getInstanceCount() const { return instances_.size(); }
+
+  /**
+   * @brief The number of instances which passed the frustum culling in the
+   * most recent draw
+   */
+  size_t getPreviousNumVisibleInstances() const {
+    return previousNumVisibleInstances_;
+  }
+
+ protected:
+  /** @brief Per-node feature tracking an instance */
+  class Instance;
+  friend class Instance;
+
+  void draw(const Magnum::Matrix4& transformationMatrix,
+            Magnum::SceneGraph::Camera3D& camera) override;
+
+  Magnum::Shaders::Phong::Flags getShaderFlags() override;
+
+  Magnum::Shaders::Flat3D::Flags getFlatShaderFlags(
+      RenderCamera::Shading shading) override;
+
+  void removeInstance(Instance& instance);
+
+  //! layout of an instance in the per-instance buffer
+  struct InstanceData {
+    Magnum::Matrix4 transformation;
+    Magnum::Matrix3x3 normalMatrix;
+    Magnum::UnsignedInt objectId;
+    //! texture offset, always zero, and layer
+    Magnum::Vector3 textureOffsetLayer;
+  };
+
+  Magnum::GL::Buffer& instanceBuffer_;
+  std::vector<Instance*> instances_;
+  size_t previousNumVisibleInstances_ = 0;
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_INSTANCEDDRAWABLE_H_
@@ -4,9 +4,24 @@
 
 #include "LightSetup.h"
 
+#include <atomic>
+
 namespace esp {
 namespace gfx {
 
+namespace {
+//! starts above 0, the version of what was never updated
+std::atomic<uint64_t> lightSetupVersion{1};
+}  // namespace
+
+uint64_t getLightSetupVersion() {
+  return lightSetupVersion.load(std::memory_order_relaxed);
+}
+
+void markLightSetupsChanged() {
+  lightSetupVersion.fetch_add(1, std::memory_order_relaxed);
+}
+
 bool operator==(const LightInfo& a, const LightInfo& b) {
   return a.vector == b.vector && a.color == b.color && a.model == b.model;
 }
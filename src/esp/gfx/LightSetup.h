@@ -5,6 +5,8 @@
 #ifndef ESP_GFX_LIGHTSETUP_H_
 #define ESP_GFX_LIGHTSETUP_H_
 
+#include <cstdint>
+
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Color.h>
 #include <Magnum/Math/Matrix4.h>
@@ -41,6 +43,22 @@ bool operator!=(const LightInfo& a, const LightInfo& b);
 //! A set of LightInfos.
 using LightSetup = std::vector<LightInfo>;
 
+/**
+ * @brief The version of the light setups of the process, incremented each
+ * time one is set, see @ref markLightSetupsChanged()
+ *
+ * Drawables and the cached light uniforms of the cameras compare it with the
+ * version they were updated at, instead of resolving their light setup and
+ * transforming its lights on every draw.
+ */
+uint64_t getLightSetupVersion();
+
+/**
+ * @brief Increment @ref getLightSetupVersion(), after a light setup is set in
+ * a @ref ShaderManager or changed in place
+ */
+void markLightSetupsChanged();
+
 /**
  * @brief Get position relative to a camera for a @ref LightInfo and a
  * rendered object. light.position and the return value are Vector4, with
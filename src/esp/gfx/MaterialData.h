@@ -6,6 +6,7 @@
 #define ESP_GFX_MATERIALDATA_H_
 
 #include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureArray.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Color.h>
 #include <Magnum/Math/Matrix3.h>
@@ -26,6 +27,19 @@ struct PhongMaterialData : public MaterialData {
   Magnum::GL::Texture2D *ambientTexture = nullptr, *diffuseTexture = nullptr,
                         *specularTexture = nullptr, *normalTexture = nullptr;
   bool perVertexObjectId = false, vertexColored = false;
+  //! the textures packed into layer @ref textureLayer of texture arrays,
+  //! instead of the separate textures above, see @ref TextureArrayPool
+  Magnum::GL::Texture2DArray *ambientTextureArray = nullptr,
+                             *diffuseTextureArray = nullptr,
+                             *specularTextureArray = nullptr,
+                             *normalTextureArray = nullptr;
+  Magnum::UnsignedInt textureLayer = 0;
+
+  //! whether the textures are in texture arrays
+  bool hasTextureArrays() const {
+    return ambientTextureArray || diffuseTextureArray ||
+           specularTextureArray || normalTextureArray;
+  }
 
   ESP_SMART_POINTERS(PhongMaterialData)
 };
@@ -4,6 +4,8 @@
 
 #include "MeshVisualizerDrawable.h"
 #include "Magnum/GL/Renderer.h"
+#include "esp/core/Profiling.h"
+#include "esp/gfx/RenderCamera.h"
 #include "esp/scene/SceneNode.h"
 
 namespace Mn = Magnum;
@@ -18,8 +20,20 @@ MeshVisualizerDrawable::MeshVisualizerDrawable(
     DrawableGroup* group)
     : Drawable{node, mesh, group}, shader_(shader) {}
 
+DrawState MeshVisualizerDrawable::getDrawState() {
+  DrawState state;
+  state.shader = &shader_;
+  state.mesh = &mesh_;
+  return state;
+}
+
 void MeshVisualizerDrawable::draw(const Magnum::Matrix4& transformationMatrix,
                                   Magnum::SceneGraph::Camera3D& camera) {
+  // the visualized mesh draws its own depth
+  if (static_cast<RenderCamera&>(camera).linearDepthShader()) {
+    return;
+  }
+
   Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::PolygonOffsetFill);
   Mn::GL::Renderer::setPolygonOffset(-5.0f, -5.0f);
 
@@ -27,6 +41,7 @@ void MeshVisualizerDrawable::draw(const Magnum::Matrix4& transformationMatrix,
       .setTransformationMatrix(transformationMatrix);
 
   shader_.draw(mesh_);
+  core::Profiler::increment(core::ProfilingCounter::DrawCalls);
 
   Mn::GL::Renderer::setPolygonOffset(0.0f, 0.0f);
   Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::PolygonOffsetFill);
@@ -28,6 +28,8 @@ class MeshVisualizerDrawable : public Drawable {
                                   Magnum::GL::Mesh& mesh,
                                   gfx::DrawableGroup* group);
 
+  DrawState getDrawState() override;
+
  protected:
   /**
    * @brief Draw the object using given camera
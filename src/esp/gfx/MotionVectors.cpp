@@ -0,0 +1,30 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "MotionVectors.h"
+
+#include <utility>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+void MotionVectorHistory::beginFrame() {
+  // only the last frame is kept, so the stale pointer of a removed drawable
+  // is forgotten after one frame
+  previous_ = std::move(current_);
+  current_.clear();
+}
+
+Mn::Matrix4 MotionVectorHistory::update(
+    const Mn::SceneGraph::Drawable3D& drawable,
+    const Mn::Matrix4& transformationProjection) {
+  current_[&drawable] = transformationProjection;
+  auto found = previous_.find(&drawable);
+  return found == previous_.end() ? transformationProjection : found->second;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,83 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_MOTIONVECTORS_H_
+#define ESP_GFX_MOTIONVECTORS_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::MotionVectorHistory
+ */
+
+#include <unordered_map>
+
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/core/esp.h"
+#include "esp/gfx/magnum.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Where the drawables were in the previous frame of one view, e.g. of
+ * a motion vector sensor
+ *
+ * Keeps the projection times the camera-relative transformation of each
+ * drawable as drawn in the last frame, so that @ref
+ * RenderCamera::Flag::MotionVectors can draw how far each surface moved
+ * since, from both the motion of the camera and of the objects. Only the
+ * drawables drawn in the previous frame are kept: a drawable which is new, or
+ * was culled then, is taken as not moved.
+ */
+class MotionVectorHistory {
+ public:
+  /**
+   * @brief Start a new frame, after which the drawables drawn since the last
+   * call are the previous frame
+   */
+  void beginFrame();
+
+  /**
+   * @brief Record the transformation of @p drawable in this frame
+   * @param drawable                 The drawable
+   * @param transformationProjection The projection times its transformation
+   *                                 relative to the camera
+   * @return The transformation of @p drawable in the previous frame, or
+   * @p transformationProjection if it was not drawn then
+   */
+  Magnum::Matrix4 update(const Magnum::SceneGraph::Drawable3D& drawable,
+                         const Magnum::Matrix4& transformationProjection);
+
+  /**
+   * @brief The number of drawables of the previous frame
+   */
+  size_t numPreviousDrawables() const { return previous_.size(); }
+
+  /**
+   * @brief Forget the previous frame, e.g. when the view jumps and the next
+   * frame shouldn't show motion
+   */
+  void clear() {
+    previous_.clear();
+    current_.clear();
+  }
+
+ private:
+  typedef std::unordered_map<const Magnum::SceneGraph::Drawable3D*,
+                             Magnum::Matrix4>
+      Transformations;
+
+  //! the drawables of the previous frame, whose pointers may be stale but
+  //! are only compared against
+  Transformations previous_;
+  //! the drawables drawn since beginFrame()
+  Transformations current_;
+
+  ESP_SMART_POINTERS(MotionVectorHistory)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_MOTIONVECTORS_H_
@@ -0,0 +1,93 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "MultiFrustumCulling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <Corrade/Utility/Assert.h>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+constexpr size_t MultiFrustumCulling::MaxFrustums;
+constexpr size_t MultiFrustumCulling::Lanes;
+
+void MultiFrustumCulling::build(
+    Cr::Containers::ArrayView<const Mn::Range3D> bounds) {
+  size_ = bounds.size();
+  // the lanes past the last box are tested too, and never read
+  blocks_.assign((size_ + Lanes - 1) / Lanes, Block{});
+  for (size_t i = 0; i < size_; ++i) {
+    Block& block = blocks_[i / Lanes];
+    const Mn::Vector3 center = bounds[i].min() + bounds[i].max();
+    const Mn::Vector3 extent = bounds[i].max() - bounds[i].min();
+    for (int axis = 0; axis < 3; ++axis) {
+      block.centers[axis][i % Lanes] = center[axis];
+      block.extents[axis][i % Lanes] = extent[axis];
+    }
+  }
+}
+
+void MultiFrustumCulling::cull(
+    Cr::Containers::ArrayView<const Mn::Frustum> frustums,
+    std::vector<uint64_t>& masks) const {
+  CORRADE_ASSERT(frustums.size() <= MaxFrustums,
+                 "MultiFrustumCulling::cull(): expected at most"
+                     << MaxFrustums << "frustums, got" << frustums.size(), );
+  masks.resize(size_);
+
+  // the planes of all frustums, laid out for the loops below
+  struct Plane {
+    float normal[3];
+    float absNormal[3];
+    float offset;
+  };
+  Plane planes[MaxFrustums * 6];
+  for (size_t f = 0; f < frustums.size(); ++f) {
+    for (int p = 0; p < 6; ++p) {
+      const Mn::Vector4& plane = frustums[f][p];
+      Plane& packed = planes[6 * f + p];
+      for (int axis = 0; axis < 3; ++axis) {
+        packed.normal[axis] = plane[axis];
+        packed.absNormal[axis] = std::abs(plane[axis]);
+      }
+      packed.offset = -2.0f * plane.w();
+    }
+  }
+
+  for (size_t b = 0; b < blocks_.size(); ++b) {
+    const Block& block = blocks_[b];
+    uint64_t blockMasks[Lanes]{};
+    for (size_t f = 0; f < frustums.size(); ++f) {
+      bool inside[Lanes];
+      std::fill(inside, inside + Lanes, true);
+      for (int p = 0; p < 6; ++p) {
+        const Plane& plane = planes[6 * f + p];
+        // rangeFrustum() on all lanes, without branches so it vectorizes
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+          const float d = block.centers[0][lane] * plane.normal[0] +
+                          block.centers[1][lane] * plane.normal[1] +
+                          block.centers[2][lane] * plane.normal[2];
+          const float r = block.extents[0][lane] * plane.absNormal[0] +
+                          block.extents[1][lane] * plane.absNormal[1] +
+                          block.extents[2][lane] * plane.absNormal[2];
+          inside[lane] &= !(d + r < plane.offset);
+        }
+      }
+      for (size_t lane = 0; lane < Lanes; ++lane) {
+        blockMasks[lane] |= uint64_t(inside[lane]) << f;
+      }
+    }
+    const size_t count = std::min(Lanes, size_ - b * Lanes);
+    std::copy(blockMasks, blockMasks + count, masks.begin() + b * Lanes);
+  }
+}
+
+}  // namespace gfx
+}  // namespace esp
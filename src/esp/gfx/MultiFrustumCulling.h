@@ -0,0 +1,81 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_MULTIFRUSTUMCULLING_H_
+#define ESP_GFX_MULTIFRUSTUMCULLING_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::MultiFrustumCulling
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Range.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief A set of axis-aligned bounding boxes culled against several
+ * frustums in one sweep, e.g. those of all sensors drawing a step
+ *
+ * The boxes are packed into blocks of @ref Lanes as structure of arrays of
+ * their centers and extents. Each block is tested against all planes of all
+ * frustums while it is in registers, in branch-free loops over the lanes
+ * which the compiler vectorizes. The test is the one of
+ * `Magnum::Math::Intersection::rangeFrustum()`, so a box passes exactly when
+ * it passes that one.
+ */
+class MultiFrustumCulling {
+ public:
+  //! The most frustums culled at once, one bit of a mask each
+  static constexpr size_t MaxFrustums = 64;
+
+  //! The boxes of a block, tested together
+  static constexpr size_t Lanes = 8;
+
+  /**
+   * @brief Replace the boxes
+   * @param bounds The boxes. Mask @p i of @ref cull() results refers to
+   * `bounds[i]`.
+   */
+  void build(Corrade::Containers::ArrayView<const Magnum::Range3D> bounds);
+
+  /** @brief The number of boxes */
+  size_t size() const { return size_; }
+
+  /**
+   * @brief Test all boxes against all @p frustums
+   * @param frustums At most @ref MaxFrustums frustums, in the same space as
+   * the boxes
+   * @param[out] masks Resized to @ref size(), with bit @p f of mask @p i set
+   * if box @p i intersects `frustums[f]`
+   */
+  void cull(Corrade::Containers::ArrayView<const Magnum::Frustum> frustums,
+            std::vector<uint64_t>& masks) const;
+
+ private:
+  //! the sums and differences of the corners of the boxes of a block, as
+  //! rangeFrustum() computes them
+  struct Block {
+    float centers[3][Lanes];
+    float extents[3][Lanes];
+  };
+
+  std::vector<Block> blocks_;
+  size_t size_ = 0;
+
+  ESP_SMART_POINTERS(MultiFrustumCulling)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_MULTIFRUSTUMCULLING_H_
@@ -0,0 +1,92 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "MultiviewFramebuffer.h"
+
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Extensions.h>
+#include <Magnum/GL/OpenGL.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Range.h>
+
+#include "esp/gfx/RenderTarget.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+const Mn::GL::Framebuffer::ColorAttachment LinearDepthBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+constexpr Mn::Int NumViews = 2;
+}  // namespace
+
+bool MultiviewFramebuffer::isSupported() {
+  return Mn::GL::Context::hasCurrent() &&
+         Mn::GL::Context::current()
+             .isExtensionSupported<Mn::GL::Extensions::OVR::multiview2>();
+}
+
+MultiviewFramebuffer::MultiviewFramebuffer(const Mn::Vector2i& size)
+    : size_{size},
+      framebuffer_{{{}, size}},
+      viewFramebuffers_{Mn::GL::Framebuffer{{{}, size}},
+                        Mn::GL::Framebuffer{{{}, size}}} {
+  CORRADE_INTERNAL_ASSERT(isSupported());
+  linearDepth_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::R32F, {size, NumViews});
+  depth_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::DepthComponent32F,
+                  {size, NumViews});
+
+  // Magnum has no multiview attachments, they are made on the bound
+  // framebuffer directly
+  framebuffer_.bind();
+  glFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   linearDepth_.id(), 0, 0, NumViews);
+  glFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                   depth_.id(), 0, 0, NumViews);
+  framebuffer_.mapForDraw({{0, LinearDepthBuffer}});
+  CORRADE_INTERNAL_ASSERT(
+      framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+      Mn::GL::Framebuffer::Status::Complete);
+
+  for (Mn::Int view = 0; view != NumViews; ++view) {
+    viewFramebuffers_[view]
+        .attachTextureLayer(LinearDepthBuffer, linearDepth_, 0, view)
+        .attachTextureLayer(Mn::GL::Framebuffer::BufferAttachment::Depth,
+                            depth_, 0, view)
+        .mapForRead(LinearDepthBuffer);
+    CORRADE_INTERNAL_ASSERT(
+        viewFramebuffers_[view].checkStatus(Mn::GL::FramebufferTarget::Read) ==
+        Mn::GL::Framebuffer::Status::Complete);
+  }
+}
+
+std::size_t MultiviewFramebuffer::getGpuBytes() const {
+  // 4-byte linear depth and depth per pixel of each view
+  return std::size_t(size_.product()) * NumViews * (4 + 4);
+}
+
+void MultiviewFramebuffer::renderEnter() {
+  // the clears take all views, zero linear depth as for the far plane
+  framebuffer_.clearDepth(1.0);
+  framebuffer_.clearColor(0, Mn::Color4{});
+  framebuffer_.bind();
+}
+
+void MultiviewFramebuffer::renderExit(RenderTarget& first,
+                                      RenderTarget& second) {
+  first.copyDepthFrom(viewFramebuffers_[0]);
+  second.copyDepthFrom(viewFramebuffers_[1]);
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,89 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_MULTIVIEWFRAMEBUFFER_H_
+#define ESP_GFX_MULTIVIEWFRAMEBUFFER_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::MultiviewFramebuffer
+ */
+
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/TextureArray.h>
+#include <Magnum/Magnum.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+class RenderTarget;
+
+/**
+ * @brief A framebuffer drawing the linear depth of two views at once, e.g. of
+ * a stereo pair of depth sensors
+ *
+ * The linear depth and depth of each view go to a layer of two-layer texture
+ * arrays attached with @gl_extension{OVR,multiview2}, so that a single pass
+ * with @ref DepthShader::Flag::Multiview draws both. @ref renderExit() then
+ * copies each view into the @ref RenderTarget of its sensor, whose reads work
+ * as if it was drawn on its own.
+ */
+class MultiviewFramebuffer {
+ public:
+  /**
+   * @brief Whether the GPU supports @gl_extension{OVR,multiview2}
+   */
+  static bool isSupported();
+
+  /**
+   * @brief Constructor
+   * @param size The size of each view in WxH
+   *
+   * Expects that @ref isSupported() is true.
+   */
+  explicit MultiviewFramebuffer(const Magnum::Vector2i& size);
+
+  /**
+   * @brief The size of each view in WxH
+   */
+  Magnum::Vector2i size() const { return size_; }
+
+  /**
+   * @brief Estimated GPU memory of the framebuffer, in bytes
+   */
+  std::size_t getGpuBytes() const;
+
+  /**
+   * @brief Called before the draw calls of both views, clears both views
+   * and binds the framebuffer
+   */
+  void renderEnter();
+
+  /**
+   * @brief Called after the draw calls, copies the first view into @p first
+   * and the second into @p second
+   *
+   * The targets are expected to be depth-only and of the size of the views,
+   * see @ref RenderTarget::copyDepthFrom().
+   */
+  void renderExit(RenderTarget& first, RenderTarget& second);
+
+ private:
+  Magnum::Vector2i size_;
+  //! the linear depth and depth of both views, a layer each
+  Magnum::GL::Texture2DArray linearDepth_;
+  Magnum::GL::Texture2DArray depth_;
+  //! draws both layers with OVR_multiview2
+  Magnum::GL::Framebuffer framebuffer_;
+  //! reads one layer each, for the copies into the render targets
+  Magnum::GL::Framebuffer viewFramebuffers_[2];
+
+  ESP_SMART_POINTERS(MultiviewFramebuffer)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_MULTIVIEWFRAMEBUFFER_H_
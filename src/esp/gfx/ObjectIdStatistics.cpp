@@ -0,0 +1,92 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObjectIdStatistics.h"
+
+#include <string>
+
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/Version.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+static void importShaderResources() {
+  CORRADE_RESOURCE_INITIALIZE(ShaderResources)
+}
+
+namespace esp {
+namespace gfx {
+
+namespace {
+enum { ObjectIdTextureUnit = 1 };
+}
+
+constexpr Mn::Int ObjectIdStatisticsShader::Width;
+
+Mn::Vector2i ObjectIdStatisticsShader::tableSize(Mn::UnsignedInt capacity) {
+  return {Mn::Math::min(Mn::Int(capacity), Width),
+          Mn::Int((capacity + Width - 1) / Width)};
+}
+
+ObjectIdStatisticsShader::ObjectIdStatisticsShader() {
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+#ifdef MAGNUM_TARGET_WEBGL
+  Mn::GL::Version glVersion = Mn::GL::Version::GLES300;
+#else
+  Mn::GL::Version glVersion = Mn::GL::Version::GL330;
+#endif
+
+  Mn::GL::Shader vert{glVersion, Mn::GL::Shader::Type::Vertex};
+  Mn::GL::Shader frag{glVersion, Mn::GL::Shader::Type::Fragment};
+
+  vert.addSource("#define TABLE_WIDTH " + std::to_string(Width) + "u\n")
+      .addSource(rs.get("object-id-statistics.vert"));
+  frag.addSource(rs.get("object-id-statistics.frag"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+
+  attachShaders({vert, frag});
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  capacityUniform_ = uniformLocation("capacity");
+  tableSizeUniform_ = uniformLocation("tableSize");
+  boundsPassUniform_ = uniformLocation("boundsPass");
+  setUniform(uniformLocation("objectIdTexture"), ObjectIdTextureUnit);
+  setCapacity(Width);
+  setBoundsPass(false);
+}
+
+ObjectIdStatisticsShader& ObjectIdStatisticsShader::setCapacity(
+    Mn::UnsignedInt capacity) {
+  CORRADE_INTERNAL_ASSERT(capacity >= 1);
+  setUniform(capacityUniform_, capacity);
+  setUniform(tableSizeUniform_, tableSize(capacity));
+  return *this;
+}
+
+ObjectIdStatisticsShader& ObjectIdStatisticsShader::setBoundsPass(
+    bool bounds) {
+  setUniform(boundsPassUniform_, Mn::Int(bounds));
+  return *this;
+}
+
+ObjectIdStatisticsShader& ObjectIdStatisticsShader::bindObjectIdTexture(
+    Mn::GL::Texture2D& texture) {
+  texture.bind(ObjectIdTextureUnit);
+  return *this;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,93 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_OBJECTIDSTATISTICS_H_
+#define ESP_GFX_OBJECTIDSTATISTICS_H_
+
+/** @file
+ * @brief Struct @ref esp::gfx::VisibleObject, class @ref
+ * esp::gfx::ObjectIdStatisticsShader
+ */
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Range.h>
+
+namespace esp {
+namespace gfx {
+
+/**
+@brief An object seen in a frame, see @ref RenderTarget::readVisibleObjects()
+*/
+struct VisibleObject {
+  /** @brief The ObjectID */
+  Magnum::UnsignedInt objectId;
+
+  /** @brief The number of pixels with the ID */
+  Magnum::UnsignedInt pixelCount;
+
+  /**
+   * @brief The bounding box of the pixels, with an exclusive max and rows
+   * counted from the bottom like the frame reads
+   */
+  Magnum::Range2Di bounds;
+};
+
+/**
+@brief Shader reducing the ObjectID of a frame to the pixel count and
+bounding box of each ID
+
+Draws a point for each pixel of the bound ObjectID texture onto the texel of
+its ID in a table of @ref Width columns, entry @cpp i @ce at
+@cpp {i % Width, i / Width} @ce like in @ref ObjectIdLookup. Drawn with
+additive blending into an R32F attachment, the table gets the pixel count of
+each ID. With @ref setBoundsPass() and max blending into an RGBA32F one, it
+gets @cpp {maxX + 1, maxY + 1, width - minX, height - minY} @ce of the pixels.
+The entries of the IDs not seen stay as they were cleared, IDs past the
+capacity of the table are dropped.
+*/
+class ObjectIdStatisticsShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  /** @brief Number of columns of the table */
+  static constexpr Magnum::Int Width = 1024;
+
+  /** @brief The size of a table of @p capacity entries */
+  static Magnum::Vector2i tableSize(Magnum::UnsignedInt capacity);
+
+  explicit ObjectIdStatisticsShader();
+
+  /**
+   * @brief Set the number of entries of the table drawn into
+   * @return Reference to self (for method chaining)
+   *
+   * The viewport has to be the @ref tableSize() of @p capacity.
+   */
+  ObjectIdStatisticsShader& setCapacity(Magnum::UnsignedInt capacity);
+
+  /**
+   * @brief Set whether the bounding boxes are drawn instead of the pixel
+   * counts
+   * @return Reference to self (for method chaining)
+   */
+  ObjectIdStatisticsShader& setBoundsPass(bool bounds);
+
+  /**
+   * @brief Bind the R32UI ObjectID texture
+   * @return Reference to self (for method chaining)
+   *
+   * A mesh of points drawn has to have a vertex for each of its texels.
+   */
+  ObjectIdStatisticsShader& bindObjectIdTexture(
+      Magnum::GL::Texture2D& texture);
+
+ private:
+  int capacityUniform_;
+  int tableSizeUniform_;
+  int boundsPassUniform_;
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_OBJECTIDSTATISTICS_H_
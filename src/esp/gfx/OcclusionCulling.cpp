@@ -0,0 +1,205 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "OcclusionCulling.h"
+
+#include <algorithm>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/Optional.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/SceneGraph/Drawable.h>
+#include <Magnum/Shaders/Generic.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/FrameArena.h"
+#include "esp/scene/SceneNode.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+// drawables not drawn for this many calls to draw() are forgotten
+constexpr uint64_t MaxUnusedDraws = 64;
+
+}  // namespace
+
+Mn::GL::Mesh OcclusionCulling::createBoundingBoxMesh() {
+  const Mn::Vector3 positions[]{
+      {-1.0f, -1.0f, -1.0f}, {1.0f, -1.0f, -1.0f}, {-1.0f, 1.0f, -1.0f},
+      {1.0f, 1.0f, -1.0f},   {-1.0f, -1.0f, 1.0f}, {1.0f, -1.0f, 1.0f},
+      {-1.0f, 1.0f, 1.0f},   {1.0f, 1.0f, 1.0f}};
+  // the boxes are drawn without face culling, the winding doesn't matter
+  const Mn::UnsignedByte indices[]{
+      0, 1, 3, 0, 3, 2,  // -Z
+      4, 5, 7, 4, 7, 6,  // +Z
+      0, 1, 5, 0, 5, 4,  // -Y
+      2, 3, 7, 2, 7, 6,  // +Y
+      0, 2, 6, 0, 6, 4,  // -X
+      1, 3, 7, 1, 7, 5,  // +X
+  };
+
+  Mn::GL::Buffer vertices;
+  vertices.setData(positions);
+  Mn::GL::Buffer indexBuffer;
+  indexBuffer.setData(indices);
+
+  Mn::GL::Mesh mesh;
+  mesh.setCount(Cr::Containers::arraySize(indices))
+      .addVertexBuffer(std::move(vertices), 0,
+                       Mn::Shaders::Generic3D::Position{})
+      .setIndexBuffer(std::move(indexBuffer), 0,
+                      Mn::GL::MeshIndexType::UnsignedByte);
+  return mesh;
+}
+
+void OcclusionCulling::collectResult(Entry& entry) {
+  if (!entry.pending) {
+    return;
+  }
+  entry.pending = false;
+  // a result the GPU has not finished yet counts as visible, which only
+  // makes the drawable an occluder
+  const bool visible =
+      !entry.query.resultAvailable() || entry.query.result<bool>();
+  if (entry.boxQueried && !visible) {
+    core::Profiler::increment(core::ProfilingCounter::DrawablesOccluded);
+  }
+  entry.visible = visible;
+}
+
+void OcclusionCulling::prune() {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (numDraws_ - it->second.lastDraw > MaxUnusedDraws) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t OcclusionCulling::draw(MagnumCamera& camera,
+                              DrawableTransforms& drawableTransforms,
+                              DepthShader& boxShader,
+                              Mn::GL::Mesh& boxMesh) {
+#ifdef MAGNUM_TARGET_GLES
+  static_cast<void>(boxShader);
+  static_cast<void>(boxMesh);
+  camera.draw(drawableTransforms);
+  return 0;
+#else
+  ++numDraws_;
+  if (drawableTransforms.empty()) {
+    return 0;
+  }
+
+  // the camera is inside boxes closer to it than the corners of the near
+  // plane, which clips their faces away
+  const Mn::Matrix4 camera2world = camera.cameraMatrix().inverted();
+  const Mn::Vector3 cameraPosition = camera2world.translation();
+  const Mn::Float nearDistance = camera.projectionMatrix()
+                                     .inverted()
+                                     .transformPoint({1.0f, 1.0f, -1.0f})
+                                     .length();
+
+  // the hidden drawables with their boxes, at the end of the list in the
+  // same order, partitioned in place with the temporaries of the pass
+  FrameVector<Mn::Range3D> boxes;
+  FrameVector<DrawableTransforms::value_type> candidates;
+  boxes.reserve(drawableTransforms.size());
+  candidates.reserve(drawableTransforms.size());
+  size_t numOccluders = 0;
+  for (size_t i = 0; i != drawableTransforms.size(); ++i) {
+    auto& node = static_cast<scene::SceneNode&>(
+        drawableTransforms[i].first.get().object());
+    Cr::Containers::Optional<Mn::Range3D> aabb = node.getWorldAABB();
+    if (aabb) {
+      Entry& entry = entries_[&drawableTransforms[i].first.get()];
+      entry.lastDraw = numDraws_;
+      collectResult(entry);
+      if (!entry.visible && !aabb->padded(Mn::Vector3{nearDistance})
+                                 .contains(cameraPosition)) {
+        candidates.push_back(drawableTransforms[i]);
+        boxes.push_back(*aabb);
+        continue;
+      }
+    }
+    drawableTransforms[numOccluders++] = drawableTransforms[i];
+  }
+  std::copy(candidates.begin(), candidates.end(),
+            drawableTransforms.begin() + numOccluders);
+
+  single_.assign(1, drawableTransforms.front());
+  DrawableTransforms& single = single_;
+  auto entryOf = [&](size_t i) -> Entry* {
+    auto found = entries_.find(&drawableTransforms[i].first.get());
+    return found == entries_.end() ? nullptr : &found->second;
+  };
+
+  // the occluders, with queries telling whether they stay occluders
+  for (size_t i = 0; i != numOccluders; ++i) {
+    single[0] = drawableTransforms[i];
+    Entry* entry = entryOf(i);
+    if (!entry) {
+      camera.draw(single);
+      continue;
+    }
+    entry->query.begin();
+    camera.draw(single);
+    entry->query.end();
+    entry->pending = true;
+    entry->boxQueried = false;
+  }
+
+  // the bounding boxes of the rest against the depth of the occluders
+  if (numOccluders != drawableTransforms.size()) {
+    Mn::GL::Renderer::setColorMask(false, false, false, false);
+    Mn::GL::Renderer::setDepthMask(false);
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+    for (size_t i = numOccluders; i != drawableTransforms.size(); ++i) {
+      const Mn::Range3D& box = boxes[i - numOccluders];
+      Entry& entry = *entryOf(i);
+      boxShader.setTransformationMatrix(
+          camera.cameraMatrix() * Mn::Matrix4::translation(box.center()) *
+          Mn::Matrix4::scaling(box.size() * 0.5f));
+      entry.query.begin();
+      boxShader.draw(boxMesh);
+      core::Profiler::increment(core::ProfilingCounter::DrawCalls);
+      entry.query.end();
+      entry.pending = true;
+      entry.boxQueried = true;
+    }
+    Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
+    Mn::GL::Renderer::setDepthMask(true);
+    Mn::GL::Renderer::setColorMask(true, true, true, true);
+  }
+
+  // and the rest themselves, only if any of their box passed
+  for (size_t i = numOccluders; i != drawableTransforms.size(); ++i) {
+    single[0] = drawableTransforms[i];
+    Entry& entry = *entryOf(i);
+    entry.query.beginConditionalRender(
+        Mn::GL::SampleQuery::ConditionalRenderMode::Wait);
+    camera.draw(single);
+    entry.query.endConditionalRender();
+  }
+
+  if (numDraws_ % MaxUnusedDraws == 0) {
+    prune();
+  }
+  return drawableTransforms.size() - numOccluders;
+#endif
+}
+
+}  // namespace gfx
+}  // namespace esp
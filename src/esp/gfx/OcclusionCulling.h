@@ -0,0 +1,129 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_OCCLUSIONCULLING_H_
+#define ESP_GFX_OCCLUSIONCULLING_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::OcclusionCulling
+ */
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Magnum/GL/GL.h>
+#include <Magnum/GL/SampleQuery.h>
+
+#include "esp/core/esp.h"
+#include "esp/gfx/magnum.h"
+
+namespace esp {
+namespace gfx {
+
+class DepthShader;
+
+/**
+ * @brief The occlusion of the drawables seen from one view, e.g. of a
+ * sensor, kept from one frame to the next
+ *
+ * Drawing with @ref draw() takes the occlusion of the previous frame as the
+ * guess for this one, the same way @ref RenderCamera::cull() starts with the
+ * frustum plane which culled a drawable last time:
+ *
+ * -  the drawables which were visible, or are new, are drawn first as the
+ *    occluders, each in an occlusion query telling whether any of it was
+ *    still visible,
+ * -  the bounding box of each drawable which was hidden is then drawn
+ *    against their depth, without writing color or depth, in an occlusion
+ *    query,
+ * -  and the drawable itself is drawn under the conditional render of that
+ *    query, so the GPU skips it without the CPU waiting for the result.
+ *
+ * The results are collected the next time a drawable is drawn, with a frame
+ * of latency, and only decide which drawables are occluders. Whatever they
+ * say, a drawable is only skipped if its bounding box is hidden behind the
+ * depth drawn in the same frame, so the image is the same as without
+ * occlusion culling. Drawables without a bounding box in world space, see
+ * @ref scene::SceneNode::getWorldAABB(), are always drawn, and counted
+ * neither way.
+ *
+ * Conditional rendering is not available on OpenGL ES and WebGL, where @ref
+ * draw() draws all drawables.
+ */
+class OcclusionCulling {
+ public:
+  /** @brief Drawables with their transformations relative to the camera */
+  typedef std::vector<
+      std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                Magnum::Matrix4>>
+      DrawableTransforms;
+
+  /**
+   * @brief An axis-aligned box from -1 to 1, drawn for the bounding boxes
+   * with the position attribute of a @ref DepthShader
+   */
+  static Magnum::GL::Mesh createBoundingBoxMesh();
+
+  /**
+   * @brief Draw @p drawableTransforms with @p camera, skipping the ones
+   * hidden behind the rest
+   * @param camera          The camera the drawables are drawn with
+   * @param drawableTransforms The drawables, reordered so that the occluders
+   *                        are first
+   * @param boxShader       Draws the bounding boxes, with the projection
+   *                        matrix of @p camera set already
+   * @param boxMesh         A mesh made by @ref createBoundingBoxMesh()
+   * @return The number of drawables drawn under a conditional render
+   */
+  size_t draw(MagnumCamera& camera,
+              DrawableTransforms& drawableTransforms,
+              DepthShader& boxShader,
+              Magnum::GL::Mesh& boxMesh);
+
+  /**
+   * @brief The number of drawables whose occlusion is kept
+   */
+  size_t numTrackedDrawables() const { return entries_.size(); }
+
+  /**
+   * @brief Forget the occlusion of all drawables, e.g. when the view is
+   * reused for another sensor
+   */
+  void clear() { entries_.clear(); }
+
+ private:
+  //! the occlusion of a drawable
+  struct Entry {
+    Magnum::GL::SampleQuery query{
+        Magnum::GL::SampleQuery::Target::AnySamplesPassed};
+    //! whether the drawable was visible at the last result collected
+    bool visible = true;
+    //! whether the query was issued and its result not collected yet
+    bool pending = false;
+    //! whether the query is of the bounding box instead of the drawable
+    bool boxQueried = false;
+    //! the last call to draw() with the drawable in it
+    uint64_t lastDraw = 0;
+  };
+
+  //! collect the pending result of @p entry into its visibility
+  void collectResult(Entry& entry);
+
+  //! forget the drawables which were not drawn for a while, whose pointers
+  //! may be stale
+  void prune();
+
+  std::unordered_map<const Magnum::SceneGraph::Drawable3D*, Entry> entries_;
+  uint64_t numDraws_ = 0;
+  //! the list of one drawable the drawables are drawn with one by one
+  DrawableTransforms single_;
+
+  ESP_SMART_POINTERS(OcclusionCulling)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_OCCLUSIONCULLING_H_
@@ -4,8 +4,13 @@
 
 #include "PTexMeshDrawable.h"
 
+#include <string>
+
 #include "esp/assets/PTexMeshData.h"
+#include "esp/core/Profiling.h"
+#include "esp/gfx/DepthUnprojection.h"
 #include "esp/gfx/PTexMeshShader.h"
+#include "esp/gfx/RenderCamera.h"
 
 namespace esp {
 namespace gfx {
@@ -19,7 +24,8 @@ PTexMeshDrawable::PTexMeshDrawable(scene::SceneNode& node,
                                    ShaderManager& shaderManager,
                                    DrawableGroup* group /* = nullptr */)
     : Drawable{node, ptexMeshData.getRenderingBuffer(submeshID)->mesh, group},
-      atlasTexture_(ptexMeshData.getRenderingBuffer(submeshID)->atlasTexture),
+      ptexMeshData_(ptexMeshData),
+      submeshID_(submeshID),
 #ifndef CORRADE_TARGET_APPLE
       adjFacesBufferTexture_(
           ptexMeshData.getRenderingBuffer(submeshID)->adjFacesBufferTexture),
@@ -30,25 +36,58 @@ PTexMeshDrawable::PTexMeshDrawable(scene::SceneNode& node,
       saturation_(ptexMeshData.saturation()),
       visualizerTriangleMesh_(
           ptexMeshData.getRenderingBuffer(submeshID)->triangleMesh) {
+  // a shader per face ID source, the mesh is uploaded for one of them
+  const PTexMeshShader::FaceIdSource faceIdSource =
+      ptexMeshData.faceIdSource();
   auto shaderResource =
       shaderManager.get<Magnum::GL::AbstractShaderProgram, PTexMeshShader>(
-          SHADER_KEY);
+          std::string{SHADER_KEY} + "-" +
+          std::to_string(static_cast<int>(faceIdSource)));
 
   if (!shaderResource) {
-    shaderManager.set<Magnum::GL::AbstractShaderProgram>(shaderResource.key(),
-                                                         new PTexMeshShader{});
+    shaderManager.set<Magnum::GL::AbstractShaderProgram>(
+        shaderResource.key(), new PTexMeshShader{faceIdSource});
   }
   shader_ = &(*shaderResource);
 }
 
+DrawState PTexMeshDrawable::getDrawState() {
+  DrawState state;
+  state.shader = shader_;
+  // identifies the atlas without uploading it
+  state.texture = ptexMeshData_.getRenderingBuffer(submeshID_);
+  state.mesh = &mesh_;
+  return state;
+}
+
 void PTexMeshDrawable::draw(const Magnum::Matrix4& transformationMatrix,
                             Magnum::SceneGraph::Camera3D& camera) {
+  if (DepthShader* depthShader =
+          static_cast<RenderCamera&>(camera).linearDepthShader()) {
+    // the adjacency primitives need the geometry shader of the PTex shader,
+    // so their depth is unprojected after the pass instead
+    if (shader_->faceIdSource() ==
+        PTexMeshShader::FaceIdSource::GeometryShader) {
+      static_cast<RenderCamera&>(camera).countDrawableWithoutLinearDepth();
+      // nor can it draw both views of a multiview pass
+      if (static_cast<RenderCamera&>(camera).drawsMultiview()) {
+        return;
+      }
+    } else {
+      depthShader->setTransformationMatrix(transformationMatrix).draw(mesh_);
+      core::Profiler::increment(core::ProfilingCounter::DrawCalls);
+      return;
+    }
+  }
+
+  Magnum::GL::Texture2D& atlasTexture =
+      ptexMeshData_.getAtlasTexture(submeshID_);
   (*shader_)
       .setExposure(exposure_)
       .setGamma(gamma_)
       .setSaturation(saturation_)
-      .setAtlasTextureSize(atlasTexture_, tileSize_)
-      .bindAtlasTexture(atlasTexture_)
+      .setAtlasTextureSize(atlasTexture, tileSize_)
+      .bindAtlasTexture(atlasTexture)
       // e.g., semantic mesh has its own per vertex annotation, which has been
       // uploaded to GPU so simply pass 0 to the uniform "objectId" in the
       // fragment shader
@@ -60,6 +99,7 @@ void PTexMeshDrawable::draw(const Magnum::Matrix4& transformationMatrix,
 #endif
       .setMVPMatrix(camera.projectionMatrix() * transformationMatrix)
       .draw(mesh_);
+  core::Profiler::increment(core::ProfilingCounter::DrawCalls);
 }
 
 }  // namespace gfx
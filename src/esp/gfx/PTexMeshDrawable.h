@@ -28,12 +28,15 @@ class PTexMeshDrawable : public Drawable {
   virtual Magnum::GL::Mesh& getVisualizerMesh() override {
     return visualizerTriangleMesh_;
   }
+  DrawState getDrawState() override;
 
  protected:
   virtual void draw(const Magnum::Matrix4& transformationMatrix,
                     Magnum::SceneGraph::Camera3D& camera) override;
 
-  Magnum::GL::Texture2D& atlasTexture_;
+  // the atlas may be streamed, so it is looked up on every draw
+  assets::PTexMeshData& ptexMeshData_;
+  int submeshID_;
 #ifndef CORRADE_TARGET_APPLE
   Magnum::GL::BufferTexture& adjFacesBufferTexture_;
 #endif
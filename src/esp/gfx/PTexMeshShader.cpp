@@ -10,9 +10,12 @@
 #include <Magnum/GL/Version.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/PixelFormat.h>
+#include <string>
 
 #include "PTexMeshShader.h"
+#include "ShaderManager.h"
 #include "esp/assets/PTexMeshData.h"
+#include "esp/core/Profiling.h"
 #include "esp/core/esp.h"
 #include "esp/io/io.h"
 
@@ -37,8 +40,18 @@ enum TextureBindingPointIndex : uint8_t {
 };
 }  // namespace
 
-PTexMeshShader::PTexMeshShader() {
+PTexMeshShader::FaceIdSource PTexMeshShader::defaultFaceIdSource() {
+#ifdef CORRADE_TARGET_APPLE
+  return FaceIdSource::VertexId;
+#else
+  return FaceIdSource::PrimitiveId;
+#endif
+}
+
+PTexMeshShader::PTexMeshShader(FaceIdSource faceIdSource)
+    : faceIdSource_{faceIdSource} {
   MAGNUM_ASSERT_GL_VERSION_SUPPORTED(Mn::GL::Version::GL410);
+  core::ScopedTimer timer{core::ProfilingStage::ShaderCompilation};
 
   if (!Corrade::Utility::Resource::hasGroup("default-shaders")) {
     importShaderResources();
@@ -48,21 +61,44 @@ PTexMeshShader::PTexMeshShader() {
   const Corrade::Utility::Resource rs{"default-shaders"};
 
   Mn::GL::Shader vert{Mn::GL::Version::GL410, Mn::GL::Shader::Type::Vertex};
-  Mn::GL::Shader geom{Mn::GL::Version::GL410, Mn::GL::Shader::Type::Geometry};
   Mn::GL::Shader frag{Mn::GL::Version::GL410, Mn::GL::Shader::Type::Fragment};
 
-  vert.addSource(rs.get("ptex-default-gl410.vert"));
-  geom.addSource(rs.get("ptex-default-gl410.geom"));
+  std::string faceIdDefine;
+  switch (faceIdSource) {
+    case FaceIdSource::GeometryShader:
+      faceIdDefine = "#define GEOMETRY_SHADER\n";
+      break;
+    case FaceIdSource::PrimitiveId:
+      break;
+    case FaceIdSource::VertexId:
+      faceIdDefine = "#define VERTEX_FACE_ID\n";
+      break;
+  }
+  vert.addSource(faceIdDefine).addSource(rs.get("ptex-default-gl410.vert"));
 #ifdef CORRADE_TARGET_APPLE
   frag.addSource("#define CORRADE_TARGET_APPLE\n");
 #endif
-  frag.addSource(rs.get("ptex-default-gl410.frag"));
-
-  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, geom, frag}));
-
-  attachShaders({vert, geom, frag});
+  frag.addSource(faceIdDefine).addSource(rs.get("ptex-default-gl410.frag"));
 
-  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+  // the geometry shader is only attached to expand the adjacency primitives
+  Mn::GL::Shader geom{Mn::GL::Version::GL410, Mn::GL::Shader::Type::Geometry};
+  if (faceIdSource == FaceIdSource::GeometryShader) {
+    geom.addSource(rs.get("ptex-default-gl410.geom"));
+    if (!loadProgramBinary(*this, {vert, geom, frag})) {
+      CORRADE_INTERNAL_ASSERT_OUTPUT(
+          Mn::GL::Shader::compile({vert, geom, frag}));
+      attachShaders({vert, geom, frag});
+      setRetrievableBinary(true);
+      CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+      saveProgramBinary(*this, {vert, geom, frag});
+    }
+  } else if (!loadProgramBinary(*this, {vert, frag})) {
+    CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+    attachShaders({vert, frag});
+    setRetrievableBinary(true);
+    CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    saveProgramBinary(*this, {vert, frag});
+  }
 
   // set texture binding points in the shader;
   // see ptex fragment shader code for details
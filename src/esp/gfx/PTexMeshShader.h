@@ -5,14 +5,14 @@
 #ifndef ESP_GFX_PTEXMESHSHADER_H_
 #define ESP_GFX_PTEXMESHSHADER_H_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/GL.h>
 #include <Magnum/Math/Matrix4.h>
 
-#include "esp/assets/PTexMeshData.h"
-
 namespace esp {
 
 // forward declaration
@@ -27,10 +27,43 @@ class PTexMeshShader : public Magnum::GL::AbstractShaderProgram {
   //! @brief vertex positions
   typedef Magnum::GL::Attribute<0, Magnum::Vector3> Position;
 
+  /**
+   * @brief How the fragment shader gets the face whose atlas tile it samples
+   */
+  enum class FaceIdSource : uint8_t {
+    /**
+     * The quads are drawn as line adjacency primitives, which a geometry
+     * shader expands, passing on gl_PrimitiveIDIn.
+     */
+    GeometryShader,
+    /**
+     * The quads are drawn as two triangles of their own four vertices, see
+     * @ref assets::PTexMeshData::setFaceIdSource(), and the face is
+     * gl_PrimitiveID / 2 in the fragment shader.
+     */
+    PrimitiveId,
+    /**
+     * Like @ref FaceIdSource::PrimitiveId, but the face is passed flat from
+     * gl_VertexID / 4, for drivers without gl_PrimitiveID in the fragment
+     * shader without a geometry shader.
+     */
+    VertexId,
+  };
+
+  /**
+   * @brief The @ref FaceIdSource to draw with by default: @ref
+   * FaceIdSource::PrimitiveId, or @ref FaceIdSource::VertexId where
+   * gl_PrimitiveID is unreliable without a geometry shader (macOS)
+   */
+  static FaceIdSource defaultFaceIdSource();
+
   /**
    * @brief Constructor
    */
-  explicit PTexMeshShader();
+  explicit PTexMeshShader(FaceIdSource faceIdSource = defaultFaceIdSource());
+
+  /** @brief The source of the face IDs of the shader */
+  FaceIdSource faceIdSource() const { return faceIdSource_; }
 
   // ======== texture binding ========
   /**
@@ -88,6 +121,7 @@ class PTexMeshShader : public Magnum::GL::AbstractShaderProgram {
   int tileSizeUniform_;
   int widthInTilesUniform_;
   int objectIdUniform_;
+  FaceIdSource faceIdSource_;
 };
 
 }  // namespace gfx
@@ -0,0 +1,118 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PhongUniformCache.h"
+
+#include <algorithm>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/SceneGraph/Camera.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+void PhongUniformCache::beginDrawPass() {
+  // forget the light setups unused in the last pass, e.g. replaced ones
+  for (auto it = lights_.begin(); it != lights_.end();) {
+    if (it->second.pass != pass_) {
+      it = lights_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ++pass_;
+  inPass_ = true;
+  numLightUploads_ = 0;
+  numLightComputations_ = 0;
+  shaderLights_.clear();
+}
+
+void PhongUniformCache::endDrawPass() {
+  inPass_ = false;
+  shaderLights_.clear();
+}
+
+const PhongUniformCache::Lights& PhongUniformCache::lights(
+    const LightSetup& lightSetup,
+    const Mn::Matrix4& cameraMatrix) {
+  Lights& lights = lights_[&lightSetup];
+  if (inPass_ && lights.pass == pass_) {
+    return lights;
+  }
+  lights.pass = pass_;
+  // a replaced setup may have the address of the previous one, but not its
+  // version
+  const uint64_t version = getLightSetupVersion();
+  if (lights.version == version && lights.cameraMatrix == cameraMatrix) {
+    return lights;
+  }
+  lights.version = version;
+  lights.cameraMatrix = cameraMatrix;
+  ++numLightComputations_;
+  lights.positions.clear();
+  lights.colors.clear();
+  lights.hasObjectLights = false;
+  constexpr float dummyRange = 10000;
+  lights.ranges.assign(lightSetup.size(), dummyRange);
+  lights.ambientColor = getAmbientLightColor(lightSetup);
+  for (const LightInfo& light : lightSetup) {
+    if (light.model == LightPositionModel::OBJECT) {
+      lights.hasObjectLights = true;
+      lights.positions.push_back(light.vector);
+    } else {
+      // the object transformation is unused for these
+      lights.positions.push_back(
+          getLightPositionRelativeToCamera(light, {}, cameraMatrix));
+    }
+    lights.colors.push_back(light.color);
+  }
+  return lights;
+}
+
+const PhongUniformCache::Lights& PhongUniformCache::setLightingUniforms(
+    Mn::Shaders::Phong& shader,
+    const LightSetup& lightSetup,
+    const Mn::Matrix4& transformationMatrix,
+    Mn::SceneGraph::Camera3D& camera) {
+  const Lights& lights = this->lights(lightSetup, camera.cameraMatrix());
+
+  if (lights.hasObjectLights) {
+    objectLightPositions_ = lights.positions;
+    for (size_t i = 0; i < lightSetup.size(); ++i) {
+      if (lightSetup[i].model == LightPositionModel::OBJECT) {
+        objectLightPositions_[i] = transformationMatrix * lights.positions[i];
+      }
+    }
+    shader.setLightPositions(objectLightPositions_);
+  }
+
+  if (inPass_) {
+    auto uploaded = std::find_if(
+        shaderLights_.begin(), shaderLights_.end(),
+        [&](const std::pair<const Mn::Shaders::Phong*, const LightSetup*>&
+                shaderLights) { return shaderLights.first == &shader; });
+    if (uploaded == shaderLights_.end()) {
+      shaderLights_.emplace_back(&shader, &lightSetup);
+    } else if (uploaded->second == &lightSetup) {
+      return lights;
+    } else {
+      uploaded->second = &lightSetup;
+    }
+  }
+  ++numLightUploads_;
+
+  // See documentation in src/deps/magnum/src/Magnum/Shaders/Phong.h
+  if (!lights.hasObjectLights) {
+    shader.setLightPositions(lights.positions);
+  }
+  shader.setLightColors(lights.colors)
+      .setLightRanges(lights.ranges)
+      .setProjectionMatrix(camera.projectionMatrix());
+  return lights;
+}
+
+}  // namespace gfx
+}  // namespace esp
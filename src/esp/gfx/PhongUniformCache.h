@@ -0,0 +1,127 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_PHONGUNIFORMCACHE_H_
+#define ESP_GFX_PHONGUNIFORMCACHE_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::PhongUniformCache
+ */
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/SceneGraph/SceneGraph.h>
+#include <Magnum/Shaders/Phong.h>
+
+#include "esp/gfx/LightSetup.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief The light and camera uniforms of the Phong shaders drawn in a pass
+ * of a @ref RenderCamera
+ *
+ * The lights of a @ref LightSetup are transformed to the camera and their
+ * uniform arrays built once per pass, and uploaded to a shader once per pass,
+ * together with the projection matrix, instead of once per drawable. A shader
+ * is shared by all drawables with the same light count and flags, so
+ * drawables then only set their per-object uniforms. Lights positioned
+ * relative to the object, see @ref LightPositionModel::OBJECT, still depend
+ * on the drawable and are uploaded on each draw.
+ *
+ * The lights are kept across passes, and only computed again once the camera
+ * moves or a light setup is set, see @ref getLightSetupVersion(). The
+ * uploads still happen once per pass, since the shaders are shared with the
+ * other cameras.
+ */
+class PhongUniformCache {
+ public:
+  /** @brief The uniform arrays of a @ref LightSetup seen from a camera */
+  struct Lights {
+    //! positions relative to the camera, the light vector for object lights
+    std::vector<Magnum::Vector4> positions;
+    std::vector<Magnum::Color3> colors;
+    std::vector<float> ranges;
+    Magnum::Color3 ambientColor;
+    //! whether a light is relative to the object, see @ref positions
+    bool hasObjectLights = false;
+    //! the pass they were last used in
+    uint64_t pass = 0;
+    //! the version of the light setups they were computed at
+    uint64_t version = 0;
+    //! the camera they were computed for
+    Magnum::Matrix4 cameraMatrix;
+  };
+
+  /**
+   * @brief Start a new pass, for which the lights are recomputed and
+   * uploaded again
+   */
+  void beginDrawPass();
+
+  /**
+   * @brief End the pass. Outside of a pass, e.g. when drawing the drawables
+   * of a camera directly, the uniforms are computed and uploaded on each use
+   * since other cameras may draw with the same shaders in between.
+   */
+  void endDrawPass();
+
+  /**
+   * @brief The uniform arrays of @p lightSetup for the camera of the pass,
+   * computed on its first use in the pass unless neither the light setups
+   * nor @p cameraMatrix changed since the last computation
+   */
+  const Lights& lights(const LightSetup& lightSetup,
+                       const Magnum::Matrix4& cameraMatrix);
+
+  /**
+   * @brief Set the lights of @p lightSetup and the projection of @p camera on
+   * @p shader, unless it already has them from this pass
+   *
+   * @param transformationMatrix The transformation of the drawn object
+   * relative to the camera, only used for object lights
+   * @return the lights, e.g. for their combined ambient color
+   */
+  const Lights& setLightingUniforms(Magnum::Shaders::Phong& shader,
+                                    const LightSetup& lightSetup,
+                                    const Magnum::Matrix4& transformationMatrix,
+                                    Magnum::SceneGraph::Camera3D& camera);
+
+  /**
+   * @brief The number of times light uniforms were uploaded since the last
+   * @ref beginDrawPass()
+   */
+  size_t getNumLightUploads() const { return numLightUploads_; }
+
+  /**
+   * @brief The number of times the lights of a setup were computed since the
+   * last @ref beginDrawPass()
+   */
+  size_t getNumLightComputations() const { return numLightComputations_; }
+
+ private:
+  uint64_t pass_ = 0;
+  bool inPass_ = false;
+  size_t numLightUploads_ = 0;
+  size_t numLightComputations_ = 0;
+  //! kept across passes so that the arrays are allocated once per light setup
+  std::unordered_map<const LightSetup*, Lights> lights_;
+  //! the light setup each shader has the uniforms of in this pass, searched
+  //! linearly as there are a few shaders, and never shrunk
+  std::vector<std::pair<const Magnum::Shaders::Phong*, const LightSetup*>>
+      shaderLights_;
+  //! scratch space for the positions of object lights
+  std::vector<Magnum::Vector4> objectLightPositions_;
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_PHONGUNIFORMCACHE_H_
@@ -0,0 +1,235 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PotentiallyVisibleSet.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/core/TaskScheduler.h"
+#include "esp/geo/MeshBVH.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t PotentiallyVisibleSetMagic = 0x31535650;  // "PVS1"
+constexpr uint32_t PotentiallyVisibleSetVersion = 1;
+
+//! the angle between two successive rays of a spiral over the sphere
+const float GoldenAngle = Mn::Constants::pi() * (3.0f - std::sqrt(5.0f));
+
+int gridCoordinate(float coordinate, float size) {
+  return int(std::floor(coordinate / size));
+}
+
+//! the grid coordinates of a cell, 21 bits each
+uint64_t cellKey(int x, int y, int z) {
+  constexpr uint64_t Mask = (uint64_t{1} << 21) - 1;
+  constexpr int Offset = 1 << 20;
+  return (uint64_t(x + Offset) & Mask) << 42 |
+         (uint64_t(y + Offset) & Mask) << 21 | (uint64_t(z + Offset) & Mask);
+}
+
+template <class T>
+void writeValue(std::ofstream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::ifstream& in, T& value) {
+  return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+}  // namespace
+
+constexpr uint32_t PotentiallyVisibleSet::NoCell;
+
+PotentiallyVisibleSet::PotentiallyVisibleSet(uint32_t numItems,
+                                             float cellSize,
+                                             float cellHeight,
+                                             float maxEyeHeight)
+    : numItems_{numItems},
+      wordsPerCell_{(numItems + 63) / 64},
+      cellSize_{cellSize},
+      cellHeight_{cellHeight},
+      maxEyeHeight_{maxEyeHeight} {}
+
+PotentiallyVisibleSet PotentiallyVisibleSet::compute(
+    const std::vector<std::vector<Mn::Vector3>>& itemTriangles,
+    const std::vector<Mn::Vector3>& navigablePoints,
+    const Configuration& configuration) {
+  PotentiallyVisibleSet set{uint32_t(itemTriangles.size()),
+                            configuration.cellSize, configuration.cellHeight,
+                            configuration.maxEyeHeight};
+  std::vector<std::vector<Mn::Vector3>> cellPoints;
+  for (const Mn::Vector3& point : navigablePoints) {
+    const uint32_t cell = set.addCell(point);
+    if (cell == cellPoints.size()) {
+      cellPoints.emplace_back();
+    }
+    cellPoints[cell].push_back(point);
+  }
+
+  // one hierarchy over all items, a triangle belongs to the last item
+  // starting at or before it
+  std::vector<uint32_t> firstTriangles;
+  std::vector<Mn::Vector3> vertices;
+  for (const std::vector<Mn::Vector3>& triangles : itemTriangles) {
+    firstTriangles.push_back(vertices.size() / 3);
+    vertices.insert(vertices.end(), triangles.begin(),
+                    triangles.begin() + triangles.size() / 3 * 3);
+  }
+  geo::MeshBVH bvh;
+  bvh.build(std::move(vertices));
+  if (bvh.numTriangles() == 0) {
+    return set;
+  }
+
+  std::vector<Mn::Vector3> directions(std::max(configuration.raysPerView, 1));
+  for (size_t i = 0; i < directions.size(); ++i) {
+    const float y = 1.0f - 2.0f * (i + 0.5f) / directions.size();
+    const float radius = std::sqrt(1.0f - y * y);
+    directions[i] = {radius * std::cos(i * GoldenAngle), y,
+                     radius * std::sin(i * GoldenAngle)};
+  }
+  const int eyeHeights = std::max(configuration.eyeHeights, 1);
+
+  // the cells write their own words of the bitsets
+  core::TaskScheduler::global().parallelForRanges(
+      cellPoints.size(), configuration.numThreads,
+      [&](size_t begin, size_t end) {
+        geo::MeshBVH::Hit hit;
+        for (size_t cell = begin; cell < end; ++cell) {
+          int view = 0;
+          for (const Mn::Vector3& point : cellPoints[cell]) {
+            for (int i = 0; i < eyeHeights; ++i, ++view) {
+              const Mn::Vector3 eye =
+                  point + Mn::Vector3::yAxis(configuration.maxEyeHeight *
+                                             (i + 1) / eyeHeights);
+              // turned for each view, so that the views of a cell look
+              // through different gaps
+              const Mn::Matrix4 rotation =
+                  Mn::Matrix4::rotationY(Mn::Rad{view * GoldenAngle});
+              for (const Mn::Vector3& direction : directions) {
+                if (!bvh.castRay(eye, rotation.transformVector(direction),
+                                 std::numeric_limits<float>::infinity(),
+                                 hit)) {
+                  continue;
+                }
+                const uint32_t item =
+                    std::upper_bound(firstTriangles.begin(),
+                                     firstTriangles.end(), hit.triangle) -
+                    firstTriangles.begin() - 1;
+                set.setVisible(cell, item);
+              }
+            }
+          }
+        }
+      });
+  return set;
+}
+
+uint32_t PotentiallyVisibleSet::addCell(const Mn::Vector3& point) {
+  const uint64_t key = cellKey(gridCoordinate(point.x(), cellSize_),
+                               gridCoordinate(point.y(), cellHeight_),
+                               gridCoordinate(point.z(), cellSize_));
+  const auto inserted = cells_.emplace(key, uint32_t(cellKeys_.size()));
+  if (inserted.second) {
+    cellKeys_.push_back(key);
+    bits_.resize(bits_.size() + wordsPerCell_);
+  }
+  return inserted.first->second;
+}
+
+uint32_t PotentiallyVisibleSet::findCell(const Mn::Vector3& position) const {
+  if (cells_.empty()) {
+    return NoCell;
+  }
+  const int x = gridCoordinate(position.x(), cellSize_);
+  const int z = gridCoordinate(position.z(), cellSize_);
+  // the highest ground a view at the position can be above
+  const int bottom = gridCoordinate(position.y() - maxEyeHeight_, cellHeight_);
+  for (int y = gridCoordinate(position.y(), cellHeight_); y >= bottom; --y) {
+    const auto found = cells_.find(cellKey(x, y, z));
+    if (found != cells_.end()) {
+      return found->second;
+    }
+  }
+  return NoCell;
+}
+
+uint32_t PotentiallyVisibleSet::numVisible(uint32_t cell) const {
+  uint32_t count = 0;
+  for (uint64_t word : cellBits(cell)) {
+    count += std::bitset<64>{word}.count();
+  }
+  return count;
+}
+
+bool PotentiallyVisibleSet::save(const std::string& filename) const {
+  std::ofstream out{filename, std::ios::binary};
+  if (!out) {
+    return false;
+  }
+  writeValue(out, PotentiallyVisibleSetMagic);
+  writeValue(out, PotentiallyVisibleSetVersion);
+  writeValue(out, numItems_);
+  writeValue(out, cellSize_);
+  writeValue(out, cellHeight_);
+  writeValue(out, maxEyeHeight_);
+  writeValue(out, uint32_t(cellKeys_.size()));
+  out.write(reinterpret_cast<const char*>(cellKeys_.data()),
+            cellKeys_.size() * sizeof(uint64_t));
+  out.write(reinterpret_cast<const char*>(bits_.data()),
+            bits_.size() * sizeof(uint64_t));
+  return bool(out);
+}
+
+bool PotentiallyVisibleSet::load(const std::string& filename) {
+  *this = PotentiallyVisibleSet{};
+  std::ifstream in{filename, std::ios::binary};
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  uint32_t numItems = 0;
+  float cellSize = 0.0f;
+  float cellHeight = 0.0f;
+  float maxEyeHeight = 0.0f;
+  uint32_t numCells = 0;
+  if (!in || !readValue(in, magic) || magic != PotentiallyVisibleSetMagic ||
+      !readValue(in, version) || version != PotentiallyVisibleSetVersion ||
+      !readValue(in, numItems) || !readValue(in, cellSize) ||
+      !readValue(in, cellHeight) || !readValue(in, maxEyeHeight) ||
+      !(cellSize > 0.0f) || !(cellHeight > 0.0f) ||
+      !readValue(in, numCells)) {
+    return false;
+  }
+
+  PotentiallyVisibleSet set{numItems, cellSize, cellHeight, maxEyeHeight};
+  set.cellKeys_.resize(numCells);
+  set.bits_.resize(numCells * set.wordsPerCell_);
+  if (!in.read(reinterpret_cast<char*>(set.cellKeys_.data()),
+               numCells * sizeof(uint64_t)) ||
+      !in.read(reinterpret_cast<char*>(set.bits_.data()),
+               set.bits_.size() * sizeof(uint64_t))) {
+    return false;
+  }
+  for (uint32_t cell = 0; cell < numCells; ++cell) {
+    set.cells_.emplace(set.cellKeys_[cell], cell);
+  }
+  *this = std::move(set);
+  return true;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,170 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_POTENTIALLYVISIBLESET_H_
+#define ESP_GFX_POTENTIALLYVISIBLESET_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::PotentiallyVisibleSet
+ */
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief The items of a static stage, e.g. its drawables, which may be
+ * visible from each cell of the navigable space, precomputed offline
+ *
+ * The cells are boxes of a grid, @ref cellSize() wide and @ref cellHeight()
+ * high, which contain navigable points. A view belongs to the cell of the
+ * highest navigable ground below it, at most @ref maxEyeHeight() below, see
+ * @ref findCell(). Each cell has a bitset of the items seen from it, which
+ * @ref DrawableGroup::cull() tests before the frustum.
+ *
+ * @ref compute() samples the visibility with rays, so an item seen only
+ * through gaps smaller than the ray spacing may be missed.
+ */
+class PotentiallyVisibleSet {
+ public:
+  //! The cell of a view outside of all cells
+  static constexpr uint32_t NoCell = std::numeric_limits<uint32_t>::max();
+
+  /** @brief The sampling of @ref compute() */
+  struct Configuration {
+    //! The width of a cell.
+    float cellSize = 1.0f;
+    //! The height of a cell, less than the height between two floors.
+    float cellHeight = 1.0f;
+    //! The highest view above the navigable ground.
+    float maxEyeHeight = 2.0f;
+    //! The views sampled above each navigable point, evenly up to
+    //! @ref maxEyeHeight.
+    int eyeHeights = 3;
+    //! The rays cast from each view, spread evenly over the sphere.
+    int raysPerView = 1024;
+    //! The most threads to cast on, all if 0 or less.
+    int numThreads = 0;
+  };
+
+  /** @brief An empty set, without cells or items */
+  PotentiallyVisibleSet() = default;
+
+  /**
+   * @brief A set without cells
+   * @param numItems The number of items
+   * @param cellSize The width of a cell
+   * @param cellHeight The height of a cell
+   * @param maxEyeHeight The highest view above the navigable ground
+   */
+  PotentiallyVisibleSet(uint32_t numItems,
+                        float cellSize,
+                        float cellHeight,
+                        float maxEyeHeight);
+
+  /**
+   * @brief Sample which items are visible from the navigable points
+   * @param itemTriangles The triangle corners of each item, three per
+   * triangle, in world space
+   * @param navigablePoints Points on the navigable ground the cells are
+   * made of, with the views sampled above them, some per cell
+   * @param configuration The sampling
+   */
+  static PotentiallyVisibleSet compute(
+      const std::vector<std::vector<Magnum::Vector3>>& itemTriangles,
+      const std::vector<Magnum::Vector3>& navigablePoints,
+      const Configuration& configuration);
+
+  /** @brief The number of items */
+  uint32_t numItems() const { return numItems_; }
+
+  /** @brief The number of cells */
+  size_t numCells() const { return cellKeys_.size(); }
+
+  /** @brief The width of a cell */
+  float cellSize() const { return cellSize_; }
+
+  /** @brief The height of a cell */
+  float cellHeight() const { return cellHeight_; }
+
+  /** @brief The highest view above the navigable ground */
+  float maxEyeHeight() const { return maxEyeHeight_; }
+
+  /**
+   * @brief The cell containing the navigable point @p point, added without
+   * visible items if new
+   */
+  uint32_t addCell(const Magnum::Vector3& point);
+
+  /**
+   * @brief The cell of a view at @p position, @ref NoCell if no cell is
+   * below it
+   */
+  uint32_t findCell(const Magnum::Vector3& position) const;
+
+  /** @brief Mark @p item as visible from @p cell */
+  void setVisible(uint32_t cell, uint32_t item) {
+    bits_[cell * wordsPerCell_ + item / 64] |= uint64_t{1} << (item % 64);
+  }
+
+  /** @brief Whether @p item is visible from @p cell */
+  bool isVisible(uint32_t cell, uint32_t item) const {
+    return bits_[cell * wordsPerCell_ + item / 64] &
+           (uint64_t{1} << (item % 64));
+  }
+
+  /**
+   * @brief The items visible from @p cell, bit @p i of word @p i / 64 for
+   * item @p i
+   */
+  Corrade::Containers::ArrayView<const uint64_t> cellBits(uint32_t cell) const {
+    return {bits_.data() + cell * wordsPerCell_, wordsPerCell_};
+  }
+
+  /** @brief The number of items visible from @p cell */
+  uint32_t numVisible(uint32_t cell) const;
+
+  /**
+   * @brief Write the set to @p filename, in the native layout
+   * @return Whether the file was written
+   */
+  bool save(const std::string& filename) const;
+
+  /**
+   * @brief Replace the set with the one in @p filename, written by @ref
+   * save()
+   * @return Whether the file was read, the set is left empty otherwise
+   */
+  bool load(const std::string& filename);
+
+ private:
+  uint32_t numItems_ = 0;
+  size_t wordsPerCell_ = 0;
+  float cellSize_ = 1.0f;
+  float cellHeight_ = 1.0f;
+  float maxEyeHeight_ = 2.0f;
+  //! the packed grid coordinates of each cell
+  std::vector<uint64_t> cellKeys_;
+  std::unordered_map<uint64_t, uint32_t> cells_;
+  //! the bitsets of the cells, wordsPerCell_ words each
+  std::vector<uint64_t> bits_;
+
+  ESP_SMART_POINTERS(PotentiallyVisibleSet)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_POTENTIALLYVISIBLESET_H_
@@ -5,12 +5,21 @@
 #include "RenderCamera.h"
 
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/GL/Renderer.h>
 #include <Magnum/Math/Frustum.h>
 #include <Magnum/Math/Intersection.h>
 #include <Magnum/Math/Range.h>
+#include <Magnum/SceneGraph/AbstractObject.h>
 #include <Magnum/SceneGraph/Drawable.h>
+#include "esp/core/Profiling.h"
+#include "esp/gfx/DepthUnprojection.h"
 #include "esp/gfx/Drawable.h"
 #include "esp/gfx/DrawableGroup.h"
+#include "esp/gfx/FrameArena.h"
+#include "esp/gfx/IndirectDrawBatch.h"
+#include "esp/gfx/MotionVectors.h"
+#include "esp/gfx/OcclusionCulling.h"
+#include "esp/gfx/RenderList.h"
 
 namespace Mn = Magnum;
 namespace Cr = Corrade;
@@ -76,23 +85,29 @@ RenderCamera& RenderCamera::setProjectionMatrix(int width,
   return *this;
 }
 
+Mn::Frustum RenderCamera::cullingFrustum() {
+  if (cullingFrustum_) {
+    return *cullingFrustum_;
+  }
+  // camera frustum relative to world origin
+  return Mn::Frustum::fromMatrix(projectionMatrix() * cameraMatrix());
+}
+
 size_t RenderCamera::cull(
     std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
                           Mn::Matrix4>>& drawableTransforms) {
-  // camera frustum relative to world origin
-  const Mn::Frustum frustum =
-      Mn::Frustum::fromMatrix(projectionMatrix() * cameraMatrix());
+  core::ScopedTimer timer{core::ProfilingStage::Culling};
+  const Mn::Frustum frustum = cullingFrustum();
 
   auto newEndIter = std::remove_if(
       drawableTransforms.begin(), drawableTransforms.end(),
       [&](const std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
                           Mn::Matrix4>& a) {
-        // obtain the absolute aabb
+        // obtain the world space aabb, of a static mesh or of a dynamic one
+        // which is only recomputed after it moved
         auto& node = static_cast<scene::SceneNode&>(a.first.get().object());
-        Corrade::Containers::Optional<Mn::Range3D> aabb =
-            node.getAbsoluteAABB();
+        Corrade::Containers::Optional<Mn::Range3D> aabb = node.getWorldAABB();
         if (aabb) {
-          // if it has an absolute aabb, it is a static mesh
           Cr::Containers::Optional<int> culledPlane =
               rangeFrustum(*aabb, frustum, node.getFrustumPlaneIndex());
           if (culledPlane) {
@@ -101,7 +116,7 @@ size_t RenderCamera::cull(
           // if it has value, it means the aabb is culled
           return (culledPlane != Cr::Containers::NullOpt);
         } else {
-          // keep the drawable if its node does not have an absolute AABB
+          // keep the drawable if its node does not have a mesh bounding box
           return false;
         }
       });
@@ -109,6 +124,73 @@ size_t RenderCamera::cull(
   return (newEndIter - drawableTransforms.begin());
 }
 
+std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                      Mn::Matrix4>>
+RenderCamera::visibleDrawableTransformations(DrawableGroup& drawables,
+                                             bool indirectBatched) {
+  std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                        Mn::Matrix4>>
+      drawableTransforms;
+  appendVisibleDrawableTransformations(drawables, indirectBatched, nullptr,
+                                       drawableTransforms);
+  return drawableTransforms;
+}
+
+void RenderCamera::appendVisibleDrawableTransformations(
+    DrawableGroup& drawables,
+    bool indirectBatched,
+    Cr::Containers::ArrayView<const uint64_t> potentiallyVisible,
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  core::ScopedTimer timer{core::ProfilingStage::Culling};
+  const Mn::Frustum frustum = cullingFrustum();
+
+  visibleDrawables_.clear();
+  drawables.cull(frustum, visibleDrawables_, indirectBatched,
+                 potentiallyVisible);
+
+  // same as MagnumCamera::drawableTransformations(), but only for the drawables
+  // that passed the culling, and without the temporary arrays of
+  // Object::transformationMatrices()
+  const Mn::Matrix4 cameraMatrix = this->cameraMatrix();
+  drawableTransforms.reserve(drawableTransforms.size() +
+                             visibleDrawables_.size());
+  for (Drawable& drawable : visibleDrawables_) {
+    drawableTransforms.emplace_back(
+        drawable,
+        cameraMatrix * drawable.object().absoluteTransformationMatrix());
+  }
+}
+
+std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                      Mn::Matrix4>>
+RenderCamera::renderListTransformations(DrawableGroup& drawables,
+                                        Flags flags) {
+  std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                        Mn::Matrix4>>
+      drawableTransforms;
+  appendRenderListTransformations(drawables, flags, drawableTransforms);
+  return drawableTransforms;
+}
+
+void RenderCamera::appendRenderListTransformations(
+    DrawableGroup& drawables,
+    Flags flags,
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  core::ScopedTimer timer{core::ProfilingStage::Culling};
+  RenderList& list = drawables.renderList();
+  // only the entries of the nodes which moved since the last draw
+  list.update();
+
+  if (flags & Flag::FrustumCulling) {
+    const Mn::Frustum frustum = cullingFrustum();
+    list.drawableTransformations(cameraMatrix(), &frustum, drawableTransforms);
+  } else {
+    list.drawableTransformations(cameraMatrix(), nullptr, drawableTransforms);
+  }
+}
+
 size_t RenderCamera::removeNonObjects(
     std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
                           Mn::Matrix4>>& drawableTransforms) {
@@ -126,44 +208,230 @@ size_t RenderCamera::removeNonObjects(
   return (newEndIter - drawableTransforms.begin());
 }
 
+size_t RenderCamera::removeObjects(
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  auto newEndIter = std::remove_if(
+      drawableTransforms.begin(), drawableTransforms.end(),
+      [&](const std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>& a) {
+        auto& node = static_cast<scene::SceneNode&>(a.first.get().object());
+        return node.getType() == scene::SceneNodeType::OBJECT;
+      });
+  return (newEndIter - drawableTransforms.begin());
+}
+
+size_t RenderCamera::removeIndirectBatched(
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  auto newEndIter = std::remove_if(
+      drawableTransforms.begin(), drawableTransforms.end(),
+      [&](const std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>& a) {
+        return static_cast<Drawable&>(a.first.get()).isIndirectBatched();
+      });
+  return (newEndIter - drawableTransforms.begin());
+}
+
+size_t RenderCamera::removeNotPotentiallyVisible(
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms,
+    Cr::Containers::ArrayView<const uint64_t> potentiallyVisible) {
+  auto newEndIter = std::remove_if(
+      drawableTransforms.begin(), drawableTransforms.end(),
+      [&](const std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>& a) {
+        const uint32_t index =
+            static_cast<Drawable&>(a.first.get()).getStaticIndex();
+        // dynamic drawables are kept
+        return index != Drawable::NoStaticIndex &&
+               !(potentiallyVisible[index / 64] & (uint64_t{1} << index % 64));
+      });
+  return (newEndIter - drawableTransforms.begin());
+}
+
 uint32_t RenderCamera::draw(MagnumDrawableGroup& drawables, Flags flags) {
+  // the temporaries of the pass, e.g. of the occlusion culling, are freed at
+  // the end of it
+  FrameArena::Scope frameScope{frameArena()};
+  phongUniformCache_.beginDrawPass();
   previousNumVisibleDrawables_ = drawables.size();
   if (flags == Flags()) {  // empty set
     MagnumCamera::draw(drawables);
+    phongUniformCache_.endDrawPass();
     return drawables.size();
   }
 
   if (flags & Flag::UseDrawableIdAsObjectId) {
     useDrawableIds_ = true;
   }
+  if (flags & (Flag::LinearDepth | Flag::DepthOnly | Flag::SurfaceNormals |
+               Flag::MotionVectors)) {
+    CORRADE_INTERNAL_ASSERT(linearDepthShader_ && instancedLinearDepthShader_);
+    drawLinearDepth_ = true;
+  }
+  if (flags & Flag::Multiview) {
+    CORRADE_INTERNAL_ASSERT(flags & Flag::LinearDepth);
+    drawMultiview_ = true;
+  }
+  if (flags & Flag::VertexColorOnly) {
+    shading_ = Shading::VertexColor;
+  } else if (flags & Flag::Unlit) {
+    shading_ = Shading::Unlit;
+  }
 
-  std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
-                        Mn::Matrix4>>
-      drawableTransforms = drawableTransformations(drawables);
+  // the hierarchical culling of gfx::DrawableGroup skips the transformations
+  // of culled drawables altogether
+  auto* group = dynamic_cast<DrawableGroup*>(&drawables);
+  const bool renderList = (flags & Flag::RenderList) && group;
+  const bool hierarchicalCulling =
+      !renderList && (flags & Flag::FrustumCulling) && group;
+
+  // the static drawables which the batch of the group draws are left out
+  // of the collection below
+  IndirectDrawBatch* indirectBatch = nullptr;
+  if ((flags & Flag::GpuDriven) && group && indirectCullingShader_ &&
+      drawLinearDepth_ && (flags & (Flag::DepthOnly | Flag::LinearDepth)) &&
+      !(flags & (Flag::ObjectsOnly | Flag::SurfaceNormals |
+                 Flag::MotionVectors | Flag::Multiview))) {
+    indirectBatch = group->indirectDrawBatch();
+  }
+  const size_t numIndirectBatched = indirectBatch ? indirectBatch->size() : 0;
+
+  // the static drawables seen from the cell of the camera, empty for all
+  Cr::Containers::ArrayView<const uint64_t> potentiallyVisible;
+  if ((flags & Flag::PotentiallyVisibleSet) && group) {
+    potentiallyVisible =
+        group->potentiallyVisible(object().absoluteTranslation());
+  }
+
+  // reused from pass to pass, MagnumCamera::draw() takes no other allocator
+  auto& drawableTransforms = drawableTransforms_;
+  drawableTransforms.clear();
+  if (renderList) {
+    appendRenderListTransformations(*group, flags, drawableTransforms);
+  } else if (hierarchicalCulling) {
+    appendVisibleDrawableTransformations(*group, !indirectBatch,
+                                         potentiallyVisible,
+                                         drawableTransforms);
+  } else {
+    const Mn::Matrix4 cameraMatrix = this->cameraMatrix();
+    drawableTransforms.reserve(drawables.size());
+    for (size_t i = 0; i != drawables.size(); ++i) {
+      drawableTransforms.emplace_back(
+          drawables[i],
+          cameraMatrix * drawables[i].object().absoluteTransformationMatrix());
+    }
+  }
+  if (indirectBatch && !hierarchicalCulling) {
+    drawableTransforms.erase(
+        drawableTransforms.begin() + removeIndirectBatched(drawableTransforms),
+        drawableTransforms.end());
+  }
+  if (!potentiallyVisible.empty() && !hierarchicalCulling) {
+    drawableTransforms.erase(
+        drawableTransforms.begin() +
+            removeNotPotentiallyVisible(drawableTransforms, potentiallyVisible),
+        drawableTransforms.end());
+  }
+  if (hierarchicalCulling || (renderList && (flags & Flag::FrustumCulling)) ||
+      !potentiallyVisible.empty()) {
+    core::Profiler::increment(
+        core::ProfilingCounter::DrawablesCulled,
+        drawables.size() - numIndirectBatched - drawableTransforms.size());
+  }
 
   if (flags & Flag::ObjectsOnly) {
     // draw just the OBJECTS
     size_t numObjects = removeNonObjects(drawableTransforms);
     drawableTransforms.erase(drawableTransforms.begin() + numObjects,
                              drawableTransforms.end());
+  } else if (flags & Flag::ExcludeObjects) {
+    // draw all but the OBJECTS
+    size_t numNonObjects = removeObjects(drawableTransforms);
+    drawableTransforms.erase(drawableTransforms.begin() + numNonObjects,
+                             drawableTransforms.end());
   }
 
-  if (flags & Flag::FrustumCulling) {
+  if (hierarchicalCulling || renderList) {
+    previousNumVisibleDrawables_ =
+        drawableTransforms.size() + numIndirectBatched;
+  } else if (flags & Flag::FrustumCulling) {
     // draw just the visible part
-    previousNumVisibleDrawables_ = cull(drawableTransforms);
+    const size_t numVisible = cull(drawableTransforms);
+    core::Profiler::increment(core::ProfilingCounter::DrawablesCulled,
+                              drawableTransforms.size() - numVisible);
     // erase all items that did not pass the frustum visibility test
-    drawableTransforms.erase(
-        drawableTransforms.begin() + previousNumVisibleDrawables_,
-        drawableTransforms.end());
+    drawableTransforms.erase(drawableTransforms.begin() + numVisible,
+                             drawableTransforms.end());
+    previousNumVisibleDrawables_ = numVisible + numIndirectBatched;
+  } else if (!potentiallyVisible.empty()) {
+    previousNumVisibleDrawables_ =
+        drawableTransforms.size() + numIndirectBatched;
+  }
+
+  if ((flags & Flag::SortByDrawState) && group) {
+    group->sortByDrawState(drawableTransforms);
   }
 
-  MagnumCamera::draw(drawableTransforms);
+  if (flags & Flag::DepthOnly) {
+    Mn::GL::Renderer::setColorMask(false, false, false, false);
+  }
+  if (indirectBatch) {
+    // drawn first so that the stage occludes the rest early
+    indirectBatch->draw(*indirectCullingShader_, *linearDepthShader_,
+                        cameraMatrix(), cullingFrustum());
+  }
+  if (flags & Flag::MotionVectors) {
+    CORRADE_INTERNAL_ASSERT(motionVectorHistory_);
+    // the same as MagnumCamera::draw(), with the previous transformation of
+    // each drawable set first
+    for (auto& drawableTransform : drawableTransforms) {
+      const Mn::Matrix4 previous = motionVectorHistory_->update(
+          drawableTransform.first,
+          projectionMatrix() * drawableTransform.second);
+      linearDepthShader_->setPreviousTransformationProjectionMatrix(previous);
+      instancedLinearDepthShader_->setPreviousTransformationProjectionMatrix(
+          previous);
+      drawableTransform.first.get().draw(drawableTransform.second, *this);
+    }
+  } else if ((flags & Flag::OcclusionCulling) &&
+             !(flags & (Flag::DepthOnly | Flag::Multiview)) &&
+             occlusionCulling_) {
+    occlusionCulling_->draw(*this, drawableTransforms, *occlusionBoxShader_,
+                            *occlusionBoxMesh_);
+  } else {
+    MagnumCamera::draw(drawableTransforms);
+  }
 
   // reset
+  if (flags & Flag::DepthOnly) {
+    Mn::GL::Renderer::setColorMask(true, true, true, true);
+  }
   if (useDrawableIds_) {
     useDrawableIds_ = false;
   }
-  return drawableTransforms.size();
+  drawLinearDepth_ = false;
+  drawMultiview_ = false;
+  shading_ = Shading::Phong;
+  phongUniformCache_.endDrawPass();
+  return drawableTransforms.size() + numIndirectBatched;
+}
+
+void RenderCamera::setLinearDepthShaders(DepthShader* shader,
+                                         DepthShader* instancedShader) {
+  linearDepthShader_ = shader;
+  instancedLinearDepthShader_ = instancedShader;
+  numDrawablesWithoutLinearDepth_ = 0;
+}
+
+void RenderCamera::setOcclusionCulling(OcclusionCulling* occlusionCulling,
+                                       DepthShader* boxShader,
+                                       Mn::GL::Mesh* boxMesh) {
+  CORRADE_INTERNAL_ASSERT(!occlusionCulling || (boxShader && boxMesh));
+  occlusionCulling_ = occlusionCulling;
+  occlusionBoxShader_ = boxShader;
+  occlusionBoxMesh_ = boxMesh;
 }
 
 esp::geo::Ray RenderCamera::unproject(const Mn::Vector2i& viewportPosition) {
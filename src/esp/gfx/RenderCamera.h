@@ -5,15 +5,26 @@
 #ifndef ESP_GFX_RENDERCAMERA_H_
 #define ESP_GFX_RENDERCAMERA_H_
 
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/GL/GL.h>
+
 #include "magnum.h"
 
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
+#include "esp/gfx/PhongUniformCache.h"
 #include "esp/scene/SceneNode.h"
 
 namespace esp {
 namespace gfx {
 
+class DepthShader;
+class Drawable;
+class DrawableGroup;
+class IndirectCullingShader;
+class MotionVectorHistory;
+class OcclusionCulling;
+
 class RenderCamera : public MagnumCamera {
  public:
   /**
@@ -38,11 +49,131 @@ class RenderCamera : public MagnumCamera {
      * object id" is not set)
      */
     UseDrawableIdAsObjectId = 1 << 2,
+    /**
+     * Draw the drawables sorted by the GL state they bind (shader, material,
+     * texture, mesh) instead of in scene graph order, to minimize state
+     * switches. Only has an effect for a @ref DrawableGroup, see @ref
+     * DrawableGroup::sortByDrawState().
+     */
+    SortByDrawState = 1 << 3,
+    /**
+     * Draw the linear depth of the drawables with the shaders set by @ref
+     * setLinearDepthShaders() instead of their own, for a render target which
+     * fuses the depth unprojection into the pass, see @ref
+     * RenderTarget::hasLinearDepth(). Drawables which cannot, e.g. PTex
+     * meshes drawn with a geometry shader, draw with their own shader and
+     * are counted by @ref countDrawableWithoutLinearDepth().
+     */
+    LinearDepth = 1 << 4,
+    /**
+     * Skip the drawables hidden behind others with the @ref OcclusionCulling
+     * set by @ref setOcclusionCulling(), after the frustum culling. Ignored
+     * if none is set.
+     */
+    OcclusionCulling = 1 << 5,
+    /**
+     * Collect the drawables and their transformations from the flattened
+     * @ref RenderList of the @ref DrawableGroup instead of walking the scene
+     * graph, see @ref DrawableGroup::renderList(). With @ref FrustumCulling,
+     * the entries of the list are culled one by one. Only has an effect for a
+     * @ref DrawableGroup.
+     */
+    RenderList = 1 << 6,
+    /**
+     * Draw the drawables with lit materials unlit, with their albedo color
+     * and texture and no lighting, normal or specular maps, see @ref
+     * shading(). Drawables without a cheaper variant draw as usual.
+     */
+    Unlit = 1 << 7,
+    /**
+     * Draw the drawables with lit materials with their vertex colors, or
+     * their flat base color, and no textures or lighting. Takes precedence
+     * over @ref Flag::Unlit.
+     */
+    VertexColorOnly = 1 << 8,
+    /**
+     * Draw only the depth buffer, for a render target of a depth sensor, see
+     * @ref RenderTarget::isDepthOnly(). As for @ref Flag::LinearDepth, the
+     * drawables draw with the position-only shaders set by @ref
+     * setLinearDepthShaders(), but with color writes masked. @ref
+     * Flag::OcclusionCulling is ignored, its bounding boxes would cost about
+     * as much as drawing the occluded positions.
+     */
+    DepthOnly = 1 << 9,
+    /**
+     * Draw the surface normals in camera space, for a render target of a
+     * normal sensor, see @ref RenderTarget::hasSurfaceNormals(). As for @ref
+     * Flag::LinearDepth, the drawables draw with the shaders set by @ref
+     * setLinearDepthShaders(), which output normals with @ref
+     * DepthShader::Flag::SurfaceNormals.
+     */
+    SurfaceNormals = 1 << 10,
+    /**
+     * Draw the motion vectors since the previous frame, for a render target
+     * of an optical flow sensor, see @ref RenderTarget::hasMotionVectors().
+     * As for @ref Flag::LinearDepth, the drawables draw with the shaders set
+     * by @ref setLinearDepthShaders(), which output motion vectors with @ref
+     * DepthShader::Flag::MotionVectors, and each gets its previous
+     * transformation from the @ref MotionVectorHistory set by @ref
+     * setMotionVectorHistory(). @ref Flag::OcclusionCulling is ignored.
+     */
+    MotionVectors = 1 << 11,
+    /**
+     * Draw two views at once into a @ref MultiviewFramebuffer, together with
+     * @ref Flag::LinearDepth. The drawables are transformed relative to this
+     * camera and the shaders set by @ref setLinearDepthShaders(), with @ref
+     * DepthShader::Flag::Multiview, transform them on to each view. Culled
+     * against the frustum set by @ref setCullingFrustum(), which is expected
+     * to hold both views. Drawables which cannot draw linear depth are not
+     * drawn, only counted by @ref countDrawableWithoutLinearDepth(), and
+     * @ref Flag::OcclusionCulling is ignored.
+     */
+    Multiview = 1 << 12,
+    /**
+     * Cull Drawables attached to @ref SceneNodes with @ref
+     * scene::SceneNodeType::OBJECT, the opposite of @ref ObjectsOnly, e.g.
+     * to draw the static stage on its own.
+     */
+    ExcludeObjects = 1 << 13,
+    /**
+     * In the passes with @ref Flag::DepthOnly or @ref Flag::LinearDepth,
+     * draw the static drawables of a @ref DrawableGroup which have their
+     * triangles set from its @ref IndirectDrawBatch, culled on the GPU by
+     * the shader set by @ref setIndirectCullingShader() and drawn with one
+     * multi-draw, see @ref DrawableGroup::indirectDrawBatch(). The other
+     * drawables are culled and drawn one by one as usual. Ignored if no
+     * shader is set, together with @ref Flag::ObjectsOnly, @ref
+     * Flag::SurfaceNormals, @ref Flag::MotionVectors or @ref
+     * Flag::Multiview, and for groups without a batch.
+     */
+    GpuDriven = 1 << 14,
+    /**
+     * Cull the static drawables of a @ref DrawableGroup which are not
+     * potentially visible from the cell of the camera, before the frustum
+     * culling, see @ref DrawableGroup::setPotentiallyVisibleSet(). All are
+     * kept if the group has no set or the camera is outside of its cells.
+     * The drawables of an indirect batch, see @ref Flag::GpuDriven, are
+     * culled on the GPU as usual.
+     */
+    PotentiallyVisibleSet = 1 << 15,
   };
 
   typedef Corrade::Containers::EnumSet<Flag> Flags;
   CORRADE_ENUMSET_FRIEND_OPERATORS(Flags)
 
+  /**
+   * @brief The shading of the current rendering pass, see @ref Flag::Unlit
+   * and @ref Flag::VertexColorOnly
+   */
+  enum class Shading : uint8_t {
+    //! the full Phong variant of each material
+    Phong,
+    //! albedo color and texture, without lighting
+    Unlit,
+    //! vertex colors or the base color, without textures or lighting
+    VertexColor,
+  };
+
   RenderCamera(scene::SceneNode& node);
   RenderCamera(scene::SceneNode& node,
                const vec3f& eye,
@@ -92,6 +223,43 @@ class RenderCamera : public MagnumCamera {
               std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
                         Magnum::Matrix4>>& drawableTransforms);
 
+  /**
+   * @brief Collect the drawables of a group which are inside the camera
+   * frustum, together with their transformations relative to the camera
+   *
+   * Unlike @ref cull(), this does not compute the transformations of all
+   * drawables upfront. Static drawables are culled hierarchically with the
+   * BVH of the group, see @ref DrawableGroup::cull(), and transformations are
+   * only computed for the drawables which passed.
+   *
+   * @param drawables, the drawable group to cull
+   * @param indirectBatched, whether to collect the drawables of the @ref
+   * DrawableGroup::indirectDrawBatch() too
+   * @return a vector of pairs of the visible Drawable3D objects and their
+   * transformations relative to the camera
+   */
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+  visibleDrawableTransformations(DrawableGroup& drawables,
+                                 bool indirectBatched = true);
+
+  /**
+   * @brief Collect the drawables of a group with their transformations
+   * relative to the camera from its flattened @ref RenderList
+   *
+   * Updates the entries of the nodes which moved first, see @ref
+   * RenderList::update(). With @ref Flag::FrustumCulling in @p flags, the
+   * drawables outside the camera frustum are skipped.
+   *
+   * @param drawables, the drawable group to collect
+   * @param flags, the rendering flags of the pass
+   * @return a vector of pairs of the Drawable3D objects and their
+   * transformations relative to the camera, in the order of the group
+   */
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+  renderListTransformations(DrawableGroup& drawables, Flags flags);
+
   /**
    * @brief Cull Drawables for SceneNodes which are not OBJECT type.
    *
@@ -104,6 +272,46 @@ class RenderCamera : public MagnumCamera {
           std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
                     Magnum::Matrix4>>& drawableTransforms);
 
+  /**
+   * @brief Cull Drawables for SceneNodes which are OBJECT type.
+   *
+   * @param drawableTransforms, a vector of pairs of Drawable3D object and its
+   * absolute transformation
+   * @return the number of drawables that are not culled
+   */
+  size_t removeObjects(
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms);
+
+  /**
+   * @brief Cull Drawables drawn from the indirect batch of their group, see
+   * @ref Drawable::isIndirectBatched().
+   *
+   * @param drawableTransforms, a vector of pairs of Drawable3D object of a
+   * @ref DrawableGroup and its absolute transformation
+   * @return the number of drawables that are not culled
+   */
+  size_t removeIndirectBatched(
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms);
+
+  /**
+   * @brief Cull the static Drawables of a @ref DrawableGroup which are not
+   * in @p potentiallyVisible, see @ref DrawableGroup::potentiallyVisible().
+   *
+   * @param drawableTransforms, a vector of pairs of Drawable3D object of a
+   * @ref DrawableGroup and its absolute transformation
+   * @param potentiallyVisible, the bitset of the static drawables to keep
+   * @return the number of drawables that are not culled
+   */
+  size_t removeNotPotentiallyVisible(
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms,
+      Corrade::Containers::ArrayView<const uint64_t> potentiallyVisible);
+
   /**
    * @brief if the "immediate" following rendering pass is to use drawable ids
    * as the object ids.
@@ -113,6 +321,109 @@ class RenderCamera : public MagnumCamera {
    * following rendering pass, otherwise false
    */
   bool useDrawableIds() { return useDrawableIds_; }
+
+  /**
+   * @brief The shading of the drawables in the current rendering pass, @ref
+   * Shading::Phong outside of a pass with @ref Flag::Unlit or @ref
+   * Flag::VertexColorOnly
+   */
+  Shading shading() const { return shading_; }
+
+  /**
+   * @brief The light and camera uniforms of the Phong shaders of the current
+   * rendering pass, reset by each @ref draw()
+   */
+  PhongUniformCache& phongUniformCache() { return phongUniformCache_; }
+
+  /**
+   * @brief Set the shaders drawing linear depth in the passes with @ref
+   * Flag::LinearDepth, for regular and instanced meshes, and reset @ref
+   * getNumDrawablesWithoutLinearDepth()
+   *
+   * The shaders are expected to have the projection matrix of the camera
+   * set already, the drawables only set their transformation.
+   */
+  void setLinearDepthShaders(DepthShader* shader, DepthShader* instancedShader);
+
+  /**
+   * @brief The shader to draw linear depth with if the "immediate" following
+   * rendering pass is to draw linear depth, see @ref Flag::LinearDepth,
+   * nullptr otherwise
+   */
+  DepthShader* linearDepthShader() {
+    return drawLinearDepth_ ? linearDepthShader_ : nullptr;
+  }
+
+  /**
+   * @brief The shader to draw the linear depth of instanced meshes with, see
+   * @ref linearDepthShader()
+   */
+  DepthShader* instancedLinearDepthShader() {
+    return drawLinearDepth_ ? instancedLinearDepthShader_ : nullptr;
+  }
+
+  /**
+   * @brief Whether the "immediate" following rendering pass draws two views
+   * at once, see @ref Flag::Multiview
+   */
+  bool drawsMultiview() const { return drawMultiview_; }
+
+  /**
+   * @brief Record that a drawable drew with its own shader in a pass with
+   * @ref Flag::LinearDepth
+   */
+  void countDrawableWithoutLinearDepth() { ++numDrawablesWithoutLinearDepth_; }
+
+  /**
+   * @brief The number of drawables which drew with their own shader in the
+   * passes with @ref Flag::LinearDepth since @ref setLinearDepthShaders()
+   */
+  size_t getNumDrawablesWithoutLinearDepth() const {
+    return numDrawablesWithoutLinearDepth_;
+  }
+
+  /**
+   * @brief Set the occlusion of the view drawn in the passes with @ref
+   * Flag::OcclusionCulling, with the shader and mesh drawing the bounding
+   * boxes, see @ref OcclusionCulling::draw(). Pass nullptr to unset.
+   *
+   * The shader is expected to have the projection matrix of the camera set
+   * already.
+   */
+  void setOcclusionCulling(OcclusionCulling* occlusionCulling,
+                           DepthShader* boxShader,
+                           Mn::GL::Mesh* boxMesh);
+
+  /**
+   * @brief Set where the drawables were in the previous frame of the view
+   * drawn in the passes with @ref Flag::MotionVectors. Pass nullptr to
+   * unset.
+   *
+   * The drawables drawn are recorded into @p history, whose @ref
+   * MotionVectorHistory::beginFrame() is expected to be called once before
+   * the passes of a frame.
+   */
+  void setMotionVectorHistory(MotionVectorHistory* history) {
+    motionVectorHistory_ = history;
+  }
+
+  /**
+   * @brief Cull against @p frustum, relative to the world origin, instead of
+   * the frustum of the camera, e.g. against one holding both views of @ref
+   * Flag::Multiview. Pass nullptr to unset.
+   */
+  void setCullingFrustum(const Mn::Frustum* frustum) {
+    cullingFrustum_ = frustum;
+  }
+
+  /**
+   * @brief Set the shader culling the indirect batches drawn in the passes
+   * with @ref Flag::GpuDriven. Pass nullptr to unset.
+   */
+  void setIndirectCullingShader(IndirectCullingShader* shader) {
+    indirectCullingShader_ = shader;
+  }
+
   /**
    * @brief Unproject a 2D viewport point to a 3D ray with origin at camera
    * position.
@@ -133,8 +444,50 @@ class RenderCamera : public MagnumCamera {
   }
 
  protected:
+  //! the frustum the drawables are culled against, relative to the world
+  //! origin, see setCullingFrustum()
+  Mn::Frustum cullingFrustum();
+
+  //! append the result of visibleDrawableTransformations() to
+  //! drawableTransforms, testing only the static drawables in
+  //! potentiallyVisible unless it is empty
+  void appendVisibleDrawableTransformations(
+      DrawableGroup& drawables,
+      bool indirectBatched,
+      Corrade::Containers::ArrayView<const uint64_t> potentiallyVisible,
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms);
+
+  //! append the result of renderListTransformations() to drawableTransforms
+  void appendRenderListTransformations(
+      DrawableGroup& drawables,
+      Flags flags,
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms);
+
   size_t previousNumVisibleDrawables_ = 0;
   bool useDrawableIds_ = false;
+  Shading shading_ = Shading::Phong;
+  bool drawLinearDepth_ = false;
+  DepthShader* linearDepthShader_ = nullptr;
+  DepthShader* instancedLinearDepthShader_ = nullptr;
+  size_t numDrawablesWithoutLinearDepth_ = 0;
+  OcclusionCulling* occlusionCulling_ = nullptr;
+  DepthShader* occlusionBoxShader_ = nullptr;
+  Mn::GL::Mesh* occlusionBoxMesh_ = nullptr;
+  MotionVectorHistory* motionVectorHistory_ = nullptr;
+  bool drawMultiview_ = false;
+  const Mn::Frustum* cullingFrustum_ = nullptr;
+  IndirectCullingShader* indirectCullingShader_ = nullptr;
+  PhongUniformCache phongUniformCache_;
+  //! the drawables of the pass with their transformations, and the result of
+  //! the culling of a group, kept so that their arrays are allocated once
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      drawableTransforms_;
+  std::vector<std::reference_wrapper<Drawable>> visibleDrawables_;
   ESP_SMART_POINTERS(RenderCamera)
 };
 
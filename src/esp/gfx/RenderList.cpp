@@ -0,0 +1,136 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RenderList.h"
+
+#include <Corrade/Containers/Optional.h>
+#include <Magnum/Math/Intersection.h>
+#include <Magnum/SceneGraph/AbstractFeature.h>
+
+#include "esp/gfx/DrawableGroup.h"
+#include "esp/scene/SceneNode.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Feature on the node of an entry, caching its absolute
+ * transformation. Its lifetime is bound to the node, so it detaches from the
+ * list once the node goes away.
+ */
+class RenderList::Entry : public Mn::SceneGraph::AbstractFeature3D {
+ public:
+  Entry(scene::SceneNode& node, RenderList& list, size_t index)
+      : Mn::SceneGraph::AbstractFeature3D{node}, list_{list}, index_{index} {
+    setCachedTransformations(Mn::SceneGraph::CachedTransformation::Absolute);
+  }
+
+  ~Entry() { list_.entries_[index_] = nullptr; }
+
+  scene::SceneNode& node() { return static_cast<scene::SceneNode&>(object()); }
+
+ private:
+  // the scene graph marks only a clean node dirty, the update cleans it
+  void markDirty() override { list_.dirty_.push_back(index_); }
+
+  void clean(const Mn::Matrix4& absoluteTransformationMatrix) override {
+    list_.worldTransformations_[index_] = absoluteTransformationMatrix;
+  }
+
+  RenderList& list_;
+  size_t index_;
+};
+
+RenderList::RenderList() = default;
+
+RenderList::~RenderList() {
+  clear();
+}
+
+void RenderList::clear() {
+  for (Entry* entry : entries_) {
+    // the feature removes itself from its node
+    delete entry;
+  }
+  drawables_.clear();
+  entries_.clear();
+  worldTransformations_.clear();
+  aabbs_.clear();
+  cullable_.clear();
+  dirty_.clear();
+}
+
+void RenderList::build(DrawableGroup& group) {
+  clear();
+  const size_t size = group.size();
+  drawables_.reserve(size);
+  entries_.reserve(size);
+  worldTransformations_.resize(size);
+  aabbs_.resize(size);
+  cullable_.resize(size);
+
+  for (size_t i = 0; i != size; ++i) {
+    Mn::SceneGraph::Drawable3D& drawable = group[i];
+    auto& node = static_cast<scene::SceneNode&>(drawable.object());
+    drawables_.push_back(&drawable);
+    // the feature is owned by the node
+    // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
+    entries_.push_back(new Entry{node, *this, i});
+    // a clean node doesn't call Entry::clean() when cleaned again
+    worldTransformations_[i] = node.absoluteTransformationMatrix();
+    updateEntry(i);
+  }
+}
+
+void RenderList::updateEntry(size_t i) {
+  scene::SceneNode& node = entries_[i]->node();
+  // calls Entry::clean() with the new transformation, and lets the next move
+  // notify the entry again
+  node.setClean();
+  Cr::Containers::Optional<Mn::Range3D> aabb = node.getWorldAABB();
+  cullable_[i] = bool(aabb);
+  if (aabb) {
+    aabbs_[i] = *aabb;
+  }
+}
+
+size_t RenderList::update() {
+  size_t numUpdated = 0;
+  for (size_t i : dirty_) {
+    // a destroyed node is dropped when the group rebuilds the list
+    if (entries_[i]) {
+      updateEntry(i);
+      ++numUpdated;
+    }
+  }
+  dirty_.clear();
+  return numUpdated;
+}
+
+size_t RenderList::drawableTransformations(
+    const Mn::Matrix4& cameraMatrix,
+    const Mn::Frustum* frustum,
+    DrawableTransforms& drawableTransforms) const {
+  size_t numCulled = 0;
+  drawableTransforms.reserve(drawableTransforms.size() + drawables_.size());
+  for (size_t i = 0; i != drawables_.size(); ++i) {
+    if (!entries_[i]) {
+      continue;
+    }
+    if (frustum && cullable_[i] &&
+        !Mn::Math::Intersection::rangeFrustum(aabbs_[i], *frustum)) {
+      ++numCulled;
+      continue;
+    }
+    drawableTransforms.emplace_back(*drawables_[i],
+                                    cameraMatrix * worldTransformations_[i]);
+  }
+  return numCulled;
+}
+
+}  // namespace gfx
+}  // namespace esp
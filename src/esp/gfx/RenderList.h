@@ -0,0 +1,133 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_RENDERLIST_H_
+#define ESP_GFX_RENDERLIST_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::RenderList
+ */
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/SceneGraph/Drawable.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+class DrawableGroup;
+
+/**
+ * @brief A flattened snapshot of the drawables of a @ref DrawableGroup, for
+ * @ref RenderCamera::Flag::RenderList
+ *
+ * Keeps the drawables of the group with the world transformation and world
+ * space bounding box of their node in contiguous arrays, so that culling and
+ * collecting the transformations for a draw iterate the arrays instead of
+ * walking the scene graph. Each entry has a feature on the node of its
+ * drawable, which the scene graph notifies when the node or an ancestor moves,
+ * so @ref update() only recomputes the entries of the nodes which moved.
+ *
+ * The list is rebuilt by its group after drawables were added or removed, see
+ * @ref DrawableGroup::renderList(). The drawables read their semantic id from
+ * their node when drawing, so it is not copied.
+ */
+class RenderList {
+ public:
+  /** @brief Drawables with their transformations relative to the camera */
+  typedef std::vector<
+      std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                Magnum::Matrix4>>
+      DrawableTransforms;
+
+  /** @brief Constructor, of an empty list */
+  explicit RenderList();
+
+  ~RenderList();
+
+  RenderList(const RenderList&) = delete;
+  RenderList& operator=(const RenderList&) = delete;
+
+  /**
+   * @brief Replace the entries by the drawables of @p group, in their order
+   * in the group
+   */
+  void build(DrawableGroup& group);
+
+  /**
+   * @brief Recompute the transformations and bounding boxes of the entries
+   * whose node moved since the last update
+   * @return The number of recomputed entries
+   */
+  size_t update();
+
+  /** @brief The number of entries */
+  size_t size() const { return drawables_.size(); }
+
+  /** @brief The world transformation of the node of each entry */
+  const std::vector<Magnum::Matrix4>& worldTransformations() const {
+    return worldTransformations_;
+  }
+
+  /**
+   * @brief The world space bounding box of the node of each entry, see
+   * @ref scene::SceneNode::getWorldAABB(). Only meaningful if the entry is
+   * @ref isCullable().
+   */
+  const std::vector<Magnum::Range3D>& worldAABBs() const { return aabbs_; }
+
+  /** @brief Whether the node of entry @p i has a bounding box */
+  bool isCullable(size_t i) const { return cullable_[i]; }
+
+  /**
+   * @brief Append the drawables with their transformations relative to the
+   * camera
+   *
+   * @param cameraMatrix    The camera matrix the transformations are
+   *                        relative to
+   * @param frustum         If not @cpp nullptr @ce, the entries with a
+   *                        bounding box outside of this world space frustum
+   *                        are skipped
+   * @param[out] drawableTransforms The drawables are appended here
+   * @return The number of skipped entries
+   *
+   * Expects @ref update() to have been called since the nodes moved.
+   */
+  size_t drawableTransformations(const Magnum::Matrix4& cameraMatrix,
+                                 const Magnum::Frustum* frustum,
+                                 DrawableTransforms& drawableTransforms) const;
+
+ private:
+  class Entry;
+  friend Entry;
+
+  //! recompute the transformation and bounding box of entry i
+  void updateEntry(size_t i);
+
+  //! remove the features from the nodes
+  void clear();
+
+  std::vector<Magnum::SceneGraph::Drawable3D*> drawables_;
+  //! the feature of each entry, nullptr once its node was destroyed
+  std::vector<Entry*> entries_;
+  std::vector<Magnum::Matrix4> worldTransformations_;
+  std::vector<Magnum::Range3D> aabbs_;
+  std::vector<bool> cullable_;
+  //! the entries notified of a move since the last update, may repeat
+  std::vector<size_t> dirty_;
+
+  ESP_SMART_POINTERS(RenderList)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_RENDERLIST_H_
@@ -6,6 +6,7 @@
 #include <Magnum/GL/BufferImage.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/OpenGL.h>
 #include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderbuffer.h>
 #include <Magnum/GL/RenderbufferFormat.h>
@@ -15,12 +16,21 @@
 #include <Magnum/Image.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Math/Color.h>
+#include <Magnum/Math/Functions.h>
 #include <Magnum/PixelFormat.h>
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Utility/Algorithms.h>
+
+#include <memory>
+#include <vector>
 
 #include "RenderTarget.h"
 #include "magnum.h"
 
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/FrameArena.h"
+#include "esp/gfx/FrameConversion.h"
+#include "esp/gfx/GpuProfiling.h"
 
 #ifdef ESP_BUILD_WITH_CUDA
 #include <cuda_gl_interop.h>
@@ -40,21 +50,145 @@ const Mn::GL::Framebuffer::ColorAttachment ObjectIdBuffer =
     Mn::GL::Framebuffer::ColorAttachment{1};
 const Mn::GL::Framebuffer::ColorAttachment UnprojectedDepthBuffer =
     Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment LinearDepthBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{2};
+const Mn::GL::Framebuffer::ColorAttachment NormalBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{3};
+const Mn::GL::Framebuffer::ColorAttachment MotionVectorBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{4};
+const Mn::GL::Framebuffer::ColorAttachment ConvertedBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment PixelCountBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment PixelBoundsBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{1};
+
+namespace {
+//! how a converted frame is stored on the GPU and read from it
+struct ConvertedFrameFormat {
+  Mn::GL::RenderbufferFormat storage;
+  Mn::GL::PixelFormat format;
+  Mn::GL::PixelType type;
+  Mn::PixelFormat pixelFormat;
+};
+
+ConvertedFrameFormat convertedFrameFormat(RenderTarget::ConvertedFrame frame) {
+  using Frame = RenderTarget::ConvertedFrame;
+  switch (frame) {
+    case Frame::Rgba:
+      return {Mn::GL::RenderbufferFormat::RGBA8, Mn::GL::PixelFormat::RGBA,
+              Mn::GL::PixelType::UnsignedByte, Mn::PixelFormat::RGBA8Unorm};
+    case Frame::Rgb:
+      return {Mn::GL::RenderbufferFormat::RGB8, Mn::GL::PixelFormat::RGB,
+              Mn::GL::PixelType::UnsignedByte, Mn::PixelFormat::RGB8Unorm};
+    case Frame::Gray:
+      return {Mn::GL::RenderbufferFormat::R8, Mn::GL::PixelFormat::Red,
+              Mn::GL::PixelType::UnsignedByte, Mn::PixelFormat::R8Unorm};
+    case Frame::Depth:
+      return {Mn::GL::RenderbufferFormat::R32F, Mn::GL::PixelFormat::Red,
+              Mn::GL::PixelType::Float, Mn::PixelFormat::R32F};
+    case Frame::HalfDepth:
+      return {Mn::GL::RenderbufferFormat::R16F, Mn::GL::PixelFormat::Red,
+              Mn::GL::PixelType::HalfFloat, Mn::PixelFormat::R16F};
+    case Frame::MillimeterDepth:
+      return {Mn::GL::RenderbufferFormat::R16UI,
+              Mn::GL::PixelFormat::RedInteger,
+              Mn::GL::PixelType::UnsignedShort, Mn::PixelFormat::R16UI};
+    case Frame::ObjectId:
+    case Frame::MappedObjectId:
+      return {Mn::GL::RenderbufferFormat::R32UI,
+              Mn::GL::PixelFormat::RedInteger, Mn::GL::PixelType::UnsignedInt,
+              Mn::PixelFormat::R32UI};
+  }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+//! the number of samples the GPU can draw a render target with
+Mn::Int supportedSamples(Mn::Int samples) {
+#ifdef MAGNUM_TARGET_WEBGL
+  // WebGL 2 has no multisample integer renderbuffers for the ObjectID
+  static_cast<void>(samples);
+  return 1;
+#else
+  GLint maxIntegerSamples = 1;
+  glGetIntegerv(GL_MAX_INTEGER_SAMPLES, &maxIntegerSamples);
+  return Mn::Math::clamp(samples, 1,
+                         Mn::Math::min(Mn::GL::Renderbuffer::maxSamples(),
+                                       Mn::Int(maxIntegerSamples)));
+#endif
+}
+
+//! the conversion shader variant of each frame, see conversionShaders_
+int conversionShaderIndex(RenderTarget::ConvertedFrame frame) {
+  if (frame == RenderTarget::ConvertedFrame::Gray)
+    return 1;
+  if (frame == RenderTarget::ConvertedFrame::MillimeterDepth)
+    return 2;
+  if (frame == RenderTarget::ConvertedFrame::MappedObjectId)
+    return 3;
+  return 0;
+}
+}  // namespace
+
+#ifndef MAGNUM_TARGET_WEBGL
+namespace {
+enum class AsyncReadType {
+  Rgba,
+  Depth,
+  UnprojectedDepth,
+  ObjectId,
+  SurfaceNormals,
+  MotionVectors,
+  Converted
+};
+
+//! A pixel buffer object of the readback ring and the fence guarding it
+struct AsyncRead {
+  Mn::GL::BufferImage2D image{Mn::NoCreate};
+  AsyncReadType type = AsyncReadType::Rgba;
+  GLsync fence = nullptr;
+};
+}  // namespace
+#endif
 
 struct RenderTarget::Impl {
   Impl(const Mn::Vector2i& size,
        const Mn::Vector2& depthUnprojection,
        DepthShader* depthShader,
-       Renderer::Flags flags)
-      : colorBuffer_{},
+       Renderer::Flags flags,
+       Mn::Int samples)
+      : size_{size},
+        // normals and motion vectors are drawn with a single sample, see
+        // samples()
+        samples_{(flags & (Renderer::Flag::SurfaceNormals |
+                           Renderer::Flag::MotionVectors))
+                     ? 1
+                     : supportedSamples(samples)},
+        colorBuffer_{},
         objectIdBuffer_{},
         depthRenderTexture_{},
+        linearDepth_{Mn::NoCreate},
+        normals_{Mn::NoCreate},
+        motionVectors_{Mn::NoCreate},
         framebuffer_{Mn::NoCreate},
+        multisampleColor_{Mn::NoCreate},
+        multisampleObjectId_{Mn::NoCreate},
+        multisampleDepth_{Mn::NoCreate},
+        multisampleFramebuffer_{Mn::NoCreate},
         depthUnprojection_{depthUnprojection},
         depthShader_{depthShader},
         unprojectedDepth_{Mn::NoCreate},
         depthUnprojectionMesh_{Mn::NoCreate},
         depthUnprojectionFrameBuffer_{Mn::NoCreate},
+        conversionSource_{Mn::NoCreate},
+        conversionSourceFramebuffer_{Mn::NoCreate},
+        converted_{Mn::NoCreate},
+        conversionFramebuffer_{Mn::NoCreate},
+        conversionMesh_{Mn::NoCreate},
+        pixelCounts_{Mn::NoCreate},
+        pixelBounds_{Mn::NoCreate},
+        statisticsFramebuffer_{Mn::NoCreate},
+        statisticsMesh_{Mn::NoCreate},
         rendererFlags_{flags} {
     if (depthShader_) {
       CORRADE_INTERNAL_ASSERT(depthShader_->flags() &
@@ -72,11 +206,82 @@ struct RenderTarget::Impl {
     framebuffer_.attachRenderbuffer(RgbaBuffer, colorBuffer_)
         .attachRenderbuffer(ObjectIdBuffer, objectIdBuffer_)
         .attachTexture(Mn::GL::Framebuffer::BufferAttachment::Depth,
-                       depthRenderTexture_, 0)
-        .mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+                       depthRenderTexture_, 0);
+    // linear depth can't be resolved, multisample targets unproject the
+    // depth of one sample, see samples()
+    if (rendererFlags_ & Renderer::Flag::SurfaceNormals) {
+      normals_ = Mn::GL::Renderbuffer{};
+      normals_.setStorage(Mn::GL::RenderbufferFormat::RGBA16F, size);
+      framebuffer_.attachRenderbuffer(NormalBuffer, normals_)
+          .mapForDraw({{0, NormalBuffer}});
+    } else if (rendererFlags_ & Renderer::Flag::MotionVectors) {
+      motionVectors_ = Mn::GL::Renderbuffer{};
+      motionVectors_.setStorage(Mn::GL::RenderbufferFormat::RG32F, size);
+      framebuffer_.attachRenderbuffer(MotionVectorBuffer, motionVectors_)
+          .mapForDraw({{0, MotionVectorBuffer}});
+    } else if ((rendererFlags_ & Renderer::Flag::FusedDepthUnprojection) &&
+        samples_ == 1) {
+      // the depth shader, and whatever a drawable which cannot draw linear
+      // depth outputs as color, goes to the linear depth only
+      linearDepth_ = Mn::GL::Renderbuffer{};
+      linearDepth_.setStorage(Mn::GL::RenderbufferFormat::R32F, size);
+      framebuffer_.attachRenderbuffer(LinearDepthBuffer, linearDepth_)
+          .mapForDraw({{0, LinearDepthBuffer}});
+    } else {
+      framebuffer_.mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+    }
     CORRADE_INTERNAL_ASSERT(
         framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
         Mn::GL::Framebuffer::Status::Complete);
+
+    if (samples_ > 1) {
+      // drawn into multisample copies of the buffers and resolved into the
+      // single-sample ones, which all reads take, on renderExit()
+      multisampleColor_ = Mn::GL::Renderbuffer{};
+      multisampleColor_.setStorageMultisample(
+          samples_, Mn::GL::RenderbufferFormat::SRGB8Alpha8, size);
+      multisampleObjectId_ = Mn::GL::Renderbuffer{};
+      multisampleObjectId_.setStorageMultisample(
+          samples_, Mn::GL::RenderbufferFormat::R32UI, size);
+      multisampleDepth_ = Mn::GL::Renderbuffer{};
+      multisampleDepth_.setStorageMultisample(
+          samples_, Mn::GL::RenderbufferFormat::DepthComponent32F, size);
+      multisampleFramebuffer_ = Mn::GL::Framebuffer{{{}, size}};
+      multisampleFramebuffer_.attachRenderbuffer(RgbaBuffer, multisampleColor_)
+          .attachRenderbuffer(ObjectIdBuffer, multisampleObjectId_)
+          .attachRenderbuffer(Mn::GL::Framebuffer::BufferAttachment::Depth,
+                              multisampleDepth_)
+          .mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+      CORRADE_INTERNAL_ASSERT(
+          multisampleFramebuffer_.checkStatus(
+              Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+    }
+  }
+
+  //! the framebuffer the draws go to
+  Mn::GL::Framebuffer& drawFramebuffer() {
+    return samples_ > 1 ? multisampleFramebuffer_ : framebuffer_;
+  }
+
+  //! resolve the samples of the color and ObjectID into the single-sample
+  //! buffers, and the depth for its unprojection
+  void resolveMultisample() {
+    const Mn::Range2Di area{{}, size_};
+    for (const Mn::GL::Framebuffer::ColorAttachment attachment :
+         {RgbaBuffer, ObjectIdBuffer}) {
+      multisampleFramebuffer_.mapForRead(attachment);
+      framebuffer_.mapForDraw(attachment);
+      Mn::GL::AbstractFramebuffer::blit(
+          multisampleFramebuffer_, framebuffer_, area, area,
+          Mn::GL::FramebufferBlit::Color,
+          Mn::GL::FramebufferBlitFilter::Nearest);
+    }
+    framebuffer_.mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+    Mn::GL::AbstractFramebuffer::blit(multisampleFramebuffer_, framebuffer_,
+                                      area, area,
+                                      Mn::GL::FramebufferBlit::Depth,
+                                      Mn::GL::FramebufferBlitFilter::Nearest);
   }
 
   void initDepthUnprojector() {
@@ -111,15 +316,172 @@ struct RenderTarget::Impl {
   }
 
   void renderEnter() {
-    framebuffer_.clearDepth(1.0);
-    framebuffer_.clearColor(0, Mn::Color4{0, 0, 0, 1});
-    framebuffer_.clearColor(1, Mn::Vector4ui{});
+    Mn::GL::Framebuffer& framebuffer = drawFramebuffer();
+    framebuffer.clearDepth(1.0);
+    if (hasLinearDepth()) {
+      // zero for the pixels nothing is drawn to, as for the far plane
+      framebuffer.clearColor(0, Mn::Color4{});
+      depthUnprojectionRequired_ = false;
+    } else if (hasSurfaceNormals() || hasMotionVectors()) {
+      framebuffer.clearColor(0, Mn::Color4{});
+    } else if (!isDepthOnly()) {
+      framebuffer.clearColor(0, Mn::Color4{0, 0, 0, 1});
+      framebuffer.clearColor(1, Mn::Vector4ui{});
+    }
+    framebuffer.bind();
+  }
+
+  bool hasLinearDepth() const { return linearDepth_.id() != 0; }
+
+  bool hasSurfaceNormals() const { return normals_.id() != 0; }
+
+  bool hasMotionVectors() const { return motionVectors_.id() != 0; }
+
+  bool isDepthOnly() const {
+    return (rendererFlags_ & Renderer::Flag::DepthOnly) || hasLinearDepth();
+  }
+
+  void requireDepthUnprojection() { depthUnprojectionRequired_ = true; }
+
+  //! the color attachments the draws go to, whose formats are
+  //! layerFormats(), as mapped for draw by the constructor
+  Cr::Containers::ArrayView<const Mn::GL::Framebuffer::ColorAttachment>
+  drawnAttachments() const {
+    static const Mn::GL::Framebuffer::ColorAttachment colorAndObjectId[]{
+        RgbaBuffer, ObjectIdBuffer};
+    static const Mn::GL::Framebuffer::ColorAttachment linearDepth[]{
+        LinearDepthBuffer};
+    static const Mn::GL::Framebuffer::ColorAttachment normals[]{NormalBuffer};
+    if (hasSurfaceNormals()) {
+      return normals;
+    } else if (hasLinearDepth()) {
+      return linearDepth;
+    } else if (isDepthOnly()) {
+      return nullptr;
+    }
+    return colorAndObjectId;
+  }
+
+  //! the formats of drawnAttachments()
+  Mn::GL::RenderbufferFormat layerFormat(std::size_t i) const {
+    if (hasSurfaceNormals()) {
+      return Mn::GL::RenderbufferFormat::RGBA16F;
+    } else if (hasLinearDepth()) {
+      return Mn::GL::RenderbufferFormat::R32F;
+    }
+    return i == 0 ? Mn::GL::RenderbufferFormat::SRGB8Alpha8
+                  : Mn::GL::RenderbufferFormat::R32UI;
+  }
+
+  //! copy drawnAttachments() and the depth from @p source to @p destination
+  void copyLayer(Mn::GL::Framebuffer& source,
+                 Mn::GL::Framebuffer& destination) {
+    const Mn::Range2Di area{{}, size_};
+    for (const Mn::GL::Framebuffer::ColorAttachment attachment :
+         drawnAttachments()) {
+      source.mapForRead(attachment);
+      destination.mapForDraw(attachment);
+      Mn::GL::AbstractFramebuffer::blit(source, destination, area, area,
+                                        Mn::GL::FramebufferBlit::Color,
+                                        Mn::GL::FramebufferBlitFilter::Nearest);
+    }
+    Mn::GL::AbstractFramebuffer::blit(source, destination, area, area,
+                                      Mn::GL::FramebufferBlit::Depth,
+                                      Mn::GL::FramebufferBlitFilter::Nearest);
+    // back to what the draws go to
+    const auto attachments = drawnAttachments();
+    if (attachments.size() == 1) {
+      framebuffer_.mapForDraw({{0, attachments[0]}});
+    } else {
+      framebuffer_.mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+    }
+  }
+
+  bool supportsLayerCache() const {
+    return samples_ == 1 && !hasMotionVectors();
+  }
+
+  bool hasCachedLayer() const { return layerFramebuffer_.id() != 0; }
+
+  void cacheLayer() {
+    if (!supportsLayerCache())
+      throw std::runtime_error(
+          "RenderTarget::cacheLayer(): the target draws with more than one "
+          "sample or draws motion vectors");
+
+    if (!hasCachedLayer()) {
+      layerFramebuffer_ = Mn::GL::Framebuffer{{{}, size_}};
+      const auto attachments = drawnAttachments();
+      for (std::size_t i = 0; i != attachments.size(); ++i) {
+        layerBuffers_[i] = Mn::GL::Renderbuffer{};
+        layerBuffers_[i].setStorage(layerFormat(i), size_);
+        layerFramebuffer_.attachRenderbuffer(attachments[i], layerBuffers_[i]);
+      }
+      layerDepth_ = Mn::GL::Renderbuffer{};
+      layerDepth_.setStorage(Mn::GL::RenderbufferFormat::DepthComponent32F,
+                             size_);
+      layerFramebuffer_.attachRenderbuffer(
+          Mn::GL::Framebuffer::BufferAttachment::Depth, layerDepth_);
+    }
+    copyLayer(framebuffer_, layerFramebuffer_);
+    layerDepthUnprojectionRequired_ = depthUnprojectionRequired_;
+    framebuffer_.bind();
+  }
+
+  void renderEnterCachedLayer() {
+    if (!hasCachedLayer())
+      throw std::runtime_error(
+          "RenderTarget::renderEnterCachedLayer(): no layer was cached");
+
+    copyLayer(layerFramebuffer_, framebuffer_);
+    depthUnprojectionRequired_ = layerDepthUnprojectionRequired_;
     framebuffer_.bind();
   }
 
-  void renderReEnter() { framebuffer_.bind(); }
+  void discardCachedLayer() {
+    layerFramebuffer_ = Mn::GL::Framebuffer{Mn::NoCreate};
+    layerBuffers_[0] = Mn::GL::Renderbuffer{Mn::NoCreate};
+    layerBuffers_[1] = Mn::GL::Renderbuffer{Mn::NoCreate};
+    layerDepth_ = Mn::GL::Renderbuffer{Mn::NoCreate};
+  }
+
+  void copyDepthFrom(Mn::GL::Framebuffer& source) {
+    if (!isDepthOnly())
+      throw std::runtime_error(
+          "RenderTarget::copyDepthFrom(): the target is not depth-only");
+
+    // into the single-sample buffers the reads take, as renderExit()
+    // resolves them
+    const Mn::Range2Di area{{}, size_};
+    Mn::GL::FramebufferBlitMask mask{Mn::GL::FramebufferBlit::Depth};
+    if (hasLinearDepth()) {
+      mask |= Mn::GL::FramebufferBlit::Color;
+      depthUnprojectionRequired_ = false;
+    }
+    Mn::GL::AbstractFramebuffer::blit(source, framebuffer_, area, area, mask,
+                                      Mn::GL::FramebufferBlitFilter::Nearest);
+  }
+
+  //! whether the linear depth drawn in the pass is complete
+  bool readsLinearDepth() const {
+    return hasLinearDepth() && !depthUnprojectionRequired_;
+  }
 
-  void renderExit() {}
+  void renderReEnter() { drawFramebuffer().bind(); }
+
+  void renderExit() {
+    // the reads take the whole framebuffer
+    drawFramebuffer().setViewport({{}, size_});
+    if (samples_ > 1) {
+      resolveMultisample();
+    }
+    // the temporaries of the passes of the frame
+    frameArena().reset();
+  }
+
+  void setDrawViewport(const Mn::Range2Di& viewport) {
+    drawFramebuffer().setViewport(viewport);
+  }
 
   void blitRgbaToDefault() {
     if (rendererFlags_ & Renderer::Flag::NoTextures)
@@ -144,7 +506,10 @@ struct RenderTarget::Impl {
   }
 
   void readFrameDepth(const Mn::MutableImageView2D& view) {
-    if (depthShader_) {
+    if (readsLinearDepth()) {
+      framebuffer_.mapForRead(LinearDepthBuffer)
+          .read(framebuffer_.viewport(), view);
+    } else if (depthShader_) {
       unprojectDepthGPU();
       depthUnprojectionFrameBuffer_.mapForRead(UnprojectedDepthBuffer)
           .read(framebuffer_.viewport(), view);
@@ -162,10 +527,445 @@ struct RenderTarget::Impl {
     framebuffer_.mapForRead(ObjectIdBuffer).read(framebuffer_.viewport(), view);
   }
 
-  Mn::Vector2i framebufferSize() const {
-    return framebuffer_.viewport().size();
+  void readFrameSurfaceNormals(const Mn::MutableImageView2D& view) {
+    if (!hasSurfaceNormals())
+      throw std::runtime_error(
+          "RenderTarget: only the targets of normal sensors draw normals");
+    framebuffer_.mapForRead(NormalBuffer).read(framebuffer_.viewport(), view);
+  }
+
+  void readFrameMotionVectors(const Mn::MutableImageView2D& view) {
+    if (!hasMotionVectors())
+      throw std::runtime_error(
+          "RenderTarget: only the targets of optical flow sensors draw "
+          "motion vectors");
+    framebuffer_.mapForRead(MotionVectorBuffer)
+        .read(framebuffer_.viewport(), view);
+  }
+
+  //! whether the frame can be read as-is, without a conversion pass
+  static bool isUnconverted(ConvertedFrame frame, Mn::Int downsampling) {
+    return downsampling == 1 &&
+           (frame == ConvertedFrame::Rgba || frame == ConvertedFrame::Depth ||
+            frame == ConvertedFrame::ObjectId);
+  }
+
+  void readFrameConverted(ConvertedFrame frame,
+                          Mn::Int downsampling,
+                          const Mn::MutableImageView2D& view) {
+    if (isUnconverted(frame, downsampling)) {
+      if (frame == ConvertedFrame::Rgba)
+        readFrameRgba(view);
+      else if (frame == ConvertedFrame::Depth)
+        readFrameDepth(view);
+      else
+        readFrameObjectId(view);
+      return;
+    }
+
+    convertFrame(frame, downsampling);
+    conversionFramebuffer_.read(conversionFramebuffer_.viewport(), view);
+  }
+
+  //! the R32F texture the depth is converted from, unprojected if needed
+  void copyDepthToConversionSource() {
+    if (readsLinearDepth()) {
+      framebuffer_.mapForRead(LinearDepthBuffer);
+      copyToConversionSource(framebuffer_, Mn::GL::TextureFormat::R32F);
+    } else if (depthShader_) {
+      unprojectDepthGPU();
+      depthUnprojectionFrameBuffer_.mapForRead(UnprojectedDepthBuffer);
+      copyToConversionSource(depthUnprojectionFrameBuffer_,
+                             Mn::GL::TextureFormat::R32F);
+    } else {
+      throw std::runtime_error(
+          "RenderTarget: converting depth on the GPU requires a DepthShader");
+    }
+  }
+
+  //! copy the read attachment of source into conversionSource_, a texture
+  //! the conversion shader can fetch from unlike the renderbuffers
+  void copyToConversionSource(Mn::GL::AbstractFramebuffer& source,
+                              Mn::GL::TextureFormat format) {
+    if (conversionSource_.id() == 0 || conversionSourceFormat_ != format) {
+      conversionSource_ = Mn::GL::Texture2D{};
+      conversionSource_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+          .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+          .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+          .setStorage(1, format, size_);
+      conversionSourceFormat_ = format;
+      conversionSourceFramebuffer_ = Mn::GL::Framebuffer{{{}, size_}};
+      conversionSourceFramebuffer_
+          .attachTexture(ConvertedBuffer, conversionSource_, 0)
+          .mapForDraw({{0, ConvertedBuffer}});
+      CORRADE_INTERNAL_ASSERT(
+          conversionSourceFramebuffer_.checkStatus(
+              Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+    }
+    Mn::GL::AbstractFramebuffer::blit(source, conversionSourceFramebuffer_,
+                                      {{}, size_}, {{}, size_},
+                                      Mn::GL::FramebufferBlit::Color,
+                                      Mn::GL::FramebufferBlitFilter::Nearest);
   }
 
+  //! draw the converted frame into conversionFramebuffer_ and map it for
+  //! reading
+  void convertFrame(ConvertedFrame frame, Mn::Int downsampling) {
+    CORRADE_ASSERT(downsampling >= 1 && size_.x() % downsampling == 0 &&
+                       size_.y() % downsampling == 0,
+                   "RenderTarget: the framebuffer size"
+                       << size_ << "is not a multiple of the downsampling"
+                       << downsampling, );
+    const Mn::Vector2i size = size_ / downsampling;
+    const ConvertedFrameFormat format = convertedFrameFormat(frame);
+    if (converted_.id() == 0 || convertedFrame_ != frame ||
+        convertedSize_ != size) {
+      converted_ = Mn::GL::Renderbuffer{};
+      converted_.setStorage(format.storage, size);
+      conversionFramebuffer_ = Mn::GL::Framebuffer{{{}, size}};
+      conversionFramebuffer_.attachRenderbuffer(ConvertedBuffer, converted_)
+          .mapForDraw({{0, ConvertedBuffer}});
+      CORRADE_INTERNAL_ASSERT(
+          conversionFramebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+      convertedFrame_ = frame;
+      convertedSize_ = size;
+    }
+
+    if (frame == ConvertedFrame::ObjectId) {
+      // integer IDs can't be averaged, take the one nearest to the center
+      Mn::GL::AbstractFramebuffer::blit(
+          framebuffer_.mapForRead(ObjectIdBuffer), conversionFramebuffer_,
+          {{}, size_}, {{}, size}, Mn::GL::FramebufferBlit::Color,
+          Mn::GL::FramebufferBlitFilter::Nearest);
+      conversionFramebuffer_.mapForRead(ConvertedBuffer);
+      return;
+    }
+
+    if (frame == ConvertedFrame::MappedObjectId) {
+      if (!objectIdLookup_)
+        throw std::runtime_error(
+            "RenderTarget: mapping the ObjectID requires a lookup table");
+      framebuffer_.mapForRead(ObjectIdBuffer);
+      copyToConversionSource(framebuffer_, Mn::GL::TextureFormat::R32UI);
+    } else if (frame == ConvertedFrame::Rgba || frame == ConvertedFrame::Rgb ||
+               frame == ConvertedFrame::Gray) {
+      if (rendererFlags_ & Renderer::Flag::NoTextures)
+        throw std::runtime_error(
+            "Simulator was initialized with requiresTextures = false");
+      // a plain RGBA8 copy, the conversion works with the encoded values
+      // the unconverted reads return
+      framebuffer_.mapForRead(RgbaBuffer);
+      copyToConversionSource(framebuffer_, Mn::GL::TextureFormat::RGBA8);
+    } else {
+      copyDepthToConversionSource();
+    }
+
+    std::unique_ptr<FrameConversionShader>& shader =
+        conversionShaders_[conversionShaderIndex(frame)];
+    if (!shader) {
+      FrameConversionShader::Flags flags;
+      if (frame == ConvertedFrame::Gray)
+        flags |= FrameConversionShader::Flag::Grayscale;
+      else if (frame == ConvertedFrame::MillimeterDepth)
+        flags |= FrameConversionShader::Flag::MillimeterDepth;
+      else if (frame == ConvertedFrame::MappedObjectId)
+        flags |= FrameConversionShader::Flag::ObjectIdLookup;
+      shader = std::make_unique<FrameConversionShader>(flags);
+    }
+    if (frame == ConvertedFrame::MappedObjectId) {
+      shader->bindLookup(*objectIdLookup_);
+    }
+    if (conversionMesh_.id() == 0) {
+      conversionMesh_ = Mn::GL::Mesh{};
+      conversionMesh_.setCount(3);
+    }
+
+    conversionFramebuffer_.bind();
+    (*shader)
+        .bindSourceTexture(conversionSource_)
+        .setDownsampling(downsampling)
+        .draw(conversionMesh_);
+    conversionFramebuffer_.mapForRead(ConvertedBuffer);
+  }
+
+#ifndef MAGNUM_TARGET_WEBGL
+  void readVisibleObjects(Mn::UnsignedInt capacity,
+                          std::vector<VisibleObject>& objects) {
+    objects.clear();
+    if (capacity == 0) {
+      return;
+    }
+    framebuffer_.mapForRead(ObjectIdBuffer);
+    copyToConversionSource(framebuffer_, Mn::GL::TextureFormat::R32UI);
+
+    const Mn::Vector2i tableSize =
+        ObjectIdStatisticsShader::tableSize(capacity);
+    if (statisticsFramebuffer_.id() == 0 || statisticsTableSize_ != tableSize) {
+      pixelCounts_ = Mn::GL::Renderbuffer{};
+      pixelCounts_.setStorage(Mn::GL::RenderbufferFormat::R32F, tableSize);
+      pixelBounds_ = Mn::GL::Renderbuffer{};
+      pixelBounds_.setStorage(Mn::GL::RenderbufferFormat::RGBA32F, tableSize);
+      statisticsFramebuffer_ = Mn::GL::Framebuffer{{{}, tableSize}};
+      statisticsFramebuffer_.attachRenderbuffer(PixelCountBuffer, pixelCounts_)
+          .attachRenderbuffer(PixelBoundsBuffer, pixelBounds_)
+          .mapForDraw({{0, PixelCountBuffer}});
+      CORRADE_INTERNAL_ASSERT(
+          statisticsFramebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+      statisticsTableSize_ = tableSize;
+    }
+    if (!statisticsShader_) {
+      statisticsShader_ = std::make_unique<ObjectIdStatisticsShader>();
+    }
+    if (statisticsMesh_.id() == 0) {
+      statisticsMesh_ = Mn::GL::Mesh{Mn::GL::MeshPrimitive::Points};
+    }
+    statisticsMesh_.setCount(size_.product());
+    statisticsShader_->bindObjectIdTexture(conversionSource_)
+        .setCapacity(capacity);
+
+    // the counts are added up, the bounds are maxima, see
+    // ObjectIdStatisticsShader
+    Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::Blending);
+    Mn::GL::Renderer::setBlendFunction(Mn::GL::Renderer::BlendFunction::One,
+                                       Mn::GL::Renderer::BlendFunction::One);
+    for (const bool bounds : {false, true}) {
+      statisticsFramebuffer_
+          .mapForDraw({{0, bounds ? PixelBoundsBuffer : PixelCountBuffer}})
+          .clearColor(0, Mn::Color4{})
+          .bind();
+      Mn::GL::Renderer::setBlendEquation(
+          bounds ? Mn::GL::Renderer::BlendEquation::Max
+                 : Mn::GL::Renderer::BlendEquation::Add);
+      statisticsShader_->setBoundsPass(bounds).draw(statisticsMesh_);
+    }
+    Mn::GL::Renderer::setBlendEquation(Mn::GL::Renderer::BlendEquation::Add);
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::Blending);
+
+    // only the rows of bounds with an ID seen
+    pixelCountData_.resize(tableSize.product());
+    statisticsFramebuffer_.mapForRead(PixelCountBuffer)
+        .read({{}, tableSize},
+              Mn::MutableImageView2D{Mn::PixelFormat::R32F, tableSize,
+                                     pixelCountData_});
+    Mn::Int firstRow = tableSize.y();
+    Mn::Int lastRow = -1;
+    for (Mn::UnsignedInt id = 0; id != capacity; ++id) {
+      if (pixelCountData_[id] > 0.0f) {
+        firstRow = Mn::Math::min(firstRow, Mn::Int(id) / tableSize.x());
+        lastRow = Mn::Int(id) / tableSize.x();
+      }
+    }
+    if (lastRow < firstRow) {
+      return;
+    }
+    const Mn::Vector2i boundsSize{tableSize.x(), lastRow - firstRow + 1};
+    pixelBoundsData_.resize(boundsSize.product());
+    statisticsFramebuffer_.mapForRead(PixelBoundsBuffer)
+        .read({{0, firstRow}, {tableSize.x(), lastRow + 1}},
+              Mn::MutableImageView2D{Mn::PixelFormat::RGBA32F, boundsSize,
+                                     pixelBoundsData_});
+
+    for (Mn::UnsignedInt id = firstRow * tableSize.x();
+         id < Mn::Math::min(capacity, Mn::UnsignedInt((lastRow + 1) *
+                                                      tableSize.x()));
+         ++id) {
+      const Mn::Float count = pixelCountData_[id];
+      if (count <= 0.0f) {
+        continue;
+      }
+      const Mn::Vector4i bounds{
+          pixelBoundsData_[id - firstRow * tableSize.x()]};
+      objects.push_back({id, Mn::UnsignedInt(count),
+                         {size_ - bounds.zw(), bounds.xy()}});
+    }
+  }
+
+  void readFrameRgbaAsync() {
+    if (rendererFlags_ & Renderer::Flag::NoTextures)
+      throw std::runtime_error(
+          "Simulator was initialized with requiresTextures = false");
+
+    framebuffer_.mapForRead(RgbaBuffer);
+    queueAsyncRead(framebuffer_, AsyncReadType::Rgba, Mn::GL::PixelFormat::RGBA,
+                   Mn::GL::PixelType::UnsignedByte);
+  }
+
+  void readFrameDepthAsync() {
+    if (readsLinearDepth()) {
+      framebuffer_.mapForRead(LinearDepthBuffer);
+      queueAsyncRead(framebuffer_, AsyncReadType::UnprojectedDepth,
+                     Mn::GL::PixelFormat::Red, Mn::GL::PixelType::Float);
+    } else if (depthShader_) {
+      unprojectDepthGPU();
+      depthUnprojectionFrameBuffer_.mapForRead(UnprojectedDepthBuffer);
+      queueAsyncRead(depthUnprojectionFrameBuffer_,
+                     AsyncReadType::UnprojectedDepth,
+                     Mn::GL::PixelFormat::Red, Mn::GL::PixelType::Float);
+    } else {
+      queueAsyncRead(framebuffer_, AsyncReadType::Depth,
+                     Mn::GL::PixelFormat::DepthComponent,
+                     Mn::GL::PixelType::Float);
+    }
+  }
+
+  void readFrameObjectIdAsync() {
+    framebuffer_.mapForRead(ObjectIdBuffer);
+    queueAsyncRead(framebuffer_, AsyncReadType::ObjectId,
+                   Mn::GL::PixelFormat::RedInteger,
+                   Mn::GL::PixelType::UnsignedInt);
+  }
+
+  void readFrameSurfaceNormalsAsync() {
+    if (!hasSurfaceNormals())
+      throw std::runtime_error(
+          "RenderTarget: only the targets of normal sensors draw normals");
+    framebuffer_.mapForRead(NormalBuffer);
+    queueAsyncRead(framebuffer_, AsyncReadType::SurfaceNormals,
+                   Mn::GL::PixelFormat::RGB, Mn::GL::PixelType::Float);
+  }
+
+  void readFrameMotionVectorsAsync() {
+    if (!hasMotionVectors())
+      throw std::runtime_error(
+          "RenderTarget: only the targets of optical flow sensors draw "
+          "motion vectors");
+    framebuffer_.mapForRead(MotionVectorBuffer);
+    queueAsyncRead(framebuffer_, AsyncReadType::MotionVectors,
+                   Mn::GL::PixelFormat::RG, Mn::GL::PixelType::Float);
+  }
+
+  void readFrameConvertedAsync(ConvertedFrame frame, Mn::Int downsampling) {
+    if (isUnconverted(frame, downsampling)) {
+      if (frame == ConvertedFrame::Rgba)
+        readFrameRgbaAsync();
+      else if (frame == ConvertedFrame::Depth)
+        readFrameDepthAsync();
+      else
+        readFrameObjectIdAsync();
+      return;
+    }
+
+    convertFrame(frame, downsampling);
+    const ConvertedFrameFormat format = convertedFrameFormat(frame);
+    queueAsyncRead(conversionFramebuffer_, AsyncReadType::Converted,
+                   format.format, format.type);
+  }
+
+  int numPendingAsyncReads() const { return numPendingAsyncReads_; }
+
+  bool isAsyncReadReady() {
+    CORRADE_ASSERT(numPendingAsyncReads_ > 0,
+                   "RenderTarget::isAsyncReadReady(): no read pending", false);
+    const GLenum status = glClientWaitSync(oldestAsyncRead().fence, 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+  }
+
+  void retrieveAsyncRead(const Mn::MutableImageView2D& view) {
+    CORRADE_ASSERT(numPendingAsyncReads_ > 0,
+                   "RenderTarget::retrieveAsyncRead(): no read pending", );
+    AsyncRead& read = oldestAsyncRead();
+
+    // flush on the first wait so that the fence is guaranteed to signal
+    GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (glClientWaitSync(read.fence, waitFlags, 1000000000) ==
+           GL_TIMEOUT_EXPIRED) {
+      waitFlags = 0;
+    }
+    glDeleteSync(read.fence);
+    read.fence = nullptr;
+    --numPendingAsyncReads_;
+
+    const std::size_t dataSize = read.image.dataSize();
+    CORRADE_ASSERT(view.data().size() >= dataSize,
+                   "RenderTarget::retrieveAsyncRead(): expected a view of at "
+                   "least"
+                       << dataSize << "bytes but got" << view.data().size(), );
+    Cr::Containers::ArrayView<char> data = read.image.buffer().map(
+        0, dataSize, Mn::GL::Buffer::MapFlag::Read);
+    CORRADE_INTERNAL_ASSERT(data);
+    Cr::Utility::copy(data, view.data().prefix(dataSize));
+    read.image.buffer().unmap();
+
+    if (read.type == AsyncReadType::Depth) {
+      unprojectDepth(depthUnprojection_,
+                     Cr::Containers::arrayCast<Mn::Float>(view.data()));
+    }
+  }
+
+  void discardAsyncReads() {
+    for (AsyncRead& read : asyncReads_) {
+      if (read.fence != nullptr) {
+        glDeleteSync(read.fence);
+        read.fence = nullptr;
+      }
+    }
+    numPendingAsyncReads_ = 0;
+  }
+#endif
+
+  Mn::Vector2i framebufferSize() const { return size_; }
+
+  Mn::Int samples() const { return samples_; }
+
+  std::size_t getGpuBytes() const {
+    const std::size_t pixels = size_.product();
+    // 32-bit color, ObjectID and depth
+    std::size_t bytes = 3 * 4 * pixels;
+    if (samples_ > 1) {
+      bytes += samples_ * 3 * 4 * pixels;
+    }
+    if (linearDepth_.id() != 0) {
+      bytes += 4 * pixels;
+    }
+    // RGBA16F
+    if (normals_.id() != 0) {
+      bytes += 8 * pixels;
+    }
+    // RG32F
+    if (motionVectors_.id() != 0) {
+      bytes += 8 * pixels;
+    }
+    if (unprojectedDepth_.id() != 0) {
+      bytes += 4 * pixels;
+    }
+    // the depth and at most 64 bits per color attachment
+    if (layerFramebuffer_.id() != 0) {
+      bytes += 4 * pixels;
+      for (std::size_t i = 0; i != drawnAttachments().size(); ++i) {
+        bytes += (hasSurfaceNormals() ? 8 : 4) * pixels;
+      }
+    }
+    // the conversion sources are all 32-bit formats
+    if (conversionSource_.id() != 0) {
+      bytes += 4 * pixels;
+    }
+    if (converted_.id() != 0) {
+      const Mn::PixelFormat format =
+          convertedFrameFormat(convertedFrame_).pixelFormat;
+      bytes += Mn::pixelSize(format) * std::size_t(convertedSize_.product());
+    }
+    // an R32F and an RGBA32F table
+    if (pixelCounts_.id() != 0) {
+      bytes += 5 * 4 * std::size_t(statisticsTableSize_.product());
+    }
+#ifndef MAGNUM_TARGET_WEBGL
+    // 0 for the slots not used yet
+    for (const AsyncRead& read : asyncReads_) {
+      bytes += read.image.dataSize();
+    }
+#endif
+    return bytes;
+  }
+
+  OcclusionCulling& occlusionCulling() { return occlusionCulling_; }
+
+  MotionVectorHistory& motionVectorHistory() { return motionVectorHistory_; }
+
+  void setObjectIdLookup(ObjectIdLookup* lookup) { objectIdLookup_ = lookup; }
+
 #ifdef ESP_BUILD_WITH_CUDA
   void readFrameRgbaGPU(uint8_t* devPtr) {
     // TODO: Consider implementing the GPU read functions with EGLImage
@@ -194,25 +994,38 @@ struct RenderTarget::Impl {
     checkCudaErrors(cudaGraphicsUnmapResources(1, &colorBufferCugl_, 0));
   }
 
-  void readFrameDepthGPU(float* devPtr) {
-    unprojectDepthGPU();
+  //! the registered resource of the linear depth, unprojected if needed
+  cudaGraphicsResource_t depthResource() {
+    if (readsLinearDepth()) {
+      if (linearDepthCugl_ == nullptr)
+        checkCudaErrors(cudaGraphicsGLRegisterImage(
+            &linearDepthCugl_, linearDepth_.id(), GL_RENDERBUFFER,
+            cudaGraphicsRegisterFlagsReadOnly));
+      return linearDepthCugl_;
+    }
 
+    unprojectDepthGPU();
     if (depthBufferCugl_ == nullptr)
       checkCudaErrors(cudaGraphicsGLRegisterImage(
           &depthBufferCugl_, unprojectedDepth_.id(), GL_RENDERBUFFER,
           cudaGraphicsRegisterFlagsReadOnly));
+    return depthBufferCugl_;
+  }
 
-    checkCudaErrors(cudaGraphicsMapResources(1, &depthBufferCugl_, 0));
+  void readFrameDepthGPU(float* devPtr) {
+    cudaGraphicsResource_t resource = depthResource();
+
+    checkCudaErrors(cudaGraphicsMapResources(1, &resource, 0));
 
     cudaArray* array = nullptr;
     checkCudaErrors(
-        cudaGraphicsSubResourceGetMappedArray(&array, depthBufferCugl_, 0, 0));
+        cudaGraphicsSubResourceGetMappedArray(&array, resource, 0, 0));
     const int widthInBytes = framebufferSize().x() * 1 * sizeof(float);
     checkCudaErrors(cudaMemcpy2DFromArray(devPtr, widthInBytes, array, 0, 0,
                                           widthInBytes, framebufferSize().y(),
                                           cudaMemcpyDeviceToDevice));
 
-    checkCudaErrors(cudaGraphicsUnmapResources(1, &depthBufferCugl_, 0));
+    checkCudaErrors(cudaGraphicsUnmapResources(1, &resource, 0));
   }
 
   void readFrameObjectIdGPU(int32_t* devPtr) {
@@ -233,24 +1046,112 @@ struct RenderTarget::Impl {
 
     checkCudaErrors(cudaGraphicsUnmapResources(1, &objecIdBufferCugl_, 0));
   }
+
+  //! prepare the frame of the given type and return its registered resource
+  cudaGraphicsResource_t cudaResource(FrameType type) {
+    switch (type) {
+      case FrameType::Rgba:
+        if (rendererFlags_ & Renderer::Flag::NoTextures)
+          throw std::runtime_error(
+              "Simulator was initialized with requiresTextures = false");
+        if (colorBufferCugl_ == nullptr)
+          checkCudaErrors(cudaGraphicsGLRegisterImage(
+              &colorBufferCugl_, colorBuffer_.id(), GL_RENDERBUFFER,
+              cudaGraphicsRegisterFlagsReadOnly));
+        return colorBufferCugl_;
+      case FrameType::Depth:
+        return depthResource();
+      case FrameType::ObjectId:
+        if (objecIdBufferCugl_ == nullptr)
+          checkCudaErrors(cudaGraphicsGLRegisterImage(
+              &objecIdBufferCugl_, objectIdBuffer_.id(), GL_RENDERBUFFER,
+              cudaGraphicsRegisterFlagsReadOnly));
+        return objecIdBufferCugl_;
+    }
+    CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+  }
 #endif
 
   ~Impl() {
+#ifndef MAGNUM_TARGET_WEBGL
+    discardAsyncReads();
+#endif
 #ifdef ESP_BUILD_WITH_CUDA
     if (colorBufferCugl_ != nullptr)
       checkCudaErrors(cudaGraphicsUnregisterResource(colorBufferCugl_));
     if (depthBufferCugl_ != nullptr)
       checkCudaErrors(cudaGraphicsUnregisterResource(depthBufferCugl_));
+    if (linearDepthCugl_ != nullptr)
+      checkCudaErrors(cudaGraphicsUnregisterResource(linearDepthCugl_));
     if (objecIdBufferCugl_ != nullptr)
       checkCudaErrors(cudaGraphicsUnregisterResource(objecIdBufferCugl_));
 #endif
   }
 
  private:
+#ifndef MAGNUM_TARGET_WEBGL
+  AsyncRead& oldestAsyncRead() {
+    return asyncReads_[(nextAsyncRead_ + AsyncReadRingSize -
+                        numPendingAsyncReads_) %
+                       AsyncReadRingSize];
+  }
+
+  void queueAsyncRead(Mn::GL::AbstractFramebuffer& source,
+                      AsyncReadType type,
+                      Mn::GL::PixelFormat format,
+                      Mn::GL::PixelType pixelType) {
+    CORRADE_ASSERT(numPendingAsyncReads_ < AsyncReadRingSize,
+                   "RenderTarget: all" << AsyncReadRingSize
+                                       << "asynchronous reads are pending, "
+                                          "retrieve one before queuing another",
+                   );
+    AsyncRead& read = asyncReads_[nextAsyncRead_];
+    // keep the buffer of the slot around unless the pixel format changes
+    if (!read.image.buffer().id() || read.type != type ||
+        read.image.format() != format || read.image.type() != pixelType) {
+      read.image = Mn::GL::BufferImage2D{format, pixelType};
+    }
+    read.type = type;
+
+    // the whole framebuffer, or the whole converted frame
+    source.read(source.viewport(), read.image,
+                Mn::GL::BufferUsage::StreamRead);
+    read.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    nextAsyncRead_ = (nextAsyncRead_ + 1) % AsyncReadRingSize;
+    ++numPendingAsyncReads_;
+  }
+
+  AsyncRead asyncReads_[AsyncReadRingSize];
+  int nextAsyncRead_ = 0;
+  int numPendingAsyncReads_ = 0;
+#endif
+
+  const Mn::Vector2i size_;
+  const Mn::Int samples_;
   Mn::GL::Renderbuffer colorBuffer_;
   Mn::GL::Renderbuffer objectIdBuffer_;
   Mn::GL::Texture2D depthRenderTexture_;
+  //! the linear depth drawn in the pass, if fused, see hasLinearDepth()
+  Mn::GL::Renderbuffer linearDepth_;
+  //! the normals of a normal sensor, see hasSurfaceNormals()
+  Mn::GL::Renderbuffer normals_;
+  //! the motion vectors of an optical flow sensor, see hasMotionVectors()
+  Mn::GL::Renderbuffer motionVectors_;
   Mn::GL::Framebuffer framebuffer_;
+  bool depthUnprojectionRequired_ = false;
+  //! what the draws go to with more than one sample, see drawFramebuffer()
+  Mn::GL::Renderbuffer multisampleColor_;
+  Mn::GL::Renderbuffer multisampleObjectId_;
+  Mn::GL::Renderbuffer multisampleDepth_;
+  Mn::GL::Framebuffer multisampleFramebuffer_;
+  //! the frame kept by cacheLayer(), with a copy of each of
+  //! drawnAttachments() and of the depth
+  Mn::GL::Renderbuffer layerBuffers_[2]{Mn::GL::Renderbuffer{Mn::NoCreate},
+                                        Mn::GL::Renderbuffer{Mn::NoCreate}};
+  Mn::GL::Renderbuffer layerDepth_{Mn::NoCreate};
+  Mn::GL::Framebuffer layerFramebuffer_{Mn::NoCreate};
+  bool layerDepthUnprojectionRequired_ = false;
 
   Mn::Vector2 depthUnprojection_;
   DepthShader* depthShader_;
@@ -258,23 +1159,58 @@ struct RenderTarget::Impl {
   Mn::GL::Mesh depthUnprojectionMesh_;
   Mn::GL::Framebuffer depthUnprojectionFrameBuffer_;
 
+  //! a texture copy of the frame to convert, see copyToConversionSource()
+  Mn::GL::Texture2D conversionSource_;
+  Mn::GL::TextureFormat conversionSourceFormat_{};
+  Mn::GL::Framebuffer conversionSourceFramebuffer_;
+  //! the converted frame, see convertFrame()
+  Mn::GL::Renderbuffer converted_;
+  ConvertedFrame convertedFrame_ = ConvertedFrame::Rgba;
+  Mn::Vector2i convertedSize_;
+  Mn::GL::Framebuffer conversionFramebuffer_;
+  Mn::GL::Mesh conversionMesh_;
+  //! the plain, grayscale, millimeter depth and ObjectID lookup
+  //! conversion, compiled on use
+  std::unique_ptr<FrameConversionShader> conversionShaders_[4];
+  ObjectIdLookup* objectIdLookup_ = nullptr;
+
+  //! the tables of readVisibleObjects() and their CPU copies
+  Mn::GL::Renderbuffer pixelCounts_;
+  Mn::GL::Renderbuffer pixelBounds_;
+  Mn::Vector2i statisticsTableSize_;
+  Mn::GL::Framebuffer statisticsFramebuffer_;
+  Mn::GL::Mesh statisticsMesh_;
+  std::unique_ptr<ObjectIdStatisticsShader> statisticsShader_;
+  std::vector<Mn::Float> pixelCountData_;
+  std::vector<Mn::Vector4> pixelBoundsData_;
+
   const Renderer::Flags rendererFlags_;
 
+  OcclusionCulling occlusionCulling_;
+  MotionVectorHistory motionVectorHistory_;
+
 #ifdef ESP_BUILD_WITH_CUDA
   cudaGraphicsResource_t colorBufferCugl_ = nullptr;
   cudaGraphicsResource_t objecIdBufferCugl_ = nullptr;
   cudaGraphicsResource_t depthBufferCugl_ = nullptr;
+  cudaGraphicsResource_t linearDepthCugl_ = nullptr;
 #endif
 };  // namespace gfx
 
+#ifndef MAGNUM_TARGET_WEBGL
+constexpr int RenderTarget::AsyncReadRingSize;
+#endif
+
 RenderTarget::RenderTarget(const Mn::Vector2i& size,
                            const Mn::Vector2& depthUnprojection,
                            DepthShader* depthShader,
-                           Renderer::Flags flags)
+                           Renderer::Flags flags,
+                           Mn::Int samples)
     : pimpl_(spimpl::make_unique_impl<Impl>(size,
                                             depthUnprojection,
                                             depthShader,
-                                            flags)) {}
+                                            flags,
+                                            samples)) {}
 
 void RenderTarget::renderEnter() {
   pimpl_->renderEnter();
@@ -288,18 +1224,102 @@ void RenderTarget::renderExit() {
   pimpl_->renderExit();
 }
 
+void RenderTarget::setDrawViewport(const Mn::Range2Di& viewport) {
+  pimpl_->setDrawViewport(viewport);
+}
+
 void RenderTarget::readFrameRgba(const Mn::MutableImageView2D& view) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
   pimpl_->readFrameRgba(view);
 }
 
 void RenderTarget::readFrameDepth(const Mn::MutableImageView2D& view) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
   pimpl_->readFrameDepth(view);
 }
 
 void RenderTarget::readFrameObjectId(const Mn::MutableImageView2D& view) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
   pimpl_->readFrameObjectId(view);
 }
 
+void RenderTarget::readFrameSurfaceNormals(const Mn::MutableImageView2D& view) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameSurfaceNormals(view);
+}
+
+void RenderTarget::readFrameMotionVectors(const Mn::MutableImageView2D& view) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameMotionVectors(view);
+}
+
+Mn::PixelFormat RenderTarget::convertedPixelFormat(ConvertedFrame frame) {
+  return convertedFrameFormat(frame).pixelFormat;
+}
+
+void RenderTarget::readFrameConverted(ConvertedFrame frame,
+                                      Mn::Int downsampling,
+                                      const Mn::MutableImageView2D& view) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameConverted(frame, downsampling, view);
+}
+
+#ifndef MAGNUM_TARGET_WEBGL
+void RenderTarget::readVisibleObjects(Mn::UnsignedInt capacity,
+                                      std::vector<VisibleObject>& objects) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readVisibleObjects(capacity, objects);
+}
+
+void RenderTarget::readFrameRgbaAsync() {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameRgbaAsync();
+}
+
+void RenderTarget::readFrameDepthAsync() {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameDepthAsync();
+}
+
+void RenderTarget::readFrameObjectIdAsync() {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameObjectIdAsync();
+}
+
+void RenderTarget::readFrameSurfaceNormalsAsync() {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameSurfaceNormalsAsync();
+}
+
+void RenderTarget::readFrameMotionVectorsAsync() {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameMotionVectorsAsync();
+}
+
+void RenderTarget::readFrameConvertedAsync(ConvertedFrame frame,
+                                           Mn::Int downsampling) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->readFrameConvertedAsync(frame, downsampling);
+}
+
+int RenderTarget::numPendingAsyncReads() const {
+  return pimpl_->numPendingAsyncReads();
+}
+
+bool RenderTarget::isAsyncReadReady() {
+  return pimpl_->isAsyncReadReady();
+}
+
+void RenderTarget::retrieveAsyncRead(const Mn::MutableImageView2D& view) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+  pimpl_->retrieveAsyncRead(view);
+}
+
+void RenderTarget::discardAsyncReads() {
+  pimpl_->discardAsyncReads();
+}
+#endif
+
 void RenderTarget::blitRgbaToDefault() {
   pimpl_->blitRgbaToDefault();
 }
@@ -308,18 +1328,130 @@ Mn::Vector2i RenderTarget::framebufferSize() const {
   return pimpl_->framebufferSize();
 }
 
+Mn::Int RenderTarget::samples() const {
+  return pimpl_->samples();
+}
+
+std::size_t RenderTarget::getGpuBytes() const {
+  return pimpl_->getGpuBytes();
+}
+
+OcclusionCulling& RenderTarget::occlusionCulling() {
+  return pimpl_->occlusionCulling();
+}
+
+MotionVectorHistory& RenderTarget::motionVectorHistory() {
+  return pimpl_->motionVectorHistory();
+}
+
+void RenderTarget::setObjectIdLookup(ObjectIdLookup* lookup) {
+  pimpl_->setObjectIdLookup(lookup);
+}
+
+bool RenderTarget::hasLinearDepth() const {
+  return pimpl_->hasLinearDepth();
+}
+
+bool RenderTarget::hasSurfaceNormals() const {
+  return pimpl_->hasSurfaceNormals();
+}
+
+bool RenderTarget::hasMotionVectors() const {
+  return pimpl_->hasMotionVectors();
+}
+
+bool RenderTarget::isDepthOnly() const {
+  return pimpl_->isDepthOnly();
+}
+
+void RenderTarget::requireDepthUnprojection() {
+  pimpl_->requireDepthUnprojection();
+}
+
+bool RenderTarget::supportsLayerCache() const {
+  return pimpl_->supportsLayerCache();
+}
+
+bool RenderTarget::hasCachedLayer() const {
+  return pimpl_->hasCachedLayer();
+}
+
+void RenderTarget::cacheLayer() {
+  pimpl_->cacheLayer();
+}
+
+void RenderTarget::renderEnterCachedLayer() {
+  pimpl_->renderEnterCachedLayer();
+}
+
+void RenderTarget::discardCachedLayer() {
+  pimpl_->discardCachedLayer();
+}
+
+void RenderTarget::copyDepthFrom(Mn::GL::Framebuffer& source) {
+  pimpl_->copyDepthFrom(source);
+}
+
 #ifdef ESP_BUILD_WITH_CUDA
 void RenderTarget::readFrameRgbaGPU(uint8_t* devPtr) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
   pimpl_->readFrameRgbaGPU(devPtr);
 }
 
 void RenderTarget::readFrameDepthGPU(float* devPtr) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
   pimpl_->readFrameDepthGPU(devPtr);
 }
 
 void RenderTarget::readFrameObjectIdGPU(int32_t* devPtr) {
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
   pimpl_->readFrameObjectIdGPU(devPtr);
 }
+
+void RenderTarget::readFramesGPU(const std::vector<RenderTarget*>& targets,
+                                 FrameType type,
+                                 void* devPtr,
+                                 void* cudaStream) {
+  if (targets.empty())
+    return;
+  ScopedGpuTimer timer{core::ProfilingStage::Readback};
+
+  const Mn::Vector2i size = targets[0]->framebufferSize();
+  std::vector<cudaGraphicsResource_t> resources;
+  resources.reserve(targets.size());
+  for (RenderTarget* target : targets) {
+    if (target->framebufferSize() != size)
+      throw std::runtime_error(
+          "RenderTarget::readFramesGPU: all render targets must have the same "
+          "size");
+    resources.push_back(target->pimpl_->cudaResource(type));
+  }
+
+  std::size_t bytesPerPixel = 4 * sizeof(uint8_t);
+  if (type == FrameType::Depth)
+    bytesPerPixel = sizeof(float);
+  else if (type == FrameType::ObjectId)
+    bytesPerPixel = sizeof(int32_t);
+  const std::size_t widthInBytes = size.x() * bytesPerPixel;
+  const std::size_t frameInBytes = widthInBytes * size.y();
+
+  auto stream = static_cast<cudaStream_t>(cudaStream);
+  checkCudaErrors(
+      cudaGraphicsMapResources(resources.size(), resources.data(), stream));
+
+  auto* dst = static_cast<uint8_t*>(devPtr);
+  for (std::size_t i = 0; i < resources.size(); ++i) {
+    cudaArray* array = nullptr;
+    checkCudaErrors(
+        cudaGraphicsSubResourceGetMappedArray(&array, resources[i], 0, 0));
+    checkCudaErrors(cudaMemcpy2DFromArrayAsync(
+        dst + i * frameInBytes, widthInBytes, array, 0, 0, widthInBytes,
+        size.y(), cudaMemcpyDeviceToDevice, stream));
+  }
+
+  checkCudaErrors(
+      cudaGraphicsUnmapResources(resources.size(), resources.data(), stream));
+}
 #endif
 
 }  // namespace gfx
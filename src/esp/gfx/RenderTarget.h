@@ -5,11 +5,17 @@
 #ifndef ESP_GFX_RENDERTARGET_H_
 #define ESP_GFX_RENDERTARGET_H_
 
+#include <Magnum/GL/GL.h>
 #include <Magnum/Magnum.h>
+#include <Magnum/Math/Range.h>
 
 #include "esp/core/esp.h"
 
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/FrameConversion.h"
+#include "esp/gfx/MotionVectors.h"
+#include "esp/gfx/ObjectIdStatistics.h"
+#include "esp/gfx/OcclusionCulling.h"
 #include "esp/gfx/Renderer.h"
 
 namespace esp {
@@ -38,11 +44,17 @@ class RenderTarget {
    *                           whether or not @ref readFrameRgba,
    *                           @ref blitRgbaToDefault, and @readFrameRgbaGPU
    *                           are valid calls.
+   * @param samples            The number of samples per pixel to draw with.
+   *                           With more than one, the draws go to multisample
+   *                           buffers that @ref renderExit() resolves on the
+   *                           GPU for the reads.  Clamped to what the GPU
+   *                           supports, see @ref samples()
    */
   RenderTarget(const Magnum::Vector2i& size,
                const Magnum::Vector2& depthUnprojection,
                DepthShader* depthShader,
-               Renderer::Flags flags);
+               Renderer::Flags flags,
+               Magnum::Int samples = 1);
 
   /**
    * @brief Constructor
@@ -73,14 +85,175 @@ class RenderTarget {
 
   /**
    * @brief Called after any draw calls that target this RenderTarget
+   *
+   * Restores the viewport changed by @ref setDrawViewport() and resolves
+   * the multisample buffers if there are any, see @ref samples().
    */
   void renderExit();
 
+  /**
+   * @brief Restrict the following draw calls to @p viewport of the
+   * framebuffer, e.g. to draw the faces of a cube map side by side, until
+   * @ref renderExit(). The reads always take the whole framebuffer.
+   */
+  void setDrawViewport(const Magnum::Range2Di& viewport);
+
   /**
    * @brief The size of the framebuffer in WxH
    */
   Magnum::Vector2i framebufferSize() const;
 
+  /**
+   * @brief The number of samples per pixel the draws take
+   *
+   * The count passed to the constructor, clamped to the multisample
+   * renderbuffers the GPU supports, and always @cpp 1 @ce on WebGL, which
+   * has no integer ones for the ObjectID, and for surface normals and
+   * motion vectors, see @ref hasSurfaceNormals() and @ref
+   * hasMotionVectors().  The color is resolved by
+   * averaging the samples, the ObjectID and the depth by taking one of them,
+   * as depth averaged across an edge would be neither surface.  A
+   * multisample render target thus never has linear depth, see
+   * @ref hasLinearDepth().
+   */
+  Magnum::Int samples() const;
+
+  /**
+   * @brief Estimated GPU memory of the render target, in bytes
+   *
+   * The color, ObjectID and depth buffers and their multisample copies, and
+   * the linear depth, normals, motion vectors, depth unprojection, frame
+   * conversion, cached layer and asynchronous readback buffers once they are
+   * created.
+   */
+  std::size_t getGpuBytes() const;
+
+  /**
+   * @brief The occlusion of the drawables seen by the draws into this
+   * target, kept from one frame to the next for @ref
+   * RenderCamera::Flag::OcclusionCulling
+   */
+  OcclusionCulling& occlusionCulling();
+
+  /**
+   * @brief Where the drawables were in the previous frame drawn into this
+   * target, for @ref RenderCamera::Flag::MotionVectors
+   */
+  MotionVectorHistory& motionVectorHistory();
+
+  /**
+   * @brief Set the table the ObjectID is looked up in for @ref
+   * ConvertedFrame::MappedObjectId
+   *
+   * The table is not owned by the target and has to outlive the reads,
+   * @cpp nullptr @ce by default, which such a read throws on.
+   */
+  void setObjectIdLookup(ObjectIdLookup* lookup);
+
+  /**
+   * @brief Whether the drawables write linear depth straight into an extra
+   * color attachment of the framebuffer, see @ref
+   * RenderCamera::Flag::LinearDepth
+   *
+   * True if the renderer flags passed to the constructor have @ref
+   * Renderer::Flag::FusedDepthUnprojection and it draws with a single
+   * sample, see @ref samples(). The depth reads then take the
+   * linear depth instead of unprojecting the depth buffer in a second pass,
+   * unless @ref requireDepthUnprojection() was called since @ref
+   * renderEnter(). Color and object ID are not drawn.
+   */
+  bool hasLinearDepth() const;
+
+  /**
+   * @brief Whether the drawables write their surface normals into an extra
+   * color attachment of the framebuffer, see @ref
+   * RenderCamera::Flag::SurfaceNormals
+   *
+   * True if the renderer flags passed to the constructor have @ref
+   * Renderer::Flag::SurfaceNormals. The target then draws with a single
+   * sample, see @ref samples(), and color and object ID are not drawn.
+   */
+  bool hasSurfaceNormals() const;
+
+  /**
+   * @brief Whether the drawables write their motion vectors into an extra
+   * color attachment of the framebuffer, see @ref
+   * RenderCamera::Flag::MotionVectors
+   *
+   * True if the renderer flags passed to the constructor have @ref
+   * Renderer::Flag::MotionVectors. The target then draws with a single
+   * sample, see @ref samples(), and color and object ID are not drawn.
+   */
+  bool hasMotionVectors() const;
+
+  /**
+   * @brief Whether only the depth of the scene is drawn into the target,
+   * i.e. its color and object ID are not
+   *
+   * True if the renderer flags passed to the constructor have @ref
+   * Renderer::Flag::DepthOnly, whose draws write the depth buffer only, or
+   * if the target has linear depth, see @ref hasLinearDepth().
+   */
+  bool isDepthOnly() const;
+
+  /**
+   * @brief Record that some drawables of the frame did not write linear
+   * depth, so the depth reads unproject the depth buffer after all
+   */
+  void requireDepthUnprojection();
+
+  /**
+   * @brief Whether the target can keep a drawn layer, see @ref cacheLayer()
+   *
+   * True if it draws with a single sample, see @ref samples(), and draws no
+   * motion vectors, see @ref hasMotionVectors().
+   */
+  bool supportsLayerCache() const;
+
+  /**
+   * @brief Whether a layer kept by @ref cacheLayer() is there to be drawn
+   * over, see @ref renderEnterCachedLayer()
+   */
+  bool hasCachedLayer() const;
+
+  /**
+   * @brief Keep a copy of what was drawn since @ref renderEnter(), e.g. the
+   * static stage, for later frames to draw over with @ref
+   * renderEnterCachedLayer()
+   *
+   * Copies the attachments the draws write and the depth, replacing the
+   * layer kept before. The draws can go on after.  Throws if @ref
+   * supportsLayerCache() is false.
+   */
+  void cacheLayer();
+
+  /**
+   * @brief Same as @ref renderEnter(), but starting from the layer kept by
+   * @ref cacheLayer() instead of a cleared frame
+   *
+   * The draws which follow are depth-tested against the layer, so that
+   * e.g. only the objects which move need to be drawn over a cached stage.
+   * Throws if there is no layer, see @ref hasCachedLayer().
+   */
+  void renderEnterCachedLayer();
+
+  /**
+   * @brief Destroy the layer kept by @ref cacheLayer(), if any
+   */
+  void discardCachedLayer();
+
+  /**
+   * @brief Take the depth, and the linear depth if the target has it, of a
+   * frame drawn into another framebuffer of the same size, e.g. of a view of
+   * a @ref MultiviewFramebuffer, instead of drawing it between @ref
+   * renderEnter() and @ref renderExit()
+   *
+   * @p source is expected to have the linear depth mapped for reading and a
+   * @ref Magnum::GL::TextureFormat::DepthComponent32F depth.  Throws if the
+   * target is not depth-only, see @ref isDepthOnly().
+   */
+  void copyDepthFrom(Magnum::GL::Framebuffer& source);
+
   /**
    * @brief Retrieve the RGBA rendering results.
    *
@@ -110,6 +283,199 @@ class RenderTarget {
    */
   void readFrameObjectId(const Magnum::MutableImageView2D& view);
 
+  /**
+   * @brief Retrieve the surface normals, see @ref hasSurfaceNormals()
+   *
+   * @param[in, out] view Preallocated memory that will be populated with the
+   * result, generally in @ref Magnum::PixelFormat::RGB32F.  The normals are
+   * unit vectors in camera space, with Y up and Z towards the camera, and
+   * zero where nothing or a mesh without normals was drawn.  Throws if the
+   * target has no normals.
+   */
+  void readFrameSurfaceNormals(const Magnum::MutableImageView2D& view);
+
+  /**
+   * @brief Retrieve the motion vectors, see @ref hasMotionVectors()
+   *
+   * @param[in, out] view Preallocated memory that will be populated with the
+   * result, generally in @ref Magnum::PixelFormat::RG32F.  Each pixel has
+   * the motion in pixels of the surface it shows, from where it was in the
+   * previous frame to where it is now, with X to the right and Y up, as the
+   * rows of the framebuffer.  Zero where nothing was drawn and in the first
+   * frame.  Throws if the target has no motion vectors.
+   */
+  void readFrameMotionVectors(const Magnum::MutableImageView2D& view);
+
+  /**
+   * @brief Kinds and formats of rendering results that can be converted on
+   * the GPU by @ref readFrameConverted()
+   */
+  enum class ConvertedFrame : Magnum::UnsignedByte {
+    /** RGBA, @ref Magnum::PixelFormat::RGBA8Unorm */
+    Rgba,
+    /** RGB without alpha, @ref Magnum::PixelFormat::RGB8Unorm */
+    Rgb,
+    /**
+     * Luma of the RGB, @ref Magnum::PixelFormat::R8Unorm.  See
+     * @ref FrameConversionShader::Flag::Grayscale
+     */
+    Gray,
+    /** Unprojected depth, @ref Magnum::PixelFormat::R32F */
+    Depth,
+    /** Unprojected depth in half floats, @ref Magnum::PixelFormat::R16F */
+    HalfDepth,
+    /**
+     * Unprojected depth in millimeters, @ref Magnum::PixelFormat::R16UI.  See
+     * @ref FrameConversionShader::Flag::MillimeterDepth
+     */
+    MillimeterDepth,
+    /** ObjectID, @ref Magnum::PixelFormat::R32UI */
+    ObjectId,
+    /**
+     * ObjectID looked up in the table of @ref setObjectIdLookup(), e.g. the
+     * semantic category of each object, @ref Magnum::PixelFormat::R32UI.
+     * See @ref FrameConversionShader::Flag::ObjectIdLookup
+     */
+    MappedObjectId
+  };
+
+  /**
+   * @brief The pixel format a converted frame is read as
+   */
+  static Magnum::PixelFormat convertedPixelFormat(ConvertedFrame frame);
+
+  /**
+   * @brief Convert the rendering results on the GPU and read the smaller
+   * result.
+   *
+   * The frame is downsampled by @p downsampling in both directions, the
+   * color and depth as the average of each square of pixels, the ObjectID as
+   * the pixel nearest to its center since IDs can't be averaged, then
+   * converted to the format of @p frame, so that only the converted pixels
+   * are transferred from the GPU.  Requires a DepthShader for the depth
+   * frames, unless the depth is linear already, see @ref hasLinearDepth().
+   *
+   * @param frame             The kind and format of the result
+   * @param downsampling      The factor to downsample by, which both
+   *                          dimensions of the framebuffer have to be a
+   *                          multiple of
+   * @param[in, out] view     Preallocated memory of the size of the
+   *                          framebuffer divided by @p downsampling, in the
+   *                          @ref convertedPixelFormat() of @p frame, that will
+   *                          be populated with the result
+   */
+  void readFrameConverted(ConvertedFrame frame,
+                          Magnum::Int downsampling,
+                          const Magnum::MutableImageView2D& view);
+
+#ifndef MAGNUM_TARGET_WEBGL
+  /**
+   * @brief Reduce the ObjectID on the GPU to the objects seen in the frame
+   * and read only those.
+   *
+   * Counts the pixels and takes the bounding box of each ID below
+   * @p capacity, see @ref ObjectIdStatisticsShader, then reads the table of
+   * the counts and the rows of bounding boxes with an ID seen, a few KB
+   * instead of the whole ObjectID frame.  IDs at or past @p capacity are
+   * left out.  Not available on WebGL, which can't blend float attachments
+   * without an extension.
+   *
+   * @param capacity      The number of IDs to count, from 0
+   * @param[out] objects  The IDs seen, in ascending order
+   */
+  void readVisibleObjects(Magnum::UnsignedInt capacity,
+                          std::vector<VisibleObject>& objects);
+
+  /**
+   * @brief The number of asynchronous reads that can be in flight at once
+   */
+  static constexpr int AsyncReadRingSize = 2;
+
+  /**
+   * @brief Queue an asynchronous read of the RGBA rendering results.
+   *
+   * The read goes into the next pixel buffer object of a ring of @ref
+   * AsyncReadRingSize buffers and returns without waiting for the GPU to
+   * finish rendering. The result is retrieved later, in the order the reads
+   * were queued, with @ref retrieveAsyncRead() as
+   * @ref Magnum::PixelFormat::RGBA8Unorm. At most @ref AsyncReadRingSize
+   * reads may be pending at once.
+   */
+  void readFrameRgbaAsync();
+
+  /**
+   * @brief Queue an asynchronous read of the depth rendering results.  See
+   * @ref readFrameRgbaAsync()
+   *
+   * The result is retrieved as unprojected @ref Magnum::PixelFormat::R32F
+   * depth. Without a DepthShader, unprojection happens on the CPU in @ref
+   * retrieveAsyncRead().
+   */
+  void readFrameDepthAsync();
+
+  /**
+   * @brief Queue an asynchronous read of the ObjectID rendering results.  See
+   * @ref readFrameRgbaAsync()
+   *
+   * The result is retrieved as @ref Magnum::PixelFormat::R32UI.
+   */
+  void readFrameObjectIdAsync();
+
+  /**
+   * @brief Queue an asynchronous read of the surface normals.  See @ref
+   * readFrameSurfaceNormals() and @ref readFrameRgbaAsync()
+   *
+   * The result is retrieved as @ref Magnum::PixelFormat::RGB32F.
+   */
+  void readFrameSurfaceNormalsAsync();
+
+  /**
+   * @brief Queue an asynchronous read of the motion vectors.  See @ref
+   * readFrameMotionVectors() and @ref readFrameRgbaAsync()
+   *
+   * The result is retrieved as @ref Magnum::PixelFormat::RG32F.
+   */
+  void readFrameMotionVectorsAsync();
+
+  /**
+   * @brief Queue an asynchronous read of the rendering results converted on
+   * the GPU.  See @ref readFrameConverted() and @ref readFrameRgbaAsync()
+   *
+   * The conversion is queued right away, the result is retrieved as the
+   * @ref convertedPixelFormat() of @p frame.
+   */
+  void readFrameConvertedAsync(ConvertedFrame frame, Magnum::Int downsampling);
+
+  /**
+   * @brief The number of queued asynchronous reads that have not been
+   * retrieved yet
+   */
+  int numPendingAsyncReads() const;
+
+  /**
+   * @brief Whether the GPU has finished the oldest pending asynchronous read,
+   * i.e. whether @ref retrieveAsyncRead() will return without waiting.
+   * Expects that a read is pending.
+   */
+  bool isAsyncReadReady();
+
+  /**
+   * @brief Retrieve the result of the oldest pending asynchronous read,
+   * waiting for the GPU if it has not finished yet.
+   *
+   * @param[in, out] view Preallocated memory that will be populated with the
+   * result.  It is expected to be large enough to hold a full frame in the
+   * pixel format of the queued read.
+   */
+  void retrieveAsyncRead(const Magnum::MutableImageView2D& view);
+
+  /**
+   * @brief Drop all pending asynchronous reads without retrieving them, e.g.
+   * once the frames they hold became stale
+   */
+  void discardAsyncReads();
+#endif
+
   /**
    * @brief Blits the rgba buffer from internal FBO to default frame buffer
    * which in case of EmscriptenApplication will be a canvas element.
@@ -151,6 +517,42 @@ class RenderTarget {
    * memory region of at least W*H*sizeof(int32_t) bytes.
    */
   void readFrameObjectIdGPU(int32_t* devPtr);
+
+  /**
+   * @brief Kinds of rendering results that can be read into CUDA memory
+   */
+  enum class FrameType {
+    /** RGBA, 4 x uint8_t per pixel.  See @ref readFrameRgbaGPU() */
+    Rgba,
+    /** Unprojected depth, 1 x float per pixel.  See @ref readFrameDepthGPU() */
+    Depth,
+    /** ObjectID, 1 x int32_t per pixel.  See @ref readFrameObjectIdGPU() */
+    ObjectId
+  };
+
+  /**
+   * @brief Reads the same kind of rendering result of several render targets
+   * into one contiguous CUDA buffer.
+   *
+   * All render targets must have the same framebuffer size. Their CUDA
+   * graphics resources are registered on first use and kept, then mapped and
+   * unmapped together with a single call each. Frame @p i is copied to
+   * @p devPtr at byte offset `i * W * H * bytesPerPixel`, i.e. @p devPtr is
+   * laid out as `[targets.size(), H, W, C]`. All copies are queued
+   * asynchronously on @p cudaStream.
+   *
+   * @param targets     The render targets to read from. Requires a valid
+   *                    DepthShader for @ref FrameType::Depth.
+   * @param type        The kind of rendering result to read
+   * @param[in, out] devPtr CUDA memory pointer that points to a contiguous
+   * memory region large enough for all frames
+   * @param cudaStream  The `cudaStream_t` to queue the copies on, nullptr for
+   *                    the default stream
+   */
+  static void readFramesGPU(const std::vector<RenderTarget*>& targets,
+                            FrameType type,
+                            void* devPtr,
+                            void* cudaStream);
 #endif
 
   ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(RenderTarget)
@@ -8,6 +8,7 @@
 #include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Mesh.h>
 #include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderbuffer.h>
 #include <Magnum/GL/RenderbufferFormat.h>
@@ -15,12 +16,20 @@
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/Image.h>
+#include <Magnum/Math/Frustum.h>
 #include <Magnum/PixelFormat.h>
 
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/FrameConversion.h"
+#include "esp/gfx/GpuProfiling.h"
+#include "esp/gfx/IndirectDrawBatch.h"
+#include "esp/gfx/MotionVectors.h"
+#include "esp/gfx/MultiviewFramebuffer.h"
+#include "esp/gfx/OcclusionCulling.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/magnum.h"
 
+namespace Cr = Corrade;
 namespace Mn = Magnum;
 
 namespace esp {
@@ -31,7 +40,11 @@ struct Renderer::Impl {
     Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::DepthTest);
     Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
   }
-  ~Impl() { LOG(INFO) << "Deconstructing Renderer"; }
+  ~Impl() {
+    VLOG(1) << "Deconstructing Renderer";
+    // the pending timer queries belong to the context going away
+    discardGpuTimings();
+  }
 
   void draw(RenderCamera& camera,
             scene::SceneGraph& sceneGraph,
@@ -51,8 +64,158 @@ struct Renderer::Impl {
 
     // set the modelview matrix, projection matrix of the render camera;
     sceneGraph.setDefaultRenderCamera(visualSensor);
+    RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+
+    switch (visualSensor.specification()->renderQuality) {
+      case sensor::RenderQuality::FULL:
+        break;
+      case sensor::RenderQuality::UNLIT:
+        flags |= RenderCamera::Flag::Unlit;
+        break;
+      case sensor::RenderQuality::VERTEX_COLOR:
+        flags |= RenderCamera::Flag::VertexColorOnly;
+        break;
+    }
+
+    // the occlusion is of the view of the sensor, kept by its target
+    if ((flags & RenderCamera::Flag::OcclusionCulling) &&
+        visualSensor.hasRenderTarget()) {
+      if (!occlusionBoxShader_) {
+        occlusionBoxShader_ = std::make_unique<DepthShader>(
+            DepthShader::Flag::NoFarPlanePatching);
+        occlusionBoxMesh_ = OcclusionCulling::createBoundingBoxMesh();
+      }
+      occlusionBoxShader_->setProjectionMatrix(camera.projectionMatrix());
+      camera.setOcclusionCulling(
+          &visualSensor.renderTarget().occlusionCulling(),
+          occlusionBoxShader_.get(), &occlusionBoxMesh_);
+    }
 
-    draw(sceneGraph.getDefaultRenderCamera(), sceneGraph, flags);
+    // the indirect batches cull on the GPU, where it has compute shaders
+    if ((flags & RenderCamera::Flag::GpuDriven) &&
+        IndirectDrawBatch::isSupported()) {
+      if (!indirectCullingShader_) {
+        indirectCullingShader_ = std::make_unique<IndirectCullingShader>();
+      }
+      camera.setIndirectCullingShader(indirectCullingShader_.get());
+    }
+
+    if (visualSensor.hasRenderTarget() &&
+        visualSensor.renderTarget().hasMotionVectors()) {
+      const Mn::Vector2 viewportSize{camera.viewport()};
+      motionVectorShader_->setProjectionMatrix(camera.projectionMatrix())
+          .setViewportSize(viewportSize);
+      instancedMotionVectorShader_
+          ->setProjectionMatrix(camera.projectionMatrix())
+          .setViewportSize(viewportSize);
+      camera.setLinearDepthShaders(motionVectorShader_.get(),
+                                   instancedMotionVectorShader_.get());
+      // the previous frame is of the sensor, kept by its target
+      MotionVectorHistory& history =
+          visualSensor.renderTarget().motionVectorHistory();
+      history.beginFrame();
+      camera.setMotionVectorHistory(&history);
+      draw(camera, sceneGraph, flags | RenderCamera::Flag::MotionVectors);
+      camera.setMotionVectorHistory(nullptr);
+    } else if (visualSensor.hasRenderTarget() &&
+               visualSensor.renderTarget().hasSurfaceNormals()) {
+      normalShader_->setProjectionMatrix(camera.projectionMatrix());
+      instancedNormalShader_->setProjectionMatrix(camera.projectionMatrix());
+      camera.setLinearDepthShaders(normalShader_.get(),
+                                   instancedNormalShader_.get());
+      draw(camera, sceneGraph, flags | RenderCamera::Flag::SurfaceNormals);
+    } else if (visualSensor.hasRenderTarget() &&
+               visualSensor.renderTarget().isDepthOnly() &&
+               !visualSensor.renderTarget().hasLinearDepth()) {
+      depthOnlyShader_->setProjectionMatrix(camera.projectionMatrix());
+      instancedDepthOnlyShader_->setProjectionMatrix(camera.projectionMatrix());
+      camera.setLinearDepthShaders(depthOnlyShader_.get(),
+                                   instancedDepthOnlyShader_.get());
+      draw(camera, sceneGraph, flags | RenderCamera::Flag::DepthOnly);
+    } else if (!visualSensor.hasRenderTarget() ||
+               !visualSensor.renderTarget().hasLinearDepth()) {
+      draw(camera, sceneGraph, flags);
+    } else {
+      linearDepthShader_->setProjectionMatrix(camera.projectionMatrix());
+      instancedLinearDepthShader_->setProjectionMatrix(
+          camera.projectionMatrix());
+      camera.setLinearDepthShaders(linearDepthShader_.get(),
+                                   instancedLinearDepthShader_.get());
+      draw(camera, sceneGraph, flags | RenderCamera::Flag::LinearDepth);
+      if (camera.getNumDrawablesWithoutLinearDepth() != 0) {
+        visualSensor.renderTarget().requireDepthUnprojection();
+      }
+    }
+    camera.setOcclusionCulling(nullptr, nullptr, nullptr);
+    camera.setIndirectCullingShader(nullptr);
+  }
+
+  bool drawStereo(sensor::VisualSensor& first,
+                  sensor::VisualSensor& second,
+                  scene::SceneGraph& sceneGraph,
+                  RenderCamera::Flags flags) {
+    RenderTarget& firstTarget = first.renderTarget();
+    RenderTarget& secondTarget = second.renderTarget();
+    if (!first.isStereoPairWith(second) || !firstTarget.isDepthOnly() ||
+        !secondTarget.isDepthOnly() || !MultiviewFramebuffer::isSupported()) {
+      drawEach(first, second, sceneGraph, flags);
+      return false;
+    }
+
+    if (!multiviewShader_) {
+      multiviewShader_ =
+          std::make_unique<DepthShader>(DepthShader::Flag::Multiview);
+      instancedMultiviewShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::Multiview |
+          DepthShader::Flag::InstancedTransformation);
+    }
+    const Mn::Vector2i size = firstTarget.framebufferSize();
+    if (!multiviewFramebuffer_ || multiviewFramebuffer_->size() != size) {
+      multiviewFramebuffer_ = MultiviewFramebuffer::create_unique(size);
+    }
+
+    // both views share the projection, the second is offset along the X
+    // axis of the first
+    sceneGraph.setDefaultRenderCamera(second);
+    RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+    const Mn::Matrix4 secondCamera = camera.cameraMatrix();
+    const Mn::Frustum secondFrustum =
+        Mn::Frustum::fromMatrix(camera.projectionMatrix() * secondCamera);
+    sceneGraph.setDefaultRenderCamera(first);
+    const Mn::Matrix4 firstCamera = camera.cameraMatrix();
+    const Mn::Frustum firstFrustum =
+        Mn::Frustum::fromMatrix(camera.projectionMatrix() * firstCamera);
+
+    // the planes other than the outer side ones are shared, so the outer
+    // ones bound the union of both frusta
+    const bool secondOnRight =
+        firstCamera.transformPoint(second.node().absoluteTranslation()).x() >
+        0.0f;
+    const Mn::Frustum& left = secondOnRight ? firstFrustum : secondFrustum;
+    const Mn::Frustum& right = secondOnRight ? secondFrustum : firstFrustum;
+    const Mn::Frustum frustum{left.left(), right.right(), left.bottom(),
+                              left.top(),  left.near(),   left.far()};
+
+    // the drawables are transformed relative to the first view
+    const Mn::Matrix4 secondView = secondCamera * firstCamera.inverted();
+    multiviewShader_->setProjectionMatrix(camera.projectionMatrix())
+        .setViewTransformationMatrices(Mn::Matrix4{}, secondView);
+    instancedMultiviewShader_->setProjectionMatrix(camera.projectionMatrix())
+        .setViewTransformationMatrices(Mn::Matrix4{}, secondView);
+    camera.setLinearDepthShaders(multiviewShader_.get(),
+                                 instancedMultiviewShader_.get());
+    camera.setCullingFrustum(&frustum);
+    multiviewFramebuffer_->renderEnter();
+    draw(camera, sceneGraph,
+         flags | RenderCamera::Flag::LinearDepth |
+             RenderCamera::Flag::Multiview);
+    camera.setCullingFrustum(nullptr);
+    if (camera.getNumDrawablesWithoutLinearDepth() != 0) {
+      drawEach(first, second, sceneGraph, flags);
+      return false;
+    }
+    multiviewFramebuffer_->renderExit(firstTarget, secondTarget);
+    return true;
   }
 
   void bindRenderTarget(sensor::VisualSensor& sensor) {
@@ -62,19 +225,212 @@ struct Renderer::Impl {
           "Sensor does not have a depthUnprojection matrix");
     }
 
+    const Flags flags = targetFlags(sensor);
+    const Mn::Int samples = sensor.specification()->samples;
+    createShaders(flags);
+
+    RenderTarget::uptr target = nullptr;
+    for (auto it = releasedTargets_.begin(); it != releasedTargets_.end();
+         ++it) {
+      if (it->size == sensor.framebufferSize() &&
+          it->depthUnprojection == *depthUnprojection &&
+          it->flags == flags && it->samples == samples) {
+        target = std::move(it->target);
+        releasedTargets_.erase(it);
+        break;
+      }
+    }
+    if (!target) {
+      target = RenderTarget::create_unique(sensor.framebufferSize(),
+                                           *depthUnprojection,
+                                           depthShader_.get(), flags, samples);
+    }
+    target->setObjectIdLookup(&objectIdLookup_);
+    sensor.bindRenderTarget(std::move(target));
+
+    sensor::ObservationSpace space;
+    if (sensor.hasObservationBuffer() || !sensor.getObservationSpace(space)) {
+      return;
+    }
+    for (auto it = releasedBuffers_.begin(); it != releasedBuffers_.end();
+         ++it) {
+      if ((*it)->shape == space.shape && (*it)->dataType == space.dataType) {
+        sensor.bindObservationBuffer(std::move(*it));
+        releasedBuffers_.erase(it);
+        break;
+      }
+    }
+  }
+
+  void releaseRenderTarget(sensor::VisualSensor& sensor) {
+    auto depthUnprojection = sensor.depthUnprojection();
+    const Flags flags = targetFlags(sensor);
+    RenderTarget::uptr target = sensor.releaseRenderTarget();
+    if (target && depthUnprojection) {
+      target->discardAsyncReads();
+      target->occlusionCulling().clear();
+      target->motionVectorHistory().clear();
+      target->discardCachedLayer();
+      releasedTargets_.push_back({target->framebufferSize(),
+                                  *depthUnprojection, flags,
+                                  sensor.specification()->samples,
+                                  std::move(target)});
+    }
+
+    core::Buffer::ptr buffer = sensor.releaseObservationBuffer();
+    // an observation may still hold it, or the memory may be the caller's
+    if (buffer && buffer.use_count() == 1 && !buffer->isExternal()) {
+      releasedBuffers_.push_back(std::move(buffer));
+    }
+  }
+
+  int numReleasedRenderTargets() const { return releasedTargets_.size(); }
+
+  std::size_t getReleasedRenderTargetGpuBytes() const {
+    std::size_t bytes = 0;
+    for (const ReleasedTarget& released : releasedTargets_) {
+      bytes += released.target->getGpuBytes();
+    }
+    return bytes;
+  }
+
+  void clearReleasedRenderTargets() {
+    releasedTargets_.clear();
+    releasedBuffers_.clear();
+  }
+
+  Flags flags() const { return flags_; }
+
+  void setFlags(Flags flags) { flags_ = flags; }
+
+  void setObjectIdLookup(
+      Cr::Containers::ArrayView<const Mn::UnsignedInt> table) {
+    objectIdLookup_.setData(table);
+  }
+
+ private:
+  //! create the shaders the targets of @p flags draw with, if missing
+  void createShaders(Flags flags) {
     if (!depthShader_) {
       depthShader_ = std::make_unique<DepthShader>(
           DepthShader::Flag::UnprojectExistingDepth);
     }
+    if ((flags & Flag::FusedDepthUnprojection) && !linearDepthShader_) {
+      linearDepthShader_ = std::make_unique<DepthShader>();
+      instancedLinearDepthShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::InstancedTransformation);
+    }
+    if ((flags & Flag::DepthOnly) && !depthOnlyShader_) {
+      // their output is masked, so the far plane needs no patching
+      depthOnlyShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::NoFarPlanePatching);
+      instancedDepthOnlyShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::NoFarPlanePatching |
+          DepthShader::Flag::InstancedTransformation);
+    }
+
+    if ((flags & Flag::SurfaceNormals) && !normalShader_) {
+      normalShader_ =
+          std::make_unique<DepthShader>(DepthShader::Flag::SurfaceNormals);
+      instancedNormalShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::SurfaceNormals |
+          DepthShader::Flag::InstancedTransformation);
+    }
 
-    sensor.bindRenderTarget(RenderTarget::create_unique(
-        sensor.framebufferSize(), *depthUnprojection, depthShader_.get(),
-        flags_));
+    if ((flags & Flag::MotionVectors) && !motionVectorShader_) {
+      motionVectorShader_ =
+          std::make_unique<DepthShader>(DepthShader::Flag::MotionVectors);
+      instancedMotionVectorShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::MotionVectors |
+          DepthShader::Flag::InstancedTransformation);
+    }
   }
 
- private:
+  void prewarmShaders() {
+    // the depth sensors, the most common ones besides the color sensors
+    Flags flags = flags_ & ~(Flag::SurfaceNormals | Flag::MotionVectors);
+    if (!(flags & Flag::FusedDepthUnprojection)) {
+      flags |= Flag::DepthOnly;
+    }
+    createShaders(flags);
+  }
+
+  //! the flags of the render target of @p sensor, only depth sensors fuse
+  //! the depth unprojection, only normal sensors draw normals and only
+  //! optical flow sensors draw motion vectors
+  Flags targetFlags(sensor::VisualSensor& sensor) const {
+    Flags flags = flags_ & ~(Flag::DepthOnly | Flag::SurfaceNormals |
+                             Flag::MotionVectors);
+    const sensor::SensorType type = sensor.specification()->sensorType;
+    if (type == sensor::SensorType::NORMAL) {
+      flags &= ~Flag::FusedDepthUnprojection;
+      flags |= Flag::SurfaceNormals;
+    } else if (type == sensor::SensorType::OPTICAL_FLOW) {
+      flags &= ~Flag::FusedDepthUnprojection;
+      flags |= Flag::MotionVectors;
+    } else if (type != sensor::SensorType::DEPTH) {
+      flags &= ~Flag::FusedDepthUnprojection;
+    } else if (!(flags & Flag::FusedDepthUnprojection)) {
+      flags |= Flag::DepthOnly;
+    }
+    return flags;
+  }
+
+  //! draw a stereo pair which cannot be drawn at once one after the other
+  void drawEach(sensor::VisualSensor& first,
+                sensor::VisualSensor& second,
+                scene::SceneGraph& sceneGraph,
+                RenderCamera::Flags flags) {
+    for (sensor::VisualSensor* sensor : {&first, &second}) {
+      sensor->renderTarget().renderEnter();
+      draw(*sensor, sceneGraph, flags);
+      sensor->renderTarget().renderExit();
+    }
+  }
+
+  //! a render target given back by releaseRenderTarget(), with what it was
+  //! created for
+  struct ReleasedTarget {
+    Mn::Vector2i size;
+    Mn::Vector2 depthUnprojection;
+    Flags flags;
+    //! the sample count the sensor asked for, not the supported one
+    Mn::Int samples;
+    RenderTarget::uptr target;
+  };
+
   std::unique_ptr<DepthShader> depthShader_;
-  const Flags flags_;
+  //! draw the linear depth of regular and instanced meshes for the render
+  //! targets with Flag::FusedDepthUnprojection
+  std::unique_ptr<DepthShader> linearDepthShader_;
+  std::unique_ptr<DepthShader> instancedLinearDepthShader_;
+  //! draw the positions of regular and instanced meshes for the render
+  //! targets with Flag::DepthOnly
+  std::unique_ptr<DepthShader> depthOnlyShader_;
+  std::unique_ptr<DepthShader> instancedDepthOnlyShader_;
+  //! draw the normals of regular and instanced meshes for the render
+  //! targets with Flag::SurfaceNormals
+  std::unique_ptr<DepthShader> normalShader_;
+  std::unique_ptr<DepthShader> instancedNormalShader_;
+  //! draw the motion vectors of regular and instanced meshes for the render
+  //! targets with Flag::MotionVectors
+  std::unique_ptr<DepthShader> motionVectorShader_;
+  std::unique_ptr<DepthShader> instancedMotionVectorShader_;
+  //! draw the linear depth of both views of a stereo pair at once, see
+  //! drawStereo()
+  std::unique_ptr<DepthShader> multiviewShader_;
+  std::unique_ptr<DepthShader> instancedMultiviewShader_;
+  MultiviewFramebuffer::uptr multiviewFramebuffer_;
+  //! draw the bounding boxes for RenderCamera::Flag::OcclusionCulling
+  std::unique_ptr<DepthShader> occlusionBoxShader_;
+  Mn::GL::Mesh occlusionBoxMesh_{Mn::NoCreate};
+  //! cull the indirect batches for RenderCamera::Flag::GpuDriven
+  std::unique_ptr<IndirectCullingShader> indirectCullingShader_;
+  //! the table of ConvertedFrame::MappedObjectId, shared by all targets
+  ObjectIdLookup objectIdLookup_;
+  Flags flags_;
+  std::vector<ReleasedTarget> releasedTargets_;
+  std::vector<core::Buffer::ptr> releasedBuffers_;
 };
 
 Renderer::Renderer(Flags flags)
@@ -83,18 +439,61 @@ Renderer::Renderer(Flags flags)
 void Renderer::draw(RenderCamera& camera,
                     scene::SceneGraph& sceneGraph,
                     RenderCamera::Flags flags) {
+  ScopedGpuTimer timer{core::ProfilingStage::Drawing};
   pimpl_->draw(camera, sceneGraph, flags);
 }
 
 void Renderer::draw(sensor::VisualSensor& visualSensor,
                     scene::SceneGraph& sceneGraph,
                     RenderCamera::Flags flags) {
+  ScopedGpuTimer timer{core::ProfilingStage::Drawing};
   pimpl_->draw(visualSensor, sceneGraph, flags);
 }
 
+bool Renderer::drawStereo(sensor::VisualSensor& first,
+                          sensor::VisualSensor& second,
+                          scene::SceneGraph& sceneGraph,
+                          RenderCamera::Flags flags) {
+  ScopedGpuTimer timer{core::ProfilingStage::Drawing};
+  return pimpl_->drawStereo(first, second, sceneGraph, flags);
+}
+
 void Renderer::bindRenderTarget(sensor::VisualSensor& sensor) {
   pimpl_->bindRenderTarget(sensor);
 }
 
+void Renderer::prewarmShaders() {
+  pimpl_->prewarmShaders();
+}
+
+void Renderer::releaseRenderTarget(sensor::VisualSensor& sensor) {
+  pimpl_->releaseRenderTarget(sensor);
+}
+
+int Renderer::numReleasedRenderTargets() const {
+  return pimpl_->numReleasedRenderTargets();
+}
+
+std::size_t Renderer::getReleasedRenderTargetGpuBytes() const {
+  return pimpl_->getReleasedRenderTargetGpuBytes();
+}
+
+void Renderer::clearReleasedRenderTargets() {
+  pimpl_->clearReleasedRenderTargets();
+}
+
+Renderer::Flags Renderer::flags() const {
+  return pimpl_->flags();
+}
+
+void Renderer::setFlags(Flags flags) {
+  pimpl_->setFlags(flags);
+}
+
+void Renderer::setObjectIdLookup(
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> table) {
+  pimpl_->setObjectIdLookup(table);
+}
+
 }  // namespace gfx
 }  // namespace esp
@@ -5,6 +5,8 @@
 #ifndef ESP_GFX_RENDERER_H_
 #define ESP_GFX_RENDERER_H_
 
+#include <Corrade/Containers/ArrayView.h>
+
 #include "esp/core/esp.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/scene/SceneGraph.h"
@@ -17,6 +19,32 @@ class Renderer {
  public:
   enum class Flag {
     NoTextures = 1 << 0,
+    /**
+     * Depth sensors draw linear depth straight into their render target
+     * instead of unprojecting the depth buffer in a full-screen pass after
+     * drawing, see @ref RenderTarget::hasLinearDepth(). Their color and
+     * object ID are not drawn.
+     */
+    FusedDepthUnprojection = 1 << 1,
+    /**
+     * Only the depth buffer is drawn, with position-only shaders and color
+     * writes masked, see @ref RenderTarget::isDepthOnly(). Set by the
+     * renderer for the render targets of the depth sensors which don't have
+     * @ref Flag::FusedDepthUnprojection.
+     */
+    DepthOnly = 1 << 2,
+    /**
+     * The camera-space surface normals are drawn instead of the color and
+     * object ID, see @ref RenderTarget::hasSurfaceNormals(). Set by the
+     * renderer for the render targets of the normal sensors.
+     */
+    SurfaceNormals = 1 << 3,
+    /**
+     * The motion vectors since the previous frame are drawn instead of the
+     * color and object ID, see @ref RenderTarget::hasMotionVectors(). Set
+     * by the renderer for the render targets of the optical flow sensors.
+     */
+    MotionVectors = 1 << 4,
   };
 
   typedef Corrade::Containers::EnumSet<Flag> Flags;
@@ -37,11 +65,94 @@ class Renderer {
             scene::SceneGraph& sceneGraph,
             RenderCamera::Flags flags = {RenderCamera::Flag::FrustumCulling});
 
+  /**
+   * @brief Draw the scene graph with a stereo pair of depth sensors, see
+   * @ref sensor::VisualSensor::isStereoPairWith()
+   *
+   * Takes the place of @ref RenderTarget::renderEnter(), @ref draw() and
+   * @ref RenderTarget::renderExit() for the targets of both sensors. With
+   * @gl_extension{OVR,multiview2}, the scene is culled once against the
+   * frustum holding both views and drawn in a single pass into a
+   * @ref MultiviewFramebuffer, whose views are then copied into the targets.
+   * Otherwise, or if the targets are not depth-only or the scene has
+   * drawables which cannot draw linear depth, e.g. PTex meshes drawn with a
+   * geometry shader, each sensor is drawn on its own.
+   * @return Whether the pair was drawn in a single pass
+   */
+  bool drawStereo(
+      sensor::VisualSensor& first,
+      sensor::VisualSensor& second,
+      scene::SceneGraph& sceneGraph,
+      RenderCamera::Flags flags = {RenderCamera::Flag::FrustumCulling});
+
   /**
    * @brief Binds a @ref RenderTarget to the sensor
+   *
+   * Takes the target from the ones given back by @ref releaseRenderTarget()
+   * if one has the size and depth unprojection of the sensor and the flags of
+   * the renderer, creating one otherwise. In the same way the sensor gets a
+   * released observation buffer of its observation space, if it has none.
    */
   void bindRenderTarget(sensor::VisualSensor& sensor);
 
+  /**
+   * @brief Create the depth shaders the render targets of depth sensors draw
+   * with ahead of the first @ref bindRenderTarget(), e.g. right after the
+   * context is created, loading them from the program binary cache if it is
+   * set, see @ref setProgramBinaryCacheDir()
+   */
+  void prewarmShaders();
+
+  /**
+   * @brief Give the render target and observation buffer of @p sensor back
+   * to the renderer, for @ref bindRenderTarget() to reuse for a sensor of the
+   * same specification, e.g. when an agent is re-created on reconfigure.
+   *
+   * The pending asynchronous reads and the cached layer of the target are
+   * discarded. A buffer
+   * provided by the caller or still referenced by an observation is not
+   * reused.
+   */
+  void releaseRenderTarget(sensor::VisualSensor& sensor);
+
+  /**
+   * @brief The number of released render targets not reused yet
+   */
+  int numReleasedRenderTargets() const;
+
+  /**
+   * @brief Estimated GPU memory of the released render targets not reused
+   * yet, see @ref RenderTarget::getGpuBytes()
+   */
+  std::size_t getReleasedRenderTargetGpuBytes() const;
+
+  /**
+   * @brief Destroy the released render targets and observation buffers that
+   * were not reused
+   */
+  void clearReleasedRenderTargets();
+
+  /**
+   * @brief The flags this renderer was constructed with, or set later
+   */
+  Flags flags() const;
+
+  /**
+   * @brief Set the flags of the render targets bound afterwards, e.g. to
+   * allow color sensors once textures are loaded. Bound targets keep theirs.
+   */
+  void setFlags(Flags flags);
+
+  /**
+   * @brief Upload the table the ObjectID of the render targets is looked up
+   * in, see @ref RenderTarget::ConvertedFrame::MappedObjectId
+   *
+   * One table is shared by all targets, e.g. the semantic category index of
+   * each object ID of the semantic scene, replaced when it changes.
+   */
+  void setObjectIdLookup(
+      Corrade::Containers::ArrayView<const Magnum::UnsignedInt> table);
+
   // draw the scene graph with the default camera in scene graph
   // user needs to set the default camera so that it has correct
   // modelview matrix, projection matrix to render the scene
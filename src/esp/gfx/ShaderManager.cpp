@@ -4,19 +4,182 @@
 
 #include "ShaderManager.h"
 
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/OpenGL.h>
+#include <Magnum/GL/Shader.h>
+
 #include "esp/core/esp.h"
 #include "esp/gfx/Drawable.h"
+#include "esp/io/io.h"
 #include "esp/scene/SceneNode.h"
 
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
 namespace esp {
 namespace gfx {
 
+namespace {
+
+/**
+ * @brief Header of a program binary cache file, followed by the binary in the
+ * driver specific format
+ */
+struct ProgramBinaryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t format;
+  uint32_t size;
+};
+
+constexpr char ProgramBinaryMagic[4]{'H', 'P', 'R', 'G'};
+constexpr uint32_t ProgramBinaryVersion = 1;
+
+std::string& programBinaryCacheDir() {
+  static std::string dir;
+  return dir;
+}
+
+//! FNV-1a, continuing from @p hash
+uint64_t hashBytes(const void* data, std::size_t size, uint64_t hash) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+uint64_t hashString(const std::string& string, uint64_t hash) {
+  const uint64_t size = string.size();
+  hash = hashBytes(&size, sizeof(size), hash);
+  return hashBytes(string.data(), string.size(), hash);
+}
+
+//! the cache file of the program of @p shaders, empty without a usable cache
+std::string programBinaryFile(
+    std::initializer_list<Cr::Containers::Reference<Mn::GL::Shader>>
+        shaders) {
+  const std::string& dir = programBinaryCacheDir();
+  GLint numFormats = 0;
+  if (!dir.empty()) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  }
+  if (numFormats <= 0) {
+    return {};
+  }
+  Mn::GL::Context& context = Mn::GL::Context::current();
+  uint64_t hash = 14695981039346656037ull;
+  hash = hashString(context.vendorString(), hash);
+  hash = hashString(context.rendererString(), hash);
+  hash = hashString(context.versionString(), hash);
+  for (Mn::GL::Shader& shader : shaders) {
+    const uint32_t type = static_cast<uint32_t>(shader.type());
+    hash = hashBytes(&type, sizeof(type), hash);
+    for (const std::string& source : shader.sources()) {
+      hash = hashString(source, hash);
+    }
+  }
+  return Cr::Utility::Directory::join(
+      dir, Cr::Utility::formatString("{:.16x}.program", hash));
+}
+
+}  // namespace
+
 void setLightSetupForSubTree(scene::SceneNode& root,
                              const Magnum::ResourceKey& lightSetup) {
-  scene::preOrderFeatureTraversalWithCallback<Drawable>(
-      root, [&lightSetup](Drawable& drawable) {
-        drawable.setLightSetup(lightSetup);
-      });
+  for (Drawable& drawable : scene::preOrderFeatures<Drawable>(root)) {
+    drawable.setLightSetup(lightSetup);
+  }
+}
+
+void setProgramBinaryCacheDir(const std::string& dir) {
+  if (!dir.empty() && !Cr::Utility::Directory::mkpath(dir)) {
+    LOG(ERROR) << "setProgramBinaryCacheDir : Cannot create " << dir
+               << ", not caching program binaries.";
+    programBinaryCacheDir().clear();
+    return;
+  }
+  programBinaryCacheDir() = dir;
+}
+
+const std::string& getProgramBinaryCacheDir() {
+  return programBinaryCacheDir();
+}
+
+bool loadProgramBinary(
+    Mn::GL::AbstractShaderProgram& program,
+    std::initializer_list<Cr::Containers::Reference<Mn::GL::Shader>>
+        shaders) {
+  const std::string file = programBinaryFile(shaders);
+  if (file.empty() || !Cr::Utility::Directory::exists(file)) {
+    return false;
+  }
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      mapped = Cr::Utility::Directory::mapRead(file);
+  ProgramBinaryHeader header{};
+  if (!mapped || mapped.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, mapped.data(), sizeof(header));
+  if (std::memcmp(header.magic, ProgramBinaryMagic,
+                  sizeof(ProgramBinaryMagic)) != 0 ||
+      header.version != ProgramBinaryVersion ||
+      mapped.size() != sizeof(header) + header.size) {
+    return false;
+  }
+
+  glProgramBinary(program.id(), header.format, mapped.data() + sizeof(header),
+                  header.size);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program.id(), GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    // e.g. after a driver update keeping the version string
+    LOG(WARNING) << "loadProgramBinary : The driver rejected " << file
+                 << ", compiling the program again.";
+    return false;
+  }
+  return true;
+}
+
+void saveProgramBinary(
+    Mn::GL::AbstractShaderProgram& program,
+    std::initializer_list<Cr::Containers::Reference<Mn::GL::Shader>>
+        shaders) {
+  const std::string file = programBinaryFile(shaders);
+  if (file.empty()) {
+    return;
+  }
+  GLint size = 0;
+  glGetProgramiv(program.id(), GL_PROGRAM_BINARY_LENGTH, &size);
+  if (size <= 0) {
+    return;
+  }
+  std::vector<char> data(sizeof(ProgramBinaryHeader) + size);
+  GLsizei length = 0;
+  GLenum format = 0;
+  glGetProgramBinary(program.id(), size, &length, &format,
+                     data.data() + sizeof(ProgramBinaryHeader));
+  if (length <= 0) {
+    return;
+  }
+  ProgramBinaryHeader header{};
+  std::memcpy(header.magic, ProgramBinaryMagic, sizeof(ProgramBinaryMagic));
+  header.version = ProgramBinaryVersion;
+  header.format = format;
+  header.size = length;
+  std::memcpy(data.data(), &header, sizeof(header));
+  data.resize(sizeof(header) + length);
+
+  if (!io::writeFileAtomically(file, data.data(), data.size())) {
+    LOG(WARNING) << "saveProgramBinary : Cannot write " << file;
+  }
 }
 
 }  // namespace gfx
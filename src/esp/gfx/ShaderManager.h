@@ -5,7 +5,12 @@
 #ifndef ESP_GFX_SHADERMANAGER_H_
 #define ESP_GFX_SHADERMANAGER_H_
 
+#include <initializer_list>
+#include <string>
+
+#include <Corrade/Containers/Reference.h>
 #include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/GL.h>
 #include <Magnum/ResourceManager.h>
 
 #include "esp/gfx/LightSetup.h"
@@ -29,6 +34,47 @@ using ShaderManager = Magnum::ResourceManager<Magnum::GL::AbstractShaderProgram,
 void setLightSetupForSubTree(scene::SceneNode& root,
                              const Magnum::ResourceKey& lightSetup);
 
+/**
+ * @brief Set the directory the programs of the shaders of this library are
+ * cached in as driver specific binaries, shared by all contexts of the
+ * process. Empty, the default, disables the cache.
+ *
+ * Each binary is keyed by the GL vendor, renderer and version strings and the
+ * sources of the program, so a cache directory can be shared by the workers
+ * of a cluster with different GPUs and drivers.
+ */
+void setProgramBinaryCacheDir(const std::string& dir);
+
+/** @brief The directory set by @ref setProgramBinaryCacheDir() */
+const std::string& getProgramBinaryCacheDir();
+
+/**
+ * @brief Load @p program from the binary cached for the sources of @p
+ * shaders, see @ref setProgramBinaryCacheDir()
+ *
+ * The shaders only need their sources added. Their compilation and the link
+ * of @p program can be skipped on success.
+ * @return false if there is no cache, no usable binary or the driver rejects
+ * it.
+ */
+bool loadProgramBinary(
+    Magnum::GL::AbstractShaderProgram& program,
+    std::initializer_list<Corrade::Containers::Reference<Magnum::GL::Shader>>
+        shaders);
+
+/**
+ * @brief Save the binary of the linked @p program to the cache, for a later
+ * @ref loadProgramBinary() of the same sources. Does nothing without a
+ * cache.
+ *
+ * The program should be linked with a retrievable binary, see @ref
+ * Magnum::GL::AbstractShaderProgram::setRetrievableBinary().
+ */
+void saveProgramBinary(
+    Magnum::GL::AbstractShaderProgram& program,
+    std::initializer_list<Corrade::Containers::Reference<Magnum::GL::Shader>>
+        shaders);
+
 }  // namespace gfx
 }  // namespace esp
 
@@ -0,0 +1,219 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "TextureArrayPool.h"
+
+#include <algorithm>
+
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/TextureData.h>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+bool TextureArrayPool::Format::operator==(const Format& other) const {
+  return format == other.format && compressed == other.compressed &&
+         size == other.size && levelCount == other.levelCount &&
+         generateMipmap == other.generateMipmap &&
+         minificationFilter == other.minificationFilter &&
+         magnificationFilter == other.magnificationFilter &&
+         mipmapFilter == other.mipmapFilter && wrappingX == other.wrappingX &&
+         wrappingY == other.wrappingY;
+}
+
+TextureArrayPool::TextureArrayPool(int maxTextureSize, int layersPerArray)
+    : maxTextureSize_{maxTextureSize},
+      layersPerArray_{Mn::UnsignedInt(std::max(layersPerArray, 1))} {}
+
+bool TextureArrayPool::isPackable(const Texture& texture) const {
+  if (!texture.data || !texture.images || texture.images->empty() ||
+      texture.data->type() != Mn::Trade::TextureData::Type::Texture2D) {
+    return false;
+  }
+  const Mn::Trade::ImageData2D& image = texture.images->front();
+  if (image.size().max() > maxTextureSize_ || image.size().min() < 1) {
+    return false;
+  }
+  // the format of a layer is given by the generic one
+  for (const Mn::Trade::ImageData2D& level : *texture.images) {
+    const bool specific =
+        level.isCompressed()
+            ? Mn::isCompressedPixelFormatImplementationSpecific(
+                  level.compressedFormat())
+            : Mn::isPixelFormatImplementationSpecific(level.format());
+    if (specific || level.isCompressed() != image.isCompressed()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TextureArrayPool::Format TextureArrayPool::formatOf(const Texture& texture) {
+  const Mn::Trade::ImageData2D& image = texture.images->front();
+  Format format;
+  format.compressed = image.isCompressed();
+  format.format = format.compressed
+                      ? Mn::GL::textureFormat(image.compressedFormat())
+                      : Mn::GL::textureFormat(image.format());
+  format.size = image.size();
+  format.levelCount = texture.images->size();
+  // as for separate textures, a single uncompressed level gets its mips
+  // generated
+  format.generateMipmap = format.levelCount == 1 && !format.compressed;
+  format.minificationFilter = texture.data->minificationFilter();
+  format.magnificationFilter = texture.data->magnificationFilter();
+  format.mipmapFilter = texture.data->mipmapFilter();
+  format.wrappingX = texture.data->wrapping()[0];
+  format.wrappingY = texture.data->wrapping()[1];
+  return format;
+}
+
+void TextureArrayPool::createSet(
+    const std::vector<Format>& formats,
+    const std::vector<Texture>& textures) {
+  sets_.emplace_back();
+  Set& set = sets_.back();
+  set.formats = formats;
+  for (std::size_t i = 0; i < formats.size(); ++i) {
+    const Format& format = formats[i];
+    const Mn::Trade::TextureData& data = *textures[i].data;
+    auto array = std::make_unique<Mn::GL::Texture2DArray>();
+    (*array)
+        .setMagnificationFilter(data.magnificationFilter())
+        .setMinificationFilter(data.minificationFilter(), data.mipmapFilter())
+        .setWrapping(data.wrapping().xy())
+        .setStorage(format.generateMipmap
+                        ? Mn::Math::log2(format.size.max()) + 1
+                        : format.levelCount,
+                    format.format, {format.size, Mn::Int(layersPerArray_)});
+    set.arrays.push_back(std::move(array));
+
+    // generated mip levels add up to a third of the first level
+    std::size_t bytes = 0;
+    for (const Mn::Trade::ImageData2D& image : *textures[i].images) {
+      bytes += image.data().size();
+    }
+    set.layerBytes += format.generateMipmap ? bytes * 4 / 3 : bytes;
+  }
+}
+
+Cr::Containers::Optional<TextureArrayPool::Allocation> TextureArrayPool::add(
+    const std::vector<Texture>& textures) {
+  if (textures.empty()) {
+    return Cr::Containers::NullOpt;
+  }
+  std::vector<Format> formats;
+  formats.reserve(textures.size());
+  for (const Texture& texture : textures) {
+    if (!isPackable(texture)) {
+      return Cr::Containers::NullOpt;
+    }
+    formats.push_back(formatOf(texture));
+  }
+
+  // the first set of the formats with a layer left, or a new one
+  int setIndex = ID_UNDEFINED;
+  for (std::size_t i = 0; i < sets_.size(); ++i) {
+    const Set& set = sets_[i];
+    if (set.formats == formats &&
+        (!set.freeLayers.empty() || set.nextLayer < layersPerArray_)) {
+      setIndex = i;
+      break;
+    }
+  }
+  if (setIndex == ID_UNDEFINED) {
+    createSet(formats, textures);
+    setIndex = sets_.size() - 1;
+  }
+  Set& set = sets_[setIndex];
+
+  Allocation allocation;
+  allocation.set = setIndex;
+  if (!set.freeLayers.empty()) {
+    allocation.layer = set.freeLayers.back();
+    set.freeLayers.pop_back();
+  } else {
+    allocation.layer = set.nextLayer++;
+  }
+
+  for (std::size_t i = 0; i < textures.size(); ++i) {
+    Mn::GL::Texture2DArray& array = *set.arrays[i];
+    const std::vector<Mn::Trade::ImageData2D>& images = *textures[i].images;
+    for (std::size_t level = 0; level < images.size(); ++level) {
+      const Mn::Trade::ImageData2D& image = images[level];
+      const Mn::Vector3i offset{0, 0, Mn::Int(allocation.layer)};
+      if (image.isCompressed()) {
+        array.setCompressedSubImage(
+            level, offset,
+            Mn::CompressedImageView3D{image.compressedStorage(),
+                                      image.compressedFormat(),
+                                      {image.size(), 1},
+                                      image.data()});
+      } else {
+        array.setSubImage(level, offset,
+                          Mn::ImageView3D{image.storage(),
+                                          image.format(),
+                                          {image.size(), 1},
+                                          image.data()});
+      }
+    }
+    allocation.arrays.push_back(&array);
+    set.mipmapsDirty |= formats[i].generateMipmap;
+  }
+  return allocation;
+}
+
+void TextureArrayPool::release(const Allocation& allocation) {
+  if (allocation.set < 0 || allocation.set >= int(sets_.size())) {
+    return;
+  }
+  sets_[allocation.set].freeLayers.push_back(allocation.layer);
+}
+
+void TextureArrayPool::generateMipmaps() {
+  for (Set& set : sets_) {
+    if (!set.mipmapsDirty) {
+      continue;
+    }
+    for (std::size_t i = 0; i < set.arrays.size(); ++i) {
+      if (set.formats[i].generateMipmap) {
+        set.arrays[i]->generateMipmap();
+      }
+    }
+    set.mipmapsDirty = false;
+  }
+}
+
+int TextureArrayPool::getNumArrays() const {
+  int count = 0;
+  for (const Set& set : sets_) {
+    count += set.arrays.size();
+  }
+  return count;
+}
+
+int TextureArrayPool::getNumUsedLayers() const {
+  int count = 0;
+  for (const Set& set : sets_) {
+    count += set.nextLayer - set.freeLayers.size();
+  }
+  return count;
+}
+
+std::size_t TextureArrayPool::getGpuBytes() const {
+  std::size_t bytes = 0;
+  for (const Set& set : sets_) {
+    bytes += set.layerBytes * layersPerArray_;
+  }
+  return bytes;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,159 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_TEXTUREARRAYPOOL_H_
+#define ESP_GFX_TEXTUREARRAYPOOL_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::TextureArrayPool
+ */
+
+#include <memory>
+#include <vector>
+
+#include <Corrade/Containers/Optional.h>
+#include <Magnum/GL/TextureArray.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector2.h>
+#include <Magnum/Sampler.h>
+#include <Magnum/Trade/Trade.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Packs the textures of materials into layers of shared texture
+ * arrays, so that drawables with different textures of the same format can
+ * be drawn with the same bindings, and instanced together, see @ref
+ * PhongMaterialData::textureLayer.
+ *
+ * The shaders read all textures of a draw at one layer, so the textures of a
+ * material are packed together: the materials whose textures have the same
+ * formats, sizes, mip levels and samplers, in the same order, share a set of
+ * arrays, one per texture, and each material gets the same layer of all of
+ * them. An array is allocated with a fixed number of layers, and a set with
+ * all layers in use gets a new set of arrays.
+ */
+class TextureArrayPool {
+ public:
+  /** @brief A texture of a material to pack */
+  struct Texture {
+    const Magnum::Trade::TextureData* data;
+    //! the mip levels, a single level gets its mips generated
+    const std::vector<Magnum::Trade::ImageData2D>* images;
+  };
+
+  /** @brief The layer the textures of a material were packed into */
+  struct Allocation {
+    //! the array of each texture, in the order given to @ref add()
+    std::vector<Magnum::GL::Texture2DArray*> arrays;
+    Magnum::UnsignedInt layer = 0;
+    //! the set of the arrays, for @ref release()
+    int set = ID_UNDEFINED;
+  };
+
+  /**
+   * @brief Constructor
+   * @param maxTextureSize The largest width or height of a packed texture,
+   * larger ones are left to separate textures
+   * @param layersPerArray The number of layers allocated for each array
+   */
+  explicit TextureArrayPool(int maxTextureSize = 512, int layersPerArray = 16);
+
+  /**
+   * @brief Whether @p texture can be packed, i.e. whether its images are at
+   * most @p maxTextureSize large and have a generic format
+   */
+  bool isPackable(const Texture& texture) const;
+
+  /**
+   * @brief Pack the textures of a material into a layer of a set of arrays
+   * @return The layer, or an empty optional if one of the textures can't be
+   * packed, see @ref isPackable()
+   *
+   * The mips of the layers of single-level textures are generated by the
+   * next @ref generateMipmaps().
+   */
+  Corrade::Containers::Optional<Allocation> add(
+      const std::vector<Texture>& textures);
+
+  /**
+   * @brief Make the layer of @p allocation available to @ref add() again.
+   * The materials drawn with it must not be drawn anymore.
+   */
+  void release(const Allocation& allocation);
+
+  /**
+   * @brief Generate the mips of the arrays with layers added since the
+   * last call
+   */
+  void generateMipmaps();
+
+  /** @brief The largest width or height of a packed texture */
+  int getMaxTextureSize() const { return maxTextureSize_; }
+
+  /**
+   * @brief Set the largest width or height of the textures packed
+   * afterwards
+   */
+  void setMaxTextureSize(int maxTextureSize) {
+    maxTextureSize_ = maxTextureSize;
+  }
+
+  /** @brief The number of arrays allocated */
+  int getNumArrays() const;
+
+  /** @brief The number of layers in use */
+  int getNumUsedLayers() const;
+
+  /** @brief Estimated GPU memory of the arrays, in bytes */
+  std::size_t getGpuBytes() const;
+
+ private:
+  //! what textures packed into one array have in common
+  struct Format {
+    Magnum::GL::TextureFormat format;
+    bool compressed;
+    Magnum::Vector2i size;
+    Magnum::UnsignedInt levelCount;
+    bool generateMipmap;
+    Magnum::SamplerFilter minificationFilter;
+    Magnum::SamplerFilter magnificationFilter;
+    Magnum::SamplerMipmap mipmapFilter;
+    Magnum::SamplerWrapping wrappingX;
+    Magnum::SamplerWrapping wrappingY;
+
+    bool operator==(const Format& other) const;
+  };
+
+  struct Set {
+    std::vector<Format> formats;
+    std::vector<std::unique_ptr<Magnum::GL::Texture2DArray>> arrays;
+    std::vector<Magnum::UnsignedInt> freeLayers;
+    Magnum::UnsignedInt nextLayer = 0;
+    std::size_t layerBytes = 0;
+    bool mipmapsDirty = false;
+  };
+
+  //! the format of @p texture in an array
+  static Format formatOf(const Texture& texture);
+
+  //! allocate the arrays of a new set of @p formats at the end
+  void createSet(const std::vector<Format>& formats,
+                 const std::vector<Texture>& textures);
+
+  int maxTextureSize_;
+  Magnum::UnsignedInt layersPerArray_;
+  std::vector<Set> sets_;
+
+  ESP_SMART_POINTERS(TextureArrayPool)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_TEXTUREARRAYPOOL_H_
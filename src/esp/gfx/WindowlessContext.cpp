@@ -13,11 +13,18 @@
 #elif defined(CORRADE_TARGET_UNIX)
 
 #ifdef ESP_BUILD_EGL_SUPPORT
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <Magnum/Platform/WindowlessEglApplication.h>
 #else
 #include <Magnum/Platform/WindowlessGlxApplication.h>
 #endif
 
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -25,26 +32,117 @@
 #include <Magnum/Platform/WindowlessWglApplication.h>
 #endif
 
+#include <algorithm>
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Context.h>
 #include <Magnum/Platform/GLContext.h>
 
+#include "GpuDevices.h"
+
 namespace Mn = Magnum;
 namespace Cr = Corrade;
 
 namespace esp {
 namespace gfx {
 
+namespace {
+
+#if defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_APPLE)
+/**
+ * @brief Point Mesa at llvmpipe before its driver is loaded, with
+ * @p numThreads rasterizer threads if positive. Variables set by the user
+ * are kept.
+ */
+void configureSoftwareRasterizer(int numThreads) {
+  setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+  if (numThreads > 0) {
+    setenv("LP_NUM_THREADS", std::to_string(numThreads).c_str(), 0);
+  }
+#ifndef ESP_BUILD_EGL_SUPPORT
+  setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+#endif
+}
+#endif
+
+#if defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_APPLE) && \
+    defined(ESP_BUILD_EGL_SUPPORT)
+//! the index of the EGL device of the software rasterizer, -1 if none
+int softwareEglDevice() {
+  auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+      eglGetProcAddress("eglQueryDevicesEXT"));
+  auto queryDeviceString = reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(
+      eglGetProcAddress("eglQueryDeviceStringEXT"));
+  EGLint count = 0;
+  if (!queryDevices || !queryDeviceString ||
+      !queryDevices(0, nullptr, &count)) {
+    return -1;
+  }
+  std::vector<EGLDeviceEXT> devices(count);
+  queryDevices(count, devices.data(), &count);
+  for (EGLint i = 0; i < count; ++i) {
+    const char* extensions = queryDeviceString(devices[i], EGL_EXTENSIONS);
+    if (extensions && std::strstr(extensions, "EGL_MESA_device_software")) {
+      return i;
+    }
+  }
+  return -1;
+}
+#endif
+
+//! the arguments the GL context of a share group is created with, without
+//! the vertex array objects each context would have its own of
+const char* SharedContextArguments[]{
+    "", "--magnum-disable-extensions",
+    "GL_ARB_vertex_array_object GL_OES_vertex_array_object"};
+
+}  // namespace
+
 struct WindowlessContext::Impl {
-  explicit Impl(int device)
-      : device_{device},
-        magnumGLContext_{Mn::NoCreate},
+  Impl(int device,
+       bool softwareRendering,
+       int numRasterizerThreads,
+       bool shareable,
+       Impl* shared = nullptr)
+      : device_{softwareRendering ? -1 : device},
+        shareable_{shareable},
+        magnumGLContext_{Mn::NoCreate, shareable ? 3 : 1,
+                         SharedContextArguments},
         windowlessGLContext_{Mn::NoCreate} {
     Mn::Platform::WindowlessGLContext::Configuration config;
+    if (shared) {
+      CORRADE_ASSERT(shared->shareable_,
+                     "WindowlessContext: the shared context is not shareable",
+                     );
+#if defined(CORRADE_TARGET_EMSCRIPTEN)
+      Mn::Fatal{} << "WindowlessContext: shared contexts are not supported "
+                     "on WebGL";
+#elif defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_APPLE) && \
+    defined(ESP_BUILD_EGL_SUPPORT)
+      // on the display of the shared context instead of a device
+      config.setSharedContext(shared->windowlessGLContext_.display(),
+                              shared->windowlessGLContext_.glContext());
+#else
+      config.setSharedContext(shared->windowlessGLContext_.glContext());
+#endif
+    }
 
 #if defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_APPLE)
+    if (softwareRendering) {
+      configureSoftwareRasterizer(numRasterizerThreads);
+    }
 #ifdef ESP_BUILD_EGL_SUPPORT
-    config.setCudaDevice(device);
+    if (!shared && softwareRendering) {
+      const int eglDevice = softwareEglDevice();
+      if (eglDevice < 0)
+        Mn::Fatal{} << "WindowlessContext: no software EGL device, install "
+                       "Mesa with llvmpipe for software rendering";
+      config.setDevice(eglDevice);
+    } else if (!shared) {
+      config.setCudaDevice(device);
+    }
 #else  // NO ESP_BUILD_EGL_SUPPORT
-    if (device != 0)
+    if (device != 0 && !softwareRendering)
       Mn::Fatal{} << "GLX context does not support multiple GPUs. Please "
                      "compile with --headless for multi-gpu support via EGL";
 
@@ -52,6 +150,10 @@ struct WindowlessContext::Impl {
       Mn::Fatal{} << "DISPLAY not detected. For headless systems, compile with "
                      "--headless for EGL support";
 #endif
+#else
+    if (softwareRendering)
+      Mn::Fatal{} << "WindowlessContext: software rendering is only "
+                     "supported on Linux";
 #endif
 
     windowlessGLContext_ =
@@ -64,20 +166,56 @@ struct WindowlessContext::Impl {
 
     if (!magnumGLContext_.tryCreate())
       Mn::Fatal{} << "WindowlessContext: Failed to create OpenGL context";
+
+    if (softwareRendering) {
+      LOG(INFO) << "WindowlessContext: software rendering with "
+                << magnumGLContext_.rendererString();
+    } else {
+      addGpuDeviceContext(device_);
+    }
+  }
+
+  explicit Impl(Impl& shared)
+      : Impl{std::max(shared.device_, 0), shared.isSoftwareRendering(), 0,
+             true, &shared} {}
+
+  ~Impl() {
+    if (device_ >= 0) {
+      removeGpuDeviceContext(device_);
+    }
   }
 
   void makeCurrent() { windowlessGLContext_.makeCurrent(); }
 
   int gpuDevice() const { return device_; }
 
+  bool isSoftwareRendering() const { return device_ < 0; }
+
+  bool isShareable() const { return shareable_; }
+
  private:
   int device_;
+  bool shareable_;
   Mn::Platform::GLContext magnumGLContext_;
   Mn::Platform::WindowlessGLContext windowlessGLContext_;
 };
 
-WindowlessContext::WindowlessContext(int device /* = 0 */)
-    : pimpl_(spimpl::make_unique_impl<Impl>(device)) {}
+WindowlessContext::WindowlessContext(int device /* = 0 */,
+                                     bool softwareRendering /* = false */,
+                                     int numRasterizerThreads /* = 0 */,
+                                     bool shareable /* = false */)
+    : pimpl_(spimpl::make_unique_impl<Impl>(device,
+                                            softwareRendering,
+                                            numRasterizerThreads,
+                                            shareable)) {}
+
+WindowlessContext::WindowlessContext(Impl& shared)
+    : pimpl_(spimpl::make_unique_impl<Impl>(shared)) {}
+
+WindowlessContext::uptr WindowlessContext::createShared(
+    WindowlessContext& shared) {
+  return uptr{new WindowlessContext{*shared.pimpl_}};
+}
 
 void WindowlessContext::makeCurrent() {
   pimpl_->makeCurrent();
@@ -87,5 +225,13 @@ int WindowlessContext::gpuDevice() const {
   return pimpl_->gpuDevice();
 }
 
+bool WindowlessContext::isSoftwareRendering() const {
+  return pimpl_->isSoftwareRendering();
+}
+
+bool WindowlessContext::isShareable() const {
+  return pimpl_->isShareable();
+}
+
 }  // namespace gfx
 }  // namespace esp
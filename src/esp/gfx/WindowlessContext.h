@@ -12,15 +12,58 @@ namespace gfx {
 
 class WindowlessContext {
  public:
-  explicit WindowlessContext(int gpuDevice = 0);
+  /**
+   * @brief Create an OpenGL context and make it current
+   * @param gpuDevice The CUDA device of the context, ignored for software
+   * rendering
+   * @param softwareRendering Whether to draw with the Mesa llvmpipe software
+   * rasterizer on the CPU instead of a GPU, for nodes without one. A headless
+   * build picks the software EGL device, GLX still needs a display, e.g.
+   * Xvfb.
+   * @param numRasterizerThreads The threads llvmpipe distributes the tiles of
+   * each frame across, 0 for its default of one per core. Applies to the
+   * first software context of the process.
+   * @param shareable Whether other contexts can share the buffers, textures
+   * and shader programs of this one, see @ref createShared(). The meshes of
+   * all contexts of the share group are then drawn without vertex array
+   * objects, which can't be shared.
+   */
+  explicit WindowlessContext(int gpuDevice = 0,
+                             bool softwareRendering = false,
+                             int numRasterizerThreads = 0,
+                             bool shareable = false);
+
+  /**
+   * @brief Create an OpenGL context sharing the objects of @p shared and make
+   * it current, e.g. to draw on another thread
+   *
+   * The context is on the device of @p shared, which has to be
+   * @ref isShareable(). Framebuffers, queries and vertex array objects stay
+   * per context, so the render targets of a sensor are only drawn with the
+   * context they were created with. The contexts can be current on different
+   * threads at once, though the shared objects, e.g. the uniforms of a
+   * shader program, are not protected against concurrent use.
+   */
+  static uptr createShared(WindowlessContext& shared);
 
   ~WindowlessContext() { LOG(INFO) << "Deconstructing WindowlessContext"; }
 
   void makeCurrent();
 
+  /** @brief The CUDA device of the context, -1 for software rendering */
   int gpuDevice() const;
 
+  /** @brief Whether the context draws with the software rasterizer */
+  bool isSoftwareRendering() const;
+
+  /** @brief Whether other contexts can share the objects of this one */
+  bool isShareable() const;
+
   ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(WindowlessContext)
+
+ private:
+  //! see createShared()
+  explicit WindowlessContext(Impl& shared);
 };
 
 }  // namespace gfx
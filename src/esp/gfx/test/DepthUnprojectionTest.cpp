@@ -5,8 +5,10 @@
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/StridedArrayView.h>
 #include <Corrade/TestSuite/Compare/Numeric.h>
+#include <Corrade/Utility/Directory.h>
 #include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/OpenGL.h>
 #include <Magnum/GL/OpenGLTester.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/TextureFormat.h>
@@ -21,6 +23,7 @@
 #include <Magnum/Trade/MeshData.h>
 
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/ShaderManager.h"
 
 namespace Cr = Corrade;
 namespace Mn = Magnum;
@@ -39,9 +42,12 @@ struct DepthUnprojectionTest : Mn::GL::OpenGLTester {
   void testCpu();
   void testGpuDirect();
   void testGpuUnprojectExisting();
+  void testGpuProgramBinaryCache();
+  void testCpuKernel();
 
   void benchmarkBaseline();
   void benchmarkCpu();
+  void benchmarkCpuKernel();
   void benchmarkGpuDirect();
   void benchmarkGpuUnprojectExisting();
 };
@@ -137,18 +143,36 @@ const struct {
      DepthShader::Flag::NoFarPlanePatching},
 };
 
+const struct {
+  const char* name;
+  DepthUnprojectionKernel kernel;
+} KernelData[]{
+    {"scalar", DepthUnprojectionKernel::Scalar},
+    {"SSE2", DepthUnprojectionKernel::Sse2},
+    {"AVX2", DepthUnprojectionKernel::Avx2},
+    {"NEON", DepthUnprojectionKernel::Neon},
+};
+
 DepthUnprojectionTest::DepthUnprojectionTest() {
   addInstancedTests(
       {&DepthUnprojectionTest::testCpu, &DepthUnprojectionTest::testGpuDirect,
        &DepthUnprojectionTest::testGpuUnprojectExisting},
       Cr::Containers::arraySize(TestData));
 
+  addTests({&DepthUnprojectionTest::testGpuProgramBinaryCache});
+
+  addInstancedTests({&DepthUnprojectionTest::testCpuKernel},
+                    Cr::Containers::arraySize(KernelData));
+
   addInstancedBenchmarks({&DepthUnprojectionTest::benchmarkBaseline}, 50,
                          Cr::Containers::arraySize(UnprojectBenchmarkData));
 
   addInstancedBenchmarks({&DepthUnprojectionTest::benchmarkCpu}, 50,
                          Cr::Containers::arraySize(UnprojectBenchmarkData));
 
+  addInstancedBenchmarks({&DepthUnprojectionTest::benchmarkCpuKernel}, 50,
+                         Cr::Containers::arraySize(KernelData));
+
   addBenchmarks({&DepthUnprojectionTest::benchmarkGpuDirect}, 50,
                 BenchmarkType::GpuTime);
 
@@ -258,6 +282,63 @@ void DepthUnprojectionTest::testGpuUnprojectExisting() {
                        Cr::TestSuite::Compare::around(data.depth * 0.0002f));
 }
 
+void DepthUnprojectionTest::testGpuProgramBinaryCache() {
+  GLint numFormats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  if (numFormats == 0)
+    CORRADE_SKIP("The driver has no program binary formats");
+
+  const std::string cacheDir = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "DepthUnprojectionTestPrograms");
+  Cr::Utility::Directory::rm(cacheDir);
+  setProgramBinaryCacheDir(cacheDir);
+
+  /* The first shader is compiled and saved, the second loaded */
+  { DepthShader shader{DepthShader::Flag::NoFarPlanePatching}; }
+  const std::vector<std::string> files = Cr::Utility::Directory::list(
+      cacheDir, Cr::Utility::Directory::Flag::SkipDotAndDotDot);
+  CORRADE_COMPARE(files.size(), 1);
+
+  DepthShader shader{DepthShader::Flag::NoFarPlanePatching};
+  shader.setProjectionMatrix(TestData[0].projection)
+      .setTransformationMatrix(Mn::Matrix4{});
+  MAGNUM_VERIFY_NO_GL_ERROR();
+
+  setProgramBinaryCacheDir({});
+  Cr::Utility::Directory::rm(Cr::Utility::Directory::join(cacheDir, files[0]));
+  Cr::Utility::Directory::rm(cacheDir);
+}
+
+void DepthUnprojectionTest::testCpuKernel() {
+  auto&& data = KernelData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  if (!isDepthUnprojectionKernelSupported(data.kernel))
+    CORRADE_SKIP("Kernel not supported by the build or the CPU");
+
+  Mn::Vector2 unprojection = calculateDepthUnprojection(
+      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.01f, 100.0f));
+
+  /* Not a multiple of any vector size to test the tail as well, with every
+     seventh value on the far plane */
+  Cr::Containers::Array<float> expected{Cr::Containers::NoInit, 1027};
+  for (std::size_t i = 0; i != expected.size(); ++i)
+    expected[i] = i % 7 == 0 ? 1.0f : float(i) / float(expected.size());
+  Cr::Containers::Array<float> depth{Cr::Containers::NoInit, expected.size()};
+  for (std::size_t i = 0; i != expected.size(); ++i)
+    depth[i] = expected[i];
+
+  unprojectDepth(DepthUnprojectionKernel::Scalar, unprojection, expected);
+  unprojectDepth(data.kernel, unprojection, depth);
+
+  /* All kernels are expected to be bit-exact with the scalar one */
+  for (std::size_t i = 0; i != expected.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_VERIFY(depth[i] == expected[i]);
+  }
+  CORRADE_COMPARE(depth[7], 0.0f);
+}
+
 constexpr Mn::Vector2i BenchmarkSize{1536};
 
 void DepthUnprojectionTest::benchmarkBaseline() {
@@ -306,6 +387,32 @@ void DepthUnprojectionTest::benchmarkCpu() {
                      Cr::TestSuite::Compare::Greater);
 }
 
+void DepthUnprojectionTest::benchmarkCpuKernel() {
+  auto&& data = KernelData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  if (!isDepthUnprojectionKernelSupported(data.kernel))
+    CORRADE_SKIP("Kernel not supported by the build or the CPU");
+
+  if (testCaseRepeatId() == 0 &&
+      data.kernel == defaultDepthUnprojectionKernel()) {
+    Mn::Debug{} << "Default kernel:" << data.name;
+  }
+
+  Mn::Vector2 unprojection = calculateDepthUnprojection(
+      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.001f, 100.0f));
+
+  Cr::Containers::Array<float> depth{Cr::Containers::NoInit,
+                                     std::size_t(BenchmarkSize.product())};
+  for (std::size_t i = 0; i != depth.size(); ++i)
+    depth[i] = float(i % 10000) / float(10000);
+
+  CORRADE_BENCHMARK(1) { unprojectDepth(data.kernel, unprojection, depth); }
+
+  CORRADE_COMPARE_AS(Mn::Math::max<float>(depth), 9.0f,
+                     Cr::TestSuite::Compare::Greater);
+}
+
 void DepthUnprojectionTest::benchmarkGpuDirect() {
   Mn::GL::Texture2D output{};
   output.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
@@ -3,9 +3,17 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "io.h"
+#include <sys/stat.h>
+#include <atomic>
+#include <cstdio>
 #include <fstream>
 #include <set>
 
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#endif
+
 namespace esp {
 namespace io {
 
@@ -44,6 +52,38 @@ size_t fileSize(const std::string& filename) {
   return (size <= 0 ? 0 : size);
 }
 
+int64_t fileModificationTime(const std::string& filename) {
+  struct stat status;
+  if (stat(filename.c_str(), &status) != 0) {
+    return 0;
+  }
+  return int64_t(status.st_mtime);
+}
+
+bool writeFileAtomically(const std::string& filename,
+                         const char* data,
+                         std::size_t size) {
+  static std::atomic<uint64_t> nextTemporary{0};
+  const std::string temporary = filename + "." + std::to_string(getpid()) +
+                                "." + std::to_string(nextTemporary++) +
+                                ".tmp";
+  bool written = false;
+  {
+    std::ofstream file(temporary, std::ios::out | std::ios::binary);
+    written = file.write(data, size) && file.flush();
+  }
+  if (!written || std::rename(temporary.c_str(), filename.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool writeFileAtomically(const std::string& filename,
+                         const std::string& data) {
+  return writeFileAtomically(filename, data.data(), data.size());
+}
+
 // TODO:
 // a corner case it will fail to match the replace_extension in c++17:
 // filename = "foo"
@@ -5,6 +5,8 @@
 #ifndef ESP_IO_IO_H_
 #define ESP_IO_IO_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -15,6 +17,32 @@ bool exists(const std::string& file);
 
 size_t fileSize(const std::string& file);
 
+/**
+ * @brief The last modification time of a file, in seconds since the epoch, 0
+ * if it doesn't exist
+ */
+int64_t fileModificationTime(const std::string& file);
+
+/**
+ * @brief Write @p size bytes of @p data to @p file through a temporary file
+ * renamed over it, so readers never see a partial file
+ * @return Whether the file was written, the temporary is removed if not
+ *
+ * Readers opening or mapping @p file concurrently, in this process or
+ * others, see either the previous file or the complete new one, so the
+ * callers writing caches need no locking of their own.
+ *
+ * The temporary is named after the process and a counter, so concurrent
+ * writers of the same file, in this process or others, don't clobber each
+ * other's. The last one renamed wins.
+ */
+bool writeFileAtomically(const std::string& file,
+                         const char* data,
+                         std::size_t size);
+
+/** @overload */
+bool writeFileAtomically(const std::string& file, const std::string& data);
+
 std::string removeExtension(const std::string& file);
 
 std::string changeExtension(const std::string& file, const std::string& ext);
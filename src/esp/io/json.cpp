@@ -4,22 +4,29 @@
 
 #include "esp/io/json.h"
 
-#include <rapidjson/filereadstream.h>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Directory.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
 #include "esp/core/esp.h"
 
+namespace Cr = Corrade;
+
 namespace esp {
 namespace io {
 
 JsonDocument parseJsonFile(const std::string& file) {
-  FILE* pFile = fopen(file.c_str(), "rb");
-  char buffer[65536];
-  rapidjson::FileReadStream is(pFile, buffer, sizeof(buffer));
+  // parse the whole file from memory instead of refilling a stream buffer,
+  // the strings are copied into the document so the mapping can go away
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      data = Cr::Utility::Directory::mapRead(file);
   JsonDocument d;
-  d.ParseStream<0, rapidjson::UTF8<>, rapidjson::FileReadStream>(is);
-  fclose(pFile);
+  if (!data) {
+    LOG(ERROR) << "Unable to read " << file;
+    throw std::runtime_error("JSON parse error");
+  }
+  d.Parse(data.data(), data.size());
 
   if (d.HasParseError()) {
     LOG(ERROR) << "Parse error reading " << file << " Error code "
@@ -48,6 +55,24 @@ std::string jsonToString(const JsonDocument& d) {
   return buffer.GetString();
 }
 
+int JsonObjectReader::read(const JsonGenericValue& jsonObject) const {
+  if (!jsonObject.IsObject()) {
+    return 0;
+  }
+  int numRead = 0;
+  std::string tag;
+  for (const auto& member : jsonObject.GetObject()) {
+    // reuse the key buffer for the lookup
+    tag.assign(member.name.GetString(), member.name.GetStringLength());
+    auto reader = readers_.find(tag);
+    if (reader != readers_.end() &&
+        reader->second(member.value, tag.c_str())) {
+      ++numRead;
+    }
+  }
+  return numRead;
+}
+
 vec3f jsonToVec3f(const JsonGenericValue& jsonArray) {
   vec3f vec;
   size_t dim = 0;
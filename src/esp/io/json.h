@@ -12,9 +12,12 @@
 
 #include <functional>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <Magnum/Magnum.h>
+#include <Magnum/Math/Quaternion.h>
 #include <Magnum/Math/Vector3.h>
 
 namespace esp {
@@ -36,176 +39,211 @@ std::string jsonToString(const JsonDocument& d);
 esp::vec3f jsonToVec3f(const JsonGenericValue& jsonArray);
 
 /**
- * @brief Check passed json doc for existence of passed @p tag as @tparam T.
- * MUST BE SPECIALIZED due to json tag queries relying on named, type-specific
- * getters.
+ * @brief Populate passed @p val with the JSON value @p jsonVal read as
+ * @tparam T. MUST BE SPECIALIZED due to json values relying on named,
+ * type-specific getters.
  *
  * @tparam T type of value to be populated.
- * @param d json document to parse
- * @param tag string tag to look for in json doc
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
  * @param val destination value to be populated
  * @return whether successful or not
  */
 template <typename T>
-bool jsonIntoVal(CORRADE_UNUSED const JsonDocument& d,
-                 const char* tag,
-                 CORRADE_UNUSED T& val) {
+bool jsonValueIntoVal(CORRADE_UNUSED const JsonGenericValue& jsonVal,
+                      const char* tag,
+                      CORRADE_UNUSED T& val) {
   LOG(ERROR) << "Unsupported typename specified for JSON tag " << tag
              << ". Aborting.";
   return false;
-}  // jsonIntoVal template definition
+}  // jsonValueIntoVal template definition
 
 /**
- * @brief Check passed json doc for existence of passed @p tag as
- * float. If present, populate passed @p val with value. Returns whether tag
- * is found and successfully populated, or not. Logs an error if tag is found
- * but is inappropriate type.
+ * @brief Populate passed @p val with the JSON value @p jsonVal as float.
+ * Logs an error if the value is of inappropriate type.
  *
- * @param d json document to parse
- * @param tag string tag to look for in json doc
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
  * @param val destination value to be populated
  * @return whether successful or not
  */
 template <>
-inline bool jsonIntoVal(const JsonDocument& d, const char* tag, float& val) {
-  if (d.HasMember(tag)) {
-    if (d[tag].IsNumber()) {
-      val = d[tag].GetFloat();
-      return true;
-    }
-    LOG(ERROR) << "Invalid float value specified in JSON config at " << tag;
+inline bool jsonValueIntoVal(const JsonGenericValue& jsonVal,
+                             const char* tag,
+                             float& val) {
+  if (jsonVal.IsNumber()) {
+    val = jsonVal.GetFloat();
+    return true;
   }
+  LOG(ERROR) << "Invalid float value specified in JSON config at " << tag;
   return false;
-}  // jsonIntoFloat
+}  // jsonValueIntoFloat
 
 /**
- * @brief Check passed json doc for existence of passed @p tag as
- * double. If present, populate passed @p val with value. Returns whether tag
- * is found and successfully populated, or not. Logs an error if tag is found
- * but is inappropriate type.
+ * @brief Populate passed @p val with the JSON value @p jsonVal as double.
+ * Logs an error if the value is of inappropriate type.
  *
- * @param d json document to parse
- * @param tag string tag to look for in json doc
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
  * @param val destination value to be populated
  * @return whether successful or not
  */
-
 template <>
-inline bool jsonIntoVal(const JsonDocument& d, const char* tag, double& val) {
-  if (d.HasMember(tag)) {
-    if (d[tag].IsNumber()) {
-      val = d[tag].GetDouble();
-      return true;
-    }
-    LOG(ERROR) << "Invalid double value specified in JSON config at " << tag;
+inline bool jsonValueIntoVal(const JsonGenericValue& jsonVal,
+                             const char* tag,
+                             double& val) {
+  if (jsonVal.IsNumber()) {
+    val = jsonVal.GetDouble();
+    return true;
   }
+  LOG(ERROR) << "Invalid double value specified in JSON config at " << tag;
   return false;
-}  // jsonIntoDouble
+}  // jsonValueIntoDouble
 
 /**
- * @brief Check passed json doc for existence of passed @p tag as
- * int. If present, populate passed @p val with value. Returns whether tag
- * is found and successfully populated, or not. Logs an error if tag is found
- * but is inappropriate type.
+ * @brief Populate passed @p val with the JSON value @p jsonVal as int.
+ * Logs an error if the value is of inappropriate type.
  *
- * @param d json document to parse
- * @param tag string tag to look for in json doc
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
  * @param val destination value to be populated
  * @return whether successful or not
  */
-
 template <>
-inline bool jsonIntoVal(const JsonDocument& d, const char* tag, int& val) {
-  if (d.HasMember(tag)) {
-    if (d[tag].IsNumber()) {
-      val = d[tag].GetInt();
-      return true;
-    }
-    LOG(ERROR) << "Invalid int value specified in JSON config at " << tag;
+inline bool jsonValueIntoVal(const JsonGenericValue& jsonVal,
+                             const char* tag,
+                             int& val) {
+  if (jsonVal.IsNumber()) {
+    val = jsonVal.GetInt();
+    return true;
   }
+  LOG(ERROR) << "Invalid int value specified in JSON config at " << tag;
   return false;
-}  // jsonIntoInt
+}  // jsonValueIntoInt
 
 /**
- * @brief Check passed json doc for existence of passed @p tag as
- * boolean. If present, populate passed @p val with value. Returns whether tag
- * is found and successfully populated, or not. Logs an error if tag is found
- * but is inappropriate type.
+ * @brief Populate passed @p val with the JSON value @p jsonVal as boolean.
+ * Logs an error if the value is of inappropriate type.
  *
- * @param d json document to parse
- * @param tag string tag to look for in json doc
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
  * @param val destination value to be populated
  * @return whether successful or not
  */
+template <>
+inline bool jsonValueIntoVal(const JsonGenericValue& jsonVal,
+                             const char* tag,
+                             bool& val) {
+  if (jsonVal.IsBool()) {
+    val = jsonVal.GetBool();
+    return true;
+  }
+  LOG(ERROR) << "Invalid boolean value specified in JSON config at " << tag;
+  return false;
+}  // jsonValueIntoBool
 
+/**
+ * @brief Populate passed @p val with the JSON value @p jsonVal as string.
+ * Logs an error if the value is of inappropriate type.
+ *
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
+ * @param val destination value to be populated
+ * @return whether successful or not
+ */
 template <>
-inline bool jsonIntoVal(const JsonDocument& d, const char* tag, bool& val) {
-  if (d.HasMember(tag)) {
-    if (d[tag].IsBool()) {
-      val = d[tag].GetBool();
-      return true;
-    }
-    LOG(ERROR) << "Invalid boolean value specified in JSON config at " << tag;
+inline bool jsonValueIntoVal(const JsonGenericValue& jsonVal,
+                             const char* tag,
+                             std::string& val) {
+  if (jsonVal.IsString()) {
+    val.assign(jsonVal.GetString(), jsonVal.GetStringLength());
+    return true;
   }
+  LOG(ERROR) << "Invalid string value specified in JSON config at " << tag;
   return false;
-}  // jsonIntoBool
+}  // jsonValueIntoString
 
 /**
- * @brief Check passed json doc for existence of passed @p tag as
- * double. If present, populate passed @p val with
- * value. Returns whether tag is found and successfully populated, or not. Logs
- * an error if tag is found but is inappropriate type.
+ * @brief Specialization to handle Magnum::Vector3 values. Populate passed @p
+ * val with the JSON value @p jsonVal if it is an array of 3 numbers. Logs an
+ * error if an element of the array is not numeric.
  *
- * @param d json document to parse
- * @param tag string tag to look for in json doc
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
  * @param val destination value to be populated
  * @return whether successful or not
  */
+template <>
+inline bool jsonValueIntoVal(const JsonGenericValue& jsonVal,
+                             const char* tag,
+                             Magnum::Vector3& val) {
+  if (!jsonVal.IsArray() || jsonVal.Size() != 3) {
+    return false;
+  }
+  for (rapidjson::SizeType i = 0; i < 3; ++i) {
+    if (jsonVal[i].IsNumber()) {
+      val[i] = jsonVal[i].GetDouble();
+    } else {
+      LOG(ERROR) << " Invalid numeric value specified in JSON config at "
+                 << tag << " index :" << i;
+      return false;
+    }
+  }  // build array
+  return true;
+}  // jsonValueIntoVector3
 
+/**
+ * @brief Specialization to handle Magnum::Quaternion values, stored as an
+ * array of 4 numbers in w, x, y, z order. Populate passed @p val with the
+ * JSON value @p jsonVal if it is such an array. Logs an error if an element of
+ * the array is not numeric.
+ *
+ * @param jsonVal json value to read
+ * @param tag string tag of the value, for error messages
+ * @param val destination value to be populated
+ * @return whether successful or not
+ */
 template <>
-inline bool jsonIntoVal(const JsonDocument& d,
-                        const char* tag,
-                        std::string& val) {
-  if (d.HasMember(tag)) {
-    if (d[tag].IsString()) {
-      val = d[tag].GetString();
-      return true;
+inline bool jsonValueIntoVal(const JsonGenericValue& jsonVal,
+                             const char* tag,
+                             Magnum::Quaternion& val) {
+  if (!jsonVal.IsArray() || jsonVal.Size() != 4) {
+    return false;
+  }
+  for (rapidjson::SizeType i = 0; i < 4; ++i) {
+    if (!jsonVal[i].IsNumber()) {
+      LOG(ERROR) << " Invalid numeric value specified in JSON config at "
+                 << tag << " index :" << i;
+      return false;
     }
-    LOG(ERROR) << "Invalid string value specified in JSON config at " << tag;
   }
-  return false;
-}  // jsonIntoString
+  val = Magnum::Quaternion{
+      {jsonVal[1].GetFloat(), jsonVal[2].GetFloat(), jsonVal[3].GetFloat()},
+      jsonVal[0].GetFloat()};
+  return true;
+}  // jsonValueIntoQuaternion
 
 /**
- * @brief Specialization to handle Magnum::Vector3 values.  Check passed json
- * doc for existence of passed @p tag as Magnum::Vector3. If present, populate
- * passed @p val with value. Returns whether tag is found and successfully
- * populated, or not. Logs an error if tag is found but is inappropriate type.
+ * @brief Check passed json doc for existence of passed @p tag as @tparam T.
+ * If present, populate passed @p val with value. Returns whether tag is found
+ * and successfully populated, or not. Logs an error if tag is found but is
+ * inappropriate type. The tag is looked up once, and the value read by @ref
+ * jsonValueIntoVal(), which must be specialized for @tparam T.
  *
+ * @tparam T type of value to be populated.
  * @param d json document to parse
  * @param tag string tag to look for in json doc
  * @param val destination value to be populated
  * @return whether successful or not
  */
-
-template <>
-inline bool jsonIntoVal(const JsonDocument& d,
-                        const char* tag,
-                        Magnum::Vector3& val) {
-  if (d.HasMember(tag) && d[tag].IsArray() && d[tag].Size() == 3) {
-    for (rapidjson::SizeType i = 0; i < 3; ++i) {
-      if (d[tag][i].IsNumber()) {
-        val[i] = d[tag][i].GetDouble();
-      } else {
-        LOG(ERROR) << " Invalid numeric value specified in JSON config at "
-                   << tag << " index :" << i;
-        return false;
-      }
-    }  // build array
-    return true;
+template <typename T>
+bool jsonIntoVal(const JsonDocument& d, const char* tag, T& val) {
+  JsonGenericValue::ConstMemberIterator member = d.FindMember(tag);
+  if (member == d.MemberEnd()) {
+    return false;
   }
-  return false;
-}  // jsonIntoString
+  return jsonValueIntoVal(member->value, tag, val);
+}  // jsonIntoVal
 
 /**
  * @brief Check passed json doc for existence of passed jsonTag as value of
@@ -260,6 +298,64 @@ bool jsonIntoConstSetter(const JsonDocument& d,
   return false;
 }  // jsonIntoArraySetter
 
+/**
+ * @brief Reads the members of a JSON object into setters in a single pass.
+ *
+ * Each @ref jsonIntoSetter() call looks its tag up among all the members of
+ * the object. A reader is given the setter of each tag once, then @ref read()
+ * iterates the members of an object and hands each one to the setter of its
+ * tag, reading it as @ref jsonIntoSetter() would. Members without a setter
+ * are ignored.
+ */
+class JsonObjectReader {
+ public:
+  /**
+   * @brief Set the setter the value of @p tag is read into, as @tparam T.
+   * Should use explicit type cast on function call if setter is specified
+   * using std::bind()
+   * @param tag string tag of the member
+   * @param setter value setter in some object to populate with the data from
+   * json.
+   * @return reference to self, for chaining
+   */
+  template <typename T>
+  JsonObjectReader& addSetter(const std::string& tag,
+                              std::function<void(T)> setter) {
+    readers_[tag] = [setter](const JsonGenericValue& jsonVal,
+                             const char* memberTag) {
+      T val;
+      if (!jsonValueIntoVal(jsonVal, memberTag, val)) {
+        return false;
+      }
+      setter(val);
+      return true;
+    };
+    return *this;
+  }
+
+  /**
+   * @brief Like @ref addSetter(), for a setter treating the value as const,
+   * see @ref jsonIntoConstSetter().
+   */
+  template <typename T>
+  JsonObjectReader& addConstSetter(const std::string& tag,
+                                   std::function<void(const T)> setter) {
+    return addSetter<T>(tag, std::function<void(T)>{std::move(setter)});
+  }
+
+  /**
+   * @brief Read the members of @p jsonObject with a setter into their setter
+   * @param jsonObject json object to read, nothing is read if it is not an
+   * object
+   * @return the number of members successfully read
+   */
+  int read(const JsonGenericValue& jsonObject) const;
+
+ private:
+  typedef std::function<bool(const JsonGenericValue&, const char*)> Reader;
+  std::unordered_map<std::string, Reader> readers_;
+};
+
 template <typename GV, typename T>
 void toVector(const GV& arr,
               std::vector<T>* vec,
@@ -37,7 +37,9 @@ const std::string ObjectAttributes::JSONConfigTestString =
       "use bounding box for collision": true,
       "join collision meshes":true,
       "inertia": [1.1, 0.9, 0.3],
-      "COM": [0.1,0.2,0.3]
+      "COM": [0.1,0.2,0.3],
+      "linear sleeping threshold": 0.6,
+      "angular sleeping threshold": 0.7
     })";
 
 const std::string StageAttributes::JSONConfigTestString =
@@ -80,11 +82,20 @@ ObjectAttributes::ObjectAttributes(const std::string& handle)
   setInertia({0, 0, 0});
   setLinearDamping(0.2);
   setAngularDamping(0.2);
+  // use the thresholds of the physics manager
+  setLinearSleepingThreshold(-1.0);
+  setAngularSleepingThreshold(-1.0);
 
   setComputeCOMFromShape(true);
 
   setBoundingBoxCollisions(false);
   setJoinCollisionMeshes(true);
+  setMaxConvexHulls(0);
+  setMaxHullVertices(32);
+  setConvexHullsHandle("");
+  setHasAssetMetadata(false);
+  setRenderAssetAabb({});
+  setRenderAssetTriangleCount(0);
   setRequiresLighting(true);
   setIsVisible(true);
   setSemanticId(0);
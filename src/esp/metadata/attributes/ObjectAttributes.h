@@ -5,6 +5,8 @@
 #ifndef ESP_METADATA_ATTRIBUTES_OBJECTATTRIBUTES_H_
 #define ESP_METADATA_ATTRIBUTES_OBJECTATTRIBUTES_H_
 
+#include <Magnum/Math/Range.h>
+
 #include "AttributesBase.h"
 
 #include "esp/assets/Asset.h"
@@ -45,7 +47,10 @@ class AbstractObjectAttributes : public AbstractAttributes {
    * @brief Scale of the ojbect
    */
   void setScale(const Magnum::Vector3& scale) { setVec3("scale", scale); }
-  Magnum::Vector3 getScale() const { return getVec3("scale"); }
+  Magnum::Vector3 getScale() const {
+    static const core::ConfigKey key{"scale"};
+    return getVec3(key);
+  }
 
   void setCollisionAssetSize(const Magnum::Vector3& collisionAssetSize) {
     setVec3("collisionAssetSize", collisionAssetSize);
@@ -58,7 +63,10 @@ class AbstractObjectAttributes : public AbstractAttributes {
    * @brief collision shape inflation margin
    */
   void setMargin(double margin) { setDouble("margin", margin); }
-  double getMargin() const { return getDouble("margin"); }
+  double getMargin() const {
+    static const core::ConfigKey key{"margin"};
+    return getDouble(key);
+  }
 
   /**
    * @brief set default up orientation for object/stage mesh
@@ -91,14 +99,16 @@ class AbstractObjectAttributes : public AbstractAttributes {
     setDouble("frictionCoefficient", frictionCoefficient);
   }
   double getFrictionCoefficient() const {
-    return getDouble("frictionCoefficient");
+    static const core::ConfigKey key{"frictionCoefficient"};
+    return getDouble(key);
   }
 
   void setRestitutionCoefficient(double restitutionCoefficient) {
     setDouble("restitutionCoefficient", restitutionCoefficient);
   }
   double getRestitutionCoefficient() const {
-    return getDouble("restitutionCoefficient");
+    static const core::ConfigKey key{"restitutionCoefficient"};
+    return getDouble(key);
   }
   void setRenderAssetType(int renderAssetType) {
     setInt("renderAssetType", renderAssetType);
@@ -198,32 +208,73 @@ class ObjectAttributes : public AbstractObjectAttributes {
   ObjectAttributes(const std::string& handle = "");
   // center of mass (COM)
   void setCOM(const Magnum::Vector3& com) { setVec3("COM", com); }
-  Magnum::Vector3 getCOM() const { return getVec3("COM"); }
+  Magnum::Vector3 getCOM() const {
+    static const core::ConfigKey key{"COM"};
+    return getVec3(key);
+  }
 
   // whether com is provided or not
   void setComputeCOMFromShape(bool computeCOMFromShape) {
     setBool("computeCOMFromShape", computeCOMFromShape);
   }
-  bool getComputeCOMFromShape() const { return getBool("computeCOMFromShape"); }
+  bool getComputeCOMFromShape() const {
+    static const core::ConfigKey key{"computeCOMFromShape"};
+    return getBool(key);
+  }
 
   void setMass(double mass) { setDouble("mass", mass); }
-  double getMass() const { return getDouble("mass"); }
+  double getMass() const {
+    static const core::ConfigKey key{"mass"};
+    return getDouble(key);
+  }
 
   // inertia diagonal
   void setInertia(const Magnum::Vector3& inertia) {
     setVec3("inertia", inertia);
   }
-  Magnum::Vector3 getInertia() const { return getVec3("inertia"); }
+  Magnum::Vector3 getInertia() const {
+    static const core::ConfigKey key{"inertia"};
+    return getVec3(key);
+  }
 
   void setLinearDamping(double linearDamping) {
     setDouble("linearDamping", linearDamping);
   }
-  double getLinearDamping() const { return getDouble("linearDamping"); }
+  double getLinearDamping() const {
+    static const core::ConfigKey key{"linearDamping"};
+    return getDouble(key);
+  }
 
   void setAngularDamping(double angularDamping) {
     setDouble("angularDamping", angularDamping);
   }
-  double getAngularDamping() const { return getDouble("angularDamping"); }
+  double getAngularDamping() const {
+    static const core::ConfigKey key{"angularDamping"};
+    return getDouble(key);
+  }
+
+  /**
+   * @brief The linear speed below which objects of this template may fall
+   * asleep, in meters per second. Negative (the default) to use the one of
+   * the @ref PhysicsManagerAttributes.
+   */
+  void setLinearSleepingThreshold(double linearSleepingThreshold) {
+    setDouble("linearSleepingThreshold", linearSleepingThreshold);
+  }
+  double getLinearSleepingThreshold() const {
+    return getDouble("linearSleepingThreshold");
+  }
+
+  /**
+   * @brief The angular speed below which objects of this template may fall
+   * asleep, in radians per second, see @ref setLinearSleepingThreshold().
+   */
+  void setAngularSleepingThreshold(double angularSleepingThreshold) {
+    setDouble("angularSleepingThreshold", angularSleepingThreshold);
+  }
+  double getAngularSleepingThreshold() const {
+    return getDouble("angularSleepingThreshold");
+  }
 
   // if true override other settings and use render mesh bounding box as
   // collision object
@@ -231,7 +282,8 @@ class ObjectAttributes : public AbstractObjectAttributes {
     setBool("useBoundingBoxForCollision", useBoundingBoxForCollision);
   }
   bool getBoundingBoxCollisions() const {
-    return getBool("useBoundingBoxForCollision");
+    static const core::ConfigKey key{"useBoundingBoxForCollision"};
+    return getBool(key);
   }
 
   // if true join all mesh components of an asset into a unified collision
@@ -241,6 +293,72 @@ class ObjectAttributes : public AbstractObjectAttributes {
   }
   bool getJoinCollisionMeshes() const { return getBool("joinCollisionMeshes"); }
 
+  /**
+   * @brief If positive, mesh collisions use a decomposition of the collision
+   * mesh into at most this many convex hulls, computed once and cached on
+   * disk, instead of the hulls of each mesh component. 0 (the default) turns
+   * the decomposition off, it also overrides @ref setJoinCollisionMeshes().
+   */
+  void setMaxConvexHulls(int maxConvexHulls) {
+    setInt("maxConvexHulls", maxConvexHulls);
+  }
+  int getMaxConvexHulls() const { return getInt("maxConvexHulls"); }
+
+  /**
+   * @brief The maximum number of vertices of each hull of the decomposition,
+   * see @ref setMaxConvexHulls()
+   */
+  void setMaxHullVertices(int maxHullVertices) {
+    setInt("maxHullVertices", maxHullVertices);
+  }
+  int getMaxHullVertices() const { return getInt("maxHullVertices"); }
+
+  /**
+   * @brief The file caching the decomposition of @ref setMaxConvexHulls(),
+   * the collision asset handle with a ".hulls" extension if empty
+   */
+  void setConvexHullsHandle(const std::string& convexHullsHandle) {
+    setString("convexHullsHandle", convexHullsHandle);
+  }
+  std::string getConvexHullsHandle() const {
+    return getString("convexHullsHandle");
+  }
+
+  /**
+   * @brief Whether the asset metadata below is filled, either from the cache
+   * file next to the render asset, see @ref
+   * managers::ObjectAttributesManager::loadAssetMetadata(), or when the render
+   * asset is first loaded. It describes the asset without loading it.
+   */
+  void setHasAssetMetadata(bool hasAssetMetadata) {
+    setBool("hasAssetMetadata", hasAssetMetadata);
+  }
+  bool getHasAssetMetadata() const { return getBool("hasAssetMetadata"); }
+
+  /**
+   * @brief The bounding box of the render asset in the frame of the object,
+   * before the scale of the template. Its center is the center of mass of
+   * objects computing it from the shape, see @ref getComputeCOMFromShape().
+   */
+  void setRenderAssetAabb(const Magnum::Range3D& aabb) {
+    setVec3("renderAssetAabbMin", aabb.min());
+    setVec3("renderAssetAabbMax", aabb.max());
+  }
+  Magnum::Range3D getRenderAssetAabb() const {
+    return {getVec3("renderAssetAabbMin"), getVec3("renderAssetAabbMax")};
+  }
+
+  /**
+   * @brief The number of triangles of the render asset, each instance of a
+   * mesh counted
+   */
+  void setRenderAssetTriangleCount(int triangleCount) {
+    setInt("renderAssetTriangleCount", triangleCount);
+  }
+  int getRenderAssetTriangleCount() const {
+    return getInt("renderAssetTriangleCount");
+  }
+
   /**
    * @brief If not visible can add dynamic non-rendered object into a scene
    * object.  If is not visible then should not add object to drawables.
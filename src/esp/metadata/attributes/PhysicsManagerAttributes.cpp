@@ -14,7 +14,18 @@ const std::string PhysicsManagerAttributes::JSONConfigTestString =
       "timestep": 1.0,
       "gravity": [1,2,3],
       "friction coefficient": 1.4,
-      "restitution coefficient": 1.1
+      "restitution coefficient": 1.1,
+      "num threads": 3,
+      "task scheduler": "openmp",
+      "cache stage bvh": true,
+      "broadphase": "sweep and prune",
+      "world bounds padding": 2.5,
+      "solver iterations": 4,
+      "manifold pool size": 1024,
+      "collision algorithm pool size": 2048,
+      "linear sleeping threshold": 0.3,
+      "angular sleeping threshold": 0.4,
+      "deactivation time": 0.5
     })";
 
 PhysicsManagerAttributes::PhysicsManagerAttributes(const std::string& handle)
@@ -22,6 +33,18 @@ PhysicsManagerAttributes::PhysicsManagerAttributes(const std::string& handle)
   setSimulator("none");
   setTimestep(0.01);
   setMaxSubsteps(10);
+  setNumThreads(1);
+  setTaskScheduler("habitat");
+  setCacheStageBvh(false);
+  // the defaults of Bullet
+  setBroadphase("dbvt");
+  setWorldBoundsPadding(1.0);
+  setSolverIterations(10);
+  setManifoldPoolSize(4096);
+  setCollisionAlgorithmPoolSize(4096);
+  setLinearSleepingThreshold(0.8);
+  setAngularSleepingThreshold(1.0);
+  setDeactivationTime(2.0);
 }  // PhysicsManagerAttributes ctor
 
 }  // namespace attributes
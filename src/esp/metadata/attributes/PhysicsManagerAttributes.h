@@ -53,6 +53,117 @@ class PhysicsManagerAttributes : public AbstractAttributes {
     return getDouble("restitutionCoefficient");
   }
 
+  /**
+   * @brief The number of threads stepping the Bullet world. More than 1 uses
+   * the multi-threaded world, which requires Bullet built with BT_THREADSAFE.
+   */
+  void setNumThreads(int numThreads) { setInt("numThreads", numThreads); }
+  int getNumThreads() const { return getInt("numThreads"); }
+
+  /**
+   * @brief The Bullet task scheduler of the multi-threaded world, one of
+   * "habitat", the threads of @ref core::TaskScheduler::global shared with
+   * the other parallel work, "internal", "openmp", "tbb" or "ppl". Falls
+   * back to the internal one if Bullet was built without the requested one.
+   */
+  void setTaskScheduler(const std::string& taskScheduler) {
+    setString("taskScheduler", taskScheduler);
+  }
+  std::string getTaskScheduler() const { return getString("taskScheduler"); }
+
+  /**
+   * @brief Whether the BVH of each stage collision mesh is saved next to the
+   * stage asset and loaded from there instead of being rebuilt.
+   */
+  void setCacheStageBvh(bool cacheStageBvh) {
+    setBool("cacheStageBvh", cacheStageBvh);
+  }
+  bool getCacheStageBvh() const { return getBool("cacheStageBvh"); }
+
+  /**
+   * @brief The Bullet broadphase, "dbvt" for a dynamic AABB tree or "sweep
+   * and prune" for an axis sweep over the bounds of the stage, which suits
+   * worlds of many static objects. See @ref setWorldBoundsPadding().
+   */
+  void setBroadphase(const std::string& broadphase) {
+    setString("broadphase", broadphase);
+  }
+  std::string getBroadphase() const { return getString("broadphase"); }
+
+  /**
+   * @brief How far the bounds of the sweep and prune broadphase extend beyond
+   * the collision AABB of the stage, in meters. Objects outside of them
+   * still collide, but slower.
+   */
+  void setWorldBoundsPadding(double worldBoundsPadding) {
+    setDouble("worldBoundsPadding", worldBoundsPadding);
+  }
+  double getWorldBoundsPadding() const {
+    return getDouble("worldBoundsPadding");
+  }
+
+  /**
+   * @brief The number of iterations of the Bullet constraint solver per
+   * substep. Fewer are faster, but let contacts and joints drift more.
+   */
+  void setSolverIterations(int solverIterations) {
+    setInt("solverIterations", solverIterations);
+  }
+  int getSolverIterations() const { return getInt("solverIterations"); }
+
+  /**
+   * @brief The number of contact manifolds Bullet preallocates, more are
+   * allocated one by one once they are used up.
+   */
+  void setManifoldPoolSize(int manifoldPoolSize) {
+    setInt("manifoldPoolSize", manifoldPoolSize);
+  }
+  int getManifoldPoolSize() const { return getInt("manifoldPoolSize"); }
+
+  /**
+   * @brief The number of collision algorithms Bullet preallocates, more are
+   * allocated one by one once they are used up.
+   */
+  void setCollisionAlgorithmPoolSize(int collisionAlgorithmPoolSize) {
+    setInt("collisionAlgorithmPoolSize", collisionAlgorithmPoolSize);
+  }
+  int getCollisionAlgorithmPoolSize() const {
+    return getInt("collisionAlgorithmPoolSize");
+  }
+
+  /**
+   * @brief The linear speed below which a dynamic object may fall asleep, in
+   * meters per second, for objects whose @ref ObjectAttributes don't set
+   * their own. Higher thresholds let settled objects sleep sooner.
+   */
+  void setLinearSleepingThreshold(double linearSleepingThreshold) {
+    setDouble("linearSleepingThreshold", linearSleepingThreshold);
+  }
+  double getLinearSleepingThreshold() const {
+    return getDouble("linearSleepingThreshold");
+  }
+
+  /**
+   * @brief The angular speed below which a dynamic object may fall asleep, in
+   * radians per second, see @ref setLinearSleepingThreshold().
+   */
+  void setAngularSleepingThreshold(double angularSleepingThreshold) {
+    setDouble("angularSleepingThreshold", angularSleepingThreshold);
+  }
+  double getAngularSleepingThreshold() const {
+    return getDouble("angularSleepingThreshold");
+  }
+
+  /**
+   * @brief How long an object must stay below its sleeping thresholds to
+   * fall asleep, in seconds. Bullet keeps it in a global, so it applies to
+   * all Bullet worlds of the process.
+   */
+  void setDeactivationTime(double deactivationTime) {
+    setDouble("deactivationTime", deactivationTime);
+  }
+  double getDeactivationTime() const { return getDouble("deactivationTime"); }
+
  public:
   ESP_SMART_POINTERS(PhysicsManagerAttributes)
 };  // class PhysicsManagerAttributes
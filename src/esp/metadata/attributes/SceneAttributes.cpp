@@ -6,6 +6,30 @@
 
 namespace esp {
 namespace metadata {
-namespace attributes {}  // namespace attributes
+namespace attributes {
+
+const std::string SceneAttributes::JSONConfigTestString =
+    R"({
+      "lighting setup": "test_lighting",
+      "object instances": [
+        {
+          "template name": "chair",
+          "translation": [1,2,3],
+          "rotation": [0,1,0,0],
+          "motion type": "STATIC"
+        },
+        {
+          "template name": "donut",
+          "translation": [4,5,6]
+        }
+      ]
+    })";
+
+SceneAttributes::SceneAttributes(const std::string& handle)
+    : AbstractAttributes("SceneAttributes", handle) {
+  setLightSetup("");
+}  // SceneAttributes ctor
+
+}  // namespace attributes
 }  // namespace metadata
 }  // namespace esp
@@ -5,11 +5,88 @@
 #ifndef ESP_METADATA_ATTRIBUTES_SCENEATTRIBUTES_H_
 #define ESP_METADATA_ATTRIBUTES_SCENEATTRIBUTES_H_
 
+#include <string>
+#include <vector>
+
+#include <Magnum/Math/Quaternion.h>
+#include <Magnum/Math/Vector3.h>
+
 #include "AttributesBase.h"
 
 namespace esp {
 namespace metadata {
-namespace attributes {}  // namespace attributes
+namespace attributes {
+
+/**
+ * @brief An object placed in a scene instance, see @ref SceneAttributes
+ */
+struct SceneObjectInstance {
+  /**
+   * @brief The handle of the object template, or a substring identifying it
+   * in the object attributes library
+   */
+  std::string templateHandle;
+
+  /** @brief Translation of the object */
+  Magnum::Vector3 translation;
+
+  /** @brief Rotation of the object */
+  Magnum::Quaternion rotation;
+
+  /**
+   * @brief Motion type of the object, one of "STATIC", "KINEMATIC" or
+   * "DYNAMIC". The object keeps the motion type it gets on creation if empty.
+   */
+  std::string motionType;
+};
+
+/**
+ * @brief attributes for a scene instance, the set of objects to place in a
+ * scene, which are all created in a single batch.
+ *
+ * The instances are kept as plain structs instead of one configuration each,
+ * so that scenes with many objects stay cheap to parse and copy.
+ */
+class SceneAttributes : public AbstractAttributes {
+ public:
+  /**
+   * @brief This defines an example json descriptor for @ref SceneAttributes,
+   * to be used to test json loading.
+   */
+  static const std::string JSONConfigTestString;
+
+  SceneAttributes(const std::string& handle = "");
+
+  /**
+   * @brief The key of the light setup the objects are drawn with, the
+   * default lighting if empty.
+   */
+  void setLightSetup(const std::string& lightSetup) {
+    setString("lightSetup", lightSetup);
+  }
+  std::string getLightSetup() const { return getString("lightSetup"); }
+
+  /** @brief Add an object to place in the scene */
+  void addObjectInstance(const SceneObjectInstance& objectInstance) {
+    objectInstances_.push_back(objectInstance);
+  }
+
+  /** @brief The objects to place in the scene, in creation order */
+  const std::vector<SceneObjectInstance>& getObjectInstances() const {
+    return objectInstances_;
+  }
+
+  /** @brief Remove all the objects */
+  void clearObjectInstances() { objectInstances_.clear(); }
+
+ protected:
+  std::vector<SceneObjectInstance> objectInstances_;
+
+ public:
+  ESP_SMART_POINTERS(SceneAttributes)
+};  // class SceneAttributes
+
+}  // namespace attributes
 }  // namespace metadata
 }  // namespace esp
 
@@ -5,6 +5,7 @@
 #include "ObjectAttributesManager.h"
 #include "AbstractObjectAttributesManagerBase.h"
 
+#include <Corrade/Utility/Directory.h>
 #include <Corrade/Utility/String.h>
 
 #include "esp/assets/Asset.h"
@@ -134,6 +135,16 @@ ObjectAttributes::ptr ObjectAttributesManager::loadFromJSONDoc(
       jsonConfig, "mass",
       std::bind(&ObjectAttributes::setMass, objAttributes, _1));
 
+  // The speeds below which the object may fall asleep
+  io::jsonIntoSetter<double>(
+      jsonConfig, "linear sleeping threshold",
+      std::bind(&ObjectAttributes::setLinearSleepingThreshold, objAttributes,
+                _1));
+  io::jsonIntoSetter<double>(
+      jsonConfig, "angular sleeping threshold",
+      std::bind(&ObjectAttributes::setAngularSleepingThreshold, objAttributes,
+                _1));
+
   // Use bounding box as collision object
   io::jsonIntoSetter<bool>(
       jsonConfig, "use bounding box for collision",
@@ -145,6 +156,20 @@ ObjectAttributes::ptr ObjectAttributesManager::loadFromJSONDoc(
       jsonConfig, "join collision meshes",
       std::bind(&ObjectAttributes::setJoinCollisionMeshes, objAttributes, _1));
 
+  // Decompose the collision mesh into convex hulls if specified
+  io::jsonIntoSetter<int>(
+      jsonConfig, "max convex hulls",
+      std::bind(&ObjectAttributes::setMaxConvexHulls, objAttributes, _1));
+  io::jsonIntoSetter<int>(
+      jsonConfig, "max hull vertices",
+      std::bind(&ObjectAttributes::setMaxHullVertices, objAttributes, _1));
+  std::string convexHullsHandle;
+  if (io::jsonIntoVal<std::string>(jsonConfig, "convex hulls",
+                                   convexHullsHandle)) {
+    objAttributes->setConvexHullsHandle(Cr::Utility::Directory::join(
+        objAttributes->getFileDirectory(), convexHullsHandle));
+  }
+
   // The object's interia matrix diagonal
   io::jsonIntoConstSetter<Magnum::Vector3>(
       jsonConfig, "inertia",
@@ -218,7 +243,7 @@ int ObjectAttributesManager::registerObjectFinalize(
     return ID_UNDEFINED;
   }
 
-  std::map<int, std::string>* mapToUse;
+  core::HandleIndex* mapToUse;
   // Handles for rendering and collision assets
   std::string renderAssetHandle = objectTemplate->getRenderAssetHandle();
   std::string collisionAssetHandle = objectTemplate->getCollisionAssetHandle();
@@ -274,6 +299,12 @@ int ObjectAttributesManager::registerObjectFinalize(
         objectTemplate->getRenderAssetIsPrimitive());
   }
 
+  // the metadata of a previous render asset may be stale
+  objectTemplate->setHasAssetMetadata(false);
+  if (!objectTemplate->getRenderAssetIsPrimitive()) {
+    loadAssetMetadata(objectTemplate);
+  }
+
   // Clear dirty flag from when asset handles are changed
   objectTemplate->setIsClean();
 
@@ -286,15 +317,77 @@ int ObjectAttributesManager::registerObjectFinalize(
   return objectTemplateID;
 }  // ObjectAttributesManager::registerObjectFinalize
 
+bool ObjectAttributesManager::loadAssetMetadata(
+    const ObjectAttributes::ptr& attributes) {
+  const std::string renderAssetHandle = attributes->getRenderAssetHandle();
+  const std::string metadataFile = assetMetadataFilename(renderAssetHandle);
+  io::JsonDocument jsonConfig;
+  if (!Cr::Utility::Directory::exists(metadataFile) ||
+      !this->verifyLoadJson(metadataFile, jsonConfig)) {
+    return false;
+  }
+  double assetSize = 0.0;
+  Magnum::Vector3 aabbMin, aabbMax;
+  int triangleCount = 0;
+  if (!io::jsonIntoVal<double>(jsonConfig, "asset size", assetSize) ||
+      assetSize != io::fileSize(renderAssetHandle) ||
+      !io::jsonIntoVal<Magnum::Vector3>(jsonConfig, "aabb min", aabbMin) ||
+      !io::jsonIntoVal<Magnum::Vector3>(jsonConfig, "aabb max", aabbMax) ||
+      !io::jsonIntoVal<int>(jsonConfig, "triangle count", triangleCount)) {
+    LOG(WARNING) << "ObjectAttributesManager::loadAssetMetadata : "
+                 << metadataFile << " is outdated or invalid, ignoring it.";
+    return false;
+  }
+  attributes->setRenderAssetAabb({aabbMin, aabbMax});
+  attributes->setRenderAssetTriangleCount(triangleCount);
+  attributes->setHasAssetMetadata(true);
+  return true;
+}  // ObjectAttributesManager::loadAssetMetadata
+
+bool ObjectAttributesManager::saveAssetMetadata(
+    const std::string& renderAssetHandle,
+    const Magnum::Range3D& aabb,
+    int triangleCount) {
+  io::JsonDocument jsonConfig{rapidjson::kObjectType};
+  io::JsonDocument::AllocatorType& allocator = jsonConfig.GetAllocator();
+  auto vec3 = [&allocator](const Magnum::Vector3& vector) {
+    rapidjson::Value array{rapidjson::kArrayType};
+    for (int i = 0; i < 3; ++i) {
+      array.PushBack(vector[i], allocator);
+    }
+    return array;
+  };
+  jsonConfig.AddMember(
+      "asset size",
+      static_cast<double>(io::fileSize(renderAssetHandle)), allocator);
+  jsonConfig.AddMember("aabb min", vec3(aabb.min()), allocator);
+  jsonConfig.AddMember("aabb max", vec3(aabb.max()), allocator);
+  jsonConfig.AddMember("triangle count", triangleCount, allocator);
+
+  const std::string metadataFile = assetMetadataFilename(renderAssetHandle);
+  if (!io::writeFileAtomically(metadataFile, io::jsonToString(jsonConfig))) {
+    LOG(WARNING) << "ObjectAttributesManager::saveAssetMetadata : Cannot "
+                    "write "
+                 << metadataFile;
+    return false;
+  }
+  return true;
+}  // ObjectAttributesManager::saveAssetMetadata
+
 std::vector<int> ObjectAttributesManager::loadAllFileBasedTemplates(
     const std::vector<std::string>& tmpltFilenames,
-    bool saveAsDefaults) {
+    bool saveAsDefaults,
+    int numThreads) {
   std::vector<int> resIDs(tmpltFilenames.size(), ID_UNDEFINED);
+  LOG(INFO) << "Loading " << tmpltFilenames.size()
+            << " file-based object templates";
+  const std::vector<ObjectAttributes::ptr> tmplts =
+      this->createObjectsFromFiles(tmpltFilenames, true, numThreads);
   for (int i = 0; i < tmpltFilenames.size(); ++i) {
-    auto objPhysPropertiesFilename = tmpltFilenames[i];
-    LOG(INFO) << "Loading file-based object template: "
-              << objPhysPropertiesFilename;
-    auto tmplt = this->createObjectFromFile(objPhysPropertiesFilename, true);
+    const ObjectAttributes::ptr& tmplt = tmplts[i];
+    if (nullptr == tmplt) {
+      continue;
+    }
 
     // save handles in list of defaults, so they are not removed, if desired.
     if (saveAsDefaults) {
@@ -310,7 +403,8 @@ std::vector<int> ObjectAttributesManager::loadAllFileBasedTemplates(
 
 std::vector<int> ObjectAttributesManager::loadObjectConfigs(
     const std::string& path,
-    bool saveAsDefaults) {
+    bool saveAsDefaults,
+    int numThreads) {
   std::vector<std::string> paths;
   std::vector<int> templateIndices;
   namespace Directory = Cr::Utility::Directory;
@@ -343,7 +437,8 @@ std::vector<int> ObjectAttributesManager::loadObjectConfigs(
     }
   }
   // build templates from aggregated paths
-  templateIndices = loadAllFileBasedTemplates(paths, saveAsDefaults);
+  templateIndices =
+      loadAllFileBasedTemplates(paths, saveAsDefaults, numThreads);
 
   return templateIndices;
 }  // ObjectAttributesManager::buildObjectConfigPaths
@@ -104,24 +104,64 @@ class ObjectAttributesManager
    * containing such files.
    * @param saveAsDefaults Set the templates loaded as undeleteable default
    * templates.
+   * @param numThreads The number of threads to parse the files on, 0 for all
+   * hardware threads. See @ref loadAllFileBasedTemplates().
    * @return A list of template indices for loaded valid object configs
    */
   std::vector<int> loadObjectConfigs(const std::string& path,
-                                     bool saveAsDefaults = false);
+                                     bool saveAsDefaults = false,
+                                     int numThreads = 0);
 
   /**
    * @brief Load all file-based object templates given string list of object
    * template file locations.
    *
    * This will take the list of file names currently specified in
-   * physicsManagerAttributes and load the referenced object templates.
+   * physicsManagerAttributes and load the referenced object templates. The
+   * files are parsed in parallel and the templates registered in the order of
+   * @p tmpltFilenames, see @ref createObjectsFromFiles().
    * @param tmpltFilenames list of file names of object templates
    * @param saveAsDefaults Set these templates as un-deletable from library.
-   * @return vector holding IDs of templates that have been added
+   * @param numThreads The number of threads to parse the files on, 0 for all
+   * hardware threads
+   * @return vector holding IDs of templates that have been added, or
+   * ID_UNDEFINED for the files that failed to load
    */
   std::vector<int> loadAllFileBasedTemplates(
       const std::vector<std::string>& tmpltFilenames,
-      bool saveAsDefaults);
+      bool saveAsDefaults,
+      int numThreads = 0);
+
+  /**
+   * @brief The file caching the asset metadata of the render asset @p
+   * renderAssetHandle next to it, see @ref loadAssetMetadata().
+   */
+  static std::string assetMetadataFilename(
+      const std::string& renderAssetHandle) {
+    return renderAssetHandle + ".metadata.json";
+  }
+
+  /**
+   * @brief Fill the asset metadata of @p attributes from the cache file of
+   * its render asset, see @ref Attrs::ObjectAttributes::setHasAssetMetadata().
+   * Called when a file-based template is registered.
+   * @return false if there is no cache file or it is outdated, the metadata
+   * is then computed when the render asset is first loaded.
+   */
+  bool loadAssetMetadata(const Attrs::ObjectAttributes::ptr& attributes);
+
+  /**
+   * @brief Write the asset metadata of the render asset @p renderAssetHandle
+   * to its cache file. The size of the asset file is recorded to detect an
+   * outdated cache.
+   * @param renderAssetHandle The render asset file.
+   * @param aabb The bounding box of the asset.
+   * @param triangleCount The number of triangles of the asset.
+   * @return whether the file was written.
+   */
+  static bool saveAssetMetadata(const std::string& renderAssetHandle,
+                                const Magnum::Range3D& aabb,
+                                int triangleCount);
 
   /**
    * @brief Check if currently configured primitive asset template library has
@@ -316,13 +356,13 @@ class ObjectAttributesManager
    * @brief Maps loaded object template IDs to the appropriate template
    * handles
    */
-  std::map<int, std::string> physicsFileObjTmpltLibByID_;
+  core::HandleIndex physicsFileObjTmpltLibByID_;
 
   /**
    * @brief Maps synthesized, primitive-based object template IDs to the
    * appropriate template handles
    */
-  std::map<int, std::string> physicsSynthObjTmpltLibByID_;
+  core::HandleIndex physicsSynthObjTmpltLibByID_;
 
  public:
   ESP_SMART_POINTERS(ObjectAttributesManager)
@@ -46,39 +46,86 @@ PhysicsManagerAttributes::ptr PhysicsAttributesManager::loadFromJSONDoc(
   PhysicsManagerAttributes::ptr physicsManagerAttributes =
       initNewObjectInternal(templateName);
 
-  // load the simulator preference - default is "none" simulator, set in
+  // read the values of the physics world in a single pass over the config
+  io::JsonObjectReader reader;
+  // the simulator preference - default is "none" simulator, set in
   // attributes ctor.
-  io::jsonIntoSetter<std::string>(
-      jsonConfig, "physics simulator",
+  reader.addSetter<std::string>(
+      "physics simulator",
       std::bind(&PhysicsManagerAttributes::setSimulator,
                 physicsManagerAttributes, _1));
-
-  // load the physics timestep
-  io::jsonIntoSetter<double>(jsonConfig, "timestep",
-                             std::bind(&PhysicsManagerAttributes::setTimestep,
-                                       physicsManagerAttributes, _1));
-
-  // load the max substeps between time step
-  io::jsonIntoSetter<int>(jsonConfig, "max substeps",
-                          std::bind(&PhysicsManagerAttributes::setMaxSubsteps,
-                                    physicsManagerAttributes, _1));
-  // load the friction coefficient
-  io::jsonIntoSetter<double>(
-      jsonConfig, "friction coefficient",
+  // the physics timestep
+  reader.addSetter<double>("timestep",
+                           std::bind(&PhysicsManagerAttributes::setTimestep,
+                                     physicsManagerAttributes, _1));
+  // the max substeps between time step
+  reader.addSetter<int>("max substeps",
+                        std::bind(&PhysicsManagerAttributes::setMaxSubsteps,
+                                  physicsManagerAttributes, _1));
+  // the friction coefficient
+  reader.addSetter<double>(
+      "friction coefficient",
       std::bind(&PhysicsManagerAttributes::setFrictionCoefficient,
                 physicsManagerAttributes, _1));
-
-  // load the restitution coefficient
-  io::jsonIntoSetter<double>(
-      jsonConfig, "restitution coefficient",
+  // the restitution coefficient
+  reader.addSetter<double>(
+      "restitution coefficient",
       std::bind(&PhysicsManagerAttributes::setRestitutionCoefficient,
                 physicsManagerAttributes, _1));
-
-  // load world gravity
-  io::jsonIntoConstSetter<Magnum::Vector3>(
-      jsonConfig, "gravity",
-      std::bind(&PhysicsManagerAttributes::setGravity, physicsManagerAttributes,
-                _1));
+  // the number of threads stepping the world
+  reader.addSetter<int>("num threads",
+                        std::bind(&PhysicsManagerAttributes::setNumThreads,
+                                  physicsManagerAttributes, _1));
+  // the task scheduler of a multi-threaded world
+  reader.addSetter<std::string>(
+      "task scheduler",
+      std::bind(&PhysicsManagerAttributes::setTaskScheduler,
+                physicsManagerAttributes, _1));
+  // whether stage BVHs are cached on disk
+  reader.addSetter<bool>(
+      "cache stage bvh",
+      std::bind(&PhysicsManagerAttributes::setCacheStageBvh,
+                physicsManagerAttributes, _1));
+  // the broadphase of the world and the padding of its bounds
+  reader.addSetter<std::string>(
+      "broadphase", std::bind(&PhysicsManagerAttributes::setBroadphase,
+                              physicsManagerAttributes, _1));
+  reader.addSetter<double>(
+      "world bounds padding",
+      std::bind(&PhysicsManagerAttributes::setWorldBoundsPadding,
+                physicsManagerAttributes, _1));
+  // the iterations of the constraint solver
+  reader.addSetter<int>(
+      "solver iterations",
+      std::bind(&PhysicsManagerAttributes::setSolverIterations,
+                physicsManagerAttributes, _1));
+  // the preallocated pools of the collision configuration
+  reader.addSetter<int>(
+      "manifold pool size",
+      std::bind(&PhysicsManagerAttributes::setManifoldPoolSize,
+                physicsManagerAttributes, _1));
+  reader.addSetter<int>(
+      "collision algorithm pool size",
+      std::bind(&PhysicsManagerAttributes::setCollisionAlgorithmPoolSize,
+                physicsManagerAttributes, _1));
+  // when settled objects fall asleep
+  reader.addSetter<double>(
+      "linear sleeping threshold",
+      std::bind(&PhysicsManagerAttributes::setLinearSleepingThreshold,
+                physicsManagerAttributes, _1));
+  reader.addSetter<double>(
+      "angular sleeping threshold",
+      std::bind(&PhysicsManagerAttributes::setAngularSleepingThreshold,
+                physicsManagerAttributes, _1));
+  reader.addSetter<double>(
+      "deactivation time",
+      std::bind(&PhysicsManagerAttributes::setDeactivationTime,
+                physicsManagerAttributes, _1));
+  // world gravity
+  reader.addConstSetter<Magnum::Vector3>(
+      "gravity", std::bind(&PhysicsManagerAttributes::setGravity,
+                           physicsManagerAttributes, _1));
+  reader.read(jsonConfig);
 
   // load the rigid object library metadata (no physics init yet...)
   if (jsonConfig.HasMember("rigid object paths") &&
@@ -0,0 +1,93 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SceneAttributesManager.h"
+
+#include "esp/io/json.h"
+
+using std::placeholders::_1;
+namespace esp {
+
+namespace metadata {
+
+using attributes::SceneAttributes;
+using attributes::SceneObjectInstance;
+namespace managers {
+
+SceneAttributes::ptr SceneAttributesManager::createObject(
+    const std::string& sceneInstanceFilename,
+    bool registerTemplate) {
+  SceneAttributes::ptr attrs;
+  std::string msg;
+  if (this->isValidFileName(sceneInstanceFilename)) {
+    attrs = this->createObjectFromFile(sceneInstanceFilename, registerTemplate);
+    msg = "File (" + sceneInstanceFilename + ") Based";
+  } else {
+    attrs = this->createDefaultObject(sceneInstanceFilename, registerTemplate);
+    msg = "File (" + sceneInstanceFilename + ") not found so new, default";
+  }
+
+  if (nullptr != attrs) {
+    LOG(INFO) << msg << " scene instance attributes created"
+              << (registerTemplate ? " and registered." : ".");
+  }
+  return attrs;
+}  // SceneAttributesManager::createObject
+
+SceneAttributes::ptr SceneAttributesManager::loadFromJSONDoc(
+    const std::string& templateName,
+    const io::JsonDocument& jsonConfig) {
+  SceneAttributes::ptr sceneAttributes = initNewObjectInternal(templateName);
+
+  io::jsonIntoSetter<std::string>(
+      jsonConfig, "lighting setup",
+      std::bind(&SceneAttributes::setLightSetup, sceneAttributes, _1));
+
+  io::JsonGenericValue::ConstMemberIterator instances =
+      jsonConfig.FindMember("object instances");
+  if (instances == jsonConfig.MemberEnd() || !instances->value.IsArray()) {
+    return sceneAttributes;
+  }
+
+  // one reader for all the instances, filling the current instance in a
+  // single pass over its members
+  SceneObjectInstance instance;
+  io::JsonObjectReader reader;
+  reader
+      .addSetter<std::string>(
+          "template name",
+          [&instance](std::string handle) {
+            instance.templateHandle = std::move(handle);
+          })
+      .addConstSetter<Magnum::Vector3>(
+          "translation",
+          [&instance](const Magnum::Vector3 translation) {
+            instance.translation = translation;
+          })
+      .addConstSetter<Magnum::Quaternion>(
+          "rotation",
+          [&instance](const Magnum::Quaternion rotation) {
+            instance.rotation = rotation;
+          })
+      .addSetter<std::string>("motion type", [&instance](std::string type) {
+        instance.motionType = std::move(type);
+      });
+
+  for (const auto& instanceConfig : instances->value.GetArray()) {
+    instance = SceneObjectInstance{};
+    reader.read(instanceConfig);
+    if (instance.templateHandle.empty()) {
+      LOG(ERROR) << "SceneAttributesManager::loadFromJSONDoc : Object "
+                    "instance without template name in "
+                 << templateName << ". Skipping.";
+      continue;
+    }
+    sceneAttributes->addObjectInstance(instance);
+  }
+  return sceneAttributes;
+}  // SceneAttributesManager::loadFromJSONDoc
+
+}  // namespace managers
+}  // namespace metadata
+}  // namespace esp
@@ -0,0 +1,140 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_METADATA_MANAGERS_SCENEATTRIBUTESMANAGER_H_
+#define ESP_METADATA_MANAGERS_SCENEATTRIBUTESMANAGER_H_
+
+/** @file
+ * @brief Class @ref esp::metadata::managers::SceneAttributesManager
+ */
+
+#include "AttributesManagerBase.h"
+
+#include "esp/metadata/attributes/SceneAttributes.h"
+
+namespace esp {
+namespace metadata {
+namespace managers {
+
+/**
+ * @brief Manages the @ref esp::metadata::attributes::SceneAttributes of scene
+ * instance files, which list the objects to place in a scene.
+ */
+class SceneAttributesManager
+    : public AttributesManager<Attrs::SceneAttributes> {
+ public:
+  explicit SceneAttributesManager(esp::assets::ResourceManager& resourceManager)
+      : AttributesManager<Attrs::SceneAttributes>::AttributesManager(
+            resourceManager,
+            "Scene Instance") {
+    buildCtorFuncPtrMaps();
+  }
+
+  /**
+   * @brief Creates an instance of a scene instance template described by
+   * passed string, the name of a scene instance file. If the file does not
+   * exist, an empty scene instance is created.
+   *
+   * If a template exists with this handle, this existing template will be
+   * overwritten with the newly created one if registerTemplate is true.
+   *
+   * @param sceneInstanceFilename The scene instance file to parse.
+   * @param registerTemplate whether to add this template to the library.
+   * @return a reference to the scene instance template.
+   */
+  Attrs::SceneAttributes::ptr createObject(
+      const std::string& sceneInstanceFilename,
+      bool registerTemplate = true) override;
+
+  /**
+   * @brief Parse passed JSON Document specifically for @ref
+   * esp::metadata::attributes::SceneAttributes object. It always returns a
+   * valid @ref esp::metadata::attributes::SceneAttributes shared_ptr object.
+   *
+   * Object instances without a template name are skipped.
+   *
+   * @param templateName the desired handle of the @ref
+   * esp::metadata::attributes::SceneAttributes.
+   * @param jsonConfig json document to parse
+   * @return a reference to the desired template.
+   */
+  Attrs::SceneAttributes::ptr loadFromJSONDoc(
+      const std::string& templateName,
+      const io::JsonDocument& jsonConfig) override;
+
+ protected:
+  /**
+   * @brief Scene instances do not reference primitive assets.
+   */
+  bool isValidPrimitiveAttributes(
+      CORRADE_UNUSED const std::string& handle) override {
+    return false;
+  }
+
+  /**
+   * @brief Used Internally.  Create and configure newly-created attributes with
+   * any default values, before any specific values are set.
+   *
+   * @param handleName handle name to be assigned to attributes
+   */
+  Attrs::SceneAttributes::ptr initNewObjectInternal(
+      const std::string& handleName) override {
+    auto newAttributes = Attrs::SceneAttributes::create(handleName);
+    this->setFileDirectoryFromHandle(newAttributes);
+    return newAttributes;
+  }
+
+  /**
+   * @brief Nothing to update on template removal.
+   *
+   * @param templateID the ID of the template to remove
+   * @param templateHandle the string key of the attributes desired.
+   */
+  void updateObjectHandleLists(
+      CORRADE_UNUSED int templateID,
+      CORRADE_UNUSED const std::string& templateHandle) override {}
+
+  /**
+   * @brief Add a copy of the @ref esp::metadata::attributes::SceneAttributes
+   * shared_ptr object to the @ref objectLibrary_.
+   *
+   * @param sceneAttributesTemplate The attributes template.
+   * @param sceneAttributesHandle The key for referencing the template in the
+   * @ref objectLibrary_.
+   * @return The index in the @ref objectLibrary_ of object
+   * template.
+   */
+  int registerObjectFinalize(
+      Attrs::SceneAttributes::ptr sceneAttributesTemplate,
+      const std::string& sceneAttributesHandle) override {
+    return this->addObjectToLibrary(sceneAttributesTemplate,
+                                    sceneAttributesHandle);
+  }  // SceneAttributesManager::registerObjectFinalize
+
+  /**
+   * @brief Any scene-attributes-specific resetting that needs to happen on
+   * reset.
+   */
+  void resetFinalize() override {}
+
+  /**
+   * @brief This function will assign the appropriately configured function
+   * pointer for the copy constructor as required by
+   * AttributesManager<SceneAttributes::ptr>
+   */
+  void buildCtorFuncPtrMaps() override {
+    this->copyConstructorMap_["SceneAttributes"] =
+        &SceneAttributesManager::createObjectCopy<Attrs::SceneAttributes>;
+  }  // SceneAttributesManager::buildCtorFuncPtrMaps
+
+ public:
+  ESP_SMART_POINTERS(SceneAttributesManager)
+
+};  // SceneAttributesManager
+
+}  // namespace managers
+}  // namespace metadata
+}  // namespace esp
+
+#endif  // ESP_METADATA_MANAGERS_SCENEATTRIBUTESMANAGER_H_
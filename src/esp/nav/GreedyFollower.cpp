@@ -1,8 +1,17 @@
 #include "esp/nav/GreedyFollower.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+
+#include <Corrade/Utility/Assert.h>
 #include <Magnum/EigenIntegration/GeometryIntegration.h>
 #include <Magnum/EigenIntegration/Integration.h>
 
+#include "esp/assets/MeshData.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/TaskScheduler.h"
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
 
@@ -34,12 +43,29 @@ GreedyGeodesicFollowerImpl::GreedyGeodesicFollowerImpl(
 
 float GreedyGeodesicFollowerImpl::geoDist(const Mn::Vector3& start,
                                           const Mn::Vector3& end) {
+  if (goalField_) {
+    return pathfinder_->geodesicDistance(*goalField_, cast<vec3f>(start));
+  }
   geoDistPath_.requestedStart = cast<vec3f>(start);
   geoDistPath_.requestedEnd = cast<vec3f>(end);
   pathfinder_->findPath(geoDistPath_);
   return geoDistPath_.geodesicDistance;
 }
 
+ShortestPath GreedyGeodesicFollowerImpl::pathTo(const Mn::Vector3& start,
+                                                const Mn::Vector3& end) {
+  ShortestPath path;
+  path.requestedStart = cast<vec3f>(start);
+  path.requestedEnd = cast<vec3f>(end);
+  if (goalField_) {
+    path.geodesicDistance =
+        pathfinder_->geodesicDistance(*goalField_, path.requestedStart);
+  } else {
+    pathfinder_->findPath(path);
+  }
+  return path;
+}
+
 GreedyGeodesicFollowerImpl::TryStepResult GreedyGeodesicFollowerImpl::tryStep(
     const scene::SceneNode& node,
     const Mn::Vector3& end) {
@@ -157,15 +183,34 @@ bool GreedyGeodesicFollowerImpl::isThrashing() {
 GreedyGeodesicFollowerImpl::CODES GreedyGeodesicFollowerImpl::nextActionAlong(
     const core::RigidState& start,
     const Mn::Vector3& end) {
-  ShortestPath path;
-  path.requestedStart = cast<vec3f>(start.translation);
-  path.requestedEnd = cast<vec3f>(end);
-  pathfinder_->findPath(path);
-
   CODES nextAction;
   if (fixThrashing_ && thrashingActions_.size() > 0) {
     nextAction = thrashingActions_.back();
     thrashingActions_.pop_back();
+    actions_.push_back(nextAction);
+    return actions_.back();
+  }
+
+  const ActionTable* table = actionTable(end);
+  const GeodesicDistanceField* const prevGoalField = goalField_;
+  if (table) {
+    goalField_ = table->goalField.get();
+  }
+  ShortestPath path = pathTo(start.translation, end);
+  if (table &&
+      path.geodesicDistance == std::numeric_limits<float>::infinity()) {
+    // the navmesh changed since the table was built
+    goalField_ = prevGoalField;
+    path = pathTo(start.translation, end);
+  }
+
+  const CODES tableAction = table && path.geodesicDistance >= goalDist_ &&
+                                    !(fixThrashing_ && isThrashing())
+                                ? table->lookup(start)
+                                : CODES::ERROR;
+  if (tableAction == CODES::FORWARD || tableAction == CODES::LEFT ||
+      tableAction == CODES::RIGHT) {
+    nextAction = tableAction;
   } else {
     const auto nextActions = nextBestPrimAlong(start, path);
     if (nextActions.size() == 0) {
@@ -178,6 +223,7 @@ GreedyGeodesicFollowerImpl::CODES GreedyGeodesicFollowerImpl::nextActionAlong(
       nextAction = nextActions[0];
     }
   }
+  goalField_ = prevGoalField;
 
   actions_.push_back(nextAction);
 
@@ -194,10 +240,7 @@ GreedyGeodesicFollowerImpl::findPath(const core::RigidState& start,
   do {
     core::RigidState state{findPathDummyNode_.rotation(),
                            findPathDummyNode_.MagnumObject::translation()};
-    ShortestPath path;
-    path.requestedStart = cast<vec3f>(state.translation);
-    path.requestedEnd = cast<vec3f>(end);
-    pathfinder_->findPath(path);
+    const ShortestPath path = pathTo(state.translation, end);
     const auto nextPrim = nextBestPrimAlong(state, path);
     if (nextPrim.size() == 0) {
       actions_.emplace_back(CODES::ERROR);
@@ -236,6 +279,249 @@ GreedyGeodesicFollowerImpl::findPath(const core::RigidState& start,
   return actions_;
 }
 
+std::vector<std::vector<GreedyGeodesicFollowerImpl::CODES>>
+GreedyGeodesicFollowerImpl::findPathsBatch(
+    const std::vector<core::RigidState>& starts,
+    const std::vector<Mn::Vector3>& ends,
+    int numThreads) {
+  CORRADE_ASSERT(starts.size() == ends.size(),
+                 "GreedyGeodesicFollowerImpl::findPathsBatch(): expected as "
+                 "many ends as starts",
+                 {});
+
+  // one distance field per distinct end location
+  std::map<std::array<float, 3>, size_t> goalIndices;
+  std::vector<vec3f> goals;
+  std::vector<size_t> endGoals(ends.size());
+  for (size_t i = 0; i < ends.size(); ++i) {
+    const std::array<float, 3> key{{ends[i].x(), ends[i].y(), ends[i].z()}};
+    auto inserted = goalIndices.emplace(key, goals.size());
+    if (inserted.second) {
+      goals.emplace_back(cast<vec3f>(ends[i]));
+    }
+    endGoals[i] = inserted.first->second;
+  }
+  std::vector<GeodesicDistanceField::ptr> goalFields(goals.size());
+  pathfinder_->parallelFor(goals.size(), numThreads, [&](size_t i, int) {
+    goalFields[i] = pathfinder_->buildGeodesicDistanceField({goals[i]});
+  });
+
+  numThreads = core::TaskScheduler::global().concurrency(starts.size(),
+                                                         numThreads);
+  // the dummy nodes and the action history are per follower, so every worker
+  // needs its own
+  std::vector<std::unique_ptr<GreedyGeodesicFollowerImpl>> workers(numThreads);
+  std::vector<std::vector<CODES>> paths(starts.size());
+  pathfinder_->parallelFor(starts.size(), numThreads, [&](size_t i,
+                                                          int threadIndex) {
+    std::unique_ptr<GreedyGeodesicFollowerImpl>& follower =
+        workers[threadIndex];
+    if (!follower) {
+      follower.reset(new GreedyGeodesicFollowerImpl{
+          pathfinder_, moveForward_, turnLeft_, turnRight_, goalDist_,
+          forwardAmount_, turnAmount_, fixThrashing_, thrashingThreshold_});
+    }
+    follower->reset();
+    // a failed field falls back to searching the paths
+    follower->goalField_ = goalFields[endGoals[i]].get();
+    paths[i] = follower->findPath(starts[i], ends[i]);
+  });
+
+  return paths;
+}
+
+bool GreedyGeodesicFollowerImpl::precomputeActions(const Mn::Vector3& end,
+                                                   float cellSize,
+                                                   int numThreads) {
+  CORRADE_ASSERT(cellSize > 0.0f,
+                 "GreedyGeodesicFollowerImpl::precomputeActions(): expected a "
+                 "positive cell size",
+                 false);
+  core::ScopedTraceEvent trace{"GreedyGeodesicFollowerImpl::precomputeActions",
+                               "nav"};
+  const assets::MeshData::ptr navMesh = pathfinder_->getNavMeshData();
+  if (!navMesh || navMesh->ibo.empty()) {
+    LOG(ERROR) << "GreedyGeodesicFollowerImpl::precomputeActions : no navmesh "
+                  "loaded";
+    return false;
+  }
+
+  std::unique_ptr<ActionTable> table{new ActionTable};
+  table->goalField =
+      pathfinder_->buildGeodesicDistanceField({cast<vec3f>(end)});
+  if (!table->goalField || pathfinder_->geodesicDistance(
+                               *table->goalField, cast<vec3f>(end)) ==
+                               std::numeric_limits<float>::infinity()) {
+    LOG(ERROR) << "GreedyGeodesicFollowerImpl::precomputeActions : the end "
+                  "location is not on the navmesh";
+    return false;
+  }
+
+  const std::pair<vec3f, vec3f> bounds = pathfinder_->bounds();
+  table->cellSize = cellSize;
+  table->originX = bounds.first[0] + 0.5f * cellSize;
+  table->originZ = bounds.first[2] + 0.5f * cellSize;
+  table->width = std::max(
+      1, int(std::ceil((bounds.second[0] - bounds.first[0]) / cellSize)));
+  table->height = std::max(
+      1, int(std::ceil((bounds.second[2] - bounds.first[2]) / cellSize)));
+  table->numHeadings =
+      std::max(1, int(std::round(2.0 * M_PI / turnAmount_)));
+
+  // rasterize the navmesh triangles onto the cell centers, one sample per
+  // cell and surface
+  std::vector<std::pair<uint32_t, float>> samples;
+  const std::vector<vec3f>& vbo = navMesh->vbo;
+  for (size_t i = 0; i + 2 < navMesh->ibo.size(); i += 3) {
+    const vec3f& a = vbo[navMesh->ibo[i]];
+    const vec3f& b = vbo[navMesh->ibo[i + 1]];
+    const vec3f& c = vbo[navMesh->ibo[i + 2]];
+    const float area =
+        (b[0] - a[0]) * (c[2] - a[2]) - (c[0] - a[0]) * (b[2] - a[2]);
+    if (std::abs(area) < 1e-12f) {
+      continue;
+    }
+    const auto cellRange = [&](float lo, float hi, float origin, int size) {
+      return std::make_pair(
+          std::max(0, int(std::ceil((lo - origin) / cellSize))),
+          std::min(size - 1, int(std::floor((hi - origin) / cellSize))));
+    };
+    const auto ws = cellRange(std::min({a[0], b[0], c[0]}),
+                              std::max({a[0], b[0], c[0]}), table->originX,
+                              table->width);
+    const auto hs = cellRange(std::min({a[2], b[2], c[2]}),
+                              std::max({a[2], b[2], c[2]}), table->originZ,
+                              table->height);
+    for (int h = hs.first; h <= hs.second; ++h) {
+      const float z = table->originZ + h * cellSize;
+      for (int w = ws.first; w <= ws.second; ++w) {
+        const float x = table->originX + w * cellSize;
+        const float u =
+            ((c[0] - x) * (a[2] - z) - (a[0] - x) * (c[2] - z)) / area;
+        const float v =
+            ((a[0] - x) * (b[2] - z) - (b[0] - x) * (a[2] - z)) / area;
+        if (u < 0.0f || v < 0.0f || u + v > 1.0f) {
+          continue;
+        }
+        const float y = a[1] + u * (b[1] - a[1]) + v * (c[1] - a[1]);
+        samples.emplace_back(h * table->width + w, y);
+      }
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+
+  // triangles sharing an edge or stacked in the detail mesh sample the same
+  // surface
+  constexpr float maxSurfaceDelta = 0.1f;
+  table->cellOffsets.assign(table->width * table->height + 1, 0);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    if (i > 0 && samples[i].first == samples[i - 1].first &&
+        samples[i].second - table->heights.back() < maxSurfaceDelta) {
+      continue;
+    }
+    table->heights.push_back(samples[i].second);
+    ++table->cellOffsets[samples[i].first + 1];
+  }
+  for (size_t i = 1; i < table->cellOffsets.size(); ++i) {
+    table->cellOffsets[i] += table->cellOffsets[i - 1];
+  }
+
+  const size_t numSamples = table->heights.size();
+  std::vector<Mn::Vector3> positions(numSamples);
+  for (size_t cell = 0; cell + 1 < table->cellOffsets.size(); ++cell) {
+    for (uint32_t j = table->cellOffsets[cell];
+         j < table->cellOffsets[cell + 1]; ++j) {
+      positions[j] = {table->originX + (cell % table->width) * cellSize,
+                      table->heights[j],
+                      table->originZ + (cell / table->width) * cellSize};
+    }
+  }
+
+  table->actions.assign(numSamples * table->numHeadings, CODES::ERROR);
+  numThreads =
+      core::TaskScheduler::global().concurrency(numSamples, numThreads);
+  // the dummy nodes are per follower, so every worker needs its own
+  std::vector<std::unique_ptr<GreedyGeodesicFollowerImpl>> workers(numThreads);
+  pathfinder_->parallelFor(numSamples, numThreads, [&](size_t i,
+                                                       int threadIndex) {
+    std::unique_ptr<GreedyGeodesicFollowerImpl>& follower =
+        workers[threadIndex];
+    if (!follower) {
+      follower.reset(new GreedyGeodesicFollowerImpl{
+          pathfinder_, moveForward_, turnLeft_, turnRight_, goalDist_,
+          forwardAmount_, turnAmount_, fixThrashing_, thrashingThreshold_});
+      follower->goalField_ = table->goalField.get();
+    }
+    const ShortestPath path = follower->pathTo(positions[i], end);
+    for (int k = 0; k < table->numHeadings; ++k) {
+      const core::RigidState state{
+          Mn::Quaternion::rotation(
+              Mn::Rad{float(2.0 * M_PI * k / table->numHeadings)},
+              Mn::Vector3::yAxis()),
+          positions[i]};
+      const auto prim = follower->nextBestPrimAlong(state, path);
+      if (!prim.empty()) {
+        table->actions[i * table->numHeadings + k] = prim[0];
+      }
+    }
+  });
+
+  actionTables_[{{end.x(), end.y(), end.z()}}] = std::move(table);
+  return true;
+}
+
+bool GreedyGeodesicFollowerImpl::hasPrecomputedActions(
+    const Mn::Vector3& end) const {
+  return actionTable(end) != nullptr;
+}
+
+void GreedyGeodesicFollowerImpl::clearPrecomputedActions() {
+  actionTables_.clear();
+}
+
+const GreedyGeodesicFollowerImpl::ActionTable*
+GreedyGeodesicFollowerImpl::actionTable(const Mn::Vector3& end) const {
+  if (actionTables_.empty()) {
+    return nullptr;
+  }
+  auto found = actionTables_.find({{end.x(), end.y(), end.z()}});
+  return found == actionTables_.end() ? nullptr : found->second.get();
+}
+
+GreedyGeodesicFollowerImpl::CODES
+GreedyGeodesicFollowerImpl::ActionTable::lookup(
+    const core::RigidState& state) const {
+  const int w = int(std::round((state.translation.x() - originX) / cellSize));
+  const int h = int(std::round((state.translation.z() - originZ) / cellSize));
+  if (w < 0 || w >= width || h < 0 || h >= height) {
+    return CODES::ERROR;
+  }
+
+  // the closest surface within the height isNavigable() allows
+  const int cell = h * width + w;
+  int sample = -1;
+  float bestDelta = 0.5f;
+  for (uint32_t i = cellOffsets[cell]; i < cellOffsets[cell + 1]; ++i) {
+    const float delta = std::abs(state.translation.y() - heights[i]);
+    if (delta <= bestDelta) {
+      bestDelta = delta;
+      sample = i;
+    }
+  }
+  if (sample < 0) {
+    return CODES::ERROR;
+  }
+
+  const Mn::Vector3 forward =
+      state.rotation.transformVector({0.0f, 0.0f, -1.0f});
+  const float heading = std::atan2(-forward.x(), -forward.z());
+  int bin = int(std::round(heading * numHeadings / (2.0 * M_PI))) % numHeadings;
+  if (bin < 0) {
+    bin += numHeadings;
+  }
+  return actions[sample * numHeadings + bin];
+}
+
 GreedyGeodesicFollowerImpl::CODES GreedyGeodesicFollowerImpl::nextActionAlong(
     const Mn::Quaternion& currentRot,
     const Mn::Vector3& currentPos,
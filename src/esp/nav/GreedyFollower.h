@@ -5,6 +5,11 @@
 #ifndef ESP_NAV_GREEDYFOLLOWER_H_
 #define ESP_NAV_GREEDYFOLLOWER_H_
 
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
 #include "esp/core/RigidState.h"
 #include "esp/core/esp.h"
 #include "esp/nav/PathFinder.h"
@@ -112,6 +117,71 @@ class GreedyGeodesicFollowerImpl {
   std::vector<CODES> findPath(const core::RigidState& start,
                               const Magnum::Vector3& end);
 
+  /**
+   * @brief Finds the full paths of many start states and end locations in
+   * parallel
+   *
+   * Same as calling @ref reset and @ref findPath for each pair, but the pairs
+   * are distributed over @p numThreads worker threads of @ref
+   * PathFinder::parallelFor, each planning on its own copy of this follower.
+   * The geodesic distances are looked up in a @ref GeodesicDistanceField per
+   * distinct end location instead of searching a path each time.
+   *
+   * The move functions are called concurrently from the worker threads.
+   * Python move functions are serialized by the GIL, so only the planning
+   * itself runs in parallel then. The state of this follower is not changed.
+   *
+   * @param[in] starts The starting states
+   * @param[in] ends The end locations, same count as @p starts
+   * @param[in] numThreads The number of worker threads, including the calling
+   * one. If zero or less, the number of hardware threads is used.
+   *
+   * @return The actions of each pair, empty where @ref findPath fails
+   */
+  std::vector<std::vector<CODES>> findPathsBatch(
+      const std::vector<core::RigidState>& starts,
+      const std::vector<Magnum::Vector3>& ends,
+      int numThreads = 0);
+
+  /**
+   * @brief Precompute the next action toward @p end over a grid of states
+   *
+   * The best action is planned for the center of every cell of a grid of
+   * @p cellSize over the navmesh, on each surface of a multi-level navmesh,
+   * and for every multiple of the turn amount as heading, with the geodesic
+   * distances looked up in a @ref GeodesicDistanceField of @p end. The
+   * planning is distributed over @p numThreads worker threads like in @ref
+   * findPathsBatch, which calls the move functions from them.
+   *
+   * Afterwards, @ref nextActionAlong toward @p end looks the action up at the
+   * cell of the state and its closest heading. It still plans, looking the
+   * distances up in the field, for states off the grid, for cells within
+   * the goal distance while the state isn't, and to break thrashing. A table
+   * is kept per goal until @ref clearPrecomputedActions(). Once the navmesh
+   * changes the field no longer reaches the goal, and the planning falls
+   * back to path queries.
+   *
+   * @param[in] end The end location
+   * @param[in] cellSize The size of a grid cell in meters
+   * @param[in] numThreads The number of worker threads, including the calling
+   * one. If zero or less, the number of hardware threads is used.
+   *
+   * @return Whether the table was built
+   */
+  bool precomputeActions(const Magnum::Vector3& end,
+                         float cellSize = 0.1f,
+                         int numThreads = 0);
+
+  /**
+   * @brief Whether @ref precomputeActions was called for @p end
+   */
+  bool hasPrecomputedActions(const Magnum::Vector3& end) const;
+
+  /**
+   * @brief Discard the tables of @ref precomputeActions
+   */
+  void clearPrecomputedActions();
+
   /**
    * @brief Reset the planner.
    *
@@ -138,9 +208,42 @@ class GreedyGeodesicFollowerImpl {
       rightDummyNode_{dummyScene_.getRootNode()},
       tryStepDummyNode_{dummyScene_.getRootNode()};
 
+  //! Distances to the end location, if set geodesic distances are looked up
+  //! in it instead of searching a path, see findPathsBatch()
+  const GeodesicDistanceField* goalField_ = nullptr;
+
+  //! The next action of the states of a grid, see precomputeActions()
+  struct ActionTable {
+    GeodesicDistanceField::ptr goalField;
+    float cellSize;
+    //! center of cell (0, 0)
+    float originX, originZ;
+    int width, height;
+    //! the headings are the multiples of 2 pi / numHeadings
+    int numHeadings;
+    //! the samples of cell h * width + w are [cellOffsets[i], ..[i + 1])
+    std::vector<uint32_t> cellOffsets;
+    std::vector<float> heights;
+    //! numHeadings actions per sample
+    std::vector<CODES> actions;
+
+    //! The action at the sample of @p state, ERROR if off the grid
+    CODES lookup(const core::RigidState& state) const;
+  };
+
+  //! by end location
+  std::map<std::array<float, 3>, std::unique_ptr<ActionTable>> actionTables_;
+
+  //! The table of @p end, nullptr if there is none
+  const ActionTable* actionTable(const Magnum::Vector3& end) const;
+
   ShortestPath geoDistPath_;
   float geoDist(const Magnum::Vector3& start, const Magnum::Vector3& end);
 
+  //! The geodesic distance of the path from @p start to @p end, and its
+  //! points unless goalField_ is set
+  ShortestPath pathTo(const Magnum::Vector3& start, const Magnum::Vector3& end);
+
   struct TryStepResult {
     float postGeodesicDistance, postDistanceToClosestObstacle;
     bool didCollide;
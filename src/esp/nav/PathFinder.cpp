@@ -3,9 +3,20 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "PathFinder.h"
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <cfloat>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
 #include <numeric>
+#include <queue>
 #include <stack>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Vector3.h>
@@ -14,15 +25,26 @@
 #include <Magnum/EigenIntegration/Integration.h>
 
 #include <Corrade/Containers/Optional.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/configure.h>
 
 #include <cstdio>
+#ifdef CORRADE_TARGET_UNIX
+#include <sys/mman.h>
+#endif
+#include <sys/stat.h>
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <limits>
 
 #include "esp/assets/MeshData.h"
+#include "esp/core/Compression.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/TaskScheduler.h"
 #include "esp/core/esp.h"
+#include "esp/core/random.h"
 
+#include "DetourCommon.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshBuilder.h"
 #include "DetourNavMeshQuery.h"
@@ -61,6 +83,99 @@ const std::vector<vec3f>& MultiGoalShortestPath::getRequestedEnds() const {
   return pimpl_->requestedEnds;
 }
 
+struct GeodesicDistanceField::Impl {
+  std::vector<vec3f> goals;
+
+  //! the navmesh the field was built on, see PathFinder::Impl
+  uint32_t navMeshVersion = 0;
+
+  //! dense indices of the walkable polygons
+  std::unordered_map<dtPolyRef, uint32_t> polyIndices;
+
+  //! positions of the portal samples and their distance to the closest goal
+  std::vector<vec3f> samplePoints;
+  std::vector<float> sampleDistances;
+
+  //! samples on the boundary of polygon i are
+  //! polySamples[polySampleOffsets[i], polySampleOffsets[i + 1])
+  std::vector<uint32_t> polySampleOffsets;
+  std::vector<uint32_t> polySamples;
+  //! the two polygons of each sample
+  std::vector<std::array<uint32_t, 2>> samplePolys;
+
+  //! snapped goals, by the polygon they are in
+  std::unordered_multimap<uint32_t, vec3f> polyGoals;
+
+  //! Dijkstra from all of @p sources, snapped points by their polygon, at
+  //! once, along straight segments inside polygons
+  void propagate(const std::vector<std::pair<uint32_t, vec3f>>& sources,
+                 std::vector<float>& distances) const;
+
+  //! The distance of a snapped point of a polygon over the samples on its
+  //! boundary, without the sources inside the polygon
+  float distanceThroughSamples(const std::vector<float>& distances,
+                               uint32_t polyIndex,
+                               const vec3f& polyPt) const;
+};
+
+void GeodesicDistanceField::Impl::propagate(
+    const std::vector<std::pair<uint32_t, vec3f>>& sources,
+    std::vector<float>& distances) const {
+  distances.assign(samplePoints.size(),
+                   std::numeric_limits<float>::infinity());
+  using QueueItem = std::pair<float, uint32_t>;
+  std::priority_queue<QueueItem, std::vector<QueueItem>,
+                      std::greater<QueueItem>>
+      queue;
+  auto relaxPoly = [&](uint32_t polyIndex, const vec3f& from, float distance) {
+    for (uint32_t i = polySampleOffsets[polyIndex];
+         i < polySampleOffsets[polyIndex + 1]; ++i) {
+      const uint32_t sample = polySamples[i];
+      const float newDistance = distance + (samplePoints[sample] - from).norm();
+      if (newDistance < distances[sample]) {
+        distances[sample] = newDistance;
+        queue.emplace(newDistance, sample);
+      }
+    }
+  };
+
+  for (const std::pair<uint32_t, vec3f>& source : sources) {
+    relaxPoly(source.first, source.second, 0.0f);
+  }
+
+  while (!queue.empty()) {
+    const QueueItem item = queue.top();
+    queue.pop();
+    if (item.first > distances[item.second])
+      continue;
+    const vec3f& from = samplePoints[item.second];
+    for (uint32_t polyIndex : samplePolys[item.second]) {
+      relaxPoly(polyIndex, from, item.first);
+    }
+  }
+}
+
+float GeodesicDistanceField::Impl::distanceThroughSamples(
+    const std::vector<float>& distances,
+    uint32_t polyIndex,
+    const vec3f& polyPt) const {
+  float distance = std::numeric_limits<float>::infinity();
+  for (uint32_t i = polySampleOffsets[polyIndex];
+       i < polySampleOffsets[polyIndex + 1]; ++i) {
+    const uint32_t sample = polySamples[i];
+    distance = std::min(
+        distance, distances[sample] + (samplePoints[sample] - polyPt).norm());
+  }
+  return distance;
+}
+
+GeodesicDistanceField::GeodesicDistanceField()
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {}
+
+const std::vector<vec3f>& GeodesicDistanceField::getGoals() const {
+  return pimpl_->goals;
+}
+
 namespace {
 template <typename T>
 std::tuple<dtStatus, dtPolyRef, vec3f> projectToPoly(
@@ -92,15 +207,23 @@ namespace impl {
 // are connected This gives O(1) lookup for if a path between two polygons
 // exists or not
 // Takes O(npolys) to construct
+//
+// The island ids are stored in a flat array indexed by the tile and polygon
+// index decoded from a dtPolyRef, so lookups don't hash.
 class IslandSystem {
  public:
-  IslandSystem(const dtNavMesh* navMesh, const dtQueryFilter* filter) {
+  static constexpr uint32_t NoIsland = ~uint32_t{0};
+
+  IslandSystem(const dtNavMesh* navMesh, const dtQueryFilter* filter)
+      : navMesh_{navMesh} {
+    allocate();
+
     std::vector<vec3f> islandVerts;
 
     // Iterate over all tiles
     for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
       const dtMeshTile* tile = navMesh->getTile(iTile);
-      if (!tile)
+      if (!tile || !tile->header)
         continue;
 
       // Iterate over all polygons in a tile
@@ -111,7 +234,7 @@ class IslandSystem {
         // If the polygon ref is valid, and we haven't seen it yet,
         // start connected component analysis from this polygon
         if (navMesh->isValidPolyRef(startRef) &&
-            (polyToIsland_.find(startRef) == polyToIsland_.end())) {
+            (islandId(startRef) == NoIsland)) {
           uint32_t newIslandId = islandRadius_.size();
           expandFrom(navMesh, filter, newIslandId, startRef, islandVerts);
 
@@ -137,27 +260,168 @@ class IslandSystem {
   inline bool hasConnection(dtPolyRef startRef, dtPolyRef endRef) const {
     // If both polygons are on the same island, there must be a path between
     // them
-    auto itStart = polyToIsland_.find(startRef);
-    if (itStart == polyToIsland_.end())
+    const uint32_t startIsland = islandId(startRef);
+    if (startIsland == NoIsland)
       return false;
 
-    auto itEnd = polyToIsland_.find(endRef);
-    if (itEnd == polyToIsland_.end())
-      return false;
+    return startIsland == islandId(endRef);
+  }
 
-    return itStart->second == itEnd->second;
+  inline uint32_t islandId(dtPolyRef ref) const {
+    const uint32_t* slot = islandIdSlot(ref);
+    return slot ? *slot : NoIsland;
   }
 
+  inline uint32_t numIslands() const { return islandRadius_.size(); }
+
   inline float islandRadius(dtPolyRef ref) const {
-    auto itRef = polyToIsland_.find(ref);
-    if (itRef == polyToIsland_.end())
+    const uint32_t island = islandId(ref);
+    if (island == NoIsland)
       return 0.0;
 
-    return islandRadius_[itRef->second];
+    return islandRadius_[island];
+  }
+
+  /**
+   * @brief Append the islands to a navmesh file, after the tiles written by
+   * PathFinder::Impl::saveNavMesh()
+   */
+  bool write(FILE* fp) const {
+    IslandsHeader header;
+    header.magic = ISLANDS_MAGIC;
+    header.version = ISLANDS_VERSION;
+    header.numIslands = islandRadius_.size();
+    header.numTiles = 0;
+    for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh_->getTile(iTile);
+      if (tile && tile->header && tile->dataSize)
+        ++header.numTiles;
+    }
+    if (fwrite(&header, sizeof(header), 1, fp) != 1)
+      return false;
+
+    for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh_->getTile(iTile);
+      if (!tile || !tile->header || !tile->dataSize)
+        continue;
+      const int tileHeader[2] = {iTile, tile->header->polyCount};
+      if (fwrite(tileHeader, sizeof(tileHeader), 1, fp) != 1 ||
+          fwrite(polyIslands_.data() + tileOffsets_[iTile], sizeof(uint32_t),
+                 tile->header->polyCount,
+                 fp) != size_t(tile->header->polyCount))
+        return false;
+    }
+
+    return fwrite(islandRadius_.data(), sizeof(float), islandRadius_.size(),
+                  fp) == islandRadius_.size();
+  }
+
+  /**
+   * @brief Read islands written by @ref write()
+   *
+   * @return nullptr if the file has no islands, e.g. because it was written
+   * by an older version, or they don't match @p navMesh
+   */
+  static std::unique_ptr<IslandSystem> read(FILE* fp,
+                                            const dtNavMesh* navMesh) {
+    IslandsHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != ISLANDS_MAGIC || header.version != ISLANDS_VERSION)
+      return nullptr;
+
+    // the counts of a corrupt file would size huge allocations, they have to
+    // fit what is left of the file
+    const long offset = ftell(fp);
+    if (offset < 0 || fseek(fp, 0, SEEK_END) != 0)
+      return nullptr;
+    const long fileEnd = ftell(fp);
+    if (fileEnd < offset || fseek(fp, offset, SEEK_SET) != 0)
+      return nullptr;
+    const uint64_t remaining = uint64_t(fileEnd - offset);
+    if (header.numIslands < 0 || header.numTiles < 0 ||
+        header.numTiles > navMesh->getMaxTiles() ||
+        uint64_t(header.numTiles) * 2 * sizeof(int) +
+                uint64_t(header.numIslands) * sizeof(float) >
+            remaining)
+      return nullptr;
+
+    std::unique_ptr<IslandSystem> islands{new IslandSystem{navMesh}};
+    islands->allocate();
+    for (int i = 0; i < header.numTiles; ++i) {
+      int tileHeader[2];
+      if (fread(tileHeader, sizeof(tileHeader), 1, fp) != 1)
+        return nullptr;
+      const int iTile = tileHeader[0];
+      const int polyCount = tileHeader[1];
+      if (iTile < 0 || iTile >= navMesh->getMaxTiles())
+        return nullptr;
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (!tile || !tile->header || tile->header->polyCount != polyCount)
+        return nullptr;
+      if (fread(islands->polyIslands_.data() + islands->tileOffsets_[iTile],
+                sizeof(uint32_t), polyCount, fp) != size_t(polyCount))
+        return nullptr;
+    }
+
+    islands->islandRadius_.resize(header.numIslands);
+    if (fread(islands->islandRadius_.data(), sizeof(float), header.numIslands,
+              fp) != size_t(header.numIslands))
+      return nullptr;
+
+    for (uint32_t island : islands->polyIslands_) {
+      if (island != NoIsland && island >= islands->islandRadius_.size())
+        return nullptr;
+    }
+
+    return islands;
   }
 
  private:
-  std::unordered_map<dtPolyRef, uint32_t> polyToIsland_;
+  static constexpr int ISLANDS_MAGIC =
+      'I' << 24 | 'S' << 16 | 'L' << 8 | 'D';  //'ISLD';
+  static constexpr int ISLANDS_VERSION = 1;
+
+  struct IslandsHeader {
+    int magic;
+    int version;
+    int numIslands;
+    int numTiles;
+  };
+
+  explicit IslandSystem(const dtNavMesh* navMesh) : navMesh_{navMesh} {}
+
+  //! size the flat array for the tiles of navMesh_, all without an island
+  void allocate() {
+    tileOffsets_.assign(navMesh_->getMaxTiles() + 1, 0);
+    for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh_->getTile(iTile);
+      const int polyCount = tile && tile->header ? tile->header->polyCount : 0;
+      tileOffsets_[iTile + 1] = tileOffsets_[iTile] + polyCount;
+    }
+    polyIslands_.assign(tileOffsets_.back(), NoIsland);
+  }
+
+  inline uint32_t* islandIdSlot(dtPolyRef ref) {
+    return const_cast<uint32_t*>(
+        const_cast<const IslandSystem*>(this)->islandIdSlot(ref));
+  }
+
+  inline const uint32_t* islandIdSlot(dtPolyRef ref) const {
+    if (!ref)
+      return nullptr;
+    unsigned int salt, iTile, iPoly;
+    navMesh_->decodePolyId(ref, salt, iTile, iPoly);
+    if (iTile >= tileOffsets_.size() - 1 ||
+        iPoly >= tileOffsets_[iTile + 1] - tileOffsets_[iTile] ||
+        navMesh_->getTile(iTile)->salt != salt)
+      return nullptr;
+    return &polyIslands_[tileOffsets_[iTile] + iPoly];
+  }
+
+  const dtNavMesh* navMesh_;
+  //! islands of the polygons of tile i are polyIslands_[tileOffsets_[i], ..)
+  std::vector<uint32_t> tileOffsets_;
+  std::vector<uint32_t> polyIslands_;
   std::vector<float> islandRadius_;
 
   void expandFrom(const dtNavMesh* navMesh,
@@ -165,7 +429,7 @@ class IslandSystem {
                   const uint32_t newIslandId,
                   const dtPolyRef& startRef,
                   std::vector<vec3f>& islandVerts) {
-    polyToIsland_.emplace(startRef, newIslandId);
+    *islandIdSlot(startRef) = newIslandId;
     islandVerts.clear();
 
     // Force std::stack to be implemented via an std::vector as linked
@@ -192,7 +456,8 @@ class IslandSystem {
            iLink = tile->links[iLink].next) {
         dtPolyRef neighbourRef = tile->links[iLink].ref;
         // If we've already visited this poly, skip it!
-        if (polyToIsland_.find(neighbourRef) != polyToIsland_.end())
+        uint32_t* neighbourIsland = islandIdSlot(neighbourRef);
+        if (!neighbourIsland || *neighbourIsland != NoIsland)
           continue;
 
         const dtMeshTile* neighbourTile = 0;
@@ -204,14 +469,263 @@ class IslandSystem {
         if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
           continue;
 
-        polyToIsland_.emplace(neighbourRef, newIslandId);
+        *neighbourIsland = newIslandId;
         stack.push(neighbourRef);
       }
     }
   }
 };
+
+constexpr uint32_t IslandSystem::NoIsland;
+constexpr int IslandSystem::ISLANDS_MAGIC;
+constexpr int IslandSystem::ISLANDS_VERSION;
+
+// Clusters of the polygons in the cells of a grid over the navmesh, every
+// connected part of a cell being a cluster, and the graph of the clusters
+// sharing a polygon edge. Long paths are searched in the graph first, which
+// has a node per cluster instead of per polygon, and then refined by Detour
+// in short segments along the corridor of clusters, so their cost grows with
+// the length of the path instead of the size of the navmesh. The clusters of
+// one cell on different floors are not connected, so stay apart.
+class PathHierarchy {
+ public:
+  static constexpr uint32_t NoCluster = ~uint32_t{0};
+
+  //! A crossing from one cluster into a neighbouring one
+  struct Edge {
+    uint32_t to;
+    //! through the portal, from center to center
+    float cost;
+    //! the midpoint of a polygon edge on the border, and that polygon
+    vec3f portal;
+    dtPolyRef portalRef;
+  };
+
+  PathHierarchy(const dtNavMesh* navMesh,
+                const dtQueryFilter* filter,
+                float clusterSize)
+      : navMesh_{navMesh}, clusterSize_{clusterSize} {
+    tileOffsets_.assign(navMesh->getMaxTiles() + 1, 0);
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      const int polyCount = tile && tile->header ? tile->header->polyCount : 0;
+      tileOffsets_[iTile + 1] = tileOffsets_[iTile] + polyCount;
+    }
+    polyClusters_.assign(tileOffsets_.back(), NoCluster);
+
+    std::vector<dtPolyRef> polys;
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (!tile || !tile->header)
+        continue;
+      for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+        const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+        const dtPoly* poly = &tile->polys[jPoly];
+        if (poly->getType() != DT_POLYTYPE_GROUND ||
+            !filter->passFilter(ref, tile, poly) || clusterId(ref) != NoCluster)
+          continue;
+        expandFrom(filter, ref, polys);
+      }
+    }
+
+    // an edge for every pair of clusters sharing a polygon edge, through the
+    // first one found
+    std::map<std::pair<uint32_t, uint32_t>, Edge> edges;
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (!tile || !tile->header)
+        continue;
+      for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+        const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+        const uint32_t from = clusterId(ref);
+        if (from == NoCluster)
+          continue;
+        const dtPoly& poly = tile->polys[jPoly];
+        for (unsigned int iLink = poly.firstLink; iLink != DT_NULL_LINK;
+             iLink = tile->links[iLink].next) {
+          const dtLink& link = tile->links[iLink];
+          const uint32_t to = clusterId(link.ref);
+          if (to == NoCluster || to == from ||
+              edges.count(std::make_pair(from, to)))
+            continue;
+          const Eigen::Map<const vec3f> a{
+              &tile->verts[poly.verts[link.edge] * 3]};
+          const Eigen::Map<const vec3f> b{
+              &tile->verts[poly.verts[(link.edge + 1) % poly.vertCount] * 3]};
+          const vec3f portal = (a + b) * 0.5f;
+          const float cost = (clusterCenters_[from] - portal).norm() +
+                             (portal - clusterCenters_[to]).norm();
+          edges.emplace(std::make_pair(from, to), Edge{to, cost, portal, ref});
+        }
+      }
+    }
+    edgeOffsets_.assign(clusterCenters_.size() + 1, 0);
+    for (const auto& edge : edges) {
+      ++edgeOffsets_[edge.first.first + 1];
+    }
+    std::partial_sum(edgeOffsets_.begin(), edgeOffsets_.end(),
+                     edgeOffsets_.begin());
+    edges_.reserve(edges.size());
+    // the map is sorted by the cluster the edges start from
+    for (const auto& edge : edges) {
+      edges_.push_back(edge.second);
+    }
+  }
+
+  float clusterSize() const { return clusterSize_; }
+
+  uint32_t numClusters() const { return clusterCenters_.size(); }
+
+  uint32_t clusterId(dtPolyRef ref) const {
+    const uint32_t* slot = clusterIdSlot(ref);
+    return slot ? *slot : NoCluster;
+  }
+
+  // A* over the clusters, touching only the clusters it expands. Returns the
+  // edges from start to end, empty if there is no corridor.
+  std::vector<const Edge*> findCorridor(uint32_t start, uint32_t end) const {
+    struct Visit {
+      float cost;
+      //! the edge it was reached by, nullptr for the start
+      const Edge* edge;
+      uint32_t from;
+      bool closed;
+    };
+    std::unordered_map<uint32_t, Visit> visits;
+    typedef std::pair<float, uint32_t> Open;
+    std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+    const vec3f& goal = clusterCenters_[end];
+    visits[start] = Visit{0.0f, nullptr, NoCluster, false};
+    open.emplace((clusterCenters_[start] - goal).norm(), start);
+    std::vector<const Edge*> corridor;
+    while (!open.empty()) {
+      const uint32_t cluster = open.top().second;
+      open.pop();
+      Visit& visit = visits[cluster];
+      if (visit.closed)
+        continue;
+      visit.closed = true;
+      if (cluster == end) {
+        for (uint32_t c = end; c != start; c = visits[c].from) {
+          corridor.push_back(visits[c].edge);
+        }
+        std::reverse(corridor.begin(), corridor.end());
+        break;
+      }
+      const float cost = visit.cost;
+      for (uint32_t i = edgeOffsets_[cluster]; i != edgeOffsets_[cluster + 1];
+           ++i) {
+        const Edge& edge = edges_[i];
+        const float edgeCost = cost + edge.cost;
+        auto found = visits.find(edge.to);
+        if (found != visits.end() &&
+            (found->second.closed || found->second.cost <= edgeCost))
+          continue;
+        visits[edge.to] = Visit{edgeCost, &edge, cluster, false};
+        open.emplace(edgeCost + (clusterCenters_[edge.to] - goal).norm(),
+                     edge.to);
+      }
+    }
+    return corridor;
+  }
+
+ private:
+  uint32_t* clusterIdSlot(dtPolyRef ref) {
+    return const_cast<uint32_t*>(
+        const_cast<const PathHierarchy*>(this)->clusterIdSlot(ref));
+  }
+
+  const uint32_t* clusterIdSlot(dtPolyRef ref) const {
+    if (!ref)
+      return nullptr;
+    unsigned int salt, iTile, iPoly;
+    navMesh_->decodePolyId(ref, salt, iTile, iPoly);
+    if (iTile >= tileOffsets_.size() - 1 ||
+        iPoly >= tileOffsets_[iTile + 1] - tileOffsets_[iTile] ||
+        navMesh_->getTile(iTile)->salt != salt)
+      return nullptr;
+    return &polyClusters_[tileOffsets_[iTile] + iPoly];
+  }
+
+  //! The grid cell of the center of a polygon
+  std::pair<int, int> cell(const dtMeshTile* tile, const dtPoly* poly) const {
+    vec3f center = vec3f::Zero();
+    for (int iVert = 0; iVert < poly->vertCount; ++iVert) {
+      center += Eigen::Map<const vec3f>(&tile->verts[poly->verts[iVert] * 3]);
+    }
+    center /= poly->vertCount;
+    return {int(std::floor(center[0] / clusterSize_)),
+            int(std::floor(center[2] / clusterSize_))};
+  }
+
+  //! Flood the new cluster of @p startRef within its cell
+  void expandFrom(const dtQueryFilter* filter,
+                  dtPolyRef startRef,
+                  std::vector<dtPolyRef>& stack) {
+    const uint32_t cluster = clusterCenters_.size();
+    const dtMeshTile* startTile = nullptr;
+    const dtPoly* startPoly = nullptr;
+    navMesh_->getTileAndPolyByRefUnsafe(startRef, &startTile, &startPoly);
+    const std::pair<int, int> startCell = cell(startTile, startPoly);
+
+    vec3f center = vec3f::Zero();
+    int numVerts = 0;
+    *clusterIdSlot(startRef) = cluster;
+    stack.assign(1, startRef);
+    while (!stack.empty()) {
+      const dtPolyRef ref = stack.back();
+      stack.pop_back();
+      const dtMeshTile* tile = nullptr;
+      const dtPoly* poly = nullptr;
+      navMesh_->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+      for (int iVert = 0; iVert < poly->vertCount; ++iVert) {
+        center += Eigen::Map<const vec3f>(&tile->verts[poly->verts[iVert] * 3]);
+      }
+      numVerts += poly->vertCount;
+
+      for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+           iLink = tile->links[iLink].next) {
+        const dtPolyRef neighbourRef = tile->links[iLink].ref;
+        const uint32_t* slot = clusterIdSlot(neighbourRef);
+        if (!slot || *slot != NoCluster)
+          continue;
+        const dtMeshTile* neighbourTile = nullptr;
+        const dtPoly* neighbourPoly = nullptr;
+        navMesh_->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile,
+                                            &neighbourPoly);
+        if (neighbourPoly->getType() != DT_POLYTYPE_GROUND ||
+            !filter->passFilter(neighbourRef, neighbourTile, neighbourPoly) ||
+            cell(neighbourTile, neighbourPoly) != startCell)
+          continue;
+        *clusterIdSlot(neighbourRef) = cluster;
+        stack.push_back(neighbourRef);
+      }
+    }
+    clusterCenters_.push_back(center / numVerts);
+  }
+
+  const dtNavMesh* navMesh_;
+  float clusterSize_;
+  //! clusters of the polygons of tile i are polyClusters_[tileOffsets_[i], ..)
+  std::vector<uint32_t> tileOffsets_;
+  std::vector<uint32_t> polyClusters_;
+  //! the mean of the polygon vertices of each cluster
+  std::vector<vec3f> clusterCenters_;
+  //! the edges from cluster i are edges_[edgeOffsets_[i], ..[i + 1])
+  std::vector<uint32_t> edgeOffsets_;
+  std::vector<Edge> edges_;
+};
+
+constexpr uint32_t PathHierarchy::NoCluster;
 }  // namespace impl
 
+namespace {
+//! Set while a PathFinder::parallelFor() worker runs: the query of the worker
+//! and the path finder it belongs to
+thread_local const void* workerQueryOwner = nullptr;
+thread_local dtNavMeshQuery* workerQuery = nullptr;
+}  // namespace
+
 struct PathFinder::Impl {
   Impl();
   ~Impl() = default;
@@ -224,12 +738,60 @@ struct PathFinder::Impl {
              const float* bmin,
              const float* bmax);
   bool build(const NavMeshSettings& bs, const esp::assets::MeshData& mesh);
+  //! Build the navmesh of each of @p variants into the one of @p impls
+  static bool buildVariants(const std::vector<NavMeshSettings>& variants,
+                            const esp::assets::MeshData& mesh,
+                            const std::vector<Impl*>& impls);
+
+  bool updateRegion(const esp::assets::MeshData& mesh,
+                    const vec3f& regionMin,
+                    const vec3f& regionMax);
 
-  vec3f getRandomNavigablePoint();
+  vec3f getRandomNavigablePoint(int islandIndex);
+  std::vector<vec3f> sampleNavigablePoints(int numPoints, int islandIndex);
+
+  int getIslandIndex(const vec3f& pt) const;
+  int numIslands() const;
 
   bool findPath(ShortestPath& path);
   bool findPath(MultiGoalShortestPath& path);
 
+  void setPathCacheSize(size_t size);
+  size_t getPathCacheSize() const;
+  size_t getPathCacheHits() const;
+  size_t getPathCacheMisses() const;
+
+  void findPathsBatch(std::vector<ShortestPath>& paths, int numThreads);
+  std::vector<float> findDistancesBatch(const std::vector<vec3f>& starts,
+                                        const std::vector<vec3f>& ends,
+                                        int numThreads);
+  std::vector<vec3f> snapPointsBatch(const std::vector<vec3f>& pts,
+                                     int numThreads);
+  Eigen::Matrix<bool, Eigen::Dynamic, 1> isNavigableBatch(
+      const std::vector<vec3f>& pts,
+      float maxYDelta,
+      int numThreads);
+  std::vector<vec3f> tryStepsBatch(const std::vector<vec3f>& starts,
+                                   const std::vector<vec3f>& ends,
+                                   bool allowSliding,
+                                   int numThreads);
+
+  void parallelForWorkers(size_t numItems,
+                          int numThreads,
+                          const std::function<void(size_t, int)>& func);
+
+  GeodesicDistanceField::ptr buildGeodesicDistanceField(
+      const std::vector<vec3f>& goals,
+      int samplesPerPortal);
+  float geodesicDistance(const GeodesicDistanceField& field, const vec3f& pt);
+  Eigen::MatrixXf geodesicDistanceMatrix(const std::vector<vec3f>& points,
+                                         int samplesPerPortal,
+                                         int numThreads);
+  //! Sample the portals of the walkable polygons into @p f, for the current
+  //! navmesh
+  void samplePortals(GeodesicDistanceField::Impl& f,
+                     int samplesPerPortal) const;
+
   template <typename T>
   T tryStep(const T& start, const T& end, bool allowSliding);
 
@@ -238,9 +800,32 @@ struct PathFinder::Impl {
 
   bool loadNavMesh(const std::string& path);
 
-  bool saveNavMesh(const std::string& path);
+  bool saveNavMesh(const std::string& path, bool mappable);
+
+  //! Write the navmesh as an entry of a variants container
+  bool writeVariant(FILE* fp) const;
+  //! Read the navmesh of an entry of a variants container, ending at @p end
+  bool readVariant(FILE* fp, long end);
+
+  bool isLoaded() const {
+    return navMesh_ != nullptr || compressedNavMesh_ != Cr::Containers::NullOpt;
+  };
 
-  bool isLoaded() const { return navMesh_ != nullptr; };
+  bool compress();
+  bool isCompressed() const { return compressed_.load(); }
+  size_t getTileDataBytes() const;
+  int streamTiles(const std::vector<vec3f>& points, float radius);
+  //! Decompress the navmesh if it's compressed. Logically const, the
+  //! navmesh stays the same. The const queries may run concurrently, the
+  //! first one decompresses under decompressMutex_ and the others wait.
+  void ensureDecompressed() const {
+    if (!isCompressed())
+      return;
+    std::lock_guard<std::mutex> lock{decompressMutex_};
+    if (isCompressed())
+      const_cast<Impl*>(this)->decompress();
+  }
+  bool decompress();
 
   float getNavigableArea() const { return navMeshArea_; };
 
@@ -248,8 +833,22 @@ struct PathFinder::Impl {
 
   float islandRadius(const vec3f& pt) const;
 
+  bool buildObstacleDistanceField(const float cellSize,
+                                  const float maxDistance);
+  bool hasObstacleDistanceField() const {
+    return bool(obstacleDistanceField_);
+  }
+  float obstacleDistanceFieldMaxError() const;
+
+  bool buildPathHierarchy(const float clusterSize);
+  bool hasPathHierarchy() const { return bool(pathHierarchy_); }
+  int numPathClusters() const;
+
   float distanceToClosestObstacle(const vec3f& pt,
                                   const float maxSearchRadius = 2.0) const;
+  std::vector<float> distancesToClosestObstacle(
+      const std::vector<vec3f>& pts,
+      const float maxSearchRadius) const;
   HitRecord closestObstacleSurfacePoint(
       const vec3f& pt,
       const float maxSearchRadius = 2.0) const;
@@ -272,14 +871,188 @@ struct PathFinder::Impl {
     void operator()(dtNavMeshQuery* query) { dtFreeNavMeshQuery(query); }
   };
 
-  std::unique_ptr<dtNavMesh, NavMeshDeleter> navMesh_ = nullptr;
+  struct MappedFileDeleter {
+    size_t size;
+    void operator()(unsigned char* data) {
+#ifdef CORRADE_TARGET_UNIX
+      munmap(data, size);
+#endif
+    }
+  };
+  typedef std::unique_ptr<dtNavMesh, NavMeshDeleter> NavMeshPtr;
+  typedef std::unique_ptr<unsigned char, MappedFileDeleter> MappedFilePtr;
+
+  //! The file the tiles of navMesh_ were mapped from, if any. Outlives it.
+  MappedFilePtr navMeshFile_{nullptr, MappedFileDeleter{0}};
+  NavMeshPtr navMesh_ = nullptr;
   std::unique_ptr<dtNavMeshQuery, NavQueryDeleter> navQuery_ = nullptr;
   std::unique_ptr<dtQueryFilter> filter_ = nullptr;
   std::unique_ptr<impl::IslandSystem> islandSystem_ = nullptr;
 
-  //! Holds triangulated geom/topo. Generated when queried. Reset with
-  //! navQuery_.
-  assets::MeshData::ptr meshData_ = nullptr;
+  //! One query per worker thread of the batched queries, grown on demand.
+  //! Reset with navQuery_.
+  std::vector<std::unique_ptr<dtNavMeshQuery, NavQueryDeleter>> queryPool_;
+
+  //! Identifies the current navmesh across all path finders, so distance
+  //! fields built on another one are detected. Changed with navQuery_.
+  uint32_t navMeshVersion_ = 0;
+
+  //! Detail triangles of the walkable polygons grouped by island, with the
+  //! running sum of their areas, to sample points in O(log n)
+  struct SamplingTable {
+    //! three vertices per triangle
+    std::vector<vec3f> verts;
+    //! area of the triangles [0, i]
+    std::vector<double> cumulativeArea;
+    //! the triangles of island i are [islandOffsets[i], islandOffsets[i + 1])
+    std::vector<uint32_t> islandOffsets;
+  };
+  //! Generated when sampled. Reset with navQuery_.
+  Cr::Containers::Optional<SamplingTable> samplingTable_;
+
+  const SamplingTable& samplingTable();
+  //! the point of the uniform random numbers u in [0, 1)
+  vec3f samplePoint(const SamplingTable& table,
+                    int islandIndex,
+                    const float* u);
+  //! the generator of the sampled points, see seed()
+  core::Random random_{0};
+
+  //! Distances to the closest obstacle at the centers of a grid over the
+  //! navmesh bounds. A cell has a sample for every surface above one another.
+  struct ObstacleDistanceField {
+    float cellSize;
+    //! center of cell (0, 0)
+    float originX, originZ;
+    int width, height;
+    //! height difference of samples in neighbouring cells on one surface
+    float climb;
+    //! distances were propagated up to this
+    float maxDistance;
+    //! the samples of cell h * width + w are [cellOffsets[i], ..[i + 1])
+    std::vector<uint32_t> cellOffsets;
+    std::vector<float> heights;
+    //! inf beyond maxDistance
+    std::vector<float> distances;
+    //! the closest obstacle point in xz
+    std::vector<vec2f> obstacles;
+
+    //! The sample of cell (h, w) on the surface at @p y, ID_UNDEFINED if none
+    int connectedSample(int h, int w, float y) const;
+    //! The sample @p pt is on, ID_UNDEFINED if none
+    int sampleAt(const vec3f& pt) const;
+  };
+  //! Built on request. Reset with navQuery_.
+  Cr::Containers::Optional<ObstacleDistanceField> obstacleDistanceField_;
+
+  //! Built on request. Reset with navQuery_.
+  std::unique_ptr<impl::PathHierarchy> pathHierarchy_;
+
+  //! The last TopDownViewCacheSize top-down views asked for, most recently
+  //! used first, by (metersPerPixel, height). Reset with navQuery_.
+  struct CachedTopDownView {
+    std::pair<float, float> key;
+    Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> view;
+  };
+  static constexpr size_t TopDownViewCacheSize = 4;
+  std::list<CachedTopDownView> topDownViewCache_;
+
+  //! The bits of the requested start and end of a path
+  typedef std::array<uint32_t, 6> PathCacheKey;
+  struct PathCacheKeyHash {
+    size_t operator()(const PathCacheKey& key) const {
+      size_t hash = 0;
+      for (const uint32_t bits : key) {
+        hash = hash * 1000003 ^ bits;
+      }
+      return hash;
+    }
+  };
+  struct CachedPath {
+    PathCacheKey key;
+    float geodesicDistance;
+    std::vector<vec3f> points;
+  };
+  //! Results of findPath(ShortestPath&), most recently used first, with
+  //! pathCacheIndex_ pointing into it. Reset with navQuery_.
+  std::list<CachedPath> pathCache_;
+  std::unordered_map<PathCacheKey,
+                     std::list<CachedPath>::iterator,
+                     PathCacheKeyHash>
+      pathCacheIndex_;
+  size_t pathCacheCapacity_ = 0;
+  size_t pathCacheHits_ = 0;
+  size_t pathCacheMisses_ = 0;
+  //! The queries may run on the workers of parallelFor()
+  mutable std::mutex pathCacheMutex_;
+
+  //! Copy a cached result into @p path, counting the hit or miss
+  bool findCachedPath(const PathCacheKey& key, ShortestPath& path);
+  void cachePath(const PathCacheKey& key, const ShortestPath& path);
+  void clearPathCache();
+
+  //! Holds triangulated geom/topo. Generated when queried, and kept only as
+  //! long as a caller holds it. Reset with navQuery_.
+  std::weak_ptr<assets::MeshData> meshData_;
+
+  //! The tiles of a compressed navmesh, see PathFinder::compress()
+  struct CompressedTile {
+    dtTileRef tileRef;
+    int dataSize;
+    std::vector<unsigned char> data;
+  };
+  struct CompressedNavMesh {
+    dtNavMeshParams params;
+    std::vector<CompressedTile> tiles;
+  };
+  //! Set instead of navMesh_ while compressed. Reset with navQuery_.
+  Cr::Containers::Optional<CompressedNavMesh> compressedNavMesh_;
+  //! Whether compressedNavMesh_ is set, read without decompressMutex_
+  std::atomic<bool> compressed_{false};
+  mutable std::mutex decompressMutex_;
+
+  //! A tile evicted by PathFinder::streamTiles(), with its bounds
+  struct EvictedTile {
+    CompressedTile tile;
+    vec3f bmin;
+    vec3f bmax;
+  };
+  //! The evicted tiles of navMesh_, cleared when it is replaced
+  std::vector<EvictedTile> evictedTiles_;
+  //! Whether streamTiles() evicts tiles of navMesh_, around streamPoints_
+  bool streaming_ = false;
+  std::vector<vec3f> streamPoints_;
+  float streamRadius_ = 0.0f;
+  //! The number of AllTilesScope instances in existence
+  int numAllTilesScopes_ = 0;
+
+  //! Restore the evicted tiles @p select returns true for, with the polygon
+  //! refs they had, so that state built on them stays valid
+  int restoreTiles(const std::function<bool(const EvictedTile&)>& select);
+  //! Evict the tiles farther than streamRadius_ from all streamPoints_
+  int evictTiles();
+
+  //! Restores all evicted tiles while it exists, and evicts them again
+  //! after. State kept across streamTiles(), such as the islands, the
+  //! sampling table and the distance field, is built in one, so that it
+  //! describes the whole navmesh wherever the agents are.
+  class AllTilesScope {
+   public:
+    explicit AllTilesScope(Impl& impl) : impl_(impl) {
+      if (impl_.numAllTilesScopes_++ == 0)
+        impl_.restoreTiles([](const EvictedTile&) { return true; });
+    }
+    ~AllTilesScope() {
+      if (--impl_.numAllTilesScopes_ == 0 && impl_.streaming_)
+        impl_.evictTiles();
+    }
+
+    AllTilesScope(const AllTilesScope&) = delete;
+    AllTilesScope& operator=(const AllTilesScope&) = delete;
+
+   private:
+    Impl& impl_;
+  };
 
   //! Sum of all NavMesh polygons. Computed on NavMesh load/recompute. See
   //! removeZeroAreaPolys.
@@ -287,18 +1060,107 @@ struct PathFinder::Impl {
 
   std::pair<vec3f, vec3f> bounds_;
 
+  //! Settings of a tiled build, needed to rebuild tiles in updateRegion()
+  struct TiledBuild {
+    NavMeshSettings settings;
+    //! Recast config of a tile, with the bounds of the whole navmesh
+    rcConfig cfg;
+    int numTilesX;
+    int numTilesY;
+    //! hash of the geometry each tile was built from, row by row
+    std::vector<uint64_t> tileHashes;
+  };
+  //! Set if the navmesh was built in tiles, NullOpt if built as a single tile
+  //! or loaded from a file
+  Cr::Containers::Optional<TiledBuild> tiledBuild_;
+
   void removeZeroAreaPolys();
 
-  bool initNavQuery();
+  //! Read the tiles of the default format, the islands are read by the caller
+  NavMeshPtr loadNavMeshSet(FILE* fp);
+  //! Use a loaded navmesh, with the islands stored with it if any
+  bool useLoadedNavMesh(NavMeshPtr mesh,
+                        MappedFilePtr mappedFile,
+                        std::unique_ptr<impl::IslandSystem> islandSystem);
+  //! Map the tiles of the mapped format into @p mappedFile, and leave fp at
+  //! the islands
+  NavMeshPtr loadMappedNavMesh(FILE* fp, MappedFilePtr& mappedFile);
+  bool writeNavMeshSet(FILE* fp) const;
+  bool writeMappedNavMesh(FILE* fp) const;
+
+  //! Also rebuilds the islands, unless @p islandSystem is given
+  bool initNavQuery(
+      std::unique_ptr<impl::IslandSystem> islandSystem = nullptr);
+
+  //! Rebuild the derived state after the navmesh was built or changed
+  bool finishBuild();
+  //! Make the navmesh a single tile of @p navData, which it takes
+  bool initSingleTile(unsigned char* navData, int navDataSize);
+
+  bool buildTiled(const NavMeshSettings& bs,
+                  const rcConfig& cfg,
+                  const float* verts,
+                  const int nverts,
+                  const int* tris,
+                  const int ntris);
+
+  //! Tiles whose geometry hashes as before are kept if @p onlyChanged is set
+  bool rebuildTiles(const float* verts,
+                    const int nverts,
+                    const int* tris,
+                    const int ntris,
+                    const int minTileX,
+                    const int minTileY,
+                    const int maxTileX,
+                    const int maxTileY,
+                    const bool onlyChanged = false);
+
+  //! Make sure queryPool_ has a query for each of @p numThreads threads.
+  //! Returns the number of threads with a query.
+  int growQueryPool(int numThreads);
+
+  //! parallelFor() with a dtNavMeshQuery from queryPool_ for each thread
+  template <typename F>
+  void parallelForQueries(size_t numItems, int numThreads, F&& func);
+
+  //! The query of the calling thread, see PathFinder::parallelFor()
+  dtNavMeshQuery* query() const {
+    return workerQueryOwner == this ? workerQuery : navQuery_.get();
+  }
+
+  Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+  findPathBetween(dtNavMeshQuery* query, const vec3f& start, const vec3f& end);
 
   Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-  findPathInternal(const vec3f& start,
+  findPathInternal(dtNavMeshQuery* query,
+                   const vec3f& start,
                    dtPolyRef startRef,
                    const vec3f& pathStart,
                    const vec3f& end,
                    dtPolyRef endRef,
                    const vec3f& pathEnd);
 
+  //! The Detour search, whose path is at most 256 polygons long
+  Cr::Containers::Optional<std::vector<vec3f>> findPathPoints(
+      dtNavMeshQuery* query,
+      const vec3f& start,
+      dtPolyRef startRef,
+      const vec3f& pathStart,
+      const vec3f& end,
+      dtPolyRef endRef,
+      const vec3f& pathEnd);
+
+  //! Search the corridor of pathHierarchy_ first, NullOpt for the paths
+  //! it doesn't take
+  Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+  findHierarchicalPath(dtNavMeshQuery* query,
+                       const vec3f& start,
+                       dtPolyRef startRef,
+                       const vec3f& pathStart,
+                       const vec3f& end,
+                       dtPolyRef endRef,
+                       const vec3f& pathEnd);
+
   bool findPathSetup(MultiGoalShortestPath& path,
                      dtPolyRef& startRef,
                      vec3f& pathStart);
@@ -339,21 +1201,8 @@ PathFinder::Impl::Impl() {
   filter_->setExcludeFlags(0);
 }
 
-bool PathFinder::Impl::build(const NavMeshSettings& bs,
-                             const float* verts,
-                             const int nverts,
-                             const int* tris,
-                             const int ntris,
-                             const float* bmin,
-                             const float* bmax) {
-  Workspace ws;
-  rcContext ctx;
-
-  //
-  // Step 1. Initialize build config.
-  //
-
-  // Init build configuration from GUI
+namespace {
+rcConfig makeConfig(const NavMeshSettings& bs) {
   rcConfig cfg;
   memset(&cfg, 0, sizeof(cfg));
   cfg.cs = bs.cellSize;
@@ -372,16 +1221,112 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   cfg.detailSampleDist =
       bs.detailSampleDist < 0.9f ? 0 : bs.cellSize * bs.detailSampleDist;
   cfg.detailSampleMaxError = bs.cellHeight * bs.detailSampleMaxError;
+  return cfg;
+}
 
-  // Set the area where the navigation will be build.
-  // Here the bounds of the input mesh are used, but the
-  // area could be specified by an user defined box, etc.
-  rcVcopy(cfg.bmin, bmin);
-  rcVcopy(cfg.bmax, bmax);
-  rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
-  LOG(INFO) << "Building navmesh with " << cfg.width << "x" << cfg.height
-            << " cells";
+//! Index buffer of a mesh, as Recast expects it
+std::vector<int> meshIndices(const esp::assets::MeshData& mesh) {
+  return std::vector<int>(mesh.ibo.begin(), mesh.ibo.end());
+}
+
+//! Hash of three 32-bit words, the bits of a position or a triangle
+struct Uint3Hash {
+  size_t operator()(const std::array<uint32_t, 3>& value) const {
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : value) {
+      hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+  }
+};
+
+/**
+ * @brief Index buffer of the triangles of a mesh that can change its navmesh,
+ * see @ref NavMeshSettings::cullInputTriangles
+ *
+ * A triangle rasterized twice gives the same spans, and spans higher than
+ * the agent height and max climb above every walkable surface can't block
+ * the agent, so both are left out. The bounds of the heightfield are still
+ * those of the whole mesh, so the voxels are the same.
+ * @param agentHeight The largest agent height the navmesh is built for
+ */
+std::vector<int> navMeshInputIndices(const esp::assets::MeshData& mesh,
+                                     const NavMeshSettings& bs,
+                                     float agentHeight) {
+  core::ScopedTraceEvent trace{"navMeshInputIndices", "nav"};
+  if (!bs.cullInputTriangles) {
+    return meshIndices(mesh);
+  }
+  const size_t numTris = mesh.ibo.size() / 3;
+  auto vertex = [&](size_t tri, int corner) -> const vec3f& {
+    return mesh.vbo[mesh.ibo[tri * 3 + corner]];
+  };
+
+  // the same threshold as rcMarkWalkableTriangles()
+  const float walkableThr = std::cos(bs.agentMaxSlope / 180.0f * RC_PI);
+  float maxWalkableY = -std::numeric_limits<float>::max();
+  for (size_t i = 0; i < numTris; ++i) {
+    const vec3f normal = (vertex(i, 1) - vertex(i, 0))
+                             .cross(vertex(i, 2) - vertex(i, 0))
+                             .normalized();
+    if (normal[1] > walkableThr) {
+      maxWalkableY = std::max({maxWalkableY, vertex(i, 0)[1],
+                               vertex(i, 1)[1], vertex(i, 2)[1]});
+    }
+  }
+  // two cells of margin for the rounding of the spans to cells
+  const float maxY = maxWalkableY + agentHeight + bs.agentMaxClimb +
+                     2.0f * bs.cellHeight;
+
+  // the vertices of joined meshes are often split by normals or texture
+  // coordinates, duplicates are found between the welded positions
+  std::unordered_map<std::array<uint32_t, 3>, uint32_t, Uint3Hash> weldedIds;
+  weldedIds.reserve(mesh.vbo.size());
+  std::vector<uint32_t> welded(mesh.vbo.size());
+  for (size_t i = 0; i < mesh.vbo.size(); ++i) {
+    std::array<uint32_t, 3> bits;
+    std::memcpy(bits.data(), mesh.vbo[i].data(), sizeof(bits));
+    welded[i] = weldedIds.emplace(bits, weldedIds.size()).first->second;
+  }
+  std::unordered_set<std::array<uint32_t, 3>, Uint3Hash> seen;
+  seen.reserve(numTris);
+
+  std::vector<int> indices;
+  indices.reserve(mesh.ibo.size());
+  for (size_t i = 0; i < numTris; ++i) {
+    if (std::min({vertex(i, 0)[1], vertex(i, 1)[1], vertex(i, 2)[1]}) > maxY) {
+      continue;
+    }
+    // rotated to start at the smallest id, which keeps the winding and so
+    // the walkability of the triangle
+    std::array<uint32_t, 3> ids;
+    for (int corner = 0; corner < 3; ++corner) {
+      ids[corner] = welded[mesh.ibo[i * 3 + corner]];
+    }
+    std::rotate(ids.begin(), std::min_element(ids.begin(), ids.end()),
+                ids.end());
+    if (!seen.insert(ids).second) {
+      continue;
+    }
+    for (int corner = 0; corner < 3; ++corner) {
+      indices.push_back(mesh.ibo[i * 3 + corner]);
+    }
+  }
+  if (indices.size() < mesh.ibo.size()) {
+    LOG(INFO) << "Rasterizing " << indices.size() / 3 << " of " << numTris
+              << " triangles into the navmesh";
+  }
+  return indices;
+}
 
+//! Step 2 of buildTileData(): rasterize the triangles into ws.solid
+bool rasterizeTile(const rcConfig& cfg,
+                   const float* verts,
+                   const int nverts,
+                   const int* tris,
+                   const int ntris,
+                   rcContext& ctx,
+                   Workspace& ws) {
   //
   // Step 2. Rasterize input polygon soup.
   //
@@ -419,6 +1364,15 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
     return false;
   }
 
+  return true;
+}
+
+//! Step 3 of buildTileData(): filter ws.solid and compact it into ws.chf.
+//! Only changes the areas of the spans of ws.solid.
+bool compactTile(const NavMeshSettings& bs,
+                 const rcConfig& cfg,
+                 rcContext& ctx,
+                 Workspace& ws) {
   //
   // Step 3. Filter walkables surfaces.
   //
@@ -440,6 +1394,7 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   // Compact the heightfield so that it is faster to handle from now on.
   // This will result more cache coherent data as well as the neighbours
   // between walkable cells will be calculated.
+  rcFreeCompactHeightfield(ws.chf);
   ws.chf = rcAllocCompactHeightfield();
   if (!ws.chf) {
     LOG(ERROR) << "Out of memory for compact heightfield";
@@ -451,6 +1406,26 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
     return false;
   }
 
+  return true;
+}
+
+//! The rest of buildTileData(), from ws.chf. Only changes its areas, regions
+//! and distance field.
+bool buildTileDataFromCompact(const NavMeshSettings& bs,
+                              const rcConfig& cfg,
+                              const int tileX,
+                              const int tileY,
+                              rcContext& ctx,
+                              Workspace& ws,
+                              unsigned char*& navData,
+                              int& navDataSize,
+                              int& numPolys,
+                              int& numVerts) {
+  navData = nullptr;
+  navDataSize = 0;
+  numPolys = 0;
+  numVerts = 0;
+
   // Erode the walkable area by agent radius.
   if (!rcErodeWalkableArea(&ctx, cfg.walkableRadius, *ws.chf)) {
     LOG(ERROR) << "Could not erode walkable area";
@@ -504,7 +1479,7 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
     return false;
   }
   // Partition the walkable surface into simple regions without holes.
-  if (!rcBuildRegions(&ctx, *ws.chf, 0, cfg.minRegionArea,
+  if (!rcBuildRegions(&ctx, *ws.chf, cfg.borderSize, cfg.minRegionArea,
                       cfg.mergeRegionArea)) {
     LOG(ERROR) << "Could not build watershed regions";
     return false;
@@ -521,6 +1496,7 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   //
 
   // Create contours.
+  rcFreeContourSet(ws.cset);
   ws.cset = rcAllocContourSet();
   if (!ws.cset) {
     LOG(ERROR) << "Out of memory for contour set";
@@ -537,6 +1513,7 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   //
 
   // Build polygon navmesh from the contours.
+  rcFreePolyMesh(ws.pmesh);
   ws.pmesh = rcAllocPolyMesh();
   if (!ws.pmesh) {
     LOG(ERROR) << "Out of memory for polymesh";
@@ -552,6 +1529,7 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   // each polygon.
   //
 
+  rcFreePolyMeshDetail(ws.dmesh);
   ws.dmesh = rcAllocPolyMeshDetail();
   if (!ws.dmesh) {
     LOG(ERROR) << "Out of memory for polymesh detail";
@@ -572,126 +1550,643 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   // (Optional) Step 8. Create Detour data from Recast poly mesh.
   //
 
-  // The GUI may allow more max points per polygon than Detour can handle.
-  // Only build the detour navmesh if we do not exceed the limit.
-  if (cfg.maxVertsPerPoly <= DT_VERTS_PER_POLYGON) {
-    unsigned char* navData = 0;
-    int navDataSize = 0;
-
-    // Update poly flags from areas.
-    for (int i = 0; i < ws.pmesh->npolys; ++i) {
-      if (ws.pmesh->areas[i] == RC_WALKABLE_AREA) {
-        ws.pmesh->areas[i] = POLYAREA_GROUND;
-      }
-      if (ws.pmesh->areas[i] == POLYAREA_GROUND) {
-        ws.pmesh->flags[i] = POLYFLAGS_WALK;
-      } else if (ws.pmesh->areas[i] == POLYAREA_DOOR) {
-        ws.pmesh->flags[i] = POLYFLAGS_WALK | POLYFLAGS_DOOR;
-      }
-    }
+  numPolys = ws.pmesh->npolys;
+  numVerts = ws.pmesh->nverts;
+  // tiles without any walkable surface are left empty
+  if (ws.pmesh->npolys == 0) {
+    return true;
+  }
 
-    dtNavMeshCreateParams params;
-    memset(&params, 0, sizeof(params));
-    params.verts = ws.pmesh->verts;
-    params.vertCount = ws.pmesh->nverts;
-    params.polys = ws.pmesh->polys;
-    params.polyAreas = ws.pmesh->areas;
-    params.polyFlags = ws.pmesh->flags;
-    params.polyCount = ws.pmesh->npolys;
-    params.nvp = ws.pmesh->nvp;
-    params.detailMeshes = ws.dmesh->meshes;
-    params.detailVerts = ws.dmesh->verts;
-    params.detailVertsCount = ws.dmesh->nverts;
-    params.detailTris = ws.dmesh->tris;
-    params.detailTriCount = ws.dmesh->ntris;
-    // params.offMeshConVerts = geom->getOffMeshConnectionVerts();
-    // params.offMeshConRad = geom->getOffMeshConnectionRads();
-    // params.offMeshConDir = geom->getOffMeshConnectionDirs();
-    // params.offMeshConAreas = geom->getOffMeshConnectionAreas();
-    // params.offMeshConFlags = geom->getOffMeshConnectionFlags();
-    // params.offMeshConUserID = geom->getOffMeshConnectionId();
-    // params.offMeshConCount = geom->getOffMeshConnectionCount();
-    params.walkableHeight = bs.agentHeight;
-    params.walkableRadius = bs.agentRadius;
-    params.walkableClimb = bs.agentMaxClimb;
-    rcVcopy(params.bmin, ws.pmesh->bmin);
-    rcVcopy(params.bmax, ws.pmesh->bmax);
-    params.cs = cfg.cs;
-    params.ch = cfg.ch;
-    params.buildBvTree = true;
-
-    if (!dtCreateNavMeshData(&params, &navData, &navDataSize)) {
-      LOG(ERROR) << "Could not build Detour navmesh";
-      return false;
+  // Update poly flags from areas.
+  for (int i = 0; i < ws.pmesh->npolys; ++i) {
+    if (ws.pmesh->areas[i] == RC_WALKABLE_AREA) {
+      ws.pmesh->areas[i] = POLYAREA_GROUND;
     }
-
-    navMesh_.reset(dtAllocNavMesh());
-    if (!navMesh_) {
-      dtFree(navData);
-      LOG(ERROR) << "Could not allocate Detour navmesh";
-      return false;
+    if (ws.pmesh->areas[i] == POLYAREA_GROUND) {
+      ws.pmesh->flags[i] = POLYFLAGS_WALK;
+    } else if (ws.pmesh->areas[i] == POLYAREA_DOOR) {
+      ws.pmesh->flags[i] = POLYFLAGS_WALK | POLYFLAGS_DOOR;
     }
+  }
 
-    dtStatus status;
-    status = navMesh_->init(navData, navDataSize, DT_TILE_FREE_DATA);
-    if (dtStatusFailed(status)) {
-      dtFree(navData);
-      LOG(ERROR) << "Could not init Detour navmesh";
-      return false;
-    }
-    if (!initNavQuery()) {
-      return false;
-    }
+  dtNavMeshCreateParams params;
+  memset(&params, 0, sizeof(params));
+  params.verts = ws.pmesh->verts;
+  params.vertCount = ws.pmesh->nverts;
+  params.polys = ws.pmesh->polys;
+  params.polyAreas = ws.pmesh->areas;
+  params.polyFlags = ws.pmesh->flags;
+  params.polyCount = ws.pmesh->npolys;
+  params.nvp = ws.pmesh->nvp;
+  params.detailMeshes = ws.dmesh->meshes;
+  params.detailVerts = ws.dmesh->verts;
+  params.detailVertsCount = ws.dmesh->nverts;
+  params.detailTris = ws.dmesh->tris;
+  params.detailTriCount = ws.dmesh->ntris;
+  // params.offMeshConVerts = geom->getOffMeshConnectionVerts();
+  // params.offMeshConRad = geom->getOffMeshConnectionRads();
+  // params.offMeshConDir = geom->getOffMeshConnectionDirs();
+  // params.offMeshConAreas = geom->getOffMeshConnectionAreas();
+  // params.offMeshConFlags = geom->getOffMeshConnectionFlags();
+  // params.offMeshConUserID = geom->getOffMeshConnectionId();
+  // params.offMeshConCount = geom->getOffMeshConnectionCount();
+  params.walkableHeight = bs.agentHeight;
+  params.walkableRadius = bs.agentRadius;
+  params.walkableClimb = bs.agentMaxClimb;
+  rcVcopy(params.bmin, ws.pmesh->bmin);
+  rcVcopy(params.bmax, ws.pmesh->bmax);
+  params.cs = cfg.cs;
+  params.ch = cfg.ch;
+  params.tileX = tileX;
+  params.tileY = tileY;
+  params.buildBvTree = true;
+
+  if (!dtCreateNavMeshData(&params, &navData, &navDataSize)) {
+    LOG(ERROR) << "Could not build Detour navmesh";
+    return false;
   }
 
-  // Added as we also need to remove these on navmesh recomputation
-  removeZeroAreaPolys();
+  return true;
+}
 
-  LOG(INFO) << "Created navmesh with " << ws.pmesh->nverts << " vertices "
-            << ws.pmesh->npolys << " polygons";
+/**
+ * @brief Build the Detour data of the navmesh inside the bounds of @p cfg
+ *
+ * @param[out] navData The Detour data, owned by the caller. nullptr if there
+ * is no walkable surface.
+ * @return Whether the build succeeded
+ */
+bool buildTileData(const NavMeshSettings& bs,
+                   const rcConfig& cfg,
+                   const int tileX,
+                   const int tileY,
+                   const float* verts,
+                   const int nverts,
+                   const int* tris,
+                   const int ntris,
+                   unsigned char*& navData,
+                   int& navDataSize,
+                   int& numPolys,
+                   int& numVerts) {
+  navData = nullptr;
+  navDataSize = 0;
+  numPolys = 0;
+  numVerts = 0;
+  if (ntris == 0) {
+    return true;
+  }
 
-  return true;
+  Workspace ws;
+  rcContext ctx;
+  return rasterizeTile(cfg, verts, nverts, tris, ntris, ctx, ws) &&
+         compactTile(bs, cfg, ctx, ws) &&
+         buildTileDataFromCompact(bs, cfg, tileX, tileY, ctx, ws, navData,
+                                  navDataSize, numPolys, numVerts);
 }
 
-bool PathFinder::Impl::initNavQuery() {
-  // if we are reinitializing the NavQuery, then also reset the MeshData
-  meshData_.reset();
+//! The Detour data of a variant built by buildVariantData()
+struct VariantData {
+  unsigned char* navData = nullptr;
+  int navDataSize = 0;
+  int numPolys = 0;
+  int numVerts = 0;
+};
 
-  navQuery_.reset(dtAllocNavMeshQuery());
-  dtStatus status = navQuery_->init(navMesh_.get(), 2048);
-  if (dtStatusFailed(status)) {
-    LOG(ERROR) << "Could not init Detour navmesh query";
-    return false;
+/**
+ * @brief Build the Detour data of a single tile navmesh for each of @p
+ * variants, which only differ in the agent radius and height, from one
+ * rasterization of the triangles
+ *
+ * The variants of one agent height also share the compact heightfield, only
+ * the erosion by the agent radius and the steps after it run for each one.
+ *
+ * @param[out] data The data of each variant, owned by the caller. nullptr
+ * for the ones without a walkable surface.
+ * @return Whether the builds succeeded, no data is returned otherwise
+ */
+bool buildVariantData(const std::vector<NavMeshSettings>& variants,
+                      const float* bmin,
+                      const float* bmax,
+                      const float* verts,
+                      const int nverts,
+                      const int* tris,
+                      const int ntris,
+                      std::vector<VariantData>& data) {
+  data.assign(variants.size(), VariantData{});
+  if (ntris == 0 || variants.empty()) {
+    return true;
   }
 
-  islandSystem_ =
-      std::make_unique<impl::IslandSystem>(navMesh_.get(), filter_.get());
+  const auto variantConfig = [&](const NavMeshSettings& bs) {
+    rcConfig cfg = makeConfig(bs);
+    rcVcopy(cfg.bmin, bmin);
+    rcVcopy(cfg.bmax, bmax);
+    rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
+    return cfg;
+  };
 
-  return true;
-}
+  Workspace ws;
+  rcContext ctx;
+  // the slope and climb the rasterization depends on are the same for all
+  if (!rasterizeTile(variantConfig(variants[0]), verts, nverts, tris, ntris,
+                     ctx, ws)) {
+    return false;
+  }
 
-bool PathFinder::Impl::build(const NavMeshSettings& bs,
-                             const esp::assets::MeshData& mesh) {
-  const int numVerts = mesh.vbo.size();
-  const int numIndices = mesh.ibo.size();
+  // the filters only change the areas of the spans, which are restored for
+  // every agent height
+  const int numColumns = ws.solid->width * ws.solid->height;
+  std::vector<unsigned char> spanAreas;
+  for (int i = 0; i < numColumns; ++i) {
+    for (const rcSpan* span = ws.solid->spans[i]; span; span = span->next)
+      spanAreas.push_back(span->area);
+  }
+
+  std::vector<size_t> order(variants.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return variants[a].agentHeight < variants[b].agentHeight;
+  });
+
+  int compactHeight = -1;
+  std::vector<unsigned char> compactAreas;
+  bool success = true;
+  for (size_t i : order) {
+    const rcConfig cfg = variantConfig(variants[i]);
+    if (cfg.walkableHeight != compactHeight) {
+      size_t area = 0;
+      for (int c = 0; c < numColumns; ++c) {
+        for (rcSpan* span = ws.solid->spans[c]; span; span = span->next)
+          span->area = spanAreas[area++];
+      }
+      if (!compactTile(variants[i], cfg, ctx, ws)) {
+        success = false;
+        break;
+      }
+      compactAreas.assign(ws.chf->areas, ws.chf->areas + ws.chf->spanCount);
+      compactHeight = cfg.walkableHeight;
+    } else {
+      // the erosion of the previous variant changed them
+      std::copy(compactAreas.begin(), compactAreas.end(), ws.chf->areas);
+    }
+
+    VariantData& variant = data[i];
+    if (!buildTileDataFromCompact(variants[i], cfg, 0, 0, ctx, ws,
+                                  variant.navData, variant.navDataSize,
+                                  variant.numPolys, variant.numVerts)) {
+      success = false;
+      break;
+    }
+  }
+
+  if (!success) {
+    for (VariantData& variant : data) {
+      dtFree(variant.navData);
+    }
+    data.assign(variants.size(), VariantData{});
+  }
+  return success;
+}
+
+//! The bounds of the vertices of a mesh
+std::pair<vec3f, vec3f> meshBounds(const esp::assets::MeshData& mesh) {
   const float mf = std::numeric_limits<float>::max();
   vec3f bmin(mf, mf, mf);
   vec3f bmax(-mf, -mf, -mf);
 
-  for (int i = 0; i < numVerts; i++) {
-    const vec3f& p = mesh.vbo[i];
+  for (const vec3f& p : mesh.vbo) {
     bmin = bmin.cwiseMin(p);
     bmax = bmax.cwiseMax(p);
   }
+  return std::make_pair(bmin, bmax);
+}
+
+//! Run func(i, threadIndex) for all i in [0, numItems) on numThreads threads
+//! of the shared scheduler including the calling one, all if zero or less
+template <typename F>
+void parallelFor(size_t numItems, int numThreads, F&& func) {
+  core::TaskScheduler::global().parallelFor(numItems, numThreads, func);
+}
+}  // namespace
+
+bool PathFinder::Impl::build(const NavMeshSettings& bs,
+                             const float* verts,
+                             const int nverts,
+                             const int* tris,
+                             const int ntris,
+                             const float* bmin,
+                             const float* bmax) {
+  core::ScopedTraceEvent trace{"PathFinder::build", "nav"};
+  //
+  // Step 1. Initialize build config.
+  //
+
+  rcConfig cfg = makeConfig(bs);
+  if (cfg.maxVertsPerPoly > DT_VERTS_PER_POLYGON) {
+    LOG(ERROR) << "Detour supports at most " << DT_VERTS_PER_POLYGON
+               << " vertices per polygon";
+    return false;
+  }
+
+  // Set the area where the navigation will be build.
+  // Here the bounds of the input mesh are used, but the
+  // area could be specified by an user defined box, etc.
+  rcVcopy(cfg.bmin, bmin);
+  rcVcopy(cfg.bmax, bmax);
+  rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
+  LOG(INFO) << "Building navmesh with " << cfg.width << "x" << cfg.height
+            << " cells";
+
+  if (bs.tileSize > 0) {
+    if (isLoaded() && tiledBuild_ && tiledBuild_->settings == bs &&
+        rcVdistSqr(tiledBuild_->cfg.bmin, cfg.bmin) == 0.0f &&
+        rcVdistSqr(tiledBuild_->cfg.bmax, cfg.bmax) == 0.0f) {
+      // same tile grid, keep the tiles whose geometry did not change
+      return rebuildTiles(verts, nverts, tris, ntris, 0, 0,
+                          tiledBuild_->numTilesX - 1,
+                          tiledBuild_->numTilesY - 1,
+                          /*onlyChanged=*/true) &&
+             finishBuild();
+    }
+    return buildTiled(bs, cfg, verts, nverts, tris, ntris) && finishBuild();
+  }
+  tiledBuild_ = Cr::Containers::NullOpt;
 
-  int* indices = new int[numIndices];
-  for (int i = 0; i < numIndices; i++) {
-    indices[i] = static_cast<int>(mesh.ibo[i]);
+  unsigned char* navData = nullptr;
+  int navDataSize = 0;
+  int numPolys = 0, numVerts = 0;
+  if (!buildTileData(bs, cfg, 0, 0, verts, nverts, tris, ntris, navData,
+                     navDataSize, numPolys, numVerts)) {
+    return false;
+  }
+  if (!navData) {
+    LOG(ERROR) << "Could not build Detour navmesh, no walkable surface";
+    return false;
   }
 
-  const bool success = build(bs, mesh.vbo[0].data(), numVerts, indices,
-                             numIndices / 3, bmin.data(), bmax.data());
-  delete[] indices;
+  LOG(INFO) << "Created navmesh with " << numVerts << " vertices " << numPolys
+            << " polygons";
+
+  return initSingleTile(navData, navDataSize);
+}
+
+bool PathFinder::Impl::initSingleTile(unsigned char* navData,
+                                      int navDataSize) {
+  navMesh_.reset(dtAllocNavMesh());
+  navMeshFile_.reset();
+  evictedTiles_.clear();
+  streaming_ = false;
+  if (!navMesh_) {
+    dtFree(navData);
+    LOG(ERROR) << "Could not allocate Detour navmesh";
+    return false;
+  }
+
+  dtStatus status;
+  status = navMesh_->init(navData, navDataSize, DT_TILE_FREE_DATA);
+  if (dtStatusFailed(status)) {
+    dtFree(navData);
+    LOG(ERROR) << "Could not init Detour navmesh";
+    return false;
+  }
+
+  return finishBuild();
+}
+
+bool PathFinder::Impl::buildTiled(const NavMeshSettings& bs,
+                                  const rcConfig& cfg,
+                                  const float* verts,
+                                  const int nverts,
+                                  const int* tris,
+                                  const int ntris) {
+  TiledBuild tiled;
+  tiled.settings = bs;
+  tiled.cfg = cfg;
+  tiled.cfg.tileSize = static_cast<int>(bs.tileSize);
+  // tiles overlap by a border, so the erosion and region partitioning near
+  // tile edges see the neighbouring geometry
+  tiled.cfg.borderSize = cfg.walkableRadius + 3;
+  tiled.cfg.width = tiled.cfg.tileSize + 2 * tiled.cfg.borderSize;
+  tiled.cfg.height = tiled.cfg.tileSize + 2 * tiled.cfg.borderSize;
+  tiled.numTilesX = (cfg.width + tiled.cfg.tileSize - 1) / tiled.cfg.tileSize;
+  tiled.numTilesY = (cfg.height + tiled.cfg.tileSize - 1) / tiled.cfg.tileSize;
+  tiled.tileHashes.assign(tiled.numTilesX * tiled.numTilesY, 0);
+
+  // the bits of a 32-bit dtPolyRef are shared between tile and polygon ids
+  const int tileBits = std::min<int>(
+      dtIlog2(dtNextPow2(tiled.numTilesX * tiled.numTilesY)), 14);
+  if ((1 << tileBits) < tiled.numTilesX * tiled.numTilesY) {
+    LOG(ERROR) << "Too many navmesh tiles (" << tiled.numTilesX << "x"
+               << tiled.numTilesY << "), increase NavMeshSettings::tileSize";
+    return false;
+  }
+
+  dtNavMeshParams params;
+  memset(&params, 0, sizeof(params));
+  rcVcopy(params.orig, cfg.bmin);
+  params.tileWidth = tiled.cfg.tileSize * cfg.cs;
+  params.tileHeight = tiled.cfg.tileSize * cfg.cs;
+  params.maxTiles = 1 << tileBits;
+  params.maxPolys = 1 << (22 - tileBits);
+
+  navMesh_.reset(dtAllocNavMesh());
+  navMeshFile_.reset();
+  evictedTiles_.clear();
+  streaming_ = false;
+  if (!navMesh_) {
+    LOG(ERROR) << "Could not allocate Detour navmesh";
+    return false;
+  }
+  if (dtStatusFailed(navMesh_->init(&params))) {
+    LOG(ERROR) << "Could not init Detour navmesh";
+    return false;
+  }
+
+  tiledBuild_ = tiled;
+  LOG(INFO) << "Building navmesh in " << tiled.numTilesX << "x"
+            << tiled.numTilesY << " tiles";
+  return rebuildTiles(verts, nverts, tris, ntris, 0, 0, tiled.numTilesX - 1,
+                      tiled.numTilesY - 1);
+}
+
+bool PathFinder::Impl::rebuildTiles(const float* verts,
+                                    const int nverts,
+                                    const int* tris,
+                                    const int ntris,
+                                    const int minTileX,
+                                    const int minTileY,
+                                    const int maxTileX,
+                                    const int maxTileY,
+                                    const bool onlyChanged /* = false */) {
+  CORRADE_INTERNAL_ASSERT(tiledBuild_);
+  TiledBuild& tiled = *tiledBuild_;
+  const float tileWidth = tiled.cfg.tileSize * tiled.cfg.cs;
+  const float border = tiled.cfg.borderSize * tiled.cfg.cs;
+  const int numTilesX = maxTileX - minTileX + 1;
+  const int numTilesY = maxTileY - minTileY + 1;
+
+  // bin the triangles into the tiles their bounds overlap, borders included
+  std::vector<std::vector<int>> tileTris(numTilesX * numTilesY);
+  for (int iTri = 0; iTri < ntris; ++iTri) {
+    float triMin[2] = {std::numeric_limits<float>::max(),
+                       std::numeric_limits<float>::max()};
+    float triMax[2] = {-std::numeric_limits<float>::max(),
+                       -std::numeric_limits<float>::max()};
+    for (int iVert = 0; iVert < 3; ++iVert) {
+      const float* v = &verts[tris[3 * iTri + iVert] * 3];
+      triMin[0] = std::min(triMin[0], v[0]);
+      triMin[1] = std::min(triMin[1], v[2]);
+      triMax[0] = std::max(triMax[0], v[0]);
+      triMax[1] = std::max(triMax[1], v[2]);
+    }
+    const int x0 = std::max(
+        minTileX, static_cast<int>(std::floor(
+                      (triMin[0] - border - tiled.cfg.bmin[0]) / tileWidth)));
+    const int y0 = std::max(
+        minTileY, static_cast<int>(std::floor(
+                      (triMin[1] - border - tiled.cfg.bmin[2]) / tileWidth)));
+    const int x1 = std::min(
+        maxTileX, static_cast<int>(std::floor(
+                      (triMax[0] + border - tiled.cfg.bmin[0]) / tileWidth)));
+    const int y1 = std::min(
+        maxTileY, static_cast<int>(std::floor(
+                      (triMax[1] + border - tiled.cfg.bmin[2]) / tileWidth)));
+    for (int y = y0; y <= y1; ++y) {
+      for (int x = x0; x <= x1; ++x) {
+        std::vector<int>& bin =
+            tileTris[(y - minTileY) * numTilesX + (x - minTileX)];
+        bin.insert(bin.end(), &tris[3 * iTri], &tris[3 * iTri + 3]);
+      }
+    }
+  }
+
+  // the tiles are independent, build them in parallel and add them after
+  struct TileResult {
+    unsigned char* navData = nullptr;
+    int navDataSize = 0;
+    int numPolys = 0;
+    int numVerts = 0;
+    bool success = false;
+    //! the geometry of the tile did not change, it is kept as is
+    bool unchanged = false;
+  };
+  std::vector<TileResult> results(tileTris.size());
+  parallelFor(tileTris.size(), 0, [&](size_t i, int) {
+    core::ScopedTraceEvent trace{"PathFinder::buildTile", "nav"};
+    const int x = minTileX + i % numTilesX;
+    const int y = minTileY + i / numTilesX;
+    TileResult& result = results[i];
+    // FNV-1a of the vertex positions of the triangles binned into the tile
+    uint64_t hash = 14695981039346656037ull;
+    for (const int index : tileTris[i]) {
+      const unsigned char* bytes =
+          reinterpret_cast<const unsigned char*>(&verts[index * 3]);
+      for (size_t iByte = 0; iByte < 3 * sizeof(float); ++iByte) {
+        hash = (hash ^ bytes[iByte]) * 1099511628211ull;
+      }
+    }
+    uint64_t& tileHash = tiled.tileHashes[y * tiled.numTilesX + x];
+    if (onlyChanged && tileHash == hash) {
+      result.success = true;
+      result.unchanged = true;
+      return;
+    }
+    rcConfig cfg = tiled.cfg;
+    cfg.bmin[0] = tiled.cfg.bmin[0] + x * tileWidth - border;
+    cfg.bmin[2] = tiled.cfg.bmin[2] + y * tileWidth - border;
+    cfg.bmax[0] = tiled.cfg.bmin[0] + (x + 1) * tileWidth + border;
+    cfg.bmax[2] = tiled.cfg.bmin[2] + (y + 1) * tileWidth + border;
+    result.success = buildTileData(
+        tiled.settings, cfg, x, y, verts, nverts, tileTris[i].data(),
+        tileTris[i].size() / 3, result.navData, result.navDataSize,
+        result.numPolys, result.numVerts);
+    // a failed tile is built again next time
+    tileHash = result.success ? hash : 0;
+  });
+
+  bool success = true;
+  int numPolys = 0, numVerts = 0;
+  size_t numRebuilt = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const int x = minTileX + i % numTilesX;
+    const int y = minTileY + i / numTilesX;
+    TileResult& result = results[i];
+    if (result.unchanged)
+      continue;
+    ++numRebuilt;
+    navMesh_->removeTile(navMesh_->getTileRefAt(x, y, 0), nullptr, nullptr);
+    success = success && result.success;
+    if (!result.navData)
+      continue;
+    if (dtStatusFailed(navMesh_->addTile(result.navData, result.navDataSize,
+                                         DT_TILE_FREE_DATA, 0, nullptr))) {
+      dtFree(result.navData);
+      LOG(ERROR) << "Could not add navmesh tile " << x << "," << y;
+      success = false;
+      continue;
+    }
+    numPolys += result.numPolys;
+    numVerts += result.numVerts;
+  }
+
+  LOG(INFO) << "Rebuilt " << numRebuilt << " of " << results.size()
+            << " navmesh tiles with " << numVerts << " vertices " << numPolys
+            << " polygons";
+  return success;
+}
+
+bool PathFinder::Impl::updateRegion(const esp::assets::MeshData& mesh,
+                                    const vec3f& regionMin,
+                                    const vec3f& regionMax) {
+  if (!isLoaded() || !tiledBuild_) {
+    LOG(ERROR) << "PathFinder::updateRegion: the navmesh was not built with "
+                  "NavMeshSettings::tileSize > 0";
+    return false;
+  }
+  // the rebuilt tiles replace the evicted ones, and the islands are built
+  // on all of them
+  const AllTilesScope allTiles{*this};
+  const TiledBuild& tiled = *tiledBuild_;
+  const float tileWidth = tiled.cfg.tileSize * tiled.cfg.cs;
+  const float border = tiled.cfg.borderSize * tiled.cfg.cs;
+
+  // tiles see the geometry up to a border around them
+  const int minTileX = std::max(
+      0, static_cast<int>(std::floor(
+             (regionMin[0] - border - tiled.cfg.bmin[0]) / tileWidth)));
+  const int minTileY = std::max(
+      0, static_cast<int>(std::floor(
+             (regionMin[2] - border - tiled.cfg.bmin[2]) / tileWidth)));
+  const int maxTileX = std::min(
+      tiled.numTilesX - 1,
+      static_cast<int>(std::floor((regionMax[0] + border - tiled.cfg.bmin[0]) /
+                                  tileWidth)));
+  const int maxTileY = std::min(
+      tiled.numTilesY - 1,
+      static_cast<int>(std::floor((regionMax[2] + border - tiled.cfg.bmin[2]) /
+                                  tileWidth)));
+  if (minTileX > maxTileX || minTileY > maxTileY) {
+    // the region is outside of the navmesh
+    return true;
+  }
+
+  const std::vector<int> indices =
+      navMeshInputIndices(mesh, tiled.settings, tiled.settings.agentHeight);
+  const bool success =
+      rebuildTiles(mesh.vbo[0].data(), mesh.vbo.size(), indices.data(),
+                   indices.size() / 3, minTileX, minTileY, maxTileX, maxTileY);
+  return finishBuild() && success;
+}
+
+bool PathFinder::Impl::finishBuild() {
+  if (!initNavQuery()) {
+    return false;
+  }
+
+  // Added as we also need to remove these on navmesh recomputation
+  removeZeroAreaPolys();
+
+  return true;
+}
+
+bool PathFinder::Impl::initNavQuery(
+    std::unique_ptr<impl::IslandSystem> islandSystem) {
+  // if we are reinitializing the NavQuery, then also reset the MeshData
+  meshData_.reset();
+  compressedNavMesh_ = Cr::Containers::NullOpt;
+  topDownViewCache_.clear();
+  clearPathCache();
+  samplingTable_ = Cr::Containers::NullOpt;
+  obstacleDistanceField_ = Cr::Containers::NullOpt;
+  pathHierarchy_ = nullptr;
+
+  navQuery_.reset(dtAllocNavMeshQuery());
+  queryPool_.clear();
+  static std::atomic<uint32_t> nextNavMeshVersion{0};
+  navMeshVersion_ = ++nextNavMeshVersion;
+  dtStatus status = navQuery_->init(navMesh_.get(), 2048);
+  if (dtStatusFailed(status)) {
+    LOG(ERROR) << "Could not init Detour navmesh query";
+    compressed_ = false;
+    return false;
+  }
+
+  if (islandSystem) {
+    islandSystem_ = std::move(islandSystem);
+  } else {
+    islandSystem_ =
+        std::make_unique<impl::IslandSystem>(navMesh_.get(), filter_.get());
+  }
+
+  // cleared last, the queries skipping decompressMutex_ see all of the above
+  compressed_ = false;
+  return true;
+}
+
+bool PathFinder::Impl::build(const NavMeshSettings& bs,
+                             const esp::assets::MeshData& mesh) {
+  const int numVerts = mesh.vbo.size();
+  const std::pair<vec3f, vec3f> bounds = meshBounds(mesh);
+
+  const std::vector<int> indices =
+      navMeshInputIndices(mesh, bs, bs.agentHeight);
+  return build(bs, mesh.vbo[0].data(), numVerts, indices.data(),
+               indices.size() / 3, bounds.first.data(), bounds.second.data());
+}
+
+bool PathFinder::Impl::buildVariants(
+    const std::vector<NavMeshSettings>& variants,
+    const esp::assets::MeshData& mesh,
+    const std::vector<Impl*>& impls) {
+  core::ScopedTraceEvent trace{"PathFinder::buildVariants", "nav"};
+  CORRADE_INTERNAL_ASSERT(variants.size() == impls.size());
+  // one rasterization only fits single tile variants differing in the
+  // agent radius and height, the others are built one by one
+  bool shared = !variants.empty() && !mesh.vbo.empty();
+  for (const NavMeshSettings& variant : variants) {
+    NavMeshSettings rest = variant;
+    rest.agentRadius = variants[0].agentRadius;
+    rest.agentHeight = variants[0].agentHeight;
+    shared = shared && rest == variants[0] && variant.tileSize <= 0 &&
+             makeConfig(variant).maxVertsPerPoly <= DT_VERTS_PER_POLYGON;
+  }
+  if (!shared) {
+    bool success = true;
+    for (size_t i = 0; i < variants.size(); ++i) {
+      success = impls[i]->build(variants[i], mesh) && success;
+    }
+    return success;
+  }
+
+  const std::pair<vec3f, vec3f> bounds = meshBounds(mesh);
+  float agentHeight = 0.0f;
+  for (const NavMeshSettings& variant : variants) {
+    agentHeight = std::max(agentHeight, variant.agentHeight);
+  }
+  const std::vector<int> indices =
+      navMeshInputIndices(mesh, variants[0], agentHeight);
+  std::vector<VariantData> data;
+  if (!buildVariantData(variants, bounds.first.data(), bounds.second.data(),
+                        mesh.vbo[0].data(), mesh.vbo.size(), indices.data(),
+                        indices.size() / 3, data)) {
+    return false;
+  }
+  bool success = true;
+  for (size_t i = 0; i < variants.size(); ++i) {
+    if (!data[i].navData) {
+      LOG(ERROR) << "Could not build Detour navmesh for agent radius "
+                 << variants[i].agentRadius << ", no walkable surface";
+      success = false;
+      continue;
+    }
+    LOG(INFO) << "Created navmesh for agent radius " << variants[i].agentRadius
+              << " and height " << variants[i].agentHeight << " with "
+              << data[i].numVerts << " vertices " << data[i].numPolys
+              << " polygons";
+    impls[i]->tiledBuild_ = Cr::Containers::NullOpt;
+    success = impls[i]->initSingleTile(data[i].navData, data[i].navDataSize) &&
+              success;
+  }
   return success;
 }
 
@@ -711,6 +2206,63 @@ struct NavMeshTileHeader {
   int dataSize;
 };
 
+// Container meant to be memory mapped: the header, a table of all tiles, the
+// tile data each starting at a page boundary, and the islands
+const int NAVMESHMAP_MAGIC = 'M' << 24 | 'N' << 16 | 'A' << 8 | 'V';  //'MNAV';
+const int NAVMESHMAP_VERSION = 1;
+//! Larger than or a multiple of the page size on all supported platforms, so
+//! copying a page written by Detour never copies another tile with it
+const uint64_t NAVMESHMAP_TILE_ALIGNMENT = 4096;
+
+struct NavMeshMapHeader {
+  int magic;
+  int version;
+  int numTiles;
+  int reserved;
+  dtNavMeshParams params;
+  uint64_t islandsOffset;
+};
+
+struct NavMeshMapTile {
+  uint64_t tileRef;
+  uint64_t dataOffset;
+  uint64_t dataSize;
+};
+
+// Container of the navmeshes of several agents: the header, then each
+// navmesh, preceded by its size in bytes, in the default format with its
+// islands
+const int NAVMESHVARIANTS_MAGIC =
+    'M' << 24 | 'V' << 16 | 'A' << 8 | 'R';  //'MVAR';
+const int NAVMESHVARIANTS_VERSION = 1;
+
+struct NavMeshVariantsHeader {
+  int magic;
+  int version;
+  int numVariants;
+  int reserved;
+};
+
+uint64_t alignTileOffset(uint64_t offset) {
+  return (offset + NAVMESHMAP_TILE_ALIGNMENT - 1) /
+         NAVMESHMAP_TILE_ALIGNMENT * NAVMESHMAP_TILE_ALIGNMENT;
+}
+
+//! The bounds of all tiles of a navmesh
+std::pair<vec3f, vec3f> tileBounds(const dtNavMesh* navMesh) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  Eigen::Array3f bmin{inf, inf, inf};
+  Eigen::Array3f bmax{-inf, -inf, -inf};
+  for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+    const dtMeshTile* tile = navMesh->getTile(i);
+    if (!tile || !tile->header)
+      continue;
+    bmin = bmin.min(Eigen::Array3f{tile->header->bmin});
+    bmax = bmax.max(Eigen::Array3f{tile->header->bmax});
+  }
+  return std::make_pair(vec3f(bmin), vec3f(bmax));
+}
+
 struct Triangle {
   std::vector<vec3f> v;
   Triangle() { v.resize(3); }
@@ -766,7 +2318,7 @@ void PathFinder::Impl::removeZeroAreaPolys() {
   for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
     const dtMeshTile* tile =
         const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
-    if (!tile)
+    if (!tile || !tile->header)
       continue;
 
     // Iterate over all polygons in a tile
@@ -791,37 +2343,77 @@ void PathFinder::Impl::removeZeroAreaPolys() {
 }
 
 bool PathFinder::Impl::loadNavMesh(const std::string& path) {
+  core::ScopedTraceEvent trace{"PathFinder::loadNavMesh", "nav"};
   FILE* fp = fopen(path.c_str(), "rb");
   if (!fp)
     return false;
 
+  int magic = 0;
+  if (fread(&magic, sizeof(magic), 1, fp) != 1) {
+    fclose(fp);
+    return false;
+  }
+  rewind(fp);
+
+  NavMeshPtr mesh;
+  MappedFilePtr mappedFile;
+  if (magic == NAVMESHMAP_MAGIC) {
+    mesh = loadMappedNavMesh(fp, mappedFile);
+  } else {
+    mesh = loadNavMeshSet(fp);
+  }
+  if (!mesh) {
+    fclose(fp);
+    return false;
+  }
+
+  // files written by older versions end here and need a flood fill
+  std::unique_ptr<impl::IslandSystem> islandSystem =
+      impl::IslandSystem::read(fp, mesh.get());
+
+  fclose(fp);
+
+  return useLoadedNavMesh(std::move(mesh), std::move(mappedFile),
+                          std::move(islandSystem));
+}
+
+bool PathFinder::Impl::useLoadedNavMesh(
+    NavMeshPtr mesh,
+    MappedFilePtr mappedFile,
+    std::unique_ptr<impl::IslandSystem> islandSystem) {
+  navMesh_ = std::move(mesh);
+  navMeshFile_ = std::move(mappedFile);
+  evictedTiles_.clear();
+  streaming_ = false;
+  bounds_ = tileBounds(navMesh_.get());
+  tiledBuild_ = Cr::Containers::NullOpt;
+
+  removeZeroAreaPolys();
+
+  return initNavQuery(std::move(islandSystem));
+}
+
+PathFinder::Impl::NavMeshPtr PathFinder::Impl::loadNavMeshSet(FILE* fp) {
   // Read header.
   NavMeshSetHeader header;
   size_t readLen = fread(&header, sizeof(NavMeshSetHeader), 1, fp);
   if (readLen != 1) {
-    fclose(fp);
-    return false;
+    return nullptr;
   }
   if (header.magic != NAVMESHSET_MAGIC) {
-    fclose(fp);
-    return false;
+    return nullptr;
   }
   if (header.version != NAVMESHSET_VERSION) {
-    fclose(fp);
-    return false;
+    return nullptr;
   }
 
-  vec3f bmin, bmax;
-
-  dtNavMesh* mesh = dtAllocNavMesh();
+  NavMeshPtr mesh{dtAllocNavMesh()};
   if (!mesh) {
-    fclose(fp);
-    return false;
+    return nullptr;
   }
   dtStatus status = mesh->init(&header.params);
   if (dtStatusFailed(status)) {
-    fclose(fp);
-    return false;
+    return nullptr;
   }
 
   // Read tiles.
@@ -829,8 +2421,7 @@ bool PathFinder::Impl::loadNavMesh(const std::string& path) {
     NavMeshTileHeader tileHeader;
     readLen = fread(&tileHeader, sizeof(tileHeader), 1, fp);
     if (readLen != 1) {
-      fclose(fp);
-      return false;
+      return nullptr;
     }
 
     if (!tileHeader.tileRef || !tileHeader.dataSize)
@@ -844,41 +2435,164 @@ bool PathFinder::Impl::loadNavMesh(const std::string& path) {
     readLen = fread(data, tileHeader.dataSize, 1, fp);
     if (readLen != 1) {
       dtFree(data);
-      fclose(fp);
-      return false;
+      return nullptr;
     }
 
     mesh->addTile(data, tileHeader.dataSize, DT_TILE_FREE_DATA,
                   tileHeader.tileRef, 0);
-    const dtMeshTile* tile = mesh->getTileByRef(tileHeader.tileRef);
-    if (i == 0) {
-      bmin = vec3f(tile->header->bmin);
-      bmax = vec3f(tile->header->bmax);
-    } else {
-      bmin = bmin.array().min(Eigen::Array3f{tile->header->bmin});
-      bmax = bmax.array().max(Eigen::Array3f{tile->header->bmax});
-    }
   }
 
-  fclose(fp);
+  return mesh;
+}
 
-  navMesh_.reset(mesh);
-  bounds_ = std::make_pair(bmin, bmax);
+PathFinder::Impl::NavMeshPtr PathFinder::Impl::loadMappedNavMesh(
+    FILE* fp,
+    MappedFilePtr& mappedFile) {
+#ifndef CORRADE_TARGET_UNIX
+  LOG(ERROR) << "Memory mapped navmesh files are not supported on this "
+                "platform, save it without mappable";
+  return nullptr;
+#else
+  NavMeshMapHeader header;
+  if (fread(&header, sizeof(header), 1, fp) != 1 ||
+      header.magic != NAVMESHMAP_MAGIC) {
+    return nullptr;
+  }
+  if (header.version != NAVMESHMAP_VERSION) {
+    LOG(ERROR) << "Unsupported navmesh file version " << header.version;
+    return nullptr;
+  }
+  // the tile table of a corrupt file would size a huge allocation, it has to
+  // fit what is left of the file
+  struct stat fileStat;
+  const long tableOffset = ftell(fp);
+  if (tableOffset < 0 || fstat(fileno(fp), &fileStat) != 0 ||
+      static_cast<uint64_t>(fileStat.st_size) < header.islandsOffset ||
+      fileStat.st_size < tableOffset) {
+    return nullptr;
+  }
+  const uint64_t remaining =
+      static_cast<uint64_t>(fileStat.st_size) - uint64_t(tableOffset);
+  if (header.numTiles < 0 || header.numTiles > header.params.maxTiles ||
+      uint64_t(header.numTiles) * sizeof(NavMeshMapTile) > remaining) {
+    LOG(ERROR) << "Corrupted navmesh file, invalid tile count";
+    return nullptr;
+  }
+  std::vector<NavMeshMapTile> tiles(header.numTiles);
+  if (fread(tiles.data(), sizeof(NavMeshMapTile), tiles.size(), fp) !=
+      tiles.size()) {
+    return nullptr;
+  }
 
-  removeZeroAreaPolys();
+  for (const NavMeshMapTile& tile : tiles) {
+    // checked without a sum which could wrap around
+    if (tile.dataOffset % NAVMESHMAP_TILE_ALIGNMENT ||
+        tile.dataOffset > header.islandsOffset ||
+        tile.dataSize > header.islandsOffset - tile.dataOffset ||
+        tile.dataSize > uint64_t(std::numeric_limits<int>::max())) {
+      LOG(ERROR) << "Corrupted navmesh file, tile data out of range";
+      return nullptr;
+    }
+  }
+
+  // Detour writes the links and the polygon flags into the tile data, so the
+  // mapping is private: pages stay shared with the page cache, and with other
+  // processes mapping the same file, until Detour writes to them. The
+  // vertices, detail meshes and BV trees are never copied.
+  const size_t mapSize = header.islandsOffset;
+  void* data = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fileno(fp), 0);
+  if (data == MAP_FAILED) {
+    LOG(ERROR) << "Could not map the navmesh file";
+    return nullptr;
+  }
+  MappedFilePtr mapped{static_cast<unsigned char*>(data),
+                       MappedFileDeleter{mapSize}};
+
+  NavMeshPtr mesh{dtAllocNavMesh()};
+  if (!mesh || dtStatusFailed(mesh->init(&header.params))) {
+    return nullptr;
+  }
+  for (const NavMeshMapTile& tile : tiles) {
+    // the data is owned by the mapping
+    if (dtStatusFailed(mesh->addTile(mapped.get() + tile.dataOffset,
+                                     tile.dataSize, 0, tile.tileRef,
+                                     nullptr))) {
+      LOG(ERROR) << "Could not add a mapped navmesh tile";
+      return nullptr;
+    }
+  }
 
-  return initNavQuery();
+  if (fseek(fp, header.islandsOffset, SEEK_SET) != 0) {
+    return nullptr;
+  }
+  mappedFile = std::move(mapped);
+  return mesh;
+#endif
 }
 
-bool PathFinder::Impl::saveNavMesh(const std::string& path) {
+bool PathFinder::Impl::saveNavMesh(const std::string& path, bool mappable) {
   const dtNavMesh* navMesh = navMesh_.get();
   if (!navMesh)
     return false;
 
+  // the file has all tiles, not only the ones streamed in
+  const AllTilesScope allTiles{*this};
+  if (!evictedTiles_.empty()) {
+    LOG(ERROR) << "saveNavMesh: Could not restore the evicted tiles";
+    return false;
+  }
+
   FILE* fp = fopen(path.c_str(), "wb");
   if (!fp)
     return false;
 
+  bool success = mappable ? writeMappedNavMesh(fp) : writeNavMeshSet(fp);
+
+  // older versions stop reading after the tiles
+  success = success && (!islandSystem_ || islandSystem_->write(fp));
+
+  fclose(fp);
+
+  return success;
+}
+
+bool PathFinder::Impl::writeVariant(FILE* fp) const {
+  // the size is only known once the entry is written
+  const long start = ftell(fp);
+  uint64_t size = 0;
+  if (start < 0 || fwrite(&size, sizeof(size), 1, fp) != 1)
+    return false;
+
+  // the tiles are read, the entries are not page aligned for a mapping
+  bool success = writeNavMeshSet(fp);
+  success = success && (!islandSystem_ || islandSystem_->write(fp));
+
+  const long end = ftell(fp);
+  size = end - start - sizeof(size);
+  return success && end >= 0 && fseek(fp, start, SEEK_SET) == 0 &&
+         fwrite(&size, sizeof(size), 1, fp) == 1 &&
+         fseek(fp, end, SEEK_SET) == 0;
+}
+
+bool PathFinder::Impl::readVariant(FILE* fp, long end) {
+  NavMeshPtr mesh = loadNavMeshSet(fp);
+  if (!mesh)
+    return false;
+
+  // the islands end the entry, they are read if there are any before it
+  std::unique_ptr<impl::IslandSystem> islandSystem;
+  if (ftell(fp) < end)
+    islandSystem = impl::IslandSystem::read(fp, mesh.get());
+
+  return useLoadedNavMesh(std::move(mesh),
+                          MappedFilePtr{nullptr, MappedFileDeleter{0}},
+                          std::move(islandSystem));
+}
+
+bool PathFinder::Impl::writeNavMeshSet(FILE* fp) const {
+  const dtNavMesh* navMesh = navMesh_.get();
+
   // Store header.
   NavMeshSetHeader header;
   header.magic = NAVMESHSET_MAGIC;
@@ -907,34 +2621,202 @@ bool PathFinder::Impl::saveNavMesh(const std::string& path) {
     fwrite(tile->data, tile->dataSize, 1, fp);
   }
 
-  fclose(fp);
+  return !ferror(fp);
+}
 
-  return true;
+bool PathFinder::Impl::writeMappedNavMesh(FILE* fp) const {
+  const dtNavMesh* navMesh = navMesh_.get();
+
+  std::vector<const dtMeshTile*> tiles;
+  for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+    const dtMeshTile* tile = navMesh->getTile(i);
+    if (tile && tile->header && tile->dataSize)
+      tiles.push_back(tile);
+  }
+
+  // lay out the tiles after the tile table
+  std::vector<NavMeshMapTile> tileTable(tiles.size());
+  uint64_t offset =
+      sizeof(NavMeshMapHeader) + tiles.size() * sizeof(NavMeshMapTile);
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    offset = alignTileOffset(offset);
+    tileTable[i].tileRef = navMesh->getTileRef(tiles[i]);
+    tileTable[i].dataOffset = offset;
+    tileTable[i].dataSize = tiles[i]->dataSize;
+    offset += tiles[i]->dataSize;
+  }
+
+  NavMeshMapHeader header{};
+  header.magic = NAVMESHMAP_MAGIC;
+  header.version = NAVMESHMAP_VERSION;
+  header.numTiles = tiles.size();
+  memcpy(&header.params, navMesh->getParams(), sizeof(dtNavMeshParams));
+  header.islandsOffset = offset;
+  fwrite(&header, sizeof(header), 1, fp);
+  fwrite(tileTable.data(), sizeof(NavMeshMapTile), tileTable.size(), fp);
+
+  const std::vector<char> padding(NAVMESHMAP_TILE_ALIGNMENT, 0);
+  uint64_t written =
+      sizeof(NavMeshMapHeader) + tiles.size() * sizeof(NavMeshMapTile);
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    fwrite(padding.data(), 1, tileTable[i].dataOffset - written, fp);
+    fwrite(tiles[i]->data, tiles[i]->dataSize, 1, fp);
+    written = tileTable[i].dataOffset + tileTable[i].dataSize;
+  }
+
+  return !ferror(fp);
 }
 
 void PathFinder::Impl::seed(uint32_t newSeed) {
-  // TODO: this should be using core::Random instead, but passing function
-  // to navQuery_->findRandomPoint needs to be figured out first
-  srand(newSeed);
+  random_.seed(newSeed);
 }
 
-// Returns a random number [0..1]
-static float frand() {
-  return static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+const PathFinder::Impl::SamplingTable& PathFinder::Impl::samplingTable() {
+  if (samplingTable_)
+    return *samplingTable_;
+
+  const AllTilesScope allTiles{*this};
+  const uint32_t numIslands = islandSystem_->numIslands();
+  std::vector<std::vector<vec3f>> islandVerts(numIslands);
+  std::vector<std::vector<double>> islandAreas(numIslands);
+  const dtNavMesh* navMesh = navMesh_.get();
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    const dtPolyRef base = navMesh->getPolyRefBase(tile);
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPoly* poly = &tile->polys[jPoly];
+      const dtPolyRef ref = base | jPoly;
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter_->passFilter(ref, tile, poly))
+        continue;
+      const uint32_t island = islandSystem_->islandId(ref);
+      if (island == impl::IslandSystem::NoIsland)
+        continue;
+
+      for (const Triangle& tri : getPolygonTriangles(poly, tile)) {
+        // weighted by the area seen from above, as findRandomPoint() does
+        const float area = 0.5f * std::abs(dtTriArea2D(
+                                      tri.v[0].data(), tri.v[1].data(),
+                                      tri.v[2].data()));
+        if (area <= 0.0f)
+          continue;
+        islandVerts[island].insert(islandVerts[island].end(),
+                                   tri.v.begin(), tri.v.end());
+        islandAreas[island].push_back(area);
+      }
+    }
+  }
+
+  samplingTable_ = SamplingTable{};
+  SamplingTable& table = *samplingTable_;
+  table.islandOffsets.reserve(numIslands + 1);
+  double totalArea = 0.0;
+  for (uint32_t iIsland = 0; iIsland < numIslands; ++iIsland) {
+    table.islandOffsets.push_back(table.cumulativeArea.size());
+    table.verts.insert(table.verts.end(), islandVerts[iIsland].begin(),
+                       islandVerts[iIsland].end());
+    for (const double area : islandAreas[iIsland]) {
+      totalArea += area;
+      table.cumulativeArea.push_back(totalArea);
+    }
+  }
+  table.islandOffsets.push_back(table.cumulativeArea.size());
+  return table;
 }
 
-vec3f PathFinder::Impl::getRandomNavigablePoint() {
-  dtPolyRef ref;
+vec3f PathFinder::Impl::samplePoint(const SamplingTable& table,
+                                    int islandIndex,
+                                    const float* u) {
+  uint32_t begin = 0;
+  uint32_t end = table.cumulativeArea.size();
+  if (islandIndex != ID_UNDEFINED) {
+    begin = table.islandOffsets[islandIndex];
+    end = table.islandOffsets[islandIndex + 1];
+  }
   constexpr float inf = std::numeric_limits<float>::infinity();
-  vec3f pt(inf, inf, inf);
-  dtStatus status =
-      navQuery_->findRandomPoint(filter_.get(), frand, &ref, pt.data());
-  if (!dtStatusSucceed(status)) {
+  if (begin == end)
+    return vec3f(inf, inf, inf);
+
+  // the triangle is found by its share of the area ...
+  const double areaBegin = begin == 0 ? 0.0 : table.cumulativeArea[begin - 1];
+  const double areaEnd = table.cumulativeArea[end - 1];
+  const double area = areaBegin + u[0] * (areaEnd - areaBegin);
+  const uint32_t iTri = std::min<uint32_t>(
+      std::upper_bound(table.cumulativeArea.begin() + begin,
+                       table.cumulativeArea.begin() + end, area) -
+          table.cumulativeArea.begin(),
+      end - 1);
+
+  // ... and the point uniformly inside of it
+  const float s = std::sqrt(u[1]);
+  const float t = u[2];
+  const vec3f* v = &table.verts[3 * iTri];
+  return (1.0f - s) * v[0] + s * (1.0f - t) * v[1] + s * t * v[2];
+}
+
+vec3f PathFinder::Impl::getRandomNavigablePoint(int islandIndex) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  if (!isLoaded() || islandIndex < ID_UNDEFINED ||
+      islandIndex >= numIslands()) {
     LOG(ERROR) << "Failed to getRandomNavigablePoint";
+    return vec3f(inf, inf, inf);
+  }
+
+  float u[3];
+  random_.fill_uniform_float_01(u, 3);
+  const vec3f pt = samplePoint(samplingTable(), islandIndex, u);
+  if (!std::isfinite(pt[0])) {
+    // callers retry this in a loop, only log a sample of the failures
+    LOG_EVERY_N(ERROR, 1000) << "Failed to getRandomNavigablePoint";
   }
   return pt;
 }
 
+std::vector<vec3f> PathFinder::Impl::sampleNavigablePoints(int numPoints,
+                                                           int islandIndex) {
+  if (!isLoaded() || islandIndex < ID_UNDEFINED ||
+      islandIndex >= numIslands()) {
+    LOG(ERROR) << "Failed to sampleNavigablePoints, invalid island "
+               << islandIndex;
+    return {};
+  }
+
+  const SamplingTable& table = samplingTable();
+  // all random numbers drawn at once, three per point
+  std::vector<float> u(3 * std::max(numPoints, 0));
+  random_.fill_uniform_float_01(u.data(), u.size());
+  std::vector<vec3f> points;
+  points.reserve(std::max(numPoints, 0));
+  for (int i = 0; i < numPoints; ++i) {
+    points.emplace_back(samplePoint(table, islandIndex, &u[3 * i]));
+  }
+  if (numPoints > 0 && !std::isfinite(points[0][0])) {
+    LOG(ERROR) << "Failed to sampleNavigablePoints, no navigable area";
+    return {};
+  }
+  return points;
+}
+
+int PathFinder::Impl::getIslandIndex(const vec3f& pt) const {
+  dtPolyRef ptRef;
+  dtStatus status;
+  std::tie(status, ptRef, std::ignore) =
+      projectToPoly(pt, query(), filter_.get());
+  if (status != DT_SUCCESS || ptRef == 0)
+    return ID_UNDEFINED;
+
+  const uint32_t island = islandSystem_->islandId(ptRef);
+  return island == impl::IslandSystem::NoIsland ? ID_UNDEFINED
+                                                : static_cast<int>(island);
+}
+
+int PathFinder::Impl::numIslands() const {
+  return isLoaded() ? islandSystem_->numIslands() : 0;
+}
+
 namespace {
 float pathLength(const std::vector<vec3f>& points) {
   CORRADE_INTERNAL_ASSERT(points.size() > 0);
@@ -951,6 +2833,15 @@ float pathLength(const std::vector<vec3f>& points) {
 }  // namespace
 
 bool PathFinder::Impl::findPath(ShortestPath& path) {
+  PathCacheKey key;
+  if (pathCacheCapacity_ != 0) {
+    std::memcpy(key.data(), path.requestedStart.data(), 3 * sizeof(float));
+    std::memcpy(key.data() + 3, path.requestedEnd.data(), 3 * sizeof(float));
+    if (findCachedPath(key, path)) {
+      return path.geodesicDistance < std::numeric_limits<float>::infinity();
+    }
+  }
+
   MultiGoalShortestPath tmp;
   tmp.requestedStart = path.requestedStart;
   tmp.setRequestedEnds({path.requestedEnd});
@@ -959,11 +2850,75 @@ bool PathFinder::Impl::findPath(ShortestPath& path) {
 
   path.geodesicDistance = tmp.geodesicDistance;
   path.points = std::move(tmp.points);
+  if (pathCacheCapacity_ != 0) {
+    cachePath(key, path);
+  }
   return status;
 }
 
+void PathFinder::Impl::setPathCacheSize(size_t size) {
+  std::lock_guard<std::mutex> lock{pathCacheMutex_};
+  pathCacheCapacity_ = size;
+  while (pathCache_.size() > size) {
+    pathCacheIndex_.erase(pathCache_.back().key);
+    pathCache_.pop_back();
+  }
+}
+
+size_t PathFinder::Impl::getPathCacheSize() const {
+  std::lock_guard<std::mutex> lock{pathCacheMutex_};
+  return pathCache_.size();
+}
+
+size_t PathFinder::Impl::getPathCacheHits() const {
+  std::lock_guard<std::mutex> lock{pathCacheMutex_};
+  return pathCacheHits_;
+}
+
+size_t PathFinder::Impl::getPathCacheMisses() const {
+  std::lock_guard<std::mutex> lock{pathCacheMutex_};
+  return pathCacheMisses_;
+}
+
+bool PathFinder::Impl::findCachedPath(const PathCacheKey& key,
+                                      ShortestPath& path) {
+  std::lock_guard<std::mutex> lock{pathCacheMutex_};
+  const auto found = pathCacheIndex_.find(key);
+  if (found == pathCacheIndex_.end()) {
+    ++pathCacheMisses_;
+    return false;
+  }
+  ++pathCacheHits_;
+  pathCache_.splice(pathCache_.begin(), pathCache_, found->second);
+  path.geodesicDistance = found->second->geodesicDistance;
+  path.points = found->second->points;
+  return true;
+}
+
+void PathFinder::Impl::cachePath(const PathCacheKey& key,
+                                 const ShortestPath& path) {
+  std::lock_guard<std::mutex> lock{pathCacheMutex_};
+  // another thread may have searched the same path meanwhile
+  if (pathCacheCapacity_ == 0 || pathCacheIndex_.count(key)) {
+    return;
+  }
+  if (pathCache_.size() == pathCacheCapacity_) {
+    pathCacheIndex_.erase(pathCache_.back().key);
+    pathCache_.pop_back();
+  }
+  pathCache_.push_front(CachedPath{key, path.geodesicDistance, path.points});
+  pathCacheIndex_.emplace(key, pathCache_.begin());
+}
+
+void PathFinder::Impl::clearPathCache() {
+  std::lock_guard<std::mutex> lock{pathCacheMutex_};
+  pathCache_.clear();
+  pathCacheIndex_.clear();
+}
+
 Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-PathFinder::Impl::findPathInternal(const vec3f& start,
+PathFinder::Impl::findPathInternal(dtNavMeshQuery* query,
+                                   const vec3f& start,
                                    dtPolyRef startRef,
                                    const vec3f& pathStart,
                                    const vec3f& end,
@@ -979,30 +2934,150 @@ PathFinder::Impl::findPathInternal(const vec3f& start,
     return Cr::Containers::NullOpt;
   }
 
+  if (pathHierarchy_) {
+    Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+        hierarchical = findHierarchicalPath(query, start, startRef, pathStart,
+                                            end, endRef, pathEnd);
+    if (hierarchical) {
+      return hierarchical;
+    }
+  }
+
+  Cr::Containers::Optional<std::vector<vec3f>> points = findPathPoints(
+      query, start, startRef, pathStart, end, endRef, pathEnd);
+  if (!points) {
+    return Cr::Containers::NullOpt;
+  }
+
+  const float length = pathLength(*points);
+
+  return std::make_tuple(length, std::move(*points));
+}
+
+Cr::Containers::Optional<std::vector<vec3f>> PathFinder::Impl::findPathPoints(
+    dtNavMeshQuery* query,
+    const vec3f& start,
+    dtPolyRef startRef,
+    const vec3f& pathStart,
+    const vec3f& end,
+    dtPolyRef endRef,
+    const vec3f& pathEnd) {
   static const int MAX_POLYS = 256;
   dtPolyRef polys[MAX_POLYS];
 
   int numPolys = 0;
   dtStatus status =
-      navQuery_->findPath(startRef, endRef, pathStart.data(), pathEnd.data(),
-                          filter_.get(), polys, &numPolys, MAX_POLYS);
+      query->findPath(startRef, endRef, pathStart.data(), pathEnd.data(),
+                      filter_.get(), polys, &numPolys, MAX_POLYS);
   if (status != DT_SUCCESS || numPolys == 0) {
     return Cr::Containers::NullOpt;
   }
 
   int numPoints = 0;
   std::vector<vec3f> points(MAX_POLYS);
-  status = navQuery_->findStraightPath(start.data(), end.data(), polys,
-                                       numPolys, points[0].data(), 0, 0,
-                                       &numPoints, MAX_POLYS);
+  status = query->findStraightPath(start.data(), end.data(), polys, numPolys,
+                                   points[0].data(), 0, 0, &numPoints,
+                                   MAX_POLYS);
   if (status != DT_SUCCESS || numPoints == 0) {
     return Corrade::Containers::NullOpt;
   }
 
   points.resize(numPoints);
+  return points;
+}
 
-  const float length = pathLength(points);
+Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+PathFinder::Impl::findHierarchicalPath(dtNavMeshQuery* query,
+                                       const vec3f& start,
+                                       dtPolyRef startRef,
+                                       const vec3f& pathStart,
+                                       const vec3f& end,
+                                       dtPolyRef endRef,
+                                       const vec3f& pathEnd) {
+  // each Detour search crosses this many clusters
+  constexpr size_t SegmentClusters = 4;
+  const uint32_t startCluster = pathHierarchy_->clusterId(startRef);
+  const uint32_t endCluster = pathHierarchy_->clusterId(endRef);
+  if (startCluster == impl::PathHierarchy::NoCluster ||
+      endCluster == impl::PathHierarchy::NoCluster ||
+      startCluster == endCluster ||
+      (pathEnd - pathStart).norm() <
+          2 * SegmentClusters * pathHierarchy_->clusterSize()) {
+    return Cr::Containers::NullOpt;
+  }
+  const std::vector<const impl::PathHierarchy::Edge*> corridor =
+      pathHierarchy_->findCorridor(startCluster, endCluster);
+  if (corridor.size() < 2 * SegmentClusters) {
+    return Cr::Containers::NullOpt;
+  }
+
+  // from portal to portal along the corridor, the last segment takes the
+  // rest of it
+  std::vector<vec3f> points;
+  std::vector<size_t> joints;
+  vec3f segmentStart = start;
+  vec3f segmentPathStart = pathStart;
+  dtPolyRef segmentStartRef = startRef;
+  for (size_t i = SegmentClusters;; i += SegmentClusters) {
+    const bool last = i + SegmentClusters > corridor.size();
+    const Cr::Containers::Optional<std::vector<vec3f>> segment =
+        last ? findPathPoints(query, segmentStart, segmentStartRef,
+                              segmentPathStart, end, endRef, pathEnd)
+             : findPathPoints(query, segmentStart, segmentStartRef,
+                              segmentPathStart, corridor[i]->portal,
+                              corridor[i]->portalRef, corridor[i]->portal);
+    if (!segment) {
+      return Cr::Containers::NullOpt;
+    }
+    if (!points.empty()) {
+      // the start of the segment is the end of the previous one
+      joints.push_back(points.size() - 1);
+      points.insert(points.end(), segment->begin() + 1, segment->end());
+    } else {
+      points = *segment;
+    }
+    if (last) {
+      break;
+    }
+    segmentStart = segmentPathStart = corridor[i]->portal;
+    segmentStartRef = corridor[i]->portalRef;
+  }
+
+  // drop the corners at the portals where the path can go straight past them
+  static const int MAX_POLYS = 256;
+  dtPolyRef polys[MAX_POLYS];
+  for (auto joint = joints.rbegin(); joint != joints.rend(); ++joint) {
+    const size_t j = *joint;
+    if (j == 0 || j + 1 >= points.size()) {
+      continue;
+    }
+    dtStatus status;
+    dtPolyRef fromRef, toRef;
+    vec3f from, to;
+    std::tie(status, fromRef, from) =
+        projectToPoly(points[j - 1], query, filter_.get());
+    if (status != DT_SUCCESS || fromRef == 0) {
+      continue;
+    }
+    std::tie(status, toRef, to) =
+        projectToPoly(points[j + 1], query, filter_.get());
+    if (status != DT_SUCCESS || toRef == 0) {
+      continue;
+    }
+    float t = 0.0f;
+    vec3f hitNormal;
+    int numPolys = 0;
+    status = query->raycast(fromRef, from.data(), to.data(), filter_.get(), &t,
+                            hitNormal.data(), polys, &numPolys, MAX_POLYS);
+    // unobstructed and ending on the polygon of the next point, not on one
+    // above or below it
+    if (dtStatusSucceed(status) && t == FLT_MAX && numPolys > 0 &&
+        polys[numPolys - 1] == toRef) {
+      points.erase(points.begin() + j);
+    }
+  }
 
+  const float length = pathLength(points);
   return std::make_tuple(length, std::move(points));
 }
 
@@ -1015,7 +3090,7 @@ bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
   // find nearest polys and path
   dtStatus status;
   std::tie(status, startRef, pathStart) =
-      projectToPoly(path.requestedStart, navQuery_.get(), filter_.get());
+      projectToPoly(path.requestedStart, query(), filter_.get());
 
   if (status != DT_SUCCESS || startRef == 0) {
     return false;
@@ -1028,7 +3103,7 @@ bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
     dtPolyRef endRef;
     vec3f pathEnd;
     std::tie(status, endRef, pathEnd) =
-        projectToPoly(rqEnd, navQuery_.get(), filter_.get());
+        projectToPoly(rqEnd, query(), filter_.get());
 
     if (status != DT_SUCCESS || endRef == 0) {
       return false;
@@ -1082,7 +3157,8 @@ bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
 
     const Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
         findResult =
-            findPathInternal(path.requestedStart, startRef, pathStart,
+            findPathInternal(query(), path.requestedStart, startRef,
+                             pathStart,
                              path.pimpl_->requestedEnds[i],
                              path.pimpl_->endRefs[i], path.pimpl_->pathEnds[i]);
 
@@ -1093,7 +3169,356 @@ bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
     }
   }
 
-  return path.geodesicDistance < std::numeric_limits<float>::infinity();
+  return path.geodesicDistance < std::numeric_limits<float>::infinity();
+}
+
+Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+PathFinder::Impl::findPathBetween(dtNavMeshQuery* query,
+                                  const vec3f& start,
+                                  const vec3f& end) {
+  dtStatus status;
+  dtPolyRef startRef, endRef;
+  vec3f pathStart, pathEnd;
+  std::tie(status, startRef, pathStart) =
+      projectToPoly(start, query, filter_.get());
+  if (status != DT_SUCCESS || startRef == 0) {
+    return Cr::Containers::NullOpt;
+  }
+  std::tie(status, endRef, pathEnd) = projectToPoly(end, query, filter_.get());
+  if (status != DT_SUCCESS || endRef == 0) {
+    return Cr::Containers::NullOpt;
+  }
+
+  return findPathInternal(query, start, startRef, pathStart, end, endRef,
+                          pathEnd);
+}
+
+int PathFinder::Impl::growQueryPool(int numThreads) {
+  // dtNavMeshQuery keeps the search state, so every worker needs its own.
+  // The navmesh, island system and filter are only read.
+  while (queryPool_.size() < static_cast<size_t>(numThreads)) {
+    std::unique_ptr<dtNavMeshQuery, NavQueryDeleter> query{
+        dtAllocNavMeshQuery()};
+    if (dtStatusFailed(query->init(navMesh_.get(), 2048))) {
+      LOG(ERROR) << "Could not init Detour navmesh query";
+      break;
+    }
+    queryPool_.emplace_back(std::move(query));
+  }
+  return std::min<size_t>(numThreads, queryPool_.size());
+}
+
+template <typename F>
+void PathFinder::Impl::parallelForQueries(size_t numItems,
+                                          int numThreads,
+                                          F&& func) {
+  numThreads = growQueryPool(
+      core::TaskScheduler::global().concurrency(numItems, numThreads));
+
+  parallelFor(numItems, numThreads, [&](size_t i, int threadIndex) {
+    func(i, queryPool_[threadIndex].get());
+  });
+}
+
+void PathFinder::Impl::parallelForWorkers(
+    size_t numItems,
+    int numThreads,
+    const std::function<void(size_t, int)>& func) {
+  numThreads = growQueryPool(
+      core::TaskScheduler::global().concurrency(numItems, numThreads));
+
+  parallelFor(numItems, numThreads, [&](size_t i, int threadIndex) {
+    // the calling thread may already be a worker of another path finder
+    const void* previousOwner = workerQueryOwner;
+    dtNavMeshQuery* previousQuery = workerQuery;
+    workerQueryOwner = this;
+    workerQuery = queryPool_[threadIndex].get();
+    func(i, threadIndex);
+    workerQueryOwner = previousOwner;
+    workerQuery = previousQuery;
+  });
+}
+
+void PathFinder::Impl::findPathsBatch(std::vector<ShortestPath>& paths,
+                                      int numThreads) {
+  for (ShortestPath& path : paths) {
+    path.geodesicDistance = std::numeric_limits<float>::infinity();
+    path.points.clear();
+  }
+  if (!isLoaded()) {
+    return;
+  }
+
+  parallelForQueries(paths.size(), numThreads,
+              [&](size_t i, dtNavMeshQuery* query) {
+                ShortestPath& path = paths[i];
+                Cr::Containers::Optional<
+                    std::tuple<float, std::vector<vec3f>>>
+                    findResult = findPathBetween(query, path.requestedStart,
+                                                 path.requestedEnd);
+                if (findResult) {
+                  path.geodesicDistance = std::get<0>(*findResult);
+                  path.points = std::move(std::get<1>(*findResult));
+                }
+              });
+}
+
+std::vector<float> PathFinder::Impl::findDistancesBatch(
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends,
+    int numThreads) {
+  CORRADE_ASSERT(starts.size() == ends.size(),
+                 "PathFinder::findDistancesBatch(): expected as many starts "
+                 "as ends, got"
+                     << starts.size() << "and" << ends.size(),
+                 {});
+
+  std::vector<float> distances(starts.size(),
+                               std::numeric_limits<float>::infinity());
+  if (!isLoaded()) {
+    return distances;
+  }
+
+  parallelForQueries(starts.size(), numThreads,
+              [&](size_t i, dtNavMeshQuery* query) {
+                Cr::Containers::Optional<
+                    std::tuple<float, std::vector<vec3f>>>
+                    findResult = findPathBetween(query, starts[i], ends[i]);
+                if (findResult) {
+                  distances[i] = std::get<0>(*findResult);
+                }
+              });
+  return distances;
+}
+
+std::vector<vec3f> PathFinder::Impl::snapPointsBatch(
+    const std::vector<vec3f>& pts,
+    int numThreads) {
+  std::vector<vec3f> snapped(pts.size(), vec3f{NAN, NAN, NAN});
+  if (!isLoaded()) {
+    return snapped;
+  }
+
+  parallelForWorkers(pts.size(), numThreads,
+                     [&](size_t i, int) { snapped[i] = snapPoint(pts[i]); });
+  return snapped;
+}
+
+Eigen::Matrix<bool, Eigen::Dynamic, 1> PathFinder::Impl::isNavigableBatch(
+    const std::vector<vec3f>& pts,
+    float maxYDelta,
+    int numThreads) {
+  // one byte per point, unlike std::vector<bool> the workers can set them
+  // concurrently
+  Eigen::Matrix<bool, Eigen::Dynamic, 1> navigable =
+      Eigen::Matrix<bool, Eigen::Dynamic, 1>::Constant(pts.size(), false);
+  if (!isLoaded()) {
+    return navigable;
+  }
+
+  parallelForWorkers(pts.size(), numThreads, [&](size_t i, int) {
+    navigable[i] = isNavigable(pts[i], maxYDelta);
+  });
+  return navigable;
+}
+
+std::vector<vec3f> PathFinder::Impl::tryStepsBatch(
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends,
+    bool allowSliding,
+    int numThreads) {
+  CORRADE_ASSERT(starts.size() == ends.size(),
+                 "PathFinder::tryStepsBatch(): expected as many starts as "
+                 "ends, got"
+                     << starts.size() << "and" << ends.size(),
+                 {});
+
+  std::vector<vec3f> steps = starts;
+  if (!isLoaded()) {
+    return steps;
+  }
+
+  parallelForWorkers(starts.size(), numThreads, [&](size_t i, int) {
+    steps[i] = tryStep(starts[i], ends[i], allowSliding);
+  });
+  return steps;
+}
+
+void PathFinder::Impl::samplePortals(GeodesicDistanceField::Impl& f,
+                                     int samplesPerPortal) const {
+  f.navMeshVersion = navMeshVersion_;
+  f.polySampleOffsets.assign(1, 0);
+  if (!isLoaded()) {
+    return;
+  }
+  samplesPerPortal = std::max(samplesPerPortal, 2);
+
+  const dtNavMesh* navMesh = navMesh_.get();
+  std::vector<std::pair<const dtMeshTile*, const dtPoly*>> polys;
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+      const dtPoly* poly = &tile->polys[jPoly];
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter_->passFilter(ref, tile, poly))
+        continue;
+      f.polyIndices.emplace(ref, polys.size());
+      polys.emplace_back(tile, poly);
+    }
+  }
+
+  // sample every portal once, from the polygon with the smaller ref, and
+  // remember the two polygons of each sample
+  std::vector<std::vector<uint32_t>> polySamples(polys.size());
+  for (const auto& refIndex : f.polyIndices) {
+    const dtMeshTile* tile = polys[refIndex.second].first;
+    const dtPoly* poly = polys[refIndex.second].second;
+    for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+         iLink = tile->links[iLink].next) {
+      const dtLink& link = tile->links[iLink];
+      if (link.ref <= refIndex.first)
+        continue;
+      auto neighbour = f.polyIndices.find(link.ref);
+      if (neighbour == f.polyIndices.end())
+        continue;
+
+      const Eigen::Map<const vec3f> edgeA{
+          &tile->verts[poly->verts[link.edge] * 3]};
+      const Eigen::Map<const vec3f> edgeB{
+          &tile->verts[poly->verts[(link.edge + 1) % poly->vertCount] * 3]};
+      // portals between tiles may only cover a part of the edge
+      float tMin = 0.0f, tMax = 1.0f;
+      if (link.side != 0xff) {
+        tMin = link.bmin / 255.0f;
+        tMax = link.bmax / 255.0f;
+      }
+      for (int iSample = 0; iSample < samplesPerPortal; ++iSample) {
+        const float t =
+            tMin + (tMax - tMin) * iSample / float(samplesPerPortal - 1);
+        const uint32_t sample = f.samplePoints.size();
+        f.samplePoints.emplace_back(edgeA + t * (edgeB - edgeA));
+        f.samplePolys.push_back({refIndex.second, neighbour->second});
+        polySamples[refIndex.second].push_back(sample);
+        polySamples[neighbour->second].push_back(sample);
+      }
+    }
+  }
+  for (const std::vector<uint32_t>& samples : polySamples) {
+    f.polySamples.insert(f.polySamples.end(), samples.begin(), samples.end());
+    f.polySampleOffsets.push_back(f.polySamples.size());
+  }
+}
+
+GeodesicDistanceField::ptr PathFinder::Impl::buildGeodesicDistanceField(
+    const std::vector<vec3f>& goals,
+    int samplesPerPortal) {
+  auto field = GeodesicDistanceField::create();
+  GeodesicDistanceField::Impl& f = *field->pimpl_;
+  f.goals = goals;
+  samplePortals(f, samplesPerPortal);
+  if (!isLoaded()) {
+    return field;
+  }
+
+  std::vector<std::pair<uint32_t, vec3f>> sources;
+  for (const vec3f& goal : goals) {
+    dtStatus status;
+    dtPolyRef goalRef;
+    vec3f snappedGoal;
+    std::tie(status, goalRef, snappedGoal) =
+        projectToPoly(goal, query(), filter_.get());
+    auto goalPoly = f.polyIndices.find(goalRef);
+    if (status != DT_SUCCESS || goalPoly == f.polyIndices.end())
+      continue;
+    f.polyGoals.emplace(goalPoly->second, snappedGoal);
+    sources.emplace_back(goalPoly->second, snappedGoal);
+  }
+  f.propagate(sources, f.sampleDistances);
+
+  return field;
+}
+
+Eigen::MatrixXf PathFinder::Impl::geodesicDistanceMatrix(
+    const std::vector<vec3f>& points,
+    int samplesPerPortal,
+    int numThreads) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  Eigen::MatrixXf distances =
+      Eigen::MatrixXf::Constant(points.size(), points.size(), inf);
+  if (!isLoaded()) {
+    return distances;
+  }
+
+  // the portal samples are shared by the searches from every point
+  GeodesicDistanceField::Impl f;
+  samplePortals(f, samplesPerPortal);
+
+  constexpr uint32_t NoPoly = ~uint32_t(0);
+  std::vector<std::pair<uint32_t, vec3f>> snapped(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    dtStatus status;
+    dtPolyRef ref;
+    std::tie(status, ref, snapped[i].second) =
+        projectToPoly(points[i], query(), filter_.get());
+    auto poly = f.polyIndices.find(ref);
+    snapped[i].first = status == DT_SUCCESS && poly != f.polyIndices.end()
+                           ? poly->second
+                           : NoPoly;
+  }
+
+  // each search only reads the samples, the workers need no Detour query
+  parallelFor(points.size(), numThreads, [&](size_t i, int) {
+    if (snapped[i].first == NoPoly)
+      return;
+    std::vector<float> sampleDistances;
+    f.propagate({snapped[i]}, sampleDistances);
+    for (size_t j = 0; j < points.size(); ++j) {
+      if (snapped[j].first == NoPoly)
+        continue;
+      float distance = f.distanceThroughSamples(
+          sampleDistances, snapped[j].first, snapped[j].second);
+      // points in the same polygon are reachable in a straight line
+      if (snapped[j].first == snapped[i].first) {
+        distance = std::min(distance,
+                            (snapped[j].second - snapped[i].second).norm());
+      }
+      distances(i, j) = distance;
+    }
+  });
+  return distances;
+}
+
+float PathFinder::Impl::geodesicDistance(const GeodesicDistanceField& field,
+                                         const vec3f& pt) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  const GeodesicDistanceField::Impl& f = *field.pimpl_;
+  if (!isLoaded() || f.navMeshVersion != navMeshVersion_) {
+    LOG(ERROR) << "PathFinder::geodesicDistance: the distance field was not "
+                  "built on the current navmesh";
+    return inf;
+  }
+
+  dtStatus status;
+  dtPolyRef ptRef;
+  vec3f polyPt;
+  std::tie(status, ptRef, polyPt) = projectToPoly(pt, query(), filter_.get());
+  auto poly = f.polyIndices.find(ptRef);
+  if (status != DT_SUCCESS || poly == f.polyIndices.end()) {
+    return inf;
+  }
+
+  float distance = inf;
+  // goals in the same polygon are reachable in a straight line
+  auto goals = f.polyGoals.equal_range(poly->second);
+  for (auto it = goals.first; it != goals.second; ++it) {
+    distance = std::min(distance, (it->second - polyPt).norm());
+  }
+  return std::min(distance, f.distanceThroughSamples(f.sampleDistances,
+                                                    poly->second, polyPt));
 }
 
 template <typename T>
@@ -1105,9 +3530,9 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   dtPolyRef startRef, endRef;
   vec3f pathStart;
   std::tie(startStatus, startRef, pathStart) =
-      projectToPoly(start, navQuery_.get(), filter_.get());
+      projectToPoly(start, query(), filter_.get());
   std::tie(endStatus, endRef, std::ignore) =
-      projectToPoly(end, navQuery_.get(), filter_.get());
+      projectToPoly(end, query(), filter_.get());
 
   if (dtStatusFailed(startStatus) || dtStatusFailed(endStatus)) {
     return start;
@@ -1119,7 +3544,7 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
 
   vec3f endPoint;
   int numPolys;
-  navQuery_->moveAlongSurface(startRef, pathStart.data(), end.data(),
+  query()->moveAlongSurface(startRef, pathStart.data(), end.data(),
                               filter_.get(), endPoint.data(), polys, &numPolys,
                               MAX_POLYS, allowSliding);
   // If there isn't any possible path between start and end, just return
@@ -1136,7 +3561,7 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   // surface at the endPoint and set its height to that.
   // Note, this will never fail as endPoint is always within in the poly
   // polys[numPolys - 1]
-  navQuery_->getPolyHeight(polys[numPolys - 1], endPoint.data(), &endPoint[1]);
+  query()->getPolyHeight(polys[numPolys - 1], endPoint.data(), &endPoint[1]);
 
   // Hack to deal with infinitely thin walls in recast allowing you to
   // transition between two different connected components
@@ -1144,7 +3569,7 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   // is in the same connected component as the startRef according to
   // findNearestPoly
   std::tie(std::ignore, endRef, std::ignore) =
-      projectToPoly(endPoint, navQuery_.get(), filter_.get());
+      projectToPoly(endPoint, query(), filter_.get());
   if (!this->islandSystem_->hasConnection(startRef, endRef)) {
     // There isn't a connection!  This happens when endPoint is on an edge
     // shared between two different connected components (aka infinitely thin
@@ -1176,7 +3601,7 @@ T PathFinder::Impl::snapPoint(const T& pt) {
   dtStatus status;
   vec3f projectedPt;
   std::tie(status, std::ignore, projectedPt) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+      projectToPoly(pt, query(), filter_.get());
 
   if (dtStatusSucceed(status)) {
     return T{projectedPt};
@@ -1189,7 +3614,7 @@ float PathFinder::Impl::islandRadius(const vec3f& pt) const {
   dtPolyRef ptRef;
   dtStatus status;
   std::tie(status, ptRef, std::ignore) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+      projectToPoly(pt, query(), filter_.get());
   if (status != DT_SUCCESS || ptRef == 0) {
     return 0.0;
   } else {
@@ -1203,21 +3628,53 @@ float PathFinder::Impl::distanceToClosestObstacle(
   return closestObstacleSurfacePoint(pt, maxSearchRadius).hitDist;
 }
 
+std::vector<float> PathFinder::Impl::distancesToClosestObstacle(
+    const std::vector<vec3f>& pts,
+    const float maxSearchRadius) const {
+  std::vector<float> distances;
+  distances.reserve(pts.size());
+  for (const vec3f& pt : pts) {
+    distances.push_back(distanceToClosestObstacle(pt, maxSearchRadius));
+  }
+  return distances;
+}
+
 HitRecord PathFinder::Impl::closestObstacleSurfacePoint(
     const vec3f& pt,
     const float maxSearchRadius /*= 2.0*/) const {
+  // the grid lookup, falls back to the wall query if pt is not on a sample or
+  // the search radius exceeds the precomputed distances
+  const int j = obstacleDistanceField_ ? obstacleDistanceField_->sampleAt(pt)
+                                       : ID_UNDEFINED;
+  if (j != ID_UNDEFINED) {
+    const ObstacleDistanceField& field = *obstacleDistanceField_;
+    if (field.distances[j] < std::numeric_limits<float>::infinity()) {
+      const vec2f obstacle = field.obstacles[j];
+      const vec2f offset = vec2f(pt[0], pt[2]) - obstacle;
+      const float hitDist = offset.norm();
+      const vec2f normal = hitDist > 0.0f ? vec2f(offset / hitDist)
+                                          : vec2f(vec2f::Zero());
+      return {vec3f(obstacle[0], field.heights[j], obstacle[1]),
+              vec3f(normal[0], 0.0f, normal[1]),
+              std::min(hitDist, maxSearchRadius)};
+    }
+    if (maxSearchRadius <= field.maxDistance) {
+      return {vec3f(pt[0], field.heights[j], pt[2]), vec3f(0, 0, 0),
+              maxSearchRadius};
+    }
+  }
+
   dtPolyRef ptRef;
   dtStatus status;
   vec3f polyPt;
-  std::tie(status, ptRef, polyPt) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+  std::tie(status, ptRef, polyPt) = projectToPoly(pt, query(), filter_.get());
   if (status != DT_SUCCESS || ptRef == 0) {
     return {vec3f(0, 0, 0), vec3f(0, 0, 0),
             std::numeric_limits<float>::infinity()};
   } else {
     vec3f hitPos, hitNormal;
     float hitDist;
-    navQuery_->findDistanceToWall(ptRef, polyPt.data(), maxSearchRadius,
+    query()->findDistanceToWall(ptRef, polyPt.data(), maxSearchRadius,
                                   filter_.get(), &hitDist, hitPos.data(),
                                   hitNormal.data());
     return {hitPos, hitNormal, hitDist};
@@ -1229,8 +3686,7 @@ bool PathFinder::Impl::isNavigable(const vec3f& pt,
   dtPolyRef ptRef;
   dtStatus status;
   vec3f polyPt;
-  std::tie(status, ptRef, polyPt) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+  std::tie(status, ptRef, polyPt) = projectToPoly(pt, query(), filter_.get());
 
   if (status != DT_SUCCESS || ptRef == 0)
     return false;
@@ -1245,9 +3701,135 @@ bool PathFinder::Impl::isNavigable(const vec3f& pt,
 
 typedef Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> MatrixXb;
 
+namespace {
+//! A detail triangle of a navmesh polygon prepared for rasterization
+struct RasterTriangle {
+  vec3f a, b, c;
+  //! twice the signed area of the triangle projected onto xz
+  float area2;
+};
+
+//! The detail triangles of all walkable polygons, except vertical ones
+std::vector<RasterTriangle> walkableTriangles(const dtNavMesh* navMesh,
+                                              const dtQueryFilter* filter) {
+  std::vector<RasterTriangle> triangles;
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    const dtPolyRef base = navMesh->getPolyRefBase(tile);
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPoly* poly = &tile->polys[jPoly];
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter->passFilter(base | jPoly, tile, poly))
+        continue;
+
+      for (const Triangle& tri : getPolygonTriangles(poly, tile)) {
+        const vec3f& a = tri.v[0];
+        const vec3f& b = tri.v[1];
+        const vec3f& c = tri.v[2];
+        const float area2 = (b[0] - a[0]) * (c[2] - a[2]) -
+                            (c[0] - a[0]) * (b[2] - a[2]);
+        // vertical triangles cover no samples
+        if (std::abs(area2) < 1e-8f)
+          continue;
+        triangles.push_back(RasterTriangle{a, b, c, area2});
+      }
+    }
+  }
+  return triangles;
+}
+
+//! Samples at (startx + w * spacing, startz + h * spacing) for w in [0,
+//! width) and h in [0, height)
+struct RasterGrid {
+  float startx, startz, spacing;
+  int width, height;
+
+  int firstColumn(float x) const { return firstIndex(x, startx); }
+  int lastColumn(float x) const { return lastIndex(x, startx, width); }
+  int firstRow(float z) const { return firstIndex(z, startz); }
+  int lastRow(float z) const { return lastIndex(z, startz, height); }
+
+ private:
+  int firstIndex(float coord, float start) const {
+    return std::max(0, static_cast<int>(std::ceil((coord - start) / spacing)));
+  }
+  int lastIndex(float coord, float start, int count) const {
+    return std::min(count - 1,
+                    static_cast<int>(std::floor((coord - start) / spacing)));
+  }
+};
+
+//! Call func(h, w, y) for the samples in the rows [rowBegin, rowEnd) of
+//! @p grid covered by @p tri, with y the height of the triangle there
+template <typename F>
+void rasterizeTriangle(const RasterTriangle& tri,
+                       const RasterGrid& grid,
+                       int rowBegin,
+                       int rowEnd,
+                       F&& func) {
+  const vec3f* v[3] = {&tri.a, &tri.b, &tri.c};
+  const float minZ = std::min({tri.a[2], tri.b[2], tri.c[2]});
+  const float maxZ = std::max({tri.a[2], tri.b[2], tri.c[2]});
+  rowBegin = std::max(rowBegin, grid.firstRow(minZ));
+  rowEnd = std::min(rowEnd, grid.lastRow(maxZ) + 1);
+  for (int h = rowBegin; h < rowEnd; ++h) {
+    const float z = grid.startz + h * grid.spacing;
+
+    // span of the row inside of the triangle, from its edges
+    float minX = std::numeric_limits<float>::infinity();
+    float maxX = -std::numeric_limits<float>::infinity();
+    for (int k = 0; k < 3; ++k) {
+      const vec3f& p = *v[k];
+      const vec3f& q = *v[(k + 1) % 3];
+      if ((z < p[2] && z < q[2]) || (z > p[2] && z > q[2]))
+        continue;
+      if (p[2] == q[2]) {
+        minX = std::min({minX, p[0], q[0]});
+        maxX = std::max({maxX, p[0], q[0]});
+      } else {
+        const float x = p[0] + (z - p[2]) / (q[2] - p[2]) * (q[0] - p[0]);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+      }
+    }
+    if (minX > maxX)
+      continue;
+
+    const int w0 = grid.firstColumn(minX);
+    const int w1 = grid.lastColumn(maxX);
+    for (int w = w0; w <= w1; ++w) {
+      // surface height at the sample from barycentric coordinates
+      const float x = grid.startx + w * grid.spacing;
+      const float l1 = ((x - tri.a[0]) * (tri.c[2] - tri.a[2]) -
+                        (tri.c[0] - tri.a[0]) * (z - tri.a[2])) /
+                       tri.area2;
+      const float l2 = ((tri.b[0] - tri.a[0]) * (z - tri.a[2]) -
+                        (x - tri.a[0]) * (tri.b[2] - tri.a[2])) /
+                       tri.area2;
+      func(h, w,
+           tri.a[1] + l1 * (tri.b[1] - tri.a[1]) + l2 * (tri.c[1] - tri.a[1]));
+    }
+  }
+}
+}  // namespace
+
 Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>
 PathFinder::Impl::getTopDownView(const float metersPerPixel,
                                  const float height) {
+  const auto cacheKey = std::make_pair(metersPerPixel, height);
+  auto cached = std::find_if(
+      topDownViewCache_.begin(), topDownViewCache_.end(),
+      [&](const CachedTopDownView& view) { return view.key == cacheKey; });
+  if (cached != topDownViewCache_.end()) {
+    topDownViewCache_.splice(topDownViewCache_.begin(), topDownViewCache_,
+                             cached);
+    return cached->view;
+  }
+  const AllTilesScope allTiles{*this};
+
   std::pair<vec3f, vec3f> mapBounds = bounds();
   vec3f bound1 = mapBounds.first;
   vec3f bound2 = mapBounds.second;
@@ -1258,34 +3840,281 @@ PathFinder::Impl::getTopDownView(const float metersPerPixel,
   int zResolution = zspan / metersPerPixel;
   float startx = fmin(bound1[0], bound2[0]);
   float startz = fmin(bound1[2], bound2[2]);
-  MatrixXb topdownMap(zResolution, xResolution);
+  MatrixXb topdownMap = MatrixXb::Zero(zResolution, xResolution);
+  if (!navMesh_) {
+    return topdownMap;
+  }
+
+  // A pixel is navigable if it lies on a walkable polygon whose surface is
+  // within isNavigable()'s default maxYDelta of the height. Instead of
+  // projecting every pixel onto the navmesh, the detail triangles are scan
+  // converted into the map.
+  const float maxYDelta = 0.5f;
+  std::vector<RasterTriangle> triangles;
+  for (const RasterTriangle& tri :
+       walkableTriangles(navMesh_.get(), filter_.get())) {
+    const float minY = std::min({tri.a[1], tri.b[1], tri.c[1]});
+    const float maxY = std::max({tri.a[1], tri.b[1], tri.c[1]});
+    if (minY <= height + maxYDelta && maxY >= height - maxYDelta)
+      triangles.push_back(tri);
+  }
 
-  float curz = startz;
-  float curx = startx;
-  for (int h = 0; h < zResolution; h++) {
-    for (int w = 0; w < xResolution; w++) {
-      vec3f point = vec3f(curx, height, curz);
-      topdownMap(h, w) = isNavigable(point, 0.5);
-      curx = curx + metersPerPixel;
+  // the rows are processed in bands, each band only visits the triangles
+  // overlapping it
+  const RasterGrid grid{startx, startz, metersPerPixel, xResolution,
+                        zResolution};
+  const int rowsPerBand = 32;
+  const int numBands = (zResolution + rowsPerBand - 1) / rowsPerBand;
+  std::vector<std::vector<uint32_t>> bandTriangles(numBands);
+  for (uint32_t iTri = 0; iTri < triangles.size(); ++iTri) {
+    const RasterTriangle& tri = triangles[iTri];
+    const int h0 = grid.firstRow(std::min({tri.a[2], tri.b[2], tri.c[2]}));
+    const int h1 = grid.lastRow(std::max({tri.a[2], tri.b[2], tri.c[2]}));
+    if (h0 > h1)
+      continue;
+    for (int iBand = h0 / rowsPerBand; iBand <= h1 / rowsPerBand; ++iBand) {
+      bandTriangles[iBand].push_back(iTri);
     }
-    curz = curz + metersPerPixel;
-    curx = startx;
   }
 
+  // bands write disjoint rows of the map
+  parallelFor(numBands, 0, [&](size_t iBand, int) {
+    const int bandBegin = iBand * rowsPerBand;
+    const int bandEnd = std::min(zResolution, bandBegin + rowsPerBand);
+    for (const uint32_t iTri : bandTriangles[iBand]) {
+      rasterizeTriangle(triangles[iTri], grid, bandBegin, bandEnd,
+                        [&](int h, int w, float y) {
+                          if (std::abs(y - height) <= maxYDelta)
+                            topdownMap(h, w) = true;
+                        });
+    }
+  });
+
+  // callers sweeping heights or resolutions don't grow the cache
+  topDownViewCache_.push_front({cacheKey, topdownMap});
+  if (topDownViewCache_.size() > TopDownViewCacheSize) {
+    topDownViewCache_.pop_back();
+  }
   return topdownMap;
 }
 
+namespace {
+//! The eight neighbours of a cell as row and column offsets, the four
+//! sharing an edge with it first
+constexpr int CellNeighbours[8][2] = {{-1, 0}, {1, 0},  {0, -1}, {0, 1},
+                                      {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+//! Samples in the same cell closer than this are on the same surface
+constexpr float SurfaceMergeDistance = 0.1f;
+}  // namespace
+
+int PathFinder::Impl::ObstacleDistanceField::connectedSample(int h,
+                                                             int w,
+                                                             float y) const {
+  if (h < 0 || h >= height || w < 0 || w >= width)
+    return ID_UNDEFINED;
+  const uint32_t cell = h * width + w;
+  int best = ID_UNDEFINED;
+  float bestDelta = climb;
+  for (uint32_t j = cellOffsets[cell]; j < cellOffsets[cell + 1]; ++j) {
+    const float delta = std::abs(heights[j] - y);
+    if (delta <= bestDelta) {
+      best = j;
+      bestDelta = delta;
+    }
+  }
+  return best;
+}
+
+int PathFinder::Impl::ObstacleDistanceField::sampleAt(
+    const vec3f& pt) const {
+  const int w = std::floor((pt[0] - originX) / cellSize + 0.5f);
+  const int h = std::floor((pt[2] - originZ) / cellSize + 0.5f);
+  // the surface must be about where isNavigable() looks for it
+  constexpr float maxYDelta = 0.5f;
+  if (h < 0 || h >= height || w < 0 || w >= width)
+    return ID_UNDEFINED;
+  const uint32_t cell = h * width + w;
+  int best = ID_UNDEFINED;
+  float bestDelta = maxYDelta;
+  for (uint32_t j = cellOffsets[cell]; j < cellOffsets[cell + 1]; ++j) {
+    const float delta = std::abs(heights[j] - pt[1]);
+    if (delta <= bestDelta) {
+      best = j;
+      bestDelta = delta;
+    }
+  }
+  return best;
+}
+
+bool PathFinder::Impl::buildObstacleDistanceField(const float cellSize,
+                                                  const float maxDistance) {
+  core::ScopedTraceEvent trace{"PathFinder::buildObstacleDistanceField",
+                               "nav"};
+  if (!isLoaded()) {
+    LOG(ERROR) << "buildObstacleDistanceField: no navmesh loaded";
+    return false;
+  }
+  if (!(cellSize > 0.0f) || !(maxDistance > 0.0f)) {
+    LOG(ERROR) << "buildObstacleDistanceField: cellSize and maxDistance "
+                  "must be positive";
+    return false;
+  }
+  const AllTilesScope allTiles{*this};
+
+  ObstacleDistanceField field;
+  field.cellSize = cellSize;
+  field.maxDistance = maxDistance;
+  field.width = std::max(
+      1, static_cast<int>(std::ceil((bounds_.second[0] - bounds_.first[0]) /
+                                    cellSize)));
+  field.height = std::max(
+      1, static_cast<int>(std::ceil((bounds_.second[2] - bounds_.first[2]) /
+                                    cellSize)));
+  field.originX = bounds_.first[0] + 0.5f * cellSize;
+  field.originZ = bounds_.first[2] + 0.5f * cellSize;
+
+  // neighbouring samples are on the same surface if the agent could step
+  // between them, a slope rises by up to a cell between the samples
+  const dtNavMesh* navMesh = navMesh_.get();
+  field.climb = 0.0f;
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (tile && tile->header)
+      field.climb = std::max(field.climb, tile->header->walkableClimb);
+  }
+  field.climb += cellSize;
+
+  // surface heights at the cell centers, several per cell on multi-level
+  // navmeshes
+  const RasterGrid grid{field.originX, field.originZ, cellSize, field.width,
+                        field.height};
+  std::vector<std::pair<uint32_t, float>> cellHeights;
+  for (const RasterTriangle& tri :
+       walkableTriangles(navMesh, filter_.get())) {
+    rasterizeTriangle(tri, grid, 0, field.height, [&](int h, int w, float y) {
+      cellHeights.emplace_back(h * field.width + w, y);
+    });
+  }
+  std::sort(cellHeights.begin(), cellHeights.end());
+
+  const size_t numCells = size_t(field.width) * field.height;
+  field.cellOffsets.assign(numCells + 1, 0);
+  std::vector<uint32_t> sampleCells;
+  for (size_t i = 0; i < cellHeights.size(); ++i) {
+    const uint32_t cell = cellHeights[i].first;
+    // polygons sharing an edge both cover the cell centers on it
+    if (i > 0 && cellHeights[i - 1].first == cell &&
+        cellHeights[i].second - field.heights.back() < SurfaceMergeDistance)
+      continue;
+    field.heights.push_back(cellHeights[i].second);
+    sampleCells.push_back(cell);
+    ++field.cellOffsets[cell + 1];
+  }
+  std::partial_sum(field.cellOffsets.begin(), field.cellOffsets.end(),
+                   field.cellOffsets.begin());
+
+  // Euclidean distance transform by propagating the closest obstacle point
+  // from sample to sample, starting at the boundary of the walkable surface.
+  // The boundary is put halfway between a sample and a missing neighbour.
+  const size_t numSamples = field.heights.size();
+  field.distances.assign(numSamples, std::numeric_limits<float>::infinity());
+  field.obstacles.assign(numSamples, vec2f::Zero());
+  typedef std::pair<float, uint32_t> Candidate;
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      std::greater<Candidate>>
+      queue;
+  auto center = [&](int h, int w) {
+    return vec2f(field.originX + w * cellSize, field.originZ + h * cellSize);
+  };
+
+  for (uint32_t j = 0; j < numSamples; ++j) {
+    const int h = sampleCells[j] / field.width;
+    const int w = sampleCells[j] % field.width;
+    for (const auto& n : CellNeighbours) {
+      if (field.connectedSample(h + n[0], w + n[1], field.heights[j]) !=
+          ID_UNDEFINED)
+        continue;
+      const vec2f obstacle = center(h, w) + 0.5f * cellSize * vec2f(n[1], n[0]);
+      const float distance = (obstacle - center(h, w)).norm();
+      if (distance < field.distances[j]) {
+        field.distances[j] = distance;
+        field.obstacles[j] = obstacle;
+      }
+    }
+    if (field.distances[j] < std::numeric_limits<float>::infinity())
+      queue.emplace(field.distances[j], j);
+  }
+
+  while (!queue.empty()) {
+    const float distance = queue.top().first;
+    const uint32_t j = queue.top().second;
+    queue.pop();
+    if (distance > field.distances[j])
+      continue;
+
+    const int h = sampleCells[j] / field.width;
+    const int w = sampleCells[j] % field.width;
+    for (const auto& n : CellNeighbours) {
+      const int t =
+          field.connectedSample(h + n[0], w + n[1], field.heights[j]);
+      if (t == ID_UNDEFINED)
+        continue;
+      const float newDistance =
+          (center(h + n[0], w + n[1]) - field.obstacles[j]).norm();
+      if (newDistance < field.distances[t] &&
+          newDistance <= maxDistance + cellSize) {
+        field.distances[t] = newDistance;
+        field.obstacles[t] = field.obstacles[j];
+        queue.emplace(newDistance, t);
+      }
+    }
+  }
+
+  obstacleDistanceField_ = std::move(field);
+  return true;
+}
+
+float PathFinder::Impl::obstacleDistanceFieldMaxError() const {
+  return obstacleDistanceField_ ? 2.0f * obstacleDistanceField_->cellSize
+                                : 0.0f;
+}
+
+bool PathFinder::Impl::buildPathHierarchy(const float clusterSize) {
+  core::ScopedTraceEvent trace{"PathFinder::buildPathHierarchy", "nav"};
+  if (!isLoaded()) {
+    LOG(ERROR) << "buildPathHierarchy: no navmesh loaded";
+    return false;
+  }
+  if (!(clusterSize > 0.0f)) {
+    LOG(ERROR) << "buildPathHierarchy: clusterSize must be positive";
+    return false;
+  }
+  const AllTilesScope allTiles{*this};
+  pathHierarchy_ = std::make_unique<impl::PathHierarchy>(
+      navMesh_.get(), filter_.get(), clusterSize);
+  // the cached paths were searched without it
+  clearPathCache();
+  return true;
+}
+
+int PathFinder::Impl::numPathClusters() const {
+  return pathHierarchy_ ? pathHierarchy_->numClusters() : 0;
+}
+
 const assets::MeshData::ptr PathFinder::Impl::getNavMeshData() {
-  if (meshData_ == nullptr && isLoaded()) {
-    meshData_ = assets::MeshData::create();
-    std::vector<esp::vec3f>& vbo = meshData_->vbo;
-    std::vector<uint32_t>& ibo = meshData_->ibo;
+  assets::MeshData::ptr meshData = meshData_.lock();
+  if (meshData == nullptr && isLoaded()) {
+    meshData = assets::MeshData::create();
+    meshData_ = meshData;
+    std::vector<esp::vec3f>& vbo = meshData->vbo;
+    std::vector<uint32_t>& ibo = meshData->ibo;
 
     // Iterate over all tiles
     for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
       const dtMeshTile* tile =
           const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
-      if (!tile)
+      if (!tile || !tile->header)
         continue;
 
       // Iterate over all polygons in a tile
@@ -1310,7 +4139,242 @@ const assets::MeshData::ptr PathFinder::Impl::getNavMeshData() {
       }
     }
   }
-  return meshData_;
+  return meshData;
+}
+
+bool PathFinder::Impl::compress() {
+  core::ScopedTraceEvent trace{"PathFinder::compress", "nav"};
+  if (!navMesh_)
+    return isCompressed();
+  // the compressed navmesh has all tiles, streaming starts over after
+  restoreTiles([](const EvictedTile&) { return true; });
+  streaming_ = false;
+
+  const dtNavMesh* navMesh = navMesh_.get();
+  CompressedNavMesh compressed;
+  compressed.params = *navMesh->getParams();
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header || !tile->dataSize)
+      continue;
+    compressed.tiles.push_back(
+        {navMesh->getTileRef(tile), tile->dataSize,
+         core::compressBytes(tile->data, tile->dataSize)});
+  }
+
+  // everything derived from the navmesh is rebuilt on demand afterwards
+  meshData_.reset();
+  topDownViewCache_.clear();
+  clearPathCache();
+  samplingTable_ = Cr::Containers::NullOpt;
+  obstacleDistanceField_ = Cr::Containers::NullOpt;
+  pathHierarchy_ = nullptr;
+  islandSystem_ = nullptr;
+  queryPool_.clear();
+  navQuery_ = nullptr;
+  navMesh_ = nullptr;
+  navMeshFile_.reset();
+  compressedNavMesh_ = std::move(compressed);
+  compressed_ = true;
+  return true;
+}
+
+size_t PathFinder::Impl::getTileDataBytes() const {
+  size_t bytes = 0;
+  if (compressedNavMesh_) {
+    for (const CompressedTile& tile : compressedNavMesh_->tiles) {
+      bytes += tile.data.size();
+    }
+  } else if (navMesh_) {
+    const dtNavMesh* navMesh = navMesh_.get();
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (tile && tile->header)
+        bytes += tile->dataSize;
+    }
+  }
+  for (const EvictedTile& evicted : evictedTiles_) {
+    bytes += evicted.tile.data.size();
+  }
+  return bytes;
+}
+
+namespace {
+//! Whether the box is within @p radius of one of @p points
+bool isBoxNear(const float* bmin,
+               const float* bmax,
+               const std::vector<vec3f>& points,
+               const float radius) {
+  for (const vec3f& point : points) {
+    float distanceSquared = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      const float d =
+          std::max(std::max(bmin[k] - point[k], point[k] - bmax[k]), 0.0f);
+      distanceSquared += d * d;
+    }
+    if (distanceSquared <= radius * radius)
+      return true;
+  }
+  return false;
+}
+}  // namespace
+
+int PathFinder::Impl::restoreTiles(
+    const std::function<bool(const EvictedTile&)>& select) {
+  if (!navMesh_)
+    return 0;
+  int numRestored = 0;
+  for (auto it = evictedTiles_.begin(); it != evictedTiles_.end();) {
+    if (!select(*it)) {
+      ++it;
+      continue;
+    }
+    const CompressedTile& tile = it->tile;
+    unsigned char* data =
+        static_cast<unsigned char*>(dtAlloc(tile.dataSize, DT_ALLOC_PERM));
+    if (!data ||
+        !core::decompressBytes(tile.data.data(), tile.data.size(), data,
+                               tile.dataSize) ||
+        dtStatusFailed(navMesh_->addTile(data, tile.dataSize,
+                                         DT_TILE_FREE_DATA, tile.tileRef,
+                                         nullptr))) {
+      LOG(ERROR) << "restoreTiles: Could not restore an evicted tile";
+      dtFree(data);
+      ++it;
+      continue;
+    }
+    it = evictedTiles_.erase(it);
+    ++numRestored;
+  }
+  return numRestored;
+}
+
+int PathFinder::Impl::evictTiles() {
+  dtNavMesh* navMesh = navMesh_.get();
+  if (!navMesh)
+    return 0;
+  int numEvicted = 0;
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile =
+        static_cast<const dtNavMesh*>(navMesh)->getTile(iTile);
+    if (!tile || !tile->header || !tile->dataSize ||
+        isBoxNear(tile->header->bmin, tile->header->bmax, streamPoints_,
+                  streamRadius_))
+      continue;
+    EvictedTile evicted{
+        {navMesh->getTileRef(tile), tile->dataSize,
+         core::compressBytes(tile->data, tile->dataSize)},
+        Eigen::Map<const vec3f>(tile->header->bmin),
+        Eigen::Map<const vec3f>(tile->header->bmax)};
+    // tiles of a mapped file don't own their data
+    const bool ownsData = tile->flags & DT_TILE_FREE_DATA;
+    unsigned char* data = nullptr;
+    if (dtStatusFailed(
+            navMesh->removeTile(evicted.tile.tileRef, &data, nullptr)))
+      continue;
+    if (ownsData)
+      dtFree(data);
+    evictedTiles_.push_back(std::move(evicted));
+    ++numEvicted;
+  }
+  return numEvicted;
+}
+
+int PathFinder::Impl::streamTiles(const std::vector<vec3f>& points,
+                                  const float radius) {
+  core::ScopedTraceEvent trace{"PathFinder::streamTiles", "nav"};
+  if (!navMesh_)
+    return 0;
+
+  streaming_ = true;
+  streamPoints_ = points;
+  streamRadius_ = radius;
+  const int numChanged =
+      restoreTiles([&](const EvictedTile& evicted) {
+        return isBoxNear(evicted.bmin.data(), evicted.bmax.data(), points,
+                         radius);
+      }) +
+      evictTiles();
+
+  // The tiles come back with the same polygon refs, so the islands, the
+  // cached paths and the other state built on the whole navmesh stay valid
+  // and the navmesh version is kept. Only the drawn mesh shows the resident
+  // tiles.
+  if (numChanged > 0)
+    meshData_.reset();
+  return numChanged;
+}
+
+bool PathFinder::Impl::decompress() {
+  core::ScopedTraceEvent trace{"PathFinder::decompress", "nav"};
+  if (!compressedNavMesh_)
+    return isLoaded();
+  const CompressedNavMesh& compressed = *compressedNavMesh_;
+
+  NavMeshPtr mesh{dtAllocNavMesh()};
+  if (!mesh || dtStatusFailed(mesh->init(&compressed.params))) {
+    LOG(ERROR) << "decompress: Could not init Detour navmesh";
+    compressedNavMesh_ = Cr::Containers::NullOpt;
+    compressed_ = false;
+    return false;
+  }
+  // the tiles are independent, each is decompressed on its own
+  std::vector<unsigned char*> tileData(compressed.tiles.size(), nullptr);
+  std::atomic<bool> success{true};
+  parallelFor(compressed.tiles.size(), 0, [&](size_t i, int) {
+    const CompressedTile& tile = compressed.tiles[i];
+    tileData[i] = static_cast<unsigned char*>(
+        dtAlloc(tile.dataSize, DT_ALLOC_PERM));
+    if (!tileData[i] ||
+        !core::decompressBytes(tile.data.data(), tile.data.size(),
+                               tileData[i], tile.dataSize))
+      success = false;
+  });
+  for (size_t i = 0; i < tileData.size(); ++i) {
+    const CompressedTile& tile = compressed.tiles[i];
+    if (!success ||
+        dtStatusFailed(mesh->addTile(tileData[i], tile.dataSize,
+                                     DT_TILE_FREE_DATA, tile.tileRef,
+                                     nullptr))) {
+      success = false;
+      dtFree(tileData[i]);
+    }
+  }
+  if (!success) {
+    LOG(ERROR) << "decompress: Could not restore the navmesh tiles";
+    compressedNavMesh_ = Cr::Containers::NullOpt;
+    compressed_ = false;
+    return false;
+  }
+
+  // the polygon refs are the same, fields built before stay valid
+  const uint32_t navMeshVersion = navMeshVersion_;
+  navMesh_ = std::move(mesh);
+  const bool initialized = initNavQuery();
+  navMeshVersion_ = navMeshVersion;
+  return initialized;
+}
+
+bool operator==(const NavMeshSettings& a, const NavMeshSettings& b) {
+  return a.cellSize == b.cellSize && a.cellHeight == b.cellHeight &&
+         a.agentHeight == b.agentHeight && a.agentRadius == b.agentRadius &&
+         a.agentMaxClimb == b.agentMaxClimb &&
+         a.agentMaxSlope == b.agentMaxSlope &&
+         a.regionMinSize == b.regionMinSize &&
+         a.regionMergeSize == b.regionMergeSize &&
+         a.edgeMaxLen == b.edgeMaxLen && a.edgeMaxError == b.edgeMaxError &&
+         a.vertsPerPoly == b.vertsPerPoly &&
+         a.detailSampleDist == b.detailSampleDist &&
+         a.detailSampleMaxError == b.detailSampleMaxError &&
+         a.filterLowHangingObstacles == b.filterLowHangingObstacles &&
+         a.filterLedgeSpans == b.filterLedgeSpans &&
+         a.filterWalkableLowHeightSpans == b.filterWalkableLowHeightSpans &&
+         a.cullInputTriangles == b.cullInputTriangles &&
+         a.tileSize == b.tileSize;
+}
+
+bool operator!=(const NavMeshSettings& a, const NavMeshSettings& b) {
+  return !(a == b);
 }
 
 PathFinder::PathFinder() : pimpl_{spimpl::make_unique_impl<Impl>()} {};
@@ -1322,31 +4386,140 @@ bool PathFinder::build(const NavMeshSettings& bs,
                        const int ntris,
                        const float* bmin,
                        const float* bmax) {
+  pimpl_->ensureDecompressed();
   return pimpl_->build(bs, verts, nverts, tris, ntris, bmin, bmax);
 }
 bool PathFinder::build(const NavMeshSettings& bs,
                        const esp::assets::MeshData& mesh) {
+  pimpl_->ensureDecompressed();
   return pimpl_->build(bs, mesh);
 }
 
-vec3f PathFinder::getRandomNavigablePoint() {
-  return pimpl_->getRandomNavigablePoint();
+bool PathFinder::updateRegion(const esp::assets::MeshData& mesh,
+                              const vec3f& regionMin,
+                              const vec3f& regionMax) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->updateRegion(mesh, regionMin, regionMax);
+}
+
+vec3f PathFinder::getRandomNavigablePoint(int islandIndex) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->getRandomNavigablePoint(islandIndex);
+}
+
+std::vector<vec3f> PathFinder::sampleNavigablePoints(int numPoints,
+                                                     int islandIndex) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->sampleNavigablePoints(numPoints, islandIndex);
+}
+
+int PathFinder::getIslandIndex(const vec3f& pt) const {
+  pimpl_->ensureDecompressed();
+  return pimpl_->getIslandIndex(pt);
+}
+
+int PathFinder::numIslands() const {
+  pimpl_->ensureDecompressed();
+  return pimpl_->numIslands();
 }
 
 bool PathFinder::findPath(ShortestPath& path) {
+  pimpl_->ensureDecompressed();
   return pimpl_->findPath(path);
 }
 
 bool PathFinder::findPath(MultiGoalShortestPath& path) {
+  pimpl_->ensureDecompressed();
   return pimpl_->findPath(path);
 }
 
+void PathFinder::setPathCacheSize(size_t size) {
+  pimpl_->setPathCacheSize(size);
+}
+
+size_t PathFinder::getPathCacheSize() const {
+  return pimpl_->getPathCacheSize();
+}
+
+size_t PathFinder::getPathCacheHits() const {
+  return pimpl_->getPathCacheHits();
+}
+
+size_t PathFinder::getPathCacheMisses() const {
+  return pimpl_->getPathCacheMisses();
+}
+
+void PathFinder::parallelFor(size_t numItems,
+                             int numThreads,
+                             const std::function<void(size_t, int)>& func) {
+  pimpl_->ensureDecompressed();
+  pimpl_->parallelForWorkers(numItems, numThreads, func);
+}
+
+void PathFinder::findPathsBatch(std::vector<ShortestPath>& paths,
+                                int numThreads) {
+  pimpl_->ensureDecompressed();
+  pimpl_->findPathsBatch(paths, numThreads);
+}
+
+std::vector<float> PathFinder::findDistancesBatch(
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends,
+    int numThreads) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->findDistancesBatch(starts, ends, numThreads);
+}
+
+std::vector<vec3f> PathFinder::snapPointsBatch(const std::vector<vec3f>& pts,
+                                               int numThreads) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->snapPointsBatch(pts, numThreads);
+}
+
+Eigen::Matrix<bool, Eigen::Dynamic, 1> PathFinder::isNavigableBatch(
+    const std::vector<vec3f>& pts,
+    float maxYDelta,
+    int numThreads) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->isNavigableBatch(pts, maxYDelta, numThreads);
+}
+
+std::vector<vec3f> PathFinder::tryStepsBatch(const std::vector<vec3f>& starts,
+                                             const std::vector<vec3f>& ends,
+                                             bool allowSliding,
+                                             int numThreads) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->tryStepsBatch(starts, ends, allowSliding, numThreads);
+}
+
+GeodesicDistanceField::ptr PathFinder::buildGeodesicDistanceField(
+    const std::vector<vec3f>& goals,
+    int samplesPerPortal) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->buildGeodesicDistanceField(goals, samplesPerPortal);
+}
+
+Eigen::MatrixXf PathFinder::geodesicDistanceMatrix(
+    const std::vector<vec3f>& points,
+    int samplesPerPortal,
+    int numThreads) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->geodesicDistanceMatrix(points, samplesPerPortal, numThreads);
+}
+
+float PathFinder::geodesicDistance(const GeodesicDistanceField& field,
+                                   const vec3f& pt) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->geodesicDistance(field, pt);
+}
+
 template vec3f PathFinder::tryStep<vec3f>(const vec3f&, const vec3f&);
 template Mn::Vector3 PathFinder::tryStep<Mn::Vector3>(const Mn::Vector3&,
                                                       const Mn::Vector3&);
 
 template <typename T>
 T PathFinder::tryStep(const T& start, const T& end) {
+  pimpl_->ensureDecompressed();
   return pimpl_->tryStep(start, end, /*allowSliding=*/true);
 }
 
@@ -1357,6 +4530,7 @@ template Mn::Vector3 PathFinder::tryStepNoSliding<Mn::Vector3>(
 
 template <typename T>
 T PathFinder::tryStepNoSliding(const T& start, const T& end) {
+  pimpl_->ensureDecompressed();
   return pimpl_->tryStep(start, end, /*allowSliding=*/false);
 }
 
@@ -1365,6 +4539,7 @@ template Mn::Vector3 PathFinder::snapPoint<Mn::Vector3>(const Mn::Vector3& pt);
 
 template <typename T>
 T PathFinder::snapPoint(const T& pt) {
+  pimpl_->ensureDecompressed();
   return pimpl_->snapPoint(pt);
 }
 
@@ -1372,8 +4547,113 @@ bool PathFinder::loadNavMesh(const std::string& path) {
   return pimpl_->loadNavMesh(path);
 }
 
-bool PathFinder::saveNavMesh(const std::string& path) {
-  return pimpl_->saveNavMesh(path);
+bool PathFinder::saveNavMesh(const std::string& path, bool mappable) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->saveNavMesh(path, mappable);
+}
+
+std::vector<PathFinder::ptr> PathFinder::buildVariants(
+    const std::vector<NavMeshSettings>& variants,
+    const esp::assets::MeshData& mesh) {
+  std::vector<PathFinder::ptr> pathFinders;
+  std::vector<Impl*> impls;
+  for (size_t i = 0; i < variants.size(); ++i) {
+    pathFinders.emplace_back(PathFinder::create());
+    impls.emplace_back(pathFinders.back()->pimpl_.get());
+  }
+  Impl::buildVariants(variants, mesh, impls);
+  return pathFinders;
+}
+
+bool PathFinder::saveNavMeshVariants(
+    const std::vector<PathFinder::ptr>& pathFinders,
+    const std::string& path) {
+  for (const PathFinder::ptr& pathFinder : pathFinders) {
+    if (!pathFinder || !pathFinder->isLoaded())
+      return false;
+    pathFinder->pimpl_->ensureDecompressed();
+  }
+
+  FILE* fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+
+  NavMeshVariantsHeader header;
+  header.magic = NAVMESHVARIANTS_MAGIC;
+  header.version = NAVMESHVARIANTS_VERSION;
+  header.numVariants = pathFinders.size();
+  header.reserved = 0;
+  bool success = fwrite(&header, sizeof(header), 1, fp) == 1;
+  for (const PathFinder::ptr& pathFinder : pathFinders) {
+    success = success && pathFinder->pimpl_->writeVariant(fp);
+  }
+
+  fclose(fp);
+
+  return success;
+}
+
+std::vector<PathFinder::ptr> PathFinder::loadNavMeshVariants(
+    const std::string& path) {
+  core::ScopedTraceEvent trace{"PathFinder::loadNavMeshVariants", "nav"};
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (!fp)
+    return {};
+
+  NavMeshVariantsHeader header;
+  if (fread(&header, sizeof(header), 1, fp) != 1 ||
+      header.magic != NAVMESHVARIANTS_MAGIC ||
+      header.version != NAVMESHVARIANTS_VERSION || header.numVariants < 0) {
+    LOG(ERROR) << "loadNavMeshVariants: " << path
+               << " is not a navmesh variants file";
+    fclose(fp);
+    return {};
+  }
+
+  std::vector<PathFinder::ptr> pathFinders;
+  for (int i = 0; i < header.numVariants; ++i) {
+    uint64_t size = 0;
+    if (fread(&size, sizeof(size), 1, fp) != 1) {
+      pathFinders.clear();
+      break;
+    }
+    const long end = ftell(fp) + size;
+    PathFinder::ptr pathFinder = PathFinder::create();
+    if (!pathFinder->pimpl_->readVariant(fp, end) ||
+        fseek(fp, end, SEEK_SET) != 0) {
+      LOG(ERROR) << "loadNavMeshVariants: Could not read navmesh " << i
+                 << " of " << path;
+      pathFinders.clear();
+      break;
+    }
+    pathFinders.emplace_back(std::move(pathFinder));
+  }
+
+  fclose(fp);
+
+  return pathFinders;
+}
+
+bool PathFinder::compress() {
+  return pimpl_->compress();
+}
+
+bool PathFinder::isCompressed() const {
+  return pimpl_->isCompressed();
+}
+
+size_t PathFinder::getTileDataBytes() const {
+  return pimpl_->getTileDataBytes();
+}
+
+int PathFinder::streamTiles(const std::vector<vec3f>& points,
+                            const float radius) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->streamTiles(points, radius);
+}
+
+int PathFinder::getNumEvictedTiles() const {
+  return pimpl_->evictedTiles_.size();
 }
 
 bool PathFinder::isLoaded() const {
@@ -1385,21 +4665,59 @@ void PathFinder::seed(uint32_t newSeed) {
 }
 
 float PathFinder::islandRadius(const vec3f& pt) const {
+  pimpl_->ensureDecompressed();
   return pimpl_->islandRadius(pt);
 }
 
 float PathFinder::distanceToClosestObstacle(const vec3f& pt,
                                             const float maxSearchRadius) const {
+  pimpl_->ensureDecompressed();
   return pimpl_->distanceToClosestObstacle(pt, maxSearchRadius);
 }
 
+std::vector<float> PathFinder::distancesToClosestObstacle(
+    const std::vector<vec3f>& pts,
+    const float maxSearchRadius) const {
+  pimpl_->ensureDecompressed();
+  return pimpl_->distancesToClosestObstacle(pts, maxSearchRadius);
+}
+
+bool PathFinder::buildObstacleDistanceField(const float cellSize,
+                                            const float maxDistance) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->buildObstacleDistanceField(cellSize, maxDistance);
+}
+
+bool PathFinder::hasObstacleDistanceField() const {
+  return pimpl_->hasObstacleDistanceField();
+}
+
+float PathFinder::obstacleDistanceFieldMaxError() const {
+  return pimpl_->obstacleDistanceFieldMaxError();
+}
+
+bool PathFinder::buildPathHierarchy(const float clusterSize) {
+  pimpl_->ensureDecompressed();
+  return pimpl_->buildPathHierarchy(clusterSize);
+}
+
+bool PathFinder::hasPathHierarchy() const {
+  return pimpl_->hasPathHierarchy();
+}
+
+int PathFinder::numPathClusters() const {
+  return pimpl_->numPathClusters();
+}
+
 HitRecord PathFinder::closestObstacleSurfacePoint(
     const vec3f& pt,
     const float maxSearchRadius) const {
+  pimpl_->ensureDecompressed();
   return pimpl_->closestObstacleSurfacePoint(pt, maxSearchRadius);
 }
 
 bool PathFinder::isNavigable(const vec3f& pt, const float maxYDelta) const {
+  pimpl_->ensureDecompressed();
   return pimpl_->isNavigable(pt);
 }
 
@@ -1414,10 +4732,12 @@ std::pair<vec3f, vec3f> PathFinder::bounds() const {
 Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> PathFinder::getTopDownView(
     const float metersPerPixel,
     const float height) {
+  pimpl_->ensureDecompressed();
   return pimpl_->getTopDownView(metersPerPixel, height);
 }
 
 const assets::MeshData::ptr PathFinder::getNavMeshData() {
+  pimpl_->ensureDecompressed();
   return pimpl_->getNavMeshData();
 }
 
@@ -5,6 +5,7 @@
 #ifndef ESP_NAV_PATHFINDER_H_
 #define ESP_NAV_PATHFINDER_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -100,6 +101,36 @@ struct MultiGoalShortestPath {
   ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(MultiGoalShortestPath);
 };
 
+/**
+ * @brief Precomputed geodesic distances to the closest of a fixed set of
+ * goals. Built by @ref PathFinder.buildGeodesicDistanceField and queried with
+ * @ref PathFinder.geodesicDistance
+ *
+ * The portals between neighbouring navmesh polygons are sampled at evenly
+ * spaced points, including their end points, and a Dijkstra search from the
+ * goals computes the distance of every sample along straight segments inside
+ * the (convex) polygons. The distance of a point is then the minimum over the
+ * samples on the boundary of its polygon, so a lookup costs a @ref
+ * PathFinder.snapPoint and a few additions. The result is the length of an
+ * actual path on the navmesh and approaches the geodesic distance as the
+ * number of samples per portal grows.
+ *
+ * A field is only valid for the navmesh it was built on, reloading or
+ * recomputing the navmesh invalidates it.
+ */
+struct GeodesicDistanceField {
+  GeodesicDistanceField();
+
+  /**
+   * @brief The goals the field was built for
+   */
+  const std::vector<vec3f>& getGoals() const;
+
+  friend class PathFinder;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(GeodesicDistanceField);
+};
+
 struct NavMeshSettings {
   //! Cell size in world units
   float cellSize;
@@ -133,6 +164,14 @@ struct NavMeshSettings {
   bool filterLowHangingObstacles;
   bool filterLedgeSpans;
   bool filterWalkableLowHeightSpans;
+  //! Whether triangles that can't change the navmesh are left out of the
+  //! rasterization: exact duplicates, and those above every walkable surface
+  //! by more than the agent height and max climb
+  bool cullInputTriangles;
+
+  //! Tile size in voxels along x and z. Zero builds a single tile, which
+  //! cannot be updated with @ref PathFinder::updateRegion.
+  float tileSize;
 
   void setDefaults() {
     cellSize = 0.05f;
@@ -151,6 +190,8 @@ struct NavMeshSettings {
     filterLowHangingObstacles = true;
     filterLedgeSpans = true;
     filterWalkableLowHeightSpans = true;
+    cullInputTriangles = true;
+    tileSize = 0.0f;
   }
 
   NavMeshSettings() { setDefaults(); }
@@ -158,6 +199,9 @@ struct NavMeshSettings {
   ESP_SMART_POINTERS(NavMeshSettings)
 };
 
+bool operator==(const NavMeshSettings& a, const NavMeshSettings& b);
+bool operator!=(const NavMeshSettings& a, const NavMeshSettings& b);
+
 /** Loads and/or builds a navigation mesh and then performs path
  * finding and collision queries on that navmesh
  *
@@ -170,6 +214,14 @@ class PathFinder {
   PathFinder();
   ~PathFinder() = default;
 
+  /**
+   * @brief Builds the navmesh of a triangle mesh inside bounds
+   *
+   * Tiles of a tiled build, see @ref NavMeshSettings.tileSize, are built in
+   * parallel. Building again with the same settings and bounds as a tiled
+   * last build keeps the tiles whose geometry did not change, so recomputing
+   * the navmesh after moving a few objects only rebuilds the tiles they touch.
+   */
   bool build(const NavMeshSettings& bs,
              const float* verts,
              const int nverts,
@@ -179,16 +231,90 @@ class PathFinder {
              const float* bmax);
   bool build(const NavMeshSettings& bs, const esp::assets::MeshData& mesh);
 
+  /**
+   * @brief Builds the navmeshes of several agents from one triangle mesh
+   *
+   * When the settings only differ in @ref NavMeshSettings.agentRadius and
+   * @ref NavMeshSettings.agentHeight and none is tiled, the mesh is
+   * rasterized once for all of them, the agents of the same height share the
+   * compact heightfield, and only the erosion by the radius and the steps
+   * after it run for each agent. Otherwise each navmesh is built on its own,
+   * as by @ref build.
+   *
+   * @param[in] variants The settings of each agent
+   * @param[in] mesh The scene geometry
+   *
+   * @return A pathfinder for each of @p variants, in the same order. The ones
+   * that could not be built are not loaded, see @ref isLoaded
+   */
+  static std::vector<std::shared_ptr<PathFinder>> buildVariants(
+      const std::vector<NavMeshSettings>& variants,
+      const esp::assets::MeshData& mesh);
+
+  /**
+   * @brief Rebuilds the tiles of a tiled navmesh which a region of the scene
+   * geometry can affect
+   *
+   * Only the tiles overlapping the region, grown by the tile border, are
+   * rebuilt from @p mesh, with the @ref NavMeshSettings of the last @ref
+   * build. To track a moved object, the region has to cover both its old and
+   * its new bounds. Dependent state, such as the islands and any @ref
+   * GeodesicDistanceField, is invalidated as on a full @ref build.
+   *
+   * @param[in] mesh The whole, updated scene geometry
+   * @param[in] regionMin Minimum of the changed region
+   * @param[in] regionMax Maximum of the changed region
+   *
+   * @return Whether the tiles were rebuilt. Fails if the navmesh was not
+   * built with @ref NavMeshSettings.tileSize greater than zero.
+   */
+  bool updateRegion(const esp::assets::MeshData& mesh,
+                    const vec3f& regionMin,
+                    const vec3f& regionMax);
+
   /**
    * @brief Returns a random navigable point
    *
+   * Points are uniformly distributed over the navigable area. The detail
+   * triangles of the navmesh and their accumulated areas are tabulated on
+   * the first call, after which a point is sampled in O(log n).
+   *
+   * @param[in] islandIndex Restrict the point to this island, see @ref
+   * getIslandIndex(). @ref ID_UNDEFINED samples all islands.
+   *
    * @return A random navigable point.
    *
    * @note This method can fail.  If it does,
    * the returned point will be arbitrary and may not be navigable. Use @ref
    * isNavigable to check if the point is navigable.
    */
-  vec3f getRandomNavigablePoint();
+  vec3f getRandomNavigablePoint(int islandIndex = ID_UNDEFINED);
+
+  /**
+   * @brief Sample many random navigable points at once, as with @ref
+   * getRandomNavigablePoint()
+   *
+   * @param[in] numPoints The number of points
+   * @param[in] islandIndex Restrict the points to this island, @ref
+   * ID_UNDEFINED samples all islands.
+   *
+   * @return The points, empty on failure.
+   */
+  std::vector<vec3f> sampleNavigablePoints(int numPoints,
+                                           int islandIndex = ID_UNDEFINED);
+
+  /**
+   * @brief The index of the island (connected component) @p pt belongs to
+   *
+   * @return The island index in [0, @ref numIslands()), or @ref
+   * ID_UNDEFINED if @p pt is not on the navmesh.
+   */
+  int getIslandIndex(const vec3f& pt) const;
+
+  /**
+   * @brief The number of islands of the navmesh, zero if none is loaded
+   */
+  int numIslands() const;
 
   /**
    * @brief Finds the shortest path between two points on the navigation mesh
@@ -217,6 +343,185 @@ class PathFinder {
    */
   bool findPath(MultiGoalShortestPath& path);
 
+  /**
+   * @brief Keep the results of the last @p size distinct @ref
+   * findPath(ShortestPath&) queries
+   *
+   * A query with the same requested start and end as a cached one, bit for
+   * bit, copies its result instead of searching, e.g. the repeated success
+   * and SPL checks of an episode. The least recently used result is dropped
+   * when the cache is full. The cache is cleared when the navmesh changes,
+   * zero, the default, disables it. Must not be called concurrently with a
+   * query.
+   */
+  void setPathCacheSize(size_t size);
+
+  /** @brief The number of cached results, see @ref setPathCacheSize() */
+  size_t getPathCacheSize() const;
+
+  /**
+   * @brief The number of queries the cache answered, see @ref
+   * setPathCacheSize()
+   */
+  size_t getPathCacheHits() const;
+
+  /**
+   * @brief The number of queries the cache searched for, see @ref
+   * setPathCacheSize()
+   */
+  size_t getPathCacheMisses() const;
+
+  /**
+   * @brief Finds the shortest paths of many @ref ShortestPath queries in
+   * parallel
+   *
+   * Same as calling @ref findPath(ShortestPath&) on each of @p paths, but the
+   * queries are distributed over @p numThreads worker threads, each with its
+   * own Detour query object. Must not run concurrently with any other method
+   * of this @ref PathFinder.
+   *
+   * @param[inout] paths The queries, their @ref ShortestPath.points and @ref
+   * ShortestPath.geodesicDistance fields are populated
+   * @param[in] numThreads The number of worker threads, including the calling
+   * one. If zero or less, all threads of @ref core::TaskScheduler::global()
+   * are used, which also bounds larger counts.
+   */
+  void findPathsBatch(std::vector<ShortestPath>& paths, int numThreads = 0);
+
+  /**
+   * @brief Geodesic distances between pairs of points, computed in parallel
+   *
+   * Like @ref findPathsBatch, but only returns the distances, without
+   * storing the points of the paths.
+   *
+   * @param[in] starts The start points
+   * @param[in] ends The end points, same count as @p starts
+   * @param[in] numThreads The number of worker threads, see @ref
+   * findPathsBatch
+   *
+   * @return The geodesic distance from `starts[i]` to `ends[i]` for every
+   * pair, inf if no path exists
+   */
+  std::vector<float> findDistancesBatch(const std::vector<vec3f>& starts,
+                                        const std::vector<vec3f>& ends,
+                                        int numThreads = 0);
+
+  /**
+   * @brief @ref snapPoint for many points, in parallel
+   *
+   * @param[in] pts The points to snap
+   * @param[in] numThreads The number of worker threads, see @ref
+   * findPathsBatch
+   *
+   * @return The snapped point for every point, {NAN, NAN, NAN} where none
+   * was within a reasonable distance
+   */
+  std::vector<vec3f> snapPointsBatch(const std::vector<vec3f>& pts,
+                                     int numThreads = 0);
+
+  /**
+   * @brief @ref isNavigable for many points, in parallel
+   *
+   * @param[in] pts The points to check
+   * @param[in] maxYDelta The maximum y displacement, see @ref isNavigable
+   * @param[in] numThreads The number of worker threads, see @ref
+   * findPathsBatch
+   *
+   * @return Whether each point is navigable
+   */
+  Eigen::Matrix<bool, Eigen::Dynamic, 1> isNavigableBatch(
+      const std::vector<vec3f>& pts,
+      float maxYDelta = 0.5,
+      int numThreads = 0);
+
+  /**
+   * @brief @ref tryStep or @ref tryStepNoSliding for many pairs of points,
+   * in parallel
+   *
+   * @param[in] starts The start points
+   * @param[in] ends The end points, same count as @p starts
+   * @param[in] allowSliding Whether to slide along walls, as @ref tryStep,
+   * or not, as @ref tryStepNoSliding
+   * @param[in] numThreads The number of worker threads, see @ref
+   * findPathsBatch
+   *
+   * @return The point reached from `starts[i]` towards `ends[i]` for every
+   * pair, the start point if the pathfinder is not loaded
+   */
+  std::vector<vec3f> tryStepsBatch(const std::vector<vec3f>& starts,
+                                   const std::vector<vec3f>& ends,
+                                   bool allowSliding = true,
+                                   int numThreads = 0);
+
+  /**
+   * @brief Run `func(i, threadIndex)` for all `i` in `[0, numItems)` on
+   * worker threads which each have their own Detour query object
+   *
+   * Within @p func, the methods of this @ref PathFinder which only query the
+   * navmesh may be called concurrently: @ref findPath, @ref tryStep, @ref
+   * tryStepNoSliding, @ref snapPoint, @ref isNavigable, @ref islandRadius,
+   * @ref getIslandIndex, @ref distanceToClosestObstacle, @ref
+   * closestObstacleSurfacePoint, @ref buildGeodesicDistanceField and @ref
+   * geodesicDistance. Everything else, including the batched queries, must not
+   * be called until this returns.
+   *
+   * @param[in] numItems The number of items
+   * @param[in] numThreads The number of worker threads, see @ref
+   * findPathsBatch
+   * @param[in] func Called once per item, with the index of the worker thread
+   * in `[0, numThreads)`
+   */
+  void parallelFor(size_t numItems,
+                   int numThreads,
+                   const std::function<void(size_t, int)>& func);
+
+  /**
+   * @brief Builds a @ref GeodesicDistanceField to the closest of @p goals
+   *
+   * @param[in] goals The goals, goals which cannot be snapped to the navmesh
+   * are ignored
+   * @param[in] samplesPerPortal The number of samples on every portal between
+   * two polygons, at least 2. More samples make the distances more accurate
+   * at the cost of a slower build.
+   */
+  GeodesicDistanceField::ptr buildGeodesicDistanceField(
+      const std::vector<vec3f>& goals,
+      int samplesPerPortal = 3);
+
+  /**
+   * @brief Geodesic distance from a point to the closest goal of a @ref
+   * GeodesicDistanceField
+   *
+   * @param[in] field A field built by this path finder on the current navmesh
+   * @param[in] pt The point, snapped to the navmesh
+   *
+   * @return The distance, inf if no goal is reachable from @p pt or the field
+   * is not valid for the current navmesh
+   */
+  float geodesicDistance(const GeodesicDistanceField& field, const vec3f& pt);
+
+  /**
+   * @brief Geodesic distances between all pairs of a set of points
+   *
+   * The portals are sampled once, as for a @ref GeodesicDistanceField, and a
+   * Dijkstra search from each point, in parallel over the points, gives the
+   * distances to all others. Much cheaper than a @ref findPath for each pair,
+   * the distances are those of the same approximation as @ref
+   * geodesicDistance.
+   *
+   * @param[in] points The points, snapped to the navmesh
+   * @param[in] samplesPerPortal The number of samples on every portal, see
+   * @ref buildGeodesicDistanceField
+   * @param[in] numThreads The number of worker threads, see @ref
+   * findPathsBatch
+   *
+   * @return The matrix of the distances from `points[i]` to `points[j]`, inf
+   * where no path exists or a point can't be snapped
+   */
+  Eigen::MatrixXf geodesicDistanceMatrix(const std::vector<vec3f>& points,
+                                         int samplesPerPortal = 3,
+                                         int numThreads = 0);
+
   /**
    * @brief Attempts to move from @ref start to @ref end and returns the
    * navigable point closest to @ref end that is feasibly reachable from @ref
@@ -250,6 +555,12 @@ class PathFinder {
   /**
    * @brief Loads a navigation meshed saved by @ref saveNavMesh
    *
+   * Files saved as mappable are memory mapped on Unix platforms, the tiles
+   * are used in place instead of being read into memory. The mapping is
+   * private, so only the pages Detour writes to, the polygons and their
+   * links, are copied. The rest stays shared with all other processes which
+   * loaded the file. Files in the default format are read.
+   *
    * @param[in] path The saved navigation mesh file, generally has extension
    * ``.navmesh``
    *
@@ -261,22 +572,110 @@ class PathFinder {
    * @brief Saves a navigation mesh to later be loaded by @ref loadNavMesh
    *
    * @param[in] path The name of the file, generally has extension ``.navmesh``
+   * @param[in] mappable Write the format @ref loadNavMesh memory maps
+   * instead of the default one. Older versions can't read it.
    *
    * @return Whether or not the navmesh was successfully saved
    */
-  bool saveNavMesh(const std::string& path);
+  bool saveNavMesh(const std::string& path, bool mappable = false);
+
+  /**
+   * @brief Saves the navigation meshes of several agents, e.g. built by @ref
+   * buildVariants, into one file
+   *
+   * The navmeshes are stored in the default format, with their islands, and
+   * are read rather than memory mapped by @ref loadNavMeshVariants.
+   *
+   * @param[in] pathFinders The loaded pathfinders of the agents
+   * @param[in] path The name of the file
+   *
+   * @return Whether or not all navigation meshes were successfully saved
+   */
+  static bool saveNavMeshVariants(
+      const std::vector<std::shared_ptr<PathFinder>>& pathFinders,
+      const std::string& path);
+
+  /**
+   * @brief Loads the navigation meshes saved by @ref saveNavMeshVariants
+   *
+   * @param[in] path The saved file
+   *
+   * @return A pathfinder for each navigation mesh, in the order they were
+   * saved, or none if the file could not be loaded
+   */
+  static std::vector<std::shared_ptr<PathFinder>> loadNavMeshVariants(
+      const std::string& path);
 
   /**
    * @return If a navigation mesh is current loaded or not
    */
   bool isLoaded() const;
 
+  /**
+   * @brief Compresses the tiles of the loaded navigation mesh in memory
+   *
+   * For pathfinders kept around while not in use, e.g. the navmeshes of many
+   * cached scenes. The tiles are compressed independently and everything
+   * derived from them, including the islands and the Detour queries, is
+   * freed. The first later call needing the navmesh decompresses all tiles
+   * and rebuilds the islands, Detour needs every tile a query may cross
+   * resident. The navmesh stays loaded and its polygons are the same, so
+   * @ref GeodesicDistanceField "GeodesicDistanceFields" stay valid, while an
+   * obstacle distance field or path hierarchy have to be built again.
+   *
+   * The const queries may run concurrently on a compressed navmesh, the
+   * first of them decompresses it under a lock while the others wait. Calling
+   * @ref compress itself concurrently with any query is not supported.
+   *
+   * @return Whether the navigation mesh is compressed
+   */
+  bool compress();
+
+  /**
+   * @brief Whether the navigation mesh is compressed, see @ref compress
+   */
+  bool isCompressed() const;
+
+  /**
+   * @brief Bytes of the tile data of the navigation mesh, compressed if
+   * @ref isCompressed
+   */
+  size_t getTileDataBytes() const;
+
+  /**
+   * @brief Keeps only the tiles of the navigation mesh near some points
+   * resident, e.g. the agents in a streamed stage, see @ref
+   * assets::StageStreamer
+   *
+   * Tiles farther than @p radius from all @p points are compressed in memory
+   * as by @ref compress and removed from the navmesh, evicted tiles within
+   * @p radius of a point are restored with the same polygon refs. Path and
+   * point queries only see the resident tiles, so paths end at the border of
+   * the evicted ones. The islands, cached paths, sampled points, obstacle
+   * distance field and path hierarchy are kept across calls and describe the
+   * whole navmesh, the evicted tiles are restored briefly to build them.
+   * @ref saveNavMesh and @ref compress also restore the evicted tiles.
+   *
+   * @param[in] points The points to keep the tiles around
+   * @param[in] radius The largest distance of a resident tile to a point
+   *
+   * @return The number of tiles evicted or restored
+   */
+  int streamTiles(const std::vector<vec3f>& points, float radius);
+
+  /**
+   * @brief The number of tiles evicted by @ref streamTiles
+   */
+  int getNumEvictedTiles() const;
+
   /**
    * @brief Seed the pathfinder.  Useful for @ref getRandomNavigablePoint
    *
    * @param[in] newSeed The random seed
    *
-   * @note This just seeds the global c @ref rand function.
+   * @note The sampled points come from a @ref core::Random owned by the
+   * pathfinder rather than the global C @ref rand function, so pathfinders
+   * sample independently and reproducibly.
    */
   void seed(uint32_t newSeed);
 
@@ -309,6 +708,80 @@ class PathFinder {
       const vec3f& pt,
       const float maxSearchRadius = 2.0) const;
 
+  /**
+   * @brief @ref distanceToClosestObstacle for many points at once
+   */
+  std::vector<float> distancesToClosestObstacle(
+      const std::vector<vec3f>& pts,
+      const float maxSearchRadius = 2.0) const;
+
+  /**
+   * @brief Precompute the distances to the closest obstacle on a grid
+   *
+   * Afterwards, @ref distanceToClosestObstacle and @ref
+   * closestObstacleSurfacePoint look the closest obstacle up in the grid
+   * cell of the point, on the surface at the height of the point, instead of
+   * querying the navmesh. Points off the grid, and search radii above
+   * @p maxDistance where no obstacle is within @p maxDistance, still use the
+   * navmesh query. Every surface of a multi-level navmesh gets its own
+   * distances.
+   *
+   * The looked up distances are within @ref obstacleDistanceFieldMaxError()
+   * of the queried ones, except near obstacles narrower than a cell. The field
+   * is discarded when the navmesh changes.
+   *
+   * @param[in] cellSize The size of a grid cell in meters
+   * @param[in] maxDistance Distances are precomputed up to this
+   *
+   * @return Whether the field was built
+   */
+  bool buildObstacleDistanceField(const float cellSize = 0.05f,
+                                  const float maxDistance = 2.0f);
+
+  /**
+   * @brief Whether @ref buildObstacleDistanceField was called on the current
+   * navmesh
+   */
+  bool hasObstacleDistanceField() const;
+
+  /**
+   * @brief The bound of the difference of the distances looked up in the
+   * obstacle distance field to the queried ones, twice its cell size. Zero if
+   * there is no field.
+   */
+  float obstacleDistanceFieldMaxError() const;
+
+  /**
+   * @brief Precompute clusters of the navmesh for long paths
+   *
+   * The polygons are clustered by the cells of a grid, every connected part
+   * of a cell being a cluster, and the clusters sharing a polygon edge are
+   * linked in a graph. Afterwards, @ref findPath and the batched queries
+   * search a path longer than eight cells in the graph first, and then with
+   * Detour in segments of four clusters along it, dropping the corners at
+   * the segment ends where the path can go straight past them. Long paths no
+   * longer run out of the polygons of a single Detour search, and their cost
+   * grows with their length instead of the size of the navmesh. They can be
+   * slightly longer than the shortest ones. The clusters are discarded when
+   * the navmesh changes.
+   *
+   * @param[in] clusterSize The size of a grid cell in meters
+   *
+   * @return Whether the clusters were built
+   */
+  bool buildPathHierarchy(const float clusterSize = 8.0f);
+
+  /**
+   * @brief Whether @ref buildPathHierarchy was called on the current navmesh
+   */
+  bool hasPathHierarchy() const;
+
+  /**
+   * @brief The number of clusters of @ref buildPathHierarchy, zero if there
+   * are none
+   */
+  int numPathClusters() const;
+
   /**
    * @brief Query whether or not a given location is navigable
    *
@@ -334,13 +807,23 @@ class PathFinder {
    */
   std::pair<vec3f, vec3f> bounds() const;
 
+  /**
+   * @brief Occupancy map of the navmesh at a height, seen from above.
+   *
+   * Pixel (h, w) samples the point (min x + w * metersPerPixel, height, min z
+   * + h * metersPerPixel) of @ref bounds() and is true if it lies on a
+   * walkable polygon within 0.5 of @p height, as with @ref isNavigable(). The
+   * polygons are rasterized into the map directly, and the map is cached per
+   * (@p metersPerPixel, @p height) until the navmesh changes.
+   */
   Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> getTopDownView(
       const float metersPerPixel,
       const float height);
 
   /**
    * @brief Returns a MeshData object containing triangulated NavMesh polys. The
-   * object is generated and stored if this is the first query.
+   * object is generated if this is the first query, and kept for later ones
+   * only as long as a caller holds it.
    *
    * Does nothing if the PathFinder is not loaded.
    *
@@ -0,0 +1,272 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/TestSuite/Tester.h>
+#include <Corrade/Utility/Directory.h>
+
+#include <esp/assets/MeshData.h>
+#include <esp/nav/PathFinder.h>
+
+#include "configure.h"
+
+namespace Cr = Corrade;
+
+namespace {
+
+constexpr struct {
+  const char* name;
+  const char* navmesh;
+} SceneData[]{
+    {"skokloster-castle", "habitat-test-scenes/skokloster-castle.navmesh"},
+    {"van-gogh-room", "habitat-test-scenes/van-gogh-room.navmesh"},
+};
+
+constexpr struct {
+  const char* name;
+  int numGoals;
+} MultiGoalData[]{{"1 goal", 1}, {"10 goals", 10}, {"100 goals", 100}};
+
+//! number of queries per benchmark iteration, so the fast ones are measurable
+constexpr int QueriesPerIteration = 100;
+
+/**
+ * @brief Benchmarks of the navmesh queries, to track their performance.
+ *
+ * The queries run on the bundled test scenes, with points sampled from a
+ * fixed seed. Skips scenes which are not downloaded.
+ */
+struct PathFinderBenchmark : Cr::TestSuite::Tester {
+  explicit PathFinderBenchmark();
+
+  void findPath();
+  void findPathMultiGoal();
+  void tryStep();
+  void snapPoint();
+  void isNavigable();
+  void getTopDownView();
+  void loadNavMesh();
+  void build();
+
+  std::string navmeshPath();
+  //! loads the scene of the test case instance, false if it is missing
+  bool loadScene(esp::nav::PathFinder& pathFinder);
+  //! start and end points with a path between them
+  void samplePairs(esp::nav::PathFinder& pathFinder,
+                   std::vector<esp::vec3f>& starts,
+                   std::vector<esp::vec3f>& ends);
+};
+
+PathFinderBenchmark::PathFinderBenchmark() {
+  addInstancedBenchmarks(
+      {&PathFinderBenchmark::findPath, &PathFinderBenchmark::tryStep,
+       &PathFinderBenchmark::snapPoint, &PathFinderBenchmark::isNavigable,
+       &PathFinderBenchmark::getTopDownView, &PathFinderBenchmark::loadNavMesh},
+      10, Cr::Containers::arraySize(SceneData));
+  addInstancedBenchmarks({&PathFinderBenchmark::findPathMultiGoal}, 10,
+                         Cr::Containers::arraySize(MultiGoalData));
+  addInstancedBenchmarks({&PathFinderBenchmark::build}, 3,
+                         Cr::Containers::arraySize(SceneData));
+}
+
+std::string PathFinderBenchmark::navmeshPath() {
+  auto&& data = SceneData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+  return Cr::Utility::Directory::join(SCENE_DATASETS, data.navmesh);
+}
+
+bool PathFinderBenchmark::loadScene(esp::nav::PathFinder& pathFinder) {
+  const std::string path = navmeshPath();
+  if (!Cr::Utility::Directory::exists(path) || !pathFinder.loadNavMesh(path))
+    return false;
+  pathFinder.seed(0);
+  return true;
+}
+
+void PathFinderBenchmark::samplePairs(esp::nav::PathFinder& pathFinder,
+                                      std::vector<esp::vec3f>& starts,
+                                      std::vector<esp::vec3f>& ends) {
+  while (starts.size() < QueriesPerIteration) {
+    esp::nav::ShortestPath path;
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+    if (pathFinder.findPath(path)) {
+      starts.push_back(path.requestedStart);
+      ends.push_back(path.requestedEnd);
+    }
+  }
+}
+
+void PathFinderBenchmark::findPath() {
+  esp::nav::PathFinder pathFinder;
+  if (!loadScene(pathFinder))
+    CORRADE_SKIP("The test scene is not available");
+
+  std::vector<esp::vec3f> starts, ends;
+  samplePairs(pathFinder, starts, ends);
+
+  int found = 0;
+  CORRADE_BENCHMARK(1) {
+    for (size_t i = 0; i < starts.size(); ++i) {
+      esp::nav::ShortestPath path;
+      path.requestedStart = starts[i];
+      path.requestedEnd = ends[i];
+      found += pathFinder.findPath(path);
+    }
+  }
+  CORRADE_COMPARE(found, starts.size());
+}
+
+void PathFinderBenchmark::findPathMultiGoal() {
+  auto&& data = MultiGoalData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  esp::nav::PathFinder pathFinder;
+  const std::string path =
+      Cr::Utility::Directory::join(SCENE_DATASETS, SceneData[0].navmesh);
+  if (!Cr::Utility::Directory::exists(path) || !pathFinder.loadNavMesh(path))
+    CORRADE_SKIP("The test scene is not available");
+  pathFinder.seed(0);
+
+  // goals on the island of the start, so a path always exists
+  std::vector<esp::vec3f> starts;
+  std::vector<std::vector<esp::vec3f>> goals;
+  for (int i = 0; i < QueriesPerIteration; ++i) {
+    starts.push_back(pathFinder.getRandomNavigablePoint());
+    goals.push_back(pathFinder.sampleNavigablePoints(
+        data.numGoals, pathFinder.getIslandIndex(starts.back())));
+  }
+
+  int found = 0;
+  CORRADE_BENCHMARK(1) {
+    for (size_t i = 0; i < starts.size(); ++i) {
+      // a new path every time, so nothing is cached between the queries
+      esp::nav::MultiGoalShortestPath path;
+      path.requestedStart = starts[i];
+      path.setRequestedEnds(goals[i]);
+      found += pathFinder.findPath(path);
+    }
+  }
+  CORRADE_COMPARE(found, starts.size());
+}
+
+void PathFinderBenchmark::tryStep() {
+  esp::nav::PathFinder pathFinder;
+  if (!loadScene(pathFinder))
+    CORRADE_SKIP("The test scene is not available");
+
+  // steps of an agent, towards a random point
+  std::vector<esp::vec3f> starts, ends;
+  for (int i = 0; i < QueriesPerIteration; ++i) {
+    starts.push_back(pathFinder.getRandomNavigablePoint());
+    const esp::vec3f direction =
+        pathFinder.getRandomNavigablePoint() - starts.back();
+    ends.push_back(starts.back() + 0.25f * direction.normalized());
+  }
+
+  esp::vec3f sum = esp::vec3f::Zero();
+  CORRADE_BENCHMARK(1) {
+    for (size_t i = 0; i < starts.size(); ++i) {
+      sum += pathFinder.tryStep(starts[i], ends[i]);
+    }
+  }
+  CORRADE_VERIFY(sum.allFinite());
+}
+
+void PathFinderBenchmark::snapPoint() {
+  esp::nav::PathFinder pathFinder;
+  if (!loadScene(pathFinder))
+    CORRADE_SKIP("The test scene is not available");
+
+  // points somewhat above and beside the navmesh
+  std::vector<esp::vec3f> points;
+  for (int i = 0; i < QueriesPerIteration; ++i) {
+    points.push_back(pathFinder.getRandomNavigablePoint() +
+                     esp::vec3f(0.1f, 0.5f, -0.1f));
+  }
+
+  esp::vec3f sum = esp::vec3f::Zero();
+  CORRADE_BENCHMARK(1) {
+    for (const esp::vec3f& pt : points) {
+      sum += pathFinder.snapPoint(pt);
+    }
+  }
+  CORRADE_VERIFY(sum.allFinite());
+}
+
+void PathFinderBenchmark::isNavigable() {
+  esp::nav::PathFinder pathFinder;
+  if (!loadScene(pathFinder))
+    CORRADE_SKIP("The test scene is not available");
+
+  // uniformly in the bounds, so many of them are not navigable
+  const std::pair<esp::vec3f, esp::vec3f> bounds = pathFinder.bounds();
+  std::vector<esp::vec3f> points;
+  for (int i = 0; i < QueriesPerIteration; ++i) {
+    const esp::vec3f t = 0.5f * (esp::vec3f::Random().array() + 1.0f);
+    points.push_back(bounds.first +
+                     esp::vec3f((bounds.second - bounds.first).array() *
+                                t.array()));
+  }
+
+  int navigable = 0;
+  CORRADE_BENCHMARK(1) {
+    for (const esp::vec3f& pt : points) {
+      navigable += pathFinder.isNavigable(pt);
+    }
+  }
+  CORRADE_VERIFY(navigable >= 0);
+}
+
+void PathFinderBenchmark::getTopDownView() {
+  esp::nav::PathFinder pathFinder;
+  if (!loadScene(pathFinder))
+    CORRADE_SKIP("The test scene is not available");
+
+  const float height = pathFinder.getRandomNavigablePoint()[1];
+  // a new path finder each iteration would measure the load, so the cache is
+  // defeated with a slightly different height instead
+  float offset = 0.0f;
+  bool any = false;
+  CORRADE_BENCHMARK(1) {
+    offset += 1e-4f;
+    any |= pathFinder.getTopDownView(0.05f, height + offset).any();
+  }
+  CORRADE_VERIFY(any);
+}
+
+void PathFinderBenchmark::loadNavMesh() {
+  const std::string path = navmeshPath();
+  if (!Cr::Utility::Directory::exists(path))
+    CORRADE_SKIP("The test scene is not available");
+
+  bool loaded = true;
+  CORRADE_BENCHMARK(1) {
+    esp::nav::PathFinder pathFinder;
+    loaded &= pathFinder.loadNavMesh(path);
+  }
+  CORRADE_VERIFY(loaded);
+}
+
+void PathFinderBenchmark::build() {
+  esp::nav::PathFinder source;
+  if (!loadScene(source))
+    CORRADE_SKIP("The test scene is not available");
+
+  // the walkable surface of the scene as the input geometry, which doesn't
+  // need the scene assets
+  const std::shared_ptr<esp::assets::MeshData> mesh = source.getNavMeshData();
+  esp::nav::NavMeshSettings settings;
+
+  bool built = true;
+  CORRADE_BENCHMARK(1) {
+    esp::nav::PathFinder pathFinder;
+    built &= pathFinder.build(settings, *mesh);
+  }
+  CORRADE_VERIFY(built);
+}
+
+}  // namespace
+
+CORRADE_TEST_MAIN(PathFinderBenchmark)
@@ -1,7 +1,10 @@
+#include <cmath>
+
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/TestSuite/Compare/Numeric.h>
 #include <Corrade/TestSuite/Tester.h>
 
+#include <esp/assets/MeshData.h>
 #include <esp/nav/PathFinder.h>
 
 #include <Corrade/Utility/Directory.h>
@@ -27,6 +30,36 @@ constexpr struct {
 } MultiGoalBenchMarkData[]{{"path to closest of 1000", false},
                            {"cached path to closest of 1000", true}};
 
+//! append a quad with vertices in counter-clockwise order seen from above
+void addQuad(esp::assets::MeshData& mesh,
+             const esp::vec3f& a,
+             const esp::vec3f& b,
+             const esp::vec3f& c,
+             const esp::vec3f& d) {
+  const uint32_t first = mesh.vbo.size();
+  mesh.vbo.insert(mesh.vbo.end(), {a, b, c, d});
+  mesh.ibo.insert(mesh.ibo.end(), {first, first + 1, first + 2, first,
+                                   first + 2, first + 3});
+}
+
+//! a 10x10 m floor, optionally with a 1 m box centered at boxX, boxZ
+esp::assets::MeshData floorMesh(bool withBox,
+                                float boxX = 5.0f,
+                                float boxZ = 5.0f) {
+  esp::assets::MeshData mesh;
+  addQuad(mesh, {0, 0, 0}, {0, 0, 10}, {10, 0, 10}, {10, 0, 0});
+  if (withBox) {
+    const float x0 = boxX - 0.5f, x1 = boxX + 0.5f;
+    const float z0 = boxZ - 0.5f, z1 = boxZ + 0.5f;
+    addQuad(mesh, {x0, 1, z0}, {x0, 1, z1}, {x1, 1, z1}, {x1, 1, z0});
+    addQuad(mesh, {x0, 0, z0}, {x0, 1, z0}, {x1, 1, z0}, {x1, 0, z0});
+    addQuad(mesh, {x0, 0, z1}, {x1, 0, z1}, {x1, 1, z1}, {x0, 1, z1});
+    addQuad(mesh, {x0, 0, z0}, {x0, 0, z1}, {x0, 1, z1}, {x0, 1, z0});
+    addQuad(mesh, {x1, 0, z0}, {x1, 1, z0}, {x1, 1, z1}, {x1, 0, z1});
+  }
+  return mesh;
+}
+
 struct PathFinderTest : Cr::TestSuite::Tester {
   explicit PathFinderTest();
 
@@ -38,13 +71,37 @@ struct PathFinderTest : Cr::TestSuite::Tester {
   void benchmarkMultiGoal();
 
   void testCaching();
+  void findPathsBatch();
+  void geodesicDistanceField();
+  void tiledBuild();
+  void updateRegion();
+  void rebuildChangedTiles();
+  void cullInputTriangles();
+  void saveLoadIslands();
+  void topDownView();
+  void sampleNavigablePoints();
+  void obstacleDistanceField();
+  void saveLoadFormats();
+
+  void benchmarkGeodesicDistanceField();
 };
 
 PathFinderTest::PathFinderTest() {
   addTests({&PathFinderTest::bounds, &PathFinderTest::tryStepNoSliding,
-            &PathFinderTest::multiGoalPath, &PathFinderTest::testCaching});
-
-  addBenchmarks({&PathFinderTest::benchmarkSingleGoal}, 1000);
+            &PathFinderTest::multiGoalPath, &PathFinderTest::testCaching,
+            &PathFinderTest::findPathsBatch,
+            &PathFinderTest::geodesicDistanceField,
+            &PathFinderTest::tiledBuild, &PathFinderTest::updateRegion,
+            &PathFinderTest::rebuildChangedTiles,
+            &PathFinderTest::cullInputTriangles,
+            &PathFinderTest::saveLoadIslands, &PathFinderTest::topDownView,
+            &PathFinderTest::sampleNavigablePoints,
+            &PathFinderTest::obstacleDistanceField,
+            &PathFinderTest::saveLoadFormats});
+
+  addBenchmarks({&PathFinderTest::benchmarkSingleGoal,
+                 &PathFinderTest::benchmarkGeodesicDistanceField},
+                1000);
   addInstancedBenchmarks({&PathFinderTest::benchmarkMultiGoal}, 100,
                          Cr::Containers::arraySize(MultiGoalBenchMarkData));
 }
@@ -154,6 +211,368 @@ void PathFinderTest::testCaching() {
   }
 }
 
+void PathFinderTest::findPathsBatch() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::nav::ShortestPath> paths(1000);
+  std::vector<esp::vec3f> starts, ends;
+  for (esp::nav::ShortestPath& path : paths) {
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+    starts.push_back(path.requestedStart);
+    ends.push_back(path.requestedEnd);
+  }
+  // a start far off the navmesh has no path
+  paths[0].requestedStart = starts[0] = esp::vec3f{1e3f, 1e3f, 1e3f};
+
+  pathFinder.findPathsBatch(paths, 4);
+  const std::vector<float> distances =
+      pathFinder.findDistancesBatch(starts, ends, 4);
+  CORRADE_COMPARE(distances.size(), paths.size());
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    CORRADE_ITERATION(i);
+    esp::nav::ShortestPath path;
+    path.requestedStart = paths[i].requestedStart;
+    path.requestedEnd = paths[i].requestedEnd;
+    const bool found = pathFinder.findPath(path);
+
+    CORRADE_COMPARE(paths[i].geodesicDistance, path.geodesicDistance);
+    CORRADE_COMPARE(paths[i].points.size(), path.points.size());
+    CORRADE_COMPARE(distances[i], path.geodesicDistance);
+    CORRADE_COMPARE(found, i != 0);
+  }
+}
+
+void PathFinderTest::geodesicDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::vec3f> goals;
+  for (int i = 0; i < 5; ++i) {
+    goals.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+  esp::nav::GeodesicDistanceField::ptr field =
+      pathFinder.buildGeodesicDistanceField(goals);
+  CORRADE_COMPARE(field->getGoals().size(), goals.size());
+
+  for (const esp::vec3f& goal : goals) {
+    CORRADE_COMPARE_AS(pathFinder.geodesicDistance(*field, goal), 1e-3f,
+                       Cr::TestSuite::Compare::Less);
+  }
+
+  // the field is a sampled approximation of the closest-goal distance
+  double relativeError = 0.0;
+  int numReachable = 0;
+  for (int i = 0; i < 1000; ++i) {
+    CORRADE_ITERATION(i);
+    const esp::vec3f pt = pathFinder.getRandomNavigablePoint();
+    esp::nav::MultiGoalShortestPath path;
+    path.requestedStart = pt;
+    path.setRequestedEnds(goals);
+    const bool found = pathFinder.findPath(path);
+
+    const float distance = pathFinder.geodesicDistance(*field, pt);
+    CORRADE_COMPARE(std::isfinite(distance), found);
+    if (found && path.geodesicDistance > 1.0f) {
+      relativeError +=
+          std::abs(distance - path.geodesicDistance) / path.geodesicDistance;
+      ++numReachable;
+    }
+  }
+  CORRADE_VERIFY(numReachable > 0);
+  CORRADE_COMPARE_AS(relativeError / numReachable, 0.05,
+                     Cr::TestSuite::Compare::Less);
+
+  // a new navmesh invalidates the field
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(std::isinf(pathFinder.geodesicDistance(*field, goals[0])));
+}
+
+void PathFinderTest::tiledBuild() {
+  esp::nav::NavMeshSettings settings;
+  const esp::assets::MeshData mesh = floorMesh(true);
+
+  esp::nav::PathFinder single;
+  CORRADE_VERIFY(single.build(settings, mesh));
+
+  settings.tileSize = 64;
+  esp::nav::PathFinder tiled;
+  CORRADE_VERIFY(tiled.build(settings, mesh));
+
+  // tiles only change the tessellation, not the navigable surface
+  CORRADE_COMPARE_WITH(tiled.getNavigableArea(), single.getNavigableArea(),
+                       Cr::TestSuite::Compare::around(0.01f *
+                                                      single.getNavigableArea()));
+
+  esp::nav::ShortestPath path;
+  path.requestedStart = esp::vec3f{1.0f, 0.0f, 5.0f};
+  path.requestedEnd = esp::vec3f{9.0f, 0.0f, 5.0f};
+  CORRADE_VERIFY(tiled.findPath(path));
+  // around the box
+  CORRADE_COMPARE_AS(path.geodesicDistance, 8.0f,
+                     Cr::TestSuite::Compare::Greater);
+}
+
+void PathFinderTest::updateRegion() {
+  esp::nav::NavMeshSettings settings;
+  settings.tileSize = 64;
+  esp::nav::PathFinder pathFinder;
+  CORRADE_VERIFY(pathFinder.build(settings, floorMesh(false)));
+  const float emptyArea = pathFinder.getNavigableArea();
+  CORRADE_VERIFY(pathFinder.isNavigable({5.0f, 0.0f, 5.0f}));
+
+  // a box is placed in the center
+  CORRADE_VERIFY(pathFinder.updateRegion(
+      floorMesh(true), {4.5f, 0.0f, 4.5f}, {5.5f, 1.0f, 5.5f}));
+  CORRADE_VERIFY(!pathFinder.isNavigable({5.0f, 0.0f, 5.0f}));
+  CORRADE_VERIFY(pathFinder.isNavigable({1.0f, 0.0f, 1.0f}));
+  CORRADE_COMPARE_AS(pathFinder.getNavigableArea(), emptyArea - 0.5f,
+                     Cr::TestSuite::Compare::Less);
+
+  // and removed again
+  CORRADE_VERIFY(pathFinder.updateRegion(
+      floorMesh(false), {4.5f, 0.0f, 4.5f}, {5.5f, 1.0f, 5.5f}));
+  CORRADE_VERIFY(pathFinder.isNavigable({5.0f, 0.0f, 5.0f}));
+  CORRADE_COMPARE_WITH(pathFinder.getNavigableArea(), emptyArea,
+                       Cr::TestSuite::Compare::around(0.01f * emptyArea));
+
+  // single-tile navmeshes can't be updated
+  esp::nav::PathFinder single;
+  CORRADE_VERIFY(single.build(esp::nav::NavMeshSettings{}, floorMesh(false)));
+  CORRADE_VERIFY(!single.updateRegion(floorMesh(true), {4.5f, 0.0f, 4.5f},
+                                      {5.5f, 1.0f, 5.5f}));
+}
+
+void PathFinderTest::rebuildChangedTiles() {
+  esp::nav::NavMeshSettings settings;
+  settings.tileSize = 64;
+  esp::nav::PathFinder pathFinder;
+  CORRADE_VERIFY(pathFinder.build(settings, floorMesh(true)));
+  const float area = pathFinder.getNavigableArea();
+  CORRADE_VERIFY(!pathFinder.isNavigable({5.0f, 0.0f, 5.0f}));
+
+  // same settings and bounds, only the tiles around the box are rebuilt
+  CORRADE_VERIFY(pathFinder.build(settings, floorMesh(true, 2.0f, 2.0f)));
+  CORRADE_VERIFY(pathFinder.isNavigable({5.0f, 0.0f, 5.0f}));
+  CORRADE_VERIFY(!pathFinder.isNavigable({2.0f, 0.0f, 2.0f}));
+  CORRADE_VERIFY(pathFinder.isNavigable({8.0f, 0.0f, 8.0f}));
+  CORRADE_COMPARE_WITH(pathFinder.getNavigableArea(), area,
+                       Cr::TestSuite::Compare::around(0.01f * area));
+
+  // the result is the one of a build from scratch
+  esp::nav::PathFinder scratch;
+  CORRADE_VERIFY(scratch.build(settings, floorMesh(true, 2.0f, 2.0f)));
+  CORRADE_COMPARE_WITH(
+      pathFinder.getNavigableArea(), scratch.getNavigableArea(),
+      Cr::TestSuite::Compare::around(1e-4f * scratch.getNavigableArea()));
+}
+
+void PathFinderTest::cullInputTriangles() {
+  // a floor rasterized twice, a low ceiling over a strip of it, and a high
+  // one over all of it, the ceilings facing down
+  esp::assets::MeshData mesh = floorMesh(false);
+  addQuad(mesh, {0, 0, 0}, {0, 0, 10}, {10, 0, 10}, {10, 0, 0});
+  addQuad(mesh, {0, 1, 0}, {2, 1, 0}, {2, 1, 10}, {0, 1, 10});
+  addQuad(mesh, {0, 5, 0}, {10, 5, 0}, {10, 5, 10}, {0, 5, 10});
+
+  esp::nav::NavMeshSettings settings;
+  settings.cullInputTriangles = false;
+  esp::nav::PathFinder full;
+  CORRADE_VERIFY(full.build(settings, mesh));
+
+  settings.cullInputTriangles = true;
+  esp::nav::PathFinder culled;
+  CORRADE_VERIFY(culled.build(settings, mesh));
+
+  // the low ceiling still blocks the agent, the culled triangles change
+  // nothing
+  CORRADE_VERIFY(!culled.isNavigable({1.0f, 0.0f, 5.0f}));
+  CORRADE_VERIFY(culled.isNavigable({6.0f, 0.0f, 5.0f}));
+  CORRADE_COMPARE(culled.getNavigableArea(), full.getNavigableArea());
+  CORRADE_COMPARE(Mn::Vector3{culled.bounds().first},
+                  Mn::Vector3{full.bounds().first});
+  CORRADE_COMPARE(Mn::Vector3{culled.bounds().second},
+                  Mn::Vector3{full.bounds().second});
+}
+
+void PathFinderTest::saveLoadIslands() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  // the saved file carries the islands, which are read instead of recomputed
+  const std::string saved = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "PathFinderTest-islands.navmesh");
+  CORRADE_VERIFY(pathFinder.saveNavMesh(saved));
+  esp::nav::PathFinder loaded;
+  CORRADE_VERIFY(loaded.loadNavMesh(saved));
+  CORRADE_VERIFY(Cr::Utility::Directory::rm(saved));
+
+  for (int i = 0; i < 100; ++i) {
+    CORRADE_ITERATION(i);
+    esp::nav::ShortestPath path;
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+    esp::nav::ShortestPath loadedPath = path;
+
+    CORRADE_COMPARE(loaded.islandRadius(path.requestedStart),
+                    pathFinder.islandRadius(path.requestedStart));
+    CORRADE_COMPARE(loaded.findPath(loadedPath), pathFinder.findPath(path));
+    CORRADE_COMPARE(loadedPath.geodesicDistance, path.geodesicDistance);
+  }
+}
+
+void PathFinderTest::topDownView() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  pathFinder.seed(0);
+
+  const float metersPerPixel = 0.1f;
+  const float height = pathFinder.getRandomNavigablePoint()[1];
+  const Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> view =
+      pathFinder.getTopDownView(metersPerPixel, height);
+  CORRADE_VERIFY(view.size() > 0);
+  CORRADE_VERIFY(view.any());
+
+  // the rasterized map agrees with projecting each pixel onto the navmesh,
+  // up to the tolerance isNavigable() has at polygon edges
+  const esp::vec3f start = pathFinder.bounds().first;
+  int mismatches = 0;
+  for (int h = 0; h < view.rows(); ++h) {
+    for (int w = 0; w < view.cols(); ++w) {
+      const esp::vec3f point{start[0] + w * metersPerPixel, height,
+                             start[2] + h * metersPerPixel};
+      mismatches += view(h, w) != pathFinder.isNavigable(point, 0.5);
+    }
+  }
+  CORRADE_COMPARE_AS(mismatches, view.size() / 100,
+                     Cr::TestSuite::Compare::LessOrEqual);
+
+  // cached until the navmesh changes
+  CORRADE_VERIFY(pathFinder.getTopDownView(metersPerPixel, height) == view);
+}
+
+void PathFinderTest::sampleNavigablePoints() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  CORRADE_VERIFY(pathFinder.numIslands() > 0);
+
+  pathFinder.seed(0);
+  const std::vector<esp::vec3f> points = pathFinder.sampleNavigablePoints(100);
+  CORRADE_COMPARE(points.size(), 100);
+  pathFinder.seed(0);
+  CORRADE_VERIFY(pathFinder.getRandomNavigablePoint() == points[0]);
+
+  const int island = pathFinder.getIslandIndex(points[0]);
+  CORRADE_VERIFY(island != esp::ID_UNDEFINED);
+  for (const esp::vec3f& pt :
+       pathFinder.sampleNavigablePoints(100, island)) {
+    CORRADE_VERIFY(pathFinder.isNavigable(pt));
+    CORRADE_COMPARE(pathFinder.getIslandIndex(pt), island);
+  }
+
+  CORRADE_VERIFY(
+      pathFinder.sampleNavigablePoints(1, pathFinder.numIslands()).empty());
+}
+
+void PathFinderTest::obstacleDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  const std::vector<esp::vec3f> points = pathFinder.sampleNavigablePoints(500);
+  const std::vector<float> exact =
+      pathFinder.distancesToClosestObstacle(points);
+
+  CORRADE_VERIFY(!pathFinder.hasObstacleDistanceField());
+  CORRADE_VERIFY(pathFinder.buildObstacleDistanceField(0.05f));
+  CORRADE_VERIFY(pathFinder.hasObstacleDistanceField());
+  const float maxError = pathFinder.obstacleDistanceFieldMaxError();
+  CORRADE_COMPARE(maxError, 0.1f);
+
+  // obstacles narrower than a cell may be missed
+  const std::vector<float> lookedUp =
+      pathFinder.distancesToClosestObstacle(points);
+  int withinBound = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(pathFinder.distanceToClosestObstacle(points[i]),
+                    lookedUp[i]);
+    withinBound += std::abs(lookedUp[i] - exact[i]) <= maxError;
+  }
+  CORRADE_COMPARE_AS(withinBound, 0.95 * points.size(),
+                     Cr::TestSuite::Compare::GreaterOrEqual);
+
+  // discarded with the navmesh
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(!pathFinder.hasObstacleDistanceField());
+}
+
+void PathFinderTest::saveLoadFormats() {
+  esp::nav::NavMeshSettings settings;
+  settings.setDefaults();
+  settings.tileSize = 4.0f;
+  esp::nav::PathFinder pathFinder;
+  CORRADE_VERIFY(pathFinder.build(settings, floorMesh(true)));
+  pathFinder.seed(0);
+
+  for (const bool mappable : {false, true}) {
+    CORRADE_ITERATION(mappable);
+    const std::string saved = Cr::Utility::Directory::join(
+        Cr::Utility::Directory::tmp(), "PathFinderTest-formats.navmesh");
+    CORRADE_VERIFY(pathFinder.saveNavMesh(saved, mappable));
+    esp::nav::PathFinder loaded;
+    CORRADE_VERIFY(loaded.loadNavMesh(saved));
+    // the mapping outlives the file
+    CORRADE_VERIFY(Cr::Utility::Directory::rm(saved));
+
+    CORRADE_COMPARE(loaded.getNavigableArea(),
+                    pathFinder.getNavigableArea());
+    CORRADE_COMPARE(Mn::Vector3{loaded.bounds().first},
+                    Mn::Vector3{pathFinder.bounds().first});
+    CORRADE_COMPARE(Mn::Vector3{loaded.bounds().second},
+                    Mn::Vector3{pathFinder.bounds().second});
+    for (int i = 0; i < 20; ++i) {
+      CORRADE_ITERATION(i);
+      esp::nav::ShortestPath path;
+      path.requestedStart = pathFinder.getRandomNavigablePoint();
+      path.requestedEnd = pathFinder.getRandomNavigablePoint();
+      esp::nav::ShortestPath loadedPath = path;
+      CORRADE_COMPARE(loaded.findPath(loadedPath), pathFinder.findPath(path));
+      CORRADE_COMPARE(loadedPath.geodesicDistance, path.geodesicDistance);
+    }
+  }
+}
+
+void PathFinderTest::benchmarkGeodesicDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  std::vector<esp::vec3f> goals;
+  for (int i = 0; i < 1000; ++i) {
+    goals.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+  esp::nav::GeodesicDistanceField::ptr field =
+      pathFinder.buildGeodesicDistanceField(goals);
+  const esp::vec3f pt = pathFinder.getRandomNavigablePoint();
+
+  float distance;
+  CORRADE_BENCHMARK(5) { distance = pathFinder.geodesicDistance(*field, pt); };
+  CORRADE_VERIFY(std::isfinite(distance));
+}
+
 void PathFinderTest::benchmarkSingleGoal() {
   esp::nav::PathFinder pathFinder;
   pathFinder.loadNavMesh(skokloster);
@@ -0,0 +1,616 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "KinematicCollision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include <Magnum/Math/Functions.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace physics {
+
+namespace {
+
+//! the most triangles in a leaf of a StageBVH
+constexpr uint32_t LeafSize = 4;
+
+//! objects overlapping more cells are kept out of the ObjectSpatialHash grid
+constexpr int MaxObjectCells = 64;
+
+//! axes this short are degenerate for separating axis tests
+constexpr float AxisEpsilon = 1e-12f;
+
+//! the box frame coordinates of the world space offset @p v
+Mn::Vector3 toBoxFrame(const CollisionBox& box, const Mn::Vector3& v) {
+  return {Mn::Math::dot(v, box.axes[0]), Mn::Math::dot(v, box.axes[1]),
+          Mn::Math::dot(v, box.axes[2])};
+}
+
+//! whether the ray from @p origin along @p direction crosses @p bounds
+//! before @p maxT
+bool rayHitsBounds(const Mn::Vector3& origin,
+                   const Mn::Vector3& direction,
+                   float maxT,
+                   const Mn::Range3D& bounds) {
+  float tmin = 0.0f;
+  float tmax = maxT;
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(direction[i]) < AxisEpsilon) {
+      if (origin[i] < bounds.min()[i] || origin[i] > bounds.max()[i]) {
+        return false;
+      }
+      continue;
+    }
+    float t1 = (bounds.min()[i] - origin[i]) / direction[i];
+    float t2 = (bounds.max()[i] - origin[i]) / direction[i];
+    if (t1 > t2) {
+      std::swap(t1, t2);
+    }
+    tmin = std::max(tmin, t1);
+    tmax = std::min(tmax, t2);
+    if (tmin > tmax) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//! Moller-Trumbore intersection of a ray with the triangle @p a, @p b, @p c
+bool rayHitsTriangle(const Mn::Vector3& origin,
+                     const Mn::Vector3& direction,
+                     float maxT,
+                     const Mn::Vector3& a,
+                     const Mn::Vector3& b,
+                     const Mn::Vector3& c,
+                     StageBVH::Hit& hit) {
+  const Mn::Vector3 e1 = b - a;
+  const Mn::Vector3 e2 = c - a;
+  const Mn::Vector3 p = Mn::Math::cross(direction, e2);
+  const float det = Mn::Math::dot(e1, p);
+  if (std::abs(det) < AxisEpsilon) {
+    return false;
+  }
+  const float invDet = 1.0f / det;
+  const Mn::Vector3 s = origin - a;
+  const float u = Mn::Math::dot(s, p) * invDet;
+  if (u < 0.0f || u > 1.0f) {
+    return false;
+  }
+  const Mn::Vector3 q = Mn::Math::cross(s, e1);
+  const float v = Mn::Math::dot(direction, q) * invDet;
+  if (v < 0.0f || u + v > 1.0f) {
+    return false;
+  }
+  const float t = Mn::Math::dot(e2, q) * invDet;
+  if (t < 0.0f || t > maxT) {
+    return false;
+  }
+  hit.t = t;
+  hit.normal = Mn::Math::cross(e1, e2).normalized();
+  if (Mn::Math::dot(hit.normal, direction) > 0.0f) {
+    hit.normal = -hit.normal;
+  }
+  return true;
+}
+
+}  // namespace
+
+CollisionBox CollisionBox::fromTransformedRange(
+    const Mn::Range3D& range,
+    const Mn::Matrix4& transform) {
+  CollisionBox box;
+  box.center = transform.transformPoint(range.center());
+  const Mn::Vector3 halfSize = range.size() / 2.0f;
+  for (int i = 0; i < 3; ++i) {
+    const Mn::Vector3 axis = transform[i].xyz();
+    const float length = axis.length();
+    if (length > AxisEpsilon) {
+      box.axes[i] = axis / length;
+      box.halfExtents[i] = halfSize[i] * length;
+    }
+  }
+  return box;
+}
+
+Mn::Range3D CollisionBox::aabb() const {
+  const Mn::Vector3 extent = Mn::Math::abs(axes[0]) * halfExtents[0] +
+                             Mn::Math::abs(axes[1]) * halfExtents[1] +
+                             Mn::Math::abs(axes[2]) * halfExtents[2];
+  return Mn::Range3D::fromCenter(center, extent);
+}
+
+bool CollisionBox::overlaps(const CollisionBox& other) const {
+  // separating axis test of the 15 candidate axes, in the frame of this box
+  const Mn::Vector3& a = halfExtents;
+  const Mn::Vector3& b = other.halfExtents;
+  float r[3][3], absR[3][3];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      r[i][j] = Mn::Math::dot(axes[i], other.axes[j]);
+      // the epsilon keeps near parallel edges from producing null axes
+      absR[i][j] = std::abs(r[i][j]) + 1e-6f;
+    }
+  }
+  const Mn::Vector3 t = toBoxFrame(*this, other.center - center);
+
+  for (int i = 0; i < 3; ++i) {
+    const float rb = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+    if (std::abs(t[i]) > a[i] + rb) {
+      return false;
+    }
+  }
+  for (int j = 0; j < 3; ++j) {
+    const float ra = a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+    const float d = t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j];
+    if (std::abs(d) > ra + b[j]) {
+      return false;
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+    for (int j = 0; j < 3; ++j) {
+      const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+      const float ra = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+      const float rb = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+      const float d = t[i2] * r[i1][j] - t[i1] * r[i2][j];
+      if (std::abs(d) > ra + rb) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool CollisionBox::overlapsTriangle(const Mn::Vector3& a,
+                                    const Mn::Vector3& b,
+                                    const Mn::Vector3& c) const {
+  // separating axis test in the box frame: the box axes, the triangle normal
+  // and the cross products of the box axes with the triangle edges
+  const Mn::Vector3 v[3]{toBoxFrame(*this, a - center),
+                         toBoxFrame(*this, b - center),
+                         toBoxFrame(*this, c - center)};
+  auto separates = [&](const Mn::Vector3& axis) {
+    if (axis.dot() < AxisEpsilon) {
+      return false;
+    }
+    const float p0 = Mn::Math::dot(v[0], axis);
+    const float p1 = Mn::Math::dot(v[1], axis);
+    const float p2 = Mn::Math::dot(v[2], axis);
+    const float radius = Mn::Math::dot(halfExtents, Mn::Math::abs(axis));
+    return std::min({p0, p1, p2}) > radius ||
+           std::max({p0, p1, p2}) < -radius;
+  };
+
+  for (int i = 0; i < 3; ++i) {
+    const float lo = std::min({v[0][i], v[1][i], v[2][i]});
+    const float hi = std::max({v[0][i], v[1][i], v[2][i]});
+    if (lo > halfExtents[i] || hi < -halfExtents[i]) {
+      return false;
+    }
+  }
+  const Mn::Vector3 edges[3]{v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+  if (separates(Mn::Math::cross(edges[0], edges[1]))) {
+    return false;
+  }
+  const Mn::Vector3 boxAxes[3]{Mn::Vector3::xAxis(), Mn::Vector3::yAxis(),
+                               Mn::Vector3::zAxis()};
+  for (const Mn::Vector3& boxAxis : boxAxes) {
+    for (const Mn::Vector3& edge : edges) {
+      if (separates(Mn::Math::cross(boxAxis, edge))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool CollisionBox::intersectRay(const Mn::Vector3& origin,
+                                const Mn::Vector3& direction,
+                                float maxT,
+                                float& t,
+                                Mn::Vector3& normal) const {
+  const Mn::Vector3 o = toBoxFrame(*this, origin - center);
+  const Mn::Vector3 d = toBoxFrame(*this, direction);
+  float tmin = -std::numeric_limits<float>::infinity();
+  float tmax = std::numeric_limits<float>::infinity();
+  int enterAxis = -1;
+  float enterSign = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(d[i]) < AxisEpsilon) {
+      if (std::abs(o[i]) > halfExtents[i]) {
+        return false;
+      }
+      continue;
+    }
+    float t1 = (-halfExtents[i] - o[i]) / d[i];
+    float t2 = (halfExtents[i] - o[i]) / d[i];
+    // entering through the negative face when moving along the axis
+    float sign = -1.0f;
+    if (t1 > t2) {
+      std::swap(t1, t2);
+      sign = 1.0f;
+    }
+    if (t1 > tmin) {
+      tmin = t1;
+      enterAxis = i;
+      enterSign = sign;
+    }
+    tmax = std::min(tmax, t2);
+    if (tmin > tmax) {
+      return false;
+    }
+  }
+  if (enterAxis < 0 || tmin < 0.0f || tmin > maxT) {
+    return false;
+  }
+  t = tmin;
+  normal = axes[enterAxis] * enterSign;
+  return true;
+}
+
+void StageBVH::build(std::vector<Mn::Vector3> vertices) {
+  clear();
+  const uint32_t numTriangles = vertices.size() / 3;
+  if (numTriangles == 0) {
+    return;
+  }
+  std::vector<uint32_t> order(numTriangles);
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<Mn::Vector3> centroids(numTriangles);
+  for (uint32_t i = 0; i < numTriangles; ++i) {
+    centroids[i] =
+        (vertices[3 * i] + vertices[3 * i + 1] + vertices[3 * i + 2]) / 3.0f;
+  }
+
+  // depth first, so the left child of a node is created right after it and
+  // only the right child index needs patching into its parent
+  struct Task {
+    uint32_t begin, end, parent;
+  };
+  constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+  std::vector<Task> tasks{{0, numTriangles, NoParent}};
+  nodes_.reserve(2 * (numTriangles / LeafSize + 1));
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    const uint32_t nodeIndex = nodes_.size();
+    if (task.parent != NoParent) {
+      nodes_[task.parent].index = nodeIndex;
+    }
+
+    Mn::Range3D bounds{vertices[3 * order[task.begin]],
+                       vertices[3 * order[task.begin]]};
+    Mn::Range3D centroidBounds{centroids[order[task.begin]],
+                               centroids[order[task.begin]]};
+    for (uint32_t i = task.begin; i < task.end; ++i) {
+      for (int corner = 0; corner < 3; ++corner) {
+        const Mn::Vector3& v = vertices[3 * order[i] + corner];
+        bounds = Mn::Math::join(bounds, Mn::Range3D{v, v});
+      }
+      const Mn::Vector3& centroid = centroids[order[i]];
+      centroidBounds =
+          Mn::Math::join(centroidBounds, Mn::Range3D{centroid, centroid});
+    }
+
+    const uint32_t count = task.end - task.begin;
+    if (count <= LeafSize) {
+      nodes_.push_back(Node{bounds, task.begin, count});
+      continue;
+    }
+    nodes_.push_back(Node{bounds, 0, 0});
+
+    const Mn::Vector3 extent = centroidBounds.size();
+    const int axis = extent.x() >= extent.y() && extent.x() >= extent.z()
+                         ? 0
+                         : (extent.y() >= extent.z() ? 1 : 2);
+    const uint32_t mid = task.begin + count / 2;
+    std::nth_element(order.begin() + task.begin, order.begin() + mid,
+                     order.begin() + task.end,
+                     [&centroids, axis](uint32_t lhs, uint32_t rhs) {
+                       return centroids[lhs][axis] < centroids[rhs][axis];
+                     });
+    tasks.push_back(Task{mid, task.end, nodeIndex});
+    tasks.push_back(Task{task.begin, mid, NoParent});
+  }
+
+  vertices_.reserve(vertices.size());
+  for (uint32_t triangle : order) {
+    vertices_.push_back(vertices[3 * triangle]);
+    vertices_.push_back(vertices[3 * triangle + 1]);
+    vertices_.push_back(vertices[3 * triangle + 2]);
+  }
+}
+
+void StageBVH::clear() {
+  nodes_.clear();
+  vertices_.clear();
+}
+
+void StageBVH::castRay(const Mn::Vector3& origin,
+                       const Mn::Vector3& direction,
+                       float maxT,
+                       std::vector<Hit>& hits,
+                       bool firstOnly) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  Hit first{maxT, {}};
+  bool hasFirst = false;
+  std::vector<uint32_t> stack{0};
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    const uint32_t nodeIndex = stack.back();
+    stack.pop_back();
+    // the first hit so far bounds the search
+    const float searchT = firstOnly ? first.t : maxT;
+    if (!rayHitsBounds(origin, direction, searchT, node.bounds)) {
+      continue;
+    }
+    if (node.count == 0) {
+      stack.push_back(node.index);
+      stack.push_back(nodeIndex + 1);
+      continue;
+    }
+    for (uint32_t i = node.index; i < node.index + node.count; ++i) {
+      Hit hit;
+      if (!rayHitsTriangle(origin, direction, searchT, vertices_[3 * i],
+                           vertices_[3 * i + 1], vertices_[3 * i + 2], hit)) {
+        continue;
+      }
+      if (!firstOnly) {
+        hits.push_back(hit);
+      } else if (!hasFirst || hit.t < first.t) {
+        first = hit;
+        hasFirst = true;
+      }
+    }
+  }
+  if (hasFirst) {
+    hits.push_back(first);
+  }
+}
+
+bool StageBVH::overlaps(const CollisionBox& box) const {
+  if (nodes_.empty()) {
+    return false;
+  }
+  const Mn::Range3D boxBounds = box.aabb();
+  std::vector<uint32_t> stack{0};
+  while (!stack.empty()) {
+    const uint32_t nodeIndex = stack.back();
+    const Node& node = nodes_[nodeIndex];
+    stack.pop_back();
+    if (!Mn::Math::intersects(node.bounds, boxBounds)) {
+      continue;
+    }
+    if (node.count == 0) {
+      stack.push_back(node.index);
+      stack.push_back(nodeIndex + 1);
+      continue;
+    }
+    for (uint32_t i = node.index; i < node.index + node.count; ++i) {
+      if (box.overlapsTriangle(vertices_[3 * i], vertices_[3 * i + 1],
+                               vertices_[3 * i + 2])) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+ObjectSpatialHash::ObjectSpatialHash(float cellSize) : cellSize_(cellSize) {}
+
+ObjectSpatialHash::CellRange ObjectSpatialHash::cellRange(
+    const Mn::Range3D& aabb) const {
+  CellRange range;
+  range.min = Mn::Vector3i{Mn::Math::floor(aabb.min() / cellSize_)};
+  range.max = Mn::Vector3i{Mn::Math::floor(aabb.max() / cellSize_)};
+  const Mn::Vector3i cells = range.max - range.min + Mn::Vector3i{1};
+  range.oversized = int64_t(cells.x()) * cells.y() * cells.z() > MaxObjectCells;
+  return range;
+}
+
+uint64_t ObjectSpatialHash::cellKey(const Mn::Vector3i& cell) {
+  // 21 bits per coordinate, far apart cells sharing a key only widen queries
+  constexpr uint64_t Mask = (uint64_t(1) << 21) - 1;
+  return ((uint64_t(cell.x()) & Mask) << 42) |
+         ((uint64_t(cell.y()) & Mask) << 21) | (uint64_t(cell.z()) & Mask);
+}
+
+void ObjectSpatialHash::insertCells(int id, const CellRange& range) {
+  if (range.oversized) {
+    oversized_.push_back(id);
+    return;
+  }
+  const Mn::Range3Di cellBounds{range.min, range.max};
+  occupied_ =
+      cells_.empty() ? cellBounds : Mn::Math::join(occupied_, cellBounds);
+  for (int x = range.min.x(); x <= range.max.x(); ++x) {
+    for (int y = range.min.y(); y <= range.max.y(); ++y) {
+      for (int z = range.min.z(); z <= range.max.z(); ++z) {
+        cells_[cellKey({x, y, z})].push_back(id);
+      }
+    }
+  }
+}
+
+void ObjectSpatialHash::removeCells(int id, const CellRange& range) {
+  auto eraseId = [id](std::vector<int>& ids) {
+    auto found = std::find(ids.begin(), ids.end(), id);
+    if (found != ids.end()) {
+      *found = ids.back();
+      ids.pop_back();
+    }
+  };
+  if (range.oversized) {
+    eraseId(oversized_);
+    return;
+  }
+  for (int x = range.min.x(); x <= range.max.x(); ++x) {
+    for (int y = range.min.y(); y <= range.max.y(); ++y) {
+      for (int z = range.min.z(); z <= range.max.z(); ++z) {
+        auto cell = cells_.find(cellKey({x, y, z}));
+        if (cell == cells_.end()) {
+          continue;
+        }
+        eraseId(cell->second);
+        if (cell->second.empty()) {
+          cells_.erase(cell);
+        }
+      }
+    }
+  }
+}
+
+void ObjectSpatialHash::update(int id, const Mn::Range3D& aabb) {
+  const CellRange range = cellRange(aabb);
+  auto existing = objects_.find(id);
+  if (existing != objects_.end()) {
+    const CellRange& old = existing->second;
+    if (old.min == range.min && old.max == range.max &&
+        old.oversized == range.oversized) {
+      return;
+    }
+    removeCells(id, old);
+    existing->second = range;
+  } else {
+    objects_.emplace(id, range);
+  }
+  insertCells(id, range);
+}
+
+void ObjectSpatialHash::remove(int id) {
+  auto existing = objects_.find(id);
+  if (existing == objects_.end()) {
+    return;
+  }
+  removeCells(id, existing->second);
+  objects_.erase(existing);
+}
+
+void ObjectSpatialHash::clear() {
+  cells_.clear();
+  objects_.clear();
+  oversized_.clear();
+}
+
+void ObjectSpatialHash::query(const Mn::Range3D& aabb,
+                              std::vector<int>& ids) const {
+  ids = oversized_;
+  CellRange range = cellRange(aabb);
+  if (range.oversized) {
+    // walking the cells would take longer than taking all objects
+    ids.clear();
+    for (const auto& object : objects_) {
+      ids.push_back(object.first);
+    }
+  } else if (!cells_.empty()) {
+    range.min = Mn::Math::max(range.min, occupied_.min());
+    range.max = Mn::Math::min(range.max, occupied_.max());
+    for (int x = range.min.x(); x <= range.max.x(); ++x) {
+      for (int y = range.min.y(); y <= range.max.y(); ++y) {
+        for (int z = range.min.z(); z <= range.max.z(); ++z) {
+          auto cell = cells_.find(cellKey({x, y, z}));
+          if (cell != cells_.end()) {
+            ids.insert(ids.end(), cell->second.begin(), cell->second.end());
+          }
+        }
+      }
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+void ObjectSpatialHash::queryRay(const Mn::Vector3& origin,
+                                 const Mn::Vector3& direction,
+                                 float maxT,
+                                 std::vector<int>& ids) const {
+  ids = oversized_;
+  auto finish = [&ids]() {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  };
+  if (cells_.empty()) {
+    finish();
+    return;
+  }
+
+  // clip the ray to the occupied cells
+  const Mn::Vector3 worldMin = Mn::Vector3{occupied_.min()} * cellSize_;
+  const Mn::Vector3 worldMax =
+      Mn::Vector3{occupied_.max() + Mn::Vector3i{1}} * cellSize_;
+  float t0 = 0.0f, t1 = maxT;
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(direction[i]) < AxisEpsilon) {
+      if (origin[i] < worldMin[i] || origin[i] > worldMax[i]) {
+        finish();
+        return;
+      }
+      continue;
+    }
+    float enter = (worldMin[i] - origin[i]) / direction[i];
+    float exit = (worldMax[i] - origin[i]) / direction[i];
+    if (enter > exit) {
+      std::swap(enter, exit);
+    }
+    t0 = std::max(t0, enter);
+    t1 = std::min(t1, exit);
+  }
+  if (t0 > t1) {
+    finish();
+    return;
+  }
+
+  // walk the crossed cells in order, see Amanatides and Woo, "A Fast Voxel
+  // Traversal Algorithm for Ray Tracing"
+  const Mn::Vector3 start = origin + direction * t0;
+  Mn::Vector3i cell = Mn::Math::clamp(
+      Mn::Vector3i{Mn::Math::floor(start / cellSize_)}, occupied_.min(),
+      occupied_.max());
+  Mn::Vector3i step;
+  Mn::Vector3 tNext, tDelta;
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(direction[i]) < AxisEpsilon) {
+      step[i] = 0;
+      tNext[i] = std::numeric_limits<float>::infinity();
+      tDelta[i] = std::numeric_limits<float>::infinity();
+      continue;
+    }
+    step[i] = direction[i] > 0.0f ? 1 : -1;
+    const float boundary = (cell[i] + (step[i] > 0 ? 1 : 0)) * cellSize_;
+    tNext[i] = (boundary - origin[i]) / direction[i];
+    tDelta[i] = cellSize_ / std::abs(direction[i]);
+  }
+  const Mn::Vector3i occupiedSize = occupied_.size() + Mn::Vector3i{1};
+  int maxSteps = occupiedSize.x() + occupiedSize.y() + occupiedSize.z();
+  for (; maxSteps >= 0; --maxSteps) {
+    auto found = cells_.find(cellKey(cell));
+    if (found != cells_.end()) {
+      ids.insert(ids.end(), found->second.begin(), found->second.end());
+    }
+    const int axis = tNext.x() <= tNext.y() && tNext.x() <= tNext.z()
+                         ? 0
+                         : (tNext.y() <= tNext.z() ? 1 : 2);
+    if (tNext[axis] > t1) {
+      break;
+    }
+    cell[axis] += step[axis];
+    if (cell[axis] < occupied_.min()[axis] ||
+        cell[axis] > occupied_.max()[axis]) {
+      break;
+    }
+    tNext[axis] += tDelta[axis];
+  }
+  finish();
+}
+
+}  // namespace physics
+}  // namespace esp
@@ -0,0 +1,198 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_PHYSICS_KINEMATICCOLLISION_H_
+#define ESP_PHYSICS_KINEMATICCOLLISION_H_
+
+/** @file
+ * @brief Struct @ref esp::physics::CollisionBox, classes @ref
+ * esp::physics::StageBVH, @ref esp::physics::ObjectSpatialHash
+ */
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Math/Vector3.h>
+
+namespace esp {
+namespace physics {
+
+/**
+ * @brief An oriented box, the collision shape of the objects of @ref
+ * KinematicPhysicsManager
+ */
+struct CollisionBox {
+  /** @brief The center in world space */
+  Magnum::Vector3 center;
+
+  /** @brief The unit axes of the box frame */
+  Magnum::Vector3 axes[3]{Magnum::Vector3::xAxis(), Magnum::Vector3::yAxis(),
+                          Magnum::Vector3::zAxis()};
+
+  /** @brief The half extents along @ref axes */
+  Magnum::Vector3 halfExtents;
+
+  /**
+   * @brief The box of @p range transformed by @p transform, which may scale
+   * but not shear
+   */
+  static CollisionBox fromTransformedRange(const Magnum::Range3D& range,
+                                           const Magnum::Matrix4& transform);
+
+  /** @brief The world space axis aligned bounds */
+  Magnum::Range3D aabb() const;
+
+  /** @brief Whether the box overlaps @p other */
+  bool overlaps(const CollisionBox& other) const;
+
+  /** @brief Whether the box overlaps the triangle @p a, @p b, @p c */
+  bool overlapsTriangle(const Magnum::Vector3& a,
+                        const Magnum::Vector3& b,
+                        const Magnum::Vector3& c) const;
+
+  /**
+   * @brief Intersect the ray from @p origin along @p direction
+   * @param[out] t The ray parameter of the first point of the box, in units
+   * of the direction length. Only set on a hit.
+   * @param[out] normal The box normal at that point. Only set on a hit.
+   * @return Whether the ray enters the box within @p maxT. Rays starting
+   * inside the box don't hit it.
+   */
+  bool intersectRay(const Magnum::Vector3& origin,
+                    const Magnum::Vector3& direction,
+                    float maxT,
+                    float& t,
+                    Magnum::Vector3& normal) const;
+};
+
+/**
+ * @brief A bounding volume hierarchy over static triangles, for the stage of
+ * @ref KinematicPhysicsManager
+ *
+ * Built once by splitting the triangles at the median of their centroids
+ * along the longest axis of their bounds, down to a few triangles per leaf.
+ * Nodes are stored depth first, the left child of a node following it.
+ */
+class StageBVH {
+ public:
+  /** @brief A ray hit of a triangle */
+  struct Hit {
+    //! The ray parameter, in units of the direction length.
+    float t;
+    //! The triangle normal, facing the ray origin.
+    Magnum::Vector3 normal;
+  };
+
+  /**
+   * @brief Build the hierarchy
+   * @param vertices The world space triangle corners, three per triangle
+   */
+  void build(std::vector<Magnum::Vector3> vertices);
+
+  /** @brief Remove all triangles */
+  void clear();
+
+  /** @brief The number of triangles */
+  size_t numTriangles() const { return vertices_.size() / 3; }
+
+  /** @brief The bounds of all triangles, empty without triangles */
+  Magnum::Range3D bounds() const {
+    return nodes_.empty() ? Magnum::Range3D{} : nodes_[0].bounds;
+  }
+
+  /**
+   * @brief Intersect the ray from @p origin along @p direction with the
+   * triangles, appending the hits within @p maxT to @p hits, unsorted
+   * @param firstOnly Only append the first hit, if any.
+   */
+  void castRay(const Magnum::Vector3& origin,
+               const Magnum::Vector3& direction,
+               float maxT,
+               std::vector<Hit>& hits,
+               bool firstOnly = false) const;
+
+  /** @brief Whether any triangle overlaps @p box */
+  bool overlaps(const CollisionBox& box) const;
+
+ private:
+  struct Node {
+    Magnum::Range3D bounds;
+    //! the first triangle of a leaf, the right child of an inner node
+    uint32_t index;
+    //! the number of triangles of a leaf, 0 for an inner node
+    uint32_t count;
+  };
+
+  std::vector<Node> nodes_;
+  //! the triangle corners, three per triangle in leaf order
+  std::vector<Magnum::Vector3> vertices_;
+};
+
+/**
+ * @brief A uniform grid hashing the objects of @ref KinematicPhysicsManager
+ * into the cells their bounds overlap
+ *
+ * Objects spanning more than a few cells are kept out of the grid in a list
+ * tested by every query, so moving them stays cheap.
+ */
+class ObjectSpatialHash {
+ public:
+  /** @brief Constructor */
+  explicit ObjectSpatialHash(float cellSize = 1.0f);
+
+  /** @brief Insert object @p id with world bounds @p aabb, or move it */
+  void update(int id, const Magnum::Range3D& aabb);
+
+  /** @brief Remove object @p id, if it is hashed */
+  void remove(int id);
+
+  /** @brief Remove all objects */
+  void clear();
+
+  /** @brief The number of hashed objects */
+  size_t size() const { return objects_.size(); }
+
+  /**
+   * @brief Replace @p ids with the sorted objects sharing a cell with @p
+   * aabb, a superset of those overlapping it
+   */
+  void query(const Magnum::Range3D& aabb, std::vector<int>& ids) const;
+
+  /**
+   * @brief Replace @p ids with the sorted objects in the cells crossed by the
+   * ray from @p origin along @p direction up to @p maxT, a superset of those
+   * it hits
+   */
+  void queryRay(const Magnum::Vector3& origin,
+                const Magnum::Vector3& direction,
+                float maxT,
+                std::vector<int>& ids) const;
+
+ private:
+  struct CellRange {
+    Magnum::Vector3i min, max;
+    bool oversized;
+  };
+
+  CellRange cellRange(const Magnum::Range3D& aabb) const;
+  void insertCells(int id, const CellRange& range);
+  void removeCells(int id, const CellRange& range);
+  static uint64_t cellKey(const Magnum::Vector3i& cell);
+
+  float cellSize_;
+  std::unordered_map<uint64_t, std::vector<int>> cells_;
+  std::unordered_map<int, CellRange> objects_;
+  std::vector<int> oversized_;
+  //! the bounds of all hashed cells, never shrunk until cleared
+  Magnum::Range3Di occupied_;
+};
+
+}  // namespace physics
+}  // namespace esp
+
+#endif  // ESP_PHYSICS_KINEMATICCOLLISION_H_
@@ -0,0 +1,217 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "KinematicPhysicsManager.h"
+
+#include <algorithm>
+
+#include "esp/assets/ResourceManager.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace physics {
+
+bool KinematicPhysicsManager::initPhysicsFinalize() {
+  activePhysSimLib_ = KINEMATIC;
+  return PhysicsManager::initPhysicsFinalize();
+}
+
+bool KinematicPhysicsManager::addStageFinalize(const std::string& handle) {
+  if (!PhysicsManager::addStageFinalize(handle)) {
+    return false;
+  }
+  buildStageBVH();
+  return true;
+}
+
+bool KinematicPhysicsManager::addStageChunkFinalize(
+    CORRADE_UNUSED const int chunkId,
+    CORRADE_UNUSED const std::string& collisionAssetHandle) {
+  buildStageBVH();
+  return true;
+}
+
+void KinematicPhysicsManager::removeStageChunkFinalize(
+    CORRADE_UNUSED const int chunkId) {
+  buildStageBVH();
+}
+
+void KinematicPhysicsManager::buildStageBVH() {
+  const std::string collisionAssetHandle =
+      staticStageObject_->getInitializationAttributes()
+          ->getCollisionAssetHandle();
+  std::vector<Mn::Vector3> vertices;
+  if (resourceManager_.hasCollisionMesh(collisionAssetHandle)) {
+    const assets::MeshMetaData& metaData =
+        resourceManager_.getMeshMetaData(collisionAssetHandle);
+    gatherStageTriangles(
+        Mn::Matrix4{}, resourceManager_.getCollisionMesh(collisionAssetHandle),
+        metaData.root, vertices);
+  }
+  gatherStageChunkTriangles(vertices);
+  stageBVH_.build(std::move(vertices));
+  LOG(INFO) << "KinematicPhysicsManager::buildStageBVH : built the BVH of "
+            << stageBVH_.numTriangles() << " stage triangles.";
+}
+
+bool KinematicPhysicsManager::isMeshPrimitiveValid(
+    const assets::CollisionMeshData& meshData) {
+  if (meshData.primitive != Mn::MeshPrimitive::Triangles) {
+    LOG(ERROR) << "KinematicPhysicsManager::isMeshPrimitiveValid : only "
+                  "triangle meshes can collide.";
+    return false;
+  }
+  return true;
+}
+
+void KinematicPhysicsManager::updateObjectBoxes() {
+  for (auto it = objectBoxes_.begin(); it != objectBoxes_.end();) {
+    if (existingObjects_.get(it->second.handle) == nullptr) {
+      objectHash_.remove(it->first);
+      it = objectBoxes_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (const auto& object : existingObjects_) {
+    const Mn::Matrix4 transformation =
+        object.second->node().absoluteTransformationMatrix();
+    auto existing = objectBoxes_.find(object.first);
+    if (existing != objectBoxes_.end() &&
+        existing->second.transformation == transformation) {
+      continue;
+    }
+    ObjectBox& objectBox = objectBoxes_[object.first];
+    objectBox.handle = existingObjects_.handle(object.first);
+    objectBox.transformation = transformation;
+    objectBox.box = CollisionBox::fromTransformedRange(
+        object.second->node().getCumulativeBB(), transformation);
+    objectHash_.update(object.first, objectBox.box.aabb());
+  }
+}
+
+bool KinematicPhysicsManager::contactTest(const int physObjectID) {
+  assertIDValidity(physObjectID);
+  updateObjectBoxes();
+  const CollisionBox& box = objectBoxes_.at(physObjectID).box;
+  if (stageBVH_.overlaps(box)) {
+    return true;
+  }
+  std::vector<int> candidates;
+  objectHash_.query(box.aabb(), candidates);
+  for (int candidate : candidates) {
+    if (candidate != physObjectID &&
+        box.overlaps(objectBoxes_.at(candidate).box)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<int> KinematicPhysicsManager::boxOverlapTest(
+    const Mn::Vector3& center,
+    const Mn::Vector3& halfExtents) {
+  updateObjectBoxes();
+  CollisionBox box;
+  box.center = center;
+  box.halfExtents = halfExtents;
+  std::vector<int> overlapping;
+  if (stageBVH_.overlaps(box)) {
+    overlapping.push_back(-1);
+  }
+  std::vector<int> candidates;
+  objectHash_.query(box.aabb(), candidates);
+  for (int candidate : candidates) {
+    if (box.overlaps(objectBoxes_.at(candidate).box)) {
+      overlapping.push_back(candidate);
+    }
+  }
+  return overlapping;
+}
+
+RaycastResults KinematicPhysicsManager::castRay(const esp::geo::Ray& ray,
+                                                double maxDistance) {
+  RaycastResults results;
+  results.ray = ray;
+  if (ray.direction.length() == 0) {
+    LOG(ERROR) << "KinematicPhysicsManager::castRay : Cannot cast ray with "
+                  "zero length, aborting. ";
+    return results;
+  }
+  updateObjectBoxes();
+
+  std::vector<StageBVH::Hit> stageHits;
+  stageBVH_.castRay(ray.origin, ray.direction, maxDistance, stageHits);
+  for (const StageBVH::Hit& stageHit : stageHits) {
+    RayHitInfo hit;
+    hit.objectId = -1;
+    hit.point = ray.origin + ray.direction * stageHit.t;
+    hit.normal = stageHit.normal;
+    hit.rayDistance = stageHit.t;
+    results.hits.push_back(hit);
+  }
+
+  std::vector<int> candidates;
+  objectHash_.queryRay(ray.origin, ray.direction, maxDistance, candidates);
+  for (int candidate : candidates) {
+    float t = 0;
+    Mn::Vector3 normal;
+    if (objectBoxes_.at(candidate).box.intersectRay(
+            ray.origin, ray.direction, maxDistance, t, normal)) {
+      RayHitInfo hit;
+      hit.objectId = candidate;
+      hit.point = ray.origin + ray.direction * t;
+      hit.normal = normal;
+      hit.rayDistance = t;
+      results.hits.push_back(hit);
+    }
+  }
+  results.sortByDistance();
+  return results;
+}
+
+void KinematicPhysicsManager::prepareFirstHits() {
+  updateObjectBoxes();
+}
+
+bool KinematicPhysicsManager::castFirstHit(const esp::geo::Ray& ray,
+                                           float maxDistance,
+                                           RayHitInfo& hit) const {
+  // reused by the rays cast on the same thread
+  thread_local std::vector<StageBVH::Hit> stageHits;
+  thread_local std::vector<int> candidates;
+  float firstT = maxDistance;
+  bool hasHit = false;
+  stageHits.clear();
+  stageBVH_.castRay(ray.origin, ray.direction, maxDistance, stageHits, true);
+  if (!stageHits.empty()) {
+    hasHit = true;
+    firstT = stageHits[0].t;
+    hit.objectId = -1;
+    hit.normal = stageHits[0].normal;
+  }
+  // objects beyond the stage hit can't be first
+  objectHash_.queryRay(ray.origin, ray.direction, firstT, candidates);
+  for (int candidate : candidates) {
+    float t = 0;
+    Mn::Vector3 normal;
+    if (objectBoxes_.at(candidate).box.intersectRay(
+            ray.origin, ray.direction, firstT, t, normal) &&
+        (!hasHit || t < firstT)) {
+      hasHit = true;
+      firstT = t;
+      hit.objectId = candidate;
+      hit.normal = normal;
+    }
+  }
+  if (hasHit) {
+    hit.point = ray.origin + ray.direction * firstT;
+    hit.rayDistance = firstT;
+  }
+  return hasHit;
+}
+
+}  // namespace physics
+}  // namespace esp
@@ -0,0 +1,160 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_PHYSICS_KINEMATICPHYSICSMANAGER_H_
+#define ESP_PHYSICS_KINEMATICPHYSICSMANAGER_H_
+
+/** @file
+ * @brief Class @ref esp::physics::KinematicPhysicsManager
+ */
+
+#include <unordered_map>
+
+#include "KinematicCollision.h"
+#include "PhysicsManager.h"
+
+namespace esp {
+namespace physics {
+
+/**
+@brief Kinematic stage and object manager with collision queries, but without
+a physics library.
+
+Selected by the "kinematic" simulator of the @ref
+metadata::attributes::PhysicsManagerAttributes. Supports the @ref
+MotionType::STATIC and @ref MotionType::KINEMATIC objects of @ref
+PhysicsManager, and answers @ref castRay(), @ref castRays(), @ref contactTest()
+and @ref boxOverlapTest() for kinematic navigation tasks at a fraction of the
+memory and step cost of a dynamics world.
+
+The stage collides as its triangles, kept in a @ref StageBVH. Objects collide
+as the oriented cumulative bounding box of their node, like Bullet objects
+with bounding box collisions, hashed into an @ref ObjectSpatialHash. Objects
+added without drawables have an empty box. Moved objects are rehashed by the
+next query.
+*/
+class KinematicPhysicsManager : public PhysicsManager {
+ public:
+  /**
+   * @brief Construct a @ref KinematicPhysicsManager with access to specific
+   * resource assets.
+   *
+   * @param _resourceManager The @ref esp::assets::ResourceManager which
+   * tracks the assets this @ref KinematicPhysicsManager will have access to.
+   */
+  explicit KinematicPhysicsManager(
+      assets::ResourceManager& _resourceManager,
+      const Attrs::PhysicsManagerAttributes::cptr _physicsManagerAttributes)
+      : PhysicsManager(_resourceManager, _physicsManagerAttributes){};
+
+  /**
+   * @brief Whether the box of an object overlaps the stage or the box of
+   * another object.
+   * @param physObjectID The object ID and key identifying the object in @ref
+   * PhysicsManager::existingObjects_.
+   */
+  bool contactTest(const int physObjectID) override;
+
+  /**
+   * @brief Cast a ray against the stage triangles and the object boxes and
+   * return all hits, sorted by distance. Rays starting inside an object box
+   * don't hit it.
+   *
+   * @param ray The ray to cast. Need not be unit length, but returned hit
+   * distances will be in units of ray length.
+   * @param maxDistance The maximum distance along the ray direction to search.
+   * In units of ray length.
+   */
+  RaycastResults castRay(const esp::geo::Ray& ray,
+                         double maxDistance = 100.0) override;
+
+  /**
+   * @brief Find the stage and the objects whose boxes overlap an axis aligned
+   * box, e.g. the bounds of an agent.
+   *
+   * @param center The world space center of the box.
+   * @param halfExtents The half extents of the box.
+   * @return The sorted IDs of the overlapping objects, -1 for the stage.
+   */
+  std::vector<int> boxOverlapTest(const Magnum::Vector3& center,
+                                  const Magnum::Vector3& halfExtents) override;
+
+ protected:
+  /**
+   * @brief Finalize physics initialization: Setup staticStageObject_ and
+   * mark the library in use.
+   */
+  bool initPhysicsFinalize() override;
+
+  /**
+   * @brief Finalize stage initialization and build the @ref StageBVH over
+   * the triangles of its collision mesh.
+   * @param handle The handle of the attributes structure defining physical
+   * properties of the stage.
+   * @return true if successful and false otherwise
+   */
+  bool addStageFinalize(const std::string& handle) override;
+
+  /**
+   * @brief Rebuild the @ref StageBVH with the triangles of the new chunk.
+   */
+  bool addStageChunkFinalize(int chunkId,
+                             const std::string& collisionAssetHandle) override;
+
+  /**
+   * @brief Rebuild the @ref StageBVH without the triangles of the chunk.
+   */
+  void removeStageChunkFinalize(int chunkId) override;
+
+  /** @brief Check that the collision mesh is made of triangles.
+   * @param meshData The mesh to validate.
+   * @return true if valid, false otherwise.
+   */
+  bool isMeshPrimitiveValid(const assets::CollisionMeshData& meshData) override;
+
+  /** @brief Update the object boxes before the rays of @ref castRays(). */
+  void prepareFirstHits() override;
+
+  /** @brief The first hit of @p ray among the stage triangles and the
+   * object boxes, see @ref castRays().
+   * @return false if it misses within @p maxDistance.
+   */
+  bool castFirstHit(const esp::geo::Ray& ray,
+                    float maxDistance,
+                    RayHitInfo& hit) const override;
+
+ private:
+  //! the collision box of an object, computed at its last transformation
+  struct ObjectBox {
+    ObjectSlotMap<physics::RigidObject>::Handle handle;
+    Magnum::Matrix4 transformation;
+    CollisionBox box;
+  };
+
+  /** @brief Drop the boxes of the removed objects and rehash the moved or
+   * added ones, once before each query.
+   */
+  void updateObjectBoxes();
+
+  /** @brief Build @ref stageBVH_ over the triangles of the collision meshes
+   * of the stage and its chunks.
+   */
+  void buildStageBVH();
+
+  //! the triangles of the stage
+  StageBVH stageBVH_;
+
+  //! the object boxes, keyed by object ID
+  std::unordered_map<int, ObjectBox> objectBoxes_;
+
+  //! the objects in the cells of their boxes
+  ObjectSpatialHash objectHash_;
+
+  ESP_SMART_POINTERS(KinematicPhysicsManager)
+};  // end class KinematicPhysicsManager
+
+}  // namespace physics
+}  // namespace esp
+
+#endif  // ESP_PHYSICS_KINEMATICPHYSICSMANAGER_H_
@@ -0,0 +1,167 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_PHYSICS_OBJECTSLOTMAP_H_
+#define ESP_PHYSICS_OBJECTSLOTMAP_H_
+
+/** @file
+ * @brief Class @ref esp::physics::ObjectSlotMap
+ */
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "esp/core/logging.h"
+
+namespace esp {
+namespace physics {
+
+/**
+ * @brief Owning storage of objects keyed by small non-negative integer ids,
+ * such as the recycled object ids of @ref PhysicsManager.
+ *
+ * An id indexes a slot directly, so lookups do not walk a tree. The existing
+ * objects are also kept in a contiguous list, which is what iteration visits,
+ * in no particular order. Every slot counts the objects it held, so a @ref
+ * Handle taken before an id was recycled no longer resolves to the new object.
+ *
+ * The subset of the std::map interface used for object storage is provided,
+ * with @ref at() returning the owning pointer.
+ */
+template <typename T>
+class ObjectSlotMap {
+ public:
+  //! An existing object, as visited by iteration
+  using value_type = std::pair<int, T*>;
+  using iterator = typename std::vector<value_type>::const_iterator;
+  using const_iterator = iterator;
+
+  /** @brief An id, tagged with the generation of the object in its slot */
+  struct Handle {
+    int id = -1;
+    uint32_t generation = 0;
+  };
+
+  /** @brief The number of existing objects */
+  size_t size() const { return existing_.size(); }
+
+  /** @brief Whether there are no existing objects */
+  bool empty() const { return existing_.empty(); }
+
+  /** @brief 1 if an object with @p id exists, 0 otherwise */
+  size_t count(int id) const {
+    return id >= 0 && size_t(id) < slots_.size() && slots_[id].object ? 1 : 0;
+  }
+
+  /** @brief The object with @p id, which must exist */
+  const std::unique_ptr<T>& at(int id) const {
+    CHECK(count(id) > 0);
+    return slots_[id].object;
+  }
+
+  /** @brief The object with @p id, nullptr if it does not exist */
+  T* get(int id) const { return count(id) ? slots_[id].object.get() : nullptr; }
+
+  /** @brief A handle to the object with @p id, which must exist */
+  Handle handle(int id) const {
+    CHECK(count(id) > 0);
+    return Handle{id, slots_[id].generation};
+  }
+
+  /**
+   * @brief The object of @p handle, nullptr if it was removed since, even if
+   * its id was reused
+   */
+  T* get(const Handle& handle) const {
+    T* object = get(handle.id);
+    return object && slots_[handle.id].generation == handle.generation
+               ? object
+               : nullptr;
+  }
+
+  /**
+   * @brief Add @p object with @p id
+   * @return false, leaving the storage unchanged, if @p id already exists
+   */
+  bool emplace(int id, std::unique_ptr<T> object) {
+    CHECK(id >= 0);
+    if (count(id)) {
+      return false;
+    }
+    if (size_t(id) >= slots_.size()) {
+      slots_.resize(id + 1);
+    }
+    Slot& slot = slots_[id];
+    slot.object = std::move(object);
+    slot.existingIndex = existing_.size();
+    existing_.emplace_back(id, slot.object.get());
+    return true;
+  }
+
+  /**
+   * @brief Remove the object with @p id without destroying it
+   * @return The object, nullptr if @p id does not exist
+   */
+  std::unique_ptr<T> release(int id) {
+    if (!count(id)) {
+      return nullptr;
+    }
+    // swap with the last existing object to keep the list contiguous
+    Slot& slot = slots_[id];
+    const value_type& last = existing_.back();
+    slots_[last.first].existingIndex = slot.existingIndex;
+    existing_[slot.existingIndex] = last;
+    existing_.pop_back();
+
+    ++slot.generation;
+    return std::move(slot.object);
+  }
+
+  /**
+   * @brief Remove and destroy the object with @p id
+   * @return The number of removed objects, 0 or 1
+   */
+  size_t erase(int id) {
+    // the destructor may query the storage, so reset the slot first
+    return release(id) ? 1 : 0;
+  }
+
+  /** @brief Remove and destroy all objects */
+  void clear() {
+    for (Slot& slot : slots_) {
+      if (slot.object) {
+        ++slot.generation;
+      }
+    }
+    existing_.clear();
+    // the destructors may query the storage, so empty the slots first
+    std::vector<std::unique_ptr<T>> objects;
+    objects.reserve(slots_.size());
+    for (Slot& slot : slots_) {
+      objects.push_back(std::move(slot.object));
+    }
+  }
+
+  iterator begin() const { return existing_.begin(); }
+  iterator end() const { return existing_.end(); }
+
+ private:
+  struct Slot {
+    std::unique_ptr<T> object;
+    //! the number of objects removed from this slot
+    uint32_t generation = 0;
+    //! index of the object in existing_, if there is one
+    size_t existingIndex = 0;
+  };
+
+  std::vector<Slot> slots_;
+  std::vector<value_type> existing_;
+};
+
+}  // namespace physics
+}  // namespace esp
+
+#endif  // ESP_PHYSICS_OBJECTSLOTMAP_H_
@@ -3,13 +3,130 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "PhysicsManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
 #include "esp/assets/CollisionMeshData.h"
+#include "esp/core/TaskScheduler.h"
+#include "esp/gfx/Drawable.h"
+#include "esp/gfx/ShaderManager.h"
 
 #include <Magnum/Math/Range.h>
 
 namespace esp {
 namespace physics {
 
+namespace {
+
+//! "PSNP", identifying serialized snapshots
+constexpr uint32_t SnapshotMagic = 0x504e5350;
+constexpr uint32_t SnapshotVersion = 2;
+
+enum SnapshotControlFlag : uint8_t {
+  ControllingLinVel = 1 << 0,
+  LinVelIsLocal = 1 << 1,
+  ControllingAngVel = 1 << 2,
+  AngVelIsLocal = 1 << 3,
+};
+
+template <typename T>
+void writeValue(std::string& data, const T& value) {
+  data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(const std::string& data, size_t& offset, T& value) {
+  if (offset + sizeof(T) > data.size()) {
+    return false;
+  }
+  std::memcpy(&value, data.data() + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+}  // namespace
+
+std::string PhysicsSnapshot::serialize() const {
+  std::string data;
+  data.reserve(3 * sizeof(uint32_t) + sizeof(double) +
+               objects.size() * (sizeof(ObjectState) + 2));
+  writeValue(data, SnapshotMagic);
+  writeValue(data, SnapshotVersion);
+  writeValue(data, worldTime);
+  writeValue(data, uint32_t(objects.size()));
+  for (const ObjectState& object : objects) {
+    const VelocityControl& control = object.velocityControl;
+    writeValue(data, int32_t(object.objectId));
+    writeValue(data, object.generation);
+    writeValue(data, uint8_t(object.motionType));
+    writeValue(data, object.translation);
+    writeValue(data, object.rotation);
+    writeValue(data, object.linearVelocity);
+    writeValue(data, object.angularVelocity);
+    writeValue(data, control.linVel);
+    writeValue(data, control.angVel);
+    writeValue(data,
+               uint8_t((control.controllingLinVel ? ControllingLinVel : 0) |
+                       (control.linVelIsLocal ? LinVelIsLocal : 0) |
+                       (control.controllingAngVel ? ControllingAngVel : 0) |
+                       (control.angVelIsLocal ? AngVelIsLocal : 0)));
+  }
+  return data;
+}
+
+bool PhysicsSnapshot::deserialize(const std::string& data) {
+  size_t offset = 0;
+  uint32_t magic = 0, version = 0, numObjects = 0;
+  if (!readValue(data, offset, magic) || magic != SnapshotMagic ||
+      !readValue(data, offset, version) || version != SnapshotVersion) {
+    LOG(ERROR) << "PhysicsSnapshot::deserialize : not a version "
+               << SnapshotVersion << " physics snapshot.";
+    return false;
+  }
+  if (!readValue(data, offset, worldTime) ||
+      !readValue(data, offset, numObjects)) {
+    LOG(ERROR) << "PhysicsSnapshot::deserialize : truncated snapshot.";
+    return false;
+  }
+
+  objects.clear();
+  objects.reserve(numObjects);
+  for (uint32_t i = 0; i < numObjects; ++i) {
+    ObjectState object;
+    VelocityControl& control = object.velocityControl;
+    int32_t objectId = 0;
+    uint8_t motionType = 0, flags = 0;
+    if (!readValue(data, offset, objectId) ||
+        !readValue(data, offset, object.generation) ||
+        !readValue(data, offset, motionType) ||
+        !readValue(data, offset, object.translation) ||
+        !readValue(data, offset, object.rotation) ||
+        !readValue(data, offset, object.linearVelocity) ||
+        !readValue(data, offset, object.angularVelocity) ||
+        !readValue(data, offset, control.linVel) ||
+        !readValue(data, offset, control.angVel) ||
+        !readValue(data, offset, flags)) {
+      LOG(ERROR) << "PhysicsSnapshot::deserialize : truncated snapshot.";
+      return false;
+    }
+    if (motionType > uint8_t(MotionType::DYNAMIC)) {
+      LOG(ERROR) << "PhysicsSnapshot::deserialize : invalid motion type "
+                 << int(motionType) << ".";
+      return false;
+    }
+    object.objectId = objectId;
+    object.motionType = MotionType(motionType);
+    control.controllingLinVel = flags & ControllingLinVel;
+    control.linVelIsLocal = flags & LinVelIsLocal;
+    control.controllingAngVel = flags & ControllingAngVel;
+    control.angVelIsLocal = flags & AngVelIsLocal;
+    objects.push_back(object);
+  }
+  return true;
+}
+
 bool PhysicsManager::initPhysics(scene::SceneNode* node) {
   physicsNode_ = node;
 
@@ -51,9 +168,250 @@ bool PhysicsManager::addStage(
 bool PhysicsManager::addStageFinalize(const std::string& handle) {
   //! Initialize scene
   bool sceneSuccess = staticStageObject_->initialize(resourceManager_, handle);
+  stageMeshBVHBuilt_ = false;
+  stageMeshBVH_.clear();
   return sceneSuccess;
 }
 
+int PhysicsManager::addStageChunk(const std::string& collisionAssetHandle) {
+  if (staticStageObject_ == nullptr ||
+      !resourceManager_.hasCollisionMesh(collisionAssetHandle)) {
+    LOG(ERROR) << "PhysicsManager::addStageChunk : no stage or no collision "
+                  "mesh of "
+               << collisionAssetHandle << ", not adding it.";
+    return ID_UNDEFINED;
+  }
+  for (const assets::CollisionMeshData& meshData :
+       resourceManager_.getCollisionMesh(collisionAssetHandle)) {
+    if (!isMeshPrimitiveValid(meshData)) {
+      return ID_UNDEFINED;
+    }
+  }
+  const int chunkId = nextStageChunkId_++;
+  stageChunks_.emplace(chunkId, collisionAssetHandle);
+  if (!addStageChunkFinalize(chunkId, collisionAssetHandle)) {
+    stageChunks_.erase(chunkId);
+    return ID_UNDEFINED;
+  }
+  stageMeshBVHBuilt_ = false;
+  return chunkId;
+}
+
+bool PhysicsManager::removeStageChunk(const int chunkId) {
+  auto chunk = stageChunks_.find(chunkId);
+  if (chunk == stageChunks_.end()) {
+    return false;
+  }
+  stageChunks_.erase(chunk);
+  removeStageChunkFinalize(chunkId);
+  stageMeshBVHBuilt_ = false;
+  return true;
+}
+
+void PhysicsManager::gatherStageChunkTriangles(
+    std::vector<Magnum::Vector3>& vertices) {
+  for (const auto& chunk : stageChunks_) {
+    gatherStageTriangles(Magnum::Matrix4{},
+                         resourceManager_.getCollisionMesh(chunk.second),
+                         resourceManager_.getMeshMetaData(chunk.second).root,
+                         vertices);
+  }
+}
+
+void PhysicsManager::gatherStageTriangles(
+    const Magnum::Matrix4& transformFromParentToWorld,
+    const std::vector<assets::CollisionMeshData>& meshGroup,
+    const assets::MeshTransformNode& node,
+    std::vector<Magnum::Vector3>& vertices) {
+  const Magnum::Matrix4 transformFromLocalToWorld =
+      transformFromParentToWorld * node.transformFromLocalToParent;
+  if (node.meshIDLocal != ID_UNDEFINED) {
+    const assets::CollisionMeshData& mesh = meshGroup[node.meshIDLocal];
+    const size_t numIndices = mesh.indices.size() / 3 * 3;
+    vertices.reserve(vertices.size() + numIndices);
+    for (size_t i = 0; i < numIndices; ++i) {
+      vertices.push_back(transformFromLocalToWorld.transformPoint(
+          mesh.positions[mesh.indices[i]]));
+    }
+  }
+  for (const auto& child : node.children) {
+    gatherStageTriangles(transformFromLocalToWorld, meshGroup, child,
+                         vertices);
+  }
+}
+
+RaycastResults PhysicsManager::castRay(const esp::geo::Ray& ray,
+                                       double maxDistance) {
+  RaycastResults results;
+  results.ray = ray;
+  if (ray.direction.length() == 0) {
+    LOG(ERROR) << "PhysicsManager::castRay : Cannot cast ray with zero "
+                  "length, aborting. ";
+    return results;
+  }
+  updateMeshRayCaster();
+
+  std::vector<geo::MeshBVH::Hit> meshHits;
+  stageMeshBVH_.castRayAll(ray.origin, ray.direction, maxDistance, meshHits);
+  for (const geo::MeshBVH::Hit& meshHit : meshHits) {
+    RayHitInfo hit;
+    hit.objectId = -1;
+    hit.point = ray.origin + ray.direction * meshHit.t;
+    hit.normal = meshHit.normal;
+    hit.rayDistance = meshHit.t;
+    results.hits.push_back(hit);
+  }
+  for (const MeshRayCasterObject& object : meshRayCasterObjects_) {
+    // an affine transformation keeps the ray parameters
+    meshHits.clear();
+    object.bvh->castRayAll(
+        object.transformFromWorldToLocal.transformPoint(ray.origin),
+        object.transformFromWorldToLocal.transformVector(ray.direction),
+        maxDistance, meshHits);
+    for (const geo::MeshBVH::Hit& meshHit : meshHits) {
+      RayHitInfo hit;
+      hit.objectId = object.objectId;
+      hit.point = ray.origin + ray.direction * meshHit.t;
+      hit.normal = (object.normalMatrix * meshHit.normal).normalized();
+      hit.rayDistance = meshHit.t;
+      results.hits.push_back(hit);
+    }
+  }
+  results.sortByDistance();
+  return results;
+}
+
+void PhysicsManager::castRays(const std::vector<esp::geo::Ray>& rays,
+                              BatchRaycastResults& results,
+                              double maxDistance,
+                              int numThreads) {
+  results.reset(rays.size());
+  // the casters are only read while casting
+  prepareFirstHits();
+  auto castRange = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const esp::geo::Ray& ray = rays[i];
+      RayHitInfo hit;
+      if (ray.direction.length() == 0 ||
+          !castFirstHit(ray, maxDistance, hit)) {
+        continue;
+      }
+      results.hasHit[i] = 1;
+      results.objectIds[i] = hit.objectId;
+      results.points[i] = hit.point;
+      results.normals[i] = hit.normal;
+      results.rayDistances[i] = hit.rayDistance;
+    }
+  };
+  core::TaskScheduler::global().parallelForRanges(rays.size(), numThreads,
+                                                  castRange);
+}
+
+void PhysicsManager::prepareFirstHits() {
+  updateMeshRayCaster();
+}
+
+bool PhysicsManager::castFirstHit(const esp::geo::Ray& ray,
+                                  float maxDistance,
+                                  RayHitInfo& hit) const {
+  float firstT = maxDistance;
+  bool hasHit = false;
+  geo::MeshBVH::Hit meshHit;
+  if (stageMeshBVH_.castRay(ray.origin, ray.direction, firstT, meshHit)) {
+    hasHit = true;
+    firstT = meshHit.t;
+    hit.objectId = -1;
+    hit.normal = meshHit.normal;
+  }
+  // the search distance shrinks with each hit, culling the farther meshes
+  for (const MeshRayCasterObject& object : meshRayCasterObjects_) {
+    if (object.bvh->castRay(
+            object.transformFromWorldToLocal.transformPoint(ray.origin),
+            object.transformFromWorldToLocal.transformVector(ray.direction),
+            firstT, meshHit)) {
+      hasHit = true;
+      firstT = meshHit.t;
+      hit.objectId = object.objectId;
+      hit.normal = (object.normalMatrix * meshHit.normal).normalized();
+    }
+  }
+  if (hasHit) {
+    hit.point = ray.origin + ray.direction * firstT;
+    hit.rayDistance = firstT;
+  }
+  return hasHit;
+}
+
+void PhysicsManager::updateMeshRayCaster() {
+  if (!stageMeshBVHBuilt_ && staticStageObject_ != nullptr) {
+    stageMeshBVHBuilt_ = true;
+    const auto stageAttributes =
+        staticStageObject_->getSharedInitializationAttributes();
+    if (stageAttributes != nullptr) {
+      std::string handle = stageAttributes->getCollisionAssetHandle();
+      if (!resourceManager_.hasCollisionMesh(handle)) {
+        handle = stageAttributes->getRenderAssetHandle();
+      }
+      std::vector<Magnum::Vector3> vertices;
+      if (resourceManager_.hasCollisionMesh(handle)) {
+        gatherStageTriangles(Magnum::Matrix4{},
+                             resourceManager_.getCollisionMesh(handle),
+                             resourceManager_.getMeshMetaData(handle).root,
+                             vertices);
+      }
+      gatherStageChunkTriangles(vertices);
+      if (!vertices.empty()) {
+        stageMeshBVH_.build(std::move(vertices));
+        LOG(INFO) << "PhysicsManager::updateMeshRayCaster : built the BVH of "
+                  << stageMeshBVH_.numTriangles() << " stage triangles.";
+      } else {
+        stageMeshBVH_.clear();
+      }
+    }
+  }
+
+  meshRayCasterObjects_.clear();
+  for (const auto& object : existingObjects_) {
+    const auto attributes = object.second->getSharedInitializationAttributes();
+    std::shared_ptr<const geo::MeshBVH> bvh =
+        getMeshBVH(attributes->getCollisionAssetHandle());
+    if (bvh == nullptr) {
+      bvh = getMeshBVH(attributes->getRenderAssetHandle());
+    }
+    if (bvh == nullptr || bvh->numTriangles() == 0) {
+      continue;
+    }
+    // the meshes are drawn under a node scaling the visual node
+    const Magnum::Matrix4 transformFromLocalToWorld =
+        object.second->visualNode_->absoluteTransformationMatrix() *
+        Magnum::Matrix4::scaling(attributes->getScale());
+    meshRayCasterObjects_.push_back(
+        MeshRayCasterObject{object.first, std::move(bvh),
+                            transformFromLocalToWorld.inverted(),
+                            transformFromLocalToWorld.normalMatrix()});
+  }
+}
+
+std::shared_ptr<const geo::MeshBVH> PhysicsManager::getMeshBVH(
+    const std::string& handle) {
+  auto cached = meshBVHs_.find(handle);
+  if (cached != meshBVHs_.end()) {
+    return cached->second;
+  }
+  std::shared_ptr<geo::MeshBVH> bvh;
+  if (resourceManager_.hasCollisionMesh(handle)) {
+    std::vector<Magnum::Vector3> vertices;
+    gatherStageTriangles(Magnum::Matrix4{},
+                         resourceManager_.getCollisionMesh(handle),
+                         resourceManager_.getMeshMetaData(handle).root,
+                         vertices);
+    bvh = std::make_shared<geo::MeshBVH>();
+    bvh->build(std::move(vertices));
+  }
+  meshBVHs_.emplace(handle, bvh);
+  return bvh;
+}
+
 int PhysicsManager::addObject(const int objectLibId,
                               DrawableGroup* drawables,
                               scene::SceneNode* attachmentNode,
@@ -69,24 +427,67 @@ int PhysicsManager::addObject(const std::string& configFileHandle,
                               DrawableGroup* drawables,
                               scene::SceneNode* attachmentNode,
                               const Magnum::ResourceKey& lightSetup) {
-  //! Make rigid object and add it to existingObjects
-  int nextObjectID_ = allocateObjectID();
-  scene::SceneNode* objectNode = attachmentNode;
-  if (attachmentNode == nullptr) {
-    objectNode = &staticStageObject_->node().createChild();
-  }
   // verify whether necessary assets exist, and if not, instantiate them
   // only make object if asset instantiation succeeds (short circuit)
-  bool objectSuccess =
-      resourceManager_.instantiateAssetsOnDemand(configFileHandle);
-  if (!objectSuccess) {
+  if (!resourceManager_.instantiateAssetsOnDemand(configFileHandle)) {
     LOG(ERROR) << "PhysicsManager::addObject : "
                   "ResourceManager::instantiateAssetsOnDemand unsuccessful. "
                   "Aborting.";
     return ID_UNDEFINED;
   }
+  return addObjectFinalize(configFileHandle, drawables, attachmentNode,
+                           lightSetup);
+}
+
+std::vector<int> PhysicsManager::addObjects(
+    const std::vector<std::string>& configFiles,
+    DrawableGroup* drawables,
+    const Magnum::ResourceKey& lightSetup) {
+  std::vector<int> objectIDs(configFiles.size(), ID_UNDEFINED);
+  // whether the assets of each distinct template could be instantiated
+  std::unordered_map<std::string, bool> instantiated;
+  for (size_t i = 0; i < configFiles.size(); ++i) {
+    const std::string& configFileHandle = configFiles[i];
+    auto inserted = instantiated.emplace(configFileHandle, false);
+    if (inserted.second) {
+      inserted.first->second =
+          resourceManager_.getObjectAttributesManager()->getObjectLibHasHandle(
+              configFileHandle) &&
+          resourceManager_.instantiateAssetsOnDemand(configFileHandle);
+      if (!inserted.first->second) {
+        LOG(ERROR) << "PhysicsManager::addObjects : Unable to instantiate "
+                      "the assets of template "
+                   << configFileHandle << ". Skipping its objects.";
+      }
+    }
+    if (inserted.first->second) {
+      objectIDs[i] =
+          addObjectFinalize(configFileHandle, drawables, nullptr, lightSetup);
+    }
+  }
+  return objectIDs;
+}
+
+int PhysicsManager::addObjectFinalize(const std::string& configFileHandle,
+                                      DrawableGroup* drawables,
+                                      scene::SceneNode* attachmentNode,
+                                      const Magnum::ResourceKey& lightSetup) {
+  if (objectPooling_ && attachmentNode == nullptr) {
+    const int pooledObjectID =
+        reusePooledObject(configFileHandle, drawables, lightSetup);
+    if (pooledObjectID != ID_UNDEFINED) {
+      return pooledObjectID;
+    }
+  }
 
-  objectSuccess =
+  //! Make rigid object and add it to existingObjects
+  int nextObjectID_ = allocateObjectID();
+  scene::SceneNode* objectNode = attachmentNode;
+  if (attachmentNode == nullptr) {
+    objectNode = &staticStageObject_->node().createChild();
+  }
+
+  bool objectSuccess =
       makeAndAddRigidObject(nextObjectID_, configFileHandle, objectNode);
 
   if (!objectSuccess) {
@@ -106,7 +507,7 @@ int PhysicsManager::addObject(const std::string& configFileHandle,
   //! Render node as child of physics node
   //! Verify we should make the object drawable
   if (existingObjects_.at(nextObjectID_)
-          ->getInitializationAttributes()
+          ->getSharedInitializationAttributes()
           ->getIsVisible()) {
     resourceManager_.addObjectToDrawables(
         configFileHandle, existingObjects_.at(nextObjectID_)->visualNode_,
@@ -123,13 +524,106 @@ int PhysicsManager::addObject(const std::string& configFileHandle,
     return ID_UNDEFINED;
   }
 
+  if (attachmentNode == nullptr) {
+    poolableObjectIDs_.insert(nextObjectID_);
+  }
   return nextObjectID_;
 }
 
+int PhysicsManager::reusePooledObject(const std::string& configFileHandle,
+                                      DrawableGroup* drawables,
+                                      const Magnum::ResourceKey& lightSetup) {
+  auto pooled = objectPool_.find(configFileHandle);
+  if (pooled == objectPool_.end() || pooled->second.empty()) {
+    return ID_UNDEFINED;
+  }
+  std::unique_ptr<physics::RigidObject> object =
+      std::move(pooled->second.back());
+  pooled->second.pop_back();
+
+  // a template registered again since must build a new object
+  if (object->getSharedInitializationAttributes() !=
+      resourceManager_.getObjectAttributesManager()->getObjectSharedByHandle(
+          configFileHandle)) {
+    scene::SceneNode* objectNode = &object->node();
+    object.reset();
+    delete objectNode;
+    return ID_UNDEFINED;
+  }
+
+  const int objectID = allocateObjectID();
+  object->reuse(objectID);
+  if (drawables &&
+      object->getSharedInitializationAttributes()->getIsVisible()) {
+    for (gfx::Drawable& drawable :
+         scene::preOrderFeatures<gfx::Drawable>(*object->visualNode_)) {
+      drawables->add(drawable);
+    }
+    gfx::setLightSetupForSubTree(*object->visualNode_, lightSetup);
+  }
+  existingObjects_.emplace(objectID, std::move(object));
+  poolableObjectIDs_.insert(objectID);
+  return objectID;
+}
+
+void PhysicsManager::setObjectPooling(bool enabled) {
+  objectPooling_ = enabled;
+  if (!enabled) {
+    clearObjectPool();
+  }
+}
+
+int PhysicsManager::getNumPooledObjects() const {
+  int numPooledObjects = 0;
+  for (const auto& pooled : objectPool_) {
+    numPooledObjects += pooled.second.size();
+  }
+  return numPooledObjects;
+}
+
+void PhysicsManager::clearObjectPool() {
+  for (auto& pooled : objectPool_) {
+    for (std::unique_ptr<physics::RigidObject>& object : pooled.second) {
+      scene::SceneNode* objectNode = &object->node();
+      object.reset();
+      delete objectNode;
+    }
+  }
+  objectPool_.clear();
+}
+
 void PhysicsManager::removeObject(const int physObjectID,
                                   bool deleteObjectNode,
                                   bool deleteVisualNode) {
   assertIDValidity(physObjectID);
+  auto activeId = std::lower_bound(activeObjectIds_.begin(),
+                                   activeObjectIds_.end(), physObjectID);
+  if (activeId != activeObjectIds_.end() && *activeId == physObjectID) {
+    activeObjectIds_.erase(activeId);
+  }
+  const bool poolable = poolableObjectIDs_.erase(physObjectID) != 0;
+  if (objectPooling_ && poolable && deleteObjectNode) {
+    std::unique_ptr<physics::RigidObject> object =
+        existingObjects_.release(physObjectID);
+    deallocateObjectID(physObjectID);
+    object->release();
+    if (object->BBNode_) {
+      delete object->BBNode_;
+      object->BBNode_ = nullptr;
+    }
+    // hide the drawables instead of destroying them
+    for (gfx::Drawable& drawable :
+         scene::preOrderFeatures<gfx::Drawable>(*object->visualNode_)) {
+      if (drawable.drawables()) {
+        drawable.drawables()->remove(drawable);
+      }
+    }
+    const std::string handle =
+        object->getSharedInitializationAttributes()->getHandle();
+    objectPool_[handle].push_back(std::move(object));
+    return;
+  }
+
   scene::SceneNode* objectNode = &existingObjects_.at(physObjectID)->node();
   scene::SceneNode* visualNode = existingObjects_.at(physObjectID)->visualNode_;
   existingObjects_.erase(physObjectID);
@@ -152,6 +646,103 @@ MotionType PhysicsManager::getObjectMotionType(const int physObjectID) const {
   return existingObjects_.at(physObjectID)->getMotionType();
 }
 
+PhysicsSnapshot PhysicsManager::saveSnapshot() const {
+  PhysicsSnapshot snapshot;
+  snapshot.worldTime = worldTime_;
+  snapshot.objects.reserve(existingObjects_.size());
+  for (const auto& objectItr : existingObjects_) {
+    const RigidObject& object = *objectItr.second;
+    PhysicsSnapshot::ObjectState state;
+    state.objectId = objectItr.first;
+    state.generation = existingObjects_.handle(objectItr.first).generation;
+    state.motionType = object.getMotionType();
+    state.translation = object.node().translation();
+    state.rotation = object.node().rotation();
+    state.linearVelocity = object.getLinearVelocity();
+    state.angularVelocity = object.getAngularVelocity();
+    state.velocityControl = *objectItr.second->getVelocityControl();
+    snapshot.objects.push_back(state);
+  }
+  return snapshot;
+}
+
+bool PhysicsManager::restoreSnapshot(const PhysicsSnapshot& snapshot) {
+  bool restoredAll = true;
+  for (const PhysicsSnapshot::ObjectState& state : snapshot.objects) {
+    // an object added since under a recycled ID gets a new generation
+    RigidObject* object = existingObjects_.get(
+        ObjectSlotMap<RigidObject>::Handle{state.objectId, state.generation});
+    if (!object) {
+      restoredAll = false;
+      continue;
+    }
+    // static objects ignore poses, so the motion type is restored around it
+    if (object->getMotionType() == MotionType::STATIC) {
+      object->setMotionType(state.motionType);
+    }
+    object->setRigidState({state.rotation, state.translation});
+    object->setMotionType(state.motionType);
+    object->setLinearVelocity(state.linearVelocity);
+    object->setAngularVelocity(state.angularVelocity);
+    *object->getVelocityControl() = state.velocityControl;
+    velocityControlledObjects_[state.objectId] =
+        existingObjects_.handle(state.objectId);
+    if (state.motionType == MotionType::DYNAMIC) {
+      object->setActive();
+    }
+  }
+  if (!restoredAll) {
+    LOG(WARNING) << "PhysicsManager::restoreSnapshot : objects of the snapshot "
+                    "were removed since, skipping them and objects "
+                    "reusing their IDs.";
+  }
+  worldTime_ = snapshot.worldTime;
+  return restoredAll;
+}
+
+int PhysicsManager::cloneObjectsFrom(const PhysicsManager& source,
+                                     DrawableGroup* drawables) {
+  std::vector<int> skippedIDs;
+  for (const int objectID : source.getExistingObjectIDs()) {
+    const RigidObject& object = *source.existingObjects_.get(objectID);
+    // attached objects belong to a node of the source scene graph
+    if (source.poolableObjectIDs_.count(objectID) == 0) {
+      skippedIDs.push_back(objectID);
+      continue;
+    }
+    // make the next allocation return the ID of the source object
+    recycledObjectIDs_.assign(1, objectID);
+    if (addObject(object.getSharedInitializationAttributes()->getHandle(),
+                  drawables) != objectID) {
+      LOG(ERROR) << "PhysicsManager::cloneObjectsFrom : Unable to copy "
+                    "object "
+                 << objectID << ". Skipping it.";
+      skippedIDs.push_back(objectID);
+      continue;
+    }
+    existingObjects_.at(objectID)->setSemanticId(
+        object.visualNode_->getSemanticId());
+  }
+  nextObjectID_ = source.nextObjectID_;
+  recycledObjectIDs_ = source.recycledObjectIDs_;
+  recycledObjectIDs_.insert(recycledObjectIDs_.end(), skippedIDs.begin(),
+                            skippedIDs.end());
+
+  PhysicsSnapshot snapshot = source.saveSnapshot();
+  snapshot.objects.erase(
+      std::remove_if(snapshot.objects.begin(), snapshot.objects.end(),
+                     [&](const PhysicsSnapshot::ObjectState& state) {
+                       return existingObjects_.get(state.objectId) == nullptr;
+                     }),
+      snapshot.objects.end());
+  // the copies have the generations of this manager's slots
+  for (PhysicsSnapshot::ObjectState& state : snapshot.objects) {
+    state.generation = existingObjects_.handle(state.objectId).generation;
+  }
+  restoreSnapshot(snapshot);
+  return snapshot.objects.size();
+}
+
 int PhysicsManager::allocateObjectID() {
   if (!recycledObjectIDs_.empty()) {
     int recycledID = recycledObjectIDs_.back();
@@ -210,6 +801,8 @@ void PhysicsManager::stepPhysics(double dt) {
     dt = fixedTimeStep_;
   }
 
+  updateVelocityControlledObjects();
+
   // handle in-between step times? Ideally dt is a multiple of
   // sceneMetaData_.timestep
   double targetTime = worldTime_ + dt;
@@ -217,12 +810,10 @@ void PhysicsManager::stepPhysics(double dt) {
     // per fixed-step operations can be added here
 
     // kinematic velocity control intergration
-    for (auto& object : existingObjects_) {
-      VelocityControl::ptr velControl = object.second->getVelocityControl();
-      if (velControl->controllingAngVel || velControl->controllingLinVel) {
-        object.second->setRigidState(velControl->integrateTransform(
-            fixedTimeStep_, object.second->getRigidState()));
-      }
+    for (RigidObject* object : activeVelocityControlledObjects_) {
+      object->setRigidState(
+          object->getVelocityControl()->integrateTransform(
+              fixedTimeStep_, object->getRigidState()));
     }
     worldTime_ += fixedTimeStep_;
   }
@@ -292,6 +883,17 @@ void PhysicsManager::setRigidState(const int physObjectID,
   assertIDValidity(physObjectID);
   existingObjects_.at(physObjectID)->setRigidState(rigidState);
 }
+void PhysicsManager::setRigidStates(
+    const std::vector<int>& physObjectIDs,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> translations,
+    Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations) {
+  CHECK_EQ(translations.size(), physObjectIDs.size());
+  CHECK_EQ(rotations.size(), physObjectIDs.size());
+  for (size_t i = 0; i < physObjectIDs.size(); ++i) {
+    existingObjects_.at(physObjectIDs[i])
+        ->setRigidState({rotations[i], translations[i]});
+  }
+}
 void PhysicsManager::setTranslation(const int physObjectID,
                                     const Magnum::Vector3& vector) {
   assertIDValidity(physObjectID);
@@ -373,6 +975,20 @@ esp::core::RigidState PhysicsManager::getRigidState(
   return existingObjects_.at(physObjectID)->getRigidState();
 }
 
+void PhysicsManager::getRigidStates(
+    const std::vector<int>& physObjectIDs,
+    Corrade::Containers::ArrayView<Magnum::Vector3> translations,
+    Corrade::Containers::ArrayView<Magnum::Quaternion> rotations) const {
+  CHECK_EQ(translations.size(), physObjectIDs.size());
+  CHECK_EQ(rotations.size(), physObjectIDs.size());
+  for (size_t i = 0; i < physObjectIDs.size(); ++i) {
+    const scene::SceneNode& node =
+        existingObjects_.at(physObjectIDs[i])->node();
+    translations[i] = node.translation();
+    rotations[i] = node.rotation();
+  }
+}
+
 Magnum::Vector3 PhysicsManager::getTranslation(const int physObjectID) const {
   assertIDValidity(physObjectID);
   return existingObjects_.at(physObjectID)->node().translation();
@@ -407,12 +1023,61 @@ Magnum::Vector3 PhysicsManager::getAngularVelocity(
   return existingObjects_.at(physObjectID)->getAngularVelocity();
 }
 
+void PhysicsManager::getVelocities(
+    const std::vector<int>& physObjectIDs,
+    Corrade::Containers::ArrayView<Magnum::Vector3> linVels,
+    Corrade::Containers::ArrayView<Magnum::Vector3> angVels) const {
+  CHECK_EQ(linVels.size(), physObjectIDs.size());
+  CHECK_EQ(angVels.size(), physObjectIDs.size());
+  for (size_t i = 0; i < physObjectIDs.size(); ++i) {
+    const auto& object = existingObjects_.at(physObjectIDs[i]);
+    linVels[i] = object->getLinearVelocity();
+    angVels[i] = object->getAngularVelocity();
+  }
+}
+
+void PhysicsManager::setVelocities(
+    const std::vector<int>& physObjectIDs,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> linVels,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> angVels) {
+  CHECK_EQ(linVels.size(), physObjectIDs.size());
+  CHECK_EQ(angVels.size(), physObjectIDs.size());
+  for (size_t i = 0; i < physObjectIDs.size(); ++i) {
+    const auto& object = existingObjects_.at(physObjectIDs[i]);
+    object->setLinearVelocity(linVels[i]);
+    object->setAngularVelocity(angVels[i]);
+  }
+}
+
 VelocityControl::ptr PhysicsManager::getVelocityControl(
     const int physObjectID) {
   assertIDValidity(physObjectID);
+  velocityControlledObjects_[physObjectID] =
+      existingObjects_.handle(physObjectID);
   return existingObjects_.at(physObjectID)->getVelocityControl();
 }
 
+void PhysicsManager::updateVelocityControlledObjects() {
+  activeVelocityControlledObjects_.clear();
+  for (auto it = velocityControlledObjects_.begin();
+       it != velocityControlledObjects_.end();) {
+    RigidObject* object = existingObjects_.get(it->second);
+    if (!object) {
+      it = velocityControlledObjects_.erase(it);
+      continue;
+    }
+    VelocityControl::ptr velControl = object->getVelocityControl();
+    if (velControl->controllingLinVel || velControl->controllingAngVel) {
+      activeVelocityControlledObjects_.push_back(object);
+    } else if (velControl.use_count() <= 2) {
+      // only held by the object and this copy, nobody can activate it
+      it = velocityControlledObjects_.erase(it);
+      continue;
+    }
+    ++it;
+  }
+}
+
 //============ Object Setter functions =============
 void PhysicsManager::setMass(const int physObjectID, const double mass) {
   assertIDValidity(physObjectID);
@@ -452,6 +1117,14 @@ void PhysicsManager::setAngularDamping(const int physObjectID,
   existingObjects_.at(physObjectID)->setAngularDamping(angDamping);
 }
 
+void PhysicsManager::setSleepingThresholds(const int physObjectID,
+                                           const double linThreshold,
+                                           const double angThreshold) {
+  assertIDValidity(physObjectID);
+  existingObjects_.at(physObjectID)
+      ->setSleepingThresholds(linThreshold, angThreshold);
+}
+
 //============ Object Getter functions =============
 double PhysicsManager::getMass(const int physObjectID) const {
   assertIDValidity(physObjectID);
@@ -498,6 +1171,18 @@ double PhysicsManager::getAngularDamping(const int physObjectID) const {
   return existingObjects_.at(physObjectID)->getAngularDamping();
 }
 
+double PhysicsManager::getLinearSleepingThreshold(
+    const int physObjectID) const {
+  assertIDValidity(physObjectID);
+  return existingObjects_.at(physObjectID)->getLinearSleepingThreshold();
+}
+
+double PhysicsManager::getAngularSleepingThreshold(
+    const int physObjectID) const {
+  assertIDValidity(physObjectID);
+  return existingObjects_.at(physObjectID)->getAngularSleepingThreshold();
+}
+
 void PhysicsManager::setObjectBBDraw(int physObjectID,
                                      DrawableGroup* drawables,
                                      bool drawBB) {
@@ -517,7 +1202,7 @@ void PhysicsManager::setObjectBBDraw(int physObjectID,
     existingObjects_.at(physObjectID)->BBNode_->MagnumObject::setScaling(scale);
     existingObjects_.at(physObjectID)
         ->BBNode_->MagnumObject::setTranslation(
-            existingObjects_[physObjectID]
+            existingObjects_.at(physObjectID)
                 ->visualNode_->getCumulativeBB()
                 .center());
     resourceManager_.addPrimitiveToDrawables(
@@ -10,13 +10,20 @@
  * esp::physics::PhysicsManager::PhysicsSimulationLibrary
  */
 
+#include <algorithm>
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <Corrade/Containers/ArrayView.h>
+
 /* Bullet Physics Integration */
 
+#include "ObjectSlotMap.h"
 #include "RigidObject.h"
 #include "RigidStage.h"
 #include "esp/assets/Asset.h"
@@ -26,6 +33,7 @@
 #include "esp/assets/MeshData.h"
 #include "esp/assets/MeshMetaData.h"
 #include "esp/assets/ResourceManager.h"
+#include "esp/geo/MeshBVH.h"
 #include "esp/gfx/DrawableGroup.h"
 #include "esp/scene/SceneNode.h"
 
@@ -66,6 +74,115 @@ struct RaycastResults {
   ESP_SMART_POINTERS(RaycastResults)
 };
 
+/**
+ * @brief First hits of a batch of rays, in flat arrays indexed by ray.
+ *
+ * Rays without a hit have @ref hasHit 0, an @ref objectIds of @ref
+ * ID_UNDEFINED, zero points and normals and an infinite @ref rayDistances.
+ * Can be reused between batches, resizing only reallocates if the batch grows.
+ */
+struct BatchRaycastResults {
+  //! Whether the ray hit anything within the max distance.
+  std::vector<uint8_t> hasHit;
+  //! The id of the object hit first. Stage hits are -1.
+  std::vector<int> objectIds;
+  //! The first impact point in world space.
+  std::vector<Magnum::Vector3> points;
+  //! The collision object normal at the first impact point.
+  std::vector<Magnum::Vector3> normals;
+  //! Distance from the ray origin to the first impact, in units of ray length.
+  std::vector<double> rayDistances;
+
+  //! The number of rays in the batch.
+  size_t size() const { return hasHit.size(); }
+
+  //! Resize to @p numRays rays, all without a hit.
+  void reset(size_t numRays) {
+    hasHit.assign(numRays, 0);
+    objectIds.assign(numRays, ID_UNDEFINED);
+    points.assign(numRays, Magnum::Vector3{});
+    normals.assign(numRays, Magnum::Vector3{});
+    rayDistances.assign(numRays, std::numeric_limits<double>::infinity());
+  }
+
+  ESP_SMART_POINTERS(BatchRaycastResults)
+};
+
+/**
+ * @brief The contact points of the last simulation step, see @ref
+ * PhysicsManager::getContactPoints(). One entry per point in each array.
+ *
+ * The points of a pair of touching objects are consecutive. Stage contacts
+ * have an object id of -1.
+ */
+struct ContactPointResults {
+  //! The id of the first object of the contact.
+  std::vector<int> objectIdsA;
+  //! The id of the second object of the contact.
+  std::vector<int> objectIdsB;
+  //! The contact point on the second object in world space.
+  std::vector<Magnum::Vector3> points;
+  //! The contact normal in world space, pointing from the second object to
+  //! the first one.
+  std::vector<Magnum::Vector3> normals;
+  //! The impulse applied by the solver along the normal during the last step.
+  std::vector<double> impulses;
+
+  //! The number of contact points.
+  size_t size() const { return objectIdsA.size(); }
+
+  //! Remove all points, keeping the allocations.
+  void clear() {
+    objectIdsA.clear();
+    objectIdsB.clear();
+    points.clear();
+    normals.clear();
+    impulses.clear();
+  }
+
+  ESP_SMART_POINTERS(ContactPointResults)
+};
+
+/**
+ * @brief The state of all objects of a @ref PhysicsManager at one point in
+ * time, see @ref PhysicsManager::saveSnapshot().
+ *
+ * Compact enough to keep many of them for branching rollouts, and
+ * serializable into a binary blob to ship it between processes.
+ */
+struct PhysicsSnapshot {
+  //! The state of one object
+  struct ObjectState {
+    int objectId = ID_UNDEFINED;
+    //! The generation of the object in its ID slot, so that an object which
+    //! reused the ID of a removed one is not restored to its state
+    uint32_t generation = 0;
+    MotionType motionType = MotionType::ERROR_MOTIONTYPE;
+    Magnum::Vector3 translation;
+    Magnum::Quaternion rotation;
+    Magnum::Vector3 linearVelocity;
+    Magnum::Vector3 angularVelocity;
+    VelocityControl velocityControl;
+  };
+
+  //! The @ref PhysicsManager::getWorldTime() at the time of the snapshot.
+  double worldTime = 0.0;
+  std::vector<ObjectState> objects;
+
+  /**
+   * @brief Serialize into a binary blob, in the byte order of this machine
+   */
+  std::string serialize() const;
+
+  /**
+   * @brief Replace the contents with a blob from @ref serialize()
+   * @return false, leaving the contents unspecified, if the blob is invalid
+   */
+  bool deserialize(const std::string& data);
+
+  ESP_SMART_POINTERS(PhysicsSnapshot)
+};
+
 // TODO: repurpose to manage multiple physical worlds. Currently represents
 // exactly one world.
 
@@ -111,7 +228,15 @@ class PhysicsManager {
      * BulletRigidObject. Suggests the use of @ref PhysicsManager derived class
      * @ref BulletPhysicsManager
      */
-    BULLET
+    BULLET,
+
+    /**
+     * Kinematics with lightweight collision queries and no dynamics. Supports
+     * @ref MotionType::STATIC and @ref MotionType::KINEMATIC objects of base
+     * class @ref RigidObject. Suggests the use of @ref PhysicsManager derived
+     * class @ref KinematicPhysicsManager
+     */
+    KINEMATIC
   };
 
   /**
@@ -149,9 +274,49 @@ class PhysicsManager {
     worldTime_ = 0.0;
   }
 
+  /**
+   * @brief Capture the rigid states, velocities, motion types and velocity
+   * controls of all objects and the world time, see @ref restoreSnapshot().
+   */
+  PhysicsSnapshot saveSnapshot() const;
+
+  /**
+   * @brief Restore the state captured by @ref saveSnapshot() in place, without
+   * re-creating any object.
+   *
+   * Objects created after the snapshot keep their state, also when they reuse
+   * the ID of an object of the snapshot. Dynamic objects are woken up, so
+   * sleeping objects of the snapshot resume simulation.
+   * @return false if an object of the snapshot no longer exists, the others
+   * are restored regardless.
+   */
+  bool restoreSnapshot(const PhysicsSnapshot& snapshot);
+
+  /**
+   * @brief Share the immutable collision data built by @p source, which must
+   * use the same resource manager, instead of building it again. Called
+   * before the stage is added, see @ref esp::sim::Simulator::clone(). Does
+   * nothing by default.
+   */
+  virtual void shareCollisionShapes(
+      CORRADE_UNUSED const PhysicsManager& source) {}
+
   /** @brief Stores references to a set of drawable elements. */
   using DrawableGroup = gfx::DrawableGroup;
 
+  /**
+   * @brief Add a copy of every object of @p source under the same ID, from
+   * the same template, and restore the copies to the state of @p source, see
+   * @ref saveSnapshot().
+   *
+   * Objects attached to existing scene nodes of @p source are skipped. Later
+   * objects receive the IDs @p source would allocate.
+   *  @param drawables Reference to the scene graph drawables group to enable
+   * rendering of the copies.
+   *  @return The number of copied objects.
+   */
+  int cloneObjectsFrom(const PhysicsManager& source, DrawableGroup* drawables);
+
   /**
    * @brief Initialize static scene collision geometry from loaded mesh data.
    * Only one 'scene' may be initialized per simulated world, but this scene may
@@ -165,6 +330,29 @@ class PhysicsManager {
   bool addStage(const std::string& handle,
                 const std::vector<assets::CollisionMeshData>& meshGroup);
 
+  /**
+   * @brief Add the collision mesh of a loaded asset to the static geometry
+   * of the stage, e.g. a chunk of a streamed stage, see @ref
+   * assets::StageStreamer. Contacts with it and rays hitting it count as the
+   * stage's.
+   *
+   * @param collisionAssetHandle An asset whose collision mesh is built, in
+   * world space, see @ref assets::ResourceManager::loadStreamedAsset()
+   * @return The id of the chunk for @ref removeStageChunk(), or @ref
+   * esp::ID_UNDEFINED if there is no stage or the mesh is invalid
+   */
+  int addStageChunk(const std::string& collisionAssetHandle);
+
+  /**
+   * @brief Remove a chunk added by @ref addStageChunk() from the static
+   * geometry. Its collision mesh may be released afterwards.
+   * @return Whether @p chunkId was a chunk
+   */
+  bool removeStageChunk(int chunkId);
+
+  /** @brief The number of chunks of @ref addStageChunk() */
+  int getNumStageChunks() const { return stageChunks_.size(); }
+
   /** @brief Instance a physical object from an object properties template in
    * the @ref esp::metadata::managers::ObjectAttributesManager.
    *  @anchor addObject_string
@@ -202,6 +390,24 @@ class PhysicsManager {
                 const Magnum::ResourceKey& lightSetup = Magnum::ResourceKey{
                     assets::ResourceManager::DEFAULT_LIGHTING_KEY});
 
+  /** @brief Instance a batch of physical objects from object properties
+   * templates in the @ref esp::metadata::managers::ObjectAttributesManager,
+   * as @ref addObject_string "addObject()" does for each of them. The assets
+   * of each distinct template are instantiated once for the whole batch.
+   *  @param configFiles The handles of the templates of the objects, one per
+   * object, in creation order.
+   *  @param drawables Reference to the scene graph drawables group to enable
+   * rendering of the newly initialized objects.
+   *  @return the instanced objects' IDs, mapping to them in @ref
+   * PhysicsManager::existingObjects_, with @ref esp::ID_UNDEFINED for the
+   * objects which failed.
+   */
+  std::vector<int> addObjects(
+      const std::vector<std::string>& configFiles,
+      DrawableGroup* drawables,
+      const Magnum::ResourceKey& lightSetup =
+          Magnum::ResourceKey{assets::ResourceManager::DEFAULT_LIGHTING_KEY});
+
   /** @brief Remove an object instance from the pysical scene by ID, destroying
    * its scene graph node and removing it from @ref
    * PhysicsManager::existingObjects_.
@@ -223,15 +429,44 @@ class PhysicsManager {
    */
   int getNumRigidObjects() const { return existingObjects_.size(); };
 
+  /** @brief Enable or disable the pooling of removed objects.
+   *
+   * With pooling, @ref removeObject() takes objects out of the world and
+   * hides their drawables instead of destroying them, and adding an object of
+   * the same template recycles one of them, keeping its scene nodes,
+   * drawables and collision shapes. Only objects added without an attachment
+   * node and removed with their object node are pooled. Disabling pooling
+   * destroys the pooled objects.
+   *  @param enabled Whether to pool removed objects.
+   */
+  void setObjectPooling(bool enabled);
+
+  /** @brief Whether removed objects are pooled, see @ref setObjectPooling().
+   */
+  bool getObjectPooling() const { return objectPooling_; }
+
+  /** @brief Get the number of removed objects kept for recycling, see @ref
+   * setObjectPooling().
+   */
+  int getNumPooledObjects() const;
+
+  /** @brief Destroy all removed objects kept for recycling, with their scene
+   * nodes, see @ref setObjectPooling().
+   */
+  void clearObjectPool();
+
   /** @brief Get a list of existing object IDs (i.e., existing keys in @ref
    * PhysicsManager::existingObjects_.)
    *  @return List of object ID keys from @ref PhysicsManager::existingObjects_.
    */
   std::vector<int> getExistingObjectIDs() const {
     std::vector<int> v;
+    v.reserve(existingObjects_.size());
     for (auto& bro : existingObjects_) {
       v.push_back(bro.first);
     }
+    // the storage is not ordered by ID
+    std::sort(v.begin(), v.end());
     return v;
   };
 
@@ -350,6 +585,18 @@ class PhysicsManager {
   void setRigidState(const int physObjectID,
                      const esp::core::RigidState& rigidState);
 
+  /** @brief Set the @ref esp::core::RigidState of many objects kinematically
+   * in one call, e.g. to restore a state captured with @ref getRigidStates().
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param translations The desired 3D positions, one per object.
+   * @param rotations The desired orientations, one per object.
+   */
+  void setRigidStates(
+      const std::vector<int>& physObjectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations);
+
   /** @brief Set the 3D position of an object kinematically.
    * Calling this during simulation of a @ref MotionType::DYNAMIC object is not
    * recommended.
@@ -488,6 +735,20 @@ class PhysicsManager {
    */
   esp::core::RigidState getRigidState(const int objectID) const;
 
+  /** @brief Get the current @ref esp::core::RigidState of many objects in one
+   * call, into contiguous arrays.
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param[out] translations The 3D positions, one per object. A @ref
+   * Magnum::Vector3 is 3 floats.
+   * @param[out] rotations The orientations, one per object. A @ref
+   * Magnum::Quaternion is 4 floats, the vector part followed by the scalar.
+   */
+  void getRigidStates(
+      const std::vector<int>& physObjectIDs,
+      Corrade::Containers::ArrayView<Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<Magnum::Quaternion> rotations) const;
+
   /** @brief Get the current 3D position of an object.
    * @param  physObjectID The object ID and key identifying the object in @ref
    * PhysicsManager::existingObjects_.
@@ -571,6 +832,18 @@ class PhysicsManager {
    */
   void setAngularDamping(const int physObjectID, const double angDamping);
 
+  /** @brief Set the speeds below which an object may fall asleep.
+   * See @ref RigidObject::setSleepingThresholds.
+   * @param physObjectID The object ID and key identifying the object in @ref
+   * PhysicsManager::existingObjects_.
+   * @param linThreshold The linear sleeping threshold, in meters per second.
+   * @param angThreshold The angular sleeping threshold, in radians per
+   * second.
+   */
+  void setSleepingThresholds(const int physObjectID,
+                             const double linThreshold,
+                             const double angThreshold);
+
   // ============ Object Getter functions =============
 
   /** @brief Get the mass of an object.
@@ -645,6 +918,22 @@ class PhysicsManager {
    */
   double getAngularDamping(const int physObjectID) const;
 
+  /** @brief Get the linear speed below which an object may fall asleep.
+   * See @ref RigidObject::getLinearSleepingThreshold.
+   * @param physObjectID The object ID and key identifying the object in @ref
+   * PhysicsManager::existingObjects_.
+   * @return The linear sleeping threshold of the object.
+   */
+  double getLinearSleepingThreshold(const int physObjectID) const;
+
+  /** @brief Get the angular speed below which an object may fall asleep.
+   * See @ref RigidObject::getAngularSleepingThreshold.
+   * @param physObjectID The object ID and key identifying the object in @ref
+   * PhysicsManager::existingObjects_.
+   * @return The angular sleeping threshold of the object.
+   */
+  double getAngularSleepingThreshold(const int physObjectID) const;
+
   // ============= Platform dependent function =============
 
   /** @brief Get the scalar collision margin of an object.
@@ -684,6 +973,17 @@ class PhysicsManager {
    */
   bool isActive(const int physObjectID) const;
 
+  /** @brief Get the sorted IDs of the objects active at the end of the last
+   * step. Maintained by the step of the physics simulator in use rather than
+   * by visiting all objects like @ref checkActiveObjects(), so cheap to poll,
+   * e.g. to wait until the objects settled. Removed objects leave it at
+   * once, objects woken between steps join it at the next step.
+   * @return The IDs of the active @ref RigidObject instances.
+   */
+  const std::vector<int>& getActiveObjectIds() const {
+    return activeObjectIds_;
+  }
+
   //============ Interact with objects =============
   // NOTE: engine specifics handled by objects themselves...
 
@@ -775,8 +1075,39 @@ class PhysicsManager {
    */
   Magnum::Vector3 getAngularVelocity(const int physObjectID) const;
 
+  /**
+   * @brief Get the linear and angular velocities of many objects in one
+   * call, into contiguous arrays, see @ref getLinearVelocity() and @ref
+   * getAngularVelocity().
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param[out] linVels The linear velocities, one per object.
+   * @param[out] angVels The angular velocities, one per object.
+   */
+  void getVelocities(const std::vector<int>& physObjectIDs,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> linVels,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> angVels)
+      const;
+
+  /**
+   * @brief Set the linear and angular velocities of many objects in one call,
+   * see @ref setLinearVelocity() and @ref setAngularVelocity().
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param linVels The linear velocities, one per object.
+   * @param angVels The angular velocities, one per object.
+   */
+  void setVelocities(
+      const std::vector<int>& physObjectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> linVels,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> angVels);
+
   /**@brief Retrieves a shared pointer to the VelocityControl struct for this
    * object.
+   *
+   * Only the objects whose control was retrieved here are visited by the
+   * velocity control integration of @ref stepPhysics(), see @ref
+   * velocityControlledObjects_.
    */
   VelocityControl::ptr getVelocityControl(const int physObjectID);
 
@@ -896,8 +1227,9 @@ class PhysicsManager {
    * @brief Cast a ray into the collision world and return a @ref RaycastResults
    * with hit information.
    *
-   * Note: not implemented here in default PhysicsManager as there are no
-   * collision objects without a simulation implementation.
+   * Without a simulation implementation, intersects the triangles of the
+   * stage and object meshes with a @ref geo::MeshBVH each, built on the first
+   * cast. Objects without a triangle mesh are missed.
    *
    * @param ray The ray to cast. Need not be unit length, but returned hit
    * distances will be in units of ray length.
@@ -906,14 +1238,56 @@ class PhysicsManager {
    * @return The raycast results sorted by distance.
    */
   virtual RaycastResults castRay(const esp::geo::Ray& ray,
-                                 CORRADE_UNUSED double maxDistance = 100.0) {
-    RaycastResults results;
-    results.ray = ray;
-    return results;
+                                 double maxDistance = 100.0);
+
+  /**
+   * @brief Cast a batch of rays into the collision world and write the first
+   * hit of each into @p results, see @ref BatchRaycastResults.
+   *
+   * Without a simulation implementation, casts against the meshes like
+   * @ref castRay().
+   *
+   * @param rays The rays to cast. Need not be unit length, but hit distances
+   * will be in units of ray length. Zero length rays miss.
+   * @param[out] results The first hits, resized to the number of rays.
+   * @param maxDistance The maximum distance along the ray direction to search.
+   * In units of ray length.
+   * @param numThreads The number of threads to cast on, 0 for all hardware
+   * threads.
+   */
+  virtual void castRays(const std::vector<esp::geo::Ray>& rays,
+                        BatchRaycastResults& results,
+                        double maxDistance = 100.0,
+                        int numThreads = 0);
+
+  /**
+   * @brief Find the stage and the objects overlapping an axis aligned box,
+   * e.g. the bounds of an agent.
+   *
+   * Not implemented for default @ref PhysicsManager. See @ref
+   * KinematicPhysicsManager and @ref BulletPhysicsManager.
+   * @param center The world space center of the box.
+   * @param halfExtents The half extents of the box.
+   * @return The sorted IDs of the overlapping objects, -1 for the stage.
+   */
+  virtual std::vector<int> boxOverlapTest(
+      CORRADE_UNUSED const Magnum::Vector3& center,
+      CORRADE_UNUSED const Magnum::Vector3& halfExtents) {
+    return {};
   }
 
   virtual int getNumActiveContactPoints() { return -1; }
 
+  /**
+   * @brief Get all contact points between the objects and the stage found by
+   * the last simulation step, in a single pass over the contact manifolds.
+   * Includes the contacts of sleeping objects. None by default.
+   * @param results The contact points, replaced by the new points.
+   */
+  virtual void getContactPoints(ContactPointResults& results) {
+    results.clear();
+  }
+
  protected:
   /** @brief Check that a given object ID is valid (i.e. it refers to an
    * existing object). Terminate the program and report an error if not. This
@@ -966,6 +1340,32 @@ class PhysicsManager {
 
   virtual bool addStageFinalize(const std::string& handle);
 
+  /**
+   * @brief Add the collision shapes of a chunk of @ref addStageChunk() to
+   * the simulation. Overidden by instancing class if physics is supported.
+   * @return true if successful and false otherwise
+   */
+  virtual bool addStageChunkFinalize(
+      CORRADE_UNUSED int chunkId,
+      CORRADE_UNUSED const std::string& collisionAssetHandle) {
+    return true;
+  }
+
+  /**
+   * @brief Remove the collision shapes of a chunk of @ref addStageChunk()
+   * from the simulation. Overidden by instancing class if physics is
+   * supported.
+   */
+  virtual void removeStageChunkFinalize(CORRADE_UNUSED int chunkId) {}
+
+  /** @brief Create, draw and finalize an object whose assets are
+   * instantiated already, see @ref addObject_string "addObject()".
+   */
+  int addObjectFinalize(const std::string& configFileHandle,
+                        DrawableGroup* drawables,
+                        scene::SceneNode* attachmentNode,
+                        const Magnum::ResourceKey& lightSetup);
+
   /** @brief Create and initialize a @ref RigidObject, assign it an ID and add
    * it to existingObjects_ map keyed with newObjectID
    * @param newObjectID valid object ID for the new object
@@ -980,6 +1380,20 @@ class PhysicsManager {
                                      const std::string& handle,
                                      scene::SceneNode* objectNode);
 
+  /** @brief Append the world space triangles of the collision mesh node
+   * @p node and its children to @p vertices.
+   */
+  void gatherStageTriangles(
+      const Magnum::Matrix4& transformFromParentToWorld,
+      const std::vector<assets::CollisionMeshData>& meshGroup,
+      const assets::MeshTransformNode& node,
+      std::vector<Magnum::Vector3>& vertices);
+
+  /** @brief Append the world space triangles of the collision meshes of the
+   * chunks of @ref addStageChunk() to @p vertices.
+   */
+  void gatherStageChunkTriangles(std::vector<Magnum::Vector3>& vertices);
+
   /** @brief A reference to a @ref esp::assets::ResourceManager which holds
    * assets that can be accessed by this @ref PhysicsManager*/
   assets::ResourceManager& resourceManager_;
@@ -1011,12 +1425,117 @@ class PhysicsManager {
    * */
   physics::RigidStage::uptr staticStageObject_ = nullptr;
 
+  /** @brief The collision asset handles of the chunks of @ref
+   * addStageChunk(), by chunk id.
+   */
+  std::map<int, std::string> stageChunks_;
+
+  /** @brief The id of the next chunk of @ref addStageChunk(). */
+  int nextStageChunkId_ = 0;
+
   //! ==== Rigid object memory management ====
 
   /** @brief Maps object IDs to all existing physical object instances in the
-   * world.
+   * world. Dense storage indexed by the recycled IDs, with the existing
+   * objects in a contiguous list for the per-step loops.
+   */
+  ObjectSlotMap<physics::RigidObject> existingObjects_;
+
+  /** @brief The objects whose @ref VelocityControl may be active, as it was
+   * handed out by @ref getVelocityControl() or restored from a snapshot.
+   * Keyed by object ID, the handle detects a recycled ID.
+   */
+  std::map<int, ObjectSlotMap<physics::RigidObject>::Handle>
+      velocityControlledObjects_;
+
+  /** @brief The objects with an active @ref VelocityControl, refreshed by
+   * @ref updateVelocityControlledObjects() once per step.
+   */
+  std::vector<physics::RigidObject*> activeVelocityControlledObjects_;
+
+  /** @brief The sorted IDs of the objects active at the end of the last step,
+   * see @ref getActiveObjectIds(). Empty without a physics simulator.
+   */
+  std::vector<int> activeObjectIds_;
+
+  /** @brief Fill @ref activeVelocityControlledObjects_ from @ref
+   * velocityControlledObjects_, dropping the removed objects and those whose
+   * inactive control is not referenced outside of the object anymore, so
+   * can't be activated again.
+   */
+  void updateVelocityControlledObjects();
+
+  /** @brief Whether removed objects are pooled, see @ref setObjectPooling().
+   */
+  bool objectPooling_ = false;
+
+  /** @brief The IDs of the existing objects whose object node was created
+   * by @ref addObject(), which can be pooled when removed.
+   */
+  std::unordered_set<int> poolableObjectIDs_;
+
+  /** @brief Removed objects kept for recycling, keyed by the handle of their
+   * template. Their nodes stay in the scene graph, without drawables in any
+   * group.
+   */
+  std::unordered_map<std::string,
+                     std::vector<std::unique_ptr<physics::RigidObject>>>
+      objectPool_;
+
+  /** @brief Recycle a pooled object of a template for a new object.
+   *  @return The ID of the new object, or @ref esp::ID_UNDEFINED if no
+   * object of the template is pooled.
+   */
+  int reusePooledObject(const std::string& configFileHandle,
+                        DrawableGroup* drawables,
+                        const Magnum::ResourceKey& lightSetup);
+
+  /** @brief An object mesh of the ray caster of @ref castRay() without a
+   * simulation implementation, at the transformation of its object.
+   */
+  struct MeshRayCasterObject {
+    int objectId;
+    std::shared_ptr<const geo::MeshBVH> bvh;
+    Magnum::Matrix4 transformFromWorldToLocal;
+    Magnum::Matrix3x3 normalMatrix;
+  };
+
+  /** @brief Build the stage BVH on first use and collect the current
+   * transformations of the object meshes, once before each cast.
+   */
+  void updateMeshRayCaster();
+
+  /** @brief The BVH of the triangles of the mesh group loaded for @p handle,
+   * cached by handle, nullptr if there is none.
    */
-  std::map<int, physics::RigidObject::uptr> existingObjects_;
+  std::shared_ptr<const geo::MeshBVH> getMeshBVH(const std::string& handle);
+
+  /** @brief Update what @ref castFirstHit() reads, once before the rays of
+   * @ref castRays() are cast. Updates the mesh ray caster by default.
+   */
+  virtual void prepareFirstHits();
+
+  /** @brief The first hit of @p ray, see @ref castRays(). Called
+   * concurrently, the first mesh hit by default.
+   * @return false if it misses within @p maxDistance.
+   */
+  virtual bool castFirstHit(const esp::geo::Ray& ray,
+                            float maxDistance,
+                            RayHitInfo& hit) const;
+
+  /** @brief Whether @ref stageMeshBVH_ is built for the current stage. */
+  bool stageMeshBVHBuilt_ = false;
+
+  /** @brief The stage triangles in world space, for @ref castRay(). */
+  geo::MeshBVH stageMeshBVH_;
+
+  /** @brief The BVHs of the object meshes in their local space, keyed by
+   * asset handle and shared by the objects of a template.
+   */
+  std::map<std::string, std::shared_ptr<const geo::MeshBVH>> meshBVHs_;
+
+  /** @brief The object meshes of the last @ref updateMeshRayCaster(). */
+  std::vector<MeshRayCasterObject> meshRayCasterObjects_;
 
   /** @brief A counter of unique object ID's allocated thus far. Used to
    * allocate new IDs when  @ref recycledObjectIDs_ is empty without needing to
@@ -310,8 +310,12 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
    * @brief Set the rotation and translation of the object.
    */
   virtual void setRigidState(const core::RigidState& rigidState) {
-    setTranslation(rigidState.translation);
-    setRotation(rigidState.rotation);
+    if (objectMotionType_ != MotionType::STATIC) {
+      // sync the simulation once, rather than for each component
+      node().setTranslation(rigidState.translation);
+      node().setRotation(rigidState.rotation);
+      syncPose();
+    }
   };
 
   /**
@@ -498,6 +502,18 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
    */
   virtual double getAngularDamping() const { return 0.0; }
 
+  /** @brief Get the linear speed below which the object may fall asleep. Only
+   * used for dervied dynamic implementations of @ref RigidObject.
+   * @return The linear sleeping threshold of the object.
+   */
+  virtual double getLinearSleepingThreshold() const { return 0.0; }
+
+  /** @brief Get the angular speed below which the object may fall asleep.
+   * Only used for dervied dynamic implementations of @ref RigidObject.
+   * @return The angular sleeping threshold of the object.
+   */
+  virtual double getAngularSleepingThreshold() const { return 0.0; }
+
   /** @brief Get the center of mass (COM) of the object.
    * @return Object 3D center of mass in the global coordinate system.
    * @todo necessary for @ref MotionType::KINEMATIC?
@@ -577,6 +593,17 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
    */
   virtual void setAngularDamping(CORRADE_UNUSED const double angDamping) {}
 
+  /** @brief Set the linear and angular speeds below which the object may fall
+   * asleep. Only used for dervied dynamic implementations of @ref
+   * RigidObject.
+   * @param linThreshold The linear sleeping threshold, in meters per second.
+   * @param angThreshold The angular sleeping threshold, in radians per
+   * second.
+   */
+  virtual void setSleepingThresholds(
+      CORRADE_UNUSED const double linThreshold,
+      CORRADE_UNUSED const double angThreshold) {}
+
   /**
    * @brief Set the @ref esp::scene::SceneNode::semanticId_ for all visual nodes
    * belonging to the object.
@@ -600,7 +627,18 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
     if (!initializationAttributes_) {
       return nullptr;
     }
-    return T::create(*(static_cast<T*>(initializationAttributes_.get())));
+    return T::create(*(static_cast<const T*>(initializationAttributes_.get())));
+  }
+
+  /**
+   * @brief Get the template used to initialize this object or scene, shared
+   * with the library it was registered in instead of copied.
+   * @return The immutable initialization template used to create this object
+   * instance or nullptr if no template exists.
+   */
+  template <class T>
+  std::shared_ptr<const T> getSharedInitializationAttributes() const {
+    return std::static_pointer_cast<const T>(initializationAttributes_);
   }
 
   /** @brief Store whatever object attributes you want here! */
@@ -633,9 +671,10 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
   MotionType objectMotionType_;
 
   /**
-   * @brief Saved attributes when the object was initialized.
+   * @brief Saved attributes when the object was initialized. Shared with the
+   * attributes library, which never modifies a registered template.
    */
-  Attrs::AbstractObjectAttributes::ptr initializationAttributes_ = nullptr;
+  Attrs::AbstractObjectAttributes::cptr initializationAttributes_ = nullptr;
 
   //! Access for the object to its own PhysicsManager id. Scene will keep -1.
   int objectId_ = -1;
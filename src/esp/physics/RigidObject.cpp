@@ -19,11 +19,14 @@ bool RigidObject::initialize(const assets::ResourceManager& resMgr,
     return false;
   }
 
-  // save a copy of the template at initialization time
+  // share the template registered at initialization time, it is replaced
+  // rather than modified when registered again
   initializationAttributes_ =
-      resMgr.getObjectAttributesManager()->getObjectCopyByHandle(handle);
+      resMgr.getObjectAttributesManager()->getObjectSharedByHandle(handle);
 
-  return initialization_LibSpecific(resMgr);
+  const bool success = initialization_LibSpecific(resMgr);
+  initialMotionType_ = objectMotionType_;
+  return success;
 }  // RigidObject::initialize
 
 bool RigidObject::finalizeObject() {
@@ -31,8 +34,7 @@ bool RigidObject::finalizeObject() {
 
   // cast initialization attributes
   Attrs::ObjectAttributes::cptr ObjectAttributes =
-      std::dynamic_pointer_cast<const Attrs::ObjectAttributes>(
-          initializationAttributes_);
+      getSharedInitializationAttributes();
 
   if (!ObjectAttributes->getComputeCOMFromShape()) {
     // will be false if the COM is provided; shift by that COM
@@ -52,6 +54,21 @@ bool RigidObject::finalizeObject() {
   return finalizeObject_LibSpecific();
 }  // RigidObject::finalizeObject
 
+void RigidObject::release() {
+  setMotionType(initialMotionType_);
+  release_LibSpecific();
+}  // RigidObject::release
+
+void RigidObject::reuse(int objectId) {
+  objectId_ = objectId;
+  // the previous object's control may still be referenced
+  velControl_ = VelocityControl::create();
+  resetTransformation();
+  setLinearVelocity(Magnum::Vector3{});
+  setAngularVelocity(Magnum::Vector3{});
+  reuse_LibSpecific();
+}  // RigidObject::reuse
+
 bool RigidObject::initialization_LibSpecific(const assets::ResourceManager&) {
   // default kineamtic unless a simulator is initialized...
   objectMotionType_ = MotionType::KINEMATIC;
@@ -129,6 +129,15 @@ class RigidObject : public RigidBase {
     return RigidBase::getInitializationAttributes<Attrs::ObjectAttributes>();
   };
 
+  /**
+   * @brief Get the template used to initialize this object without copying
+   * it, see @ref RigidBase::getSharedInitializationAttributes().
+   */
+  Attrs::ObjectAttributes::cptr getSharedInitializationAttributes() const {
+    return RigidBase::getSharedInitializationAttributes<
+        Attrs::ObjectAttributes>();
+  };
+
  private:
   /**
    * @brief Finalize the initialization of this @ref RigidScene
@@ -168,6 +177,37 @@ class RigidObject : public RigidBase {
    */
   VelocityControl::ptr getVelocityControl() { return velControl_; };
 
+  /**
+   * @brief Take the object out of the simulated world instead of destroying
+   * it, to be recycled by @ref reuse(). The object gets back the @ref
+   * MotionType it was initialized with.
+   */
+  void release();
+
+  /**
+   * @brief Bring an object taken out by @ref release() back into the world
+   * as a new object, at the origin of its parent node, at rest and with a new
+   * @ref VelocityControl.
+   * @param objectId The id of the new object.
+   */
+  void reuse(int objectId);
+
+ private:
+  /**
+   * @brief any physics-lib-specific code taking the object out of the world
+   * in @ref release().
+   */
+  virtual void release_LibSpecific() {}
+
+  /**
+   * @brief any physics-lib-specific code adding the object back to the world
+   * in @ref reuse().
+   */
+  virtual void reuse_LibSpecific() {}
+
+  //! The @ref MotionType after initialization, restored by @ref release()
+  MotionType initialMotionType_ = MotionType::KINEMATIC;
+
  protected:
   /**
    * @brief Convenience variable: specifies a constant control velocity (linear
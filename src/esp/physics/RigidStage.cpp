@@ -18,7 +18,7 @@ bool RigidStage::initialize(const assets::ResourceManager& resMgr,
   }
   objectMotionType_ = MotionType::STATIC;
   initializationAttributes_ =
-      resMgr.getStageAttributesManager()->getObjectCopyByHandle(handle);
+      resMgr.getStageAttributesManager()->getObjectSharedByHandle(handle);
 
   return initialization_LibSpecific(resMgr);
 }
@@ -41,6 +41,15 @@ class RigidStage : public RigidBase {
   std::shared_ptr<Attrs::StageAttributes> getInitializationAttributes() const {
     return RigidBase::getInitializationAttributes<Attrs::StageAttributes>();
   };
+
+  /**
+   * @brief Get the template used to initialize this stage without copying
+   * it, see @ref RigidBase::getSharedInitializationAttributes().
+   */
+  Attrs::StageAttributes::cptr getSharedInitializationAttributes() const {
+    return RigidBase::getSharedInitializationAttributes<
+        Attrs::StageAttributes>();
+  };
   /**
    * @brief Finalize the creation of this @ref RigidStage
    * @return whether successful finalization.
@@ -63,7 +63,7 @@ struct SimulationContactResultCallback
 
 class BulletBase {
  public:
-  BulletBase(std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+  BulletBase(std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
              std::shared_ptr<std::map<const btCollisionObject*, int>>
                  collisionObjToObjIds)
       : bWorld_(bWorld), collisionObjToObjIds_(collisionObjToObjIds) {}
@@ -94,8 +94,8 @@ class BulletBase {
 
  protected:
   /** @brief A pointer to the Bullet world to which this object belongs. See
-   * @ref btMultiBodyDynamicsWorld.*/
-  std::shared_ptr<btMultiBodyDynamicsWorld> bWorld_;
+   * @ref btDiscreteDynamicsWorld.*/
+  std::shared_ptr<btDiscreteDynamicsWorld> bWorld_;
 
   /** @brief Static data: All components of a @ref RigidObjectType::SCENE are
    * stored here. Also, all objects set to STATIC are stored here.
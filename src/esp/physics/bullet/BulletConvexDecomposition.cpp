@@ -0,0 +1,447 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "BulletConvexDecomposition.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+#include <Magnum/BulletIntegration/Integration.h>
+
+#include "LinearMath/btConvexHullComputer.h"
+
+#include "esp/io/io.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace physics {
+
+namespace {
+//! 'HULL', identifies the files of @ref saveConvexDecomposition()
+constexpr uint32_t ConvexDecompositionMagic = 'H' << 24 | 'U' << 16 |
+                                              'L' << 8 | 'L';
+constexpr uint32_t ConvexDecompositionVersion = 2;
+
+//! candidate split planes per axis of a part
+constexpr int SplitCandidates = 8;
+
+//! the voxels of a mesh and the surface points falling in each
+struct VoxelGrid {
+  std::array<int, 3> dims{};
+  Mn::Vector3 origin;
+  float voxelSize = 0.0f;
+  //! whether each voxel is inside the mesh or on its surface
+  std::vector<char> solid;
+  //! the surface points of each surface voxel furthest along the 8
+  //! diagonals, the rest are inside their hull
+  std::unordered_map<int, std::array<Mn::Vector3, 8>> extremes;
+
+  int index(int x, int y, int z) const {
+    return (z * dims[1] + y) * dims[0] + x;
+  }
+
+  std::array<int, 3> coordinates(int index) const {
+    return {index % dims[0], index / dims[0] % dims[1],
+            index / (dims[0] * dims[1])};
+  }
+
+  void addSurfacePoint(const Mn::Vector3& point) {
+    std::array<int, 3> cell;
+    for (int k = 0; k < 3; ++k) {
+      cell[k] = std::min(
+          std::max(int((point[k] - origin[k]) / voxelSize), 1), dims[k] - 2);
+    }
+    const int i = index(cell[0], cell[1], cell[2]);
+    solid[i] = 1;
+    auto found = extremes.find(i);
+    if (found == extremes.end()) {
+      std::array<Mn::Vector3, 8> points;
+      points.fill(point);
+      extremes.emplace(i, points);
+      return;
+    }
+    for (int d = 0; d < 8; ++d) {
+      const Mn::Vector3 diagonal{d & 1 ? 1.0f : -1.0f, d & 2 ? 1.0f : -1.0f,
+                                 d & 4 ? 1.0f : -1.0f};
+      if (Mn::Math::dot(point, diagonal) >
+          Mn::Math::dot(found->second[d], diagonal)) {
+        found->second[d] = point;
+      }
+    }
+  }
+};
+
+//! a set of solid voxels of the grid
+struct Part {
+  std::vector<int> voxels;
+  std::array<int, 3> min{};
+  std::array<int, 3> max{};
+  float concavity = 0.0f;
+  //! whether the part is too thin to split further
+  bool unsplittable = false;
+};
+
+VoxelGrid voxelize(const std::vector<Mn::Vector3>& positions,
+                   const std::vector<uint32_t>& indices,
+                   int resolution) {
+  Mn::Vector3 min{std::numeric_limits<float>::max()};
+  Mn::Vector3 max{-std::numeric_limits<float>::max()};
+  for (const Mn::Vector3& position : positions) {
+    min = Mn::Math::min(min, position);
+    max = Mn::Math::max(max, position);
+  }
+
+  VoxelGrid grid;
+  grid.voxelSize = (max - min).max() / float(std::max(resolution, 1));
+  // one empty voxel of padding on each side, for the flood fill
+  grid.origin = min - Mn::Vector3{grid.voxelSize};
+  for (int k = 0; k < 3; ++k) {
+    grid.dims[k] =
+        std::max(int(std::ceil((max[k] - min[k]) / grid.voxelSize)), 1) + 2;
+  }
+  grid.solid.assign(std::size_t(grid.dims[0]) * grid.dims[1] * grid.dims[2],
+                    0);
+
+  // sample the triangles densely enough to touch every voxel they cross
+  for (std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+    const Mn::Vector3& a = positions[indices[t]];
+    const Mn::Vector3& b = positions[indices[t + 1]];
+    const Mn::Vector3& c = positions[indices[t + 2]];
+    const float longest =
+        std::max({(b - a).length(), (c - a).length(), (c - b).length()});
+    const int steps =
+        std::max(int(std::ceil(2.0f * longest / grid.voxelSize)), 1);
+    for (int i = 0; i <= steps; ++i) {
+      for (int j = 0; i + j <= steps; ++j) {
+        grid.addSurfacePoint(a + (b - a) * (float(i) / steps) +
+                             (c - a) * (float(j) / steps));
+      }
+    }
+  }
+
+  // the voxels the outside can't reach are inside the mesh
+  std::vector<char> outside(grid.solid.size(), 0);
+  std::vector<int> stack{0};
+  outside[0] = 1;
+  while (!stack.empty()) {
+    const std::array<int, 3> cell = grid.coordinates(stack.back());
+    stack.pop_back();
+    for (int n = 0; n < 6; ++n) {
+      std::array<int, 3> neighbor = cell;
+      neighbor[n / 2] += n % 2 ? 1 : -1;
+      if (neighbor[n / 2] < 0 || neighbor[n / 2] >= grid.dims[n / 2]) {
+        continue;
+      }
+      const int i = grid.index(neighbor[0], neighbor[1], neighbor[2]);
+      if (!outside[i] && !grid.solid[i]) {
+        outside[i] = 1;
+        stack.push_back(i);
+      }
+    }
+  }
+  for (std::size_t i = 0; i < outside.size(); ++i) {
+    if (!outside[i]) {
+      grid.solid[i] = 1;
+    }
+  }
+  return grid;
+}
+
+//! the surface points of a part, or the corners of its voxels if it has none
+btAlignedObjectArray<btVector3> partPoints(const VoxelGrid& grid,
+                                           const Part& part) {
+  btAlignedObjectArray<btVector3> points;
+  for (int voxel : part.voxels) {
+    auto found = grid.extremes.find(voxel);
+    if (found != grid.extremes.end()) {
+      for (const Mn::Vector3& point : found->second) {
+        points.push_back(btVector3(point));
+      }
+    }
+  }
+  if (points.size() == 0) {
+    for (int d = 0; d < 8; ++d) {
+      Mn::Vector3 corner;
+      for (int k = 0; k < 3; ++k) {
+        corner[k] = grid.origin[k] +
+                    grid.voxelSize * float((d >> k & 1) ? part.max[k] + 1
+                                                        : part.min[k]);
+      }
+      points.push_back(btVector3(corner));
+    }
+  }
+  return points;
+}
+
+//! the volume of the hull computed by @p hull, zero for flat hulls
+double hullVolume(const btConvexHullComputer& hull) {
+  if (hull.vertices.size() == 0) {
+    return 0.0;
+  }
+  btVector3 center{0, 0, 0};
+  for (int i = 0; i < hull.vertices.size(); ++i) {
+    center += hull.vertices[i];
+  }
+  center /= btScalar(hull.vertices.size());
+  double volume = 0.0;
+  for (int f = 0; f < hull.faces.size(); ++f) {
+    const btConvexHullComputer::Edge* first = &hull.edges[hull.faces[f]];
+    const btVector3 a = hull.vertices[first->getSourceVertex()] - center;
+    for (const btConvexHullComputer::Edge* edge = first->getNextEdgeOfFace();
+         edge->getNextEdgeOfFace() != first;
+         edge = edge->getNextEdgeOfFace()) {
+      const btVector3 b = hull.vertices[edge->getSourceVertex()] - center;
+      const btVector3 c = hull.vertices[edge->getTargetVertex()] - center;
+      volume += a.dot(b.cross(c)) / 6.0;
+    }
+  }
+  return std::abs(volume);
+}
+
+//! the volume of the hull of a part beyond the part itself
+float concavity(const VoxelGrid& grid, const Part& part) {
+  const btAlignedObjectArray<btVector3> points = partPoints(grid, part);
+  btConvexHullComputer hull;
+  hull.compute(points[0].m_floats, sizeof(btVector3), points.size(), 0.0, 0.0);
+  // the voxels overshoot the surface, which hides concavities smaller than
+  // them
+  const double volume = double(part.voxels.size()) * grid.voxelSize *
+                        grid.voxelSize * grid.voxelSize;
+  return float(std::max(hullVolume(hull) - volume, 0.0));
+}
+
+Part makePart(const VoxelGrid& grid, std::vector<int> voxels) {
+  Part part;
+  part.voxels = std::move(voxels);
+  part.min.fill(std::numeric_limits<int>::max());
+  part.max.fill(std::numeric_limits<int>::min());
+  for (int voxel : part.voxels) {
+    const std::array<int, 3> cell = grid.coordinates(voxel);
+    for (int k = 0; k < 3; ++k) {
+      part.min[k] = std::min(part.min[k], cell[k]);
+      part.max[k] = std::max(part.max[k], cell[k]);
+    }
+  }
+  part.concavity = concavity(grid, part);
+  return part;
+}
+
+/**
+ * @brief Split a part at the candidate plane leaving the least concave halves
+ * @return Whether the part could be split, it can't if it is one voxel thick
+ */
+bool splitPart(const VoxelGrid& grid,
+               const Part& part,
+               Part& first,
+               Part& second) {
+  float best = std::numeric_limits<float>::max();
+  bool found = false;
+  for (int k = 0; k < 3; ++k) {
+    const int extent = part.max[k] - part.min[k];
+    if (extent == 0) {
+      continue;
+    }
+    const int step = std::max(extent / SplitCandidates, 1);
+    for (int plane = part.min[k] + step; plane <= part.max[k]; plane += step) {
+      std::vector<int> below;
+      std::vector<int> above;
+      for (int voxel : part.voxels) {
+        (grid.coordinates(voxel)[k] < plane ? below : above).push_back(voxel);
+      }
+      if (below.empty() || above.empty()) {
+        continue;
+      }
+      Part candidateFirst = makePart(grid, std::move(below));
+      Part candidateSecond = makePart(grid, std::move(above));
+      const float cost = candidateFirst.concavity + candidateSecond.concavity;
+      if (cost < best) {
+        best = cost;
+        first = std::move(candidateFirst);
+        second = std::move(candidateSecond);
+        found = true;
+      }
+    }
+  }
+  return found;
+}
+
+//! keep the @p count vertices of a hull spread the furthest apart
+ConvexHullPoints simplifyHull(const btAlignedObjectArray<btVector3>& vertices,
+                              int count) {
+  ConvexHullPoints points;
+  const int size = vertices.size();
+  if (size <= count) {
+    for (int i = 0; i < size; ++i) {
+      points.emplace_back(vertices[i]);
+    }
+    return points;
+  }
+
+  btVector3 center{0, 0, 0};
+  for (int i = 0; i < size; ++i) {
+    center += vertices[i];
+  }
+  center /= btScalar(size);
+  // start from the vertex furthest from the center, then repeatedly add the
+  // one furthest from all chosen so far
+  std::vector<btScalar> distances(size);
+  for (int i = 0; i < size; ++i) {
+    distances[i] = vertices[i].distance2(center);
+  }
+  for (int chosen = 0; chosen < count; ++chosen) {
+    const int next = int(std::max_element(distances.begin(), distances.end()) -
+                         distances.begin());
+    points.emplace_back(vertices[next]);
+    for (int i = 0; i < size; ++i) {
+      distances[i] =
+          chosen == 0 ? vertices[i].distance2(vertices[next])
+                      : std::min(distances[i],
+                                 vertices[i].distance2(vertices[next]));
+    }
+  }
+  return points;
+}
+
+template <class T>
+void writeValue(std::string& out, const T& value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::ifstream& in, T& value) {
+  return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+}  // namespace
+
+std::vector<ConvexHullPoints> convexDecomposition(
+    const std::vector<Mn::Vector3>& positions,
+    const std::vector<uint32_t>& indices,
+    const ConvexDecompositionSettings& settings) {
+  std::vector<ConvexHullPoints> hulls;
+  if (indices.size() < 3 || settings.maxHulls < 1) {
+    return hulls;
+  }
+
+  const VoxelGrid grid = voxelize(positions, indices, settings.resolution);
+  if (grid.voxelSize <= 0.0f) {
+    // degenerate mesh, all its vertices are at one point
+    hulls.push_back({positions[indices[0]]});
+    return hulls;
+  }
+  std::vector<int> solidVoxels;
+  for (std::size_t i = 0; i < grid.solid.size(); ++i) {
+    if (grid.solid[i]) {
+      solidVoxels.push_back(int(i));
+    }
+  }
+  const float threshold = settings.maxConcavity * float(solidVoxels.size()) *
+                          grid.voxelSize * grid.voxelSize * grid.voxelSize;
+
+  std::vector<Part> parts;
+  parts.push_back(makePart(grid, std::move(solidVoxels)));
+  while (int(parts.size()) < settings.maxHulls) {
+    auto worst = parts.end();
+    for (auto part = parts.begin(); part != parts.end(); ++part) {
+      if (!part->unsplittable &&
+          (worst == parts.end() || part->concavity > worst->concavity)) {
+        worst = part;
+      }
+    }
+    if (worst == parts.end() || worst->concavity <= threshold) {
+      break;
+    }
+    Part first;
+    Part second;
+    if (!splitPart(grid, *worst, first, second)) {
+      worst->unsplittable = true;
+      continue;
+    }
+    *worst = std::move(first);
+    parts.push_back(std::move(second));
+  }
+
+  for (const Part& part : parts) {
+    const btAlignedObjectArray<btVector3> points = partPoints(grid, part);
+    btConvexHullComputer hull;
+    if (points.size() > 3) {
+      hull.compute(points[0].m_floats, sizeof(btVector3), points.size(), 0.0,
+                   0.0);
+    }
+    hulls.push_back(simplifyHull(
+        hull.vertices.size() > 0 ? hull.vertices : points,
+        std::max(settings.maxHullVertices, 4)));
+  }
+  return hulls;
+}
+
+bool saveConvexDecomposition(const std::string& path,
+                             const std::string& assetFile,
+                             const ConvexDecompositionSettings& settings,
+                             const std::vector<ConvexHullPoints>& hulls) {
+  std::string out;
+  writeValue(out, ConvexDecompositionMagic);
+  writeValue(out, ConvexDecompositionVersion);
+  writeValue(out, settings);
+  writeValue(out, uint64_t(io::fileSize(assetFile)));
+  writeValue(out, io::fileModificationTime(assetFile));
+  writeValue(out, uint32_t(hulls.size()));
+  for (const ConvexHullPoints& hull : hulls) {
+    writeValue(out, uint32_t(hull.size()));
+    out.append(reinterpret_cast<const char*>(hull.data()),
+               hull.size() * sizeof(Mn::Vector3));
+  }
+  return io::writeFileAtomically(path, out);
+}
+
+bool loadConvexDecomposition(const std::string& path,
+                             const std::string& assetFile,
+                             const ConvexDecompositionSettings& settings,
+                             std::vector<ConvexHullPoints>& hulls) {
+  std::ifstream in{path, std::ios::binary};
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  ConvexDecompositionSettings savedSettings;
+  uint64_t assetSize = 0;
+  int64_t assetModificationTime = 0;
+  uint32_t numHulls = 0;
+  // an edited asset, or one that is gone, invalidates its decomposition
+  if (!in || !readValue(in, magic) || magic != ConvexDecompositionMagic ||
+      !readValue(in, version) || version != ConvexDecompositionVersion ||
+      !readValue(in, savedSettings) ||
+      savedSettings.maxHulls != settings.maxHulls ||
+      savedSettings.maxHullVertices != settings.maxHullVertices ||
+      savedSettings.resolution != settings.resolution ||
+      savedSettings.maxConcavity != settings.maxConcavity ||
+      !readValue(in, assetSize) || !readValue(in, assetModificationTime) ||
+      !io::exists(assetFile) || assetSize != io::fileSize(assetFile) ||
+      assetModificationTime != io::fileModificationTime(assetFile) ||
+      !readValue(in, numHulls) ||
+      numHulls > uint32_t(std::max(settings.maxHulls, 0))) {
+    return false;
+  }
+
+  std::vector<ConvexHullPoints> loaded(numHulls);
+  for (ConvexHullPoints& hull : loaded) {
+    uint32_t numPoints = 0;
+    if (!readValue(in, numPoints) ||
+        numPoints > uint32_t(std::max(settings.maxHullVertices, 4))) {
+      return false;
+    }
+    hull.resize(numPoints);
+    if (!in.read(reinterpret_cast<char*>(hull.data()),
+                 numPoints * sizeof(Mn::Vector3))) {
+      return false;
+    }
+  }
+  hulls = std::move(loaded);
+  return true;
+}
+
+}  // namespace physics
+}  // namespace esp
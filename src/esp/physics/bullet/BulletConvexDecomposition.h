@@ -0,0 +1,99 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_PHYSICS_BULLET_BULLETCONVEXDECOMPOSITION_H_
+#define ESP_PHYSICS_BULLET_BULLETCONVEXDECOMPOSITION_H_
+
+/** @file
+ * @brief Struct @ref esp::physics::ConvexDecompositionSettings, functions
+ * @ref esp::physics::convexDecomposition(), @ref
+ * esp::physics::saveConvexDecomposition(), @ref
+ * esp::physics::loadConvexDecomposition()
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+namespace esp {
+namespace physics {
+
+/**
+ * @brief Settings of @ref convexDecomposition()
+ */
+struct ConvexDecompositionSettings {
+  /** @brief The maximum number of hulls */
+  int maxHulls = 8;
+
+  /** @brief The maximum number of vertices of each hull */
+  int maxHullVertices = 32;
+
+  /** @brief The number of voxels along the longest side of the mesh bounds */
+  int resolution = 32;
+
+  /**
+   * @brief Parts are split further while the volume of their hull exceeds
+   * their own by more than this fraction of the volume of the mesh
+   */
+  float maxConcavity = 0.01f;
+};
+
+/** @brief The points of a convex hull */
+using ConvexHullPoints = std::vector<Magnum::Vector3>;
+
+/**
+ * @brief Approximate a triangle mesh by a few simplified convex hulls
+ * @param positions The vertex positions
+ * @param indices The indices of the triangles
+ * @param settings The settings of the decomposition
+ *
+ * In the style of V-HACD, the mesh is voxelized and its solid voxels are
+ * recursively split by axis aligned planes, each time splitting the part
+ * whose convex hull is furthest from its voxels at the plane which makes the
+ * two halves the most convex, until there are @ref
+ * ConvexDecompositionSettings::maxHulls "maxHulls" parts or all are convex
+ * enough. The hull of each part is built from points of the mesh surface
+ * inside it and reduced to at most @ref
+ * ConvexDecompositionSettings::maxHullVertices "maxHullVertices" of its
+ * vertices, the ones spread the furthest apart.
+ *
+ * This takes far longer than building a hull, the result is meant to be
+ * computed once per mesh and kept, see @ref saveConvexDecomposition().
+ */
+std::vector<ConvexHullPoints> convexDecomposition(
+    const std::vector<Magnum::Vector3>& positions,
+    const std::vector<uint32_t>& indices,
+    const ConvexDecompositionSettings& settings);
+
+/**
+ * @brief Save a decomposition made by @ref convexDecomposition() with @p
+ * settings of the mesh in @p assetFile
+ * @return Whether the file could be written
+ *
+ * The file is written aside and renamed over @p path, and keeps the size and
+ * modification time of @p assetFile, which @ref loadConvexDecomposition()
+ * compares.
+ */
+bool saveConvexDecomposition(const std::string& path,
+                             const std::string& assetFile,
+                             const ConvexDecompositionSettings& settings,
+                             const std::vector<ConvexHullPoints>& hulls);
+
+/**
+ * @brief Load a decomposition saved by @ref saveConvexDecomposition()
+ * @return Whether the file exists, is valid and was made with @p settings
+ * from @p assetFile as it is now. @p hulls is only changed if it does.
+ */
+bool loadConvexDecomposition(const std::string& path,
+                             const std::string& assetFile,
+                             const ConvexDecompositionSettings& settings,
+                             std::vector<ConvexHullPoints>& hulls);
+
+}  // namespace physics
+}  // namespace esp
+
+#endif  // ESP_PHYSICS_BULLET_BULLETCONVEXDECOMPOSITION_H_
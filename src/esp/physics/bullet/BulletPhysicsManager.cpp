@@ -6,27 +6,280 @@
 //#include "BulletCollision/Gimpact/btGImpactShape.h"
 
 #include "BulletPhysicsManager.h"
+
+#include <algorithm>
+#include <set>
+
+#include <LinearMath/btThreads.h>
+
 #include "BulletRigidObject.h"
 #include "esp/assets/ResourceManager.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/TaskScheduler.h"
 
 namespace esp {
 namespace physics {
 
+namespace {
+
+/**
+ * @brief Tests the broadphase leaves of one ray like btCollisionWorld::rayTest
+ * does, but on a caller owned traversal stack. The stack of
+ * btDbvtBroadphase::rayTest() is shared unless Bullet is built thread-safe.
+ */
+struct FirstHitRayTester : btDbvt::ICollide {
+  FirstHitRayTester(const btVector3& from,
+                    const btVector3& to,
+                    btCollisionWorld::ClosestRayResultCallback& result)
+      : result_{result} {
+    fromTransform_.setIdentity();
+    fromTransform_.setOrigin(from);
+    toTransform_.setIdentity();
+    toTransform_.setOrigin(to);
+
+    const btVector3 direction = (to - from).normalized();
+    for (int i = 0; i < 3; ++i) {
+      directionInverse[i] = direction[i] == btScalar(0.0)
+                                ? btScalar(BT_LARGE_FLOAT)
+                                : btScalar(1.0) / direction[i];
+      signs[i] = directionInverse[i] < 0.0;
+    }
+    lambdaMax = direction.dot(to - from);
+  }
+
+  void Process(const btDbvtNode* leaf) override {
+    const btBroadphaseProxy* proxy =
+        static_cast<const btBroadphaseProxy*>(leaf->data);
+    btCollisionObject* object =
+        static_cast<btCollisionObject*>(proxy->m_clientObject);
+    if (result_.m_closestHitFraction == btScalar(0.0) ||
+        !result_.needsCollision(object->getBroadphaseHandle())) {
+      return;
+    }
+    btCollisionWorld::rayTestSingle(fromTransform_, toTransform_, object,
+                                    object->getCollisionShape(),
+                                    object->getWorldTransform(), result_);
+  }
+
+  btVector3 directionInverse;
+  unsigned int signs[3];
+  btScalar lambdaMax;
+
+ private:
+  btTransform fromTransform_;
+  btTransform toTransform_;
+  btCollisionWorld::ClosestRayResultCallback& result_;
+};
+
+/**
+ * @brief Collects the collision objects touching the tested object of a
+ * btCollisionWorld::contactTest()
+ */
+struct OverlapResultCallback : btCollisionWorld::ContactResultCallback {
+  explicit OverlapResultCallback(const btCollisionObject* tested)
+      : tested_{tested} {}
+
+  btScalar addSingleResult(btManifoldPoint&,
+                           const btCollisionObjectWrapper* colObj0Wrap,
+                           int,
+                           int,
+                           const btCollisionObjectWrapper* colObj1Wrap,
+                           int,
+                           int) override {
+    const btCollisionObject* other = colObj0Wrap->getCollisionObject();
+    if (other == tested_) {
+      other = colObj1Wrap->getCollisionObject();
+    }
+    overlapping.insert(other);
+    return 0;
+  }
+
+  std::set<const btCollisionObject*> overlapping;
+
+ private:
+  const btCollisionObject* tested_;
+};
+
+#if BT_THREADSAFE
+/**
+ * @brief Runs the parallel loops of Bullet on @ref core::TaskScheduler::global,
+ * so that the worlds step on the same threads as the rest of the simulators
+ */
+class SharedTaskScheduler : public btITaskScheduler {
+ public:
+  SharedTaskScheduler()
+      : btITaskScheduler{"habitat"},
+        numThreads_{core::TaskScheduler::global().numThreads()} {}
+
+  int getMaxNumThreads() const override {
+    return core::TaskScheduler::global().numThreads();
+  }
+  int getNumThreads() const override { return numThreads_; }
+  void setNumThreads(int numThreads) override {
+    numThreads_ = std::max(1, std::min(numThreads, getMaxNumThreads()));
+  }
+
+  void parallelFor(int iBegin,
+                   int iEnd,
+                   int grainSize,
+                   const btIParallelForBody& body) override {
+    const int grain = std::max(grainSize, 1);
+    const size_t numChunks = (iEnd - iBegin + grain - 1) / grain;
+    core::TaskScheduler::global().parallelFor(
+        numChunks, numThreads_, [&](size_t chunk, int) {
+          const int begin = iBegin + chunk * grain;
+          body.forLoop(begin, std::min(begin + grain, iEnd));
+        });
+  }
+
+  btScalar parallelSum(int iBegin,
+                       int iEnd,
+                       int grainSize,
+                       const btIParallelSumBody& body) override {
+    core::TaskScheduler& scheduler = core::TaskScheduler::global();
+    const int grain = std::max(grainSize, 1);
+    const size_t numChunks = (iEnd - iBegin + grain - 1) / grain;
+    std::vector<btScalar> sums(scheduler.concurrency(numChunks, numThreads_),
+                               btScalar(0.0));
+    scheduler.parallelFor(numChunks, numThreads_,
+                          [&](size_t chunk, int threadIndex) {
+                            const int begin = iBegin + chunk * grain;
+                            sums[threadIndex] += body.sumLoop(
+                                begin, std::min(begin + grain, iEnd));
+                          });
+    btScalar sum = 0.0;
+    for (btScalar partial : sums) {
+      sum += partial;
+    }
+    return sum;
+  }
+
+ private:
+  int numThreads_;
+};
+#endif
+
+/**
+ * @brief The process-wide Bullet task scheduler called @p name, falling back
+ * to the internal one
+ * @return nullptr if Bullet was built without BT_THREADSAFE
+ */
+btITaskScheduler* getTaskScheduler(const std::string& name) {
+  btITaskScheduler* scheduler = nullptr;
+#if BT_THREADSAFE
+  // Bullet indexes its per-thread data by each thread that ever ran a loop
+  if (name == "habitat" &&
+      core::TaskScheduler::global().numThreads() < BT_MAX_THREAD_COUNT) {
+    static SharedTaskScheduler shared;
+    return &shared;
+  }
+#endif
+  if (name == "openmp") {
+    scheduler = btGetOpenMPTaskScheduler();
+  } else if (name == "tbb") {
+    scheduler = btGetTBBTaskScheduler();
+  } else if (name == "ppl") {
+    scheduler = btGetPPLTaskScheduler();
+  } else if (name != "internal" && name != "habitat") {
+    LOG(WARNING) << "BulletPhysicsManager : unknown task scheduler " << name
+                 << ", using the internal one.";
+  }
+  if (!scheduler) {
+    // Bullet doesn't own the schedulers it creates, so it lives as long as the
+    // process; the others are static already
+    static std::unique_ptr<btITaskScheduler> internal{
+        btCreateDefaultTaskScheduler()};
+    if (internal && name != "internal" && name != "habitat") {
+      LOG(WARNING) << "BulletPhysicsManager : Bullet was built without the "
+                   << name << " task scheduler, using the internal one.";
+    }
+    scheduler = internal.get();
+  }
+  return scheduler;
+}
+
+//! sweep and prune handles, the broadphase preallocates them all
+constexpr unsigned int SweepAndPruneMaxHandles = 32768;
+
+/**
+ * @brief A sweep and prune broadphase, which answers ray tests with a tree of
+ * its proxies, exposed for @ref FirstHitRayTester
+ */
+class SweepAndPruneBroadphase : public bt32BitAxisSweep3 {
+ public:
+  SweepAndPruneBroadphase(const btVector3& worldAabbMin,
+                          const btVector3& worldAabbMax)
+      : bt32BitAxisSweep3{worldAabbMin, worldAabbMax,
+                          SweepAndPruneMaxHandles} {}
+
+  btDbvtBroadphase* raycastTree() const { return m_raycastAccelerator; }
+};
+
+}  // namespace
+
 BulletPhysicsManager::~BulletPhysicsManager() {
   LOG(INFO) << "Deconstructing BulletPhysicsManager";
 
   existingObjects_.clear();
+  objectPool_.clear();
   staticStageObject_.reset(nullptr);
 }
 
 bool BulletPhysicsManager::initPhysicsFinalize() {
   activePhysSimLib_ = BULLET;
+  // a global of Bullet, shared by all worlds in the process
+  gDeactivationTime = physicsManagerAttributes_->getDeactivationTime();
 
   //! We can potentially use other collision checking algorithms, by
   //! uncommenting the line below
-  // btGImpactCollisionAlgorithm::registerAlgorithm(&bDispatcher_);
-  bWorld_ = std::make_shared<btMultiBodyDynamicsWorld>(
-      &bDispatcher_, &bBroadphase_, &bSolver_, &bCollisionConfig_);
+  // btGImpactCollisionAlgorithm::registerAlgorithm(bDispatcher_.get());
+  btDefaultCollisionConstructionInfo collisionInfo;
+  collisionInfo.m_defaultMaxPersistentManifoldPoolSize =
+      physicsManagerAttributes_->getManifoldPoolSize();
+  collisionInfo.m_defaultMaxCollisionAlgorithmPoolSize =
+      physicsManagerAttributes_->getCollisionAlgorithmPoolSize();
+  bCollisionConfig_ =
+      std::make_unique<btDefaultCollisionConfiguration>(collisionInfo);
+  // the sweep and prune needs the bounds of the stage, it replaces this
+  // broadphase once the stage is added
+  auto broadphase = std::make_unique<btDbvtBroadphase>();
+  bRaycastTree_ = broadphase.get();
+  bBroadphase_ = std::move(broadphase);
+
+  const int numThreads = physicsManagerAttributes_->getNumThreads();
+  btITaskScheduler* scheduler =
+      numThreads > 1
+          ? getTaskScheduler(physicsManagerAttributes_->getTaskScheduler())
+          : nullptr;
+  if (numThreads > 1 && !scheduler) {
+    LOG(WARNING) << "BulletPhysicsManager::initPhysicsFinalize : Bullet was "
+                    "built without BT_THREADSAFE, stepping on one thread.";
+  }
+
+  if (scheduler) {
+    // the scheduler is global to Bullet, so shared by all worlds in the
+    // process
+    scheduler->setNumThreads(
+        std::min(numThreads, scheduler->getMaxNumThreads()));
+    btSetTaskScheduler(scheduler);
+    bDispatcher_ =
+        std::make_unique<btCollisionDispatcherMt>(bCollisionConfig_.get());
+    bSolverPool_ = std::make_unique<btConstraintSolverPoolMt>(numThreads);
+    bSolver_ = std::make_unique<btSequentialImpulseConstraintSolverMt>();
+    bWorld_ = std::make_shared<btDiscreteDynamicsWorldMt>(
+        bDispatcher_.get(), bBroadphase_.get(), bSolverPool_.get(),
+        bSolver_.get(), bCollisionConfig_.get());
+  } else {
+    bDispatcher_ =
+        std::make_unique<btCollisionDispatcher>(bCollisionConfig_.get());
+    auto solver = std::make_unique<btMultiBodyConstraintSolver>();
+    bWorld_ = std::make_shared<btMultiBodyDynamicsWorld>(
+        bDispatcher_.get(), bBroadphase_.get(), solver.get(),
+        bCollisionConfig_.get());
+    bSolver_ = std::move(solver);
+  }
+  bWorld_->getSolverInfo().m_numIterations =
+      physicsManagerAttributes_->getSolverIterations();
 
   debugDrawer_.setMode(
       Magnum::BulletIntegration::DebugDraw::Mode::DrawWireframe |
@@ -39,26 +292,108 @@ bool BulletPhysicsManager::initPhysicsFinalize() {
   Corrade::Utility::Debug() << "creating staticStageObject_";
   //! Create new scene node
   staticStageObject_ = physics::BulletRigidStage::create_unique(
-      &physicsNode_->createChild(), bWorld_, collisionObjToObjIds_);
+      &physicsNode_->createChild(), bWorld_, collisionObjToObjIds_,
+      physicsManagerAttributes_->getCacheStageBvh());
   Corrade::Utility::Debug() << "creating staticStageObject_ .. done";
 
   return true;
 }
 
+void BulletPhysicsManager::shareCollisionShapes(const PhysicsManager& source) {
+  const auto* bulletSource =
+      dynamic_cast<const BulletPhysicsManager*>(&source);
+  if (bulletSource == nullptr) {
+    return;
+  }
+  convexHullCache_ = bulletSource->convexHullCache_;
+  static_cast<BulletRigidStage*>(staticStageObject_.get())
+      ->shareShapesFrom(static_cast<const BulletRigidStage&>(
+          *bulletSource->staticStageObject_));
+}
+
 // Bullet Mesh conversion adapted from:
 // https://github.com/mosra/magnum-integration/issues/20
 bool BulletPhysicsManager::addStageFinalize(const std::string& handle) {
   //! Initialize scene
   bool sceneSuccess = staticStageObject_->initialize(resourceManager_, handle);
 
+  const std::string broadphase = physicsManagerAttributes_->getBroadphase();
+  if (sceneSuccess && broadphase == "sweep and prune") {
+    useSweepAndPruneBroadphase();
+  } else if (broadphase != "dbvt" && broadphase != "sweep and prune") {
+    LOG(WARNING) << "BulletPhysicsManager::addStageFinalize : unknown "
+                    "broadphase "
+                 << broadphase << ", using dbvt.";
+  }
+
   return sceneSuccess;
 }
 
+bool BulletPhysicsManager::addStageChunkFinalize(
+    const int chunkId,
+    const std::string& collisionAssetHandle) {
+  static_cast<BulletRigidStage*>(staticStageObject_.get())
+      ->addChunk(chunkId, resourceManager_, collisionAssetHandle);
+  return true;
+}
+
+void BulletPhysicsManager::removeStageChunkFinalize(const int chunkId) {
+  static_cast<BulletRigidStage*>(staticStageObject_.get())
+      ->removeChunk(chunkId);
+}
+
+void BulletPhysicsManager::useSweepAndPruneBroadphase() {
+  const Magnum::Range3D stageAabb = getStageCollisionShapeAabb();
+  if (stageAabb.size().isZero()) {
+    LOG(WARNING) << "BulletPhysicsManager::useSweepAndPruneBroadphase : the "
+                    "stage has no collision bounds, keeping the dbvt "
+                    "broadphase.";
+    return;
+  }
+  const Magnum::Vector3 padding{
+      float(physicsManagerAttributes_->getWorldBoundsPadding())};
+  auto broadphase = std::make_unique<SweepAndPruneBroadphase>(
+      btVector3(stageAabb.min() - padding),
+      btVector3(stageAabb.max() + padding));
+
+  // move the collision objects over, keeping their filters
+  struct Member {
+    btCollisionObject* object;
+    int group;
+    int mask;
+  };
+  std::vector<Member> members;
+  btCollisionObjectArray& objects = bWorld_->getCollisionObjectArray();
+  for (int i = 0; i < objects.size(); ++i) {
+    const btBroadphaseProxy* proxy = objects[i]->getBroadphaseHandle();
+    members.push_back(Member{objects[i], proxy->m_collisionFilterGroup,
+                             proxy->m_collisionFilterMask});
+  }
+  for (const Member& member : members) {
+    bWorld_->removeCollisionObject(member.object);
+  }
+  bRaycastTree_ = broadphase->raycastTree();
+  bWorld_->setBroadphase(broadphase.get());
+  bBroadphase_ = std::move(broadphase);
+  for (const Member& member : members) {
+    if (btRigidBody* body = btRigidBody::upcast(member.object)) {
+      bWorld_->addRigidBody(body, member.group, member.mask);
+    } else {
+      bWorld_->addCollisionObject(member.object, member.group, member.mask);
+    }
+  }
+}
+
 bool BulletPhysicsManager::makeAndAddRigidObject(int newObjectID,
                                                  const std::string& handle,
                                                  scene::SceneNode* objectNode) {
   auto ptr = physics::BulletRigidObject::create_unique(
-      objectNode, newObjectID, bWorld_, collisionObjToObjIds_);
+      objectNode, newObjectID, bWorld_, collisionObjToObjIds_,
+      convexHullCache_);
+  // the template may override them
+  ptr->setSleepingThresholds(
+      physicsManagerAttributes_->getLinearSleepingThreshold(),
+      physicsManagerAttributes_->getAngularSleepingThreshold());
   bool objSuccess = ptr->initialize(resourceManager_, handle);
   if (objSuccess) {
     existingObjects_.emplace(newObjectID, std::move(ptr));
@@ -103,10 +438,8 @@ bool BulletPhysicsManager::isMeshPrimitiveValid(
 void BulletPhysicsManager::setGravity(const Magnum::Vector3& gravity) {
   bWorld_->setGravity(btVector3(gravity));
   // After gravity change, need to reactive all bullet objects
-  for (std::map<int, physics::RigidObject::uptr>::iterator it =
-           existingObjects_.begin();
-       it != existingObjects_.end(); ++it) {
-    it->second->setActive();
+  for (auto& object : existingObjects_) {
+    object.second->setActive();
   }
 }
 
@@ -119,38 +452,39 @@ void BulletPhysicsManager::stepPhysics(double dt) {
   if (!initialized_) {
     return;
   }
+  core::ScopedTimer timer{core::ProfilingStage::Physics};
   if (dt <= 0) {
     dt = fixedTimeStep_;
   }
 
-  // set specified control velocities
-  for (auto& objectItr : existingObjects_) {
-    VelocityControl::ptr velControl = objectItr.second->getVelocityControl();
-    if (objectItr.second->getMotionType() == MotionType::KINEMATIC) {
+  // set specified control velocities, only visiting the objects with an
+  // active control
+  updateVelocityControlledObjects();
+  for (RigidObject* objectPtr : activeVelocityControlledObjects_) {
+    RigidObject& object = *objectPtr;
+    VelocityControl::ptr velControl = object.getVelocityControl();
+    if (object.getMotionType() == MotionType::KINEMATIC) {
       // kinematic velocity control intergration
       if (velControl->controllingAngVel || velControl->controllingLinVel) {
-        objectItr.second->setRigidState(velControl->integrateTransform(
-            dt, objectItr.second->getRigidState()));
-        objectItr.second->setActive();
+        object.setRigidState(
+            velControl->integrateTransform(dt, object.getRigidState()));
+        object.setActive();
       }
-    } else if (objectItr.second->getMotionType() == MotionType::DYNAMIC) {
+    } else if (object.getMotionType() == MotionType::DYNAMIC) {
       if (velControl->controllingLinVel) {
         if (velControl->linVelIsLocal) {
-          setLinearVelocity(objectItr.first,
-                            objectItr.second->node().rotation().transformVector(
-                                velControl->linVel));
+          object.setLinearVelocity(
+              object.node().rotation().transformVector(velControl->linVel));
         } else {
-          setLinearVelocity(objectItr.first, velControl->linVel);
+          object.setLinearVelocity(velControl->linVel);
         }
       }
       if (velControl->controllingAngVel) {
         if (velControl->angVelIsLocal) {
-          setAngularVelocity(
-              objectItr.first,
-              objectItr.second->node().rotation().transformVector(
-                  velControl->angVel));
+          object.setAngularVelocity(
+              object.node().rotation().transformVector(velControl->angVel));
         } else {
-          setAngularVelocity(objectItr.first, velControl->angVel);
+          object.setAngularVelocity(velControl->angVel);
         }
       }
     }
@@ -161,6 +495,26 @@ void BulletPhysicsManager::stepPhysics(double dt) {
   int numSubStepsTaken =
       bWorld_->stepSimulation(dt, /*maxSubSteps*/ 10000, fixedTimeStep_);
   worldTime_ += numSubStepsTaken * fixedTimeStep_;
+  updateActiveObjectIds();
+}
+
+void BulletPhysicsManager::updateActiveObjectIds() {
+  activeObjectIds_.clear();
+  // the stage and the STATIC objects are not in there, and only the active
+  // bodies are looked up, so settled objects cost a flag check
+  btAlignedObjectArray<btRigidBody*>& bodies =
+      bWorld_->getNonStaticRigidBodies();
+  for (int i = 0; i < bodies.size(); ++i) {
+    if (!bodies[i]->isActive()) {
+      continue;
+    }
+    auto objectId = collisionObjToObjIds_->find(bodies[i]);
+    if (objectId != collisionObjToObjIds_->end() &&
+        existingObjects_.count(objectId->second)) {
+      activeObjectIds_.push_back(objectId->second);
+    }
+  }
+  std::sort(activeObjectIds_.begin(), activeObjectIds_.end());
 }
 
 void BulletPhysicsManager::setMargin(const int physObjectID,
@@ -257,6 +611,73 @@ RaycastResults BulletPhysicsManager::castRay(const esp::geo::Ray& ray,
   return results;
 }
 
+void BulletPhysicsManager::castRays(const std::vector<esp::geo::Ray>& rays,
+                                    BatchRaycastResults& results,
+                                    double maxDistance,
+                                    int numThreads) {
+  results.reset(rays.size());
+  auto castRange = [&](size_t begin, size_t end) {
+    btAlignedObjectArray<const btDbvtNode*> stack;
+    for (size_t i = begin; i < end; ++i) {
+      const esp::geo::Ray& ray = rays[i];
+      const double rayLength = ray.direction.length();
+      if (rayLength == 0) {
+        continue;
+      }
+      const btVector3 from(ray.origin);
+      const btVector3 to(ray.origin + ray.direction * maxDistance);
+
+      btCollisionWorld::ClosestRayResultCallback closest(from, to);
+      FirstHitRayTester tester(from, to, closest);
+      const btVector3 zero{0, 0, 0};
+      for (const btDbvt& tree : bRaycastTree_->m_sets) {
+        tree.rayTestInternal(tree.m_root, from, to, tester.directionInverse,
+                             tester.signs, tester.lambdaMax, zero, zero, stack,
+                             tester);
+      }
+      if (!closest.hasHit()) {
+        continue;
+      }
+
+      results.hasHit[i] = 1;
+      results.points[i] = Magnum::Vector3{closest.m_hitPointWorld};
+      results.normals[i] = Magnum::Vector3{closest.m_hitNormalWorld};
+      results.rayDistances[i] =
+          (closest.m_closestHitFraction * maxDistance) / rayLength;
+      auto objectId = collisionObjToObjIds_->find(closest.m_collisionObject);
+      if (objectId != collisionObjToObjIds_->end()) {
+        results.objectIds[i] = objectId->second;
+      }
+    }
+  };
+
+  core::TaskScheduler::global().parallelForRanges(rays.size(), numThreads,
+                                                  castRange);
+}
+
+std::vector<int> BulletPhysicsManager::boxOverlapTest(
+    const Magnum::Vector3& center,
+    const Magnum::Vector3& halfExtents) {
+  btBoxShape shape{btVector3(halfExtents)};
+  btCollisionObject box;
+  box.setCollisionShape(&shape);
+  box.getWorldTransform().setOrigin(btVector3(center));
+
+  OverlapResultCallback overlaps{&box};
+  bWorld_->contactTest(&box, overlaps);
+  std::vector<int> objectIds;
+  for (const btCollisionObject* object : overlaps.overlapping) {
+    auto objectId = collisionObjToObjIds_->find(object);
+    objectIds.push_back(objectId != collisionObjToObjIds_->end()
+                            ? objectId->second
+                            : -1);
+  }
+  std::sort(objectIds.begin(), objectIds.end());
+  objectIds.erase(std::unique(objectIds.begin(), objectIds.end()),
+                  objectIds.end());
+  return objectIds;
+}
+
 int BulletPhysicsManager::getNumActiveContactPoints() {
   int pointCount = 0;
   auto* dispatcher = bWorld_->getDispatcher();
@@ -277,5 +698,33 @@ int BulletPhysicsManager::getNumActiveContactPoints() {
   return pointCount;
 }
 
+void BulletPhysicsManager::getContactPoints(ContactPointResults& results) {
+  results.clear();
+  auto objectIdOf = [&](const btCollisionObject* collisionObject) {
+    auto objectId = collisionObjToObjIds_->find(collisionObject);
+    return objectId != collisionObjToObjIds_->end() ? objectId->second
+                                                    : ID_UNDEFINED;
+  };
+
+  auto* dispatcher = bWorld_->getDispatcher();
+  for (int i = 0; i < dispatcher->getNumManifolds(); i++) {
+    const btPersistentManifold* manifold =
+        dispatcher->getManifoldByIndexInternal(i);
+    if (manifold->getNumContacts() == 0) {
+      continue;
+    }
+    const int objectIdA = objectIdOf(manifold->getBody0());
+    const int objectIdB = objectIdOf(manifold->getBody1());
+    for (int j = 0; j < manifold->getNumContacts(); j++) {
+      const btManifoldPoint& point = manifold->getContactPoint(j);
+      results.objectIdsA.push_back(objectIdA);
+      results.objectIdsB.push_back(objectIdB);
+      results.points.emplace_back(point.getPositionWorldOnB());
+      results.normals.emplace_back(point.m_normalWorldOnB);
+      results.impulses.push_back(point.getAppliedImpulse());
+    }
+  }
+}
+
 }  // namespace physics
 }  // namespace esp
@@ -15,6 +15,9 @@
 #include <Magnum/BulletIntegration/MotionState.h>
 #include <btBulletDynamicsCommon.h>
 
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
 #include "BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h"
 #include "BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h"
 
@@ -30,7 +33,9 @@ namespace physics {
 @brief Dynamic stage and object manager interfacing with Bullet physics
 engine: https://github.com/bulletphysics/bullet3.
 
-See @ref btMultiBodyDynamicsWorld.
+See @ref btMultiBodyDynamicsWorld, or @ref btDiscreteDynamicsWorldMt if
+@ref metadata::attributes::PhysicsManagerAttributes::getNumThreads() is more
+than 1.
 
 Enables @ref RigidObject simulation with @ref MotionType::DYNAMIC.
 
@@ -55,6 +60,7 @@ class BulletPhysicsManager : public PhysicsManager {
       : PhysicsManager(_resourceManager, _physicsManagerAttributes) {
     collisionObjToObjIds_ =
         std::make_shared<std::map<const btCollisionObject*, int>>();
+    convexHullCache_ = std::make_shared<BulletConvexHullCache>();
   };
 
   /** @brief Destructor which destructs necessary Bullet physics structures.*/
@@ -64,7 +70,7 @@ class BulletPhysicsManager : public PhysicsManager {
 
   /** @brief Step the physical world forward in time. Time may only advance in
    * increments of @ref fixedTimeStep_. See @ref
-   * btMultiBodyDynamicsWorld::stepSimulation.
+   * btDiscreteDynamicsWorld::stepSimulation.
    * @param dt The desired amount of time to advance the physical world.
    */
   void stepPhysics(double dt) override;
@@ -183,6 +189,38 @@ class BulletPhysicsManager : public PhysicsManager {
   virtual RaycastResults castRay(const esp::geo::Ray& ray,
                                  double maxDistance = 100.0) override;
 
+  /**
+   * @brief Cast a batch of rays into the collision world and write the first
+   * hit of each into @p results, see @ref BatchRaycastResults.
+   *
+   * The rays are split between the threads, each traversing the broadphase
+   * with its own stack. The collision world is only read, so it must not be
+   * modified until this returns.
+   *
+   * @param rays The rays to cast. Need not be unit length, but hit distances
+   * will be in units of ray length. Zero length rays miss.
+   * @param[out] results The first hits, resized to the number of rays.
+   * @param maxDistance The maximum distance along the ray direction to search.
+   * In units of ray length.
+   * @param numThreads The number of threads to cast on, 0 for all hardware
+   * threads.
+   */
+  void castRays(const std::vector<esp::geo::Ray>& rays,
+                BatchRaycastResults& results,
+                double maxDistance = 100.0,
+                int numThreads = 0) override;
+
+  /**
+   * @brief Find the stage and the objects overlapping an axis aligned box,
+   * with a contact test of a temporary box collision object.
+   *
+   * @param center The world space center of the box.
+   * @param halfExtents The half extents of the box.
+   * @return The sorted IDs of the overlapping objects, -1 for the stage.
+   */
+  std::vector<int> boxOverlapTest(const Magnum::Vector3& center,
+                                  const Magnum::Vector3& halfExtents) override;
+
   // The number of contact points that were active during the last step. An
   // object resting on another object will involve several active contact
   // points. Once both objects are asleep, the contact points are inactive. This
@@ -190,6 +228,19 @@ class BulletPhysicsManager : public PhysicsManager {
   // in the current scene.
   int getNumActiveContactPoints() override;
 
+  /**
+   * @brief Get all contact points of the manifolds of the last step. See
+   * @ref PhysicsManager::getContactPoints.
+   */
+  void getContactPoints(ContactPointResults& results) override;
+
+  /**
+   * @brief Share the convex hulls of the objects and the mesh shapes of the
+   * stage built by a @ref BulletPhysicsManager @p source. See @ref
+   * PhysicsManager::shareCollisionShapes.
+   */
+  void shareCollisionShapes(const PhysicsManager& source) override;
+
  protected:
   //============ Initialization =============
   /**
@@ -210,6 +261,18 @@ class BulletPhysicsManager : public PhysicsManager {
    */
   bool addStageFinalize(const std::string& handle) override;
 
+  /**
+   * @brief Add the collision meshes of a chunk as static collision objects
+   * of the stage, see @ref BulletRigidStage::addChunk().
+   */
+  bool addStageChunkFinalize(int chunkId,
+                             const std::string& collisionAssetHandle) override;
+
+  /**
+   * @brief Remove the collision objects of a chunk from the world.
+   */
+  void removeStageChunkFinalize(int chunkId) override;
+
   /** @brief Create and initialize an @ref RigidObject and add
    * it to existingObjects_ map keyed with newObjectID
    * @param newObjectID valid object ID for the new object
@@ -224,14 +287,29 @@ class BulletPhysicsManager : public PhysicsManager {
                              const std::string& handle,
                              scene::SceneNode* objectNode) override;
 
-  btDbvtBroadphase bBroadphase_;
-  btDefaultCollisionConfiguration bCollisionConfig_;
-
-  btMultiBodyConstraintSolver bSolver_;
-  btCollisionDispatcher bDispatcher_{&bCollisionConfig_};
-
-  /** @brief A pointer to the Bullet world. See @ref btMultiBodyDynamicsWorld.*/
-  std::shared_ptr<btMultiBodyDynamicsWorld> bWorld_;
+  /** @brief Refresh @ref activeObjectIds_ after a step from the bodies Bullet
+   * can move, without visiting the STATIC objects.
+   */
+  void updateActiveObjectIds();
+
+  //! the broadphase of the world, a @ref btDbvtBroadphase or a sweep and
+  //! prune over the stage bounds, see @ref useSweepAndPruneBroadphase()
+  std::unique_ptr<btBroadphaseInterface> bBroadphase_;
+  //! the tree of the broadphase answering ray tests, see @ref castRays()
+  btDbvtBroadphase* bRaycastTree_ = nullptr;
+  //! sized by the pools of the
+  //! @ref metadata::attributes::PhysicsManagerAttributes
+  std::unique_ptr<btDefaultCollisionConfiguration> bCollisionConfig_;
+
+  //! a @ref btCollisionDispatcherMt for a multi-threaded world
+  std::unique_ptr<btCollisionDispatcher> bDispatcher_;
+  //! a pool of solvers for a multi-threaded world, nullptr otherwise
+  std::unique_ptr<btConstraintSolverPoolMt> bSolverPool_;
+  std::unique_ptr<btConstraintSolver> bSolver_;
+
+  /** @brief A pointer to the Bullet world. See @ref btMultiBodyDynamicsWorld
+   * and @ref btDiscreteDynamicsWorldMt.*/
+  std::shared_ptr<btDiscreteDynamicsWorld> bWorld_;
 
   mutable Magnum::BulletIntegration::DebugDraw debugDrawer_;
 
@@ -240,7 +318,19 @@ class BulletPhysicsManager : public PhysicsManager {
   std::shared_ptr<std::map<const btCollisionObject*, int>>
       collisionObjToObjIds_;
 
+  //! convex hulls of the collision meshes, built once and shared by all
+  //! objects instanced from the same template
+  std::shared_ptr<BulletConvexHullCache> convexHullCache_;
+
  private:
+  /** @brief Replace the broadphase of the world by a sweep and prune over
+   * the collision AABB of the stage, padded by @ref
+   * metadata::attributes::PhysicsManagerAttributes::getWorldBoundsPadding().
+   * The collision objects already in the world are moved over with their
+   * filters.
+   */
+  void useSweepAndPruneBroadphase();
+
   /** @brief Check if a particular mesh can be used as a collision mesh for
    * Bullet.
    * @param meshData The mesh to validate. Only a triangle mesh is valid. Checks
@@ -11,7 +11,9 @@
 #include "BulletCollision/CollisionShapes/btConvexTriangleMeshShape.h"
 #include "BulletCollision/Gimpact/btGImpactShape.h"
 #include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
+#include "BulletConvexDecomposition.h"
 #include "BulletRigidObject.h"
+#include "LinearMath/btConvexHullComputer.h"
 
 //!  A Few considerations in construction
 //!  Bullet Mesh conversion adapted from:
@@ -29,17 +31,77 @@
 namespace esp {
 namespace physics {
 
+namespace {
+
+/**
+ * @brief Build a hull of only the points on the convex hull of @p points,
+ * which are all kept if the hull can't be computed (e.g. for flat meshes).
+ */
+std::shared_ptr<btConvexHullShape> makeConvexHull(
+    const btAlignedObjectArray<btVector3>& points) {
+  auto hull = std::make_shared<btConvexHullShape>();
+  btConvexHullComputer hullComputer;
+  if (points.size() > 3) {
+    hullComputer.compute(points[0].m_floats, sizeof(btVector3), points.size(),
+                         0.0, 0.0);
+  }
+  const btAlignedObjectArray<btVector3>& hullPoints =
+      hullComputer.vertices.size() > 0 ? hullComputer.vertices : points;
+  for (int i = 0; i < hullPoints.size(); ++i) {
+    hull->addPoint(hullPoints[i], false);
+  }
+  hull->setMargin(0.0);
+  hull->recalcLocalAabb();
+  return hull;
+}
+
+/**
+ * @brief Gather the triangles of all meshes under @p node into a single mesh,
+ * in the frame of the object
+ */
+void joinCollisionMeshTriangles(
+    const Magnum::Matrix4& transformFromParentToWorld,
+    const std::vector<assets::CollisionMeshData>& meshGroup,
+    const assets::MeshTransformNode& node,
+    std::vector<Magnum::Vector3>& positions,
+    std::vector<uint32_t>& indices) {
+  const Magnum::Matrix4 transformFromLocalToWorld =
+      transformFromParentToWorld * node.transformFromLocalToParent;
+  if (node.meshIDLocal != ID_UNDEFINED) {
+    const assets::CollisionMeshData& mesh = meshGroup[node.meshIDLocal];
+    const uint32_t offset = positions.size();
+    for (const Magnum::Vector3& position : mesh.positions) {
+      positions.push_back(transformFromLocalToWorld.transformPoint(position));
+    }
+    for (const Magnum::UnsignedInt index : mesh.indices) {
+      indices.push_back(offset + index);
+    }
+  }
+  for (const auto& child : node.children) {
+    joinCollisionMeshTriangles(transformFromLocalToWorld, meshGroup, child,
+                               positions, indices);
+  }
+}
+
+}  // namespace
+
 BulletRigidObject::BulletRigidObject(
     scene::SceneNode* rigidBodyNode,
     int objectId,
-    std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+    std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
     std::shared_ptr<std::map<const btCollisionObject*, int> >
-        collisionObjToObjIds)
+        collisionObjToObjIds,
+    std::shared_ptr<BulletConvexHullCache> convexHullCache)
     : BulletBase(bWorld, collisionObjToObjIds),
       RigidObject(rigidBodyNode, objectId),
-      MotionState(*rigidBodyNode) {}
+      MotionState(*rigidBodyNode),
+      convexHullCache_(std::move(convexHullCache)) {}
 
 BulletRigidObject::~BulletRigidObject() {
+  if (released_) {
+    // not in the world anymore, see release_LibSpecific()
+    return;
+  }
   if (!isActive()) {
     // This object may be supporting other sleeping objects, so wake them before
     // removing.
@@ -64,12 +126,19 @@ bool BulletRigidObject::initialization_LibSpecific(
     const assets::ResourceManager& resMgr) {
   objectMotionType_ = MotionType::DYNAMIC;
   // get this object's creation template, appropriately cast
-  auto tmpAttr = getInitializationAttributes();
+  auto tmpAttr = getSharedInitializationAttributes();
 
   //! Physical parameters
   double margin = tmpAttr->getMargin();
   bool joinCollisionMeshes = tmpAttr->getJoinCollisionMeshes();
   usingBBCollisionShape_ = tmpAttr->getBoundingBoxCollisions();
+  // negative thresholds keep the ones of the physics manager
+  if (tmpAttr->getLinearSleepingThreshold() >= 0) {
+    linearSleepingThreshold_ = tmpAttr->getLinearSleepingThreshold();
+  }
+  if (tmpAttr->getAngularSleepingThreshold() >= 0) {
+    angularSleepingThreshold_ = tmpAttr->getAngularSleepingThreshold();
+  }
 
   // TODO(alexanderwclegg): should provide the option for joinCollisionMeshes
   // and collisionFromBB_ to specify complete vs. component level bounding box
@@ -108,17 +177,65 @@ bool BulletRigidObject::initialization_LibSpecific(
         resMgr.getMeshMetaData(collisionAssetHandle);
 
     if (!usingBBCollisionShape_) {
-      constructBulletCompoundFromMeshes(Magnum::Matrix4{}, meshGroup,
-                                        metaData.root, joinCollisionMeshes);
-
-      // add the final object after joining meshes
-      if (joinCollisionMeshes) {
-        bObjectConvexShapes_.back()->setLocalScaling(
-            btVector3(tmpAttr->getCollisionAssetSize()));
-        bObjectConvexShapes_.back()->setMargin(0.0);
-        bObjectConvexShapes_.back()->recalcLocalAabb();
-        bObjectShape_->addChildShape(btTransform::getIdentity(),
-                                     bObjectConvexShapes_.back().get());
+      // the joined hull is scaled by the collision asset size, so templates
+      // differing only in it can't share that hull. The hulls are scaled by
+      // the object scale too: btCompoundShape::setLocalScaling() would
+      // rescale the shared children in place.
+      const Magnum::Vector3 scale = tmpAttr->getScale();
+      BulletConvexHullKey cacheKey;
+      cacheKey.collisionAssetHandle = collisionAssetHandle;
+      cacheKey.scale = {scale.x(), scale.y(), scale.z()};
+      const int maxConvexHulls = tmpAttr->getMaxConvexHulls();
+      if (maxConvexHulls > 0) {
+        cacheKey.maxConvexHulls = maxConvexHulls;
+        cacheKey.maxHullVertices = tmpAttr->getMaxHullVertices();
+      } else {
+        cacheKey.joined = joinCollisionMeshes;
+      }
+      if (maxConvexHulls > 0 || joinCollisionMeshes) {
+        const Magnum::Vector3 assetSize = tmpAttr->getCollisionAssetSize();
+        cacheKey.collisionAssetSize = {assetSize.x(), assetSize.y(),
+                                       assetSize.z()};
+      }
+
+      auto cachedHulls = convexHullCache_->find(cacheKey);
+      if (cachedHulls == convexHullCache_->end()) {
+        auto hulls = std::make_shared<BulletConvexHulls>();
+        if (maxConvexHulls > 0) {
+          constructBulletConvexDecomposition(meshGroup, metaData.root, *hulls);
+        } else {
+          constructBulletCompoundFromMeshes(Magnum::Matrix4{}, meshGroup,
+                                            metaData.root, joinCollisionMeshes,
+                                            *hulls);
+        }
+
+        // reduce the joined points to their hull once all meshes were added
+        if (maxConvexHulls <= 0 && joinCollisionMeshes &&
+            !hulls->hulls.empty()) {
+          std::shared_ptr<btConvexHullShape>& joined =
+              hulls->hulls.back().second;
+          btAlignedObjectArray<btVector3> points;
+          points.resize(joined->getNumPoints());
+          for (int i = 0; i < joined->getNumPoints(); ++i) {
+            points[i] = joined->getUnscaledPoints()[i];
+          }
+          joined = makeConvexHull(points);
+          joined->setLocalScaling(btVector3(tmpAttr->getCollisionAssetSize()));
+        }
+        // as btCompoundShape::setLocalScaling() does, once per cached hull
+        for (auto& hull : hulls->hulls) {
+          hull.first.translation() *= scale;
+          hull.second->setLocalScaling(hull.second->getLocalScaling() *
+                                       btVector3(scale));
+          hull.second->recalcLocalAabb();
+        }
+        cachedHulls = convexHullCache_->emplace(cacheKey, hulls).first;
+      }
+
+      for (const auto& hull : cachedHulls->second->hulls) {
+        bObjectConvexShapes_.push_back(hull.second);
+        bObjectShape_->addChildShape(btTransform{hull.first},
+                                     hull.second.get());
       }
     }
   }  // if using prim collider else use mesh collider
@@ -126,7 +243,10 @@ bool BulletRigidObject::initialization_LibSpecific(
   //! Set properties
   bObjectShape_->setMargin(margin);
 
-  bObjectShape_->setLocalScaling(btVector3{tmpAttr->getScale()});
+  // the shared hulls of mesh colliders are scaled already
+  if (bObjectConvexShapes_.empty()) {
+    bObjectShape_->setLocalScaling(btVector3{tmpAttr->getScale()});
+  }
 
   // create the bObjectRigidBody_
   constructRigidBody(false);
@@ -136,6 +256,22 @@ bool BulletRigidObject::initialization_LibSpecific(
   return true;
 }  // initialization_LibSpecific
 
+void BulletRigidObject::release_LibSpecific() {
+  // release() restored the initial motion type, so the object is not static
+  activateCollisionIsland();
+  bWorld_->removeRigidBody(bObjectRigidBody_.get());
+  collisionObjToObjIds_->erase(bObjectRigidBody_.get());
+  released_ = true;
+}  // release_LibSpecific
+
+void BulletRigidObject::reuse_LibSpecific() {
+  bObjectRigidBody_->clearForces();
+  collisionObjToObjIds_->emplace(bObjectRigidBody_.get(), objectId_);
+  bWorld_->addRigidBody(bObjectRigidBody_.get());
+  released_ = false;
+  setActive();
+}  // reuse_LibSpecific
+
 bool BulletRigidObject::finalizeObject_LibSpecific() {
   if (usingBBCollisionShape_) {
     setCollisionFromBB();
@@ -216,7 +352,8 @@ void BulletRigidObject::constructBulletCompoundFromMeshes(
     const Magnum::Matrix4& transformFromParentToWorld,
     const std::vector<assets::CollisionMeshData>& meshGroup,
     const assets::MeshTransformNode& node,
-    bool join) {
+    bool join,
+    BulletConvexHulls& hulls) {
   Magnum::Matrix4 transformFromLocalToWorld =
       transformFromParentToWorld * node.transformFromLocalToParent;
   if (node.meshIDLocal != ID_UNDEFINED) {
@@ -227,35 +364,100 @@ void BulletRigidObject::constructBulletCompoundFromMeshes(
     if (join) {
       // add all points to a single convex instead of compounding (more
       // stable)
-      if (bObjectConvexShapes_.empty()) {
+      if (hulls.hulls.empty()) {
         // create the convex if it does not exist
-        bObjectConvexShapes_.emplace_back(
-            std::make_unique<btConvexHullShape>());
+        hulls.hulls.emplace_back(Magnum::Matrix4{},
+                                 std::make_shared<btConvexHullShape>());
       }
 
       // add points
       for (auto& v : mesh.positions) {
-        bObjectConvexShapes_.back()->addPoint(
+        hulls.hulls.back().second->addPoint(
             btVector3(transformFromLocalToWorld.transformPoint(v)), false);
       }
     } else {
-      bObjectConvexShapes_.emplace_back(std::make_unique<btConvexHullShape>(
-          static_cast<const btScalar*>(mesh.positions.data()->data()),
-          mesh.positions.size(), sizeof(Magnum::Vector3)));
-      bObjectConvexShapes_.back()->setMargin(0.0);
-      bObjectConvexShapes_.back()->recalcLocalAabb();
-      //! Add to compound shape stucture
-      bObjectShape_->addChildShape(btTransform{transformFromLocalToWorld},
-                                   bObjectConvexShapes_.back().get());
+      btAlignedObjectArray<btVector3> points;
+      points.resize(mesh.positions.size());
+      for (std::size_t i = 0; i < mesh.positions.size(); ++i) {
+        points[i] = btVector3(mesh.positions[i]);
+      }
+      //! Added to the compound shape stucture by the caller
+      hulls.hulls.emplace_back(transformFromLocalToWorld,
+                               makeConvexHull(points));
     }
   }
 
   for (auto& child : node.children) {
     constructBulletCompoundFromMeshes(transformFromLocalToWorld, meshGroup,
-                                      child, join);
+                                      child, join, hulls);
   }
 }  // constructBulletCompoundFromMeshes
 
+void BulletRigidObject::constructBulletConvexDecomposition(
+    const std::vector<assets::CollisionMeshData>& meshGroup,
+    const assets::MeshTransformNode& root,
+    BulletConvexHulls& hulls) {
+  auto tmpAttr = getSharedInitializationAttributes();
+  ConvexDecompositionSettings settings;
+  settings.maxHulls = tmpAttr->getMaxConvexHulls();
+  settings.maxHullVertices = tmpAttr->getMaxHullVertices();
+  const std::string hullsFile =
+      tmpAttr->getConvexHullsHandle().empty()
+          ? tmpAttr->getCollisionAssetHandle() + ".hulls"
+          : tmpAttr->getConvexHullsHandle();
+
+  // the decomposition takes long, so it is only made if it wasn't saved yet
+  const std::string& assetFile = tmpAttr->getCollisionAssetHandle();
+  std::vector<ConvexHullPoints> decomposition;
+  if (!loadConvexDecomposition(hullsFile, assetFile, settings,
+                               decomposition)) {
+    std::vector<Magnum::Vector3> positions;
+    std::vector<uint32_t> indices;
+    joinCollisionMeshTriangles(Magnum::Matrix4{}, meshGroup, root, positions,
+                               indices);
+    decomposition = convexDecomposition(positions, indices, settings);
+    if (!saveConvexDecomposition(hullsFile, assetFile, settings,
+                                 decomposition)) {
+      LOG(WARNING) << "BulletRigidObject::constructBulletConvexDecomposition "
+                      ": Could not cache the convex decomposition of "
+                   << assetFile << " in " << hullsFile;
+    }
+  }
+
+  for (const ConvexHullPoints& hullPoints : decomposition) {
+    btAlignedObjectArray<btVector3> points;
+    points.resize(hullPoints.size());
+    for (std::size_t i = 0; i < hullPoints.size(); ++i) {
+      points[i] = btVector3(hullPoints[i]);
+    }
+    std::shared_ptr<btConvexHullShape> hull = makeConvexHull(points);
+    hull->setLocalScaling(btVector3(tmpAttr->getCollisionAssetSize()));
+    hull->recalcLocalAabb();
+    hulls.hulls.emplace_back(Magnum::Matrix4{}, std::move(hull));
+  }
+}  // constructBulletConvexDecomposition
+
+void BulletRigidObject::setMargin(const double margin) {
+  for (auto& convexShape : bObjectConvexShapes_) {
+    if (convexShape.use_count() > 1) {
+      // shared with the cache, so swap in a copy before modifying it
+      auto copy = std::make_shared<btConvexHullShape>(
+          &convexShape->getUnscaledPoints()->getX(),
+          convexShape->getNumPoints(), sizeof(btVector3));
+      copy->setLocalScaling(convexShape->getLocalScaling());
+      btCompoundShapeChild* children = bObjectShape_->getChildList();
+      for (int i = 0; i < bObjectShape_->getNumChildShapes(); ++i) {
+        if (children[i].m_childShape == convexShape.get()) {
+          children[i].m_childShape = copy.get();
+        }
+      }
+      convexShape = std::move(copy);
+    }
+    convexShape->setMargin(margin);
+  }
+  bObjectShape_->setMargin(margin);
+}  // setMargin
+
 void BulletRigidObject::setCollisionFromBB() {
   btVector3 dim(node().getCumulativeBB().size() / 2.0);
 
@@ -269,7 +471,7 @@ void BulletRigidObject::setCollisionFromBB() {
   bObjectShape_->recalculateLocalAabb();
   bObjectRigidBody_->setCollisionShape(bObjectShape_.get());
 
-  auto tmpAttr = getInitializationAttributes();
+  auto tmpAttr = getSharedInitializationAttributes();
   btVector3 bInertia(tmpAttr->getInertia());
   if (bInertia == btVector3{0, 0, 0}) {
     // allow bullet to compute the inertia tensor if we don't have one
@@ -363,7 +565,7 @@ void BulletRigidObject::syncPose() {
 
 void BulletRigidObject::constructRigidBody(bool kinematic) {
   // get this object's creation template, appropriately cast
-  auto tmpAttr = getInitializationAttributes();
+  auto tmpAttr = getSharedInitializationAttributes();
 
   double mass = 0;
   btVector3 bInertia = {0, 0, 0};
@@ -386,6 +588,8 @@ void BulletRigidObject::constructRigidBody(bool kinematic) {
   info.m_restitution = tmpAttr->getRestitutionCoefficient();
   info.m_linearDamping = tmpAttr->getLinearDamping();
   info.m_angularDamping = tmpAttr->getAngularDamping();
+  info.m_linearSleepingThreshold = linearSleepingThreshold_;
+  info.m_angularSleepingThreshold = angularSleepingThreshold_;
 
   //! Create rigid body
   if (collisionObjToObjIds_->count(bObjectRigidBody_.get())) {
@@ -6,10 +6,19 @@
 #define ESP_PHYSICS_BULLET_BULLETRIGIDOBJECT_H_
 
 /** @file
- * @brief Struct SimulationContactResultCallback, class @ref
- * esp::physics::BulletRigidObject
+ * @brief Struct SimulationContactResultCallback, struct @ref
+ * esp::physics::BulletConvexHulls, @ref esp::physics::BulletConvexHullKey,
+ * class @ref esp::physics::BulletRigidObject
  */
 
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include <Magnum/BulletIntegration/DebugDraw.h>
 #include <Magnum/BulletIntegration/Integration.h>
 
@@ -26,6 +35,49 @@
 namespace esp {
 namespace physics {
 
+/**
+ * @brief The convex hulls built from the collision meshes of an object
+ * template, shared by all objects instanced from it.
+ *
+ * The hulls are immutable while shared, an object changing them must replace
+ * its references with its own copies first. See @ref
+ * BulletRigidObject::setMargin.
+ */
+struct BulletConvexHulls {
+  //! the hulls and their transformations in the local space of the object,
+  //! scaled by the object scale
+  std::vector<std::pair<Magnum::Matrix4, std::shared_ptr<btConvexHullShape>>>
+      hulls;
+};
+
+/**
+ * @brief The collision asset and the options @ref BulletConvexHulls were
+ * built with, compared by their exact values.
+ */
+struct BulletConvexHullKey {
+  std::string collisionAssetHandle;
+  std::array<float, 3> scale;
+  //! 0 unless built as a convex decomposition
+  int maxConvexHulls = 0;
+  int maxHullVertices = 0;
+  bool joined = false;
+  //! the collision asset size, zero unless the hulls are scaled by it
+  std::array<float, 3> collisionAssetSize{};
+
+  bool operator<(const BulletConvexHullKey& other) const {
+    return std::tie(collisionAssetHandle, scale, maxConvexHulls,
+                    maxHullVertices, joined, collisionAssetSize) <
+           std::tie(other.collisionAssetHandle, other.scale,
+                    other.maxConvexHulls, other.maxHullVertices, other.joined,
+                    other.collisionAssetSize);
+  }
+};
+
+//! @ref BulletConvexHulls keyed by collision asset and the options they were
+//! built with
+using BulletConvexHullCache =
+    std::map<BulletConvexHullKey, std::shared_ptr<const BulletConvexHulls>>;
+
 /**
  * @brief An individual rigid object instance implementing an interface with
  * Bullet physics to enable dynamic objects. See @ref btRigidBody for @ref
@@ -42,12 +94,15 @@ class BulletRigidObject : public BulletBase,
    * @brief Constructor for a @ref BulletRigidObject.
    * @param rigidBodyNode The @ref scene::SceneNode this feature will be
    * attached to.
+   * @param convexHullCache The convex hulls of collision meshes already built
+   * for other objects, the hulls built for this object are added to it.
    */
   BulletRigidObject(scene::SceneNode* rigidBodyNode,
                     int objectId,
-                    std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+                    std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
                     std::shared_ptr<std::map<const btCollisionObject*, int>>
-                        collisionObjToObjIds);
+                        collisionObjToObjIds,
+                    std::shared_ptr<BulletConvexHullCache> convexHullCache);
 
   /**
    * @brief Destructor cleans up simulation structures for the object.
@@ -74,10 +129,10 @@ class BulletRigidObject : public BulletBase,
   // const assets::AbstractPrimitiveAttributes& primAttributes);
 
   /**
-   * @brief Recursively construct a @ref btCompoundShape for collision from
-   * loaded mesh assets. A @ref btConvexHullShape is constructed for each
-   * sub-component, transformed to object-local space and added to the compound
-   * in a flat manner for efficiency.
+   * @brief Recursively construct the convex hulls of a compound collision
+   * shape from loaded mesh assets. A @ref btConvexHullShape is constructed for
+   * each sub-component, transformed to object-local space and added to
+   * @p hulls in a flat manner for efficiency.
    * @param transformFromParentToWorld The cumulative parent-to-world
    * transformation matrix constructed by composition down the @ref
    * MeshTransformNode tree to the current node.
@@ -85,12 +140,32 @@ class BulletRigidObject : public BulletBase,
    * @param node The current @ref MeshTransformNode in the recursion.
    * @param join Whether or not to join sub-meshes into a single con convex
    * shape, rather than creating individual convexes under the compound.
+   * @param hulls The constructed hulls. If @p join, the points of all
+   * sub-meshes are accumulated into a single hull, which is reduced to its
+   * convex hull points once the caller is done.
    */
   void constructBulletCompoundFromMeshes(
       const Magnum::Matrix4& transformFromParentToWorld,
       const std::vector<assets::CollisionMeshData>& meshGroup,
       const assets::MeshTransformNode& node,
-      bool join);
+      bool join,
+      BulletConvexHulls& hulls);
+
+  /**
+   * @brief Decompose all meshes under @p root into the convex hulls set by
+   * the initialization attributes, see @ref
+   * metadata::attributes::ObjectAttributes::setMaxConvexHulls(). The
+   * decomposition is loaded from its cache file if it has one and saved to it
+   * otherwise.
+   * @param meshGroup Access structure for collision mesh data.
+   * @param root The root @ref MeshTransformNode of the meshes.
+   * @param hulls The constructed hulls, in the frame of the object and
+   * scaled by the collision asset size.
+   */
+  void constructBulletConvexDecomposition(
+      const std::vector<assets::CollisionMeshData>& meshGroup,
+      const assets::MeshTransformNode& root,
+      BulletConvexHulls& hulls);
 
   /**
    * @brief Check whether object is being actively simulated, or sleeping.
@@ -379,16 +454,44 @@ class BulletRigidObject : public BulletBase,
     bObjectRigidBody_->setDamping(getLinearDamping(), angularDamping);
   }
 
+  /** @brief Set the speeds below which the object may fall asleep.
+   * See @ref btRigidBody::setSleepingThresholds. Kept when the rigid body is
+   * rebuilt for another @ref MotionType.
+   * @param linThreshold The linear sleeping threshold, in meters per second.
+   * @param angThreshold The angular sleeping threshold, in radians per
+   * second.
+   */
+  void setSleepingThresholds(const double linThreshold,
+                             const double angThreshold) override {
+    linearSleepingThreshold_ = linThreshold;
+    angularSleepingThreshold_ = angThreshold;
+    if (bObjectRigidBody_) {
+      bObjectRigidBody_->setSleepingThresholds(linThreshold, angThreshold);
+    }
+  }
+
+  /** @brief Get the linear speed below which the object may fall asleep.
+   * See @ref btRigidBody::getLinearSleepingThreshold.
+   */
+  double getLinearSleepingThreshold() const override {
+    return linearSleepingThreshold_;
+  }
+
+  /** @brief Get the angular speed below which the object may fall asleep.
+   * See @ref btRigidBody::getAngularSleepingThreshold.
+   */
+  double getAngularSleepingThreshold() const override {
+    return angularSleepingThreshold_;
+  }
+
   /** @brief Set the scalar collision margin of an object. See @ref
    * btCompoundShape::setMargin.
+   *
+   * The convex hulls shared with other objects through the @ref
+   * BulletConvexHullCache are replaced by copies owned by this object first.
    * @param margin The new scalar collision margin of the object.
    */
-  void setMargin(const double margin) override {
-    for (std::size_t i = 0; i < bObjectConvexShapes_.size(); i++) {
-      bObjectConvexShapes_[i]->setMargin(margin);
-    }
-    bObjectShape_->setMargin(margin);
-  }
+  void setMargin(const double margin) override;
 
   /** @brief Sets the object's collision shape to its bounding box.
    * Since the bounding hierarchy is not constructed when the object is
@@ -432,6 +535,17 @@ class BulletRigidObject : public BulletBase,
   bool initialization_LibSpecific(
       const assets::ResourceManager& resMgr) override;
 
+  /**
+   * @brief Remove the rigid body from the world, waking the objects it may
+   * have been supporting.
+   */
+  void release_LibSpecific() override;
+
+  /**
+   * @brief Add the rigid body back to the world under the new object id.
+   */
+  void reuse_LibSpecific() override;
+
  protected:
   /**
    * @brief Used to synchronize Bullet's notion of the object state
@@ -456,8 +570,20 @@ class BulletRigidObject : public BulletBase,
   //! If true, the object's bounding box will be used for collision once
   //! computed
   bool usingBBCollisionShape_ = false;
-  //! Object data: Composite convex collision shape
-  std::vector<std::unique_ptr<btConvexHullShape>> bObjectConvexShapes_;
+
+  //! If true, the rigid body was taken out of the world by @ref release()
+  bool released_ = false;
+
+  //! The sleeping thresholds of the rigid body, the defaults of Bullet
+  double linearSleepingThreshold_ = 0.8;
+  double angularSleepingThreshold_ = 1.0;
+
+  //! Object data: Composite convex collision shape, possibly shared with
+  //! other objects through the @ref convexHullCache_
+  std::vector<std::shared_ptr<btConvexHullShape>> bObjectConvexShapes_;
+
+  //! convex hulls shared by all objects of the physics manager
+  std::shared_ptr<BulletConvexHullCache> convexHullCache_;
 
   //! list of @ref btCollisionShape for storing arbitrary collision shapes
   //! referenced within the @ref bObjectShape_.
@@ -2,6 +2,11 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
 #include <Magnum/BulletIntegration/DebugDraw.h>
 #include <Magnum/BulletIntegration/Integration.h>
 
@@ -15,12 +20,76 @@
 namespace esp {
 namespace physics {
 
+namespace {
+
+/**
+ * @brief Header of a BVH cache file, followed by the BVH serialized in place.
+ * The in-place layout depends on the Bullet build, which is checked as well.
+ */
+struct BvhFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t scalarSize;
+  uint32_t pointerSize;
+  uint64_t meshHash;
+  uint64_t dataSize;
+};
+
+constexpr char BvhFileMagic[4]{'H', 'B', 'V', 'H'};
+constexpr uint32_t BvhFileVersion = 1;
+
+//! FNV-1a, continuing from @p hash
+uint64_t hashBytes(const void* data, std::size_t size, uint64_t hash) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+//! hash of everything the BVH of a mesh shape is built from
+uint64_t hashMeshShape(const assets::CollisionMeshData& mesh,
+                       const btVector3& scaling,
+                       btScalar margin) {
+  uint64_t hash = 14695981039346656037ull;
+  hash = hashBytes(mesh.positions.data(),
+                   mesh.positions.size() * sizeof(Magnum::Vector3), hash);
+  hash = hashBytes(mesh.indices.data(),
+                   mesh.indices.size() * sizeof(Magnum::UnsignedInt), hash);
+  const btScalar shapeParameters[]{scaling.x(), scaling.y(), scaling.z(),
+                                   margin};
+  return hashBytes(shapeParameters, sizeof(shapeParameters), hash);
+}
+
+BvhFileHeader makeBvhFileHeader(uint64_t meshHash, uint64_t dataSize) {
+  BvhFileHeader header{};
+  std::memcpy(header.magic, BvhFileMagic, sizeof(BvhFileMagic));
+  header.version = BvhFileVersion;
+  header.scalarSize = sizeof(btScalar);
+  header.pointerSize = sizeof(void*);
+  header.meshHash = meshHash;
+  header.dataSize = dataSize;
+  return header;
+}
+
+}  // namespace
+
+BulletRigidStage::SerializedBvh::~SerializedBvh() {
+  if (bvh) {
+    bvh->~btOptimizedBvh();
+  }
+  btAlignedFree(buffer);
+}
+
 BulletRigidStage::BulletRigidStage(
     scene::SceneNode* rigidBodyNode,
-    std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+    std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
     std::shared_ptr<std::map<const btCollisionObject*, int> >
-        collisionObjToObjIds)
-    : BulletBase(bWorld, collisionObjToObjIds), RigidStage{rigidBodyNode} {}
+        collisionObjToObjIds,
+    bool cacheBvh /* = false */)
+    : BulletBase(bWorld, collisionObjToObjIds),
+      RigidStage{rigidBodyNode},
+      cacheBvh_(cacheBvh) {}
 
 BulletRigidStage::~BulletRigidStage() {
   // remove collision objects from the world
@@ -28,6 +97,9 @@ BulletRigidStage::~BulletRigidStage() {
     bWorld_->removeRigidBody(co.get());
     collisionObjToObjIds_->erase(co.get());
   }
+  while (!chunks_.empty()) {
+    removeChunk(chunks_.begin()->first);
+  }
 }
 bool BulletRigidStage::initialization_LibSpecific(
     const assets::ResourceManager& resMgr) {
@@ -40,26 +112,79 @@ bool BulletRigidStage::initialization_LibSpecific(
   const assets::MeshMetaData& metaData =
       resMgr.getMeshMetaData(collisionAssetHandle);
 
-  constructBulletSceneFromMeshes(Magnum::Matrix4{}, meshGroup, metaData.root);
-  for (auto& object : bStaticCollisionObjects_) {
+  // shapes shared from another stage are reused if built from the same asset
+  if (!stageShapes_ ||
+      stageShapes_->collisionAssetHandle != collisionAssetHandle) {
+    stageShapes_ = std::make_shared<StageShapes>();
+    stageShapes_->collisionAssetHandle = collisionAssetHandle;
+    constructBulletSceneFromMeshes(Magnum::Matrix4{}, meshGroup,
+                                   metaData.root, *stageShapes_);
+  }
+  addStaticCollisionObjects(*stageShapes_, bStaticCollisionObjects_);
+
+  return true;
+
+}  // initialization_LibSpecific
+
+void BulletRigidStage::addStaticCollisionObjects(
+    const StageShapes& shapes,
+    std::vector<std::unique_ptr<btRigidBody>>& objects) {
+  const std::size_t firstObject = objects.size();
+  for (std::size_t i = 0; i < shapes.shapes.size(); ++i) {
+    // mass == 0 to indicate static. See isStaticObject assert below. See also
+    // examples/MultiThreadedDemo/CommonRigidBodyMTBase.h
+    btVector3 localInertia(0, 0, 0);
+    btRigidBody::btRigidBodyConstructionInfo cInfo(
+        /*mass*/ 0.0, nullptr, shapes.shapes[i].get(), localInertia);
+    cInfo.m_startWorldTransform = shapes.transforms[i];
+    std::unique_ptr<btRigidBody> sceneCollisionObject =
+        std::make_unique<btRigidBody>(cInfo);
+    ASSERT(sceneCollisionObject->isStaticObject());
+    objects.emplace_back(std::move(sceneCollisionObject));
+  }
+  for (std::size_t i = firstObject; i < objects.size(); ++i) {
+    btRigidBody* object = objects[i].get();
     object->setFriction(initializationAttributes_->getFrictionCoefficient());
     object->setRestitution(
         initializationAttributes_->getRestitutionCoefficient());
     bWorld_->addRigidBody(
-        object.get(),
+        object,
         2,       // collisionFilterGroup (2 == StaticFilter)
         1 + 2);  // collisionFilterMask (1 == DefaultFilter, 2==StaticFilter)
-    collisionObjToObjIds_->emplace(object.get(), objectId_);
+    collisionObjToObjIds_->emplace(object, objectId_);
   }
+}  // addStaticCollisionObjects
 
-  return true;
+void BulletRigidStage::addChunk(const int chunkId,
+                                const assets::ResourceManager& resMgr,
+                                const std::string& collisionAssetHandle) {
+  removeChunk(chunkId);
+  Chunk& chunk = chunks_[chunkId];
+  chunk.shapes = std::make_unique<StageShapes>();
+  chunk.shapes->collisionAssetHandle = collisionAssetHandle;
+  constructBulletSceneFromMeshes(
+      Magnum::Matrix4{}, resMgr.getCollisionMesh(collisionAssetHandle),
+      resMgr.getMeshMetaData(collisionAssetHandle).root, *chunk.shapes);
+  addStaticCollisionObjects(*chunk.shapes, chunk.objects);
+}  // addChunk
 
-}  // initialization_LibSpecific
+void BulletRigidStage::removeChunk(const int chunkId) {
+  auto chunk = chunks_.find(chunkId);
+  if (chunk == chunks_.end()) {
+    return;
+  }
+  for (auto& co : chunk->second.objects) {
+    bWorld_->removeRigidBody(co.get());
+    collisionObjToObjIds_->erase(co.get());
+  }
+  chunks_.erase(chunk);
+}  // removeChunk
 
 void BulletRigidStage::constructBulletSceneFromMeshes(
     const Magnum::Matrix4& transformFromParentToWorld,
     const std::vector<assets::CollisionMeshData>& meshGroup,
-    const assets::MeshTransformNode& node) {
+    const assets::MeshTransformNode& node,
+    StageShapes& shapes) {
   Magnum::Matrix4 transformFromLocalToWorld =
       transformFromParentToWorld * node.transformFromLocalToParent;
   if (node.meshIDLocal != ID_UNDEFINED) {
@@ -90,42 +215,105 @@ void BulletRigidStage::constructBulletSceneFromMeshes(
     //! Embed 3D mesh into bullet shape
     //! btBvhTriangleMeshShape is the most generic/slow choice
     //! which allows concavity if the object is static
+    //! The bvh is built (or loaded) only once, after setting margin and scale
     std::unique_ptr<btBvhTriangleMeshShape> meshShape =
         std::make_unique<btBvhTriangleMeshShape>(indexedVertexArray.get(),
-                                                 true);
+                                                 true, false);
     meshShape->setMargin(0.04);
-    meshShape->setLocalScaling(
-        btVector3{transformFromLocalToWorld
-                      .scaling()});  // scale is a property of the shape
-
-    // re-build the bvh after setting margin
-    meshShape->buildOptimizedBvh();
-    // mass == 0 to indicate static. See isStaticObject assert below. See also
-    // examples/MultiThreadedDemo/CommonRigidBodyMTBase.h
-    btVector3 localInertia(0, 0, 0);
-    btRigidBody::btRigidBodyConstructionInfo cInfo(
-        /*mass*/ 0.0, nullptr, meshShape.get(), localInertia);
-    cInfo.m_startWorldTransform =
-        btTransform{btMatrix3x3{transformFromLocalToWorld.rotation()},
-                    btVector3{transformFromLocalToWorld.translation()}};
-    std::unique_ptr<btRigidBody> sceneCollisionObject =
-        std::make_unique<btRigidBody>(cInfo);
-    ASSERT(sceneCollisionObject->isStaticObject());
-    bStageArrays_.emplace_back(std::move(indexedVertexArray));
-    bStageShapes_.emplace_back(std::move(meshShape));
-    bStaticCollisionObjects_.emplace_back(std::move(sceneCollisionObject));
+    // scale is a property of the shape
+    setupMeshShapeBvh(*meshShape, mesh,
+                      btVector3{transformFromLocalToWorld.scaling()}, shapes);
+    shapes.arrays.emplace_back(std::move(indexedVertexArray));
+    shapes.shapes.emplace_back(std::move(meshShape));
+    shapes.transforms.emplace_back(
+        btMatrix3x3{transformFromLocalToWorld.rotation()},
+        btVector3{transformFromLocalToWorld.translation()});
   }
 
   for (auto& child : node.children) {
-    constructBulletSceneFromMeshes(transformFromLocalToWorld, meshGroup, child);
+    constructBulletSceneFromMeshes(transformFromLocalToWorld, meshGroup, child,
+                                   shapes);
   }
 }  // constructBulletSceneFromMeshes
 
+void BulletRigidStage::setupMeshShapeBvh(btBvhTriangleMeshShape& meshShape,
+                                         const assets::CollisionMeshData& mesh,
+                                         const btVector3& scaling,
+                                         StageShapes& shapes) {
+  const bool scaled =
+      (meshShape.getLocalScaling() - scaling).length2() > SIMD_EPSILON;
+  std::string bvhFile;
+  uint64_t meshHash = 0;
+  if (cacheBvh_) {
+    meshHash = hashMeshShape(mesh, scaling, meshShape.getMargin());
+    char hashString[17];
+    std::snprintf(hashString, sizeof(hashString), "%016llx",
+                  static_cast<unsigned long long>(meshHash));
+    bvhFile = shapes.collisionAssetHandle + "." + hashString + ".bvh";
+
+    std::ifstream file{bvhFile, std::ios::binary};
+    BvhFileHeader header{};
+    const BvhFileHeader expected = makeBvhFileHeader(meshHash, 0);
+    if (file && file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 &&
+        header.version == expected.version &&
+        header.scalarSize == expected.scalarSize &&
+        header.pointerSize == expected.pointerSize &&
+        header.meshHash == meshHash) {
+      auto serialized = std::make_unique<SerializedBvh>();
+      serialized->buffer = btAlignedAlloc(header.dataSize, 16);
+      if (file.read(static_cast<char*>(serialized->buffer), header.dataSize)) {
+        // the in-place data is a btQuantizedBvh, which btOptimizedBvh only
+        // extends with methods for building and refitting, as in Bullet's
+        // own ConcaveDemo
+        serialized->bvh = static_cast<btOptimizedBvh*>(
+            btQuantizedBvh::deSerializeInPlace(
+                serialized->buffer, static_cast<unsigned>(header.dataSize),
+                false));
+      }
+      if (serialized->bvh) {
+        // sets the scaling without rebuilding the bvh
+        meshShape.setOptimizedBvh(serialized->bvh, scaling);
+        shapes.bvhs.emplace_back(std::move(serialized));
+        return;
+      }
+      LOG(WARNING) << "BulletRigidStage::setupMeshShapeBvh : Could not load "
+                   << bvhFile << ", rebuilding it.";
+    }
+  }
+
+  // set the scaling without the rebuild of btBvhTriangleMeshShape
+  if (scaled) {
+    meshShape.btTriangleMeshShape::setLocalScaling(scaling);
+  }
+  meshShape.buildOptimizedBvh();
+
+  if (cacheBvh_) {
+    const btOptimizedBvh& bvh = *meshShape.getOptimizedBvh();
+    const unsigned dataSize = bvh.calculateSerializeBufferSize();
+    void* buffer = btAlignedAlloc(dataSize, 16);
+    const BvhFileHeader header = makeBvhFileHeader(meshHash, dataSize);
+    std::ofstream file{bvhFile, std::ios::binary | std::ios::trunc};
+    if (!bvh.serializeInPlace(buffer, dataSize, false) || !file ||
+        !file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+        !file.write(static_cast<const char*>(buffer), dataSize)) {
+      LOG(WARNING) << "BulletRigidStage::setupMeshShapeBvh : Could not save "
+                   << bvhFile;
+    }
+    btAlignedFree(buffer);
+  }
+}  // setupMeshShapeBvh
+
 void BulletRigidStage::setFrictionCoefficient(
     const double frictionCoefficient) {
   for (std::size_t i = 0; i < bStaticCollisionObjects_.size(); i++) {
     bStaticCollisionObjects_[i]->setFriction(frictionCoefficient);
   }
+  for (auto& chunk : chunks_) {
+    for (auto& object : chunk.second.objects) {
+      object->setFriction(frictionCoefficient);
+    }
+  }
 }
 
 void BulletRigidStage::setRestitutionCoefficient(
@@ -133,6 +321,11 @@ void BulletRigidStage::setRestitutionCoefficient(
   for (std::size_t i = 0; i < bStaticCollisionObjects_.size(); i++) {
     bStaticCollisionObjects_[i]->setRestitution(restitutionCoefficient);
   }
+  for (auto& chunk : chunks_) {
+    for (auto& object : chunk.second.objects) {
+      object->setRestitution(restitutionCoefficient);
+    }
+  }
 }
 
 double BulletRigidStage::getFrictionCoefficient() const {
@@ -21,10 +21,17 @@ namespace physics {
 
 class BulletRigidStage : public BulletBase, public RigidStage {
  public:
+  /**
+   * @brief Constructor for a @ref BulletRigidStage.
+   * @param cacheBvh Whether the BVH of each collision mesh is loaded from and
+   * saved to a file next to the collision asset, see @ref
+   * metadata::attributes::PhysicsManagerAttributes::setCacheStageBvh.
+   */
   BulletRigidStage(scene::SceneNode* rigidBodyNode,
-                   std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+                   std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
                    std::shared_ptr<std::map<const btCollisionObject*, int>>
-                       collisionObjToObjIds);
+                       collisionObjToObjIds,
+                   bool cacheBvh = false);
 
   /**
    * @brief Destructor cleans up simulation structures for the stage object.
@@ -42,6 +49,8 @@ class BulletRigidStage : public BulletBase, public RigidStage {
   bool initialization_LibSpecific(
       const assets::ResourceManager& resMgr) override;
 
+  struct StageShapes;
+
   /**
    * @brief Recursively construct the static collision mesh objects from
    * imported assets.
@@ -50,11 +59,35 @@ class BulletRigidStage : public BulletBase, public RigidStage {
    * MeshTransformNode tree to the current node.
    * @param meshGroup Access structure for collision mesh data.
    * @param node The current @ref MeshTransformNode in the recursion.
+   * @param shapes The shapes to add to.
    */
   void constructBulletSceneFromMeshes(
       const Magnum::Matrix4& transformFromParentToWorld,
       const std::vector<assets::CollisionMeshData>& meshGroup,
-      const assets::MeshTransformNode& node);
+      const assets::MeshTransformNode& node,
+      StageShapes& shapes);
+
+  /**
+   * @brief Create static collision objects from @p shapes, add them to the
+   * world and append them to @p objects.
+   */
+  void addStaticCollisionObjects(
+      const StageShapes& shapes,
+      std::vector<std::unique_ptr<btRigidBody>>& objects);
+
+  /**
+   * @brief Set the optimized BVH of a stage mesh shape, either loaded from the
+   * BVH cache file of @p mesh or built and then saved to it.
+   * @param meshShape The shape, constructed without a BVH.
+   * @param mesh The collision mesh wrapped by @p meshShape.
+   * @param scaling The local scaling of the shape, which the BVH depends on.
+   * @param shapes The shapes @p meshShape is added to, which keep a loaded
+   * BVH alive.
+   */
+  void setupMeshShapeBvh(btBvhTriangleMeshShape& meshShape,
+                         const assets::CollisionMeshData& mesh,
+                         const btVector3& scaling,
+                         StageShapes& shapes);
 
  public:
   /**
@@ -90,14 +123,86 @@ class BulletRigidStage : public BulletBase, public RigidStage {
    */
   void setRestitutionCoefficient(const double restitutionCoefficient) override;
 
+  /**
+   * @brief Reuse the collision shapes of @p source instead of building them,
+   * if both stages are initialized from the same collision asset. Call before
+   * @ref initialize(). The shapes stay alive as long as any stage using them.
+   */
+  void shareShapesFrom(const BulletRigidStage& source) {
+    stageShapes_ = source.stageShapes_;
+  }
+
+  /**
+   * @brief Add the collision meshes of a chunk of a streamed stage as static
+   * collision objects of the stage, see @ref
+   * PhysicsManager::addStageChunk()
+   * @param chunkId The id of the chunk
+   * @param resMgr The resource manager holding the collision meshes
+   * @param collisionAssetHandle The asset of the collision meshes
+   */
+  void addChunk(int chunkId,
+                const assets::ResourceManager& resMgr,
+                const std::string& collisionAssetHandle);
+
+  /**
+   * @brief Remove the collision objects of a chunk of @ref addChunk() from
+   * the world.
+   */
+  void removeChunk(int chunkId);
+
  private:
   // === Physical stage ===
 
-  //! Stage data: Bullet triangular mesh vertices
-  std::vector<std::unique_ptr<btTriangleIndexVertexArray>> bStageArrays_;
+  //! Whether the mesh BVHs are cached on disk
+  bool cacheBvh_;
+
+  /**
+   * @brief A BVH deserialized in place from its cache file. Not owned by the
+   * shape using it, so it has to outlive the shapes of @ref StageShapes.
+   */
+  struct SerializedBvh {
+    SerializedBvh() = default;
+    SerializedBvh(const SerializedBvh&) = delete;
+    SerializedBvh& operator=(const SerializedBvh&) = delete;
+    ~SerializedBvh();
+
+    //! 16-byte aligned buffer holding the BVH and its nodes
+    void* buffer = nullptr;
+    btOptimizedBvh* bvh = nullptr;
+  };
+
+  /**
+   * @brief The collision shapes of the stage, immutable once built, so the
+   * stages of cloned simulators can share them, see @ref shareShapesFrom().
+   */
+  struct StageShapes {
+    //! the collision asset the shapes are built from
+    std::string collisionAssetHandle;
+
+    //! Stage data: Bullet triangular mesh vertices
+    std::vector<std::unique_ptr<btTriangleIndexVertexArray>> arrays;
+
+    //! Stage data: BVHs loaded from the cache
+    std::vector<std::unique_ptr<SerializedBvh>> bvhs;
+
+    //! Stage data: Bullet triangular mesh shape
+    std::vector<std::unique_ptr<btBvhTriangleMeshShape>> shapes;
+
+    //! Stage data: the world transform of each shape
+    std::vector<btTransform> transforms;
+  };
+
+  //! the shapes of the stage, possibly shared with other stages
+  std::shared_ptr<StageShapes> stageShapes_;
+
+  //! the shapes and collision objects of a chunk of @ref addChunk()
+  struct Chunk {
+    std::unique_ptr<StageShapes> shapes;
+    std::vector<std::unique_ptr<btRigidBody>> objects;
+  };
 
-  //! Stage data: Bullet triangular mesh shape
-  std::vector<std::unique_ptr<btBvhTriangleMeshShape>> bStageShapes_;
+  //! the chunks of @ref addChunk(), by id
+  std::map<int, Chunk> chunks_;
 
  public:
   ESP_SMART_POINTERS(BulletRigidStage)
@@ -0,0 +1,269 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <cstdint>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/TestSuite/Tester.h>
+#include <Corrade/Utility/Directory.h>
+
+#include <esp/assets/ResourceManager.h>
+#include <esp/core/Profiling.h>
+#include <esp/gfx/WindowlessContext.h>
+#include <esp/physics/PhysicsManager.h>
+#include <esp/scene/SceneManager.h>
+
+#include "configure.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+using esp::core::residentMemory;
+using esp::physics::PhysicsManager;
+
+namespace {
+
+constexpr struct {
+  const char* name;
+  int numObjects;
+  //! a mesh object instead of a primitive cube
+  bool mesh;
+} ObjectData[]{
+    {"10 primitives", 10, false},
+    {"100 primitives", 100, false},
+    {"1000 primitives", 1000, false},
+    {"10 meshes", 10, true},
+    {"100 meshes", 100, true},
+    {"1000 meshes", 1000, true},
+};
+
+//! number of queries per benchmark iteration, so the fast ones are measurable
+constexpr int QueriesPerIteration = 100;
+
+//! objects per row and rows per layer of the grid the objects are dropped in
+constexpr int GridSize = 10;
+
+/**
+ * @brief Benchmarks of the physics world with a growing number of objects, to
+ * track how the stepping and the queries scale.
+ *
+ * The objects are dropped in a grid above the simple room test stage. Each
+ * iteration of the stepping benchmark is one step, so it reports per-step
+ * timings while the objects fall and settle. The memory benchmark reports the
+ * growth of the resident memory while adding the objects, on Linux only.
+ * Skips if the test assets are not downloaded.
+ */
+struct PhysicsBenchmark : Cr::TestSuite::Tester {
+  explicit PhysicsBenchmark();
+
+  void stepPhysics();
+  void castRay();
+  void contactTest();
+  void addRemoveObject();
+  void addObjectsMemory();
+
+  void memoryBegin();
+  std::uint64_t memoryEnd();
+
+  //! loads the stage into a new physics world, false if it is missing
+  bool loadStage();
+  //! adds the objects of the test case instance in a grid above the stage
+  void addObjects();
+  int addObject(const Mn::Vector3& position);
+
+  // must be declared first, so it is destroyed last
+  esp::gfx::WindowlessContext::uptr context_;
+  std::unique_ptr<esp::assets::ResourceManager> resourceManager_;
+  std::unique_ptr<esp::scene::SceneManager> sceneManager_;
+  PhysicsManager::ptr physicsManager_;
+  int sceneID_ = esp::ID_UNDEFINED;
+
+  std::string objectHandle_;
+  std::vector<int> objectIds_;
+  std::uint64_t memoryBefore_ = 0;
+};
+
+const std::string dataDir = Cr::Utility::Directory::join(SCENE_DATASETS, "../");
+
+PhysicsBenchmark::PhysicsBenchmark() {
+  addInstancedBenchmarks(
+      {&PhysicsBenchmark::stepPhysics, &PhysicsBenchmark::castRay,
+       &PhysicsBenchmark::contactTest, &PhysicsBenchmark::addRemoveObject},
+      50, Cr::Containers::arraySize(ObjectData));
+  addCustomInstancedBenchmarks({&PhysicsBenchmark::addObjectsMemory}, 1,
+                               Cr::Containers::arraySize(ObjectData),
+                               &PhysicsBenchmark::memoryBegin,
+                               &PhysicsBenchmark::memoryEnd,
+                               BenchmarkUnits::Bytes);
+
+  context_ = esp::gfx::WindowlessContext::create_unique(0);
+}
+
+bool PhysicsBenchmark::loadStage() {
+  auto&& data = ObjectData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  const std::string stageFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/scenes/simple_room.glb");
+  const std::string physicsConfigFile =
+      Cr::Utility::Directory::join(dataDir, "default.phys_scene_config.json");
+  if (!Cr::Utility::Directory::exists(stageFile) ||
+      !Cr::Utility::Directory::exists(physicsConfigFile))
+    return false;
+
+  // a new world for every test case, destroyed in dependency order
+  objectIds_.clear();
+  physicsManager_.reset();
+  sceneManager_.reset();
+  resourceManager_ = std::make_unique<esp::assets::ResourceManager>();
+  sceneManager_ = std::make_unique<esp::scene::SceneManager>();
+  sceneID_ = sceneManager_->initSceneGraph();
+
+  auto physicsManagerAttributes =
+      resourceManager_->getPhysicsAttributesManager()->createObject(
+          physicsConfigFile, true);
+  auto stageAttributesMgr = resourceManager_->getStageAttributesManager();
+  if (physicsManagerAttributes != nullptr) {
+    stageAttributesMgr->setCurrPhysicsManagerAttributesHandle(
+        physicsManagerAttributes->getHandle());
+  }
+  auto stageAttributes = stageAttributesMgr->createObject(stageFile, true);
+
+  auto& rootNode = sceneManager_->getSceneGraph(sceneID_).getRootNode();
+  resourceManager_->initPhysicsManager(physicsManager_, true, &rootNode,
+                                       physicsManagerAttributes);
+  std::vector<int> tempIDs{sceneID_, esp::ID_UNDEFINED};
+  if (!resourceManager_->loadStage(stageAttributes, physicsManager_,
+                                   sceneManager_.get(), tempIDs, false))
+    return false;
+
+  auto objectAttributesManager = resourceManager_->getObjectAttributesManager();
+  if (data.mesh) {
+    objectHandle_ = Cr::Utility::Directory::join(
+        dataDir, "test_assets/objects/nested_box.glb");
+    auto objectAttributes =
+        esp::metadata::attributes::ObjectAttributes::create();
+    objectAttributes->setRenderAssetHandle(objectHandle_);
+    objectAttributesManager->registerObject(objectAttributes, objectHandle_);
+  } else {
+    objectHandle_ =
+        objectAttributesManager->getObjectHandlesBySubstring("cubeSolid")[0];
+  }
+  return true;
+}
+
+int PhysicsBenchmark::addObject(const Mn::Vector3& position) {
+  const int objectId = physicsManager_->addObject(
+      objectHandle_, &sceneManager_->getSceneGraph(sceneID_).getDrawables());
+  physicsManager_->setTranslation(objectId, position);
+  return objectId;
+}
+
+void PhysicsBenchmark::addObjects() {
+  const int numObjects = ObjectData[testCaseInstanceId()].numObjects;
+  // centered above the table of the room, layers are stacked upwards
+  const Mn::Vector3 gridBase{0.21964f, 1.5f, -0.0897472f};
+  float spacing = 0.0f;
+  for (int i = 0; i < numObjects; ++i) {
+    const int objectId = addObject(gridBase);
+    if (i == 0) {
+      const Mn::Range3D bb =
+          physicsManager_->getObjectSceneNode(objectId).getCumulativeBB();
+      spacing = 1.5f * bb.size().max();
+    }
+    const int column = i % GridSize;
+    const int row = (i / GridSize) % GridSize;
+    const int layer = i / (GridSize * GridSize);
+    physicsManager_->setTranslation(
+        objectId, gridBase + spacing * Mn::Vector3(column - GridSize / 2,
+                                                   layer, row - GridSize / 2));
+    objectIds_.push_back(objectId);
+  }
+}
+
+void PhysicsBenchmark::stepPhysics() {
+  if (!loadStage())
+    CORRADE_SKIP("The test assets are not available");
+  addObjects();
+
+  const double timestep = 1.0 / 60.0;
+  CORRADE_BENCHMARK(1) { physicsManager_->stepPhysics(timestep); }
+  CORRADE_VERIFY(physicsManager_->getWorldTime() > 0.0);
+}
+
+void PhysicsBenchmark::castRay() {
+  if (!loadStage())
+    CORRADE_SKIP("The test assets are not available");
+  addObjects();
+  // settle the objects first
+  physicsManager_->stepPhysics(1.0);
+
+  // straight down through the objects, some of them miss between the objects
+  std::vector<esp::geo::Ray> rays;
+  for (int i = 0; i < QueriesPerIteration; ++i) {
+    const Mn::Vector3 above =
+        physicsManager_->getTranslation(objectIds_[i % objectIds_.size()]) +
+        Mn::Vector3{0.01f * (i % 7), 5.0f, 0.01f * (i % 5)};
+    rays.emplace_back(above, Mn::Vector3{0.0f, -1.0f, 0.0f});
+  }
+
+  int hits = 0;
+  CORRADE_BENCHMARK(1) {
+    for (const esp::geo::Ray& ray : rays) {
+      hits += physicsManager_->castRay(ray, 10.0).hasHits();
+    }
+  }
+  CORRADE_VERIFY(hits > 0);
+}
+
+void PhysicsBenchmark::contactTest() {
+  if (!loadStage())
+    CORRADE_SKIP("The test assets are not available");
+  addObjects();
+  physicsManager_->stepPhysics(1.0);
+
+  int contacts = 0;
+  CORRADE_BENCHMARK(1) {
+    for (int objectId : objectIds_) {
+      contacts += physicsManager_->contactTest(objectId);
+    }
+  }
+  CORRADE_VERIFY(contacts >= 0);
+}
+
+void PhysicsBenchmark::addRemoveObject() {
+  if (!loadStage())
+    CORRADE_SKIP("The test assets are not available");
+  addObjects();
+  physicsManager_->stepPhysics(1.0);
+
+  // into the existing objects, so the broadphase sees them
+  const Mn::Vector3 position =
+      physicsManager_->getTranslation(objectIds_.front());
+  const int numObjects = physicsManager_->getNumRigidObjects();
+  CORRADE_BENCHMARK(1) { physicsManager_->removeObject(addObject(position)); }
+  CORRADE_COMPARE(physicsManager_->getNumRigidObjects(), numObjects);
+}
+
+void PhysicsBenchmark::memoryBegin() {
+  memoryBefore_ = residentMemory();
+}
+
+std::uint64_t PhysicsBenchmark::memoryEnd() {
+  const std::uint64_t memoryAfter = residentMemory();
+  return memoryAfter > memoryBefore_ ? memoryAfter - memoryBefore_ : 0;
+}
+
+void PhysicsBenchmark::addObjectsMemory() {
+  if (!loadStage())
+    CORRADE_SKIP("The test assets are not available");
+
+  CORRADE_BENCHMARK(1) { addObjects(); }
+  CORRADE_COMPARE(physicsManager_->getNumRigidObjects(),
+                  ObjectData[testCaseInstanceId()].numObjects);
+}
+
+}  // namespace
+
+CORRADE_TEST_MAIN(PhysicsBenchmark)
@@ -0,0 +1,5 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#define SCENE_DATASETS "${SCENE_DATASETS}"
@@ -86,6 +86,8 @@ bool SemanticScene::
     scene.objects_[id] = std::move(object);
   }
 
+  scene.buildSpatialIndex();
+  scene.buildSemanticIdTables();
   return true;
 }
 
@@ -6,16 +6,72 @@
 #include "SemanticScene.h"
 
 #include <algorithm>
-#include <fstream>
+#include <cstring>
 #include <map>
-#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Directory.h>
 
 #include "esp/io/io.h"
 
+namespace Cr = Corrade;
+
 namespace esp {
 namespace scene {
 
+namespace {
+
+/**
+ * @brief The line starting at @p pos without its line break, advancing @p pos
+ * to the beginning of the next line
+ */
+std::pair<const char*, const char*> readLine(const char*& pos,
+                                             const char* end) {
+  const char* begin = pos;
+  const char* newline =
+      static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+  const char* lineEnd = newline ? newline : end;
+  pos = newline ? newline + 1 : end;
+  if (lineEnd != begin && lineEnd[-1] == '\r') {
+    --lineEnd;
+  }
+  return {begin, lineEnd};
+}
+
+/**
+ * @brief Split the line [@p begin, @p end) at runs of spaces, reusing the
+ * strings of @p tokens so that a pass over a file barely allocates
+ */
+void tokenizeLine(const char* begin,
+                  const char* end,
+                  std::vector<std::string>& tokens) {
+  size_t count = 0;
+  const char* p = begin;
+  while (p != end) {
+    while (p != end && *p == ' ') {
+      ++p;
+    }
+    if (p == end) {
+      break;
+    }
+    const char* tokenEnd = p;
+    while (tokenEnd != end && *tokenEnd != ' ') {
+      ++tokenEnd;
+    }
+    if (count == tokens.size()) {
+      tokens.emplace_back();
+    }
+    tokens[count++].assign(p, tokenEnd);
+    p = tokenEnd;
+  }
+  tokens.resize(count);
+}
+
+}  // namespace
+
 static const std::map<char, std::string> kRegionCategoryMap = {
     {'a', "bathroom"},  // with toilet and sink
     {'b', "bedroom"},
@@ -126,10 +182,19 @@ bool SemanticScene::loadMp3dHouse(
     return geo::OBB(center, 2 * radius, quatf(boxRotation));
   };
 
-  // open stream and determine house format version
-  std::ifstream ifs = std::ifstream(houseFilename);
-  std::string header;
-  std::getline(ifs, header);
+  // parse straight out of the mapped file, in a single pass
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      mapped = Cr::Utility::Directory::mapRead(houseFilename);
+  if (!mapped) {
+    LOG(ERROR) << "Could not read file " << houseFilename;
+    return false;
+  }
+  const char* pos = mapped.begin();
+  const char* const fileEnd = mapped.end();
+
+  // determine house format version
+  const std::pair<const char*, const char*> headerLine = readLine(pos, fileEnd);
+  const std::string header{headerLine.first, headerLine.second};
   if (header != "ASCII 1.1") {
     LOG(ERROR) << "Unsupported House format header " << header;
     return false;
@@ -140,13 +205,20 @@ bool SemanticScene::loadMp3dHouse(
   scene.regions_.clear();
   scene.objects_.clear();
 
-  std::string line;
-  while (std::getline(ifs, line)) {
-    if (line.empty()) {
+  std::vector<std::string> tokens;
+  while (pos != fileEnd) {
+    const std::pair<const char*, const char*> line = readLine(pos, fileEnd);
+    if (line.first == line.second) {
+      continue;
+    }
+    // most lines are vertices, surfaces and images this loader doesn't need,
+    // skip them without tokenizing
+    const char type = *line.first;
+    if (type == '\0' || !std::strchr("HLRCOE", type)) {
       continue;
     }
-    const std::vector<std::string> tokens = io::tokenize(line, " ", 0, true);
-    switch (line[0]) {
+    tokenizeLine(line.first, line.second, tokens);
+    switch (type) {
       case 'H': {  // house
         // H name label #images #panoramas #vertices #surfaces #segments
         //   #objects #categories #regions #portals #levels  0 0 0 0 0
@@ -266,6 +338,8 @@ bool SemanticScene::loadMp3dHouse(
     }
   }
 
+  scene.buildSpatialIndex();
+  scene.buildSemanticIdTables();
   return true;
 }
 
@@ -87,19 +87,9 @@ ObjectControls& ObjectControls::action(SceneNode& object,
                                        const std::string& actName,
                                        float distance,
                                        bool applyFilter /* = true */) {
-  if (moveFuncMap_.count(actName)) {
-    if (applyFilter) {
-      // TODO: use magnum math for the filter func as well?
-      const auto startPosition =
-          cast<vec3f>(object.absoluteTransformation().translation());
-      moveFuncMap_[actName](object, distance);
-      const auto endPos =
-          cast<vec3f>(object.absoluteTransformation().translation());
-      const vec3f filteredEndPosition = moveFilterFunc_(startPosition, endPos);
-      object.translate(Magnum::Vector3(vec3f(filteredEndPosition - endPos)));
-    } else {
-      moveFuncMap_[actName](object, distance);
-    }
+  const MoveFunc* moveFunc = getMoveFunc(actName);
+  if (moveFunc) {
+    applyMoveFunc(object, *moveFunc, distance, applyFilter);
   } else {
     LOG(ERROR) << "Tried to perform unknown action with name " << actName;
   }
@@ -107,5 +97,26 @@ ObjectControls& ObjectControls::action(SceneNode& object,
   return *this;
 }
 
+ObjectControls& ObjectControls::applyMoveFunc(
+    SceneNode& object,
+    const MoveFunc& moveFunc,
+    float distance,
+    bool applyFilter /* = true */) {
+  if (applyFilter) {
+    // TODO: use magnum math for the filter func as well?
+    const auto startPosition =
+        cast<vec3f>(object.absoluteTransformation().translation());
+    moveFunc(object, distance);
+    const auto endPos =
+        cast<vec3f>(object.absoluteTransformation().translation());
+    const vec3f filteredEndPosition = moveFilterFunc_(startPosition, endPos);
+    object.translate(Magnum::Vector3(vec3f(filteredEndPosition - endPos)));
+  } else {
+    moveFunc(object, distance);
+  }
+
+  return *this;
+}
+
 }  // namespace scene
 }  // namespace esp
@@ -24,6 +24,9 @@ class ObjectControls {
   typedef std::function<SceneNode&(SceneNode&, float)> MoveFunc;
   typedef std::function<vec3f(const vec3f&, const vec3f&)> MoveFilterFunc;
   ObjectControls& setMoveFilterFunction(MoveFilterFunc filterFunc);
+  const MoveFilterFunc& getMoveFilterFunction() const {
+    return moveFilterFunc_;
+  }
 
   ObjectControls& action(SceneNode& object,
                          const std::string& actName,
@@ -36,6 +39,24 @@ class ObjectControls {
     return action(object, actName, distance, applyFilter);
   }
 
+  /**
+   * @brief Apply a move function obtained from @ref getMoveFunc(), without
+   * looking the action up by name
+   */
+  ObjectControls& applyMoveFunc(SceneNode& object,
+                                const MoveFunc& moveFunc,
+                                float distance,
+                                bool applyFilter = true);
+
+  /**
+   * @brief The move function of an action, or nullptr if there is no action
+   * named @p actName. The function stays valid as long as the controls.
+   */
+  const MoveFunc* getMoveFunc(const std::string& actName) const {
+    auto moveFunc = moveFuncMap_.find(actName);
+    return moveFunc == moveFuncMap_.end() ? nullptr : &moveFunc->second;
+  }
+
   inline const std::map<std::string, MoveFunc>& getMoveFuncMap() const {
     return moveFuncMap_;
   }
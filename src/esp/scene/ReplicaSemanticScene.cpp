@@ -104,6 +104,8 @@ bool SemanticScene::loadReplicaHouse(
     scene.objects_[id] = std::move(object);
   }
 
+  scene.buildSpatialIndex();
+  scene.buildSemanticIdTables();
   return true;
 }
 
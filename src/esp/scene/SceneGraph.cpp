@@ -47,7 +47,21 @@ const gfx::DrawableGroup* SceneGraph::getDrawableGroup(
 }
 
 bool SceneGraph::deleteDrawableGroup(const std::string& id) {
-  return drawableGroups_.erase(id);
+  auto it = drawableGroups_.find(id);
+  if (it == drawableGroups_.end()) {
+    return false;
+  }
+  deletedDrawablesEpoch_ += it->second.epoch() + 1;
+  drawableGroups_.erase(it);
+  return true;
+}
+
+uint64_t SceneGraph::getDrawablesEpoch() {
+  uint64_t epoch = deletedDrawablesEpoch_;
+  for (auto& group : drawableGroups_) {
+    epoch += group.second.epoch();
+  }
+  return epoch;
 }
 
 }  // namespace scene
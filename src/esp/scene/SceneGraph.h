@@ -23,7 +23,7 @@ class SceneGraph {
   using DrawableGroups = std::unordered_map<std::string, gfx::DrawableGroup>;
 
   SceneGraph();
-  virtual ~SceneGraph() { LOG(INFO) << "Deconstructing SceneGraph"; };
+  virtual ~SceneGraph() { VLOG(1) << "Deconstructing SceneGraph"; };
 
   SceneNode& getRootNode() { return rootNode_; }
   const SceneNode& getRootNode() const { return rootNode_; }
@@ -101,6 +101,13 @@ class SceneGraph {
    */
   bool deleteDrawableGroup(const std::string& id);
 
+  /**
+   * @brief A counter which changes whenever a drawable was added or removed
+   * or the node of one moved, over all drawable groups, see @ref
+   * gfx::DrawableGroup::epoch()
+   */
+  uint64_t getDrawablesEpoch();
+
  protected:
   MagnumScene world_;
 
@@ -135,6 +142,10 @@ class SceneGraph {
   // drawable groups for this scene graph
   // This is a mapping from (groupID -> group of drawables).
   DrawableGroups drawableGroups_;
+
+  // the epochs of the deleted drawable groups, so that getDrawablesEpoch()
+  // never goes back
+  uint64_t deletedDrawablesEpoch_ = 0;
 };
 }  // namespace scene
 }  // namespace esp
@@ -16,13 +16,20 @@ int SceneManager::initSceneGraph() {
 
 SceneGraph& SceneManager::getSceneGraph(int sceneID) {
   ASSERT(sceneID >= 0 && sceneID < sceneGraphs_.size());
+  ASSERT(sceneGraphs_[sceneID] != nullptr);
   return (*(sceneGraphs_[sceneID].get()));
 }
 
 const SceneGraph& SceneManager::getSceneGraph(int sceneID) const {
   ASSERT(sceneID >= 0 && sceneID < sceneGraphs_.size());
+  ASSERT(sceneGraphs_[sceneID] != nullptr);
   return (*(sceneGraphs_[sceneID].get()));
 }
 
+void SceneManager::releaseSceneGraph(int sceneID) {
+  ASSERT(sceneID >= 0 && sceneID < sceneGraphs_.size());
+  sceneGraphs_[sceneID].reset();
+}
+
 }  // namespace scene
 }  // namespace esp
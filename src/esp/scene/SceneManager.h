@@ -31,6 +31,9 @@ class SceneManager {
   SceneGraph& getSceneGraph(int sceneID);
   const SceneGraph& getSceneGraph(int sceneID) const;
 
+  // destroys a scene graph, the IDs of the others stay valid
+  void releaseSceneGraph(int sceneID);
+
  protected:
   // Each item within is a base node, parent of all in that scene, for easy
   // manipulation (e.g., rotate the entire scene)
@@ -3,6 +3,9 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "SceneNode.h"
+
+#include <Magnum/SceneGraph/AbstractFeature.h>
+
 #include "esp/geo/geo.h"
 
 namespace Mn = Magnum;
@@ -10,13 +13,74 @@ namespace Mn = Magnum;
 namespace esp {
 namespace scene {
 
+/**
+ * Invalidates the bounding boxes of its node when the node or one of its
+ * ancestors moves. The scene graph then marks the node dirty, which it only
+ * does for a clean node, so whatever computes the bounding boxes cleans it.
+ */
+class SceneNode::BoundsInvalidation : public Mn::SceneGraph::AbstractFeature3D {
+ public:
+  explicit BoundsInvalidation(SceneNode& node)
+      : Mn::SceneGraph::AbstractFeature3D{node}, node_{node} {}
+
+ private:
+  void markDirty() override { node_.invalidateBounds(); }
+
+  SceneNode& node_;
+};
+
 SceneNode::SceneNode(SceneNode& parent) {
   setParent(&parent);
   setId(parent.getId());
+  addFeature<BoundsInvalidation>();
+  invalidateAncestorBounds();
 }
 
 SceneNode::SceneNode(MagnumScene& parentNode) {
   setParent(&parentNode);
+  addFeature<BoundsInvalidation>();
+}
+
+SceneNode::~SceneNode() {
+  // while the whole tree is destroyed, the parent is no SceneNode anymore
+  invalidateAncestorBounds();
+}
+
+void SceneNode::invalidateBounds() {
+  worldBBDirty_ = true;
+  invalidateAncestorBounds();
+}
+
+void SceneNode::invalidateAncestorBounds() {
+  for (SceneNode* node = dynamic_cast<SceneNode*>(parent());
+       node && !node->cumulativeBBDirty_;
+       node = dynamic_cast<SceneNode*>(node->parent())) {
+    node->cumulativeBBDirty_ = true;
+  }
+}
+
+void SceneNode::setMeshBB(Mn::Range3D meshBB) {
+  meshBB_ = std::move(meshBB);
+  worldBBDirty_ = true;
+  cumulativeBBDirty_ = true;
+  invalidateAncestorBounds();
+}
+
+Corrade::Containers::Optional<Mn::Range3D> SceneNode::getWorldAABB() {
+  if (aabb_) {
+    return aabb_;
+  }
+  if (meshBB_.size().isZero()) {
+    return Corrade::Containers::NullOpt;
+  }
+  if (worldBBDirty_) {
+    worldBBDirty_ = false;
+    // the next move makes the node dirty again, and invalidates the box
+    setClean();
+    worldBB_ =
+        geo::getTransformedBB(meshBB_, absoluteTransformationMatrix());
+  }
+  return worldBB_;
 }
 
 SceneNode& SceneNode::createChild() {
@@ -28,6 +92,15 @@ SceneNode& SceneNode::createChild() {
 
 //! @brief recursively compute the cumulative bounding box of this node's tree.
 const Mn::Range3D& SceneNode::computeCumulativeBB() {
+  // a clean node notifies its next move, which invalidates the cumulative
+  // bounding box of its parent. A node is dirty only if its parent's was
+  // invalidated, which the traversal then reaches.
+  setClean();
+  if (!cumulativeBBDirty_) {
+    return cumulativeBB_;
+  }
+  cumulativeBBDirty_ = false;
+
   // first copy from your precomputed mesh bb
   cumulativeBB_ = Mn::Range3D(meshBB_);
   auto* child = children().first();
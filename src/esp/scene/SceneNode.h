@@ -5,7 +5,9 @@
 #ifndef ESP_SCENE_SCENENODE_H_
 #define ESP_SCENE_SCENENODE_H_
 
-#include <stack>
+#include <cstddef>
+#include <iterator>
+#include <utility>
 
 #include <Corrade/Containers/Containers.h>
 #include <Corrade/Containers/Optional.h>
@@ -40,6 +42,7 @@ class SceneNode : public MagnumObject {
   // terminate node (e.g., "MagnumScene" defined in SceneGraph) as its ancestor
   SceneNode() = delete;
   SceneNode(SceneNode& parent);
+  ~SceneNode();
 
   // get the type of the attached object
   SceneNodeType getType() const { return type_; }
@@ -74,7 +77,9 @@ class SceneNode : public MagnumObject {
   }
 
   //! recursively compute the cumulative bounding box of the full scene graph
-  //! tree for which this node is the root
+  //! tree for which this node is the root, only descending into the subtrees
+  //! in which a node moved, got a new mesh bounding box, or was added or
+  //! removed since the last call
   const Magnum::Range3D& computeCumulativeBB();
 
   //! return the local bounding box for meshes stored at this node
@@ -85,12 +90,25 @@ class SceneNode : public MagnumObject {
     return aabb_;
   };
 
+  /**
+   * @brief The world space bounding box of the mesh stored at this node, for
+   * culling
+   *
+   * The absolute AABB of a static mesh, see @ref getAbsoluteAABB(), otherwise
+   * the mesh bounding box transformed by the absolute transformation of the
+   * node. That one is cached and only recomputed after the node or one of its
+   * ancestors moved, so a dynamic node that stands still costs no matrix
+   * products. @ref Corrade::Containers::NullOpt for a node without a mesh
+   * bounding box, which can't be culled.
+   */
+  Corrade::Containers::Optional<Magnum::Range3D> getWorldAABB();
+
   //! return the cumulative bounding box of the full scene graph tree for which
   //! this node is the root
   const Magnum::Range3D& getCumulativeBB() const { return cumulativeBB_; };
 
   //! set local bounding box for meshes stored at this node
-  void setMeshBB(Magnum::Range3D meshBB) { meshBB_ = std::move(meshBB); };
+  void setMeshBB(Magnum::Range3D meshBB);
 
   //! set the global bounding box for mesh stored in this node
   void setAbsoluteAABB(Magnum::Range3D aabb) { aabb_ = std::move(aabb); };
@@ -132,10 +150,214 @@ class SceneNode : public MagnumObject {
 
   //! the frustum plane in last frame that culls this node
   int frustumPlaneIndex = 0;
+
+ private:
+  class BoundsInvalidation;
+
+  //! the bounding boxes depending on the transformation of this node went
+  //! stale, called when it or an ancestor moves
+  void invalidateBounds();
+
+  //! mark the cumulative bounding boxes of the ancestors stale
+  void invalidateAncestorBounds();
+
+  //! meshBB_ in world space, see getWorldAABB()
+  Magnum::Range3D worldBB_;
+  bool worldBBDirty_ = true;
+
+  //! whether cumulativeBB_ has to be recomputed. If set, it is set for all
+  //! ancestors too.
+  bool cumulativeBBDirty_ = true;
 };
 
 // Traversal Helpers
 
+/**
+ * @brief Iterator over the nodes of a subtree in pre-order, parents before
+ * their children and children in order
+ *
+ * Follows the links of the nodes to their first child, next sibling and
+ * parent instead of keeping a stack of the nodes to visit, so that it
+ * neither allocates nor depends on the depth of the tree. The subtree is
+ * expected to not change structure while it is iterated.
+ *
+ * @tparam Node @ref SceneNode or `const SceneNode`
+ */
+template <class Node>
+class PreOrderIterator {
+ public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef Node value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef Node* pointer;
+  typedef Node& reference;
+
+  //! the end of any traversal
+  PreOrderIterator() = default;
+
+  //! the beginning of the traversal of the subtree of @p root
+  explicit PreOrderIterator(Node& root) : root_{&root}, node_{&root} {}
+
+  Node& operator*() const { return *node_; }
+  Node* operator->() const { return node_; }
+
+  PreOrderIterator& operator++() {
+    if (auto* child = node_->children().first()) {
+      node_ = static_cast<Node*>(child);
+      return *this;
+    }
+    // the next sibling of the closest ancestor in the subtree which has one
+    for (Node* node = node_; node != root_;
+         node = static_cast<Node*>(node->parent())) {
+      if (auto* sibling = node->nextSibling()) {
+        node_ = static_cast<Node*>(sibling);
+        return *this;
+      }
+    }
+    node_ = nullptr;
+    return *this;
+  }
+
+  PreOrderIterator operator++(int) {
+    PreOrderIterator previous = *this;
+    ++*this;
+    return previous;
+  }
+
+  bool operator==(const PreOrderIterator& other) const {
+    return node_ == other.node_;
+  }
+  bool operator!=(const PreOrderIterator& other) const {
+    return node_ != other.node_;
+  }
+
+ private:
+  Node* root_ = nullptr;
+  Node* node_ = nullptr;
+};
+
+/**
+ * @brief Iterator over the features of type @p Feature of the nodes of a
+ * subtree in pre-order, see @ref PreOrderIterator
+ *
+ * @tparam Feature Feature type, const for a const @p Node
+ * @tparam Node @ref SceneNode or `const SceneNode`
+ */
+template <class Feature, class Node>
+class PreOrderFeatureIterator {
+ public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef Feature value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef Feature* pointer;
+  typedef Feature& reference;
+
+  //! the end of any traversal
+  PreOrderFeatureIterator() = default;
+
+  //! the beginning of the traversal of the subtree of @p root
+  explicit PreOrderFeatureIterator(Node& root)
+      : nodes_{root}, abstractFeature_{root.features().first()} {
+    findFeature();
+  }
+
+  Feature& operator*() const { return *feature_; }
+  Feature* operator->() const { return feature_; }
+
+  PreOrderFeatureIterator& operator++() {
+    abstractFeature_ = abstractFeature_->nextFeature();
+    findFeature();
+    return *this;
+  }
+
+  PreOrderFeatureIterator operator++(int) {
+    PreOrderFeatureIterator previous = *this;
+    ++*this;
+    return previous;
+  }
+
+  bool operator==(const PreOrderFeatureIterator& other) const {
+    return feature_ == other.feature_;
+  }
+  bool operator!=(const PreOrderFeatureIterator& other) const {
+    return feature_ != other.feature_;
+  }
+
+ private:
+  //! the first feature of the type from abstractFeature_ on, in this or the
+  //! next nodes
+  void findFeature() {
+    for (;;) {
+      for (; abstractFeature_;
+           abstractFeature_ = abstractFeature_->nextFeature()) {
+        feature_ = dynamic_cast<Feature*>(abstractFeature_);
+        if (feature_) {
+          return;
+        }
+      }
+      if (++nodes_ == PreOrderIterator<Node>{}) {
+        feature_ = nullptr;
+        return;
+      }
+      abstractFeature_ = nodes_->features().first();
+    }
+  }
+
+  PreOrderIterator<Node> nodes_;
+  decltype(std::declval<Node&>().features().first()) abstractFeature_ =
+      nullptr;
+  Feature* feature_ = nullptr;
+};
+
+/** @brief A begin and end iterator pair, for range-based for loops */
+template <class Iterator>
+class TraversalRange {
+ public:
+  explicit TraversalRange(Iterator begin) : begin_{begin} {}
+
+  Iterator begin() const { return begin_; }
+  Iterator end() const { return Iterator{}; }
+
+ private:
+  Iterator begin_;
+};
+
+/**
+ * @brief The nodes of the subtree of @p root in pre-order, see @ref
+ * PreOrderIterator
+ */
+inline TraversalRange<PreOrderIterator<SceneNode>> preOrder(SceneNode& root) {
+  return TraversalRange<PreOrderIterator<SceneNode>>{
+      PreOrderIterator<SceneNode>{root}};
+}
+
+/** @overload */
+inline TraversalRange<PreOrderIterator<const SceneNode>> preOrder(
+    const SceneNode& root) {
+  return TraversalRange<PreOrderIterator<const SceneNode>>{
+      PreOrderIterator<const SceneNode>{root}};
+}
+
+/**
+ * @brief The features of type @p Feature of the subtree of @p root in
+ * pre-order, see @ref PreOrderFeatureIterator
+ */
+template <class Feature>
+TraversalRange<PreOrderFeatureIterator<Feature, SceneNode>> preOrderFeatures(
+    SceneNode& root) {
+  return TraversalRange<PreOrderFeatureIterator<Feature, SceneNode>>{
+      PreOrderFeatureIterator<Feature, SceneNode>{root}};
+}
+
+/** @overload */
+template <class Feature>
+TraversalRange<PreOrderFeatureIterator<const Feature, const SceneNode>>
+preOrderFeatures(const SceneNode& root) {
+  return TraversalRange<
+      PreOrderFeatureIterator<const Feature, const SceneNode>>{
+      PreOrderFeatureIterator<const Feature, const SceneNode>{root}};
+}
+
 /**
  * @brief Perform a pre-order traversal and invoke a callback at each node
  *
@@ -144,27 +366,17 @@ class SceneNode : public MagnumObject {
  */
 template <typename Callable>
 void preOrderTraversalWithCallback(const SceneNode& node, Callable&& cb) {
-  std::stack<std::reference_wrapper<const SceneNode>> stack;
-  stack.emplace(node);
-
-  do {
-    const SceneNode& currNode = stack.top();
-    stack.pop();
-    std::forward<Callable>(cb)(currNode);
-
-    for (const MagnumObject& child : currNode.children()) {
-      stack.emplace(static_cast<const SceneNode&>(child));
-    }
-  } while (!stack.empty());
+  for (const SceneNode& currNode : preOrder(node)) {
+    cb(currNode);
+  }
 }
 
 /** @overload */
 template <typename Callable>
 void preOrderTraversalWithCallback(SceneNode& node, Callable&& cb) {
-  auto constCb = [&cb](const SceneNode& node) {
-    std::forward<Callable>(cb)(const_cast<SceneNode&>(node));
-  };
-  preOrderTraversalWithCallback(const_cast<const SceneNode&>(node), constCb);
+  for (SceneNode& currNode : preOrder(node)) {
+    cb(currNode);
+  }
 }
 
 /**
@@ -178,24 +390,17 @@ void preOrderTraversalWithCallback(SceneNode& node, Callable&& cb) {
 template <typename Feature, typename Callable>
 void preOrderFeatureTraversalWithCallback(const SceneNode& node,
                                           Callable&& cb) {
-  auto featureCb = [&cb](const SceneNode& node) {
-    for (const auto& abstractFeature : node.features()) {
-      auto feature = dynamic_cast<const Feature*>(&abstractFeature);
-      if (feature)
-        std::forward<Callable>(cb)(*feature);
-    }
-  };
-  preOrderTraversalWithCallback(node, featureCb);
+  for (const Feature& feature : preOrderFeatures<Feature>(node)) {
+    cb(feature);
+  }
 }
 
 /** @overload */
 template <typename Feature, typename Callable>
 void preOrderFeatureTraversalWithCallback(SceneNode& node, Callable&& cb) {
-  auto constFeatureCb = [&cb](const Feature& feature) {
-    std::forward<Callable>(cb)(const_cast<Feature&>(feature));
-  };
-  preOrderFeatureTraversalWithCallback<Feature>(
-      const_cast<const SceneNode&>(node), constFeatureCb);
+  for (Feature& feature : preOrderFeatures<Feature>(node)) {
+    cb(feature);
+  }
 }
 
 }  // namespace scene
@@ -0,0 +1,160 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SemanticScene.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <Magnum/EigenIntegration/Integration.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace scene {
+
+namespace {
+
+Mn::Range3D toRange(const box3f& box) {
+  return Mn::Range3D{Mn::Vector3{box.min()}, Mn::Vector3{box.max()}};
+}
+
+}  // namespace
+
+void SemanticScene::buildSpatialIndex() {
+  std::vector<Mn::Range3D> objectBounds;
+  objectBVHItems_.clear();
+  objectOBBs_.clear();
+  for (size_t i = 0; i != objects_.size(); ++i) {
+    // the ids of some formats leave gaps in the objects
+    if (objects_[i]) {
+      objectBounds.push_back(toRange(objects_[i]->aabb()));
+      objectBVHItems_.push_back(i);
+      objectOBBs_.add(objects_[i]->obb());
+    }
+  }
+  objectBVH_.build(std::move(objectBounds));
+
+  std::vector<Mn::Range3D> regionBounds;
+  regionBVHItems_.clear();
+  for (size_t i = 0; i != regions_.size(); ++i) {
+    if (regions_[i]) {
+      regionBounds.push_back(toRange(regions_[i]->aabb()));
+      regionBVHItems_.push_back(i);
+    }
+  }
+  regionBVH_.build(std::move(regionBounds));
+}
+
+void SemanticScene::buildSemanticIdTables() {
+  semanticIdObjectIndices_.clear();
+  semanticIdCategoryIndices_.clear();
+  semanticIdRegionIndices_.clear();
+
+  if (segmentToObjectIndex_.empty()) {
+    denseSemanticIds_ = true;
+    for (size_t i = 0; i != objects_.size(); ++i) {
+      semanticIdObjectIndices_.push_back(objects_[i] ? int(i) : ID_UNDEFINED);
+    }
+  } else {
+    int minId = 0;
+    int maxId = 0;
+    for (const auto& entry : segmentToObjectIndex_) {
+      minId = std::min(minId, entry.first);
+      maxId = std::max(maxId, entry.first);
+    }
+    // the mask indices of some formats combine the region index with the
+    // segment index, a table of those would be mostly holes
+    constexpr size_t maxHolesPerId = 16;
+    const size_t tableSize = size_t(maxId) + 1;
+    denseSemanticIds_ =
+        minId >= 0 &&
+        tableSize <= maxHolesPerId * segmentToObjectIndex_.size() + 65536;
+    if (!denseSemanticIds_) {
+      LOG(WARNING) << "SemanticScene::buildSemanticIdTables : mask indices "
+                   << "in [" << minId << ", " << maxId
+                   << "] are too sparse for a dense table";
+      return;
+    }
+    semanticIdObjectIndices_.assign(tableSize, ID_UNDEFINED);
+    for (const auto& entry : segmentToObjectIndex_) {
+      semanticIdObjectIndices_[entry.first] = entry.second;
+    }
+  }
+
+  std::unordered_map<const SemanticRegion*, int> regionIndices;
+  for (size_t i = 0; i != regions_.size(); ++i) {
+    if (regions_[i]) {
+      regionIndices.emplace(regions_[i].get(), i);
+    }
+  }
+
+  semanticIdCategoryIndices_.assign(semanticIdObjectIndices_.size(),
+                                    ID_UNDEFINED);
+  semanticIdRegionIndices_.assign(semanticIdObjectIndices_.size(),
+                                  ID_UNDEFINED);
+  for (size_t i = 0; i != semanticIdObjectIndices_.size(); ++i) {
+    const int objectIndex = semanticIdObjectIndices_[i];
+    if (objectIndex < 0 || size_t(objectIndex) >= objects_.size() ||
+        !objects_[objectIndex]) {
+      continue;
+    }
+    const SemanticObject& object = *objects_[objectIndex];
+    if (object.category_) {
+      const int index = object.category_->index();
+      semanticIdCategoryIndices_[i] = index < 0 ? ID_UNDEFINED : index;
+    }
+    auto found = regionIndices.find(object.region_.get());
+    if (found != regionIndices.end()) {
+      semanticIdRegionIndices_[i] = found->second;
+    }
+  }
+}
+
+std::vector<std::vector<int>> SemanticScene::objectsWithinRadius(
+    const std::vector<vec3f>& points,
+    float radius) const {
+  std::vector<std::vector<int>> result(points.size());
+  std::vector<uint32_t> candidates;
+  for (size_t i = 0; i != points.size(); ++i) {
+    const Mn::Vector3 point{points[i]};
+    candidates.clear();
+    objectBVH_.overlap(Mn::Range3D{point - Mn::Vector3{radius},
+                                   point + Mn::Vector3{radius}},
+                       candidates);
+    for (uint32_t item : candidates) {
+      if (objectOBBs_.distance(item, points[i]) <= radius) {
+        result[i].push_back(objectBVHItems_[item]);
+      }
+    }
+    std::sort(result[i].begin(), result[i].end());
+  }
+  return result;
+}
+
+std::vector<int> SemanticScene::regionsContaining(
+    const std::vector<vec3f>& points) const {
+  std::vector<int> result(points.size(), ID_UNDEFINED);
+  std::vector<uint32_t> candidates;
+  for (size_t i = 0; i != points.size(); ++i) {
+    const Mn::Vector3 point{points[i]};
+    candidates.clear();
+    regionBVH_.overlap(Mn::Range3D{point, point}, candidates);
+    float smallestVolume = 0.0f;
+    for (uint32_t item : candidates) {
+      const int index = regionBVHItems_[item];
+      const float volume = regions_[index]->aabb().volume();
+      // ties go to the lowest index, so the result is deterministic
+      if (result[i] == ID_UNDEFINED || volume < smallestVolume ||
+          (volume == smallestVolume && index < result[i])) {
+        result[i] = index;
+        smallestVolume = volume;
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace scene
+}  // namespace esp
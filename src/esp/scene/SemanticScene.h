@@ -5,6 +5,7 @@
 #ifndef ESP_SCENE_SEMANTICSCENE_H_
 #define ESP_SCENE_SEMANTICSCENE_H_
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -13,6 +14,8 @@
 
 #include "esp/core/esp.h"
 #include "esp/geo/OBB.h"
+#include "esp/geo/OBBSet.h"
+#include "esp/gfx/CullingBVH.h"
 
 namespace esp {
 namespace scene {
@@ -38,7 +41,7 @@ class SemanticLevel;
 //! levels, regions and objects
 class SemanticScene {
  public:
-  ~SemanticScene() { LOG(INFO) << "Deconstructing SemanticScene"; }
+  ~SemanticScene() { VLOG(1) << "Deconstructing SemanticScene"; }
   //! return axis aligned bounding box of this House
   box3f aabb() const { return bbox_; }
 
@@ -71,16 +74,92 @@ class SemanticScene {
     return segmentToObjectIndex_;
   }
 
+  /**
+   * @brief The category index of each object ID drawn by the semantic mesh,
+   * under @p mapping, for looking semantic observations up in on the GPU,
+   * see @ref gfx::Renderer::setObjectIdLookup()
+   *
+   * The object IDs are the indices of @ref objects(). Those of no object,
+   * or of one without a category, map to 0.
+   */
+  inline std::vector<uint32_t> objectCategoryIndices(
+      const std::string& mapping = "") const;
+
   //! convert semantic mesh mask index to object index or ID_UNDEFINED if
   //! not mapped
   inline int semanticIndexToObjectIndex(int maskIndex) const {
-    if (segmentToObjectIndex_.count(maskIndex) > 0) {
-      return segmentToObjectIndex_.at(maskIndex);
-    } else {
-      return ID_UNDEFINED;
+    if (maskIndex >= 0 &&
+        size_t(maskIndex) < semanticIdObjectIndices_.size()) {
+      return semanticIdObjectIndices_[maskIndex];
     }
+    if (!denseSemanticIds_) {
+      auto found = segmentToObjectIndex_.find(maskIndex);
+      if (found != segmentToObjectIndex_.end()) {
+        return found->second;
+      }
+    }
+    return ID_UNDEFINED;
+  }
+
+  /**
+   * @brief The index into @ref objects() of each semantic id, ID_UNDEFINED
+   * for unmapped ids
+   *
+   * The semantic ids are the mask indices of @ref getSemanticIndexMap() if
+   * the scene has any, the object indices the semantic mesh is drawn with
+   * otherwise. The tables are built once by the loaders, for mapping whole
+   * semantic observations at once. They are empty if the mask indices are
+   * too sparse for a dense table, then only @ref
+   * semanticIndexToObjectIndex() maps them.
+   */
+  const std::vector<int>& semanticIdObjectIndices() const {
+    return semanticIdObjectIndices_;
+  }
+
+  /**
+   * @brief The index of the category of the object of each semantic id,
+   * under the default mapping, ID_UNDEFINED if there is none
+   *
+   * See @ref semanticIdObjectIndices().
+   */
+  const std::vector<int>& semanticIdCategoryIndices() const {
+    return semanticIdCategoryIndices_;
   }
 
+  /**
+   * @brief The index into @ref regions() of the region of the object of each
+   * semantic id, ID_UNDEFINED if there is none
+   *
+   * See @ref semanticIdObjectIndices().
+   */
+  const std::vector<int>& semanticIdRegionIndices() const {
+    return semanticIdRegionIndices_;
+  }
+
+  /**
+   * @brief The objects within a distance of each of a batch of points
+   * @param points  The points to query, in the frame of the scene
+   * @param radius  The maximal distance of an object to a point
+   * @return For each point, the indices into @ref objects() of the objects
+   * whose oriented bounding box is within @p radius of the point, in
+   * increasing order
+   *
+   * The candidates are found with a bounding volume hierarchy over the
+   * objects, which the loaders build along with the scene.
+   */
+  std::vector<std::vector<int>> objectsWithinRadius(
+      const std::vector<vec3f>& points,
+      float radius) const;
+
+  /**
+   * @brief The region containing each of a batch of points
+   * @param points  The points to query, in the frame of the scene
+   * @return For each point, the index into @ref regions() of the region whose
+   * bounding box contains it, or @ref ID_UNDEFINED if there is none. Where
+   * the boxes of regions overlap, e.g. in doorways, the smallest box wins.
+   */
+  std::vector<int> regionsContaining(const std::vector<vec3f>& points) const;
+
   //! load SemanticScene from a Gibson house format file
   static bool loadGibsonHouse(
       const std::string& filename,
@@ -119,6 +198,35 @@ class SemanticScene {
   //! map from combined region-segment id to objectIndex for semantic mesh
   std::unordered_map<int, int> segmentToObjectIndex_;
 
+  /**
+   * @brief Build the hierarchies for @ref objectsWithinRadius() and @ref
+   * regionsContaining(), called by the loaders once the scene is complete
+   */
+  void buildSpatialIndex();
+
+  /**
+   * @brief Build the tables of @ref semanticIdObjectIndices() and its
+   * siblings, called by the loaders once the scene is complete
+   */
+  void buildSemanticIdTables();
+
+  //! whether the semantic id tables cover all mask indices of
+  //! segmentToObjectIndex_
+  bool denseSemanticIds_ = false;
+  std::vector<int> semanticIdObjectIndices_;
+  std::vector<int> semanticIdCategoryIndices_;
+  std::vector<int> semanticIdRegionIndices_;
+
+  //! bounding volume hierarchy over the axis aligned bounding boxes of the
+  //! objects and the object index of each of its items
+  gfx::CullingBVH objectBVH_;
+  std::vector<int> objectBVHItems_;
+  //! the oriented bounding boxes of the BVH items, in the same order
+  geo::OBBSet objectOBBs_;
+  //! the same for the regions
+  gfx::CullingBVH regionBVH_;
+  std::vector<int> regionBVHItems_;
+
   ESP_SMART_POINTERS(SemanticScene)
 };
 
@@ -215,6 +323,18 @@ class SemanticObject {
   ESP_SMART_POINTERS(SemanticObject)
 };
 
+std::vector<uint32_t> SemanticScene::objectCategoryIndices(
+    const std::string& mapping) const {
+  std::vector<uint32_t> indices(objects_.size(), 0);
+  for (size_t i = 0; i != objects_.size(); ++i) {
+    if (objects_[i] && objects_[i]->category()) {
+      const int index = objects_[i]->category()->index(mapping);
+      indices[i] = index < 0 ? 0 : index;
+    }
+  }
+  return indices;
+}
+
 }  // namespace scene
 }  // namespace esp
 
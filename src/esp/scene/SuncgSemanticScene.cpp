@@ -226,6 +226,8 @@ bool SemanticScene::loadSuncgHouse(
 
     iLevel++;
   }  // for level
+  scene.buildSpatialIndex();
+  scene.buildSemanticIdTables();
   return true;
 }
 
@@ -31,11 +31,17 @@ struct ReplicaSceneTest : Cr::TestSuite::Tester {
   void testSemanticSceneOBB();
 
   void testSemanticSceneLoading();
+
+  void testSpatialQueries();
+
+  void testSemanticIdTables();
 };
 
 ReplicaSceneTest::ReplicaSceneTest() {
   addTests({&ReplicaSceneTest::testSemanticSceneOBB,
-            &ReplicaSceneTest::testSemanticSceneLoading});
+            &ReplicaSceneTest::testSemanticSceneLoading,
+            &ReplicaSceneTest::testSpatialQueries,
+            &ReplicaSceneTest::testSemanticIdTables});
 }
 
 void ReplicaSceneTest::testSemanticSceneOBB() {
@@ -117,6 +123,100 @@ void ReplicaSceneTest::testSemanticSceneLoading() {
   CORRADE_COMPARE(scene->objects()[12]->category()->name(), "book");
 }
 
+void ReplicaSceneTest::testSpatialQueries() {
+  if (!Cr::Utility::Directory::exists(replicaRoom0)) {
+    CORRADE_SKIP("Replica dataset not found at '" + replicaRoom0 +
+                 "'\nSkipping test");
+  }
+
+  esp::scene::SemanticScene scene;
+  CORRADE_VERIFY(esp::scene::SemanticScene::loadReplicaHouse(
+      Cr::Utility::Directory::join(replicaRoom0, "info_semantic.json"), scene));
+
+  // query around the object centers, and compare with brute force
+  std::vector<esp::vec3f> points;
+  for (const auto& obj : scene.objects()) {
+    if (obj != nullptr && points.size() < 10) {
+      points.push_back(obj->obb().center());
+    }
+  }
+  CORRADE_VERIFY(!points.empty());
+  const float radius = 0.5f;
+  const std::vector<std::vector<int>> nearby =
+      scene.objectsWithinRadius(points, radius);
+  CORRADE_COMPARE(nearby.size(), points.size());
+  for (size_t i = 0; i != points.size(); ++i) {
+    CORRADE_ITERATION(i);
+    std::vector<int> groundTruth;
+    for (size_t j = 0; j != scene.objects().size(); ++j) {
+      const auto& obj = scene.objects()[j];
+      if (obj != nullptr && obj->obb().distance(points[i]) <= radius) {
+        groundTruth.push_back(j);
+      }
+    }
+    // at least the object around the point itself
+    CORRADE_VERIFY(!groundTruth.empty());
+    CORRADE_VERIFY(nearby[i] == groundTruth);
+  }
+
+  // each point is either in a region's box, or in none
+  const std::vector<int> regions = scene.regionsContaining(points);
+  CORRADE_COMPARE(regions.size(), points.size());
+  for (size_t i = 0; i != points.size(); ++i) {
+    CORRADE_ITERATION(i);
+    if (regions[i] == esp::ID_UNDEFINED) {
+      for (const auto& region : scene.regions()) {
+        CORRADE_VERIFY(!region || !region->aabb().contains(points[i]));
+      }
+    } else {
+      CORRADE_VERIFY(scene.regions()[regions[i]]->aabb().contains(points[i]));
+    }
+  }
+}
+
+void ReplicaSceneTest::testSemanticIdTables() {
+  if (!Cr::Utility::Directory::exists(replicaRoom0)) {
+    CORRADE_SKIP("Replica dataset not found at '" + replicaRoom0 +
+                 "'\nSkipping test");
+  }
+
+  esp::scene::SemanticScene scene;
+  CORRADE_VERIFY(esp::scene::SemanticScene::loadReplicaHouse(
+      Cr::Utility::Directory::join(replicaRoom0, "info_semantic.json"), scene));
+
+  // the semantic mesh is drawn with the object indices
+  const auto& objects = scene.objects();
+  const std::vector<int>& objectIndices = scene.semanticIdObjectIndices();
+  const std::vector<int>& categoryIndices = scene.semanticIdCategoryIndices();
+  const std::vector<int>& regionIndices = scene.semanticIdRegionIndices();
+  CORRADE_COMPARE(objectIndices.size(), objects.size());
+  CORRADE_COMPARE(categoryIndices.size(), objects.size());
+  CORRADE_COMPARE(regionIndices.size(), objects.size());
+  for (size_t i = 0; i != objects.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(scene.semanticIndexToObjectIndex(i), objectIndices[i]);
+    if (!objects[i]) {
+      CORRADE_COMPARE(objectIndices[i], esp::ID_UNDEFINED);
+      continue;
+    }
+    CORRADE_COMPARE(objectIndices[i], int(i));
+    const int categoryIndex =
+        objects[i]->category() ? objects[i]->category()->index() : -1;
+    CORRADE_COMPARE(categoryIndices[i],
+                    categoryIndex < 0 ? esp::ID_UNDEFINED : categoryIndex);
+    if (objects[i]->region()) {
+      CORRADE_VERIFY(regionIndices[i] != esp::ID_UNDEFINED);
+      CORRADE_VERIFY(scene.regions()[regionIndices[i]] ==
+                     objects[i]->region());
+    } else {
+      CORRADE_COMPARE(regionIndices[i], esp::ID_UNDEFINED);
+    }
+  }
+  CORRADE_COMPARE(scene.semanticIndexToObjectIndex(objects.size()),
+                  esp::ID_UNDEFINED);
+  CORRADE_COMPARE(scene.semanticIndexToObjectIndex(-1), esp::ID_UNDEFINED);
+}
+
 }  // namespace
 
 CORRADE_TEST_MAIN(ReplicaSceneTest)
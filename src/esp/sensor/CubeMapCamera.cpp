@@ -0,0 +1,298 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CubeMapCamera.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/PixelFormat.h>
+
+#include "esp/gfx/RenderTarget.h"
+#include "esp/sim/Simulator.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sensor {
+
+namespace {
+
+constexpr int NumFaces = 6;
+
+// rotation of the camera, which looks down -Z, to look at each face
+Mn::Matrix3x3 faceRotation(CubeMapCamera::Face face) {
+  using namespace Mn::Math::Literals;
+  switch (face) {
+    case CubeMapCamera::Face::PositiveX:
+      return Mn::Matrix4::rotationY(-90.0_degf).rotationScaling();
+    case CubeMapCamera::Face::NegativeX:
+      return Mn::Matrix4::rotationY(90.0_degf).rotationScaling();
+    case CubeMapCamera::Face::PositiveY:
+      return Mn::Matrix4::rotationX(90.0_degf).rotationScaling();
+    case CubeMapCamera::Face::NegativeY:
+      return Mn::Matrix4::rotationX(-90.0_degf).rotationScaling();
+    case CubeMapCamera::Face::PositiveZ:
+      return Mn::Matrix4::rotationY(180.0_degf).rotationScaling();
+    case CubeMapCamera::Face::NegativeZ:
+      break;
+  }
+  return Mn::Matrix3x3{};
+}
+
+}  // namespace
+
+bool CubeMapCamera::isCubeMapSpec(const SensorSpec& spec) {
+  return spec.sensorSubtype == CubeMapSubtype ||
+         spec.sensorSubtype == EquirectangularSubtype;
+}
+
+CubeMapCamera::CubeMapCamera(scene::SceneNode& cameraNode,
+                             SensorSpec::ptr spec)
+    : PinholeCamera(cameraNode, spec),
+      equirectangular_{spec_->sensorSubtype == EquirectangularSubtype} {
+  if (hasConvertedObservation()) {
+    throw std::runtime_error(
+        "CubeMapCamera: observation formats and downsampling are not "
+        "supported");
+  }
+  if (spec_->sensorType == SensorType::NORMAL) {
+    throw std::runtime_error(
+        "CubeMapCamera: normal sensors are not supported, the faces would "
+        "have normals in different camera spaces");
+  }
+  if (spec_->sensorType == SensorType::OPTICAL_FLOW) {
+    throw std::runtime_error(
+        "CubeMapCamera: optical flow sensors are not supported");
+  }
+  const int height = spec_->resolution[0];
+  const int width = spec_->resolution[1];
+  if (equirectangular_) {
+    auto it = spec_->parameters.find("cubemap_size");
+    faceSize_ = it != spec_->parameters.end() ? std::atoi(it->second.c_str())
+                                              : std::max(1, height / 2);
+    if (faceSize_ <= 0 || width <= 0 || height <= 0) {
+      throw std::runtime_error(
+          "CubeMapCamera: invalid resolution or cubemap_size of an "
+          "equirectangular sensor");
+    }
+  } else {
+    faceSize_ = width;
+    if (width <= 0 || height != NumFaces * width) {
+      throw std::runtime_error(
+          "CubeMapCamera: the resolution of a cubemap sensor must be a stack "
+          "of 6 square faces, [6 * size, size]");
+    }
+  }
+
+  // each face is a square 90 degree pinhole view
+  width_ = faceSize_;
+  height_ = faceSize_;
+  hfov_ = 90.0f;
+
+  if (equirectangular_) {
+    buildResampleTable();
+  }
+}
+
+Mn::Range2Di CubeMapCamera::faceViewport(Face face) const {
+  // the first face is at the top of the image, i.e. the last rows of the
+  // framebuffer, which OpenGL counts from the bottom
+  const int row = NumFaces - 1 - static_cast<int>(face);
+  return Mn::Range2Di::fromSize({0, row * faceSize_}, {faceSize_, faceSize_});
+}
+
+CubeMapCamera& CubeMapCamera::setTransformationMatrix(
+    gfx::RenderCamera& targetCamera) {
+  PinholeCamera::setTransformationMatrix(targetCamera);
+  scene::SceneNode& cameraNode = targetCamera.node();
+  cameraNode.setTransformation(cameraNode.transformation() *
+                               Mn::Matrix4::from(faceRotation(face_), {}));
+  return *this;
+}
+
+CubeMapCamera& CubeMapCamera::setViewport(gfx::RenderCamera& targetCamera) {
+  targetCamera.setViewport({faceSize_, faceSize_});
+  return *this;
+}
+
+bool CubeMapCamera::getObservation(sim::Simulator& sim, Observation& obs) {
+  if (!equirectangular_) {
+    return PinholeCamera::getObservation(sim, obs);
+  }
+  if (!hasRenderTarget())
+    return false;
+
+  drawObservation(sim);
+#ifndef MAGNUM_TARGET_WEBGL
+  if (sim.isAsyncObservationReadbackEnabled()) {
+    readEquirectangularAsync(obs);
+    return true;
+  }
+#endif
+  readObservation(obs);
+
+  return true;
+}
+
+bool CubeMapCamera::drawObservation(sim::Simulator& sim) {
+  if (!hasRenderTarget()) {
+    return false;
+  }
+
+  gfx::RenderTarget& tgt = renderTarget();
+  tgt.renderEnter();
+  for (int i = 0; i != NumFaces; ++i) {
+    face_ = Face(i);
+    tgt.setDrawViewport(faceViewport(face_));
+    drawScene(sim);
+  }
+  face_ = Face::NegativeZ;
+  tgt.renderExit();
+
+  return true;
+}
+
+Mn::PixelFormat CubeMapCamera::facePixelFormat() const {
+  if (spec_->sensorType == SensorType::SEMANTIC) {
+    return Mn::PixelFormat::R32UI;
+  } else if (spec_->sensorType == SensorType::DEPTH) {
+    return Mn::PixelFormat::R32F;
+  }
+  return Mn::PixelFormat::RGBA8Unorm;
+}
+
+bool CubeMapCamera::readObservationFrom(gfx::RenderTarget& source,
+                                        Observation& obs) {
+  if (!equirectangular_) {
+    return PinholeCamera::readObservationFrom(source, obs);
+  }
+
+  if (faces_ == nullptr) {
+    ObservationSpace space;
+    getObservationSpace(space);
+    faces_ = core::Buffer::create(
+        {static_cast<size_t>(NumFaces * faceSize_),
+         static_cast<size_t>(faceSize_), space.shape[2]},
+        space.dataType);
+  }
+  const Mn::MutableImageView2D view{facePixelFormat(),
+                                    source.framebufferSize(), faces_->data};
+  if (spec_->sensorType == SensorType::SEMANTIC) {
+    source.readFrameObjectId(view);
+  } else if (spec_->sensorType == SensorType::DEPTH) {
+    source.readFrameDepth(view);
+  } else {
+    source.readFrameRgba(view);
+  }
+  resample(obs);
+  return true;
+}
+
+#ifndef MAGNUM_TARGET_WEBGL
+void CubeMapCamera::readEquirectangularAsync(Observation& obs) {
+  gfx::RenderTarget& tgt = renderTarget();
+  const bool hasPreviousFrame = tgt.numPendingAsyncReads() > 0;
+  if (!hasPreviousFrame) {
+    readObservation(obs);
+  }
+
+  if (spec_->sensorType == SensorType::SEMANTIC) {
+    tgt.readFrameObjectIdAsync();
+  } else if (spec_->sensorType == SensorType::DEPTH) {
+    tgt.readFrameDepthAsync();
+  } else {
+    tgt.readFrameRgbaAsync();
+  }
+
+  if (hasPreviousFrame) {
+    // faces_ was allocated by the synchronous read that started the pipeline
+    tgt.retrieveAsyncRead(Mn::MutableImageView2D{
+        facePixelFormat(), tgt.framebufferSize(), faces_->data});
+    resample(obs);
+  }
+}
+#endif
+
+void CubeMapCamera::buildResampleTable() {
+  const int height = spec_->resolution[0];
+  const int width = spec_->resolution[1];
+  const float pi = Mn::Constants::pi();
+
+  Mn::Matrix3x3 rotations[NumFaces];
+  for (int i = 0; i != NumFaces; ++i) {
+    rotations[i] = faceRotation(Face(i));
+  }
+
+  sourcePixels_.resize(size_t(width) * height);
+  rayScales_.resize(size_t(width) * height);
+  for (int row = 0; row != height; ++row) {
+    // the buffers hold the bottom row of the image first
+    const float elevation = 0.5f * pi - (height - row - 0.5f) / height * pi;
+    for (int col = 0; col != width; ++col) {
+      const float azimuth = (col + 0.5f) / width * 2.0f * pi - pi;
+      const Mn::Vector3 ray{std::sin(azimuth) * std::cos(elevation),
+                            std::sin(elevation),
+                            -std::cos(azimuth) * std::cos(elevation)};
+
+      // the face the ray is most aligned with, and the ray as seen by it
+      int face = 0;
+      Mn::Vector3 local;
+      for (int i = 0; i != NumFaces; ++i) {
+        const Mn::Vector3 candidate = rotations[i].transposed() * ray;
+        if (i == 0 || candidate.z() < local.z()) {
+          face = i;
+          local = candidate;
+        }
+      }
+
+      const Mn::Vector2 ndc = local.xy() / -local.z();
+      const Mn::Vector2i pixel = Mn::Math::clamp(
+          Mn::Vector2i{(ndc + Mn::Vector2{1.0f}) * 0.5f * float(faceSize_)},
+          Mn::Vector2i{0}, Mn::Vector2i{faceSize_ - 1});
+      const Mn::Vector2i offset = faceViewport(Face(face)).min();
+      const size_t index = size_t(row) * width + col;
+      sourcePixels_[index] =
+          (offset.y() + pixel.y()) * faceSize_ + offset.x() + pixel.x();
+      // the depth is along the axis of the face, the distance along the ray
+      // is longer away from its center
+      rayScales_[index] = 1.0f / -local.z();
+    }
+  }
+}
+
+void CubeMapCamera::resample(Observation& obs) {
+  if (buffer_ == nullptr) {
+    ObservationSpace space;
+    getObservationSpace(space);
+    buffer_ = core::Buffer::create(space.shape, space.dataType);
+  }
+  obs.buffer = buffer_;
+
+  const size_t numPixels = sourcePixels_.size();
+  uint8_t* dst = buffer_->data.data();
+  const uint8_t* src = faces_->data.data();
+  if (spec_->sensorType == SensorType::DEPTH) {
+    float* dstDepth = reinterpret_cast<float*>(dst);
+    const float* srcDepth = reinterpret_cast<const float*>(src);
+    for (size_t i = 0; i != numPixels; ++i) {
+      dstDepth[i] = srcDepth[sourcePixels_[i]] * rayScales_[i];
+    }
+    return;
+  }
+
+  const size_t pixelSize = buffer_->data.size() / numPixels;
+  for (size_t i = 0; i != numPixels; ++i) {
+    std::memcpy(dst + i * pixelSize, src + sourcePixels_[i] * pixelSize,
+                pixelSize);
+  }
+}
+
+}  // namespace sensor
+}  // namespace esp
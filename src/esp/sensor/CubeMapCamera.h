@@ -0,0 +1,150 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_CUBEMAPCAMERA_H_
+#define ESP_SENSOR_CUBEMAPCAMERA_H_
+
+/** @file
+ * @brief Class @ref esp::sensor::CubeMapCamera
+ */
+
+#include <vector>
+
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+
+#include "PinholeCamera.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief A 360° camera seeing all six faces of a cube around its node, for a
+ * sensor spec with the @ref CubeMapCamera::CubeMapSubtype or @ref
+ * CubeMapCamera::EquirectangularSubtype subtype.
+ *
+ * The faces are 90° pinhole views, drawn one after another into viewports of
+ * a single render target stacked along Y, so that an observation takes one
+ * @ref gfx::RenderTarget::renderEnter() / @ref gfx::RenderTarget::renderExit()
+ * cycle and one readback instead of six. Each face still culls on its own.
+ *
+ * With @ref CubeMapSubtype the observation is the stack, with the faces in
+ * the order of @ref Face from the top row of the image down, and the
+ * resolution has to be 6 face sizes high and one face size wide. Depth is
+ * along the axis of the face.
+ *
+ * With @ref EquirectangularSubtype the faces, of a size given by the
+ * @cb{.json} "cubemap_size" @ce parameter and half the height of the
+ * resolution by default, are resampled after the readback into an
+ * equirectangular panorama with the longitude going right from the back and
+ * the forward direction in the middle. Depth is the distance along the ray.
+ */
+class CubeMapCamera : public PinholeCamera {
+ public:
+  /** @brief The faces, in the order of the stack */
+  enum class Face {
+    PositiveX,
+    NegativeX,
+    PositiveY,
+    NegativeY,
+    PositiveZ,
+    NegativeZ,
+  };
+
+  /** @brief @ref SensorSpec::sensorSubtype of the stacked faces */
+  static constexpr const char* CubeMapSubtype = "cubemap";
+
+  /** @brief @ref SensorSpec::sensorSubtype of the equirectangular panorama */
+  static constexpr const char* EquirectangularSubtype = "equirectangular";
+
+  /** @brief Whether @p spec is for a @ref CubeMapCamera */
+  static bool isCubeMapSpec(const SensorSpec& spec);
+
+  /**
+   * @brief Constructor
+   *
+   * Throws if the resolution of a @ref CubeMapSubtype spec isn't a stack of
+   * six square faces, or if the spec has an observation format or
+   * downsampling, see @ref hasConvertedObservation().
+   */
+  explicit CubeMapCamera(scene::SceneNode& cameraNode, SensorSpec::ptr spec);
+
+  virtual ~CubeMapCamera() {}
+
+  /** @brief The size of each face */
+  int faceSize() const { return faceSize_; }
+
+  /** @brief Whether the observation is an equirectangular panorama */
+  bool isEquirectangular() const { return equirectangular_; }
+
+  /**
+   * @brief The viewport of @p face in the render target
+   */
+  Magnum::Range2Di faceViewport(Face face) const;
+
+  /**
+   * @brief The size of the render target holding the stack of faces
+   */
+  virtual Magnum::Vector2i framebufferSize() const override {
+    return {faceSize_, 6 * faceSize_};
+  }
+
+  // face the render camera the way of the face being drawn
+  virtual CubeMapCamera& setTransformationMatrix(
+      gfx::RenderCamera& targetCamera) override;
+  virtual CubeMapCamera& setViewport(gfx::RenderCamera& targetCamera) override;
+
+  virtual bool getObservation(sim::Simulator& sim, Observation& obs) override;
+
+  /**
+   * @brief Draw all faces into the render target
+   */
+  virtual bool drawObservation(sim::Simulator& sim) override;
+
+  virtual bool readObservationFrom(gfx::RenderTarget& source,
+                                   Observation& obs) override;
+
+#ifndef MAGNUM_TARGET_WEBGL
+  //! a panorama is resampled from its faces on the CPU, so it only queues
+  //! the reads of a cube map
+  bool queueObservationRead() override {
+    return !equirectangular_ && PinholeCamera::queueObservationRead();
+  }
+#endif
+
+ protected:
+  //! resample the stack of faces in faces_ into the observation buffer
+  void resample(Observation& obs);
+
+#ifndef MAGNUM_TARGET_WEBGL
+  //! @ref PinholeCamera::readObservationAsync() of a panorama
+  void readEquirectangularAsync(Observation& obs);
+#endif
+
+  //! the pixel format of the stack of faces in memory
+  Magnum::PixelFormat facePixelFormat() const;
+
+  //! build sourcePixels_ and rayScales_ for the resample
+  void buildResampleTable();
+
+  int faceSize_;
+  bool equirectangular_;
+  //! the face drawn, with the camera facing its way
+  Face face_ = Face::NegativeZ;
+
+  //! the stack of faces read back for a panorama
+  core::Buffer::ptr faces_ = nullptr;
+  //! the pixel of the stack of faces for each pixel of the panorama
+  std::vector<uint32_t> sourcePixels_;
+  //! the ratio of the distance along the ray to the depth along the face axis
+  std::vector<float> rayScales_;
+
+  ESP_SMART_POINTERS(CubeMapCamera)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_CUBEMAPCAMERA_H_
@@ -0,0 +1,100 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "LidarSensor.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/sim/Simulator.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sensor {
+
+namespace {
+
+//! the value of the parameter @p name of @p spec, @p defaultValue if unset
+float parameter(const SensorSpec& spec,
+                const std::string& name,
+                float defaultValue) {
+  auto it = spec.parameters.find(name);
+  return it != spec.parameters.end() ? std::atof(it->second.c_str())
+                                     : defaultValue;
+}
+
+}  // namespace
+
+LidarSensor::LidarSensor(scene::SceneNode& node, SensorSpec::ptr spec)
+    : Sensor(node, spec),
+      maxRange_{parameter(*spec_, "max_range", 10.0f)} {
+  const int rows = spec_->resolution[0];
+  const int cols = spec_->resolution[1];
+  const Mn::Rad horizontalFov{
+      Mn::Deg{parameter(*spec_, "horizontal_fov", 360.0f)}};
+  const Mn::Rad verticalFov{Mn::Deg{parameter(*spec_, "vertical_fov", 30.0f)}};
+  if (rows <= 0 || cols <= 0 || maxRange_ <= 0.0f ||
+      float(horizontalFov) <= 0.0f || float(verticalFov) <= 0.0f) {
+    throw std::runtime_error(
+        "LidarSensor: the resolution, max_range, horizontal_fov and "
+        "vertical_fov have to be positive");
+  }
+
+  directions_.reserve(size_t(rows) * cols);
+  for (int row = 0; row != rows; ++row) {
+    // a single row looks straight ahead
+    const float elevation =
+        rows == 1 ? 0.0f : (0.5f - (row + 0.5f) / rows) * float(verticalFov);
+    for (int col = 0; col != cols; ++col) {
+      const float azimuth =
+          ((col + 0.5f) / cols - 0.5f) * float(horizontalFov);
+      directions_.emplace_back(std::sin(azimuth) * std::cos(elevation),
+                               std::sin(elevation),
+                               -std::cos(azimuth) * std::cos(elevation));
+    }
+  }
+  rays_.resize(directions_.size());
+}
+
+bool LidarSensor::getObservationSpace(ObservationSpace& space) {
+  space.spaceType = ObservationSpaceType::TENSOR;
+  space.shape = {static_cast<size_t>(spec_->resolution[0]),
+                 static_cast<size_t>(spec_->resolution[1])};
+  space.dataType = core::DataType::DT_FLOAT;
+  return true;
+}
+
+bool LidarSensor::getObservation(sim::Simulator& sim, Observation& obs) {
+  if (buffer_ == nullptr) {
+    ObservationSpace space;
+    getObservationSpace(space);
+    buffer_ = core::Buffer::create(space.shape, space.dataType);
+  }
+  obs.buffer = buffer_;
+
+  const Mn::Matrix4 absTransform = node().absoluteTransformationMatrix();
+  const Mn::Vector3 origin = absTransform.translation();
+  for (size_t i = 0; i != directions_.size(); ++i) {
+    rays_[i].origin = origin;
+    // unit length, so the hit distances are in meters
+    rays_[i].direction =
+        absTransform.transformVector(directions_[i]).normalized();
+  }
+
+  const physics::BatchRaycastResults results = sim.castRays(rays_, maxRange_);
+  float* ranges = reinterpret_cast<float*>(buffer_->data.data());
+  for (size_t i = 0; i != rays_.size(); ++i) {
+    ranges[i] = results.hasHit[i] ? float(results.rayDistances[i]) : 0.0f;
+  }
+  return true;
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,89 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_LIDARSENSOR_H_
+#define ESP_SENSOR_LIDARSENSOR_H_
+
+/** @file
+ * @brief Class @ref esp::sensor::LidarSensor
+ */
+
+#include <vector>
+
+#include <Magnum/Math/Vector3.h>
+
+#include "Sensor.h"
+#include "esp/core/esp.h"
+#include "esp/geo/geo.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief A scanning range sensor, for a sensor spec of @ref
+ * SensorType::LIDAR, casting a fixed pattern of rays from its node into the
+ * collision world in one batch per observation, see @ref
+ * sim::Simulator::castRays().
+ *
+ * The resolution is the number of rows and columns of the scan, a single row
+ * making a 2D lidar. The columns sweep the @cb{.json} "horizontal_fov" @ce
+ * parameter, 360° by default, from left to right around the forward
+ * direction of the node, at the centers of equal steps, so a full turn starts
+ * behind it. The rows sweep the @cb{.json} "vertical_fov" @ce parameter, 30°
+ * by default, from the top down, which a single row ignores, looking
+ * straight ahead.
+ *
+ * The observation is a float array of the same rows and columns with the
+ * distance to the first hit of each ray, and zero if there is none within
+ * the @cb{.json} "max_range" @ce parameter, 10 meters by default, as for
+ * the far plane of a depth sensor. Like any raycast it needs physics to be
+ * enabled, otherwise all rays miss.
+ */
+class LidarSensor : public Sensor {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * Throws if the resolution or the parameters are not positive.
+   */
+  explicit LidarSensor(scene::SceneNode& node, SensorSpec::ptr spec);
+
+  virtual ~LidarSensor() {}
+
+  /** @brief Whether @p spec is for a @ref LidarSensor */
+  static bool isLidarSpec(const SensorSpec& spec) {
+    return spec.sensorType == SensorType::LIDAR;
+  }
+
+  /** @brief The maximum distance a ray hits at */
+  float maxRange() const { return maxRange_; }
+
+  /**
+   * @brief The direction of each ray in the frame of the node, rows first
+   */
+  const std::vector<Magnum::Vector3>& rayDirections() const {
+    return directions_;
+  }
+
+  virtual bool getObservation(sim::Simulator& sim, Observation& obs) override;
+
+  virtual bool getObservationSpace(ObservationSpace& space) override;
+
+  // nothing to display
+  virtual bool displayObservation(sim::Simulator&) override { return false; }
+
+ protected:
+  float maxRange_;
+  std::vector<Magnum::Vector3> directions_;
+
+  //! the rays of the last observation, reused
+  std::vector<geo::Ray> rays_;
+
+  ESP_SMART_POINTERS(LidarSensor)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_LIDARSENSOR_H_
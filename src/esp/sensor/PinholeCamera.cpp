@@ -2,22 +2,112 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <stdexcept>
+
 #include <Magnum/ImageView.h>
 #include <Magnum/Math/Algorithms/GramSchmidt.h>
 #include <Magnum/PixelFormat.h>
+#include <Magnum/PixelStorage.h>
 
 #include "PinholeCamera.h"
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/Renderer.h"
 #include "esp/sim/Simulator.h"
 
 namespace esp {
 namespace sensor {
 
+namespace {
+using ConvertedFrame = gfx::RenderTarget::ConvertedFrame;
+
+//! the frame the render target converts the observation of spec into
+ConvertedFrame convertedFrame(const SensorSpec& spec) {
+  switch (spec.observationFormat) {
+    case ObservationFormat::RGB:
+      return ConvertedFrame::Rgb;
+    case ObservationFormat::GRAYSCALE:
+      return ConvertedFrame::Gray;
+    case ObservationFormat::HALF_DEPTH:
+      return ConvertedFrame::HalfDepth;
+    case ObservationFormat::MILLIMETER_DEPTH:
+      return ConvertedFrame::MillimeterDepth;
+    case ObservationFormat::SEMANTIC_CATEGORY:
+      return ConvertedFrame::MappedObjectId;
+    case ObservationFormat::DEFAULT:
+      break;
+  }
+  if (spec.sensorType == SensorType::SEMANTIC) {
+    return ConvertedFrame::ObjectId;
+  } else if (spec.sensorType == SensorType::DEPTH) {
+    return ConvertedFrame::Depth;
+  }
+  return ConvertedFrame::Rgba;
+}
+
+bool isDepthFormat(ObservationFormat format) {
+  return format == ObservationFormat::HALF_DEPTH ||
+         format == ObservationFormat::MILLIMETER_DEPTH;
+}
+
+//! the rendering flags of the draws, as enabled in the simulator
+gfx::RenderCamera::Flags renderCameraFlags(sim::Simulator& sim) {
+  gfx::RenderCamera::Flags flags;
+  if (sim.isFrustumCullingEnabled())
+    flags |= gfx::RenderCamera::Flag::FrustumCulling;
+  if (sim.isSortByDrawStateEnabled())
+    flags |= gfx::RenderCamera::Flag::SortByDrawState;
+  if (sim.isOcclusionCullingEnabled())
+    flags |= gfx::RenderCamera::Flag::OcclusionCulling;
+  if (sim.isPotentiallyVisibleSetEnabled())
+    flags |= gfx::RenderCamera::Flag::PotentiallyVisibleSet;
+  if (sim.isRenderListEnabled())
+    flags |= gfx::RenderCamera::Flag::RenderList;
+  if (sim.isGpuDrivenRenderEnabled())
+    flags |= gfx::RenderCamera::Flag::GpuDriven;
+  return flags;
+}
+}  // namespace
+
 PinholeCamera::PinholeCamera(scene::SceneNode& pinholeCameraNode,
                              sensor::SensorSpec::ptr spec)
     : sensor::VisualSensor(pinholeCameraNode, spec) {
   setProjectionParameters(spec);
+
+  const ObservationFormat format = spec_->observationFormat;
+  const bool isSemantic = spec_->sensorType == SensorType::SEMANTIC;
+  if (format != ObservationFormat::DEFAULT &&
+      ((format == ObservationFormat::SEMANTIC_CATEGORY) != isSemantic ||
+       isDepthFormat(format) != (spec_->sensorType == SensorType::DEPTH))) {
+    throw std::runtime_error(
+        "PinholeCamera: the observation format does not fit the sensor type");
+  }
+  const int downsampling = spec_->downsampling;
+  if (downsampling < 1 || spec_->resolution[0] % downsampling != 0 ||
+      spec_->resolution[1] % downsampling != 0) {
+    throw std::runtime_error(
+        "PinholeCamera: the downsampling has to divide the resolution");
+  }
+  if (spec_->sensorType == SensorType::NORMAL &&
+      (format != ObservationFormat::DEFAULT || downsampling != 1)) {
+    throw std::runtime_error(
+        "PinholeCamera: normals have no observation formats or downsampling");
+  }
+  if (spec_->sensorType == SensorType::OPTICAL_FLOW &&
+      (format != ObservationFormat::DEFAULT || downsampling != 1)) {
+    throw std::runtime_error(
+        "PinholeCamera: optical flow has no observation formats or "
+        "downsampling");
+  }
+}
+
+bool PinholeCamera::hasConvertedObservation() const {
+  return spec_->observationFormat != ObservationFormat::DEFAULT ||
+         spec_->downsampling != 1;
+}
+
+Magnum::Vector2i PinholeCamera::observationSize() const {
+  return framebufferSize() / spec_->downsampling;
 }
 
 void PinholeCamera::setProjectionParameters(SensorSpec::ptr spec) {
@@ -77,13 +167,28 @@ PinholeCamera& PinholeCamera::setViewport(gfx::RenderCamera& targetCamera) {
 
 bool PinholeCamera::getObservationSpace(ObservationSpace& space) {
   space.spaceType = ObservationSpaceType::TENSOR;
-  space.shape = {static_cast<size_t>(spec_->resolution[0]),
-                 static_cast<size_t>(spec_->resolution[1]),
-                 static_cast<size_t>(spec_->channels)};
+  size_t channels = spec_->channels;
+  if (spec_->observationFormat == ObservationFormat::RGB ||
+      spec_->sensorType == SensorType::NORMAL) {
+    channels = 3;
+  } else if (spec_->sensorType == SensorType::OPTICAL_FLOW) {
+    channels = 2;
+  } else if (spec_->observationFormat == ObservationFormat::GRAYSCALE) {
+    channels = 1;
+  }
+  const Magnum::Vector2i size = observationSize();
+  space.shape = {static_cast<size_t>(size.y()), static_cast<size_t>(size.x()),
+                 channels};
   space.dataType = core::DataType::DT_UINT8;
-  if (spec_->sensorType == SensorType::SEMANTIC) {
+  if (spec_->observationFormat == ObservationFormat::HALF_DEPTH) {
+    space.dataType = core::DataType::DT_FLOAT16;
+  } else if (spec_->observationFormat == ObservationFormat::MILLIMETER_DEPTH) {
+    space.dataType = core::DataType::DT_UINT16;
+  } else if (spec_->sensorType == SensorType::SEMANTIC) {
     space.dataType = core::DataType::DT_UINT32;
-  } else if (spec_->sensorType == SensorType::DEPTH) {
+  } else if (spec_->sensorType == SensorType::DEPTH ||
+             spec_->sensorType == SensorType::NORMAL ||
+             spec_->sensorType == SensorType::OPTICAL_FLOW) {
     space.dataType = core::DataType::DT_FLOAT;
   }
   return true;
@@ -97,6 +202,12 @@ bool PinholeCamera::getObservation(sim::Simulator& sim, Observation& obs) {
     return false;
 
   drawObservation(sim);
+#ifndef MAGNUM_TARGET_WEBGL
+  if (sim.isAsyncObservationReadbackEnabled()) {
+    readObservationAsync(obs);
+    return true;
+  }
+#endif
   readObservation(obs);
 
   return true;
@@ -107,12 +218,65 @@ bool PinholeCamera::drawObservation(sim::Simulator& sim) {
     return false;
   }
 
+  if (sim.isLayeredCompositionEnabled() &&
+      renderTarget().supportsLayerCache()) {
+    drawLayered(sim);
+    return true;
+  }
+
   renderTarget().renderEnter();
+  drawScene(sim);
+  renderTarget().renderExit();
 
-  gfx::RenderCamera::Flags flags;
-  if (sim.isFrustumCullingEnabled())
-    flags |= gfx::RenderCamera::Flag::FrustumCulling;
+  return true;
+}
 
+void PinholeCamera::drawLayered(sim::Simulator& sim) {
+  gfx::RenderTarget& target = renderTarget();
+  const gfx::RenderCamera::Flags flags = renderCameraFlags(sim);
+  gfx::Renderer::ptr renderer = sim.getRenderer();
+  const Magnum::Matrix4 pose = node().absoluteTransformationMatrix();
+  if (!target.hasCachedLayer() || !cachedLayer_ ||
+      cachedLayer_->pose != pose ||
+      cachedLayer_->stageEpoch != sim.getStageEpoch() ||
+      !(cachedLayer_->spec == *spec_)) {
+    target.renderEnter();
+    // a separate semantic scene graph is all stage
+    if (spec_->sensorType == SensorType::SEMANTIC &&
+        &sim.getActiveSemanticSceneGraph() != &sim.getActiveSceneGraph()) {
+      renderer->draw(*this, sim.getActiveSemanticSceneGraph(), flags);
+    } else {
+      scene::SceneGraph& sceneGraph = spec_->sensorType == SensorType::SEMANTIC
+                                          ? sim.getActiveSemanticSceneGraph()
+                                          : sim.getActiveSceneGraph();
+      renderer->draw(*this, sceneGraph,
+                     flags | gfx::RenderCamera::Flag::ExcludeObjects);
+    }
+    target.cacheLayer();
+    cachedLayer_ = CachedLayer{pose, sim.getStageEpoch(), *spec_};
+  } else {
+    target.renderEnterCachedLayer();
+  }
+
+  renderer->draw(*this, sim.getActiveSceneGraph(),
+                 flags | gfx::RenderCamera::Flag::ObjectsOnly);
+  target.renderExit();
+}
+
+bool PinholeCamera::drawStereoObservation(sim::Simulator& sim,
+                                          VisualSensor& other) {
+  if (!hasRenderTarget() || !other.hasRenderTarget() ||
+      spec_->sensorType != SensorType::DEPTH || !isStereoPairWith(other)) {
+    return false;
+  }
+
+  sim.getRenderer()->drawStereo(*this, other, sim.getActiveSceneGraph(),
+                                renderCameraFlags(sim));
+  return true;
+}
+
+void PinholeCamera::drawScene(sim::Simulator& sim) {
+  gfx::RenderCamera::Flags flags = renderCameraFlags(sim);
   gfx::Renderer::ptr renderer = sim.getRenderer();
   if (spec_->sensorType == SensorType::SEMANTIC) {
     // TODO: check sim has semantic scene graph
@@ -125,13 +289,14 @@ bool PinholeCamera::drawObservation(sim::Simulator& sim) {
     // SensorType is DEPTH or any other type
     renderer->draw(*this, sim.getActiveSceneGraph(), flags);
   }
-
-  renderTarget().renderExit();
-
-  return true;
 }
 
 void PinholeCamera::readObservation(Observation& obs) {
+  readObservationFrom(renderTarget(), obs);
+}
+
+bool PinholeCamera::readObservationFrom(gfx::RenderTarget& source,
+                                        Observation& obs) {
   // Make sure we have memory
   if (buffer_ == nullptr) {
     // TODO: check if our sensor was resized and resize our buffer if needed
@@ -141,22 +306,101 @@ void PinholeCamera::readObservation(Observation& obs) {
   }
   obs.buffer = buffer_;
 
+  if (hasConvertedObservation()) {
+    const ConvertedFrame frame = convertedFrame(*spec_);
+    // rows of RGB, single channel uint8 or 16-bit pixels are tightly packed
+    source.readFrameConverted(
+        frame, spec_->downsampling,
+        Magnum::MutableImageView2D{
+            Magnum::PixelStorage{}.setAlignment(1),
+            gfx::RenderTarget::convertedPixelFormat(frame), observationSize(),
+            obs.buffer->data});
+    return true;
+  }
+
   // TODO: have different classes for the different types of sensors
   // TODO: do we need to flip axis?
   if (spec_->sensorType == SensorType::SEMANTIC) {
-    renderTarget().readFrameObjectId(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::R32UI, renderTarget().framebufferSize(),
+    source.readFrameObjectId(Magnum::MutableImageView2D{
+        Magnum::PixelFormat::R32UI, source.framebufferSize(),
         obs.buffer->data});
   } else if (spec_->sensorType == SensorType::DEPTH) {
-    renderTarget().readFrameDepth(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::R32F, renderTarget().framebufferSize(),
+    source.readFrameDepth(Magnum::MutableImageView2D{
+        Magnum::PixelFormat::R32F, source.framebufferSize(), obs.buffer->data});
+  } else if (spec_->sensorType == SensorType::NORMAL) {
+    source.readFrameSurfaceNormals(Magnum::MutableImageView2D{
+        Magnum::PixelFormat::RGB32F, source.framebufferSize(),
+        obs.buffer->data});
+  } else if (spec_->sensorType == SensorType::OPTICAL_FLOW) {
+    source.readFrameMotionVectors(Magnum::MutableImageView2D{
+        Magnum::PixelFormat::RG32F, source.framebufferSize(),
         obs.buffer->data});
   } else {
-    renderTarget().readFrameRgba(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::RGBA8Unorm, renderTarget().framebufferSize(),
+    source.readFrameRgba(Magnum::MutableImageView2D{
+        Magnum::PixelFormat::RGBA8Unorm, source.framebufferSize(),
         obs.buffer->data});
   }
+  return true;
+}
+
+#ifndef MAGNUM_TARGET_WEBGL
+void PinholeCamera::readObservationAsync(Observation& obs) {
+  const bool hasPreviousFrame = renderTarget().numPendingAsyncReads() > 0;
+  if (!hasPreviousFrame) {
+    readObservation(obs);
+  }
+  PinholeCamera::queueObservationRead();
+  if (hasPreviousFrame) {
+    PinholeCamera::retrieveObservationRead(obs);
+  }
+}
+
+bool PinholeCamera::queueObservationRead() {
+  gfx::RenderTarget& tgt = renderTarget();
+  if (hasConvertedObservation()) {
+    tgt.readFrameConvertedAsync(convertedFrame(*spec_), spec_->downsampling);
+  } else if (spec_->sensorType == SensorType::SEMANTIC) {
+    tgt.readFrameObjectIdAsync();
+  } else if (spec_->sensorType == SensorType::DEPTH) {
+    tgt.readFrameDepthAsync();
+  } else if (spec_->sensorType == SensorType::NORMAL) {
+    tgt.readFrameSurfaceNormalsAsync();
+  } else if (spec_->sensorType == SensorType::OPTICAL_FLOW) {
+    tgt.readFrameMotionVectorsAsync();
+  } else {
+    tgt.readFrameRgbaAsync();
+  }
+  return true;
+}
+
+bool PinholeCamera::isObservationReadReady() {
+  return renderTarget().isAsyncReadReady();
+}
+
+void PinholeCamera::retrieveObservationRead(Observation& obs) {
+  if (buffer_ == nullptr) {
+    ObservationSpace space;
+    getObservationSpace(space);
+    buffer_ = core::Buffer::create(space.shape, space.dataType);
+  }
+  Magnum::PixelFormat format = Magnum::PixelFormat::RGBA8Unorm;
+  if (hasConvertedObservation()) {
+    format = gfx::RenderTarget::convertedPixelFormat(convertedFrame(*spec_));
+  } else if (spec_->sensorType == SensorType::SEMANTIC) {
+    format = Magnum::PixelFormat::R32UI;
+  } else if (spec_->sensorType == SensorType::DEPTH) {
+    format = Magnum::PixelFormat::R32F;
+  } else if (spec_->sensorType == SensorType::NORMAL) {
+    format = Magnum::PixelFormat::RGB32F;
+  } else if (spec_->sensorType == SensorType::OPTICAL_FLOW) {
+    format = Magnum::PixelFormat::RG32F;
+  }
+  obs.buffer = buffer_;
+  renderTarget().retrieveAsyncRead(Magnum::MutableImageView2D{
+      Magnum::PixelStorage{}.setAlignment(1), format, observationSize(),
+      obs.buffer->data});
 }
+#endif
 
 bool PinholeCamera::displayObservation(sim::Simulator& sim) {
   if (!hasRenderTarget()) {
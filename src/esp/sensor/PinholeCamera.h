@@ -24,6 +24,7 @@ class PinholeCamera : public VisualSensor {
   // constructor: the status of the pinhole camera is "valid" after
   // construction;
   // user can use them immediately
+  // throws if the observation format or downsampling of the spec is invalid
   explicit PinholeCamera(scene::SceneNode& pinholeCameraNode,
                          SensorSpec::ptr spec);
 
@@ -62,6 +63,38 @@ class PinholeCamera : public VisualSensor {
    */
   virtual bool drawObservation(sim::Simulator& sim) override;
 
+  virtual bool readObservationFrom(gfx::RenderTarget& source,
+                                   Observation& obs) override;
+
+#ifndef MAGNUM_TARGET_WEBGL
+  bool queueObservationRead() override;
+  bool isObservationReadReady() override;
+  void retrieveObservationRead(Observation& obs) override;
+#endif
+
+  /**
+   * @brief Draw the observations of a stereo pair of depth sensors at once,
+   * see @ref VisualSensor::drawStereoObservation()
+   *
+   * Only depth sensors are supported, whose views take a single pass where
+   * the GPU supports it, see @ref gfx::Renderer::drawStereo().
+   */
+  virtual bool drawStereoObservation(sim::Simulator& sim,
+                                     VisualSensor& other) override;
+
+  /**
+   * @brief Whether the observation is converted on the GPU, i.e. the spec
+   * has a @ref SensorSpec::observationFormat or @ref SensorSpec::downsampling
+   * other than the default. See @ref gfx::RenderTarget::readFrameConverted()
+   */
+  bool hasConvertedObservation() const;
+
+  /**
+   * @brief The size of the observation in WxH, the framebuffer size divided by
+   * @ref SensorSpec::downsampling
+   */
+  Magnum::Vector2i observationSize() const;
+
  protected:
   // projection parameters
   int width_ = 640;      // canvas width
@@ -72,12 +105,48 @@ class PinholeCamera : public VisualSensor {
 
   ESP_SMART_POINTERS(PinholeCamera)
 
+  /**
+   * @brief Draw the scene graphs of the sensor type into the bound render
+   * target, between its @ref gfx::RenderTarget::renderEnter() and
+   * @ref gfx::RenderTarget::renderExit()
+   */
+  void drawScene(sim::Simulator& sim);
+
+  /**
+   * @brief Draw the scene graphs of the sensor type into the bound render
+   * target over its cached stage layer, drawing and caching the layer first
+   * if the pose, the specification or the stage changed, see @ref
+   * sim::Simulator::setLayeredCompositionEnabled()
+   */
+  void drawLayered(sim::Simulator& sim);
+
+  //! what the layer cached by the render target was drawn from
+  struct CachedLayer {
+    Magnum::Matrix4 pose;
+    uint64_t stageEpoch;
+    SensorSpec spec;
+  };
+  Corrade::Containers::Optional<CachedLayer> cachedLayer_;
+
   /**
    * @brief Read the observation that was rendered by the simulator
    * @param[in,out] obs Instance of Observation class in which the observation
    *                    will be stored
    */
   void readObservation(Observation& obs);
+
+#ifndef MAGNUM_TARGET_WEBGL
+  /**
+   * @brief Queue an asynchronous read of the observation that was just drawn
+   * and retrieve the one drawn by the previous call.
+   *
+   * If no earlier read is in flight (e.g. on the first call), the observation
+   * just drawn is read synchronously instead so that @p obs is always valid.
+   * @param[in,out] obs Instance of Observation class in which the observation
+   *                    will be stored
+   */
+  void readObservationAsync(Observation& obs);
+#endif
 };
 
 }  // namespace sensor
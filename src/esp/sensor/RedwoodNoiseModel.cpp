@@ -4,64 +4,90 @@
 
 #include <cuda_runtime.h>
 
+#include <mutex>
+#include <set>
+
 #include "RedwoodNoiseModel.h"
 
+#include "esp/core/Profiling.h"
+#include "esp/sensor/CudaDeviceContext.h"
+
 namespace esp {
 namespace sensor {
 
 namespace {
 
-struct CudaDeviceContext {
-  explicit CudaDeviceContext(const int deviceId) {
-    cudaGetDevice(&currentDevice);
-    if (deviceId != currentDevice) {
-      cudaSetDevice(deviceId);
-      setDevice = true;
-    }
-  }
-
-  ~CudaDeviceContext() {
-    if (setDevice)
-      cudaSetDevice(currentDevice);
-  }
-
- private:
-  bool setDevice = false;
-  int currentDevice = -1;
+//! the live noise models, for RedwoodNoiseModelGPUImpl::getTotalGpuBytes()
+struct NoiseModelRegistry {
+  std::mutex mutex;
+  std::set<const RedwoodNoiseModelGPUImpl*> models;
 };
 
+NoiseModelRegistry& noiseModelRegistry() {
+  static NoiseModelRegistry registry;
+  return registry;
+}
+
 }  // namespace
 
 RedwoodNoiseModelGPUImpl::RedwoodNoiseModelGPUImpl(
     const Eigen::Ref<const Eigen::RowMatrixXf> model,
     const int gpuDeviceId,
-    const float noiseMultiplier)
-    : gpuDeviceId_{gpuDeviceId}, noiseMultiplier_{noiseMultiplier} {
+    const float noiseMultiplier,
+    const uint32_t seed)
+    : gpuDeviceId_{gpuDeviceId},
+      noiseMultiplier_{noiseMultiplier},
+      seed_{seed} {
   CudaDeviceContext ctx{gpuDeviceId_};
 
-  cudaMalloc(&devModel_, model.rows() * model.cols() * sizeof(float));
-  cudaMemcpy(devModel_, model.data(),
-             model.rows() * model.cols() * sizeof(float),
+  modelSize_ = model.rows() * model.cols();
+  cudaMalloc(&devModel_, modelSize_ * sizeof(float));
+  cudaMemcpy(devModel_, model.data(), modelSize_ * sizeof(float),
              cudaMemcpyHostToDevice);
-  curandStates_ = impl::getCurandStates();
+
+  NoiseModelRegistry& registry = noiseModelRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  registry.models.insert(this);
 }
 
 RedwoodNoiseModelGPUImpl::~RedwoodNoiseModelGPUImpl() {
+  {
+    NoiseModelRegistry& registry = noiseModelRegistry();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    registry.models.erase(this);
+  }
   CudaDeviceContext ctx{gpuDeviceId_};
 
   if (devModel_ != nullptr)
     cudaFree(devModel_);
-  impl::freeCurandStates(curandStates_);
+  if (devScratch_ != nullptr)
+    cudaFree(devScratch_);
+}
+
+size_t RedwoodNoiseModelGPUImpl::getGpuBytes() const {
+  return (modelSize_ + scratchSize_) * sizeof(float);
+}
+
+size_t RedwoodNoiseModelGPUImpl::getTotalGpuBytes() {
+  NoiseModelRegistry& registry = noiseModelRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  size_t bytes = 0;
+  for (const RedwoodNoiseModelGPUImpl* model : registry.models) {
+    bytes += model->getGpuBytes();
+  }
+  return bytes;
 }
 
 Eigen::RowMatrixXf RedwoodNoiseModelGPUImpl::simulateFromCPU(
     const Eigen::Ref<const Eigen::RowMatrixXf> depth) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
   CudaDeviceContext ctx{gpuDeviceId_};
 
   Eigen::RowMatrixXf noisyDepth(depth.rows(), depth.cols());
 
   impl::simulateFromCPU(depth.data(), depth.rows(), depth.cols(), devModel_,
-                        curandStates_, noiseMultiplier_, noisyDepth.data());
+                        seed_, numFrames_++, noiseMultiplier_,
+                        noisyDepth.data());
   return noisyDepth;
 }
 
@@ -69,9 +95,33 @@ void RedwoodNoiseModelGPUImpl::simulateFromGPU(const float* devDepth,
                                                const int rows,
                                                const int cols,
                                                float* devNoisyDepth) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
+  CudaDeviceContext ctx{gpuDeviceId_};
+  impl::simulateFromGPU(devDepth, rows, cols, devModel_, seed_,
+                        numFrames_++, noiseMultiplier_, devNoisyDepth);
+}
+
+void RedwoodNoiseModelGPUImpl::simulateInPlaceFromGPU(float* devDepth,
+                                                      const int rows,
+                                                      const int cols,
+                                                      const int numFrames,
+                                                      const bool flipped,
+                                                      void* cudaStream) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
   CudaDeviceContext ctx{gpuDeviceId_};
-  impl::simulateFromGPU(devDepth, rows, cols, devModel_, curandStates_,
-                        noiseMultiplier_, devNoisyDepth);
+
+  const size_t size = size_t(numFrames) * rows * cols;
+  if (size > scratchSize_) {
+    if (devScratch_ != nullptr)
+      cudaFree(devScratch_);
+    cudaMalloc(&devScratch_, size * sizeof(float));
+    scratchSize_ = size;
+  }
+
+  impl::simulateInPlaceFromGPU(devDepth, numFrames, rows, cols, flipped,
+                               devModel_, seed_, numFrames_, noiseMultiplier_,
+                               devScratch_, cudaStream);
+  numFrames_ += numFrames;
 }
 
 }  // namespace sensor
@@ -7,162 +7,94 @@
 #include <algorithm>
 
 #include <cuda_runtime.h>
-#include <curand_kernel.h>
+
+#include "RedwoodNoiseModelKernel.h"
 
 namespace {
-const int MODEL_N_DIMS = 5;
-const int MODEL_N_COLS = 80;
-
-// Read about the noise model here: http://www.alexteichman.com/octo/clams/
-// Original source code: http://redwood-data.org/indoor/data/simdepth.py
-__device__ float undistort(const int _x,
-                           const int _y,
-                           const float z,
-                           const float* __restrict__ model) {
-  const int i2 = (z + 1) / 2;
-  const int i1 = i2 - 1;
-  const float a = (z - (i1 * 2 + 1)) / 2.0f;
-  const int x = _x / 8;
-  const int y = _y / 6;
-
-  const float f =
-      (1 - a) *
-          model[(y * MODEL_N_COLS + x) * MODEL_N_DIMS + min(max(i1, 0), 4)] +
-      a * model[(y * MODEL_N_COLS + x) * MODEL_N_DIMS + min(i2, 4)];
-
-  if (f <= 1e-5f)
-    return 0;
-  else
-    return z / f;
-}
 
+// Each blockIdx.y processes one frame of a batch of H x W frames. Frames that
+// are flipped are stored bottom row first, as read from OpenGL. The noise of
+// a pixel is drawn from its own counter of the generator, so it doesn't
+// depend on the launch configuration.
 __global__ void redwoodNoiseModelKernel(const float* __restrict__ depth,
                                         const int H,
                                         const int W,
-                                        curandState_t* states,
+                                        const unsigned int seed,
+                                        const uint64_t firstFrame,
                                         const float* __restrict__ model,
                                         const float noiseMultiplier,
+                                        const bool flipped,
                                         float* __restrict__ noisyDepth) {
   const int TID = threadIdx.x;
   const int BID = blockIdx.x;
 
-  // curandStates are thread-safe, so all threads in a block share the same
-  // state. They are NOT block safe however
-  curandState_t curandState = states[BID];
-
-  const float ymax = H - 1;
-  const float xmax = W - 1;
+  depth += blockIdx.y * H * W;
+  noisyDepth += blockIdx.y * H * W;
 
   for (int j = BID; j < H; j += gridDim.x) {
     for (int i = TID; i < W; i += blockDim.x) {
-      // Shuffle pixels
-      const int y =
-          min(max(j + curand_normal(&curandState) * 0.25f * noiseMultiplier,
-                  0.0f),
-              ymax) +
-          0.5f;
-      const int x =
-          min(max(i + curand_normal(&curandState) * 0.25f * noiseMultiplier,
-                  0.0f),
-              xmax) +
-          0.5f;
-
-      // downsample
-      const float d = depth[(y - y % 2) * W + x - x % 2];
-      // If depth is greater than 10m, the sensor will just return a zero
-      if (d >= 10.0f) {
-        noisyDepth[j * W + i] = 0.0f;
-      } else {
-        // Distortion
-        // The noise model was originally made for a 640x480 sensor,
-        // so re-map our arbitrarily sized sensor to that size!
-        const float undistorted_d =
-            undistort(x / xmax * 639.0f, y / ymax * 479.0f, d, model);
-
-        // quantization and high freq noise
-        if (undistorted_d == 0.0f)
-          noisyDepth[j * W + i] = 0.0f;
-        else {
-          const float denom = (round(35.130f / undistorted_d +
-                                     curand_normal(&curandState) * 0.027778f *
-                                         noiseMultiplier) *
-                               8.0f);
-          noisyDepth[j * W + i] = denom > 1e-5 ? (35.130f * 8.0f / denom) : 0.0;
-        }
-      }
+      float normals[3];
+      esp::sensor::impl::redwoodPixelNormals(
+          seed, firstFrame + blockIdx.y, uint64_t(j) * W + i, normals);
+      noisyDepth[j * W + i] = esp::sensor::impl::redwoodNoisyDepth(
+          depth, H, W, j, i, normals, model, noiseMultiplier, flipped);
     }
   }
 }
 
-__global__ void curandStatesSetupKernel(curandState_t* state, int seed, int n) {
-  int id = threadIdx.x + blockIdx.x * 64;
-  if (id < n) {
-    curand_init(seed, id + 1, 0, &state[id]);
-  }
-}
-
 }  // namespace
 
 namespace esp {
 namespace sensor {
 namespace impl {
 
-struct CurandStates {
-  CurandStates() : devStates(0), n_blocks_(0) {}
-  void alloc(const int n_blocks) {
-    if (n_blocks > n_blocks_) {
-      release();
-      cudaMalloc(&devStates, n_blocks * sizeof(curandState_t));
-      curandStatesSetupKernel<<<std::max(n_blocks / 64, 1), 64>>>(
-          devStates, rand(), n_blocks);
-      n_blocks_ = n_blocks;
-    }
-  }
-
-  void release() {
-    if (devStates != 0) {
-      cudaFree(devStates);
-      devStates = 0;
-    }
-  }
-
-  ~CurandStates() { release(); }
-
-  curandState_t* devStates;
-
- private:
-  int n_blocks_;
-};
-
-CurandStates* getCurandStates() {
-  return new CurandStates();
-}
-void freeCurandStates(CurandStates* curandStates) {
-  if (curandStates != 0)
-    delete curandStates;
-}
-
 void simulateFromGPU(const float* __restrict__ devDepth,
                      const int H,
                      const int W,
                      const float* __restrict__ devModel,
-                     CurandStates* curandStates,
+                     const unsigned int seed,
+                     const uint64_t firstFrame,
                      const float noiseMultiplier,
                      float* __restrict__ devNoisyDepth) {
   const int n_threads = std::min(std::max(W / 4, 1), 256);
   const int n_blocks = std::max(H / 8, 1);
 
-  curandStates->alloc(n_blocks);
   redwoodNoiseModelKernel<<<n_blocks, n_threads>>>(
-      devDepth, H, W, curandStates->devStates, devModel, noiseMultiplier,
+      devDepth, H, W, seed, firstFrame, devModel, noiseMultiplier, false,
       devNoisyDepth);
 }
 
+void simulateInPlaceFromGPU(float* devDepth,
+                            const int N,
+                            const int H,
+                            const int W,
+                            const bool flipped,
+                            const float* __restrict__ devModel,
+                            const unsigned int seed,
+                            const uint64_t firstFrame,
+                            const float noiseMultiplier,
+                            float* __restrict__ devScratch,
+                            void* cudaStream) {
+  const auto stream = static_cast<cudaStream_t>(cudaStream);
+  const int n_threads = std::min(std::max(W / 4, 1), 256);
+  const int n_blocks = std::max(H / 8, 1);
+
+  // The kernel reads shuffled neighbours of each pixel, so the clean depth
+  // has to be kept intact until all of them are written
+  cudaMemcpyAsync(devScratch, devDepth, N * H * W * sizeof(float),
+                  cudaMemcpyDeviceToDevice, stream);
+
+  redwoodNoiseModelKernel<<<dim3(n_blocks, N), n_threads, 0, stream>>>(
+      devScratch, H, W, seed, firstFrame, devModel, noiseMultiplier, flipped,
+      devDepth);
+}
+
 void simulateFromCPU(const float* __restrict__ depth,
                      const int H,
                      const int W,
                      const float* __restrict__ devModel,
-                     CurandStates* curandStates,
+                     const unsigned int seed,
+                     const uint64_t firstFrame,
                      const float noiseMultiplier,
                      float* __restrict__ noisyDepth) {
   float *devDepth, *devNoisyDepth;
@@ -171,7 +103,7 @@ void simulateFromCPU(const float* __restrict__ depth,
 
   cudaMemcpy(devDepth, depth, H * W * sizeof(float), cudaMemcpyHostToDevice);
 
-  simulateFromGPU(devDepth, H, W, devModel, curandStates, noiseMultiplier,
+  simulateFromGPU(devDepth, H, W, devModel, seed, firstFrame, noiseMultiplier,
                   devNoisyDepth);
 
   cudaMemcpy(noisyDepth, devNoisyDepth, H * W * sizeof(float),
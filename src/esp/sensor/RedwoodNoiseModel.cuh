@@ -5,21 +5,19 @@
 #ifndef ESP_SENSOR_REDWOODNOISEMODEL_CUH_
 #define ESP_SENSOR_REDWOODNOISEMODEL_CUH_
 
+#include <cstddef>
+#include <cstdint>
+
 namespace esp {
 namespace sensor {
 namespace impl {
 
-struct CurandStates;
-
-CurandStates* getCurandStates();
-
-void freeCurandStates(CurandStates* curandStates);
-
 void simulateFromCPU(const float* __restrict__ depth,
                      const int H,
                      const int W,
                      const float* __restrict__ devModel,
-                     CurandStates* curandStates,
+                     const unsigned int seed,
+                     const uint64_t firstFrame,
                      const float noiseMultiplier,
                      float* __restrict__ noisyDepth);
 
@@ -27,9 +25,22 @@ void simulateFromGPU(const float* __restrict__ devDepth,
                      const int H,
                      const int W,
                      const float* __restrict__ devModel,
-                     CurandStates* curandStates,
+                     const unsigned int seed,
+                     const uint64_t firstFrame,
                      const float noiseMultiplier,
                      float* __restrict__ devNoisyDepth);
+
+void simulateInPlaceFromGPU(float* devDepth,
+                            const int N,
+                            const int H,
+                            const int W,
+                            const bool flipped,
+                            const float* __restrict__ devModel,
+                            const unsigned int seed,
+                            const uint64_t firstFrame,
+                            const float noiseMultiplier,
+                            float* __restrict__ devScratch,
+                            void* stream);
 }  // namespace impl
 }  // namespace sensor
 }  // namespace esp
@@ -19,6 +19,11 @@ namespace sensor {
  Depth sensors
  * provided here: http://redwood-data.org/indoor/dataset.html
  *
+ * The noise of a pixel is drawn from the counter-based generator of @ref
+ * core::Random by its index and the index of its frame since the model was
+ * created, as in @ref RedwoodNoiseModelCPUImpl, which gives the same noise
+ * for the same seed and frames.
+ *
  * Please cite the following work if you use this noise model
  * @verbatim
 @inproceedings{choi2015robust,
@@ -40,10 +45,13 @@ struct RedwoodNoiseModelGPUImpl {
    * @param noiseMultiplier   Multiplier for the Gaussian random-variables. This
    *                          can be used to increase or decrease the noise
    *                          level
+   * @param seed              The seed of the noise, the same seed gives the
+   *                          same noise for the same depth
    */
   RedwoodNoiseModelGPUImpl(const Eigen::Ref<const Eigen::RowMatrixXf> model,
                            const int gpuDeviceId,
-                           const float noiseMultiplier);
+                           const float noiseMultiplier,
+                           const uint32_t seed = std::random_device()());
 
   /**
    * @brief Simulates noisy depth from clean depth.  The input is assumed to be
@@ -74,13 +82,59 @@ struct RedwoodNoiseModelGPUImpl {
                        const int cols,
                        float* devNoisyDepth);
 
+  /**
+   * @brief Simulates noisy depth in-place on a batch of depth frames on the
+   * GPU, e.g. the output of @ref gfx::RenderTarget::readFrameDepthGPU() or
+   * @ref gfx::RenderTarget::readFramesGPU().
+   *
+   * The clean depth is staged in a scratch buffer that is kept across calls,
+   * so no memory is allocated once the largest batch has been seen. All work
+   * is queued on @p cudaStream without synchronizing.
+   *
+   * @param[in, out] devDepth  Device pointer to @p numFrames contiguous
+   *                           depth frames in row-major order, replaced
+   *                           with their noisy version
+   * @param[in] rows           The number of rows of each depth image
+   * @param[in] cols           The number of columns
+   * @param[in] numFrames      The number of frames in the batch
+   * @param[in] flipped        Whether the frames are stored bottom row
+   *                           first, as read from OpenGL
+   * @param[in] cudaStream     The `cudaStream_t` to run on, nullptr for the
+   *                           default stream
+   */
+  void simulateInPlaceFromGPU(float* devDepth,
+                              const int rows,
+                              const int cols,
+                              const int numFrames = 1,
+                              const bool flipped = false,
+                              void* cudaStream = nullptr);
+
   ~RedwoodNoiseModelGPUImpl();
 
+  /**
+   * @brief Device memory of the model and the scratch buffer, in bytes. The
+   * scratch buffer grows with the largest batch simulated so far.
+   */
+  size_t getGpuBytes() const;
+
+  /** @brief Device memory of all noise models of the process, in bytes */
+  static size_t getTotalGpuBytes();
+
+  /**
+   * @brief The number of frames simulated so far, the frame index of the
+   * noise of the next one
+   */
+  uint64_t getNumFrames() const { return numFrames_; }
+
  private:
   const int gpuDeviceId_;
   const float noiseMultiplier_;
   float* devModel_ = nullptr;
-  impl::CurandStates* curandStates_ = nullptr;
+  size_t modelSize_ = 0;
+  float* devScratch_ = nullptr;
+  size_t scratchSize_ = 0;
+  const uint32_t seed_;
+  uint64_t numFrames_ = 0;
 
   ESP_SMART_POINTERS(RedwoodNoiseModelGPUImpl)
 };
@@ -0,0 +1,99 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RedwoodNoiseModelCPU.h"
+
+#include <algorithm>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/TaskScheduler.h"
+
+#include "RedwoodNoiseModelKernel.h"
+
+namespace esp {
+namespace sensor {
+
+RedwoodNoiseModelCPUImpl::RedwoodNoiseModelCPUImpl(
+    const Eigen::Ref<const Eigen::RowMatrixXf> model,
+    const float noiseMultiplier,
+    const uint32_t seed,
+    const int numThreads)
+    : model_(model.data(), model.data() + model.rows() * model.cols()),
+      noiseMultiplier_{noiseMultiplier},
+      seed_{seed},
+      numThreads_{numThreads} {}
+
+Eigen::RowMatrixXf RedwoodNoiseModelCPUImpl::simulateFromCPU(
+    const Eigen::Ref<const Eigen::RowMatrixXf> depth) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
+  Eigen::RowMatrixXf noisyDepth(depth.rows(), depth.cols());
+  simulate(depth.data(), depth.rows(), depth.cols(), 1, false,
+           noisyDepth.data());
+  return noisyDepth;
+}
+
+void RedwoodNoiseModelCPUImpl::simulateInPlace(float* depth,
+                                               const int rows,
+                                               const int cols,
+                                               const int numFrames,
+                                               const bool flipped) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
+  // shuffled neighbours of each pixel are read, so the clean depth has to be
+  // kept intact until all of them are written
+  const size_t size = size_t(numFrames) * rows * cols;
+  if (size > scratch_.size()) {
+    scratch_.resize(size);
+  }
+  std::copy(depth, depth + size, scratch_.begin());
+  simulate(scratch_.data(), rows, cols, numFrames, flipped, depth);
+}
+
+void RedwoodNoiseModelCPUImpl::simulate(const float* depth,
+                                        const int rows,
+                                        const int cols,
+                                        const int numFrames,
+                                        const bool flipped,
+                                        float* noisyDepth) {
+  const uint64_t firstFrame = numFrames_;
+  numFrames_ += numFrames;
+  if (rows <= 0 || cols <= 0) {
+    return;
+  }
+
+  core::TaskScheduler::global().parallelForRanges(
+      size_t(numFrames) * rows, numThreads_, [&](size_t begin, size_t end) {
+        std::vector<uint32_t> bits(4 * cols);
+        std::vector<float> normals(3 * cols);
+        for (size_t row = begin; row < end; ++row) {
+          const size_t frame = row / rows;
+          const int j = row % rows;
+          const float* frameDepth = depth + frame * rows * cols;
+
+          // the random numbers of the row first, in straight loops over the
+          // pixels without branches, so that they vectorize
+          const uint64_t firstPixel = uint64_t(j) * cols;
+          for (int i = 0; i < cols; ++i) {
+            impl::philoxBlock(seed_, firstFrame + frame, firstPixel + i,
+                              &bits[4 * i]);
+          }
+          for (int i = 0; i < cols; ++i) {
+            float unused;
+            impl::boxMuller(bits[4 * i], bits[4 * i + 1], normals[3 * i],
+                            normals[3 * i + 1]);
+            impl::boxMuller(bits[4 * i + 2], bits[4 * i + 3],
+                            normals[3 * i + 2], unused);
+          }
+
+          float* out = noisyDepth + row * cols;
+          for (int i = 0; i < cols; ++i) {
+            out[i] = impl::redwoodNoisyDepth(frameDepth, rows, cols, j, i,
+                                             &normals[3 * i], model_.data(),
+                                             noiseMultiplier_, flipped);
+          }
+        }
+      });
+}
+
+}  // namespace sensor
+}  // namespace esp
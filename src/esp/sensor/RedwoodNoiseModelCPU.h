@@ -0,0 +1,113 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_REDWOODNOISEMODELCPU_H_
+#define ESP_SENSOR_REDWOODNOISEMODELCPU_H_
+
+/** @file
+ * @brief Struct @ref esp::sensor::RedwoodNoiseModelCPUImpl
+ */
+
+#include <random>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief A CPU implementation of the Redwood Noise Model for PrimeSense
+ * depth sensors, for machines without CUDA
+ *
+ * The same model as @ref RedwoodNoiseModelGPUImpl, with the same interface
+ * for depth on the CPU, and the same noise: the random numbers of a pixel are
+ * drawn from the counter-based generator of @ref core::Random, keyed by the
+ * seed, the index of the frame since the model was created and the index of
+ * the pixel. A model of each implementation with the same seed, simulating
+ * the same frames, gives the same noisy depth up to the rounding of the
+ * math functions of the host and the device.
+ *
+ * The rows are split among the threads of @ref core::TaskScheduler, and each
+ * row is simulated in passes over its pixels, the random numbers first, which
+ * the compiler vectorizes, then the lookups of the shuffled pixels.
+ */
+struct RedwoodNoiseModelCPUImpl {
+  /**
+   * @brief Constructor
+   * @param model             The distortion model from
+   *                          http://redwood-data.org/indoor/data/dist-model.txt
+   *                          The 3rd dimension is assumed to have been
+   *                          flattened into the second
+   * @param noiseMultiplier   Multiplier for the Gaussian random-variables. This
+   *                          can be used to increase or decrease the noise
+   *                          level
+   * @param seed              The seed of the noise, the same seed gives the
+   *                          same noise for the same depth
+   * @param numThreads        The most threads to simulate on, all if 0
+   */
+  RedwoodNoiseModelCPUImpl(const Eigen::Ref<const Eigen::RowMatrixXf> model,
+                           const float noiseMultiplier,
+                           const uint32_t seed = std::random_device()(),
+                           const int numThreads = 0);
+
+  /**
+   * @brief Simulates noisy depth from clean depth
+   *
+   * @param[in] depth  Clean depth, i.e. depth from habitat's depth shader
+   * @return Simulated noisy depth
+   */
+  Eigen::RowMatrixXf simulateFromCPU(
+      const Eigen::Ref<const Eigen::RowMatrixXf> depth);
+
+  /**
+   * @brief Simulates noisy depth in-place on a batch of depth frames, e.g.
+   * the observations of depth sensors
+   *
+   * The clean depth is staged in a scratch buffer that is kept across calls,
+   * so no memory is allocated once the largest batch has been seen.
+   *
+   * @param[in, out] depth  @p numFrames contiguous depth frames in row-major
+   *                        order, replaced with their noisy version
+   * @param[in] rows        The number of rows of each depth image
+   * @param[in] cols        The number of columns
+   * @param[in] numFrames   The number of frames in the batch
+   * @param[in] flipped     Whether the frames are stored bottom row first,
+   *                        as read from OpenGL
+   */
+  void simulateInPlace(float* depth,
+                       const int rows,
+                       const int cols,
+                       const int numFrames = 1,
+                       const bool flipped = false);
+
+  /**
+   * @brief The number of frames simulated so far, the frame index of the
+   * noise of the next one
+   */
+  uint64_t getNumFrames() const { return numFrames_; }
+
+ private:
+  //! simulate from @p depth into @p noisyDepth, which don't overlap
+  void simulate(const float* depth,
+                int rows,
+                int cols,
+                int numFrames,
+                bool flipped,
+                float* noisyDepth);
+
+  const std::vector<float> model_;
+  const float noiseMultiplier_;
+  const uint32_t seed_;
+  const int numThreads_;
+  uint64_t numFrames_ = 0;
+  std::vector<float> scratch_;
+
+  ESP_SMART_POINTERS(RedwoodNoiseModelCPUImpl)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_REDWOODNOISEMODELCPU_H_
@@ -0,0 +1,171 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_REDWOODNOISEMODELKERNEL_H_
+#define ESP_SENSOR_REDWOODNOISEMODELKERNEL_H_
+
+/** @file
+ * @brief The per-pixel Redwood depth noise, shared by
+ * @ref esp::sensor::RedwoodNoiseModelCPUImpl and
+ * @ref esp::sensor::RedwoodNoiseModelGPUImpl
+ *
+ * Included by both CUDA and C++ sources, so it has no dependencies and its
+ * functions compile for the host and the device.
+ */
+
+#include <cmath>
+#include <cstdint>
+
+#ifdef __CUDACC__
+#define ESP_REDWOOD_FUNCTION __host__ __device__ inline
+#else
+#define ESP_REDWOOD_FUNCTION inline
+#endif
+
+namespace esp {
+namespace sensor {
+namespace impl {
+
+//! the depth bins of each cell of the distortion model
+constexpr int RedwoodModelDims = 5;
+//! the cells of a row of the distortion model
+constexpr int RedwoodModelCols = 80;
+
+/**
+ * Block @p counter of the stream @p stream of @ref core::Random seeded with
+ * @p seed, the Philox4x32-10 generator, so the noise of a pixel depends on
+ * nothing but its index and frame
+ */
+ESP_REDWOOD_FUNCTION void philoxBlock(uint32_t seed,
+                                      uint64_t stream,
+                                      uint64_t counter,
+                                      uint32_t* out) {
+  uint32_t ctr[4]{uint32_t(counter), uint32_t(counter >> 32),
+                  uint32_t(stream), uint32_t(stream >> 32)};
+  uint32_t key[2]{seed, 0};
+  for (int round = 0; round < 10; ++round) {
+    const uint64_t product0 = uint64_t(0xD2511F53u) * ctr[0];
+    const uint64_t product1 = uint64_t(0xCD9E8D57u) * ctr[2];
+    const uint32_t next[4]{uint32_t(product1 >> 32) ^ ctr[1] ^ key[0],
+                           uint32_t(product1),
+                           uint32_t(product0 >> 32) ^ ctr[3] ^ key[1],
+                           uint32_t(product0)};
+    for (int i = 0; i < 4; ++i) {
+      ctr[i] = next[i];
+    }
+    key[0] += 0x9E3779B9u;
+    key[1] += 0xBB67AE85u;
+  }
+  for (int i = 0; i < 4; ++i) {
+    out[i] = ctr[i];
+  }
+}
+
+/**
+ * The two normally distributed numbers of Box-Muller from two uniform ones,
+ * in the order @ref core::Random::normal_float_01() returns them
+ */
+ESP_REDWOOD_FUNCTION void boxMuller(uint32_t a,
+                                    uint32_t b,
+                                    float& first,
+                                    float& second) {
+  // the 24 high bits, u1 in (0, 1] so that its log is finite
+  const float u1 = 1.0f - (a >> 8) * (1.0f / 16777216.0f);
+  const float u2 = (b >> 8) * (1.0f / 16777216.0f);
+  const float radius = sqrtf(-2.0f * logf(u1));
+  const float angle = 2.0f * 3.14159265358979f * u2;
+  first = radius * cosf(angle);
+  second = radius * sinf(angle);
+}
+
+/**
+ * The three normally distributed numbers of pixel @p pixel of frame @p frame:
+ * the row and column shuffles and the disparity noise
+ */
+ESP_REDWOOD_FUNCTION void redwoodPixelNormals(uint32_t seed,
+                                              uint64_t frame,
+                                              uint64_t pixel,
+                                              float* normals) {
+  uint32_t bits[4];
+  philoxBlock(seed, frame, pixel, bits);
+  float unused;
+  boxMuller(bits[0], bits[1], normals[0], normals[1]);
+  boxMuller(bits[2], bits[3], normals[2], unused);
+}
+
+// Read about the noise model here: http://www.alexteichman.com/octo/clams/
+// Original source code: http://redwood-data.org/indoor/data/simdepth.py
+ESP_REDWOOD_FUNCTION float redwoodUndistort(const int _x,
+                                            const int _y,
+                                            const float z,
+                                            const float* model) {
+  const int i2 = (z + 1) / 2;
+  const int i1 = i2 - 1;
+  const float a = (z - (i1 * 2 + 1)) / 2.0f;
+  const int x = _x / 8;
+  const int y = _y / 6;
+  const int cell = (y * RedwoodModelCols + x) * RedwoodModelDims;
+
+  const int lower = i1 < 0 ? 0 : (i1 > 4 ? 4 : i1);
+  const int upper = i2 > 4 ? 4 : i2;
+  const float f = (1 - a) * model[cell + lower] + a * model[cell + upper];
+
+  if (f <= 1e-5f)
+    return 0;
+  else
+    return z / f;
+}
+
+/**
+ * The noisy depth of the pixel in row @p j and column @p i of a @p H x @p W
+ * frame, stored bottom row first if @p flipped, from the clean @p depth and
+ * the @ref redwoodPixelNormals() of the pixel
+ */
+ESP_REDWOOD_FUNCTION float redwoodNoisyDepth(const float* depth,
+                                             const int H,
+                                             const int W,
+                                             const int j,
+                                             const int i,
+                                             const float* normals,
+                                             const float* model,
+                                             const float noiseMultiplier,
+                                             const bool flipped) {
+  const float ymax = H - 1;
+  const float xmax = W - 1;
+
+  // Shuffle pixels
+  const int y =
+      fminf(fmaxf(j + normals[0] * 0.25f * noiseMultiplier, 0.0f), ymax) +
+      0.5f;
+  const int x =
+      fminf(fmaxf(i + normals[1] * 0.25f * noiseMultiplier, 0.0f), xmax) +
+      0.5f;
+
+  // downsample
+  const float d = depth[(y - y % 2) * W + x - x % 2];
+  // If depth is greater than 10m, the sensor will just return a zero
+  if (d >= 10.0f)
+    return 0.0f;
+
+  // Distortion
+  // The noise model was originally made for a 640x480 sensor,
+  // so re-map our arbitrarily sized sensor to that size!
+  const float modelY = flipped ? ymax - y : y;
+  const float undistorted_d =
+      redwoodUndistort(x / xmax * 639.0f, modelY / ymax * 479.0f, d, model);
+
+  // quantization and high freq noise
+  if (undistorted_d == 0.0f)
+    return 0.0f;
+  const float denom = roundf(35.130f / undistorted_d +
+                             normals[2] * 0.027778f * noiseMultiplier) *
+                      8.0f;
+  return denom > 1e-5f ? (35.130f * 8.0f / denom) : 0.0f;
+}
+
+}  // namespace impl
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_REDWOODNOISEMODELKERNEL_H_
@@ -0,0 +1,132 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <cuda_runtime.h>
+
+#include <mutex>
+#include <set>
+
+#include "RgbNoiseModel.h"
+
+#include "esp/core/Profiling.h"
+#include "esp/sensor/CudaDeviceContext.h"
+
+namespace esp {
+namespace sensor {
+
+namespace {
+
+//! the live noise models, for RgbNoiseModelGPUImpl::getTotalGpuBytes()
+struct NoiseModelRegistry {
+  std::mutex mutex;
+  std::set<const RgbNoiseModelGPUImpl*> models;
+};
+
+NoiseModelRegistry& noiseModelRegistry() {
+  static NoiseModelRegistry registry;
+  return registry;
+}
+
+}  // namespace
+
+RgbNoiseModelGPUImpl::RgbNoiseModelGPUImpl(
+    const RgbNoiseParameters& parameters,
+    const int gpuDeviceId,
+    const uint32_t seed)
+    : parameters_{parameters}, gpuDeviceId_{gpuDeviceId}, seed_{seed} {
+  NoiseModelRegistry& registry = noiseModelRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  registry.models.insert(this);
+}
+
+RgbNoiseModelGPUImpl::~RgbNoiseModelGPUImpl() {
+  {
+    NoiseModelRegistry& registry = noiseModelRegistry();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    registry.models.erase(this);
+  }
+  CudaDeviceContext ctx{gpuDeviceId_};
+
+  if (devStaging_ != nullptr)
+    cudaFree(devStaging_);
+  if (devScratch_ != nullptr)
+    cudaFree(devScratch_);
+}
+
+size_t RgbNoiseModelGPUImpl::getGpuBytes() const {
+  return stagingSize_ + scratchSize_;
+}
+
+size_t RgbNoiseModelGPUImpl::getTotalGpuBytes() {
+  NoiseModelRegistry& registry = noiseModelRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  size_t bytes = 0;
+  for (const RgbNoiseModelGPUImpl* model : registry.models) {
+    bytes += model->getGpuBytes();
+  }
+  return bytes;
+}
+
+void RgbNoiseModelGPUImpl::reserveScratch(const size_t bytes) {
+  if (bytes > scratchSize_) {
+    if (devScratch_ != nullptr)
+      cudaFree(devScratch_);
+    cudaMalloc(&devScratch_, bytes);
+    scratchSize_ = bytes;
+  }
+}
+
+void RgbNoiseModelGPUImpl::simulateFromCPU(const uint8_t* image,
+                                           const int rows,
+                                           const int cols,
+                                           const int channels,
+                                           uint8_t* noisyImage) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
+  CudaDeviceContext ctx{gpuDeviceId_};
+
+  const size_t size = size_t(rows) * cols * channels;
+  if (size > stagingSize_) {
+    if (devStaging_ != nullptr)
+      cudaFree(devStaging_);
+    cudaMalloc(&devStaging_, size);
+    stagingSize_ = size;
+  }
+  reserveScratch(impl::rgbNoiseScratchBytes(parameters_, 1));
+
+  cudaMemcpy(devStaging_, image, size, cudaMemcpyHostToDevice);
+  impl::simulateRgbNoise(devStaging_, 1, rows, cols, channels, parameters_,
+                         seed_, frame_++, devScratch_, devStaging_, nullptr);
+  cudaMemcpy(noisyImage, devStaging_, size, cudaMemcpyDeviceToHost);
+}
+
+void RgbNoiseModelGPUImpl::simulateFromGPU(const uint8_t* devImage,
+                                           const int rows,
+                                           const int cols,
+                                           const int channels,
+                                           uint8_t* devNoisyImage) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
+  CudaDeviceContext ctx{gpuDeviceId_};
+  reserveScratch(impl::rgbNoiseScratchBytes(parameters_, 1));
+  impl::simulateRgbNoise(devImage, 1, rows, cols, channels, parameters_,
+                         seed_, frame_++, devScratch_, devNoisyImage,
+                         nullptr);
+}
+
+void RgbNoiseModelGPUImpl::simulateInPlaceFromGPU(uint8_t* devImage,
+                                                  const int rows,
+                                                  const int cols,
+                                                  const int channels,
+                                                  const int numFrames,
+                                                  void* cudaStream) {
+  core::ScopedTimer timer{core::ProfilingStage::Noise};
+  CudaDeviceContext ctx{gpuDeviceId_};
+  reserveScratch(impl::rgbNoiseScratchBytes(parameters_, numFrames));
+  impl::simulateRgbNoise(devImage, numFrames, rows, cols, channels,
+                         parameters_, seed_, frame_, devScratch_, devImage,
+                         cudaStream);
+  frame_ += numFrames;
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,200 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RgbNoiseModel.cuh"
+
+#include <algorithm>
+
+#include <cuda_runtime.h>
+
+namespace esp {
+namespace sensor {
+namespace impl {
+
+namespace {
+
+const int NumValues = 256;
+const int NumThreads = 256;
+
+// The Philox4x32-10 counter-based generator of core::Random, so that the
+// noise of an element is a pure function of the seed, the frame and the
+// element, whatever thread draws it
+struct ElementRandom {
+  __device__ ElementRandom(const uint32_t seed,
+                           const uint64_t stream,
+                           const uint32_t element)
+      : seed_{seed}, stream_{stream}, element_{element} {}
+
+  __device__ float uniform01() {
+    if (blockIndex_ == 4) {
+      block_ = nextBlock();
+      blockIndex_ = 0;
+    }
+    const uint32_t bits = blockIndex_ == 0   ? block_.x
+                          : blockIndex_ == 1 ? block_.y
+                          : blockIndex_ == 2 ? block_.z
+                                             : block_.w;
+    ++blockIndex_;
+    // the 24 high bits, the precision of a float in [0, 1)
+    return (bits >> 8) * (1.0f / 16777216.0f);
+  }
+
+  // Box-Muller, with u1 in (0, 1] so that its log is finite
+  __device__ float normal() {
+    const float u1 = 1.0f - uniform01();
+    const float u2 = uniform01();
+    return sqrtf(-2.0f * logf(u1)) * cospif(2.0f * u2);
+  }
+
+  // Knuth's multiplication for small means, the normal approximation for
+  // the large ones, which the quantization of the frame hides
+  __device__ float poisson(const float lambda) {
+    if (lambda >= 30.0f) {
+      return fmaxf(rintf(lambda + sqrtf(lambda) * normal()), 0.0f);
+    }
+    const float limit = expf(-lambda);
+    float k = 0.0f;
+    float p = uniform01();
+    while (p > limit) {
+      k += 1.0f;
+      p *= uniform01();
+    }
+    return k;
+  }
+
+ private:
+  __device__ uint4 nextBlock() {
+    uint4 ctr = make_uint4(element_, counter_++, uint32_t(stream_),
+                           uint32_t(stream_ >> 32));
+    uint2 key = make_uint2(seed_, 0);
+    for (int round = 0; round < 10; ++round) {
+      const uint32_t hi0 = __umulhi(0xD2511F53u, ctr.x);
+      const uint32_t lo0 = 0xD2511F53u * ctr.x;
+      const uint32_t hi1 = __umulhi(0xCD9E8D57u, ctr.z);
+      const uint32_t lo1 = 0xCD9E8D57u * ctr.z;
+      ctr = make_uint4(hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0);
+      key.x += 0x9E3779B9u;
+      key.y += 0xBB67AE85u;
+    }
+    return ctr;
+  }
+
+  const uint32_t seed_;
+  const uint64_t stream_;
+  const uint32_t element_;
+  //! index of the next block of the element
+  uint32_t counter_ = 0;
+  uint4 block_;
+  //! next unused number of block_, 4 when it is used up
+  int blockIndex_ = 4;
+};
+
+// Each blockIdx.y marks the values used in one frame of the batch
+__global__ void markUsedValuesKernel(const uint8_t* __restrict__ image,
+                                     const int size,
+                                     unsigned int* __restrict__ used) {
+  image += size_t(blockIdx.y) * size;
+  used += blockIdx.y * NumValues;
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < size;
+       i += gridDim.x * blockDim.x) {
+    // every writer writes the same, so the races are benign
+    used[image[i]] = 1;
+  }
+}
+
+// One block of NumValues threads per frame, levels = the number of used
+// values rounded up to a power of two
+__global__ void countLevelsKernel(const unsigned int* __restrict__ used,
+                                  float* __restrict__ levels) {
+  const int count =
+      __syncthreads_count(used[blockIdx.x * NumValues + threadIdx.x]);
+  if (threadIdx.x == 0) {
+    levels[blockIdx.x] = exp2f(ceilf(log2f(float(max(count, 1)))));
+  }
+}
+
+// Each blockIdx.y processes one frame of a batch of frames of size elements
+__global__ void rgbNoiseKernel(const uint8_t* image,
+                               const int size,
+                               const RgbNoiseParameters parameters,
+                               const uint32_t seed,
+                               const uint64_t firstFrame,
+                               const float* __restrict__ levels,
+                               uint8_t* noisyImage) {
+  image += size_t(blockIdx.y) * size;
+  noisyImage += size_t(blockIdx.y) * size;
+  const uint64_t stream = firstFrame + blockIdx.y;
+
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < size;
+       i += gridDim.x * blockDim.x) {
+    ElementRandom random{seed, stream, uint32_t(i)};
+    const float value = image[i] / 255.0f;
+    float noisy = value;
+    switch (parameters.type) {
+      case RgbNoiseType::Gaussian:
+        noisy = value + (random.normal() * parameters.sigma + parameters.mean) *
+                            parameters.intensityConstant;
+        break;
+      case RgbNoiseType::SaltAndPepper: {
+        const float u = random.uniform01();
+        if (u < parameters.amount * parameters.saltVsPepper) {
+          // as the CPU implementation does, which sets the value to 1
+          noisy = 1.0f / 255.0f;
+        } else if (u < parameters.amount) {
+          noisy = 0.0f;
+        }
+        break;
+      }
+      case RgbNoiseType::Poisson: {
+        const float level = levels[blockIdx.y];
+        noisy = random.poisson(value * level) / level;
+        break;
+      }
+    }
+    // truncated, as the CPU implementations convert back to uint8
+    noisyImage[i] = uint8_t(fminf(fmaxf(noisy, 0.0f), 1.0f) * 255.0f);
+  }
+}
+
+}  // namespace
+
+size_t rgbNoiseScratchBytes(const RgbNoiseParameters& parameters,
+                            const int numFrames) {
+  if (parameters.type != RgbNoiseType::Poisson)
+    return 0;
+  return size_t(numFrames) * (NumValues * sizeof(unsigned int) + sizeof(float));
+}
+
+void simulateRgbNoise(const uint8_t* devImage,
+                      const int N,
+                      const int H,
+                      const int W,
+                      const int C,
+                      const RgbNoiseParameters& parameters,
+                      const uint32_t seed,
+                      const uint64_t firstFrame,
+                      void* devScratch,
+                      uint8_t* devNoisyImage,
+                      void* cudaStream) {
+  const auto stream = static_cast<cudaStream_t>(cudaStream);
+  const int size = H * W * C;
+  const int n_blocks = std::max(std::min(size / (NumThreads * 4), 1024), 1);
+
+  float* devLevels = nullptr;
+  if (parameters.type == RgbNoiseType::Poisson) {
+    auto* devUsed = static_cast<unsigned int*>(devScratch);
+    devLevels = reinterpret_cast<float*>(devUsed + N * NumValues);
+    cudaMemsetAsync(devUsed, 0, N * NumValues * sizeof(unsigned int), stream);
+    markUsedValuesKernel<<<dim3(n_blocks, N), NumThreads, 0, stream>>>(
+        devImage, size, devUsed);
+    countLevelsKernel<<<N, NumValues, 0, stream>>>(devUsed, devLevels);
+  }
+
+  rgbNoiseKernel<<<dim3(n_blocks, N), NumThreads, 0, stream>>>(
+      devImage, size, parameters, seed, firstFrame, devLevels, devNoisyImage);
+}
+
+}  // namespace impl
+}  // namespace sensor
+}  // namespace esp
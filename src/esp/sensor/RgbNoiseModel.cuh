@@ -0,0 +1,62 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_RGBNOISEMODEL_CUH_
+#define ESP_SENSOR_RGBNOISEMODEL_CUH_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esp {
+namespace sensor {
+
+//! The noise of a @ref RgbNoiseModelGPUImpl
+enum class RgbNoiseType {
+  //! clamp(color + (normal * sigma + mean) * intensityConstant), in [0, 1]
+  Gaussian,
+  //! each channel set to 1 with probability amount * saltVsPepper and to 0
+  //! with probability amount * (1 - saltVsPepper)
+  SaltAndPepper,
+  //! each channel drawn from a Poisson distribution of the color times the
+  //! number of distinct values of the frame, rounded up to a power of two
+  Poisson,
+};
+
+//! The parameters of a @ref RgbNoiseModelGPUImpl, those of the Python noise
+//! models of the same name
+struct RgbNoiseParameters {
+  RgbNoiseType type = RgbNoiseType::Gaussian;
+  float intensityConstant = 0.2f;
+  float mean = 0.0f;
+  float sigma = 1.0f;
+  float saltVsPepper = 0.5f;
+  float amount = 0.05f;
+};
+
+namespace impl {
+
+//! the device scratch memory of @ref simulateRgbNoise() for @p numFrames
+size_t rgbNoiseScratchBytes(const RgbNoiseParameters& parameters,
+                            const int numFrames);
+
+//! The noise of element e of frame n is drawn from the Philox4x32-10 blocks
+//! of counter (e, i), with stream firstFrame + n and key seed, as by
+//! core::Random. @p image and @p noisyImage may be the same.
+void simulateRgbNoise(const uint8_t* devImage,
+                      const int N,
+                      const int H,
+                      const int W,
+                      const int C,
+                      const RgbNoiseParameters& parameters,
+                      const uint32_t seed,
+                      const uint64_t firstFrame,
+                      void* devScratch,
+                      uint8_t* devNoisyImage,
+                      void* stream);
+
+}  // namespace impl
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_RGBNOISEMODEL_CUH_
@@ -0,0 +1,124 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_RGBNOISEMODEL_H_
+#define ESP_SENSOR_RGBNOISEMODEL_H_
+
+#include <cstdint>
+#include <random>
+
+#include "esp/core/esp.h"
+
+#include "RgbNoiseModel.cuh"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * Provides a CUDA/GPU implementation of the Gaussian, salt and pepper and
+ * Poisson noise models of color sensors, see @ref RgbNoiseType
+ *
+ * The noise of each channel of each pixel is drawn from the same
+ * counter-based generator as @ref core::Random, keyed by the seed, with one
+ * stream per frame simulated, so the noise is reproducible whatever the
+ * batching and needs no random states on the device.
+ */
+struct RgbNoiseModelGPUImpl {
+  /**
+   * @brief Constructor
+   * @param parameters  The noise and its parameters
+   * @param gpuDeviceId The CUDA device ID to use
+   * @param seed        The seed of the noise, the same seed gives the same
+   *                    noise for the same sequence of frames
+   */
+  RgbNoiseModelGPUImpl(const RgbNoiseParameters& parameters,
+                       const int gpuDeviceId,
+                       const uint32_t seed = std::random_device()());
+
+  /**
+   * @brief Simulates a noisy color frame from a clean one.  The input and
+   * output are assumed to be on the CPU.
+   *
+   * @param[in] image       Clean color, @p rows x @p cols x @p channels
+   *                        bytes in row-major order
+   * @param[in] rows        The number of rows of the frame
+   * @param[in] cols        The number of columns
+   * @param[in] channels    The number of channels, e.g. 4 for RGBA
+   * @param[out] noisyImage Memory of the same size to write the noisy
+   *                        color to
+   */
+  void simulateFromCPU(const uint8_t* image,
+                       const int rows,
+                       const int cols,
+                       const int channels,
+                       uint8_t* noisyImage);
+
+  /**
+   * @brief Similar to @ref simulateFromCPU() but the input and output are
+   * assumed to be on the GPU.  If they aren't, bad things happen, segfaults
+   * happen.
+   */
+  void simulateFromGPU(const uint8_t* devImage,
+                       const int rows,
+                       const int cols,
+                       const int channels,
+                       uint8_t* devNoisyImage);
+
+  /**
+   * @brief Simulates noisy color in-place on a batch of color frames on the
+   * GPU, e.g. the output of @ref gfx::RenderTarget::readFrameRgbaGPU().
+   *
+   * The noise is per channel, so the row order of the frames doesn't
+   * matter. All work is queued on @p cudaStream without synchronizing.
+   *
+   * @param[in, out] devImage  Device pointer to @p numFrames contiguous
+   *                           color frames in row-major order, replaced
+   *                           with their noisy version
+   * @param[in] rows           The number of rows of each frame
+   * @param[in] cols           The number of columns
+   * @param[in] channels       The number of channels
+   * @param[in] numFrames      The number of frames in the batch
+   * @param[in] cudaStream     The `cudaStream_t` to run on, nullptr for the
+   *                           default stream
+   */
+  void simulateInPlaceFromGPU(uint8_t* devImage,
+                              const int rows,
+                              const int cols,
+                              const int channels,
+                              const int numFrames = 1,
+                              void* cudaStream = nullptr);
+
+  ~RgbNoiseModelGPUImpl();
+
+  /**
+   * @brief Device memory of the staging and scratch buffers, in bytes,
+   * which grow with the largest frames simulated so far
+   */
+  size_t getGpuBytes() const;
+
+  /** @brief Device memory of all RGB noise models of the process, in bytes */
+  static size_t getTotalGpuBytes();
+
+ private:
+  //! grow the scratch buffer to @p bytes
+  void reserveScratch(size_t bytes);
+
+  const RgbNoiseParameters parameters_;
+  const int gpuDeviceId_;
+  const uint32_t seed_;
+  //! the stream of the next frame simulated
+  uint64_t frame_ = 0;
+  //! the frames staged from the CPU
+  uint8_t* devStaging_ = nullptr;
+  size_t stagingSize_ = 0;
+  void* devScratch_ = nullptr;
+  size_t scratchSize_ = 0;
+
+  ESP_SMART_POINTERS(RgbNoiseModelGPUImpl)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_RGBNOISEMODEL_H_
@@ -4,6 +4,8 @@
 
 #include "Sensor.h"
 
+#include <iterator>
+
 #include <Magnum/EigenIntegration/Integration.h>
 
 namespace esp {
@@ -20,17 +22,42 @@ Sensor::Sensor(scene::SceneNode& node, SensorSpec::ptr spec)
   setTransformationFromSpec();
 }
 
+void Sensor::bindObservationBuffer(core::Buffer::ptr buffer) {
+  ObservationSpace space;
+  if (!getObservationSpace(space)) {
+    throw std::runtime_error("Sensor has no observation space");
+  }
+  if (buffer == nullptr || buffer->shape != space.shape ||
+      buffer->dataType != space.dataType) {
+    throw std::runtime_error(
+        "Observation buffer does not match the observation space of the "
+        "sensor");
+  }
+  buffer_ = std::move(buffer);
+}
+
 void SensorSuite::add(Sensor::ptr sensor) {
   const std::string uuid = sensor->specification()->uuid;
   sensors_[uuid] = sensor;
+
+  sensorList_.clear();
+  for (const auto& it : sensors_) {
+    sensorList_.push_back(it.second);
+  }
 }
 
 Sensor::ptr SensorSuite::get(const std::string& uuid) const {
   return (sensors_.at(uuid));
 }
 
+int SensorSuite::getSensorIndex(const std::string& uuid) const {
+  auto it = sensors_.find(uuid);
+  return it == sensors_.end() ? -1 : std::distance(sensors_.begin(), it);
+}
+
 void SensorSuite::clear() {
   sensors_.clear();
+  sensorList_.clear();
 }
 
 void Sensor::setTransformationFromSpec() {
@@ -53,7 +80,13 @@ bool operator==(const SensorSpec& a, const SensorSpec& b) {
          a.position == b.position && a.orientation == b.orientation &&
          a.resolution == b.resolution && a.channels == b.channels &&
          a.encoding == b.encoding && a.observationSpace == b.observationSpace &&
-         a.noiseModel == b.noiseModel && a.gpu2gpuTransfer == b.gpu2gpuTransfer;
+         a.noiseModel == b.noiseModel &&
+         a.noiseModelKwargs == b.noiseModelKwargs &&
+         a.gpu2gpuTransfer == b.gpu2gpuTransfer &&
+         a.observationFormat == b.observationFormat &&
+         a.downsampling == b.downsampling && a.samples == b.samples &&
+         a.renderQuality == b.renderQuality &&
+         a.updatePeriod == b.updatePeriod;
 }
 bool operator!=(const SensorSpec& a, const SensorSpec& b) {
   return !(a == b);
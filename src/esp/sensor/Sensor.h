@@ -29,6 +29,39 @@ enum class SensorType {
   FORCE = 7,
   TENSOR = 8,
   TEXT = 9,
+  // distances along a scan of rays, see LidarSensor
+  LIDAR = 10,
+  // the motion in pixels since the previous frame, see
+  // gfx::RenderTarget::readFrameMotionVectors()
+  OPTICAL_FLOW = 11,
+};
+
+// Pixel format of the observation of a visual sensor, converted on the GPU
+enum class ObservationFormat {
+  // RGBA uint8 color, float depth in meters, uint32 semantic IDs
+  DEFAULT = 0,
+  // RGB uint8 color without alpha
+  RGB = 1,
+  // single channel uint8 luma of the RGB color
+  GRAYSCALE = 2,
+  // half-precision float depth in meters
+  HALF_DEPTH = 3,
+  // uint16 depth in millimeters, clamped to 65535
+  MILLIMETER_DEPTH = 4,
+  // uint32 category indices of the semantic objects instead of their IDs,
+  // looked up on the GPU, see SemanticScene::objectCategoryIndices()
+  SEMANTIC_CATEGORY = 5,
+};
+
+// Shading a visual sensor draws the scene with, cheaper tiers skip the
+// lighting and texture fetches of the full Phong shaders
+enum class RenderQuality {
+  // the full Phong variant of each material
+  FULL = 0,
+  // albedo color and texture, without lighting
+  UNLIT = 1,
+  // vertex colors or the base color of each material, without textures
+  VERTEX_COLOR = 2,
 };
 
 enum class ObservationSpaceType {
@@ -53,7 +86,24 @@ struct SensorSpec {
   // description of Sensor observation space as gym.spaces.Dict()
   std::string observationSpace = "";
   std::string noiseModel = "None";
+  // keyword arguments of the noise model, each value JSON encoded, mirrored
+  // from noise_model_kwargs in Python, where the noise models are applied
+  std::map<std::string, std::string> noiseModelKwargs;
   bool gpu2gpuTransfer = false;
+  // pixel format of the observation of a visual sensor
+  ObservationFormat observationFormat = ObservationFormat::DEFAULT;
+  // factor the resolution is downsampled by on the GPU for the observation of
+  // a visual sensor, averaging each square of pixels, must divide it
+  int downsampling = 1;
+  // number of MSAA samples per pixel a visual sensor draws with, resolved on
+  // the GPU before the readback, clamped to what the GPU supports
+  int samples = 1;
+  // shading tier a visual sensor draws the scene with
+  RenderQuality renderQuality = RenderQuality::FULL;
+  // the sensor observes in every updatePeriod-th call of
+  // Simulator::getAgentObservations and returns its last observation in the
+  // others, with 0 it observes only on demand, by getAgentObservation
+  int updatePeriod = 1;
   ESP_SMART_POINTERS(SensorSpec)
 };
 
@@ -78,7 +128,7 @@ struct ObservationSpace {
 class Sensor : public Magnum::SceneGraph::AbstractFeature3D {
  public:
   explicit Sensor(scene::SceneNode& node, SensorSpec::ptr spec);
-  virtual ~Sensor() { LOG(INFO) << "Deconstructing Sensor"; }
+  virtual ~Sensor() { VLOG(1) << "Deconstructing Sensor"; }
 
   // Get the scene node being attached to.
   scene::SceneNode& node() { return object(); }
@@ -112,6 +162,36 @@ class Sensor : public Magnum::SceneGraph::AbstractFeature3D {
    */
   virtual bool displayObservation(sim::Simulator& sim) = 0;
 
+  /**
+   * @brief Make the sensor write its observations into @p buffer instead of
+   * a buffer it allocates itself.
+   *
+   * Register the buffer once, e.g. one wrapping caller-provided memory (see
+   * @ref core::Buffer::Buffer(void*, std::vector<size_t>, core::DataType)),
+   * and every following observation is read back directly into it.  The
+   * shape and data type of @p buffer must match @ref getObservationSpace().
+   */
+  void bindObservationBuffer(core::Buffer::ptr buffer);
+
+  /**
+   * @brief Whether the sensor has a buffer to write its observations into,
+   * bound or allocated by the first observation
+   */
+  bool hasObservationBuffer() const { return buffer_ != nullptr; }
+
+  /**
+   * @brief The buffer the sensor writes its observations into, nullptr if
+   * it has none yet
+   */
+  const core::Buffer::ptr& observationBuffer() const { return buffer_; }
+
+  /**
+   * @brief Take the observation buffer away from the sensor, e.g. to hand it
+   * to another sensor with the same observation space. The next observation
+   * allocates a new one.
+   */
+  core::Buffer::ptr releaseObservationBuffer() { return std::move(buffer_); }
+
  protected:
   SensorSpec::ptr spec_ = nullptr;
   core::Buffer::ptr buffer_ = nullptr;
@@ -126,13 +206,30 @@ class SensorSuite {
  public:
   void add(Sensor::ptr sensor);
   void clear();
-  ~SensorSuite() { LOG(INFO) << "Deconstructing SensorSuite"; }
+  ~SensorSuite() { VLOG(1) << "Deconstructing SensorSuite"; }
 
   Sensor::ptr get(const std::string& uuid) const;
   std::map<std::string, Sensor::ptr>& getSensors() { return sensors_; }
 
+  /**
+   * @brief The sensors in the order of their uuids, as in @ref getSensors().
+   * Sensor @p i is the one observation @p i is of in @ref
+   * sim::Simulator::getAgentObservations(int, std::vector<Observation>&).
+   *
+   * Kept up to date by @ref add() and @ref clear(), so the map of
+   * @ref getSensors() must not be changed directly.
+   */
+  const std::vector<Sensor::ptr>& getSensorList() const { return sensorList_; }
+
+  /**
+   * @brief The index of the sensor @p uuid in @ref getSensorList(), -1 if
+   * there is no such sensor
+   */
+  int getSensorIndex(const std::string& uuid) const;
+
  protected:
   std::map<std::string, Sensor::ptr> sensors_;
+  std::vector<Sensor::ptr> sensorList_;
 
   ESP_SMART_POINTERS(SensorSuite)
 };
@@ -0,0 +1,141 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "TopDownMapCamera.h"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/MeshTools/Compile.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include "esp/gfx/RenderTarget.h"
+#include "esp/nav/PathFinder.h"
+#include "esp/sim/Simulator.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sensor {
+
+namespace {
+
+//! the value of the parameter @p name of @p spec, @p defaultValue if unset
+float parameter(const SensorSpec& spec,
+                const std::string& name,
+                float defaultValue) {
+  auto it = spec.parameters.find(name);
+  return it != spec.parameters.end() ? std::atof(it->second.c_str())
+                                     : defaultValue;
+}
+
+}  // namespace
+
+bool TopDownMapCamera::isTopDownMapSpec(const SensorSpec& spec) {
+  return spec.sensorSubtype == Subtype;
+}
+
+TopDownMapCamera::TopDownMapCamera(scene::SceneNode& cameraNode,
+                                   SensorSpec::ptr spec)
+    : PinholeCamera(cameraNode, spec),
+      metersPerPixel_{parameter(*spec_, "meters_per_pixel", 0.1f)},
+      slabHeight_{parameter(*spec_, "slab_height", 1.0f)} {
+  if (spec_->sensorType != SensorType::COLOR) {
+    throw std::runtime_error(
+        "TopDownMapCamera: a top-down map has to be a color sensor");
+  }
+  if (metersPerPixel_ <= 0.0f || slabHeight_ <= 0.0f) {
+    throw std::runtime_error(
+        "TopDownMapCamera: meters_per_pixel and slab_height have to be "
+        "positive");
+  }
+}
+
+Mn::Matrix4 TopDownMapCamera::mapTransformationProjection() const {
+  const Mn::Matrix4 absTransform = node().absoluteTransformationMatrix();
+  const Mn::Vector3 position = absTransform.translation();
+
+  // the heading of the node, ignoring its tilt, is up on the map
+  Mn::Vector3 forward = absTransform.transformVector(-Mn::Vector3::zAxis());
+  forward.y() = 0.0f;
+  if (forward.isZero()) {
+    // looking straight up or down
+    forward = absTransform.transformVector(Mn::Vector3::yAxis());
+    forward.y() = 0.0f;
+  }
+  const Mn::Vector3 eye = position + Mn::Vector3::yAxis(0.5f * slabHeight_);
+  const Mn::Matrix4 camera =
+      Mn::Matrix4::lookAt(eye, eye - Mn::Vector3::yAxis(), forward.normalized())
+          .inverted();
+
+  const Mn::Vector2 size =
+      Mn::Vector2{framebufferSize()} * Mn::Float(metersPerPixel_);
+  return Mn::Matrix4::orthographicProjection(size, 0.0f, slabHeight_) *
+         camera;
+}
+
+void TopDownMapCamera::updateNavMesh(sim::Simulator& sim) {
+  nav::PathFinder::ptr pathfinder = sim.getPathFinder();
+  assets::MeshData::ptr navMeshData =
+      pathfinder && pathfinder->isLoaded() ? pathfinder->getNavMeshData()
+                                           : nullptr;
+  if (navMeshData == navMeshData_) {
+    return;
+  }
+  navMeshData_ = navMeshData;
+  navMesh_ = Mn::GL::Mesh{Mn::NoCreate};
+  if (!navMeshData_) {
+    return;
+  }
+
+  std::vector<Mn::Vector3> positions;
+  positions.reserve(navMeshData_->vbo.size());
+  for (const vec3f& vertex : navMeshData_->vbo) {
+    positions.emplace_back(vertex);
+  }
+  const Mn::Trade::MeshData mesh{
+      Mn::MeshPrimitive::Triangles,
+      {},
+      navMeshData_->ibo,
+      Mn::Trade::MeshIndexData{navMeshData_->ibo},
+      {},
+      positions,
+      {Mn::Trade::MeshAttributeData{Mn::Trade::MeshAttribute::Position,
+                                    Cr::Containers::arrayView(positions)}}};
+  navMesh_ = Mn::MeshTools::compile(mesh);
+}
+
+bool TopDownMapCamera::drawObservation(sim::Simulator& sim) {
+  if (!hasRenderTarget()) {
+    return false;
+  }
+  updateNavMesh(sim);
+
+  gfx::RenderTarget& tgt = renderTarget();
+  tgt.renderEnter();
+  if (navMeshData_) {
+    if (!shader_) {
+      shader_ = std::make_unique<Mn::Shaders::Flat3D>();
+    }
+    shader_->setColor(Mn::Color4{1.0f})
+        .setTransformationProjectionMatrix(mapTransformationProjection());
+    // the winding of the triangles seen from above is not guaranteed
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+    shader_->draw(navMesh_);
+    Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
+  }
+  tgt.renderExit();
+
+  return true;
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,100 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_TOPDOWNMAPCAMERA_H_
+#define ESP_SENSOR_TOPDOWNMAPCAMERA_H_
+
+/** @file
+ * @brief Class @ref esp::sensor::TopDownMapCamera
+ */
+
+#include <memory>
+
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Shaders/Flat.h>
+
+#include "PinholeCamera.h"
+#include "esp/assets/MeshData.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief An egocentric top-down map of the navigable area around its node,
+ * for a color sensor spec with the @ref TopDownMapCamera::Subtype subtype.
+ *
+ * Instead of the scene, draws the triangles of the navmesh of the simulator,
+ * see @ref nav::PathFinder::getNavMeshData(), in white on black with an
+ * orthographic projection looking down. The map is centered on the node and
+ * rotated with its heading, so that its forward direction points up the
+ * image and its right to the right. Only the navmesh within a slab around
+ * the height of the node is drawn, keeping the other floors of a building
+ * out, so the sensor is best placed at the height of the agent.
+ *
+ * The @cb{.json} "meters_per_pixel" @ce parameter, 0.1 by default, is the
+ * size of a pixel on the ground and the @cb{.json} "slab_height" @ce
+ * parameter, 1.0 by default, the height of the slab centered on the node.
+ * With the @ref ObservationFormat::GRAYSCALE observation format, the map is
+ * a single channel with 255 for navigable.
+ *
+ * The navmesh is uploaded once and again only when the path finder
+ * recomputes it, so a map costs a single draw per observation.
+ */
+class TopDownMapCamera : public PinholeCamera {
+ public:
+  /** @brief @ref SensorSpec::sensorSubtype of the top-down map */
+  static constexpr const char* Subtype = "topdown_map";
+
+  /** @brief Whether @p spec is for a @ref TopDownMapCamera */
+  static bool isTopDownMapSpec(const SensorSpec& spec);
+
+  /**
+   * @brief Constructor
+   *
+   * Throws if the spec is not of a @ref SensorType::COLOR sensor, or if its
+   * parameters are not positive.
+   */
+  explicit TopDownMapCamera(scene::SceneNode& cameraNode,
+                            SensorSpec::ptr spec);
+
+  virtual ~TopDownMapCamera() {}
+
+  /** @brief The size of a pixel of the map on the ground */
+  float metersPerPixel() const { return metersPerPixel_; }
+
+  /** @brief The height of the slab of the navmesh drawn */
+  float slabHeight() const { return slabHeight_; }
+
+  /**
+   * @brief The projection and camera matrix the map is drawn with, from the
+   * current transformation of the node
+   */
+  Magnum::Matrix4 mapTransformationProjection() const;
+
+  /**
+   * @brief Draw the navmesh into the render target
+   */
+  virtual bool drawObservation(sim::Simulator& sim) override;
+
+ protected:
+  //! upload the navmesh of @p sim if it changed since the last draw
+  void updateNavMesh(sim::Simulator& sim);
+
+  float metersPerPixel_;
+  float slabHeight_;
+
+  //! the navmesh data navMesh_ was made from, to detect a recomputed one
+  assets::MeshData::ptr navMeshData_ = nullptr;
+  Magnum::GL::Mesh navMesh_{Magnum::NoCreate};
+  std::unique_ptr<Magnum::Shaders::Flat3D> shader_;
+
+  ESP_SMART_POINTERS(TopDownMapCamera)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_TOPDOWNMAPCAMERA_H_
@@ -3,6 +3,10 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "VisualSensor.h"
+
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/TypeTraits.h>
+
 #include "esp/gfx/RenderTarget.h"
 
 namespace esp {
@@ -19,5 +23,42 @@ void VisualSensor::bindRenderTarget(gfx::RenderTarget::uptr&& tgt) {
   tgt_ = std::move(tgt);
 }
 
+bool VisualSensor::isColocatedWith(const VisualSensor& other) const {
+  const SensorSpec& spec = *spec_;
+  const SensorSpec& otherSpec = *other.spec_;
+  return spec.sensorSubtype == otherSpec.sensorSubtype &&
+         spec.resolution == otherSpec.resolution &&
+         spec.samples == otherSpec.samples &&
+         spec.parameters == otherSpec.parameters &&
+         node().absoluteTransformation() ==
+             other.node().absoluteTransformation();
+}
+
+bool VisualSensor::isStereoPairWith(const VisualSensor& other) const {
+  const SensorSpec& spec = *spec_;
+  const SensorSpec& otherSpec = *other.spec_;
+  if (spec.sensorType != otherSpec.sensorType ||
+      spec.sensorSubtype != otherSpec.sensorSubtype ||
+      spec.resolution != otherSpec.resolution ||
+      spec.samples != otherSpec.samples ||
+      spec.parameters != otherSpec.parameters) {
+    return false;
+  }
+  const Magnum::Matrix4 transformation = node().absoluteTransformationMatrix();
+  const Magnum::Matrix4 otherTransformation =
+      other.node().absoluteTransformationMatrix();
+  if (transformation.rotationScaling() !=
+      otherTransformation.rotationScaling()) {
+    return false;
+  }
+  // the baseline, in the space of this sensor
+  const Magnum::Vector3 offset =
+      transformation.inverted().transformPoint(
+          otherTransformation.translation());
+  return offset.x() != 0.0f &&
+         Magnum::Math::TypeTraits<float>::equals(offset.y(), 0.0f) &&
+         Magnum::Math::TypeTraits<float>::equals(offset.z(), 0.0f);
+}
+
 }  // namespace sensor
 }  // namespace esp
@@ -30,7 +30,7 @@ class VisualSensor : public Sensor {
    * @brief Return the size of the framebuffer corresponding to the sensor's
    * resolution as a [W, H] Vector2i
    */
-  Magnum::Vector2i framebufferSize() const {
+  virtual Magnum::Vector2i framebufferSize() const {
     // NB: The sensor's resolution is in H x W format as that more cleanly
     // corresponds to the practice of treating images as arrays that is used in
     // modern CV and DL. However, graphics frameworks expect W x H format for
@@ -89,6 +89,14 @@ class VisualSensor : public Sensor {
    */
   void bindRenderTarget(std::unique_ptr<gfx::RenderTarget>&& tgt);
 
+  /**
+   * @brief Take the render target away from the sensor, which has none
+   * afterwards. See @ref gfx::Renderer::releaseRenderTarget()
+   */
+  std::unique_ptr<gfx::RenderTarget> releaseRenderTarget() {
+    return std::move(tgt_);
+  }
+
   /**
    * @brief Returns a reference to the sensors render target
    */
@@ -108,6 +116,78 @@ class VisualSensor : public Sensor {
     return false;
   }
 
+  /**
+   * @brief Read the observation of this sensor from a render target that
+   * another, co-located sensor has drawn into.  See @ref isColocatedWith()
+   * @return true if success, otherwise false (e.g., not supported by the
+   * sensor)
+   * @param[in] source The render target holding the drawn frame
+   * @param[in,out] obs Instance of Observation class in which the observation
+   *                    will be stored
+   */
+  virtual bool readObservationFrom(CORRADE_UNUSED gfx::RenderTarget& source,
+                                   CORRADE_UNUSED Observation& obs) {
+    return false;
+  }
+
+  /**
+   * @brief Queue an asynchronous read of the observation just drawn, to be
+   * retrieved with @ref retrieveObservationRead() once
+   * @ref isObservationReadReady()
+   * @return false if the sensor can't read asynchronously, e.g. it resamples
+   * its frame on the CPU, nothing is queued then
+   */
+  virtual bool queueObservationRead() { return false; }
+
+  /**
+   * @brief Whether the GPU finished the oldest read queued with @ref
+   * queueObservationRead(), so that retrieving it won't wait
+   */
+  virtual bool isObservationReadReady() { return true; }
+
+  /**
+   * @brief Retrieve the oldest read queued with @ref queueObservationRead()
+   * into the observation buffer of the sensor, waiting for the GPU if needed
+   * @param[in,out] obs Instance of Observation class in which the observation
+   *                    will be stored
+   */
+  virtual void retrieveObservationRead(CORRADE_UNUSED Observation& obs) {}
+
+  /**
+   * @brief Whether this sensor sees exactly what @p other sees, i.e. both
+   * share the same pose, projection model, projection parameters,
+   * resolution and sample count.  A single draw then yields the color, depth
+   * and object id observations of both.
+   */
+  bool isColocatedWith(const VisualSensor& other) const;
+
+  /**
+   * @brief Whether this sensor and @p other are the two eyes of a stereo
+   * pair, i.e. both share the sensor type, orientation, projection model,
+   * projection parameters, resolution and sample count, and are offset
+   * along their X axis only.  Both views can then be drawn at once, see
+   * @ref drawStereoObservation().
+   */
+  bool isStereoPairWith(const VisualSensor& other) const;
+
+  /**
+   * @brief Draw the observations of this sensor and of @p other, a stereo
+   * pair, into their render targets at once, see @ref isStereoPairWith()
+   * and @ref gfx::Renderer::drawStereo()
+   * @return true if success, otherwise false (e.g., not supported by the
+   * sensor or not a stereo pair), in which case neither is drawn
+   * @param[in] sim Instance of Simulator class for which the observations
+   *                need to be drawn
+   * @param[in] other The other sensor of the pair
+   *
+   * The observations are then read by @ref readObservationFrom() with the
+   * render target of each sensor.
+   */
+  virtual bool drawStereoObservation(CORRADE_UNUSED sim::Simulator& sim,
+                                     CORRADE_UNUSED VisualSensor& other) {
+    return false;
+  }
+
  protected:
   std::unique_ptr<gfx::RenderTarget> tgt_;
 
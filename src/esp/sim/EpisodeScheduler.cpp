@@ -0,0 +1,192 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "EpisodeScheduler.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "Simulator.h"
+
+namespace esp {
+namespace sim {
+
+namespace {
+
+template <class T>
+void shuffle(std::vector<T>& values, core::Random& random) {
+  for (size_t i = values.size(); i > 1; --i) {
+    std::swap(values[i - 1], values[random.uniform_uint() % i]);
+  }
+}
+
+}  // namespace
+
+EpisodeScheduler::EpisodeScheduler(
+    const std::vector<std::string>& episodeScenes,
+    int numWorkers,
+    const Configuration& configuration)
+    : configuration_{configuration} {
+  // one shard of all episodes of each scene, in the order of the dataset
+  std::unordered_map<std::string, size_t> sceneIndices;
+  std::vector<Shard> shards;
+  for (size_t episode = 0; episode < episodeScenes.size(); ++episode) {
+    const auto inserted =
+        sceneIndices.emplace(episodeScenes[episode], scenes_.size());
+    if (inserted.second) {
+      scenes_.push_back(episodeScenes[episode]);
+      shards.push_back({inserted.first->second, {}});
+    }
+    episodeScenes_.push_back(inserted.first->second);
+    shards[inserted.first->second].episodes.push_back(episode);
+  }
+
+  // split the scenes larger than the share of a worker, then the largest
+  // shards until each worker can get one
+  workers_.resize(std::max(numWorkers, 1));
+  const size_t share =
+      std::max<size_t>((episodeScenes.size() + workers_.size() - 1) /
+                           workers_.size(),
+                       1);
+  for (size_t i = 0; i < shards.size(); ++i) {
+    while (shards[i].episodes.size() > share) {
+      Shard rest{shards[i].scene,
+                 std::vector<size_t>(shards[i].episodes.begin() + share,
+                                     shards[i].episodes.end())};
+      shards[i].episodes.resize(share);
+      shards.push_back(std::move(rest));
+    }
+  }
+  const auto bySize = [](const Shard& a, const Shard& b) {
+    return a.episodes.size() > b.episodes.size();
+  };
+  while (shards.size() < workers_.size()) {
+    auto largest = std::min_element(shards.begin(), shards.end(), bySize);
+    if (largest == shards.end() || largest->episodes.size() < 2) {
+      break;
+    }
+    const size_t half = largest->episodes.size() / 2;
+    Shard rest{largest->scene,
+               std::vector<size_t>(largest->episodes.begin() + half,
+                                   largest->episodes.end())};
+    largest->episodes.resize(half);
+    shards.push_back(std::move(rest));
+  }
+
+  // the largest shards first, each to the worker with the fewest episodes
+  std::stable_sort(shards.begin(), shards.end(), bySize);
+  std::vector<size_t> numEpisodes(workers_.size(), 0);
+  for (Shard& shard : shards) {
+    const size_t worker =
+        std::min_element(numEpisodes.begin(), numEpisodes.end()) -
+        numEpisodes.begin();
+    numEpisodes[worker] += shard.episodes.size();
+    // the shards of one scene on a worker are one visit
+    std::vector<Shard>& workerShards = workers_[worker].shards;
+    auto same = std::find_if(
+        workerShards.begin(), workerShards.end(),
+        [&](const Shard& other) { return other.scene == shard.scene; });
+    if (same == workerShards.end()) {
+      workerShards.push_back(std::move(shard));
+    } else {
+      same->episodes.insert(same->episodes.end(), shard.episodes.begin(),
+                            shard.episodes.end());
+    }
+  }
+
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i].random = core::Random(configuration_.seed, i);
+    scheduleEpoch(workers_[i]);
+  }
+}
+
+std::vector<std::string> EpisodeScheduler::getWorkerScenes(
+    const int worker) const {
+  std::vector<std::string> scenes;
+  for (const Shard& shard : workers_[worker].shards) {
+    scenes.push_back(scenes_[shard.scene]);
+  }
+  return scenes;
+}
+
+size_t EpisodeScheduler::getNumWorkerEpisodes(const int worker) const {
+  size_t count = 0;
+  for (const Shard& shard : workers_[worker].shards) {
+    count += shard.episodes.size();
+  }
+  return count;
+}
+
+void EpisodeScheduler::scheduleEpoch(Worker& worker) {
+  std::vector<Shard> shards = worker.shards;
+  if (configuration_.shuffle) {
+    shuffle(shards, worker.random);
+    for (Shard& shard : shards) {
+      shuffle(shard.episodes, worker.random);
+    }
+  }
+  // the epoch starts in the scene the last one ended in
+  auto current =
+      std::find_if(shards.begin(), shards.end(), [&](const Shard& shard) {
+        return shard.scene == worker.scene;
+      });
+  if (current != shards.end()) {
+    std::rotate(shards.begin(), current, current + 1);
+  }
+
+  const size_t perVisit = configuration_.episodesPerVisit;
+  std::vector<size_t> next(shards.size(), 0);
+  bool remaining = true;
+  while (remaining) {
+    remaining = false;
+    for (size_t i = 0; i < shards.size(); ++i) {
+      const std::vector<size_t>& episodes = shards[i].episodes;
+      const size_t end = perVisit == 0
+                             ? episodes.size()
+                             : std::min(episodes.size(), next[i] + perVisit);
+      worker.queue.insert(worker.queue.end(), episodes.begin() + next[i],
+                          episodes.begin() + end);
+      next[i] = end;
+      remaining |= end < episodes.size();
+    }
+  }
+}
+
+size_t EpisodeScheduler::nextEpisode(const int worker) {
+  Worker& state = workers_[worker];
+  if (state.queue.empty()) {
+    return ~size_t{};
+  }
+  const size_t episode = state.queue.front();
+  state.queue.pop_front();
+  if (episodeScenes_[episode] != state.scene) {
+    state.scene = episodeScenes_[episode];
+    ++state.numSceneSwitches;
+  }
+  if (state.queue.empty()) {
+    scheduleEpoch(state);
+  }
+  return episode;
+}
+
+size_t EpisodeScheduler::nextEpisode(const int worker, Simulator& simulator) {
+  const size_t episode = nextEpisode(worker);
+  const Worker& state = workers_[worker];
+  if (!state.queue.empty() &&
+      episodeScenes_[state.queue.front()] != state.scene) {
+    simulator.prefetchScene(scenes_[episodeScenes_[state.queue.front()]]);
+  }
+  return episode;
+}
+
+const std::string& EpisodeScheduler::peekNextScene(const int worker) const {
+  static const std::string none;
+  const Worker& state = workers_[worker];
+  return state.queue.empty() ? none
+                             : scenes_[episodeScenes_[state.queue.front()]];
+}
+
+}  // namespace sim
+}  // namespace esp
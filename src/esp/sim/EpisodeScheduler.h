@@ -0,0 +1,145 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_EPISODESCHEDULER_H_
+#define ESP_SIM_EPISODESCHEDULER_H_
+
+/** @file
+ * @brief Class @ref esp::sim::EpisodeScheduler
+ */
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/core/random.h"
+
+namespace esp {
+namespace sim {
+
+class Simulator;
+
+/**
+ * @brief Orders the episodes of a dataset for a group of workers so that
+ * each runs the episodes of a scene in a row, switching scenes rarely
+ *
+ * The episodes are grouped by scene and the scenes are split among the
+ * workers, balancing the number of episodes. A scene with more episodes than
+ * a worker's share is split among several workers, so that every worker has
+ * episodes as long as there are at least as many episodes as workers. Each
+ * worker runs through the episodes of its scenes once per epoch, visiting
+ * its scenes in turn for up to @ref Configuration::episodesPerVisit episodes
+ * each, in an order shuffled anew each epoch. @ref nextEpisode(int,
+ * Simulator&) prefetches the scene of the episode after a switch, so it is
+ * decoded while the current one runs.
+ *
+ * Workers have separate states, so different workers may be scheduled from
+ * different threads, each worker from one thread at a time.
+ */
+class EpisodeScheduler {
+ public:
+  /** @brief The mixing of the scenes */
+  struct Configuration {
+    /**
+     * The most episodes of a scene in a row before the worker visits its
+     * next scene, 0 for all of them. Trades scene switches for a mix of
+     * scenes closer to the shuffled dataset.
+     */
+    size_t episodesPerVisit = 0;
+    //! Whether to shuffle the scenes and episodes of each worker each epoch
+    bool shuffle = true;
+    //! The seed of the shuffles, each worker shuffles with a stream of it
+    unsigned int seed = 0;
+  };
+
+  /**
+   * @brief Schedule the episodes of a dataset
+   * @param episodeScenes The scene of each episode
+   * @param numWorkers The number of workers, at least 1
+   * @param configuration The mixing
+   */
+  explicit EpisodeScheduler(const std::vector<std::string>& episodeScenes,
+                            int numWorkers,
+                            const Configuration& configuration = {});
+
+  /** @brief The number of workers */
+  int getNumWorkers() const { return workers_.size(); }
+
+  /** @brief The scene of @p episode */
+  const std::string& getScene(size_t episode) const {
+    return scenes_[episodeScenes_[episode]];
+  }
+
+  /** @brief The scenes of the worker @p worker, each once */
+  std::vector<std::string> getWorkerScenes(int worker) const;
+
+  /**
+   * @brief The number of episodes the worker @p worker runs per epoch
+   */
+  size_t getNumWorkerEpisodes(int worker) const;
+
+  /**
+   * @brief The next episode of the worker @p worker, starting a new epoch
+   * after its last one
+   * @return The index of the episode in the dataset, or ~size_t{} if the
+   * worker has no episodes
+   */
+  size_t nextEpisode(int worker);
+
+  /**
+   * @brief Like @ref nextEpisode(int), prefetching the scene of the episode
+   * after it in @p simulator if it is another scene, see
+   * @ref Simulator::prefetchScene()
+   */
+  size_t nextEpisode(int worker, Simulator& simulator);
+
+  /**
+   * @brief The scene of the episode the next @ref nextEpisode() of @p worker
+   * returns, an empty string if the worker has no episodes
+   */
+  const std::string& peekNextScene(int worker) const;
+
+  /**
+   * @brief The number of episodes of the worker @p worker in another scene
+   * than the episode before them, the first one included
+   */
+  size_t getNumSceneSwitches(int worker) const {
+    return workers_[worker].numSceneSwitches;
+  }
+
+ private:
+  //! episodes of one scene given to one worker
+  struct Shard {
+    size_t scene;
+    std::vector<size_t> episodes;
+  };
+
+  struct Worker {
+    std::vector<Shard> shards;
+    //! the episodes of the current epoch not returned yet
+    std::deque<size_t> queue;
+    core::Random random;
+    //! the scene of the last returned episode, ~size_t{} before the first
+    size_t scene = ~size_t{};
+    size_t numSceneSwitches = 0;
+  };
+
+  //! queue the episodes of the next epoch of @p worker
+  void scheduleEpoch(Worker& worker);
+
+  Configuration configuration_;
+  std::vector<std::string> scenes_;
+  //! the index into scenes_ of each episode
+  std::vector<size_t> episodeScenes_;
+  std::vector<Worker> workers_;
+
+  ESP_SMART_POINTERS(EpisodeScheduler)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_EPISODESCHEDULER_H_
@@ -0,0 +1,567 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObservationDataset.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Corrade/Utility/String.h>
+
+#include "esp/core/Compression.h"
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace sim {
+
+namespace {
+
+constexpr uint32_t ObservationDatasetMagic = 0x31444f48;  // "HOD1"
+constexpr uint32_t ObservationDatasetVersion = 2;
+
+//! the alignment of the fields of a chunk in a shard, so that they can be
+//! viewed in place as arrays of any type
+constexpr uint64_t ChunkAlignment = 64;
+
+bool isShardFile(const std::string& filename) {
+  return Cr::Utility::String::beginsWith(filename, "shard-") &&
+         Cr::Utility::String::endsWith(filename, ".hod");
+}
+
+size_t byteSize(const core::SharedMemoryRing::Field& field) {
+  size_t size = core::getDataTypeByteSize(field.dataType);
+  for (size_t dimension : field.shape) {
+    size *= dimension;
+  }
+  return size;
+}
+
+bool operator==(const core::SharedMemoryRing::Field& a,
+                const core::SharedMemoryRing::Field& b) {
+  return a.name == b.name && a.shape == b.shape && a.dataType == b.dataType;
+}
+
+//! XOR each record of @p data with the one before it, into @p out
+void deltaEncode(Cr::Containers::ArrayView<const char> data,
+                 size_t recordSize,
+                 std::vector<unsigned char>& out) {
+  out.assign(data.begin(), data.end());
+  for (size_t i = recordSize; i < out.size(); ++i) {
+    out[i] ^= data[i - recordSize];
+  }
+}
+
+//! reads values and arrays out of a mapped shard, failing past its end
+class Reader {
+ public:
+  explicit Reader(Cr::Containers::ArrayView<const char> data) : data_{data} {}
+
+  template <class T>
+  bool read(T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    return readBytes(&value, sizeof(T));
+  }
+
+  bool readBytes(void* out, size_t size) {
+    if (size > data_.size() - pos_) {
+      return false;
+    }
+    std::memcpy(out, data_.data() + pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  void seek(size_t position) { pos_ = std::min(position, data_.size()); }
+  size_t remaining() const { return data_.size() - pos_; }
+
+ private:
+  Cr::Containers::ArrayView<const char> data_;
+  size_t pos_ = 0;
+};
+
+//! decompress @p data into all of @p out and undo deltaEncode()
+bool decodeDeltaLz(Cr::Containers::ArrayView<const char> data,
+                   size_t recordSize,
+                   Cr::Containers::ArrayView<char> out) {
+  if (!core::decompressBytes(
+          reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+          reinterpret_cast<unsigned char*>(out.data()), out.size())) {
+    return false;
+  }
+  for (size_t j = recordSize; j < out.size(); ++j) {
+    out[j] ^= out[j - recordSize];
+  }
+  return true;
+}
+
+}  // namespace
+
+struct ObservationDatasetWriter::Impl {
+  Impl(const std::string& directory,
+       const std::vector<Field>& fields,
+       const Configuration& configuration)
+      : fields_{fields},
+        directory_{directory},
+        configuration_{configuration} {
+    configuration_.recordsPerChunk =
+        std::max<size_t>(configuration_.recordsPerChunk, 1);
+    configuration_.chunksPerShard =
+        std::max<size_t>(configuration_.chunksPerShard, 1);
+    configuration_.maxPendingRecords =
+        std::max<size_t>(configuration_.maxPendingRecords, 1);
+    for (const Field& field : fields_) {
+      fieldSizes_.push_back(byteSize(field));
+      recordSize_ += fieldSizes_.back();
+      chunkFields_.emplace_back(Cr::Containers::ValueInit,
+                                configuration_.recordsPerChunk *
+                                    fieldSizes_.back());
+    }
+
+    if (!Cr::Utility::Directory::mkpath(directory_)) {
+      LOG(ERROR) << "ObservationDatasetWriter : Cannot create " << directory_;
+      good_ = false;
+    }
+    // the shards of an earlier dataset would be read with these
+    for (const std::string& file : Cr::Utility::Directory::list(directory_)) {
+      if (!isShardFile(file)) {
+        continue;
+      }
+      const std::string shard = Cr::Utility::Directory::join(directory_, file);
+      if (!configuration_.overwrite) {
+        LOG(ERROR) << "ObservationDatasetWriter : " << directory_
+                   << " already has shards, enable overwrite to replace them";
+        good_ = false;
+        break;
+      }
+      if (!Cr::Utility::Directory::rm(shard)) {
+        LOG(ERROR) << "ObservationDatasetWriter : Cannot delete " << shard;
+        good_ = false;
+        break;
+      }
+    }
+    if (!good_) {
+      stopped_ = true;
+      return;
+    }
+    worker_ = std::thread{[this]() { run(); }};
+  }
+
+  ~Impl() { close(); }
+
+  bool push(const std::vector<Cr::Containers::ArrayView<const char>>& data) {
+    if (data.size() != fields_.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (data[i].size() != fieldSizes_[i]) {
+        return false;
+      }
+    }
+    Cr::Containers::Array<char> record{Cr::Containers::NoInit, recordSize_};
+    size_t offset = 0;
+    for (const Cr::Containers::ArrayView<const char>& field : data) {
+      std::memcpy(record.data() + offset, field.data(), field.size());
+      offset += field.size();
+    }
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    written_.wait(lock, [this]() {
+      return stopped_ ||
+             records_.size() + numWriting_ < configuration_.maxPendingRecords;
+    });
+    // the thread may have written its last chunk already
+    if (stopped_) {
+      return false;
+    }
+    records_.push_back(std::move(record));
+    ++numRecords_;
+    queued_.notify_one();
+    return true;
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    written_.wait(lock,
+                  [this]() { return records_.empty() && numWriting_ == 0; });
+  }
+
+  bool close() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopped_ = true;
+    }
+    queued_.notify_all();
+    written_.notify_all();
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    return good_;
+  }
+
+  size_t numRecords() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return numRecords_;
+  }
+
+  const std::vector<Field> fields_;
+  std::vector<size_t> fieldSizes_;
+  //! set by the thread, read by any
+  std::atomic<bool> good_{true};
+
+ private:
+  //! one chunk of the index of a shard
+  struct Chunk {
+    uint32_t numRecords;
+    std::vector<std::pair<uint64_t, uint64_t>> fields;
+  };
+
+  void run() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (true) {
+      queued_.wait(lock, [this]() { return stopped_ || !records_.empty(); });
+      if (records_.empty()) {
+        lock.unlock();
+        writeChunk();
+        closeShard();
+        return;
+      }
+      Cr::Containers::Array<char> record = std::move(records_.front());
+      records_.pop_front();
+      numWriting_ = 1;
+      lock.unlock();
+
+      size_t offset = 0;
+      for (size_t i = 0; i < fields_.size(); ++i) {
+        std::memcpy(chunkFields_[i].data() + chunkRecords_ * fieldSizes_[i],
+                    record.data() + offset, fieldSizes_[i]);
+        offset += fieldSizes_[i];
+      }
+      if (++chunkRecords_ == configuration_.recordsPerChunk) {
+        writeChunk();
+      }
+
+      lock.lock();
+      numWriting_ = 0;
+      written_.notify_all();
+    }
+  }
+
+  void pad() {
+    while (shardSize_ % ChunkAlignment != 0) {
+      shard_.put(0);
+      ++shardSize_;
+    }
+  }
+
+  void writeBytes(const void* data, size_t size) {
+    shard_.write(static_cast<const char*>(data), size);
+    shardSize_ += size;
+  }
+
+  template <class T>
+  void write(const T& value) {
+    writeBytes(&value, sizeof(T));
+  }
+
+  void openShard() {
+    shardFilename_ = Cr::Utility::Directory::join(
+        directory_, Cr::Utility::formatString("shard-{:.5}.hod", numShards_++));
+    shard_.open(shardFilename_, std::ios::binary | std::ios::trunc);
+    shardSize_ = 0;
+    write(ObservationDatasetMagic);
+    write(ObservationDatasetVersion);
+    write(uint32_t(configuration_.compression));
+    write(uint32_t(fields_.size()));
+    for (const Field& field : fields_) {
+      write(uint32_t(field.name.size()));
+      writeBytes(field.name.data(), field.name.size());
+      write(uint32_t(field.dataType));
+      write(uint32_t(field.shape.size()));
+      for (size_t dimension : field.shape) {
+        write(uint64_t(dimension));
+      }
+    }
+  }
+
+  void writeChunk() {
+    if (chunkRecords_ == 0) {
+      return;
+    }
+    if (!shard_.is_open()) {
+      openShard();
+    }
+    Chunk chunk{uint32_t(chunkRecords_), {}};
+    for (size_t i = 0; i < fields_.size(); ++i) {
+      Cr::Containers::ArrayView<const char> data =
+          chunkFields_[i].prefix(chunkRecords_ * fieldSizes_[i]);
+      if (configuration_.compression == DatasetCompression::DeltaLz) {
+        deltaEncode(data, fieldSizes_[i], delta_);
+        encoded_ = core::compressBytes(delta_.data(), delta_.size());
+        data = Cr::Containers::arrayView(
+            reinterpret_cast<const char*>(encoded_.data()), encoded_.size());
+      }
+      pad();
+      chunk.fields.emplace_back(shardSize_, data.size());
+      writeBytes(data.data(), data.size());
+    }
+    index_.push_back(std::move(chunk));
+    chunkRecords_ = 0;
+    if (index_.size() == configuration_.chunksPerShard) {
+      closeShard();
+    }
+  }
+
+  void closeShard() {
+    if (!shard_.is_open()) {
+      return;
+    }
+    pad();
+    const uint64_t indexOffset = shardSize_;
+    write(uint32_t(index_.size()));
+    for (const Chunk& chunk : index_) {
+      write(chunk.numRecords);
+      for (const std::pair<uint64_t, uint64_t>& field : chunk.fields) {
+        write(field.first);
+        write(field.second);
+      }
+    }
+    write(indexOffset);
+    write(ObservationDatasetMagic);
+    shard_.close();
+    if (!shard_) {
+      LOG(ERROR) << "ObservationDatasetWriter : Cannot write "
+                 << shardFilename_;
+      good_ = false;
+    }
+    shard_.clear();
+    index_.clear();
+  }
+
+  const std::string directory_;
+  Configuration configuration_;
+  size_t recordSize_ = 0;
+
+  mutable std::mutex mutex_;
+  //! notified when a record is queued or the writer stops
+  std::condition_variable queued_;
+  //! notified when a record was copied into its chunk
+  std::condition_variable written_;
+  std::deque<Cr::Containers::Array<char>> records_;
+  //! the record taken from records_ and being written, 0 or 1
+  size_t numWriting_ = 0;
+  size_t numRecords_ = 0;
+  bool stopped_ = false;
+
+  // the state of the thread
+  //! the records of the current chunk, each field contiguously
+  std::vector<Cr::Containers::Array<char>> chunkFields_;
+  size_t chunkRecords_ = 0;
+  std::vector<unsigned char> delta_;
+  std::vector<unsigned char> encoded_;
+  std::ofstream shard_;
+  std::string shardFilename_;
+  uint64_t shardSize_ = 0;
+  size_t numShards_ = 0;
+  std::vector<Chunk> index_;
+
+  std::thread worker_;
+};
+
+ObservationDatasetWriter::ObservationDatasetWriter(
+    const std::string& directory,
+    const std::vector<Field>& fields,
+    const Configuration& configuration)
+    : pimpl_{spimpl::make_unique_impl<Impl>(directory, fields,
+                                            configuration)} {}
+
+ObservationDatasetWriter::~ObservationDatasetWriter() = default;
+
+const std::vector<ObservationDatasetWriter::Field>&
+ObservationDatasetWriter::fields() const {
+  return pimpl_->fields_;
+}
+
+size_t ObservationDatasetWriter::fieldSize(size_t field) const {
+  return pimpl_->fieldSizes_[field];
+}
+
+bool ObservationDatasetWriter::write(
+    const std::vector<Cr::Containers::ArrayView<const char>>& data) {
+  return pimpl_->push(data);
+}
+
+void ObservationDatasetWriter::wait() {
+  pimpl_->wait();
+}
+
+bool ObservationDatasetWriter::close() {
+  return pimpl_->close();
+}
+
+size_t ObservationDatasetWriter::numRecords() const {
+  return pimpl_->numRecords();
+}
+
+bool ObservationDatasetWriter::isGood() const {
+  return pimpl_->good_;
+}
+
+bool ObservationDatasetReader::open(const std::string& directory) {
+  *this = ObservationDatasetReader{};
+  ObservationDatasetReader reader;
+  for (const std::string& file : Cr::Utility::Directory::list(
+           directory, Cr::Utility::Directory::Flag::SortAscending)) {
+    if (!isShardFile(file)) {
+      continue;
+    }
+    const std::string filename = Cr::Utility::Directory::join(directory, file);
+    Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+        mapped = Cr::Utility::Directory::mapRead(filename);
+    if (!mapped) {
+      LOG(ERROR) << "ObservationDatasetReader::open : Cannot map " << filename;
+      return false;
+    }
+    Reader in{mapped};
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t compression = 0;
+    uint32_t numFields = 0;
+    bool good = in.read(magic) && magic == ObservationDatasetMagic &&
+                in.read(version) && version == ObservationDatasetVersion &&
+                in.read(compression) &&
+                compression <= uint32_t(DatasetCompression::DeltaLz) &&
+                in.read(numFields);
+    std::vector<Field> fields(good ? numFields : 0);
+    for (Field& field : fields) {
+      uint32_t nameLength = 0;
+      uint32_t dataType = 0;
+      uint32_t numDimensions = 0;
+      good = good && in.read(nameLength) && nameLength <= in.remaining();
+      if (good) {
+        field.name.resize(nameLength);
+        in.readBytes(&field.name[0], nameLength);
+      }
+      good = good && in.read(dataType) && in.read(numDimensions) &&
+             numDimensions <= in.remaining() / sizeof(uint64_t);
+      field.dataType = core::DataType(dataType);
+      field.shape.resize(good ? numDimensions : 0);
+      for (size_t& dimension : field.shape) {
+        uint64_t value = 0;
+        good = good && in.read(value);
+        dimension = value;
+      }
+    }
+    if (good && reader.shards_.empty()) {
+      reader.fields_ = fields;
+      for (const Field& field : fields) {
+        reader.fieldSizes_.push_back(byteSize(field));
+      }
+    }
+    good = good && fields == reader.fields_;
+
+    // the index, from the footer at the end
+    uint64_t indexOffset = 0;
+    uint32_t numChunks = 0;
+    const size_t footerSize = sizeof(uint64_t) + sizeof(uint32_t);
+    if (good && mapped.size() >= footerSize) {
+      in.seek(mapped.size() - footerSize);
+      good = in.read(indexOffset) && in.read(magic) &&
+             magic == ObservationDatasetMagic && indexOffset < mapped.size();
+      in.seek(indexOffset);
+      good = good && in.read(numChunks);
+    } else {
+      good = false;
+    }
+    for (uint32_t c = 0; good && c < numChunks; ++c) {
+      Chunk chunk{reader.shards_.size(), reader.numRecords_, 0, {}};
+      good = in.read(chunk.numRecords);
+      for (size_t i = 0; good && i < reader.fields_.size(); ++i) {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        good = in.read(offset) && in.read(size) && offset <= indexOffset &&
+               size <= indexOffset - offset &&
+               (compression != uint32_t(DatasetCompression::None) ||
+                size == chunk.numRecords * reader.fieldSizes_[i]);
+        chunk.fields.emplace_back(offset, size);
+      }
+      reader.numRecords_ += chunk.numRecords;
+      reader.chunks_.push_back(std::move(chunk));
+    }
+    if (!good) {
+      LOG(ERROR) << "ObservationDatasetReader::open : " << filename
+                 << " is not a shard of this dataset";
+      return false;
+    }
+    reader.shards_.push_back(std::move(mapped));
+    reader.compressions_.push_back(DatasetCompression(compression));
+  }
+  if (reader.shards_.empty()) {
+    LOG(ERROR) << "ObservationDatasetReader::open : No shards in "
+               << directory;
+    return false;
+  }
+  reader.decoded_.resize(reader.fields_.size());
+  *this = std::move(reader);
+  return true;
+}
+
+int ObservationDatasetReader::fieldIndex(const std::string& name) const {
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].name == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+Cr::Containers::ArrayView<const char> ObservationDatasetReader::read(
+    size_t record,
+    size_t field) {
+  if (record >= numRecords_ || field >= fields_.size()) {
+    return {};
+  }
+  const size_t index =
+      std::upper_bound(chunks_.begin(), chunks_.end(), record,
+                       [](size_t record, const Chunk& chunk) {
+                         return record < chunk.firstRecord;
+                       }) -
+      chunks_.begin() - 1;
+  const Chunk& chunk = chunks_[index];
+  const size_t size = fieldSizes_[field];
+  const size_t offset = (record - chunk.firstRecord) * size;
+  const Cr::Containers::ArrayView<const char> data = shards_[chunk.shard].slice(
+      chunk.fields[field].first,
+      chunk.fields[field].first + chunk.fields[field].second);
+  if (compressions_[chunk.shard] == DatasetCompression::None) {
+    return data.slice(offset, offset + size);
+  }
+
+  DecodedChunk& decoded = decoded_[field];
+  if (decoded.chunk != index) {
+    decoded.data = Cr::Containers::Array<char>{Cr::Containers::NoInit,
+                                                chunk.numRecords * size};
+    if (!decodeDeltaLz(data, size, decoded.data)) {
+      LOG(ERROR) << "ObservationDatasetReader::read : Chunk " << index
+                 << " of field " << fields_[field].name << " is malformed";
+      decoded = DecodedChunk{};
+      return {};
+    }
+    decoded.chunk = index;
+  }
+  return decoded.data.slice(offset, offset + size);
+}
+
+}  // namespace sim
+}  // namespace esp
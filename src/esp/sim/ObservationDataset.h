@@ -0,0 +1,210 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_OBSERVATIONDATASET_H_
+#define ESP_SIM_OBSERVATIONDATASET_H_
+
+/** @file
+ * @brief Class @ref esp::sim::ObservationDatasetWriter, class
+ * @ref esp::sim::ObservationDatasetReader, enum
+ * @ref esp::sim::DatasetCompression
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Directory.h>
+
+#include "esp/core/SharedMemoryRing.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sim {
+
+/**
+ * @brief The encoding of the chunks of an observation dataset
+ */
+enum class DatasetCompression : uint32_t {
+  //! Records stored as they are, read in place from the mapped shards
+  None = 0,
+
+  /**
+   * Each record XORed with the previous one of its chunk, which leaves runs
+   * of zeros where the frames didn't change, then compressed with
+   * @ref core::compressBytes(). Shrinks depth and semantic frames and the
+   * agent state a lot, color frames of a moving agent much less. Read by
+   * decoding the whole chunk.
+   */
+  DeltaLz = 1,
+};
+
+/**
+ * @brief Streams records of fixed-size fields, e.g. the observations, state
+ * and action of an agent at each step, into chunked shard files on a thread
+ * of its own
+ *
+ * The records are copied when queued. A chunk holds
+ * @ref Configuration::recordsPerChunk records, each field contiguously, and a
+ * shard, a file `shard-NNNNN.hod` in the directory, holds
+ * @ref Configuration::chunksPerShard chunks and an index of them, so a shard
+ * is complete and readable with @ref ObservationDatasetReader once it is
+ * closed. Once @ref Configuration::maxPendingRecords are queued, queueing
+ * waits for the oldest to be written. Not thread-safe.
+ */
+class ObservationDatasetWriter {
+ public:
+  //! A field of a record, as those of a @ref core::SharedMemoryRing
+  typedef core::SharedMemoryRing::Field Field;
+
+  /** @brief The layout of the dataset */
+  struct Configuration {
+    //! The records of a chunk, the ones decoded together
+    size_t recordsPerChunk = 64;
+    //! The chunks of a shard file
+    size_t chunksPerShard = 64;
+    //! The encoding of the chunks
+    DatasetCompression compression = DatasetCompression::DeltaLz;
+    //! The most records queued and not written yet
+    size_t maxPendingRecords = 256;
+    //! Whether to delete the shards already in the directory. If not, the
+    //! writer refuses all records when there are some.
+    bool overwrite = false;
+  };
+
+  /**
+   * @brief Start the thread writing the shards
+   * @param directory The directory of the shards, created if it doesn't
+   * exist. If it has shards already, they are deleted with
+   * @ref Configuration::overwrite, else the writer is closed and not
+   * @ref isGood().
+   * @param fields The fields of each record
+   * @param configuration The layout
+   */
+  explicit ObservationDatasetWriter(const std::string& directory,
+                                    const std::vector<Field>& fields,
+                                    const Configuration& configuration = {});
+
+  /** @brief Write the records still queued, see @ref close() */
+  ~ObservationDatasetWriter();
+
+  ObservationDatasetWriter(const ObservationDatasetWriter&) = delete;
+  ObservationDatasetWriter& operator=(const ObservationDatasetWriter&) =
+      delete;
+
+  /** @brief The fields of each record */
+  const std::vector<Field>& fields() const;
+
+  /** @brief The size in bytes of field @p field of a record */
+  size_t fieldSize(size_t field) const;
+
+  /**
+   * @brief Queue a record
+   * @param data The bytes of each field of @ref fields(), in that order
+   * @return false if the writer is closed, also while waiting for the queue,
+   * or @p data doesn't match the fields, nothing is queued then
+   */
+  bool write(
+      const std::vector<Corrade::Containers::ArrayView<const char>>& data);
+
+  /** @brief Wait for all queued records to be written to their chunks */
+  void wait();
+
+  /**
+   * @brief Write the queued records and the last, partial chunk, close the
+   * last shard and stop the thread. Further records are refused.
+   * @return false if writing any shard failed
+   */
+  bool close();
+
+  /** @brief The number of records queued so far */
+  size_t numRecords() const;
+
+  /** @brief Whether all shards were written without an error so far */
+  bool isGood() const;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(ObservationDatasetWriter)
+};
+
+/**
+ * @brief Random access to the records of the shards of an
+ * @ref ObservationDatasetWriter
+ *
+ * The shards are memory-mapped. A field of a chunk stored with
+ * @ref DatasetCompression::None is viewed in place in the mapping, one that
+ * is encoded is decoded whole and kept until a record of another chunk is
+ * read, so reading the records of a chunk in any order decodes it once. Not
+ * thread-safe, the workers of a data loader open a reader each.
+ */
+class ObservationDatasetReader {
+ public:
+  typedef ObservationDatasetWriter::Field Field;
+
+  /**
+   * @brief Map the shards in @p directory
+   * @return false if there are no shards or one is malformed or has other
+   * fields than the first one, the reader is empty then
+   */
+  bool open(const std::string& directory);
+
+  /** @brief The number of records in all shards */
+  size_t numRecords() const { return numRecords_; }
+
+  /** @brief The fields of each record */
+  const std::vector<Field>& fields() const { return fields_; }
+
+  /** @brief The index of the field @p name, -1 if there is no such field */
+  int fieldIndex(const std::string& name) const;
+
+  /** @brief The size in bytes of field @p field of a record */
+  size_t fieldSize(size_t field) const { return fieldSizes_[field]; }
+
+  /**
+   * @brief The bytes of field @p field of record @p record
+   *
+   * Views the mapped shard or the decoded chunk, valid until the next call
+   * reading another chunk.
+   * @return An empty view if there is no such record or field or its chunk
+   * is malformed
+   */
+  Corrade::Containers::ArrayView<const char> read(size_t record,
+                                                  size_t field);
+
+ private:
+  struct Chunk {
+    size_t shard;
+    uint64_t firstRecord;
+    uint32_t numRecords;
+    //! the offset and size of each field in the shard
+    std::vector<std::pair<uint64_t, uint64_t>> fields;
+  };
+
+  struct DecodedChunk {
+    size_t chunk = ~size_t{};
+    Corrade::Containers::Array<char> data;
+  };
+
+  typedef Corrade::Containers::Array<const char,
+                                     Corrade::Utility::Directory::MapDeleter>
+      MappedShard;
+
+  std::vector<MappedShard> shards_;
+  std::vector<DatasetCompression> compressions_;
+  std::vector<Chunk> chunks_;
+  std::vector<Field> fields_;
+  std::vector<size_t> fieldSizes_;
+  //! the last decoded chunk of each field
+  std::vector<DecodedChunk> decoded_;
+  size_t numRecords_ = 0;
+
+  ESP_SMART_POINTERS(ObservationDatasetReader)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_OBSERVATIONDATASET_H_
@@ -0,0 +1,538 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SessionRecording.h"
+
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Utility/Directory.h>
+
+#include "Simulator.h"
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace sim {
+
+namespace {
+
+constexpr char Magic[4]{'H', 'S', 'E', 'S'};
+constexpr uint32_t Version = 3;
+
+//! Appends values to a string in native layout
+class Writer {
+ public:
+  template <typename T>
+  void write(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    data_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void write(const std::string& value) {
+    write<uint32_t>(value.size());
+    data_.append(value);
+  }
+
+  void write(const vec3f& value) {
+    write<float>(value[0]);
+    write<float>(value[1]);
+    write<float>(value[2]);
+  }
+
+  void write(const vec2i& value) {
+    write<int32_t>(value[0]);
+    write<int32_t>(value[1]);
+  }
+
+  void write(const core::RigidState& state) {
+    write(state.rotation);
+    write(state.translation);
+  }
+
+  const std::string& data() const { return data_; }
+
+ private:
+  std::string data_;
+};
+
+//! Reads values written by @ref Writer, failing on a truncated file
+class Reader {
+ public:
+  explicit Reader(const std::string& data) : data_{data} {}
+
+  template <typename T>
+  bool read(T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    if (sizeof(T) > data_.size() - pos_) {
+      return false;
+    }
+    std::memcpy(&value, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool read(std::string& value) {
+    uint32_t size = 0;
+    if (!read(size) || size > data_.size() - pos_) {
+      return false;
+    }
+    value.assign(data_, pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  bool read(vec3f& value) {
+    return read(value[0]) && read(value[1]) && read(value[2]);
+  }
+
+  bool read(vec2i& value) { return read(value[0]) && read(value[1]); }
+
+  bool read(core::RigidState& state) {
+    return read(state.rotation) && read(state.translation);
+  }
+
+  bool atEnd() const { return pos_ == data_.size(); }
+
+ private:
+  const std::string& data_;
+  std::size_t pos_ = 0;
+};
+
+void writeAgentConfig(Writer& writer, const agent::AgentConfiguration& cfg) {
+  writer.write(cfg.height);
+  writer.write(cfg.radius);
+  writer.write(cfg.mass);
+  writer.write(cfg.linearAcceleration);
+  writer.write(cfg.angularAcceleration);
+  writer.write(cfg.linearFriction);
+  writer.write(cfg.angularFriction);
+  writer.write(cfg.coefficientOfRestitution);
+  writer.write(cfg.bodyType);
+  writer.write(cfg.velocityControlSubstep);
+  writer.write(cfg.velocityControlAllowSliding);
+
+  writer.write<uint32_t>(cfg.sensorSpecifications.size());
+  for (const sensor::SensorSpec::ptr& spec : cfg.sensorSpecifications) {
+    writer.write(spec->uuid);
+    writer.write<int32_t>(int32_t(spec->sensorType));
+    writer.write(spec->sensorSubtype);
+    writer.write<uint32_t>(spec->parameters.size());
+    for (const auto& parameter : spec->parameters) {
+      writer.write(parameter.first);
+      writer.write(parameter.second);
+    }
+    writer.write(spec->position);
+    writer.write(spec->orientation);
+    writer.write(spec->resolution);
+    writer.write<int32_t>(spec->channels);
+    writer.write(spec->encoding);
+    writer.write(spec->observationSpace);
+    writer.write(spec->noiseModel);
+    writer.write<uint32_t>(spec->noiseModelKwargs.size());
+    for (const auto& kwarg : spec->noiseModelKwargs) {
+      writer.write(kwarg.first);
+      writer.write(kwarg.second);
+    }
+    writer.write(spec->gpu2gpuTransfer);
+    writer.write<int32_t>(int32_t(spec->observationFormat));
+    writer.write<int32_t>(spec->downsampling);
+    writer.write<int32_t>(spec->samples);
+    writer.write<int32_t>(int32_t(spec->renderQuality));
+    writer.write<int32_t>(spec->updatePeriod);
+  }
+
+  writer.write<uint32_t>(cfg.actionSpace.size());
+  for (const auto& action : cfg.actionSpace) {
+    writer.write(action.first);
+    writer.write(action.second->name);
+    writer.write<uint32_t>(action.second->actuation.size());
+    for (const auto& actuation : action.second->actuation) {
+      writer.write(actuation.first);
+      writer.write(actuation.second);
+    }
+  }
+}
+
+bool readAgentConfig(Reader& reader, agent::AgentConfiguration& cfg) {
+  if (!reader.read(cfg.height) || !reader.read(cfg.radius) ||
+      !reader.read(cfg.mass) || !reader.read(cfg.linearAcceleration) ||
+      !reader.read(cfg.angularAcceleration) ||
+      !reader.read(cfg.linearFriction) || !reader.read(cfg.angularFriction) ||
+      !reader.read(cfg.coefficientOfRestitution) ||
+      !reader.read(cfg.bodyType) || !reader.read(cfg.velocityControlSubstep) ||
+      !reader.read(cfg.velocityControlAllowSliding)) {
+    return false;
+  }
+
+  uint32_t numSensors = 0;
+  if (!reader.read(numSensors)) {
+    return false;
+  }
+  cfg.sensorSpecifications.clear();
+  for (uint32_t i = 0; i < numSensors; ++i) {
+    auto spec = sensor::SensorSpec::create();
+    int32_t sensorType = 0, channels = 0, observationFormat = 0;
+    int32_t downsampling = 0, samples = 0, renderQuality = 0;
+    int32_t updatePeriod = 1;
+    uint32_t numParameters = 0, numKwargs = 0;
+    if (!reader.read(spec->uuid) || !reader.read(sensorType) ||
+        !reader.read(spec->sensorSubtype) || !reader.read(numParameters)) {
+      return false;
+    }
+    spec->parameters.clear();
+    for (uint32_t j = 0; j < numParameters; ++j) {
+      std::string key, value;
+      if (!reader.read(key) || !reader.read(value)) {
+        return false;
+      }
+      spec->parameters[key] = value;
+    }
+    if (!reader.read(spec->position) || !reader.read(spec->orientation) ||
+        !reader.read(spec->resolution) || !reader.read(channels) ||
+        !reader.read(spec->encoding) || !reader.read(spec->observationSpace) ||
+        !reader.read(spec->noiseModel) || !reader.read(numKwargs)) {
+      return false;
+    }
+    for (uint32_t j = 0; j < numKwargs; ++j) {
+      std::string key, value;
+      if (!reader.read(key) || !reader.read(value)) {
+        return false;
+      }
+      spec->noiseModelKwargs[key] = value;
+    }
+    if (!reader.read(spec->gpu2gpuTransfer) ||
+        !reader.read(observationFormat) || !reader.read(downsampling) ||
+        !reader.read(samples) || !reader.read(renderQuality) ||
+        !reader.read(updatePeriod)) {
+      return false;
+    }
+    spec->sensorType = sensor::SensorType(sensorType);
+    spec->channels = channels;
+    spec->observationFormat = sensor::ObservationFormat(observationFormat);
+    spec->downsampling = downsampling;
+    spec->samples = samples;
+    spec->renderQuality = sensor::RenderQuality(renderQuality);
+    spec->updatePeriod = updatePeriod;
+    cfg.sensorSpecifications.push_back(spec);
+  }
+
+  uint32_t numActions = 0;
+  if (!reader.read(numActions)) {
+    return false;
+  }
+  cfg.actionSpace.clear();
+  for (uint32_t i = 0; i < numActions; ++i) {
+    std::string key, name;
+    uint32_t numActuations = 0;
+    if (!reader.read(key) || !reader.read(name) ||
+        !reader.read(numActuations)) {
+      return false;
+    }
+    agent::ActuationMap actuation;
+    for (uint32_t j = 0; j < numActuations; ++j) {
+      std::string actuationKey;
+      float amount = 0.0f;
+      if (!reader.read(actuationKey) || !reader.read(amount)) {
+        return false;
+      }
+      actuation[actuationKey] = amount;
+    }
+    cfg.actionSpace[key] = agent::ActionSpec::create(name, actuation);
+  }
+  return true;
+}
+
+}  // namespace
+
+const char* sessionEventTypeName(SessionEventType type) {
+  switch (type) {
+    case SessionEventType::AddAgent:
+      return "AddAgent";
+    case SessionEventType::Seed:
+      return "Seed";
+    case SessionEventType::Reset:
+      return "Reset";
+    case SessionEventType::ActByName:
+      return "ActByName";
+    case SessionEventType::ActByIndices:
+      return "ActByIndices";
+    case SessionEventType::StepWorld:
+      return "StepWorld";
+    case SessionEventType::Observe:
+      return "Observe";
+    case SessionEventType::AddObject:
+      return "AddObject";
+    case SessionEventType::RemoveObject:
+      return "RemoveObject";
+    case SessionEventType::SetRigidState:
+      return "SetRigidState";
+  }
+  return "";
+}
+
+bool SessionRecording::save(const std::string& filename) const {
+  Writer writer;
+  writer.write(Magic);
+  writer.write(Version);
+  writer.write(scene);
+  writer.write<uint64_t>(events.size());
+  for (const SessionEvent& event : events) {
+    writer.write(event.type);
+    switch (event.type) {
+      case SessionEventType::AddAgent:
+        writeAgentConfig(writer, event.agentConfig);
+        break;
+      case SessionEventType::Seed:
+        writer.write(event.seed);
+        break;
+      case SessionEventType::Reset:
+        break;
+      case SessionEventType::ActByName:
+        writer.write<int32_t>(event.id);
+        writer.write(event.name);
+        break;
+      case SessionEventType::ActByIndices:
+        writer.write<uint32_t>(event.indices.size());
+        for (const int index : event.indices) {
+          writer.write<int32_t>(index);
+        }
+        break;
+      case SessionEventType::StepWorld:
+        writer.write(event.dt);
+        break;
+      case SessionEventType::Observe:
+      case SessionEventType::SetRigidState:
+        writer.write<int32_t>(event.id);
+        writer.write<uint32_t>(event.states.size());
+        for (const core::RigidState& state : event.states) {
+          writer.write(state);
+        }
+        break;
+      case SessionEventType::AddObject:
+        writer.write<int32_t>(event.id);
+        writer.write(event.name);
+        break;
+      case SessionEventType::RemoveObject:
+        writer.write<int32_t>(event.id);
+        break;
+    }
+  }
+  return Cr::Utility::Directory::writeString(filename, writer.data());
+}
+
+bool SessionRecording::load(const std::string& filename,
+                            SessionRecording& recording) {
+  if (!Cr::Utility::Directory::exists(filename)) {
+    LOG(ERROR) << "SessionRecording::load : " << filename << " not found";
+    return false;
+  }
+  const std::string data = Cr::Utility::Directory::readString(filename);
+  Reader reader{data};
+  char magic[4];
+  uint32_t version = 0;
+  uint64_t numEvents = 0;
+  if (!reader.read(magic) || std::memcmp(magic, Magic, sizeof(Magic)) != 0 ||
+      !reader.read(version) || version != Version) {
+    LOG(ERROR) << "SessionRecording::load : " << filename
+               << " is not a session recording of version " << Version;
+    return false;
+  }
+  recording.events.clear();
+  bool success = reader.read(recording.scene) && reader.read(numEvents);
+  for (uint64_t i = 0; success && i < numEvents; ++i) {
+    SessionEvent event;
+    int32_t id = ID_UNDEFINED;
+    uint32_t count = 0;
+    success = reader.read(event.type);
+    if (!success) {
+      break;
+    }
+    switch (event.type) {
+      case SessionEventType::AddAgent:
+        success = readAgentConfig(reader, event.agentConfig);
+        break;
+      case SessionEventType::Seed:
+        success = reader.read(event.seed);
+        break;
+      case SessionEventType::Reset:
+        break;
+      case SessionEventType::ActByName:
+      case SessionEventType::AddObject:
+        success = reader.read(id) && reader.read(event.name);
+        break;
+      case SessionEventType::ActByIndices:
+        success = reader.read(count);
+        for (uint32_t j = 0; success && j < count; ++j) {
+          int32_t index = 0;
+          success = reader.read(index);
+          event.indices.push_back(index);
+        }
+        break;
+      case SessionEventType::StepWorld:
+        success = reader.read(event.dt);
+        break;
+      case SessionEventType::Observe:
+      case SessionEventType::SetRigidState:
+        success = reader.read(id) && reader.read(count);
+        for (uint32_t j = 0; success && j < count; ++j) {
+          core::RigidState state;
+          success = reader.read(state);
+          event.states.push_back(state);
+        }
+        break;
+      case SessionEventType::RemoveObject:
+        success = reader.read(id);
+        break;
+      default:
+        success = false;
+    }
+    event.id = id;
+    recording.events.push_back(std::move(event));
+  }
+  if (!success || !reader.atEnd()) {
+    LOG(ERROR) << "SessionRecording::load : " << filename
+               << " is truncated or corrupted";
+    return false;
+  }
+  return true;
+}
+
+bool replaySession(Simulator& simulator,
+                   const SessionRecording& recording,
+                   SessionReplayTimes* times) {
+  using Clock = std::chrono::steady_clock;
+  bool success = true;
+  // recorded object IDs to the ones of the replay, objects of the scene
+  // keep theirs
+  std::unordered_map<int, int> objectIds;
+  const auto objectId = [&](int recordedId) {
+    auto found = objectIds.find(recordedId);
+    return found == objectIds.end() ? recordedId : found->second;
+  };
+  std::vector<sensor::Observation> observations;
+  int numAgents = 0;
+
+  // consecutive rigid states are applied in one bulk call, before the next
+  // event of another type
+  std::vector<int> pendingIds;
+  std::vector<Magnum::Vector3> pendingTranslations;
+  std::vector<Magnum::Quaternion> pendingRotations;
+  const auto applyRigidStates = [&]() {
+    if (pendingIds.empty()) {
+      return;
+    }
+    const Clock::time_point start = Clock::now();
+    simulator.setRigidStates(pendingIds, pendingTranslations,
+                             pendingRotations);
+    if (times) {
+      const std::chrono::duration<double, std::milli> elapsed =
+          Clock::now() - start;
+      times->milliseconds[int(SessionEventType::SetRigidState)] +=
+          elapsed.count();
+    }
+    pendingIds.clear();
+    pendingTranslations.clear();
+    pendingRotations.clear();
+  };
+
+  for (const SessionEvent& event : recording.events) {
+    if (event.type != SessionEventType::SetRigidState) {
+      applyRigidStates();
+    }
+    const bool isAgentEvent = event.type == SessionEventType::ActByName ||
+                              event.type == SessionEventType::Observe;
+    if (isAgentEvent && (event.id < 0 || event.id >= numAgents)) {
+      LOG(ERROR) << "replaySession : " << sessionEventTypeName(event.type)
+                 << " of unknown agent " << event.id;
+      success = false;
+      continue;
+    }
+
+    const Clock::time_point start = Clock::now();
+    switch (event.type) {
+      case SessionEventType::AddAgent:
+        for (const sensor::SensorSpec::ptr& spec :
+             event.agentConfig.sensorSpecifications) {
+          if (spec->noiseModel != "None") {
+            LOG(WARNING) << "replaySession : The " << spec->noiseModel
+                         << " noise model of sensor " << spec->uuid
+                         << " is applied only by the Python sensors";
+          }
+        }
+        simulator.addAgent(event.agentConfig);
+        ++numAgents;
+        break;
+      case SessionEventType::Seed:
+        simulator.seed(event.seed);
+        break;
+      case SessionEventType::Reset:
+        simulator.reset();
+        break;
+      case SessionEventType::ActByName:
+        success &= simulator.getAgent(event.id)->act(event.name);
+        break;
+      case SessionEventType::ActByIndices:
+        success &= simulator.actAll(event.indices);
+        break;
+      case SessionEventType::StepWorld:
+        simulator.stepWorld(event.dt);
+        break;
+      case SessionEventType::Observe: {
+        agent::Agent& agent = *simulator.getAgent(event.id);
+        const std::vector<sensor::Sensor::ptr>& sensors =
+            agent.getSensorSuite().getSensorList();
+        if (event.states.size() != sensors.size() + 1) {
+          LOG(ERROR) << "replaySession : Observe of agent " << event.id
+                     << " with " << event.states.size() << " poses for "
+                     << sensors.size() << " sensors and the body";
+          success = false;
+          break;
+        }
+        agent.node().setTranslation(event.states[0].translation);
+        agent.node().setRotation(event.states[0].rotation);
+        for (std::size_t i = 0; i < sensors.size(); ++i) {
+          sensors[i]->node().setTranslation(event.states[i + 1].translation);
+          sensors[i]->node().setRotation(event.states[i + 1].rotation);
+        }
+        simulator.getAgentObservations(event.id, observations);
+        break;
+      }
+      case SessionEventType::AddObject: {
+        const int newId = simulator.addObjectByHandle(event.name);
+        if (newId == ID_UNDEFINED) {
+          LOG(ERROR) << "replaySession : Cannot add an object of template "
+                     << event.name;
+          success = false;
+        }
+        objectIds[event.id] = newId;
+        break;
+      }
+      case SessionEventType::RemoveObject:
+        simulator.removeObject(objectId(event.id));
+        break;
+      case SessionEventType::SetRigidState:
+        if (!event.states.empty() && objectId(event.id) != ID_UNDEFINED) {
+          pendingIds.push_back(objectId(event.id));
+          pendingTranslations.push_back(event.states[0].translation);
+          pendingRotations.push_back(event.states[0].rotation);
+        }
+        break;
+    }
+    if (times) {
+      const std::chrono::duration<double, std::milli> elapsed =
+          Clock::now() - start;
+      ++times->calls[int(event.type)];
+      times->milliseconds[int(event.type)] += elapsed.count();
+    }
+  }
+  applyRigidStates();
+  return success;
+}
+
+}  // namespace sim
+}  // namespace esp
@@ -0,0 +1,138 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_SESSIONRECORDING_H_
+#define ESP_SIM_SESSIONRECORDING_H_
+
+/** @file
+ * @brief Struct @ref esp::sim::SessionRecording, function @ref
+ * esp::sim::replaySession()
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp/agent/Agent.h"
+#include "esp/core/RigidState.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sim {
+
+class Simulator;
+
+/**
+ * @brief The simulator calls a @ref SessionEvent records
+ */
+enum class SessionEventType : uint8_t {
+  //! @ref Simulator::addAgent(), with the configuration of the agent
+  AddAgent,
+  //! @ref Simulator::seed()
+  Seed,
+  //! @ref Simulator::reset()
+  Reset,
+  //! an agent acting by action name in @ref Simulator::step()
+  ActByName,
+  //! all agents acting by action index, @ref Simulator::actAll()
+  ActByIndices,
+  //! @ref Simulator::stepWorld()
+  StepWorld,
+  //! @ref Simulator::getAgentObservations(), with the poses of the agent
+  //! and of its sensors
+  Observe,
+  //! @ref Simulator::addObject() or @ref Simulator::addObjectByHandle()
+  AddObject,
+  //! @ref Simulator::removeObject()
+  RemoveObject,
+  //! the rigid state of an object after it was set by @ref
+  //! Simulator::setRigidState() or another transformation setter
+  SetRigidState,
+};
+
+/** @brief The number of @ref SessionEventType values */
+constexpr int NumSessionEventTypes = 10;
+
+/** @brief The name of an event type, e.g. "StepWorld" */
+const char* sessionEventTypeName(SessionEventType type);
+
+/**
+ * @brief One recorded simulator call, only the fields its type uses are set
+ */
+struct SessionEvent {
+  SessionEventType type = SessionEventType::StepWorld;
+  //! the agent or object ID, as in the recorded session
+  int id = ID_UNDEFINED;
+  //! the action name of ActByName, the template handle of AddObject
+  std::string name;
+  //! the action indices of ActByIndices, by agent ID
+  std::vector<int> indices;
+  //! the state of SetRigidState. For Observe, the state of the agent body
+  //! followed by the local states of its sensors, in sensor list order
+  std::vector<core::RigidState> states;
+  //! the time step of StepWorld
+  double dt = 0.0;
+  //! the seed of Seed
+  uint32_t seed = 0;
+  //! the agent of AddAgent. Sensors keep all their settings, including the
+  //! noise model and its arguments, which only the Python sensors apply.
+  agent::AgentConfiguration agentConfig;
+};
+
+/**
+ * @brief A simulator session, recorded by @ref Simulator::startRecording()
+ *
+ * Saved in a compact native binary format, recordings are not portable
+ * between platforms of different endianness.
+ */
+struct SessionRecording {
+  //! the scene the session was recorded in
+  std::string scene;
+  std::vector<SessionEvent> events;
+
+  /**
+   * @brief Save the recording to @p filename
+   * @return false if the file couldn't be written
+   */
+  bool save(const std::string& filename) const;
+
+  /**
+   * @brief Load a recording saved by @ref save()
+   * @return false if the file couldn't be read or is not a recording
+   */
+  static bool load(const std::string& filename, SessionRecording& recording);
+};
+
+/**
+ * @brief Wall clock time spent replaying each @ref SessionEventType
+ */
+struct SessionReplayTimes {
+  uint64_t calls[NumSessionEventTypes]{};
+  double milliseconds[NumSessionEventTypes]{};
+};
+
+/**
+ * @brief Replay a recording on @p simulator, which has to have the scene of
+ * the recording loaded and no agents
+ *
+ * The calls are made again in order. Objects get new IDs, later events
+ * referring to them are mapped to those. The agent and sensor poses of
+ * Observe events are restored before observing, so the observations match
+ * the recorded ones even if the actions moved the agents differently.
+ * Consecutive SetRigidState events are applied with one @ref
+ * Simulator::setRigidStates() call.
+ * @param simulator The simulator to replay on
+ * @param recording The recorded session
+ * @param[out] times If not nullptr, the time spent per event type
+ * @return false if an event couldn't be replayed, e.g. because an object
+ * template is missing. The events after it are still replayed.
+ */
+bool replaySession(Simulator& simulator,
+                   const SessionRecording& recording,
+                   SessionReplayTimes* times = nullptr);
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_SESSIONRECORDING_H_
@@ -4,18 +4,29 @@
 
 #include "Simulator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Utility/Directory.h>
 #include <Corrade/Utility/String.h>
 #include <Magnum/EigenIntegration/GeometryIntegration.h>
 #include <Magnum/GL/Context.h>
+#include <Magnum/GL/Renderer.h>
 
+#include "esp/core/Profiling.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/Drawable.h"
+#include "esp/gfx/GpuDevices.h"
+#include "esp/gfx/GpuProfiling.h"
+#include "esp/gfx/PotentiallyVisibleSet.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/Renderer.h"
+#include "esp/gfx/ShaderManager.h"
 #include "esp/io/io.h"
 #include "esp/metadata/attributes/AttributesBase.h"
 #include "esp/nav/PathFinder.h"
@@ -24,6 +35,10 @@
 #include "esp/scene/SemanticScene.h"
 #include "esp/sensor/PinholeCamera.h"
 #include "esp/sensor/VisualSensor.h"
+#ifdef ESP_BUILD_WITH_CUDA
+#include "esp/sensor/RedwoodNoiseModel.h"
+#include "esp/sensor/RgbNoiseModel.h"
+#endif
 
 namespace Cr = Corrade;
 
@@ -42,23 +57,72 @@ Simulator::Simulator(const SimulatorConfiguration& cfg)
   reconfigure(cfg);
 }
 
+Simulator::Simulator(const SimulatorConfiguration& cfg,
+                     std::shared_ptr<assets::ResourceManager> resourceManager,
+                     std::shared_ptr<gfx::Renderer> renderer)
+    : renderer_{std::move(renderer)},
+      resourceManager_{std::move(resourceManager)},
+      random_{core::Random::create(cfg.randomSeed)},
+      requiresTextures_{Cr::Containers::NullOpt} {
+  CORRADE_ASSERT(!cfg.createRenderer || Magnum::GL::Context::hasCurrent(),
+                 "Simulator: no OpenGL context to share the assets in", );
+  reconfigure(cfg);
+}
+
+Simulator::Simulator(const Simulator& source, const SimulatorConfiguration& cfg)
+    : renderer_{source.renderer_},
+      resourceManager_{source.resourceManager_},
+      cloneSource_{&source},
+      random_{core::Random::create(cfg.randomSeed)},
+      requiresTextures_{source.requiresTextures_} {
+  reconfigure(cfg);
+  cloneSource_ = nullptr;
+}
+
+std::shared_ptr<Simulator> Simulator::clone() {
+  core::ScopedTraceEvent trace{"Simulator::clone", "sim"};
+  waitForPhysicsStep();
+  std::shared_ptr<Simulator> copy{new Simulator{*this, config_}};
+  if (physicsManager_ && copy->physicsManager_) {
+    copy->physicsManager_->cloneObjectsFrom(
+        *physicsManager_, &copy->getActiveSceneGraph().getDrawables());
+  }
+  auto state = agent::AgentState::create();
+  for (const agent::Agent::ptr& agent : agents_) {
+    agent->getState(state);
+    copy->addAgent(agent->getConfig())->setState(*state);
+  }
+  return copy;
+}
+
 Simulator::~Simulator() {
   LOG(INFO) << "Deconstructing Simulator";
   close();
 }
 
 void Simulator::close() {
+  waitForPhysicsStep();
+  // the sensors of the observations in flight may be gone already
+  asyncObservations_ = Corrade::Containers::NullOpt;
+  // writes the frames still queued
+  frameEncoder_ = nullptr;
   pathfinder_ = nullptr;
   navMeshVisPrimID_ = esp::ID_UNDEFINED;
   navMeshVisNode_ = nullptr;
   agents_.clear();
 
+  // the chunks are in the scene graph and the physics world
+  stageStreamer_ = nullptr;
   physicsManager_ = nullptr;
   semanticScene_ = nullptr;
+  // the scene graphs go with the scene manager
+  residentScenes_.clear();
+  activeSceneReused_ = false;
 
   sceneID_.clear();
   sceneManager_ = nullptr;
 
+  unpinStageAssets();
   resourceManager_ = nullptr;
 
   renderer_ = nullptr;
@@ -69,12 +133,25 @@ void Simulator::close() {
   config_ = SimulatorConfiguration{};
 
   frustumCulling_ = true;
+  sortByDrawState_ = false;
+  occlusionCulling_ = false;
+  potentiallyVisibleSet_ = false;
+  multiFrustumCulling_ = false;
+  renderList_ = false;
+  gpuDrivenRender_ = false;
+  asyncObservationReadback_ = false;
+  asyncPhysics_ = false;
+  sharedSensorRender_ = false;
+  stereoRender_ = false;
+  layeredComposition_ = false;
   requiresTextures_ = Cr::Containers::NullOpt;
 }
 
 void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
+  core::ScopedTraceEvent trace{"Simulator::reconfigure", "sim"};
+  waitForPhysicsStep();
   if (!resourceManager_) {
-    resourceManager_ = std::make_unique<assets::ResourceManager>();
+    resourceManager_ = std::make_shared<assets::ResourceManager>();
   }
 
   if (!sceneManager_) {
@@ -88,20 +165,58 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
   }
   // otherwise set current configuration and initialize
   // TODO can optimize to do partial re-initialization instead of from-scratch
+  // the scene graphs may be new, with their drawables epochs starting over
+  cachedObservations_.clear();
+  scheduledSensors_.clear();
+  markSceneChanged();
   config_ = cfg;
+  // loading the new stage may release the assets of the previous one
+  unpinStageAssets();
 
   if (requiresTextures_ == Cr::Containers::NullOpt) {
     requiresTextures_ = config_.requiresTextures;
     resourceManager_->setRequiresTextures(config_.requiresTextures);
   } else if (!(*requiresTextures_) && config_.requiresTextures) {
-    throw std::runtime_error(
-        "requiresTextures was changed to True from False.  Must call close() "
-        "before changing this value.");
+    // loads the textures of the assets loaded so far
+    requiresTextures_ = true;
+    resourceManager_->setRequiresTextures(true);
   } else if ((*requiresTextures_) && !config_.requiresTextures) {
     LOG(WARNING) << "Not changing requiresTextures as the simulator was "
                     "initialized with True.  Call close() to change this.";
   }
 
+  resourceManager_->setInstancedObjectRendering(
+      config_.instancedObjectRendering);
+  resourceManager_->setRenderOnly(config_.renderOnly);
+  resourceManager_->setStageAssetCacheBudget(config_.assetCacheCpuBudget,
+                                             config_.assetCacheGpuBudget);
+  resourceManager_->setPTexAtlasStreaming(config_.ptexAtlasStreaming,
+                                          config_.ptexAtlasBudget);
+  resourceManager_->setPTexGeometryShader(config_.ptexGeometryShader);
+  resourceManager_->setTextureTranscodeCacheDir(
+      config_.textureTranscodeCacheDir);
+  // the limit only grows for the sensors attached so far
+  resourceManager_->setMaxTextureSize(
+      config_.maxTextureSize > 0
+          ? std::max(config_.maxTextureSize, sensorTextureSize_)
+          : 0);
+  resourceManager_->setCompactVertexFormat(config_.compactVertexFormat);
+  resourceManager_->setMeshArenaEnabled(config_.sharedMeshArena);
+  resourceManager_->setInstanceMeshCpuData(config_.instanceMeshCpuData);
+  resourceManager_->setTextureArraySize(config_.textureArraySize);
+  resourceManager_->setSemanticVertexIds(config_.semanticVertexIds);
+  resourceManager_->setLevelsOfDetail(config_.levelOfDetailCount,
+                                      config_.levelOfDetailPixelError);
+  if (config_.pipelinedStep) {
+    setAsyncObservationReadbackEnabled(true);
+  }
+
+  activeSceneReused_ = false;
+  if (config_.residentScenes > 0 && switchToResidentScene()) {
+    pinStageAssets();
+    return;
+  }
+
   // use physics attributes manager to get physics manager attributes
   // described by config file - this always exists to configure scene
   // attributes
@@ -138,18 +253,24 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
   esp::assets::AssetType stageType = static_cast<esp::assets::AssetType>(
       stageAttributes->getRenderAssetType());
 
-  // create pathfinder and load navmesh if available
-  pathfinder_ = nav::PathFinder::create();
-  if (io::exists(navmeshFilename)) {
-    LOG(INFO) << "Loading navmesh from " << navmeshFilename;
-    pathfinder_->loadNavMesh(navmeshFilename);
-    LOG(INFO) << "Loaded.";
+  if (cloneSource_) {
+    // shared and already seeded
+    pathfinder_ = cloneSource_->pathfinder_;
   } else {
-    LOG(WARNING) << "Navmesh file not found, checked at " << navmeshFilename;
-  }
+    // create pathfinder and load navmesh if available
+    pathfinder_ = nav::PathFinder::create();
+    if (io::exists(navmeshFilename)) {
+      core::ScopedTimer timer{core::ProfilingStage::NavmeshLoading};
+      LOG(INFO) << "Loading navmesh from " << navmeshFilename;
+      pathfinder_->loadNavMesh(navmeshFilename);
+      LOG(INFO) << "Loaded.";
+    } else {
+      LOG(WARNING) << "Navmesh file not found, checked at " << navmeshFilename;
+    }
 
-  // Calling to seeding needs to be done after the pathfinder creation
-  seed(config_.randomSeed);
+    // Calling to seeding needs to be done after the pathfinder creation
+    seed(config_.randomSeed);
+  }
 
   // initalize scene graph
   // CAREFUL!
@@ -167,16 +288,37 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
     /* When creating a viewer based app, there is no need to create a
     WindowlessContext since a (windowed) context already exists. */
     if (!context_ && !Magnum::GL::Context::hasCurrent()) {
-      context_ = gfx::WindowlessContext::create_unique(config_.gpuDeviceId);
+      core::ScopedTimer timer{core::ProfilingStage::ContextCreation};
+      context_ = gfx::WindowlessContext::create_unique(
+          gfx::selectGpuDevice(config_.gpuDevicePolicy, config_.gpuDeviceId),
+          config_.softwareRendering, config_.softwareRenderingThreads);
     }
 
+    gfx::setProgramBinaryCacheDir(config_.programBinaryCacheDir);
+
     // reinitalize members
+    if (renderer_ && *requiresTextures_ &&
+        (renderer_->flags() & gfx::Renderer::Flag::NoTextures)) {
+      // color sensors can be added now that the textures are loaded
+      renderer_->setFlags(renderer_->flags() &
+                          ~gfx::Renderer::Flag::NoTextures);
+    }
     if (!renderer_) {
       gfx::Renderer::Flags flags;
-      if (!config_.requiresTextures)
+      if (!*requiresTextures_)
         flags |= gfx::Renderer::Flag::NoTextures;
       renderer_ = gfx::Renderer::create(flags);
     }
+    if (config_.fusedDepthUnprojection) {
+      renderer_->setFlags(renderer_->flags() |
+                          gfx::Renderer::Flag::FusedDepthUnprojection);
+    } else {
+      renderer_->setFlags(renderer_->flags() &
+                          ~gfx::Renderer::Flag::FusedDepthUnprojection);
+    }
+    if (!config_.programBinaryCacheDir.empty()) {
+      renderer_->prewarmShaders();
+    }
 
     auto& sceneGraph = sceneManager_->getSceneGraph(activeSceneID_);
     auto& rootNode = sceneGraph.getRootNode();
@@ -185,8 +327,18 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
     bool loadSuccess = false;
 
     // (re)seat & (re)init physics manager
-    resourceManager_->initPhysicsManager(physicsManager_, config_.enablePhysics,
-                                         &rootNode, physicsManagerAttributes);
+    if (config_.renderOnly && config_.enablePhysics) {
+      LOG(WARNING) << "Simulator::reconfigure : physics is not enabled for "
+                      "a render only simulator";
+    }
+    // the chunks of the previous stage are in its physics world
+    stageStreamer_ = nullptr;
+    resourceManager_->initPhysicsManager(
+        physicsManager_, config_.enablePhysics && !config_.renderOnly,
+        &rootNode, physicsManagerAttributes);
+    if (cloneSource_ && cloneSource_->physicsManager_ && physicsManager_) {
+      physicsManager_->shareCollisionShapes(*cloneSource_->physicsManager_);
+    }
 
     std::vector<int> tempIDs{activeSceneID_, activeSemanticSceneID_};
     // Load scene
@@ -200,6 +352,30 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
       throw std::invalid_argument("Cannot load: " + stageFilename);
     }
 
+    // the stage meshes visible from each navigable cell, if precomputed
+    const std::string pvsFilename = io::changeExtension(
+        stageAttributes->getRenderAssetHandle(), ".pvs");
+    if (io::exists(pvsFilename)) {
+      auto pvs = gfx::PotentiallyVisibleSet::create();
+      if (pvs->load(pvsFilename)) {
+        LOG(INFO) << "Loaded the potentially visible set " << pvsFilename;
+        sceneGraph.getDrawables().setPotentiallyVisibleSet(std::move(pvs));
+      } else {
+        LOG(WARNING) << "Cannot read the potentially visible set "
+                     << pvsFilename;
+      }
+    }
+
+    // the chunks of a stage too large to be resident, if it is chunked, the
+    // navmesh shared by clones is left whole
+    assets::StageStreamer::Configuration streaming;
+    streaming.loadRadius = config_.stageChunkLoadRadius;
+    streaming.evictRadius = config_.stageChunkEvictRadius;
+    stageStreamer_ = resourceManager_->createStageStreamer(
+        stageAttributes, rootNode, sceneGraph.getDrawables(),
+        config_.renderOnly ? nullptr : physicsManager_,
+        cloneSource_ ? nullptr : pathfinder_, streaming);
+
     // refresh the NavMesh visualization if necessary after loading a new
     // SceneGraph
     if (isNavMeshVisualizationActive()) {
@@ -225,10 +401,12 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
         sceneID_.push_back(activeSemanticSceneID_);
       } else {  // activeSemanticSceneID_ = activeSceneID_;
         // instance meshes and suncg houses contain their semantic annotations
-        // empty scene has none to worry about
+        // empty scene has none to worry about, and neither has a stage
+        // drawing the ids of its semantic mesh
         if (!(stageType == assets::AssetType::SUNCG_SCENE ||
               stageType == assets::AssetType::INSTANCE_MESH ||
-              stageFilename.compare(assets::EMPTY_SCENE) == 0)) {
+              stageFilename.compare(assets::EMPTY_SCENE) == 0 ||
+              resourceManager_->stageHasSemanticVertexIds())) {
           // TODO: programmatic generation of semantic meshes when no
           // annotations are provided.
           LOG(WARNING) << ":\n---\n The active scene does not contain semantic "
@@ -239,56 +417,264 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
   }    // if (config_.createRenderer)
 
   semanticScene_ = nullptr;
-  semanticScene_ = scene::SemanticScene::create();
-  switch (stageType) {
-    case assets::AssetType::INSTANCE_MESH:
-      houseFilename = Cr::Utility::Directory::join(
-          Cr::Utility::Directory::path(houseFilename), "info_semantic.json");
-      if (io::exists(houseFilename)) {
-        scene::SemanticScene::loadReplicaHouse(houseFilename, *semanticScene_);
-      }
-      break;
-    case assets::AssetType::MP3D_MESH:
-      // TODO(msb) Fix AssetType determination logic.
-      if (io::exists(houseFilename)) {
-        using Corrade::Utility::String::endsWith;
-        if (endsWith(houseFilename, ".house")) {
-          scene::SemanticScene::loadMp3dHouse(houseFilename, *semanticScene_);
-        } else if (endsWith(houseFilename, ".scn")) {
-          scene::SemanticScene::loadGibsonHouse(houseFilename, *semanticScene_);
+  if (cloneSource_) {
+    semanticScene_ = cloneSource_->semanticScene_;
+  } else {
+    semanticScene_ = scene::SemanticScene::create();
+    core::ScopedTimer timer{core::ProfilingStage::SemanticSceneLoading};
+    switch (stageType) {
+      case assets::AssetType::INSTANCE_MESH:
+        houseFilename = Cr::Utility::Directory::join(
+            Cr::Utility::Directory::path(houseFilename),
+            "info_semantic.json");
+        if (io::exists(houseFilename)) {
+          scene::SemanticScene::loadReplicaHouse(houseFilename,
+                                                 *semanticScene_);
         }
-      }
-      break;
-    case assets::AssetType::SUNCG_SCENE:
-      scene::SemanticScene::loadSuncgHouse(stageFilename, *semanticScene_);
-      break;
-    default:
-      break;
+        break;
+      case assets::AssetType::MP3D_MESH:
+        // TODO(msb) Fix AssetType determination logic.
+        if (io::exists(houseFilename)) {
+          using Corrade::Utility::String::endsWith;
+          if (endsWith(houseFilename, ".house")) {
+            scene::SemanticScene::loadMp3dHouse(houseFilename,
+                                                *semanticScene_);
+          } else if (endsWith(houseFilename, ".scn")) {
+            scene::SemanticScene::loadGibsonHouse(houseFilename,
+                                                  *semanticScene_);
+          }
+        }
+        break;
+      case assets::AssetType::SUNCG_SCENE:
+        scene::SemanticScene::loadSuncgHouse(stageFilename, *semanticScene_);
+        break;
+      default:
+        break;
+    }
+  }
+  if (renderer_) {
+    // for the ObservationFormat::SEMANTIC_CATEGORY semantic observations
+    renderer_->setObjectIdLookup(semanticScene_->objectCategoryIndices());
+  }
+
+  if (config_.residentScenes > 0) {
+    keepActiveSceneResident();
   }
 
   reset();
+  pinStageAssets();
+  restartViewCache();
 }  // Simulator::reconfigure
 
+void Simulator::pinStageAssets() {
+  unpinStageAssets();
+  pinnedStageAssets_ = resourceManager_->getCurrentStageAssets();
+  resourceManager_->pinStageAssets(pinnedStageAssets_);
+}
+
+void Simulator::unpinStageAssets() {
+  if (resourceManager_) {
+    resourceManager_->unpinStageAssets(pinnedStageAssets_);
+  }
+  pinnedStageAssets_.clear();
+}
+
+bool Simulator::switchToResidentScene() {
+  auto resident = std::find_if(
+      residentScenes_.begin(), residentScenes_.end(),
+      [&](const ResidentScene& scene) { return scene.config == config_; });
+  if (resident == residentScenes_.end()) {
+    return false;
+  }
+  // the most recently active first
+  std::rotate(residentScenes_.begin(), resident, resident + 1);
+  const ResidentScene& scene = residentScenes_.front();
+  LOG(INFO) << "Simulator::switchToResidentScene : Switching to resident "
+               "scene "
+            << config_.scene.id;
+
+  activeSceneID_ = scene.sceneID;
+  activeSemanticSceneID_ = scene.semanticSceneID;
+  physicsManager_ = scene.physicsManager;
+  pathfinder_ = scene.pathfinder;
+  stageStreamer_ = scene.stageStreamer;
+  semanticScene_ = scene.semanticScene;
+  resourceManager_->useStageAssets(scene.stageAssets);
+  if (config_.createRenderer) {
+    resourceManager_->setLightSetup(scene.lightSetup);
+  }
+  moveAgentsToActiveScene();
+  seed(config_.randomSeed);
+
+  if (isNavMeshVisualizationActive()) {
+    // the visualization is in the previous scene graph
+    setNavMeshVisualization(false);
+    setNavMeshVisualization(true);
+  }
+  if (renderer_) {
+    renderer_->setObjectIdLookup(semanticScene_->objectCategoryIndices());
+  }
+  activeSceneReused_ = true;
+
+  reset();
+  return true;
+}
+
+void Simulator::keepActiveSceneResident() {
+  ResidentScene scene;
+  scene.config = config_;
+  scene.sceneID = activeSceneID_;
+  scene.semanticSceneID = activeSemanticSceneID_;
+  scene.physicsManager = physicsManager_;
+  scene.pathfinder = pathfinder_;
+  scene.semanticScene = semanticScene_;
+  scene.stageAssets = resourceManager_->getCurrentStageAssets();
+  if (config_.createRenderer) {
+    scene.lightSetup = *resourceManager_->getLightSetup();
+  }
+  scene.stageStreamer = stageStreamer_;
+  residentScenes_.insert(residentScenes_.begin(), std::move(scene));
+  moveAgentsToActiveScene();
+
+  // loading the stage may have released the assets of resident scenes
+  const std::vector<std::string> cachedAssets =
+      resourceManager_->getCachedStageAssets();
+  std::vector<ResidentScene> kept;
+  for (ResidentScene& resident : residentScenes_) {
+    const bool assetsLoaded = std::all_of(
+        resident.stageAssets.begin(), resident.stageAssets.end(),
+        [&](const std::string& asset) {
+          return std::find(cachedAssets.begin(), cachedAssets.end(), asset) !=
+                 cachedAssets.end();
+        });
+    if (assetsLoaded && kept.size() < size_t(config_.residentScenes)) {
+      kept.push_back(std::move(resident));
+    } else {
+      releaseResidentScene(resident);
+    }
+  }
+  residentScenes_ = std::move(kept);
+}
+
+void Simulator::releaseResidentScene(ResidentScene& scene) {
+  LOG(INFO) << "Simulator::releaseResidentScene : Releasing scene "
+            << scene.config.scene.id;
+  // the chunks and the objects live in the scene graph
+  scene.stageStreamer = nullptr;
+  scene.physicsManager = nullptr;
+  sceneManager_->releaseSceneGraph(scene.sceneID);
+  if (scene.semanticSceneID != ID_UNDEFINED &&
+      scene.semanticSceneID != scene.sceneID) {
+    sceneManager_->releaseSceneGraph(scene.semanticSceneID);
+  }
+}
+
+void Simulator::moveAgentsToActiveScene() {
+  scene::SceneNode& rootNode = getActiveSceneGraph().getRootNode();
+  for (const agent::Agent::ptr& agent : agents_) {
+    agent->node().setParent(&rootNode);
+  }
+}
+
+std::vector<std::string> Simulator::getResidentScenes() const {
+  std::vector<std::string> scenes;
+  for (const ResidentScene& scene : residentScenes_) {
+    scenes.push_back(scene.config.scene.id);
+  }
+  return scenes;
+}
+
+void Simulator::prefetchScene(const std::string& sceneFilename) {
+  if (!resourceManager_ || !Magnum::GL::Context::hasCurrent()) {
+    LOG(WARNING) << "Simulator::prefetchScene : No renderer yet, not "
+                    "prefetching "
+                 << sceneFilename;
+    return;
+  }
+  auto stageAttributes =
+      resourceManager_->getStageAttributesManager()->createObject(sceneFilename,
+                                                                  true);
+  if (stageAttributes) {
+    resourceManager_->prefetchStage(stageAttributes);
+  }
+}
+
 void Simulator::reset() {
+  waitForPhysicsStep();
+  recordEvent(SessionEventType::Reset);
   if (physicsManager_ != nullptr) {
     // Note: only resets time to 0 by default.
     physicsManager_->reset();
   }
 
+  // frames queued before the reset must not be returned after it
+  discardAsyncObservationReadbacks();
+  scheduledSensors_.clear();
+
   for (auto& agent : agents_) {
     agent->reset();
   }
   const Magnum::Range3D& sceneBB =
       getActiveSceneGraph().getRootNode().computeCumulativeBB();
   resourceManager_->setLightSetup(gfx::getLightsAtBoxCorners(sceneBB));
+  // the chunks around the initial states, after the lights of the stage
+  updateStageStreaming(true);
 }  // Simulator::reset()
 
+bool Simulator::resetEpisode(
+    const std::vector<agent::AgentState>& agentStates,
+    const esp::physics::PhysicsSnapshot& objectStates) {
+  waitForPhysicsStep();
+  // frames queued in the previous episode must not be returned in this one
+  discardAsyncObservationReadbacks();
+  scheduledSensors_.clear();
+
+  bool success = true;
+  if (agentStates.size() > agents_.size()) {
+    LOG(ERROR) << "Simulator::resetEpisode: " << agentStates.size()
+               << " agent states for " << agents_.size() << " agents";
+    success = false;
+  }
+  for (int agentId = 0;
+       agentId < std::min(agentStates.size(), agents_.size()); ++agentId) {
+    agents_[agentId]->setState(agentStates[agentId]);
+  }
+
+  if (physicsManager_ != nullptr) {
+    success &= physicsManager_->restoreSnapshot(objectStates);
+  }
+  updateStageStreaming(true);
+  return success;
+}
+
+void Simulator::updateStageStreaming(const bool wait) {
+  if (!stageStreamer_) {
+    return;
+  }
+  std::vector<Magnum::Vector3> positions;
+  positions.reserve(agents_.size());
+  for (const auto& agent : agents_) {
+    positions.push_back(agent->node().absoluteTranslation());
+  }
+  stageStreamer_->update(positions, wait);
+}
+
 void Simulator::seed(uint32_t newSeed) {
+  if (SessionEvent* event = recordEvent(SessionEventType::Seed)) {
+    event->seed = newSeed;
+  }
   random_->seed(newSeed);
   pathfinder_->seed(newSeed);
+  if (resourceManager_) {
+    // random template handles are sampled reproducibly
+    resourceManager_->getAssetAttributesManager()->seed(newSeed);
+    resourceManager_->getObjectAttributesManager()->seed(newSeed);
+  }
 }
 
 scene::SceneGraph& Simulator::getActiveSceneGraph() {
+  // drawing reads the nodes the physics writes
+  waitForPhysicsStep();
   CHECK_GE(activeSceneID_, 0);
   CHECK_LT(activeSceneID_, sceneID_.size());
   return sceneManager_->getSceneGraph(activeSceneID_);
@@ -296,6 +682,7 @@ scene::SceneGraph& Simulator::getActiveSceneGraph() {
 
 //! return the semantic scene's SceneGraph for rendering
 scene::SceneGraph& Simulator::getActiveSemanticSceneGraph() {
+  waitForPhysicsStep();
   CHECK_GE(activeSemanticSceneID_, 0);
   CHECK_LT(activeSemanticSceneID_, sceneID_.size());
   return sceneManager_->getSceneGraph(activeSemanticSceneID_);
@@ -312,8 +699,17 @@ int Simulator::addObject(const int objectLibId,
     // to own reference to a sceneGraph to avoid this.
     auto& sceneGraph_ = sceneManager_->getSceneGraph(activeSceneID_);
     auto& drawables = sceneGraph_.getDrawables();
-    return physicsManager_->addObject(objectLibId, &drawables, attachmentNode,
-                                      lightSetupKey);
+    const int objectID = physicsManager_->addObject(
+        objectLibId, &drawables, attachmentNode, lightSetupKey);
+    SessionEvent* event = objectID != ID_UNDEFINED
+                              ? recordEvent(SessionEventType::AddObject)
+                              : nullptr;
+    if (event) {
+      event->id = objectID;
+      event->name =
+          getObjectAttributesManager()->getObjectHandleByID(objectLibId);
+    }
+    return objectID;
   }
   return ID_UNDEFINED;
 }
@@ -327,12 +723,105 @@ int Simulator::addObjectByHandle(const std::string& objectLibHandle,
     // to own reference to a sceneGraph to avoid this.
     auto& sceneGraph_ = sceneManager_->getSceneGraph(activeSceneID_);
     auto& drawables = sceneGraph_.getDrawables();
-    return physicsManager_->addObject(objectLibHandle, &drawables,
-                                      attachmentNode, lightSetupKey);
+    const int objectID = physicsManager_->addObject(
+        objectLibHandle, &drawables, attachmentNode, lightSetupKey);
+    SessionEvent* event = objectID != ID_UNDEFINED
+                              ? recordEvent(SessionEventType::AddObject)
+                              : nullptr;
+    if (event) {
+      event->id = objectID;
+      event->name = objectLibHandle;
+    }
+    return objectID;
   }
   return ID_UNDEFINED;
 }
 
+std::vector<int> Simulator::loadSceneInstance(
+    const std::string& sceneInstanceFile,
+    const int sceneID) {
+  if (!sceneHasPhysics(sceneID)) {
+    return {};
+  }
+  const Attrs::SceneAttributes::ptr sceneAttributes =
+      getSceneAttributesManager()->createObject(sceneInstanceFile, true);
+  if (nullptr == sceneAttributes) {
+    return {};
+  }
+  const std::vector<Attrs::SceneObjectInstance>& instances =
+      sceneAttributes->getObjectInstances();
+
+  // resolve the template of each distinct name once
+  auto objectAttributesMgr = getObjectAttributesManager();
+  std::unordered_map<std::string, std::string> templateHandles;
+  std::vector<std::string> handles;
+  handles.reserve(instances.size());
+  for (const Attrs::SceneObjectInstance& instance : instances) {
+    auto found = templateHandles.find(instance.templateHandle);
+    if (found == templateHandles.end()) {
+      std::string handle = instance.templateHandle;
+      if (!objectAttributesMgr->getObjectLibHasHandle(handle)) {
+        std::vector<std::string> matches =
+            objectAttributesMgr->getObjectHandlesBySubstring(handle);
+        handle = matches.empty() ? "" : matches[0];
+      }
+      if (handle.empty()) {
+        LOG(ERROR) << "Simulator::loadSceneInstance : No object template "
+                      "matching "
+                   << instance.templateHandle << " in " << sceneInstanceFile
+                   << ". Skipping its objects.";
+      }
+      found = templateHandles.emplace(instance.templateHandle, handle).first;
+    }
+    handles.push_back(found->second);
+  }
+
+  std::string lightSetupKey = sceneAttributes->getLightSetup();
+  if (lightSetupKey.empty()) {
+    lightSetupKey = assets::ResourceManager::DEFAULT_LIGHTING_KEY;
+  }
+  // TODO: change implementation to support multi-world and physics worlds
+  // to own reference to a sceneGraph to avoid this.
+  auto& sceneGraph_ = sceneManager_->getSceneGraph(activeSceneID_);
+  auto& drawables = sceneGraph_.getDrawables();
+  std::vector<int> objectIDs =
+      physicsManager_->addObjects(handles, &drawables, lightSetupKey);
+
+  // place the objects in one batch, before they may become static
+  std::vector<int> placedIDs;
+  std::vector<Magnum::Vector3> translations;
+  std::vector<Magnum::Quaternion> rotations;
+  for (size_t i = 0; i < instances.size(); ++i) {
+    if (objectIDs[i] != ID_UNDEFINED) {
+      placedIDs.push_back(objectIDs[i]);
+      translations.push_back(instances[i].translation);
+      rotations.push_back(instances[i].rotation);
+    }
+  }
+  physicsManager_->setRigidStates(placedIDs, translations, rotations);
+
+  for (size_t i = 0; i < instances.size(); ++i) {
+    if (objectIDs[i] == ID_UNDEFINED) {
+      continue;
+    }
+    const Attrs::SceneObjectInstance& instance = instances[i];
+    if (instance.motionType == "STATIC") {
+      physicsManager_->setObjectMotionType(objectIDs[i],
+                                           physics::MotionType::STATIC);
+    } else if (instance.motionType == "KINEMATIC") {
+      physicsManager_->setObjectMotionType(objectIDs[i],
+                                           physics::MotionType::KINEMATIC);
+    } else if (instance.motionType == "DYNAMIC") {
+      physicsManager_->setObjectMotionType(objectIDs[i],
+                                           physics::MotionType::DYNAMIC);
+    } else if (!instance.motionType.empty()) {
+      LOG(ERROR) << "Simulator::loadSceneInstance : Unknown motion type "
+                 << instance.motionType << " in " << sceneInstanceFile;
+    }
+  }
+  return objectIDs;
+}
+
 const Attrs::ObjectAttributes::cptr Simulator::getObjectInitializationTemplate(
     const int objectId,
     const int sceneID) const {
@@ -358,6 +847,23 @@ std::vector<int> Simulator::getExistingObjectIDs(const int sceneID) {
   return std::vector<int>();  // empty if no simulator exists
 }
 
+std::vector<int> Simulator::getActiveObjectIds(const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->getActiveObjectIds();
+  }
+  return {};
+}
+
+void Simulator::setObjectSleepingThresholds(const double linThreshold,
+                                            const double angThreshold,
+                                            const int objectID,
+                                            const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->setSleepingThresholds(objectID, linThreshold,
+                                           angThreshold);
+  }
+}
+
 // remove object objectID instance in sceneID
 void Simulator::removeObject(const int objectID,
                              bool deleteObjectNode,
@@ -365,7 +871,30 @@ void Simulator::removeObject(const int objectID,
                              const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
     physicsManager_->removeObject(objectID, deleteObjectNode, deleteVisualNode);
+    if (SessionEvent* event = recordEvent(SessionEventType::RemoveObject)) {
+      event->id = objectID;
+    }
+  }
+}
+
+void Simulator::setObjectPooling(const bool enabled, const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->setObjectPooling(enabled);
+  }
+}
+
+bool Simulator::getObjectPooling(const int sceneID) const {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->getObjectPooling();
+  }
+  return false;
+}
+
+int Simulator::getNumPooledObjects(const int sceneID) const {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->getNumPooledObjects();
   }
+  return 0;
 }
 
 esp::physics::MotionType Simulator::getObjectMotionType(const int objectID,
@@ -444,6 +973,7 @@ void Simulator::setTransformation(const Magnum::Matrix4& transform,
                                   const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
     physicsManager_->setTransformation(objectID, transform);
+    recordRigidState(objectID, sceneID);
   }
 }
 
@@ -468,7 +998,55 @@ void Simulator::setRigidState(const esp::core::RigidState& rigidState,
                               const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
     physicsManager_->setRigidState(objectID, rigidState);
+    recordRigidState(objectID, sceneID);
+  }
+}
+
+void Simulator::getRigidStates(
+    const std::vector<int>& objectIDs,
+    Corrade::Containers::ArrayView<Magnum::Vector3> translations,
+    Corrade::Containers::ArrayView<Magnum::Quaternion> rotations,
+    const int sceneID) const {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->getRigidStates(objectIDs, translations, rotations);
+  }
+}
+
+void Simulator::setRigidStates(
+    const std::vector<int>& objectIDs,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> translations,
+    Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations,
+    const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->setRigidStates(objectIDs, translations, rotations);
+    for (const int objectID : objectIDs) {
+      recordRigidState(objectID, sceneID);
+    }
+  }
+}
+
+void Simulator::recordRigidState(const int objectID, const int sceneID) {
+  if (SessionEvent* event = recordEvent(SessionEventType::SetRigidState)) {
+    event->id = objectID;
+    event->states.push_back(getRigidState(objectID, sceneID));
+  }
+}
+
+esp::physics::PhysicsSnapshot Simulator::savePhysicsSnapshot(
+    const int sceneID) const {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->saveSnapshot();
   }
+  return esp::physics::PhysicsSnapshot();
+}
+
+bool Simulator::restorePhysicsSnapshot(
+    const esp::physics::PhysicsSnapshot& snapshot,
+    const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->restoreSnapshot(snapshot);
+  }
+  return false;
 }
 
 // set object translation directly
@@ -477,6 +1055,7 @@ void Simulator::setTranslation(const Magnum::Vector3& translation,
                                const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
     physicsManager_->setTranslation(objectID, translation);
+    recordRigidState(objectID, sceneID);
   }
 }
 
@@ -496,6 +1075,7 @@ void Simulator::setRotation(const Magnum::Quaternion& rotation,
                             const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
     physicsManager_->setRotation(objectID, rotation);
+    recordRigidState(objectID, sceneID);
   }
 }
 
@@ -539,6 +1119,26 @@ Magnum::Vector3 Simulator::getAngularVelocity(const int objectID,
   return Magnum::Vector3();
 }
 
+void Simulator::getVelocities(
+    const std::vector<int>& objectIDs,
+    Corrade::Containers::ArrayView<Magnum::Vector3> linVels,
+    Corrade::Containers::ArrayView<Magnum::Vector3> angVels,
+    const int sceneID) const {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->getVelocities(objectIDs, linVels, angVels);
+  }
+}
+
+void Simulator::setVelocities(
+    const std::vector<int>& objectIDs,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> linVels,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> angVels,
+    const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->setVelocities(objectIDs, linVels, angVels);
+  }
+}
+
 bool Simulator::contactTest(const int objectID, const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
     return physicsManager_->contactTest(objectID);
@@ -555,6 +1155,38 @@ esp::physics::RaycastResults Simulator::castRay(const esp::geo::Ray& ray,
   return esp::physics::RaycastResults();
 }
 
+esp::physics::BatchRaycastResults Simulator::castRays(
+    const std::vector<esp::geo::Ray>& rays,
+    float maxDistance,
+    int numThreads,
+    const int sceneID) {
+  esp::physics::BatchRaycastResults results;
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->castRays(rays, results, maxDistance, numThreads);
+  } else {
+    results.reset(rays.size());
+  }
+  return results;
+}
+
+std::vector<int> Simulator::boxOverlapTest(const Magnum::Vector3& center,
+                                           const Magnum::Vector3& halfExtents,
+                                           const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->boxOverlapTest(center, halfExtents);
+  }
+  return {};
+}
+
+esp::physics::ContactPointResults Simulator::getContactPoints(
+    const int sceneID) {
+  esp::physics::ContactPointResults results;
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->getContactPoints(results);
+  }
+  return results;
+}
+
 void Simulator::setObjectBBDraw(bool drawBB,
                                 const int objectID,
                                 const int sceneID) {
@@ -570,18 +1202,99 @@ void Simulator::setObjectSemanticId(uint32_t semanticId,
                                     const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
     physicsManager_->setSemanticId(objectID, semanticId);
+    markSceneChanged();
   }
 }
 
 double Simulator::stepWorld(const double dt) {
+  core::ScopedTraceEvent trace{"Simulator::stepWorld", "sim"};
+  beginWorldStep(dt);
   if (physicsManager_ != nullptr) {
     physicsManager_->stepPhysics(dt);
+    // the moves of instanced objects are not in the drawables epochs
+    if (physicsManager_->getNumRigidObjects() > 0) {
+      markSceneChanged();
+    }
   }
   return getWorldTime();
 }
 
+void Simulator::beginWorldStep(const double dt) {
+  waitForPhysicsStep();
+  if (SessionEvent* event = recordEvent(SessionEventType::StepWorld)) {
+    event->dt = dt;
+  }
+  stepAgentVelocityControl(dt);
+  updateStageStreaming();
+}
+
+void Simulator::launchPhysicsStep(const double dt) {
+  // the moves of instanced objects are not in the drawables epochs
+  if (physicsManager_->getNumRigidObjects() > 0) {
+    markSceneChanged();
+  }
+  physicsStep_ = std::async(std::launch::async, [this, dt]() {
+    physicsManager_->stepPhysics(dt);
+    // only this thread swaps the buffers, readers copy the front one
+    const int back = 1 - frontPhysicsSnapshot_;
+    physicsSnapshots_[back] = physicsManager_->saveSnapshot();
+    std::lock_guard<std::mutex> lock{physicsSnapshotMutex_};
+    frontPhysicsSnapshot_ = back;
+  });
+}
+
+void Simulator::setAsyncPhysicsEnabled(bool val) {
+  if (!val) {
+    waitForPhysicsStep();
+  }
+  asyncPhysics_ = val;
+}
+
+esp::physics::PhysicsSnapshot Simulator::getLatestPhysicsSnapshot() const {
+  std::lock_guard<std::mutex> lock{physicsSnapshotMutex_};
+  return physicsSnapshots_[frontPhysicsSnapshot_];
+}
+
+void Simulator::stepAgentVelocityControl(const double dt) {
+  using Magnum::EigenIntegration::cast;
+  const bool constrained = pathfinder_->isLoaded();
+  for (const auto& agent : agents_) {
+    const physics::VelocityControl& velocityControl =
+        *agent->getVelocityControl();
+    if (!velocityControl.controllingLinVel &&
+        !velocityControl.controllingAngVel) {
+      continue;
+    }
+    const agent::AgentConfiguration& config = agent->getConfig();
+    const int numSubsteps =
+        std::max(1, int(std::ceil(dt / config.velocityControlSubstep)));
+    const float substep = dt / numSubsteps;
+    scene::SceneNode& node = agent->node();
+    for (int i = 0; i < numSubsteps; ++i) {
+      const vec3f start =
+          cast<vec3f>(node.absoluteTransformation().translation());
+      const core::RigidState state = velocityControl.integrateTransform(
+          substep, core::RigidState{node.rotation(), node.translation()});
+      node.setRotation(state.rotation);
+      node.setTranslation(state.translation);
+      if (!constrained) {
+        continue;
+      }
+      // the navmesh works in world space, correct like the move filter of
+      // scene::ObjectControls does
+      const vec3f end =
+          cast<vec3f>(node.absoluteTransformation().translation());
+      const vec3f filteredEnd = config.velocityControlAllowSliding
+                                    ? pathfinder_->tryStep(start, end)
+                                    : pathfinder_->tryStepNoSliding(start, end);
+      node.translate(Magnum::Vector3(vec3f(filteredEnd - end)));
+    }
+  }
+}
+
 // get the simulated world time (0 if no physics enabled)
 double Simulator::getWorldTime() {
+  waitForPhysicsStep();
   if (physicsManager_ != nullptr) {
     return physicsManager_->getWorldTime();
   }
@@ -601,17 +1314,9 @@ Magnum::Vector3 Simulator::getGravity(const int sceneID) const {
   return Magnum::Vector3();
 }
 
-bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
-                                 const nav::NavMeshSettings& navMeshSettings,
-                                 bool includeStaticObjects) {
-  CORRADE_ASSERT(config_.createRenderer,
-                 "Simulator::recomputeNavMesh: "
-                 "SimulatorConfiguration::createRenderer is "
-                 "false. Scene geometry is required to recompute navmesh. No "
-                 "geometry is "
-                 "loaded without renderer initialization.",
-                 false);
-
+assets::MeshData::uptr Simulator::joinedNavMeshGeometry(
+    bool includeStaticObjects) {
+  waitForPhysicsStep();
   assets::MeshData::uptr joinedMesh = assets::MeshData::create_unique();
   auto stageInitAttrs = physicsManager_->getStageInitAttributes();
   if (stageInitAttrs != nullptr) {
@@ -654,11 +1359,72 @@ bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
     }
   }
 
+  return joinedMesh;
+}
+
+bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
+                                 const nav::NavMeshSettings& navMeshSettings,
+                                 bool includeStaticObjects) {
+  CORRADE_ASSERT(config_.createRenderer,
+                 "Simulator::recomputeNavMesh: "
+                 "SimulatorConfiguration::createRenderer is "
+                 "false. Scene geometry is required to recompute navmesh. No "
+                 "geometry is "
+                 "loaded without renderer initialization.",
+                 false);
+
+  assets::MeshData::uptr joinedMesh =
+      joinedNavMeshGeometry(includeStaticObjects);
+
   if (!pathfinder.build(navMeshSettings, *joinedMesh)) {
     LOG(ERROR) << "Failed to build navmesh";
     return false;
   }
 
+  refreshNavMeshVisualization(pathfinder);
+
+  LOG(INFO) << "reconstruct navmesh successful";
+  return true;
+}
+
+std::vector<nav::PathFinder::ptr> Simulator::recomputeNavMeshVariants(
+    const std::vector<nav::NavMeshSettings>& navMeshSettings,
+    bool includeStaticObjects) {
+  CORRADE_ASSERT(config_.createRenderer,
+                 "Simulator::recomputeNavMeshVariants: "
+                 "SimulatorConfiguration::createRenderer is false. Scene "
+                 "geometry is required to recompute navmeshes.",
+                 {});
+
+  assets::MeshData::uptr joinedMesh =
+      joinedNavMeshGeometry(includeStaticObjects);
+
+  return nav::PathFinder::buildVariants(navMeshSettings, *joinedMesh);
+}
+
+bool Simulator::updateNavMeshRegion(nav::PathFinder& pathfinder,
+                                    const vec3f& regionMin,
+                                    const vec3f& regionMax,
+                                    bool includeStaticObjects) {
+  CORRADE_ASSERT(config_.createRenderer,
+                 "Simulator::updateNavMeshRegion: "
+                 "SimulatorConfiguration::createRenderer is false. Scene "
+                 "geometry is required to update the navmesh.",
+                 false);
+
+  assets::MeshData::uptr joinedMesh =
+      joinedNavMeshGeometry(includeStaticObjects);
+
+  if (!pathfinder.updateRegion(*joinedMesh, regionMin, regionMax)) {
+    LOG(ERROR) << "Failed to update navmesh region";
+    return false;
+  }
+
+  refreshNavMeshVisualization(pathfinder);
+  return true;
+}
+
+void Simulator::refreshNavMeshVisualization(nav::PathFinder& pathfinder) {
   if (&pathfinder == pathfinder_.get()) {
     if (isNavMeshVisualizationActive()) {
       // if updating pathfinder_ instance, refresh the visualization.
@@ -666,9 +1432,6 @@ bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
       setNavMeshVisualization(true);
     }
   }
-
-  LOG(INFO) << "reconstruct navmesh successful";
-  return true;
 }
 
 bool Simulator::setNavMeshVisualization(bool visualize) {
@@ -725,6 +1488,15 @@ agent::Agent::ptr Simulator::addAgent(
   // transformation of the sensor w.r.t. the agent (done internally in the
   // constructor of Agent)
 
+  if (SessionEvent* event = recordEvent(SessionEventType::AddAgent)) {
+    event->agentConfig = agentConfig;
+    // the specs may be changed after they were added
+    for (sensor::SensorSpec::ptr& spec :
+         event->agentConfig.sensorSpecifications) {
+      spec = sensor::SensorSpec::create(*spec);
+    }
+  }
+
   auto& agentNode = agentParentNode.createChild();
   agent::Agent::ptr ag = agent::Agent::create(agentNode, agentConfig);
 
@@ -737,6 +1509,7 @@ agent::Agent::ptr Simulator::addAgent(
     if (it.second->isVisualSensor()) {
       auto sensor = static_cast<sensor::VisualSensor*>(it.second.get());
       renderer_->bindRenderTarget(*sensor);
+      fitTextureSizeToSensor(*sensor);
     }
   }
 
@@ -757,6 +1530,17 @@ agent::Agent::ptr Simulator::addAgent(
   return addAgent(agentConfig, getActiveSceneGraph().getRootNode());
 }
 
+void Simulator::fitTextureSizeToSensor(const sensor::VisualSensor& sensor) {
+  if (config_.maxTextureSize <= 0) {
+    return;
+  }
+  sensorTextureSize_ =
+      std::max(sensorTextureSize_, 2 * sensor.framebufferSize().max());
+  if (sensorTextureSize_ > resourceManager_->getMaxTextureSize()) {
+    resourceManager_->setMaxTextureSize(sensorTextureSize_);
+  }
+}
+
 agent::Agent::ptr Simulator::getAgent(const int agentId) {
   ASSERT(0 <= agentId && agentId < agents_.size());
   return agents_[agentId];
@@ -768,6 +1552,14 @@ nav::PathFinder::ptr Simulator::getPathFinder() {
 
 void Simulator::setPathFinder(nav::PathFinder::ptr pathfinder) {
   pathfinder_ = pathfinder;
+  if (stageStreamer_) {
+    stageStreamer_->setPathFinder(pathfinder_);
+  }
+  // switching back to the active scene restores this one
+  if (!residentScenes_.empty() &&
+      residentScenes_.front().sceneID == activeSceneID_) {
+    residentScenes_.front().pathfinder = pathfinder_;
+  }
 }
 gfx::RenderTarget* Simulator::getRenderTarget(int agentId,
                                               const std::string& sensorId) {
@@ -783,8 +1575,46 @@ gfx::RenderTarget* Simulator::getRenderTarget(int agentId,
   return nullptr;
 }
 
+void Simulator::saveFrame(const std::string& filename) {
+  agent::Agent::ptr ag = getAgent(config_.defaultAgentId);
+  if (ag != nullptr) {
+    for (const sensor::Sensor::ptr& sensor :
+         ag->getSensorSuite().getSensorList()) {
+      if (sensor->isVisualSensor() &&
+          sensor->specification()->sensorType == sensor::SensorType::COLOR) {
+        saveFrame(config_.defaultAgentId, sensor->specification()->uuid,
+                  filename);
+        return;
+      }
+    }
+  }
+  LOG(ERROR) << "Simulator::saveFrame : The default agent has no color "
+                "sensor, not writing "
+             << filename;
+}
+
+bool Simulator::saveFrame(const int agentId,
+                          const std::string& sensorId,
+                          const std::string& filename) {
+  gfx::RenderTarget* target = getRenderTarget(agentId, sensorId);
+  if (target == nullptr) {
+    LOG(ERROR) << "Simulator::saveFrame : Agent " << agentId
+               << " has no visual sensor " << sensorId;
+    return false;
+  }
+  return getFrameEncoder().encodeFrame(*target, filename);
+}
+
+gfx::FrameEncoder& Simulator::getFrameEncoder() {
+  if (!frameEncoder_) {
+    frameEncoder_ = gfx::FrameEncoder::create_unique();
+  }
+  return *frameEncoder_;
+}
+
 bool Simulator::displayObservation(const int agentId,
                                    const std::string& sensorId) {
+  waitForPhysicsStep();
   agent::Agent::ptr ag = getAgent(agentId);
 
   if (ag != nullptr) {
@@ -798,6 +1628,7 @@ bool Simulator::displayObservation(const int agentId,
 
 bool Simulator::drawObservation(const int agentId,
                                 const std::string& sensorId) {
+  waitForPhysicsStep();
   agent::Agent::ptr ag = getAgent(agentId);
 
   if (ag != nullptr) {
@@ -810,9 +1641,90 @@ bool Simulator::drawObservation(const int agentId,
   return false;
 }
 
+core::ProfilingStats Simulator::getProfilingStats() {
+  gfx::collectGpuTimings();
+  return core::Profiler::stats();
+}
+
+void Simulator::resetProfilingStats() {
+  // results of queries still in flight belong to the old stats
+  gfx::discardGpuTimings();
+  core::Profiler::reset();
+}
+
+gfx::GpuMemoryUsage Simulator::getGpuMemoryUsage() const {
+  gfx::GpuMemoryUsage usage;
+  if (resourceManager_) {
+    usage = resourceManager_->getGpuMemoryUsage();
+  }
+  for (const agent::Agent::ptr& agent : agents_) {
+    for (const auto& sensor : agent->getSensorSuite().getSensors()) {
+      if (!sensor.second->isVisualSensor()) {
+        continue;
+      }
+      auto& visualSensor =
+          static_cast<sensor::VisualSensor&>(*sensor.second);
+      if (visualSensor.hasRenderTarget()) {
+        usage.renderTargetBytes += visualSensor.renderTarget().getGpuBytes();
+      }
+    }
+  }
+  if (renderer_) {
+    usage.renderTargetBytes += renderer_->getReleasedRenderTargetGpuBytes();
+  }
+#ifdef ESP_BUILD_WITH_CUDA
+  usage.noiseModelBytes = sensor::RedwoodNoiseModelGPUImpl::getTotalGpuBytes() +
+                          sensor::RgbNoiseModelGPUImpl::getTotalGpuBytes();
+#endif
+  return usage;
+}
+
+std::map<std::string, std::size_t> Simulator::getAssetGpuBytes() const {
+  if (!resourceManager_) {
+    return {};
+  }
+  return resourceManager_->getAssetGpuBytes();
+}
+
+void Simulator::startRecording() {
+  recording_ = std::make_unique<SessionRecording>();
+  recording_->scene = config_.scene.id;
+  for (const agent::Agent::ptr& agent : agents_) {
+    SessionEvent* event = recordEvent(SessionEventType::AddAgent);
+    event->agentConfig = agent->getConfig();
+    for (sensor::SensorSpec::ptr& spec :
+         event->agentConfig.sensorSpecifications) {
+      spec = sensor::SensorSpec::create(*spec);
+    }
+  }
+}
+
+bool Simulator::stopRecording(const std::string& filename) {
+  if (!recording_) {
+    LOG(ERROR) << "Simulator::stopRecording : Not recording";
+    return false;
+  }
+  std::unique_ptr<SessionRecording> recording = std::move(recording_);
+  return recording->save(filename);
+}
+
+void Simulator::startTracing() {
+  core::Tracer::start();
+}
+
+bool Simulator::stopTracing(const std::string& filename) {
+  // the GPU events are only recorded once their query results are in
+  if (core::Tracer::isTracing()) {
+    gfx::collectGpuTimings(/*wait=*/true);
+  }
+  return core::Tracer::stop(filename);
+}
+
 bool Simulator::getAgentObservation(const int agentId,
                                     const std::string& sensorId,
                                     sensor::Observation& observation) {
+  core::ScopedTimer timer{core::ProfilingStage::AgentObservations};
+  waitForPhysicsStep();
   agent::Agent::ptr ag = getAgent(agentId);
   if (ag != nullptr) {
     sensor::Sensor::ptr sensor = ag->getSensorSuite().get(sensorId);
@@ -826,19 +1738,734 @@ bool Simulator::getAgentObservation(const int agentId,
 int Simulator::getAgentObservations(
     const int agentId,
     std::map<std::string, sensor::Observation>& observations) {
-  observations.clear();
+  const int numObserved = getAgentObservations(agentId, sensorObservations_);
+  const std::vector<sensor::Sensor::ptr>& sensors =
+      getAgent(agentId)->getSensorSuite().getSensorList();
+
+  // update the map in place, both it and the list are ordered by uuid
+  auto it = observations.begin();
+  for (int i = 0; i < sensors.size(); ++i) {
+    const std::string& uuid = sensors[i]->specification()->uuid;
+    while (it != observations.end() && it->first < uuid) {
+      it = observations.erase(it);
+    }
+    if (sensorObservations_[i].buffer == nullptr) {
+      if (it != observations.end() && it->first == uuid) {
+        it = observations.erase(it);
+      }
+      continue;
+    }
+    if (it == observations.end() || it->first != uuid) {
+      it = observations.emplace_hint(it, uuid, sensor::Observation{});
+    }
+    it->second = sensorObservations_[i];
+    ++it;
+  }
+  observations.erase(it, observations.end());
+  return numObserved;
+}
+
+int Simulator::getAgentObservations(
+    const int agentId,
+    std::vector<sensor::Observation>& observations) {
+  core::ScopedTimer timer{core::ProfilingStage::AgentObservations};
+  waitForPhysicsStep();
+  const std::vector<sensor::Sensor::ptr>& sensors =
+      getAgent(agentId)->getSensorSuite().getSensorList();
+  observations.resize(sensors.size());
+  if (SessionEvent* event = recordEvent(SessionEventType::Observe)) {
+    const scene::SceneNode& agentNode = agents_[agentId]->node();
+    event->id = agentId;
+    event->states.emplace_back(agentNode.rotation(), agentNode.translation());
+    for (const sensor::Sensor::ptr& sensor : sensors) {
+      event->states.emplace_back(sensor->node().rotation(),
+                                 sensor->node().translation());
+    }
+  }
+
+  const bool useCache = observationCache_ && !asyncObservationReadback_;
+  const uint64_t epoch = useCache ? observationEpoch() : 0;
+  // only while the scene is the one the cache was restarted with
+  const bool useViewCache = viewCache_ && !asyncObservationReadback_ &&
+                            observationEpoch() == viewCacheEpoch_;
+  viewCacheMisses_.clear();
+  const bool shareRender = sharedSensorRender_ && !asyncObservationReadback_;
+  // semantic sensors draw the same frame as the others only if there is no
+  // separate semantic mesh
+  const bool semanticSharesScene = activeSemanticSceneID_ == activeSceneID_;
+  const bool stereoRender = stereoRender_ && !asyncObservationReadback_;
+  drawnSensors_.clear();
+  stereoDrawnSensors_.clear();
+  // unless the step already culled for the sensors of all agents
+  const bool precull = multiFrustumCulling_ && !preculledSensorFrustums_;
+  if (precull) {
+    for (const sensor::Sensor::ptr& sensor : sensors) {
+      addSensorFrustum(*sensor);
+    }
+    precullSensorFrustums();
+  }
+  int numObserved = 0;
+  for (int i = 0; i < sensors.size(); ++i) {
+    sensor::Sensor& sensor = *sensors[i];
+    sensor::Observation& obs = observations[i];
+    obs.buffer = nullptr;
+    const int updatePeriod = sensor.specification()->updatePeriod;
+    if (updatePeriod != 1) {
+      ScheduledSensor& scheduled = scheduledSensors_[&sensor];
+      if (scheduled.sensor.lock() != sensors[i]) {
+        scheduled = {sensors[i], 0, nullptr};
+      }
+      if (updatePeriod <= 0 || scheduled.calls++ % updatePeriod != 0) {
+        obs.buffer = scheduled.buffer;
+        numObserved += obs.buffer != nullptr;
+        continue;
+      }
+    }
+    const sensor::SensorType type = sensor.specification()->sensorType;
+    // the flow of an unchanged view is zero, not the cached one
+    if (useCache && sensor.isVisualSensor() &&
+        type != sensor::SensorType::OPTICAL_FLOW &&
+        sensor.specification()->noiseModel == "None") {
+      CachedObservation& cached = cachedObservations_[&sensor];
+      const Magnum::Matrix4 pose = sensor.node().absoluteTransformationMatrix();
+      if (cached.sensor.lock() == sensors[i] && cached.epoch == epoch &&
+          cached.pose == pose && cached.spec == *sensor.specification() &&
+          cached.buffer && cached.buffer == sensor.observationBuffer()) {
+        obs.buffer = cached.buffer;
+        ++numObserved;
+        continue;
+      }
+      // the buffer is set once the sensor observed
+      cached = {sensors[i], epoch, pose, *sensor.specification(), nullptr};
+    }
+    if (useViewCache && sensor.isVisualSensor() &&
+        type != sensor::SensorType::OPTICAL_FLOW &&
+        sensor.specification()->noiseModel == "None") {
+      const ViewCache::Key key =
+          viewCache_->key(viewCacheSceneHash_, *sensor.specification(),
+                          sensor.node().absoluteTransformationMatrix());
+      if (!sensor.hasObservationBuffer()) {
+        sensor::ObservationSpace space;
+        if (sensor.getObservationSpace(space)) {
+          sensor.bindObservationBuffer(
+              core::Buffer::create(space.shape, space.dataType));
+        }
+      }
+      if (sensor.hasObservationBuffer() &&
+          viewCache_->read(key, *sensor.observationBuffer())) {
+        obs.buffer = sensor.observationBuffer();
+        ++numObserved;
+        continue;
+      }
+      // written once the sensor observed
+      viewCacheMisses_.emplace_back(i, key);
+    }
+    // the second sensor of a stereo pair was drawn with the first one
+    if (std::find(stereoDrawnSensors_.begin(), stereoDrawnSensors_.end(),
+                  &sensor) != stereoDrawnSensors_.end()) {
+      auto& visualSensor = static_cast<sensor::VisualSensor&>(sensor);
+      if (visualSensor.readObservationFrom(visualSensor.renderTarget(), obs)) {
+        ++numObserved;
+      } else {
+        obs.buffer = nullptr;
+      }
+      continue;
+    }
+    if (stereoRender && sensor.isVisualSensor() &&
+        type == sensor::SensorType::DEPTH &&
+        drawStereoPair(sensors, i)) {
+      auto& visualSensor = static_cast<sensor::VisualSensor&>(sensor);
+      if (visualSensor.readObservationFrom(visualSensor.renderTarget(), obs)) {
+        if (shareRender) {
+          drawnSensors_.push_back(&visualSensor);
+        }
+        ++numObserved;
+      } else {
+        obs.buffer = nullptr;
+      }
+      continue;
+    }
+    // normal and optical flow sensors draw normals and motion vectors
+    // instead of the frame the others read
+    if (shareRender && sensor.isVisualSensor() &&
+        type != sensor::SensorType::NORMAL &&
+        type != sensor::SensorType::OPTICAL_FLOW &&
+        (semanticSharesScene || type != sensor::SensorType::SEMANTIC)) {
+      auto& visualSensor = static_cast<sensor::VisualSensor&>(sensor);
+      const bool readsDepth = type == sensor::SensorType::DEPTH;
+      // the targets of depth sensors hold no color and object ID
+      auto drawn = std::find_if(
+          drawnSensors_.begin(), drawnSensors_.end(),
+          [&](sensor::VisualSensor* other) {
+            return visualSensor.isColocatedWith(*other) &&
+                   (readsDepth || !other->renderTarget().isDepthOnly());
+          });
+      if (drawn != drawnSensors_.end() &&
+          visualSensor.readObservationFrom((*drawn)->renderTarget(), obs)) {
+        ++numObserved;
+        continue;
+      }
+      if (visualSensor.getObservation(*this, obs)) {
+        drawnSensors_.push_back(&visualSensor);
+        ++numObserved;
+      } else {
+        obs.buffer = nullptr;
+      }
+      continue;
+    }
+    if (sensor.getObservation(*this, obs)) {
+      ++numObserved;
+    } else {
+      obs.buffer = nullptr;
+    }
+  }
+
+  for (const std::pair<int, ViewCache::Key>& miss : viewCacheMisses_) {
+    if (observations[miss.first].buffer) {
+      viewCache_->write(miss.second, *observations[miss.first].buffer);
+    }
+  }
+  for (int i = 0; i < sensors.size(); ++i) {
+    if (useCache) {
+      auto cached = cachedObservations_.find(sensors[i].get());
+      if (cached != cachedObservations_.end()) {
+        cached->second.buffer = observations[i].buffer;
+      }
+    }
+    const int updatePeriod = sensors[i]->specification()->updatePeriod;
+    if (updatePeriod > 1) {
+      scheduledSensors_[sensors[i].get()].buffer = observations[i].buffer;
+    }
+  }
+  if (precull) {
+    clearPreculledSensorFrustums();
+  }
+  return numObserved;
+}
+
+void Simulator::addSensorFrustum(sensor::Sensor& sensor) {
+  if (!sensor.isVisualSensor()) {
+    return;
+  }
+  // the frustum the render camera culls against once the sensor draws
+  scene::SceneGraph& sceneGraph = getActiveSceneGraph();
+  sceneGraph.setDefaultRenderCamera(static_cast<sensor::VisualSensor&>(sensor));
+  gfx::RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+  sensorFrustums_.push_back(Magnum::Frustum::fromMatrix(
+      camera.projectionMatrix() * camera.cameraMatrix()));
+}
+
+void Simulator::precullSensorFrustums() {
+  // a single frustum is culled faster by the BVHs of the group
+  if (!frustumCulling_ || renderList_ || sensorFrustums_.size() < 2) {
+    sensorFrustums_.clear();
+    return;
+  }
+  core::ScopedTimer timer{core::ProfilingStage::Culling};
+  getActiveSceneGraph().getDrawables().precull(sensorFrustums_);
+  if (activeSemanticSceneID_ != activeSceneID_) {
+    getActiveSemanticSceneGraph().getDrawables().precull(sensorFrustums_);
+  }
+  preculledSensorFrustums_ = true;
+}
+
+void Simulator::clearPreculledSensorFrustums() {
+  if (preculledSensorFrustums_) {
+    getActiveSceneGraph().getDrawables().clearPrecull();
+    if (activeSemanticSceneID_ != activeSceneID_) {
+      getActiveSemanticSceneGraph().getDrawables().clearPrecull();
+    }
+  }
+  sensorFrustums_.clear();
+  preculledSensorFrustums_ = false;
+}
+
+bool Simulator::drawStereoPair(
+    const std::vector<sensor::Sensor::ptr>& sensors,
+    const int first) {
+  auto& firstSensor = static_cast<sensor::VisualSensor&>(*sensors[first]);
+  for (int i = first + 1; i < sensors.size(); ++i) {
+    sensor::Sensor& sensor = *sensors[i];
+    // the second one is observed right after, not from the cache
+    if (!sensor.isVisualSensor() || sensor.specification()->updatePeriod != 1 ||
+        std::find(stereoDrawnSensors_.begin(), stereoDrawnSensors_.end(),
+                  &sensor) != stereoDrawnSensors_.end()) {
+      continue;
+    }
+    auto& visualSensor = static_cast<sensor::VisualSensor&>(sensor);
+    if (firstSensor.isStereoPairWith(visualSensor) &&
+        firstSensor.drawStereoObservation(*this, visualSensor)) {
+      stereoDrawnSensors_.push_back(&sensor);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Simulator::restartViewCache() {
+  if (viewCache_) {
+    viewCacheSceneHash_ = ViewCache::sceneHash(config_);
+    viewCacheEpoch_ = observationEpoch();
+  }
+}
+
+uint64_t Simulator::observationEpoch() {
+  uint64_t epoch = sceneEpoch_ + getActiveSceneGraph().getDrawablesEpoch();
+  if (activeSemanticSceneID_ != activeSceneID_) {
+    epoch += getActiveSemanticSceneGraph().getDrawablesEpoch();
+  }
+  return epoch;
+}
+
+bool Simulator::getAgentObservations(const int agentId,
+                                     core::SharedMemoryRing& ring,
+                                     const int slot) {
+  waitForPhysicsStep();
+  agent::Agent::ptr ag = getAgent(agentId);
+  std::map<std::string, sensor::Sensor::ptr>& sensors =
+      ag->getSensorSuite().getSensors();
+
+  // bind the fields of the slot as the observation buffers of their sensors,
+  // keeping the buffers they had
+  std::map<std::string, core::Buffer::ptr> fields;
+  std::map<std::string, core::Buffer::ptr> sensorBuffers;
+  bool success = true;
+  for (const core::SharedMemoryRing::Field& field : ring.fields()) {
+    auto it = sensors.find(field.name);
+    core::Buffer::ptr buffer = ring.field(slot, field.name);
+    sensor::ObservationSpace space;
+    if (it == sensors.end() || !buffer ||
+        !it->second->getObservationSpace(space) ||
+        space.shape != field.shape || space.dataType != field.dataType) {
+      LOG(ERROR) << "Simulator::getAgentObservations: field " << field.name
+                 << " doesn't match a sensor of agent " << agentId;
+      success = false;
+      continue;
+    }
+    sensorBuffers[field.name] = it->second->releaseObservationBuffer();
+    it->second->bindObservationBuffer(buffer);
+    fields[field.name] = std::move(buffer);
+  }
+
+  std::map<std::string, sensor::Observation> observations;
+  getAgentObservations(agentId, observations);
+
+  for (const auto& it : fields) {
+    auto observation = observations.find(it.first);
+    sensor::Sensor& sensor = *sensors.at(it.first);
+    if (observation == observations.end() ||
+        observation->second.buffer == nullptr) {
+      success &= sensor.specification()->updatePeriod == 0;
+    } else if (observation->second.buffer != it.second) {
+      // the sensor read into a buffer of its own
+      std::memcpy(it.second->data.data(),
+                  observation->second.buffer->data.data(),
+                  it.second->data.size());
+    }
+    // an asynchronous readback writes into the buffer the sensor has then,
+    // so it always needs one
+    core::Buffer::ptr& previous = sensorBuffers.at(it.first);
+    sensor.releaseObservationBuffer();
+    if (previous) {
+      sensor.bindObservationBuffer(std::move(previous));
+    } else if (asyncObservationReadback_) {
+      sensor::ObservationSpace space;
+      sensor.getObservationSpace(space);
+      sensor.bindObservationBuffer(
+          core::Buffer::create(space.shape, space.dataType));
+    }
+  }
+
+  if (success) {
+    ring.publish(slot);
+  }
+  return success;
+}
+
+std::vector<core::SharedMemoryRing::Field>
+Simulator::getAgentObservationFields(const int agentId) {
+  std::vector<core::SharedMemoryRing::Field> fields;
+  for (const auto& it : getAgent(agentId)->getSensorSuite().getSensors()) {
+    sensor::ObservationSpace space;
+    if (it.second->getObservationSpace(space)) {
+      fields.push_back({it.first, space.shape, space.dataType});
+    }
+  }
+  return fields;
+}
+
+std::vector<core::SharedMemoryRing::Field> Simulator::getAgentDatasetFields(
+    const int agentId) {
+  std::vector<core::SharedMemoryRing::Field> fields =
+      getAgentObservationFields(agentId);
+  fields.push_back({"action", {1}, core::DataType::DT_INT32});
+  fields.push_back({"agent_position", {3}, core::DataType::DT_FLOAT});
+  fields.push_back({"agent_rotation", {4}, core::DataType::DT_FLOAT});
+  return fields;
+}
+
+bool Simulator::getAgentObservations(const int agentId,
+                                     ObservationDatasetWriter& writer,
+                                     const int action) {
+  getAgentObservations(agentId, sensorObservations_);
+  agent::Agent::ptr ag = getAgent(agentId);
+  agent::AgentState::ptr state = agent::AgentState::create();
+  ag->getState(state);
+  const int32_t actionValue = action;
+
+  std::vector<Cr::Containers::ArrayView<const char>> data;
+  for (const core::SharedMemoryRing::Field& field : writer.fields()) {
+    const size_t numData = data.size();
+    const int index = ag->getSensorSuite().getSensorIndex(field.name);
+    if (index >= 0) {
+      const core::Buffer::ptr& buffer = sensorObservations_[index].buffer;
+      if (buffer) {
+        data.emplace_back(reinterpret_cast<const char*>(buffer->data.data()),
+                          buffer->data.size());
+      }
+    } else if (field.name == "action") {
+      data.emplace_back(reinterpret_cast<const char*>(&actionValue),
+                        sizeof(actionValue));
+    } else if (field.name == "agent_position") {
+      data.emplace_back(reinterpret_cast<const char*>(state->position.data()),
+                        3 * sizeof(float));
+    } else if (field.name == "agent_rotation") {
+      data.emplace_back(reinterpret_cast<const char*>(state->rotation.data()),
+                        4 * sizeof(float));
+    }
+    if (data.size() == numData) {
+      LOG(ERROR) << "Simulator::getAgentObservations: field " << field.name
+                 << " has no observation of agent " << agentId;
+      return false;
+    }
+  }
+  if (!writer.write(data)) {
+    LOG(ERROR) << "Simulator::getAgentObservations: the writer is closed or "
+                  "its fields don't match the observations of agent "
+               << agentId;
+    return false;
+  }
+  return true;
+}
+
+bool Simulator::step(
+    const std::map<int, std::string>& actions,
+    std::map<int, std::map<std::string, sensor::Observation>>& observations,
+    const double dt) {
+  waitForPhysicsStep();
+  const bool success = actByNames(actions);
+  stepWorldAndObserve(observations, dt);
+  return success;
+}
+
+bool Simulator::actByNames(const std::map<int, std::string>& actions) {
+  bool success = true;
+  for (const auto& action : actions) {
+    if (SessionEvent* event = recordEvent(SessionEventType::ActByName)) {
+      event->id = action.first;
+      event->name = action.second;
+    }
+    if (!getAgent(action.first)->act(action.second)) {
+      LOG(ERROR) << "Simulator::step: agent " << action.first
+                 << " has no action " << action.second;
+      success = false;
+    }
+  }
+  return success;
+}
+
+bool Simulator::stepAsync(const std::map<int, std::string>& actions,
+                          StepCallback callback,
+                          const double dt) {
+  // the previous step completes before the agents move on
+  pollAsyncObservations(true);
+  waitForPhysicsStep();
+  const bool success = actByNames(actions);
+  stepWorld(dt);
+
+  std::vector<sensor::Sensor*> sensors;
+  std::vector<std::pair<int, std::string>> keys;
+  for (int agentId = 0; agentId < agents_.size(); ++agentId) {
+    for (const auto& it : agents_[agentId]->getSensorSuite().getSensors()) {
+      sensors.push_back(it.second.get());
+      keys.emplace_back(agentId, it.first);
+    }
+  }
+  auto byAgent = [keys = std::move(keys), callback = std::move(callback)](
+                     std::vector<sensor::Observation>& observations) {
+    std::map<int, std::map<std::string, sensor::Observation>> byAgentId;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      byAgentId[keys[i].first][keys[i].second] = std::move(observations[i]);
+    }
+    callback(byAgentId);
+  };
+  observeAsync(sensors, std::move(byAgent));
+  return success;
+}
+
+void Simulator::observeAsync(const std::vector<sensor::Sensor*>& sensors,
+                             ObservationCallback callback) {
+  pollAsyncObservations(true);
+  waitForPhysicsStep();
+  // the queued reads are retrieved oldest first, so none of step() may be
+  // ahead of them
+  discardAsyncObservationReadbacks();
+
+  AsyncObservations pending;
+  pending.sensors = sensors;
+  pending.observations.resize(sensors.size());
+  pending.callback = std::move(callback);
+  if (multiFrustumCulling_) {
+    for (sensor::Sensor* sensor : sensors) {
+      addSensorFrustum(*sensor);
+    }
+    precullSensorFrustums();
+  }
+  for (size_t i = 0; i < sensors.size(); ++i) {
+    sensor::Sensor& sensor = *sensors[i];
+    sensor::Observation& obs = pending.observations[i];
+    if (!sensor.isVisualSensor()) {
+      sensor.getObservation(*this, obs);
+      continue;
+    }
+    auto& visualSensor = static_cast<sensor::VisualSensor&>(sensor);
+    if (!visualSensor.drawObservation(*this)) {
+      continue;
+    }
+    if (visualSensor.queueObservationRead()) {
+      pending.queued.push_back(i);
+    } else {
+      visualSensor.readObservationFrom(visualSensor.renderTarget(), obs);
+    }
+  }
+  clearPreculledSensorFrustums();
+  // start the GPU on the frames just queued, instead of leaving them in the
+  // driver until more commands are issued
+  Magnum::GL::Renderer::flush();
+  asyncObservations_ = std::move(pending);
+}
+
+bool Simulator::pollAsyncObservations(const bool wait) {
+  if (!asyncObservations_) {
+    return true;
+  }
+  AsyncObservations& pending = *asyncObservations_;
+  if (!wait) {
+    for (size_t i : pending.queued) {
+      if (!static_cast<sensor::VisualSensor*>(pending.sensors[i])
+               ->isObservationReadReady()) {
+        return false;
+      }
+    }
+  }
+  for (size_t i : pending.queued) {
+    static_cast<sensor::VisualSensor*>(pending.sensors[i])
+        ->retrieveObservationRead(pending.observations[i]);
+  }
+  // the callback may observe again
+  AsyncObservations completed = std::move(pending);
+  asyncObservations_ = Corrade::Containers::NullOpt;
+  completed.callback(completed.observations);
+  return true;
+}
+
+bool Simulator::stepByActionIndices(
+    const std::vector<int>& actionIndices,
+    std::map<int, std::map<std::string, sensor::Observation>>& observations,
+    const double dt) {
+  const bool success = actAll(actionIndices);
+  stepWorldAndObserve(observations, dt);
+  return success;
+}
+
+bool Simulator::actAll(const std::vector<int>& actionIndices,
+                       const int numThreads) {
+  core::ScopedTraceEvent trace{"Simulator::actAll", "sim"};
+  waitForPhysicsStep();
+  if (SessionEvent* event = recordEvent(SessionEventType::ActByIndices)) {
+    event->indices = actionIndices;
+  }
+  using Magnum::EigenIntegration::cast;
+  bool success = true;
+  movedAgents_.clear();
+  moveStarts_.clear();
+  moveEnds_.clear();
+  const int numActing = std::min<size_t>(actionIndices.size(), agents_.size());
+  for (int agentId = 0; agentId < numActing; ++agentId) {
+    const int actionIndex = actionIndices[agentId];
+    if (actionIndex < 0) {
+      continue;
+    }
+    agent::Agent& agent = *agents_[agentId];
+    const bool isBodyAction = agent.isBodyAction(actionIndex);
+    const vec3f start =
+        cast<vec3f>(agent.node().absoluteTransformation().translation());
+    if (!agent.act(actionIndex, /*applyFilter=*/false)) {
+      LOG(ERROR) << "Simulator::actAll: agent " << agentId
+                 << " has no action of index " << actionIndex;
+      success = false;
+      continue;
+    }
+    if (isBodyAction) {
+      movedAgents_.push_back(agentId);
+      moveStarts_.push_back(start);
+      moveEnds_.push_back(
+          cast<vec3f>(agent.node().absoluteTransformation().translation()));
+    }
+  }
+
+  filteredMoveEnds_.resize(moveEnds_.size());
+  if (pathfinder_->isLoaded()) {
+    // the filter addAgent() sets, the navmesh queries run concurrently
+    pathfinder_->parallelFor(moveEnds_.size(), numThreads,
+                             [this](size_t i, int /*threadIndex*/) {
+                               filteredMoveEnds_[i] = pathfinder_->tryStep(
+                                   moveStarts_[i], moveEnds_[i]);
+                             });
+  } else {
+    for (int i = 0; i < moveEnds_.size(); ++i) {
+      filteredMoveEnds_[i] =
+          agents_[movedAgents_[i]]->getControls()->getMoveFilterFunction()(
+              moveStarts_[i], moveEnds_[i]);
+    }
+  }
+  for (int i = 0; i < moveEnds_.size(); ++i) {
+    agents_[movedAgents_[i]]->node().translate(
+        Magnum::Vector3(vec3f(filteredMoveEnds_[i] - moveEnds_[i])));
+  }
+  return success;
+}
+
+void Simulator::stepWorldAndObserve(
+    std::map<int, std::map<std::string, sensor::Observation>>& observations,
+    const double dt) {
+  const bool asyncPhysics = asyncPhysics_ && physicsManager_ != nullptr;
+  if (asyncPhysics) {
+    // only the agents move before the frames, the physics of the step runs
+    // once they are queued
+    beginWorldStep(dt);
+  } else {
+    stepWorld(dt);
+  }
+
+  // kept from the previous step, so that the observations are updated in
+  // place
+  observations.erase(observations.lower_bound(agents_.size()),
+                     observations.end());
+  if (multiFrustumCulling_) {
+    // one sweep for the sensors of all agents
+    for (const agent::Agent::ptr& agent : agents_) {
+      for (const sensor::Sensor::ptr& sensor :
+           agent->getSensorSuite().getSensorList()) {
+        addSensorFrustum(*sensor);
+      }
+    }
+    precullSensorFrustums();
+  }
+  for (int agentId = 0; agentId < agents_.size(); ++agentId) {
+    getAgentObservations(agentId, observations[agentId]);
+  }
+  clearPreculledSensorFrustums();
+  if (asyncObservationReadback_) {
+    // start the GPU on the frames just queued, instead of leaving them in the
+    // driver until the next step issues more commands
+    Magnum::GL::Renderer::flush();
+  }
+  if (asyncPhysics) {
+    launchPhysicsStep(dt);
+  }
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+int Simulator::getAgentObservationsGPU(
+    const int agentId,
+    const sensor::SensorType sensorType,
+    void* devPtr,
+    void* cudaStream,
+    sensor::RedwoodNoiseModelGPUImpl* depthNoiseModel,
+    sensor::RgbNoiseModelGPUImpl* colorNoiseModel) {
+  core::ScopedTimer timer{core::ProfilingStage::AgentObservations};
+  waitForPhysicsStep();
+  gfx::RenderTarget::FrameType frameType;
+  switch (sensorType) {
+    case sensor::SensorType::COLOR:
+      frameType = gfx::RenderTarget::FrameType::Rgba;
+      break;
+    case sensor::SensorType::DEPTH:
+      frameType = gfx::RenderTarget::FrameType::Depth;
+      break;
+    case sensor::SensorType::SEMANTIC:
+      frameType = gfx::RenderTarget::FrameType::ObjectId;
+      break;
+    default:
+      throw std::runtime_error(
+          "Simulator::getAgentObservationsGPU: unsupported sensor type");
+  }
+
+  std::vector<gfx::RenderTarget*> targets;
   agent::Agent::ptr ag = getAgent(agentId);
   if (ag != nullptr) {
-    const std::map<std::string, sensor::Sensor::ptr>& sensors =
-        ag->getSensorSuite().getSensors();
-    for (std::pair<std::string, sensor::Sensor::ptr> s : sensors) {
-      sensor::Observation obs;
-      if (s.second->getObservation(*this, obs)) {
-        observations[s.first] = obs;
+    for (auto& it : ag->getSensorSuite().getSensors()) {
+      if (!it.second->isVisualSensor() ||
+          it.second->specification()->sensorType != sensorType)
+        continue;
+      auto sensor = static_cast<sensor::VisualSensor*>(it.second.get());
+      if (sensor->drawObservation(*this)) {
+        targets.push_back(&sensor->renderTarget());
+      }
+    }
+  }
+  gfx::RenderTarget::readFramesGPU(targets, frameType, devPtr, cudaStream);
+
+  if (depthNoiseModel != nullptr && sensorType == sensor::SensorType::DEPTH &&
+      !targets.empty()) {
+    const Magnum::Vector2i size = targets[0]->framebufferSize();
+    // frames come straight from OpenGL, i.e. bottom row first
+    depthNoiseModel->simulateInPlaceFromGPU(static_cast<float*>(devPtr),
+                                            size.y(), size.x(), targets.size(),
+                                            true, cudaStream);
+  }
+  if (colorNoiseModel != nullptr && sensorType == sensor::SensorType::COLOR &&
+      !targets.empty()) {
+    const Magnum::Vector2i size = targets[0]->framebufferSize();
+    colorNoiseModel->simulateInPlaceFromGPU(static_cast<uint8_t*>(devPtr),
+                                            size.y(), size.x(), 4,
+                                            targets.size(), cudaStream);
+  }
+  return targets.size();
+}
+#endif
+
+void Simulator::setAsyncObservationReadbackEnabled(bool val) {
+  if (!val) {
+    discardAsyncObservationReadbacks();
+  }
+  asyncObservationReadback_ = val;
+}
+
+void Simulator::discardAsyncObservationReadbacks() {
+  if (asyncObservations_) {
+#ifndef MAGNUM_TARGET_WEBGL
+    for (size_t i : asyncObservations_->queued) {
+      static_cast<sensor::VisualSensor*>(asyncObservations_->sensors[i])
+          ->renderTarget()
+          .discardAsyncReads();
+    }
+#endif
+    asyncObservations_ = Corrade::Containers::NullOpt;
+  }
+#ifndef MAGNUM_TARGET_WEBGL
+  for (auto& agent : agents_) {
+    for (auto& it : agent->getSensorSuite().getSensors()) {
+      if (it.second->isVisualSensor()) {
+        auto sensor = static_cast<sensor::VisualSensor*>(it.second.get());
+        if (sensor->hasRenderTarget()) {
+          sensor->renderTarget().discardAsyncReads();
+        }
       }
     }
   }
-  return observations.size();
+#endif
 }
 
 bool Simulator::getAgentObservationSpace(const int agentId,
@@ -874,6 +2501,7 @@ int Simulator::getAgentObservationSpaces(
 
 void Simulator::setLightSetup(gfx::LightSetup setup, const std::string& key) {
   resourceManager_->setLightSetup(std::move(setup), key);
+  markSceneChanged();
 }
 
 gfx::LightSetup Simulator::getLightSetup(const std::string& key) {
@@ -886,6 +2514,7 @@ void Simulator::setObjectLightSetup(const int objectID,
   if (sceneHasPhysics(sceneID)) {
     gfx::setLightSetupForSubTree(physicsManager_->getObjectSceneNode(objectID),
                                  lightSetupKey);
+    markSceneChanged();
   }
 }
 
@@ -5,11 +5,22 @@
 #ifndef ESP_SIM_SIMULATOR_H_
 #define ESP_SIM_SIMULATOR_H_
 
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
 #include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Frustum.h>
 #include "esp/agent/Agent.h"
 #include "esp/assets/ResourceManager.h"
+#include "esp/assets/StageStreamer.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/SharedMemoryRing.h"
 #include "esp/core/esp.h"
 #include "esp/core/random.h"
+#include "esp/gfx/FrameEncoder.h"
+#include "esp/gfx/GpuDevices.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/WindowlessContext.h"
 #include "esp/nav/PathFinder.h"
@@ -19,7 +30,10 @@
 #include "esp/scene/SceneManager.h"
 #include "esp/scene/SceneNode.h"
 
+#include "ObservationDataset.h"
+#include "SessionRecording.h"
 #include "SimulatorConfiguration.h"
+#include "ViewCache.h"
 
 namespace esp {
 namespace nav {
@@ -33,6 +47,10 @@ class SemanticScene;
 namespace gfx {
 class Renderer;
 }  // namespace gfx
+namespace sensor {
+struct RedwoodNoiseModelGPUImpl;
+struct RgbNoiseModelGPUImpl;
+}  // namespace sensor
 }  // namespace esp
 
 namespace esp {
@@ -43,8 +61,43 @@ namespace Attrs = esp::metadata::attributes;
 class Simulator {
  public:
   explicit Simulator(const SimulatorConfiguration& cfg);
+
+  /**
+   * @brief Construct a simulator drawing with the OpenGL context current on
+   * the calling thread, with the assets, shaders and renderer it shares with
+   * other simulators, see @ref VectorSimulator.
+   *
+   * The simulator doesn't own a context, so @ref gpuDevice() isn't available.
+   * @param cfg The configuration
+   * @param resourceManager The resource manager to load the assets with
+   * @param renderer The renderer to bind the render targets of the sensors to
+   */
+  Simulator(const SimulatorConfiguration& cfg,
+            std::shared_ptr<assets::ResourceManager> resourceManager,
+            std::shared_ptr<gfx::Renderer> renderer);
+
   virtual ~Simulator();
 
+  /**
+   * @brief Create a simulator in the current state of this one, e.g. to plan
+   * rollouts from it, without loading anything again.
+   *
+   * The clone uses the resource manager and the renderer of this simulator,
+   * sharing its meshes, textures, collision meshes and attribute templates,
+   * and shares its navmesh, semantic scene and Bullet collision shapes. Only
+   * the mutable state is duplicated: a new scene graph, the objects, added
+   * again under the same IDs from the same templates and restored to their
+   * rigid states and velocities, and the agents, added with the same
+   * configurations and states.
+   *
+   * Objects attached to existing scene nodes, the render settings and the
+   * session recording are not copied. Changes to the navmesh, e.g. by @ref
+   * recomputeNavMesh(), affect both simulators, and the convex hull cache of
+   * the objects is not synchronized between threads. The clone must not
+   * outlive the OpenGL context this simulator draws with.
+   */
+  std::shared_ptr<Simulator> clone();
+
   /**
    * @brief Closes the simulator and frees all loaded assets and GPU contexts.
    *
@@ -58,8 +111,56 @@ class Simulator {
 
   virtual void reconfigure(const SimulatorConfiguration& cfg);
 
+  /**
+   * @brief Start decoding the assets of a scene on worker threads, so that a
+   * later @ref reconfigure to it only has to upload them to the GPU.
+   *
+   * Uses the scene configuration values of the current configuration. Does
+   * nothing before the first @ref reconfigure created the renderer. See @ref
+   * esp::assets::ResourceManager::prefetchStage.
+   * @param sceneFilename The scene file, or scene instance config file.
+   */
+  void prefetchScene(const std::string& sceneFilename);
+
+  /**
+   * @brief The scene ids of the resident scenes, the active one first, then
+   * the most recently active. See @ref SimulatorConfiguration::residentScenes.
+   *
+   * A @ref reconfigure to the configuration a resident scene was loaded with
+   * switches the active scene graph, semantic scene graph, navmesh and
+   * physics world back to it and moves the agents there, without loading
+   * anything. Its objects keep their states until the @ref reset() ending the
+   * reconfigure. The least recently active scene is released once more are
+   * resident than configured.
+   */
+  std::vector<std::string> getResidentScenes() const;
+
+  /**
+   * @brief Whether the last @ref reconfigure switched to a resident scene
+   * instead of loading it, see @ref getResidentScenes()
+   */
+  bool isActiveSceneReused() const { return activeSceneReused_; }
+
   virtual void reset();
 
+  /**
+   * @brief Start a new episode in the current scene by only moving the agents
+   * and objects.
+   *
+   * Unlike @ref reconfigure and @ref reset, keeps the scene graph, the
+   * agents, their sensors and render targets and the light setup as they
+   * are, apart from dropping pending asynchronous readbacks of the previous
+   * episode.
+   * @param agentStates The state of each agent by agent ID, the agents past
+   * its end keep theirs. The sensors are reset to their specifications.
+   * @param objectStates The objects and world time to restore, e.g. saved by
+   * @ref savePhysicsSnapshot() at the start of a previous episode. Ignored
+   * without physics.
+   * @return false if there is no agent or object of one of the states
+   */
+  bool resetEpisode(const std::vector<agent::AgentState>& agentStates,
+                    const esp::physics::PhysicsSnapshot& objectStates = {});
+
  public:
   virtual void seed(uint32_t newSeed);
 
@@ -71,12 +172,41 @@ class Simulator {
   scene::SceneGraph& getActiveSceneGraph();
   scene::SceneGraph& getActiveSemanticSceneGraph();
 
+  /**
+   * @brief Write the frame last drawn by the first color sensor of the
+   * default agent to @p filename, see @ref saveFrame(int, const
+   * std::string&, const std::string&)
+   */
   void saveFrame(const std::string& filename);
 
+  /**
+   * @brief Write the RGBA frame last drawn by a visual sensor to
+   * @p filename, encoded on the thread of @ref getFrameEncoder()
+   *
+   * Only the read of the frame waits for the GPU, so saving the frames of a
+   * whole episode barely slows down the steps. The format is that of the
+   * file extension, e.g. PNG or JPEG.
+   * @return false if the agent has no such visual sensor
+   */
+  bool saveFrame(int agentId,
+                 const std::string& sensorId,
+                 const std::string& filename);
+
+  /**
+   * @brief The encoder writing the frames of @ref saveFrame(), created on
+   * first use
+   *
+   * Recordings can queue the color observations of the sensors to it, to
+   * encode them off the thread stepping the simulator. Its frames are all
+   * written in @ref close().
+   */
+  gfx::FrameEncoder& getFrameEncoder();
+
   /**
    * @brief The ID of the CUDA device of the OpenGL context owned by the
    * simulator.  This will only be nonzero if the simulator is built in
-   * --headless mode on linux
+   * --headless mode on linux, and is -1 with @ref
+   * SimulatorConfiguration::softwareRendering
    */
   int gpuDevice() const {
     CORRADE_ASSERT(context_ != nullptr,
@@ -116,6 +246,14 @@ class Simulator {
       const {
     return resourceManager_->getStageAttributesManager();
   }
+  /**
+   * @brief Return manager for construction and access to scene instance
+   * attributes.
+   */
+  const AttrMgrs::SceneAttributesManager::ptr getSceneAttributesManager()
+      const {
+    return resourceManager_->getSceneAttributesManager();
+  }
 
   /** @brief Return the library implementation type for the simulator currently
    * in use. Use to check for a particular implementation.
@@ -180,6 +318,24 @@ class Simulator {
                             assets::ResourceManager::DEFAULT_LIGHTING_KEY,
                         int sceneID = 0);
 
+  /**
+   * @brief Instance all the objects of a scene instance file in a single
+   * batch, see @ref esp::metadata::attributes::SceneAttributes and @ref
+   * esp::physics::PhysicsManager::addObjects().
+   *
+   * The template name of each object is either the handle of its template or
+   * a substring of it, resolved once per distinct name. The objects are
+   * placed at their translation and rotation, then given their motion type.
+   * @param sceneInstanceFile The scene instance file to load, through @ref
+   * esp::metadata::managers::SceneAttributesManager.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * add the objects to.
+   * @return The IDs assigned to the objects, in the order of the file, with
+   * @ref esp::ID_UNDEFINED for the objects which failed.
+   */
+  std::vector<int> loadSceneInstance(const std::string& sceneInstanceFile,
+                                     int sceneID = 0);
+
   /**
    * @brief Get a static view of a physics object's template when the object was
    * instanced.
@@ -212,6 +368,27 @@ class Simulator {
                     bool deleteVisualNode = true,
                     int sceneID = 0);
 
+  /**
+   * @brief Enable or disable the pooling of removed objects, recycled by
+   * later additions of the same template. See @ref
+   * esp::physics::PhysicsManager::setObjectPooling().
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * pool the objects of.
+   */
+  void setObjectPooling(bool enabled, int sceneID = 0);
+
+  /**
+   * @brief Whether removed objects are pooled. See @ref
+   * esp::physics::PhysicsManager::setObjectPooling().
+   */
+  bool getObjectPooling(int sceneID = 0) const;
+
+  /**
+   * @brief Get the number of removed objects kept for recycling. See @ref
+   * esp::physics::PhysicsManager::getNumPooledObjects().
+   */
+  int getNumPooledObjects(int sceneID = 0) const;
+
   /**
    * @brief Get the IDs of the physics objects instanced in a physical scene.
    * See @ref esp::physics::PhysicsManager::getExistingObjectIDs.
@@ -248,6 +425,31 @@ class Simulator {
                            int objectID,
                            int sceneID = 0);
 
+  /**
+   * @brief Get the sorted IDs of the objects active at the end of the last
+   * physics step, cheap to poll until the objects settled. See @ref
+   * esp::physics::PhysicsManager::getActiveObjectIds.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * query.
+   */
+  std::vector<int> getActiveObjectIds(int sceneID = 0);
+
+  /**
+   * @brief Set the speeds below which an object may fall asleep. See @ref
+   * esp::physics::PhysicsManager::setSleepingThresholds.
+   * @param linThreshold The linear sleeping threshold, in meters per second.
+   * @param angThreshold The angular sleeping threshold, in radians per
+   * second.
+   * @param objectID The ID of the object identifying it in @ref
+   * esp::physics::PhysicsManager::existingObjects_.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * query.
+   */
+  void setObjectSleepingThresholds(double linThreshold,
+                                   double angThreshold,
+                                   int objectID,
+                                   int sceneID = 0);
+
   /**@brief Retrieves a shared pointer to the VelocityControl struct for this
    * object.
    */
@@ -355,6 +557,61 @@ class Simulator {
                      int objectID,
                      int sceneID = 0);
 
+  /**
+   * @brief Get the current @ref esp::core::RigidState of many objects in one
+   * call, into contiguous arrays.
+   * See @ref esp::physics::PhysicsManager::getRigidStates.
+   * @param objectIDs The object IDs and keys identifying the objects in @ref
+   * esp::physics::PhysicsManager::existingObjects_.
+   * @param[out] translations The 3D positions, one per object.
+   * @param[out] rotations The orientations, one per object.
+   * @param sceneID !! Not used currently !! Specifies which physical scene of
+   * the objects.
+   */
+  void getRigidStates(
+      const std::vector<int>& objectIDs,
+      Corrade::Containers::ArrayView<Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<Magnum::Quaternion> rotations,
+      int sceneID = 0) const;
+
+  /**
+   * @brief Set the @ref esp::core::RigidState of many objects kinematically
+   * in one call.
+   * See @ref esp::physics::PhysicsManager::setRigidStates.
+   * @param objectIDs The object IDs and keys identifying the objects in @ref
+   * esp::physics::PhysicsManager::existingObjects_.
+   * @param translations The desired 3D positions, one per object.
+   * @param rotations The desired orientations, one per object.
+   * @param sceneID !! Not used currently !! Specifies which physical scene of
+   * the objects.
+   */
+  void setRigidStates(
+      const std::vector<int>& objectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations,
+      int sceneID = 0);
+
+  /**
+   * @brief Capture the state of all objects and the world time.
+   * See @ref esp::physics::PhysicsManager::saveSnapshot.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * capture.
+   * @return The snapshot, empty if the scene has no physics.
+   */
+  esp::physics::PhysicsSnapshot savePhysicsSnapshot(int sceneID = 0) const;
+
+  /**
+   * @brief Restore the state captured by @ref savePhysicsSnapshot() in place.
+   * See @ref esp::physics::PhysicsManager::restoreSnapshot.
+   * @param snapshot The snapshot to restore.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * restore.
+   * @return false if an object of the snapshot no longer exists or the scene
+   * has no physics.
+   */
+  bool restorePhysicsSnapshot(const esp::physics::PhysicsSnapshot& snapshot,
+                              int sceneID = 0);
+
   /**
    * @brief Set the 3D position of an object kinematically.
    * See @ref esp::physics::PhysicsManager::setTranslation.
@@ -451,6 +708,38 @@ class Simulator {
    */
   Magnum::Vector3 getAngularVelocity(int objectID, int sceneID = 0);
 
+  /**
+   * @brief Get the linear and angular velocities of many objects in one call,
+   * into contiguous arrays.
+   * See @ref esp::physics::PhysicsManager::getVelocities.
+   * @param objectIDs The object IDs and keys identifying the objects in @ref
+   * esp::physics::PhysicsManager::existingObjects_.
+   * @param[out] linVels The linear velocities, one per object.
+   * @param[out] angVels The angular velocities, one per object.
+   * @param sceneID !! Not used currently !! Specifies which physical scene of
+   * the objects.
+   */
+  void getVelocities(const std::vector<int>& objectIDs,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> linVels,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> angVels,
+                     int sceneID = 0) const;
+
+  /**
+   * @brief Set the linear and angular velocities of many objects in one call.
+   * See @ref esp::physics::PhysicsManager::setVelocities.
+   * @param objectIDs The object IDs and keys identifying the objects in @ref
+   * esp::physics::PhysicsManager::existingObjects_.
+   * @param linVels The desired linear velocities, one per object.
+   * @param angVels The desired angular velocities, one per object.
+   * @param sceneID !! Not used currently !! Specifies which physical scene of
+   * the objects.
+   */
+  void setVelocities(
+      const std::vector<int>& objectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> linVels,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> angVels,
+      int sceneID = 0);
+
   /**
    * @brief Turn on/off rendering for the bounding box of the object's visual
    * component.
@@ -494,8 +783,8 @@ class Simulator {
   /**
    * @brief Raycast into the collision world of a scene.
    *
-   * Note: A default @ref physics::PhysicsManager has no collision world, so
-   * physics must be enabled for this feature.
+   * Note: Without a physics simulator, the rays are cast against the stage
+   * and object meshes instead, see @ref physics::PhysicsManager::castRay.
    *
    * @param ray The ray to cast. Need not be unit length, but returned hit
    * distances will be in units of ray length.
@@ -509,6 +798,47 @@ class Simulator {
                                        float maxDistance = 100.0,
                                        int sceneID = 0);
 
+  /**
+   * @brief Cast a batch of rays into the collision world and return the first
+   * hit of each, see @ref physics::BatchRaycastResults.
+   *
+   * Note: Without a physics simulator, the rays are cast against the stage
+   * and object meshes instead, see @ref physics::PhysicsManager::castRays.
+   *
+   * @param rays The rays to cast. Need not be unit length, but returned hit
+   * distances will be in units of ray length.
+   * @param maxDistance The maximum distance along the ray direction to search.
+   * In units of ray length.
+   * @param numThreads The number of threads to cast on, 0 for all hardware
+   * threads.
+   * @param sceneID !! Not used currently !! Specifies which physical scene of
+   * the object.
+   * @return The first hits, indexed by ray.
+   */
+  esp::physics::BatchRaycastResults castRays(
+      const std::vector<esp::geo::Ray>& rays,
+      float maxDistance = 100.0,
+      int numThreads = 0,
+      int sceneID = 0);
+
+  /**
+   * @brief Find the stage and the objects overlapping an axis aligned box,
+   * e.g. the bounds of an agent. See @ref
+   * esp::physics::PhysicsManager::boxOverlapTest.
+   *
+   * Note: A default @ref physics::PhysicsManager has no collision world, so
+   * physics must be enabled for this feature.
+   *
+   * @param center The world space center of the box.
+   * @param halfExtents The half extents of the box.
+   * @param sceneID !! Not used currently !! Specifies which physical scene of
+   * the object.
+   * @return The sorted IDs of the overlapping objects, -1 for the stage.
+   */
+  std::vector<int> boxOverlapTest(const Magnum::Vector3& center,
+                                  const Magnum::Vector3& halfExtents,
+                                  int sceneID = 0);
+
   /**
    * @brief the physical world has a notion of time which passes during
    * animation/simulation/action/etc... Step the physical world forward in time
@@ -522,6 +852,20 @@ class Simulator {
    */
   double stepWorld(double dt = 1.0 / 60.0);
 
+  /**
+   * @brief Move the bodies of the natively added agents by their @ref
+   * agent::Agent::getVelocityControl() over @p dt, constrained to the navmesh.
+   *
+   * Integrates with @ref physics::VelocityControl::integrateTransform() in
+   * equal substeps of at most @ref
+   * agent::AgentConfiguration::velocityControlSubstep, each passed through
+   * @ref nav::PathFinder::tryStep(), or @ref
+   * nav::PathFinder::tryStepNoSliding() if the agent doesn't allow sliding.
+   * Agents controlling no velocity don't move. Done by @ref stepWorld() before stepping the physics.
+   * @param dt The time to integrate over
+   */
+  void stepAgentVelocityControl(double dt);
+
   /**
    * @brief Get the current time in the simulated world. This is always 0 if no
    * @ref esp::physics::PhysicsManager is initialized. See @ref stepWorld. See
@@ -554,6 +898,36 @@ class Simulator {
                         const nav::NavMeshSettings& navMeshSettings,
                         bool includeStaticObjects = false);
 
+  /**
+   * @brief Compute the navmeshes of several agents for the simulator's
+   * current active scene in one pass, see @ref nav::PathFinder::buildVariants.
+   * @param navMeshSettings The @ref nav::NavMeshSettings of each agent.
+   * @param includeStaticObjects Same as for @ref recomputeNavMesh.
+   * @return A pathfinder for each of @p navMeshSettings, in the same order.
+   * The ones whose navmesh could not be built are not loaded.
+   */
+  std::vector<nav::PathFinder::ptr> recomputeNavMeshVariants(
+      const std::vector<nav::NavMeshSettings>& navMeshSettings,
+      bool includeStaticObjects = false);
+
+  /**
+   * @brief Rebuild the part of a tiled navmesh affected by a region of the
+   * current scene, e.g. after objects in it moved. See @ref
+   * nav::PathFinder::updateRegion.
+   * @param pathfinder The pathfinder whose navmesh was built by @ref
+   * recomputeNavMesh with @ref nav::NavMeshSettings::tileSize greater than
+   * zero.
+   * @param regionMin Minimum of the changed region, covering both the old
+   * and the new bounds of moved objects.
+   * @param regionMax Maximum of the changed region.
+   * @param includeStaticObjects Same as for @ref recomputeNavMesh.
+   * @return Whether or not the update succeeded.
+   */
+  bool updateNavMeshRegion(nav::PathFinder& pathfinder,
+                           const vec3f& regionMin,
+                           const vec3f& regionMax,
+                           bool includeStaticObjects = false);
+
   /**
    * @brief Set visualization of the current NavMesh @ref pathfinder_ on or off.
    *
@@ -573,6 +947,16 @@ class Simulator {
                              scene::SceneNode& agentParentNode);
   agent::Agent::ptr addAgent(const agent::AgentConfiguration& agentConfig);
 
+  /**
+   * @brief Raise the texture size limit, if @ref
+   * SimulatorConfiguration::maxTextureSize is set, to twice the larger side
+   * of the resolution of a visual sensor attached to the simulator. Textures
+   * loaded at a lower limit are loaded again at the new one, see @ref
+   * assets::ResourceManager::setMaxTextureSize(). Called by @ref addAgent()
+   * for the sensors of the agent.
+   */
+  void fitTextureSizeToSensor(const sensor::VisualSensor& sensor);
+
   /**
    * @brief Displays observations on default frame buffer for a
    * particular sensor of an agent
@@ -613,6 +997,209 @@ class Simulator {
       int agentId,
       std::map<std::string, sensor::Observation>& observations);
 
+  /**
+   * @brief Observe with all sensors of an agent, without allocating.
+   *
+   * Observation @p i is of sensor @p i of @ref
+   * sensor::SensorSuite::getSensorList(), with a null buffer if the sensor
+   * didn't observe. Once @p observations has the size of the list and the
+   * sensors have their buffers, i.e. after the first call, neither this nor
+   * the sensors allocate.
+   *
+   * A sensor with a @ref sensor::SensorSpec::updatePeriod of @p n observes
+   * in the first and then every @p n th call for its agent and returns the
+   * buffer of its last observation in between, one with a period of 0 gets
+   * a null buffer, it observes only in @ref getAgentObservation(). The
+   * schedules start over in @ref reset() and @ref resetEpisode().
+   * @return The number of sensors that observed or returned their last
+   * observation
+   */
+  int getAgentObservations(int agentId,
+                           std::vector<sensor::Observation>& observations);
+
+  /**
+   * @brief Observe with the sensors of an agent, writing the observations
+   * straight into slot @p slot of a shared memory ring and publishing it.
+   *
+   * The sensors with a field of their uuid in @p ring read back into it
+   * without an intermediate copy, the observations of the others are
+   * dropped. See @ref getAgentObservationFields() for the fields to create
+   * the ring with. With asynchronous readback the slot gets the frame of the
+   * previous call, see @ref setAsyncObservationReadbackEnabled(). The fields
+   * of sensors observing only on demand are left as they are.
+   * @return false if a field doesn't match the observation space of its
+   * sensor, a sensor failed to observe or has no frame read back yet, the
+   * slot is not published then
+   */
+  bool getAgentObservations(int agentId,
+                            core::SharedMemoryRing& ring,
+                            int slot);
+
+  /**
+   * @brief The fields of a @ref core::SharedMemoryRing holding the
+   * observations of all sensors of an agent, named by sensor uuid
+   */
+  std::vector<core::SharedMemoryRing::Field> getAgentObservationFields(
+      int agentId);
+
+  /**
+   * @brief The fields of an @ref ObservationDatasetWriter recording an
+   * agent with @ref getAgentObservations(int, ObservationDatasetWriter&, int)
+   *
+   * Those of @ref getAgentObservationFields(), then `action`, one int32,
+   * `agent_position`, three floats, and `agent_rotation`, the four floats of
+   * the quaternion of @ref agent::AgentState.
+   */
+  std::vector<core::SharedMemoryRing::Field> getAgentDatasetFields(
+      int agentId);
+
+  /**
+   * @brief Observe with the sensors of an agent and queue the observations,
+   * its state and @p action as a record of @p writer
+   *
+   * The record is copied, so the sensors observe again while the writer
+   * encodes it, see @ref ObservationDatasetWriter.
+   * @param agentId The agent
+   * @param writer A writer with the fields of @ref getAgentDatasetFields()
+   * or a subset of them
+   * @param action The action the agent takes next, e.g. the index for @ref
+   * actAll(), stored as its `action` field
+   * @return false if a field doesn't match a sensor, a sensor didn't observe
+   * or @p writer is closed, nothing is queued then
+   */
+  bool getAgentObservations(int agentId,
+                            ObservationDatasetWriter& writer,
+                            int action = -1);
+
+  /**
+   * @brief Act with agents, step the physics and observe with all sensors of
+   * all agents in one call.
+   *
+   * Applies each action with @ref agent::Agent::act(), then @ref stepWorld()
+   * and @ref getAgentObservations() for every agent. With asynchronous
+   * observation readback, e.g. for @ref SimulatorConfiguration::pipelinedStep,
+   * the observations are those of the previous step and the GPU works on the
+   * ones of this step until the next.
+   * @param actions The action to take by agent ID, agents not in it don't act
+   * @param[out] observations The observations of each agent by agent ID
+   * @param dt The time to step the physics by
+   * @return false if an agent doesn't have its action, which it then skipped
+   */
+  bool step(
+      const std::map<int, std::string>& actions,
+      std::map<int, std::map<std::string, sensor::Observation>>& observations,
+      double dt = 1.0 / 60.0);
+
+  //! called with the observations of @ref observeAsync(), one per sensor
+  using ObservationCallback =
+      std::function<void(std::vector<sensor::Observation>& observations)>;
+
+  //! called with the observations of each agent of @ref stepAsync()
+  using StepCallback = std::function<void(
+      std::map<int, std::map<std::string, sensor::Observation>>&
+          observations)>;
+
+  /**
+   * @brief Observe with @p sensors without waiting for the GPU, calling
+   * @p callback with their observations from @ref pollAsyncObservations()
+   * once they are read back.
+   *
+   * Draws each visual sensor, queues the read of its frame, see @ref
+   * sensor::VisualSensor::queueObservationRead(), and flushes the GL command
+   * stream. The CPU is then free, e.g. for the steps of other simulators,
+   * whose GPU work overlaps this one. Sensors that can't read asynchronously
+   * and other sensors observe right away. Observations still in flight are
+   * completed first, waiting for them, and the reads the asynchronous
+   * observation readback has in flight are dropped. The sensors have to stay
+   * alive until @p callback is called.
+   */
+  void observeAsync(const std::vector<sensor::Sensor*>& sensors,
+                    ObservationCallback callback);
+
+  /**
+   * @brief Complete the observations of @ref observeAsync() by retrieving
+   * them and calling their callback, if the GPU finished them or @p wait
+   * @return false if the observations are still in flight
+   */
+  bool pollAsyncObservations(bool wait = false);
+
+  //! Whether observations of @ref observeAsync() are in flight
+  bool hasAsyncObservations() const { return bool(asyncObservations_); }
+
+  /**
+   * @brief Act with agents and step the physics like @ref step(), then
+   * @ref observeAsync() with all sensors of all agents
+   * @return false if an agent doesn't have its action, which it then skipped
+   */
+  bool stepAsync(const std::map<int, std::string>& actions,
+                 StepCallback callback,
+                 double dt = 1.0 / 60.0);
+
+  /**
+   * @brief Act with agents, step the physics and observe with all sensors of
+   * all agents in one call, with the actions given by index in the compiled
+   * action table of each agent, see @ref agent::Agent::act(int). Does no
+   * string handling for the actions.
+   * @param actionIndices The action index to take by agent ID, negative for
+   * no action. Agents past its end don't act.
+   * @param[out] observations The observations of each agent by agent ID
+   * @param dt The time to step the physics by
+   * @return false if an agent doesn't have its action, which it then skipped
+   */
+  bool stepByActionIndices(
+      const std::vector<int>& actionIndices,
+      std::map<int, std::map<std::string, sensor::Observation>>& observations,
+      double dt = 1.0 / 60.0);
+
+  /**
+   * @brief Act with all agents in one pass, with the actions given by index
+   * in the compiled action table of each agent, see @ref
+   * agent::Agent::act(int, bool).
+   *
+   * The moves of the body actions are applied unfiltered first, then all
+   * passed through the navmesh with @ref nav::PathFinder::tryStep() in
+   * parallel, like the move filter @ref addAgent() sets, and corrected
+   * together. Without a loaded navmesh, the move filter of each agent is used.
+   * @param actionIndices The action index to take by agent ID, negative for
+   * no action. Agents past its end don't act.
+   * @param numThreads The number of threads for the navmesh queries, see
+   * @ref nav::PathFinder::parallelFor()
+   * @return false if an agent doesn't have its action, which it then skipped
+   */
+  bool actAll(const std::vector<int>& actionIndices, int numThreads = 0);
+
+#ifdef ESP_BUILD_WITH_CUDA
+  /**
+   * @brief Draw all visual sensors of a given type of an agent and read their
+   * observations straight into one batched CUDA buffer.
+   *
+   * The sensors are taken in the order of their uuids and must all have the
+   * same resolution. Their render targets are mapped with a single CUDA
+   * graphics call and copied into @p devPtr, laid out as
+   * `[numSensors, H, W, C]`, on @p cudaStream.  See
+   * @ref gfx::RenderTarget::readFramesGPU()
+   * @param agentId    Id of the agent whose sensors are read
+   * @param sensorType One of @ref sensor::SensorType::COLOR,
+   *                   @ref sensor::SensorType::DEPTH or
+   *                   @ref sensor::SensorType::SEMANTIC
+   * @param devPtr     CUDA memory large enough for all observations
+   * @param cudaStream The `cudaStream_t` to queue the copies on, nullptr for
+   *                   the default stream
+   * @param depthNoiseModel If not nullptr and @p sensorType is
+   *                   @ref sensor::SensorType::DEPTH, applied in-place to the
+   *                   whole batch on @p cudaStream right after the readback
+   * @param colorNoiseModel The same for @ref sensor::SensorType::COLOR
+   * @return The number of observations written to @p devPtr
+   */
+  int getAgentObservationsGPU(
+      int agentId,
+      sensor::SensorType sensorType,
+      void* devPtr,
+      void* cudaStream,
+      sensor::RedwoodNoiseModelGPUImpl* depthNoiseModel = nullptr,
+      sensor::RgbNoiseModelGPUImpl* colorNoiseModel = nullptr);
+#endif
+
   bool getAgentObservationSpace(int agentId,
                                 const std::string& sensorId,
                                 sensor::ObservationSpace& space);
@@ -635,6 +1222,448 @@ class Simulator {
    */
   bool isFrustumCullingEnabled() { return frustumCulling_; }
 
+  /**
+   * @brief Enable or disable drawing sorted by GL state (disabled by default)
+   *
+   * When enabled, sensors draw the scene with @ref
+   * gfx::RenderCamera::Flag::SortByDrawState, i.e. grouped by shader,
+   * material, texture and mesh instead of in scene graph order.
+   * @param val true = enable, false = disable
+   */
+  void setSortByDrawStateEnabled(bool val) { sortByDrawState_ = val; }
+
+  /**
+   * @brief Get status, whether drawing sorted by GL state is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isSortByDrawStateEnabled() const { return sortByDrawState_; }
+
+  /**
+   * @brief Enable or disable occlusion culling (disabled by default)
+   *
+   * When enabled, sensors draw the scene with @ref
+   * gfx::RenderCamera::Flag::OcclusionCulling, skipping the static drawables
+   * hidden behind the others, which are guessed from the previous frame of
+   * the sensor, see @ref gfx::OcclusionCulling. The observations are the
+   * same either way. Has no effect on OpenGL ES and WebGL.
+   * @param val true = enable, false = disable
+   */
+  void setOcclusionCullingEnabled(bool val) { occlusionCulling_ = val; }
+
+  /**
+   * @brief Get status, whether occlusion culling is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isOcclusionCullingEnabled() const { return occlusionCulling_; }
+
+  /**
+   * @brief Enable or disable the potentially visible set (disabled by
+   * default)
+   *
+   * When enabled, sensors draw the scene with @ref
+   * gfx::RenderCamera::Flag::PotentiallyVisibleSet, skipping the stage
+   * meshes which were not seen from the navigable cell of the sensor, as
+   * precomputed by `datatool create_pvs` into a `.pvs` file next to the
+   * stage asset, see @ref gfx::PotentiallyVisibleSet. Has no effect for
+   * stages without one. The visibility is sampled, so a mesh seen only
+   * through a small gap may be missing from the observations.
+   * @param val true = enable, false = disable
+   */
+  void setPotentiallyVisibleSetEnabled(bool val) {
+    potentiallyVisibleSet_ = val;
+  }
+
+  /**
+   * @brief Get status, whether the potentially visible set is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isPotentiallyVisibleSetEnabled() const {
+    return potentiallyVisibleSet_;
+  }
+
+  /**
+   * @brief The streamer of the chunks of the active stage, nullptr unless
+   * the stage is chunked, see @ref assets::StageStreamer and @ref
+   * SimulatorConfiguration::stageChunkLoadRadius
+   */
+  std::shared_ptr<assets::StageStreamer> getStageStreamer() const {
+    return stageStreamer_;
+  }
+
+  /**
+   * @brief Load and evict the chunks and navmesh tiles of a chunked stage
+   * around the agents. Called by each step, and with @p wait by @ref
+   * reset(), so only needed after moving the agents otherwise.
+   * @param wait Whether to wait for the chunks within the load radius to be
+   * loaded instead of instantiating the decoded ones only
+   */
+  void updateStageStreaming(bool wait = false);
+
+  /**
+   * @brief Enable or disable multi-frustum culling (disabled by default)
+   *
+   * When enabled with frustum culling, @ref getAgentObservations(), @ref
+   * step() and @ref observeAsync() cull the drawables against the frustums
+   * of all visual sensors they observe with in one sweep, see @ref
+   * gfx::DrawableGroup::precull(), and each sensor then only collects the
+   * drawables of its frustum. This saves the culling of all but one sweep
+   * for agents with several sensors, and across the agents of a step. Has
+   * no effect for a single sensor or with render lists.
+   * @param val true = enable, false = disable
+   */
+  void setMultiFrustumCullingEnabled(bool val) { multiFrustumCulling_ = val; }
+
+  /**
+   * @brief Get status, whether multi-frustum culling is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isMultiFrustumCullingEnabled() const { return multiFrustumCulling_; }
+
+  /**
+   * @brief Enable or disable drawing objects instanced, see @ref
+   * SimulatorConfiguration::instancedObjectRendering. Only affects the
+   * objects added afterwards.
+   * @param val true = enable, false = disable
+   */
+  void setInstancedObjectRenderingEnabled(bool val) {
+    config_.instancedObjectRendering = val;
+    resourceManager_->setInstancedObjectRendering(val);
+  }
+
+  /**
+   * @brief Get status, whether objects added now are drawn instanced
+   * @return true if enabled, otherwise false
+   */
+  bool isInstancedObjectRenderingEnabled() const {
+    return config_.instancedObjectRendering;
+  }
+
+  /**
+   * @brief Enable or disable drawing from flattened render lists (disabled
+   * by default)
+   *
+   * When enabled, sensors draw the scene with @ref
+   * gfx::RenderCamera::Flag::RenderList, collecting the drawables and their
+   * transformations from contiguous arrays which are only updated for the
+   * nodes which moved, instead of walking the scene graph, see @ref
+   * gfx::RenderList. The observations are the same either way.
+   * @param val true = enable, false = disable
+   */
+  void setRenderListEnabled(bool val) { renderList_ = val; }
+
+  /**
+   * @brief Get status, whether drawing from render lists is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isRenderListEnabled() const { return renderList_; }
+
+  /**
+   * @brief Enable or disable GPU-driven depth drawing (disabled by default)
+   *
+   * When enabled, depth sensors and the linear depth passes draw the static
+   * stage meshes with @ref gfx::RenderCamera::Flag::GpuDriven, culled by a
+   * compute shader and submitted in a single multi-draw from one vertex and
+   * index buffer, see @ref gfx::IndirectDrawBatch, so that their CPU cost
+   * does not grow with the number of meshes. Objects and the color,
+   * semantic, normal and optical flow passes draw one by one as before.
+   * Ignored where the GPU has no OpenGL 4.3. The observations are the same
+   * either way.
+   * @param val true = enable, false = disable
+   */
+  void setGpuDrivenRenderEnabled(bool val) { gpuDrivenRender_ = val; }
+
+  /**
+   * @brief Get status, whether GPU-driven depth drawing is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isGpuDrivenRenderEnabled() const { return gpuDrivenRender_; }
+
+  /**
+   * @brief Enable or disable asynchronous observation readback (disabled by
+   * default)
+   *
+   * When enabled, @ref getAgentObservation and @ref getAgentObservations
+   * queue the readback of the frame they draw into a pixel buffer object and
+   * return the observation drawn by the previous call, so that the CPU does
+   * not stall until the GPU finishes the current frame. Observations thus lag
+   * one call behind: the first call after enabling, or after @ref reset,
+   * returns its own frame, which the second call then returns again.
+   * Disabling drops any pending readback.
+   * @param val true = enable, false = disable
+   */
+  void setAsyncObservationReadbackEnabled(bool val);
+
+  /**
+   * @brief Get status, whether asynchronous observation readback is enabled
+   * or not
+   * @return true if enabled, otherwise false
+   */
+  bool isAsyncObservationReadbackEnabled() const {
+    return asyncObservationReadback_;
+  }
+
+  /**
+   * @brief Enable or disable stepping the physics on a dedicated thread
+   * (disabled by default)
+   *
+   * When enabled, @ref step and @ref stepByActionIndices move the agents and
+   * queue the frames of their observations first, then step the physics of
+   * the step on the physics thread while the GPU draws them. The physics
+   * step thus overlaps the GPU work, the readback and whatever the caller
+   * does until the next call, or in a @ref VectorSimulator the rendering of
+   * the next environments. Observations lag the physics by one step.
+   *
+   * The physics writes the rigid states into the scene nodes, so any call
+   * accessing the world waits for the running step first. Each finished step
+   * publishes its rigid states into a double-buffered snapshot, which @ref
+   * getLatestPhysicsSnapshot reads without waiting. Disabling waits for the
+   * running step.
+   * @param val true = enable, false = disable
+   */
+  void setAsyncPhysicsEnabled(bool val);
+
+  /**
+   * @brief Get status, whether stepping the physics on a dedicated thread is
+   * enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isAsyncPhysicsEnabled() const { return asyncPhysics_; }
+
+  /**
+   * @brief The rigid states published by the last physics step finished on
+   * the physics thread, see @ref setAsyncPhysicsEnabled. Doesn't wait for
+   * the running step. Empty if no step ran on the physics thread yet.
+   */
+  esp::physics::PhysicsSnapshot getLatestPhysicsSnapshot() const;
+
+  /**
+   * @brief Enable or disable shared sensor rendering (disabled by default)
+   *
+   * When enabled, @ref getAgentObservations draws the scene only once for
+   * each group of co-located visual sensors of the agent (see @ref
+   * sensor::VisualSensor::isColocatedWith()) and resolves the color, depth
+   * and semantic observations of the group from the matching attachments of
+   * that single frame. Semantic sensors only join a group when the semantic
+   * scene graph is the active scene graph, otherwise they still draw the
+   * semantic mesh on their own. The frame of a depth sensor has no color and
+   * object ID (see @ref gfx::RenderTarget::isDepthOnly()), so only other
+   * depth sensors read from it. Normal and optical flow sensors always draw
+   * on their own. Ignored while asynchronous observation readback is
+   * enabled.
+   * @param val true = enable, false = disable
+   */
+  void setSharedSensorRenderEnabled(bool val) { sharedSensorRender_ = val; }
+
+  /**
+   * @brief Get status, whether shared sensor rendering is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isSharedSensorRenderEnabled() const { return sharedSensorRender_; }
+
+  /**
+   * @brief Enable or disable stereo rendering (disabled by default)
+   *
+   * When enabled, @ref getAgentObservations draws each stereo pair of depth
+   * sensors of the agent (see @ref
+   * sensor::VisualSensor::isStereoPairWith()) at once, culling the scene a
+   * single time for both views and drawing them in one pass where the GPU
+   * supports @gl_extension{OVR,multiview2}, see @ref
+   * gfx::Renderer::drawStereo(). A sensor pairs with the first later sensor
+   * of the list that matches it, both observed in the call. Ignored while
+   * asynchronous observation readback is enabled.
+   * @param val true = enable, false = disable
+   */
+  void setStereoRenderEnabled(bool val) { stereoRender_ = val; }
+
+  /**
+   * @brief Get status, whether stereo rendering is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isStereoRenderEnabled() const { return stereoRender_; }
+
+  /**
+   * @brief Enable or disable layered composition (disabled by default)
+   *
+   * When enabled, the pinhole visual sensors draw the stage, i.e. the
+   * drawables not attached to an object, once per sensor pose into a layer
+   * their render target keeps (see @ref gfx::RenderTarget::cacheLayer()),
+   * and as long as neither the pose, the specification of the sensor nor
+   * the stage change (see @ref getStageEpoch()), only draw the objects over
+   * it, depth-tested against the stage. Semantic sensors keep the semantic
+   * scene graph, if it is a separate one, as their layer. Targets drawing
+   * with more than one sample and optical flow sensors always draw the whole
+   * scene.
+   * @param val true = enable, false = disable
+   */
+  void setLayeredCompositionEnabled(bool val) { layeredComposition_ = val; }
+
+  /**
+   * @brief Get status, whether layered composition is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isLayeredCompositionEnabled() const { return layeredComposition_; }
+
+  /**
+   * @brief A counter which changes whenever the stage layer of @ref
+   * setLayeredCompositionEnabled() has to be drawn again, i.e. on
+   * reconfigure, after a simulator call changing what is drawn otherwise,
+   * e.g. the light setups, and on @ref markSceneChanged()
+   *
+   * The stage is assumed to be static, changes made to it outside of these
+   * need a @ref markSceneChanged().
+   */
+  uint64_t getStageEpoch() const { return sceneEpoch_; }
+
+  /**
+   * @brief Enable or disable the observation cache (disabled by default)
+   *
+   * When enabled, @ref getAgentObservations returns the previous observation
+   * of a visual sensor without drawing it again if neither the sensor, i.e.
+   * its pose, specification and observation buffer, nor the scene changed
+   * since. The scene changed if a drawable was added or removed or the node
+   * of one moved (see @ref scene::SceneGraph::getDrawablesEpoch()), or after
+   * a simulator call changing what is drawn otherwise, e.g. the light setups.
+   * Changes made around the simulator, e.g. to a material or to an instance
+   * node of an instanced object, need a @ref markSceneChanged(). Sensors
+   * with a noise model, optical flow sensors, whose flow of an unchanged
+   * view is zero, and asynchronous readbacks are never cached.
+   * @param val true = enable, false = disable
+   */
+  void setObservationCacheEnabled(bool val) {
+    observationCache_ = val;
+    cachedObservations_.clear();
+  }
+
+  /**
+   * @brief Get status, whether the observation cache is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isObservationCacheEnabled() const { return observationCache_; }
+
+  /**
+   * @brief Let the next @ref getAgentObservations draw all sensors again,
+   * after changing what the scene looks like outside of the simulator, see
+   * @ref setObservationCacheEnabled()
+   */
+  void markSceneChanged() { ++sceneEpoch_; }
+
+  /**
+   * @brief Set the disk-backed cache of observations, or none (the default)
+   *
+   * With a cache, @ref getAgentObservations reads the observation of a visual
+   * sensor from it instead of drawing it if it has one of the scene, the
+   * sensor specification and the quantized pose of the sensor, and writes
+   * those it draws. The cache only serves while the scene is as it was when
+   * it was set or the last @ref reconfigure() loaded it: it is skipped once
+   * an object is added, removed or moved, or after a @ref markSceneChanged().
+   * The scene is identified by its files, see @ref ViewCache::sceneHash().
+   * Sensors with a noise model, optical flow sensors and asynchronous
+   * readbacks are never cached.
+   * @param cache The cache, can be shared with other simulators
+   */
+  void setViewCache(ViewCache::ptr cache) {
+    viewCache_ = std::move(cache);
+    restartViewCache();
+  }
+
+  /** @brief The disk-backed cache of observations, if any */
+  const ViewCache::ptr& getViewCache() const { return viewCache_; }
+
+  /**
+   * @brief Enable or disable the per-stage profiling of @ref core::Profiler
+   * (disabled by default)
+   *
+   * The profiler is process-wide, so the setting and the collected stats are
+   * shared by all simulator instances.
+   * @param val true = enable, false = disable
+   */
+  void setProfilingEnabled(bool val) { core::Profiler::setEnabled(val); }
+
+  /**
+   * @brief Get status, whether profiling is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isProfilingEnabled() const { return core::Profiler::isEnabled(); }
+
+  /**
+   * @brief Get the timings and counters collected since the last @ref
+   * resetProfilingStats
+   *
+   * GPU times of render stages are only included once the GPU finished them,
+   * this does not wait for it.
+   */
+  core::ProfilingStats getProfilingStats();
+
+  /**
+   * @brief Zero all profiling timings and counters
+   */
+  void resetProfilingStats();
+
+  /**
+   * @brief Estimated GPU memory this simulator allocated, by what it holds
+   *
+   * The loaded assets of its resource manager and the render targets of the
+   * sensors of its agents, with the released ones its renderer keeps for
+   * reuse. Noise models are not owned by a simulator, so the noise model
+   * field is the device memory of all CUDA noise models of the process.
+   */
+  gfx::GpuMemoryUsage getGpuMemoryUsage() const;
+
+  /**
+   * @brief Estimated GPU memory of each asset loaded by this simulator, by
+   * filename, see @ref assets::ResourceManager::getAssetGpuBytes()
+   */
+  std::map<std::string, std::size_t> getAssetGpuBytes() const;
+
+  /**
+   * @brief Start recording a timeline trace of @ref core::Tracer, dropping
+   * the events of a previous one
+   *
+   * The trace holds the profiling stages of each step, with the GPU time of
+   * the render stages on their own track, scene loading phases and navmesh
+   * builds, on the track of the thread they ran on. Like the profiler, the
+   * tracer is process-wide.
+   */
+  void startTracing();
+
+  /**
+   * @brief Stop recording and save the trace in the Chrome trace event
+   * format, which chrome://tracing and https://ui.perfetto.dev open
+   *
+   * Waits for the GPU to finish the traced render stages.
+   * @return false if the file couldn't be written
+   */
+  bool stopTracing(const std::string& filename);
+
+  /**
+   * @brief Get status, whether a trace is being recorded or not
+   */
+  bool isTracing() const { return core::Tracer::isTracing(); }
+
+  /**
+   * @brief Start recording the session, dropping a previous recording
+   *
+   * Agent actions taken through @ref step() and @ref actAll(), agent
+   * observations with the poses they were taken at, object additions and
+   * removals, rigid states set on objects, physics steps, seeds and resets
+   * are recorded. The agents added so far are recorded first. Replay a
+   * session with @ref replaySession().
+   */
+  void startRecording();
+
+  /**
+   * @brief Stop recording and save the session to @p filename, see @ref
+   * SessionRecording::save()
+   * @return false if nothing was being recorded or the file couldn't be
+   * written
+   */
+  bool stopRecording(const std::string& filename);
+
+  /**
+   * @brief Get status, whether the session is being recorded or not
+   */
+  bool isRecording() const { return recording_ != nullptr; }
+
   /**
    * @brief Get a copy of an existing @ref gfx::LightSetup by its key.
    *
@@ -681,7 +1710,21 @@ class Simulator {
     return physicsManager_->getNumActiveContactPoints();
   }
 
+  /**
+   * @brief Get all contact points found by the last physics step. See @ref
+   * esp::physics::PhysicsManager::getContactPoints.
+   */
+  esp::physics::ContactPointResults getContactPoints(int sceneID = 0);
+
  protected:
+  /**
+   * @brief Step the physics and observe with all agents, the part of @ref
+   * step() after the actions
+   */
+  void stepWorldAndObserve(
+      std::map<int, std::map<std::string, sensor::Observation>>& observations,
+      double dt);
+
   Simulator(){};
 
   //! sample a random valid AgentState in passed agentState
@@ -692,9 +1735,37 @@ class Simulator {
   }
 
   bool sceneHasPhysics(int sceneID) const {
+    waitForPhysicsStep();
     return isValidScene(sceneID) && physicsManager_ != nullptr;
   }
 
+  //! wait for the physics step running on the physics thread, if any
+  void waitForPhysicsStep() const {
+    if (physicsStep_.valid()) {
+      physicsStep_.get();
+    }
+  }
+
+  //! wait for the running physics step, record the world step and move the
+  //! agents with their velocity controls, the part of a step before the
+  //! physics
+  void beginWorldStep(double dt);
+
+  //! step the physics on the physics thread and publish its rigid states
+  //! once it is done, see setAsyncPhysicsEnabled()
+  void launchPhysicsStep(double dt);
+
+  //! the collision geometry of the stage, and optionally of all STATIC
+  //! objects, joined into one mesh in world space
+  assets::MeshData::uptr joinedNavMeshGeometry(bool includeStaticObjects);
+
+  //! redraw the navmesh visualization if it shows @p pathfinder
+  void refreshNavMeshVisualization(nav::PathFinder& pathfinder);
+
+  //! texture size limit of the visual sensors attached so far, see
+  //! fitTextureSizeToSensor()
+  int sensorTextureSize_ = 0;
+
   gfx::WindowlessContext::uptr context_ = nullptr;
   std::shared_ptr<gfx::Renderer> renderer_ = nullptr;
   // CANNOT make the specification of resourceManager_ above the context_!
@@ -703,7 +1774,9 @@ class Simulator {
   // If you switch the order, you will have the error:
   // GL::Context::current(): no current context from Magnum
   // during the deconstruction
-  std::unique_ptr<assets::ResourceManager> resourceManager_ = nullptr;
+  // It may be shared with other simulators, which the owner of the context
+  // destroys first, see VectorSimulator
+  std::shared_ptr<assets::ResourceManager> resourceManager_ = nullptr;
 
   scene::SceneManager::uptr sceneManager_ = nullptr;
   int activeSceneID_ = ID_UNDEFINED;
@@ -714,9 +1787,61 @@ class Simulator {
 
   std::shared_ptr<physics::PhysicsManager> physicsManager_ = nullptr;
 
+  //! the streamer of the chunks of the active stage, if it is chunked
+  std::shared_ptr<assets::StageStreamer> stageStreamer_ = nullptr;
+
+  //! a scene kept loaded to switch back to, see getResidentScenes()
+  struct ResidentScene {
+    //! the configuration it was loaded with
+    SimulatorConfiguration config;
+    int sceneID = ID_UNDEFINED;
+    int semanticSceneID = ID_UNDEFINED;
+    std::shared_ptr<physics::PhysicsManager> physicsManager;
+    nav::PathFinder::ptr pathfinder;
+    std::shared_ptr<scene::SemanticScene> semanticScene;
+    //! the stage assets, its scene graphs must not be drawn once one of them
+    //! is released
+    std::vector<std::string> stageAssets;
+    gfx::LightSetup lightSetup;
+    std::shared_ptr<assets::StageStreamer> stageStreamer;
+  };
+  //! the resident scenes, the active one first when it is resident
+  std::vector<ResidentScene> residentScenes_;
+  //! whether the last reconfigure switched to a resident scene
+  bool activeSceneReused_ = false;
+
+  //! construct a simulator sharing the resources of @p source, see clone()
+  Simulator(const Simulator& source, const SimulatorConfiguration& cfg);
+  //! the simulator being cloned while it is reconfigured, see clone()
+  const Simulator* cloneSource_ = nullptr;
+
+  //! switch to the resident scene loaded with config_, if any
+  bool switchToResidentScene();
+  //! make the just loaded scene resident and release the scenes not
+  //! resident anymore
+  void keepActiveSceneResident();
+  //! destroy the physics world and the scene graphs of a resident scene
+  void releaseResidentScene(ResidentScene& scene);
+  //! move the agents into the active scene graph
+  void moveAgentsToActiveScene();
+
   core::Random::ptr random_;
   SimulatorConfiguration config_;
 
+  //! the session being recorded, nullptr if not recording
+  std::unique_ptr<SessionRecording> recording_;
+  //! append an event of @p type to recording_, nullptr if not recording
+  SessionEvent* recordEvent(SessionEventType type) {
+    if (!recording_) {
+      return nullptr;
+    }
+    recording_->events.emplace_back();
+    recording_->events.back().type = type;
+    return &recording_->events.back();
+  }
+  //! record the rigid state an object was set to
+  void recordRigidState(int objectID, int sceneID);
+
   std::vector<agent::Agent::ptr> agents_;
   nav::PathFinder::ptr pathfinder_;
   // state indicating frustum culling is enabled or not
@@ -730,6 +1855,155 @@ class Simulator {
   // rquires it when drawing the observation
   bool frustumCulling_ = true;
 
+  //! whether drawables are drawn sorted by the GL state they bind
+  bool sortByDrawState_ = false;
+
+  //! whether hidden drawables are skipped with occlusion queries
+  bool occlusionCulling_ = false;
+  //! whether the stage meshes not visible from the cell of a sensor are
+  //! skipped
+  bool potentiallyVisibleSet_ = false;
+
+  //! the encoder of saveFrame(), see getFrameEncoder()
+  gfx::FrameEncoder::uptr frameEncoder_;
+
+  //! whether the frustums of all sensors observing are culled at once
+  bool multiFrustumCulling_ = false;
+  //! the frustums of the sensors observing next, see addSensorFrustum()
+  std::vector<Magnum::Frustum> sensorFrustums_;
+  //! whether the drawable groups hold the results of precullSensorFrustums()
+  bool preculledSensorFrustums_ = false;
+
+  //! add the frustum of @p sensor to those precullSensorFrustums() culls,
+  //! if it is a visual sensor
+  void addSensorFrustum(sensor::Sensor& sensor);
+  //! cull the drawables of the active scene graphs against the added
+  //! frustums at once, for the draws until clearPreculledSensorFrustums()
+  void precullSensorFrustums();
+  //! drop the frustums and the results of precullSensorFrustums()
+  void clearPreculledSensorFrustums();
+
+  //! whether drawables are collected from the flattened render lists
+  bool renderList_ = false;
+  bool gpuDrivenRender_ = false;
+
+  //! whether observations are read back asynchronously, one frame behind
+  bool asyncObservationReadback_ = false;
+
+  //! whether the physics is stepped on a dedicated thread, one step behind
+  //! the observations
+  bool asyncPhysics_ = false;
+  //! the physics step running on the physics thread
+  mutable std::future<void> physicsStep_;
+  //! the rigid states published by the steps of the physics thread, the
+  //! thread writing the one readers don't copy from before swapping them
+  esp::physics::PhysicsSnapshot physicsSnapshots_[2];
+  int frontPhysicsSnapshot_ = 0;
+  mutable std::mutex physicsSnapshotMutex_;
+
+  //! whether co-located sensors share a single draw of the scene
+  bool sharedSensorRender_ = false;
+
+  //! whether stereo pairs of depth sensors are drawn at once
+  bool stereoRender_ = false;
+
+  //! whether the stage is drawn once per sensor pose and kept
+  bool layeredComposition_ = false;
+
+  //! whether unchanged observations are returned without drawing them
+  bool observationCache_ = false;
+
+  //! bumped by the simulator calls which change what is drawn, in addition
+  //! to the drawables epochs of the scene graphs
+  uint64_t sceneEpoch_ = 0;
+
+  //! what a cached observation of a sensor was drawn from
+  struct CachedObservation {
+    std::weak_ptr<sensor::Sensor> sensor;
+    uint64_t epoch;
+    Magnum::Matrix4 pose;
+    sensor::SensorSpec spec;
+    core::Buffer::ptr buffer;
+  };
+  std::unordered_map<const sensor::Sensor*, CachedObservation>
+      cachedObservations_;
+
+  //! the stage assets of the active scene, pinned so that the stage loads
+  //! of other simulators sharing the resource manager, e.g. the other
+  //! environments of a VectorSimulator or clones, don't release them
+  std::vector<std::string> pinnedStageAssets_;
+
+  //! pin the stage assets of the active scene instead of the previous ones
+  void pinStageAssets();
+
+  //! unpin the stage assets pinned by pinStageAssets()
+  void unpinStageAssets();
+
+  //! the disk-backed cache of observations, serving while the
+  //! observation epoch is still viewCacheEpoch_
+  ViewCache::ptr viewCache_;
+  uint64_t viewCacheEpoch_ = 0;
+  uint64_t viewCacheSceneHash_ = 0;
+
+  //! the indices of the sensors of the current getAgentObservations() call
+  //! which missed the view cache, with their keys
+  std::vector<std::pair<int, ViewCache::Key>> viewCacheMisses_;
+
+  //! let the view cache serve the scene as it is now
+  void restartViewCache();
+
+  //! the update schedule of a sensor with an update period other than 1
+  struct ScheduledSensor {
+    std::weak_ptr<sensor::Sensor> sensor;
+    uint64_t calls;
+    core::Buffer::ptr buffer;
+  };
+  std::unordered_map<const sensor::Sensor*, ScheduledSensor>
+      scheduledSensors_;
+
+  //! the epoch the observation cache compares, see markSceneChanged()
+  uint64_t observationEpoch();
+
+  //! draw the depth sensor @p first of @p sensors together with the first
+  //! later one it is a stereo pair with, recorded in stereoDrawnSensors_
+  //! @return false if there is none, in which case nothing is drawn
+  bool drawStereoPair(const std::vector<sensor::Sensor::ptr>& sensors,
+                      int first);
+
+  //! sensors whose render target holds a frame drawn in the current
+  //! getAgentObservations() call, kept to not allocate in each call
+  std::vector<sensor::VisualSensor*> drawnSensors_;
+
+  //! the second sensors of the stereo pairs drawn in the current
+  //! getAgentObservations() call, whose observations are only read
+  std::vector<const sensor::Sensor*> stereoDrawnSensors_;
+
+  //! the observations the map overload of getAgentObservations() copies out
+  std::vector<sensor::Observation> sensorObservations_;
+
+  //! the agents actAll() moved, with their unfiltered and filtered moves,
+  //! kept so that steady stepping doesn't allocate
+  std::vector<int> movedAgents_;
+  std::vector<vec3f> moveStarts_, moveEnds_, filteredMoveEnds_;
+
+  //! drop the pending asynchronous readbacks of all visual sensors, and
+  //! the observations of observeAsync() in flight without their callback
+  void discardAsyncObservationReadbacks();
+
+  //! the observations of observeAsync() in flight
+  struct AsyncObservations {
+    std::vector<sensor::Sensor*> sensors;
+    std::vector<sensor::Observation> observations;
+    //! the indices of the sensors with a queued read
+    std::vector<size_t> queued;
+    ObservationCallback callback;
+  };
+  Corrade::Containers::Optional<AsyncObservations> asyncObservations_;
+
+  //! act with the agents by action name, the part of step() before the
+  //! physics
+  bool actByNames(const std::map<int, std::string>& actions);
+
   //! NavMesh visualization variables
   int navMeshVisPrimID_ = esp::ID_UNDEFINED;
   esp::scene::SceneNode* navMeshVisNode_ = nullptr;
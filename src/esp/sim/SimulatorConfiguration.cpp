@@ -13,8 +13,30 @@ bool operator==(const SimulatorConfiguration& a,
          a.compressTextures == b.compressTextures &&
          a.createRenderer == b.createRenderer &&
          a.enablePhysics == b.enablePhysics &&
+         a.renderOnly == b.renderOnly &&
          a.physicsConfigFile.compare(b.physicsConfigFile) == 0 &&
          a.loadSemanticMesh == b.loadSemanticMesh &&
+         a.semanticVertexIds == b.semanticVertexIds &&
+         a.instancedObjectRendering == b.instancedObjectRendering &&
+         a.assetCacheCpuBudget == b.assetCacheCpuBudget &&
+         a.assetCacheGpuBudget == b.assetCacheGpuBudget &&
+         a.residentScenes == b.residentScenes &&
+         a.ptexAtlasStreaming == b.ptexAtlasStreaming &&
+         a.ptexAtlasBudget == b.ptexAtlasBudget &&
+         a.ptexGeometryShader == b.ptexGeometryShader &&
+         a.textureTranscodeCacheDir == b.textureTranscodeCacheDir &&
+         a.programBinaryCacheDir == b.programBinaryCacheDir &&
+         a.maxTextureSize == b.maxTextureSize &&
+         a.compactVertexFormat == b.compactVertexFormat &&
+         a.sharedMeshArena == b.sharedMeshArena &&
+         a.instanceMeshCpuData == b.instanceMeshCpuData &&
+         a.textureArraySize == b.textureArraySize &&
+         a.levelOfDetailCount == b.levelOfDetailCount &&
+         a.levelOfDetailPixelError == b.levelOfDetailPixelError &&
+         a.pipelinedStep == b.pipelinedStep &&
+         a.fusedDepthUnprojection == b.fusedDepthUnprojection &&
+         a.stageChunkLoadRadius == b.stageChunkLoadRadius &&
+         a.stageChunkEvictRadius == b.stageChunkEvictRadius &&
          a.sceneLightSetup.compare(b.sceneLightSetup) == 0;
 }
 
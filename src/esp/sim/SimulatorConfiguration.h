@@ -6,6 +6,7 @@
 #define ESP_SIM_SIMULATORCONFIGURATION_H_
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/GpuDevices.h"
 #include "esp/physics/configure.h"
 #include "esp/scene/SceneConfiguration.h"
 
@@ -16,6 +17,21 @@ struct SimulatorConfiguration {
   scene::SceneConfiguration scene;
   int defaultAgentId = 0;
   int gpuDeviceId = 0;
+  /**
+   * @brief How to pick the GPU of the OpenGL context the simulator creates,
+   * @ref gpuDeviceId for @ref gfx::GpuDevicePolicy::Fixed. See @ref
+   * gfx::selectGpuDevice()
+   */
+  gfx::GpuDevicePolicy gpuDevicePolicy = gfx::GpuDevicePolicy::Fixed;
+  /**
+   * @brief Whether the OpenGL context the simulator creates draws with the
+   * llvmpipe software rasterizer on the CPU, for nodes without a GPU, with
+   * @ref softwareRenderingThreads threads, 0 for one per core. Best suited to
+   * low resolution depth and semantic sensors. See @ref
+   * gfx::WindowlessContext
+   */
+  bool softwareRendering = false;
+  int softwareRenderingThreads = 0;
   unsigned int randomSeed = 0;
   std::string defaultCameraUuid = "rgba_camera";
   bool compressTextures = false;
@@ -29,15 +45,142 @@ struct SimulatorConfiguration {
    * simulation, if a suitable library (i.e. Bullet) has been installed.
    */
   bool enablePhysics = false;
+  /**
+   * @brief Whether the scene is only rendered, e.g. to replay recorded
+   * trajectories. No physics engine is created even if @ref enablePhysics is
+   * set and no collision meshes are loaded or built for the stage and the
+   * objects, which are only moved kinematically, see @ref
+   * assets::ResourceManager::setRenderOnly()
+   */
+  bool renderOnly = false;
   /**
    * @brief Whether or not to load the semantic mesh
    */
   bool loadSemanticMesh = true;
+  /**
+   * @brief Whether the render mesh of the stage draws the object ids of the
+   * semantic mesh, so that semantic sensors draw the stage once, together
+   * with the other sensors, instead of a separate semantic scene graph. See
+   * @ref assets::ResourceManager::setSemanticVertexIds()
+   */
+  bool semanticVertexIds = false;
   /**
    * @brief Whether or not to load textures for the meshes. This MUST be true
-   * for RGB rendering
+   * for RGB rendering. Changing it to true in a later reconfigure loads the
+   * textures of the assets loaded without them.
    */
   bool requiresTextures = true;
+  /**
+   * @brief Whether or not objects added with the same template share one
+   * instanced draw call per mesh and material, see @ref
+   * gfx::InstancedDrawable
+   */
+  bool instancedObjectRendering = false;
+  /**
+   * @brief Memory budgets in bytes of the stage assets kept loaded across
+   * reconfigures, 0 for no limit, see @ref
+   * assets::ResourceManager::setStageAssetCacheBudget()
+   */
+  size_t assetCacheCpuBudget = 0;
+  size_t assetCacheGpuBudget = 0;
+  /**
+   * @brief The number of scenes, the active one included, kept loaded with
+   * their scene graphs, navmeshes and physics worlds after switching away
+   * from them, 0 for none. Reconfiguring back to a resident scene with the
+   * same configuration only switches the active scene, see @ref
+   * Simulator::getResidentScenes(). Scenes whose stage assets the @ref
+   * assetCacheCpuBudget or @ref assetCacheGpuBudget releases stop being
+   * resident.
+   */
+  int residentScenes = 0;
+  /**
+   * @brief Whether PTex meshes upload their atlas textures when drawn and
+   * evict them under @ref ptexAtlasBudget bytes of GPU memory, 0 for no limit,
+   * see @ref assets::PTexAtlasCache
+   */
+  bool ptexAtlasStreaming = false;
+  size_t ptexAtlasBudget = 0;
+  /**
+   * @brief Whether PTex meshes are drawn with the geometry shader expanding
+   * their quads instead of as triangles, e.g. for comparison, see @ref
+   * gfx::PTexMeshShader::FaceIdSource
+   */
+  bool ptexGeometryShader = false;
+  /**
+   * @brief Directory caching Basis textures transcoded to the GPU format, so
+   * that loading the same scenes again skips transcoding, empty for no cache,
+   * see @ref assets::ResourceManager::setTextureTranscodeCacheDir()
+   */
+  std::string textureTranscodeCacheDir;
+  /**
+   * @brief Directory caching the linked programs of the PTex and depth
+   * shaders as driver specific binaries, so that new simulators skip their
+   * compilation, empty for no cache. The depth shaders are also created with
+   * the renderer then. See @ref gfx::setProgramBinaryCacheDir()
+   */
+  std::string programBinaryCacheDir;
+  /**
+   * @brief Largest mip level of the textures uploaded, in texels along the
+   * longer side, 0 for no limit. Visual sensors attached later raise it to
+   * twice their resolution, see @ref Simulator::fitTextureSizeToSensor()
+   */
+  int maxTextureSize = 0;
+  /**
+   * @brief Whether meshes are uploaded with packed normals and colors, half
+   * float texture coordinates and 16-bit indices where possible, see @ref
+   * assets::BaseMesh::setCompactVertexFormat()
+   */
+  bool compactVertexFormat = false;
+  /**
+   * @brief Whether the generic and instance meshes suballocate their vertex
+   * and index buffers from a few large buffers shared by all meshes, see
+   * @ref assets::MeshArena
+   */
+  bool sharedMeshArena = false;
+  /**
+   * @brief What CPU-side data the semantic instance meshes keep once drawn,
+   * all of it by default, see @ref
+   * assets::GenericInstanceMeshData::releaseCpuData()
+   */
+  assets::InstanceMeshCpuData instanceMeshCpuData =
+      assets::InstanceMeshCpuData::All;
+  /**
+   * @brief The largest object textures packed into layers of shared texture
+   * arrays, 0 to disable, so that instanced objects of the same mesh with
+   * different textures are drawn together, see @ref
+   * assets::ResourceManager::setTextureArraySize()
+   */
+  int textureArraySize = 0;
+  /**
+   * @brief Coarser levels of detail generated for the general meshes, 0 for
+   * none, drawn when their error on screen is at most @ref
+   * levelOfDetailPixelError pixels, see @ref
+   * assets::ResourceManager::setLevelsOfDetail()
+   */
+  int levelOfDetailCount = 0;
+  float levelOfDetailPixelError = 1.0f;
+  /**
+   * @brief Whether @ref Simulator::step() returns the observations of the
+   * previous step, so that the GPU draws and reads back a step while the
+   * physics of the next one runs on the CPU. Trades a step of latency for
+   * throughput, see @ref Simulator::setAsyncObservationReadbackEnabled()
+   */
+  bool pipelinedStep = false;
+  /**
+   * @brief Whether depth sensors draw linear depth straight into their render
+   * target instead of unprojecting the depth buffer in a second pass, see
+   * @ref gfx::Renderer::Flag::FusedDepthUnprojection. Applies to the depth
+   * sensors created afterwards.
+   */
+  bool fusedDepthUnprojection = false;
+  /**
+   * @brief Distance to an agent within which the chunks of a chunked stage
+   * are loaded, and beyond which from all agents they and the navmesh tiles
+   * are evicted, see @ref assets::StageStreamer. Only used for stages with a
+   * `.chunks.json` manifest next to their render asset.
+   */
+  float stageChunkLoadRadius = 20.0f;
+  float stageChunkEvictRadius = 30.0f;
   std::string physicsConfigFile =
       ESP_DEFAULT_PHYS_SCENE_CONFIG_REL_PATH;  // should we instead link a
                                                // PhysicsManagerConfiguration
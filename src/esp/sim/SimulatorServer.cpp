@@ -0,0 +1,354 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SimulatorServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "VectorSimulator.h"
+#include "esp/sensor/Sensor.h"
+
+namespace esp {
+namespace sim {
+
+namespace {
+
+using MessageType = SimulatorServer::MessageType;
+using MessageHeader = SimulatorServer::MessageHeader;
+
+//! the largest request payload accepted, a step of a million environments
+constexpr uint64_t MaxRequestSize = 4 << 20;
+
+//! writes all @p count buffers of @p iov, retrying partial writes
+bool writeAll(int fd, iovec* iov, int count) {
+  while (count > 0) {
+    const ssize_t written = writev(fd, iov, std::min(count, IOV_MAX));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    size_t remaining = written;
+    while (count > 0 && remaining >= iov->iov_len) {
+      remaining -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+      iov->iov_len -= remaining;
+    }
+  }
+  return true;
+}
+
+bool readAll(int fd, void* data, size_t size) {
+  char* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    const ssize_t count = read(fd, bytes, size);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return false;
+    }
+    bytes += count;
+    size -= count;
+  }
+  return true;
+}
+
+//! builds the payload of a reply
+class Payload {
+ public:
+  template <class T>
+  Payload& add(const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    data_.insert(data_.end(), bytes, bytes + sizeof(T));
+    return *this;
+  }
+
+  Payload& addString(const std::string& string) {
+    add(uint32_t(string.size()));
+    data_.insert(data_.end(), string.begin(), string.end());
+    return *this;
+  }
+
+  const std::vector<char>& data() const { return data_; }
+
+ private:
+  std::vector<char> data_;
+};
+
+MessageHeader header(MessageType type, uint64_t size) {
+  return {SimulatorServer::Magic, SimulatorServer::Version, type, size};
+}
+
+bool sendMessage(int fd, MessageType type, const Payload& payload) {
+  MessageHeader messageHeader = header(type, payload.data().size());
+  iovec iov[]{{&messageHeader, sizeof(messageHeader)},
+              {const_cast<char*>(payload.data().data()),
+               payload.data().size()}};
+  return writeAll(fd, iov, 2);
+}
+
+bool sendError(int fd, const std::string& message) {
+  LOG(WARNING) << "SimulatorServer : " << message;
+  return sendMessage(fd, MessageType::Error, Payload{}.addString(message));
+}
+
+//! the observation fields of the environments, in the order of the batched
+//! observations
+std::vector<std::pair<std::string, sensor::ObservationSpace>>
+observationFields(VectorSimulator& simulator) {
+  std::map<std::string, sensor::ObservationSpace> spaces;
+  for (const auto& it :
+       simulator.getAgent(0)->getSensorSuite().getSensors()) {
+    it.second->getObservationSpace(spaces[it.first]);
+  }
+  return {spaces.begin(), spaces.end()};
+}
+
+}  // namespace
+
+SimulatorServer::SimulatorServer(VectorSimulator& simulator)
+    : simulator_{simulator} {}
+
+SimulatorServer::~SimulatorServer() {
+  if (listenFd_ >= 0) {
+    close(listenFd_);
+  }
+}
+
+int SimulatorServer::listen(int port, const std::string& address) {
+  CORRADE_ASSERT(listenFd_ < 0, "SimulatorServer::listen: already listening",
+                 port_);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    throw std::runtime_error("SimulatorServer: invalid address " + address);
+  }
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  const int reuse = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  socklen_t length = sizeof(addr);
+  if (listenFd_ < 0 ||
+      bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(listenFd_, 1) != 0 ||
+      getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &length) !=
+          0) {
+    const std::string error = std::strerror(errno);
+    if (listenFd_ >= 0) {
+      close(listenFd_);
+      listenFd_ = -1;
+    }
+    throw std::runtime_error("SimulatorServer: cannot listen on " + address +
+                             ":" + std::to_string(port) + ", " + error);
+  }
+  port_ = ntohs(addr.sin_port);
+  return port_;
+}
+
+void SimulatorServer::serve(int numClients) {
+  CORRADE_ASSERT(listenFd_ >= 0, "SimulatorServer::serve: not listening", );
+  for (int served = 0; !stopped_ && (numClients <= 0 || served < numClients);
+       ++served) {
+    const int fd = accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        --served;
+        continue;
+      }
+      // e.g. the socket was shut down by stop()
+      break;
+    }
+    // the replies are single writes, sent as they are
+    const int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    serveSession(fd);
+    close(fd);
+    ring_ = nullptr;
+  }
+}
+
+void SimulatorServer::stop() {
+  stopped_ = true;
+  if (listenFd_ >= 0) {
+    // wakes up a serve() blocked in accept()
+    shutdown(listenFd_, SHUT_RDWR);
+  }
+}
+
+void SimulatorServer::serveSession(int fd) {
+  const int numEnvs = simulator_.getNumEnvs();
+  MessageHeader request{};
+  while (readAll(fd, &request, sizeof(request))) {
+    if (request.magic != Magic || request.version != Version ||
+        request.size > MaxRequestSize) {
+      sendError(fd, "unsupported protocol version or byte order");
+      return;
+    }
+    request_.resize(request.size);
+    if (!readAll(fd, request_.data(), request_.size())) {
+      return;
+    }
+
+    bool sent = false;
+    switch (request.type) {
+      case MessageType::Describe: {
+        Payload payload;
+        payload.add(uint32_t(numEnvs));
+        const auto& actionSpace =
+            simulator_.getAgent(0)->getConfig().actionSpace;
+        payload.add(uint32_t(actionSpace.size()));
+        // the compiled action table is in the order of the names
+        for (const auto& action : actionSpace) {
+          payload.addString(action.first);
+        }
+        const auto fields = observationFields(simulator_);
+        payload.add(uint32_t(fields.size()));
+        for (const auto& field : fields) {
+          payload.addString(field.first);
+          payload.add(uint32_t(field.second.dataType));
+          payload.add(uint32_t(field.second.shape.size() + 1));
+          payload.add(uint64_t(numEnvs));
+          for (size_t extent : field.second.shape) {
+            payload.add(uint64_t(extent));
+          }
+        }
+        sent = sendMessage(fd, MessageType::Description, payload);
+        break;
+      }
+      case MessageType::Reset:
+        simulator_.resetAll();
+        sent = sendObservations(fd, simulator_.getObservations());
+        break;
+      case MessageType::Step: {
+        if (request_.size() != sizeof(double) + numEnvs * sizeof(int32_t)) {
+          sent = sendError(fd, "expected a time step and " +
+                                   std::to_string(numEnvs) + " actions");
+          break;
+        }
+        double dt = 0.0;
+        std::memcpy(&dt, request_.data(), sizeof(dt));
+        if (!std::isfinite(dt) || dt < 0.0) {
+          sent = sendError(fd, "expected a finite, non-negative time step");
+          break;
+        }
+        std::vector<int> actionIndices(numEnvs);
+        for (int i = 0; i < numEnvs; ++i) {
+          int32_t index = 0;
+          std::memcpy(&index,
+                      request_.data() + sizeof(dt) + i * sizeof(int32_t),
+                      sizeof(index));
+          actionIndices[i] = index;
+        }
+        sent = sendObservations(
+            fd, simulator_.stepAllByActionIndices(actionIndices, dt));
+        break;
+      }
+      case MessageType::MapSharedMemory: {
+        uint32_t numSlots = 0;
+        if (request_.size() != sizeof(numSlots)) {
+          sent = sendError(fd, "expected a number of slots");
+          break;
+        }
+        std::memcpy(&numSlots, request_.data(), sizeof(numSlots));
+        std::vector<core::SharedMemoryRing::Field> ringFields;
+        for (const auto& field : observationFields(simulator_)) {
+          std::vector<size_t> shape{size_t(numEnvs)};
+          shape.insert(shape.end(), field.second.shape.begin(),
+                       field.second.shape.end());
+          ringFields.push_back({field.first, shape, field.second.dataType});
+        }
+        const std::string name = "/habitat-server-" +
+                                 std::to_string(getpid()) + "-" +
+                                 std::to_string(port_);
+        try {
+          ring_ = std::make_unique<core::SharedMemoryRing>(name, numSlots,
+                                                           ringFields);
+        } catch (const std::runtime_error& error) {
+          sent = sendError(fd, error.what());
+          break;
+        }
+        nextSlot_ = 0;
+        sent = sendMessage(fd, MessageType::SharedMemory,
+                           Payload{}.addString(name));
+        break;
+      }
+      case MessageType::Close:
+        sendMessage(fd, MessageType::Close, Payload{});
+        return;
+      default:
+        sent = sendError(fd, "unknown request");
+        break;
+    }
+    if (!sent) {
+      return;
+    }
+  }
+}
+
+bool SimulatorServer::sendObservations(
+    int fd,
+    const std::map<std::string, core::Buffer::ptr>& observations) {
+  const auto fields = observationFields(simulator_);
+  std::vector<const core::Buffer*> frames;
+  for (const auto& field : fields) {
+    auto found = observations.find(field.first);
+    if (found == observations.end() || found->second == nullptr) {
+      return sendError(fd, "no observation of " + field.first + " yet");
+    }
+    frames.push_back(found->second.get());
+  }
+
+  int32_t slot = -1;
+  if (ring_ != nullptr) {
+    slot = nextSlot_;
+    nextSlot_ = (nextSlot_ + 1) % ring_->numSlots();
+    for (size_t i = 0; i < fields.size(); ++i) {
+      core::Buffer::ptr view = ring_->field(slot, fields[i].first);
+      if (view == nullptr || view->data.size() != frames[i]->data.size()) {
+        return sendError(fd, "the observation of " + fields[i].first +
+                                 " doesn't fit the shared memory ring");
+      }
+      std::memcpy(view->data.data(), frames[i]->data.data(),
+                  view->data.size());
+    }
+    ring_->publish(slot);
+    return sendMessage(fd, MessageType::Observations, Payload{}.add(slot));
+  }
+
+  uint64_t size = sizeof(slot);
+  for (const core::Buffer* frame : frames) {
+    size += frame->data.size();
+  }
+  MessageHeader messageHeader = header(MessageType::Observations, size);
+  std::vector<iovec> iov{{&messageHeader, sizeof(messageHeader)},
+                         {&slot, sizeof(slot)}};
+  for (const core::Buffer* frame : frames) {
+    iov.push_back({const_cast<uint8_t*>(frame->data.data()),
+                   frame->data.size()});
+  }
+  return writeAll(fd, iov.data(), iov.size());
+}
+
+}  // namespace sim
+}  // namespace esp
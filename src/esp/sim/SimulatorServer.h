@@ -0,0 +1,165 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_SIMULATORSERVER_H_
+#define ESP_SIM_SIMULATORSERVER_H_
+
+/** @file
+ * @brief Class @ref esp::sim::SimulatorServer
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp/core/SharedMemoryRing.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sim {
+
+class VectorSimulator;
+
+/**
+ * @brief Serves the environments of a @ref VectorSimulator to a trainer on
+ * another machine, or in another process, over TCP.
+ *
+ * Each message is a @ref MessageHeader followed by its payload, in the byte
+ * order of the server, which the client checks through @ref Magic. The
+ * client sends a request and reads its reply before sending the next:
+ *
+ * - @ref MessageType::Describe, no payload, replied to with a
+ *   @ref MessageType::Description: the `uint32` number of environments, the
+ *   `uint32` number of actions followed by their names in index order, and
+ *   the `uint32` number of observation fields followed by the name, the
+ *   `uint32` @ref core::DataType, the `uint32` number of dimensions and the
+ *   `uint64` extents of each. A name is a `uint32` length and the
+ *   characters. The fields are the batched observations of @ref
+ *   VectorSimulator::getObservations(), environment first.
+ * - @ref MessageType::Reset, no payload, resets all environments and is
+ *   replied to with their @ref MessageType::Observations.
+ * - @ref MessageType::Step, a finite, non-negative `double` time step and
+ *   an `int32` action index per environment, negative for no action, steps
+ *   all environments in one call, see @ref
+ *   VectorSimulator::stepAllByActionIndices(), and is replied to with their
+ *   @ref MessageType::Observations.
+ * - @ref MessageType::MapSharedMemory, the `uint32` number of slots, for a
+ *   client on the same machine: replied to with a
+ *   @ref MessageType::SharedMemory holding the name of a @ref
+ *   core::SharedMemoryRing with a slot of the fields, which the later
+ *   observations are written into instead of being sent.
+ * - @ref MessageType::Close, no payload, replied to with an empty
+ *   @ref MessageType::Close, and ends the session.
+ *
+ * @ref MessageType::Observations holds the `int32` slot of the shared memory
+ * ring the observations were published in, or -1 followed by the bytes of
+ * the fields in order, sent straight from the batched observation buffers
+ * with a single gathering write. The frames of a reply are thus contiguous
+ * per field in memory the server keeps, ready to be registered with a
+ * transport such as RDMA. A request that fails is replied to with a @ref
+ * MessageType::Error holding a message.
+ *
+ * The server is driven from the thread owning the OpenGL context of the
+ * simulator and serves one client at a time.
+ */
+class SimulatorServer {
+ public:
+  //! First field of each message, "HSRV" in the byte order of the server
+  static constexpr uint32_t Magic = 0x56525348;
+
+  //! Version of the protocol
+  static constexpr uint16_t Version = 1;
+
+  //! The kind of a message
+  enum class MessageType : uint16_t {
+    Describe = 0,
+    Description = 1,
+    Reset = 2,
+    Step = 3,
+    Observations = 4,
+    MapSharedMemory = 5,
+    SharedMemory = 6,
+    Close = 7,
+    Error = 8,
+  };
+
+  //! Header of each message
+  struct MessageHeader {
+    uint32_t magic;
+    uint16_t version;
+    MessageType type;
+    //! size of the payload following the header
+    uint64_t size;
+  };
+
+  /**
+   * @brief Serve the environments of @p simulator, which has to outlive the
+   * server
+   */
+  explicit SimulatorServer(VectorSimulator& simulator);
+
+  ~SimulatorServer();
+
+  SimulatorServer(const SimulatorServer&) = delete;
+  SimulatorServer& operator=(const SimulatorServer&) = delete;
+
+  /**
+   * @brief Listen for clients on @p port of @p address
+   * @param port The port, 0 to pick a free one
+   * @param address The IPv4 address of the interface, the loopback one by
+   * default, "0.0.0.0" for all interfaces. The protocol has no
+   * authentication, so only listen on a trusted network.
+   * @return The port listened on
+   * @throw std::runtime_error If the address cannot be bound
+   */
+  int listen(int port, const std::string& address = "127.0.0.1");
+
+  /** @brief The port listened on, 0 before @ref listen() */
+  int port() const { return port_; }
+
+  /**
+   * @brief Serve clients one after another, each until it closes its
+   * session or disconnects
+   * @param numClients The number of clients to serve before returning, 0 to
+   * serve until @ref stop()
+   */
+  void serve(int numClients = 0);
+
+  /**
+   * @brief Make @ref serve() return once the current session ends. Can be
+   * called from any thread.
+   */
+  void stop();
+
+ private:
+  //! handle the requests of the client on socket @p fd until it is done
+  void serveSession(int fd);
+
+  //! reply with @p observations, the batched ones of the environments
+  bool sendObservations(
+      int fd,
+      const std::map<std::string, core::Buffer::ptr>& observations);
+
+  VectorSimulator& simulator_;
+  int listenFd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> stopped_{false};
+
+  //! the ring the observations of the current session are written into
+  std::unique_ptr<core::SharedMemoryRing> ring_;
+  int nextSlot_ = 0;
+
+  //! the payload of the request being handled, kept to not allocate
+  std::vector<char> request_;
+
+  ESP_SMART_POINTERS(SimulatorServer)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_SIMULATORSERVER_H_
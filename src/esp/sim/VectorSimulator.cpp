@@ -0,0 +1,304 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "VectorSimulator.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Renderer.h>
+
+#include "esp/gfx/Renderer.h"
+#include "esp/sensor/Sensor.h"
+
+namespace esp {
+namespace sim {
+
+/**
+ * @brief A thread running the tasks of one environment, with an OpenGL
+ * context sharing the one of the vector simulator current on it
+ */
+struct VectorSimulator::EnvThread {
+  explicit EnvThread(gfx::WindowlessContext& sharedContext)
+      : thread_{&EnvThread::run, this, std::ref(sharedContext)} {}
+
+  ~EnvThread() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+
+  //! run @p task on the thread, see wait()
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      task_ = std::move(task);
+    }
+    wake_.notify_one();
+  }
+
+  //! wait for the task submitted last
+  void wait() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_.wait(lock, [this] { return !task_; });
+  }
+
+ private:
+  void run(gfx::WindowlessContext& sharedContext) {
+    // created and destroyed on this thread, the only one it is current on
+    gfx::WindowlessContext::uptr context =
+        gfx::WindowlessContext::createShared(sharedContext);
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      wake_.wait(lock, [this] { return task_ || stopping_; });
+      if (!task_) {
+        return;
+      }
+      lock.unlock();
+      task_();
+      lock.lock();
+      task_ = nullptr;
+      done_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  std::function<void()> task_;
+  bool stopping_ = false;
+  // started last, once the members above are
+  std::thread thread_;
+};
+
+VectorSimulator::VectorSimulator(
+    const std::vector<SimulatorConfiguration>& cfgs,
+    const agent::AgentConfiguration& agentConfig,
+    bool threaded) {
+  CORRADE_ASSERT(!cfgs.empty(), "VectorSimulator: no environments", );
+
+  context_ = gfx::WindowlessContext::create_unique(
+      gfx::selectGpuDevice(cfgs[0].gpuDevicePolicy, cfgs[0].gpuDeviceId),
+      cfgs[0].softwareRendering, cfgs[0].softwareRenderingThreads, threaded);
+  resourceManager_ = std::make_shared<assets::ResourceManager>();
+  gfx::Renderer::Flags flags;
+  if (!cfgs[0].requiresTextures) {
+    flags |= gfx::Renderer::Flag::NoTextures;
+  }
+
+  if (threaded) {
+    envs_.resize(cfgs.size());
+    envObservations_.resize(cfgs.size());
+    for (size_t i = 0; i < cfgs.size(); ++i) {
+      threads_.emplace_back(std::make_unique<EnvThread>(*context_));
+    }
+    // the render targets are per context, so is the renderer pooling them
+    runOnThreads([&](int envId) {
+      // loaded one at a time, an asset of several scenes once for all
+      std::lock_guard<std::recursive_mutex> lock{
+          resourceManager_->getRegistryMutex()};
+      envs_[envId] = std::make_unique<Simulator>(
+          cfgs[envId], resourceManager_, gfx::Renderer::create(flags));
+      envs_[envId]->addAgent(agentConfig);
+      // the uploads are complete before the other contexts use them
+      Magnum::GL::Renderer::finish();
+    });
+  } else {
+    renderer_ = gfx::Renderer::create(flags);
+    envs_.reserve(cfgs.size());
+    for (const SimulatorConfiguration& cfg : cfgs) {
+      envs_.emplace_back(
+          std::make_unique<Simulator>(cfg, resourceManager_, renderer_));
+      envs_.back()->addAgent(agentConfig);
+    }
+  }
+  resetAll();
+}
+
+VectorSimulator::~VectorSimulator() {
+  LOG(INFO) << "Deconstructing VectorSimulator";
+  observations_.clear();
+  envObservations_.clear();
+  if (isThreaded()) {
+    // with their render targets, on the thread of their context
+    runOnThreads([&](int envId) { envs_[envId] = nullptr; });
+    threads_.clear();
+  }
+  envs_.clear();
+}
+
+void VectorSimulator::runOnThreads(const std::function<void(int)>& task) {
+  for (int i = 0; i < threads_.size(); ++i) {
+    threads_[i]->submit([&task, i] { task(i); });
+  }
+  for (auto& thread : threads_) {
+    thread->wait();
+  }
+}
+
+void VectorSimulator::observeOnThread(int envId) {
+  // the default light setup is shared by all environments, and the shader
+  // programs with it
+  std::lock_guard<std::recursive_mutex> lock{
+      resourceManager_->getRegistryMutex()};
+  useDefaultLightSetup(envId);
+  envs_[envId]->getAgentObservations(0, envObservations_[envId]);
+  Magnum::GL::Renderer::flush();
+}
+
+Simulator& VectorSimulator::getEnv(int envId) {
+  ASSERT(0 <= envId && envId < envs_.size());
+  return *envs_[envId];
+}
+
+agent::Agent::ptr VectorSimulator::getAgent(int envId) {
+  // the agent added in the constructor is the first of each environment
+  return getEnv(envId).getAgent(0);
+}
+
+void VectorSimulator::resetAll() {
+  if (isThreaded()) {
+    defaultLightSetups_.resize(envs_.size());
+    runOnThreads([&](int envId) {
+      std::lock_guard<std::recursive_mutex> lock{
+          resourceManager_->getRegistryMutex()};
+      envs_[envId]->reset();
+      defaultLightSetups_[envId] = envs_[envId]->getLightSetup();
+    });
+    return;
+  }
+  for (auto& env : envs_) {
+    env->reset();
+  }
+  saveDefaultLightSetups();
+}
+
+void VectorSimulator::saveDefaultLightSetups() {
+  // Simulator::reset() set the default light setup from the scene bounds,
+  // each environment overwriting the one of the previous
+  defaultLightSetups_.clear();
+  for (auto& env : envs_) {
+    defaultLightSetups_.push_back(env->getLightSetup());
+  }
+}
+
+const std::map<std::string, core::Buffer::ptr>& VectorSimulator::stepAll(
+    const std::vector<std::string>& actions,
+    double dt) {
+  CORRADE_ASSERT(actions.size() == envs_.size(),
+                 "VectorSimulator::stepAll: expected" << envs_.size()
+                                                      << "actions, got"
+                                                      << actions.size(),
+                 observations_);
+  if (isThreaded()) {
+    std::vector<int> actionIndices(actions.size(), ID_UNDEFINED);
+    for (int i = 0; i < envs_.size(); ++i) {
+      if (actions[i].empty()) {
+        continue;
+      }
+      actionIndices[i] = envs_[i]->getAgent(0)->getActionIndex(actions[i]);
+      if (actionIndices[i] == ID_UNDEFINED) {
+        LOG(ERROR) << "VectorSimulator::stepAll: environment " << i
+                   << " has no action " << actions[i];
+      }
+    }
+    return stepAllByActionIndices(actionIndices, dt);
+  }
+  std::map<int, std::map<std::string, sensor::Observation>> envObservations;
+  for (int i = 0; i < envs_.size(); ++i) {
+    std::map<int, std::string> envActions;
+    if (!actions[i].empty()) {
+      envActions[0] = actions[i];
+    }
+    useDefaultLightSetup(i);
+    envs_[i]->step(envActions, envObservations, dt);
+    batchObservations(i, envObservations[0]);
+  }
+  return observations_;
+}
+
+const std::map<std::string, core::Buffer::ptr>&
+VectorSimulator::stepAllByActionIndices(
+    const std::vector<int>& actionIndices,
+    double dt) {
+  CORRADE_ASSERT(actionIndices.size() == envs_.size(),
+                 "VectorSimulator::stepAllByActionIndices: expected"
+                     << envs_.size() << "actions, got" << actionIndices.size(),
+                 observations_);
+  if (isThreaded()) {
+    runOnThreads([&](int envId) {
+      envs_[envId]->actAll({actionIndices[envId]});
+      envs_[envId]->stepWorld(dt);
+      observeOnThread(envId);
+    });
+    for (int i = 0; i < envs_.size(); ++i) {
+      batchObservations(i, envObservations_[i]);
+    }
+    return observations_;
+  }
+  std::map<int, std::map<std::string, sensor::Observation>> envObservations;
+  std::vector<int> envActions(1);
+  for (int i = 0; i < envs_.size(); ++i) {
+    envActions[0] = actionIndices[i];
+    useDefaultLightSetup(i);
+    envs_[i]->stepByActionIndices(envActions, envObservations, dt);
+    batchObservations(i, envObservations[0]);
+  }
+  return observations_;
+}
+
+const std::map<std::string, core::Buffer::ptr>&
+VectorSimulator::getObservations() {
+  if (isThreaded()) {
+    runOnThreads([&](int envId) { observeOnThread(envId); });
+    for (int i = 0; i < envs_.size(); ++i) {
+      batchObservations(i, envObservations_[i]);
+    }
+    return observations_;
+  }
+  std::map<std::string, sensor::Observation> envObservations;
+  for (int i = 0; i < envs_.size(); ++i) {
+    useDefaultLightSetup(i);
+    envs_[i]->getAgentObservations(0, envObservations);
+    batchObservations(i, envObservations);
+  }
+  return observations_;
+}
+
+void VectorSimulator::useDefaultLightSetup(int envId) {
+  if (envs_.size() > 1) {
+    envs_[envId]->setLightSetup(defaultLightSetups_[envId]);
+  }
+}
+
+void VectorSimulator::batchObservations(
+    int envId,
+    const std::map<std::string, sensor::Observation>& envObservations) {
+  for (const auto& it : envObservations) {
+    const core::Buffer::ptr& frame = it.second.buffer;
+    if (frame == nullptr) {
+      // no frame read back yet, e.g. from an asynchronous readback
+      continue;
+    }
+    core::Buffer::ptr& batch = observations_[it.first];
+    if (batch == nullptr || batch->dataType != frame->dataType ||
+        batch->totalSize != frame->totalSize * envs_.size()) {
+      std::vector<size_t> shape{envs_.size()};
+      shape.insert(shape.end(), frame->shape.begin(), frame->shape.end());
+      batch = core::Buffer::create(shape, frame->dataType);
+    }
+    const size_t frameBytes = frame->data.size();
+    std::memcpy(batch->data.data() + envId * frameBytes, frame->data.data(),
+                frameBytes);
+  }
+}
+
+}  // namespace sim
+}  // namespace esp
@@ -0,0 +1,176 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_VECTORSIMULATOR_H_
+#define ESP_SIM_VECTORSIMULATOR_H_
+
+/** @file
+ * @brief Class @ref esp::sim::VectorSimulator
+ */
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp/agent/Agent.h"
+#include "esp/core/Buffer.h"
+#include "esp/core/esp.h"
+#include "esp/gfx/LightSetup.h"
+#include "esp/gfx/WindowlessContext.h"
+
+#include "Simulator.h"
+#include "SimulatorConfiguration.h"
+
+namespace esp {
+namespace sim {
+
+/**
+ * @brief A group of environments, each a @ref Simulator with its own scene,
+ * physics, navmesh and agent, stepped and observed together.
+ *
+ * The environments share one OpenGL context, one @ref
+ * assets::ResourceManager, whose shader manager holds the shader programs,
+ * and one @ref gfx::Renderer, so an asset in several of their scenes is
+ * loaded and uploaded once. The light setups of the resource manager are
+ * shared by key as well, except for the default one, which each environment
+ * gets from the bounds of its own scene before it is drawn.
+ *
+ * Threaded, each environment is stepped and drawn on a thread of its own,
+ * with an OpenGL context in the share group of the one of the vector
+ * simulator and a renderer of its own. The actions, physics and readbacks of
+ * the environments then run concurrently, while their draws, which share the
+ * shader programs, are serialized by @ref
+ * assets::ResourceManager::getRegistryMutex().
+ */
+class VectorSimulator {
+ public:
+  /**
+   * @brief Create an environment for each configuration and add an agent
+   * configured by @p agentConfig to each of them.
+   *
+   * The context is created on the GPU the device placement of the first
+   * configuration picks, see @ref SimulatorConfiguration::gpuDevicePolicy.
+   * @param cfgs The configurations of the environments, with the same values
+   * for the asset loading options such as @ref
+   * SimulatorConfiguration::requiresTextures
+   * @param agentConfig The configuration of the agent of each environment
+   * @param threaded Whether to step and draw each environment on a thread of
+   * its own, see @ref isThreaded()
+   */
+  VectorSimulator(const std::vector<SimulatorConfiguration>& cfgs,
+                  const agent::AgentConfiguration& agentConfig,
+                  bool threaded = false);
+
+  ~VectorSimulator();
+
+  /** @brief The number of environments */
+  int getNumEnvs() const { return envs_.size(); }
+
+  /**
+   * @brief The environment @p envId, to configure its scene or agent directly
+   *
+   * If @ref isThreaded(), its context is only current on its thread, so it
+   * is only drawn by @ref stepAll() and @ref getObservations().
+   */
+  Simulator& getEnv(int envId);
+
+  /** @brief The agent of the environment @p envId */
+  agent::Agent::ptr getAgent(int envId);
+
+  /**
+   * @brief The ID of the CUDA device of the shared OpenGL context, -1 with
+   * @ref SimulatorConfiguration::softwareRendering
+   */
+  int gpuDevice() const { return context_->gpuDevice(); }
+
+  /**
+   * @brief Whether each environment is stepped and drawn on a thread of its
+   * own, with an OpenGL context sharing the assets of the others
+   */
+  bool isThreaded() const { return !threads_.empty(); }
+
+  /** @brief Reset all environments and their agents */
+  void resetAll();
+
+  /**
+   * @brief Act in every environment, step its physics and return the
+   * observations of all of them, see @ref Simulator::step().
+   * @param actions An action of the action space of the agents for each
+   * environment, an empty string for no action
+   * @param dt The time to step the physics by
+   * @return See @ref getObservations()
+   */
+  const std::map<std::string, core::Buffer::ptr>& stepAll(
+      const std::vector<std::string>& actions,
+      double dt = 1.0 / 60.0);
+
+  /**
+   * @brief Like @ref stepAll(const std::vector<std::string>&, double), with
+   * the actions given by index in the compiled action table of the agents,
+   * see @ref agent::Agent::getActionIndex().
+   * @param actionIndices An action index for each environment, negative for
+   * no action
+   * @param dt The time to step the physics by
+   * @return See @ref getObservations()
+   */
+  const std::map<std::string, core::Buffer::ptr>& stepAllByActionIndices(
+      const std::vector<int>& actionIndices,
+      double dt = 1.0 / 60.0);
+
+  /**
+   * @brief Draw the sensors of the agents of all environments.
+   *
+   * @return For each sensor uuid, one buffer with the observations of all
+   * environments in order, with the environment as the outermost dimension.
+   * The buffers are reused and overwritten by the next call.
+   */
+  const std::map<std::string, core::Buffer::ptr>& getObservations();
+
+ private:
+  struct EnvThread;
+
+  //! run @p task(envId) for each environment on its thread and wait for all
+  void runOnThreads(const std::function<void(int)>& task);
+
+  //! draw the sensors of environment @p envId on its thread, see runOnThreads()
+  void observeOnThread(int envId);
+
+  //! remember the default light setups the environments just set, see reset()
+  void saveDefaultLightSetups();
+
+  //! set the default light setup of environment @p envId before drawing it
+  void useDefaultLightSetup(int envId);
+
+  //! copy the observations of environment @p envId into observations_
+  void batchObservations(
+      int envId,
+      const std::map<std::string, sensor::Observation>& envObservations);
+
+  // destroyed in reverse, the environments before the shared resources and
+  // those before the context
+  gfx::WindowlessContext::uptr context_ = nullptr;
+  std::shared_ptr<gfx::Renderer> renderer_ = nullptr;
+  std::shared_ptr<assets::ResourceManager> resourceManager_ = nullptr;
+  std::vector<std::unique_ptr<Simulator>> envs_;
+  //! the thread of each environment if threaded, destroying it on its own
+  std::vector<std::unique_ptr<EnvThread>> threads_;
+
+  //! the default light setup of each environment
+  std::vector<gfx::LightSetup> defaultLightSetups_;
+
+  //! the observations of each environment drawn on its thread
+  std::vector<std::map<std::string, sensor::Observation>> envObservations_;
+
+  //! the batched observations returned by getObservations()
+  std::map<std::string, core::Buffer::ptr> observations_;
+
+  ESP_SMART_POINTERS(VectorSimulator)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_VECTORSIMULATOR_H_
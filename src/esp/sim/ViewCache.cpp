@@ -0,0 +1,217 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ViewCache.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Magnum/Math/Quaternion.h>
+
+#include "esp/core/Compression.h"
+#include "esp/core/Profiling.h"
+#include "esp/io/io.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sim {
+
+namespace {
+
+const uint32_t VIEWCACHE_MAGIC = 'H' << 24 | 'V' << 16 | 'C' << 8 | 'E';
+const uint32_t VIEWCACHE_VERSION = 1;
+
+//! The header of an entry, followed by the compressed observation
+struct EntryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t scene;
+  uint64_t spec;
+  int32_t pose[7];
+  uint32_t reserved;
+  //! size of the observation
+  uint64_t size;
+};
+
+struct Fnv1a {
+  uint64_t hash = 14695981039346656037ull;
+
+  void add(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+  template <typename T>
+  void add(const T& value) {
+    add(&value, sizeof(T));
+  }
+  void add(const std::string& value) {
+    add(value.size());
+    add(value.data(), value.size());
+  }
+};
+
+//! add the path, size and modification time of @p file
+void addFile(Fnv1a& hash, const std::string& file) {
+  hash.add(file);
+  struct stat fileStat;
+  if (stat(file.c_str(), &fileStat) == 0) {
+    hash.add(uint64_t(fileStat.st_size));
+    hash.add(uint64_t(fileStat.st_mtime));
+  }
+}
+
+int32_t quantize(float value, float step) {
+  return int32_t(std::lround(value / step));
+}
+
+}  // namespace
+
+ViewCache::ViewCache(const std::string& directory,
+                     float positionStep,
+                     float rotationStep)
+    : directory_{directory},
+      positionStep_{positionStep},
+      rotationStep_{rotationStep} {
+  CORRADE_ASSERT(positionStep > 0.0f && rotationStep > 0.0f,
+                 "ViewCache::ViewCache(): expected positive steps", );
+  if (!Cr::Utility::Directory::mkpath(directory_)) {
+    LOG(ERROR) << "ViewCache::ViewCache : could not create " << directory_;
+  }
+}
+
+uint64_t ViewCache::sceneHash(const SimulatorConfiguration& cfg) {
+  Fnv1a hash;
+  hash.add(cfg.scene.dataset);
+  addFile(hash, cfg.scene.id);
+  hash.add(cfg.scene.filepaths.size());
+  for (const auto& filepath : cfg.scene.filepaths) {
+    hash.add(filepath.first);
+    addFile(hash, filepath.second);
+  }
+  hash.add(cfg.sceneLightSetup);
+  hash.add(cfg.requiresTextures);
+  hash.add(cfg.loadSemanticMesh);
+  return hash.hash;
+}
+
+uint64_t ViewCache::specHash(const sensor::SensorSpec& spec) {
+  Fnv1a hash;
+  hash.add(spec.sensorType);
+  hash.add(spec.sensorSubtype);
+  hash.add(spec.parameters.size());
+  for (const auto& parameter : spec.parameters) {
+    hash.add(parameter.first);
+    hash.add(parameter.second);
+  }
+  hash.add(spec.position.data(), sizeof(float) * 3);
+  hash.add(spec.orientation.data(), sizeof(float) * 3);
+  hash.add(spec.resolution.data(), sizeof(int) * 2);
+  hash.add(spec.channels);
+  hash.add(spec.encoding);
+  hash.add(spec.observationSpace);
+  hash.add(spec.noiseModel);
+  hash.add(spec.gpu2gpuTransfer);
+  hash.add(spec.observationFormat);
+  hash.add(spec.downsampling);
+  hash.add(spec.samples);
+  hash.add(spec.renderQuality);
+  return hash.hash;
+}
+
+ViewCache::Key ViewCache::key(uint64_t sceneHash,
+                              const sensor::SensorSpec& spec,
+                              const Mn::Matrix4& pose) const {
+  Key key;
+  key.scene = sceneHash;
+  key.spec = specHash(spec);
+  const Mn::Vector3 translation = pose.translation();
+  // q and -q are the same rotation
+  Mn::Quaternion rotation = Mn::Quaternion::fromMatrix(pose.rotation());
+  if (rotation.scalar() < 0.0f) {
+    rotation = -rotation;
+  }
+  for (int i = 0; i < 3; ++i) {
+    key.pose[i] = quantize(translation[i], positionStep_);
+    key.pose[3 + i] = quantize(rotation.vector()[i], rotationStep_);
+  }
+  key.pose[6] = quantize(rotation.scalar(), rotationStep_);
+  return key;
+}
+
+std::string ViewCache::filename(const Key& key) const {
+  Fnv1a hash;
+  hash.add(key.scene);
+  hash.add(key.spec);
+  hash.add(key.pose.data(), sizeof(int32_t) * key.pose.size());
+  // spread over subdirectories, millions of entries in one are slow to open
+  return Cr::Utility::Directory::join(
+      {directory_, Cr::Utility::formatString("{:.2x}", hash.hash >> 56),
+       Cr::Utility::formatString("{:.16x}.hvc", hash.hash)});
+}
+
+bool ViewCache::read(const Key& key, core::Buffer& buffer) const {
+  const std::string file = filename(key);
+  bool hit = false;
+  if (buffer.deviceId() < 0 && Cr::Utility::Directory::exists(file)) {
+    const Cr::Containers::Array<char> data = Cr::Utility::Directory::read(file);
+    EntryHeader header;
+    if (data.size() >= sizeof(header)) {
+      std::memcpy(&header, data.data(), sizeof(header));
+      hit = header.magic == VIEWCACHE_MAGIC &&
+            header.version == VIEWCACHE_VERSION && header.scene == key.scene &&
+            header.spec == key.spec &&
+            std::equal(key.pose.begin(), key.pose.end(), header.pose) &&
+            header.size == buffer.data.size() &&
+            core::decompressBytes(
+                reinterpret_cast<const unsigned char*>(data.data()) +
+                    sizeof(header),
+                data.size() - sizeof(header), buffer.data.data(),
+                buffer.data.size());
+    }
+  }
+  core::Profiler::increment(hit ? core::ProfilingCounter::ViewCacheHits
+                                : core::ProfilingCounter::ViewCacheMisses);
+  return hit;
+}
+
+bool ViewCache::write(const Key& key, const core::Buffer& buffer) const {
+  if (buffer.deviceId() >= 0) {
+    return false;
+  }
+  const std::string file = filename(key);
+  if (!Cr::Utility::Directory::mkpath(Cr::Utility::Directory::path(file))) {
+    return false;
+  }
+
+  EntryHeader header{};
+  header.magic = VIEWCACHE_MAGIC;
+  header.version = VIEWCACHE_VERSION;
+  header.scene = key.scene;
+  header.spec = key.spec;
+  std::copy(key.pose.begin(), key.pose.end(), header.pose);
+  header.size = buffer.data.size();
+  const std::vector<unsigned char> compressed =
+      core::compressBytes(buffer.data.data(), buffer.data.size());
+  Cr::Containers::Array<char> data{
+      Cr::Containers::NoInit, sizeof(header) + compressed.size()};
+  std::memcpy(data.data(), &header, sizeof(header));
+  std::memcpy(data.data() + sizeof(header), compressed.data(),
+              compressed.size());
+
+  return io::writeFileAtomically(file, data.data(), data.size());
+}
+
+}  // namespace sim
+}  // namespace esp
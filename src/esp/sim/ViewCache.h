@@ -0,0 +1,131 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_VIEWCACHE_H_
+#define ESP_SIM_VIEWCACHE_H_
+
+/** @file
+ * @brief Class @ref esp::sim::ViewCache
+ */
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/core/Buffer.h"
+#include "esp/core/esp.h"
+#include "esp/sensor/Sensor.h"
+
+#include "SimulatorConfiguration.h"
+
+namespace esp {
+namespace sim {
+
+/**
+ * @brief A disk-backed cache of the observations of visual sensors, by scene,
+ * sensor specification and quantized pose
+ *
+ * For generating datasets which render the same scene from poses on a grid,
+ * where the same poses come back in loops or overlapping episodes. Each entry
+ * is a file in a subdirectory of @ref directory(), holding the observation
+ * compressed with @ref core::compressBytes() after a header with its whole
+ * key, so a hash collision is a miss. The entries are written to a temporary
+ * file and renamed, so several processes may share a directory.
+ *
+ * The translation of a pose is quantized to multiples of the position step
+ * and the components of its rotation quaternion to multiples of the rotation
+ * step, so poses within a step of each other may share an entry. Hits and
+ * misses of @ref read() are counted by the @ref core::Profiler. Safe to share
+ * between simulators, and to use from several threads.
+ */
+class ViewCache {
+ public:
+  /** @brief The key of an entry */
+  struct Key {
+    //! hash of the scene, see @ref sceneHash()
+    uint64_t scene = 0;
+    //! hash of the sensor specification, see @ref specHash()
+    uint64_t spec = 0;
+    //! the quantized translation and rotation quaternion of the pose
+    std::array<int32_t, 7> pose{};
+  };
+
+  /**
+   * @brief Open the cache in @p directory
+   * @param directory The directory of the entries, created if it doesn't
+   * exist
+   * @param positionStep The quantization step of the translations, in
+   * meters
+   * @param rotationStep The quantization step of the components of the
+   * rotation quaternions
+   */
+  explicit ViewCache(const std::string& directory,
+                     float positionStep = 0.001f,
+                     float rotationStep = 0.0005f);
+
+  /** @brief The directory of the entries */
+  const std::string& directory() const { return directory_; }
+
+  /** @brief The quantization step of the translations */
+  float positionStep() const { return positionStep_; }
+
+  /** @brief The quantization step of the rotation quaternion components */
+  float rotationStep() const { return rotationStep_; }
+
+  /**
+   * @brief Hash of the scene a configuration loads
+   *
+   * Covers the scene and its files by path, size and modification time, the
+   * light setup and whether textures are loaded, not the changes made to the
+   * scene once loaded.
+   */
+  static uint64_t sceneHash(const SimulatorConfiguration& cfg);
+
+  /**
+   * @brief Hash of what a sensor specification draws, i.e. all but its uuid
+   * and update period
+   */
+  static uint64_t specHash(const sensor::SensorSpec& spec);
+
+  /**
+   * @brief The key of the observation of a sensor
+   * @param sceneHash The hash of the scene
+   * @param spec The specification of the sensor
+   * @param pose The absolute transformation of the sensor, rigid
+   */
+  Key key(uint64_t sceneHash,
+          const sensor::SensorSpec& spec,
+          const Magnum::Matrix4& pose) const;
+
+  /**
+   * @brief Read the entry of @p key into @p buffer
+   * @return false if there is no such entry, it doesn't have the size of
+   * @p buffer or it is malformed. @p buffer may be overwritten then.
+   */
+  bool read(const Key& key, core::Buffer& buffer) const;
+
+  /**
+   * @brief Write @p buffer as the entry of @p key, replacing any
+   * @return false if the entry couldn't be written
+   */
+  bool write(const Key& key, const core::Buffer& buffer) const;
+
+ private:
+  //! the file of the entry of @p key
+  std::string filename(const Key& key) const;
+
+  std::string directory_;
+  float positionStep_;
+  float rotationStep_;
+
+  ESP_SMART_POINTERS(ViewCache)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_VIEWCACHE_H_
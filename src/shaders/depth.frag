@@ -3,14 +3,39 @@ uniform highp sampler2D depthTexture;
 uniform highp vec2 depthUnprojection;
 
 in highp vec2 textureCoordinates;
+#elif defined(SURFACE_NORMALS)
+in highp vec3 transformedNormal;
+#elif defined(MOTION_VECTORS)
+uniform highp vec2 viewportSize;
+
+in highp vec4 currentPosition;
+in highp vec4 previousPosition;
 #else
 in highp float depth;
 #endif
 
+#ifdef SURFACE_NORMALS
+out highp vec4 surfaceNormal;
+#elif defined(MOTION_VECTORS)
+out highp vec2 motionVector;
+#else
 out highp float originalDepth;
+#endif
 
 void main() {
-  #ifdef UNPROJECT_EXISTING_DEPTH
+  #ifdef SURFACE_NORMALS
+  /* Meshes without normals have the default zero attribute */
+  highp float normalLength = length(transformedNormal);
+  surfaceNormal = vec4(normalLength > 0.0 ?
+    transformedNormal/normalLength : vec3(0.0), 0.0);
+  #elif defined(MOTION_VECTORS)
+  /* In framebuffer pixels, from where the surface was in the previous frame
+     to where it is now. Surfaces which were behind the camera are taken as
+     not moved. */
+  motionVector = previousPosition.w > 0.0 ?
+    (currentPosition.xy/currentPosition.w -
+     previousPosition.xy/previousPosition.w)*0.5*viewportSize : vec2(0.0);
+  #elif defined(UNPROJECT_EXISTING_DEPTH)
   highp float depth = texture(depthTexture, textureCoordinates).r;
   originalDepth =
     #ifndef NO_FAR_PLANE_PATCHING
@@ -2,19 +2,64 @@
 uniform highp mat4 transformationMatrix;
 uniform highp mat4 projectionMatrix;
 #endif
+#ifdef MOTION_VECTORS
+uniform highp mat4 previousTransformationProjectionMatrix;
+#endif
+#ifdef MULTIVIEW
+layout(num_views = 2) in;
+uniform highp mat4 viewTransformationMatrices[2];
+#endif
 
 #ifdef UNPROJECT_EXISTING_DEPTH
 out highp vec2 textureCoordinates;
 #else
 layout(location = 0) in highp vec4 position;
+#ifdef INSTANCED_TRANSFORMATION
+layout(location = TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION)
+in highp mat4 instancedTransformationMatrix;
+#endif
+#ifdef SURFACE_NORMALS
+layout(location = NORMAL_ATTRIBUTE_LOCATION) in highp vec3 normal;
+out highp vec3 transformedNormal;
+#elif defined(MOTION_VECTORS)
+out highp vec4 currentPosition;
+out highp vec4 previousPosition;
+#else
 out highp float depth;
 #endif
+#endif
 
 void main() {
   #ifndef UNPROJECT_EXISTING_DEPTH
-  vec4 transformed = transformationMatrix*position;
+  highp mat4 transformation = transformationMatrix
+    #ifdef INSTANCED_TRANSFORMATION
+    *instancedTransformationMatrix
+    #endif
+    ;
+  #ifdef MULTIVIEW
+  /* From the camera of the transformation to the one of this view */
+  transformation = viewTransformationMatrices[gl_ViewID_OVR]*transformation;
+  #endif
+  vec4 transformed = transformation*position;
   gl_Position = projectionMatrix*transformed;
+  #ifdef SURFACE_NORMALS
+  /* The cofactor matrix is the normal matrix up to a scale, which the
+     fragment shader normalizes away */
+  highp mat3 m = mat3(transformation);
+  transformedNormal = mat3(cross(m[1], m[2]), cross(m[2], m[0]),
+                           cross(m[0], m[1]))*normal;
+  #elif defined(MOTION_VECTORS)
+  /* Instances are assumed to stay where they were relative to the drawable,
+     only its own previous transformation is known */
+  currentPosition = gl_Position;
+  previousPosition = previousTransformationProjectionMatrix*
+    #ifdef INSTANCED_TRANSFORMATION
+    instancedTransformationMatrix*
+    #endif
+    position;
+  #else
   depth = -transformed.z;
+  #endif
   #else
   gl_Position = vec4((gl_VertexID == 2) ?  3.0 : -1.0,
                      (gl_VertexID == 1) ? -3.0 :  1.0, 0.0, 1.0);
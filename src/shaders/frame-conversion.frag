@@ -0,0 +1,44 @@
+#ifdef OBJECT_ID_LOOKUP
+uniform highp usampler2D sourceTexture;
+uniform highp usampler2D lookupTexture;
+uniform highp uint lookupSize;
+#else
+uniform highp sampler2D sourceTexture;
+#endif
+uniform highp int downsampling;
+
+#if defined(MILLIMETER_DEPTH) || defined(OBJECT_ID_LOOKUP)
+out highp uint convertedValue;
+#else
+out highp vec4 convertedValue;
+#endif
+
+void main() {
+  /* The box of source texels covered by this output pixel, counted from the
+     bottom left like the viewport */
+  highp ivec2 origin = ivec2(gl_FragCoord.xy)*downsampling;
+
+  #ifdef OBJECT_ID_LOOKUP
+  /* IDs can't be averaged, take the one nearest to the center of the box */
+  highp uint id = texelFetch(sourceTexture, origin + ivec2(downsampling/2),
+                             0).r;
+  convertedValue = id < lookupSize ?
+    texelFetch(lookupTexture, ivec2(int(id % LOOKUP_WIDTH),
+                                    int(id/LOOKUP_WIDTH)), 0).r : 0u;
+  #else
+  highp vec4 sum = vec4(0.0);
+  for(lowp int y = 0; y < downsampling; ++y)
+    for(lowp int x = 0; x < downsampling; ++x)
+      sum += texelFetch(sourceTexture, origin + ivec2(x, y), 0);
+  highp vec4 average = sum/float(downsampling*downsampling);
+
+  #if defined(GRAYSCALE)
+  convertedValue = vec4(vec3(dot(average.rgb, vec3(0.299, 0.587, 0.114))),
+                        average.a);
+  #elif defined(MILLIMETER_DEPTH)
+  convertedValue = uint(clamp(average.r*1000.0 + 0.5, 0.0, 65535.0));
+  #else
+  convertedValue = average;
+  #endif
+  #endif
+}
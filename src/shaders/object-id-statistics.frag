@@ -0,0 +1,7 @@
+flat in highp vec4 statistics;
+
+out highp vec4 tableEntry;
+
+void main() {
+  tableEntry = statistics;
+}
@@ -0,0 +1,28 @@
+uniform highp usampler2D objectIdTexture;
+uniform highp uint capacity;
+uniform highp ivec2 tableSize;
+uniform lowp int boundsPass;
+
+flat out highp vec4 statistics;
+
+void main() {
+  /* One point per pixel of the ObjectID, rows counted from the bottom */
+  highp ivec2 size = textureSize(objectIdTexture, 0);
+  highp ivec2 pixel = ivec2(gl_VertexID % size.x, gl_VertexID/size.x);
+  highp uint id = texelFetch(objectIdTexture, pixel, 0).r;
+
+  /* Added up, the pixel count. Blended with max, the extent of the pixels,
+     the minima counted down from the size so that all are maxima */
+  statistics = boundsPass != 0 ?
+    vec4(vec2(pixel + ivec2(1)), vec2(size - pixel)) : vec4(1.0);
+
+  /* The center of the texel of the ID in the table, outside of the clip
+     volume for IDs past its capacity */
+  if(id >= capacity) {
+    gl_Position = vec4(2.0, 2.0, 0.0, 1.0);
+  } else {
+    highp vec2 texel = vec2(float(id % TABLE_WIDTH),
+                            float(id/TABLE_WIDTH)) + vec2(0.5);
+    gl_Position = vec4(texel*2.0/vec2(tableSize) - vec2(1.0), 0.0, 1.0);
+  }
+}
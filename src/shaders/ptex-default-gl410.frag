@@ -182,8 +182,18 @@ uniform highp uint objectId;
 
 in vec2 uv;
 
+#if defined(GEOMETRY_SHADER)
+#define FACE_ID gl_PrimitiveID
+#elif defined(VERTEX_FACE_ID)
+flat in int faceId;
+#define FACE_ID faceId
+#else
+// each quad is drawn as two triangles
+#define FACE_ID (gl_PrimitiveID >> 1)
+#endif
+
 void main() {
-  vec4 c = textureAtlas(atlasTex, gl_PrimitiveID, uv * tileSize) * exposure;
+  vec4 c = textureAtlas(atlasTex, FACE_ID, uv * tileSize) * exposure;
 	applySaturation(c, saturation);
 	c.rgb = pow(c.rgb, vec3(gamma));
 	FragColor = vec4(c.rgb, 1.0f);
@@ -1,6 +1,25 @@
 layout(location = 0) in vec4 position;
 uniform mat4 MVP;
 
+#ifndef GEOMETRY_SHADER
+// the four vertices of each quad are consecutive, see
+// PTexMeshData::setFaceIdSource()
+out vec2 uv;
+#ifdef VERTEX_FACE_ID
+flat out int faceId;
+#endif
+#endif
+
 void main() {
   gl_Position = MVP * position;
+
+#ifndef GEOMETRY_SHADER
+  // the corners 0, 1, 2, 3 of a quad are at (0, 0), (1, 0), (1, 1), (0, 1),
+  // as in the geometry shader
+  int corner = gl_VertexID & 3;
+  uv = vec2(float(corner == 1 || corner == 2), float(corner >= 2));
+#ifdef VERTEX_FACE_ID
+  faceId = gl_VertexID >> 2;
+#endif
+#endif
 }
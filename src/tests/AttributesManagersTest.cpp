@@ -10,6 +10,7 @@
 #include "esp/metadata/managers/AttributesManagerBase.h"
 #include "esp/metadata/managers/ObjectAttributesManager.h"
 #include "esp/metadata/managers/PhysicsAttributesManager.h"
+#include "esp/metadata/managers/SceneAttributesManager.h"
 #include "esp/metadata/managers/StageAttributesManager.h"
 
 #include "configure.h"
@@ -31,6 +32,7 @@ using Attrs::CylinderPrimitiveAttributes;
 using Attrs::IcospherePrimitiveAttributes;
 using Attrs::ObjectAttributes;
 using Attrs::PhysicsManagerAttributes;
+using Attrs::SceneAttributes;
 using Attrs::StageAttributes;
 using Attrs::UVSpherePrimitiveAttributes;
 
@@ -47,6 +49,7 @@ class AttributesManagersTest : public testing::Test {
     objectAttributesManager_ = resourceManager_.getObjectAttributesManager();
     physicsAttributesManager_ = resourceManager_.getPhysicsAttributesManager();
     stageAttributesManager_ = resourceManager_.getStageAttributesManager();
+    sceneAttributesManager_ = resourceManager_.getSceneAttributesManager();
   };
 
   /**
@@ -112,12 +115,19 @@ class AttributesManagersTest : public testing::Test {
               attrTemplate2->getString(keyStr));
     // get original template ID
     int oldID = attrTemplate1->getID();
+    // share the registered template without copying it
+    auto sharedTemplate = mgr->getObjectSharedByHandle(handle);
+    ASSERT_NE(nullptr, sharedTemplate);
+    ASSERT_EQ(sharedTemplate->getID(), oldID);
 
     // register modified template and verify that this is the template now
     // stored
     int newID = mgr->registerObject(attrTemplate2, handle);
     // verify IDs are the same
     ASSERT_EQ(oldID, newID);
+    // verify registration replaced the shared template instead of modifying it
+    ASSERT_NE(sharedTemplate, mgr->getObjectSharedByHandle(handle));
+    ASSERT_EQ(sharedTemplate->hasValue(keyStr), false);
 
     // get another copy
     auto attrTemplate3 = mgr->getObjectCopyByHandle(handle);
@@ -360,6 +370,7 @@ class AttributesManagersTest : public testing::Test {
   AttrMgrs::ObjectAttributesManager::ptr objectAttributesManager_ = nullptr;
   AttrMgrs::PhysicsAttributesManager::ptr physicsAttributesManager_ = nullptr;
   AttrMgrs::StageAttributesManager::ptr stageAttributesManager_ = nullptr;
+  AttrMgrs::SceneAttributesManager::ptr sceneAttributesManager_ = nullptr;
 };  // class AttributesManagersTest
 
 /**
@@ -383,6 +394,17 @@ TEST_F(AttributesManagersTest, AttributesManagers_JSONLoadTest) {
   ASSERT_EQ(physMgrAttr->getSimulator(), "bullet_test");
   ASSERT_EQ(physMgrAttr->getFrictionCoefficient(), 1.4);
   ASSERT_EQ(physMgrAttr->getRestitutionCoefficient(), 1.1);
+  ASSERT_EQ(physMgrAttr->getNumThreads(), 3);
+  ASSERT_EQ(physMgrAttr->getTaskScheduler(), "openmp");
+  ASSERT_TRUE(physMgrAttr->getCacheStageBvh());
+  ASSERT_EQ(physMgrAttr->getBroadphase(), "sweep and prune");
+  ASSERT_EQ(physMgrAttr->getWorldBoundsPadding(), 2.5);
+  ASSERT_EQ(physMgrAttr->getSolverIterations(), 4);
+  ASSERT_EQ(physMgrAttr->getManifoldPoolSize(), 1024);
+  ASSERT_EQ(physMgrAttr->getCollisionAlgorithmPoolSize(), 2048);
+  ASSERT_EQ(physMgrAttr->getLinearSleepingThreshold(), 0.3);
+  ASSERT_EQ(physMgrAttr->getAngularSleepingThreshold(), 0.4);
+  ASSERT_EQ(physMgrAttr->getDeactivationTime(), 0.5);
 
   auto stageAttr =
       testBuildAttributesFromJSONString<AttrMgrs::StageAttributesManager,
@@ -433,6 +455,27 @@ TEST_F(AttributesManagersTest, AttributesManagers_JSONLoadTest) {
   ASSERT_EQ(objAttr->getJoinCollisionMeshes(), true);
   ASSERT_EQ(objAttr->getInertia(), Magnum::Vector3(1.1, 0.9, 0.3));
   ASSERT_EQ(objAttr->getCOM(), Magnum::Vector3(0.1, 0.2, 0.3));
+  ASSERT_EQ(objAttr->getLinearSleepingThreshold(), 0.6);
+  ASSERT_EQ(objAttr->getAngularSleepingThreshold(), 0.7);
+
+  auto sceneAttr =
+      testBuildAttributesFromJSONString<AttrMgrs::SceneAttributesManager,
+                                        SceneAttributes>(
+          sceneAttributesManager_);
+  // verify exists
+  ASSERT_NE(nullptr, sceneAttr);
+  // match values set in test JSON
+  ASSERT_EQ(sceneAttr->getLightSetup(), "test_lighting");
+  const auto& instances = sceneAttr->getObjectInstances();
+  ASSERT_EQ(instances.size(), 2u);
+  ASSERT_EQ(instances[0].templateHandle, "chair");
+  ASSERT_EQ(instances[0].translation, Magnum::Vector3(1, 2, 3));
+  ASSERT_EQ(instances[0].rotation, Magnum::Quaternion({1, 0, 0}, 0));
+  ASSERT_EQ(instances[0].motionType, "STATIC");
+  ASSERT_EQ(instances[1].templateHandle, "donut");
+  ASSERT_EQ(instances[1].translation, Magnum::Vector3(4, 5, 6));
+  ASSERT_EQ(instances[1].rotation, Magnum::Quaternion());
+  ASSERT_EQ(instances[1].motionType, "");
 
 }  // AttributesManagersTest::AttributesManagers_JSONLoadTest
 
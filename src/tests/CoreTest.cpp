@@ -4,8 +4,23 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "esp/core/Buffer.h"
+#include "esp/core/Compression.h"
 #include "esp/core/Configuration.h"
+#include "esp/core/HandleIndex.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/TaskScheduler.h"
 #include "esp/core/esp.h"
+#include "esp/core/random.h"
 
 using namespace esp::core;
 
@@ -17,4 +32,382 @@ TEST(CoreTest, ConfigurationTest) {
   EXPECT_TRUE(cfg.hasValue("myString"));
   EXPECT_EQ(cfg.get<int>("myInt"), 10);
   EXPECT_EQ(cfg.get<std::string>("myString"), "test");
+
+  // numbers convert between number types, the rest through strings
+  cfg.setDouble("myDouble", 2.5);
+  EXPECT_EQ(cfg.getInt("myDouble"), 2);
+  EXPECT_EQ(cfg.getDouble("myInt"), 10.0);
+  EXPECT_EQ(cfg.getString("myInt"), "10");
+  cfg.setString("myNumberString", "1.5");
+  EXPECT_EQ(cfg.getDouble("myNumberString"), 1.5);
+  cfg.setVec3("myVec3", Magnum::Vector3{1.0f, 2.0f, 3.0f});
+  EXPECT_EQ(cfg.getVec3("myVec3"), (Magnum::Vector3{1.0f, 2.0f, 3.0f}));
+
+  // an interned key reads the same value, missing values are defaulted
+  const ConfigKey key{"myDouble"};
+  EXPECT_EQ(key.name(), "myDouble");
+  EXPECT_EQ(ConfigKey::find("myDouble"), key.id());
+  EXPECT_EQ(cfg.getDouble(key), 2.5);
+  EXPECT_EQ(Configuration{}.getDouble(key), 0.0);
+  EXPECT_FALSE(cfg.hasValue("missing"));
+  EXPECT_EQ(cfg.getString("missing"), "");
+  EXPECT_EQ(cfg.getVec3("missing"), Magnum::Vector3{});
+
+  // a single value becomes the first one of a group
+  EXPECT_EQ(cfg.addStringToGroup("myString", "second"), 2);
+  EXPECT_EQ(cfg.getStringGroup("myString"),
+            (std::vector<std::string>{"test", "second"}));
+  EXPECT_EQ(cfg.getString("myString"), "test");
+  EXPECT_TRUE(cfg.removeValue("myString"));
+  EXPECT_EQ(cfg.getStringGroup("myString"),
+            std::vector<std::string>{"second"});
+  EXPECT_TRUE(cfg.removeValue("myString"));
+  EXPECT_FALSE(cfg.hasValue("myString"));
+  EXPECT_FALSE(cfg.removeValue("myString"));
+
+  const Corrade::Utility::ConfigurationGroup group =
+      cfg.getConfigurationGroup();
+  EXPECT_EQ(group.value<int>("myInt"), 10);
+  EXPECT_EQ(group.value<double>("myDouble"), 2.5);
+  EXPECT_EQ(group.value<Magnum::Vector3>("myVec3"),
+            (Magnum::Vector3{1.0f, 2.0f, 3.0f}));
+  EXPECT_FALSE(group.hasValue("myString"));
+}
+
+TEST(CoreTest, RandomTest) {
+  Random random{7};
+  std::vector<uint32_t> sequence;
+  for (int i = 0; i < 10; ++i) {
+    sequence.push_back(random.uniform_uint());
+  }
+  random.seed(7);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(random.uniform_uint(), sequence[i]);
+  }
+
+  // streams are independent of each other and of the order of use
+  Random stream = random.stream(1);
+  EXPECT_EQ(stream.getStream(), 1u);
+  EXPECT_NE(stream.uniform_uint(), sequence[0]);
+  EXPECT_EQ(Random(7, 1).uniform_uint(), random.stream(1).uniform_uint());
+
+  // bulk sampling draws the same numbers as one at a time
+  Random single{3};
+  Random bulk{3};
+  bulk.uniform_uint();
+  single.uniform_uint();
+  std::vector<float> floats(11);
+  bulk.fill_uniform_float_01(floats.data(), floats.size());
+  for (float value : floats) {
+    EXPECT_EQ(value, single.uniform_float_01());
+    EXPECT_GE(value, 0.0f);
+    EXPECT_LT(value, 1.0f);
+  }
+  EXPECT_EQ(bulk.uniform_uint(), single.uniform_uint());
+
+  for (int i = 0; i < 100; ++i) {
+    const int value = random.uniform_int(-2, 3);
+    EXPECT_GE(value, -2);
+    EXPECT_LT(value, 3);
+    EXPECT_TRUE(std::isfinite(random.normal_float_01()));
+  }
+}
+
+TEST(CoreTest, ExternalBufferTest) {
+  std::vector<float> memory(2 * 3, 1.0f);
+  {
+    Buffer buffer{memory.data(), {2, 3}, DataType::DT_FLOAT};
+    EXPECT_TRUE(buffer.isExternal());
+    EXPECT_EQ(buffer.totalSize, 6);
+    EXPECT_EQ(buffer.data.size(), 6 * sizeof(float));
+    EXPECT_EQ(static_cast<void*>(buffer.data.data()), memory.data());
+
+    buffer.clear();
+  }
+  // the memory is cleared through the buffer but survives its destruction
+  EXPECT_EQ(memory, std::vector<float>(2 * 3, 0.0f));
+
+  Buffer owning{{2, 3}, DataType::DT_FLOAT};
+  EXPECT_FALSE(owning.isExternal());
+}
+
+TEST(CoreTest, PooledBufferTest) {
+  EXPECT_EQ(BufferPool::sizeClass(1), 64u);
+  EXPECT_EQ(BufferPool::sizeClass(64), 64u);
+  EXPECT_EQ(BufferPool::sizeClass(65), 128u);
+  EXPECT_EQ(BufferPool::sizeClass(640 * 480 * 4), 1280u * 1024u);
+  BufferPool::trim();
+
+  const uint8_t* memory = nullptr;
+  {
+    Buffer buffer{{480, 640, 4}, DataType::DT_UINT8};
+    EXPECT_FALSE(buffer.isExternal());
+    EXPECT_EQ(buffer.data.size(), 480u * 640u * 4u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data.data()) %
+                  BufferPool::Alignment,
+              0u);
+    memory = buffer.data.data();
+    buffer.data[0] = 1;
+  }
+  EXPECT_EQ(BufferPool::cachedBytes(), BufferPool::sizeClass(480 * 640 * 4));
+
+  // a buffer of the same size class reuses the memory, zeroed
+  Buffer reused{{480, 640}, DataType::DT_FLOAT};
+  EXPECT_EQ(reused.data.data(), memory);
+  EXPECT_EQ(reused.data[0], 0);
+  EXPECT_EQ(BufferPool::cachedBytes(), 0u);
+
+  Buffer pinned{{16}, DataType::DT_FLOAT, /*pinned=*/true};
+  EXPECT_EQ(pinned.data.size(), 16u * sizeof(float));
+#ifndef ESP_BUILD_WITH_CUDA
+  EXPECT_FALSE(pinned.isPinned());
+#endif
+
+  BufferPool::setMaxCachedBytes(0);
+  reused.data = Corrade::Containers::Array<uint8_t>{};
+  EXPECT_EQ(BufferPool::cachedBytes(), 0u);
+  BufferPool::setMaxCachedBytes(size_t{1} << 30);
+}
+
+TEST(CoreTest, CompressionTest) {
+  // runs, a repeated pattern and noise
+  std::vector<unsigned char> data(100000, 7);
+  for (size_t i = 20000; i < 40000; ++i) {
+    data[i] = i % 13;
+  }
+  uint32_t state = 1;
+  for (size_t i = 60000; i < 70000; ++i) {
+    state = state * 1664525u + 1013904223u;
+    data[i] = state >> 24;
+  }
+  const std::vector<unsigned char> compressed =
+      compressBytes(data.data(), data.size());
+  EXPECT_LT(compressed.size(), data.size() / 4);
+
+  std::vector<unsigned char> decompressed(data.size());
+  EXPECT_TRUE(decompressBytes(compressed.data(), compressed.size(),
+                              decompressed.data(), decompressed.size()));
+  EXPECT_EQ(decompressed, data);
+
+  // a wrong size or truncated input
+  EXPECT_FALSE(decompressBytes(compressed.data(), compressed.size(),
+                               decompressed.data(), decompressed.size() - 1));
+  EXPECT_FALSE(decompressBytes(compressed.data(), compressed.size() / 2,
+                               decompressed.data(), decompressed.size()));
+
+  const std::vector<unsigned char> empty = compressBytes(data.data(), 0);
+  EXPECT_TRUE(
+      decompressBytes(empty.data(), empty.size(), decompressed.data(), 0));
+}
+
+TEST(CoreTest, ProfilerTest) {
+  Profiler::reset();
+  Profiler::setEnabled(false);
+  {
+    ScopedTimer timer{ProfilingStage::Physics};
+    Profiler::increment(ProfilingCounter::DrawCalls, 3);
+  }
+  // nothing is collected while disabled
+  EXPECT_EQ(Profiler::stats().physics.calls, 0u);
+  EXPECT_EQ(Profiler::stats().drawCalls, 0u);
+
+  Profiler::setEnabled(true);
+  for (int i = 0; i < 2; ++i) {
+    ScopedTimer timer{ProfilingStage::Physics};
+    Profiler::increment(ProfilingCounter::DrawCalls, 3);
+  }
+  Profiler::increment(ProfilingCounter::DrawablesCulled);
+  Profiler::addGpuTime(ProfilingStage::Drawing, 1.5);
+  Profiler::setEnabled(false);
+
+  const ProfilingStats& stats = Profiler::stats();
+  EXPECT_EQ(stats.physics.calls, 2u);
+  EXPECT_GE(stats.physics.cpuTimeMs, 0.0);
+  EXPECT_EQ(stats.timing(ProfilingStage::Physics).calls, 2u);
+  EXPECT_EQ(stats.drawing.calls, 0u);
+  EXPECT_DOUBLE_EQ(stats.drawing.gpuTimeMs, 1.5);
+  EXPECT_EQ(stats.drawCalls, 6u);
+  EXPECT_EQ(stats.counter(ProfilingCounter::DrawablesCulled), 1u);
+
+  Profiler::reset();
+  EXPECT_EQ(Profiler::stats().physics.calls, 0u);
+  EXPECT_EQ(Profiler::stats().drawCalls, 0u);
+
+  // the counts of other threads, ended or not, are summed up
+  Profiler::setEnabled(true);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([]() {
+      for (int j = 0; j < 1000; ++j) {
+        Profiler::increment(ProfilingCounter::DrawCalls);
+      }
+    });
+  }
+  Profiler::increment(ProfilingCounter::DrawCalls);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  Profiler::setEnabled(false);
+  EXPECT_EQ(Profiler::stats().drawCalls, 4001u);
+  Profiler::reset();
+  EXPECT_EQ(Profiler::stats().drawCalls, 0u);
+}
+
+TEST(CoreTest, TracerTest) {
+  Profiler::setEnabled(false);
+  {
+    ScopedTraceEvent event{"untraced", "test"};
+  }
+  Tracer::start();
+  EXPECT_TRUE(Tracer::isTracing());
+  EXPECT_EQ(Tracer::numEvents(), 0u);
+  {
+    // traced whether or not the profiler is enabled
+    ScopedTimer timer{ProfilingStage::Physics};
+    ScopedTraceEvent event{"mainThreadEvent", "test"};
+  }
+  int workerTrack = -1;
+  std::thread worker{[&]() {
+    ScopedTraceEvent event{"workerEvent", "test"};
+    workerTrack = Tracer::currentThreadTrack();
+  }};
+  worker.join();
+  EXPECT_EQ(Tracer::numEvents(), 3u);
+  EXPECT_NE(workerTrack, Tracer::currentThreadTrack());
+  EXPECT_NE(workerTrack, Tracer::GpuTrack);
+
+  const std::string filename = "CoreTest_TracerTest.json";
+  EXPECT_TRUE(Tracer::stop(filename));
+  EXPECT_FALSE(Tracer::isTracing());
+  EXPECT_EQ(Profiler::stats().physics.calls, 0u);
+  std::stringstream trace;
+  trace << std::ifstream{filename}.rdbuf();
+  std::remove(filename.c_str());
+  EXPECT_EQ(trace.str().find("{\"traceEvents\":["), 0u);
+  EXPECT_NE(trace.str().find("\"name\":\"Physics\""), std::string::npos);
+  EXPECT_NE(trace.str().find("\"name\":\"mainThreadEvent\""),
+            std::string::npos);
+  EXPECT_NE(trace.str().find("\"name\":\"workerEvent\""),
+            std::string::npos);
+  EXPECT_EQ(trace.str().find("untraced"), std::string::npos);
+}
+
+TEST(CoreTest, HandleIndexTest) {
+  HandleIndex index;
+  EXPECT_TRUE(index.emplace(3, "data/objects/Chair_01.json"));
+  EXPECT_TRUE(index.emplace(1, "data/objects/table.json"));
+  EXPECT_TRUE(index.emplace(7, "data/objects/chairBlue.json"));
+  EXPECT_TRUE(index.emplace(5, "cubeSolid"));
+  // an existing id keeps its handle, as with std::map::emplace()
+  EXPECT_FALSE(index.emplace(1, "other"));
+  EXPECT_EQ(index.size(), 4u);
+  EXPECT_EQ(index.at(1), "data/objects/table.json");
+
+  // case-insensitive, ordered by id, through the trigram index and without
+  using Handles = std::vector<std::string>;
+  EXPECT_EQ(index.handlesBySubstring("CHAIR", true),
+            (Handles{"data/objects/Chair_01.json",
+                     "data/objects/chairBlue.json"}));
+  EXPECT_EQ(index.handlesBySubstring("chair", false),
+            (Handles{"data/objects/table.json", "cubeSolid"}));
+  EXPECT_EQ(index.handlesBySubstring("ub", true), (Handles{"cubeSolid"}));
+  EXPECT_EQ(index.handlesBySubstring("sofa", true), Handles{});
+  EXPECT_EQ(index.handlesBySubstring("sofa", false).size(), 4u);
+  EXPECT_EQ(index.handlesBySubstring("", false).size(), 4u);
+
+  // removal moves the last handle into the freed slot
+  EXPECT_EQ(index.erase(3), 1u);
+  EXPECT_EQ(index.erase(3), 0u);
+  EXPECT_EQ(index.count(3), 0u);
+  EXPECT_EQ(index.at(5), "cubeSolid");
+  EXPECT_EQ(index.handlesBySubstring("chair", true),
+            (Handles{"data/objects/chairBlue.json"}));
+
+  // sampling is reproducible for a seed and covers all handles
+  esp::core::Random random{0};
+  std::vector<std::string> samples;
+  for (int i = 0; i < 100; ++i) {
+    samples.push_back(index.randomHandle(random));
+  }
+  random.seed(0);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(index.randomHandle(random), samples[i]);
+  }
+  for (const std::string& handle : index.handlesBySubstring("", true)) {
+    EXPECT_NE(std::find(samples.begin(), samples.end(), handle),
+              samples.end());
+  }
+
+  index.clear();
+  EXPECT_EQ(index.size(), 0u);
+  EXPECT_EQ(index.handlesBySubstring("chair", true), Handles{});
+}
+
+TEST(CoreTest, TaskSchedulerTest) {
+  TaskScheduler scheduler{4};
+  EXPECT_EQ(scheduler.numThreads(), 4);
+  EXPECT_EQ(scheduler.concurrency(2), 2);
+  EXPECT_EQ(scheduler.concurrency(100, 3), 3);
+
+  // every item once, on thread indices below the concurrency, with loops
+  // nested in the items
+  std::vector<std::atomic<int>> hits(1000);
+  std::atomic<int> badThreadIndices{0};
+  std::atomic<int> nestedItems{0};
+  scheduler.parallelFor(hits.size(), 0, [&](size_t i, int threadIndex) {
+    ++hits[i];
+    if (threadIndex < 0 || threadIndex >= 4) {
+      ++badThreadIndices;
+    }
+    if (i % 100 == 0) {
+      scheduler.parallelFor(10, 0, [&](size_t, int) { ++nestedItems; });
+    }
+  });
+  for (const std::atomic<int>& hit : hits) {
+    EXPECT_EQ(hit, 1);
+  }
+  EXPECT_EQ(badThreadIndices, 0);
+  EXPECT_EQ(nestedItems, 100);
+
+  std::vector<int> covered(777, 0);
+  scheduler.parallelForRanges(covered.size(), 3, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ++covered[i];
+    }
+  });
+  EXPECT_EQ(std::count(covered.begin(), covered.end(), 1), 777);
+
+  // tasks run after their dependencies, and can add more tasks
+  std::mutex mutex;
+  std::vector<int> order;
+  auto record = [&](int task) {
+    std::lock_guard<std::mutex> lock{mutex};
+    order.push_back(task);
+  };
+  std::atomic<int> numRun{0};
+  {
+    TaskGroup group{scheduler};
+    const TaskGroup::TaskId first = group.add([&]() { record(0); });
+    const TaskGroup::TaskId second =
+        group.add([&]() { record(1); }, {first});
+    group.add([&]() { record(2); }, {first, second});
+    for (int i = 0; i < 20; ++i) {
+      group.add([&]() {
+        ++numRun;
+        group.add([&]() { ++numRun; });
+      });
+    }
+    group.wait();
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+  }
+  EXPECT_EQ(numRun, 40);
+
+  // without workers everything runs on the calling thread
+  TaskScheduler serial{1};
+  int numItems = 0;
+  serial.parallelFor(10, 0, [&](size_t, int threadIndex) {
+    EXPECT_EQ(threadIndex, 0);
+    ++numItems;
+  });
+  EXPECT_EQ(numItems, 10);
 }
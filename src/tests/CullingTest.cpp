@@ -2,6 +2,7 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 //
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/Optional.h>
 #include <Corrade/TestSuite/Compare/Numeric.h>
 #include <Corrade/TestSuite/Tester.h>
@@ -12,9 +13,13 @@
 #include <Magnum/Math/Intersection.h>
 #include <Magnum/Math/Range.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <string>
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/CullingBVH.h"
+#include "esp/gfx/MultiFrustumCulling.h"
+#include "esp/gfx/PotentiallyVisibleSet.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/WindowlessContext.h"
@@ -37,15 +42,60 @@ struct CullingTest : Cr::TestSuite::Tester {
   // tests
   void computeAbsoluteAABB();
   void frustumCulling();
+  void cullingBVH();
+  void cullingBVHOverlap();
+  void dynamicWorldAABB();
+  void potentiallyVisibleSet();
+  void multiFrustumCulling();
+
+  // benchmarks
+  void cullLinearBenchmark();
+  void cullBVHBenchmark();
+  void cullMultiFrustumBenchmark();
 };
 
 CullingTest::CullingTest() {
   // clang-format off
   addTests({&CullingTest::computeAbsoluteAABB,
-            &CullingTest::frustumCulling});
+            &CullingTest::frustumCulling,
+            &CullingTest::cullingBVH,
+            &CullingTest::cullingBVHOverlap,
+            &CullingTest::dynamicWorldAABB,
+            &CullingTest::potentiallyVisibleSet,
+            &CullingTest::multiFrustumCulling});
+
+  addBenchmarks({&CullingTest::cullLinearBenchmark,
+                 &CullingTest::cullBVHBenchmark,
+                 &CullingTest::cullMultiFrustumBenchmark}, 10);
   // clang-format on
 }
 
+// a scene of many small boxes, similar to a large scan split by object id
+std::vector<Mn::Range3D> gridOfBoxes() {
+  std::vector<Mn::Range3D> boxes;
+  for (int x = -50; x < 50; ++x) {
+    for (int z = -50; z < 50; ++z) {
+      for (int y = 0; y < 3; ++y) {
+        const Mn::Vector3 min{2.0f * x, 2.0f * y, 2.0f * z};
+        boxes.emplace_back(min, min + Mn::Vector3{0.5f + 0.01f * (x & 7)});
+      }
+    }
+  }
+  return boxes;
+}
+
+// a camera which sees a part of gridOfBoxes()
+Mn::Frustum gridCameraFrustum(float yaw) {
+  const Mn::Matrix4 camera =
+      Mn::Matrix4::translation({0.0f, 1.5f, 0.0f}) *
+      Mn::Matrix4::rotationY(Mn::Deg{yaw}) *
+      Mn::Matrix4::rotationX(Mn::Deg{-10.0f});
+  return Mn::Frustum::fromMatrix(
+      Mn::Matrix4::perspectiveProjection(Mn::Deg{90.0f}, 4.0f / 3.0f, 0.01f,
+                                         40.0f) *
+      camera.invertedRigid());
+}
+
 void CullingTest::computeAbsoluteAABB() {
   // must create a GL context which will be used in the resource manager
   esp::gfx::WindowlessContext::uptr context_ =
@@ -269,6 +319,275 @@ void CullingTest::frustumCulling() {
   target->renderExit();
   CORRADE_COMPARE(numVisibleObjects, numVisibleObjectsGroundTruth);
 }
+
+void CullingTest::cullingBVH() {
+  const std::vector<Mn::Range3D> boxes = gridOfBoxes();
+  esp::gfx::CullingBVH bvh{boxes};
+  CORRADE_COMPARE(bvh.size(), boxes.size());
+  CORRADE_COMPARE(bvh.bounds().min(), (Mn::Vector3{-100.0f, 0.0f, -100.0f}));
+
+  // query a couple of times from different directions, so that temporal
+  // coherence has to deal with changed culling planes
+  for (float yaw : {0.0f, 45.0f, 170.0f, 0.0f}) {
+    CORRADE_ITERATION(yaw);
+    const Mn::Frustum frustum = gridCameraFrustum(yaw);
+
+    std::vector<uint32_t> visible;
+    const size_t numVisible = bvh.cull(frustum, visible);
+    CORRADE_COMPARE(numVisible, visible.size());
+    std::sort(visible.begin(), visible.end());
+
+    // ground truth: brute force test of every box
+    std::vector<uint32_t> groundTruth;
+    for (uint32_t iBox = 0; iBox < boxes.size(); ++iBox) {
+      if (Mn::Math::Intersection::rangeFrustum(boxes[iBox], frustum)) {
+        groundTruth.push_back(iBox);
+      }
+    }
+    CORRADE_VERIFY(!groundTruth.empty());
+    CORRADE_VERIFY(groundTruth.size() < boxes.size());
+    CORRADE_VERIFY(visible == groundTruth);
+  }
+
+  // an empty hierarchy culls nothing
+  esp::gfx::CullingBVH empty;
+  std::vector<uint32_t> visible;
+  CORRADE_VERIFY(!empty.cull(gridCameraFrustum(0.0f), visible));
+  CORRADE_VERIFY(visible.empty());
+}
+
+void CullingTest::cullingBVHOverlap() {
+  const std::vector<Mn::Range3D> boxes = gridOfBoxes();
+  const esp::gfx::CullingBVH bvh{boxes};
+
+  for (const Mn::Range3D& range :
+       {Mn::Range3D{{-3.0f, 0.0f, -3.0f}, {3.0f, 1.0f, 3.0f}},
+        Mn::Range3D{{10.25f, 2.0f, 4.0f}, {10.25f, 2.0f, 4.0f}},
+        Mn::Range3D{{-40.0f, -1.0f, 20.0f}, {-20.0f, 5.0f, 50.0f}}}) {
+    CORRADE_ITERATION(range);
+    std::vector<uint32_t> items;
+    const size_t numItems = bvh.overlap(range, items);
+    CORRADE_COMPARE(numItems, items.size());
+    std::sort(items.begin(), items.end());
+
+    // ground truth: brute force test of every box, touching counts
+    std::vector<uint32_t> groundTruth;
+    for (uint32_t iBox = 0; iBox < boxes.size(); ++iBox) {
+      if ((boxes[iBox].min() <= range.max()).all() &&
+          (range.min() <= boxes[iBox].max()).all()) {
+        groundTruth.push_back(iBox);
+      }
+    }
+    CORRADE_VERIFY(!groundTruth.empty());
+    CORRADE_VERIFY(items == groundTruth);
+  }
+
+  // a box in the gaps between the boxes overlaps none
+  std::vector<uint32_t> items;
+  CORRADE_VERIFY(!bvh.overlap(
+      Mn::Range3D{{1.0f, 0.0f, 1.0f}, {1.5f, 10.0f, 1.5f}}, items));
+  CORRADE_VERIFY(items.empty());
+}
+
+void CullingTest::dynamicWorldAABB() {
+  esp::scene::SceneGraph sceneGraph;
+  esp::scene::SceneNode& root = sceneGraph.getRootNode();
+  esp::scene::SceneNode& object = root.createChild();
+  esp::scene::SceneNode& mesh = object.createChild();
+  const Mn::Range3D unitBox{Mn::Vector3{-1.0f}, Mn::Vector3{1.0f}};
+  mesh.setMeshBB(unitBox);
+  mesh.translate({0.0f, 1.0f, 0.0f});
+  object.translate({2.0f, 0.0f, 0.0f});
+
+  // a node without a mesh bounding box can't be culled
+  CORRADE_VERIFY(!object.getWorldAABB());
+  CORRADE_COMPARE(*mesh.getWorldAABB(),
+                  (Mn::Range3D{{1.0f, 0.0f, -1.0f}, {3.0f, 2.0f, 1.0f}}));
+  CORRADE_COMPARE(root.computeCumulativeBB().max(),
+                  (Mn::Vector3{3.0f, 2.0f, 1.0f}));
+  CORRADE_COMPARE(root.computeCumulativeBB().min().z(), -1.0f);
+
+  // moving an ancestor updates the cached boxes of the whole subtree
+  for (int i = 0; i != 2; ++i) {
+    CORRADE_ITERATION(i);
+    object.translate({0.0f, 0.0f, -4.0f});
+    const float z = -4.0f * (i + 1);
+    CORRADE_COMPARE(
+        *mesh.getWorldAABB(),
+        (Mn::Range3D{{1.0f, 0.0f, z - 1.0f}, {3.0f, 2.0f, z + 1.0f}}));
+    CORRADE_COMPARE(root.computeCumulativeBB().min().z(), z - 1.0f);
+  }
+
+  // so does a new mesh bounding box, a new and a destroyed node
+  mesh.setMeshBB(unitBox.scaled(Mn::Vector3{2.0f}));
+  CORRADE_COMPARE(mesh.getWorldAABB()->size(), Mn::Vector3{4.0f});
+  CORRADE_COMPARE(root.computeCumulativeBB().min().z(), -10.0f);
+  esp::scene::SceneNode& farAway = mesh.createChild();
+  farAway.setMeshBB(unitBox);
+  farAway.translate({0.0f, 0.0f, -100.0f});
+  CORRADE_COMPARE(root.computeCumulativeBB().min().z(), -109.0f);
+  delete &farAway;
+  CORRADE_COMPARE(root.computeCumulativeBB().min().z(), -10.0f);
+
+  // and that a static mesh has an absolute AABB
+  mesh.setAbsoluteAABB(unitBox);
+  CORRADE_COMPARE(*mesh.getWorldAABB(), unitBox);
+}
+
+// the two triangles of a rectangle with the corners a, b and c, b + c - a
+void addQuad(std::vector<Mn::Vector3>& triangles,
+             const Mn::Vector3& a,
+             const Mn::Vector3& b,
+             const Mn::Vector3& c) {
+  const Mn::Vector3 d = b + c - a;
+  triangles.insert(triangles.end(), {a, b, c, c, b, d});
+}
+
+void CullingTest::potentiallyVisibleSet() {
+  using esp::gfx::PotentiallyVisibleSet;
+  // two rooms split by a wall higher than the views, each with a back wall
+  std::vector<std::vector<Mn::Vector3>> items(4);
+  addQuad(items[0], {-10.0f, 0.0f, -10.0f}, {10.0f, 0.0f, -10.0f},
+          {-10.0f, 0.0f, 10.0f});
+  addQuad(items[1], {0.0f, 0.0f, -10.0f}, {0.0f, 5.0f, -10.0f},
+          {0.0f, 0.0f, 10.0f});
+  addQuad(items[2], {-10.0f, 0.0f, -9.5f}, {0.0f, 0.0f, -9.5f},
+          {-10.0f, 3.0f, -9.5f});
+  addQuad(items[3], {0.0f, 0.0f, -9.5f}, {10.0f, 0.0f, -9.5f},
+          {0.0f, 3.0f, -9.5f});
+
+  // navigable points in the left room only
+  std::vector<Mn::Vector3> navigablePoints;
+  for (float x = -8.75f; x < -1.0f; x += 0.5f) {
+    for (float z = -8.75f; z < 9.0f; z += 0.5f) {
+      navigablePoints.emplace_back(x, 0.0f, z);
+    }
+  }
+  PotentiallyVisibleSet::Configuration configuration;
+  configuration.cellSize = 2.0f;
+  configuration.raysPerView = 256;
+  const PotentiallyVisibleSet set = PotentiallyVisibleSet::compute(
+      items, navigablePoints, configuration);
+  CORRADE_COMPARE(set.numItems(), 4u);
+  CORRADE_COMPARE(set.numCells(), size_t{5 * 10});
+
+  for (uint32_t cell = 0; cell < set.numCells(); ++cell) {
+    CORRADE_ITERATION(cell);
+    CORRADE_VERIFY(set.isVisible(cell, 0));
+    CORRADE_VERIFY(set.isVisible(cell, 1));
+    CORRADE_VERIFY(set.isVisible(cell, 2));
+    // hidden behind the wall between the rooms
+    CORRADE_VERIFY(!set.isVisible(cell, 3));
+    CORRADE_COMPARE(set.numVisible(cell), 3u);
+  }
+
+  // a view belongs to the cell of the ground below it
+  const uint32_t cell = set.findCell({-5.0f, 1.5f, 3.0f});
+  CORRADE_VERIFY(cell != PotentiallyVisibleSet::NoCell);
+  CORRADE_COMPARE(set.findCell({-4.5f, 0.1f, 2.5f}), cell);
+  CORRADE_COMPARE(set.findCell({-5.0f, 5.0f, 3.0f}),
+                  PotentiallyVisibleSet::NoCell);
+  CORRADE_COMPARE(set.findCell({5.0f, 1.5f, 3.0f}),
+                  PotentiallyVisibleSet::NoCell);
+
+  // and it reads back the same
+  const std::string file =
+      Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(), "test.pvs");
+  CORRADE_VERIFY(set.save(file));
+  PotentiallyVisibleSet loaded;
+  CORRADE_VERIFY(loaded.load(file));
+  Cr::Utility::Directory::rm(file);
+  CORRADE_COMPARE(loaded.numItems(), set.numItems());
+  CORRADE_COMPARE(loaded.numCells(), set.numCells());
+  CORRADE_COMPARE(loaded.findCell({-5.0f, 1.5f, 3.0f}), cell);
+  for (uint32_t item = 0; item < set.numItems(); ++item) {
+    CORRADE_COMPARE(loaded.isVisible(cell, item), set.isVisible(cell, item));
+  }
+  CORRADE_VERIFY(!loaded.load(file));
+  CORRADE_COMPARE(loaded.numCells(), size_t{0});
+}
+
+void CullingTest::multiFrustumCulling() {
+  // not a multiple of the lanes, so that the last block is partial
+  std::vector<Mn::Range3D> boxes = gridOfBoxes();
+  boxes.pop_back();
+  esp::gfx::MultiFrustumCulling culling;
+  culling.build(boxes);
+  CORRADE_COMPARE(culling.size(), boxes.size());
+
+  std::vector<Mn::Frustum> frustums;
+  for (float yaw : {0.0f, 45.0f, 170.0f, 300.0f}) {
+    frustums.push_back(gridCameraFrustum(yaw));
+  }
+  std::vector<uint64_t> masks;
+  culling.cull(frustums, masks);
+  CORRADE_COMPARE(masks.size(), boxes.size());
+
+  // ground truth: brute force test of every box against every frustum
+  for (size_t f = 0; f < frustums.size(); ++f) {
+    CORRADE_ITERATION(f);
+    size_t numVisible = 0;
+    for (size_t iBox = 0; iBox < boxes.size(); ++iBox) {
+      const bool visible =
+          Mn::Math::Intersection::rangeFrustum(boxes[iBox], frustums[f]);
+      numVisible += visible;
+      CORRADE_COMPARE(bool(masks[iBox] & (uint64_t{1} << f)), visible);
+    }
+    CORRADE_VERIFY(numVisible);
+    CORRADE_VERIFY(numVisible < boxes.size());
+  }
+  // no bits past the frustums
+  for (uint64_t mask : masks) {
+    CORRADE_COMPARE(mask >> frustums.size(), uint64_t{0});
+  }
+
+  // without boxes there is nothing to cull
+  esp::gfx::MultiFrustumCulling empty;
+  empty.build({});
+  empty.cull(frustums, masks);
+  CORRADE_VERIFY(masks.empty());
+}
+
+void CullingTest::cullLinearBenchmark() {
+  const std::vector<Mn::Range3D> boxes = gridOfBoxes();
+  const Mn::Frustum frustum = gridCameraFrustum(30.0f);
+
+  size_t numVisible = 0;
+  CORRADE_BENCHMARK(10) {
+    for (const Mn::Range3D& box : boxes) {
+      numVisible += Mn::Math::Intersection::rangeFrustum(box, frustum);
+    }
+  }
+  CORRADE_VERIFY(numVisible);
+}
+
+void CullingTest::cullBVHBenchmark() {
+  esp::gfx::CullingBVH bvh{gridOfBoxes()};
+  const Mn::Frustum frustum = gridCameraFrustum(30.0f);
+
+  std::vector<uint32_t> visible;
+  visible.reserve(bvh.size());
+  size_t numVisible = 0;
+  CORRADE_BENCHMARK(10) {
+    visible.clear();
+    numVisible += bvh.cull(frustum, visible);
+  }
+  CORRADE_VERIFY(numVisible);
+}
+
+void CullingTest::cullMultiFrustumBenchmark() {
+  // the boxes against the frustums of eight sensors in one sweep
+  esp::gfx::MultiFrustumCulling culling;
+  culling.build(gridOfBoxes());
+  std::vector<Mn::Frustum> frustums;
+  for (int i = 0; i < 8; ++i) {
+    frustums.push_back(gridCameraFrustum(45.0f * i));
+  }
+
+  std::vector<uint64_t> masks;
+  CORRADE_BENCHMARK(10) { culling.cull(frustums, masks); }
+  CORRADE_COMPARE(masks.size(), culling.size());
+}
 }  // namespace
 }  // namespace Test
 
@@ -2,6 +2,8 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <cstdint>
+
 #include <Corrade/TestSuite/Tester.h>
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/GL/Mesh.h>
@@ -10,7 +12,12 @@
 #include <Magnum/Shaders/Flat.h>
 #include <Magnum/Trade/MeshData.h>
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/FrameArena.h"
 #include "esp/gfx/GenericDrawable.h"
+#include "esp/gfx/PhongUniformCache.h"
+#include "esp/gfx/RenderCamera.h"
+#include "esp/gfx/RenderList.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/WindowlessContext.h"
 #include "esp/scene/SceneManager.h"
@@ -38,6 +45,11 @@ struct DrawableTest : Cr::TestSuite::Tester {
   explicit DrawableTest();
   // tests
   void addRemoveDrawables();
+  void sortByDrawState();
+  void renderList();
+  void phongUniformCache();
+  void renderQuality();
+  void frameArena();
 
  protected:
   esp::gfx::WindowlessContext::uptr context_ =
@@ -53,7 +65,12 @@ struct DrawableTest : Cr::TestSuite::Tester {
 DrawableTest::DrawableTest() {
   resourceManager_ = std::make_unique<ResourceManagerExtended>();
   //clang-format off
-  addTests({&DrawableTest::addRemoveDrawables});
+  addTests({&DrawableTest::addRemoveDrawables,
+            &DrawableTest::sortByDrawState,
+            &DrawableTest::renderList,
+            &DrawableTest::phongUniformCache,
+            &DrawableTest::renderQuality,
+            &DrawableTest::frameArena});
   // flang-format on
   auto stageAttributesMgr = resourceManager_->getStageAttributesManager();
   std::string stageFile =
@@ -143,6 +160,218 @@ void DrawableTest::addRemoveDrawables() {
   CORRADE_VERIFY(!drawableGroup_->hasDrawable(dr->getDrawableId()));
 }
 
+void DrawableTest::sortByDrawState() {
+  Mn::GL::Mesh box = Mn::MeshTools::compile(Mn::Primitives::cubeSolidStrip());
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID_);
+  esp::scene::SceneNode& node = sceneGraph.getRootNode().createChild();
+
+  // interleave drawables with another material and mesh with the scene ones
+  node.addFeature<esp::gfx::GenericDrawable>(
+      box, resourceManager_->getShaderManager(),
+      esp::assets::ResourceManager::NO_LIGHT_KEY,
+      esp::assets::ResourceManager::PER_VERTEX_OBJECT_ID_MATERIAL_KEY,
+      drawableGroup_);
+
+  esp::gfx::RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+  auto checkSorted = [&]() {
+    auto drawableTransforms = camera.drawableTransformations(*drawableGroup_);
+    CORRADE_COMPARE(drawableTransforms.size(), drawableGroup_->size());
+    drawableGroup_->sortByDrawState(drawableTransforms);
+    for (size_t i = 1; i < drawableTransforms.size(); ++i) {
+      CORRADE_ITERATION(i);
+      auto& previous = static_cast<esp::gfx::Drawable&>(
+          drawableTransforms[i - 1].first.get());
+      auto& current =
+          static_cast<esp::gfx::Drawable&>(drawableTransforms[i].first.get());
+      CORRADE_VERIFY(previous.getDrawOrder() < current.getDrawOrder());
+      CORRADE_VERIFY(!(current.getDrawState() < previous.getDrawState()));
+    }
+  };
+  checkSorted();
+
+  // adding a drawable invalidates the cached order
+  node.addFeature<esp::gfx::GenericDrawable>(
+      box, resourceManager_->getShaderManager(),
+      esp::assets::ResourceManager::NO_LIGHT_KEY,
+      esp::assets::ResourceManager::PER_VERTEX_OBJECT_ID_MATERIAL_KEY,
+      drawableGroup_);
+  checkSorted();
+}
+
+void DrawableTest::renderList() {
+  Mn::GL::Mesh box = Mn::MeshTools::compile(Mn::Primitives::cubeSolidStrip());
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID_);
+  esp::scene::SceneNode& parent = sceneGraph.getRootNode().createChild();
+  esp::scene::SceneNode& node = parent.createChild();
+  node.setMeshBB(Mn::Range3D{Mn::Vector3{-1.0f}, Mn::Vector3{1.0f}});
+  node.addFeature<esp::gfx::GenericDrawable>(
+      box, resourceManager_->getShaderManager(),
+      esp::assets::ResourceManager::NO_LIGHT_KEY,
+      esp::assets::ResourceManager::PER_VERTEX_OBJECT_ID_MATERIAL_KEY,
+      drawableGroup_);
+
+  esp::gfx::RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+  // the same drawables and transformations as walking the scene graph
+  auto checkTransformations = [&]() {
+    auto expected = camera.drawableTransformations(*drawableGroup_);
+    auto actual = camera.renderListTransformations(*drawableGroup_, {});
+    CORRADE_COMPARE(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+      CORRADE_ITERATION(i);
+      CORRADE_VERIFY(&actual[i].first.get() == &expected[i].first.get());
+      CORRADE_COMPARE(actual[i].second, expected[i].second);
+    }
+  };
+  checkTransformations();
+  esp::gfx::RenderList& list = drawableGroup_->renderList();
+  CORRADE_COMPARE(list.size(), drawableGroup_->size());
+  CORRADE_VERIFY(list.update() == 0);
+
+  // moving the parent updates only the entry of its child
+  parent.translate(Mn::Vector3{0.0f, 0.0f, -5.0f});
+  CORRADE_VERIFY(list.update() == 1);
+  CORRADE_VERIFY(list.update() == 0);
+  const size_t last = list.size() - 1;
+  CORRADE_COMPARE(list.worldTransformations()[last],
+                  node.absoluteTransformationMatrix());
+  CORRADE_VERIFY(list.isCullable(last));
+  CORRADE_COMPARE(list.worldAABBs()[last],
+                  (Mn::Range3D{{-1.0f, -1.0f, -6.0f}, {1.0f, 1.0f, -4.0f}}));
+  parent.translate(Mn::Vector3{0.0f, 1.0f, 0.0f});
+  checkTransformations();
+
+  // removing the drawable rebuilds the list
+  delete &parent;
+  CORRADE_COMPARE(drawableGroup_->renderList().size(), drawableGroup_->size());
+  checkTransformations();
+}
+
+void DrawableTest::phongUniformCache() {
+  using esp::gfx::LightPositionModel;
+  const esp::gfx::LightSetup lightSetup{
+      {Mn::Vector4{1.0f, 2.0f, 3.0f, 1.0f}, Mn::Color3{0.5f},
+       LightPositionModel::GLOBAL},
+      {Mn::Vector4{0.0f, 0.0f, 1.0f, 0.0f}, Mn::Color3{1.0f},
+       LightPositionModel::CAMERA},
+      {Mn::Vector4{0.0f, 1.0f, 0.0f, 1.0f}, Mn::Color3{1.0f},
+       LightPositionModel::OBJECT}};
+  const Mn::Matrix4 cameraMatrix =
+      Mn::Matrix4::translation(Mn::Vector3{0.0f, 0.0f, -5.0f});
+
+  esp::gfx::PhongUniformCache cache;
+  cache.beginDrawPass();
+  const auto& lights = cache.lights(lightSetup, cameraMatrix);
+  CORRADE_COMPARE(lights.positions.size(), 3);
+  CORRADE_COMPARE(lights.positions[0], (Mn::Vector4{1.0f, 2.0f, -2.0f, 1.0f}));
+  CORRADE_COMPARE(lights.positions[1], lightSetup[1].vector);
+  // object lights are transformed on each draw
+  CORRADE_COMPARE(lights.positions[2], lightSetup[2].vector);
+  CORRADE_VERIFY(lights.hasObjectLights);
+  CORRADE_COMPARE(lights.colors[0], Mn::Color3{0.5f});
+
+  // the lights are computed once per pass
+  cache.lights(lightSetup, Mn::Matrix4{});
+  CORRADE_COMPARE(lights.positions[0], (Mn::Vector4{1.0f, 2.0f, -2.0f, 1.0f}));
+  cache.endDrawPass();
+  cache.beginDrawPass();
+  cache.lights(lightSetup, Mn::Matrix4{});
+  CORRADE_COMPARE(lights.positions[0], (Mn::Vector4{1.0f, 2.0f, 3.0f, 1.0f}));
+  cache.endDrawPass();
+
+  // and kept across passes until the camera moves or a light setup is set
+  cache.beginDrawPass();
+  cache.lights(lightSetup, Mn::Matrix4{});
+  CORRADE_COMPARE(cache.getNumLightComputations(), 0);
+  esp::gfx::markLightSetupsChanged();
+  cache.lights(lightSetup, Mn::Matrix4{});
+  CORRADE_COMPARE(cache.getNumLightComputations(), 0);
+  cache.endDrawPass();
+  cache.beginDrawPass();
+  cache.lights(lightSetup, Mn::Matrix4{});
+  CORRADE_COMPARE(cache.getNumLightComputations(), 1);
+  cache.lights(lightSetup, cameraMatrix);
+  CORRADE_COMPARE(cache.getNumLightComputations(), 1);
+  cache.endDrawPass();
+  cache.beginDrawPass();
+  cache.lights(lightSetup, cameraMatrix);
+  CORRADE_COMPARE(cache.getNumLightComputations(), 1);
+  CORRADE_COMPARE(lights.positions[0], (Mn::Vector4{1.0f, 2.0f, -2.0f, 1.0f}));
+  cache.endDrawPass();
+
+  // the drawables sharing a shader and a light setup upload the lights once
+  esp::gfx::RenderCamera& camera =
+      sceneManager_.getSceneGraph(sceneID_).getDefaultRenderCamera();
+  esp::gfx::RenderTarget::uptr target = esp::gfx::RenderTarget::create_unique(
+      Mn::Vector2i{64, 64},
+      esp::gfx::calculateDepthUnprojection(camera.projectionMatrix()));
+  target->renderEnter();
+  camera.draw(*drawableGroup_);
+  target->renderExit();
+  CORRADE_VERIFY(camera.phongUniformCache().getNumLightUploads() > 0);
+  CORRADE_VERIFY(camera.phongUniformCache().getNumLightUploads() <
+                 drawableGroup_->size());
+}
+
+void DrawableTest::renderQuality() {
+  esp::gfx::RenderCamera& camera =
+      sceneManager_.getSceneGraph(sceneID_).getDefaultRenderCamera();
+  esp::gfx::RenderTarget::uptr target = esp::gfx::RenderTarget::create_unique(
+      Mn::Vector2i{64, 64},
+      esp::gfx::calculateDepthUnprojection(camera.projectionMatrix()));
+
+  // the cheaper tiers draw everything with flat shaders, without lights
+  for (esp::gfx::RenderCamera::Flag flag :
+       {esp::gfx::RenderCamera::Flag::Unlit,
+        esp::gfx::RenderCamera::Flag::VertexColorOnly}) {
+    target->renderEnter();
+    CORRADE_COMPARE(camera.draw(*drawableGroup_, flag),
+                    drawableGroup_->size());
+    target->renderExit();
+    CORRADE_COMPARE(camera.phongUniformCache().getNumLightUploads(), 0);
+    CORRADE_VERIFY(camera.shading() ==
+                   esp::gfx::RenderCamera::Shading::Phong);
+  }
+
+  target->renderEnter();
+  camera.draw(*drawableGroup_);
+  target->renderExit();
+  CORRADE_VERIFY(camera.phongUniformCache().getNumLightUploads() > 0);
+}
+
+void DrawableTest::frameArena() {
+  esp::gfx::FrameArena arena{256};
+  void* first = arena.allocate(100, 16);
+  CORRADE_COMPARE(reinterpret_cast<std::uintptr_t>(first) % 16, 0);
+  {
+    // the allocations of a scope are taken back at its end
+    esp::gfx::FrameArena::Scope scope{arena};
+    esp::gfx::FrameVector<int> values{esp::gfx::FrameAllocator<int>{arena}};
+    values.reserve(100);
+    CORRADE_VERIFY(arena.bytesUsed() >= 100 + 100 * sizeof(int));
+  }
+  CORRADE_COMPARE(arena.bytesUsed(), 100);
+
+  // larger than a block, in a block of its own
+  CORRADE_VERIFY(arena.allocate(1000) != nullptr);
+  CORRADE_VERIFY(arena.numBlockAllocations() >= 2);
+
+  // once merged, a frame of the same size allocates nothing more
+  arena.reset();
+  CORRADE_COMPARE(arena.bytesUsed(), 0);
+  const size_t numBlockAllocations = arena.numBlockAllocations();
+  arena.allocate(100, 16);
+  arena.allocate(1000);
+  arena.reset();
+  CORRADE_COMPARE(arena.numBlockAllocations(), numBlockAllocations);
+
+  // the draws leave the arena of the thread as they found it
+  esp::gfx::RenderCamera& camera =
+      sceneManager_.getSceneGraph(sceneID_).getDefaultRenderCamera();
+  const size_t used = esp::gfx::frameArena().bytesUsed();
+  camera.draw(*drawableGroup_, esp::gfx::RenderCamera::Flag::FrustumCulling);
+  CORRADE_COMPARE(esp::gfx::frameArena().bytesUsed(), used);
+}
+
 }  // namespace
 }  // namespace Test
 
@@ -10,7 +10,9 @@
 #include <Magnum/Math/FunctionsBatch.h>
 #include "esp/core/Utility.h"
 #include "esp/geo/CoordinateFrame.h"
+#include "esp/geo/MeshBVH.h"
 #include "esp/geo/OBB.h"
+#include "esp/geo/OBBSet.h"
 #include "esp/geo/geo.h"
 
 namespace Cr = Corrade;
@@ -47,7 +49,9 @@ struct GeoTest : Cr::TestSuite::Tester {
   void aabb();
   void obbConstruction();
   void obbFunctions();
+  void obbSet();
   void coordinateFrame();
+  void meshBVH();
   // benchmarks
   void getTransformedBB_standard();
   void getTransformedBB();
@@ -66,7 +70,9 @@ GeoTest::GeoTest() {
   addTests({&GeoTest::aabb,
             &GeoTest::obbConstruction,
             &GeoTest::obbFunctions,
-            &GeoTest::coordinateFrame});
+            &GeoTest::obbSet,
+            &GeoTest::coordinateFrame,
+            &GeoTest::meshBVH});
   addBenchmarks({&GeoTest::getTransformedBB_standard,
                  &GeoTest::getTransformedBB}, 10);
   // clang-format on
@@ -160,6 +166,51 @@ void GeoTest::obbFunctions() {
   CORRADE_COMPARE_AS(obb2.distance(vec3f(-10, -5, 2)), 1, float);
 }
 
+void GeoTest::obbSet() {
+  const std::vector<OBB> boxes{
+      OBB{vec3f(0, 0, 0), vec3f(20, 2, 10),
+          quatf::FromTwoVectors(vec3f::UnitY(), vec3f::UnitZ())},
+      OBB{vec3f(3, -1, 2), vec3f(1, 1, 1), quatf::Identity()},
+      OBB{vec3f(-4, 2, 0), vec3f(2, 4, 1),
+          quatf(Eigen::AngleAxisf(0.7f, vec3f(1, 1, 0).normalized()))}};
+  const OBBSet set{boxes};
+  CORRADE_COMPARE(set.size(), boxes.size());
+
+  // the same results as the boxes one by one
+  std::vector<uint8_t> contained;
+  std::vector<float> distances;
+  for (const vec3f& p : {vec3f(0, 0, 0), vec3f(-5, -2, 0.5), vec3f(5, 0, 2),
+                         vec3f(3.4f, -1.2f, 2.1f), vec3f(-4, 2.5f, 0.2f),
+                         vec3f(-20, 0, 0), vec3f(-10, -5, 2)}) {
+    CORRADE_ITERATION(Mn::Vector3{p});
+    set.contains(p, contained);
+    set.distances(p, distances);
+    CORRADE_COMPARE(contained.size(), boxes.size());
+    CORRADE_COMPARE(distances.size(), boxes.size());
+    for (size_t i = 0; i != boxes.size(); ++i) {
+      CORRADE_ITERATION(i);
+      CORRADE_COMPARE(bool(contained[i]), boxes[i].contains(p));
+      CORRADE_COMPARE(distances[i], boxes[i].distance(p));
+      CORRADE_COMPARE(set.distance(i, p), boxes[i].distance(p));
+    }
+  }
+
+  // a ray along the x axis starts inside the first box, hits the third one
+  // behind it and misses the second
+  std::vector<float> hits;
+  set.rayIntersections(Ray{{-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}, hits);
+  CORRADE_COMPARE(hits.size(), boxes.size());
+  CORRADE_COMPARE(hits[0], 0.0f);
+  CORRADE_VERIFY(hits[1] < 0.0f);
+  CORRADE_VERIFY(hits[2] < 0.0f);
+  // a ray pointing down through the second box into the first one, with a
+  // direction of length 2
+  set.rayIntersections(Ray{{3.0f, -1.0f, 10.0f}, {0.0f, 0.0f, -2.0f}}, hits);
+  CORRADE_COMPARE(hits[0], 4.5f);
+  CORRADE_COMPARE(hits[1], 3.75f);
+  CORRADE_VERIFY(hits[2] < 0.0f);
+}
+
 void GeoTest::coordinateFrame() {
   const vec3f origin(1, -2, 3);
   const vec3f up(0, 0, 1);
@@ -200,6 +251,66 @@ void GeoTest::coordinateFrame() {
   CORRADE_VERIFY(c3 == c4);
 }
 
+void GeoTest::meshBVH() {
+  // two 10x10 grids of unit quads facing up, at y = 0 and y = -1
+  std::vector<Mn::Vector3> vertices;
+  for (float y : {0.0f, -1.0f}) {
+    for (int i = 0; i < 10; ++i) {
+      for (int j = 0; j < 10; ++j) {
+        const Mn::Vector3 a{float(i), y, float(j)};
+        const Mn::Vector3 b = a + Mn::Vector3::xAxis();
+        const Mn::Vector3 c = a + Mn::Vector3::zAxis();
+        const Mn::Vector3 d = b + Mn::Vector3::zAxis();
+        vertices.insert(vertices.end(), {a, c, b, b, c, d});
+      }
+    }
+  }
+  MeshBVH bvh;
+  bvh.build(vertices);
+  CORRADE_COMPARE(bvh.numTriangles(), 400);
+  CORRADE_COMPARE(bvh.bounds().min(), (Mn::Vector3{0.0f, -1.0f, 0.0f}));
+  CORRADE_COMPARE(bvh.bounds().max(), (Mn::Vector3{10.0f, 0.0f, 10.0f}));
+
+  MeshBVH::Hit hit;
+  CORRADE_VERIFY(bvh.castRay({2.25f, 5.0f, 7.75f}, {0.0f, -2.0f, 0.0f},
+                             100.0f, hit));
+  CORRADE_COMPARE(hit.t, 2.5f);
+  CORRADE_COMPARE(hit.normal, Mn::Vector3::yAxis());
+  const Mn::Vector3 corner = vertices[3 * hit.triangle];
+  CORRADE_COMPARE(corner.y(), 0.0f);
+  CORRADE_VERIFY(corner.x() <= 2.25f && corner.x() + 1.0f >= 2.25f);
+  CORRADE_VERIFY(corner.z() <= 7.75f && corner.z() + 1.0f >= 7.75f);
+
+  // from below, the normal faces the ray origin
+  CORRADE_VERIFY(bvh.castRay({5.5f, -3.0f, 5.5f}, {0.0f, 1.0f, 0.0f}, 100.0f,
+                             hit));
+  CORRADE_COMPARE(hit.t, 2.0f);
+  CORRADE_COMPARE(hit.normal, -Mn::Vector3::yAxis());
+  CORRADE_VERIFY(!bvh.castRay({5.5f, -3.0f, 5.5f}, {0.0f, 1.0f, 0.0f}, 1.5f,
+                              hit));
+  CORRADE_COMPARE(hit.triangle, MeshBVH::NoTriangle);
+  CORRADE_VERIFY(!bvh.castRay({12.0f, 5.0f, 5.0f}, {0.0f, -1.0f, 0.0f},
+                              100.0f, hit));
+
+  std::vector<MeshBVH::Hit> hits;
+  bvh.castRayAll({3.5f, 1.0f, 3.5f}, {0.0f, -1.0f, 0.0f}, 100.0f, hits);
+  CORRADE_COMPARE(hits.size(), 2);
+  CORRADE_COMPARE(hits[0].t, 1.0f);
+  CORRADE_COMPARE(hits[1].t, 2.0f);
+
+  const std::vector<Ray> rays{{{1.5f, 1.0f, 1.5f}, {0.0f, -1.0f, 0.0f}},
+                              {{-1.0f, 1.0f, -1.0f}, {0.0f, -1.0f, 0.0f}},
+                              {{-1.0f, -0.5f, 5.5f}, {1.0f, 0.0f, 0.0f}},
+                              {{-1.0f, 2.0f, 4.5f}, {1.0f, -1.0f, 0.0f}}};
+  std::vector<MeshBVH::Hit> batchHits(rays.size());
+  bvh.castRays(rays, 100.0f, batchHits);
+  CORRADE_COMPARE(batchHits[0].t, 1.0f);
+  CORRADE_COMPARE(batchHits[1].triangle, MeshBVH::NoTriangle);
+  CORRADE_COMPARE(batchHits[2].triangle, MeshBVH::NoTriangle);
+  CORRADE_COMPARE(batchHits[3].t, 2.0f);
+  CORRADE_COMPARE(batchHits[3].normal, Mn::Vector3::yAxis());
+}
+
 }  // namespace Test
 
 CORRADE_TEST_MAIN(Test::GeoTest)
@@ -3,6 +3,7 @@
 // LICENSE file in the root directory of this source tree.
 
 #include <gtest/gtest.h>
+#include <cstdio>
 #include "esp/core/esp.h"
 #include "esp/io/io.h"
 #include "esp/io/json.h"
@@ -35,6 +36,20 @@ TEST(IOTest, fileSizeTest) {
   LOG(INFO) << "File size of " << nonexistingFile << " is " << result;
 }
 
+TEST(IOTest, writeFileAtomicallyTest) {
+  const std::string file = ::testing::TempDir() + "IOTest.atomic";
+  EXPECT_TRUE(writeFileAtomically(file, std::string(16, 'a')));
+  EXPECT_EQ(fileSize(file), 16);
+  // a second write replaces the file as a whole
+  EXPECT_TRUE(writeFileAtomically(file, std::string(4, 'b')));
+  EXPECT_EQ(fileSize(file), 4);
+  std::remove(file.c_str());
+
+  // nothing is written into a directory that doesn't exist
+  EXPECT_FALSE(writeFileAtomically("/nonexistent/IOTest.atomic", "data"));
+  EXPECT_FALSE(exists("/nonexistent/IOTest.atomic"));
+}
+
 TEST(IOTest, fileRmExtTest) {
   std::string filename = "/foo/bar.jpeg";
 
@@ -150,3 +165,37 @@ TEST(IOTest, JsonTest) {
   EXPECT_EQ(success, true);
   EXPECT_EQ(attributes->getRenderAssetHandle(), "banana.glb");
 }
+
+TEST(IOTest, JsonObjectReaderTest) {
+  std::string attr_str =
+      "{\"render mesh\": \"banana.glb\",\"join collision "
+      "meshes\":false,\"mass\": \"heavy\",\"scale\": [2.0,2.0,2],"
+      "\"unknown\": 3}";
+  const auto& jsonDoc = esp::io::parseJsonString(attr_str);
+
+  // for function ptr placeholder
+  using std::placeholders::_1;
+  ObjectAttributes::ptr attributes = ObjectAttributes::create("temp");
+  attributes->setMass(1.0);
+
+  esp::io::JsonObjectReader reader;
+  reader
+      .addConstSetter<Magnum::Vector3>(
+          "scale", std::bind(&ObjectAttributes::setScale, attributes, _1))
+      .addSetter<double>("mass",
+                         std::bind(&ObjectAttributes::setMass, attributes, _1))
+      .addSetter<bool>(
+          "join collision meshes",
+          std::bind(&ObjectAttributes::setJoinCollisionMeshes, attributes, _1))
+      .addSetter<std::string>(
+          "render mesh",
+          std::bind(&ObjectAttributes::setRenderAssetHandle, attributes, _1));
+  // the mass is of the wrong type and "unknown" has no setter
+  EXPECT_EQ(reader.read(jsonDoc), 3);
+  EXPECT_EQ(attributes->getScale()[1], 2);
+  EXPECT_EQ(attributes->getMass(), 1.0);
+  EXPECT_EQ(attributes->getJoinCollisionMeshes(), false);
+  EXPECT_EQ(attributes->getRenderAssetHandle(), "banana.glb");
+  // only objects are read
+  EXPECT_EQ(reader.read(jsonDoc["scale"]), 0);
+}
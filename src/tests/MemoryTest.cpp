@@ -0,0 +1,156 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/TestSuite/Tester.h>
+#include <Corrade/Utility/Directory.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "esp/gfx/GpuDevices.h"
+#include "esp/sim/Simulator.h"
+
+#include "configure.h"
+
+namespace Cr = Corrade;
+
+using esp::agent::Agent;
+using esp::agent::AgentConfiguration;
+using esp::gfx::GpuMemoryUsage;
+using esp::sim::Simulator;
+using esp::sim::SimulatorConfiguration;
+
+namespace {
+
+//! The allocations made through operator new while counting is enabled, from
+//! any thread. Allocations straight from malloc(), like those of Eigen, are
+//! not seen.
+std::atomic<bool> countAllocations{false};
+std::atomic<size_t> numAllocations{0};
+
+//! Counts the allocations made during its lifetime
+struct AllocationCounter {
+  AllocationCounter() {
+    numAllocations = 0;
+    countAllocations = true;
+  }
+  ~AllocationCounter() { countAllocations = false; }
+
+  size_t count() const { return numAllocations; }
+};
+
+void* allocate(std::size_t size) {
+  if (countAllocations.load(std::memory_order_relaxed)) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+}  // namespace
+
+// the nothrow and sized variants of the standard library forward to these
+void* operator new(std::size_t size) {
+  return allocate(size);
+}
+void* operator new[](std::size_t size) {
+  return allocate(size);
+}
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+const std::string vangogh =
+    Cr::Utility::Directory::join(SCENE_DATASETS,
+                                 "habitat-test-scenes/van-gogh-room.glb");
+const std::string skokloster =
+    Cr::Utility::Directory::join(SCENE_DATASETS,
+                                 "habitat-test-scenes/skokloster-castle.glb");
+
+struct MemoryTest : Cr::TestSuite::Tester {
+  explicit MemoryTest();
+
+  void stepWithoutAllocations();
+  void reconfigureGpuMemory();
+};
+
+MemoryTest::MemoryTest() {
+  addTests({&MemoryTest::stepWithoutAllocations,
+            &MemoryTest::reconfigureGpuMemory});
+}
+
+void MemoryTest::stepWithoutAllocations() {
+  SimulatorConfiguration cfg;
+  cfg.scene.id = vangogh;
+  Simulator simulator(cfg);
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {};
+  std::vector<Agent::ptr> agents;
+  for (int i = 0; i < 4; ++i) {
+    agents.push_back(simulator.addAgent(agentConfig));
+  }
+  const int moveForward = agents[0]->getActionIndex("moveForward");
+  const int turnLeft = agents[0]->getActionIndex("turnLeft");
+  std::vector<int> forward(agents.size(), moveForward);
+  std::vector<int> left(agents.size(), turnLeft);
+
+  // the first steps grow the buffers the later ones reuse
+  for (int i = 0; i < 10; ++i) {
+    CORRADE_VERIFY(simulator.actAll(i % 2 ? forward : left, 1));
+    simulator.stepWorld(1.0 / 60.0);
+  }
+
+  size_t allocations;
+  bool acted = true;
+  {
+    AllocationCounter counter;
+    for (int i = 0; i < 100; ++i) {
+      acted = simulator.actAll(i % 2 ? forward : left, 1) && acted;
+      simulator.stepWorld(1.0 / 60.0);
+    }
+    allocations = counter.count();
+  }
+  CORRADE_VERIFY(acted);
+  CORRADE_COMPARE(allocations, 0);
+}
+
+void MemoryTest::reconfigureGpuMemory() {
+  SimulatorConfiguration cfg;
+  cfg.scene.id = vangogh;
+  SimulatorConfiguration otherCfg;
+  otherCfg.scene.id = skokloster;
+  Simulator simulator(cfg);
+
+  // the assets stay loaded across scenes, so the baseline is that of both
+  simulator.reconfigure(otherCfg);
+  simulator.reconfigure(cfg);
+  const GpuMemoryUsage baseline = simulator.getGpuMemoryUsage();
+  CORRADE_VERIFY(baseline.totalBytes() > 0);
+
+  for (int i = 0; i < 3; ++i) {
+    CORRADE_ITERATION(i);
+    simulator.reconfigure(otherCfg);
+    simulator.reconfigure(cfg);
+    const GpuMemoryUsage usage = simulator.getGpuMemoryUsage();
+    CORRADE_COMPARE(usage.meshBytes, baseline.meshBytes);
+    CORRADE_COMPARE(usage.textureBytes, baseline.textureBytes);
+    CORRADE_COMPARE(usage.ptexAtlasBytes, baseline.ptexAtlasBytes);
+    CORRADE_COMPARE(usage.renderTargetBytes, baseline.renderTargetBytes);
+    CORRADE_COMPARE(usage.totalBytes(), baseline.totalBytes());
+  }
+}
+
+}  // namespace
+
+CORRADE_TEST_MAIN(MemoryTest)
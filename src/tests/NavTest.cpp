@@ -4,6 +4,7 @@
 
 #include <Corrade/Utility/Directory.h>
 #include <gtest/gtest.h>
+#include <cstring>
 
 #include "esp/assets/MeshData.h"
 #include "esp/core/esp.h"
@@ -55,6 +56,52 @@ TEST(NavTest, PathFinderLoadTest) {
   testPathFinder(pf);
 }
 
+TEST(NavTest, PathFinderCorruptIslandsTest) {
+  PathFinder pf;
+  ASSERT_TRUE(pf.loadNavMesh(Cr::Utility::Directory::join(
+      SCENE_DATASETS, "habitat-test-scenes/skokloster-castle.navmesh")));
+  const std::string file = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "NavTest.navmesh");
+  ASSERT_TRUE(pf.saveNavMesh(file));
+
+  // the islands end the file, their header now claims more than is left
+  std::string data = Cr::Utility::Directory::readString(file);
+  const int magic = 'I' << 24 | 'S' << 16 | 'L' << 8 | 'D';
+  const std::size_t header = data.rfind(
+      std::string(reinterpret_cast<const char*>(&magic), sizeof(magic)));
+  ASSERT_NE(header, std::string::npos);
+  const int numIslands = 1 << 30;
+  std::memcpy(&data[header + 2 * sizeof(int)], &numIslands, sizeof(int));
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(file, data));
+
+  // the islands are rejected and flood filled again
+  PathFinder corrupt;
+  ASSERT_TRUE(corrupt.loadNavMesh(file));
+  EXPECT_EQ(corrupt.numIslands(), pf.numIslands());
+  Cr::Utility::Directory::rm(file);
+}
+
+TEST(NavTest, PathFinderCorruptMappedHeaderTest) {
+  PathFinder pf;
+  ASSERT_TRUE(pf.loadNavMesh(Cr::Utility::Directory::join(
+      SCENE_DATASETS, "habitat-test-scenes/skokloster-castle.navmesh")));
+  const std::string file = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "NavTestMapped.navmesh");
+  ASSERT_TRUE(pf.saveNavMesh(file, true));
+  const std::string data = Cr::Utility::Directory::readString(file);
+
+  // the tile count follows the magic and the version, neither a negative
+  // count nor one larger than the file is allocated
+  for (const int numTiles : {-1, 1 << 30}) {
+    std::string corrupt = data;
+    std::memcpy(&corrupt[2 * sizeof(int)], &numTiles, sizeof(int));
+    ASSERT_TRUE(Cr::Utility::Directory::writeString(file, corrupt));
+    PathFinder corruptPf;
+    EXPECT_FALSE(corruptPf.loadNavMesh(file));
+  }
+  Cr::Utility::Directory::rm(file);
+}
+
 void printRandomizedPathSet(PathFinder& pf) {
   core::Random random;
   ShortestPath path;
@@ -13,6 +13,7 @@
 
 #include "esp/physics/PhysicsManager.h"
 #ifdef ESP_BUILD_WITH_BULLET
+#include "esp/physics/bullet/BulletConvexDecomposition.h"
 #include "esp/physics/bullet/BulletPhysicsManager.h"
 #endif
 
@@ -44,7 +45,8 @@ class PhysicsManagerTest : public testing::Test {
     physicsAttributesManager_ = resourceManager_->getPhysicsAttributesManager();
   };
 
-  void initStage(const std::string stageFile) {
+  void initStage(const std::string stageFile,
+                 const std::string& simulator = "") {
     // const esp::assets::AssetInfo info =
     //     esp::assets::AssetInfo::fromPath(stageFile);
 
@@ -54,6 +56,9 @@ class PhysicsManagerTest : public testing::Test {
     // construct appropriate physics attributes based on config file
     auto physicsManagerAttributes =
         physicsAttributesManager_->createObject(physicsConfigFile, true);
+    if (!simulator.empty()) {
+      physicsManagerAttributes->setSimulator(simulator);
+    }
     auto stageAttributesMgr = resourceManager_->getStageAttributesManager();
     if (physicsManagerAttributes != nullptr) {
       stageAttributesMgr->setCurrPhysicsManagerAttributesHandle(
@@ -147,6 +152,9 @@ TEST_F(PhysicsManagerTest, JoinCompound) {
       }
       int numActiveObjects = physicsManager_->checkActiveObjects();
       LOG(INFO) << " Number of active objects: " << numActiveObjects;
+      // the set maintained by the step agrees with the full check
+      ASSERT_EQ(physicsManager_->getActiveObjectIds().size(),
+                size_t(numActiveObjects));
 
       if (i == 1) {
         // when collision meshes are joined, objects should be stable
@@ -344,8 +352,237 @@ TEST_F(PhysicsManagerTest, BulletCompoundShapeMargins) {
     ASSERT_EQ(AabbOb2, objectGroundTruth);
   }
 }
+
+TEST_F(PhysicsManagerTest, BulletSharedConvexHulls) {
+  // test that objects sharing the convex hulls of a template can still change
+  // their margins independently
+  LOG(INFO) << "Starting physics test: BulletSharedConvexHulls";
+
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(objectFile);
+
+  if (physicsManager_->getPhysicsSimulationLibrary() ==
+      PhysicsManager::PhysicsSimulationLibrary::BULLET) {
+    ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+    ObjectAttributes->setRenderAssetHandle(objectFile);
+    ObjectAttributes->setMargin(0.1);
+    ObjectAttributes->setJoinCollisionMeshes(false);
+
+    auto objectAttributesManager =
+        resourceManager_->getObjectAttributesManager();
+    objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+
+    auto* drawables = &sceneManager_.getSceneGraph(sceneID_).getDrawables();
+    int objectId0 = physicsManager_->addObject(objectFile, drawables);
+    int objectId1 = physicsManager_->addObject(objectFile, drawables);
+
+    esp::physics::BulletPhysicsManager* bPhysManager =
+        static_cast<esp::physics::BulletPhysicsManager*>(physicsManager_.get());
+
+    Magnum::Range3D objectGroundTruth({-1.1, -1.1, -1.1}, {1.1, 1.1, 1.1});
+    ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId0),
+              objectGroundTruth);
+    ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId1),
+              objectGroundTruth);
+
+    physicsManager_->setMargin(objectId0, 0.2);
+    ASSERT_EQ(physicsManager_->getMargin(objectId0), 0.2);
+    ASSERT_EQ(physicsManager_->getMargin(objectId1), 0.1);
+    ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId1),
+              objectGroundTruth);
+
+    // objects added later still get the unmodified hulls
+    int objectId2 = physicsManager_->addObject(objectFile, drawables);
+    ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId2),
+              objectGroundTruth);
+  }
+}
+
+TEST_F(PhysicsManagerTest, BulletSharedScaledConvexHulls) {
+  // test that the shared hulls of scaled objects are scaled once, and only
+  // for the objects of that scale
+  LOG(INFO) << "Starting physics test: BulletSharedScaledConvexHulls";
+
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(objectFile);
+
+  if (physicsManager_->getPhysicsSimulationLibrary() ==
+      PhysicsManager::PhysicsSimulationLibrary::BULLET) {
+    esp::physics::BulletPhysicsManager* bPhysManager =
+        static_cast<esp::physics::BulletPhysicsManager*>(physicsManager_.get());
+    auto objectAttributesManager =
+        resourceManager_->getObjectAttributesManager();
+    auto* drawables = &sceneManager_.getSceneGraph(sceneID_).getDrawables();
+
+    for (bool join : {true, false}) {
+      ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+      ObjectAttributes->setRenderAssetHandle(objectFile);
+      ObjectAttributes->setMargin(0.0);
+      ObjectAttributes->setJoinCollisionMeshes(join);
+      ObjectAttributes->setScale({2.0, 3.0, 4.0});
+      objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+
+      int objectId0 = physicsManager_->addObject(objectFile, drawables);
+      int objectId1 = physicsManager_->addObject(objectFile, drawables);
+      Magnum::Range3D scaledGroundTruth({-2.0, -3.0, -4.0}, {2.0, 3.0, 4.0});
+      ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId0),
+                scaledGroundTruth);
+      ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId1),
+                scaledGroundTruth);
+
+      // an unscaled instance of the same collision asset is not affected
+      ObjectAttributes->setScale({1.0, 1.0, 1.0});
+      objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+      int objectId2 = physicsManager_->addObject(objectFile, drawables);
+      ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId2),
+                Magnum::Range3D({-1.0, -1.0, -1.0}, {1.0, 1.0, 1.0}));
+      ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId0),
+                scaledGroundTruth);
+    }
+  }
+}
+
+TEST(BulletConvexDecompositionTest, LShape) {
+  // an L of two boxes, which no single convex hull fits
+  std::vector<Magnum::Vector3> positions;
+  std::vector<uint32_t> indices;
+  auto addBox = [&](const Magnum::Vector3& min, const Magnum::Vector3& max) {
+    const uint32_t offset = positions.size();
+    for (int corner = 0; corner < 8; ++corner) {
+      positions.emplace_back(corner & 1 ? max.x() : min.x(),
+                             corner & 2 ? max.y() : min.y(),
+                             corner & 4 ? max.z() : min.z());
+    }
+    const uint32_t faces[][4] = {{0, 2, 6, 4}, {1, 5, 7, 3}, {0, 4, 5, 1},
+                                 {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 6, 7, 5}};
+    for (const auto& face : faces) {
+      for (uint32_t index : {face[0], face[1], face[2], face[0], face[2],
+                             face[3]}) {
+        indices.push_back(offset + index);
+      }
+    }
+  };
+  addBox({0, 0, 0}, {4, 1, 1});
+  addBox({0, 0, 0}, {1, 4, 1});
+
+  esp::physics::ConvexDecompositionSettings settings;
+  settings.maxHulls = 4;
+  settings.maxHullVertices = 12;
+  const std::vector<esp::physics::ConvexHullPoints> hulls =
+      esp::physics::convexDecomposition(positions, indices, settings);
+  ASSERT_GE(hulls.size(), 2u);
+  ASSERT_LE(hulls.size(), 4u);
+  for (const auto& hull : hulls) {
+    ASSERT_GE(hull.size(), 4u);
+    ASSERT_LE(hull.size(), 12u);
+    for (const Magnum::Vector3& point : hull) {
+      // the hulls stay within the L, not its bounding square
+      ASSERT_FALSE(point.x() > 1.5f && point.y() > 1.5f);
+    }
+  }
+
+  // the decomposition round trips through its cache file, which is only
+  // valid for the same settings and the same asset
+  const std::string assetFile =
+      Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(), "L.glb");
+  const std::string hullsFile = assetFile + ".hulls";
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(assetFile, "mesh"));
+  ASSERT_TRUE(esp::physics::saveConvexDecomposition(hullsFile, assetFile,
+                                                    settings, hulls));
+  std::vector<esp::physics::ConvexHullPoints> loaded;
+  ASSERT_TRUE(esp::physics::loadConvexDecomposition(hullsFile, assetFile,
+                                                    settings, loaded));
+  ASSERT_EQ(loaded, hulls);
+  esp::physics::ConvexDecompositionSettings fewerHulls = settings;
+  fewerHulls.maxHulls = 5;
+  ASSERT_FALSE(esp::physics::loadConvexDecomposition(hullsFile, assetFile,
+                                                     fewerHulls, loaded));
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(assetFile, "edited mesh"));
+  ASSERT_FALSE(esp::physics::loadConvexDecomposition(hullsFile, assetFile,
+                                                     settings, loaded));
+
+  // a file claiming more hulls than the settings allow is rejected
+  std::vector<esp::physics::ConvexHullPoints> tooMany(settings.maxHulls + 1,
+                                                      hulls[0]);
+  ASSERT_TRUE(esp::physics::saveConvexDecomposition(hullsFile, assetFile,
+                                                    settings, tooMany));
+  ASSERT_FALSE(esp::physics::loadConvexDecomposition(hullsFile, assetFile,
+                                                     settings, loaded));
+  ASSERT_EQ(loaded, hulls);
+  Cr::Utility::Directory::rm(hullsFile);
+  Cr::Utility::Directory::rm(assetFile);
+}
 #endif
 
+TEST_F(PhysicsManagerTest, KinematicCollision) {
+  LOG(INFO) << "Starting physics test: KinematicCollision";
+
+  std::string stageFile =
+      Cr::Utility::Directory::join(dataDir, "test_assets/scenes/plane.glb");
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(stageFile, "kinematic");
+  ASSERT_EQ(physicsManager_->getPhysicsSimulationLibrary(),
+            PhysicsManager::PhysicsSimulationLibrary::KINEMATIC);
+
+  ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+  ObjectAttributes->setRenderAssetHandle(objectFile);
+  auto objectAttributesManager = resourceManager_->getObjectAttributesManager();
+  objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+
+  // two centered boxes with dimension 2x2x2, colliding as their bounding box
+  auto& drawables = sceneManager_.getSceneGraph(sceneID_).getDrawables();
+  int objectId0 = physicsManager_->addObject(objectFile, &drawables);
+  int objectId1 = physicsManager_->addObject(objectFile, &drawables);
+
+  physicsManager_->setTranslation(objectId0, Magnum::Vector3{0, 1.1, 0});
+  physicsManager_->setTranslation(objectId1, Magnum::Vector3{2.2, 1.1, 0});
+  ASSERT_FALSE(physicsManager_->contactTest(objectId0));
+  ASSERT_FALSE(physicsManager_->contactTest(objectId1));
+
+  // a ray down hits the top of box 0, then the floor
+  esp::geo::Ray down{{0, 5.0, 0}, {0, -1.0, 0}};
+  esp::physics::RaycastResults results = physicsManager_->castRay(down);
+  ASSERT_EQ(results.hits.size(), 2u);
+  ASSERT_EQ(results.hits[0].objectId, objectId0);
+  ASSERT_NEAR(results.hits[0].rayDistance, 2.9, 1e-4);
+  ASSERT_NEAR(results.hits[0].normal.y(), 1.0, 1e-4);
+  ASSERT_EQ(results.hits[1].objectId, -1);
+
+  esp::physics::BatchRaycastResults batchResults;
+  physicsManager_->castRays({down, {{0, 5.0, 0}, {0, 1.0, 0}}}, batchResults);
+  ASSERT_TRUE(batchResults.hasHit[0]);
+  ASSERT_EQ(batchResults.objectIds[0], objectId0);
+  ASSERT_NEAR(batchResults.rayDistances[0], 2.9, 1e-4);
+  ASSERT_FALSE(batchResults.hasHit[1]);
+
+  // an agent sized box above box 1, then touching it
+  const Magnum::Vector3 agentExtents{0.2, 0.5, 0.2};
+  ASSERT_TRUE(
+      physicsManager_->boxOverlapTest({2.2, 3.5, 0}, agentExtents).empty());
+  ASSERT_EQ(physicsManager_->boxOverlapTest({2.2, 2.3, 0}, agentExtents),
+            std::vector<int>{objectId1});
+
+  // move box 0 into floor
+  physicsManager_->setTranslation(objectId0, Magnum::Vector3{0, 0.9, 0});
+  ASSERT_TRUE(physicsManager_->contactTest(objectId0));
+  ASSERT_FALSE(physicsManager_->contactTest(objectId1));
+
+  // move box 0 into box 1
+  physicsManager_->setTranslation(objectId0, Magnum::Vector3{1.1, 1.1, 0});
+  ASSERT_TRUE(physicsManager_->contactTest(objectId0));
+  ASSERT_TRUE(physicsManager_->contactTest(objectId1));
+
+  // removed objects don't collide anymore
+  physicsManager_->removeObject(objectId1);
+  ASSERT_FALSE(physicsManager_->contactTest(objectId0));
+}
+
 TEST_F(PhysicsManagerTest, ConfigurableScaling) {
   // test scaling of objects via template configuration (visual and collision)
   LOG(INFO) << "Starting physics test: ConfigurableScaling";
@@ -811,6 +1048,17 @@ TEST_F(PhysicsManagerTest, TestRemoveSleepingSupport) {
     for (auto id : cubeIds) {
       assert(!physicsManager_->isActive(id));
     }
+    ASSERT_TRUE(physicsManager_->getActiveObjectIds().empty());
+
+    // the thresholds of the physics manager apply, and can be overridden
+    ASSERT_EQ(physicsManager_->getLinearSleepingThreshold(cubeIds.back()),
+              physicsManager_->getInitializationAttributes()
+                  ->getLinearSleepingThreshold());
+    physicsManager_->setSleepingThresholds(cubeIds.back(), 0.1, 0.2);
+    ASSERT_FLOAT_EQ(
+        physicsManager_->getLinearSleepingThreshold(cubeIds.back()), 0.1);
+    ASSERT_FLOAT_EQ(
+        physicsManager_->getAngularSleepingThreshold(cubeIds.back()), 0.2);
 
     // no active contact points
     ASSERT_EQ(physicsManager_->getNumActiveContactPoints(), 0);
@@ -827,3 +1075,90 @@ TEST_F(PhysicsManagerTest, TestRemoveSleepingSupport) {
     ASSERT_GT(physicsManager_->getNumActiveContactPoints(), 0);
   }
 }
+
+TEST_F(PhysicsManagerTest, ObjectPooling) {
+  // test that removed objects are recycled by the next add of their template
+  LOG(INFO) << "Starting physics test: ObjectPooling";
+
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(objectFile);
+
+  ObjectAttributes::ptr objectAttributes = ObjectAttributes::create();
+  objectAttributes->setRenderAssetHandle(objectFile);
+  resourceManager_->getObjectAttributesManager()->registerObject(
+      objectAttributes, objectFile);
+
+  auto& drawables = sceneManager_.getSceneGraph(sceneID_).getDrawables();
+  const std::size_t numStageDrawables = drawables.size();
+  physicsManager_->setObjectPooling(true);
+
+  int objectId = physicsManager_->addObject(objectFile, &drawables);
+  const std::size_t numDrawables = drawables.size();
+  ASSERT_GT(numDrawables, numStageDrawables);
+  esp::scene::SceneNode* objectNode =
+      &physicsManager_->getObjectSceneNode(objectId);
+  physicsManager_->setTranslation(objectId, {1.0, 2.0, 3.0});
+
+  // the removed object is hidden and kept
+  physicsManager_->removeObject(objectId);
+  ASSERT_EQ(physicsManager_->getNumRigidObjects(), 0);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 1);
+  ASSERT_EQ(drawables.size(), numStageDrawables);
+
+  // and comes back at the origin, drawn again
+  int recycledId = physicsManager_->addObject(objectFile, &drawables);
+  ASSERT_NE(recycledId, esp::ID_UNDEFINED);
+  ASSERT_EQ(&physicsManager_->getObjectSceneNode(recycledId), objectNode);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 0);
+  ASSERT_EQ(drawables.size(), numDrawables);
+  ASSERT_EQ(physicsManager_->getTranslation(recycledId), Magnum::Vector3{});
+
+  // a second object of the template is new
+  int newId = physicsManager_->addObject(objectFile, &drawables);
+  ASSERT_NE(&physicsManager_->getObjectSceneNode(newId), objectNode);
+  physicsManager_->removeObject(recycledId);
+  physicsManager_->removeObject(newId);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 2);
+
+  // disabling the pooling destroys the pooled objects
+  physicsManager_->setObjectPooling(false);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 0);
+  ASSERT_EQ(drawables.size(), numStageDrawables);
+}
+
+TEST(ObjectSlotMapTest, RecycledIds) {
+  esp::physics::ObjectSlotMap<int> objects;
+  ASSERT_TRUE(objects.emplace(0, std::make_unique<int>(10)));
+  ASSERT_TRUE(objects.emplace(3, std::make_unique<int>(13)));
+  ASSERT_TRUE(objects.emplace(1, std::make_unique<int>(11)));
+  ASSERT_FALSE(objects.emplace(1, std::make_unique<int>(-1)));
+  ASSERT_EQ(objects.size(), 3);
+  ASSERT_EQ(objects.count(2), 0);
+  ASSERT_EQ(objects.count(-1), 0);
+  ASSERT_EQ(*objects.at(3), 13);
+
+  // removal keeps the other objects reachable, by id and by iteration
+  const auto handle = objects.handle(0);
+  ASSERT_EQ(objects.erase(0), 1);
+  ASSERT_EQ(objects.erase(0), 0);
+  ASSERT_EQ(objects.get(0), nullptr);
+  ASSERT_EQ(*objects.at(1), 11);
+  int sum = 0;
+  for (auto& object : objects) {
+    ASSERT_EQ(objects.get(object.first), object.second);
+    sum += *object.second;
+  }
+  ASSERT_EQ(sum, 24);
+
+  // a handle does not resolve to the object reusing its id
+  ASSERT_TRUE(objects.emplace(0, std::make_unique<int>(20)));
+  ASSERT_EQ(*objects.get(0), 20);
+  ASSERT_EQ(objects.get(handle), nullptr);
+  ASSERT_EQ(*objects.get(objects.handle(0)), 20);
+
+  objects.clear();
+  ASSERT_TRUE(objects.empty());
+  ASSERT_EQ(objects.get(3), nullptr);
+}
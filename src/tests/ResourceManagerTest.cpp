@@ -2,13 +2,26 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/Optional.h>
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/EigenIntegration/Integration.h>
 #include <Magnum/Math/Range.h>
+#include <Magnum/MeshTools/CompressIndices.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Primitives/Icosphere.h>
+#include <Magnum/Trade/MeshData.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <random>
 #include <string>
 
+#include "esp/assets/CompressedGltf.h"
+#include "esp/assets/GenericMeshData.h"
+#include "esp/assets/IndexOptimization.h"
+#include "esp/assets/MeshArena.h"
+#include "esp/assets/ObjectIdTransfer.h"
 #include "esp/assets/ResourceManager.h"
 #include "esp/gfx/Renderer.h"
 #include "esp/gfx/WindowlessContext.h"
@@ -82,3 +95,530 @@ TEST(ResourceManagerTest, createJoinedCollisionMesh) {
     ASSERT_EQ(indexGroundTruth[iix], joinedBox->ibo[iix]);
   }
 }
+
+TEST(ResourceManagerTest, sceneCache) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  // a copy, so the cache is not written into the test assets
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  const std::string tmpBoxFile = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "transform_box_scene_cache.glb");
+  ASSERT_TRUE(Cr::Utility::Directory::copy(boxFile, tmpBoxFile));
+  const std::string cacheFile = esp::assets::sceneCacheFilename(tmpBoxFile);
+  ASSERT_TRUE(ResourceManager::bakeSceneCache(tmpBoxFile, cacheFile));
+
+  const esp::assets::AssetInfo info =
+      esp::assets::AssetInfo::fromPath(tmpBoxFile);
+  std::unique_ptr<esp::assets::DecodedAssetData> cached =
+      esp::assets::loadSceneCache(cacheFile, info, true);
+  ASSERT_NE(cached, nullptr);
+  ASSERT_EQ(cached->meshes.size(), 6u);
+  ASSERT_FALSE(cached->root.children.empty());
+
+  // loading goes through the cache and gives the same mesh as importing
+  ResourceManager resourceManager;
+  SceneManager sceneManager_;
+  auto stageAttributes =
+      resourceManager.getStageAttributesManager()->createObject(tmpBoxFile,
+                                                                true);
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+  ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                        &sceneManager_, tempIDs, false));
+  esp::assets::MeshData::uptr joinedBox =
+      resourceManager.createJoinedCollisionMesh(tmpBoxFile);
+  ASSERT_EQ(joinedBox->vbo.size(), 24u);
+  ASSERT_EQ(joinedBox->ibo.size(), 36u);
+
+  // a corrupt or truncated cache is ignored instead of asserting
+  const std::string cache = Cr::Utility::Directory::readString(cacheFile);
+  std::string corrupt = cache;
+  corrupt[corrupt.size() / 2] ^= 0x5a;
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(cacheFile, corrupt));
+  ASSERT_EQ(esp::assets::loadSceneCache(cacheFile, info, true), nullptr);
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(
+      cacheFile, cache.substr(0, cache.size() / 2)));
+  ASSERT_EQ(esp::assets::loadSceneCache(cacheFile, info, true), nullptr);
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(cacheFile, cache));
+  ASSERT_NE(esp::assets::loadSceneCache(cacheFile, info, true), nullptr);
+
+  // an outdated cache is ignored
+  ASSERT_TRUE(Cr::Utility::Directory::appendString(tmpBoxFile, " "));
+  ASSERT_EQ(esp::assets::loadSceneCache(cacheFile, info, true), nullptr);
+
+  Cr::Utility::Directory::rm(cacheFile);
+  Cr::Utility::Directory::rm(tmpBoxFile);
+}
+
+#ifdef ESP_BUILD_MESHOPT_SUPPORT
+TEST(ResourceManagerTest, compressedGltf) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  const std::string tmpBoxFile = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "transform_box_meshopt.glb");
+  ASSERT_FALSE(esp::assets::isCompressedGltf(boxFile));
+  ASSERT_TRUE(esp::assets::compressGltf(boxFile, tmpBoxFile));
+  ASSERT_TRUE(esp::assets::isCompressedGltf(tmpBoxFile));
+  ASSERT_TRUE(esp::assets::decompressGltf(tmpBoxFile));
+
+  // the compressed file loads as the same mesh as the original
+  ResourceManager resourceManager;
+  SceneManager sceneManager_;
+  auto stageAttributes =
+      resourceManager.getStageAttributesManager()->createObject(tmpBoxFile,
+                                                                true);
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+  ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                        &sceneManager_, tempIDs, false));
+  esp::assets::MeshData::uptr joinedBox =
+      resourceManager.createJoinedCollisionMesh(tmpBoxFile);
+  ASSERT_EQ(joinedBox->vbo.size(), 24u);
+  ASSERT_EQ(joinedBox->ibo.size(), 36u);
+
+  Cr::Utility::Directory::rm(tmpBoxFile);
+}
+#endif
+
+TEST(ResourceManagerTest, assetMetadata) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  // a copy, so the metadata is not written into the test assets
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  const std::string tmpBoxFile = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "transform_box_metadata.glb");
+  ASSERT_TRUE(Cr::Utility::Directory::copy(boxFile, tmpBoxFile));
+  const std::string metadataFile =
+      esp::metadata::managers::ObjectAttributesManager::assetMetadataFilename(
+          tmpBoxFile);
+  Cr::Utility::Directory::rm(metadataFile);
+
+  // the metadata is computed when the render asset is first loaded
+  {
+    ResourceManager resourceManager;
+    auto objectAttributesMgr = resourceManager.getObjectAttributesManager();
+    const std::string handle =
+        objectAttributesMgr->createObject(tmpBoxFile, true)->getHandle();
+    EXPECT_FALSE(objectAttributesMgr->getObjectCopyByHandle(handle)
+                     ->getHasAssetMetadata());
+    ASSERT_TRUE(resourceManager.instantiateAssetsOnDemand(handle));
+    auto attributes = objectAttributesMgr->getObjectCopyByHandle(handle);
+    ASSERT_TRUE(attributes->getHasAssetMetadata());
+    // 6 planes of 2 triangles with corners at the unit corner coordinates
+    EXPECT_EQ(attributes->getRenderAssetTriangleCount(), 12);
+    EXPECT_EQ(attributes->getRenderAssetAabb(),
+              (Mn::Range3D{{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}}));
+  }
+  ASSERT_TRUE(Cr::Utility::Directory::exists(metadataFile));
+
+  // and read from the cache by the next template, without loading the asset
+  {
+    ResourceManager resourceManager;
+    auto attributes =
+        resourceManager.getObjectAttributesManager()->createObject(tmpBoxFile,
+                                                                   true);
+    ASSERT_TRUE(attributes->getHasAssetMetadata());
+    EXPECT_EQ(attributes->getRenderAssetTriangleCount(), 12);
+    EXPECT_EQ(attributes->getRenderAssetAabb(),
+              (Mn::Range3D{{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}}));
+  }
+
+  // the datatool bakes the same metadata
+  Cr::Utility::Directory::rm(metadataFile);
+  ASSERT_TRUE(ResourceManager::bakeAssetMetadata(tmpBoxFile));
+  {
+    ResourceManager resourceManager;
+    auto attributes =
+        resourceManager.getObjectAttributesManager()->createObject(tmpBoxFile,
+                                                                   true);
+    ASSERT_TRUE(attributes->getHasAssetMetadata());
+    EXPECT_EQ(attributes->getRenderAssetTriangleCount(), 12);
+  }
+
+  // a cache of another version of the asset is ignored
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(
+      metadataFile,
+      R"({"asset size": 1, "aabb min": [0, 0, 0], "aabb max": [1, 1, 1],
+          "triangle count": 1})"));
+  {
+    ResourceManager resourceManager;
+    EXPECT_FALSE(resourceManager.getObjectAttributesManager()
+                     ->createObject(tmpBoxFile, true)
+                     ->getHasAssetMetadata());
+  }
+
+  Cr::Utility::Directory::rm(metadataFile);
+  Cr::Utility::Directory::rm(tmpBoxFile);
+}
+
+TEST(ResourceManagerTest, transcodedImageCache) {
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  const uint64_t hash = esp::assets::fileContentHash(boxFile);
+  ASSERT_NE(hash, 0u);
+  ASSERT_EQ(esp::assets::fileContentHash(boxFile), hash);
+
+  // keyed by the contents, the format and the image
+  const std::string cacheDir = Cr::Utility::Directory::tmp();
+  const std::string cacheFile = esp::assets::transcodedImageCacheFilename(
+      cacheDir, hash, "Bc7RGBA", 0);
+  ASSERT_NE(cacheFile, esp::assets::transcodedImageCacheFilename(
+                           cacheDir, hash, "Etc2RGBA", 0));
+  ASSERT_NE(cacheFile, esp::assets::transcodedImageCacheFilename(
+                           cacheDir, hash, "Bc7RGBA", 1));
+
+  // two mip levels of BC7 blocks, 16 bytes per 4x4 block
+  std::vector<Mn::Trade::ImageData2D> levels;
+  Cr::Containers::Array<char> level0{Cr::Containers::ValueInit, 64};
+  level0[5] = 42;
+  levels.emplace_back(Mn::CompressedPixelFormat::Bc7RGBAUnorm,
+                      Mn::Vector2i{8}, std::move(level0));
+  levels.emplace_back(Mn::CompressedPixelFormat::Bc7RGBAUnorm,
+                      Mn::Vector2i{4},
+                      Cr::Containers::Array<char>{Cr::Containers::ValueInit,
+                                                  16});
+  ASSERT_TRUE(esp::assets::saveTranscodedImage(levels, cacheFile));
+
+  std::vector<Mn::Trade::ImageData2D> loaded;
+  ASSERT_TRUE(esp::assets::loadTranscodedImage(cacheFile, loaded));
+  ASSERT_EQ(loaded.size(), 2u);
+  ASSERT_TRUE(loaded[0].isCompressed());
+  ASSERT_EQ(loaded[0].compressedFormat(),
+            Mn::CompressedPixelFormat::Bc7RGBAUnorm);
+  ASSERT_EQ(loaded[0].size(), Mn::Vector2i{8});
+  ASSERT_EQ(loaded[0].data().size(), 64u);
+  ASSERT_EQ(loaded[0].data()[5], 42);
+  ASSERT_EQ(loaded[1].size(), Mn::Vector2i{4});
+
+  // a missing or invalid file is a miss
+  Cr::Utility::Directory::rm(cacheFile);
+  ASSERT_FALSE(esp::assets::loadTranscodedImage(cacheFile, loaded));
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(cacheFile, "HSCN"));
+  ASSERT_FALSE(esp::assets::loadTranscodedImage(cacheFile, loaded));
+  ASSERT_TRUE(loaded.empty());
+  Cr::Utility::Directory::rm(cacheFile);
+}
+
+TEST(ResourceManagerTest, collisionMeshSharesMeshData) {
+  // 16-bit indices, which the collision data needs unpacked
+  Mn::Trade::MeshData sphere =
+      Mn::MeshTools::compressIndices(Mn::Primitives::icosphereSolid(1));
+  ASSERT_EQ(sphere.indexType(), Mn::MeshIndexType::UnsignedShort);
+  const Cr::Containers::Array<Mn::Vector3> positions =
+      sphere.positions3DAsArray();
+  const Cr::Containers::Array<Mn::UnsignedInt> indices =
+      sphere.indicesAsArray();
+
+  esp::assets::GenericMeshData mesh;
+  mesh.setMeshData(std::move(sphere));
+  const esp::assets::CollisionMeshData& collisionMeshData =
+      mesh.getCollisionMeshData();
+  const Mn::Trade::MeshData& meshData = *mesh.getMeshData();
+
+  // the collision data views the mesh instead of copies
+  const Cr::Containers::ArrayView<const char> vertexData =
+      meshData.vertexData();
+  EXPECT_GE(reinterpret_cast<const char*>(collisionMeshData.positions.data()),
+            vertexData.begin());
+  EXPECT_LE(reinterpret_cast<const char*>(collisionMeshData.positions.end()),
+            vertexData.end());
+  EXPECT_EQ(reinterpret_cast<const char*>(collisionMeshData.indices.data()),
+            meshData.indexData().data());
+
+  ASSERT_EQ(collisionMeshData.positions.size(), positions.size());
+  for (std::size_t i = 0; i != positions.size(); ++i) {
+    EXPECT_EQ(collisionMeshData.positions[i], positions[i]);
+  }
+  ASSERT_EQ(collisionMeshData.indices.size(), indices.size());
+  for (std::size_t i = 0; i != indices.size(); ++i) {
+    EXPECT_EQ(collisionMeshData.indices[i], indices[i]);
+  }
+  // the mesh still has all its attributes
+  EXPECT_TRUE(meshData.hasAttribute(Mn::Trade::MeshAttribute::Normal));
+}
+
+TEST(ResourceManagerTest, levelsOfDetail) {
+  esp::assets::GenericMeshData mesh;
+  mesh.setMeshData(Mn::Primitives::icosphereSolid(4));
+  const std::size_t indexCount = mesh.getCollisionMeshData().indices.size();
+
+  mesh.generateLevelsOfDetail(3);
+  const std::vector<esp::assets::GenericMeshData::LevelOfDetail>& levels =
+      mesh.getLevelsOfDetail();
+  ASSERT_EQ(levels.size(), 3u);
+
+  // every level is a range of whole triangles in the uploaded indices, which
+  // are the full detail followed by the levels, each at most as large as the
+  // previous one
+  std::size_t previousCount = indexCount;
+  for (const esp::assets::GenericMeshData::LevelOfDetail& level : levels) {
+    EXPECT_LE(level.indexOffset + level.indexCount,
+              indexCount + mesh.getLevelOfDetailIndices().size());
+    EXPECT_EQ(level.indexCount % 3, 0u);
+    EXPECT_GT(level.indexCount, 0u);
+    EXPECT_LE(level.indexCount, previousCount);
+    previousCount = level.indexCount;
+  }
+  EXPECT_LT(levels.back().indexCount, indexCount);
+
+  // the levels only reference existing vertices
+  const std::size_t vertexCount =
+      mesh.getCollisionMeshData().positions.size();
+  for (Mn::UnsignedInt index : mesh.getLevelOfDetailIndices()) {
+    EXPECT_LT(index, vertexCount);
+  }
+
+  // generating as many again keeps them, none removes them
+  const std::vector<Mn::UnsignedInt> indices = mesh.getLevelOfDetailIndices();
+  mesh.generateLevelsOfDetail(3);
+  EXPECT_EQ(mesh.getLevelOfDetailIndices(), indices);
+  mesh.generateLevelsOfDetail(0);
+  EXPECT_TRUE(mesh.getLevelsOfDetail().empty());
+  EXPECT_TRUE(mesh.getLevelOfDetailIndices().empty());
+}
+
+TEST(ResourceManagerTest, optimizeIndexOrder) {
+  esp::assets::GenericMeshData mesh;
+  mesh.setMeshData(Mn::Primitives::icosphereSolid(4));
+  const Cr::Containers::ArrayView<const Mn::Vector3> positions =
+      mesh.getCollisionMeshData().positions;
+  const Cr::Containers::ArrayView<const Mn::UnsignedInt> sphereIndices =
+      mesh.getCollisionMeshData().indices;
+
+  // the triangles in random order, as the worst case for the cache
+  std::vector<std::array<Mn::UnsignedInt, 3>> triangles;
+  for (std::size_t i = 0; i + 2 < sphereIndices.size(); i += 3) {
+    triangles.push_back(
+        {sphereIndices[i], sphereIndices[i + 1], sphereIndices[i + 2]});
+  }
+  std::shuffle(triangles.begin(), triangles.end(), std::mt19937{0});
+  std::vector<Mn::UnsignedInt> indices;
+  for (const std::array<Mn::UnsignedInt, 3>& triangle : triangles) {
+    indices.insert(indices.end(), triangle.begin(), triangle.end());
+  }
+  const float shuffledRatio =
+      esp::assets::averageCacheMissRatio(indices, positions.size());
+
+  esp::assets::optimizeVertexCache(indices, positions.size());
+  esp::assets::optimizeOverdraw(indices, positions);
+  const float optimizedRatio =
+      esp::assets::averageCacheMissRatio(indices, positions.size());
+  EXPECT_LT(optimizedRatio, 1.0f);
+  EXPECT_LT(optimizedRatio, shuffledRatio);
+
+  // the same triangles with the same winding, just reordered
+  const auto canonical = [](const std::vector<Mn::UnsignedInt>& indices) {
+    std::vector<std::array<Mn::UnsignedInt, 3>> result;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+      std::array<Mn::UnsignedInt, 3> triangle{indices[i], indices[i + 1],
+                                              indices[i + 2]};
+      std::rotate(triangle.begin(),
+                  std::min_element(triangle.begin(), triangle.end()),
+                  triangle.end());
+      result.push_back(triangle);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  const std::vector<Mn::UnsignedInt> original(sphereIndices.begin(),
+                                              sphereIndices.end());
+  EXPECT_EQ(canonical(indices), canonical(original));
+}
+
+TEST(ResourceManagerTest, transferObjectIds) {
+  const std::vector<Mn::Vector3> sourcePositions{
+      {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {-0.95f, 0.0f, 0.0f}};
+  const std::vector<Mn::UnsignedInt> sourceObjectIds{3, 7, 11};
+  const std::vector<Mn::Vector3> positions{{-0.02f, 0.01f, 0.0f},
+                                           {0.97f, 0.0f, 0.03f},
+                                           {-1.0f, 0.0f, 0.0f},
+                                           {0.4f, 0.0f, 0.0f},
+                                           {0.0f, 0.0f, -0.2f}};
+
+  // the nearest source vertex, across the cell boundaries at 0 too
+  const std::vector<Mn::UnsignedInt> objectIds = esp::assets::transferObjectIds(
+      positions, sourcePositions, sourceObjectIds, 0.1f);
+  const std::vector<Mn::UnsignedInt> expected{3, 7, 11, 0, 0};
+  EXPECT_EQ(objectIds, expected);
+
+  // a farther vertex is still not taken over a nearer one
+  const std::vector<Mn::UnsignedInt> farObjectIds =
+      esp::assets::transferObjectIds(positions, sourcePositions,
+                                     sourceObjectIds, 0.6f);
+  const std::vector<Mn::UnsignedInt> farExpected{3, 7, 11, 3, 3};
+  EXPECT_EQ(farObjectIds, farExpected);
+}
+
+TEST(ResourceManagerTest, gpuMemoryUsage) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  // must declare these in this order due to avoid deallocation errors
+  ResourceManager resourceManager;
+  SceneManager sceneManager_;
+  auto stageAttributesMgr = resourceManager.getStageAttributesManager();
+  std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  auto stageAttributes = stageAttributesMgr->createObject(boxFile, true);
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+  ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                        &sceneManager_, tempIDs, false));
+
+  // the 6 planes of the box, 24 vertices and 36 indices at the least
+  const esp::gfx::GpuMemoryUsage usage = resourceManager.getGpuMemoryUsage();
+  EXPECT_GE(usage.meshBytes, 24 * sizeof(Mn::Vector3) + 36 * 2);
+  EXPECT_EQ(usage.renderTargetBytes, 0u);
+  EXPECT_EQ(usage.totalBytes(), usage.meshBytes + usage.textureBytes +
+                                    usage.ptexAtlasBytes);
+
+  const std::map<std::string, std::size_t> assetBytes =
+      resourceManager.getAssetGpuBytes();
+  ASSERT_EQ(assetBytes.count(boxFile), 1u);
+  EXPECT_GE(assetBytes.at(boxFile), 24 * sizeof(Mn::Vector3) + 36 * 2);
+  // primitive assets may be loaded besides
+  EXPECT_LE(assetBytes.at(boxFile), usage.totalBytes());
+}
+
+TEST(ResourceManagerTest, maxTextureSize) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  // must declare these in this order due to avoid deallocation errors
+  ResourceManager resourceManager;
+  SceneManager sceneManager_;
+  resourceManager.setMaxTextureSize(64);
+  // the chair has a single 1024x1024 texture, halved down to 64x64
+  std::string chairFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/chair.glb");
+  auto stageAttributes =
+      resourceManager.getStageAttributesManager()->createObject(chairFile,
+                                                                true);
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+  ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                        &sceneManager_, tempIDs, false));
+  const std::size_t truncatedBytes =
+      resourceManager.getGpuMemoryUsage().textureBytes;
+  EXPECT_GT(truncatedBytes, 0u);
+  EXPECT_LE(truncatedBytes, 64 * 64 * 4 * 4 / 3);
+
+  // raising the limit loads the texture again at full resolution
+  resourceManager.setMaxTextureSize(0);
+  EXPECT_GE(resourceManager.getGpuMemoryUsage().textureBytes,
+            1024 * 1024 * 3);
+  // lowering it does not touch uploaded textures
+  resourceManager.setMaxTextureSize(64);
+  EXPECT_GE(resourceManager.getGpuMemoryUsage().textureBytes,
+            1024 * 1024 * 3);
+}
+
+TEST(ResourceManagerTest, sharedPrimitiveMeshes) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  ResourceManager first;
+  ResourceManager second;
+  // the synthesized object template is named after its primitive template
+  const std::vector<std::string> handles =
+      first.getAssetAttributesManager()->getTemplateHandlesByPrimType(
+          esp::metadata::PrimObjTypes::ICOSPHERE_SOLID);
+  ASSERT_EQ(handles.size(), 1u);
+  ASSERT_TRUE(first.instantiateAssetsOnDemand(handles[0]));
+  // the second manager reuses the mesh and uploads its own copy
+  ASSERT_TRUE(second.instantiateAssetsOnDemand(handles[0]));
+
+  const std::map<std::string, std::size_t> firstBytes =
+      first.getAssetGpuBytes();
+  const std::map<std::string, std::size_t> secondBytes =
+      second.getAssetGpuBytes();
+  ASSERT_EQ(firstBytes.count(handles[0]), 1u);
+  ASSERT_EQ(secondBytes.count(handles[0]), 1u);
+  EXPECT_GT(firstBytes.at(handles[0]), 0u);
+  EXPECT_EQ(firstBytes.at(handles[0]), secondBytes.at(handles[0]));
+}
+
+TEST(ResourceManagerTest, meshArena) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  // must declare these in this order due to avoid deallocation errors
+  ResourceManager resourceManager;
+  SceneManager sceneManager_;
+  resourceManager.setMeshArenaEnabled(true);
+  std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  auto stageAttributes =
+      resourceManager.getStageAttributesManager()->createObject(boxFile, true);
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+  ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                        &sceneManager_, tempIDs, false));
+
+  // all 6 planes of the box share one vertex and one index pool
+  const esp::assets::MeshArena& arena = resourceManager.getMeshArena();
+  EXPECT_GE(arena.poolCount(), 1u);
+  EXPECT_LE(arena.poolCount(), 2u);
+  EXPECT_GT(arena.getFreeBytes(), 0u);
+  EXPECT_GE(resourceManager.getGpuMemoryUsage().meshBytes,
+            arena.getFreeBytes() + 24 * sizeof(Mn::Vector3));
+}
+
+TEST(ResourceManagerTest, meshArenaFreeList) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  using esp::assets::MeshArena;
+  MeshArena arena{1024};
+  const std::vector<char> data(100, 'a');
+  MeshArena::Allocation first = arena.allocate(MeshArena::Kind::Vertex, data);
+  MeshArena::Allocation second = arena.allocate(MeshArena::Kind::Vertex, data);
+  MeshArena::Allocation third = arena.allocate(MeshArena::Kind::Vertex, data);
+  ASSERT_TRUE(first && second && third);
+  EXPECT_EQ(arena.poolCount(), 1u);
+  EXPECT_EQ(&first.buffer(), &third.buffer());
+  EXPECT_EQ(first.offset() % 16, 0u);
+  EXPECT_LT(first.offset(), second.offset());
+  EXPECT_LT(second.offset(), third.offset());
+
+  // the freed middle range is reused by the next allocation that fits
+  const std::size_t secondOffset = second.offset();
+  second = MeshArena::Allocation{};
+  EXPECT_EQ(arena.getFreeBytes(), 1024 - first.size() - third.size());
+  MeshArena::Allocation reused = arena.allocate(MeshArena::Kind::Vertex, data);
+  EXPECT_EQ(reused.offset(), secondOffset);
+
+  // data larger than a pool gets a pool of its own, indices another one
+  const std::vector<char> large(2000, 'b');
+  MeshArena::Allocation big = arena.allocate(MeshArena::Kind::Vertex, large);
+  MeshArena::Allocation index = arena.allocate(MeshArena::Kind::Index, data);
+  EXPECT_EQ(arena.poolCount(), 3u);
+  EXPECT_NE(&big.buffer(), &first.buffer());
+  EXPECT_NE(&index.buffer(), &first.buffer());
+
+  // a pool goes away with its last allocation
+  big = MeshArena::Allocation{};
+  EXPECT_EQ(arena.poolCount(), 2u);
+  EXPECT_FALSE(arena.allocate(MeshArena::Kind::Index, {}));
+}
@@ -3,6 +3,9 @@
 // LICENSE file in the root directory of this source tree.
 
 #include <gtest/gtest.h>
+#include <vector>
+
+#include <Magnum/SceneGraph/AbstractFeature.h>
 
 #include "esp/scene/SceneGraph.h"
 
@@ -38,3 +41,55 @@ TEST_F(SceneGraphTest, DeleteDrawableGroup) {
   EXPECT_EQ(g.getDrawableGroups().size(), numInitialGroups);
   ASSERT_EQ(g.getDrawableGroup(groupName), nullptr);
 }
+
+namespace {
+struct TestFeature : Magnum::SceneGraph::AbstractFeature3D {
+  TestFeature(esp::scene::SceneNode& node, int value)
+      : Magnum::SceneGraph::AbstractFeature3D{node}, value{value} {}
+  int value;
+};
+}  // namespace
+
+TEST_F(SceneGraphTest, PreOrderTraversal) {
+  esp::scene::SceneNode& root = g.getRootNode().createChild();
+  // root(0) -> [a(1) -> [b(2)], c(3) -> [d(4), e(5)]]
+  esp::scene::SceneNode& a = root.createChild();
+  esp::scene::SceneNode& b = a.createChild();
+  esp::scene::SceneNode& c = root.createChild();
+  esp::scene::SceneNode& d = c.createChild();
+  esp::scene::SceneNode& e = c.createChild();
+  int id = 0;
+  for (esp::scene::SceneNode* node : {&root, &a, &b, &c, &d, &e}) {
+    node->setId(id++);
+  }
+
+  std::vector<int> ids;
+  for (const esp::scene::SceneNode& node : esp::scene::preOrder(root)) {
+    ids.push_back(node.getId());
+  }
+  EXPECT_EQ(ids, (std::vector<int>{0, 1, 2, 3, 4, 5}));
+
+  // a subtree stops at its root, even with siblings after it
+  ids.clear();
+  esp::scene::preOrderTraversalWithCallback(
+      c, [&](esp::scene::SceneNode& node) { ids.push_back(node.getId()); });
+  EXPECT_EQ(ids, (std::vector<int>{3, 4, 5}));
+
+  b.addFeature<TestFeature>(1);
+  c.addFeature<TestFeature>(2);
+  e.addFeature<TestFeature>(3);
+  e.addFeature<TestFeature>(4);
+  std::vector<int> values;
+  for (TestFeature& feature : esp::scene::preOrderFeatures<TestFeature>(root)) {
+    values.push_back(feature.value);
+  }
+  EXPECT_EQ(values, (std::vector<int>{1, 2, 3, 4}));
+
+  values.clear();
+  const esp::scene::SceneNode& constA = a;
+  for (const TestFeature& feature :
+       esp::scene::preOrderFeatures<TestFeature>(constA)) {
+    values.push_back(feature.value);
+  }
+  EXPECT_EQ(values, (std::vector<int>{1}));
+}
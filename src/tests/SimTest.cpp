@@ -2,19 +2,41 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/Optional.h>
 #include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/TestSuite/Compare/Numeric.h>
 #include <Corrade/TestSuite/Tester.h>
+#include <Corrade/Utility/DebugStl.h>
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/DebugTools/CompareImage.h>
 #include <Magnum/EigenIntegration/Integration.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Magnum.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/FunctionsBatch.h>
 #include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/AbstractImporter.h>
+#include <Magnum/Trade/ImageData.h>
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/FrameEncoder.h"
+#include "esp/gfx/IndirectDrawBatch.h"
+#include "esp/gfx/RenderTarget.h"
+#include "esp/gfx/Renderer.h"
 #include "esp/physics/RigidObject.h"
+#include "esp/sensor/CubeMapCamera.h"
+#include "esp/sensor/LidarSensor.h"
+#include "esp/sensor/TopDownMapCamera.h"
+#include "esp/sim/EpisodeScheduler.h"
 #include "esp/sim/Simulator.h"
+#include "esp/sim/VectorSimulator.h"
 
 #include "configure.h"
 
@@ -25,6 +47,7 @@ using esp::agent::Agent;
 using esp::agent::AgentConfiguration;
 using esp::agent::AgentState;
 using esp::assets::ResourceManager;
+using esp::core::SharedMemoryRing;
 using esp::gfx::LightInfo;
 using esp::gfx::LightPositionModel;
 using esp::gfx::LightSetup;
@@ -37,8 +60,15 @@ using esp::sensor::ObservationSpace;
 using esp::sensor::ObservationSpaceType;
 using esp::sensor::SensorSpec;
 using esp::sensor::SensorType;
+using esp::sim::EpisodeScheduler;
+using esp::sim::SessionEvent;
+using esp::sim::SessionEventType;
+using esp::sim::SessionRecording;
+using esp::sim::SessionReplayTimes;
 using esp::sim::Simulator;
 using esp::sim::SimulatorConfiguration;
+using esp::sim::VectorSimulator;
+using esp::sim::ViewCache;
 
 namespace {
 
@@ -86,6 +116,45 @@ struct SimTest : Cr::TestSuite::Tester {
   void reconfigure();
   void reset();
   void getSceneRGBAObservation();
+  void getAsyncRGBAObservation();
+  void getSharedRenderObservations();
+  void getVectorSimulatorObservations();
+  void getThreadedVectorSimulatorObservations();
+  void step();
+  void stepActionIndices();
+  void actAll();
+  void recordReplaySession();
+  void renderOnlySimulator();
+  void cloneSimulator();
+  void cloneKeepsStageAssets();
+  void agentVelocityControl();
+  void pipelinedStep();
+  void stepAsyncPhysics();
+  void reuseRenderTargets();
+  void saveFrame();
+  void writeObservationsToSharedMemoryRing();
+  void writeObservationDataset();
+  void scheduleEpisodesByScene();
+  void getAgentObservationsInPlace();
+  void getCachedObservation();
+  void getViewCachedObservation();
+  void getScheduledObservations();
+  void getLayeredObservation();
+  void getFusedDepthObservation();
+  void getDepthOnlyObservation();
+  void getSurfaceNormalObservation();
+  void getOpticalFlowObservation();
+  void getStereoDepthObservation();
+  void getGpuDrivenDepthObservation();
+  void getCubeMapObservation();
+  void getConvertedObservation();
+  void getMultisampledObservation();
+  void getOcclusionCulledObservation();
+  void getTopDownMapObservation();
+  void getLidarObservation();
+  void getSemanticCategoryObservation();
+  void readVisibleObjects();
+  void getInstancedObjectsRGBAObservation();
   void getSceneWithLightingRGBAObservation();
   void getDefaultLightingRGBAObservation();
   void getCustomLightingRGBAObservation();
@@ -94,6 +163,7 @@ struct SimTest : Cr::TestSuite::Tester {
   void multipleLightingSetupsRGBAObservation();
   void recomputeNavmeshWithStaticObjects();
   void loadingObjectTemplates();
+  void loadSceneInstance();
   void buildingPrimAssetObjectTemplates();
 
   // TODO: remove outlier pixels from image and lower maxThreshold
@@ -111,6 +181,45 @@ SimTest::SimTest() {
             &SimTest::reconfigure,
             &SimTest::reset,
             &SimTest::getSceneRGBAObservation,
+            &SimTest::getAsyncRGBAObservation,
+            &SimTest::getSharedRenderObservations,
+            &SimTest::getVectorSimulatorObservations,
+            &SimTest::getThreadedVectorSimulatorObservations,
+            &SimTest::step,
+            &SimTest::stepActionIndices,
+            &SimTest::actAll,
+            &SimTest::recordReplaySession,
+            &SimTest::renderOnlySimulator,
+            &SimTest::cloneSimulator,
+            &SimTest::cloneKeepsStageAssets,
+            &SimTest::agentVelocityControl,
+            &SimTest::pipelinedStep,
+            &SimTest::stepAsyncPhysics,
+            &SimTest::reuseRenderTargets,
+            &SimTest::saveFrame,
+            &SimTest::writeObservationsToSharedMemoryRing,
+            &SimTest::writeObservationDataset,
+            &SimTest::scheduleEpisodesByScene,
+            &SimTest::getAgentObservationsInPlace,
+            &SimTest::getCachedObservation,
+            &SimTest::getViewCachedObservation,
+            &SimTest::getScheduledObservations,
+            &SimTest::getLayeredObservation,
+            &SimTest::getFusedDepthObservation,
+            &SimTest::getDepthOnlyObservation,
+            &SimTest::getSurfaceNormalObservation,
+            &SimTest::getOpticalFlowObservation,
+            &SimTest::getStereoDepthObservation,
+            &SimTest::getGpuDrivenDepthObservation,
+            &SimTest::getCubeMapObservation,
+            &SimTest::getConvertedObservation,
+            &SimTest::getMultisampledObservation,
+            &SimTest::getOcclusionCulledObservation,
+            &SimTest::getTopDownMapObservation,
+            &SimTest::getLidarObservation,
+            &SimTest::getSemanticCategoryObservation,
+            &SimTest::readVisibleObjects,
+            &SimTest::getInstancedObjectsRGBAObservation,
             &SimTest::getSceneWithLightingRGBAObservation,
             &SimTest::getDefaultLightingRGBAObservation,
             &SimTest::getCustomLightingRGBAObservation,
@@ -119,6 +228,7 @@ SimTest::SimTest() {
             &SimTest::multipleLightingSetupsRGBAObservation,
             &SimTest::recomputeNavmeshWithStaticObjects,
             &SimTest::loadingObjectTemplates,
+            &SimTest::loadSceneInstance,
             &SimTest::buildingPrimAssetObjectTemplates});
   // clang-format on
 }
@@ -221,6 +331,2017 @@ void SimTest::getSceneRGBAObservation() {
                                     maxThreshold, 0.75f);
 }
 
+void SimTest::getAsyncRGBAObservation() {
+  auto simulator = getSimulator(vangogh);
+
+  auto pinholeCameraSpec = SensorSpec::create();
+  pinholeCameraSpec->sensorSubtype = "pinhole";
+  pinholeCameraSpec->sensorType = SensorType::COLOR;
+  pinholeCameraSpec->position = {1.0f, 1.5f, 1.0f};
+  pinholeCameraSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {pinholeCameraSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+
+  const auto getObservation = [&]() {
+    Observation observation;
+    CORRADE_INTERNAL_ASSERT_OUTPUT(simulator->getAgentObservation(
+        0, pinholeCameraSpec->uuid, observation));
+    return std::vector<uint8_t>(observation.buffer->data.begin(),
+                                observation.buffer->data.end());
+  };
+
+  // synchronous ground truth at two different poses
+  const std::vector<uint8_t> first = getObservation();
+  agent->node().translate({0.5f, 0.0f, 0.0f});
+  const std::vector<uint8_t> second = getObservation();
+  CORRADE_VERIFY(first != second);
+
+  agent->node().translate({-0.5f, 0.0f, 0.0f});
+  simulator->setAsyncObservationReadbackEnabled(true);
+  CORRADE_VERIFY(simulator->isAsyncObservationReadbackEnabled());
+
+  // the first call returns its own frame, later ones lag one call behind
+  CORRADE_VERIFY(getObservation() == first);
+  agent->node().translate({0.5f, 0.0f, 0.0f});
+  CORRADE_VERIFY(getObservation() == first);
+  CORRADE_VERIFY(getObservation() == second);
+
+  // disabling drops the pending frame and reads synchronously again
+  simulator->setAsyncObservationReadbackEnabled(false);
+  agent->node().translate({-0.5f, 0.0f, 0.0f});
+  CORRADE_VERIFY(getObservation() == first);
+}
+
+void SimTest::getSharedRenderObservations() {
+  auto simulator = getSimulator(vangogh);
+
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  auto depthSpec = SensorSpec::create();
+  *depthSpec = *colorSpec;
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::DEPTH;
+  depthSpec->channels = 1;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+
+  const auto getObservations = [&]() {
+    std::map<std::string, Observation> observations;
+    CORRADE_INTERNAL_ASSERT_OUTPUT(
+        simulator->getAgentObservations(0, observations) == 2);
+    std::map<std::string, std::vector<uint8_t>> data;
+    for (const auto& it : observations) {
+      data[it.first] = std::vector<uint8_t>(it.second.buffer->data.begin(),
+                                            it.second.buffer->data.end());
+    }
+    return data;
+  };
+
+  const auto expected = getObservations();
+  simulator->setSharedSensorRenderEnabled(true);
+  CORRADE_VERIFY(simulator->isSharedSensorRenderEnabled());
+  const auto shared = getObservations();
+  CORRADE_VERIFY(shared.at("color") == expected.at("color"));
+  CORRADE_VERIFY(shared.at("depth") == expected.at("depth"));
+}
+
+void SimTest::getVectorSimulatorObservations() {
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  std::vector<uint8_t> expected;
+  {
+    Simulator simulator(simConfig);
+    simulator.addAgent(agentConfig)->setState(AgentState{});
+    Observation observation;
+    CORRADE_VERIFY(simulator.getAgentObservation(0, "color", observation));
+    expected.assign(observation.buffer->data.begin(),
+                    observation.buffer->data.end());
+  }
+
+  VectorSimulator envs{{simConfig, simConfig}, agentConfig};
+  CORRADE_COMPARE(envs.getNumEnvs(), 2);
+  for (int i = 0; i < envs.getNumEnvs(); ++i) {
+    envs.getAgent(i)->setState(AgentState{});
+  }
+
+  const auto& observations = envs.stepAll({"", ""});
+  CORRADE_COMPARE(observations.size(), 1);
+  const esp::core::Buffer& batch = *observations.at("color");
+  CORRADE_VERIFY(batch.shape == (std::vector<size_t>{2, 128, 128, 4}));
+  const auto frame = [&](int envId) {
+    const uint8_t* begin = batch.data.data() + envId * expected.size();
+    return std::vector<uint8_t>(begin, begin + expected.size());
+  };
+  CORRADE_VERIFY(frame(0) == expected);
+  CORRADE_VERIFY(frame(1) == expected);
+
+  // only the second agent moves
+  envs.stepAll({"", "turnLeft"});
+  CORRADE_VERIFY(frame(0) == expected);
+  CORRADE_VERIFY(frame(1) != expected);
+}
+
+void SimTest::getThreadedVectorSimulatorObservations() {
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  std::vector<uint8_t> expected;
+  {
+    VectorSimulator envs{{simConfig}, agentConfig};
+    envs.getAgent(0)->setState(AgentState{});
+    const auto& observations = envs.getObservations();
+    const esp::core::Buffer& batch = *observations.at("color");
+    expected.assign(batch.data.begin(), batch.data.end());
+  }
+
+  // each environment on its thread, drawing the meshes and textures loaded
+  // once into a shared context
+  VectorSimulator envs{{simConfig, simConfig, simConfig}, agentConfig, true};
+  CORRADE_VERIFY(envs.isThreaded());
+  CORRADE_COMPARE(envs.getNumEnvs(), 3);
+  for (int i = 0; i < envs.getNumEnvs(); ++i) {
+    envs.getAgent(i)->setState(AgentState{});
+  }
+
+  const auto& observations = envs.stepAll({"", "", ""});
+  const esp::core::Buffer& batch = *observations.at("color");
+  CORRADE_VERIFY(batch.shape == (std::vector<size_t>{3, 128, 128, 4}));
+  const auto frame = [&](int envId) {
+    const uint8_t* begin = batch.data.data() + envId * expected.size();
+    return std::vector<uint8_t>(begin, begin + expected.size());
+  };
+  for (int i = 0; i < envs.getNumEnvs(); ++i) {
+    CORRADE_VERIFY(frame(i) == expected);
+  }
+
+  envs.stepAll({"turnLeft", "", ""});
+  CORRADE_VERIFY(frame(0) != expected);
+  CORRADE_VERIFY(frame(1) == expected);
+  CORRADE_VERIFY(frame(2) == expected);
+}
+
+void SimTest::step() {
+  auto simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  simulator->addAgent(agentConfig)->setState(AgentState{});
+
+  std::map<int, std::map<std::string, Observation>> observations;
+  CORRADE_VERIFY(simulator->step({}, observations));
+  CORRADE_COMPARE(observations.size(), 1);
+  CORRADE_COMPARE(observations.at(0).size(), 1);
+  const std::vector<uint8_t> before(
+      observations.at(0).at("color").buffer->data.begin(),
+      observations.at(0).at("color").buffer->data.end());
+
+  CORRADE_VERIFY(simulator->step({{0, "turnLeft"}}, observations));
+  CORRADE_VERIFY(simulator->getWorldTime() > 0.0);
+  const std::vector<uint8_t> after(
+      observations.at(0).at("color").buffer->data.begin(),
+      observations.at(0).at("color").buffer->data.end());
+  CORRADE_VERIFY(after != before);
+
+  // an unknown action is skipped, the others still step and observe
+  CORRADE_VERIFY(!simulator->step({{0, "fly"}}, observations));
+  CORRADE_COMPARE(observations.at(0).size(), 1);
+}
+
+void SimTest::stepActionIndices() {
+  auto simulator = getSimulator(vangogh);
+  AgentConfiguration agentConfig{};
+  auto agent = simulator->addAgent(agentConfig);
+  agent->setState(AgentState{});
+  CORRADE_COMPARE(agent->getNumActions(), agentConfig.actionSpace.size());
+  CORRADE_COMPARE(agent->getActionIndex("fly"), esp::ID_UNDEFINED);
+  const int moveForward = agent->getActionIndex("moveForward");
+  CORRADE_VERIFY(moveForward >= 0);
+
+  // acting by index moves the agent like acting by name
+  AgentState::ptr byName = AgentState::create();
+  CORRADE_VERIFY(agent->act("moveForward"));
+  agent->getState(byName);
+  agent->setState(AgentState{});
+  AgentState::ptr byIndex = AgentState::create();
+  CORRADE_VERIFY(agent->act(moveForward));
+  agent->getState(byIndex);
+  CORRADE_VERIFY(byIndex->position.isApprox(byName->position));
+  CORRADE_VERIFY(!agent->act(agent->getNumActions()));
+
+  std::map<int, std::map<std::string, Observation>> observations;
+  agent->setState(AgentState{});
+  CORRADE_VERIFY(simulator->stepByActionIndices({moveForward}, observations));
+  agent->getState(byIndex);
+  CORRADE_VERIFY(byIndex->position.isApprox(byName->position));
+  CORRADE_COMPARE(observations.at(0).size(), 1);
+  // a negative index is no action
+  CORRADE_VERIFY(simulator->stepByActionIndices({-1}, observations));
+  agent->getState(byIndex);
+  CORRADE_VERIFY(byIndex->position.isApprox(byName->position));
+}
+
+void SimTest::actAll() {
+  auto simulator = getSimulator(vangogh);
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {};
+  constexpr int numAgents = 16;
+  std::vector<Agent::ptr> agents;
+  for (int i = 0; i < numAgents; ++i) {
+    agents.push_back(simulator->addAgent(agentConfig));
+  }
+  const int moveForward = agents[0]->getActionIndex("moveForward");
+  const int turnLeft = agents[0]->getActionIndex("turnLeft");
+
+  // the batched moves end where acting one by one does
+  std::vector<AgentState::ptr> expected;
+  for (int i = 0; i < numAgents; ++i) {
+    AgentState::ptr state = AgentState::create();
+    agents[i]->reset();
+    agents[i]->act(i % 2 ? moveForward : turnLeft);
+    agents[i]->getState(state);
+    expected.push_back(state);
+    agents[i]->reset();
+  }
+  std::vector<int> actions;
+  for (int i = 0; i < numAgents; ++i) {
+    actions.push_back(i % 2 ? moveForward : turnLeft);
+  }
+  CORRADE_VERIFY(simulator->actAll(actions, 4));
+  for (int i = 0; i < numAgents; ++i) {
+    CORRADE_ITERATION(i);
+    AgentState::ptr state = AgentState::create();
+    agents[i]->getState(state);
+    CORRADE_VERIFY(state->position.isApprox(expected[i]->position));
+    CORRADE_VERIFY(state->rotation.isApprox(expected[i]->rotation));
+  }
+
+  actions[0] = agents[0]->getNumActions();
+  CORRADE_VERIFY(!simulator->actAll(actions));
+}
+
+void SimTest::recordReplaySession() {
+  auto simulator = getSimulator(vangogh);
+  simulator->startRecording();
+  CORRADE_VERIFY(simulator->isRecording());
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->resolution = {64, 64};
+  colorSpec->updatePeriod = 3;
+  colorSpec->noiseModel = "GaussianNoiseModel";
+  colorSpec->noiseModelKwargs = {{"intensity_constant", "0.1"}};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  simulator->addAgent(agentConfig)->setState(AgentState{});
+  simulator->seed(7);
+  std::map<int, std::map<std::string, Observation>> observations;
+  CORRADE_VERIFY(simulator->step({{0, "moveForward"}}, observations));
+  CORRADE_VERIFY(simulator->step({{0, "turnLeft"}}, observations));
+  AgentState::ptr recorded = AgentState::create();
+  simulator->getAgent(0)->getState(recorded);
+
+  const std::string filename = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "SimTest.session");
+  CORRADE_VERIFY(simulator->stopRecording(filename));
+  CORRADE_VERIFY(!simulator->isRecording());
+
+  SessionRecording recording;
+  CORRADE_VERIFY(SessionRecording::load(filename, recording));
+  CORRADE_COMPARE(recording.scene, vangogh);
+  CORRADE_VERIFY(recording.events.size() >= 4);
+  CORRADE_VERIFY(recording.events[0].type == SessionEventType::AddAgent);
+  CORRADE_COMPARE(
+      recording.events[0].agentConfig.sensorSpecifications.size(), 1);
+  CORRADE_VERIFY(*recording.events[0].agentConfig.sensorSpecifications[0] ==
+                 *colorSpec);
+  CORRADE_VERIFY(recording.events[1].type == SessionEventType::Seed);
+  CORRADE_COMPARE(recording.events[1].seed, 7);
+  CORRADE_VERIFY(
+      std::count_if(recording.events.begin(), recording.events.end(),
+                    [](const SessionEvent& event) {
+                      return event.type == SessionEventType::ActByName;
+                    }) == 2);
+
+  // the replayed agent ends where the recorded one did
+  auto replayed = getSimulator(vangogh);
+  SessionReplayTimes times;
+  CORRADE_VERIFY(esp::sim::replaySession(*replayed, recording, &times));
+  CORRADE_COMPARE(times.calls[int(SessionEventType::ActByName)], 2);
+  AgentState::ptr state = AgentState::create();
+  replayed->getAgent(0)->getState(state);
+  CORRADE_VERIFY(state->position.isApprox(recorded->position));
+  CORRADE_VERIFY(state->rotation.isApprox(recorded->rotation));
+  Cr::Utility::Directory::rm(filename);
+}
+
+void SimTest::renderOnlySimulator() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  simConfig.enablePhysics = true;
+  simConfig.physicsConfigFile = physicsConfigFile;
+  simConfig.renderOnly = true;
+  auto simulator = Simulator::create_unique(simConfig);
+  CORRADE_COMPARE(simulator->getPhysicsSimulationLibrary(),
+                  esp::physics::PhysicsManager::PhysicsSimulationLibrary::NONE);
+
+  // objects still render and move kinematically, in bulk
+  auto objs = simulator->getObjectAttributesManager()
+                  ->getObjectHandlesBySubstring("nested_box");
+  std::vector<int> objectIDs;
+  for (int i = 0; i < 2; ++i) {
+    objectIDs.push_back(simulator->addObjectByHandle(objs[0]));
+    CORRADE_VERIFY(objectIDs.back() != esp::ID_UNDEFINED);
+  }
+  const std::vector<Mn::Vector3> translations{{1.0f, 0.5f, -0.5f},
+                                              {0.4f, 0.5f, -0.5f}};
+  const std::vector<Mn::Quaternion> rotations(2, Mn::Quaternion{});
+  simulator->setRigidStates(objectIDs, translations, rotations);
+  CORRADE_COMPARE(simulator->getTranslation(objectIDs[1]), translations[1]);
+  simulator->stepWorld(0.1);
+  CORRADE_COMPARE(simulator->getTranslation(objectIDs[1]), translations[1]);
+}
+
+void SimTest::cloneSimulator() {
+  auto simulator = getSimulator(vangogh);
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {};
+  auto agent = simulator->addAgent(agentConfig);
+  auto objs = simulator->getObjectAttributesManager()
+                  ->getObjectHandlesBySubstring("nested_box");
+  std::vector<int> objectIDs;
+  for (int i = 0; i < 3; ++i) {
+    objectIDs.push_back(simulator->addObjectByHandle(objs[0]));
+  }
+  // the clone allocates the same IDs after a removal
+  simulator->removeObject(objectIDs[1]);
+  const Mn::Vector3 translation{1.0f, 0.5f, -0.5f};
+  simulator->setTranslation(translation, objectIDs[2]);
+
+  auto clone = simulator->clone();
+  CORRADE_VERIFY(clone->getPathFinder() == simulator->getPathFinder());
+  CORRADE_COMPARE(clone->getExistingObjectIDs().size(), 2);
+  CORRADE_COMPARE(clone->getTranslation(objectIDs[2]), translation);
+  AgentState::ptr state = AgentState::create();
+  AgentState::ptr cloneState = AgentState::create();
+  agent->getState(state);
+  clone->getAgent(0)->getState(cloneState);
+  CORRADE_VERIFY(cloneState->position.isApprox(state->position));
+  CORRADE_VERIFY(cloneState->rotation.isApprox(state->rotation));
+  CORRADE_COMPARE(clone->addObjectByHandle(objs[0]),
+                  simulator->addObjectByHandle(objs[0]));
+
+  // the rollout doesn't change the source
+  clone->setTranslation(Mn::Vector3{0.0f, 2.0f, 0.0f}, objectIDs[2]);
+  clone->stepWorld(0.5);
+  CORRADE_COMPARE(simulator->getTranslation(objectIDs[2]), translation);
+}
+
+void SimTest::cloneKeepsStageAssets() {
+  SimulatorConfiguration cfg;
+  cfg.scene.id = vangogh;
+  // every stage load releases all the stage assets it can
+  cfg.assetCacheCpuBudget = 1;
+  cfg.assetCacheGpuBudget = 1;
+  auto simulator = Simulator::create_unique(cfg);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  simulator->addAgent(agentConfig)->setState(AgentState{});
+
+  auto clone = simulator->clone();
+  std::vector<Observation> observations;
+  CORRADE_COMPARE(clone->getAgentObservations(0, observations), 1);
+  const std::vector<uint8_t> before(observations[0].buffer->data.begin(),
+                                    observations[0].buffer->data.end());
+
+  // the stage of the source is released, not the one the clone draws
+  SimulatorConfiguration otherCfg = cfg;
+  otherCfg.scene.id = skokloster;
+  simulator->reconfigure(otherCfg);
+  CORRADE_COMPARE(clone->getAgentObservations(0, observations), 1);
+  CORRADE_VERIFY(std::equal(before.begin(), before.end(),
+                            observations[0].buffer->data.begin()));
+}
+
+void SimTest::agentVelocityControl() {
+  auto simulator = getSimulator(vangogh);
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {};
+  auto agent = simulator->addAgent(agentConfig);
+  AgentState::ptr before = AgentState::create();
+  agent->getState(before);
+
+  // nothing controlled, nothing moves
+  simulator->stepWorld(0.5);
+  AgentState::ptr after = AgentState::create();
+  agent->getState(after);
+  CORRADE_VERIFY(after->position.isApprox(before->position));
+
+  auto velocityControl = agent->getVelocityControl();
+  velocityControl->controllingLinVel = true;
+  velocityControl->linVelIsLocal = true;
+  velocityControl->linVel = Magnum::Vector3{0.0f, 0.0f, -1.0f};
+  velocityControl->controllingAngVel = true;
+  velocityControl->angVel = Magnum::Vector3{0.0f, 1.0f, 0.0f};
+  for (int i = 0; i < 10; ++i) {
+    simulator->stepWorld(0.1);
+    agent->getState(after);
+    CORRADE_ITERATION(i);
+    CORRADE_VERIFY(simulator->getPathFinder()->isNavigable(after->position));
+  }
+  CORRADE_VERIFY(!after->position.isApprox(before->position));
+  CORRADE_VERIFY(!after->rotation.isApprox(before->rotation));
+}
+
+void SimTest::pipelinedStep() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  simConfig.pipelinedStep = true;
+  Simulator simulator(simConfig);
+  CORRADE_VERIFY(simulator.isAsyncObservationReadbackEnabled());
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+
+  std::map<int, std::map<std::string, Observation>> observations;
+  const auto step = [&](const std::map<int, std::string>& actions) {
+    CORRADE_INTERNAL_ASSERT_OUTPUT(simulator.step(actions, observations));
+    const esp::core::Buffer& buffer = *observations.at(0).at("color").buffer;
+    return std::vector<uint8_t>(buffer.data.begin(), buffer.data.end());
+  };
+
+  // the first step returns its own frame, the others the previous one
+  const std::vector<uint8_t> first = step({});
+  CORRADE_VERIFY(step({{0, "turnLeft"}}) == first);
+  CORRADE_VERIFY(step({}) != first);
+}
+
+void SimTest::stepAsyncPhysics() {
+  // the same steps end in the same state with and without the physics thread
+  Mn::Vector3 translations[2];
+  double worldTimes[2];
+  AgentState::ptr agentStates[2] = {AgentState::create(),
+                                    AgentState::create()};
+  for (int async : {0, 1}) {
+    CORRADE_ITERATION(async);
+    auto simulator = getSimulator(vangogh);
+    AgentConfiguration agentConfig{};
+    agentConfig.sensorSpecifications = {};
+    Agent::ptr agent = simulator->addAgent(agentConfig);
+    agent->setState(AgentState{});
+    auto objs = simulator->getObjectAttributesManager()
+                    ->getObjectHandlesBySubstring("nested_box");
+    const int objectID = simulator->addObjectByHandle(objs[0]);
+    CORRADE_VERIFY(objectID != esp::ID_UNDEFINED);
+    // falls during the steps
+    simulator->setTranslation({1.0f, 2.0f, -1.0f}, objectID);
+    simulator->setAsyncPhysicsEnabled(async);
+    simulator->setProfilingEnabled(true);
+    simulator->resetProfilingStats();
+
+    std::map<int, std::map<std::string, Observation>> observations;
+    for (int i = 0; i < 20; ++i) {
+      CORRADE_VERIFY(simulator->step(
+          {{0, i % 2 ? "moveForward" : "turnLeft"}}, observations));
+    }
+    // waits for the last step
+    translations[async] = simulator->getTranslation(objectID);
+    worldTimes[async] = simulator->getWorldTime();
+    agent->getState(agentStates[async]);
+
+    // the steps on the physics thread are profiled as well
+    CORRADE_COMPARE(simulator->getProfilingStats().physics.calls, 20);
+    simulator->setProfilingEnabled(false);
+  }
+  CORRADE_VERIFY(translations[0].y() < 2.0f);
+  CORRADE_COMPARE(translations[1], translations[0]);
+  CORRADE_COMPARE(worldTimes[1], worldTimes[0]);
+  CORRADE_VERIFY(agentStates[1]->position.isApprox(agentStates[0]->position));
+  CORRADE_VERIFY(agentStates[1]->rotation.isApprox(agentStates[0]->rotation));
+}
+
+void SimTest::reuseRenderTargets() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  const auto visualSensor = [&](int agentId) -> esp::sensor::VisualSensor& {
+    return static_cast<esp::sensor::VisualSensor&>(
+        *simulator.getAgent(agentId)->getSensorSuite().get("color"));
+  };
+
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+  Observation observation;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "color", observation));
+  const esp::gfx::RenderTarget* target = &visualSensor(0).renderTarget();
+  const esp::core::Buffer* buffer = observation.buffer.get();
+  observation.buffer = nullptr;
+
+  // the sensor of an agent re-created with the same specification gets the
+  // target and buffer of the old one
+  esp::gfx::Renderer& renderer = *simulator.getRenderer();
+  renderer.releaseRenderTarget(visualSensor(0));
+  CORRADE_VERIFY(!visualSensor(0).hasRenderTarget());
+  CORRADE_COMPARE(renderer.numReleasedRenderTargets(), 1);
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+  CORRADE_COMPARE(renderer.numReleasedRenderTargets(), 0);
+  CORRADE_VERIFY(&visualSensor(1).renderTarget() == target);
+  CORRADE_VERIFY(simulator.getAgentObservation(1, "color", observation));
+  CORRADE_VERIFY(observation.buffer.get() == buffer);
+
+  // a buffer an observation still holds is not reused
+  renderer.releaseRenderTarget(visualSensor(1));
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+  CORRADE_VERIFY(&visualSensor(2).renderTarget() == target);
+  CORRADE_VERIFY(!visualSensor(2).hasObservationBuffer());
+}
+
+void SimTest::saveFrame() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {96, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+  Observation observation;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "color", observation));
+
+  const std::string png =
+      Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(), "frame.png");
+  const std::string jpeg =
+      Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(), "frame.jpg");
+  CORRADE_VERIFY(simulator.saveFrame(0, "color", png));
+  CORRADE_VERIFY(!simulator.saveFrame(0, "nonexistent", jpeg));
+  simulator.saveFrame(jpeg);
+  esp::gfx::FrameEncoder& encoder = simulator.getFrameEncoder();
+  encoder.wait();
+  CORRADE_COMPARE(encoder.numPending(), size_t{0});
+  CORRADE_COMPARE(encoder.numWritten(), size_t{2});
+  CORRADE_COMPARE(encoder.numFailed(), size_t{0});
+  CORRADE_VERIFY(Cr::Utility::Directory::exists(jpeg));
+
+  // the PNG has the pixels of the observation, with the top row first
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImporter> manager;
+  Cr::Containers::Pointer<Mn::Trade::AbstractImporter> importer =
+      manager.loadAndInstantiate("AnyImageImporter");
+  CORRADE_VERIFY(importer);
+  CORRADE_VERIFY(importer->openFile(png));
+  Cr::Containers::Optional<Mn::Trade::ImageData2D> image = importer->image2D(0);
+  CORRADE_VERIFY(image);
+  CORRADE_COMPARE(image->size(), (Mn::Vector2i{128, 96}));
+  const Cr::Containers::StridedArrayView3D<const char> pixels =
+      image->pixels();
+  const size_t pixelSize = image->pixelSize();
+  CORRADE_COMPARE(pixelSize, size_t{4});
+  size_t numDifferent = 0;
+  for (int y = 0; y < 96; ++y) {
+    for (int x = 0; x < 128; ++x) {
+      const uint8_t* expected =
+          observation.buffer->data.data() + ((95 - y) * 128 + x) * 4;
+      numDifferent += std::memcmp(&pixels[y][x][0], expected, 4) != 0;
+    }
+  }
+  CORRADE_COMPARE(numDifferent, size_t{0});
+
+  importer->close();
+  Cr::Utility::Directory::rm(png);
+  Cr::Utility::Directory::rm(jpeg);
+}
+
+void SimTest::writeObservationsToSharedMemoryRing() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+
+  // the ring of one process, opened again as another process would
+  SharedMemoryRing writer{"esp-SimTest-ring", 2,
+                          simulator.getAgentObservationFields(0)};
+  SharedMemoryRing reader{"esp-SimTest-ring"};
+  CORRADE_COMPARE(reader.numSlots(), 2);
+  CORRADE_COMPARE(reader.slotSize(), writer.slotSize());
+  CORRADE_COMPARE(reader.fields().size(), 1);
+  CORRADE_COMPARE(reader.fields()[0].name, "color");
+  CORRADE_VERIFY(reader.fields()[0].shape ==
+                 (std::vector<size_t>{128, 128, 4}));
+
+  CORRADE_VERIFY(simulator.getAgentObservations(0, writer, 1));
+  CORRADE_COMPARE(reader.sequence(0), 0);
+  CORRADE_COMPARE(reader.sequence(1), 1);
+
+  Observation observation;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "color", observation));
+  esp::core::Buffer::ptr field = reader.field(1, "color");
+  CORRADE_VERIFY(field->isExternal());
+  CORRADE_VERIFY(std::equal(field->data.begin(), field->data.end(),
+                            observation.buffer->data.begin()));
+  // the sensor got its own buffer back
+  CORRADE_VERIFY(observation.buffer->data.data() != field->data.data());
+  CORRADE_VERIFY(!reader.field(2, "color"));
+  CORRADE_VERIFY(!reader.field(1, "depth"));
+}
+
+void SimTest::writeObservationDataset() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {64, 64};
+  auto depthSpec = SensorSpec::create();
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::DEPTH;
+  depthSpec->position = {1.0f, 1.5f, 1.0f};
+  depthSpec->resolution = {64, 64};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+
+  const std::vector<SharedMemoryRing::Field> fields =
+      simulator.getAgentDatasetFields(0);
+  CORRADE_COMPARE(fields.size(), size_t{5});
+  CORRADE_COMPARE(fields[0].name, "color");
+  CORRADE_COMPARE(fields[1].name, "depth");
+  CORRADE_COMPARE(fields[2].name, "action");
+  CORRADE_COMPARE(fields[4].name, "agent_rotation");
+
+  const std::string directory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "SimTest-dataset");
+  for (esp::sim::DatasetCompression compression :
+       {esp::sim::DatasetCompression::None,
+        esp::sim::DatasetCompression::DeltaLz}) {
+    CORRADE_ITERATION(int(compression));
+    // three chunks, the last one partial, in two shards
+    esp::sim::ObservationDatasetWriter::Configuration configuration;
+    configuration.recordsPerChunk = 2;
+    configuration.chunksPerShard = 2;
+    configuration.compression = compression;
+    configuration.maxPendingRecords = 1;
+    configuration.overwrite = true;
+    std::vector<std::vector<uint8_t>> colors;
+    std::vector<std::vector<uint8_t>> depths;
+    {
+      esp::sim::ObservationDatasetWriter writer{directory, fields,
+                                                configuration};
+      for (int i = 0; i < 5; ++i) {
+        AgentState state;
+        state.position = {0.1f * i, 0.0f, 0.0f};
+        agent->setState(state);
+        CORRADE_VERIFY(simulator.getAgentObservations(0, writer, i));
+        Observation observation;
+        simulator.getAgentObservation(0, "color", observation);
+        colors.emplace_back(observation.buffer->data.begin(),
+                            observation.buffer->data.end());
+        simulator.getAgentObservation(0, "depth", observation);
+        depths.emplace_back(observation.buffer->data.begin(),
+                            observation.buffer->data.end());
+      }
+      CORRADE_COMPARE(writer.numRecords(), size_t{5});
+      CORRADE_VERIFY(writer.close());
+      CORRADE_VERIFY(!simulator.getAgentObservations(0, writer));
+    }
+    CORRADE_VERIFY(Cr::Utility::Directory::exists(
+        Cr::Utility::Directory::join(directory, "shard-00001.hod")));
+
+    esp::sim::ObservationDatasetReader reader;
+    CORRADE_VERIFY(reader.open(directory));
+    CORRADE_COMPARE(reader.numRecords(), size_t{5});
+    CORRADE_COMPARE(reader.fields().size(), size_t{5});
+    CORRADE_COMPARE(reader.fieldIndex("depth"), 1);
+    CORRADE_COMPARE(reader.fieldIndex("semantic"), -1);
+    // out of order, across chunks and shards
+    for (int i : {3, 0, 4, 1, 2}) {
+      Cr::Containers::ArrayView<const char> color = reader.read(i, 0);
+      Cr::Containers::ArrayView<const char> depth = reader.read(i, 1);
+      Cr::Containers::ArrayView<const char> action = reader.read(i, 2);
+      Cr::Containers::ArrayView<const char> position = reader.read(i, 3);
+      CORRADE_COMPARE(color.size(), colors[i].size());
+      CORRADE_COMPARE(depth.size(), depths[i].size());
+      CORRADE_VERIFY(std::memcmp(color, colors[i].data(), color.size()) == 0);
+      CORRADE_VERIFY(std::memcmp(depth, depths[i].data(), depth.size()) == 0);
+      CORRADE_COMPARE(*reinterpret_cast<const int32_t*>(action.data()), i);
+      CORRADE_COMPARE(reinterpret_cast<const float*>(position.data())[0],
+                      0.1f * i);
+    }
+    CORRADE_VERIFY(reader.read(5, 0).empty());
+    CORRADE_VERIFY(reader.read(0, 5).empty());
+  }
+
+  // the shards of the last dataset are kept unless overwriting them
+  {
+    esp::sim::ObservationDatasetWriter writer{directory, fields};
+    CORRADE_VERIFY(!writer.isGood());
+    CORRADE_VERIFY(!simulator.getAgentObservations(0, writer));
+    CORRADE_VERIFY(!writer.close());
+  }
+  esp::sim::ObservationDatasetReader reader;
+  CORRADE_VERIFY(reader.open(directory));
+  CORRADE_COMPARE(reader.numRecords(), size_t{5});
+  Cr::Utility::Directory::rm(
+      Cr::Utility::Directory::join(directory, "shard-00000.hod"));
+  Cr::Utility::Directory::rm(
+      Cr::Utility::Directory::join(directory, "shard-00001.hod"));
+  Cr::Utility::Directory::rm(directory);
+}
+
+void SimTest::scheduleEpisodesByScene() {
+  // six episodes of a, three of b and one of c, shuffled
+  const std::vector<std::string> scenes{"a", "b", "a", "c", "a", "b",
+                                        "a", "a", "b", "a"};
+  EpisodeScheduler scheduler{scenes, 2};
+  CORRADE_COMPARE(scheduler.getNumWorkers(), 2);
+  CORRADE_COMPARE(scheduler.getScene(3), "c");
+  // a is split to balance the workers, the rest of it goes with b and c
+  CORRADE_VERIFY(scheduler.getWorkerScenes(0) ==
+                 (std::vector<std::string>{"a"}));
+  std::vector<std::string> workerScenes = scheduler.getWorkerScenes(1);
+  std::sort(workerScenes.begin(), workerScenes.end());
+  CORRADE_VERIFY(workerScenes == (std::vector<std::string>{"a", "b", "c"}));
+  CORRADE_COMPARE(scheduler.getNumWorkerEpisodes(0), size_t{5});
+  CORRADE_COMPARE(scheduler.getNumWorkerEpisodes(1), size_t{5});
+
+  // each episode once an epoch, the scenes of a worker in a row
+  std::vector<int> counts(scenes.size(), 0);
+  for (int worker = 0; worker < 2; ++worker) {
+    for (int i = 0; i < 5; ++i) {
+      const std::string next = scheduler.peekNextScene(worker);
+      const size_t episode = scheduler.nextEpisode(worker);
+      CORRADE_COMPARE(scheduler.getScene(episode), next);
+      ++counts[episode];
+    }
+  }
+  CORRADE_VERIFY(std::all_of(counts.begin(), counts.end(),
+                             [](int count) { return count == 1; }));
+  CORRADE_COMPARE(scheduler.getNumSceneSwitches(0), size_t{1});
+  CORRADE_COMPARE(scheduler.getNumSceneSwitches(1), size_t{3});
+  // the next epoch starts in the scene the last one ended in
+  for (int i = 0; i < 5; ++i) {
+    scheduler.nextEpisode(1);
+  }
+  CORRADE_COMPARE(scheduler.getNumSceneSwitches(1), size_t{5});
+
+  // one episode a visit mixes the scenes, in the same order for a seed
+  EpisodeScheduler::Configuration configuration;
+  configuration.episodesPerVisit = 1;
+  configuration.shuffle = false;
+  EpisodeScheduler mixed{scenes, 2, configuration};
+  for (int i = 0; i < 5; ++i) {
+    mixed.nextEpisode(1);
+  }
+  CORRADE_COMPARE(mixed.getNumSceneSwitches(1), size_t{4});
+
+  EpisodeScheduler shuffled{scenes, 1};
+  EpisodeScheduler same{scenes, 1};
+  for (int i = 0; i < 20; ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(shuffled.nextEpisode(0), same.nextEpisode(0));
+  }
+
+  EpisodeScheduler idle{{"a"}, 2};
+  CORRADE_COMPARE(idle.nextEpisode(1), ~size_t{});
+  CORRADE_COMPARE(idle.peekNextScene(1), "");
+}
+
+void SimTest::getAgentObservationsInPlace() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->resolution = {128, 128};
+  auto depthSpec = SensorSpec::create();
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::DEPTH;
+  depthSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {depthSpec, colorSpec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  const esp::sensor::SensorSuite& sensors = agent->getSensorSuite();
+  CORRADE_COMPARE(sensors.getSensorList().size(), 2);
+  CORRADE_COMPARE(sensors.getSensorIndex("color"), 0);
+  CORRADE_COMPARE(sensors.getSensorIndex("depth"), 1);
+  CORRADE_COMPARE(sensors.getSensorIndex("semantic"), -1);
+
+  std::vector<Observation> observations;
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 2);
+  CORRADE_COMPARE(observations.size(), 2);
+  const Observation* first = observations.data();
+  const esp::core::Buffer* colorBuffer = observations[0].buffer.get();
+  CORRADE_COMPARE(observations[0].buffer->dataType,
+                  esp::core::DataType::DT_UINT8);
+  CORRADE_COMPARE(observations[1].buffer->dataType,
+                  esp::core::DataType::DT_FLOAT);
+
+  // the next call reuses both the vector and the buffers
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 2);
+  CORRADE_VERIFY(observations.data() == first);
+  CORRADE_VERIFY(observations[0].buffer.get() == colorBuffer);
+
+  // the map is updated in place, dropping what isn't a sensor of the agent
+  std::map<std::string, Observation> observationMap{{"a", {}}, {"e", {}}};
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observationMap), 2);
+  CORRADE_COMPARE(observationMap.size(), 2);
+  CORRADE_VERIFY(observationMap.at("color").buffer.get() == colorBuffer);
+  CORRADE_VERIFY(observationMap.at("depth").buffer != nullptr);
+}
+
+void SimTest::getCachedObservation() {
+  auto simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setState(AgentState{});
+  simulator->setObservationCacheEnabled(true);
+  simulator->setProfilingEnabled(true);
+
+  // counts the draw calls of one observation
+  std::vector<Observation> observations;
+  const auto observe = [&]() {
+    simulator->resetProfilingStats();
+    CORRADE_COMPARE(simulator->getAgentObservations(0, observations), 1);
+    return simulator->getProfilingStats().drawCalls;
+  };
+  CORRADE_VERIFY(observe() > 0);
+  const std::vector<uint8_t> first(observations[0].buffer->data.begin(),
+                                   observations[0].buffer->data.end());
+
+  // nothing changed, the observation is not drawn again
+  CORRADE_COMPARE(observe(), 0);
+  CORRADE_VERIFY(std::equal(first.begin(), first.end(),
+                            observations[0].buffer->data.begin()));
+
+  // the agent turned
+  CORRADE_VERIFY(agent->act("turnLeft"));
+  CORRADE_VERIFY(observe() > 0);
+  CORRADE_COMPARE(observe(), 0);
+
+  // an object was added, and moved directly through its node
+  auto objs = simulator->getObjectAttributesManager()
+                  ->getObjectHandlesBySubstring("nested_box");
+  const int objectID = simulator->addObjectByHandle(objs[0]);
+  CORRADE_VERIFY(objectID != esp::ID_UNDEFINED);
+  CORRADE_VERIFY(observe() > 0);
+  simulator->getObjectSceneNode(objectID)->translate({0.0f, 0.1f, 0.0f});
+  CORRADE_VERIFY(observe() > 0);
+
+  // the light setups changed
+  simulator->setLightSetup(lightSetup1);
+  CORRADE_VERIFY(observe() > 0);
+  simulator->markSceneChanged();
+  CORRADE_VERIFY(observe() > 0);
+  CORRADE_COMPARE(observe(), 0);
+
+  simulator->setObservationCacheEnabled(false);
+  CORRADE_VERIFY(observe() > 0);
+  simulator->setProfilingEnabled(false);
+}
+
+void SimTest::getViewCachedObservation() {
+  const std::string directory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "SimTest-views");
+  // the entries are in subdirectories
+  const auto removeCache = [&]() {
+    using Cr::Utility::Directory::Flag;
+    for (const std::string& subdirectory : Cr::Utility::Directory::list(
+             directory, Flag::SkipDotAndDotDot)) {
+      const std::string path =
+          Cr::Utility::Directory::join(directory, subdirectory);
+      for (const std::string& file :
+           Cr::Utility::Directory::list(path, Flag::SkipDotAndDotDot)) {
+        Cr::Utility::Directory::rm(Cr::Utility::Directory::join(path, file));
+      }
+      Cr::Utility::Directory::rm(path);
+    }
+    Cr::Utility::Directory::rm(directory);
+  };
+  removeCache();
+
+  auto simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setState(AgentState{});
+  simulator->setViewCache(ViewCache::create(directory));
+  simulator->setProfilingEnabled(true);
+
+  std::vector<Observation> observations;
+  const auto observe = [&]() {
+    simulator->resetProfilingStats();
+    CORRADE_COMPARE(simulator->getAgentObservations(0, observations), 1);
+    return simulator->getProfilingStats();
+  };
+  esp::core::ProfilingStats stats = observe();
+  CORRADE_COMPARE(stats.viewCacheHits, 0);
+  CORRADE_COMPARE(stats.viewCacheMisses, 1);
+  CORRADE_VERIFY(stats.drawCalls > 0);
+  const std::vector<uint8_t> first(observations[0].buffer->data.begin(),
+                                   observations[0].buffer->data.end());
+
+  // read back from the disk, also by another cache in the same directory
+  for (int i = 0; i < 2; ++i) {
+    CORRADE_ITERATION(i);
+    if (i == 1) {
+      simulator->setViewCache(ViewCache::create(directory));
+    }
+    std::fill(observations[0].buffer->data.begin(),
+              observations[0].buffer->data.end(), 0);
+    stats = observe();
+    CORRADE_COMPARE(stats.viewCacheHits, 1);
+    CORRADE_COMPARE(stats.drawCalls, 0);
+    CORRADE_VERIFY(std::equal(first.begin(), first.end(),
+                              observations[0].buffer->data.begin()));
+  }
+
+  // a new pose is drawn
+  CORRADE_VERIFY(agent->act("turnLeft"));
+  stats = observe();
+  CORRADE_COMPARE(stats.viewCacheMisses, 1);
+  CORRADE_VERIFY(stats.drawCalls > 0);
+
+  // the scene changed, the cache is not used anymore
+  auto objs = simulator->getObjectAttributesManager()
+                  ->getObjectHandlesBySubstring("nested_box");
+  CORRADE_VERIFY(simulator->addObjectByHandle(objs[0]) != esp::ID_UNDEFINED);
+  stats = observe();
+  CORRADE_COMPARE(stats.viewCacheHits, 0);
+  CORRADE_COMPARE(stats.viewCacheMisses, 0);
+  CORRADE_VERIFY(stats.drawCalls > 0);
+
+  simulator->setViewCache(nullptr);
+  simulator->setProfilingEnabled(false);
+  removeCache();
+}
+
+void SimTest::getScheduledObservations() {
+  auto simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->resolution = {128, 128};
+  colorSpec->updatePeriod = 3;
+  auto depthSpec = SensorSpec::create();
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::DEPTH;
+  depthSpec->resolution = {128, 128};
+  auto onDemandSpec = SensorSpec::create(*depthSpec);
+  onDemandSpec->uuid = "on_demand";
+  onDemandSpec->updatePeriod = 0;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec, onDemandSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  // the sensor list is ordered by uuid
+  std::vector<Observation> observations;
+  CORRADE_COMPARE(simulator->getAgentObservations(0, observations), 2);
+  CORRADE_VERIFY(observations[0].buffer);
+  CORRADE_VERIFY(observations[1].buffer);
+  CORRADE_VERIFY(!observations[2].buffer);
+  const std::vector<uint8_t> first(observations[0].buffer->data.begin(),
+                                   observations[0].buffer->data.end());
+
+  // the color sensor returns its last observation until it is due again
+  CORRADE_VERIFY(agent->act("turnLeft"));
+  for (int call = 1; call < 3; ++call) {
+    CORRADE_COMPARE(simulator->getAgentObservations(0, observations), 2);
+    CORRADE_VERIFY(std::equal(first.begin(), first.end(),
+                              observations[0].buffer->data.begin()));
+    CORRADE_VERIFY(!observations[2].buffer);
+  }
+  CORRADE_COMPARE(simulator->getAgentObservations(0, observations), 2);
+  CORRADE_VERIFY(!std::equal(first.begin(), first.end(),
+                             observations[0].buffer->data.begin()));
+
+  Observation onDemand;
+  CORRADE_VERIFY(simulator->getAgentObservation(0, "on_demand", onDemand));
+  CORRADE_VERIFY(onDemand.buffer);
+}
+
+void SimTest::getLayeredObservation() {
+  auto simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setState(AgentState{});
+  auto objs = simulator->getObjectAttributesManager()
+                  ->getObjectHandlesBySubstring("nested_box");
+  const int objectID = simulator->addObjectByHandle(objs[0]);
+  CORRADE_VERIFY(objectID != esp::ID_UNDEFINED);
+  simulator->setTranslation({1.0f, 0.5f, -0.5f}, objectID);
+  simulator->setLayeredCompositionEnabled(true);
+  CORRADE_VERIFY(simulator->isLayeredCompositionEnabled());
+  simulator->setProfilingEnabled(true);
+
+  // counts the draw calls of one observation
+  std::vector<Observation> observations;
+  const auto observe = [&]() {
+    simulator->resetProfilingStats();
+    CORRADE_COMPARE(simulator->getAgentObservations(0, observations), 1);
+    return simulator->getProfilingStats().drawCalls;
+  };
+  const uint64_t stageAndObjects = observe();
+  auto& colorSensor = static_cast<esp::sensor::VisualSensor&>(
+      *agent->getSensorSuite().get("color"));
+  CORRADE_VERIFY(colorSensor.renderTarget().hasCachedLayer());
+
+  // the object moved, only it is drawn again over the stage
+  simulator->setTranslation({1.2f, 0.5f, -0.5f}, objectID);
+  const uint64_t objects = observe();
+  CORRADE_COMPARE_AS(objects, stageAndObjects,
+                     Cr::TestSuite::Compare::Less);
+  const std::vector<uint8_t> layered(observations[0].buffer->data.begin(),
+                                     observations[0].buffer->data.end());
+
+  // the same as drawing the whole scene
+  simulator->setLayeredCompositionEnabled(false);
+  CORRADE_COMPARE(observe(), stageAndObjects);
+  const auto& whole = observations[0].buffer->data;
+  CORRADE_COMPARE(whole.size(), layered.size());
+  for (std::size_t i = 0; i != layered.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE_WITH(int(layered[i]), int(whole[i]),
+                         Cr::TestSuite::Compare::around(1));
+  }
+
+  // the agent moved, the stage is drawn again
+  simulator->setLayeredCompositionEnabled(true);
+  AgentState state{};
+  state.position = {0.05f, 0.0f, 0.0f};
+  agent->setState(state);
+  CORRADE_COMPARE_AS(observe(), objects, Cr::TestSuite::Compare::Greater);
+  CORRADE_COMPARE(observe(), objects);
+  simulator->markSceneChanged();
+  CORRADE_COMPARE_AS(observe(), objects, Cr::TestSuite::Compare::Greater);
+  simulator->setProfilingEnabled(false);
+}
+
+void SimTest::getFusedDepthObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto depthSpec = SensorSpec::create();
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::DEPTH;
+  depthSpec->position = {1.0f, 1.5f, 1.0f};
+  depthSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {depthSpec};
+  const auto visualSensor = [&](int agentId) -> esp::sensor::VisualSensor& {
+    return static_cast<esp::sensor::VisualSensor&>(
+        *simulator.getAgent(agentId)->getSensorSuite().get("depth"));
+  };
+
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+  CORRADE_VERIFY(!visualSensor(0).renderTarget().hasLinearDepth());
+  Observation unprojected;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "depth", unprojected));
+
+  // the same view, drawn with the depth unprojection fused into the pass
+  esp::gfx::Renderer& renderer = *simulator.getRenderer();
+  renderer.setFlags(renderer.flags() |
+                    esp::gfx::Renderer::Flag::FusedDepthUnprojection);
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+  CORRADE_VERIFY(visualSensor(1).renderTarget().hasLinearDepth());
+  Observation fused;
+  CORRADE_VERIFY(simulator.getAgentObservation(1, "depth", fused));
+
+  const auto unprojectedDepth =
+      Cr::Containers::arrayCast<const float>(unprojected.buffer->data);
+  const auto fusedDepth =
+      Cr::Containers::arrayCast<const float>(fused.buffer->data);
+  CORRADE_COMPARE(fusedDepth.size(), unprojectedDepth.size());
+  CORRADE_COMPARE_AS(Mn::Math::max<float>(fusedDepth), 0.0f,
+                     Cr::TestSuite::Compare::Greater);
+  for (std::size_t i = 0; i != fusedDepth.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE_WITH(
+        fusedDepth[i], unprojectedDepth[i],
+        Cr::TestSuite::Compare::around(unprojectedDepth[i] * 0.001f + 1e-4f));
+  }
+}
+
+void SimTest::getDepthOnlyObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorType = SensorType::COLOR;
+  colorSpec->position = {1.0f, 1.5f, 1.0f};
+  colorSpec->resolution = {128, 128};
+  auto depthSpec = SensorSpec::create(*colorSpec);
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::DEPTH;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+  const auto visualSensor =
+      [&](const std::string& uuid) -> esp::sensor::VisualSensor& {
+    return static_cast<esp::sensor::VisualSensor&>(
+        *agent->getSensorSuite().get(uuid));
+  };
+  CORRADE_VERIFY(!visualSensor("color").renderTarget().isDepthOnly());
+  CORRADE_VERIFY(visualSensor("depth").renderTarget().isDepthOnly());
+  CORRADE_VERIFY(!visualSensor("depth").renderTarget().hasLinearDepth());
+
+  // the depth of the fully shaded color frame
+  simulator.setSharedSensorRenderEnabled(true);
+  std::vector<Observation> observations;
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 2);
+  const auto sharedDepth = Cr::Containers::arrayCast<const float>(
+      observations[1].buffer->data);
+  const std::vector<float> shaded(sharedDepth.begin(), sharedDepth.end());
+
+  // drawn on its own, with position-only shaders
+  simulator.setSharedSensorRenderEnabled(false);
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 2);
+  const auto depthOnly = Cr::Containers::arrayCast<const float>(
+      observations[1].buffer->data);
+  CORRADE_COMPARE(depthOnly.size(), shaded.size());
+  CORRADE_COMPARE_AS(Mn::Math::max<float>(depthOnly), 0.0f,
+                     Cr::TestSuite::Compare::Greater);
+  for (std::size_t i = 0; i != depthOnly.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE_WITH(
+        depthOnly[i], shaded[i],
+        Cr::TestSuite::Compare::around(shaded[i] * 0.001f + 1e-4f));
+  }
+}
+
+void SimTest::getSurfaceNormalObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto normalSpec = SensorSpec::create();
+  normalSpec->uuid = "normal";
+  normalSpec->sensorType = SensorType::NORMAL;
+  normalSpec->position = {1.0f, 1.5f, 1.0f};
+  normalSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {normalSpec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+  auto& normalSensor = static_cast<esp::sensor::VisualSensor&>(
+      *agent->getSensorSuite().get("normal"));
+  CORRADE_VERIFY(normalSensor.renderTarget().hasSurfaceNormals());
+
+  std::vector<Observation> observations;
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 1);
+  CORRADE_VERIFY(observations[0].buffer);
+  CORRADE_COMPARE(observations[0].buffer->shape,
+                  (std::vector<size_t>{128, 128, 3}));
+  CORRADE_COMPARE(observations[0].buffer->dataType,
+                  esp::core::DataType::DT_FLOAT);
+
+  // unit camera-space normals where the scene is, zero where it is not
+  const auto normals = Cr::Containers::arrayCast<const Mn::Vector3>(
+      observations[0].buffer->data);
+  std::size_t covered = 0;
+  for (std::size_t i = 0; i != normals.size(); ++i) {
+    const float length = normals[i].length();
+    if (length == 0.0f) {
+      continue;
+    }
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE_WITH(length, 1.0f, Cr::TestSuite::Compare::around(0.01f));
+    ++covered;
+  }
+  CORRADE_COMPARE_AS(covered, std::size_t{0}, Cr::TestSuite::Compare::Greater);
+}
+
+void SimTest::getOpticalFlowObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto flowSpec = SensorSpec::create();
+  flowSpec->uuid = "flow";
+  flowSpec->sensorType = SensorType::OPTICAL_FLOW;
+  flowSpec->position = {1.0f, 1.5f, 1.0f};
+  flowSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {flowSpec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+  auto& flowSensor = static_cast<esp::sensor::VisualSensor&>(
+      *agent->getSensorSuite().get("flow"));
+  CORRADE_VERIFY(flowSensor.renderTarget().hasMotionVectors());
+
+  const auto maxMotion = [](const Observation& observation) {
+    const auto flow = Cr::Containers::arrayCast<const Mn::Vector2>(
+        observation.buffer->data);
+    float motion = 0.0f;
+    for (const Mn::Vector2& pixel : flow) {
+      motion = Mn::Math::max(motion, pixel.length());
+    }
+    return motion;
+  };
+
+  // nothing to compare the first frame with
+  std::vector<Observation> observations;
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 1);
+  CORRADE_COMPARE(observations[0].buffer->shape,
+                  (std::vector<size_t>{128, 128, 2}));
+  CORRADE_COMPARE(observations[0].buffer->dataType,
+                  esp::core::DataType::DT_FLOAT);
+  CORRADE_COMPARE_AS(maxMotion(observations[0]), 1e-3f,
+                     Cr::TestSuite::Compare::Less);
+
+  // moving the agent sideways moves the scene across the frame
+  AgentState state{};
+  state.position = {0.1f, 0.0f, 0.0f};
+  agent->setState(state);
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 1);
+  CORRADE_COMPARE_AS(maxMotion(observations[0]), 1.0f,
+                     Cr::TestSuite::Compare::Greater);
+
+  // and not moving it again doesn't
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 1);
+  CORRADE_COMPARE_AS(maxMotion(observations[0]), 1e-3f,
+                     Cr::TestSuite::Compare::Less);
+}
+
+void SimTest::getStereoDepthObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto leftSpec = SensorSpec::create();
+  leftSpec->uuid = "left";
+  leftSpec->sensorType = SensorType::DEPTH;
+  leftSpec->position = {0.95f, 1.5f, 1.0f};
+  leftSpec->resolution = {128, 128};
+  auto rightSpec = SensorSpec::create(*leftSpec);
+  rightSpec->uuid = "right";
+  rightSpec->position = {1.05f, 1.5f, 1.0f};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {leftSpec, rightSpec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+  const auto visualSensor =
+      [&](const std::string& uuid) -> esp::sensor::VisualSensor& {
+    return static_cast<esp::sensor::VisualSensor&>(
+        *agent->getSensorSuite().get(uuid));
+  };
+  CORRADE_VERIFY(visualSensor("left").isStereoPairWith(visualSensor("right")));
+  CORRADE_VERIFY(visualSensor("right").isStereoPairWith(visualSensor("left")));
+  CORRADE_VERIFY(!visualSensor("left").isStereoPairWith(visualSensor("left")));
+
+  // each eye drawn on its own
+  std::vector<Observation> observations;
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 2);
+  std::vector<std::vector<float>> separate;
+  for (const Observation& observation : observations) {
+    const auto depth =
+        Cr::Containers::arrayCast<const float>(observation.buffer->data);
+    separate.emplace_back(depth.begin(), depth.end());
+  }
+  CORRADE_VERIFY(separate[0] != separate[1]);
+
+  // both at once, in a single pass where multiview is supported
+  simulator.setStereoRenderEnabled(true);
+  CORRADE_VERIFY(simulator.isStereoRenderEnabled());
+  CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 2);
+  for (std::size_t eye = 0; eye != 2; ++eye) {
+    CORRADE_ITERATION(eye);
+    const auto stereo = Cr::Containers::arrayCast<const float>(
+        observations[eye].buffer->data);
+    CORRADE_COMPARE(stereo.size(), separate[eye].size());
+    CORRADE_COMPARE_AS(Mn::Math::max<float>(stereo), 0.0f,
+                       Cr::TestSuite::Compare::Greater);
+    for (std::size_t i = 0; i != stereo.size(); ++i) {
+      CORRADE_ITERATION(i);
+      CORRADE_COMPARE_WITH(stereo[i], separate[eye][i],
+                           Cr::TestSuite::Compare::around(
+                               separate[eye][i] * 0.001f + 1e-4f));
+    }
+  }
+}
+
+void SimTest::getGpuDrivenDepthObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto depthSpec = SensorSpec::create();
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::DEPTH;
+  depthSpec->position = {1.0f, 1.5f, 1.0f};
+  depthSpec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {depthSpec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+  simulator.setProfilingEnabled(true);
+
+  // counts the draw calls of one observation
+  std::vector<Observation> observations;
+  const auto observe = [&]() {
+    simulator.resetProfilingStats();
+    CORRADE_COMPARE(simulator.getAgentObservations(0, observations), 1);
+    return simulator.getProfilingStats().drawCalls;
+  };
+  const uint64_t drawCalls = observe();
+  const auto depth =
+      Cr::Containers::arrayCast<const float>(observations[0].buffer->data);
+  const std::vector<float> expected(depth.begin(), depth.end());
+  CORRADE_COMPARE_AS(Mn::Math::max<float>(depth), 0.0f,
+                     Cr::TestSuite::Compare::Greater);
+
+  // the stage drawn from its indirect batch, with the vertices transformed
+  // to world space upfront
+  simulator.setGpuDrivenRenderEnabled(true);
+  CORRADE_VERIFY(simulator.isGpuDrivenRenderEnabled());
+  const uint64_t gpuDrivenDrawCalls = observe();
+  const auto gpuDriven =
+      Cr::Containers::arrayCast<const float>(observations[0].buffer->data);
+  CORRADE_COMPARE(gpuDriven.size(), expected.size());
+  for (std::size_t i = 0; i != gpuDriven.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE_WITH(
+        gpuDriven[i], expected[i],
+        Cr::TestSuite::Compare::around(expected[i] * 0.001f + 1e-4f));
+  }
+
+  if (!esp::gfx::IndirectDrawBatch::isSupported())
+    CORRADE_SKIP("The GPU has no OpenGL 4.3");
+  CORRADE_COMPARE_AS(gpuDrivenDrawCalls, drawCalls,
+                     Cr::TestSuite::Compare::LessOrEqual);
+}
+
+void SimTest::getCubeMapObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto makeSpec = [](const std::string& uuid, SensorType type,
+                     const std::string& subtype, int height, int width) {
+    auto spec = SensorSpec::create();
+    spec->uuid = uuid;
+    spec->sensorType = type;
+    spec->sensorSubtype = subtype;
+    spec->position = {1.0f, 1.5f, 1.0f};
+    spec->resolution = {height, width};
+    return spec;
+  };
+  const int faceSize = 64;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {
+      makeSpec("color", SensorType::COLOR, "pinhole", faceSize, faceSize),
+      makeSpec("depth", SensorType::DEPTH, "pinhole", faceSize, faceSize),
+      makeSpec("cubemap", SensorType::COLOR,
+               esp::sensor::CubeMapCamera::CubeMapSubtype, 6 * faceSize,
+               faceSize),
+      makeSpec("equirectangular", SensorType::DEPTH,
+               esp::sensor::CubeMapCamera::EquirectangularSubtype, faceSize,
+               2 * faceSize)};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  auto& cubeMap = static_cast<esp::sensor::CubeMapCamera&>(
+      *agent->getSensorSuite().get("cubemap"));
+  CORRADE_COMPARE(cubeMap.faceSize(), faceSize);
+  CORRADE_COMPARE(cubeMap.framebufferSize(),
+                  (Mn::Vector2i{faceSize, 6 * faceSize}));
+  CORRADE_VERIFY(!cubeMap.isEquirectangular());
+
+  // a resolution that isn't a stack of square faces is rejected
+  auto& node = simulator.getActiveSceneGraph().getRootNode().createChild();
+  bool thrown = false;
+  try {
+    esp::sensor::CubeMapCamera::create(
+        node, makeSpec("invalid", SensorType::COLOR,
+                       esp::sensor::CubeMapCamera::CubeMapSubtype, faceSize,
+                       faceSize));
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  CORRADE_VERIFY(thrown);
+
+  Observation color, depth, stack, panorama;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "color", color));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "depth", depth));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "cubemap", stack));
+  CORRADE_VERIFY(
+      simulator.getAgentObservation(0, "equirectangular", panorama));
+  CORRADE_COMPARE(stack.buffer->shape,
+                  (std::vector<size_t>{6 * faceSize, faceSize, 4}));
+  CORRADE_COMPARE(panorama.buffer->shape,
+                  (std::vector<size_t>{faceSize, 2 * faceSize, 1}));
+
+  // the forward face is the bottom of the stack, i.e. its first rows in
+  // memory, and sees what a pinhole camera with the same pose sees
+  const Mn::Vector2i size{faceSize};
+  CORRADE_COMPARE_WITH(
+      (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size,
+                       Cr::Containers::arrayView(stack.buffer->data)
+                           .prefix(color.buffer->data.size())}),
+      (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size,
+                       color.buffer->data}),
+      (Mn::DebugTools::CompareImage{1.0f, 0.01f}));
+
+  // the middle of the panorama is the forward direction, where the distance
+  // along the ray is the depth along the axis
+  const auto pinholeDepth =
+      Cr::Containers::arrayCast<const float>(depth.buffer->data);
+  const auto panoramaDepth =
+      Cr::Containers::arrayCast<const float>(panorama.buffer->data);
+  const float expected =
+      pinholeDepth[(faceSize / 2) * faceSize + faceSize / 2];
+  CORRADE_COMPARE_AS(expected, 0.0f, Cr::TestSuite::Compare::Greater);
+  CORRADE_COMPARE_WITH(panoramaDepth[(faceSize / 2) * 2 * faceSize + faceSize],
+                       expected,
+                       Cr::TestSuite::Compare::around(expected * 0.05f));
+}
+
+void SimTest::getConvertedObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto makeSpec = [](const std::string& uuid, SensorType type,
+                     esp::sensor::ObservationFormat format, int downsampling) {
+    auto spec = SensorSpec::create();
+    spec->uuid = uuid;
+    spec->sensorType = type;
+    spec->position = {1.0f, 1.5f, 1.0f};
+    spec->resolution = {128, 128};
+    spec->observationFormat = format;
+    spec->downsampling = downsampling;
+    return spec;
+  };
+  using esp::sensor::ObservationFormat;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {
+      makeSpec("color", SensorType::COLOR, ObservationFormat::DEFAULT, 1),
+      makeSpec("depth", SensorType::DEPTH, ObservationFormat::DEFAULT, 1),
+      makeSpec("rgb", SensorType::COLOR, ObservationFormat::RGB, 2),
+      makeSpec("gray", SensorType::COLOR, ObservationFormat::GRAYSCALE, 4),
+      makeSpec("millimeters", SensorType::DEPTH,
+               ObservationFormat::MILLIMETER_DEPTH, 4)};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  // a format that doesn't fit the sensor type and a downsampling that
+  // doesn't divide the resolution are rejected
+  auto& node = simulator.getActiveSceneGraph().getRootNode().createChild();
+  for (const SensorSpec::ptr& spec :
+       {makeSpec("invalid", SensorType::COLOR,
+                 ObservationFormat::HALF_DEPTH, 1),
+        makeSpec("invalid", SensorType::DEPTH, ObservationFormat::DEFAULT,
+                 3)}) {
+    bool thrown = false;
+    try {
+      esp::sensor::PinholeCamera::create(node, spec);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    CORRADE_VERIFY(thrown);
+  }
+
+  ObservationSpace space;
+  CORRADE_VERIFY(simulator.getAgentObservationSpace(0, "millimeters", space));
+  CORRADE_COMPARE(space.shape, (std::vector<size_t>{32, 32, 1}));
+  CORRADE_COMPARE(int(space.dataType), int(esp::core::DataType::DT_UINT16));
+
+  Observation color, depth, rgb, gray, millimeters;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "color", color));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "depth", depth));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "rgb", rgb));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "gray", gray));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "millimeters", millimeters));
+  CORRADE_COMPARE(rgb.buffer->shape, (std::vector<size_t>{64, 64, 3}));
+  CORRADE_COMPARE(gray.buffer->shape, (std::vector<size_t>{32, 32, 1}));
+
+  // the same conversion of the full observations on the CPU
+  const auto colorPixels =
+      Cr::Containers::arrayCast<const Mn::Color4ub>(color.buffer->data);
+  const auto depthPixels =
+      Cr::Containers::arrayCast<const float>(depth.buffer->data);
+  const auto boxAverage = [&](int x, int y, int downsampling) {
+    Mn::Vector4 sum;
+    float depthSum = 0.0f;
+    for (int j = 0; j != downsampling; ++j) {
+      for (int i = 0; i != downsampling; ++i) {
+        const std::size_t index =
+            (y * downsampling + j) * 128 + x * downsampling + i;
+        sum += Mn::Vector4{colorPixels[index]};
+        depthSum += depthPixels[index];
+      }
+    }
+    const float count = downsampling * downsampling;
+    return std::make_pair(sum / count, depthSum / count);
+  };
+  std::vector<Mn::Color3ub> expectedRgb;
+  for (int y = 0; y != 64; ++y) {
+    for (int x = 0; x != 64; ++x) {
+      expectedRgb.push_back(Mn::Color3ub{
+          Mn::Math::round(boxAverage(x, y, 2).first.rgb())});
+    }
+  }
+  std::vector<Mn::UnsignedByte> expectedGray;
+  std::vector<Mn::UnsignedShort> expectedMillimeters;
+  for (int y = 0; y != 32; ++y) {
+    for (int x = 0; x != 32; ++x) {
+      const auto average = boxAverage(x, y, 4);
+      expectedGray.push_back(Mn::UnsignedByte(Mn::Math::round(
+          Mn::Math::dot(average.first.rgb(), Mn::Vector3{0.299f, 0.587f,
+                                                         0.114f}))));
+      expectedMillimeters.push_back(Mn::UnsignedShort(
+          Mn::Math::min(average.second * 1000.0f + 0.5f, 65535.0f)));
+    }
+  }
+
+  CORRADE_COMPARE_WITH(
+      (Mn::ImageView2D{Mn::PixelFormat::RGB8Unorm, {64, 64},
+                       rgb.buffer->data}),
+      (Mn::ImageView2D{Mn::PixelFormat::RGB8Unorm, {64, 64}, expectedRgb}),
+      (Mn::DebugTools::CompareImage{1.0f, 0.01f}));
+  CORRADE_COMPARE_WITH(
+      (Mn::ImageView2D{Mn::PixelFormat::R8Unorm, {32, 32}, gray.buffer->data}),
+      (Mn::ImageView2D{Mn::PixelFormat::R8Unorm, {32, 32}, expectedGray}),
+      (Mn::DebugTools::CompareImage{1.0f, 0.01f}));
+
+  const auto millimeterDepth =
+      Cr::Containers::arrayCast<const Mn::UnsignedShort>(
+          millimeters.buffer->data);
+  CORRADE_COMPARE(millimeterDepth.size(), expectedMillimeters.size());
+  CORRADE_COMPARE_AS(Mn::Math::max<Mn::UnsignedShort>(millimeterDepth),
+                     Mn::UnsignedShort(0), Cr::TestSuite::Compare::Greater);
+  for (std::size_t i = 0; i != millimeterDepth.size(); ++i) {
+    CORRADE_ITERATION(i);
+    const float expected = expectedMillimeters[i];
+    CORRADE_COMPARE_WITH(
+        float(millimeterDepth[i]), expected,
+        Cr::TestSuite::Compare::around(1.0f + expected * 0.001f));
+  }
+}
+
+void SimTest::getMultisampledObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto makeSpec = [](const std::string& uuid, int samples) {
+    auto spec = SensorSpec::create();
+    spec->uuid = uuid;
+    spec->position = {1.0f, 1.5f, 1.0f};
+    spec->resolution = {128, 128};
+    spec->samples = samples;
+    return spec;
+  };
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {makeSpec("color", 1),
+                                      makeSpec("multisampled", 4)};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  Observation color, multisampled;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "color", color));
+  CORRADE_VERIFY(
+      simulator.getAgentObservation(0, "multisampled", multisampled));
+
+  // the resolved samples only differ from a single one along the edges
+  const Mn::Vector2i size{128};
+  CORRADE_COMPARE_WITH(
+      (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size,
+                       multisampled.buffer->data}),
+      (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size,
+                       color.buffer->data}),
+      (Mn::DebugTools::CompareImage{255.0f, 4.0f}));
+
+  auto& sensor = static_cast<esp::sensor::VisualSensor&>(
+      *agent->getSensorSuite().get("multisampled"));
+  // GL only guarantees one sample for the integer ObjectID renderbuffer
+  if (sensor.renderTarget().samples() == 1)
+    CORRADE_SKIP("The GPU has no multisample integer renderbuffers");
+  CORRADE_COMPARE_AS(sensor.renderTarget().samples(), 4,
+                     Cr::TestSuite::Compare::LessOrEqual);
+  CORRADE_VERIFY(!std::equal(color.buffer->data.begin(),
+                             color.buffer->data.end(),
+                             multisampled.buffer->data.begin()));
+}
+
+void SimTest::getOcclusionCulledObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  auto spec = SensorSpec::create();
+  spec->uuid = "color";
+  spec->position = {1.0f, 1.5f, 1.0f};
+  spec->resolution = {128, 128};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {spec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  Observation reference;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "color", reference));
+  // the sensor draws the next observations into the same buffer
+  const std::vector<uint8_t> expected{reference.buffer->data.begin(),
+                                      reference.buffer->data.end()};
+
+  // the first frame guesses every drawable is visible, the next ones take
+  // the results of the previous, the image is the same in all of them
+  simulator.setOcclusionCullingEnabled(true);
+  const Mn::Vector2i size{128};
+  for (int frame = 0; frame != 3; ++frame) {
+    CORRADE_ITERATION(frame);
+    Observation culled;
+    CORRADE_VERIFY(simulator.getAgentObservation(0, "color", culled));
+    CORRADE_COMPARE_WITH(
+        (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size,
+                         culled.buffer->data}),
+        (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size, expected}),
+        (Mn::DebugTools::CompareImage{0.0f, 0.0f}));
+  }
+}
+
+void SimTest::getTopDownMapObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  Simulator simulator(simConfig);
+  const int size = 64;
+  auto spec = SensorSpec::create();
+  spec->uuid = "map";
+  spec->sensorSubtype = esp::sensor::TopDownMapCamera::Subtype;
+  spec->observationFormat = esp::sensor::ObservationFormat::GRAYSCALE;
+  spec->position = {0.0f, 0.0f, 0.0f};
+  spec->resolution = {size, size};
+  spec->parameters["meters_per_pixel"] = "0.05";
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {spec};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+
+  // only color maps
+  auto& node = simulator.getActiveSceneGraph().getRootNode().createChild();
+  auto depthSpec = SensorSpec::create(*spec);
+  depthSpec->sensorType = SensorType::DEPTH;
+  depthSpec->observationFormat = esp::sensor::ObservationFormat::DEFAULT;
+  bool thrown = false;
+  try {
+    esp::sensor::TopDownMapCamera::create(node, depthSpec);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  CORRADE_VERIFY(thrown);
+
+  AgentState state;
+  state.position = simulator.getPathFinder()->getRandomNavigablePoint();
+  agent->setState(state);
+  Observation map;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "map", map));
+  CORRADE_COMPARE(map.buffer->shape, (std::vector<size_t>{size, size, 1}));
+  const std::vector<uint8_t> forward{map.buffer->data.begin(),
+                                     map.buffer->data.end()};
+  // the agent stands on the navmesh, in the middle of the map
+  const int center = (size / 2) * size + size / 2;
+  CORRADE_COMPARE(std::max({forward[center], forward[center - 1],
+                            forward[center - size],
+                            forward[center - size - 1]}),
+                  Mn::UnsignedByte(255));
+
+  // turned left, the map turns right around the agent, so what was on its
+  // left is up, the rows are bottom first
+  state.rotation =
+      esp::quatf(Eigen::AngleAxisf(M_PI / 2, esp::vec3f::UnitY())).coeffs();
+  agent->setState(state);
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "map", map));
+  std::vector<uint8_t> expected(forward.size());
+  for (int y = 0; y != size; ++y) {
+    for (int x = 0; x != size; ++x) {
+      expected[y * size + x] = forward[x * size + size - 1 - y];
+    }
+  }
+  CORRADE_COMPARE_WITH(
+      (Mn::ImageView2D{Mn::PixelFormat::R8Unorm, Mn::Vector2i{size},
+                       map.buffer->data}),
+      (Mn::ImageView2D{Mn::PixelFormat::R8Unorm, Mn::Vector2i{size},
+                       expected}),
+      (Mn::DebugTools::CompareImage{255.0f, 4.0f}));
+}
+
+void SimTest::getLidarObservation() {
+  auto simulator = getSimulator(planeScene);
+  auto spec = SensorSpec::create();
+  spec->uuid = "lidar";
+  spec->sensorType = SensorType::LIDAR;
+  spec->position = {0.0f, 1.0f, 0.0f};
+  spec->resolution = {3, 8};
+  spec->parameters["vertical_fov"] = "90";
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {spec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  auto& lidar = static_cast<esp::sensor::LidarSensor&>(
+      *agent->getSensorSuite().get("lidar"));
+  CORRADE_VERIFY(!lidar.isVisualSensor());
+  CORRADE_COMPARE(lidar.maxRange(), 10.0f);
+  // the rows are 30 degrees up, straight ahead and 30 degrees down
+  CORRADE_COMPARE(lidar.rayDirections().size(), std::size_t{24});
+  CORRADE_COMPARE(lidar.rayDirections()[0].y(), 0.5f);
+  CORRADE_COMPARE(lidar.rayDirections()[8].y(), 0.0f);
+  CORRADE_COMPARE(lidar.rayDirections()[16].y(), -0.5f);
+
+  Observation obs;
+  CORRADE_VERIFY(simulator->getAgentObservation(0, "lidar", obs));
+  CORRADE_COMPARE(obs.buffer->shape, (std::vector<size_t>{3, 8}));
+  CORRADE_COMPARE(obs.buffer->dataType, esp::core::DataType::DT_FLOAT);
+
+  // each range is the first hit of the same ray cast on its own
+  const auto ranges = Cr::Containers::arrayCast<const float>(obs.buffer->data);
+  const Mn::Vector3 origin =
+      lidar.node().absoluteTransformationMatrix().translation();
+  int numHits = 0;
+  for (size_t i = 0; i != ranges.size(); ++i) {
+    CORRADE_ITERATION(i);
+    esp::physics::RaycastResults results = simulator->castRay(
+        esp::geo::Ray{origin, lidar.rayDirections()[i]}, lidar.maxRange());
+    const float expected = results.hasHits() ? results.hits[0].rayDistance
+                                             : 0.0f;
+    CORRADE_COMPARE(ranges[i], expected);
+    numHits += results.hasHits();
+  }
+  // at least the rays down hit the plane
+  CORRADE_COMPARE_AS(numHits, 8, Cr::TestSuite::Compare::GreaterOrEqual);
+}
+
+void SimTest::getSemanticCategoryObservation() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  simConfig.enablePhysics = true;
+  simConfig.physicsConfigFile = physicsConfigFile;
+  Simulator simulator(simConfig);
+  auto objs = simulator.getObjectAttributesManager()
+                  ->getObjectHandlesBySubstring("nested_box");
+  for (int i = 0; i < 3; ++i) {
+    int objectID = simulator.addObjectByHandle(objs[0]);
+    CORRADE_INTERNAL_ASSERT(objectID != esp::ID_UNDEFINED);
+    simulator.setTranslation({1.0f - 0.6f * i, 0.5f, -0.5f}, objectID);
+    simulator.setObjectSemanticId(i + 1, objectID);
+  }
+
+  using esp::sensor::ObservationFormat;
+  auto makeSpec = [](const std::string& uuid, ObservationFormat format,
+                     int downsampling) {
+    auto spec = SensorSpec::create();
+    spec->uuid = uuid;
+    spec->sensorType = SensorType::SEMANTIC;
+    spec->position = {0.0f, 1.5f, 2.0f};
+    spec->resolution = {64, 64};
+    spec->channels = 1;
+    spec->observationFormat = format;
+    spec->downsampling = downsampling;
+    return spec;
+  };
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {
+      makeSpec("ids", ObservationFormat::DEFAULT, 1),
+      makeSpec("categories", ObservationFormat::SEMANTIC_CATEGORY, 1),
+      makeSpec("downsampled", ObservationFormat::SEMANTIC_CATEGORY, 2)};
+  Agent::ptr agent = simulator.addAgent(agentConfig);
+  agent->setState(AgentState{});
+
+  // only a semantic sensor can read categories
+  {
+    auto spec = makeSpec("invalid", ObservationFormat::SEMANTIC_CATEGORY, 1);
+    spec->sensorType = SensorType::COLOR;
+    auto& node = simulator.getActiveSceneGraph().getRootNode().createChild();
+    bool thrown = false;
+    try {
+      esp::sensor::PinholeCamera::create(node, spec);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    CORRADE_VERIFY(thrown);
+  }
+
+  // the third object ID is past the end of the table
+  const std::vector<Mn::UnsignedInt> table{0, 7, 9};
+  simulator.getRenderer()->setObjectIdLookup(table);
+  auto category = [&](Mn::UnsignedInt id) {
+    return id < table.size() ? table[id] : 0;
+  };
+
+  Observation ids, categories, downsampled;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "ids", ids));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "categories", categories));
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "downsampled", downsampled));
+  CORRADE_COMPARE(downsampled.buffer->shape,
+                  (std::vector<size_t>{32, 32, 1}));
+  CORRADE_COMPARE(downsampled.buffer->dataType,
+                  esp::core::DataType::DT_UINT32);
+
+  const auto idPixels =
+      Cr::Containers::arrayCast<const Mn::UnsignedInt>(ids.buffer->data);
+  const auto categoryPixels = Cr::Containers::arrayCast<const Mn::UnsignedInt>(
+      categories.buffer->data);
+  const auto downsampledPixels =
+      Cr::Containers::arrayCast<const Mn::UnsignedInt>(
+          downsampled.buffer->data);
+  std::size_t numMapped = 0;
+  for (std::size_t i = 0; i != idPixels.size(); ++i) {
+    CORRADE_COMPARE(categoryPixels[i], category(idPixels[i]));
+    numMapped += categoryPixels[i] != 0;
+  }
+  // the boxes are in view
+  CORRADE_VERIFY(numMapped > 0);
+  // the ID nearest to the center of each square of pixels
+  for (int y = 0; y != 32; ++y) {
+    for (int x = 0; x != 32; ++x) {
+      CORRADE_COMPARE(downsampledPixels[y * 32 + x],
+                      category(idPixels[(2 * y + 1) * 64 + 2 * x + 1]));
+    }
+  }
+}
+
+void SimTest::readVisibleObjects() {
+  SimulatorConfiguration simConfig{};
+  simConfig.scene.id = vangogh;
+  simConfig.enablePhysics = true;
+  simConfig.physicsConfigFile = physicsConfigFile;
+  Simulator simulator(simConfig);
+  auto objs = simulator.getObjectAttributesManager()
+                  ->getObjectHandlesBySubstring("nested_box");
+  for (int i = 0; i < 3; ++i) {
+    int objectID = simulator.addObjectByHandle(objs[0]);
+    CORRADE_INTERNAL_ASSERT(objectID != esp::ID_UNDEFINED);
+    simulator.setTranslation({1.0f - 0.6f * i, 0.5f, -0.5f}, objectID);
+    simulator.setObjectSemanticId(i + 1, objectID);
+  }
+  auto spec = SensorSpec::create();
+  spec->uuid = "ids";
+  spec->sensorType = SensorType::SEMANTIC;
+  spec->position = {0.0f, 1.5f, 2.0f};
+  spec->resolution = {64, 48};
+  spec->channels = 1;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {spec};
+  simulator.addAgent(agentConfig)->setState(AgentState{});
+
+  Observation ids;
+  CORRADE_VERIFY(simulator.getAgentObservation(0, "ids", ids));
+  const auto idPixels =
+      Cr::Containers::arrayCast<const Mn::UnsignedInt>(ids.buffer->data);
+  const Mn::Int width = 48;
+
+  // what np.unique and a bounding box of each ID would give, the last box
+  // is past the capacity
+  const Mn::UnsignedInt capacity = 3;
+  std::map<Mn::UnsignedInt, esp::gfx::VisibleObject> expected;
+  for (std::size_t i = 0; i != idPixels.size(); ++i) {
+    if (idPixels[i] >= capacity) {
+      continue;
+    }
+    const Mn::Vector2i pixel{Mn::Int(i % width), Mn::Int(i / width)};
+    const Mn::Range2Di bounds{pixel, pixel + Mn::Vector2i{1}};
+    auto it = expected.find(idPixels[i]);
+    if (it == expected.end()) {
+      expected[idPixels[i]] = {idPixels[i], 1, bounds};
+    } else {
+      ++it->second.pixelCount;
+      it->second.bounds = Mn::Math::join(it->second.bounds, bounds);
+    }
+  }
+  // the boxes are in view
+  CORRADE_VERIFY(expected.count(1) || expected.count(2));
+
+  auto& sensor = static_cast<esp::sensor::VisualSensor&>(
+      *simulator.getAgent(0)->getSensorSuite().get("ids"));
+  std::vector<esp::gfx::VisibleObject> objects;
+  sensor.renderTarget().readVisibleObjects(capacity, objects);
+  CORRADE_COMPARE(objects.size(), expected.size());
+  auto it = expected.begin();
+  for (const esp::gfx::VisibleObject& object : objects) {
+    CORRADE_ITERATION(object.objectId);
+    CORRADE_COMPARE(object.objectId, it->first);
+    CORRADE_COMPARE(object.pixelCount, it->second.pixelCount);
+    CORRADE_COMPARE(object.bounds, it->second.bounds);
+    ++it;
+  }
+
+  // nothing is counted without a capacity
+  sensor.renderTarget().readVisibleObjects(0, objects);
+  CORRADE_VERIFY(objects.empty());
+}
+
+void SimTest::getInstancedObjectsRGBAObservation() {
+  auto pinholeCameraSpec = SensorSpec::create();
+  pinholeCameraSpec->sensorSubtype = "pinhole";
+  pinholeCameraSpec->sensorType = SensorType::COLOR;
+  pinholeCameraSpec->position = {1.0f, 1.5f, 1.0f};
+  pinholeCameraSpec->resolution = {128, 128};
+
+  // the same scene with several copies of an object, drawn with and without
+  // instancing
+  const auto render = [&](bool instanced, size_t& numDrawables) {
+    SimulatorConfiguration simConfig{};
+    simConfig.scene.id = vangogh;
+    simConfig.enablePhysics = true;
+    simConfig.physicsConfigFile = physicsConfigFile;
+    simConfig.instancedObjectRendering = instanced;
+    auto simulator = Simulator::create_unique(simConfig);
+
+    auto objs = simulator->getObjectAttributesManager()
+                    ->getObjectHandlesBySubstring("nested_box");
+    for (int i = 0; i < 3; ++i) {
+      int objectID = simulator->addObjectByHandle(objs[0]);
+      CORRADE_INTERNAL_ASSERT(objectID != esp::ID_UNDEFINED);
+      simulator->setTranslation({1.0f - 0.6f * i, 0.5f, -0.5f}, objectID);
+    }
+    numDrawables = simulator->getActiveSceneGraph().getDrawables().size();
+
+    AgentConfiguration agentConfig{};
+    agentConfig.sensorSpecifications = {pinholeCameraSpec};
+    Agent::ptr agent = simulator->addAgent(agentConfig);
+    agent->setInitialState(AgentState{});
+
+    Observation observation;
+    CORRADE_INTERNAL_ASSERT_OUTPUT(simulator->getAgentObservation(
+        0, pinholeCameraSpec->uuid, observation));
+    return std::vector<uint8_t>(observation.buffer->data.begin(),
+                                observation.buffer->data.end());
+  };
+
+  size_t numDrawables = 0;
+  size_t numInstancedDrawables = 0;
+  const std::vector<uint8_t> expected = render(false, numDrawables);
+  const std::vector<uint8_t> instanced = render(true, numInstancedDrawables);
+  CORRADE_VERIFY(numInstancedDrawables < numDrawables);
+
+  const Mn::Vector2i size{pinholeCameraSpec->resolution[0],
+                          pinholeCameraSpec->resolution[1]};
+  CORRADE_COMPARE_WITH(
+      (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size, instanced}),
+      (Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm, size, expected}),
+      (Mn::DebugTools::CompareImage{1.0f, 0.01f}));
+}
+
 void SimTest::getSceneWithLightingRGBAObservation() {
   setTestCaseName(CORRADE_FUNCTION);
   auto simulator = getSimulator(vangogh, "custom_lighting_1");
@@ -436,6 +2557,13 @@ void SimTest::loadingObjectTemplates() {
   std::vector<int> templateIndices2 = objectAttribsMgr->loadObjectConfigs(
       Cr::Utility::Directory::join(TEST_ASSETS, "objects"));
   CORRADE_VERIFY(templateIndices2 == templateIndices);
+  // parsing on one or several threads registers the same templates
+  CORRADE_VERIFY(objectAttribsMgr->loadObjectConfigs(
+                     Cr::Utility::Directory::join(TEST_ASSETS, "objects"),
+                     false, 1) == templateIndices);
+  CORRADE_VERIFY(objectAttribsMgr->loadObjectConfigs(
+                     Cr::Utility::Directory::join(TEST_ASSETS, "objects"),
+                     false, 3) == templateIndices);
 
   // test the loaded assets and accessing them by name
   // verify that getting the template handles with empty string returns all
@@ -479,6 +2607,27 @@ void SimTest::loadingObjectTemplates() {
   CORRADE_VERIFY(newTemplate2->getRenderAssetHandle() == chairPath);
 }
 
+void SimTest::loadSceneInstance() {
+  auto simulator = getSimulator(vangogh);
+  std::vector<int> objectIDs = simulator->loadSceneInstance(
+      Cr::Utility::Directory::join(TEST_ASSETS, "testing.scene_instance.json"));
+  // the last instance has no matching template
+  CORRADE_COMPARE(objectIDs.size(), 3);
+  CORRADE_VERIFY(objectIDs[0] != esp::ID_UNDEFINED);
+  CORRADE_VERIFY(objectIDs[1] != esp::ID_UNDEFINED);
+  CORRADE_COMPARE(objectIDs[2], esp::ID_UNDEFINED);
+  CORRADE_COMPARE(simulator->getExistingObjectIDs().size(), 2);
+
+  CORRADE_COMPARE(simulator->getTranslation(objectIDs[0]),
+                  Magnum::Vector3(1, 2, 3));
+  CORRADE_COMPARE(simulator->getTranslation(objectIDs[1]),
+                  Magnum::Vector3(-1, 2, 3));
+  CORRADE_VERIFY(simulator->getObjectMotionType(objectIDs[0]) ==
+                 esp::physics::MotionType::STATIC);
+  CORRADE_VERIFY(simulator->getObjectMotionType(objectIDs[1]) !=
+                 esp::physics::MotionType::STATIC);
+}
+
 void SimTest::buildingPrimAssetObjectTemplates() {
   Corrade::Utility::Debug()
       << "Starting Test : buildingPrimAssetObjectTemplates ";
@@ -0,0 +1,248 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures the frame rate of N environments stepped and observed in one
+// process, without the interprocess communication of examples/benchmark.py
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Corrade/Utility/Arguments.h>
+#include <Magnum/GL/OpenGL.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/esp.h"
+#include "esp/gfx/GpuDevices.h"
+#include "esp/physics/configure.h"
+#include "esp/sim/VectorSimulator.h"
+
+namespace Cr = Corrade;
+
+using esp::agent::AgentConfiguration;
+using esp::core::ProfilingStats;
+using esp::sensor::SensorSpec;
+using esp::sensor::SensorType;
+using esp::sim::SimulatorConfiguration;
+using esp::sim::VectorSimulator;
+
+namespace {
+
+//! the heap allocations of the process, counted by the operators below
+std::atomic<size_t> numHeapAllocations{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  ++numHeapAllocations;
+  if (void* data = std::malloc(size ? size : 1)) {
+    return data;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* data) noexcept {
+  std::free(data);
+}
+
+void operator delete(void* data, size_t) noexcept {
+  std::free(data);
+}
+
+namespace {
+
+// GL_NVX_gpu_memory_info, in KiB
+constexpr GLenum GpuMemoryTotalNVX = 0x9048;
+constexpr GLenum GpuMemoryAvailableNVX = 0x9049;
+
+//! the GPU memory the context uses, 0 if the driver can't tell
+size_t gpuMemoryUsed() {
+  GLint total = 0;
+  GLint available = 0;
+  glGetIntegerv(GpuMemoryTotalNVX, &total);
+  glGetIntegerv(GpuMemoryAvailableNVX, &available);
+  if (glGetError() != GL_NO_ERROR) {
+    return 0;
+  }
+  return size_t(total - available) * 1024;
+}
+
+void printTiming(const char* stage,
+                 const ProfilingStats::Timing& timing,
+                 int frames) {
+  std::printf("  %-20s %10.3f %10.3f %10.1f\n", stage,
+              timing.cpuTimeMs / frames, timing.gpuTimeMs / frames,
+              double(timing.calls) / frames);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Cr::Utility::Arguments args;
+  args.addArgument("scene")
+      .setHelp("scene", "scene/stage file to load")
+      .addOption("num-envs", "1")
+      .setHelp("num-envs", "environments stepped together")
+      .addOption("sensors", "color")
+      .setHelp("sensors",
+               "comma-separated sensors of each agent, any of color, depth "
+               "and semantic")
+      .addOption("resolution", "128")
+      .setHelp("resolution", "width and height of each sensor", "R")
+      .addOption("frames", "1000")
+      .setHelp("frames", "frames measured after the warm-up")
+      .addOption("warmup-frames", "20")
+      .setHelp("warmup-frames", "frames stepped before the measurement")
+      .addBooleanOption("enable-physics")
+      .addOption("physics-config", ESP_DEFAULT_PHYS_SCENE_CONFIG_REL_PATH)
+      .setHelp("physics-config",
+               "Provide a non-default PhysicsManager config file.")
+      .addBooleanOption("disable-frustum-culling")
+      .addBooleanOption("ptex-geometry-shader")
+      .setHelp("ptex-geometry-shader",
+               "draw PTex meshes, e.g. Replica scenes, with the geometry "
+               "shader expanding their quads instead of as triangles")
+      .addOption("gpu-device", "0")
+      .addOption("seed", "1")
+      .setGlobalHelp(
+          "Steps agents taking random actions in N environments of one "
+          "process and reports the frames per second, the time of each "
+          "stage per frame and the GPU memory used.")
+      .parse(argc, argv);
+
+  const int numEnvs = args.value<int>("num-envs");
+  const int resolution = args.value<int>("resolution");
+  const int frames = args.value<int>("frames");
+  const int warmupFrames = args.value<int>("warmup-frames");
+  if (numEnvs < 1 || resolution < 1 || frames < 1 || warmupFrames < 0) {
+    LOG(ERROR) << "benchmark: num-envs, resolution and frames must be "
+                  "positive";
+    return 1;
+  }
+
+  SimulatorConfiguration simConfig;
+  simConfig.scene.id = args.value("scene");
+  simConfig.gpuDeviceId = args.value<int>("gpu-device");
+  simConfig.enablePhysics = args.isSet("enable-physics");
+  simConfig.physicsConfigFile = args.value("physics-config");
+  simConfig.frustumCulling = !args.isSet("disable-frustum-culling");
+  simConfig.ptexGeometryShader = args.isSet("ptex-geometry-shader");
+
+  AgentConfiguration agentConfig;
+  agentConfig.sensorSpecifications.clear();
+  bool requiresTextures = false;
+  std::istringstream sensorNames{args.value("sensors")};
+  for (std::string name; std::getline(sensorNames, name, ',');) {
+    if (name.empty()) {
+      continue;
+    }
+    auto spec = SensorSpec::create();
+    spec->uuid = name;
+    spec->position = {0.0f, 1.5f, 0.0f};
+    spec->resolution = {resolution, resolution};
+    if (name == "color") {
+      spec->sensorType = SensorType::COLOR;
+      requiresTextures = true;
+    } else if (name == "depth") {
+      spec->sensorType = SensorType::DEPTH;
+      spec->channels = 1;
+    } else if (name == "semantic") {
+      spec->sensorType = SensorType::SEMANTIC;
+      spec->channels = 1;
+    } else {
+      LOG(ERROR) << "benchmark: unknown sensor " << name;
+      return 1;
+    }
+    agentConfig.sensorSpecifications.push_back(spec);
+  }
+  simConfig.requiresTextures = requiresTextures;
+
+  std::vector<SimulatorConfiguration> simConfigs;
+  for (int i = 0; i < numEnvs; ++i) {
+    simConfig.randomSeed = args.value<unsigned int>("seed") + i;
+    simConfigs.push_back(simConfig);
+  }
+  VectorSimulator simulator{simConfigs, agentConfig};
+  for (int i = 0; i < numEnvs; ++i) {
+    simulator.getEnv(i).setFrustumCullingEnabled(simConfig.frustumCulling);
+  }
+
+  std::mt19937 random{args.value<unsigned int>("seed")};
+  const std::vector<std::string> actionNames{"moveForward", "turnLeft",
+                                             "turnRight"};
+  std::uniform_int_distribution<int> actionDistribution{
+      0, int(actionNames.size()) - 1};
+  std::vector<std::string> actions(numEnvs);
+  const auto step = [&]() {
+    for (std::string& action : actions) {
+      action = actionNames[actionDistribution(random)];
+    }
+    simulator.stepAll(actions);
+  };
+
+  for (int frame = 0; frame < warmupFrames; ++frame) {
+    step();
+  }
+
+  esp::sim::Simulator& env = simulator.getEnv(0);
+  env.resetProfilingStats();
+  env.setProfilingEnabled(true);
+  const size_t heapAllocationsBefore = numHeapAllocations;
+  const auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    step();
+  }
+  glFinish();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const size_t heapAllocations = numHeapAllocations - heapAllocationsBefore;
+  env.setProfilingEnabled(false);
+  const ProfilingStats stats = env.getProfilingStats();
+
+  std::printf("%d environments, sensors %s at %dx%d, physics %s, culling %s\n",
+              numEnvs, args.value("sensors").c_str(), resolution, resolution,
+              simConfig.enablePhysics ? "on" : "off",
+              simConfig.frustumCulling ? "on" : "off");
+  std::printf("frames per second: %.1f per environment, %.1f in total\n",
+              frames / elapsed.count(), frames * numEnvs / elapsed.count());
+
+  // the stages cover all environments of a step
+  std::printf("\n  %-20s %10s %10s %10s\n", "stage per step", "cpu ms",
+              "gpu ms", "calls");
+  printTiming("agent observations", stats.agentObservations, frames);
+  printTiming("physics", stats.physics, frames);
+  printTiming("culling", stats.culling, frames);
+  printTiming("drawing", stats.drawing, frames);
+  printTiming("readback", stats.readback, frames);
+  printTiming("noise", stats.noise, frames);
+  std::printf("  drawables culled per step: %.1f, draw calls per step: %.1f\n",
+              double(stats.drawablesCulled) / frames,
+              double(stats.drawCalls) / frames);
+  std::printf("  heap allocations per step: %.1f\n",
+              double(heapAllocations) / frames);
+
+  std::printf("\nGPU memory\n");
+  const size_t contextMemory = gpuMemoryUsed();
+  if (contextMemory) {
+    std::printf("  used on device %d: %.1f MiB\n", simulator.gpuDevice(),
+                contextMemory / (1024.0 * 1024.0));
+  }
+  for (const esp::gfx::GpuDeviceInfo& device : esp::gfx::gpuDevices()) {
+    if (device.totalMemory) {
+      std::printf("  device %d: %.1f of %.1f MiB free\n", device.device,
+                  device.freeMemory / (1024.0 * 1024.0),
+                  device.totalMemory / (1024.0 * 1024.0));
+    }
+  }
+  if (!contextMemory && !esp::gfx::gpuDevices()[0].totalMemory) {
+    std::printf("  unknown, the driver reports no GPU memory\n");
+  }
+  return 0;
+}
@@ -0,0 +1,240 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures the time of each phase of loading a scene and the host and GPU
+// memory it takes, with cold and warm caches, for the scenes of a data
+// directory, writing one JSON object per load
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/String.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/esp.h"
+#include "esp/gfx/GpuDevices.h"
+#include "esp/sim/Simulator.h"
+
+namespace Cr = Corrade;
+
+using Cr::Utility::Directory;
+using Cr::Utility::String::endsWith;
+using esp::core::Profiler;
+using esp::core::ProfilingStage;
+using esp::core::ProfilingStats;
+using esp::core::peakResidentMemory;
+using esp::core::residentMemory;
+using esp::sim::SimulatorConfiguration;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+//! the timed phases, in the order they run, and their JSON keys
+const struct {
+  ProfilingStage stage;
+  const char* key;
+} LoadPhases[]{
+    {ProfilingStage::ContextCreation, "context_creation_ms"},
+    {ProfilingStage::ImporterSetup, "importer_setup_ms"},
+    {ProfilingStage::StageLoading, "stage_loading_ms"},
+    {ProfilingStage::AssetImport, "asset_import_ms"},
+    {ProfilingStage::HierarchyJoin, "hierarchy_join_ms"},
+    {ProfilingStage::BoundsComputation, "bounds_computation_ms"},
+    {ProfilingStage::GpuUpload, "gpu_upload_ms"},
+    {ProfilingStage::CollisionMeshBuild, "collision_mesh_build_ms"},
+    {ProfilingStage::ShaderCompilation, "shader_compilation_ms"},
+    {ProfilingStage::SemanticSceneLoading, "semantic_scene_loading_ms"},
+    {ProfilingStage::NavmeshLoading, "navmesh_loading_ms"},
+};
+
+//! whether @p file is a scene the simulator loads as a stage: GLB and glTF
+//! meshes, including MP3D ones, and Replica PTex meshes
+bool isSceneFile(const std::string& file) {
+  return endsWith(file, ".glb") || endsWith(file, ".gltf") ||
+         Directory::filename(file) == "mesh.ply";
+}
+
+//! the scenes under @p dir, sorted, skipping the object models
+void findScenes(const std::string& dir, std::vector<std::string>& scenes) {
+  for (const std::string& name :
+       Directory::list(dir, Directory::Flag::SkipDotAndDotDot |
+                                Directory::Flag::SortAscending)) {
+    const std::string path = Directory::join(dir, name);
+    if (Directory::isDirectory(path)) {
+      if (name != "objects") {
+        findScenes(path, scenes);
+      }
+    } else if (isSceneFile(path)) {
+      scenes.push_back(path);
+    }
+  }
+}
+
+//! the format of a scene file, to group the results of similar scenes
+std::string sceneFormat(const std::string& scene) {
+  if (Directory::filename(scene) == "mesh.ply") {
+    return "ptex";
+  }
+  if (Directory::exists(Directory::splitExtension(scene).first + ".house")) {
+    return "mp3d";
+  }
+  const std::string extension = Directory::splitExtension(scene).second;
+  return extension.empty() ? "unknown" : extension.substr(1);
+}
+
+//! remove the files of the cache directory @p dir, which has no
+//! subdirectories
+void clearCacheDir(const std::string& dir) {
+  for (const std::string& name :
+       Directory::list(dir, Directory::Flag::SkipDotAndDotDot)) {
+    Directory::rm(Directory::join(dir, name));
+  }
+}
+
+//! @p value as a JSON string
+std::string jsonString(const std::string& value) {
+  std::string json = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      json += '\\';
+    }
+    json += c;
+  }
+  return json + "\"";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Cr::Utility::Arguments args;
+  args.addArgument("data-dir")
+      .setHelp("data-dir", "directory searched for scenes, e.g. data/")
+      .addOption("scenes", "")
+      .setHelp("scenes",
+               "comma-separated scene files to load instead of those found "
+               "in the data directory")
+      .addOption("warm-runs", "3")
+      .setHelp("warm-runs", "loads per scene after the cold one")
+      .addOption("cache-dir", "")
+      .setHelp("cache-dir",
+               "directory of the texture transcode and shader program "
+               "caches, emptied before the cold load of each scene, no "
+               "caches if empty")
+      .addBooleanOption("enable-physics")
+      .addOption("label", "")
+      .setHelp("label", "written with each result, e.g. the commit measured")
+      .addOption("output", "")
+      .setHelp("output", "file to write the results to, stdout if empty")
+      .addOption("gpu-device", "0")
+      .setGlobalHelp(
+          "Constructs a simulator for each scene, once with empty caches and "
+          "then again with the caches filled, and writes the time of each "
+          "loading phase, the resident host memory and the tracked GPU "
+          "memory after each load as one JSON object per line. The peak "
+          "resident memory is that of the process so far, run a single "
+          "scene per process for its own peak. Scene cache files baked next "
+          "to the assets are used by all loads, and the cold load may still "
+          "hit the page cache of the OS.")
+      .parse(argc, argv);
+
+  const int warmRuns = args.value<int>("warm-runs");
+  if (warmRuns < 0) {
+    LOG(ERROR) << "load_benchmark: warm-runs must not be negative";
+    return 1;
+  }
+
+  std::vector<std::string> scenes;
+  std::istringstream sceneNames{args.value("scenes")};
+  for (std::string scene; std::getline(sceneNames, scene, ',');) {
+    if (!scene.empty()) {
+      scenes.push_back(scene);
+    }
+  }
+  if (scenes.empty()) {
+    findScenes(args.value("data-dir"), scenes);
+  }
+  if (scenes.empty()) {
+    LOG(ERROR) << "load_benchmark: no scenes found in "
+               << args.value("data-dir");
+    return 1;
+  }
+
+  FILE* output = stdout;
+  if (!args.value("output").empty()) {
+    output = std::fopen(args.value("output").c_str(), "w");
+    if (output == nullptr) {
+      LOG(ERROR) << "load_benchmark: cannot write to " << args.value("output");
+      return 1;
+    }
+  }
+
+  const std::string cacheDir = args.value("cache-dir");
+  SimulatorConfiguration simConfig;
+  simConfig.gpuDeviceId = args.value<int>("gpu-device");
+  simConfig.enablePhysics = args.isSet("enable-physics");
+  if (!cacheDir.empty()) {
+    simConfig.textureTranscodeCacheDir = Directory::join(cacheDir, "textures");
+    simConfig.programBinaryCacheDir = Directory::join(cacheDir, "programs");
+  }
+
+  for (const std::string& scene : scenes) {
+    simConfig.scene.id = scene;
+    if (!cacheDir.empty()) {
+      clearCacheDir(simConfig.textureTranscodeCacheDir);
+      clearCacheDir(simConfig.programBinaryCacheDir);
+    }
+    for (int run = 0; run <= warmRuns; ++run) {
+      const std::uint64_t residentBefore = residentMemory();
+      Profiler::reset();
+      Profiler::setEnabled(true);
+      const Clock::time_point start = Clock::now();
+      auto simulator = esp::sim::Simulator::create_unique(simConfig);
+      const double constructionMs =
+          std::chrono::duration<double, std::milli>(Clock::now() - start)
+              .count();
+      Profiler::setEnabled(false);
+      const ProfilingStats stats = Profiler::stats();
+      const std::uint64_t resident = residentMemory();
+      const esp::gfx::GpuMemoryUsage gpuMemory =
+          simulator->getGpuMemoryUsage();
+
+      std::fprintf(output,
+                   "{\"label\": %s, \"scene\": %s, \"format\": %s, "
+                   "\"cache\": \"%s\", \"run\": %d, \"construction_ms\": %.3f",
+                   jsonString(args.value("label")).c_str(),
+                   jsonString(scene).c_str(),
+                   jsonString(sceneFormat(scene)).c_str(),
+                   run == 0 ? "cold" : "warm", run, constructionMs);
+      for (const auto& phase : LoadPhases) {
+        std::fprintf(output, ", \"%s\": %.3f", phase.key,
+                     stats.timing(phase.stage).cpuTimeMs);
+      }
+      std::fprintf(
+          output,
+          ", \"resident_bytes\": %llu, \"resident_growth_bytes\": %lld, "
+          "\"peak_resident_bytes\": %llu, \"gpu_mesh_bytes\": %zu, "
+          "\"gpu_texture_bytes\": %zu, \"gpu_ptex_atlas_bytes\": %zu, "
+          "\"gpu_bytes\": %zu}\n",
+          static_cast<unsigned long long>(resident),
+          static_cast<long long>(resident) -
+              static_cast<long long>(residentBefore),
+          static_cast<unsigned long long>(peakResidentMemory()),
+          gpuMemory.meshBytes, gpuMemory.textureBytes,
+          gpuMemory.ptexAtlasBytes, gpuMemory.totalBytes());
+      std::fflush(output);
+    }
+  }
+
+  if (output != stdout) {
+    std::fclose(output);
+  }
+  return 0;
+}
@@ -0,0 +1,292 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures the rendering of a set of scenes over a sweep of resolutions,
+// sensor types and renderer features, writing one JSON object per
+// configuration to compare the frame times across commits
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/String.h>
+#include <Magnum/GL/OpenGL.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/esp.h"
+#include "esp/sim/Simulator.h"
+
+namespace Cr = Corrade;
+
+using esp::agent::AgentConfiguration;
+using esp::core::ProfilingStats;
+using esp::sensor::SensorSpec;
+using esp::sensor::SensorType;
+using esp::sim::Simulator;
+using esp::sim::SimulatorConfiguration;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+//! the renderer features that can be swept, toggled at runtime
+enum Feature : unsigned {
+  FrustumCulling = 1 << 0,
+  SortedDraws = 1 << 1,
+  Instancing = 1 << 2,
+};
+
+const struct {
+  const char* name;
+  Feature feature;
+} FeatureNames[]{
+    {"culling", FrustumCulling},
+    {"sorted-draws", SortedDraws},
+    {"instancing", Instancing},
+};
+
+//! an agent with a single sensor, one per swept resolution and sensor type
+struct SweptSensor {
+  int agentId;
+  std::string sensor;
+  int resolution;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::istringstream stream{list};
+  for (std::string item; std::getline(stream, item, ',');) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+//! the format of a scene file, to group the results of similar scenes
+std::string sceneFormat(const std::string& scene) {
+  if (Cr::Utility::String::endsWith(scene, "_semantic.ply") ||
+      Cr::Utility::String::endsWith(scene, ".house")) {
+    return "instance mesh";
+  }
+  if (Cr::Utility::String::endsWith(scene, "mesh.ply")) {
+    return "ptex";
+  }
+  const size_t dot = scene.rfind('.');
+  return dot == std::string::npos ? "unknown" : scene.substr(dot + 1);
+}
+
+//! @p value as a JSON string
+std::string jsonString(const std::string& value) {
+  std::string json = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      json += '\\';
+    }
+    json += c;
+  }
+  return json + "\"";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Cr::Utility::Arguments args;
+  args.addArgument("scenes")
+      .setHelp("scenes",
+               "comma-separated scene/stage files to load, e.g. a GLB, a "
+               "Replica PTex mesh and an MP3D house")
+      .addOption("resolutions", "128,256,512")
+      .setHelp("resolutions", "comma-separated sensor widths and heights")
+      .addOption("sensors", "color,depth,semantic")
+      .setHelp("sensors",
+               "comma-separated sensor types measured one at a time, any of "
+               "color, depth and semantic")
+      .addOption("features", "culling,sorted-draws,instancing")
+      .setHelp("features",
+               "comma-separated renderer features measured on and off in "
+               "all combinations, any of culling, sorted-draws and "
+               "instancing")
+      .addOption("frames", "200")
+      .setHelp("frames", "frames measured per configuration")
+      .addOption("warmup-frames", "20")
+      .setHelp("warmup-frames", "frames drawn before each measurement")
+      .addOption("label", "")
+      .setHelp("label", "written with each result, e.g. the commit measured")
+      .addOption("output", "")
+      .setHelp("output", "file to write the results to, stdout if empty")
+      .addOption("gpu-device", "0")
+      .addOption("seed", "1")
+      .setGlobalHelp(
+          "Draws the observations of an agent walking randomly through each "
+          "scene, for each resolution, sensor type and combination of "
+          "renderer features, and writes the frames per second and the "
+          "draw, readback and GPU time per frame as one JSON object per "
+          "line.")
+      .parse(argc, argv);
+
+  const int frames = args.value<int>("frames");
+  const int warmupFrames = args.value<int>("warmup-frames");
+  if (frames < 1 || warmupFrames < 0) {
+    LOG(ERROR) << "render_benchmark: frames must be positive";
+    return 1;
+  }
+
+  std::vector<int> resolutions;
+  for (const std::string& resolution : splitList(args.value("resolutions"))) {
+    resolutions.push_back(std::stoi(resolution));
+    if (resolutions.back() < 1) {
+      LOG(ERROR) << "render_benchmark: resolutions must be positive";
+      return 1;
+    }
+  }
+
+  unsigned sweptFeatures = 0;
+  for (const std::string& name : splitList(args.value("features"))) {
+    bool known = false;
+    for (const auto& feature : FeatureNames) {
+      if (name == feature.name) {
+        sweptFeatures |= feature.feature;
+        known = true;
+      }
+    }
+    if (!known) {
+      LOG(ERROR) << "render_benchmark: unknown feature " << name;
+      return 1;
+    }
+  }
+
+  // one agent per sensor, so a scene is loaded once for the whole sweep
+  std::vector<AgentConfiguration> agentConfigs;
+  std::vector<SweptSensor> sweptSensors;
+  bool requiresTextures = false;
+  for (const std::string& name : splitList(args.value("sensors"))) {
+    for (int resolution : resolutions) {
+      auto spec = SensorSpec::create();
+      spec->uuid = name;
+      spec->position = {0.0f, 1.5f, 0.0f};
+      spec->resolution = {resolution, resolution};
+      if (name == "color") {
+        spec->sensorType = SensorType::COLOR;
+        requiresTextures = true;
+      } else if (name == "depth") {
+        spec->sensorType = SensorType::DEPTH;
+        spec->channels = 1;
+      } else if (name == "semantic") {
+        spec->sensorType = SensorType::SEMANTIC;
+        spec->channels = 1;
+      } else {
+        LOG(ERROR) << "render_benchmark: unknown sensor " << name;
+        return 1;
+      }
+      AgentConfiguration agentConfig;
+      agentConfig.sensorSpecifications = {spec};
+      sweptSensors.push_back(
+          SweptSensor{int(agentConfigs.size()), name, resolution});
+      agentConfigs.push_back(agentConfig);
+    }
+  }
+
+  FILE* output = stdout;
+  if (!args.value("output").empty()) {
+    output = std::fopen(args.value("output").c_str(), "w");
+    if (output == nullptr) {
+      LOG(ERROR) << "render_benchmark: cannot write to "
+                 << args.value("output");
+      return 1;
+    }
+  }
+
+  SimulatorConfiguration simConfig;
+  simConfig.gpuDeviceId = args.value<int>("gpu-device");
+  simConfig.requiresTextures = requiresTextures;
+  const unsigned int seed = args.value<unsigned int>("seed");
+  const std::vector<std::string> actionNames{"moveForward", "turnLeft",
+                                             "turnRight"};
+
+  for (const std::string& scene : splitList(args.value("scenes"))) {
+    simConfig.scene.id = scene;
+    auto simulator = Simulator::create_unique(simConfig);
+    std::vector<esp::agent::AgentState::ptr> initialStates;
+    for (const AgentConfiguration& agentConfig : agentConfigs) {
+      initialStates.push_back(esp::agent::AgentState::create());
+      simulator->addAgent(agentConfig)->getState(initialStates.back());
+    }
+
+    for (const SweptSensor& swept : sweptSensors) {
+      // every subset of the swept features, the unswept ones stay on
+      for (unsigned features = 0; features <= sweptFeatures; ++features) {
+        if (features & ~sweptFeatures) {
+          continue;
+        }
+        const unsigned enabled = features | (~sweptFeatures & 7u);
+        simulator->setFrustumCullingEnabled(enabled & FrustumCulling);
+        simulator->setSortByDrawStateEnabled(enabled & SortedDraws);
+        simulator->setInstancedObjectRenderingEnabled(enabled & Instancing);
+
+        // the same walk for every configuration and commit
+        std::mt19937 random{seed};
+        std::uniform_int_distribution<int> actionDistribution{
+            0, int(actionNames.size()) - 1};
+        esp::agent::Agent::ptr agent = simulator->getAgent(swept.agentId);
+        agent->setState(*initialStates[swept.agentId]);
+        esp::sensor::Observation observation;
+        const auto frame = [&]() {
+          agent->act(actionNames[actionDistribution(random)]);
+          simulator->getAgentObservation(swept.agentId, swept.sensor,
+                                         observation);
+        };
+
+        for (int i = 0; i < warmupFrames; ++i) {
+          frame();
+        }
+        simulator->resetProfilingStats();
+        simulator->setProfilingEnabled(true);
+        const Clock::time_point start = Clock::now();
+        for (int i = 0; i < frames; ++i) {
+          frame();
+        }
+        glFinish();
+        const std::chrono::duration<double> elapsed = Clock::now() - start;
+        simulator->setProfilingEnabled(false);
+        const ProfilingStats stats = simulator->getProfilingStats();
+
+        std::fprintf(
+            output,
+            "{\"label\": %s, \"scene\": %s, \"format\": %s, "
+            "\"sensor\": %s, \"resolution\": %d, \"culling\": %s, "
+            "\"sorted_draws\": %s, \"instancing\": %s, \"frames\": %d, "
+            "\"fps\": %.2f, \"frame_ms\": %.4f, \"culling_ms\": %.4f, "
+            "\"draw_ms\": %.4f, \"readback_ms\": %.4f, "
+            "\"draw_gpu_ms\": %.4f, \"readback_gpu_ms\": %.4f, "
+            "\"gpu_ms\": %.4f, \"draw_calls\": %.1f, "
+            "\"drawables_culled\": %.1f}\n",
+            jsonString(args.value("label")).c_str(),
+            jsonString(scene).c_str(), jsonString(sceneFormat(scene)).c_str(),
+            jsonString(swept.sensor).c_str(), swept.resolution,
+            enabled & FrustumCulling ? "true" : "false",
+            enabled & SortedDraws ? "true" : "false",
+            enabled & Instancing ? "true" : "false", frames,
+            frames / elapsed.count(), elapsed.count() * 1000.0 / frames,
+            stats.culling.cpuTimeMs / frames, stats.drawing.cpuTimeMs / frames,
+            stats.readback.cpuTimeMs / frames,
+            stats.drawing.gpuTimeMs / frames,
+            stats.readback.gpuTimeMs / frames,
+            (stats.drawing.gpuTimeMs + stats.readback.gpuTimeMs) / frames,
+            double(stats.drawCalls) / frames,
+            double(stats.drawablesCulled) / frames);
+        std::fflush(output);
+      }
+    }
+  }
+
+  if (output != stdout) {
+    std::fclose(output);
+  }
+  return 0;
+}
@@ -0,0 +1,171 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Replays a session recorded by Simulator::startRecording() headless and
+// reports the time it took, per recorded call and per profiled stage, so that
+// builds can be compared on real workloads
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include <Corrade/Utility/Arguments.h>
+#include <Magnum/GL/OpenGL.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/esp.h"
+#include "esp/physics/configure.h"
+#include "esp/sim/SessionRecording.h"
+#include "esp/sim/Simulator.h"
+
+namespace Cr = Corrade;
+
+using esp::core::ProfilingStats;
+using esp::sim::SessionEvent;
+using esp::sim::SessionEventType;
+using esp::sim::SessionRecording;
+using esp::sim::SessionReplayTimes;
+using esp::sim::Simulator;
+using esp::sim::SimulatorConfiguration;
+
+namespace {
+
+void printTiming(const char* stage,
+                 const ProfilingStats::Timing& timing,
+                 int runs) {
+  std::printf("  %-20s %10.3f %10.3f %10.1f\n", stage,
+              timing.cpuTimeMs / runs, timing.gpuTimeMs / runs,
+              double(timing.calls) / runs);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Cr::Utility::Arguments args;
+  args.addArgument("recording")
+      .setHelp("recording", "session recorded by Simulator::startRecording()")
+      .addOption("scene", "")
+      .setHelp("scene", "scene to load instead of the recorded one")
+      .addOption("runs", "3")
+      .setHelp("runs", "times the session is replayed, the first one warms up")
+      .addBooleanOption("enable-physics")
+      .addOption("physics-config", ESP_DEFAULT_PHYS_SCENE_CONFIG_REL_PATH)
+      .setHelp("physics-config",
+               "Provide a non-default PhysicsManager config file.")
+      .addBooleanOption("render-only")
+      .setHelp("render-only", "load no physics engine and collision meshes")
+      .addBooleanOption("disable-frustum-culling")
+      .addOption("gpu-device", "0")
+      .setGlobalHelp(
+          "Replays a recorded simulator session headless and reports the "
+          "time of each recorded call and of each stage per replay.")
+      .parse(argc, argv);
+
+  SessionRecording recording;
+  if (!SessionRecording::load(args.value("recording"), recording)) {
+    return 1;
+  }
+  const int runs = args.value<int>("runs");
+  if (runs < 1) {
+    LOG(ERROR) << "replay: runs must be positive";
+    return 1;
+  }
+
+  SimulatorConfiguration simConfig;
+  simConfig.scene.id = args.value("scene").empty() ? recording.scene
+                                                   : args.value("scene");
+  simConfig.gpuDeviceId = args.value<int>("gpu-device");
+  simConfig.enablePhysics = args.isSet("enable-physics");
+  simConfig.physicsConfigFile = args.value("physics-config");
+  simConfig.renderOnly = args.isSet("render-only");
+  simConfig.frustumCulling = !args.isSet("disable-frustum-culling");
+  simConfig.requiresTextures = false;
+  for (const SessionEvent& event : recording.events) {
+    if (event.type != SessionEventType::AddAgent) {
+      continue;
+    }
+    for (const auto& spec : event.agentConfig.sensorSpecifications) {
+      simConfig.requiresTextures |=
+          spec->sensorType == esp::sensor::SensorType::COLOR;
+    }
+  }
+
+  // a fresh simulator per run, the session adds its own agents and objects
+  double totalMs = 0.0;
+  SessionReplayTimes times;
+  ProfilingStats stats;
+  bool success = true;
+  for (int run = 0; run < runs; ++run) {
+    Simulator simulator{simConfig};
+    const bool measured = run > 0 || runs == 1;
+    SessionReplayTimes runTimes;
+    simulator.resetProfilingStats();
+    simulator.setProfilingEnabled(measured);
+    const auto start = std::chrono::steady_clock::now();
+    success &= esp::sim::replaySession(simulator, recording, &runTimes);
+    glFinish();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    simulator.setProfilingEnabled(false);
+    if (!measured) {
+      continue;
+    }
+    totalMs += elapsed.count();
+    for (int i = 0; i < esp::sim::NumSessionEventTypes; ++i) {
+      times.calls[i] += runTimes.calls[i];
+      times.milliseconds[i] += runTimes.milliseconds[i];
+    }
+    // the profiler is process-wide, so its stats cover this run only
+    const ProfilingStats runStats = simulator.getProfilingStats();
+    for (uint8_t i = 0; i <= uint8_t(esp::core::ProfilingStage::Noise); ++i) {
+      const auto stage = esp::core::ProfilingStage(i);
+      stats.timing(stage).calls += runStats.timing(stage).calls;
+      stats.timing(stage).cpuTimeMs += runStats.timing(stage).cpuTimeMs;
+      stats.timing(stage).gpuTimeMs += runStats.timing(stage).gpuTimeMs;
+    }
+    stats.drawCalls += runStats.drawCalls;
+    stats.drawablesCulled += runStats.drawablesCulled;
+  }
+  const int measuredRuns = runs == 1 ? 1 : runs - 1;
+
+  std::printf("%s: %zu events in %s, physics %s, culling %s\n",
+              args.value("recording").c_str(), recording.events.size(),
+              simConfig.scene.id.c_str(),
+              simConfig.renderOnly
+                  ? "render only"
+                  : simConfig.enablePhysics ? "on" : "off",
+              simConfig.frustumCulling ? "on" : "off");
+  std::printf("replay time: %.3f ms, average of %d runs\n",
+              totalMs / measuredRuns, measuredRuns);
+
+  std::printf("\n  %-20s %10s %10s\n", "call per replay", "ms", "calls");
+  for (int i = 0; i < esp::sim::NumSessionEventTypes; ++i) {
+    if (times.calls[i] == 0) {
+      continue;
+    }
+    std::printf("  %-20s %10.3f %10.1f\n",
+                esp::sim::sessionEventTypeName(SessionEventType(i)),
+                times.milliseconds[i] / measuredRuns,
+                double(times.calls[i]) / measuredRuns);
+  }
+
+  std::printf("\n  %-20s %10s %10s %10s\n", "stage per replay", "cpu ms",
+              "gpu ms", "calls");
+  printTiming("agent observations", stats.agentObservations, measuredRuns);
+  printTiming("physics", stats.physics, measuredRuns);
+  printTiming("culling", stats.culling, measuredRuns);
+  printTiming("drawing", stats.drawing, measuredRuns);
+  printTiming("readback", stats.readback, measuredRuns);
+  printTiming("noise", stats.noise, measuredRuns);
+  std::printf("  drawables culled per replay: %.1f, draw calls per replay: "
+              "%.1f\n",
+              double(stats.drawablesCulled) / measuredRuns,
+              double(stats.drawCalls) / measuredRuns);
+
+  if (!success) {
+    LOG(ERROR) << "replay: some events could not be replayed";
+    return 1;
+  }
+  return 0;
+}
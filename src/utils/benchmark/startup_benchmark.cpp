@@ -0,0 +1,197 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures how long constructing and destroying a simulator takes, with the
+// time of each startup phase, to track the startup optimizations
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Corrade/Utility/Arguments.h>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/esp.h"
+#include "esp/physics/configure.h"
+#include "esp/sim/Simulator.h"
+
+namespace Cr = Corrade;
+
+using esp::agent::AgentConfiguration;
+using esp::core::Profiler;
+using esp::core::ProfilingStage;
+using esp::core::ProfilingStats;
+using esp::sensor::SensorSpec;
+using esp::sensor::SensorType;
+using esp::sim::SimulatorConfiguration;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+//! the phases of a startup, in the order they run
+const ProfilingStage StartupPhases[]{
+    ProfilingStage::ContextCreation, ProfilingStage::ImporterSetup,
+    ProfilingStage::NavmeshLoading,  ProfilingStage::PrimitiveAttributes,
+    ProfilingStage::StageLoading,    ProfilingStage::ShaderCompilation,
+};
+
+void printPhase(const char* phase, double milliseconds, int runs) {
+  std::printf("  %-24s %10.2f\n", phase, milliseconds / runs);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Cr::Utility::Arguments args;
+  args.addArgument("scenes")
+      .setHelp("scenes", "comma-separated scene/stage files to load")
+      .addOption("runs", "5")
+      .setHelp("runs", "simulators constructed and destroyed per scene")
+      .addOption("sensors", "color,depth")
+      .setHelp("sensors",
+               "comma-separated sensors of the agent added after the "
+               "construction, any of color, depth and semantic")
+      .addOption("resolution", "128")
+      .setHelp("resolution", "width and height of each sensor", "R")
+      .addBooleanOption("enable-physics")
+      .addOption("physics-config", ESP_DEFAULT_PHYS_SCENE_CONFIG_REL_PATH)
+      .setHelp("physics-config",
+               "Provide a non-default PhysicsManager config file.")
+      .addOption("program-binary-cache-dir", "")
+      .setHelp("program-binary-cache-dir",
+               "cache the linked shader programs in this directory")
+      .addOption("texture-transcode-cache-dir", "")
+      .setHelp("texture-transcode-cache-dir",
+               "cache the transcoded Basis textures in this directory")
+      .addOption("gpu-device", "0")
+      .setGlobalHelp(
+          "Constructs a simulator for each scene, adds an agent, draws its "
+          "first observations and destroys it, several times, and reports "
+          "the mean time of each startup phase.")
+      .parse(argc, argv);
+
+  const int runs = args.value<int>("runs");
+  const int resolution = args.value<int>("resolution");
+  if (runs < 1 || resolution < 1) {
+    LOG(ERROR) << "startup_benchmark: runs and resolution must be positive";
+    return 1;
+  }
+
+  SimulatorConfiguration simConfig;
+  simConfig.gpuDeviceId = args.value<int>("gpu-device");
+  simConfig.enablePhysics = args.isSet("enable-physics");
+  simConfig.physicsConfigFile = args.value("physics-config");
+  simConfig.programBinaryCacheDir = args.value("program-binary-cache-dir");
+  simConfig.textureTranscodeCacheDir =
+      args.value("texture-transcode-cache-dir");
+
+  AgentConfiguration agentConfig;
+  agentConfig.sensorSpecifications.clear();
+  bool requiresTextures = false;
+  std::istringstream sensorNames{args.value("sensors")};
+  for (std::string name; std::getline(sensorNames, name, ',');) {
+    if (name.empty()) {
+      continue;
+    }
+    auto spec = SensorSpec::create();
+    spec->uuid = name;
+    spec->position = {0.0f, 1.5f, 0.0f};
+    spec->resolution = {resolution, resolution};
+    if (name == "color") {
+      spec->sensorType = SensorType::COLOR;
+      requiresTextures = true;
+    } else if (name == "depth") {
+      spec->sensorType = SensorType::DEPTH;
+      spec->channels = 1;
+    } else if (name == "semantic") {
+      spec->sensorType = SensorType::SEMANTIC;
+      spec->channels = 1;
+    } else {
+      LOG(ERROR) << "startup_benchmark: unknown sensor " << name;
+      return 1;
+    }
+    agentConfig.sensorSpecifications.push_back(spec);
+  }
+  simConfig.requiresTextures = requiresTextures;
+
+  std::vector<std::string> scenes;
+  std::istringstream sceneNames{args.value("scenes")};
+  for (std::string scene; std::getline(sceneNames, scene, ',');) {
+    if (!scene.empty()) {
+      scenes.push_back(scene);
+    }
+  }
+
+  std::printf("%d runs per scene, sensors %s at %dx%d, physics %s\n", runs,
+              args.value("sensors").c_str(), resolution, resolution,
+              simConfig.enablePhysics ? "on" : "off");
+  for (const std::string& scene : scenes) {
+    simConfig.scene.id = scene;
+    double constructionMs = 0.0;
+    double agentMs = 0.0;
+    double firstObservationMs = 0.0;
+    double destructionMs = 0.0;
+    ProfilingStats stats;
+    for (int run = 0; run < runs; ++run) {
+      Profiler::reset();
+      Profiler::setEnabled(true);
+      Clock::time_point start = Clock::now();
+      auto simulator = esp::sim::Simulator::create_unique(simConfig);
+      constructionMs += millisecondsSince(start);
+
+      start = Clock::now();
+      simulator->addAgent(agentConfig);
+      agentMs += millisecondsSince(start);
+
+      start = Clock::now();
+      for (const auto& spec : agentConfig.sensorSpecifications) {
+        esp::sensor::Observation observation;
+        simulator->getAgentObservation(0, spec->uuid, observation);
+      }
+      firstObservationMs += millisecondsSince(start);
+      Profiler::setEnabled(false);
+
+      for (ProfilingStage phase : StartupPhases) {
+        stats.timing(phase).cpuTimeMs +=
+            Profiler::stats().timing(phase).cpuTimeMs;
+      }
+
+      start = Clock::now();
+      simulator = nullptr;
+      destructionMs += millisecondsSince(start);
+    }
+
+    // the stage loading includes the shaders of the stage drawables
+    double phasesMs = 0.0;
+    for (ProfilingStage phase : StartupPhases) {
+      if (phase != ProfilingStage::ShaderCompilation) {
+        phasesMs += stats.timing(phase).cpuTimeMs;
+      }
+    }
+
+    std::printf("\n%s\n  %-24s %10s\n", scene.c_str(), "phase per run",
+                "cpu ms");
+    printPhase("construction", constructionMs, runs);
+    printPhase("  context creation", stats.contextCreation.cpuTimeMs, runs);
+    printPhase("  plugins and managers", stats.importerSetup.cpuTimeMs, runs);
+    printPhase("  navmesh loading", stats.navmeshLoading.cpuTimeMs, runs);
+    printPhase("  primitive attributes", stats.primitiveAttributes.cpuTimeMs,
+               runs);
+    printPhase("  stage loading", stats.stageLoading.cpuTimeMs, runs);
+    printPhase("  other", constructionMs - phasesMs, runs);
+    printPhase("agent and sensors", agentMs, runs);
+    printPhase("first observations", firstObservationMs, runs);
+    printPhase("destruction", destructionMs, runs);
+    printPhase("shader compilation", stats.shaderCompilation.cpuTimeMs, runs);
+  }
+  return 0;
+}
@@ -51,8 +51,8 @@ MeshData SceneLoader::load(const AssetInfo& info) {
     const auto& vbo = instanceMeshData->getVertexBufferObjectCPU();
     const auto& cbo = instanceMeshData->getColorBufferObjectCPU();
     const auto& ibo = instanceMeshData->getIndexBufferObjectCPU();
-    mesh.vbo = vbo;
-    mesh.ibo = ibo;
+    mesh.vbo.assign(vbo.begin(), vbo.end());
+    mesh.ibo.assign(ibo.begin(), ibo.end());
     for (const auto& c : cbo) {
       mesh.cbo.emplace_back(c.cast<float>() / 255.0f);
     }
@@ -2,17 +2,30 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "SceneLoader.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+#include "esp/assets/CompressedGltf.h"
 #include "esp/assets/Mp3dInstanceMeshData.h"
+#include "esp/assets/ResourceManager.h"
+#include "esp/core/TaskScheduler.h"
 #include "esp/core/esp.h"
+#include "esp/io/io.h"
 #include "esp/nav/PathFinder.h"
 #include "esp/scene/SemanticScene.h"
 
@@ -150,34 +163,264 @@ int createMp3dSemanticMesh(const std::string& plyFile,
   return 0;
 }
 
-int main(int argc, char** argv) {
-  if (argc < 4) {
-    std::cout << "Usage: datatool task input_file output_file" << std::endl;
+int bakeSceneCache(const std::string& meshFile,
+                   const std::string& cacheFile,
+                   int levelOfDetailCount) {
+  if (!ResourceManager::bakeSceneCache(meshFile, cacheFile,
+                                       levelOfDetailCount)) {
+    LOG(ERROR) << "Failed baking scene cache of " << meshFile;
+    return 1;
+  }
+  if (cacheFile != sceneCacheFilename(meshFile)) {
+    LOG(INFO) << "The scene cache is only used when moved to "
+              << sceneCacheFilename(meshFile);
+  }
+  return 0;
+}
+
+int transcodeTextures(const std::string& meshFile,
+                      const std::string& cacheDir,
+                      const std::string& basisFormat) {
+  if (!ResourceManager::bakeTranscodedTextures(meshFile, cacheDir,
+                                               basisFormat)) {
+    LOG(ERROR) << "Failed transcoding the textures of " << meshFile;
+    return 1;
+  }
+  return 0;
+}
+
+// The visibility from the navmesh next to meshFile, sampled in cells of
+// cellSize meters
+int createPotentiallyVisibleSet(const std::string& meshFile,
+                                const std::string& pvsFile,
+                                float cellSize) {
+  const std::string navmeshFile =
+      esp::io::changeExtension(meshFile, ".navmesh");
+  PathFinder pf;
+  if (!pf.loadNavMesh(navmeshFile)) {
+    LOG(ERROR) << "Failed to load navmesh " << navmeshFile;
+    return 2;
+  }
+  esp::gfx::PotentiallyVisibleSet::Configuration configuration;
+  configuration.cellSize = cellSize;
+  // about 8 sampled points per cell of the navigable area
+  const int numPoints = std::max(
+      1, int(std::ceil(8.0f * pf.getNavigableArea() / (cellSize * cellSize))));
+  std::vector<Magnum::Vector3> navigablePoints;
+  for (const esp::vec3f& point : pf.sampleNavigablePoints(numPoints)) {
+    navigablePoints.emplace_back(point[0], point[1], point[2]);
+  }
+  if (navigablePoints.empty()) {
+    LOG(ERROR) << "Failed to sample the navmesh " << navmeshFile;
+    return 2;
+  }
+  if (!ResourceManager::bakePotentiallyVisibleSet(meshFile, navigablePoints,
+                                                  pvsFile, configuration)) {
+    LOG(ERROR) << "Failed computing the potentially visible set of "
+               << meshFile;
+    return 1;
+  }
+  if (pvsFile != esp::io::changeExtension(meshFile, ".pvs")) {
+    LOG(INFO) << "The potentially visible set is only used when moved to "
+              << esp::io::changeExtension(meshFile, ".pvs");
+  }
+  return 0;
+}
+
+// The navmesh and scene cache where the simulator looks for them
+int preprocessScene(const std::string& meshFile, int levelOfDetailCount) {
+  const int result =
+      createNavMesh(meshFile, esp::io::changeExtension(meshFile, ".navmesh"));
+  if (result != 0) {
+    return result;
+  }
+  return bakeSceneCache(meshFile, sceneCacheFilename(meshFile),
+                        levelOfDetailCount);
+}
+
+int runBatch(const std::string& manifestFile, unsigned int numThreads);
+
+// Run the task args[0] with the arguments following it, 64 for a usage error
+int runTask(const std::vector<std::string>& args) {
+  const std::string& task = args[0];
+  if (task == "batch") {
+    // optionally followed by the number of worker threads
+    const int numThreads = args.size() > 2 ? std::atoi(args[2].c_str()) : 0;
+    return runBatch(args[1], std::max(0, numThreads));
+  }
+  if (task == "preprocess_scene") {
+    // optionally followed by the number of coarser levels of detail
+    const int levelOfDetailCount =
+        args.size() > 2 ? std::atoi(args[2].c_str()) : 0;
+    return preprocessScene(args[1], levelOfDetailCount);
+  }
+  if (task == "bake_asset_metadata") {
+    // written next to the render asset, where object templates look for it
+    if (!ResourceManager::bakeAssetMetadata(args[1])) {
+      LOG(ERROR) << "Failed baking the asset metadata of " << args[1];
+      return 1;
+    }
+    return 0;
+  }
+  if (args.size() < 3) {
+    std::cout << "Usage: datatool " << task << " input_file output_file"
+              << std::endl;
     return 64;
   }
-  const std::string task = argv[1];
   if (task == "create_navmesh") {
-    createNavMesh(argv[2], argv[3]);
-  } else if (task == "create_mp3d_semantic_mesh") {
-    if (argc < 5) {
+    return createNavMesh(args[1], args[2]);
+  }
+  if (task == "create_mp3d_semantic_mesh") {
+    if (args.size() < 4) {
       std::cout << "Usage: datatool create_mp3d_semantic_mesh input_ply "
                    "input_house output_mesh"
                 << std::endl;
       return 64;
     }
-    createMp3dSemanticMesh(argv[2], argv[3], argv[4]);
-  } else if (task == "create_gibson_semantic_mesh") {
-    if (argc < 5) {
+    return createMp3dSemanticMesh(args[1], args[2], args[3]);
+  }
+  if (task == "create_gibson_semantic_mesh") {
+    if (args.size() < 4) {
       std::cout << "Usage: datatool create_gibson_semantic_mesh input_obj "
                    "input_ids output_mesh"
                 << std::endl;
       return 64;
     }
-    createGibsonSemanticMesh(argv[2], argv[3], argv[4]);
-  } else {
-    LOG(ERROR) << "Unrecognized task " << task;
+    return createGibsonSemanticMesh(args[1], args[2], args[3]);
+  }
+  if (task == "bake_scene_cache") {
+    // optionally followed by the number of coarser levels of detail
+    const int levelOfDetailCount =
+        args.size() > 3 ? std::atoi(args[3].c_str()) : 0;
+    return bakeSceneCache(args[1], args[2], levelOfDetailCount);
+  }
+  if (task == "transcode_textures") {
+    // optionally followed by the Basis target format, e.g. Bc7RGBA
+    return transcodeTextures(args[1], args[2], args.size() > 3 ? args[3] : "");
+  }
+  if (task == "compress_gltf") {
+    // lossless EXT_meshopt_compression of the vertex and index buffers
+    if (!compressGltf(args[1], args[2])) {
+      LOG(ERROR) << "Failed compressing " << args[1];
+      return 1;
+    }
+    return 0;
+  }
+  if (task == "create_pvs") {
+    // optionally followed by the cell size in meters, 1 by default
+    const float cellSize =
+        args.size() > 3 ? float(std::atof(args[3].c_str())) : 1.0f;
+    if (!(cellSize > 0.0f)) {
+      LOG(ERROR) << "The cell size has to be positive";
+      return 64;
+    }
+    return createPotentiallyVisibleSet(args[1], args[2], cellSize);
+  }
+  LOG(ERROR) << "Unrecognized task " << task;
+  return 64;
+}
+
+/**
+ * Run the jobs of a manifest on a pool of worker threads. Every line of the
+ * manifest is the arguments of one datatool task, e.g.
+ * "create_navmesh scene.glb scene.navmesh", or just a scene file, which is
+ * preprocessed as with "preprocess_scene". Empty lines and lines starting with
+ * # are skipped. The lines of finished jobs are appended to
+ * <manifestFile>.done, and jobs listed there are skipped when the batch is run
+ * again, so an interrupted batch resumes where it stopped.
+ */
+int runBatch(const std::string& manifestFile, unsigned int numThreads) {
+  std::ifstream manifest(manifestFile);
+  if (!manifest) {
+    LOG(ERROR) << "Failed to open manifest " << manifestFile;
     return 1;
   }
+  const std::string doneFile = manifestFile + ".done";
+  std::unordered_set<std::string> done;
+  {
+    std::ifstream doneLog(doneFile);
+    std::string line;
+    while (std::getline(doneLog, line)) {
+      done.insert(line);
+    }
+  }
+
+  std::vector<std::string> jobs;
+  std::string line;
+  size_t skipped = 0;
+  while (std::getline(manifest, line)) {
+    if (line.empty() || line[0] == '#' ||
+        line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+    if (done.count(line)) {
+      ++skipped;
+    } else {
+      jobs.push_back(line);
+    }
+  }
+  if (skipped > 0) {
+    LOG(INFO) << "Skipping " << skipped << " jobs already done in "
+              << doneFile;
+  }
+  if (jobs.empty()) {
+    return 0;
+  }
+
+  std::ofstream doneLog(doneFile, std::ios::app);
+  std::mutex mutex;
+  size_t finished = 0;
+  size_t failed = 0;
+  // the jobs take the threads of the shared scheduler, so their own parallel
+  // loops don't oversubscribe the cores
+  esp::core::TaskScheduler::global().parallelFor(
+      jobs.size(), numThreads, [&](size_t iJob, int) {
+        std::vector<std::string> args;
+        std::istringstream tokens(jobs[iJob]);
+        for (std::string arg; tokens >> arg;) {
+          args.push_back(arg);
+        }
+        if (args.size() == 1) {
+          args.insert(args.begin(), "preprocess_scene");
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const int result = args[0] == "batch" ? 64 : runTask(args);
+        const std::chrono::duration<double> seconds =
+            std::chrono::steady_clock::now() - start;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++finished;
+        if (result == 0) {
+          // flushed right away so that a killed batch keeps its progress
+          doneLog << jobs[iJob] << std::endl;
+        } else {
+          ++failed;
+        }
+        std::cout << "[" << finished << "/" << jobs.size() << "] "
+                  << (result == 0 ? "done" : "FAILED") << " in "
+                  << seconds.count() << "s: " << jobs[iJob] << std::endl;
+      });
+
+  if (failed > 0) {
+    LOG(ERROR) << failed << " of " << jobs.size() << " jobs failed, running "
+               << manifestFile << " again retries them";
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cout << "Usage: datatool task input_file output_file" << std::endl
+              << "       datatool batch manifest_file [num_threads]"
+              << std::endl;
+    return 64;
+  }
+  const std::string task = argv[1];
+  const int result = runTask(std::vector<std::string>(argv + 1, argv + argc));
+  if (result != 0) {
+    return result;
+  }
 
   LOG(INFO) << "task: \"" << task << "\" done";
   return 0;
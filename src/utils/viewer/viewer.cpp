@@ -40,6 +40,7 @@
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
 #include <sophus/so3.hpp>
+#include "esp/core/Profiling.h"
 #include "esp/core/Utility.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/Drawable.h"
@@ -136,7 +137,11 @@ Key Commands:
 
   Utilities:
   'e' enable/disable frustum culling.
-  'c' show/hide FPS overlay.
+  'g' enable/disable occlusion culling.
+  'l' enable/disable drawing from render lists.
+  'j' enable/disable instanced drawing of the objects added afterwards.
+  'r' cycle the render quality: full, unlit, vertex colors.
+  'c' show/hide the frame timing overlay.
   'n' show/hide NavMesh wireframe.
   'i' Save a screenshot to "./screenshots/year_month_day_hour-minute-second/#.png"
 
@@ -206,6 +211,22 @@ Key Commands:
   Mn::ImGuiIntegration::Context imgui_{Mn::NoCreate};
   bool showFPS_ = true;
 
+  //! Collect the profiling stats of the overlay, averaged over
+  //! hudUpdateInterval_ seconds so that they are readable
+  void updateHudStats();
+  //! Draw the frame timing overlay
+  void drawHud(uint32_t visibles);
+  //! Cycle the render quality of the camera sensor
+  void cycleRenderQuality();
+
+  const double hudUpdateInterval_ = 0.5;
+  double hudElapsed_ = 0.0;
+  uint32_t hudFramesSinceUpdate_ = 0;
+  //! stats of the last interval and the number of frames they cover
+  esp::core::ProfilingStats hudStats_;
+  uint32_t hudFrames_ = 0;
+  esp::gfx::GpuMemoryUsage hudGpuMemory_;
+
   // NOTE: Mouse + shift is to select object on the screen!!
   void createPickedObjectVisualizer(unsigned int objectId);
   std::unique_ptr<ObjectPickingHelper> objectPickingHelper_;
@@ -371,6 +392,8 @@ Viewer::Viewer(const Arguments& arguments)
   agentBodyNode_ = &defaultAgent_->node();
 
   objectPickingHelper_ = std::make_unique<ObjectPickingHelper>(viewportSize);
+  // the stage times of the overlay
+  simulator_->setProfilingEnabled(showFPS_);
   timeline_.start();
 
   printHelpText();
@@ -559,16 +582,8 @@ void Viewer::drawEvent() {
   imgui_.newFrame();
 
   if (showFPS_) {
-    ImGui::SetNextWindowPos(ImVec2(10, 10));
-    ImGui::Begin("main", NULL,
-                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground |
-                     ImGuiWindowFlags_AlwaysAutoResize);
-    ImGui::SetWindowFontScale(2.0);
-    ImGui::Text("%.1f FPS", Mn::Double(ImGui::GetIO().Framerate));
-    uint32_t total = activeSceneGraph_->getDrawables().size();
-    ImGui::Text("%u drawables", total);
-    ImGui::Text("%u culled", total - visibles);
-    ImGui::End();
+    updateHudStats();
+    drawHud(visibles);
   }
 
   /* Set appropriate states. If you only draw ImGui, it is sufficient to
@@ -593,6 +608,93 @@ void Viewer::drawEvent() {
   redraw();
 }
 
+void Viewer::updateHudStats() {
+  hudElapsed_ += timeline_.previousFrameDuration();
+  ++hudFramesSinceUpdate_;
+  if (hudElapsed_ < hudUpdateInterval_) {
+    return;
+  }
+  hudStats_ = simulator_->getProfilingStats();
+  hudFrames_ = hudFramesSinceUpdate_;
+  hudGpuMemory_ = simulator_->getGpuMemoryUsage();
+  simulator_->resetProfilingStats();
+  hudElapsed_ = 0.0;
+  hudFramesSinceUpdate_ = 0;
+}
+
+void Viewer::drawHud(uint32_t visibles) {
+  constexpr double MiB = 1024.0 * 1024.0;
+  const auto onOff = [](bool enabled) { return enabled ? "on" : "off"; };
+
+  ImGui::SetNextWindowPos(ImVec2(10, 10));
+  ImGui::Begin("main", NULL,
+               ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground |
+                   ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SetWindowFontScale(2.0);
+  const Mn::Double fps = ImGui::GetIO().Framerate;
+  ImGui::Text("%.1f FPS, %.2f ms", fps, fps > 0.0 ? 1000.0 / fps : 0.0);
+  uint32_t total = activeSceneGraph_->getDrawables().size();
+  ImGui::Text("%u drawables, %u visible, %u culled", total, visibles,
+              total - visibles);
+
+  if (hudFrames_ > 0) {
+    // per frame averages of the last interval
+    ImGui::Separator();
+    for (uint8_t i = 0; i <= uint8_t(esp::core::ProfilingStage::Noise); ++i) {
+      const auto stage = esp::core::ProfilingStage(i);
+      const esp::core::ProfilingStats::Timing& timing =
+          hudStats_.timing(stage);
+      if (timing.calls == 0) {
+        continue;
+      }
+      ImGui::Text("%-18s %6.2f ms CPU %6.2f ms GPU",
+                  esp::core::profilingStageName(stage),
+                  timing.cpuTimeMs / hudFrames_,
+                  timing.gpuTimeMs / hudFrames_);
+    }
+    ImGui::Text("%.0f draw calls, %.0f culled, %.0f occluded",
+                double(hudStats_.drawCalls) / hudFrames_,
+                double(hudStats_.drawablesCulled) / hudFrames_,
+                double(hudStats_.drawablesOccluded) / hudFrames_);
+    ImGui::Text("GPU memory %.1f MiB: meshes %.1f, textures %.1f, targets %.1f",
+                hudGpuMemory_.totalBytes() / MiB, hudGpuMemory_.meshBytes / MiB,
+                (hudGpuMemory_.textureBytes + hudGpuMemory_.ptexAtlasBytes) /
+                    MiB,
+                hudGpuMemory_.renderTargetBytes / MiB);
+  }
+
+  ImGui::Separator();
+  ImGui::Text("[e] frustum culling %s  [g] occlusion culling %s",
+              onOff(simulator_->isFrustumCullingEnabled()),
+              onOff(simulator_->isOcclusionCullingEnabled()));
+  ImGui::Text("[l] render lists %s  [j] instancing %s",
+              onOff(simulator_->isRenderListEnabled()),
+              onOff(simulator_->isInstancedObjectRenderingEnabled()));
+  const char* qualityNames[]{"full", "unlit", "vertex colors"};
+  ImGui::Text("[r] render quality %s",
+              qualityNames[int(defaultAgent_->getSensorSuite()
+                                   .get("rgba_camera")
+                                   ->specification()
+                                   ->renderQuality)]);
+  ImGui::End();
+}
+
+void Viewer::cycleRenderQuality() {
+  esp::sensor::SensorSpec::ptr spec =
+      defaultAgent_->getSensorSuite().get("rgba_camera")->specification();
+  switch (spec->renderQuality) {
+    case esp::sensor::RenderQuality::FULL:
+      spec->renderQuality = esp::sensor::RenderQuality::UNLIT;
+      break;
+    case esp::sensor::RenderQuality::UNLIT:
+      spec->renderQuality = esp::sensor::RenderQuality::VERTEX_COLOR;
+      break;
+    case esp::sensor::RenderQuality::VERTEX_COLOR:
+      spec->renderQuality = esp::sensor::RenderQuality::FULL;
+      break;
+  }
+}
+
 void Viewer::viewportEvent(ViewportEvent& event) {
   auto& sensors = defaultAgent_->getSensorSuite();
   for (auto entry : sensors.getSensors()) {
@@ -768,8 +870,23 @@ void Viewer::keyPressEvent(KeyEvent& event) {
       simulator_->setFrustumCullingEnabled(
           !simulator_->isFrustumCullingEnabled());
       break;
+    case KeyEvent::Key::G:
+      simulator_->setOcclusionCullingEnabled(
+          !simulator_->isOcclusionCullingEnabled());
+      break;
+    case KeyEvent::Key::L:
+      simulator_->setRenderListEnabled(!simulator_->isRenderListEnabled());
+      break;
+    case KeyEvent::Key::J:
+      simulator_->setInstancedObjectRenderingEnabled(
+          !simulator_->isInstancedObjectRenderingEnabled());
+      break;
+    case KeyEvent::Key::R:
+      cycleRenderQuality();
+      break;
     case KeyEvent::Key::C:
       showFPS_ = !showFPS_;
+      simulator_->setProfilingEnabled(showFPS_);
       break;
     case KeyEvent::Key::O:
       addTemplateObject();
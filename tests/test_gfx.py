@@ -55,3 +55,75 @@ def test_unproject():
         assert np.allclose(
             test_ray_2.direction, np.array([0.569653, -0.581161, -0.581161]), atol=0.07
         )
+
+
+@pytest.mark.skipif(
+    not osp.exists("data/scene_datasets/habitat-test-scenes/apartment_1.glb"),
+    reason="Requires the habitat-test-scenes",
+)
+def test_batch_renderer_matches_per_sensor_rendering():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/apartment_1.glb"
+    cfg_settings["width"] = 64
+    cfg_settings["height"] = 48
+    cfg_settings["color_sensor"] = True
+
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        obs = sim.get_sensor_observations()["color_sensor"]
+
+        sensor_object = sim._sensors["color_sensor"]._sensor_object
+        scene_graph = sim.get_active_scene_graph()
+        num_tiles = 3
+        batch = habitat_sim.gfx.BatchRenderer(
+            sim.renderer, sensor_object.framebuffer_size, num_tiles
+        )
+        assert batch.num_tiles == num_tiles
+
+        with batch:
+            for tile in range(num_tiles):
+                batch.draw_tile(tile, sensor_object, scene_graph)
+            for tile in (-1, num_tiles):
+                with pytest.raises(IndexError):
+                    batch.draw_tile(tile, sensor_object, scene_graph)
+
+        size = batch.framebuffer_size
+        frame = np.empty((size[1], size[0], 4), dtype=np.uint8)
+        batch.read_frame_rgba(
+            mn.MutableImageView2D(
+                mn.PixelFormat.RGBA8_UNORM, size, frame.reshape(size[1], -1)
+            )
+        )
+
+        for tile in range(num_tiles):
+            viewport = batch.tile_viewport(tile)
+            tile_frame = frame[
+                viewport.bottom : viewport.top, viewport.left : viewport.right
+            ]
+            assert np.array_equal(np.flip(tile_frame, axis=0), obs)
+
+
+def test_gpu_device_placement():
+    num_devices = habitat_sim.gfx.num_gpu_devices()
+    assert num_devices >= 1
+    assert len(habitat_sim.gfx.gpu_devices()) == num_devices
+
+    # round-robin placement cycles through all devices
+    policy = habitat_sim.gfx.GpuDevicePolicy.ROUND_ROBIN
+    first = habitat_sim.gfx.select_gpu_device(policy)
+    for i in range(1, num_devices + 1):
+        assert habitat_sim.gfx.select_gpu_device(policy) == (first + i) % num_devices
+
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "NONE"
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    hab_cfg.sim_cfg.gpu_device_policy = habitat_sim.gfx.GpuDevicePolicy.LEAST_LOADED
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        device = sim.gpu_device
+        assert habitat_sim.gfx.gpu_devices()[device].num_contexts == 1
+        # the next context goes to another device if there is one
+        next_device = habitat_sim.gfx.select_gpu_device(
+            habitat_sim.gfx.GpuDevicePolicy.LEAST_LOADED
+        )
+        assert (next_device != device) == (num_devices > 1)
+    assert habitat_sim.gfx.gpu_devices()[device].num_contexts == 0
@@ -180,3 +180,123 @@ def test_greedy_follower(test_navmesh, move_filter_fn, action_noise, pbar):
 
     if not test_all:
         assert test_spl / NUM_TESTS >= ACCEPTABLE_SPLS[(move_filter_fn, action_noise)]
+
+
+@pytest.mark.parametrize("test_navmesh", test_navmeshes)
+def test_greedy_follower_batch(test_navmesh):
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    assert pathfinder.is_loaded
+    pathfinder.seed(0)
+
+    scene_graph = habitat_sim.SceneGraph()
+    agent = habitat_sim.Agent(scene_graph.get_root_node().create_child())
+    agent.controls.move_filter_fn = pathfinder.try_step
+    agent.agent_config.action_space["turn_left"].actuation.amount = TURN_DEGREE
+    agent.agent_config.action_space["turn_right"].actuation.amount = TURN_DEGREE
+
+    follower = habitat_sim.GreedyGeodesicFollower(
+        pathfinder,
+        agent,
+        forward_key="move_forward",
+        left_key="turn_left",
+        right_key="turn_right",
+    )
+
+    start_states = []
+    goals = []
+    while len(start_states) < 20:
+        state = habitat_sim.AgentState()
+        state.position = pathfinder.get_random_navigable_point()
+        goal_pos = pathfinder.get_random_navigable_point()
+        path = habitat_sim.ShortestPath()
+        path.requested_start = state.position
+        path.requested_end = goal_pos
+        if pathfinder.find_path(path) and path.geodesic_distance > 2.0:
+            start_states.append(state)
+            goals.append(goal_pos)
+
+    num_reached = 0
+    for state, goal_pos, action_list in zip(
+        start_states, goals, follower.find_paths(start_states, goals)
+    ):
+        if action_list is None:
+            continue
+
+        agent.state = state
+        for action in action_list:
+            if action is None:
+                break
+            agent.act(action)
+
+        path = habitat_sim.ShortestPath()
+        path.requested_start = agent.state.position
+        path.requested_end = goal_pos
+        pathfinder.find_path(path)
+        num_reached += path.geodesic_distance <= follower.forward_spec.amount
+
+    assert num_reached >= 0.9 * len(start_states)
+
+
+@pytest.mark.parametrize("test_navmesh", test_navmeshes)
+def test_greedy_follower_precomputed(test_navmesh):
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    assert pathfinder.is_loaded
+    pathfinder.seed(0)
+
+    scene_graph = habitat_sim.SceneGraph()
+    agent = habitat_sim.Agent(scene_graph.get_root_node().create_child())
+    agent.controls.move_filter_fn = pathfinder.try_step
+    agent.agent_config.action_space["turn_left"].actuation.amount = TURN_DEGREE
+    agent.agent_config.action_space["turn_right"].actuation.amount = TURN_DEGREE
+
+    follower = habitat_sim.GreedyGeodesicFollower(
+        pathfinder,
+        agent,
+        forward_key="move_forward",
+        left_key="turn_left",
+        right_key="turn_right",
+    )
+
+    goal_pos = pathfinder.get_random_navigable_point()
+    assert not follower.impl.has_precomputed_actions(goal_pos)
+    assert follower.precompute_actions(goal_pos, cell_size=0.25)
+    assert follower.impl.has_precomputed_actions(goal_pos)
+
+    num_reached = 0
+    num_episodes = 0
+    while num_episodes < 10:
+        state = habitat_sim.AgentState()
+        state.position = pathfinder.get_random_navigable_point()
+        path = habitat_sim.ShortestPath()
+        path.requested_start = state.position
+        path.requested_end = goal_pos
+        if not pathfinder.find_path(path) or path.geodesic_distance < 2.0:
+            continue
+
+        num_episodes += 1
+        agent.state = state
+        try:
+            for _ in range(int(1e4)):
+                action = follower.next_action_along(goal_pos)
+                if action is None:
+                    break
+                agent.act(action)
+        except habitat_sim.errors.GreedyFollowerError:
+            continue
+
+        path.requested_start = agent.state.position
+        pathfinder.find_path(path)
+        num_reached += path.geodesic_distance <= follower.forward_spec.amount
+
+    assert num_reached >= 0.9 * num_episodes
+
+    follower.clear_precomputed_actions()
+    assert not follower.impl.has_precomputed_actions(goal_pos)
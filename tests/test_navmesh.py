@@ -1,6 +1,8 @@
 import math
+from concurrent.futures import ThreadPoolExecutor
 from os import path as osp
 
+import numpy as np
 import pytest
 
 import examples.settings
@@ -143,3 +145,346 @@ def test_navmesh_area(test_scene):
             assert math.isclose(recomputedNavMeshArea1, 565.1781616210938)
         elif test_scene.endswith("van-gogh-room.glb"):
             assert math.isclose(recomputedNavMeshArea1, 9.17772102355957)
+
+
+def test_recompute_navmesh_variants(tmpdir):
+    test_scene = test_scenes[1]
+    if not osp.exists(test_scene):
+        pytest.skip(f"{test_scene} not found")
+
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = test_scene
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        variants = []
+        for radius, height in [(0.1, 1.5), (0.2, 1.5), (0.3, 0.8)]:
+            navmesh_settings = habitat_sim.NavMeshSettings()
+            navmesh_settings.set_defaults()
+            navmesh_settings.agent_radius = radius
+            navmesh_settings.agent_height = height
+            variants.append(navmesh_settings)
+
+        pathfinders = sim.recompute_navmesh_variants(variants)
+        assert len(pathfinders) == len(variants)
+
+        # the shared rasterization builds the same navmeshes as separate builds
+        for pathfinder, navmesh_settings in zip(pathfinders, variants):
+            assert pathfinder.is_loaded
+            assert sim.recompute_navmesh(sim.pathfinder, navmesh_settings)
+            assert math.isclose(
+                pathfinder.navigable_area, sim.pathfinder.navigable_area
+            )
+        # a larger agent fits in less of the scene
+        assert pathfinders[0].navigable_area > pathfinders[1].navigable_area
+
+        path = str(tmpdir.join("variants.navmesh"))
+        assert habitat_sim.PathFinder.save_nav_mesh_variants(pathfinders, path)
+        loaded = habitat_sim.PathFinder.load_nav_mesh_variants(path)
+        assert len(loaded) == len(pathfinders)
+        for pathfinder, loaded_pathfinder in zip(pathfinders, loaded):
+            assert loaded_pathfinder.is_loaded
+            assert math.isclose(
+                loaded_pathfinder.navigable_area, pathfinder.navigable_area
+            )
+
+
+def test_find_path_threads():
+    test_navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    # find_path releases the GIL, a path finder per thread searches in parallel
+    pathfinders = []
+    for _ in range(4):
+        pathfinder = habitat_sim.PathFinder()
+        pathfinder.load_nav_mesh(test_navmesh)
+        pathfinder.seed(0)
+        pathfinders.append(pathfinder)
+
+    samples = [
+        (
+            pathfinders[0].get_random_navigable_point(),
+            pathfinders[0].get_random_navigable_point(),
+        )
+        for _ in range(100)
+    ]
+
+    def find_distances(pathfinder):
+        distances = []
+        for start, end in samples:
+            path = habitat_sim.ShortestPath()
+            path.requested_start = start
+            path.requested_end = end
+            pathfinder.find_path(path)
+            distances.append(path.geodesic_distance)
+        return distances
+
+    expected = find_distances(pathfinders[0])
+    with ThreadPoolExecutor(len(pathfinders)) as executor:
+        for distances in executor.map(find_distances, pathfinders):
+            assert distances == expected
+
+
+def test_find_path_cache():
+    test_navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    pathfinder.seed(0)
+    samples = [
+        (
+            pathfinder.get_random_navigable_point(),
+            pathfinder.get_random_navigable_point(),
+        )
+        for _ in range(6)
+    ]
+
+    def find_paths():
+        results = []
+        for start, end in samples:
+            path = habitat_sim.ShortestPath()
+            path.requested_start = start
+            path.requested_end = end
+            found_path = pathfinder.find_path(path)
+            results.append((found_path, path.geodesic_distance, len(path.points)))
+        return results
+
+    expected = find_paths()
+    pathfinder.set_path_cache_size(4)
+    assert find_paths() == expected
+    assert pathfinder.path_cache_size == 4
+    assert pathfinder.path_cache_misses == len(samples)
+
+    # cycling through more samples than fit evicts each before it repeats,
+    # leaving the last 4 cached
+    assert find_paths() == expected
+    assert pathfinder.path_cache_misses == 2 * len(samples)
+    for start, end in samples[-4:]:
+        path = habitat_sim.ShortestPath()
+        path.requested_start = start
+        path.requested_end = end
+        pathfinder.find_path(path)
+    assert pathfinder.path_cache_hits == 4
+
+    # a new navmesh clears the cache
+    pathfinder.load_nav_mesh(test_navmesh)
+    assert pathfinder.path_cache_size == 0
+
+
+def test_point_queries_batch():
+    test_navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    pathfinder.seed(0)
+    lower, upper = pathfinder.get_bounds()
+    rng = np.random.default_rng(0)
+    points = rng.uniform(lower, upper, size=(200, 3)).astype(np.float32)
+    navigable_points = np.array(
+        [pathfinder.get_random_navigable_point() for _ in range(200)],
+        dtype=np.float32,
+    )
+
+    snapped = pathfinder.snap_points_batch(points, num_threads=4)
+    assert snapped.shape == (200, 3)
+    for pt, snapped_pt in zip(points, snapped):
+        expected = np.array(pathfinder.snap_point(pt))
+        assert np.allclose(snapped_pt, expected, equal_nan=True)
+
+    navigable = pathfinder.is_navigable_batch(
+        np.concatenate([points, navigable_points]), num_threads=4
+    )
+    assert navigable.shape == (400,)
+    assert navigable[200:].all()
+    for pt, is_navigable in zip(points, navigable[:200]):
+        assert is_navigable == pathfinder.is_navigable(pt)
+
+    for allow_sliding in [True, False]:
+        steps = pathfinder.try_steps_batch(
+            navigable_points, points, allow_sliding=allow_sliding, num_threads=4
+        )
+        assert steps.shape == (200, 3)
+        try_step = (
+            pathfinder.try_step if allow_sliding else pathfinder.try_step_no_sliding
+        )
+        for start, end, step in zip(navigable_points, points, steps):
+            assert np.allclose(step, try_step(start, end), atol=EPS)
+
+    with pytest.raises(ValueError):
+        pathfinder.try_steps_batch(navigable_points, points[:10])
+
+
+def test_geodesic_distance_matrix():
+    test_navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    pathfinder.seed(0)
+    points = np.array(
+        [pathfinder.get_random_navigable_point() for _ in range(30)],
+        dtype=np.float32,
+    )
+
+    distances = pathfinder.geodesic_distance_matrix(points, num_threads=4)
+    assert distances.shape == (30, 30)
+    assert np.allclose(np.diag(distances), 0.0, atol=EPS)
+
+    # the same distances as a field of each point, never shorter than the
+    # shortest path
+    for i in range(5):
+        field = pathfinder.build_geodesic_distance_field([points[i]])
+        shortest = pathfinder.find_distances_batch(
+            [points[i]] * len(points), list(points)
+        )
+        for j, pt in enumerate(points):
+            expected = pathfinder.geodesic_distance(field, pt)
+            if math.isinf(expected):
+                assert math.isinf(distances[i, j])
+                continue
+            assert math.isclose(distances[i, j], expected, rel_tol=1e-4, abs_tol=EPS)
+            assert distances[i, j] >= shortest[j] - 1e-3
+
+
+def test_compress_navmesh():
+    test_navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    pathfinder.seed(0)
+    samples = [
+        (
+            pathfinder.get_random_navigable_point(),
+            pathfinder.get_random_navigable_point(),
+        )
+        for _ in range(50)
+    ]
+    starts = [start for start, _ in samples]
+    ends = [end for _, end in samples]
+    expected = pathfinder.find_distances_batch(starts, ends)
+    area = pathfinder.navigable_area
+    num_islands = pathfinder.num_islands
+    tile_data_bytes = pathfinder.tile_data_bytes
+
+    assert pathfinder.compress()
+    assert pathfinder.is_compressed
+    assert pathfinder.is_loaded
+    assert pathfinder.tile_data_bytes < tile_data_bytes
+    assert pathfinder.navigable_area == area
+
+    # the first query decompresses the same navmesh
+    distances = pathfinder.find_distances_batch(starts, ends)
+    assert not pathfinder.is_compressed
+    assert pathfinder.tile_data_bytes == tile_data_bytes
+    assert pathfinder.num_islands == num_islands
+    for distance, expected_distance in zip(distances, expected):
+        assert distance == expected_distance
+
+
+def test_stream_navmesh_tiles(tmp_path):
+    test_navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    pathfinder.seed(0)
+    samples = [
+        (
+            pathfinder.get_random_navigable_point(),
+            pathfinder.get_random_navigable_point(),
+        )
+        for _ in range(50)
+    ]
+    starts = [start for start, _ in samples]
+    ends = [end for _, end in samples]
+    expected = pathfinder.find_distances_batch(starts, ends)
+    tile_data_bytes = pathfinder.tile_data_bytes
+    num_islands = pathfinder.num_islands
+
+    # no tile is near a point far away from the navmesh
+    far = np.array([1e4, 1e4, 1e4], dtype=np.float32)
+    num_evicted = pathfinder.stream_tiles([far], 1.0)
+    assert num_evicted > 0
+    assert pathfinder.num_evicted_tiles == num_evicted
+    assert pathfinder.tile_data_bytes < tile_data_bytes
+
+    # the islands describe the whole navmesh wherever the tiles are streamed
+    assert pathfinder.num_islands == num_islands
+
+    # saving writes the evicted tiles too, and keeps them evicted
+    saved_navmesh = str(tmp_path / "streamed.navmesh")
+    assert pathfinder.save_nav_mesh(saved_navmesh)
+    assert pathfinder.num_evicted_tiles == num_evicted
+    saved = habitat_sim.PathFinder()
+    assert saved.load_nav_mesh(saved_navmesh)
+    assert saved.tile_data_bytes == tile_data_bytes
+    assert saved.num_islands == num_islands
+
+    # all of them are near the navmesh with a large radius, and restored with
+    # the same polygons
+    assert pathfinder.stream_tiles([starts[0]], 1e5) == num_evicted
+    assert pathfinder.num_evicted_tiles == 0
+    assert pathfinder.tile_data_bytes == tile_data_bytes
+    distances = pathfinder.find_distances_batch(starts, ends)
+    for distance, expected_distance in zip(distances, expected):
+        assert distance == expected_distance
+
+
+def test_path_hierarchy():
+    test_navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    pathfinder.seed(0)
+    samples = [
+        (
+            pathfinder.get_random_navigable_point(),
+            pathfinder.get_random_navigable_point(),
+        )
+        for _ in range(100)
+    ]
+    expected = pathfinder.find_distances_batch(
+        [start for start, _ in samples], [end for _, end in samples]
+    )
+
+    # small clusters for the castle to have long paths through many of them
+    assert pathfinder.build_path_hierarchy(cluster_size=1.0)
+    assert pathfinder.has_path_hierarchy
+    assert pathfinder.num_path_clusters > 0
+    distances = pathfinder.find_distances_batch(
+        [start for start, _ in samples], [end for _, end in samples]
+    )
+    for distance, expected_distance in zip(distances, expected):
+        if math.isinf(expected_distance):
+            assert math.isinf(distance)
+        else:
+            assert expected_distance - EPS <= distance
+            assert distance <= expected_distance * 1.1 + EPS
+
+    # a new navmesh discards the clusters
+    pathfinder.load_nav_mesh(test_navmesh)
+    assert not pathfinder.has_path_hierarchy
@@ -411,3 +411,239 @@ def test_raycast():
             )
             assert abs(raycast_results.hits[0].ray_distance - 2.8935) < 0.001
             assert raycast_results.hits[0].object_id == 0
+
+
+@pytest.mark.skipif(
+    not osp.exists("data/scene_datasets/habitat-test-scenes/apartment_1.glb"),
+    reason="Requires the habitat-test-scenes",
+)
+def test_raycast_batch():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/apartment_1.glb"
+    cfg_settings["enable_physics"] = True
+
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        if (
+            sim.get_physics_simulation_library()
+            == habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            return
+
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        cube_obj_id = sim.add_object_by_handle(cube_prim_handle)
+        sim.set_translation(mn.Vector3(3.0, 0, 0), cube_obj_id)
+
+        # rays in all directions, plus one of zero length which misses
+        rng = np.random.RandomState(0)
+        directions = rng.normal(size=(1000, 3)).astype(np.float32)
+        directions[0] = [1.0, 0, 0]
+        directions[-1] = 0
+        origins = np.zeros_like(directions)
+
+        results = sim.cast_rays(origins, directions, max_distance=20.0)
+        assert len(results) == len(directions)
+        assert results.points.shape == (len(directions), 3)
+        assert results.has_hit[0]
+        assert results.object_ids[0] == cube_obj_id
+        assert not results.has_hit[-1]
+        assert results.ray_distances[-1] == np.inf
+
+        # the first hits of single rays
+        for i in range(0, len(directions) - 1, 97):
+            ray = habitat_sim.geo.Ray(
+                mn.Vector3(origins[i]), mn.Vector3(directions[i])
+            )
+            single = sim.cast_ray(ray, max_distance=20.0)
+            assert results.has_hit[i] == single.has_hits()
+            if single.has_hits():
+                hit = single.hits[0]
+                assert results.object_ids[i] == hit.object_id
+                assert np.allclose(results.points[i], hit.point, atol=1e-4)
+                assert np.allclose(results.normals[i], hit.normal, atol=1e-4)
+                assert abs(results.ray_distances[i] - hit.ray_distance) < 1e-4
+
+        # the same hits on one thread
+        serial = sim.cast_rays(
+            origins, directions, max_distance=20.0, num_threads=1
+        )
+        assert np.array_equal(serial.has_hit, results.has_hit)
+        assert np.array_equal(serial.object_ids, results.object_ids)
+        assert np.allclose(serial.points, results.points)
+
+
+@pytest.mark.skipif(
+    not osp.exists("data/scene_datasets/habitat-test-scenes/skokloster-castle.glb"),
+    reason="Requires the habitat-test-scenes",
+)
+def test_rigid_states_batch():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings[
+        "scene"
+    ] = "data/scene_datasets/habitat-test-scenes/skokloster-castle.glb"
+    cfg_settings["enable_physics"] = True
+
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        object_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(5)]
+        for i, object_id in enumerate(object_ids):
+            sim.set_translation(mn.Vector3(i, 1.0, -i), object_id)
+            sim.set_rotation(
+                mn.Quaternion.rotation(mn.Deg(10 * i), mn.Vector3.y_axis()), object_id
+            )
+
+        translations, rotations = sim.get_rigid_states(object_ids)
+        assert translations.shape == (5, 3)
+        assert rotations.shape == (5, 4)
+        for i, object_id in enumerate(object_ids):
+            assert np.allclose(translations[i], sim.get_translation(object_id))
+            rotation = sim.get_rotation(object_id)
+            assert np.allclose(rotations[i, :3], rotation.vector)
+            assert np.isclose(rotations[i, 3], rotation.scalar)
+
+        # restore the captured state after moving the objects
+        sim.set_rigid_states(
+            object_ids, np.zeros_like(translations), np.tile([0, 0, 0, 1.0], (5, 1))
+        )
+        assert np.allclose(sim.get_rigid_states(object_ids)[0], 0)
+        sim.set_rigid_states(object_ids, translations, rotations)
+        restored_translations, restored_rotations = sim.get_rigid_states(object_ids)
+        assert np.allclose(restored_translations, translations)
+        assert np.allclose(restored_rotations, rotations)
+
+        # velocities only exist with dynamics
+        if (
+            sim.get_physics_simulation_library()
+            == habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            return
+        lin_vels = np.arange(15, dtype=np.float32).reshape(5, 3)
+        ang_vels = -lin_vels
+        sim.set_velocities(object_ids, lin_vels, ang_vels)
+        got_lin_vels, got_ang_vels = sim.get_velocities(object_ids)
+        for i, object_id in enumerate(object_ids):
+            assert np.allclose(got_lin_vels[i], sim.get_linear_velocity(object_id))
+            assert np.allclose(got_ang_vels[i], sim.get_angular_velocity(object_id))
+        assert np.allclose(got_lin_vels, lin_vels)
+        assert np.allclose(got_ang_vels, ang_vels)
+
+
+@pytest.mark.skipif(
+    not osp.exists("data/scene_datasets/habitat-test-scenes/skokloster-castle.glb"),
+    reason="Requires the habitat-test-scenes",
+)
+def test_physics_snapshot():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings[
+        "scene"
+    ] = "data/scene_datasets/habitat-test-scenes/skokloster-castle.glb"
+    cfg_settings["enable_physics"] = True
+
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        if (
+            sim.get_physics_simulation_library()
+            == habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            return
+
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        object_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(3)]
+        for i, object_id in enumerate(object_ids):
+            sim.set_translation(mn.Vector3(-0.8 + 0.5 * i, 1.5, 11.3), object_id)
+        sim.set_object_motion_type(
+            habitat_sim.physics.MotionType.KINEMATIC, object_ids[-1]
+        )
+        vel_control = sim.get_object_velocity_control(object_ids[-1])
+        vel_control.controlling_lin_vel = True
+        vel_control.linear_velocity = mn.Vector3(0, 0, 1.0)
+        sim.step_physics(0.1)
+
+        snapshot = sim.save_physics_snapshot()
+        assert len(snapshot) == 3
+        assert snapshot.world_time == sim.get_world_time()
+        rollout_start = sim.get_rigid_states(object_ids)
+
+        # roll out, then restore and roll out again the same way, short enough
+        # for the cubes to still fall freely
+        sim.step_physics(0.2)
+        rollout_end = sim.get_rigid_states(object_ids)
+        sim.set_object_motion_type(
+            habitat_sim.physics.MotionType.STATIC, object_ids[0]
+        )
+        vel_control.controlling_lin_vel = False
+
+        # also through a serialized copy, as sent to another process
+        blob = snapshot.to_bytes()
+        restored = habitat_sim.physics.PhysicsSnapshot.from_bytes(blob)
+        assert sim.restore_physics_snapshot(restored)
+        assert sim.get_world_time() == snapshot.world_time
+        assert (
+            sim.get_object_motion_type(object_ids[0])
+            == habitat_sim.physics.MotionType.DYNAMIC
+        )
+        assert vel_control.controlling_lin_vel
+        for expected, actual in zip(rollout_start, sim.get_rigid_states(object_ids)):
+            assert np.allclose(expected, actual, atol=1e-5)
+
+        sim.step_physics(0.2)
+        for expected, actual in zip(rollout_end, sim.get_rigid_states(object_ids)):
+            assert np.allclose(expected, actual, atol=1e-3)
+
+        # objects removed since the snapshot are skipped
+        sim.remove_object(object_ids[1])
+        assert not sim.restore_physics_snapshot(snapshot)
+
+        # as is a new object that reuses the ID of a removed one
+        recycled_id = sim.add_object_by_handle(cube_prim_handle)
+        assert recycled_id == object_ids[1]
+        sim.set_object_motion_type(
+            habitat_sim.physics.MotionType.KINEMATIC, recycled_id
+        )
+        sim.set_translation(mn.Vector3(1.0, 2.0, 3.0), recycled_id)
+        assert not sim.restore_physics_snapshot(snapshot)
+        assert sim.get_translation(recycled_id) == mn.Vector3(1.0, 2.0, 3.0)
+        assert (
+            sim.get_object_motion_type(recycled_id)
+            == habitat_sim.physics.MotionType.KINEMATIC
+        )
+
+
+def test_contact_points():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings[
+        "scene"
+    ] = "data/scene_datasets/habitat-test-scenes/skokloster-castle.glb"
+    cfg_settings["enable_physics"] = True
+
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        if (
+            sim.get_physics_simulation_library()
+            == habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            return
+
+        # two overlapping cubes, in contact after the first step
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        object_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(2)]
+        sim.set_translation(mn.Vector3(-0.8, 1.5, 11.3), object_ids[0])
+        sim.set_translation(mn.Vector3(-0.7, 1.6, 11.3), object_ids[1])
+        sim.step_physics(1.0 / 60.0)
+
+        contacts = sim.get_contact_points()
+        assert len(contacts) > 0
+        assert contacts.points.shape == (len(contacts), 3)
+        assert contacts.normals.shape == (len(contacts), 3)
+        assert len(contacts.impulses) == len(contacts)
+        assert np.allclose(np.linalg.norm(contacts.normals, axis=1), 1.0, atol=1e-4)
+        pairs = {
+            frozenset((a, b))
+            for a, b in zip(contacts.object_ids_a, contacts.object_ids_b)
+        }
+        assert frozenset(object_ids) in pairs
@@ -58,3 +58,19 @@ def test_semantic_scene(scene, make_cfg_settings):
 
     for level in scene.levels:
         level.id
+
+    object_indices = scene.semantic_id_to_object_index
+    category_indices = scene.semantic_id_to_category_index
+    region_indices = scene.semantic_id_to_region_index
+    assert len(category_indices) == len(object_indices)
+    assert len(region_indices) == len(object_indices)
+    for semantic_id, obj_index in enumerate(object_indices):
+        assert scene.semantic_index_to_object_index(semantic_id) == obj_index
+        if obj_index < 0 or obj_index >= len(scene.objects):
+            continue
+        obj = scene.objects[obj_index]
+        if obj is None:
+            continue
+        assert category_indices[semantic_id] == max(obj.category.index(), -1)
+        if region_indices[semantic_id] >= 0:
+            assert scene.regions[region_indices[semantic_id]].id == obj.region.id
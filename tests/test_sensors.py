@@ -169,6 +169,151 @@ def test_reconfigure_render(
     sim.close()
 
 
+@pytest.mark.gfxtest
+def test_bound_observation_buffer(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = False
+    make_cfg_settings["color_sensor"] = True
+    make_cfg_settings["scene"] = scene
+
+    with habitat_sim.Simulator(make_cfg(make_cfg_settings)) as sim:
+        expected = sim.get_sensor_observations()["color_sensor"]
+
+        sensor_object = sim._sensors["color_sensor"]._sensor_object
+        size = sensor_object.framebuffer_size
+        target = np.zeros((size[1], size[0], 4), dtype=np.uint8)
+        sensor_object.bind_observation_buffer(target)
+
+        with pytest.raises(ValueError):
+            sensor_object.bind_observation_buffer(target[:, ::2])
+
+        obs = habitat_sim.sensor.Observation()
+        assert sensor_object.get_observation(sim, obs)
+        assert obs.buffer.is_external
+        assert np.shares_memory(np.asarray(obs.buffer), target)
+        assert np.array_equal(np.flip(target, axis=0), expected)
+
+        assert obs.buffer.__dlpack_device__() == (1, 0)
+        if hasattr(np, "from_dlpack"):
+            assert np.shares_memory(np.from_dlpack(obs.buffer), target)
+
+
+@pytest.mark.gfxtest
+def test_step_async(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = False
+    make_cfg_settings["color_sensor"] = True
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["scene"] = scene
+
+    with habitat_sim.Simulator(make_cfg(make_cfg_settings)) as sim:
+        sim.reset()
+        expected = {
+            uuid: np.array(obs) for uuid, obs in sim.step("move_forward").items()
+        }
+
+        sim.reset()
+        future = sim.step_async("move_forward")
+        observations = future.result()
+        assert future.done()
+        assert not sim.has_async_observations
+        for uuid, obs in expected.items():
+            assert np.array_equal(observations[uuid], obs), uuid
+
+
+@pytest.mark.gfxtest
+def test_converted_observation_formats(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = False
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["scene"] = scene
+
+    cfg = make_cfg(make_cfg_settings)
+    with habitat_sim.Simulator(cfg) as sim:
+        expected = sim.get_sensor_observations()["depth_sensor"]
+
+    # half-float depth at a quarter of the resolution, downsampled on the GPU
+    spec = cfg.agents[0].sensor_specifications[0]
+    spec.observation_format = habitat_sim.sensor.ObservationFormat.HALF_DEPTH
+    spec.downsampling = 4
+    with habitat_sim.Simulator(cfg) as sim:
+        obs = sim.get_sensor_observations()["depth_sensor"]
+
+    height, width = expected.shape
+    assert obs.dtype == np.float16
+    assert obs.shape == (height // 4, width // 4)
+    boxes = expected.reshape(height // 4, 4, width // 4, 4).mean(axis=(1, 3))
+    assert np.allclose(obs, boxes, rtol=1e-2, atol=1e-2)
+
+
+@pytest.mark.gfxtest
+def test_semantic_vertex_ids(make_cfg_settings):
+    scene = _test_scenes[1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = False
+    make_cfg_settings["semantic_sensor"] = True
+    make_cfg_settings["scene"] = scene
+
+    cfg = make_cfg(make_cfg_settings)
+    with habitat_sim.Simulator(cfg) as sim:
+        obs, expected = _render_and_load_gt(sim, scene, "semantic_sensor", False)
+        separate_mesh_bytes = sim.get_gpu_memory_usage().mesh_bytes
+
+    # the stage draws the ids of the semantic mesh in the same pass as its colors
+    cfg.sim_cfg.semantic_vertex_ids = True
+    with habitat_sim.Simulator(cfg) as sim:
+        obs, _ = _render_and_load_gt(sim, scene, "semantic_sensor", False)
+        assert (
+            sim.get_active_scene_graph() is sim.get_active_semantic_scene_graph()
+        )
+        # the semantic mesh is not uploaded next to the render mesh
+        assert sim.get_gpu_memory_usage().mesh_bytes < separate_mesh_bytes
+
+    # the ids only differ where the render and semantic meshes do
+    assert np.mean(obs["semantic_sensor"] == expected) > 0.9
+
+
+@pytest.mark.gfxtest
+def test_instance_mesh_cpu_data(make_cfg_settings):
+    scene = _test_scenes[1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = False
+    make_cfg_settings["semantic_sensor"] = True
+    make_cfg_settings["scene"] = scene
+
+    # the semantic mesh draws the same without its CPU-side data
+    observations = []
+    for cpu_data in [
+        habitat_sim.sim.InstanceMeshCpuData.ALL,
+        habitat_sim.sim.InstanceMeshCpuData.NONE,
+    ]:
+        cfg = make_cfg(make_cfg_settings)
+        cfg.sim_cfg.instance_mesh_cpu_data = cpu_data
+        with habitat_sim.Simulator(cfg) as sim:
+            obs, _ = _render_and_load_gt(sim, scene, "semantic_sensor", False)
+            observations.append(obs["semantic_sensor"])
+
+    assert np.array_equal(observations[0], observations[1])
+
+
 # Tests to make sure that no sensors is supported and doesn't crash
 # Also tests to make sure we can have multiple instances
 # of the simulator with no sensors
@@ -218,6 +363,36 @@ def test_smoke_redwood_noise(scene, gpu2gpu, make_cfg_settings):
     sim.close()
 
 
+def test_redwood_noise_cpu():
+    from habitat_sim._ext.habitat_sim_bindings import RedwoodNoiseModelCPUImpl
+
+    dist = np.load(
+        osp.join(
+            osp.dirname(habitat_sim.__file__),
+            "sensors",
+            "noise_models",
+            "data",
+            "redwood-depth-dist-model.npy",
+        )
+    )
+    depth = np.linspace(0.5, 12.0, 64 * 96, dtype=np.float32).reshape(64, 96)
+
+    first = RedwoodNoiseModelCPUImpl(dist, 1.0, 7)
+    second = RedwoodNoiseModelCPUImpl(dist, 1.0, 7, num_threads=1)
+    noisy = first.simulate_from_cpu(depth)
+    assert np.array_equal(noisy, second.simulate_from_cpu(depth))
+    assert not np.array_equal(noisy, first.simulate_from_cpu(depth))
+    assert first.num_frames == 2
+    assert np.all(noisy[depth >= 11.0] == 0.0)
+
+    # the frames of a batch get the noise of consecutive single frames
+    batch = np.stack([depth, depth])
+    third = RedwoodNoiseModelCPUImpl(dist, 1.0, 7)
+    third.simulate_in_place(batch)
+    assert np.array_equal(batch[0], noisy)
+    assert np.array_equal(batch[1], second.simulate_from_cpu(depth))
+
+
 @pytest.mark.gfxtest
 @pytest.mark.parametrize("scene", _test_scenes)
 @pytest.mark.parametrize(
@@ -229,19 +404,26 @@ def test_smoke_redwood_noise(scene, gpu2gpu, make_cfg_settings):
         "PoissonNoiseModel",
     ],
 )
-def test_rgb_noise(scene, model_name, make_cfg_settings):
+@pytest.mark.parametrize("gpu2gpu", [True, False])
+def test_rgb_noise(scene, model_name, gpu2gpu, make_cfg_settings):
     if not osp.exists(scene):
         pytest.skip("Skipping {}".format(scene))
 
+    # the speckle noise has no CUDA implementation to run on the tensors
+    if gpu2gpu and (not habitat_sim.cuda_enabled or model_name == "SpeckleNoiseModel"):
+        pytest.skip("Skipping GPU->GPU test")
+
     make_cfg_settings["depth_sensor"] = False
     make_cfg_settings["color_sensor"] = True
     make_cfg_settings["semantic_sensor"] = False
     make_cfg_settings["scene"] = scene
     hsim_cfg = make_cfg(make_cfg_settings)
     hsim_cfg.agents[0].sensor_specifications[0].noise_model = model_name
+    for sensor_spec in hsim_cfg.agents[0].sensor_specifications:
+        sensor_spec.gpu2gpu_transfer = gpu2gpu
 
     with habitat_sim.Simulator(hsim_cfg) as sim:
-        obs, gt = _render_and_load_gt(sim, scene, "color_sensor", False)
+        obs, gt = _render_and_load_gt(sim, scene, "color_sensor", gpu2gpu)
 
         assert np.linalg.norm(
             obs["color_sensor"].astype(np.float) - gt.astype(np.float)
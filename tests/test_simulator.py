@@ -1,4 +1,5 @@
 import random
+import threading
 from os import path as osp
 
 import magnum as mn
@@ -94,6 +95,152 @@ def test_multiple_construct_destroy():
             pass
 
 
+# Switching between stages with a tiny asset cache budget releases and reloads
+# the previous stage without crashing
+def test_asset_cache_budget():
+    scenes = [
+        "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb",
+        "data/scene_datasets/habitat-test-scenes/skokloster-castle.glb",
+    ]
+    if not all(osp.exists(scene) for scene in scenes):
+        return
+
+    sim_cfg = habitat_sim.SimulatorConfiguration()
+    sim_cfg.asset_cache_cpu_budget = 1
+    sim_cfg.asset_cache_gpu_budget = 1
+    agent_config = habitat_sim.AgentConfiguration()
+
+    sim_cfg.scene.id = scenes[0]
+    with habitat_sim.Simulator(
+        habitat_sim.Configuration(sim_cfg, [agent_config])
+    ) as sim:
+        for scene in scenes[1:] + scenes:
+            sim_cfg.scene.id = scene
+            sim.reconfigure(habitat_sim.Configuration(sim_cfg, [agent_config]))
+            sim.initialize_agent(0)
+            sim.step("move_forward")
+
+
+# A prefetched scene renders the same as one loaded without prefetching
+def test_prefetch_scene():
+    scenes = [
+        "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb",
+        "data/scene_datasets/habitat-test-scenes/skokloster-castle.glb",
+    ]
+    if not all(osp.exists(scene) for scene in scenes):
+        return
+
+    observations = []
+    for prefetch in [False, True]:
+        cfg_settings = examples.settings.default_sim_settings.copy()
+        cfg_settings["scene"] = scenes[0]
+        with habitat_sim.Simulator(examples.settings.make_cfg(cfg_settings)) as sim:
+            if prefetch:
+                sim.prefetch_scene(scenes[1])
+            cfg_settings["scene"] = scenes[1]
+            sim.reconfigure(examples.settings.make_cfg(cfg_settings))
+            observations.append(sim.get_sensor_observations()["color_sensor"])
+
+    assert np.array_equal(observations[0], observations[1])
+
+
+# Switching back to a resident scene reuses it and renders as when loaded
+def test_resident_scenes():
+    scenes = [
+        "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb",
+        "data/scene_datasets/habitat-test-scenes/skokloster-castle.glb",
+    ]
+    if not all(osp.exists(scene) for scene in scenes):
+        return
+
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = scenes[0]
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    hab_cfg.sim_cfg.resident_scenes = 2
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        start_state = sim.get_agent(0).get_state()
+        expected = sim.get_sensor_observations()["color_sensor"]
+        for scene in scenes[1:] + scenes[:1]:
+            cfg_settings["scene"] = scene
+            hab_cfg = examples.settings.make_cfg(cfg_settings)
+            hab_cfg.sim_cfg.resident_scenes = 2
+            sim.reconfigure(hab_cfg)
+        assert sim.active_scene_reused
+        assert sim.get_resident_scenes() == scenes
+        sim.get_agent(0).set_state(start_state)
+        observation = sim.get_sensor_observations()["color_sensor"]
+
+    assert np.array_equal(expected, observation)
+
+
+def test_compact_vertex_format():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb"
+    if not osp.exists(cfg_settings["scene"]):
+        return
+
+    observations = []
+    for compact in [False, True]:
+        hab_cfg = examples.settings.make_cfg(cfg_settings)
+        hab_cfg.sim_cfg.compact_vertex_format = compact
+        with habitat_sim.Simulator(hab_cfg) as sim:
+            observations.append(sim.get_sensor_observations()["color_sensor"])
+
+    # packed normals and half float texture coordinates differ only slightly
+    difference = np.abs(
+        observations[0].astype(np.int32) - observations[1].astype(np.int32)
+    )
+    assert difference.mean() < 1.0
+
+
+def test_deferred_textures():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb"
+    if not osp.exists(cfg_settings["scene"]):
+        return
+
+    with habitat_sim.Simulator(examples.settings.make_cfg(cfg_settings)) as sim:
+        expected = sim.get_sensor_observations()["color_sensor"]
+
+    # textures are skipped for a depth-only agent and loaded once a color
+    # sensor is added
+    cfg_settings["color_sensor"] = False
+    cfg_settings["depth_sensor"] = True
+    with habitat_sim.Simulator(examples.settings.make_cfg(cfg_settings)) as sim:
+        assert not sim.config.sim_cfg.requires_textures
+        cfg_settings["color_sensor"] = True
+        sim.reconfigure(examples.settings.make_cfg(cfg_settings))
+        observation = sim.get_sensor_observations()["color_sensor"]
+
+    difference = np.abs(expected.astype(np.int32) - observation.astype(np.int32))
+    assert difference.mean() < 1.0
+
+
+def test_reset_episode():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb"
+    if not osp.exists(cfg_settings["scene"]):
+        return
+
+    with habitat_sim.Simulator(examples.settings.make_cfg(cfg_settings)) as sim:
+        start_state = sim.get_agent(0).get_state()
+        expected = sim.get_sensor_observations()["color_sensor"]
+        sensor = sim._sensors["color_sensor"]._sensor_object
+        for _ in range(5):
+            sim.step("move_forward")
+        assert not np.array_equal(
+            sim.get_sensor_observations()["color_sensor"], expected
+        )
+
+        observations = sim.reset_episode([start_state])
+        assert np.allclose(
+            sim.get_agent(0).get_state().position, start_state.position
+        )
+        assert np.array_equal(observations["color_sensor"], expected)
+        # the sensors are kept, not re-created
+        assert sim._sensors["color_sensor"]._sensor_object is sensor
+
+
 def test_scene_bounding_boxes():
     cfg_settings = examples.settings.default_sim_settings.copy()
     cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb"
@@ -154,3 +301,55 @@ def test_object_template_editing():
 
         obj_init_template = sim.get_object_initialization_template(object_id)
         assert obj_init_template.render_asset_handle.endswith("sphere.glb")
+
+
+# A RemoteVectorEnv steps the environments of a SimulatorServer
+def test_remote_vector_env():
+    scene = "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb"
+    if not osp.exists(scene):
+        return
+
+    from habitat_sim.remote import RemoteVectorEnv
+    from habitat_sim.sim import SimulatorServer, VectorSimulator
+
+    sim_cfg = habitat_sim.SimulatorConfiguration()
+    sim_cfg.scene.id = scene
+    color_spec = habitat_sim.SensorSpec()
+    color_spec.uuid = "color"
+    color_spec.resolution = [32, 32]
+    vector_sim = VectorSimulator([sim_cfg, sim_cfg], [color_spec])
+    server = SimulatorServer(vector_sim)
+    port = server.listen()
+
+    results = {}
+
+    def run_client():
+        try:
+            with RemoteVectorEnv("127.0.0.1", port) as env:
+                results["reset"] = env.reset()["color"].copy()
+                results["step"] = env.step(["moveForward", None])["color"].copy()
+                try:
+                    env.step([None, None], dt=float("nan"))
+                except RuntimeError as error:
+                    results["nan"] = str(error)
+                # the session survives a rejected request
+                results["after"] = env.step([None, None])["color"].copy()
+            # the next client receives its observations through shared memory
+            with RemoteVectorEnv("127.0.0.1", port, shared_memory_slots=2) as env:
+                results["shared"] = env.step([None, None])["color"].copy()
+        except Exception as error:
+            results["error"] = error
+
+    client = threading.Thread(target=run_client)
+    client.start()
+    # the server is driven from the thread owning the OpenGL context
+    server.serve(2)
+    client.join()
+
+    assert "error" not in results, results.get("error")
+    assert results["reset"].shape == (2, 32, 32, 4)
+    assert results["step"].shape == (2, 32, 32, 4)
+    assert "time step" in results["nan"]
+    # no action and no physics leave the observations as they were
+    assert np.array_equal(results["after"][1], results["step"][1])
+    assert np.array_equal(results["shared"], results["after"])
@@ -9,3 +9,48 @@ from habitat_sim.utils.collect_env import main as collect_env
 
 def test_collect_env():
     collect_env()
+
+
+def test_batched_pose_conversion():
+    import numpy as np
+    import quaternion
+
+    import habitat_sim
+    from habitat_sim.utils.common import quats_from_coeffs, quats_to_coeffs
+
+    rng = np.random.default_rng(0)
+    coeffs = rng.normal(size=(100, 4)).astype(np.float32)
+    coeffs /= np.linalg.norm(coeffs, axis=1, keepdims=True)
+    quats = quats_from_coeffs(coeffs)
+    assert np.allclose(quats_to_coeffs(quats), coeffs)
+
+    matrices = habitat_sim.geo.quaternions_to_rotation_matrices(coeffs)
+    assert np.allclose(matrices, quaternion.as_rotation_matrix(quats), atol=1e-5)
+    # q and -q are the same rotation
+    back = habitat_sim.geo.rotation_matrices_to_quaternions(matrices)
+    assert np.allclose(np.abs(np.sum(back * coeffs, axis=1)), 1.0, atol=1e-5)
+
+    frame = habitat_sim.geo.CoordinateFrame(
+        up=np.array([0.0, 0.0, 1.0]),
+        front=np.array([0.0, 1.0, 0.0]),
+        origin=np.array([1.0, 2.0, 3.0]),
+    )
+    points = rng.normal(size=(100, 3)).astype(np.float32)
+    in_frame = frame.points_world_to_frame(points)
+    assert np.allclose(frame.points_frame_to_world(in_frame), points, atol=1e-5)
+    # the world up and front are the up and front of the frame, from its origin
+    origin = np.array([[1.0, 2.0, 3.0]])
+    assert np.allclose(frame.points_world_to_frame(origin), 0.0, atol=1e-5)
+    up_and_front = origin + np.stack([habitat_sim.geo.UP, habitat_sim.geo.FRONT])
+    assert np.allclose(
+        frame.points_world_to_frame(up_and_front),
+        [[0.0, 0.0, 1.0], [0.0, 1.0, 0.0]],
+        atol=1e-5,
+    )
+
+    rotations = frame.rotations_world_to_frame(coeffs)
+    assert np.allclose(
+        np.abs(np.sum(frame.rotations_frame_to_world(rotations) * coeffs, axis=1)),
+        1.0,
+        atol=1e-5,
+    )